@@ -0,0 +1,95 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "render_line_kernels.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace std::chrono;
+
+// A pixel-doubled 320x200 frame: 320 source pixels per line, each written
+// twice, and every output line written twice
+constexpr size_t Width  = 320;
+constexpr size_t Height = 200;
+
+constexpr auto NumFrames = 5000;
+
+template <typename Src, typename Convert>
+static void run(const char* name, Convert convert)
+{
+	std::vector<Src> src(Width * Height);
+	for (size_t i = 0; i < src.size(); ++i) {
+		src[i] = static_cast<Src>(i * 2654435761u >> 7);
+	}
+	std::vector<uint32_t> out(Width * 2 * Height * 2);
+
+	const auto start = high_resolution_clock::now();
+	for (auto frame = 0; frame < NumFrames; ++frame) {
+		for (size_t y = 0; y < Height; ++y) {
+			auto line = out.data() + y * 2 * Width * 2;
+			convert(src.data() + y * Width, line);
+
+			std::memcpy(line + Width * 2, line, Width * 2 * sizeof(uint32_t));
+		}
+	}
+	const auto elapsed = duration_cast<microseconds>(
+	        high_resolution_clock::now() - start);
+
+	// Report the output bandwidth, which is what bounds the scalers
+	const auto num_bytes = static_cast<double>(out.size() * sizeof(uint32_t)) *
+	                       NumFrames;
+	const auto elapsed_s  = elapsed.count() / 1000000.0;
+	const auto speed_mb_s = num_bytes / (1024 * 1024) / elapsed_s;
+	const auto frame_us   = elapsed.count() / static_cast<double>(NumFrames);
+	printf("%-12s %8.1f MB/s %8.1f us/frame (checksum %08x)\n",
+	       name,
+	       speed_mb_s,
+	       frame_us,
+	       out[out.size() / 3]);
+}
+
+int main()
+{
+	setvbuf(stdout, nullptr, _IONBF, 0);
+
+	std::vector<uint32_t> lut(256);
+	for (size_t i = 0; i < lut.size(); ++i) {
+		lut[i] = static_cast<uint32_t>(i * 0x010101);
+	}
+
+	run<uint8_t>("memcpy", [](const uint8_t*, uint32_t* line) {
+		static const std::vector<uint32_t> frame_line(Width * 2, 0x123456);
+		std::memcpy(line, frame_line.data(), Width * 2 * sizeof(uint32_t));
+	});
+	run<uint8_t>("8 to 32", [&lut](const uint8_t* src, uint32_t* line) {
+		RENDER_Convert8To32Doubled(src, Width, lut.data(), line);
+	});
+	run<uint16_t>("15 to 32", [](const uint16_t* src, uint32_t* line) {
+		RENDER_Convert15To32Doubled(src, Width, line);
+	});
+	run<uint16_t>("16 to 32", [](const uint16_t* src, uint32_t* line) {
+		RENDER_Convert16To32Doubled(src, Width, line);
+	});
+
+	return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "cpu_trace_format.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+// Decodes a binary CPU trace written by the debugger's TRACE command to text
+// on stdout, one line per instruction
+
+static bool has_flag(const uint32_t flags, const int bit)
+{
+	return (flags >> bit) & 1;
+}
+
+static void print_record(const CpuTrace::Record& r)
+{
+	printf("%04X:%08X  ", r.cs, r.eip);
+	for (const auto byte : r.code) {
+		printf("%02X ", byte);
+	}
+	printf(" %s EAX:%08X EBX:%08X ECX:%08X EDX:%08X ESI:%08X EDI:%08X EBP:%08X ESP:%08X "
+	       "DS:%04X ES:%04X FS:%04X GS:%04X SS:%04X "
+	       "CF:%d ZF:%d SF:%d OF:%d AF:%d PF:%d IF:%d DF:%d\n",
+	       r.is_code_32bit ? "32" : "16",
+	       r.eax,
+	       r.ebx,
+	       r.ecx,
+	       r.edx,
+	       r.esi,
+	       r.edi,
+	       r.ebp,
+	       r.esp,
+	       r.ds,
+	       r.es,
+	       r.fs,
+	       r.gs,
+	       r.ss,
+	       has_flag(r.flags, 0),
+	       has_flag(r.flags, 6),
+	       has_flag(r.flags, 7),
+	       has_flag(r.flags, 11),
+	       has_flag(r.flags, 4),
+	       has_flag(r.flags, 2),
+	       has_flag(r.flags, 9),
+	       has_flag(r.flags, 10));
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s LOGCPU.BIN\n", argv[0]);
+		return 1;
+	}
+
+	auto file = fopen(argv[1], "rb");
+	if (!file) {
+		fprintf(stderr, "Can't open '%s'\n", argv[1]);
+		return 1;
+	}
+
+	CpuTrace::FileHeader header = {};
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+	    !std::equal(std::begin(CpuTrace::Magic),
+	                std::end(CpuTrace::Magic),
+	                header.magic)) {
+		fprintf(stderr, "'%s' isn't a binary CPU trace\n", argv[1]);
+		fclose(file);
+		return 1;
+	}
+	if (header.version != CpuTrace::Version ||
+	    header.record_size != sizeof(CpuTrace::Record)) {
+		fprintf(stderr,
+		        "'%s' was written by an incompatible version, or on a host "
+		        "with a different byte order\n",
+		        argv[1]);
+		fclose(file);
+		return 1;
+	}
+
+	uint64_t num_decoded = 0;
+	CpuTrace::Record record = {};
+	while (num_decoded < header.num_records &&
+	       fread(&record, sizeof(record), 1, file) == 1) {
+		print_record(record);
+		++num_decoded;
+	}
+	fclose(file);
+
+	if (num_decoded != header.num_records) {
+		fprintf(stderr,
+		        "'%s' is truncated: decoded %llu of %llu instructions\n",
+		        argv[1],
+		        static_cast<unsigned long long>(num_decoded),
+		        static_cast<unsigned long long>(header.num_records));
+		return 1;
+	}
+	return 0;
+}
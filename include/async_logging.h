@@ -0,0 +1,45 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_ASYNC_LOGGING_H
+#define DOSBOX_ASYNC_LOGGING_H
+
+// Asynchronous log writer
+// ~~~~~~~~~~~~~~~~~~~~~~~
+// Moves loguru's stderr output to a writer thread, so a logging thread only
+// formats its message and queues it. The queue is bounded: messages that
+// don't fit are dropped and counted rather than stalling the emulation.
+//
+// Each call site may log up to 'MaxMessagesPerSecond' messages per second;
+// the emulation's busiest paths can log on every port access or frame, and
+// the excess messages are suppressed and reported as a count.
+//
+// Fatal messages are written synchronously after draining the queue, so
+// nothing is lost when DOSBox aborts.
+
+// Must be called after loguru::init(); takes over loguru's stderr output at
+// its current verbosity
+void LOGGING_StartAsyncWriter();
+
+// Writes the queued messages and hands stderr back to loguru. Also called at
+// exit, and safe to call more than once.
+void LOGGING_StopAsyncWriter();
+
+#endif
@@ -24,8 +24,10 @@
 #include <cstdio>
 #include <array>
 #include <memory>
+#include <string>
 
 #include "bios.h"
+#include "disk_image_overlay.h"
 #include "dos_inc.h"
 #include "mem.h"
 
@@ -49,11 +51,26 @@ public:
 	uint8_t Read_AbsoluteSector(uint32_t sectnum, void * data);
 	uint8_t Write_AbsoluteSector(uint32_t sectnum, void * data);
 
+	// Transfer a run of consecutive sectors with a single seek and host
+	// read or write
+	uint8_t Read_Sectors(uint32_t head, uint32_t cylinder, uint32_t sector,
+	                     uint32_t num_sectors, void* data);
+	uint8_t Write_Sectors(uint32_t head, uint32_t cylinder, uint32_t sector,
+	                      uint32_t num_sectors, const void* data);
+	uint8_t Read_AbsoluteSectors(uint32_t sectnum, uint32_t num_sectors, void* data);
+	uint8_t Write_AbsoluteSectors(uint32_t sectnum, uint32_t num_sectors,
+	                              const void* data);
+
 	void Set_Geometry(uint32_t setHeads, uint32_t setCyl, uint32_t setSect, uint32_t setSectSize);
 	void Get_Geometry(uint32_t * getHeads, uint32_t *getCyl, uint32_t *getSect, uint32_t *getSectSize);
 	uint8_t GetBiosType(void);
 	uint32_t getSectSize(void);
 
+	// Diverts all writes to a copy-on-write overlay in the delta file at
+	// 'path', leaving the image file unchanged. Must be attached after
+	// the geometry has been set, and before any sectors are accessed.
+	bool AttachOverlay(const std::string& path);
+
 	imageDisk(FILE *img_file, const char *img_name, uint32_t img_size_k, bool is_hdd);
 	imageDisk(const imageDisk&) = delete; // prevent copy
 	imageDisk& operator=(const imageDisk&) = delete; // prevent assignment
@@ -73,8 +90,16 @@ public:
 	uint32_t sector_size;
 	uint32_t heads,cylinders,sectors;
 private:
+	uint8_t ReadImage(cross_off_t bytenum, size_t num_bytes, void* data);
+	uint8_t WriteImage(cross_off_t bytenum, size_t num_bytes, const void* data);
+	uint8_t ReadWithOverlay(cross_off_t bytenum, size_t num_bytes, void* data);
+	uint8_t WriteToOverlay(cross_off_t bytenum, size_t num_bytes, const void* data);
+
 	cross_off_t current_fpos;
 	enum { NONE,READ,WRITE } last_action;
+
+	uint32_t image_size_kb = 0;
+	std::unique_ptr<DiskImageOverlay> overlay = {};
 };
 
 void updateDPT(void);
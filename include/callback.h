@@ -82,9 +82,16 @@ static inline PhysPt CALLBACK_GetBase() {
 	return (CB_SEG << 4) + CB_SOFFSET;
 }
 
-callback_number_t CALLBACK_Allocate();
+// Callbacks allocated with 'may_run_inline' are run straight from translated
+// code instead of exiting the CPU core. Their handlers must always return
+// CBRET_NONE and must not run guest code (CALLBACK_RunRealInt and friends) or
+// switch the CPU mode or core; changing CS:IP and the registers is fine.
+callback_number_t CALLBACK_Allocate(bool may_run_inline = false);
 void CALLBACK_DeAllocate(const callback_number_t in);
 
+void CALLBACK_SetMayRunInline(callback_number_t cb_number, bool may_run_inline);
+bool CALLBACK_MayRunInline(callback_number_t cb_number);
+
 void CALLBACK_Idle();
 
 
@@ -0,0 +1,61 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CD_SECTOR_CACHE_H
+#define DOSBOX_CD_SECTOR_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "sector_cache.h"
+
+// A read cache of a CD-ROM image's cooked data sectors, which also follows
+// the requested sectors to detect sequential reading, so the image can read
+// ahead of programs streaming from the disc.
+class CdSectorCache : public SectorCache {
+public:
+	static constexpr size_t SectorSize = 2048; // cooked data sectors
+
+	// The read-ahead window starts small and doubles on every miss of a
+	// sequential run
+	static constexpr uint32_t MinReadAhead = 4;
+	static constexpr uint32_t MaxReadAhead = 32;
+
+	// A 'max_sectors' of zero disables the cache
+	explicit CdSectorCache(size_t max_sectors);
+
+	// Empties the cache and forgets the sequence of requests
+	void Clear();
+
+	// Tracks the sequence of requests; call for every requested sector
+	void NoteRequest(uint32_t sector);
+
+	// Returns the number of sectors to read after a missed sector, zero if
+	// the requests aren't sequential
+	uint32_t GetReadAheadOnMiss();
+
+private:
+	uint32_t next_sector = std::numeric_limits<uint32_t>::max();
+	uint32_t read_ahead  = 0;
+	bool is_sequential   = false;
+};
+
+#endif
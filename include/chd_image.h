@@ -0,0 +1,148 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CHD_IMAGE_H
+#define DOSBOX_CHD_IMAGE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A reader of CD-ROM images in MAME's compressed hunks of data (CHD) format,
+// version 5. The disc's frames, each 2352 bytes of sector data followed by
+// 96 bytes of subcode, are stored in fixed-size hunks that are compressed
+// independently and located through a map, so any frame can be read without
+// decompressing the ones before it.
+//
+// Decompressed hunks are kept in a small LRU cache, and the hunk following
+// the one being read is decompressed ahead on a worker thread, so sequential
+// reads rarely wait for the decompressor. Reading is thread-safe.
+//
+// Only the zlib-based codecs ('cdzl' and 'zlib') are supported, which is what
+// 'chdman createcd -c cdzl' produces; images using the other codecs or a
+// parent image are refused.
+class ChdImage {
+public:
+	static constexpr uint32_t FrameSize      = 2448;
+	static constexpr uint32_t SectorDataSize = 2352;
+
+	// The number of hunks kept decompressed
+	static constexpr size_t MaxCachedHunks = 16;
+
+	struct Track {
+		int number = 0;
+		// The CHD track type, such as 'MODE1_RAW' or 'AUDIO'
+		std::string type = {};
+		uint32_t frames  = 0;
+		uint32_t pregap  = 0;
+		uint32_t postgap = 0;
+		// Set if the pregap's frames are stored at the start of the track
+		bool has_pregap_data = false;
+		// The image's frame holding the track's first stored frame
+		uint32_t first_frame = 0;
+	};
+
+	// Opens the image in 'file', taking ownership of it. Returns nullptr,
+	// with the reason in 'error', if the file can't be used; 'error' is
+	// left empty if the file isn't a CHD image at all.
+	static std::unique_ptr<ChdImage> Open(FILE* file, std::string& error);
+
+	static std::unique_ptr<ChdImage> Open(const std::string& path,
+	                                      std::string& error);
+
+	~ChdImage();
+
+	ChdImage(const ChdImage&)            = delete;
+	ChdImage& operator=(const ChdImage&) = delete;
+
+	const std::vector<Track>& GetTracks() const
+	{
+		return tracks;
+	}
+
+	uint32_t GetNumFrames() const
+	{
+		return num_frames;
+	}
+
+	// Copies 'num_bytes' of a frame, starting 'offset' bytes into it
+	bool ReadFrame(uint32_t frame, uint32_t offset, uint8_t* data,
+	               uint32_t num_bytes);
+
+private:
+	struct MapEntry {
+		uint64_t offset     = 0;
+		uint32_t length     = 0;
+		uint16_t crc        = 0;
+		uint8_t compression = 0;
+	};
+
+	using Hunk = std::vector<uint8_t>;
+
+	struct CachedHunk {
+		uint32_t number = 0;
+		Hunk data       = {};
+	};
+
+	ChdImage(FILE* file);
+
+	bool ReadHeader(std::string& error);
+	bool ReadMap(std::string& error);
+	bool ReadMetadata(std::string& error);
+
+	bool ReadFile(uint64_t offset, uint8_t* data, size_t num_bytes);
+	bool DecompressHunk(uint32_t number, Hunk& hunk);
+	const Hunk* GetHunk(uint32_t number);
+	void PrefetchHunk(uint32_t number);
+	void CollectPrefetchedHunk();
+	void CacheHunk(uint32_t number, Hunk&& hunk);
+
+	FILE* file = nullptr;
+	// Serialises the file accesses of the emulation and worker threads
+	std::mutex file_mutex = {};
+
+	std::vector<MapEntry> map = {};
+	std::vector<Track> tracks = {};
+	uint32_t compressors[4]   = {};
+	uint64_t logical_bytes    = 0;
+	uint64_t map_offset       = 0;
+	uint64_t meta_offset      = 0;
+	uint32_t hunk_bytes       = 0;
+	uint32_t frames_per_hunk  = 0;
+	uint32_t num_frames       = 0;
+
+	// Guards the cache and the prefetch
+	std::mutex cache_mutex = {};
+	// Most recently used first
+	std::list<CachedHunk> cached_hunks = {};
+	std::unordered_map<uint32_t, std::list<CachedHunk>::iterator> cache_index = {};
+
+	std::future<bool> prefetch = {};
+	Hunk prefetch_hunk         = {};
+	uint32_t prefetch_number   = 0;
+};
+
+#endif
@@ -56,13 +56,18 @@ struct CommandLineArguments {
 	bool exit;
 	bool securemode;
 	bool noautoexec;
+	bool headless;
+	bool trace_startup;
 	std::string working_dir;
 	std::string lang;
 	std::string machine;
+	std::string record;
+	std::string replay;
 	std::vector<std::string> conf;
 	std::vector<std::string> set;
 	std::optional<std::vector<std::string>> editconf;
 	std::optional<int> socket;
+	std::optional<int> time_limit;
 };
 
 class Config {
@@ -66,6 +66,9 @@ extern int CPU_CycleLimit;
 
 extern int64_t CPU_IODelayRemoved;
 
+// Skip the rest of the cycle slice when the guest busy-waits on a port
+extern bool CPU_SkipIdlePolling;
+
 struct CpuAutoDetermineMode {
 	bool auto_core   = false;
 	bool auto_cycles = false;
@@ -74,6 +77,13 @@ struct CpuAutoDetermineMode {
 extern ArchitectureType CPU_ArchitectureType;
 extern Bitu CPU_PrefetchQueueSize;
 
+// Number of times the dynamic core lets the normal core execute code at a
+// given address before translating it; zero translates everything eagerly
+extern uint8_t CPU_DynamicCoreTranslationThreshold;
+
+// Size of the dynamic core's code cache, applied when it is first allocated
+extern uint16_t CPU_DynamicCoreCacheSizeMb;
+
 void CPU_AddConfigSection(const ConfigPtr& conf);
 
 uint8_t CPU_GetLastInterrupt();
@@ -94,6 +104,11 @@ constexpr bool CPU_UseRwxMemProtect = true;
 
 Bits CPU_Core_Normal_Run() noexcept;
 Bits CPU_Core_Normal_Trap_Run() noexcept;
+#if C_CORE_THREADED_DISPATCH
+// Switches the normal core between its threaded and its switch based opcode
+// dispatch, threaded by default
+void CPU_Core_Normal_SetThreadedDispatch(const bool enabled);
+#endif
 Bits CPU_Core_Simple_Run() noexcept;
 Bits CPU_Core_Simple_Trap_Run() noexcept;
 Bits CPU_Core_Full_Run() noexcept;
@@ -0,0 +1,43 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CPU_BUDGET_H
+#define DOSBOX_CPU_BUDGET_H
+
+// Host CPU budget shared between instances
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Instances running on 'max' cycles each aim to use their 'max' percentage of
+// a host core, so several of them on the same host compete for the cores. With
+// the 'cpu_budget' setting they share a budget instead: each instance of the
+// host user with the same budget gets an equal part of it.
+//
+// The instances find each other through a small table of slots in a file in
+// the temporary directory that they all map into memory. An instance refreshes
+// its slot whenever the cycles get adjusted; stale slots, of paused, fixed
+// cycles and exited instances, don't count and get reused.
+
+// Sets the budget in percent of one host core, 0 disables sharing
+void CPU_BUDGET_Configure(const int budget_percent);
+
+// Returns this instance's part of the budget in percent of one host core, at
+// most 'max_percent'
+int CPU_BUDGET_GetShare(const int max_percent);
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_DIR_PREFETCHER_H
+#define DOSBOX_DIR_PREFETCHER_H
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "std_filesystem.h"
+
+// Lists the directories of a host directory tree on a background thread,
+// breadth-first from its base, so the drive cache doesn't have to wait for
+// the host when it first reads a directory. Listings are keyed by the
+// directory's host path with a trailing separator, the way the drive cache
+// names its directories. A listing is handed out once, and dropped if the
+// directory has been modified since it was listed.
+class DirPrefetcher {
+public:
+	struct Entry {
+		std::string name = {};
+		bool is_directory = false;
+	};
+
+	// Stops listing after 'max_entries' entries in total
+	DirPrefetcher(const std::string& base_dir, size_t max_entries = 200000);
+	~DirPrefetcher();
+
+	DirPrefetcher(const DirPrefetcher&)            = delete;
+	DirPrefetcher& operator=(const DirPrefetcher&) = delete;
+
+	// Moves out the listing of a directory, if it's been listed and is
+	// still current
+	std::optional<std::vector<Entry>> Take(const std::string& dir);
+
+	// Waits for the whole tree to be listed
+	void Wait();
+
+	size_t GetNumListings();
+
+private:
+	struct Listing {
+		std::vector<Entry> entries = {};
+		std_fs::file_time_type last_write_time = {};
+	};
+
+	void Run(std::string base_dir, size_t max_entries);
+
+	std::mutex mutex = {};
+	std::unordered_map<std::string, Listing> listings = {};
+	std::atomic<bool> stop_requested = false;
+	std::thread thread = {};
+};
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_DISK_IMAGE_OVERLAY_H
+#define DOSBOX_DISK_IMAGE_OVERLAY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "cross.h"
+
+// Copy-on-write overlay of a disk image
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Holds the blocks written to a disk image in a separate, sparse delta file,
+// leaving the base image unchanged so any number of instances can share it.
+//
+// The delta file starts with a header identifying the base image by its
+// size, followed by records of a block number and the block's data. Records
+// are appended when a block is first written and updated in place after
+// that, so the file only grows by the blocks actually changed.
+class DiskImageOverlay {
+public:
+	static constexpr uint32_t BlockSize = 512;
+
+	// Opens the delta file at 'path', creating it if it doesn't exist.
+	// Returns nullptr if the file can't be opened, or if it's not an
+	// overlay of an image of 'image_size_kb' KB.
+	static std::unique_ptr<DiskImageOverlay> Open(const std::string& path,
+	                                              uint32_t image_size_kb);
+
+	DiskImageOverlay(const DiskImageOverlay&)            = delete;
+	DiskImageOverlay& operator=(const DiskImageOverlay&) = delete;
+
+	~DiskImageOverlay();
+
+	bool Contains(uint32_t block) const
+	{
+		return index.find(block) != index.end();
+	}
+
+	// Reads a block from the delta file, returning false if the block
+	// hasn't been written to the overlay or on read errors
+	bool Read(uint32_t block, void* data);
+
+	bool Write(uint32_t block, const void* data);
+
+	size_t GetNumBlocks() const
+	{
+		return index.size();
+	}
+
+private:
+	explicit DiskImageOverlay(FILE* delta_file);
+
+	bool LoadIndex(uint32_t image_size_kb);
+
+	bool Seek(cross_off_t offset);
+
+	FILE* file = nullptr;
+
+	// Offsets of the blocks' data in the delta file
+	std::unordered_map<uint32_t, cross_off_t> index = {};
+
+	cross_off_t end_offset = 0;
+};
+
+#endif
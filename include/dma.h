@@ -24,6 +24,7 @@
 
 #include <cassert>
 #include <functional>
+#include <span>
 
 #include "inout.h"
 #include "support.h"
@@ -77,6 +78,16 @@ public:
 	size_t Read(size_t words, uint8_t* const dest_buffer);
 	size_t Write(size_t words, uint8_t* const src_buffer);
 
+	// Returns the guest memory the next read of up to 'words' would
+	// transfer, as long as it's contiguous in host memory. The span can be
+	// shorter than requested (or empty) if the transfer crosses into a
+	// differently mapped page, the end of the guest's RAM, or terminal
+	// count. Consume the words with Skip() after using them in place.
+	std::span<const uint8_t> PeekRead(size_t words) const;
+
+	// Advances the channel like Read(), without copying any data
+	size_t Skip(size_t words);
+
 	// Reset the channel back to defaults, without callbacks or reservations.
 	void Reset();
 
@@ -139,6 +139,7 @@ enum { HAND_NONE=0,HAND_FILE,HAND_DEVICE};
 
 void DOS_SetupFiles (void);
 bool DOS_ReadFile(uint16_t handle,uint8_t * data,uint16_t * amount, bool fcb = false);
+bool DOS_ReadFileToMemory(uint16_t handle, PhysPt dest, uint16_t* amount);
 bool DOS_WriteFile(uint16_t handle,uint8_t * data,uint16_t * amount,bool fcb = false);
 bool DOS_SeekFile(uint16_t handle,uint32_t * pos,uint32_t type,bool fcb = false);
 bool DOS_CloseFile(uint16_t handle,bool fcb = false,uint8_t * refcnt = nullptr);
@@ -226,6 +227,12 @@ bool DOS_Canonicalize(const char* const name, char* const canonicalized);
 std::string DOS_Canonicalize(const char* const name);
 bool DOS_CreateTempFile(char* const name, uint16_t* entry);
 bool DOS_FileExists(const char* const name);
+
+// The generation changes whenever a drive is mounted or unmounted, a
+// directory is changed, or files might have been created, renamed, or
+// deleted, so lookups of file names can be cached until it does
+void DOS_NotifyFilesChanged();
+uint32_t DOS_GetFilesGeneration();
 bool DOS_LockFile(const uint16_t entry, const uint32_t pos, const uint32_t len);
 bool DOS_UnlockFile(const uint16_t entry, const uint32_t pos, const uint32_t len);
 
@@ -682,6 +689,9 @@ public:
 	uint8_t GetSearchDrive() const { return SGET_BYTE(sDTA, sdrive); }
 	void GetSearchParams(FatAttributeFlags& attr, char* pattern) const;
 
+	// The pattern in the space-padded 8.3 form GetSearchParams returns
+	static std::string ToSearchPattern(const char* pattern);
+
 	struct Result {
 		std::string name = {};
 
@@ -745,6 +755,11 @@ enum class ResultSorting {
 	ByDateTime,
 };
 
+// Returns all the matches of a search at once, without touching the current
+// DTA; for the shell's own directory listings
+bool DOS_FindAll(const char* search, FatAttributeFlags attr,
+                 std::vector<DOS_DTA::Result>& results);
+
 void DOS_Sort(std::vector<DOS_DTA::Result>& list, const ResultSorting sorting,
               const bool reverse_order      = false,
               const ResultGrouping grouping = ResultGrouping::None);
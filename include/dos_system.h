@@ -22,6 +22,9 @@
 
 #include "dosbox.h"
 
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -196,6 +199,9 @@ private:
 #define MAX_OPENDIRS 2048
 //Can be high as it's only storage (16 bit variable)
 
+class DirPrefetcher;
+class HostDirWatcher;
+
 class DOS_Drive_Cache {
 public:
 	enum TDirSort { NOSORT, ALPHABETICAL, DIRALPHABETICAL, ALPHABETICALREV, DIRALPHABETICALREV };
@@ -208,6 +214,29 @@ public:
 	void SetBaseDir(const char *path);
 	void SetDirSort(TDirSort sort) { sortDirType = sort; }
 
+	// Starts listing the base directory's tree in the background
+	void StartPrefetch();
+
+	// Refreshes cached directories when they're changed on the host
+	void StartWatching();
+
+	// Lists the directories with the given function instead of the host's,
+	// for drives whose contents aren't on the host. It's given the base
+	// directory's path joined with the directory's, ending in a separator,
+	// and returns nothing if the directory doesn't exist. It has to be set
+	// before the base directory, which is listed right away.
+	struct ListedEntry {
+		std::string name  = {};
+		bool is_directory = false;
+	};
+	using DirLister = std::function<std::optional<std::vector<ListedEntry>>(
+	        const std::string& dir)>;
+
+	void SetDirLister(DirLister lister)
+	{
+		dirLister = std::move(lister);
+	}
+
 	bool  OpenDir              (const char* path, uint16_t& id);
 	bool  ReadDir              (uint16_t id, char* &result);
 
@@ -281,6 +310,9 @@ private:
 	void		CopyEntry		(CFileInfo* dir, CFileInfo* from);
 	uint16_t		GetFreeID		(CFileInfo* dir);
 	void		Clear			(void);
+	void		CacheOutDir		(CFileInfo* dir);
+	CFileInfo*	FindCachedDir		(const std::string& host_dir);
+	void		ProcessHostChanges	(void);
 
 	CFileInfo*	dirBase;
 	char		dirPath				[CROSS_LEN];
@@ -297,6 +329,10 @@ private:
 
 	char		label				[CROSS_LEN];
 	bool		updatelabel;
+
+	std::unique_ptr<DirPrefetcher> prefetcher;
+	std::unique_ptr<HostDirWatcher> watcher;
+	DirLister dirLister = {};
 };
 
 enum class DosDriveType : uint16_t {
@@ -306,6 +342,7 @@ enum class DosDriveType : uint16_t {
 	Fat     = 3,
 	Iso     = 4,
 	Virtual = 5,
+	Zip     = 6,
 };
 
 class DOS_Drive {
@@ -324,6 +361,26 @@ public:
 	virtual bool FindFirst(const char* dir, DOS_DTA& dta,
 	                       bool fcb_findfirst = false)                  = 0;
 	virtual bool FindNext(DOS_DTA& dta)                                 = 0;
+
+	// Receives the search results of FindAll, like DOS_DTA::SetResult
+	using FindResultCallback = std::function<void(const char* name,
+	                                              uint32_t size,
+	                                              uint16_t date,
+	                                              uint16_t time,
+	                                              FatAttributeFlags attr)>;
+
+	// Reports all the entries of 'dir' matching the search at once, for
+	// the shell's own listings; 'search_pattern' is in the space-padded
+	// 8.3 form of the DTA. Returns whether anything was found, or nothing
+	// if the drive has no batch enumeration, in which case the search has
+	// to go through FindFirst and FindNext.
+	virtual std::optional<bool> FindAll([[maybe_unused]] const char* dir,
+	                                    [[maybe_unused]] FatAttributeFlags attr,
+	                                    [[maybe_unused]] const char* search_pattern,
+	                                    [[maybe_unused]] const FindResultCallback& on_result)
+	{
+		return {};
+	}
 	virtual bool GetFileAttr(const char* name, FatAttributeFlags* attr) = 0;
 	virtual bool SetFileAttr(const char* name, const FatAttributeFlags attr) = 0;
 	virtual bool Rename(const char* oldname, const char* newname) = 0;
@@ -334,6 +391,8 @@ public:
 	virtual uint8_t GetMediaByte(void)                            = 0;
 	virtual void SetDir(const char* path);
 	virtual void EmptyCache() { dirCache.EmptyCache(); }
+	// Writes back any buffered writes to the underlying storage
+	virtual void FlushBuffers() {}
 	virtual bool IsReadOnly() const = 0;
 	virtual bool IsRemote(void)     = 0;
 	virtual bool IsRemovable(void)  = 0;
@@ -360,6 +419,8 @@ public:
 		case DosDriveType::Iso:
 			return MSG_Get("MOUNT_TYPE_ISO") + std::string(" ") + info;
 		case DosDriveType::Virtual: return MSG_Get("MOUNT_TYPE_VIRTUAL");
+		case DosDriveType::Zip:
+			return MSG_Get("MOUNT_TYPE_ZIP") + std::string(" ") + info;
 		default: return MSG_Get("MOUNT_TYPE_UNKNOWN");
 		}
 	}
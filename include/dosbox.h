@@ -78,6 +78,13 @@ int64_t DOSBOX_GetTicksDone();
 void DOSBOX_SetTicksDone(const int64_t ticks_done);
 void DOSBOX_SetTicksScheduled(const int64_t ticks_scheduled);
 
+// The emulated milliseconds still to run to catch up with the host's time
+int64_t DOSBOX_GetTicksRemaining();
+
+// Shifts the emulated time against the host's by whole ticks: positive
+// values hold the emulation back, negative ones let it run ahead
+void DOSBOX_ShiftTicks(const int64_t num_ticks);
+
 enum SVGACards {
 	SVGA_None,
 	SVGA_S3Trio,
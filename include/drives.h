@@ -21,6 +21,7 @@
 
 #include "dosbox.h"
 
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -29,6 +30,8 @@
 
 #include "dos_inc.h"
 #include "dos_system.h"
+#include "sector_cache.h"
+#include "zip_archive.h"
 
 // GCC throws a warning about non-virtual destructor for std::enable_shared_from_this
 // This is normally a helpful warning. Ex: If DOS_Drive had a non-virtual destructor, it would be a problem.
@@ -93,6 +96,9 @@ public:
 	bool TestDir(const char* dir) override;
 	bool FindFirst(const char* _dir, DOS_DTA& dta, bool fcb_findfirst = false) override;
 	bool FindNext(DOS_DTA& dta) override;
+	std::optional<bool> FindAll(const char* _dir, FatAttributeFlags attr,
+	                            const char* search_pattern,
+	                            const FindResultCallback& on_result) override;
 	bool GetFileAttr(const char* name, FatAttributeFlags* attr) override;
 	bool SetFileAttr(const char* name, const FatAttributeFlags attr) override;
 	bool Rename(const char* oldname, const char* newname) override;
@@ -105,6 +111,7 @@ public:
 	bool IsRemote(void) override;
 	bool IsRemovable(void) override;
 	Bits UnMount(void) override;
+	void FlushBuffers() override;
 	const char* GetBasedir() const
 	{
 		return basedir;
@@ -119,6 +126,9 @@ protected:
 	} srchInfo[MAX_OPENDIRS];
 
 private:
+	bool FindNextMatch(uint16_t id, FatAttributeFlags search_attr,
+	                   const char* search_pattern,
+	                   const FindResultCallback& on_result);
 	void MaybeLogFilesystemProtection(const std::string& filename);
 	bool FileIsReadOnly(const char* name);
 	const bool readonly;
@@ -197,9 +207,10 @@ class fatDrive final : public DOS_Drive, public std::enable_shared_from_this<fat
 public:
 	fatDrive(const char* sysFilename, uint32_t bytesector,
 	         uint32_t cylsector, uint32_t headscyl, uint32_t cylinders,
-	         bool roflag);
+	         bool roflag, const std::string& overlay_filename = {});
 	fatDrive(const fatDrive&)            = delete; // prevent copying
 	fatDrive& operator=(const fatDrive&) = delete; // prevent assignment
+	~fatDrive() override;
 	std::unique_ptr<DOS_File> FileOpen(const char* name, uint8_t flags) override;
 	std::unique_ptr<DOS_File> FileCreate(const char* name,
 	                                     FatAttributeFlags attributes) override;
@@ -221,16 +232,27 @@ public:
 	bool IsRemote(void) override;
 	bool IsRemovable(void) override;
 	Bits UnMount(void) override;
-	void EmptyCache(void) override {}
+	void EmptyCache(void) override;
+	void FlushBuffers() override;
 
 public:
+	// Accesses the FAT and directory sectors through the sector cache
 	uint8_t readSector(uint32_t sectnum, void * data);
 	uint8_t writeSector(uint32_t sectnum, void * data);
+
+	// Accesses file data sectors, which are only served from the sector
+	// cache if they're already in it
+	uint8_t readDataSector(uint32_t sectnum, void* data);
+	uint8_t readDataSectors(uint32_t sectnum, uint32_t num_sectors, void* data);
+	uint8_t writeDataSector(uint32_t sectnum, void* data);
 	uint32_t getAbsoluteSectFromBytePos(uint32_t startClustNum, uint32_t bytePos);
 	uint32_t getSectorCount();
 	uint32_t getSectorSize(void);
 	uint32_t getClusterSize(void);
 	uint32_t getAbsoluteSectFromChain(uint32_t startClustNum, uint32_t logicalSector);
+	uint32_t getClustFirstSect(uint32_t clustNum);
+	// Returns false at the end of the cluster chain
+	bool getNextCluster(uint32_t clustNum, uint32_t* nextClust);
 	bool allocateCluster(uint32_t useCluster, uint32_t prevCluster);
 	uint32_t appendCluster(uint32_t startCluster);
 	void deleteClustChain(uint32_t startCluster, uint32_t bytePos);
@@ -244,7 +266,6 @@ public:
 private:
 	uint32_t getClusterValue(uint32_t clustNum);
 	void setClusterValue(uint32_t clustNum, uint32_t clustValue);
-	uint32_t getClustFirstSect(uint32_t clustNum);
 	bool FindNextInternal(uint32_t dirClustNumber, DOS_DTA & dta, direntry *foundEntry);
 	bool getDirClustNum(const char * dir, uint32_t * clustNum, bool parDir);
 	bool getFileDirEntry(const char* const filename, direntry* useEntry,
@@ -253,6 +274,8 @@ private:
 	bool addDirectoryEntry(uint32_t dirClustNumber, direntry useEntry);
 	void zeroOutCluster(uint32_t clustNumber);
 	bool getEntryName(const char *fullname, char *entname);
+	uint8_t readSectorFromDisk(uint32_t sectnum, void* data);
+	uint8_t writeSectorToDisk(uint32_t sectnum, const void* data);
 	
 	bootstrap bootbuffer;
 	bool absolute;
@@ -266,6 +289,8 @@ private:
 
 	uint8_t fatSectBuffer[1024];
 	uint32_t curFatSect;
+
+	SectorCache sector_cache;
 };
 
 class cdromDrive final : public localDrive
@@ -284,6 +309,9 @@ public:
 	bool Rename(const char* oldname, const char* newname) override;
 	bool GetFileAttr(const char* name, FatAttributeFlags* attr) override;
 	bool FindFirst(const char* _dir, DOS_DTA& dta, bool fcb_findfirst = false) override;
+	std::optional<bool> FindAll(const char* _dir, FatAttributeFlags attr,
+	                            const char* search_pattern,
+	                            const FindResultCallback& on_result) override;
 	void SetDir(const char* path) override;
 	bool IsRemote(void) override;
 	bool IsRemovable(void) override;
@@ -369,7 +397,6 @@ struct isoDirEntry {
 #define IS_ASSOC(fileFlags)	(!!(fileFlags & ISO_ASSOCIATED))
 #define IS_DIR(fileFlags)	(!!(fileFlags & ISO_DIRECTORY))
 #define IS_HIDDEN(fileFlags)	(!!(fileFlags & ISO_HIDDEN))
-#define ISO_MAX_HASH_TABLE_SIZE 	100
 
 // Must be constructed with a shared_ptr or it will throw an exception on internal call to shared_from_this()
 class isoDrive final : public DOS_Drive, public std::enable_shared_from_this<isoDrive> {
@@ -427,11 +454,13 @@ private:
 	
 	int nextFreeDirIterator;
 	
-	struct SectorHashEntry {
+	// The directory sector last read. Image sectors are cached by their
+	// CD-ROM interface, shared with the MSCDEX reads.
+	struct CachedSector {
 		bool valid;
 		uint32_t sector;
 		uint8_t data[ISO_FRAMESIZE];
-	} sectorHashEntries[ISO_MAX_HASH_TABLE_SIZE];
+	} cachedDirSector;
 
 	bool iso;
 	bool dataCD;
@@ -443,6 +472,58 @@ private:
 	char discLabel[32];
 };
 
+// A read-only drive of a ZIP archive's contents. The archive's index is
+// read when it's mounted, and its files are decompressed as they're read.
+class zipDrive final : public DOS_Drive, public std::enable_shared_from_this<zipDrive> {
+public:
+	zipDrive(const char* archive_path, std::unique_ptr<ZipArchive> zip_archive,
+	         uint8_t mediaid);
+	std::unique_ptr<DOS_File> FileOpen(const char* name, uint8_t flags) override;
+	std::unique_ptr<DOS_File> FileCreate(const char* name,
+	                                     FatAttributeFlags attributes) override;
+	bool FileUnlink(const char* name) override;
+	bool RemoveDir(const char* dir) override;
+	bool MakeDir(const char* dir) override;
+	bool TestDir(const char* dir) override;
+	bool FindFirst(const char* _dir, DOS_DTA& dta, bool fcb_findfirst) override;
+	bool FindNext(DOS_DTA& dta) override;
+	bool GetFileAttr(const char* name, FatAttributeFlags* attr) override;
+	bool SetFileAttr(const char* name, const FatAttributeFlags attr) override;
+	bool Rename(const char* oldname, const char* newname) override;
+	bool AllocationInfo(uint16_t* bytes_sector, uint8_t* sectors_cluster,
+	                    uint16_t* total_clusters,
+	                    uint16_t* free_clusters) override;
+	bool FileExists(const char* name) override;
+	uint8_t GetMediaByte(void) override;
+	void EmptyCache(void) override {}
+	bool IsReadOnly() const override { return true; }
+	bool IsRemote(void) override;
+	bool IsRemovable(void) override;
+	Bits UnMount(void) override;
+
+private:
+	std::string ToArchivePath(const char* host_path) const;
+	const ZipArchive::Entry* FindEntry(const char* dos_name);
+	const ZipArchive::Entry* FindEntry(const std::string& archive_path) const;
+	std::shared_ptr<ZipEntryReader> GetReader(const ZipArchive::Entry& entry);
+
+	std::unique_ptr<ZipArchive> archive = {};
+
+	// The readers of the files opened last, most recently used first, kept
+	// so reopened files don't have to be decompressed again
+	std::list<std::pair<const ZipArchive::Entry*, std::shared_ptr<ZipEntryReader>>> kept_readers = {};
+
+	ZipArchive::Entry root              = {};
+	uint8_t mediaid                     = 0;
+
+	// The archive's path with a trailing separator, the base of the
+	// paths given to the drive cache
+	char basedir[CROSS_LEN] = "";
+	struct {
+		char srch_dir[CROSS_LEN] = "";
+	} srchInfo[MAX_OPENDIRS];
+};
+
 class VFILE_Block;
 using vfile_block_t = std::shared_ptr<VFILE_Block>;
 
@@ -477,7 +558,6 @@ private:
 	Virtual_Drive(const Virtual_Drive&); // prevent copying
 	Virtual_Drive& operator= (const Virtual_Drive&); // prevent assignment
 	vfile_block_t search_file;
-	bool is_name_equal(vfile_block_t file_block, const char* name) const;
 	vfile_block_t find_vfile_by_name(const char* name) const;
 	vfile_block_t find_vfile_dir_by_name(const char* dir) const;
 	bool vfile_name_exists(const std::string& name) const;
@@ -501,6 +581,12 @@ public:
 	                                     FatAttributeFlags attributes) override;
 	bool FindFirst(const char* _dir, DOS_DTA& dta, bool fcb_findfirst) override;
 	bool FindNext(DOS_DTA& dta) override;
+	// The overlay merges the listings in its FindFirst and FindNext
+	std::optional<bool> FindAll(const char*, FatAttributeFlags, const char*,
+	                            const FindResultCallback&) override
+	{
+		return {};
+	}
 	bool FileUnlink(const char* name) override;
 	bool GetFileAttr(const char* name, FatAttributeFlags* attr) override;
 	bool SetFileAttr(const char* name, const FatAttributeFlags attr) override;
@@ -525,8 +611,8 @@ private:
 	void remove_DOSdir_from_cache(const char* name);
 	void update_cache(bool read_directory_contents = false);
 
-	std::vector<std::string> deleted_files_in_base; //Set is probably better, or some other solution (involving the disk).
-	std::vector<std::string> deleted_paths_in_base; //Currently only used to hide the overlay folder.
+	std::unordered_set<std::string> deleted_files_in_base;
+	std::unordered_set<std::string> deleted_paths_in_base; //Currently only used to hide the overlay folder.
 	std::string overlap_folder;
 	void add_deleted_file(const char* name, bool create_on_disk);
 	void remove_deleted_file(const char* name, bool create_on_disk);
@@ -537,6 +623,7 @@ private:
 	bool check_if_leading_is_deleted(const char* name);
 
 	bool is_dir_only_in_overlay(const char* name); //cached
+	bool is_file_in_overlay(const char* name);     //cached
 
 
 	void remove_special_file_from_disk(const char* dosname, const char* operation);
@@ -544,8 +631,11 @@ private:
 	std::string create_filename_of_special_operation(const char* dosname, const char* operation);
 	void convert_overlay_to_DOSname_in_base(char* dirname );
 	//For caching the update_cache routine.
-	std::vector<std::string> DOSnames_cache; //Also set is probably better.
+	// DOS names of the files present in the overlay, kept up to date by the
+	// operations writing to it so lookups don't have to query the host
+	std::unordered_set<std::string> DOSnames_cache;
 	std::vector<std::string> DOSdirs_cache; //Can not blindly change its type. it is important that subdirs come after the parent directory.
+	std::unordered_set<std::string> DOSdirs_index; // Lookups in DOSdirs_cache
 	const std::string special_prefix;
 };
 
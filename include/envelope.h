@@ -74,6 +74,12 @@ public:
 
 	void Reactivate();
 
+	// Whether 'Process' still changes the frames
+	bool IsActive() const
+	{
+		return is_active;
+	}
+
 	// prevent copying
 	Envelope(const Envelope&) = delete;
 
@@ -91,6 +97,7 @@ private:
 
 	using process_f   = std::function<void(Envelope&, bool, AudioFrame&)>;
 	process_f process = &Envelope::Apply;
+	bool is_active    = true;
 
 	std::string channel_name = {};
 
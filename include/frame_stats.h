@@ -0,0 +1,88 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_FRAME_STATS_H
+#define DOSBOX_FRAME_STATS_H
+
+#include <cstdint>
+#include <string>
+
+#include "timer.h"
+
+// Frame statistics
+// ~~~~~~~~~~~~~~~~
+// Measures where the host's time goes for each frame, in release builds as
+// well (the Tracy zones only exist in profiling builds):
+//
+//  - render:    drawing the frame's lines, from VGA_DrawPart to the scalers
+//  - upload:    handing the finished frame to the output (the texture upload)
+//  - present:   presenting it, including waiting for the previous one
+//  - emulation: the rest of the time between two frames
+//
+// With the audio buffer level sampled at the end of every frame. A summary is
+// logged every second, and every frame's measurements can be written to a CSV
+// file for tracking regressions. Everything runs on the emulation thread.
+
+enum class FrameStage { Render, Upload, Present };
+
+// Configures the statistics from the 'frame_stats' setting: "off", "log", or
+// the path of a CSV file to write as well
+void FRAMESTATS_Init(const std::string& setting);
+
+bool FRAMESTATS_IsEnabled();
+
+void FRAMESTATS_AddStageTime(const FrameStage stage, const int64_t elapsed_us);
+
+// Completes the current frame's measurements
+void FRAMESTATS_EndFrame();
+
+// Adds the time spent in its scope to a stage of the current frame
+class FrameStageTimer {
+public:
+	explicit FrameStageTimer(const FrameStage stage)
+	        : stage(stage),
+	          is_timing(FRAMESTATS_IsEnabled()),
+	          start_us(is_timing ? GetTicksUs() : 0)
+	{}
+
+	~FrameStageTimer()
+	{
+		Stop();
+	}
+
+	// Ends the timing before the end of the scope
+	void Stop()
+	{
+		if (is_timing) {
+			FRAMESTATS_AddStageTime(stage, GetTicksUsSince(start_us));
+			is_timing = false;
+		}
+	}
+
+	FrameStageTimer(const FrameStageTimer&)            = delete;
+	FrameStageTimer& operator=(const FrameStageTimer&) = delete;
+
+private:
+	const FrameStage stage;
+	bool is_timing;
+	const int64_t start_us;
+};
+
+#endif
@@ -226,4 +226,20 @@ bool truncate_native_file(const NativeFileHandle handle);
 DosDateTime get_dos_file_time(const NativeFileHandle handle);
 void set_dos_file_time(const NativeFileHandle handle, const uint16_t date, const uint16_t time);
 
+// Read-only memory mapping of a whole file. The mapped pages are backed by the
+// host's page cache, so all the processes mapping the same file share a single
+// copy of it instead of each reading it into private memory.
+struct MappedFile {
+	const uint8_t* data = nullptr;
+	size_t size         = 0;
+#if defined(WIN32)
+	HANDLE mapping = nullptr;
+#endif
+};
+
+// Returns an empty optional if the file can't be mapped, or is empty
+std::optional<MappedFile> map_native_file(const std_fs::path& path);
+
+void unmap_native_file(MappedFile& file);
+
 #endif
@@ -0,0 +1,88 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_GUEST_STATS_H
+#define DOSBOX_GUEST_STATS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Section;
+
+// Guest performance counters
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Always-on counters of what the emulated machine spends its time on, shown
+// by the STATS program and logged periodically if 'stats_log_interval' is
+// set. They're plain counters, only written from the emulation thread, so
+// counting costs no more than an increment on the hot paths.
+
+enum class StatsCore : uint8_t { Normal, Simple, Full, Dynamic, Other };
+
+constexpr size_t NumStatsCores = 5;
+
+struct GuestStats {
+	// Emulated cycles executed with each CPU core, one per instruction in
+	// the interpreting cores
+	std::array<uint64_t, NumStatsCores> cycles = {};
+
+	// Blocks the dynamic cores translated, and threw away because the
+	// guest modified their code
+	uint64_t dyn_blocks_translated  = 0;
+	uint64_t dyn_blocks_invalidated = 0;
+
+	uint64_t pic_events  = 0;
+	uint64_t page_faults = 0;
+	uint64_t tlb_flushes = 0;
+
+	// Page faults whose handler had to run in a nested loop, as they
+	// happened in the middle of an instruction
+	uint64_t nested_page_faults = 0;
+
+	// Reads and writes of each I/O port
+	std::array<uint64_t, 65536> io_port_accesses = {};
+
+	// INT 21h calls of each function, by AH
+	std::array<uint64_t, 256> int21_calls = {};
+};
+
+extern GuestStats guest_stats;
+
+const char* STATS_GetCoreName(StatsCore core);
+
+struct StatsCount {
+	uint32_t index = 0;
+	uint64_t count = 0;
+};
+
+// Returns the non-zero counts in descending order, at most 'max_entries' of
+// them
+std::vector<StatsCount> STATS_GetTopCounts(const uint64_t* counts,
+                                           size_t num_counts, size_t max_entries);
+
+// Returns the host time in seconds since the counters were last reset
+double STATS_GetSecondsSinceReset();
+
+void STATS_Reset();
+
+void STATS_Init(Section* sec);
+
+#endif
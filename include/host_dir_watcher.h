@@ -0,0 +1,70 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_HOST_DIR_WATCHER_H
+#define DOSBOX_HOST_DIR_WATCHER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports the files and directories that get added to or removed from
+// watched host directories, so cached listings of them can be refreshed
+// without rescanning the whole drive. Only implemented with inotify on Linux
+// hosts; elsewhere, nothing can be watched.
+class HostDirWatcher {
+public:
+	enum class Change {
+		Added,
+		Removed,
+		// Events were lost, so any watched directory may have changed
+		Overflow,
+	};
+
+	struct Event {
+		// The directory's path as passed to Watch()
+		std::string dir = {};
+		std::string name = {};
+		Change change = Change::Added;
+	};
+
+	HostDirWatcher();
+	~HostDirWatcher();
+
+	HostDirWatcher(const HostDirWatcher&)            = delete;
+	HostDirWatcher& operator=(const HostDirWatcher&) = delete;
+
+	bool IsSupported() const
+	{
+		return fd >= 0;
+	}
+
+	// Watching a directory again is harmless
+	void Watch(const std::string& dir);
+
+	// Returns the changes since the last call, without blocking
+	std::vector<Event> TakeEvents();
+
+private:
+	int fd = -1;
+	std::unordered_map<int, std::string> watched_dirs = {};
+};
+
+#endif
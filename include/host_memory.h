@@ -0,0 +1,95 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_HOST_MEMORY_H
+#define DOSBOX_HOST_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Host memory accounting
+// ~~~~~~~~~~~~~~~~~~~~~~
+// The subsystems holding large buffers count them here, so the 'MEM /HOST'
+// command and the log at exit can break down where the process' memory
+// goes. Blocks tracked with their address also report how much of them
+// the host has actually committed, which is often far less than their size
+// for the lazily mapped buffers, like the video memory. Counted-only bytes,
+// like queued data, are assumed to be resident.
+
+enum class HostMemoryUse : uint8_t {
+	GuestRam,
+	VideoMemory,
+	DynrecCache,
+	Voodoo,
+	SoundFonts,
+	Mt32Roms,
+	MixerBuffers,
+	CaptureQueues,
+};
+
+constexpr auto NumHostMemoryUses = static_cast<size_t>(HostMemoryUse::CaptureQueues) + 1;
+
+// Counting can be done from any thread
+void HOST_MEMORY_Add(const HostMemoryUse use, const size_t num_bytes);
+void HOST_MEMORY_Remove(const HostMemoryUse use, const size_t num_bytes);
+
+// A block of memory that's counted for as long as the object lives
+class TrackedHostMemory {
+public:
+	explicit TrackedHostMemory(const HostMemoryUse use);
+	~TrackedHostMemory();
+
+	TrackedHostMemory(const TrackedHostMemory&)            = delete;
+	TrackedHostMemory& operator=(const TrackedHostMemory&) = delete;
+
+	// Replaces the tracked block; without 'data', the bytes are only
+	// counted
+	void Track(const void* data, const size_t num_bytes);
+
+	void Clear()
+	{
+		Track(nullptr, 0);
+	}
+
+private:
+	HostMemoryUse use = {};
+	const void* data  = nullptr;
+	size_t num_bytes  = 0;
+};
+
+struct HostMemoryUsage {
+	HostMemoryUse use         = {};
+	size_t num_bytes          = 0;
+	size_t num_resident_bytes = 0;
+};
+
+std::vector<HostMemoryUsage> HOST_MEMORY_GetUsage();
+
+const char* HOST_MEMORY_GetName(const HostMemoryUse use);
+
+// The resident memory of the whole process, if the host reports it
+std::optional<size_t> HOST_MEMORY_GetProcessResidentBytes();
+std::optional<size_t> HOST_MEMORY_GetProcessPeakResidentBytes();
+
+void HOST_MEMORY_LogUsage();
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_HOST_THREADS_H
+#define DOSBOX_HOST_THREADS_H
+
+#include <string>
+#include <thread>
+
+// Host CPU affinity and priority of the emulator's threads
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The threads are put in three groups, configured with the 'thread_affinity'
+// and 'thread_priority' settings:
+//
+// - Emulation: the main thread running the emulated machine.
+// - Audio: the mixer's threads, and the threads rendering or decoding audio
+//   on its behalf (OPL, MT-32, FluidSynth, CD audio).
+// - Worker: the helper threads doing everything else (Voodoo rasterisation,
+//   captures, ReelMagic decoding, directory prefetching).
+//
+// Threads of groups without a set affinity may run on any core, even if the
+// emulation thread they were started from is pinned.
+
+enum class HostThreadGroup { Emulation, Audio, Worker };
+
+// Reads the group's settings: 'auto' or a list of cores and core ranges such
+// as '2,3' or '4-7' for the affinity, and 'auto', 'lowest', 'lower',
+// 'normal', 'higher' or 'highest' for the priority
+void HOST_THREADS_Configure(const HostThreadGroup group,
+                            const std::string& affinity_pref,
+                            const std::string& priority_pref);
+
+// Applies the group's settings to a newly started thread
+void HOST_THREADS_Apply(std::thread& thread, const HostThreadGroup group);
+
+void HOST_THREADS_ApplyToCurrentThread(const HostThreadGroup group);
+
+#endif
@@ -37,6 +37,10 @@ uint8_t IO_ReadB(io_port_t port);
 uint16_t IO_ReadW(io_port_t port);
 uint32_t IO_ReadD(io_port_t port);
 
+// Read handlers whose value changes at a known emulated time (in PIC_FullIndex
+// milliseconds) call this, so skipping idle polling loops doesn't skip past it
+void IO_SetPollingDeadline(const double deadline_ms);
+
 // type-sized IO handler API
 enum class io_width_t : uint8_t {
 	byte = 1, // bytes
@@ -158,6 +162,10 @@ constexpr io_port_t port_num_fast_a20 = 0x92u;
 constexpr io_port_t port_num_pci_config_address = 0xcf8u;
 constexpr io_port_t port_num_pci_config_data    = 0xcfcu;
 
+// PCI bus-master IDE registers, 8 per channel
+// (can be moved, but the four last bits have to be 0)
+constexpr io_port_t port_num_bus_master_ide = 0xffa0u;
+
 // VirtualBox communication interface
 // (can be moved, but two last bits have to be 0)
 constexpr io_port_t port_num_virtualbox = 0x5654u;
@@ -23,6 +23,10 @@
 
 #include <SDL_net.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 struct packetBuffer {
 	uint8_t buffer[1024];
 	int16_t packetSize;  // Packet size remaining in read
@@ -32,14 +36,25 @@ struct packetBuffer {
 	bool waitsize;
 };
 
-#define SOCKETTABLESIZE 16
+// A client connected to the IPX tunneling server, with its traffic counts
+struct IpxServerClient {
+	IPaddress address = {};
+
+	uint64_t packets_received = 0;
+	uint64_t bytes_received   = 0;
+	uint64_t packets_sent     = 0;
+	uint64_t bytes_sent       = 0;
+};
+
+constexpr size_t IpxServerMaxClients = 256;
 #define CONVIP(hostvar) hostvar & 0xff, (hostvar >> 8) & 0xff, (hostvar >> 16) & 0xff, (hostvar >> 24) & 0xff
 #define CONVIPX(hostvar) hostvar[0], hostvar[1], hostvar[2], hostvar[3], hostvar[4], hostvar[5]
 
 
 void IPX_StopServer();
 bool IPX_StartServer(uint16_t portnum);
-bool IPX_isConnectedToServer(Bits tableNum, IPaddress ** ptrAddr);
+// Returns a snapshot of the clients connected to the server
+std::vector<IpxServerClient> IPX_GetServerClients();
 
 uint8_t packetCRC(uint8_t *buffer, uint16_t bufSize);
 
@@ -166,6 +166,11 @@ static inline uint64_t phys_readq(PhysPt addr)
 void MEM_BlockWrite(PhysPt pt, const void *data, size_t size);
 void MEM_BlockRead(PhysPt pt, void *data, Bitu size);
 void MEM_BlockCopy(PhysPt dest, PhysPt src, Bitu size);
+
+// Returns the host memory that the 'size' bytes from 'pt' on can be written
+// to directly, or nullptr when they aren't one contiguous run of host memory,
+// such as when some of them go through memory handlers
+HostPt MEM_GetHostWritePtr(PhysPt pt, size_t size);
 void MEM_StrCopy(PhysPt pt, char *data, Bitu size);
 
 void mem_memcpy(PhysPt dest, PhysPt src, Bitu size);
@@ -35,9 +35,11 @@
 #include <vector>
 
 #include "../src/hardware/compressor.h"
+#include "../src/hardware/mixer_kernels.h"
 #include "audio_frame.h"
 #include "control.h"
 #include "envelope.h"
+#include "host_memory.h"
 
 #include <Iir.h>
 
@@ -63,6 +65,15 @@ constexpr auto Min16BitSampleValue = INT16_MIN;
 
 static constexpr auto MaxFilterOrder = 16;
 
+// The sections of a channel's Butterworth filter, designed with the Iir
+// library and run on both channels at once by the sample kernels
+struct MixerFilterCascade {
+	std::array<MixerBiquad, MixerMaxBiquads> sections    = {};
+	std::array<MixerBiquadState, MixerMaxBiquads> states = {};
+	size_t num_sections                                  = 0;
+};
+static_assert((MaxFilterOrder + 1) / 2 <= MixerMaxBiquads);
+
 static constexpr auto MillisInSecond  = 1000.0;
 static constexpr auto MillisInSecondF = 1000.0f;
 
@@ -117,6 +128,7 @@ enum class ChannelFeature {
 	ChorusSend,
 	DigitalAudio,
 	FadeOut,
+	ParallelRendering,
 	ReverbSend,
 	Sleep,
 	Stereo,
@@ -125,6 +137,29 @@ enum class ChannelFeature {
 
 enum class FilterState { Off, On };
 
+// The host time spent on a channel's processing stages, in nanoseconds
+struct MixerChannelProfile {
+	// Rendering and converting by the device, not counting the stages below
+	int64_t device_ns = 0;
+
+	int64_t resample_ns = 0;
+
+	// The high-pass and low-pass filters, and the crossfeed
+	int64_t filters_ns = 0;
+};
+
+// The host time spent on the master channel's processing stages, in
+// nanoseconds, and the host time the measurements span
+struct MixerProfile {
+	int64_t reverb_ns = 0;
+	int64_t chorus_ns = 0;
+
+	// The high-pass filter, the compressor, and the audio capture
+	int64_t master_ns = 0;
+
+	int64_t elapsed_ns = 0;
+};
+
 struct MixerChannelSettings {
 	bool is_enabled          = {};
 	AudioFrame user_volume   = {};
@@ -230,6 +265,12 @@ public:
 	void SetResampleMethod(const ResampleMethod method);
 	void SetZeroOrderHoldUpsamplerTargetRate(const int target_rate_hz);
 
+	// Sets the Speex resampler's quality from 0 (fastest) to 10 (best)
+	void SetResampleQuality(const int quality);
+
+	MixerChannelProfile GetProfile() const;
+	void ResetProfile();
+
 	void SetCrossfeedStrength(const float strength);
 	float GetCrossfeedStrength() const;
 
@@ -275,9 +316,6 @@ private:
 	MixerChannel()                    = delete;
 	MixerChannel(const MixerChannel&) = delete;
 
-	template <class Type, bool stereo, bool signeddata, bool nativeorder>
-	AudioFrame ConvertNextFrame(const Type* data, const int pos);
-
 	template <class Type, bool stereo, bool signeddata, bool nativeorder>
 	void ConvertSamplesAndMaybeZohUpsample(const Type* data, const int frames,
 	                                       std::vector<float>& out);
@@ -289,6 +327,17 @@ private:
 
 	AudioFrame ApplyCrossfeed(const AudioFrame frame) const;
 
+	// Calls the handler until the requested frames are done
+	void RenderFrames(const float stretch_factor);
+
+	// Scratch buffers of the sample conversion and resampling, owned by
+	// the channel so channels can render in parallel
+	std::vector<float> convert_buf = {};
+	std::vector<float> temp_buf    = {};
+	std::vector<float> out_buf     = {};
+
+	TrackedHostMemory tracked_state{HostMemoryUse::MixerBuffers};
+
 	std::string name = {};
 	Envelope envelope;
 	MIXER_Handler handler = nullptr;
@@ -367,26 +416,33 @@ private:
 	} lerp_upsampler = {};
 
 	struct {
-		int target_rate_hz = 0;
-		float pos          = 0.0f;
-		float step         = 0.0f;
+		// The rate set by the device, and the one the upsampler
+		// actually holds the frames to
+		int requested_rate_hz = 0;
+		int target_rate_hz    = 0;
+		float pos             = 0.0f;
+		float step            = 0.0f;
 	} zoh_upsampler = {};
 
 	struct {
 		SpeexResamplerState* state = nullptr;
+
+		int quality = 0;
 	} speex_resampler = {};
 
+	MixerChannelProfile profile = {};
+
 	struct {
 		struct {
 			FilterState state = FilterState::Off;
-			std::array<Iir::Butterworth::HighPass<MaxFilterOrder>, 2> hpf = {};
+			MixerFilterCascade cascade = {};
 			int order          = 0;
 			int cutoff_freq_hz = 0;
 		} highpass = {};
 
 		struct {
 			FilterState state = FilterState::Off;
-			std::array<Iir::Butterworth::LowPass<MaxFilterOrder>, 2> lpf = {};
+			MixerFilterCascade cascade = {};
 			int order          = 0;
 			int cutoff_freq_hz = 0;
 		} lowpass = {};
@@ -458,6 +514,15 @@ void MIXER_AddConfigSection(const ConfigPtr& conf);
 int MIXER_GetSampleRate();
 int MIXER_GetPreBufferMs();
 
+// The milliseconds of mixed audio waiting to be played
+int MIXER_GetBufferedMs();
+
+// The host time spent since the last reset, for the MIXER /PROFILE view
+MixerProfile MIXER_GetProfile();
+
+// Restarts the measurements of the master and all the channels
+void MIXER_ResetProfile();
+
 const AudioFrame MIXER_GetMasterVolume();
 void MIXER_SetMasterVolume(const AudioFrame volume);
 
@@ -196,6 +196,11 @@ struct bx_ne2k_t {
 	uint8_t base_irq = 0;
 	int tx_timer_index = 0;
 	int tx_timer_active = 0;
+
+	// Receive interrupt coalescing: the interrupts of the frames received
+	// within this window are raised once, at the end of the window
+	double rx_irq_window_ms = 0.0;
+	bool rx_irq_scheduled = false;
 };
 
 class bx_ne2k_c  {
@@ -231,6 +236,7 @@ public:
 public:
   static void tx_timer_handler(void *);
   BX_NE2K_SMF void tx_timer(void);
+  BX_NE2K_SMF void rx_irq_timer(void);
 
   //static void rx_handler(void *arg, const void *buf, unsigned len);
   BX_NE2K_SMF unsigned mcast_index(const void *dst);
@@ -91,15 +91,21 @@ Bitu PAGING_GetDirBase();
 void PAGING_SetDirBase(Bitu cr3);
 void PAGING_InitTLB();
 void PAGING_ClearTLB();
+void PAGING_InvalidatePage(Bitu lin_addr);
 
 void PAGING_LinkPage(uint32_t lin_page,uint32_t phys_page);
 void PAGING_LinkPage_ReadOnly(uint32_t lin_page,uint32_t phys_page);
 void PAGING_UnlinkPages(Bitu lin_page,Bitu pages);
+void PAGING_UnlinkPhysPages(const Bitu phys_page, const Bitu pages);
 /* This maps the page directly, only use when paging is disabled */
 void PAGING_MapPage(Bitu lin_page,Bitu phys_page);
 bool PAGING_MakePhysPage(Bitu & page);
 bool PAGING_ForcePageInit(Bitu lin_addr);
 
+// Called by the full core after an IRET, to end the nested handling of a
+// page fault once the guest's handler returned to the faulting instruction
+void PAGING_CheckPageFaultReturn();
+
 void MEM_SetLFB(Bitu page, Bitu pages, PageHandler *handler, PageHandler *mmiohandler);
 void MEM_SetPageHandler(Bitu phys_page, Bitu pages, PageHandler * handler);
 void MEM_ResetPageHandler(Bitu phys_page, Bitu pages);
@@ -228,6 +234,11 @@ struct PagingBlock {
 	struct {
 		uint32_t used = 0;
 		std::vector<uint32_t> entries = std::vector<uint32_t>(PAGING_LINKS);
+
+		// The page directory and table entries each link was made from,
+		// zero if it wasn't made by walking the page tables
+		std::vector<uint32_t> dir_entries = std::vector<uint32_t>(PAGING_LINKS);
+		std::vector<uint32_t> table_entries = std::vector<uint32_t>(PAGING_LINKS);
 	} links = {};
 
 	std::vector<uint32_t> firstmb = std::vector<uint32_t>(LINK_START);
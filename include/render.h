@@ -134,6 +134,10 @@ struct RenderedImage {
 	// bottom row
 	bool is_flipped_vertically = false;
 
+	// If true, the image is identical to the previous frame, as the
+	// renderer found no changed lines and no palette changes
+	bool is_unchanged = false;
+
 	// Bytes per row
 	uint16_t pitch = 0;
 
@@ -209,6 +213,18 @@ void RENDER_SetSize(const ImageInfo& image_info, const double frames_per_second)
 bool RENDER_StartUpdate();
 void RENDER_EndUpdate(bool abort);
 
+// Whether to skip drawing a frame entirely because the emulation is behind
+// the host's time, so the frame would be superseded before it's seen
+bool RENDER_ShouldSkipFrame(const double frame_period_ms);
+
+// Whether the next line of the frame can be passed as nullptr, meaning it's
+// unchanged since the previous frame, so the scaler keeps its cached copy
+bool RENDER_CanSkipUnchangedLine();
+
+// Whether the lines passed to RENDER_DrawLine make it into the scaler's cache,
+// i.e., the next frame can compare against them
+bool RENDER_IsCachingLines();
+
 void RENDER_SetPalette(const uint8_t entry, const uint8_t red,
                        const uint8_t green, const uint8_t blue);
 
@@ -0,0 +1,57 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_REPLAY_H
+#define DOSBOX_REPLAY_H
+
+#include <cstdint>
+
+#include "keyboard.h"
+#include "mouse.h"
+
+class Section;
+
+// Input recording and replay
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+// With '--record <file>', the keyboard and mouse events from the host, the
+// emulated cycles of every tick, the wall-clock time and the randomizer seed
+// are written to a text file, each event stamped with the tick and the cycle
+// within the tick it arrived at. '--replay <file>' feeds the same events back
+// at the same emulated times while ignoring the host input, so a session can
+// be reproduced for performance measurements, typically with '--headless'.
+
+void REPLAY_Init(Section* sec);
+
+// True while replaying, when the live input from the host has to be dropped
+bool REPLAY_IsIgnoringHostInput();
+
+// Record the input events dispatched from the GUI
+void REPLAY_RecordKey(const KBD_KEYS key, const bool is_pressed);
+void REPLAY_RecordMouseMoved(const float x_rel, const float y_rel,
+                             const int32_t x_abs, const int32_t y_abs);
+void REPLAY_RecordMouseButton(const MouseButtonId button_id, const bool pressed);
+void REPLAY_RecordMouseWheel(const int16_t w_rel);
+
+// The wall-clock time the guest sees, in milliseconds since the Unix epoch:
+// the host time, or while recording or replaying, the start time of the
+// recording advanced by the emulated time
+int64_t REPLAY_GetWallClockMs();
+
+#endif
@@ -23,7 +23,9 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <bit>
+#include <cstddef>
 #include <cstdint>
 
 #include "math_utils.h"
@@ -60,7 +62,12 @@ public:
 		return data_.at(n);
 	}
 
-	std::array<T, N>& data() const
+	std::array<T, N>& data()
+	{
+		return data_;
+	}
+
+	const std::array<T, N>& data() const
 	{
 		return data_;
 	}
@@ -196,4 +203,79 @@ public:
 	std::array<T, N> data_ = {};
 };
 
+// Lock-free ring buffer for passing items from exactly one producer thread to
+// exactly one consumer thread.
+//
+// The producer only ever moves the write index and the consumer the read
+// index, so neither has to wait for the other: a full buffer makes 'Push'
+// take fewer items, and an empty one makes 'Pop' return fewer. The indexes
+// count up indefinitely and are wrapped when accessing the items, which tells
+// a full buffer apart from an empty one without giving up a slot.
+//
+template <class T, size_t N>
+class SpscRingBuffer {
+	static_assert(std::has_single_bit(N), "SpscRingBuffer size must be power of two");
+
+	static constexpr size_t IndexMask = (N - 1);
+
+public:
+	static constexpr size_t Capacity()
+	{
+		return N;
+	}
+
+	// The number of items available to the consumer. It can only grow
+	// when called by the consumer, and only shrink when called by the
+	// producer.
+	size_t Size() const
+	{
+		return write_index.load(std::memory_order_acquire) -
+		       read_index.load(std::memory_order_acquire);
+	}
+
+	// Producer: appends up to 'num_items' items, returns how many fitted
+	size_t Push(const T* items, const size_t num_items)
+	{
+		const auto write = write_index.load(std::memory_order_relaxed);
+		const auto read  = read_index.load(std::memory_order_acquire);
+
+		const auto num_pushed = std::min(num_items, N - (write - read));
+		for (size_t i = 0; i < num_pushed; ++i) {
+			data_[(write + i) & IndexMask] = items[i];
+		}
+		write_index.store(write + num_pushed, std::memory_order_release);
+		return num_pushed;
+	}
+
+	// Consumer: removes up to 'num_items' items into 'items', returns how
+	// many were available
+	size_t Pop(T* items, const size_t num_items)
+	{
+		const auto read  = read_index.load(std::memory_order_relaxed);
+		const auto write = write_index.load(std::memory_order_acquire);
+
+		const auto num_popped = std::min(num_items, write - read);
+		for (size_t i = 0; i < num_popped; ++i) {
+			items[i] = data_[(read + i) & IndexMask];
+		}
+		read_index.store(read + num_popped, std::memory_order_release);
+		return num_popped;
+	}
+
+	// Consumer: removes all the items
+	void Clear()
+	{
+		read_index.store(write_index.load(std::memory_order_acquire),
+		                 std::memory_order_release);
+	}
+
+private:
+	std::array<T, N> data_ = {};
+
+	// Kept on separate cache lines, as each is written by a different
+	// thread
+	alignas(64) std::atomic<size_t> write_index = 0;
+	alignas(64) std::atomic<size_t> read_index  = 0;
+};
+
 #endif // DOSBOX_RING_BUFFER_H
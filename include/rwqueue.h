@@ -34,15 +34,30 @@
  *
  *  Producer and consumer thread(s) are expected to simply call the enqueue and
  *  dequeue methods directly without any thread state management.
+ *
+ *  Queues with exactly one producer and one consumer thread can be created in
+ *  the lock-free mode: the items then move through a ring buffer with
+ *  wait-free fast paths, and the mutex and conditions are only used to block
+ *  when the queue is full or empty. In this mode, Resize() must only be called
+ *  while neither thread uses the queue, and Clear() only by the consumer.
  */
 
 #include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <vector>
 
+enum class RWQueueMode {
+	// Any number of producers and consumers, taking the mutex on every call
+	Locking,
+
+	// A single producer and a single consumer thread
+	LockFree,
+};
+
 template <typename T>
 class RWQueue {
 private:
@@ -54,12 +69,37 @@ private:
 	std::atomic<bool> is_running      = true;
 	using difference_t = typename std::vector<T>::difference_type;
 
+	// Lock-free mode
+	// ~~~~~~~~~~~~~~
+	// The indexes count the items ever written and read, their difference
+	// being the number of items in the ring. They're kept on separate cache
+	// lines so the producer and the consumer don't contend for them.
+	const RWQueueMode mode = RWQueueMode::Locking;
+
+	std::unique_ptr<T[]> ring = {};
+
+	alignas(64) std::atomic<size_t> write_index = 0;
+	alignas(64) std::atomic<size_t> read_index  = 0;
+
+	// Set while a thread blocks, so the other one only has to take the
+	// mutex to wake it up
+	std::atomic<bool> is_producer_waiting = false;
+	std::atomic<bool> is_consumer_waiting = false;
+
+	size_t RingSize() const;
+	void WaitForRoom(const size_t num_items);
+	void WaitForItems(const size_t num_items);
+	void NotifyProducer();
+	void NotifyConsumer();
+	void MoveIntoRing(typename std::vector<T>::iterator source, const size_t num_items);
+	void MoveOutOfRing(typename std::vector<T>::iterator target, const size_t num_items);
+
 public:
 	RWQueue()                                      = delete;
 	RWQueue(const RWQueue<T>& other)               = delete;
 	RWQueue<T>& operator=(const RWQueue<T>& other) = delete;
 
-	RWQueue(size_t queue_capacity);
+	RWQueue(size_t queue_capacity, const RWQueueMode queue_mode = RWQueueMode::Locking);
 	void Resize(size_t queue_capacity);
 
 	bool IsEmpty();
@@ -0,0 +1,103 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_SAVESTATE_H
+#define DOSBOX_SAVESTATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "std_filesystem.h"
+
+/*
+Save states
+~~~~~~~~~~~
+Modules register their state next to their *_Init(Section*) function, under
+a name that's unique within the save state:
+
+ - Components serialize their (small) state into a byte buffer when saving,
+   and get the same buffer back when loading. Every buffer is checked before
+   any of them gets loaded, so a state that can't be used, e.g., because a
+   size doesn't match, is refused as a whole instead of leaving a mix of the
+   current and the saved state behind; loading itself can't fail.
+
+ - Memory regions are large areas, like the guest's RAM, that are written
+   as-is. On POSIX hosts they're written by a forked child process, so the
+   emulation carries on right away while the host kernel keeps the snapshot
+   copy-on-write: only the pages the guest modifies in the meantime get
+   copied. A save costs about as much as duplicating the process' page
+   tables instead of a copy of all the memory.
+
+Registering again under the same name replaces the previous registration,
+so modules can simply register again when they're re-initialized.
+*/
+
+using savestate_save_f = std::function<void(std::vector<uint8_t>& data)>;
+using savestate_check_f = std::function<bool(const std::vector<uint8_t>& data)>;
+using savestate_load_f  = std::function<void(const std::vector<uint8_t>& data)>;
+
+// Optional hook that stores the loaded region contents instead of a plain
+// memory copy
+using savestate_restore_f = std::function<void(const uint8_t* data, size_t size)>;
+
+void SAVESTATE_AddComponent(const std::string& name, savestate_save_f save,
+                            savestate_check_f check, savestate_load_f load);
+
+void SAVESTATE_AddMemoryRegion(const std::string& name, uint8_t* data,
+                               size_t size, savestate_restore_f restore = {});
+
+void SAVESTATE_Remove(const std::string& name);
+
+// Returns once the component state is taken; the memory regions might still
+// be written in the background
+bool SAVESTATE_Save(const std_fs::path& file);
+
+// Waits for a save still being written in the background
+bool SAVESTATE_WaitForSave();
+
+bool SAVESTATE_Load(const std_fs::path& file);
+
+/*
+Rewinding
+~~~~~~~~~
+A bounded ring of in-memory snapshots to step back through. Components are
+kept whole, they're small. Memory regions are kept as deltas: every capture
+compares the regions against a copy of their contents at the previous
+snapshot, page by page, and stores only the changed pages, XORed with their
+previous contents and run-length encoded on a worker thread. Rewinding
+restores the latest snapshot and drops it, so stepping back repeatedly walks
+through the older ones.
+
+Changing the registrations clears the snapshots.
+*/
+
+// Keeps up to 'num_snapshots' snapshots, 0 disables rewinding
+void SAVESTATE_SetRewindDepth(const size_t num_snapshots);
+
+void SAVESTATE_CaptureRewindPoint();
+
+// Returns false if there's no snapshot to go back to, or if a component
+// refuses its state
+bool SAVESTATE_Rewind();
+
+#endif
@@ -23,6 +23,7 @@
 
 #include "SDL.h"
 
+#include <array>
 #include <cstring>
 #include <optional>
 #include <string>
@@ -127,6 +128,10 @@ enum class FrameMode {
 
 	// Variable frame rate, throttled to the display's rate
 	ThrottledVfr,
+
+	// Constant frame rate, with the emulation timed so the frames are
+	// completed just before the display's vertical blank
+	JustInTime,
 };
 
 enum class HostRateMode {
@@ -184,6 +189,9 @@ struct SDL_Block {
 	bool resizing_window = false;
 	bool wait_on_error   = false;
 
+	// Nothing gets rendered or presented, see the --headless option
+	bool headless = false;
+
 	uint32_t start_event_id = UINT32_MAX;
 
 	bool is_paused = false;
@@ -285,6 +293,56 @@ struct SDL_Block {
 
 		GLuint actual_frame_count;
 		GLfloat vertex_data[2 * 3];
+
+		// 8-bit indexed frames are uploaded as-is and expanded into
+		// 'texture' on the GPU through a palette lookup, which also
+		// doubles the frames passed on undoubled
+		struct {
+			bool is_supported = false;
+			bool is_active    = false;
+			bool is_dirty     = false;
+
+			// Range of the colours changed since the last upload
+			uint8_t dirty_first = 0;
+			uint8_t dirty_last  = 0;
+
+			// Size of the uploaded, possibly undoubled frames
+			int width_px  = 0;
+			int height_px = 0;
+
+			GLuint program         = 0;
+			GLint position         = -1;
+			GLint index_size       = -1;
+			GLint frame_scale      = -1;
+			GLuint index_texture   = 0;
+			GLuint palette_texture = 0;
+			GLuint framebuffer     = 0;
+
+			std::array<uint32_t, 256> colours = {};
+		} palette = {};
+
+		// Ring of pixel buffer objects the changed lines are streamed
+		// through, so the texture updates don't wait for the GPU
+		struct {
+			bool is_supported = false;
+
+			std::array<GLuint, 3> buffers = {};
+			size_t size  = 0;
+			size_t index = 0;
+		} upload = {};
+
+		// Pixel buffer object the rendered output is read back into for
+		// the post-render captures, so they don't stall the GPU
+		struct {
+			bool is_supported = false;
+			bool is_pending   = false;
+
+			GLuint buffer    = 0;
+			int frames_since = 0;
+
+			// The captured image, minus the pixels
+			RenderedImage image = {};
+		} readback = {};
 	} opengl = {};
 #endif // C_OPENGL
 
@@ -316,6 +374,9 @@ struct SDL_Block {
 		FrameMode desired_mode        = FrameMode::Unset;
 		FrameMode mode                = FrameMode::Unset;
 
+		// Present the OpenGL frames on a separate thread
+		bool threaded_presentation = false;
+
 		// in ms, for use with PIC timers
 		double period_ms      = 0.0;
 		float max_dupe_frames = 0.0f;
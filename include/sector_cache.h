@@ -0,0 +1,107 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_SECTOR_CACHE_H
+#define DOSBOX_SECTOR_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// A cache of a drive's fixed size sectors, keyed by their absolute sector
+// numbers. When full, the least recently used sector is evicted. With a
+// 'write_sector' function it's a write-back cache: sectors written through
+// the cache are only marked dirty, and they're written back when they're
+// evicted or when the cache is flushed. Without one it only caches reads.
+class SectorCache {
+public:
+	using WriteSector = std::function<void(uint32_t sectnum, const uint8_t* data)>;
+
+	// A 'max_sectors' of zero disables the cache
+	SectorCache(size_t max_sectors, size_t sector_size,
+	            WriteSector write_sector = {});
+
+	SectorCache(const SectorCache&)            = delete;
+	SectorCache& operator=(const SectorCache&) = delete;
+
+	bool IsEnabled() const
+	{
+		return max_sectors > 0;
+	}
+
+	bool Contains(uint32_t sectnum) const;
+
+	// Copies a cached sector into 'data', returning false if it isn't
+	// cached
+	bool Read(uint32_t sectnum, void* data);
+
+	// Caches a clean sector that has just been read from the disk
+	void Insert(uint32_t sectnum, const void* data);
+
+	// Caches a written sector, to be written back later; needs a
+	// 'write_sector' function
+	void Write(uint32_t sectnum, const void* data);
+
+	// Updates a sector only if it's already cached, returning whether it
+	// was
+	bool WriteIfCached(uint32_t sectnum, const void* data);
+
+	// Writes back the dirty sectors in ascending order and keeps them
+	// cached as clean
+	void Flush();
+
+	// Writes back the dirty sectors and empties the cache
+	void Clear();
+
+	size_t GetNumCachedSectors() const
+	{
+		return entries.size();
+	}
+
+	size_t GetMaxSectors() const
+	{
+		return max_sectors;
+	}
+
+	size_t GetNumDirtySectors() const;
+
+private:
+	struct Entry {
+		uint32_t sectnum = 0;
+		bool is_dirty    = false;
+		std::vector<uint8_t> data = {};
+	};
+
+	Entry& Store(uint32_t sectnum, const void* data);
+
+	// Most recently used first
+	std::list<Entry> entries = {};
+	std::unordered_map<uint32_t, std::list<Entry>::iterator> index = {};
+
+	WriteSector write_sector = {};
+
+	size_t max_sectors = 0;
+	size_t sector_size = 0;
+};
+
+#endif
@@ -272,6 +272,10 @@ public:
 	// depratched
 	// connected device checks, if port can receive data:
 	bool CanReceiveByte();
+
+	// The number of bytes that can be received in one go without changing
+	// when the RX interrupt is raised
+	size_t GetRxBatchSize() const;
 	
 	// when THR was shifted to TX
 	void ByteTransmitting();
@@ -456,6 +460,13 @@ private:
 	uint8_t loopback_data = 0;
 	void transmitLoopbackByte(uint8_t val, bool value);
 
+	// FIFO timeout
+	void startRxTimeout();
+	void stopRxTimeout();
+	double rx_timeout_deadline    = 0.0;
+	bool rx_timeout_armed         = false;
+	bool rx_timeout_event_pending = false;
+
 	// 16C550 (FIFO)
 public: // todo remove
 	MyFifo *rxfifo = nullptr;
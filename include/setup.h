@@ -32,6 +32,7 @@
 #include <optional>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include "std_filesystem.h"
@@ -366,7 +367,8 @@ public:
 	void AddDestroyFunction(SectionFunction func,
 	                        bool changeable_at_runtime = false);
 
-	void ExecuteInit(bool initall = true);
+	// Logs the wall time of every init function with 'log_timings'
+	void ExecuteInit(bool initall = true, bool log_timings = false);
 	void ExecuteDestroy(bool destroyall = true);
 
 	bool IsActive() const
@@ -395,6 +397,19 @@ private:
 	typedef std::deque<Property*>::iterator it;
 	typedef std::deque<Property*>::const_iterator const_it;
 
+	// The properties by their lowercase names, so looking them up by name
+	// doesn't search through the whole section
+	std::unordered_map<std::string, Property*> properties_by_name = {};
+
+	template <typename T>
+	T* AddProperty(T* property);
+
+	// Finds a property by its name regardless of case
+	Property* FindProperty(const std::string_view name) const;
+
+	// Finds a property by its exact name
+	Property* FindPropertyExact(const std::string_view name) const;
+
 public:
 	Section_prop(const std::string& name, bool active = true) : Section(name, active) {}
 
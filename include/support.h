@@ -161,6 +161,10 @@ constexpr cast_t check_cast(const check_t in)
 template <typename T>
 std::function<T()> CreateRandomizer(const T min_value, const T max_value);
 
+// Seeds the randomizers with a fixed value instead of one from the host OS,
+// for reproducible runs; only has an effect before the first randomizer is made
+void SetRandomizerSeed(const uint32_t seed);
+
 // Include a message in assert, similar to static_assert:
 #define assertm(exp, msg) assert(((void)msg, exp))
 // Use (void) to silent unused warnings.
@@ -336,6 +340,43 @@ template <typename T>
 std::pair<std::unique_ptr<T[]>, T*> make_unique_aligned_array(
         const size_t byte_alignment, const size_t req_elems, const T& init_val = {});
 
+// A zero-initialised, page-aligned byte buffer for large allocations of which
+// often only a small part gets used, like video memory. On hosts with mmap or
+// VirtualAlloc, its pages only take up host memory once they're first written
+// to, and Clear() zeroes it by handing the pages back to the host. Elsewhere
+// it's a regular heap allocation.
+class ZeroedBuffer {
+public:
+	ZeroedBuffer() = default;
+	explicit ZeroedBuffer(const size_t num_bytes);
+	~ZeroedBuffer();
+
+	ZeroedBuffer(ZeroedBuffer&& other) noexcept;
+	ZeroedBuffer& operator=(ZeroedBuffer&& other) noexcept;
+
+	ZeroedBuffer(const ZeroedBuffer&)            = delete;
+	ZeroedBuffer& operator=(const ZeroedBuffer&) = delete;
+
+	uint8_t* data() const
+	{
+		return bytes;
+	}
+	size_t size() const
+	{
+		return num_bytes;
+	}
+
+	// Zeroes the whole buffer
+	void Clear();
+
+private:
+	void Free();
+
+	uint8_t* bytes   = nullptr;
+	size_t num_bytes = 0;
+	bool is_mapped   = false;
+};
+
 // This struct can be used in combination with std::visit and std::variant to
 // define code for each type specified in the variant.
 //
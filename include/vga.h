@@ -26,6 +26,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "bgrx8888.h"
 #include "bit_view.h"
@@ -35,9 +36,7 @@
 #include "rgb666.h"
 #include "video.h"
 
-//Don't enable keeping changes and mapping lfb probably...
 #define VGA_LFB_MAPPED
-//#define VGA_KEEP_CHANGES
 #define VGA_CHANGE_SHIFT	9
 
 class PageHandler;
@@ -329,9 +328,17 @@ struct VgaDraw {
 	// at the "nomimal width" of the video mode.
 	bool pixel_doubling_allowed  = false;
 
+	// Value of the 'vga_render_per_scanline' setting, read once at startup
+	// as the setting can't change at runtime
+	bool render_per_scanline = true;
+
 	uint8_t font[64 * 1024] = {};
 	uint8_t* font_tables[2] = {nullptr, nullptr};
 
+	// Incremented when the font memory is written or the font tables are
+	// selected, so the cached glyphs of the text modes can be invalidated
+	uint32_t font_generation = 0;
+
 	Bitu blinking                      = 0;
 	bool blink                         = false;
 	PixelsPerChar pixels_per_character = PixelsPerChar::Eight;
@@ -1020,19 +1027,16 @@ struct VgaMemory {
 	uint8_t* linear = {};
 };
 
-struct VGA_Changes {
-	// Add a few more just to be safe
-	// Allocated dynamically: [(VGA_MEMORY >> VGA_CHANGE_SHIFT) + 32]
-	uint8_t* map = nullptr;
-
-	uint8_t checkMask    = 0;
-	uint8_t frame        = 0;
-	uint8_t writeMask    = 0;
-	bool active          = 0;
-	uint32_t clearMask   = 0;
-	uint32_t start       = 0;
-	uint32_t last        = 0;
-	uint32_t lastAddress = 0;
+// Blocks of video memory written by the page handlers, tracked so the
+// scanlines that haven't changed since the last frame can be skipped. Each
+// entry covers (1 << VGA_CHANGE_SHIFT) bytes, in the address units the draw
+// functions of the current mode read the memory in.
+struct VgaChanges {
+	// Writes since the start of the frame being drawn
+	std::vector<uint8_t> written = {};
+
+	// Writes during the previous frame
+	std::vector<uint8_t> previous = {};
 };
 
 struct VgaLfb {
@@ -1076,9 +1080,7 @@ struct VgaType {
 	// How much delay to add to video memory I/O in nanoseconds
 	uint16_t vmem_delay_ns = 0;
 
-#ifdef VGA_KEEP_CHANGES
 	VgaChanges changes = {};
-#endif
 
 	VgaLfb lfb = {};
 
@@ -1151,6 +1153,10 @@ void VGA_SetupDAC(void);
 void VGA_SetupCRTC(void);
 void VGA_SetupMisc(void);
 void VGA_SetupGFX(void);
+
+// Selects and writes a graphics controller register like the port writes
+// to 3CEh and 3CFh do, for the BIOS without the I/O port overhead and delay
+void VGA_WriteGfxRegister(const uint8_t index, const uint8_t value);
 void VGA_SetupSEQ(void);
 void VGA_SetupOther(void);
 void VGA_SetupXGA(void);
@@ -1159,6 +1165,9 @@ void VGA_AddCompositeSettings(Config& conf);
 // Some support functions
 struct VideoModeBlock;
 
+// Zeroes all of the video memory, handing its pages back to the host
+void VGA_ClearMemory();
+
 void VGA_SetClock(Bitu which, uint32_t target);
 
 // Save, get, and limit refresh and clock functions
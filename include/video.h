@@ -363,6 +363,7 @@ constexpr uint8_t GFX_CAN_32     = 1 << 3;
 constexpr uint8_t GFX_DBL_H      = 1 << 4; // double-width  flag
 constexpr uint8_t GFX_DBL_W      = 1 << 5; // double-height flag
 constexpr uint8_t GFX_CAN_RANDOM = 1 << 6; // interface can also do random acces
+constexpr uint8_t GFX_DBL_OUTPUT = 1 << 7; // interface doubles the undoubled frame
 
 // return code of:
 // - true means event loop can keep running.
@@ -376,6 +377,15 @@ void GFX_DisengageRendering();
 uint8_t GFX_GetBestMode(const uint8_t flags);
 uint32_t GFX_GetRGB(const uint8_t red, const uint8_t green, const uint8_t blue);
 
+// True if the output can look up the colours of 8-bit indexed frames on the
+// GPU, so they can be passed on without palettizing them to 32-bit first
+bool GFX_CanLookUpPalette();
+
+// Sets the 'first' to 'last' colours (as returned by GFX_GetRGB) of the 8-bit
+// frames from the 256 'colours'
+void GFX_SetPalette(const uint32_t* colours, const uint8_t first,
+                    const uint8_t last);
+
 struct ShaderInfo;
 
 void GFX_SetShader(const ShaderInfo& shader_info, const std::string& shader_source);
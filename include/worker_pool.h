@@ -0,0 +1,59 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_WORKER_POOL_H
+#define DOSBOX_WORKER_POOL_H
+
+#include <functional>
+
+class Section;
+
+// Shared worker thread pool
+// ~~~~~~~~~~~~~~~~~~~~~~~~~
+// One pool of threads, sized by the 'worker_threads' setting, runs the
+// parallel work of all the subsystems instead of each starting its own
+// threads. Every worker has its own task queue, taking its tasks from the
+// front; workers with an empty queue steal tasks from the back of the others'
+// queues. The threads are started on the first use, and stopped when the
+// pool's section is destroyed or at exit; tasks submitted after that run on
+// the submitting thread.
+
+void WORKERS_Init(Section* sec);
+
+// Sets the number of worker threads, stopping the running ones; 0 picks one
+// per host core, less one for the emulation thread
+void WORKERS_SetNumThreads(const int num_threads);
+
+int WORKERS_GetNumThreads();
+
+// Runs the task on one of the worker threads, or right away on the calling
+// thread if the pool is shut down
+void WORKERS_Submit(std::function<void()> task);
+
+// Calls 'func(index, participant)' for every index in [0, num_items) on up to
+// 'max_helpers' workers and the calling thread, and returns once all the calls
+// have finished. The 'participant' is 0 on the calling thread and 1 to
+// 'max_helpers' on the workers, so per-thread state can be indexed by it. As
+// the calling thread claims items too, the work also finishes when all the
+// workers are busy with other tasks.
+void WORKERS_ParallelFor(const int num_items, const int max_helpers,
+                         const std::function<void(int index, int participant)>& func);
+
+#endif
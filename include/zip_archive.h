@@ -0,0 +1,158 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_ZIP_ARCHIVE_H
+#define DOSBOX_ZIP_ARCHIVE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ZipEntryReader;
+
+// A read-only index of a ZIP archive's contents, built from its central
+// directory when the archive is opened; the archive's contents are only
+// read when its files are. Paths are relative to the archive's root, use
+// '/' separators, and have no trailing separator; the root is "". The
+// directories missing from the central directory are implied by the paths
+// of their contents.
+class ZipArchive {
+public:
+	struct Entry {
+		std::string path = {};
+		// The last component of the path
+		std::string name = {};
+
+		uint64_t header_offset   = 0;
+		uint64_t compressed_size = 0;
+		uint64_t size            = 0;
+
+		uint16_t method   = 0;
+		uint16_t dos_time = 0;
+		uint16_t dos_date = 0;
+		// The FAT attributes, if the archive was made on DOS or Windows
+		uint8_t dos_attributes = 0;
+
+		bool is_directory = false;
+		bool is_encrypted = false;
+	};
+
+	// Opens the archive in 'file', taking ownership of it. Returns nullptr,
+	// with the reason in 'error', if it can't be read; 'error' is left
+	// empty if the file isn't a ZIP archive at all.
+	static std::unique_ptr<ZipArchive> Open(FILE* file, std::string& error);
+
+	static std::unique_ptr<ZipArchive> Open(const std::string& path,
+	                                        std::string& error);
+
+	ZipArchive(const ZipArchive&)            = delete;
+	ZipArchive& operator=(const ZipArchive&) = delete;
+
+	const Entry* Find(const std::string& path) const;
+
+	// Returns the entries of a directory, or nullptr if it doesn't exist
+	const std::vector<const Entry*>* ListDir(const std::string& path) const;
+
+	size_t GetNumEntries() const
+	{
+		return entries.size();
+	}
+
+	// Opens a file for reading, returning nullptr if it's encrypted or
+	// compressed with a method other than deflate
+	std::unique_ptr<ZipEntryReader> OpenEntry(const Entry& entry) const;
+
+private:
+	ZipArchive(FILE* file);
+
+	bool ReadCentralDirectory(std::string& error);
+	void BuildIndex();
+
+	std::shared_ptr<FILE> file = {};
+	uint64_t file_size         = 0;
+
+	std::vector<Entry> entries = {};
+	std::unordered_map<std::string, const Entry*> index = {};
+	std::unordered_map<std::string, std::vector<const Entry*>> dirs = {};
+};
+
+// Reads a file of a ZIP archive at random offsets. Deflated files can only be
+// decompressed from their start, so their decompressed data is kept in an
+// LRU cache of blocks; reading a block that has been evicted decompresses
+// the file again from its start.
+class ZipEntryReader {
+public:
+	static constexpr size_t BlockSize       = 32 * 1024;
+	static constexpr size_t MaxCachedBlocks = 128;
+
+	ZipEntryReader(std::shared_ptr<FILE> file, uint64_t data_offset,
+	               const ZipArchive::Entry& entry);
+	~ZipEntryReader();
+
+	ZipEntryReader(const ZipEntryReader&)            = delete;
+	ZipEntryReader& operator=(const ZipEntryReader&) = delete;
+
+	uint64_t GetSize() const
+	{
+		return size;
+	}
+
+	// Copies up to 'num_bytes' from 'offset', less at the end of the file.
+	// Returns false if the archive can't be read or its data is corrupt.
+	bool Read(uint64_t offset, uint8_t* data, size_t num_bytes,
+	          size_t& num_read);
+
+	size_t GetNumCachedBlocks() const
+	{
+		return cached_blocks.size();
+	}
+
+private:
+	struct Block {
+		uint64_t number            = 0;
+		std::vector<uint8_t> data = {};
+	};
+
+	bool ReadRaw(uint64_t offset, uint8_t* data, size_t num_bytes);
+	const std::vector<uint8_t>* GetBlock(uint64_t number);
+	bool InflateNextBlock();
+	bool RestartInflating();
+
+	std::shared_ptr<FILE> file = {};
+	uint64_t data_offset       = 0;
+	uint64_t compressed_size   = 0;
+	uint64_t size              = 0;
+	bool is_deflated           = false;
+
+	// The inflating state, as a z_stream
+	struct Inflater;
+	std::unique_ptr<Inflater> inflater;
+	uint64_t next_block = 0;
+
+	// Most recently used first
+	std::list<Block> cached_blocks = {};
+	std::unordered_map<uint64_t, std::list<Block>::iterator> cache_index = {};
+};
+
+#endif
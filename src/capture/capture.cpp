@@ -28,7 +28,9 @@
 
 #include "capture_audio.h"
 #include "capture_midi.h"
+#include "capture_raw_video.h"
 #include "capture_video.h"
+#include "capture_writer.h"
 #include "checks.h"
 #include "control.h"
 #include "fs_utils.h"
@@ -46,6 +48,10 @@ static struct {
 	std_fs::path path     = {};
 	bool path_initialised = false;
 
+	// Stream the video uncompressed instead of encoding it as ZMBV
+	bool use_raw_video                         = false;
+	std::optional<std_fs::path> raw_video_path = {};
+
 	struct {
 		CaptureState audio = {};
 		CaptureState midi  = {};
@@ -65,6 +71,10 @@ static struct {
 
 static std::unique_ptr<ImageCapturer> image_capturer = {};
 
+// Outlives the capture section, as the raw OPL capturer is shut down with
+// the OPL emulation
+static CaptureWriter capture_writer = {};
+
 bool CAPTURE_IsCapturingAudio()
 {
 	return capture.state.audio != CaptureState::Off;
@@ -105,6 +115,8 @@ static const char* capture_type_to_string(const CaptureType type)
 	case CaptureType::RadOplInstruments: return "RAD capture";
 
 	case CaptureType::Video: return "video output";
+	case CaptureType::RawVideo: return "raw video output";
+	case CaptureType::RawVideoAudio: return "raw video audio output";
 
 	case CaptureType::RawImage: return "raw image";
 	case CaptureType::UpscaledImage: return "upscaled image";
@@ -124,7 +136,9 @@ static const char* capture_type_to_basename(const CaptureType type)
 	case CaptureType::RawOplStream: return "rawopl";
 	case CaptureType::RadOplInstruments: return "oplinstr";
 
-	case CaptureType::Video: return "video";
+	case CaptureType::Video:
+	case CaptureType::RawVideo:
+	case CaptureType::RawVideoAudio: return "video";
 
 	case CaptureType::RawImage:
 	case CaptureType::UpscaledImage:
@@ -145,6 +159,8 @@ static const char* capture_type_to_extension(const CaptureType type)
 	case CaptureType::RadOplInstruments: return ".rad";
 
 	case CaptureType::Video: return ".avi";
+	case CaptureType::RawVideo: return ".raw";
+	case CaptureType::RawVideoAudio: return ".pcm";
 
 	case CaptureType::RawImage:
 	case CaptureType::UpscaledImage:
@@ -234,7 +250,11 @@ static void set_next_capture_index(const CaptureType type, int32_t index)
 		capture.next_index.rad_opl_instrument = index;
 		break;
 
-	case CaptureType::Video: capture.next_index.video = index; break;
+	case CaptureType::Video:
+	case CaptureType::RawVideo:
+	case CaptureType::RawVideoAudio:
+		capture.next_index.video = index;
+		break;
 
 	case CaptureType::RawImage:
 	case CaptureType::UpscaledImage:
@@ -302,7 +322,9 @@ int32_t get_next_capture_index(const CaptureType type)
 	case CaptureType::RadOplInstruments:
 		return capture.next_index.rad_opl_instrument++;
 
-	case CaptureType::Video: return capture.next_index.video++;
+	case CaptureType::Video:
+	case CaptureType::RawVideo:
+	case CaptureType::RawVideoAudio: return capture.next_index.video++;
 
 	case CaptureType::RawImage:
 	case CaptureType::UpscaledImage:
@@ -352,6 +374,31 @@ FILE* CAPTURE_CreateFile(const CaptureType type,
 	return handle;
 }
 
+void CAPTURE_AppendToFile(FILE* handle, std::vector<uint8_t>&& data)
+{
+	capture_writer.Append(handle, std::move(data));
+}
+
+void CAPTURE_WriteToFileAt(FILE* handle, const long offset,
+                           std::vector<uint8_t>&& data)
+{
+	capture_writer.WriteAt(handle, offset, std::move(data));
+}
+
+void CAPTURE_CloseFile(FILE* handle)
+{
+	capture_writer.CloseFile(handle);
+}
+
+static void finalise_video()
+{
+	if (capture.use_raw_video) {
+		capture_raw_video_finalise();
+	} else {
+		capture_video_finalise();
+	}
+}
+
 void CAPTURE_StartVideoCapture()
 {
 	switch (capture.state.video) {
@@ -380,7 +427,7 @@ void CAPTURE_StopVideoCapture()
 		GFX_NotifyVideoCaptureStatus(false);
 		break;
 	case CaptureState::InProgress:
-		capture_video_finalise();
+		finalise_video();
 		capture.state.video = CaptureState::Off;
 		GFX_NotifyVideoCaptureStatus(false);
 		LOG_MSG("CAPTURE: Stopped capturing video output");
@@ -399,7 +446,13 @@ void CAPTURE_AddFrame(const RenderedImage& image, const float frames_per_second)
 		capture.state.video = CaptureState::InProgress;
 		[[fallthrough]];
 	case CaptureState::InProgress:
-		capture_video_add_frame(image, frames_per_second);
+		if (capture.use_raw_video) {
+			capture_raw_video_add_frame(image,
+			                            frames_per_second,
+			                            capture.raw_video_path);
+		} else {
+			capture_video_add_frame(image, frames_per_second);
+		}
 		break;
 	}
 }
@@ -420,9 +473,15 @@ void CAPTURE_AddAudioData(const uint32_t sample_rate, const uint32_t num_sample_
 		capture.state.video = CaptureState::InProgress;
 		[[fallthrough]];
 	case CaptureState::InProgress:
-		capture_video_add_audio_data(sample_rate,
-		                             num_sample_frames,
-		                             sample_frames);
+		if (capture.use_raw_video) {
+			capture_raw_video_add_audio_data(sample_rate,
+			                                 num_sample_frames,
+			                                 sample_frames);
+		} else {
+			capture_video_add_audio_data(sample_rate,
+			                             num_sample_frames,
+			                             sample_frames);
+		}
 		break;
 	}
 
@@ -568,12 +627,15 @@ static void capture_destroy(Section* /*sec*/)
 		capture_midi_finalise();
 		capture.state.midi = CaptureState::Off;
 	}
+	// Waits until the finalised audio and MIDI files are written out
+	capture_writer.Close();
+
 	// When destructed, the threaded image capturer instances do a blocking
 	// wait until all pending capture tasks are processed.
 	image_capturer = {};
 
 	if (capture.state.video == CaptureState::InProgress) {
-		capture_video_finalise();
+		finalise_video();
 		capture.state.video = CaptureState::Off;
 	}
 
@@ -602,6 +664,15 @@ static void capture_init(Section* sec)
 
 	const std::string prefs = secprop->Get_string("default_image_capture_formats");
 
+	capture.use_raw_video = (secprop->Get_string("video_capture_format") == "raw");
+
+	const std::string raw_video_path = secprop->Get_string("raw_video_capture_path");
+	if (raw_video_path.empty()) {
+		capture.raw_video_path = {};
+	} else {
+		capture.raw_video_path = std_fs::path(raw_video_path);
+	}
+
 	image_capturer = std::make_unique<ImageCapturer>(prefs);
 
 	constexpr auto changeable_at_runtime = true;
@@ -689,6 +760,26 @@ static void init_capture_dosbox_settings(Section_prop& secprop)
 	        "Keybindings for taking single screenshots in specific formats are also\n"
 	        "available.");
 	assert(str_prop);
+
+	str_prop = secprop.Add_string("video_capture_format", when_idle, "zmbv");
+	str_prop->Set_values({"zmbv", "raw"});
+	str_prop->Set_help(
+	        "Set the format of video captures ('zmbv' by default):\n"
+	        "  zmbv:  The video is compressed with the lossless ZMBV codec and saved\n"
+	        "         with the audio as 'videoNNNN.avi'.\n"
+	        "  raw:   The uncompressed frames are written as 32-bit BGRX pixels to\n"
+	        "         'videoNNNN.raw', and the audio as 16-bit stereo samples to\n"
+	        "         'videoNNNN.pcm', for encoding with external tools such as FFmpeg.\n"
+	        "         The FFmpeg parameters of the streams are logged when they start.\n"
+	        "         New streams are started when the video mode changes.");
+	assert(str_prop);
+
+	str_prop = secprop.Add_string("raw_video_capture_path", when_idle, "");
+	str_prop->Set_help(
+	        "Write the raw video captures to '<path>.raw' and '<path>.pcm' instead of\n"
+	        "the capture directory (unset by default). These can be named pipes read\n"
+	        "by an encoder, e.g. created with 'mkfifo' on Linux and macOS.");
+	assert(str_prop);
 }
 
 void CAPTURE_AddConfigSection(const ConfigPtr& conf)
@@ -26,8 +26,10 @@
 
 #include "std_filesystem.h"
 
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <vector>
 
 enum class CaptureType {
 	Audio,
@@ -35,6 +37,8 @@ enum class CaptureType {
 	RawOplStream,
 	RadOplInstruments,
 	Video,
+	RawVideo,
+	RawVideoAudio,
 	RawImage,
 	UpscaledImage,
 	RenderedImage,
@@ -53,6 +57,14 @@ void CAPTURE_AddConfigSection(const ConfigPtr& conf);
 FILE* CAPTURE_CreateFile(const CaptureType type,
                          const std::optional<std_fs::path>& path = {});
 
+// Write and close the capture files on a background thread, so the calling
+// thread never waits for the disk; see 'capture_writer.h'. The file handle
+// must not be used directly after passing it to these.
+void CAPTURE_AppendToFile(FILE* handle, std::vector<uint8_t>&& data);
+void CAPTURE_WriteToFileAt(FILE* handle, const long offset,
+                           std::vector<uint8_t>&& data);
+void CAPTURE_CloseFile(FILE* handle);
+
 // Used to add the last rendered frame to be captured either as a screenshot
 // or as a video recording (or both).
 void CAPTURE_AddFrame(const RenderedImage& image, const float frames_per_second);
@@ -21,8 +21,10 @@
 
 #include "capture.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <vector>
 
 #include "mem.h"
 #include "setup.h"
@@ -32,14 +34,22 @@ static constexpr auto SampleFrameSize   = 4;
 static constexpr auto NumFramesInBuffer = 16 * 1024;
 static constexpr auto NumChannels       = 2;
 
+static constexpr auto BufferSize = NumFramesInBuffer * SampleFrameSize;
+
+// The header sizes are updated with every 16th buffer written, about every
+// 6 seconds at 44.1 kHz
+static constexpr auto NumBuffersPerHeaderUpdate = 16;
+
 static struct {
 	FILE* handle = nullptr;
 
-	uint16_t buf[NumFramesInBuffer][NumChannels] = {};
+	// Handed over to the capture writer when full
+	std::vector<uint8_t> buf = {};
 
 	uint32_t sample_rate_hz  = 0;
-	uint32_t buf_frames_used = 0;
-	
+	uint32_t buffers_written = 0;
+
+
 	// TODO A 16-bit / 44.1kHz WAV file is limited to a bit less than 4GB
 	// worth of sample data because the chunk sizes are stored as 32-bit
 	// unsigned integers in the RIFF container the WAV format uses.
@@ -73,6 +83,29 @@ static uint8_t wav_header[] = {
 };
 // clang-format on
 
+static std::vector<uint8_t> make_wav_header()
+{
+	constexpr auto chunk_header_size = 8;
+
+	const auto riff_chunk_size = static_cast<uint32_t>(wave.data_bytes_written +
+	                             sizeof(wav_header) - chunk_header_size);
+
+	constexpr auto riff_chunk_size_offset = 0x04;
+	host_writed(&wav_header[riff_chunk_size_offset], riff_chunk_size);
+
+	constexpr auto sample_rate_offset = 0x18;
+	host_writed(&wav_header[sample_rate_offset], wave.sample_rate_hz);
+
+	constexpr auto byte_rate_offset = 0x1c;
+	host_writed(&wav_header[byte_rate_offset],
+	            wave.sample_rate_hz * SampleFrameSize);
+
+	constexpr auto data_chunk_size_offset = 0x28;
+	host_writed(&wav_header[data_chunk_size_offset], wave.data_bytes_written);
+
+	return std::vector<uint8_t>(std::begin(wav_header), std::end(wav_header));
+}
+
 static void create_wave_file(const uint32_t sample_rate_hz)
 {
 	wave.handle = CAPTURE_CreateFile(CaptureType::Audio);
@@ -81,10 +114,28 @@ static void create_wave_file(const uint32_t sample_rate_hz)
 	}
 
 	wave.sample_rate_hz     = sample_rate_hz;
-	wave.buf_frames_used    = 0;
+	wave.buffers_written    = 0;
 	wave.data_bytes_written = 0;
 
-	fwrite(wav_header, 1, sizeof(wav_header), wave.handle);
+	wave.buf.clear();
+	wave.buf.reserve(BufferSize);
+
+	CAPTURE_AppendToFile(wave.handle, make_wav_header());
+}
+
+static void write_buffer()
+{
+	const auto num_bytes = static_cast<uint32_t>(wave.buf.size());
+
+	CAPTURE_AppendToFile(wave.handle, std::move(wave.buf));
+	wave.data_bytes_written += num_bytes;
+
+	if (++wave.buffers_written % NumBuffersPerHeaderUpdate == 0) {
+		CAPTURE_WriteToFileAt(wave.handle, 0, make_wav_header());
+	}
+
+	wave.buf = {};
+	wave.buf.reserve(BufferSize);
 }
 
 void capture_audio_add_data(const uint32_t sample_rate_hz,
@@ -100,32 +151,20 @@ void capture_audio_add_data(const uint32_t sample_rate_hz,
 		return;
 	}
 
-	const int16_t* data   = sample_frames;
-	auto remaining_frames = num_sample_frames;
-
-	while (remaining_frames > 0) {
-		uint32_t frames_left = NumFramesInBuffer - wave.buf_frames_used;
-		if (!frames_left) {
-			const auto bytes_to_write = NumFramesInBuffer * SampleFrameSize;
-			fwrite(wave.buf, 1, bytes_to_write, wave.handle);
-
-			wave.data_bytes_written += bytes_to_write;
-			wave.buf_frames_used = 0;
+	auto data            = reinterpret_cast<const uint8_t*>(sample_frames);
+	auto remaining_bytes = static_cast<size_t>(num_sample_frames) * SampleFrameSize;
 
-			frames_left = NumFramesInBuffer;
+	while (remaining_bytes > 0) {
+		if (wave.buf.size() == BufferSize) {
+			write_buffer();
 		}
+		const auto num_bytes = std::min(remaining_bytes,
+		                                BufferSize - wave.buf.size());
 
-		if (frames_left > remaining_frames) {
-			frames_left = remaining_frames;
-		}
-
-		memcpy(&wave.buf[wave.buf_frames_used],
-		       data,
-		       frames_left * SampleFrameSize);
+		wave.buf.insert(wave.buf.end(), data, data + num_bytes);
 
-		wave.buf_frames_used += frames_left;
-		data += frames_left * NumChannels;
-		remaining_frames -= frames_left;
+		data += num_bytes;
+		remaining_bytes -= num_bytes;
 	}
 }
 
@@ -136,32 +175,13 @@ void capture_audio_finalise()
 	}
 
 	// Flush audio buffer
-	const auto bytes_to_write = wave.buf_frames_used * SampleFrameSize;
-	fwrite(wave.buf, 1, bytes_to_write, wave.handle);
+	const auto bytes_to_write = static_cast<uint32_t>(wave.buf.size());
+	CAPTURE_AppendToFile(wave.handle, std::move(wave.buf));
 	wave.data_bytes_written += bytes_to_write;
 
 	// Update headers
-	constexpr auto chunk_header_size = 8;
-
-	const auto riff_chunk_size = static_cast<uint32_t>(wave.data_bytes_written +
-	                             sizeof(wav_header) - chunk_header_size);
-
-	constexpr auto riff_chunk_size_offset = 0x04;
-	host_writed(&wav_header[riff_chunk_size_offset], riff_chunk_size);
-
-	constexpr auto sample_rate_offset = 0x18;
-	host_writed(&wav_header[sample_rate_offset], wave.sample_rate_hz);
-
-	constexpr auto byte_rate_offset = 0x1c;
-	host_writed(&wav_header[byte_rate_offset],
-	            wave.sample_rate_hz * SampleFrameSize);
-
-	constexpr auto data_chunk_size_offset = 0x28;
-	host_writed(&wav_header[data_chunk_size_offset], wave.data_bytes_written);
-
-	fseek(wave.handle, 0, 0);
-	fwrite(wav_header, 1, sizeof(wav_header), wave.handle);
-	fclose(wave.handle);
+	CAPTURE_WriteToFileAt(wave.handle, 0, make_wav_header());
+	CAPTURE_CloseFile(wave.handle);
 
 	wave = {};
 
@@ -21,22 +21,22 @@
 
 #include "capture.h"
 
-#include <array>
-#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 
 #include "midi.h"
 #include "pic.h"
-#include "support.h"
+
+static constexpr auto BufferSize = 4 * 1024;
 
 static struct {
 	FILE* handle = nullptr;
 
-	std::array<uint8_t, 4 * 1024> buffer = {};
+	// Handed over to the capture writer when full
+	std::vector<uint8_t> buffer = {};
 
-	uint32_t bytes_used    = 0;
 	uint32_t bytes_written = 0;
 	uint32_t last_tick     = 0;
 } midi = {};
@@ -53,14 +53,37 @@ static uint8_t midi_header[] = {
 };
 // clang-format on
 
+// Updates the track chunk's length, so the file is complete up to the last
+// written buffer even if it never gets finalised
+static void write_track_length()
+{
+	std::vector<uint8_t> size = {
+	        static_cast<uint8_t>(midi.bytes_written >> 24),
+	        static_cast<uint8_t>(midi.bytes_written >> 16),
+	        static_cast<uint8_t>(midi.bytes_written >> 8),
+	        static_cast<uint8_t>(midi.bytes_written >> 0),
+	};
+
+	constexpr auto midi_header_size_offset = 18;
+	CAPTURE_WriteToFileAt(midi.handle, midi_header_size_offset, std::move(size));
+}
+
+static void write_buffer()
+{
+	midi.bytes_written += static_cast<uint32_t>(midi.buffer.size());
+	CAPTURE_AppendToFile(midi.handle, std::move(midi.buffer));
+
+	midi.buffer = {};
+	midi.buffer.reserve(BufferSize);
+}
+
 static void raw_midi_add(const uint8_t data)
 {
-	midi.buffer[midi.bytes_used++] = data;
+	midi.buffer.push_back(data);
 
-	if (midi.bytes_used >= midi.buffer.size()) {
-		midi.bytes_written += midi.bytes_used;
-		fwrite(midi.buffer.data(), 1, midi.buffer.size(), midi.handle);
-		midi.bytes_used = 0;
+	if (midi.buffer.size() >= BufferSize) {
+		write_buffer();
+		write_track_length();
 	}
 }
 
@@ -84,7 +107,13 @@ static void create_midi_file()
 	if (!midi.handle) {
 		return;
 	}
-	fwrite(midi_header, 1, sizeof(midi_header), midi.handle);
+	midi.buffer.reserve(BufferSize);
+	midi.buffer.assign(std::begin(midi_header), std::end(midi_header));
+	write_buffer();
+
+	// The track length doesn't include the header
+	midi.bytes_written = 0;
+
 	midi.last_tick = PIC_Ticks;
 }
 
@@ -125,28 +154,10 @@ void capture_midi_finalise()
 	raw_midi_add(0x00);
 
 	// Flush buffer
-	fwrite(midi.buffer.data(), 1, midi.bytes_used, midi.handle);
-	midi.bytes_written += midi.bytes_used;
-
-	constexpr auto midi_header_size_offset = 18;
-	if (fseek(midi.handle, midi_header_size_offset, SEEK_SET) != 0) {
-		LOG_WARNING("CAPTURE: Failed to seek in captured MIDI file '%s'",
-		            safe_strerror(errno).c_str());
-		fclose(midi.handle);
-		midi = {};
-		return;
-	}
-
-	uint8_t size[4];
-
-	size[0] = (uint8_t)(midi.bytes_written >> 24);
-	size[1] = (uint8_t)(midi.bytes_written >> 16);
-	size[2] = (uint8_t)(midi.bytes_written >> 8);
-	size[3] = (uint8_t)(midi.bytes_written >> 0);
-	fwrite(&size, 1, 4, midi.handle);
+	write_buffer();
+	write_track_length();
 
-	fclose(midi.handle);
+	CAPTURE_CloseFile(midi.handle);
 	midi = {};
-	return;
 }
 
@@ -0,0 +1,221 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "capture_raw_video.h"
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+#include "capture.h"
+#include "checks.h"
+#include "image/image_decoder.h"
+
+CHECK_NARROWING();
+
+static constexpr auto BytesPerOutputPixel = 4;
+static constexpr auto SampleFrameSize     = 4;
+
+// The audio of one frame is at most 1/10th of a second at 48 kHz in
+// practice, so this only guards against runaway growth
+static constexpr auto MaxAudioBytesPerFrame = 48000 * SampleFrameSize;
+
+static struct {
+	FILE* video_handle = nullptr;
+	FILE* audio_handle = nullptr;
+
+	uint16_t width          = 0;
+	uint16_t height         = 0;
+	float frames_per_second = 0.0f;
+
+	// The audio captured since the last frame, written along with the
+	// next frame to keep the streams in sync
+	std::vector<uint8_t> audio    = {};
+	uint32_t audio_sample_rate_hz = 0;
+
+	ImageDecoder image_decoder = {};
+} raw_video = {};
+
+static bool create_stream_files(const std::optional<std_fs::path>& path)
+{
+	std_fs::path video_path = {};
+	std_fs::path audio_path = {};
+
+	if (path) {
+		video_path = *path;
+		video_path += ".raw";
+		audio_path = *path;
+		audio_path += ".pcm";
+	} else {
+		const auto index = get_next_capture_index(CaptureType::RawVideo);
+		video_path = generate_capture_filename(CaptureType::RawVideo, index);
+		audio_path = generate_capture_filename(CaptureType::RawVideoAudio, index);
+	}
+
+	// Opening a named pipe waits for its reader, so open the video
+	// stream first as FFmpeg opens its inputs in order
+	raw_video.video_handle = CAPTURE_CreateFile(CaptureType::RawVideo, video_path);
+	if (!raw_video.video_handle) {
+		return false;
+	}
+	raw_video.audio_handle = CAPTURE_CreateFile(CaptureType::RawVideoAudio,
+	                                            audio_path);
+	if (!raw_video.audio_handle) {
+		CAPTURE_CloseFile(raw_video.video_handle);
+		raw_video.video_handle = nullptr;
+		return false;
+	}
+
+	LOG_MSG("CAPTURE: Raw video stream parameters for FFmpeg: "
+	        "-f rawvideo -pixel_format bgr0 -video_size %dx%d -framerate %.6f -i '%s' "
+	        "-f s16le -sample_rate %u -channels 2 -i '%s'",
+	        raw_video.width,
+	        raw_video.height,
+	        static_cast<double>(raw_video.frames_per_second),
+	        video_path.string().c_str(),
+	        raw_video.audio_sample_rate_hz,
+	        audio_path.string().c_str());
+	return true;
+}
+
+void capture_raw_video_finalise()
+{
+	if (raw_video.video_handle) {
+		CAPTURE_CloseFile(raw_video.video_handle);
+	}
+	if (raw_video.audio_handle) {
+		CAPTURE_AppendToFile(raw_video.audio_handle, std::move(raw_video.audio));
+		CAPTURE_CloseFile(raw_video.audio_handle);
+	}
+	raw_video.video_handle = nullptr;
+	raw_video.audio_handle = nullptr;
+	raw_video.audio        = {};
+}
+
+void capture_raw_video_add_audio_data(const uint32_t sample_rate,
+                                      const uint32_t num_sample_frames,
+                                      const int16_t* sample_frames)
+{
+	// The sample rate is needed for the stream parameters, so it's
+	// tracked before the first frame too
+	raw_video.audio_sample_rate_hz = sample_rate;
+
+	if (!raw_video.audio_handle) {
+		return;
+	}
+	const auto num_bytes = static_cast<size_t>(num_sample_frames) * SampleFrameSize;
+	if (raw_video.audio.size() + num_bytes > MaxAudioBytesPerFrame) {
+		return;
+	}
+
+	// The mixer's samples are in host byte order
+	const auto data = reinterpret_cast<const uint8_t*>(sample_frames);
+#if defined(WORDS_BIGENDIAN)
+	for (size_t i = 0; i < num_bytes; i += 2) {
+		raw_video.audio.push_back(data[i + 1]);
+		raw_video.audio.push_back(data[i]);
+	}
+#else
+	raw_video.audio.insert(raw_video.audio.end(), data, data + num_bytes);
+#endif
+}
+
+// Reconstructs the raw image as BGRX pixels in a single pass
+static std::vector<uint8_t> convert_frame(const RenderedImage& image)
+{
+	const auto& src = image.params;
+	assert(!image.is_flipped_vertically);
+
+	const auto row_skip_count   = static_cast<uint8_t>(src.rendered_double_scan ? 1 : 0);
+	const auto pixel_skip_count = static_cast<uint8_t>(
+	        src.rendered_pixel_doubling ? 1 : 0);
+
+	const auto row_bytes = static_cast<size_t>(raw_video.width) * BytesPerOutputPixel;
+
+	std::vector<uint8_t> frame(row_bytes * raw_video.height);
+	auto out = frame.data();
+
+	// Most of the true colour modes are rendered as BGRX already
+	if (src.pixel_format == PixelFormat::BGRX32_ByteArray && pixel_skip_count == 0) {
+		const auto src_pitch = image.pitch * (row_skip_count + 1);
+
+		auto src_row = image.image_data;
+		for (auto y = 0; y < raw_video.height; ++y, src_row += src_pitch) {
+			std::memcpy(out, src_row, row_bytes);
+			out += row_bytes;
+		}
+		return frame;
+	}
+
+	auto& decoder = raw_video.image_decoder;
+	decoder.Init(image, row_skip_count, pixel_skip_count);
+
+	for (auto y = 0; y < raw_video.height; ++y) {
+		for (auto x = 0; x < raw_video.width; ++x) {
+			const auto pixel = decoder.GetNextPixelAsRgb888();
+
+			*out++ = pixel.blue;
+			*out++ = pixel.green;
+			*out++ = pixel.red;
+			*out++ = 0;
+		}
+		decoder.AdvanceRow();
+	}
+	return frame;
+}
+
+void capture_raw_video_add_frame(const RenderedImage& image,
+                                 const float frames_per_second,
+                                 const std::optional<std_fs::path>& path)
+{
+	const auto& src = image.params;
+
+	const auto raw_width = check_cast<uint16_t>(
+	        src.width / (src.rendered_pixel_doubling ? 2 : 1));
+
+	const auto raw_height = check_cast<uint16_t>(
+	        src.height / (src.rendered_double_scan ? 2 : 1));
+
+	// The streams have fixed parameters, so start new ones if any of them
+	// changes
+	if (raw_video.video_handle &&
+	    (raw_video.width != raw_width || raw_video.height != raw_height ||
+	     raw_video.frames_per_second != frames_per_second)) {
+		LOG_MSG("CAPTURE: Video mode changed, starting new raw video streams");
+		capture_raw_video_finalise();
+	}
+
+	if (!raw_video.video_handle) {
+		raw_video.width             = raw_width;
+		raw_video.height            = raw_height;
+		raw_video.frames_per_second = frames_per_second;
+
+		if (!create_stream_files(path)) {
+			return;
+		}
+	}
+
+	// The conversion is the only copy of the frame; the capture writer
+	// hands the buffers over to the disk or pipe on its own thread
+	CAPTURE_AppendToFile(raw_video.video_handle, convert_frame(image));
+
+	CAPTURE_AppendToFile(raw_video.audio_handle, std::move(raw_video.audio));
+	raw_video.audio = {};
+}
@@ -0,0 +1,50 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CAPTURE_RAW_VIDEO_H
+#define DOSBOX_CAPTURE_RAW_VIDEO_H
+
+#include <optional>
+
+#include "render.h"
+#include "std_filesystem.h"
+
+// Raw video capture for external encoders
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Writes the raw, uncompressed frames as a stream of 32-bit BGRX pixels
+// (FFmpeg's 'bgr0' pixel format), and the audio as a stream of 16-bit
+// signed little-endian stereo samples. The streams have no headers, so they
+// can be written into named pipes read by FFmpeg; the parameters are logged
+// at the start of each stream.
+//
+// If `path` is provided, the streams are written to '<path>.raw' and
+// '<path>.pcm', otherwise to autogenerated 'videoNNNN' files in the capture
+// directory.
+void capture_raw_video_add_frame(const RenderedImage& image,
+                                 const float frames_per_second,
+                                 const std::optional<std_fs::path>& path);
+
+void capture_raw_video_add_audio_data(const uint32_t sample_rate,
+                                      const uint32_t num_sample_frames,
+                                      const int16_t* sample_frames);
+
+void capture_raw_video_finalise();
+
+#endif
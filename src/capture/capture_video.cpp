@@ -21,13 +21,24 @@
 
 #include "capture.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
-
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "host_memory.h"
+#include "host_threads.h"
 #include "math_utils.h"
 #include "mem.h"
 #include "render.h"
 #include "support.h"
+#include "tracy.h"
 
 #include "zmbv/zmbv.h"
 
@@ -38,28 +49,130 @@ static constexpr auto NumAudioChannels = 2;
 
 static constexpr auto AviHeaderSize = 500;
 
+// Threaded compression
+// ~~~~~~~~~~~~~~~~~~~~
+// The emulation thread only copies the frames and the audio captured along
+// with them into a queue. An encoder thread runs the codec's motion vector
+// search (itself split across several threads by block rows), and a writer
+// thread deflates the encoded frames and writes them to the AVI file, so
+// the deflating of a frame overlaps the search of the next one.
+
+// A copy of a rendered frame and of the audio captured before it, queued by
+// the emulation thread
+struct CapturedFrame {
+	RenderedImage image     = {};
+	float frames_per_second = 0.0f;
+
+	// Repeats the previous frame, without image data
+	bool is_duplicate = false;
+
+	std::vector<int16_t> audio = {};
+	uint32_t sample_rate       = 0;
+};
+
+// The buffers of a frame in the writer's queue, recycled once written
+struct FrameBuffers {
+	VideoCodec::EncodedFrame encoded = {};
+	std::vector<uint8_t> output      = {};
+};
+
+// An encoded frame, queued by the encoder thread. Duplicated frames are
+// written as empty "drop" chunks that players show as a repeat of the
+// previous frame.
+struct EncodedFrame {
+	// Set on the first frame of a new file
+	std::shared_ptr<VideoCodec> new_codec = {};
+	int width                             = 0;
+	int height                            = 0;
+	float frames_per_second               = 0.0f;
+
+	FrameBuffers buffers = {};
+	bool has_video       = false;
+	bool is_keyframe     = false;
+	bool is_duplicate    = false;
+
+	std::vector<int16_t> audio = {};
+	uint32_t sample_rate       = 0;
+};
+
+// The host memory a captured frame holds while it waits for the encoder
+static size_t get_queued_bytes(const CapturedFrame& frame)
+{
+	constexpr size_t PaletteBytes = 256 * 4;
+
+	const auto& image = frame.image;
+
+	auto num_bytes = frame.audio.size() * sizeof(int16_t);
+	if (image.image_data) {
+		num_bytes += static_cast<size_t>(image.params.height) * image.pitch;
+	}
+	if (image.palette_data) {
+		num_bytes += PaletteBytes;
+	}
+	return num_bytes;
+}
+
+static constexpr size_t MaxCapturedFrames = 8;
+static constexpr size_t MaxEncodedFrames  = 4;
+static constexpr int MaxSearchThreads     = 4;
+
+static struct {
+	std::thread encoder = {};
+	std::thread writer  = {};
+
+	std::mutex mutex                  = {};
+	std::condition_variable has_room  = {};
+	std::condition_variable has_items = {};
+
+	std::deque<CapturedFrame> captured_frames = {};
+	std::deque<EncodedFrame> encoded_frames   = {};
+	std::vector<FrameBuffers> spare_buffers   = {};
+
+	bool is_running   = false;
+	bool stop_encoder = false;
+	bool stop_writer  = false;
+} pipeline = {};
+
+// The audio captured since the last frame, only used on the emulation thread
+static struct {
+	std::vector<int16_t> samples = {};
+	uint32_t sample_rate         = 0;
+} pending_audio = {};
+
+// The parameters of the last queued frame, only used on the emulation thread
+static struct {
+	bool has_frame          = false;
+	ImageInfo params        = {};
+	float frames_per_second = 0.0f;
+} last_frame = {};
+
+// The state of the encoder thread
+static struct {
+	std::shared_ptr<VideoCodec> codec = {};
+	uint16_t width                    = 0;
+	uint16_t height                   = 0;
+	PixelFormat pixel_format          = {};
+	float frames_per_second           = 0.0f;
+	uint32_t frames                   = 0;
+} encoder = {};
+
+// The file being written, only used on the writer thread
 static struct {
 	FILE* handle = nullptr;
 
-	uint32_t frames          = 0;
-	VideoCodec* codec        = nullptr;
-	int width                = 0;
-	int height               = 0;
-	PixelFormat pixel_format = {};
-	float frames_per_second  = 0.0f;
+	uint32_t frames                   = 0;
+	std::shared_ptr<VideoCodec> codec = {};
+	int width                         = 0;
+	int height                        = 0;
+	float frames_per_second           = 0.0f;
 
 	uint32_t written           = 0;
-	uint32_t buf_size          = 0;
-	std::vector<uint8_t> buf   = {};
 	std::vector<uint8_t> index = {};
 	uint32_t index_used        = 0;
 
 	struct {
-		int16_t buf[NumSampleFramesInBuffer][NumAudioChannels] = {};
-
-		uint32_t sample_rate     = 0;
-		uint32_t buf_frames_used = 0;
-		uint32_t bytes_written   = 0;
+		uint32_t sample_rate   = 0;
+		uint32_t bytes_written = 0;
 	} audio = {};
 } video = {};
 
@@ -136,7 +249,7 @@ static void add_avi_chunk(const char* tag, const uint32_t size,
 	host_writed(index + 12, size);
 }
 
-void capture_video_finalise()
+static void finalise_avi_file()
 {
 	if (!video.handle) {
 		return;
@@ -297,7 +410,7 @@ void capture_video_finalise()
 	fwrite(&avi_header, 1, AviHeaderSize, video.handle);
 
 	fclose(video.handle);
-	delete video.codec;
+	video.codec  = {};
 	video.handle = nullptr;
 }
 
@@ -305,54 +418,46 @@ void capture_video_add_audio_data(const uint32_t sample_rate,
                                   const uint32_t num_sample_frames,
                                   const int16_t* sample_frames)
 {
-	if (!video.handle) {
+	// Like the video, the audio starts with the first frame
+	if (!pipeline.is_running) {
 		return;
 	}
-	auto frames_left = NumSampleFramesInBuffer - video.audio.buf_frames_used;
-	if (frames_left > num_sample_frames) {
-		frames_left = num_sample_frames;
-	}
+	auto& samples = pending_audio.samples;
+
+	const auto frames_used = samples.size() / NumAudioChannels;
+	const auto frames_left = std::min(static_cast<size_t>(num_sample_frames),
+	                                  NumSampleFramesInBuffer - frames_used);
 
-	memcpy(&video.audio.buf[video.audio.buf_frames_used],
-	       sample_frames,
-	       frames_left * SampleFrameSize);
+	samples.insert(samples.end(),
+	               sample_frames,
+	               sample_frames + frames_left * NumAudioChannels);
 
-	video.audio.buf_frames_used += frames_left;
-	video.audio.sample_rate = sample_rate;
+	pending_audio.sample_rate = sample_rate;
 }
 
-static void create_avi_file(const uint16_t width, const uint16_t height,
-                            const PixelFormat pixel_format,
-                            const float frames_per_second, ZMBV_FORMAT format)
+static void create_avi_file(const EncodedFrame& frame)
 {
+	video.codec = frame.new_codec;
+
 	video.handle = CAPTURE_CreateFile(CaptureType::Video);
 	if (!video.handle) {
 		return;
 	}
-	video.codec = new VideoCodec();
-	if (!video.codec->SetupCompress(width, height)) {
-		return;
-	}
-
-	video.buf_size = video.codec->NeededSize(width, height, format);
-	video.buf.resize(video.buf_size);
 
 	video.index.resize(16 * 4096);
 	video.index_used = 8;
 
-	video.width             = width;
-	video.height            = height;
-	video.pixel_format      = pixel_format;
-	video.frames_per_second = frames_per_second;
+	video.width             = frame.width;
+	video.height            = frame.height;
+	video.frames_per_second = frame.frames_per_second;
 
 	for (auto i = 0; i < AviHeaderSize; ++i) {
 		fputc(0, video.handle);
 	}
 
-	video.frames                = 0;
-	video.written               = 0;
-	video.audio.buf_frames_used = 0;
-	video.audio.bytes_written   = 0;
+	video.frames              = 0;
+	video.written             = 0;
+	video.audio.bytes_written = 0;
 }
 
 // Performs some transforms on the passed down rendered image to make sure
@@ -379,7 +484,7 @@ static void create_avi_file(const uint16_t width, const uint16_t height,
 // artifacts (so 320x200 is rendered as 640x200, and 640x200 as 1280x200).
 // These are written as-is, otherwise we'd be losing information.
 //
-static void compress_raw_frame(const RenderedImage& image)
+static void compress_raw_frame(VideoCodec& codec, const RenderedImage& image)
 {
 	const auto& src = image.params;
 	auto src_row    = image.image_data;
@@ -396,7 +501,7 @@ static void compress_raw_frame(const RenderedImage& image)
 	const auto pixel_skip_count = (src.rendered_pixel_doubling ? 1 : 0);
 
 	auto compress_row = [&](const uint8_t* row_buffer) {
-		video.codec->CompressLines(1, &row_buffer);
+		codec.CompressLines(1, &row_buffer);
 	};
 
 	const auto src_bpp = to_bytes_per_pixel(src.pixel_format);
@@ -439,10 +544,39 @@ static void compress_raw_frame(const RenderedImage& image)
 	}
 }
 
-void capture_video_add_frame(const RenderedImage& image, const float frames_per_second)
+// Runs on the encoder thread
+static void queue_encoded_frame(EncodedFrame&& frame)
 {
-	const auto& src = image.params;
-	assert(src.width <= SCALER_MAXWIDTH);
+	std::unique_lock<std::mutex> lock(pipeline.mutex);
+	pipeline.has_room.wait(lock, [] {
+		return pipeline.encoded_frames.size() < MaxEncodedFrames;
+	});
+	pipeline.encoded_frames.push_back(std::move(frame));
+	pipeline.has_items.notify_all();
+}
+
+// Skips the motion search, compression and deflating altogether
+static void encode_duplicate_frame(CapturedFrame& captured)
+{
+	EncodedFrame frame = {};
+	frame.audio        = std::move(captured.audio);
+	frame.sample_rate  = captured.sample_rate;
+
+	// There's nothing to repeat if the previous frame didn't make it
+	frame.is_duplicate = (encoder.codec != nullptr);
+
+	queue_encoded_frame(std::move(frame));
+}
+
+static void encode_frame(CapturedFrame& captured)
+{
+	if (captured.is_duplicate) {
+		encode_duplicate_frame(captured);
+		return;
+	}
+
+	const auto& image = captured.image;
+	const auto& src   = image.params;
 
 	// To reconstruct the raw image, we must skip every second row when
 	// dealing with "baked-in" double scanning.
@@ -454,56 +588,244 @@ void capture_video_add_frame(const RenderedImage& image, const float frames_per_
 	const auto raw_height = check_cast<uint16_t>(
 	        src.height / (src.rendered_double_scan ? 2 : 1));
 
-	// Disable capturing if any of the test fails
-	if (video.handle && (video.width != raw_width || video.height != raw_height ||
-	                     video.pixel_format != src.pixel_format ||
-	                     video.frames_per_second != frames_per_second)) {
-		capture_video_finalise();
+	// Start a new file if any of the test fails
+	if (encoder.codec &&
+	    (encoder.width != raw_width || encoder.height != raw_height ||
+	     encoder.pixel_format != src.pixel_format ||
+	     encoder.frames_per_second != captured.frames_per_second)) {
+		encoder.codec = {};
 	}
 
 	const auto zmbv_format = to_zmbv_format(src.pixel_format);
 
-	if (!video.handle) {
-		create_avi_file(raw_width,
-		                raw_height,
-		                src.pixel_format,
-		                frames_per_second,
-		                zmbv_format);
+	EncodedFrame frame = {};
+	frame.audio        = std::move(captured.audio);
+	frame.sample_rate  = captured.sample_rate;
+
+	if (!encoder.codec) {
+		auto codec = std::make_shared<VideoCodec>();
+		if (codec->SetupCompress(raw_width, raw_height)) {
+			const auto num_threads = std::clamp(
+			        static_cast<int>(std::thread::hardware_concurrency()) - 2,
+			        1,
+			        MaxSearchThreads);
+			codec->SetSearchThreads(num_threads);
+
+			encoder.codec             = codec;
+			encoder.width             = raw_width;
+			encoder.height            = raw_height;
+			encoder.pixel_format      = src.pixel_format;
+			encoder.frames_per_second = captured.frames_per_second;
+			encoder.frames            = 0;
+
+			frame.new_codec         = codec;
+			frame.width             = raw_width;
+			frame.height            = raw_height;
+			frame.frames_per_second = captured.frames_per_second;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pipeline.mutex);
+		if (!pipeline.spare_buffers.empty()) {
+			frame.buffers = std::move(pipeline.spare_buffers.back());
+			pipeline.spare_buffers.pop_back();
+		}
+	}
+
+	if (encoder.codec) {
+		auto& codec       = *encoder.codec;
+		auto& output      = frame.buffers.output;
+		const auto flags  = (encoder.frames % 300 == 0) ? 1 : 0;
+		const auto needed = codec.NeededSize(raw_width, raw_height, zmbv_format);
+		output.resize(check_cast<size_t>(needed));
+
+		if (codec.PrepareCompressFrame(flags,
+		                               zmbv_format,
+		                               image.palette_data,
+		                               output.data(),
+		                               check_cast<uint32_t>(output.size()))) {
+			compress_raw_frame(codec, image);
+			codec.EncodeFrame(frame.buffers.encoded);
+
+			frame.has_video   = true;
+			frame.is_keyframe = (flags & 1);
+			encoder.frames++;
+		}
+	}
+	captured.image.free();
+
+	queue_encoded_frame(std::move(frame));
+}
+
+static void run_encoder()
+{
+	while (true) {
+		CapturedFrame captured = {};
+		{
+			std::unique_lock<std::mutex> lock(pipeline.mutex);
+			pipeline.has_items.wait(lock, [] {
+				return pipeline.stop_encoder ||
+				       !pipeline.captured_frames.empty();
+			});
+			if (pipeline.captured_frames.empty()) {
+				break;
+			}
+			captured = std::move(pipeline.captured_frames.front());
+			pipeline.captured_frames.pop_front();
+			HOST_MEMORY_Remove(HostMemoryUse::CaptureQueues,
+			                   get_queued_bytes(captured));
+		}
+		pipeline.has_room.notify_all();
+
+		ZoneScopedN("Video capture encode");
+		encode_frame(captured);
+	}
+	encoder.codec = {};
+}
+
+// Runs on the writer thread
+static void write_frame(EncodedFrame& frame)
+{
+	if (frame.new_codec) {
+		finalise_avi_file();
+		create_avi_file(frame);
 	}
 	if (!video.handle) {
 		return;
 	}
 
-	const auto codec_flags = (video.frames % 300 == 0) ? 1 : 0;
+	if (frame.has_video) {
+		const auto written = video.codec->DeflateFrame(frame.buffers.encoded);
+		if (written < 0) {
+			return;
+		}
+		add_avi_chunk("00dc",
+		              check_cast<uint32_t>(written),
+		              frame.buffers.output.data(),
+		              frame.is_keyframe ? 0x10 : 0x0);
+		video.frames++;
+	} else if (frame.is_duplicate) {
+		add_avi_chunk("00dc", 0, nullptr, 0x0);
+		video.frames++;
+	}
 
-	if (!video.codec->PrepareCompressFrame(codec_flags,
-	                                       zmbv_format,
-	                                       image.palette_data,
-	                                       video.buf.data(),
-	                                       video.buf_size)) {
-		return;
+	if (!frame.audio.empty()) {
+		const auto num_bytes = check_cast<uint32_t>(frame.audio.size() *
+		                                            sizeof(int16_t));
+		add_avi_chunk("01wb", num_bytes, frame.audio.data(), 0);
+
+		video.audio.bytes_written = num_bytes;
+		video.audio.sample_rate   = frame.sample_rate;
+	}
+}
+
+static void run_writer()
+{
+	while (true) {
+		EncodedFrame frame = {};
+		{
+			std::unique_lock<std::mutex> lock(pipeline.mutex);
+			pipeline.has_items.wait(lock, [] {
+				return pipeline.stop_writer ||
+				       !pipeline.encoded_frames.empty();
+			});
+			if (pipeline.encoded_frames.empty()) {
+				break;
+			}
+			frame = std::move(pipeline.encoded_frames.front());
+			pipeline.encoded_frames.pop_front();
+		}
+		pipeline.has_room.notify_all();
+
+		ZoneScopedN("Video capture write");
+		write_frame(frame);
+
+		std::lock_guard<std::mutex> lock(pipeline.mutex);
+		pipeline.spare_buffers.push_back(std::move(frame.buffers));
 	}
+	finalise_avi_file();
+}
 
-	compress_raw_frame(image);
+static void start_pipeline()
+{
+	pipeline.stop_encoder = false;
+	pipeline.stop_writer  = false;
+
+	pipeline.encoder = std::thread(run_encoder);
+	set_thread_name(pipeline.encoder, "dosbox:vidcap");
+	HOST_THREADS_Apply(pipeline.encoder, HostThreadGroup::Worker);
+
+	pipeline.writer = std::thread(run_writer);
+	set_thread_name(pipeline.writer, "dosbox:vidwrite");
+	HOST_THREADS_Apply(pipeline.writer, HostThreadGroup::Worker);
+
+	pipeline.is_running = true;
+}
 
-	const auto written = video.codec->FinishCompressFrame();
-	if (written < 0) {
+// Lets the threads finish compressing and writing the queued frames
+void capture_video_finalise()
+{
+	if (!pipeline.is_running) {
 		return;
 	}
+	{
+		std::lock_guard<std::mutex> lock(pipeline.mutex);
+		pipeline.stop_encoder = true;
+	}
+	pipeline.has_items.notify_all();
+	pipeline.encoder.join();
 
-	add_avi_chunk("00dc", written, video.buf.data(), codec_flags & 1 ? 0x10 : 0x0);
-	video.frames++;
+	{
+		std::lock_guard<std::mutex> lock(pipeline.mutex);
+		pipeline.stop_writer = true;
+	}
+	pipeline.has_items.notify_all();
+	pipeline.writer.join();
+
+	pipeline.spare_buffers.clear();
+	pending_audio.samples.clear();
+	last_frame = {};
 
-	//		LOG_MSG("CAPTURE: Frame %d video %d audio
-	//%d",video.frames, written, video.audio_buf_frames_used *4 );
-	if (video.audio.buf_frames_used) {
-		add_avi_chunk("01wb",
-		              video.audio.buf_frames_used * SampleFrameSize,
-		              video.audio.buf,
-		              0);
+	pipeline.is_running = false;
+}
+
+void capture_video_add_frame(const RenderedImage& image, const float frames_per_second)
+{
+	assert(image.params.width <= SCALER_MAXWIDTH);
+
+	if (!pipeline.is_running) {
+		start_pipeline();
+	}
 
-		video.audio.bytes_written = video.audio.buf_frames_used *
-		                            SampleFrameSize;
-		video.audio.buf_frames_used = 0;
+	// Frames the renderer found unchanged don't need copying, as long as
+	// they would go into the same file as the previous frame
+	const auto is_duplicate = image.is_unchanged && last_frame.has_frame &&
+	                          last_frame.params == image.params &&
+	                          last_frame.frames_per_second == frames_per_second;
+
+	CapturedFrame captured     = {};
+	captured.is_duplicate      = is_duplicate;
+	captured.frames_per_second = frames_per_second;
+	if (!is_duplicate) {
+		captured.image = image.deep_copy();
+
+		last_frame.has_frame         = true;
+		last_frame.params            = image.params;
+		last_frame.frames_per_second = frames_per_second;
 	}
+	captured.audio             = std::move(pending_audio.samples);
+	captured.sample_rate       = pending_audio.sample_rate;
+
+	pending_audio.samples = {};
+	pending_audio.samples.reserve(captured.audio.capacity());
+
+	// Only waits if the encoder falls behind by several frames
+	std::unique_lock<std::mutex> lock(pipeline.mutex);
+	pipeline.has_room.wait(lock, [] {
+		return pipeline.captured_frames.size() < MaxCapturedFrames;
+	});
+	HOST_MEMORY_Add(HostMemoryUse::CaptureQueues, get_queued_bytes(captured));
+	pipeline.captured_frames.push_back(std::move(captured));
+	pipeline.has_items.notify_all();
 }
@@ -0,0 +1,124 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "capture_writer.h"
+
+#include <cassert>
+#include <cerrno>
+
+#include "checks.h"
+#include "host_memory.h"
+#include "host_threads.h"
+#include "logging.h"
+#include "support.h"
+#include "tracy.h"
+
+CHECK_NARROWING();
+
+CaptureWriter::~CaptureWriter()
+{
+	Close();
+}
+
+void CaptureWriter::Append(FILE* handle, std::vector<uint8_t>&& data)
+{
+	CaptureWriteTask task = {};
+	task.handle           = handle;
+	task.data             = std::move(data);
+	Queue(std::move(task));
+}
+
+void CaptureWriter::WriteAt(FILE* handle, const long offset, std::vector<uint8_t>&& data)
+{
+	assert(offset >= 0);
+
+	CaptureWriteTask task = {};
+	task.handle           = handle;
+	task.data             = std::move(data);
+	task.offset           = offset;
+	Queue(std::move(task));
+}
+
+void CaptureWriter::CloseFile(FILE* handle)
+{
+	CaptureWriteTask task = {};
+	task.handle           = handle;
+	task.close            = true;
+	Queue(std::move(task));
+}
+
+void CaptureWriter::Queue(CaptureWriteTask&& task)
+{
+	assert(task.handle);
+
+	// Queued under the lock so that a file can't miss its close when the
+	// writer stops meanwhile
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!is_open) {
+		write_fifo.Start();
+		writer = std::thread(&CaptureWriter::WriteQueuedData, this);
+		set_thread_name(writer, "dosbox:capwrite");
+		HOST_THREADS_Apply(writer, HostThreadGroup::Worker);
+		is_open = true;
+	}
+	HOST_MEMORY_Add(HostMemoryUse::CaptureQueues, task.data.size());
+	write_fifo.Enqueue(std::move(task));
+}
+
+void CaptureWriter::Close()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!is_open) {
+		return;
+	}
+
+	// Stop queuing new writes
+	write_fifo.Stop();
+
+	// Let the writer finish the pending writes
+	if (writer.joinable()) {
+		writer.join();
+	}
+
+	is_open = false;
+}
+
+void CaptureWriter::WriteQueuedData()
+{
+	while (auto task = write_fifo.Dequeue()) {
+		ZoneScopedN("Capture write");
+		auto handle = task->handle;
+
+		const auto is_write_at = task->offset >= 0;
+		if (is_write_at && fseek(handle, task->offset, SEEK_SET) != 0) {
+			LOG_WARNING("CAPTURE: Failed to seek in capture file: %s",
+			            safe_strerror(errno).c_str());
+		} else if (!task->data.empty()) {
+			fwrite(task->data.data(), 1, task->data.size(), handle);
+		}
+		if (is_write_at) {
+			fseek(handle, 0, SEEK_END);
+		}
+		if (task->close) {
+			fclose(handle);
+		}
+		HOST_MEMORY_Remove(HostMemoryUse::CaptureQueues, task->data.size());
+	}
+}
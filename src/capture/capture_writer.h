@@ -0,0 +1,88 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CAPTURE_WRITER_H
+#define DOSBOX_CAPTURE_WRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rwqueue.h"
+
+struct CaptureWriteTask {
+	FILE* handle = nullptr;
+
+	// Written at the end of the file, or at 'offset' if it's not negative
+	std::vector<uint8_t> data = {};
+	long offset               = -1;
+
+	// Closes the file after the write
+	bool close = false;
+};
+
+// Threaded capture file writer; the audio, MIDI and raw OPL capturers hand
+// their filled buffers over to it, so the mixer and emulation threads never
+// wait for slow disks or network filesystems. The writes are done in the
+// order they were queued in, and the thread is started on the first write.
+//
+// Writing at an offset is meant for updating the sizes in the file headers
+// as the recording goes on; the following writes continue at the end of the
+// file. This way the files are playable even if DOSBox never gets to close
+// them, e.g. after a crash.
+//
+class CaptureWriter {
+public:
+	CaptureWriter() = default;
+	~CaptureWriter();
+
+	void Append(FILE* handle, std::vector<uint8_t>&& data);
+	void WriteAt(FILE* handle, long offset, std::vector<uint8_t>&& data);
+
+	// Closes the file once its queued writes are done
+	void CloseFile(FILE* handle);
+
+	// Waits for the queued writes to finish and stops the thread
+	void Close();
+
+	// prevent copying
+	CaptureWriter(const CaptureWriter&) = delete;
+	// prevent assignment
+	CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+private:
+	// About 6 seconds of CD quality audio in the WAV capturer's buffers
+	static constexpr auto MaxQueuedWrites = 256;
+
+	void Queue(CaptureWriteTask&& task);
+	void WriteQueuedData();
+
+	RWQueue<CaptureWriteTask> write_fifo{MaxQueuedWrites};
+	std::thread writer = {};
+
+	// The capturers run on different threads, so starting and stopping the
+	// writer is serialised
+	std::mutex mutex = {};
+	bool is_open     = false;
+};
+
+#endif // DOSBOX_CAPTURE_WRITER_H
@@ -20,8 +20,10 @@
 
 #include "image_capturer.h"
 
+#include <algorithm>
 #include <cassert>
 #include <string>
+#include <thread>
 
 #include "std_filesystem.h"
 
@@ -35,8 +37,15 @@ ImageCapturer::ImageCapturer(const std::string& grouped_mode_prefs)
 {
 	ConfigureGroupedMode(grouped_mode_prefs);
 
-	for (auto& image_saver : image_savers) {
-		image_saver.Open();
+	const auto num_savers = std::clamp(
+	        static_cast<int>(std::thread::hardware_concurrency() / 2),
+	        MinImageSavers,
+	        MaxImageSavers);
+
+	for (auto i = 0; i < num_savers; ++i) {
+		auto image_saver = std::make_unique<ImageSaver>();
+		image_saver->Open();
+		image_savers.emplace_back(std::move(image_saver));
 	}
 
 	LOG_MSG("CAPTURE: Image capturer started");
@@ -102,7 +111,7 @@ void ImageCapturer::ConfigureGroupedMode(const std::string& prefs)
 ImageCapturer::~ImageCapturer()
 {
 	for (auto& image_saver : image_savers) {
-		image_saver.Close();
+		image_saver->Close();
 	}
 
 	LOG_MSG("CAPTURE: Image capturer shutting down");
@@ -205,11 +214,28 @@ void ImageCapturer::CapturePostRenderImage(const RenderedImage& image)
 	state.grouped = CaptureState::Off;
 }
 
+// Picks the saver with the fewest queued images, going round-robin among the
+// idle ones
 ImageSaver& ImageCapturer::GetNextImageSaver()
 {
-	++current_image_saver_index;
-	current_image_saver_index %= NumImageSavers;
-	return image_savers[current_image_saver_index];
+	assert(!image_savers.empty());
+
+	const auto num_savers = image_savers.size();
+
+	auto best_index      = (current_image_saver_index + 1) % num_savers;
+	auto best_num_queued = image_savers[best_index]->GetNumQueuedImages();
+
+	for (size_t i = 2; i <= num_savers && best_num_queued > 0; ++i) {
+		const auto index = (current_image_saver_index + i) % num_savers;
+		const auto num_queued = image_savers[index]->GetNumQueuedImages();
+		if (num_queued < best_num_queued) {
+			best_index      = index;
+			best_num_queued = num_queued;
+		}
+	}
+
+	current_image_saver_index = best_index;
+	return *image_savers[current_image_saver_index];
 }
 
 void ImageCapturer::RequestRawCapture()
@@ -21,8 +21,9 @@
 #ifndef DOSBOX_IMAGE_CAPTURER_H
 #define DOSBOX_IMAGE_CAPTURER_H
 
-#include <array>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "std_filesystem.h"
 
@@ -96,9 +97,13 @@ private:
 
 	std_fs::path rendered_path    = {};
 
-	static constexpr auto NumImageSavers                = 3;
-	size_t current_image_saver_index                    = 0;
-	std::array<ImageSaver, NumImageSavers> image_savers = {};
+	// Enough savers for a grouped capture; more on hosts with many cores so
+	// rapid screenshot sequences don't back up
+	static constexpr auto MinImageSavers = 3;
+	static constexpr auto MaxImageSavers = 8;
+
+	size_t current_image_saver_index                      = 0;
+	std::vector<std::unique_ptr<ImageSaver>> image_savers = {};
 
 	void ConfigureGroupedMode(const std::string& prefs);
 
@@ -27,8 +27,10 @@
 
 #include "../capture.h"
 #include "checks.h"
+#include "host_threads.h"
 #include "png_writer.h"
 #include "support.h"
+#include "tracy.h"
 
 CHECK_NARROWING();
 
@@ -46,6 +48,7 @@ void ImageSaver::Open()
 	const auto worker_function = std::bind(&ImageSaver::SaveQueuedImages, this);
 	renderer = std::thread(worker_function);
 	set_thread_name(renderer, "dosbox:imgcap");
+	HOST_THREADS_Apply(renderer, HostThreadGroup::Worker);
 
 	is_open = true;
 }
@@ -80,9 +83,15 @@ void ImageSaver::QueueImage(const RenderedImage& image, const CapturedImageType
 	image_fifo.Enqueue(std::move(task));
 }
 
+size_t ImageSaver::GetNumQueuedImages()
+{
+	return image_fifo.Size();
+}
+
 void ImageSaver::SaveQueuedImages()
 {
 	while (auto task = image_fifo.Dequeue()) {
+		ZoneScopedN("Image capture");
 		SaveImage(*task);
 		task->image.free();
 	}
@@ -107,6 +116,9 @@ void ImageSaver::SaveImage(const SaveImageTask& task)
 		return;
 	}
 
+	// Catch up quickly with rapid screenshot sequences
+	use_fast_compression = (image_fifo.Size() > 0);
+
 	switch (task.image_type) {
 	case CapturedImageType::Raw: SaveRawImage(task.image); break;
 	case CapturedImageType::Upscaled: SaveUpscaledImage(task.image); break;
@@ -153,6 +165,9 @@ static void write_upscaled_png(FILE* outfile, PngWriter& png_writer,
 void ImageSaver::SaveRawImage(const RenderedImage& image)
 {
 	PngWriter png_writer = {};
+	if (use_fast_compression) {
+		png_writer.EnableFastCompression();
+	}
 
 	const auto& src = image.params;
 
@@ -229,6 +244,9 @@ static constexpr auto square_pixel_aspect_ratio = Fraction{1};
 void ImageSaver::SaveUpscaledImage(const RenderedImage& image)
 {
 	PngWriter png_writer = {};
+	if (use_fast_compression) {
+		png_writer.EnableFastCompression();
+	}
 
 	image_scaler.Init(image);
 
@@ -248,6 +266,9 @@ void ImageSaver::SaveUpscaledImage(const RenderedImage& image)
 void ImageSaver::SaveRenderedImage(const RenderedImage& image)
 {
 	PngWriter png_writer = {};
+	if (use_fast_compression) {
+		png_writer.EnableFastCompression();
+	}
 
 	const auto& src = image.params;
 
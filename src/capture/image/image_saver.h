@@ -87,6 +87,8 @@ public:
 	                const CapturedImageType type,
 	                const std::optional<std_fs::path>& path);
 
+	size_t GetNumQueuedImages();
+
 	// prevent copying
 	ImageSaver(const ImageSaver&) = delete;
 	// prevent assignment
@@ -114,6 +116,9 @@ private:
 	std::vector<uint8_t> row_buf = {};
 
 	FILE* outfile = nullptr;
+
+	// Set while more images are waiting to be saved
+	bool use_fast_compression = false;
 };
 
 #endif // DOSBOX_IMAGE_SAVER_H
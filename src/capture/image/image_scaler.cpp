@@ -233,6 +233,30 @@ void ImageScaler::AllocateBuffers()
 	// without branching (the interpolator operates on the current and the
 	// next pixel).
 	linear_row_buf.resize((input.params.width + 1u) * ComponentsPerRgbPixel);
+
+	PrecalculateSharpUpscaleColumns();
+}
+
+void ImageScaler::PrecalculateSharpUpscaleColumns()
+{
+	sharp_upscale_columns.resize(output.width);
+
+	for (auto x = 0; x < output.width; ++x) {
+		const auto x0 = static_cast<float>(x) * output.one_per_horiz_scale;
+		const auto floor_x0 = static_cast<uint16_t>(x0);
+		assert(floor_x0 < input.params.width);
+
+		// Calculate linear interpolation factor `t` between the current
+		// and the next pixel so that the interpolation "band" is one
+		// pixel wide at most at the edges of the pixel.
+		const auto x1 = x0 + output.one_per_horiz_scale;
+		const auto t  = std::max(x1 - (floor_x0 + 1.0f), 0.0f) *
+		               output.horiz_scale;
+
+		auto& column      = sharp_upscale_columns[x];
+		column.src_offset = floor_x0 * ComponentsPerRgbPixel;
+		column.t          = t;
+	}
 }
 
 uint16_t ImageScaler::GetOutputWidth() const
@@ -307,13 +331,8 @@ void ImageScaler::GenerateNextSharpUpscaledOutputRow()
 	auto row_start = linear_row_buf.begin();
 	auto out       = output.row_buf.begin();
 
-	for (auto x = 0; x < output.width; ++x) {
-		const auto x0 = static_cast<float>(x) * output.one_per_horiz_scale;
-		const auto floor_x0 = static_cast<uint16_t>(x0);
-		assert(floor_x0 < input.params.width);
-
-		const auto row_offs = floor_x0 * ComponentsPerRgbPixel;
-		auto pixel_addr     = row_start + row_offs;
+	for (const auto& column : sharp_upscale_columns) {
+		auto pixel_addr = row_start + column.src_offset;
 
 		// Current pixel
 		const auto r0 = *pixel_addr++;
@@ -325,12 +344,7 @@ void ImageScaler::GenerateNextSharpUpscaledOutputRow()
 		const auto g1 = *pixel_addr++;
 		const auto b1 = *pixel_addr++;
 
-		// Calculate linear interpolation factor `t` between the current
-		// and the next pixel so that the interpolation "band" is one
-		// pixel wide at most at the edges of the pixel.
-		const auto x1 = x0 + output.one_per_horiz_scale;
-		const auto t  = std::max(x1 - (floor_x0 + 1.0f), 0.0f) *
-		               output.horiz_scale;
+		const auto t = column.t;
 
 		const auto out_r = lerp(r0, r1, t);
 		const auto out_g = lerp(g0, g1, t);
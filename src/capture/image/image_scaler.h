@@ -101,6 +101,7 @@ private:
 	void UpdateOutputParamsUpscale();
 	void LogParams();
 	void AllocateBuffers();
+	void PrecalculateSharpUpscaleColumns();
 
 	void DecodeNextRowToLinearRgb();
 
@@ -114,6 +115,14 @@ private:
 
 	std::vector<float> linear_row_buf = {};
 
+	// The source pixel offsets and interpolation factors of the output
+	// columns, as they're the same for every row
+	struct SharpUpscaleColumn {
+		uint32_t src_offset = 0;
+		float t             = 0.0f;
+	};
+	std::vector<SharpUpscaleColumn> sharp_upscale_columns = {};
+
 	struct {
 		uint16_t width  = 0;
 		uint16_t height = 0;
@@ -49,6 +49,10 @@ public:
 
 	void WriteRow(std::vector<uint8_t>::const_iterator row);
 
+	// Trades some compression for speed, e.g. when images are being saved
+	// in quick succession. Must be called before the Init methods.
+	void EnableFastCompression();
+
 	// prevent copying
 	PngWriter(const PngWriter&) = delete;
 	// prevent assignment
@@ -67,6 +71,8 @@ private:
 
 	png_structp png_ptr    = nullptr;
 	png_infop png_info_ptr = nullptr;
+
+	bool use_fast_compression = false;
 };
 
 #endif
@@ -35,6 +35,7 @@
 
 CallBack_Handler CallBack_Handlers[CB_MAX];
 std::string CallBack_Description[CB_MAX];
+static bool CallBack_MayRunInline[CB_MAX];
 
 static callback_number_t call_stop    = 0;
 static callback_number_t call_idle    = 0;
@@ -47,7 +48,7 @@ static Bitu illegal_handler()
 	E_Exit("CALLBACK: Illegal CallBack called");
 }
 
-callback_number_t CALLBACK_Allocate()
+callback_number_t CALLBACK_Allocate(const bool may_run_inline)
 {
 	// Ensure our returned type can handle the maximum callback
 	static_assert(CB_MAX < std::numeric_limits<callback_number_t>::max());
@@ -55,6 +56,7 @@ callback_number_t CALLBACK_Allocate()
 	for (callback_number_t i = 1; i < CB_MAX; ++i) {
 		if (CallBack_Handlers[i] == &illegal_handler) {
 			CallBack_Handlers[i] = nullptr;
+			CallBack_MayRunInline[i] = may_run_inline;
 			return i;
 		}
 	}
@@ -65,6 +67,19 @@ callback_number_t CALLBACK_Allocate()
 void CALLBACK_DeAllocate(callback_number_t cb_num)
 {
 	CallBack_Handlers[cb_num] = &illegal_handler;
+	CallBack_MayRunInline[cb_num] = false;
+}
+
+void CALLBACK_SetMayRunInline(const callback_number_t cb_num, const bool may_run_inline)
+{
+	if (cb_num < CB_MAX) {
+		CallBack_MayRunInline[cb_num] = may_run_inline;
+	}
+}
+
+bool CALLBACK_MayRunInline(const callback_number_t cb_num)
+{
+	return cb_num < CB_MAX && CallBack_MayRunInline[cb_num];
 }
 
 void CALLBACK_Idle() {
@@ -340,9 +340,20 @@ restart_core:
 	/* Find correct Dynamic Block to run */
 	CacheBlock * block=chandler->FindCacheBlock(ip_point&4095);
 	if (!block) {
-		if (!chandler->invalidation_map || (chandler->invalidation_map[ip_point&4095]<4)) {
+		// translate unless the instruction (or its code region) is known
+		// to be modified, or the code hasn't been entered often enough
+		// yet (tiered mode)
+		const bool is_stable = (!chandler->invalidation_map ||
+		                        (chandler->invalidation_map[ip_point & 4095] < 4)) &&
+		                       !chandler->IsSelfModifying(ip_point & 4095);
+		const bool is_hot = !CPU_DynamicCoreTranslationThreshold ||
+		                    chandler->CountEntry(ip_point & 4095);
+		if (is_stable && is_hot) {
 			block=CreateCacheBlock(chandler,ip_point,32);
 		} else {
+			if (!is_stable) {
+				++smc_stats.interpreted_entries;
+			}
 			int32_t old_cycles=CPU_Cycles;
 			CPU_Cycles=1;
 
@@ -358,6 +369,7 @@ restart_core:
 	}
 run_block:
 	cache.block.running=nullptr;
+	block->cache.referenced = true;
 	const auto ret = sync_normal_fpu_and_run_dyn_code(block->cache.start);
 #	if C_DEBUG
 	cycle_count += 32;
@@ -121,6 +121,47 @@ enum BlockReturn {
 	BR_SMCBlock
 };
 
+// double precision operations on two registers of the fpu stack that
+// backends defining DRC_USE_NATIVE_FPU emit as host instructions
+enum FpuArithOp {
+	FPU_ARITH_ADD,
+	FPU_ARITH_MUL,
+	FPU_ARITH_SUB,
+	FPU_ARITH_SUBR,
+	FPU_ARITH_DIV,
+	FPU_ARITH_DIVR
+};
+
+// packed operations on two mmx registers that backends defining
+// DRC_USE_NATIVE_MMX emit as host vector instructions
+enum MmxOp {
+	MMX_OP_PADDB,
+	MMX_OP_PADDW,
+	MMX_OP_PADDD,
+	MMX_OP_PADDSB,
+	MMX_OP_PADDSW,
+	MMX_OP_PADDUSB,
+	MMX_OP_PADDUSW,
+	MMX_OP_PSUBB,
+	MMX_OP_PSUBW,
+	MMX_OP_PSUBD,
+	MMX_OP_PSUBSB,
+	MMX_OP_PSUBSW,
+	MMX_OP_PSUBUSB,
+	MMX_OP_PSUBUSW,
+	MMX_OP_PMULLW,
+	MMX_OP_PCMPEQB,
+	MMX_OP_PCMPEQW,
+	MMX_OP_PCMPEQD,
+	MMX_OP_PCMPGTB,
+	MMX_OP_PCMPGTW,
+	MMX_OP_PCMPGTD,
+	MMX_OP_PAND,
+	MMX_OP_PANDN,
+	MMX_OP_POR,
+	MMX_OP_PXOR
+};
+
 // identificator to signal self-modification of the currently executed block
 #define SMC_CURRENT_BLOCK	0xffff
 
@@ -188,6 +229,7 @@ static_assert(offsetof(core_dynrec_t, readdata) % sizeof(uint32_t) == 0,
 #endif
 
 #include "core_dynrec/decoder.h"
+#include "core_dynrec/cache_profile.h"
 
 CacheBlock *LinkBlocks(BlockReturn ret)
 {
@@ -261,12 +303,27 @@ Bits CPU_Core_Dynrec_Run() noexcept
 		CacheBlock *block = chandler->FindCacheBlock(ip_point & 4095);
 		if (!block) {
 			// no block found, thus translate the instruction stream
-			// unless the instruction is known to be modified
-			if (!chandler->invalidation_map || (chandler->invalidation_map[ip_point&4095]<4)) {
+			// unless the instruction (or its code region) is known to be
+			// modified, or the code hasn't been entered often enough yet
+			// (tiered mode)
+			const bool is_stable = (!chandler->invalidation_map ||
+			                        (chandler->invalidation_map[ip_point & 4095] < 4)) &&
+			                       !chandler->IsSelfModifying(ip_point & 4095);
+			const bool is_hot = !CPU_DynamicCoreTranslationThreshold ||
+			                    chandler->CountEntry(ip_point & 4095);
+			if (is_stable && is_hot) {
+				if (!chandler->HasActiveBlocks()) {
+					DynrecProfile::on_fresh_page(chandler, ip_point);
+				}
 				// translate up to 32 instructions
 				block=CreateCacheBlock(chandler,ip_point,32);
+				DynrecProfile::on_block_created(block);
 			} else {
-				// let the normal core handle this instruction to avoid zero-sized blocks
+				if (!is_stable) {
+					++smc_stats.interpreted_entries;
+				}
+				// let the normal core handle this instruction to avoid
+				// zero-sized blocks, or to keep cold code interpreted
 				Bitu old_cycles=CPU_Cycles;
 				CPU_Cycles=1;
 				Bits nc_retcode=CPU_Core_Normal_Run();
@@ -281,6 +338,7 @@ Bits CPU_Core_Dynrec_Run() noexcept
 
 run_block:
 		cache.block.running=nullptr;
+		block->cache.referenced = true;
 		// now we're ready to run the dynamic code block
 //		BlockReturn ret=((BlockReturn (*)(void))(block->cache.start))();
 		BlockReturn ret=core_dynrec.runcode(block->cache.start);
@@ -390,7 +448,13 @@ void CPU_Core_Dynrec_Cache_Init(bool enable_cache) {
 }
 
 void CPU_Core_Dynrec_Cache_Close(void) {
+	DynrecProfile::shutdown();
 	cache_close();
 }
 
+void CPU_Core_Dynrec_SetBlockCacheFile(const std_fs::path& file)
+{
+	DynrecProfile::init(file);
+}
+
 #endif
@@ -0,0 +1,307 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+	Persistent block profile for the dynrec core.
+
+	The translated host code itself can't be stored on disk: it embeds
+	absolute host addresses (register file, helper functions, the cache
+	itself) that change with every launch. What we can store is *where*
+	the blocks were, keyed by a hash of the guest code page they were
+	translated from.
+
+	When a fresh code page is seen, its contents are hashed. If the hash
+	matches a page from the previous session, all blocks known to start
+	in that page are translated in one go, before control reaches them.
+	This replaces the many single-block cache misses (and the normal core
+	fallbacks in between) during level loads with one batch per page.
+
+	Only blocks that end within their own page are recorded; translating
+	a block that crosses into the next page could raise a page fault
+	outside of the guest's control flow.
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#include "std_filesystem.h"
+
+namespace DynrecProfile {
+
+constexpr char FileMagic[] = {'D', 'R', 'B', 'P'};
+constexpr uint32_t FileVersion = 1;
+
+// Upper bound on the blocks recorded per page; a 4K page can't
+// reasonably hold more distinct block entry points than this
+constexpr uint16_t MaxBlocksPerPage = 1024;
+
+struct PageProfile {
+	bool big = false;
+	std::vector<uint16_t> block_starts = {};
+};
+
+struct State {
+	std_fs::path file = {};
+
+	// profiles loaded from the previous session, consumed on first use
+	std::unordered_map<uint64_t, PageProfile> loaded = {};
+
+	// profiles gathered in this session
+	std::unordered_map<uint64_t, PageProfile> recorded = {};
+
+	// content hash of the page each active code page handler was set up for
+	std::unordered_map<const CodePageHandler*, uint64_t> page_hashes = {};
+
+	bool warming = false;
+};
+
+static State state = {};
+
+static bool is_enabled()
+{
+	return !state.file.empty();
+}
+
+// 64-bit FNV-1a over the guest page contents
+static uint64_t hash_page(const uint8_t* page)
+{
+	constexpr uint64_t FnvOffsetBasis = 0xcbf29ce484222325;
+	constexpr uint64_t FnvPrime       = 0x100000001b3;
+
+	uint64_t hash = FnvOffsetBasis;
+	for (size_t i = 0; i < 4096; ++i) {
+		hash ^= page[i];
+		hash *= FnvPrime;
+	}
+	return hash;
+}
+
+static void add_block_start(PageProfile& profile, const uint16_t start)
+{
+	auto& starts = profile.block_starts;
+	if (starts.size() >= MaxBlocksPerPage) {
+		return;
+	}
+	if (std::find(starts.begin(), starts.end(), start) == starts.end()) {
+		starts.push_back(start);
+	}
+}
+
+static void load()
+{
+	state.loaded.clear();
+
+	std::ifstream in(state.file, std::ios::binary);
+	if (!in) {
+		return;
+	}
+
+	char magic[sizeof(FileMagic)] = {};
+	uint32_t version              = 0;
+	uint32_t num_pages            = 0;
+
+	in.read(magic, sizeof(magic));
+	in.read(reinterpret_cast<char*>(&version), sizeof(version));
+	in.read(reinterpret_cast<char*>(&num_pages), sizeof(num_pages));
+
+	if (!in || memcmp(magic, FileMagic, sizeof(magic)) != 0 ||
+	    version != FileVersion) {
+		LOG_WARNING("DYNREC: Ignoring invalid block cache file '%s'",
+		            state.file.string().c_str());
+		return;
+	}
+
+	for (uint32_t i = 0; i < num_pages; ++i) {
+		uint64_t hash       = 0;
+		uint8_t big         = 0;
+		uint16_t num_blocks = 0;
+
+		in.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+		in.read(reinterpret_cast<char*>(&big), sizeof(big));
+		in.read(reinterpret_cast<char*>(&num_blocks), sizeof(num_blocks));
+		if (!in || num_blocks > MaxBlocksPerPage) {
+			break;
+		}
+
+		PageProfile profile = {};
+		profile.big         = (big != 0);
+		profile.block_starts.resize(num_blocks);
+		in.read(reinterpret_cast<char*>(profile.block_starts.data()),
+		        num_blocks * sizeof(uint16_t));
+		if (!in) {
+			break;
+		}
+		state.loaded[hash] = std::move(profile);
+	}
+
+	LOG_MSG("DYNREC: Loaded block profiles for %zu code pages from '%s'",
+	        state.loaded.size(),
+	        state.file.string().c_str());
+}
+
+static void save()
+{
+	// carry over unused profiles so a short session doesn't wipe them
+	for (auto& [hash, profile] : state.loaded) {
+		state.recorded.try_emplace(hash, std::move(profile));
+	}
+	state.loaded.clear();
+
+	if (state.recorded.empty()) {
+		return;
+	}
+
+	std::ofstream out(state.file, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		LOG_WARNING("DYNREC: Can't write block cache file '%s'",
+		            state.file.string().c_str());
+		return;
+	}
+
+	const auto num_pages = static_cast<uint32_t>(state.recorded.size());
+
+	out.write(FileMagic, sizeof(FileMagic));
+	out.write(reinterpret_cast<const char*>(&FileVersion), sizeof(FileVersion));
+	out.write(reinterpret_cast<const char*>(&num_pages), sizeof(num_pages));
+
+	for (const auto& [hash, profile] : state.recorded) {
+		const uint8_t big = profile.big ? 1 : 0;
+		const auto num_blocks = static_cast<uint16_t>(
+		        profile.block_starts.size());
+
+		out.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+		out.write(reinterpret_cast<const char*>(&big), sizeof(big));
+		out.write(reinterpret_cast<const char*>(&num_blocks),
+		          sizeof(num_blocks));
+		out.write(reinterpret_cast<const char*>(profile.block_starts.data()),
+		          num_blocks * sizeof(uint16_t));
+	}
+}
+
+static void init(const std_fs::path& file)
+{
+	if (file == state.file) {
+		return;
+	}
+	if (is_enabled()) {
+		save();
+	}
+	state = {};
+	state.file = file;
+
+	if (is_enabled()) {
+		load();
+	}
+}
+
+static void shutdown()
+{
+	if (is_enabled()) {
+		save();
+	}
+	state = {};
+}
+
+// Called when a block is about to be translated in a code page that holds
+// no other blocks yet. Hashes the page and pre-translates the blocks known
+// from the previous session.
+static void on_fresh_page(CodePageHandler* codepage, const PhysPt ip_point)
+{
+	if (!is_enabled() || state.warming) {
+		return;
+	}
+
+	const PhysPt page_base = ip_point & ~PhysPt(4095);
+	const auto phys_page   = PAGING_GetPhysicalPage(page_base) >> 12;
+
+	const auto host_page = codepage->GetHostReadPt(phys_page);
+	if (!host_page) {
+		state.page_hashes.erase(codepage);
+		return;
+	}
+
+	const auto hash = hash_page(host_page);
+	state.page_hashes[codepage] = hash;
+
+	const auto it = state.loaded.find(hash);
+	if (it == state.loaded.end()) {
+		return;
+	}
+	const auto profile = std::move(it->second);
+	state.loaded.erase(it);
+
+	// Known blocks are carried over even if they don't get hit this time
+	auto& recorded = state.recorded[hash];
+	recorded.big   = profile.big;
+
+	if (profile.big != cpu.code.big) {
+		return;
+	}
+
+	state.warming = true;
+	for (const auto start : profile.block_starts) {
+		add_block_start(recorded, start);
+
+		if (start >= 4096 || start == (ip_point & 4095)) {
+			continue;
+		}
+		if (codepage->FindCacheBlock(start)) {
+			continue;
+		}
+		CreateCacheBlock(codepage, page_base + start, 32);
+	}
+	state.warming = false;
+}
+
+// Called when a code page handler is released, so a handler reused for
+// another page doesn't keep the hash of the page it was set up for before
+static void on_page_released(const CodePageHandler* codepage)
+{
+	state.page_hashes.erase(codepage);
+}
+
+// Called after a block has been translated
+static void on_block_created(const CacheBlock* block)
+{
+	if (!is_enabled() || state.warming || !block) {
+		return;
+	}
+	// blocks spanning a page boundary are never pre-translated
+	if (block->crossblock) {
+		return;
+	}
+	const auto it = state.page_hashes.find(block->page.handler);
+	if (it == state.page_hashes.end()) {
+		return;
+	}
+	// the page was modified after it was hashed, so the block doesn't
+	// belong to the recorded contents anymore
+	if (block->page.handler->invalidation_map) {
+		state.page_hashes.erase(it);
+		return;
+	}
+	auto& profile = state.recorded[it->second];
+	profile.big   = cpu.code.big;
+	add_block_start(profile, block->page.start);
+}
+
+} // namespace DynrecProfile
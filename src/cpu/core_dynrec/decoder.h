@@ -901,20 +901,20 @@ static CacheBlock *CreateCacheBlock(CodePageHandler *codepage, PhysPt start, Bit
 
 		// 'call near imm16/32'
 		case 0xe8:
-			dyn_call_near_imm();
-			goto finish_block;
+			if (dyn_call_near_imm()) goto finish_block;
+			break;
 		// 'jmp near imm16/32'
 		case 0xe9:
-			dyn_exit_link(decode.big_op ? (int32_t)decode_fetchd() : (int16_t)decode_fetchw());
-			goto finish_block;
+			if (dyn_jmp_near(decode.big_op ? (int32_t)decode_fetchd() : (int16_t)decode_fetchw())) goto finish_block;
+			break;
 		// 'jmp far'
 		case 0xea:
 			dyn_jmp_far_imm();
 			goto finish_block;
 		// 'jmp short imm8'
 		case 0xeb:
-			dyn_exit_link((int8_t)decode_fetchb());
-			goto finish_block;
+			if (dyn_jmp_near((int8_t)decode_fetchb())) goto finish_block;
+			break;
 
 
 		// repeat prefixes
@@ -213,6 +213,32 @@ static void decode_advancepage(void) {
 	decode.page.index=0;
 }
 
+// Superblocks: rather than ending the block at a short forward jump or
+// call, decoding continues at its target if that lies in the same page.
+// The skipped bytes are marked in the write map as if they were code, so
+// the block still covers one contiguous range of the page and writes to
+// the gap invalidate it like writes to the code itself.
+// Only done for 32-bit operand sizes, where eip and the linear address
+// wrap around identically.
+constexpr Bits MaxInlinedJumpDistance = 256;
+
+static bool decode_continue_at(const Bits eip_change)
+{
+	if (!decode.big_op || eip_change < 0 || eip_change > MaxInlinedJumpDistance) {
+		return false;
+	}
+	const Bitu target_index = decode.page.index + eip_change;
+	if (target_index >= 4096) {
+		return false;
+	}
+	for (Bitu i = decode.page.index; i < target_index; ++i) {
+		decode.page.wmap[i] += 0x01;
+	}
+	decode.page.index = target_index;
+	decode.code += eip_change;
+	return true;
+}
+
 // fetch the next byte of the instruction stream
 static uint8_t decode_fetchb(void) {
 	if (decode.page.index >= 4096) {
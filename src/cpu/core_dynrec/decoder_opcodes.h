@@ -542,8 +542,16 @@ static void dyn_imul_gvev(Bitu immsize) {
 			break;
 	}
 
-	if (decode.big_op) gen_call_function_raw((void*)dynrec_dimul_dword);
-	else gen_call_function_raw((void*)dynrec_dimul_word);
+	// multiplications only set CF and OF and keep the other flags, so they
+	// can be simplified together with the preceding instructions once the
+	// flags turn out to be dead
+	if (decode.big_op) {
+		InvalidateFlagsPartially((void*)&dynrec_dimul_dword_simple,t_MUL);
+		gen_call_function_raw((void*)dynrec_dimul_dword);
+	} else {
+		InvalidateFlagsPartially((void*)&dynrec_dimul_word_simple,t_MUL);
+		gen_call_function_raw((void*)dynrec_dimul_word);
+	}
 
 	MOV_REG_WORD_FROM_HOST_REG(FC_RETOP,decode.modrm.reg,decode.big_op);
 }
@@ -725,9 +733,11 @@ static void dyn_grp3_eb(void) {
 		dyn_sop_byte_gencall(SOP_NEG);
 		break;
 	case 0x4:	// mul Eb
+		InvalidateFlagsPartially((void*)&dynrec_mul_byte_simple,t_MUL);
 		gen_call_function_raw((void*)&dynrec_mul_byte);
 		return;
 	case 0x5:	// imul Eb
+		InvalidateFlagsPartially((void*)&dynrec_imul_byte_simple,t_MUL);
 		gen_call_function_raw((void*)&dynrec_imul_byte);
 		return;
 	case 0x6:	// div Eb
@@ -770,12 +780,22 @@ static void dyn_grp3_ev(void) {
 		dyn_sop_word_gencall(SOP_NEG,decode.big_op);
 		break;
 	case 0x4:	// mul Eb
-		if (decode.big_op) gen_call_function_raw((void*)&dynrec_mul_dword);
-		else gen_call_function_raw((void*)&dynrec_mul_word);
+		if (decode.big_op) {
+			InvalidateFlagsPartially((void*)&dynrec_mul_dword_simple,t_MUL);
+			gen_call_function_raw((void*)&dynrec_mul_dword);
+		} else {
+			InvalidateFlagsPartially((void*)&dynrec_mul_word_simple,t_MUL);
+			gen_call_function_raw((void*)&dynrec_mul_word);
+		}
 		return;
 	case 0x5:	// imul Eb
-		if (decode.big_op) gen_call_function_raw((void*)&dynrec_imul_dword);
-		else gen_call_function_raw((void*)&dynrec_imul_word);
+		if (decode.big_op) {
+			InvalidateFlagsPartially((void*)&dynrec_imul_dword_simple,t_MUL);
+			gen_call_function_raw((void*)&dynrec_imul_dword);
+		} else {
+			InvalidateFlagsPartially((void*)&dynrec_imul_word_simple,t_MUL);
+			gen_call_function_raw((void*)&dynrec_imul_word);
+		}
 		return;
 	case 0x6:	// div Eb
 		if (decode.big_op) gen_call_function_raw((void*)&dynrec_div_dword);
@@ -798,6 +818,18 @@ static void dyn_grp3_ev(void) {
 }
 
 
+// Returns true if the callback was run, false if it has to exit the core
+static bool dynrec_run_inline_callback(const Bitu cb_num)
+{
+	if (!CALLBACK_MayRunInline(static_cast<callback_number_t>(cb_num))) {
+		return false;
+	}
+	FillFlags();
+	[[maybe_unused]] const auto ret = (*CallBack_Handlers[cb_num])();
+	assert(ret == CBRET_NONE);
+	return true;
+}
+
 static bool dyn_grp4_eb(void) {
 	dyn_get_modrm();
 	switch (decode.modrm.reg) {
@@ -817,12 +849,25 @@ static bool dyn_grp4_eb(void) {
 		}
 		break;
 	case 0x7:		//CALBACK Iw
-		gen_mov_direct_dword(&core_dynrec.callback,decode_fetchw());
+	{
+		const auto cb_num = decode_fetchw();
 		dyn_set_eip_end();
 		dyn_reduce_cycles();
+		if (CALLBACK_MayRunInline(static_cast<callback_number_t>(cb_num))) {
+			// run the handler right away and continue in this core with
+			// the (possibly changed) CS:IP, falling back to the core exit
+			// if the callback got reallocated since the translation
+			gen_call_function_I((void*)&dynrec_run_inline_callback, cb_num);
+			gen_extend_byte(false, FC_RETOP); // bool -> dword
+			const uint8_t* not_inline = gen_create_branch_on_zero(FC_RETOP, true);
+			dyn_return(BR_Normal);
+			gen_fill_branch(not_inline);
+		}
+		gen_mov_direct_dword(&core_dynrec.callback,cb_num);
 		dyn_return(BR_CallBack);
 		dyn_closeblock();
 		return true;
+	}
 	default:
 		IllegalOptionDynrec("dyn_grp4_eb");
 		break;
@@ -1002,7 +1047,8 @@ static bool dyn_grp7(void) {
 			case 0x07:	// INVLPG
 //				if (cpu.pmode && cpu.cpl) EXCEPTION(EXCEPTION_GP);
 				if (cpu.pmode && cpu.cpl) IllegalOptionDynrec("invlpg nonpriviledged");
-				gen_call_function_raw((void*)PAGING_ClearTLB);
+				dyn_fill_ea(FC_ADDR);
+				gen_call_function_R((void*)PAGING_InvalidatePage,FC_ADDR);
 				break;
 			default: IllegalOptionDynrec("dyn_grp7_1");
 		}
@@ -1105,6 +1151,17 @@ static void dyn_exit_link(Bits eip_change) {
 	dyn_closeblock();
 }
 
+// returns true if the block was closed, false if decoding continues at
+// the jump target (see decode_continue_at)
+static bool dyn_jmp_near(Bits eip_change)
+{
+	if (decode_continue_at(eip_change)) {
+		return false;
+	}
+	dyn_exit_link(eip_change);
+	return true;
+}
+
 
 static void dyn_branched_exit(BranchTypes btype,int32_t eip_add) {
 	Bitu eip_base=decode.code-decode.code_start;
@@ -1199,7 +1256,9 @@ static void dyn_ret_near(Bitu bytes) {
 	dyn_closeblock();
 }
 
-static void dyn_call_near_imm(void) {
+// returns true if the block was closed, false if decoding continues at
+// the call target (see decode_continue_at)
+static bool dyn_call_near_imm(void) {
 	Bits imm;
 	if (decode.big_op) imm=(int32_t)decode_fetchd();
 	else imm=(int16_t)decode_fetchw();
@@ -1207,12 +1266,17 @@ static void dyn_call_near_imm(void) {
 	if (decode.big_op) gen_call_function_raw((void*)&dynrec_push_dword);
 	else gen_call_function_raw((void*)&dynrec_push_word);
 
+	if (decode_continue_at(imm)) {
+		return false;
+	}
+
 	dyn_set_eip_end(FC_OP1,imm);
 	gen_mov_word_from_reg(FC_OP1,decode.big_op?(void*)(&reg_eip):(void*)(&reg_ip),decode.big_op);
 
 	dyn_reduce_cycles();
 	gen_jmp_ptr(&decode.block->link[0].to, offsetof(CacheBlock, cache.start));
 	dyn_closeblock();
+	return true;
 }
 
 static void dyn_ret_far(Bitu bytes) {
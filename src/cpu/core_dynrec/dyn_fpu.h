@@ -52,18 +52,36 @@ static void FPU_FFREE(Bitu st) {
 #endif
 
 
+// load TOP into reg_top and the index of STi into reg_sti, reading TOP
+// from memory only once (it is always masked, so ST0 needs no wrapping)
+static inline void dyn_fpu_top_sti(HostReg reg_top,HostReg reg_sti,Bitu i) {
+	gen_mov_word_to_reg(reg_top,(void*)(&TOP),true);
+	gen_mov_regs(reg_sti,reg_top);
+	if (i) {
+		gen_add_imm(reg_sti,i);
+		gen_and_imm(reg_sti,7);
+	}
+}
+
 static inline void dyn_fpu_top() {
-	gen_mov_word_to_reg(FC_OP2,(void*)(&TOP),true);
-	gen_add_imm(FC_OP2,decode.modrm.rm);
-	gen_and_imm(FC_OP2,7);
-	gen_mov_word_to_reg(FC_OP1,(void*)(&TOP),true);
+	dyn_fpu_top_sti(FC_OP1,FC_OP2,decode.modrm.rm);
 }
 
 static inline void dyn_fpu_top_swapped() {
-	gen_mov_word_to_reg(FC_OP1,(void*)(&TOP),true);
-	gen_add_imm(FC_OP1,decode.modrm.rm);
-	gen_and_imm(FC_OP1,7);
-	gen_mov_word_to_reg(FC_OP2,(void*)(&TOP),true);
+	dyn_fpu_top_sti(FC_OP2,FC_OP1,decode.modrm.rm);
+}
+
+// FADD/FMUL/FSUB/FSUBR/FDIV/FDIVR on the stack registers indexed by FC_OP1
+// and FC_OP2. Without the x87 helpers these are plain double arithmetic, so
+// backends that can emit it inline give identical results without the call;
+// the x87 helpers are kept as they compute with extended precision.
+static inline void dyn_fpu_arith([[maybe_unused]] void* func,
+                                 [[maybe_unused]] FpuArithOp op) {
+#if defined(DRC_USE_NATIVE_FPU) && !C_FPU_X86
+	gen_fpu_arith_regs(&fpu.regs[0],FC_OP1,FC_OP2,op);
+#else
+	gen_call_function_RR(func,FC_OP1,FC_OP2);
+#endif
 }
 
 static void dyn_eatree() {
@@ -107,10 +125,10 @@ static void dyn_fpu_esc0(){
 		dyn_fpu_top();
 		switch (decode.modrm.reg){
 		case 0x00:		//FADD ST,STi
-			gen_call_function_RR((void*)&FPU_FADD,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FADD,FPU_ARITH_ADD);
 			break;
 		case 0x01:		// FMUL  ST,STi
-			gen_call_function_RR((void*)&FPU_FMUL,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FMUL,FPU_ARITH_MUL);
 			break;
 		case 0x02:		// FCOM  STi
 			gen_call_function_RR((void*)&FPU_FCOM,FC_OP1,FC_OP2);
@@ -120,16 +138,16 @@ static void dyn_fpu_esc0(){
 			gen_call_function_raw((void*)&FPU_FPOP);
 			break;
 		case 0x04:		// FSUB  ST,STi
-			gen_call_function_RR((void*)&FPU_FSUB,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FSUB,FPU_ARITH_SUB);
 			break;	
 		case 0x05:		// FSUBR ST,STi
-			gen_call_function_RR((void*)&FPU_FSUBR,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FSUBR,FPU_ARITH_SUBR);
 			break;
 		case 0x06:		// FDIV  ST,STi
-			gen_call_function_RR((void*)&FPU_FDIV,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FDIV,FPU_ARITH_DIV);
 			break;
 		case 0x07:		// FDIVR ST,STi
-			gen_call_function_RR((void*)&FPU_FDIVR,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FDIVR,FPU_ARITH_DIVR);
 			break;
 		default:
 			break;
@@ -339,10 +357,7 @@ static void dyn_fpu_esc2(){
 		case 0x05:
 			switch(decode.modrm.rm){
 			case 0x01:		/* FUCOMPP */
-				gen_mov_word_to_reg(FC_OP2,(void*)(&TOP),true);
-				gen_add_imm(FC_OP2,1);
-				gen_and_imm(FC_OP2,7);
-				gen_mov_word_to_reg(FC_OP1,(void*)(&TOP),true);
+				dyn_fpu_top_sti(FC_OP1,FC_OP2,1);
 				gen_call_function_RR((void *)&FPU_FUCOM,FC_OP1,FC_OP2);
 				gen_call_function_raw((void *)&FPU_FPOP);
 				gen_call_function_raw((void *)&FPU_FPOP);
@@ -439,11 +454,11 @@ static void dyn_fpu_esc4(){
 		switch(decode.modrm.reg){
 		case 0x00:	/* FADD STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FADD,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FADD,FPU_ARITH_ADD);
 			break;
 		case 0x01:	/* FMUL STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FMUL,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FMUL,FPU_ARITH_MUL);
 			break;
 		case 0x02:  /* FCOM*/
 			dyn_fpu_top();
@@ -456,19 +471,19 @@ static void dyn_fpu_esc4(){
 			break;
 		case 0x04:  /* FSUBR STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FSUBR,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FSUBR,FPU_ARITH_SUBR);
 			break;
 		case 0x05:  /* FSUB  STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FSUB,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FSUB,FPU_ARITH_SUB);
 			break;
 		case 0x06:  /* FDIVR STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FDIVR,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FDIVR,FPU_ARITH_DIVR);
 			break;
 		case 0x07:  /* FDIV STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FDIV,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FDIV,FPU_ARITH_DIV);
 			break;
 		default:
 			break;
@@ -559,11 +574,11 @@ static void dyn_fpu_esc6(){
 		switch(decode.modrm.reg){
 		case 0x00:	/*FADDP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FADD,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FADD,FPU_ARITH_ADD);
 			break;
 		case 0x01:	/* FMULP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FMUL,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FMUL,FPU_ARITH_MUL);
 			break;
 		case 0x02:  /* FCOMP5*/
 			dyn_fpu_top();
@@ -574,28 +589,25 @@ static void dyn_fpu_esc6(){
 				LOG(LOG_FPU,LOG_WARN)("ESC 6:Unhandled group %X subfunction %X",static_cast<uint32_t>(decode.modrm.reg),static_cast<uint32_t>(decode.modrm.rm));
 				return;
 			}
-			gen_mov_word_to_reg(FC_OP2,(void*)(&TOP),true);
-			gen_add_imm(FC_OP2,1);
-			gen_and_imm(FC_OP2,7);
-			gen_mov_word_to_reg(FC_OP1,(void*)(&TOP),true);
+			dyn_fpu_top_sti(FC_OP1,FC_OP2,1);
 			gen_call_function_RR((void*)&FPU_FCOM,FC_OP1,FC_OP2);
 			gen_call_function_raw((void*)&FPU_FPOP); /* extra pop at the bottom*/
 			break;
 		case 0x04:  /* FSUBRP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FSUBR,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FSUBR,FPU_ARITH_SUBR);
 			break;
 		case 0x05:  /* FSUBP  STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FSUB,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FSUB,FPU_ARITH_SUB);
 			break;
 		case 0x06:	/* FDIVRP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FDIVR,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FDIVR,FPU_ARITH_DIVR);
 			break;
 		case 0x07:  /* FDIVP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR((void*)&FPU_FDIV,FC_OP1,FC_OP2);
+			dyn_fpu_arith((void*)&FPU_FDIV,FPU_ARITH_DIV);
 			break;
 		default:
 			break;
@@ -30,6 +30,19 @@ extern uint32_t* lookupRMEAregd[256];
 #define SaveMd(off, val) mem_writed(off, val)
 #define SaveMq(off, val) mem_writeq(off, val)
 
+// Emits the register form of the current instruction inline on backends
+// that define DRC_USE_NATIVE_MMX, the registers are known from the modrm
+// byte. Returns false if the helper function has to be called instead.
+static bool dyn_mmx_native([[maybe_unused]] const MmxOp op)
+{
+#if defined(DRC_USE_NATIVE_MMX)
+	gen_mmx_op_regs(&fpu.mmx_regs[0], decode.modrm.reg, decode.modrm.rm, op);
+	return true;
+#else
+	return false;
+#endif
+}
+
 static void mmx_movd_pqed(const Bitu rm, const PhysPt eaa = 0)
 {
 	auto rmrq = lookupRMregMM[rm];
@@ -151,7 +164,7 @@ static void dyn_mmx_paddb()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_paddb, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PADDB)) {
 		gen_call_function_I((void*)mmx_paddb, decode.modrm.val);
 	}
 }
@@ -179,7 +192,7 @@ static void dyn_mmx_paddw()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_paddw, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PADDW)) {
 		gen_call_function_I((void*)mmx_paddw, decode.modrm.val);
 	}
 }
@@ -207,7 +220,7 @@ static void dyn_mmx_paddd()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_paddd, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PADDD)) {
 		gen_call_function_I((void*)mmx_paddd, decode.modrm.val);
 	}
 }
@@ -235,7 +248,7 @@ static void dyn_mmx_paddsb()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_paddsb, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PADDSB)) {
 		gen_call_function_I((void*)mmx_paddsb, decode.modrm.val);
 	}
 }
@@ -263,7 +276,7 @@ static void dyn_mmx_paddsw()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_paddsw, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PADDSW)) {
 		gen_call_function_I((void*)mmx_paddsw, decode.modrm.val);
 	}
 }
@@ -291,7 +304,7 @@ static void dyn_mmx_paddusb()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_paddusb, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PADDUSB)) {
 		gen_call_function_I((void*)mmx_paddusb, decode.modrm.val);
 	}
 }
@@ -319,7 +332,7 @@ static void dyn_mmx_paddusw()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_paddusw, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PADDUSW)) {
 		gen_call_function_I((void*)mmx_paddusw, decode.modrm.val);
 	}
 }
@@ -347,7 +360,7 @@ static void dyn_mmx_psubb()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_psubb, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PSUBB)) {
 		gen_call_function_I((void*)mmx_psubb, decode.modrm.val);
 	}
 }
@@ -375,7 +388,7 @@ static void dyn_mmx_psubw()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_psubw, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PSUBW)) {
 		gen_call_function_I((void*)mmx_psubw, decode.modrm.val);
 	}
 }
@@ -403,7 +416,7 @@ static void dyn_mmx_psubsb()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_psubsb, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PSUBSB)) {
 		gen_call_function_I((void*)mmx_psubsb, decode.modrm.val);
 	}
 }
@@ -431,7 +444,7 @@ static void dyn_mmx_psubsw()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_psubsw, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PSUBSW)) {
 		gen_call_function_I((void*)mmx_psubsw, decode.modrm.val);
 	}
 }
@@ -459,7 +472,7 @@ static void dyn_mmx_psubusb()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_psubusb, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PSUBUSB)) {
 		gen_call_function_I((void*)mmx_psubusb, decode.modrm.val);
 	}
 }
@@ -487,7 +500,7 @@ static void dyn_mmx_psubusw()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_psubusw, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PSUBUSW)) {
 		gen_call_function_I((void*)mmx_psubusw, decode.modrm.val);
 	}
 }
@@ -515,7 +528,7 @@ static void dyn_mmx_psubd()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_psubd, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PSUBD)) {
 		gen_call_function_I((void*)mmx_psubd, decode.modrm.val);
 	}
 }
@@ -599,7 +612,7 @@ static void dyn_mmx_pmullw()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_pmullw, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PMULLW)) {
 		gen_call_function_I((void*)mmx_pmullw, decode.modrm.val);
 	}
 }
@@ -813,7 +826,7 @@ static void dyn_mmx_pcmpeqb()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_pcmpeqb, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PCMPEQB)) {
 		gen_call_function_I((void*)mmx_pcmpeqb, decode.modrm.val);
 	}
 }
@@ -842,7 +855,7 @@ static void dyn_mmx_pcmpeqw()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_pcmpeqw, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PCMPEQW)) {
 		gen_call_function_I((void*)mmx_pcmpeqw, decode.modrm.val);
 	}
 }
@@ -871,7 +884,7 @@ static void dyn_mmx_pcmpeqd()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_pcmpeqd, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PCMPEQD)) {
 		gen_call_function_I((void*)mmx_pcmpeqd, decode.modrm.val);
 	}
 }
@@ -900,7 +913,7 @@ static void dyn_mmx_pcmpgtb()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_pcmpgtb, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PCMPGTB)) {
 		gen_call_function_I((void*)mmx_pcmpgtb, decode.modrm.val);
 	}
 }
@@ -929,7 +942,7 @@ static void dyn_mmx_pcmpgtw()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_pcmpgtw, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PCMPGTW)) {
 		gen_call_function_I((void*)mmx_pcmpgtw, decode.modrm.val);
 	}
 }
@@ -958,7 +971,7 @@ static void dyn_mmx_pcmpgtd()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_pcmpgtd, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PCMPGTD)) {
 		gen_call_function_I((void*)mmx_pcmpgtd, decode.modrm.val);
 	}
 }
@@ -1387,7 +1400,7 @@ static void dyn_mmx_por()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_por, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_POR)) {
 		gen_call_function_I((void*)mmx_por, decode.modrm.val);
 	}
 }
@@ -1415,7 +1428,7 @@ static void dyn_mmx_pxor()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_pxor, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PXOR)) {
 		gen_call_function_I((void*)mmx_pxor, decode.modrm.val);
 	}
 }
@@ -1443,7 +1456,7 @@ static void dyn_mmx_pand()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_pand, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PAND)) {
 		gen_call_function_I((void*)mmx_pand, decode.modrm.val);
 	}
 }
@@ -1471,7 +1484,7 @@ static void dyn_mmx_pandn()
 	if (decode.modrm.mod < 3) {
 		dyn_fill_ea(FC_ADDR);
 		gen_call_function_IR((void*)mmx_pandn, decode.modrm.val, FC_ADDR);
-	} else {
+	} else if (!dyn_mmx_native(MMX_OP_PANDN)) {
 		gen_call_function_I((void*)mmx_pandn, decode.modrm.val);
 	}
 }
@@ -1392,6 +1392,11 @@ static void DRC_CALL_CONV dynrec_mul_byte(uint8_t op) {
 	}
 }
 
+static void DRC_CALL_CONV dynrec_mul_byte_simple(uint8_t op) DRC_FC;
+static void DRC_CALL_CONV dynrec_mul_byte_simple(uint8_t op) {
+	reg_ax=reg_al*op;
+}
+
 static void DRC_CALL_CONV dynrec_imul_byte(uint8_t op) DRC_FC;
 static void DRC_CALL_CONV dynrec_imul_byte(uint8_t op) {
 	FillFlagsNoCFOF();
@@ -1405,6 +1410,11 @@ static void DRC_CALL_CONV dynrec_imul_byte(uint8_t op) {
 	}
 }
 
+static void DRC_CALL_CONV dynrec_imul_byte_simple(uint8_t op) DRC_FC;
+static void DRC_CALL_CONV dynrec_imul_byte_simple(uint8_t op) {
+	reg_ax=((int8_t)reg_al) * ((int8_t)op);
+}
+
 static void DRC_CALL_CONV dynrec_mul_word(uint16_t op) DRC_FC;
 static void DRC_CALL_CONV dynrec_mul_word(uint16_t op) {
 	FillFlagsNoCFOF();
@@ -1421,6 +1431,13 @@ static void DRC_CALL_CONV dynrec_mul_word(uint16_t op) {
 	}
 }
 
+static void DRC_CALL_CONV dynrec_mul_word_simple(uint16_t op) DRC_FC;
+static void DRC_CALL_CONV dynrec_mul_word_simple(uint16_t op) {
+	Bitu tempu=(Bitu)reg_ax*(Bitu)op;
+	reg_ax=(uint16_t)(tempu);
+	reg_dx=(uint16_t)(tempu >> 16);
+}
+
 static void DRC_CALL_CONV dynrec_imul_word(uint16_t op) DRC_FC;
 static void DRC_CALL_CONV dynrec_imul_word(uint16_t op) {
 	FillFlagsNoCFOF();
@@ -1436,6 +1453,13 @@ static void DRC_CALL_CONV dynrec_imul_word(uint16_t op) {
 	}
 }
 
+static void DRC_CALL_CONV dynrec_imul_word_simple(uint16_t op) DRC_FC;
+static void DRC_CALL_CONV dynrec_imul_word_simple(uint16_t op) {
+	Bits temps=((int16_t)reg_ax)*((int16_t)op);
+	reg_ax=(int16_t)(temps);
+	reg_dx=(int16_t)(temps >> 16);
+}
+
 static void DRC_CALL_CONV dynrec_mul_dword(uint32_t op) DRC_FC;
 static void DRC_CALL_CONV dynrec_mul_dword(uint32_t op) {
 	FillFlagsNoCFOF();
@@ -1452,6 +1476,13 @@ static void DRC_CALL_CONV dynrec_mul_dword(uint32_t op) {
 	}
 }
 
+static void DRC_CALL_CONV dynrec_mul_dword_simple(uint32_t op) DRC_FC;
+static void DRC_CALL_CONV dynrec_mul_dword_simple(uint32_t op) {
+	uint64_t tempu=(uint64_t)reg_eax*(uint64_t)op;
+	reg_eax=(uint32_t)(tempu);
+	reg_edx=(uint32_t)(tempu >> 32);
+}
+
 static void DRC_CALL_CONV dynrec_imul_dword(uint32_t op) DRC_FC;
 static void DRC_CALL_CONV dynrec_imul_dword(uint32_t op) {
 	FillFlagsNoCFOF();
@@ -1470,6 +1501,13 @@ static void DRC_CALL_CONV dynrec_imul_dword(uint32_t op) {
 	}
 }
 
+static void DRC_CALL_CONV dynrec_imul_dword_simple(uint32_t op) DRC_FC;
+static void DRC_CALL_CONV dynrec_imul_dword_simple(uint32_t op) {
+	int64_t temps=((int64_t)((int32_t)reg_eax))*((int64_t)((int32_t)op));
+	reg_eax=(uint32_t)(temps);
+	reg_edx=(uint32_t)(temps >> 32);
+}
+
 
 static bool DRC_CALL_CONV dynrec_div_byte(uint8_t op) DRC_FC;
 static bool DRC_CALL_CONV dynrec_div_byte(uint8_t op) {
@@ -1574,6 +1612,11 @@ static uint16_t DRC_CALL_CONV dynrec_dimul_word(uint16_t op1,uint16_t op2) {
 	return (uint16_t)(res & 0xffff);
 }
 
+static uint16_t DRC_CALL_CONV dynrec_dimul_word_simple(uint16_t op1,uint16_t op2) DRC_FC;
+static uint16_t DRC_CALL_CONV dynrec_dimul_word_simple(uint16_t op1,uint16_t op2) {
+	return (uint16_t)((((int16_t)op1) * ((int16_t)op2)) & 0xffff);
+}
+
 static uint32_t DRC_CALL_CONV dynrec_dimul_dword(uint32_t op1,uint32_t op2) DRC_FC;
 static uint32_t DRC_CALL_CONV dynrec_dimul_dword(uint32_t op1,uint32_t op2) {
 	FillFlagsNoCFOF();
@@ -1588,6 +1631,11 @@ static uint32_t DRC_CALL_CONV dynrec_dimul_dword(uint32_t op1,uint32_t op2) {
 	return (int32_t)res;
 }
 
+static uint32_t DRC_CALL_CONV dynrec_dimul_dword_simple(uint32_t op1,uint32_t op2) DRC_FC;
+static uint32_t DRC_CALL_CONV dynrec_dimul_dword_simple(uint32_t op1,uint32_t op2) {
+	return (int32_t)(((int64_t)((int32_t)op1))*((int64_t)((int32_t)op2)));
+}
+
 
 
 static uint16_t DRC_CALL_CONV dynrec_cbw(uint8_t op) DRC_FC;
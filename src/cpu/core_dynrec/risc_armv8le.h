@@ -38,6 +38,11 @@
 // use FC_SEGS_ADDR to hold the address of "Segs" and to access it using FC_SEGS_ADDR
 #define DRC_USE_SEGS_ADDR
 
+// emit fpu stack register arithmetic as host instructions, see gen_fpu_arith_regs
+#define DRC_USE_NATIVE_FPU
+// emit packed mmx register operations as host instructions, see gen_mmx_op_regs
+#define DRC_USE_NATIVE_MMX
+
 // register mapping
 typedef uint8_t HostReg;
 
@@ -334,6 +339,25 @@ typedef uint8_t HostReg;
 // ubfm dst, src, #rimm, #simm		@	0 <= rimm < 64, 0 <= simm < 64
 #define UBFM64(dst, src, rimm, simm) (0xd3400000 + (dst) + ((src) << 5) + ((rimm) << 16) + ((simm) << 10) )
 
+// floating point
+// ldr dreg, [addr1, waddr2, uxtw #3]
+#define LDR_D_REG_UXTW_3(dreg, addr1, addr2) (0xfc605800 + (dreg) + ((addr1) << 5) + ((addr2) << 16) )
+// str dreg, [addr1, waddr2, uxtw #3]
+#define STR_D_REG_UXTW_3(dreg, addr1, addr2) (0xfc205800 + (dreg) + ((addr1) << 5) + ((addr2) << 16) )
+// fadd ddst, dsrc1, dsrc2
+#define FADD_D(dst, src1, src2) (0x1e602800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+// fsub ddst, dsrc1, dsrc2
+#define FSUB_D(dst, src1, src2) (0x1e603800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+// fmul ddst, dsrc1, dsrc2
+#define FMUL_D(dst, src1, src2) (0x1e600800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+// fdiv ddst, dsrc1, dsrc2
+#define FDIV_D(dst, src1, src2) (0x1e601800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+// ldr dreg, [addr, #imm]		@	0 <= imm < 32768	&	imm mod 8 = 0
+#define LDR_D_IMM(dreg, addr, imm) (0xfd400000 + (dreg) + ((addr) << 5) + ((imm) << 7) )
+// str dreg, [addr, #imm]		@	0 <= imm < 32768	&	imm mod 8 = 0
+#define STR_D_IMM(dreg, addr, imm) (0xfd000000 + (dreg) + ((addr) << 5) + ((imm) << 7) )
+// 64-bit vector instruction op vdst, vsrc1, vsrc2, op includes the element size
+#define NEON_3REG(op, dst, src1, src2) ((op) + (dst) + ((src1) << 5) + ((src2) << 16) )
 
 // move a full register from reg_src to reg_dst
 static void gen_mov_regs(HostReg reg_dst,HostReg reg_src) {
@@ -1133,6 +1157,68 @@ static void gen_fill_function_ptr(const uint8_t * pos,void* fct_ptr,Bitu flags_t
 }
 #endif
 
+// perform a double precision operation on two registers of the fpu stack,
+// the indexes of which (0..7) are in reg_st and reg_other:
+//   regs[reg_st] = regs[reg_st] op regs[reg_other]
+// (the operands are swapped for FPU_ARITH_SUBR and FPU_ARITH_DIVR)
+// d0 and d1 are destroyed
+static void gen_fpu_arith_regs(void* regs,HostReg reg_st,HostReg reg_other,FpuArithOp op) {
+	gen_mov_qword_to_reg_imm(temp1, (uint64_t)regs);
+	cache_addd( LDR_D_REG_UXTW_3(0, temp1, reg_st) );        // ldr d0, [temp1, reg_st, uxtw #3]
+	cache_addd( LDR_D_REG_UXTW_3(1, temp1, reg_other) );     // ldr d1, [temp1, reg_other, uxtw #3]
+	switch (op) {
+		case FPU_ARITH_ADD:  cache_addd( FADD_D(0, 0, 1) ); break;    // fadd d0, d0, d1
+		case FPU_ARITH_MUL:  cache_addd( FMUL_D(0, 0, 1) ); break;    // fmul d0, d0, d1
+		case FPU_ARITH_SUB:  cache_addd( FSUB_D(0, 0, 1) ); break;    // fsub d0, d0, d1
+		case FPU_ARITH_SUBR: cache_addd( FSUB_D(0, 1, 0) ); break;    // fsub d0, d1, d0
+		case FPU_ARITH_DIV:  cache_addd( FDIV_D(0, 0, 1) ); break;    // fdiv d0, d0, d1
+		case FPU_ARITH_DIVR: cache_addd( FDIV_D(0, 1, 0) ); break;    // fdiv d0, d1, d0
+	}
+	cache_addd( STR_D_REG_UXTW_3(0, temp1, reg_st) );        // str d0, [temp1, reg_st, uxtw #3]
+}
+
+// perform a packed operation on two mmx registers, given by their index in
+// the regs array: regs[dst] = regs[dst] op regs[src]
+// d0 and d1 are destroyed
+static void gen_mmx_op_regs(void* regs,Bitu dst,Bitu src,MmxOp op) {
+	static const uint32_t neon_ops[] = {
+		0x0e208400,	// PADDB   - add v.8b
+		0x0e608400,	// PADDW   - add v.4h
+		0x0ea08400,	// PADDD   - add v.2s
+		0x0e200c00,	// PADDSB  - sqadd v.8b
+		0x0e600c00,	// PADDSW  - sqadd v.4h
+		0x2e200c00,	// PADDUSB - uqadd v.8b
+		0x2e600c00,	// PADDUSW - uqadd v.4h
+		0x2e208400,	// PSUBB   - sub v.8b
+		0x2e608400,	// PSUBW   - sub v.4h
+		0x2ea08400,	// PSUBD   - sub v.2s
+		0x0e202c00,	// PSUBSB  - sqsub v.8b
+		0x0e602c00,	// PSUBSW  - sqsub v.4h
+		0x2e202c00,	// PSUBUSB - uqsub v.8b
+		0x2e602c00,	// PSUBUSW - uqsub v.4h
+		0x0e609c00,	// PMULLW  - mul v.4h
+		0x2e208c00,	// PCMPEQB - cmeq v.8b
+		0x2e608c00,	// PCMPEQW - cmeq v.4h
+		0x2ea08c00,	// PCMPEQD - cmeq v.2s
+		0x0e203400,	// PCMPGTB - cmgt v.8b
+		0x0e603400,	// PCMPGTW - cmgt v.4h
+		0x0ea03400,	// PCMPGTD - cmgt v.2s
+		0x0e201c00,	// PAND    - and v.8b
+		0x0e601c00,	// PANDN   - bic v.8b
+		0x0ea01c00,	// POR     - orr v.8b
+		0x2e201c00,	// PXOR    - eor v.8b
+	};
+	gen_mov_qword_to_reg_imm(temp1, (uint64_t)regs);
+	cache_addd( LDR_D_IMM(0, temp1, dst * 8) );      // ldr d0, [temp1, #(dst * 8)]
+	cache_addd( LDR_D_IMM(1, temp1, src * 8) );      // ldr d1, [temp1, #(src * 8)]
+	if (op == MMX_OP_PANDN) {
+		cache_addd( NEON_3REG(neon_ops[op], 0, 1, 0) );   // bic v0.8b, v1.8b, v0.8b
+	} else {
+		cache_addd( NEON_3REG(neon_ops[op], 0, 0, 1) );   // op v0, v0, v1
+	}
+	cache_addd( STR_D_IMM(0, temp1, dst * 8) );      // str d0, [temp1, #(dst * 8)]
+}
+
 static void cache_block_closing([[maybe_unused]] const uint8_t *block_start,
                                 [[maybe_unused]] Bitu block_size) { }
 
@@ -33,6 +33,11 @@
 #define DRC_CALL_CONV	/* nothing */
 #define DRC_FC			/* nothing */
 
+// emit fpu stack register arithmetic as host instructions, see gen_fpu_arith_regs
+#define DRC_USE_NATIVE_FPU
+// emit packed mmx register operations as host instructions, see gen_mmx_op_regs
+#define DRC_USE_NATIVE_MMX
+
 
 // register mapping
 typedef uint8_t HostReg;
@@ -693,6 +698,80 @@ static void gen_fill_function_ptr(const uint8_t * pos,void* fct_ptr,Bitu flags_t
 }
 #endif
 
+// sse2 scalar double instruction op with xmm and the memory operand [base+index*8]
+static void gen_sse2_sd_memop(uint8_t op,uint8_t xmm,HostReg base,HostReg index) {
+	cache_addb(0xf2);
+	cache_addb(0x0f);
+	cache_addb(op);
+	cache_addb(0x04+(xmm<<3));
+	cache_addb(0xc0+(index<<3)+base);
+}
+
+// perform a double precision operation on two registers of the fpu stack,
+// the indexes of which (0..7) are in reg_st and reg_other:
+//   regs[reg_st] = regs[reg_st] op regs[reg_other]
+// (the operands are swapped for FPU_ARITH_SUBR and FPU_ARITH_DIVR)
+// rax and xmm0 are destroyed
+static void gen_fpu_arith_regs(void* regs,HostReg reg_st,HostReg reg_other,FpuArithOp op) {
+	const bool reversed = (op == FPU_ARITH_SUBR) || (op == FPU_ARITH_DIVR);
+	gen_mov_reg_qword(HOST_EAX,(uint64_t)regs);
+	gen_sse2_sd_memop(0x10,0,HOST_EAX,reversed ? reg_other : reg_st);	// movsd xmm0,[rax+reg*8]
+	uint8_t sse_op = 0x58;
+	switch (op) {
+		case FPU_ARITH_ADD: sse_op = 0x58; break;	// addsd
+		case FPU_ARITH_MUL: sse_op = 0x59; break;	// mulsd
+		case FPU_ARITH_SUB:
+		case FPU_ARITH_SUBR: sse_op = 0x5c; break;	// subsd
+		case FPU_ARITH_DIV:
+		case FPU_ARITH_DIVR: sse_op = 0x5e; break;	// divsd
+	}
+	gen_sse2_sd_memop(sse_op,0,HOST_EAX,reversed ? reg_st : reg_other);	// op xmm0,[rax+reg*8]
+	gen_sse2_sd_memop(0x11,0,HOST_EAX,reg_st);		// movsd [rax+reg_st*8],xmm0
+}
+
+// perform a packed operation on two mmx registers, given by their index in
+// the regs array: regs[dst] = regs[dst] op regs[src]
+// rax, xmm0 and xmm1 are destroyed
+static void gen_mmx_op_regs(void* regs,Bitu dst,Bitu src,MmxOp op) {
+	static const uint8_t sse2_ops[] = {
+		0xfc,	// PADDB
+		0xfd,	// PADDW
+		0xfe,	// PADDD
+		0xec,	// PADDSB
+		0xed,	// PADDSW
+		0xdc,	// PADDUSB
+		0xdd,	// PADDUSW
+		0xf8,	// PSUBB
+		0xf9,	// PSUBW
+		0xfa,	// PSUBD
+		0xe8,	// PSUBSB
+		0xe9,	// PSUBSW
+		0xd8,	// PSUBUSB
+		0xd9,	// PSUBUSW
+		0xd5,	// PMULLW
+		0x74,	// PCMPEQB
+		0x75,	// PCMPEQW
+		0x76,	// PCMPEQD
+		0x64,	// PCMPGTB
+		0x65,	// PCMPGTW
+		0x66,	// PCMPGTD
+		0xdb,	// PAND
+		0xdf,	// PANDN
+		0xeb,	// POR
+		0xef,	// PXOR
+	};
+	gen_mov_reg_qword(HOST_EAX,(uint64_t)regs);
+	cache_addd(0x407e0ff3);		// movq xmm0,[rax+dst*8]
+	cache_addb((uint8_t)(dst*8));
+	cache_addd(0x487e0ff3);		// movq xmm1,[rax+src*8]
+	cache_addb((uint8_t)(src*8));
+	cache_addw(0x0f66);		// op xmm0,xmm1 (the 128-bit form, only the low half is kept)
+	cache_addb(sse2_ops[op]);
+	cache_addb(0xc1);
+	cache_addd(0x40d60f66);		// movq [rax+dst*8],xmm0
+	cache_addb((uint8_t)(dst*8));
+}
+
 static void cache_block_closing([[maybe_unused]] const uint8_t* block_start, [[maybe_unused]] Bitu block_size) { }
 
 static void cache_block_before_close(void) { }
@@ -345,12 +345,14 @@ l_M_Ed:
 		break;
 	case D_IRETw:
 		CPU_IRET(false,GetIP());
+		PAGING_CheckPageFaultReturn();
 		if (GETFLAG(IF) && PIC_IRQCheck) {
 			return CBRET_NONE;
 		}
 		continue;
 	case D_IRETd:
 		CPU_IRET(true,GetIP());
+		PAGING_CheckPageFaultReturn();
 		if (GETFLAG(IF) && PIC_IRQCheck) 
 			return CBRET_NONE;
 		continue;
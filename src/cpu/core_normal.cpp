@@ -18,6 +18,8 @@
  */
 #include "dosbox.h"
 
+#include <array>
+
 // Needed for std::isnan in simde
 #include <cmath>
 
@@ -65,6 +67,10 @@ extern Bitu cycle_count;
 #define CPU_FPU	1						//Enable FPU escape instructions
 #endif
 
+#if C_CORE_THREADED_DISPATCH
+#define OPCODE_DISPATCH_THREADED 1
+#endif
+
 #define CPU_PIC_CHECK 1
 #define CPU_TRAP_CHECK 1
 
@@ -148,9 +154,59 @@ static inline uint32_t Fetchd() {
 
 #define EALookupTable (core.ea_table)
 
+#if defined(OPCODE_DISPATCH_THREADED)
+// Threaded dispatch: jumping through a table of label addresses right
+// after the opcode fetch, instead of through the switch's single shared
+// indirect branch, gives the host's branch predictor a better chance.
+// The switch stays in place to build the table on first use. Filling the
+// table with the switch instead dispatches through it, as the benchmarks do
+// to compare both.
+static struct {
+	std::array<void*, 0x400> table = {};
+	size_t index                   = 0;
+	bool is_building               = false;
+	bool is_built                  = false;
+	bool is_threaded               = true;
+} dispatch = {};
+
+void CPU_Core_Normal_SetThreadedDispatch(const bool enabled)
+{
+	dispatch.is_threaded = enabled;
+	dispatch.is_built    = false;
+}
+
+// Computed gotos are a GCC/Clang extension. Opcodes sharing an
+// implementation now pass through the table building check of the preceding
+// opcode, which the compiler reports as an unannotated fallthrough.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#pragma GCC diagnostic ignored "-Wimplicit-fallthrough"
+#endif
+
 Bits CPU_Core_Normal_Run() noexcept
 {
 	ZoneScoped;
+#if defined(OPCODE_DISPATCH_THREADED)
+	Bitu opcode = 0;
+	if (!dispatch.is_built && !dispatch.is_threaded) {
+		dispatch.table.fill(&&dispatch_switch);
+		dispatch.is_built = true;
+	}
+	if (!dispatch.is_built) {
+		dispatch.table.fill(&&illegal_opcode);
+		dispatch.is_building = true;
+		dispatch.index       = 0;
+		opcode               = 0;
+		goto dispatch_switch;
+	build_next_dispatch_entry:
+		if (++dispatch.index < dispatch.table.size()) {
+			opcode = dispatch.index;
+			goto dispatch_switch;
+		}
+		dispatch.is_building = false;
+		dispatch.is_built    = true;
+	}
+#endif
 	while (CPU_Cycles-->0) {
 		LOADIP;
 		core.opcode_index=cpu.code.big*0x200;
@@ -169,12 +225,24 @@ Bits CPU_Core_Normal_Run() noexcept
 		cycle_count++;
 #endif
 restart_opcode:
+#if defined(OPCODE_DISPATCH_THREADED)
+		opcode = core.opcode_index + Fetchb();
+		goto *dispatch.table[opcode];
+	dispatch_switch:
+		switch (opcode) {
+#else
 		switch (core.opcode_index+Fetchb()) {
+#endif
 		#include "core_normal/prefix_none.h"
 		#include "core_normal/prefix_0f.h"
 		#include "core_normal/prefix_66.h"
 		#include "core_normal/prefix_66_0f.h"
 		default:
+#if defined(OPCODE_DISPATCH_THREADED)
+			if (dispatch.is_building) {
+				goto build_next_dispatch_entry;
+			}
+#endif
 		illegal_opcode:
 #if C_DEBUG	
 			{
@@ -202,6 +270,10 @@ decode_end:
 	return CBRET_NONE;
 }
 
+#if defined(OPCODE_DISPATCH_THREADED)
+#pragma GCC diagnostic pop
+#endif
+
 Bits CPU_Core_Normal_Trap_Run() noexcept
 {
 	Bits oldCycles = CPU_Cycles;
@@ -141,25 +141,45 @@
 	}																		\
 }
 
+// With threaded dispatch, every opcode case also gets a label whose address
+// goes into the dispatch table. The table is built by visiting all opcodes
+// once through the switch, see CPU_Core_Normal_Run().
+#if defined(OPCODE_DISPATCH_THREADED)
+#define OPCODE_LABEL(_NAME)						\
+	if (dispatch.is_building) {					\
+		dispatch.table[dispatch.index] = &&_NAME;	\
+		goto build_next_dispatch_entry;			\
+	}											\
+	_NAME:
+#else
+#define OPCODE_LABEL(_NAME)
+#endif
+
 #define CASE_W(_WHICH)							\
-	case (OPCODE_NONE+_WHICH):
+	case (OPCODE_NONE+_WHICH):					\
+	OPCODE_LABEL(opcode_w_ ## _WHICH)
 
 #define CASE_D(_WHICH)							\
-	case (OPCODE_SIZE+_WHICH):
+	case (OPCODE_SIZE+_WHICH):					\
+	OPCODE_LABEL(opcode_d_ ## _WHICH)
 
 #define CASE_B(_WHICH)							\
-	CASE_W(_WHICH)								\
-	CASE_D(_WHICH)
+	case (OPCODE_NONE+_WHICH):					\
+	case (OPCODE_SIZE+_WHICH):					\
+	OPCODE_LABEL(opcode_b_ ## _WHICH)
 
 #define CASE_0F_W(_WHICH)						\
-	case ((OPCODE_0F|OPCODE_NONE)+_WHICH):
+	case ((OPCODE_0F|OPCODE_NONE)+_WHICH):		\
+	OPCODE_LABEL(opcode_0f_w_ ## _WHICH)
 
 #define CASE_0F_D(_WHICH)						\
-	case ((OPCODE_0F|OPCODE_SIZE)+_WHICH):
+	case ((OPCODE_0F|OPCODE_SIZE)+_WHICH):		\
+	OPCODE_LABEL(opcode_0f_d_ ## _WHICH)
 
 #define CASE_0F_B(_WHICH)						\
-	CASE_0F_W(_WHICH)							\
-	CASE_0F_D(_WHICH)
+	case ((OPCODE_0F|OPCODE_NONE)+_WHICH):		\
+	case ((OPCODE_0F|OPCODE_SIZE)+_WHICH):		\
+	OPCODE_LABEL(opcode_0f_b_ ## _WHICH)
 
 #define FixEA16 \
 	do { \
@@ -18,8 +18,180 @@
 
 #include "../string_ops.h"
 
+#include <algorithm>
+#include <cstring>
+
 #define LoadD(_BLAH) _BLAH
 
+// Cores that have to see all stores to guest memory, like the prefetch core
+// for its queue, are told about the runs written straight to host memory
+// through this, before they're written
+#ifndef STRING_BEFORE_HOST_WRITE
+#define STRING_BEFORE_HOST_WRITE(address, num_bytes)
+#endif
+
+template <typename T>
+static T load_string_element(const PhysPt address)
+{
+	if constexpr (sizeof(T) == 1) {
+		return LoadMb(address);
+	} else if constexpr (sizeof(T) == 2) {
+		return LoadMw(address);
+	} else {
+		return LoadMd(address);
+	}
+}
+
+template <typename T>
+static void save_string_element(const PhysPt address, const T val)
+{
+	if constexpr (sizeof(T) == 1) {
+		SaveMb(address, val);
+	} else if constexpr (sizeof(T) == 2) {
+		SaveMw(address, val);
+	} else {
+		SaveMd(address, val);
+	}
+}
+
+// Number of elements a string operation can process from 'index' in its
+// direction before an element straddles a 4K page or the index wraps
+// around the address size mask. Zero means the very next element does.
+template <typename T>
+static uint32_t string_run_length(const PhysPt base, const uint32_t index,
+                                  const uint32_t add_mask, const bool backwards)
+{
+	constexpr uint32_t size = sizeof(T);
+
+	const uint32_t offset = (base + index) & 4095;
+	if (offset + size > 4096) {
+		return 0;
+	}
+	if (backwards) {
+		return std::min(offset, index) / size + 1;
+	}
+	const uint64_t until_wrap = uint64_t(add_mask) - index + 1;
+	return static_cast<uint32_t>(
+	        std::min(uint64_t(4096 - offset), until_wrap) / size);
+}
+
+// Address of the lowest byte touched by a run of elements
+template <typename T>
+static PhysPt string_run_first(const PhysPt address, const uint32_t run,
+                               const bool backwards)
+{
+	return backwards ? static_cast<PhysPt>(address - (run - 1) * sizeof(T))
+	                 : address;
+}
+
+// Host address of the lowest byte touched by a run of elements, or nullptr
+// if the page has to go through its handler
+template <typename T>
+static HostPt string_run_host_pointer(const HostPt tlb, const PhysPt address,
+                                      const uint32_t run, const bool backwards)
+{
+	if (!tlb) {
+		return nullptr;
+	}
+	return tlb + string_run_first<T>(address, run, backwards);
+}
+
+// REP MOVS and REP STOS work directly on host memory for as long as both
+// ends stay within pages that are backed by it. Everything else (handler
+// pages such as VGA memory and code pages, elements straddling a page or
+// the index wrap, and overlapping copies whose element-wise result differs
+// from memmove) falls back to the regular memory access path.
+template <typename T>
+static void move_string(const PhysPt si_base, uint32_t& si_index,
+                        const PhysPt di_base, uint32_t& di_index,
+                        const Bits add_index, const uint32_t add_mask,
+                        uint32_t count)
+{
+	const Bits step      = add_index * static_cast<Bits>(sizeof(T));
+	const bool backwards = (step < 0);
+
+	while (count > 0) {
+		const auto run = std::min({count,
+		                           string_run_length<T>(si_base, si_index, add_mask, backwards),
+		                           string_run_length<T>(di_base, di_index, add_mask, backwards)});
+#if !C_HEAVY_DEBUG
+		if (run > 0) {
+			const auto si_address = si_base + si_index;
+			const auto di_address = di_base + di_index;
+
+			const auto src = string_run_host_pointer<T>(
+			        get_tlb_read(si_address), si_address, run, backwards);
+			const auto dst = string_run_host_pointer<T>(
+			        get_tlb_write(di_address), di_address, run, backwards);
+
+			// memmove matches the element-wise copy unless the
+			// destination runs ahead into the not yet read source
+			const bool matches_memmove = backwards ? (dst >= src)
+			                                       : (dst <= src);
+			if (src && dst && matches_memmove) {
+				STRING_BEFORE_HOST_WRITE(string_run_first<T>(di_address, run, backwards),
+				                         run * sizeof(T));
+				memmove(dst, src, run * sizeof(T));
+				si_index = (si_index + step * run) & add_mask;
+				di_index = (di_index + step * run) & add_mask;
+				count -= run;
+				continue;
+			}
+		}
+#endif
+		for (auto n = std::max(run, 1u); n > 0; --n, --count) {
+			save_string_element<T>(di_base + di_index,
+			                       load_string_element<T>(si_base + si_index));
+			di_index = (di_index + step) & add_mask;
+			si_index = (si_index + step) & add_mask;
+		}
+	}
+}
+
+template <typename T>
+static void store_string(const PhysPt di_base, uint32_t& di_index, const T val,
+                         const Bits add_index, const uint32_t add_mask,
+                         uint32_t count)
+{
+	const Bits step      = add_index * static_cast<Bits>(sizeof(T));
+	const bool backwards = (step < 0);
+
+	while (count > 0) {
+		const auto run = std::min(count,
+		                          string_run_length<T>(di_base, di_index, add_mask, backwards));
+#if !C_HEAVY_DEBUG
+		if (run > 0) {
+			const auto di_address = di_base + di_index;
+
+			const auto dst = string_run_host_pointer<T>(
+			        get_tlb_write(di_address), di_address, run, backwards);
+			if (dst) {
+				STRING_BEFORE_HOST_WRITE(string_run_first<T>(di_address, run, backwards),
+				                         run * sizeof(T));
+				if constexpr (sizeof(T) == 1) {
+					memset(dst, val, run);
+				} else {
+					for (uint32_t i = 0; i < run; ++i) {
+						if constexpr (sizeof(T) == 2) {
+							host_writew(dst + i * sizeof(T), val);
+						} else {
+							host_writed(dst + i * sizeof(T), val);
+						}
+					}
+				}
+				di_index = (di_index + step * run) & add_mask;
+				count -= run;
+				continue;
+			}
+		}
+#endif
+		for (auto n = std::max(run, 1u); n > 0; --n, --count) {
+			save_string_element<T>(di_base + di_index, val);
+			di_index = (di_index + step) & add_mask;
+		}
+	}
+}
+
 static void DoString(STRING_OP type) {
 	const auto si_base = BaseDS;
 	const auto di_base = SegBase(es);
@@ -92,47 +264,28 @@ static void DoString(STRING_OP type) {
 		}
 		break;
 	case R_STOSB:
-		for (;count>0;count--) {
-			SaveMb(di_base+di_index,reg_al);
-			di_index=(di_index+add_index) & add_mask;
-		}
+		store_string<uint8_t>(di_base, di_index, reg_al, add_index, add_mask, count);
+		count = 0;
 		break;
 	case R_STOSW:
-		add_index *= 2;
-		for (;count>0;count--) {
-			SaveMw(di_base+di_index,reg_ax);
-			di_index=(di_index+add_index) & add_mask;
-		}
+		store_string<uint16_t>(di_base, di_index, reg_ax, add_index, add_mask, count);
+		count = 0;
 		break;
 	case R_STOSD:
-		add_index *= 4;
-		for (;count>0;count--) {
-			SaveMd(di_base+di_index,reg_eax);
-			di_index=(di_index+add_index) & add_mask;
-		}
+		store_string<uint32_t>(di_base, di_index, reg_eax, add_index, add_mask, count);
+		count = 0;
 		break;
 	case R_MOVSB:
-		for (;count>0;count--) {
-			SaveMb(di_base+di_index,LoadMb(si_base+si_index));
-			di_index=(di_index+add_index) & add_mask;
-			si_index=(si_index+add_index) & add_mask;
-		}
+		move_string<uint8_t>(si_base, si_index, di_base, di_index, add_index, add_mask, count);
+		count = 0;
 		break;
 	case R_MOVSW:
-		add_index *= 2;
-		for (;count>0;count--) {
-			SaveMw(di_base+di_index,LoadMw(si_base+si_index));
-			di_index=(di_index+add_index) & add_mask;
-			si_index=(si_index+add_index) & add_mask;
-		}
+		move_string<uint16_t>(si_base, si_index, di_base, di_index, add_index, add_mask, count);
+		count = 0;
 		break;
 	case R_MOVSD:
-		add_index *= 4;
-		for (;count>0;count--) {
-			SaveMd(di_base+di_index,LoadMd(si_base+si_index));
-			di_index=(di_index+add_index) & add_mask;
-			si_index=(si_index+add_index) & add_mask;
-		}
+		move_string<uint32_t>(si_base, si_index, di_base, di_index, add_index, add_mask, count);
+		count = 0;
 		break;
 	case R_LODSB:
 		for (;count>0;count--) {
@@ -17,6 +17,7 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include <algorithm>
 #include <cstdio>
 
 // Needed for std::isnan in simde
@@ -44,22 +45,28 @@
 #define LoadMw(off) mem_readw(off)
 #define LoadMd(off) mem_readd(off)
 #define LoadMq(off) mem_readq(off)
-#define SaveMb(off,val)	mem_writeb(off,val)
-#define SaveMw(off,val)	mem_writew(off,val)
-#define SaveMd(off,val)	mem_writed(off,val)
-#define SaveMq(off,val) mem_writeq(off,val) 
+#define WriteMb(off,val) mem_writeb(off,val)
+#define WriteMw(off,val) mem_writew(off,val)
+#define WriteMd(off,val) mem_writed(off,val)
+#define WriteMq(off,val) mem_writeq(off,val)
 #else 
 #include "paging.h"
 #define LoadMb(off) mem_readb_inline(off)
 #define LoadMw(off) mem_readw_inline(off)
 #define LoadMd(off) mem_readd_inline(off)
 #define LoadMq(off) mem_readq_inline(off)
-#define SaveMb(off,val)	mem_writeb_inline(off,val)
-#define SaveMw(off,val)	mem_writew_inline(off,val)
-#define SaveMd(off,val)	mem_writed_inline(off,val)
-#define SaveMq(off,val) mem_writeq_inline(off,val)
+#define WriteMb(off,val) mem_writeb_inline(off,val)
+#define WriteMw(off,val) mem_writew_inline(off,val)
+#define WriteMd(off,val) mem_writed_inline(off,val)
+#define WriteMq(off,val) mem_writeq_inline(off,val)
 #endif
 
+// The stores first save the bytes they overwrite in the prefetch queue
+#define SaveMb(off,val)	save_mb(off,val)
+#define SaveMw(off,val)	save_mw(off,val)
+#define SaveMd(off,val)	save_md(off,val)
+#define SaveMq(off,val) save_mq(off,val)
+
 extern Bitu cycle_count;
 
 #if C_FPU
@@ -121,32 +128,85 @@ static struct {
 #define BaseSS		core.base_ss
 
 
+// The prefetch queue
+// ~~~~~~~~~~~~~~~~~~
+// The queue holds the CPU_PrefetchQueueSize bytes from 'pq_start' as they
+// were when fetched, so the code executes stale bytes if it modifies itself
+// within the queue. Rather than copying the code into the queue, the
+// instructions are fetched straight from memory, and only the bytes the
+// stores overwrite within the queue are kept, in 'pq_saved'. Unless the code
+// modifies itself just ahead of the instruction pointer, this runs about as
+// fast as the normal core.
 #define MAX_PQ_SIZE 32
-static uint8_t prefetch_buffer[MAX_PQ_SIZE];
+static uint8_t pq_saved[MAX_PQ_SIZE];
+static uint32_t pq_saved_mask = 0;
 static bool pq_valid=false;
 static Bitu pq_start;
 
+static_assert(MAX_PQ_SIZE <= 32, "The saved bytes need to fit the mask");
+
+static inline void pq_save_overwritten(const PhysPt addr, const Bitu num_bytes)
+{
+	if (!pq_valid || addr + num_bytes <= pq_start ||
+	    addr >= pq_start + CPU_PrefetchQueueSize) {
+		return;
+	}
+	// only the part of the range within the queue, string operations
+	// pass whole runs of up to a page
+	const PhysPt first = std::max<PhysPt>(addr, pq_start);
+	const PhysPt last  = std::min<PhysPt>(addr + num_bytes,
+	                                      pq_start + CPU_PrefetchQueueSize);
+	for (auto pt = first; pt < last; pt++) {
+		const auto index = pt - pq_start;
+		if (!(pq_saved_mask & (1u << index))) {
+			pq_saved[index] = LoadMb(pt);
+			pq_saved_mask |= (1u << index);
+		}
+	}
+}
+
+// Empties the queue and starts filling it from 'start'
+static inline void pq_restart(const PhysPt start)
+{
+	pq_start      = start;
+	pq_valid      = true;
+	pq_saved_mask = 0;
+}
+
+// Drops the bytes before 'start' and tops the queue up from memory
+static inline void pq_advance(const PhysPt start)
+{
+	const auto num_dropped = start - pq_start;
+	if (pq_saved_mask) {
+		pq_saved_mask >>= num_dropped;
+		for (Bitu i = 0; i < CPU_PrefetchQueueSize - num_dropped; i++) {
+			pq_saved[i] = pq_saved[i + num_dropped];
+		}
+	}
+	pq_start = start;
+}
+
+static inline uint8_t pq_readb(const PhysPt addr)
+{
+	const auto index = addr - pq_start;
+	if (pq_saved_mask & (1u << index)) {
+		return pq_saved[index];
+	}
+	return LoadMb(addr);
+}
+
 static uint8_t Fetchb() {
 	uint8_t temp;
 	if (pq_valid && (core.cseip>=pq_start) && (core.cseip<pq_start+CPU_PrefetchQueueSize)) {
-		temp=prefetch_buffer[core.cseip-pq_start];
+		temp = pq_saved_mask ? pq_readb(core.cseip) : LoadMb(core.cseip);
 		if ((core.cseip+1>=pq_start+CPU_PrefetchQueueSize-4) &&
 			(core.cseip+1<pq_start+CPU_PrefetchQueueSize)) {
-			Bitu remaining_bytes=pq_start+CPU_PrefetchQueueSize-(core.cseip+1);
-			for (Bitu i=0; i<remaining_bytes; i++) prefetch_buffer[i]=prefetch_buffer[core.cseip+1-pq_start+i];
-			for (Bitu i=remaining_bytes; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+1+i);
-			pq_start=core.cseip+1;
-			pq_valid=true;
+			pq_advance(core.cseip + 1);
 		}
 	} else {
-		for (Bitu i=0; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+i);
-		pq_start=core.cseip;
-		pq_valid=true;
-		temp=prefetch_buffer[0];
+		pq_restart(core.cseip);
+		temp = LoadMb(core.cseip);
 	}
-/*	if (temp!=LoadMb(core.cseip)) {
-		LOG_MSG("prefetch queue content!=memory at %x:%x",SegValue(cs),reg_eip);
-	} */
 	core.cseip+=1;
 	return temp;
 }
@@ -154,25 +214,17 @@ static uint8_t Fetchb() {
 static uint16_t Fetchw() {
 	uint16_t temp;
 	if (pq_valid && (core.cseip>=pq_start) && (core.cseip+2<pq_start+CPU_PrefetchQueueSize)) {
-		temp=prefetch_buffer[core.cseip-pq_start]|
-			(prefetch_buffer[core.cseip-pq_start+1]<<8);
+		temp = pq_saved_mask ? (pq_readb(core.cseip) |
+		                        (pq_readb(core.cseip + 1) << 8))
+		                     : LoadMw(core.cseip);
 		if ((core.cseip+2>=pq_start+CPU_PrefetchQueueSize-4) &&
 			(core.cseip+2<pq_start+CPU_PrefetchQueueSize)) {
-			Bitu remaining_bytes=pq_start+CPU_PrefetchQueueSize-(core.cseip+2);
-			for (Bitu i=0; i<remaining_bytes; i++) prefetch_buffer[i]=prefetch_buffer[core.cseip+2-pq_start+i];
-			for (Bitu i=remaining_bytes; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+2+i);
-			pq_start=core.cseip+2;
-			pq_valid=true;
+			pq_advance(core.cseip + 2);
 		}
 	} else {
-		for (Bitu i=0; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+i);
-		pq_start=core.cseip;
-		pq_valid=true;
-		temp=prefetch_buffer[0] | (prefetch_buffer[1]<<8);
+		pq_restart(core.cseip);
+		temp = LoadMw(core.cseip);
 	}
-/*	if (temp!=LoadMw(core.cseip)) {
-		LOG_MSG("prefetch queue content!=memory at %x:%x",SegValue(cs),reg_eip);
-	} */
 	core.cseip+=2;
 	return temp;
 }
@@ -180,37 +232,70 @@ static uint16_t Fetchw() {
 static uint32_t Fetchd() {
 	uint32_t temp;
 	if (pq_valid && (core.cseip>=pq_start) && (core.cseip+4<pq_start+CPU_PrefetchQueueSize)) {
-		temp=prefetch_buffer[core.cseip-pq_start]|
-			(prefetch_buffer[core.cseip-pq_start+1]<<8)|
-			(prefetch_buffer[core.cseip-pq_start+2]<<16)|
-			(prefetch_buffer[core.cseip-pq_start+3]<<24);
+		temp = pq_saved_mask ? (pq_readb(core.cseip) |
+		                        (pq_readb(core.cseip + 1) << 8) |
+		                        (pq_readb(core.cseip + 2) << 16) |
+		                        (pq_readb(core.cseip + 3) << 24))
+		                     : LoadMd(core.cseip);
 		if ((core.cseip+4>=pq_start+CPU_PrefetchQueueSize-4) &&
 			(core.cseip+4<pq_start+CPU_PrefetchQueueSize)) {
-			Bitu remaining_bytes=pq_start+CPU_PrefetchQueueSize-(core.cseip+4);
-			for (Bitu i=0; i<remaining_bytes; i++) prefetch_buffer[i]=prefetch_buffer[core.cseip+4-pq_start+i];
-			for (Bitu i=remaining_bytes; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+4+i);
-			pq_start=core.cseip+4;
-			pq_valid=true;
+			pq_advance(core.cseip + 4);
 		}
 	} else {
-		for (Bitu i=0; i<CPU_PrefetchQueueSize; i++) prefetch_buffer[i]=LoadMb(core.cseip+i);
-		pq_start=core.cseip;
-		pq_valid=true;
-		temp=prefetch_buffer[0] | (prefetch_buffer[1]<<8) |
-			(prefetch_buffer[2]<<16) | (prefetch_buffer[3]<<24);
+		pq_restart(core.cseip);
+		temp = LoadMd(core.cseip);
 	}
-/*	if (temp!=LoadMd(core.cseip)) {
-		LOG_MSG("prefetch queue content!=memory at %x:%x",SegValue(cs),reg_eip);
-	} */
 	core.cseip+=4;
 	return temp;
 }
 
-#define Push_16 CPU_Push16
-#define Push_32 CPU_Push32
+static void save_mb(const PhysPt addr, const uint8_t val)
+{
+	pq_save_overwritten(addr, 1);
+	WriteMb(addr, val);
+}
+
+static void save_mw(const PhysPt addr, const uint16_t val)
+{
+	pq_save_overwritten(addr, 2);
+	WriteMw(addr, val);
+}
+
+static void save_md(const PhysPt addr, const uint32_t val)
+{
+	pq_save_overwritten(addr, 4);
+	WriteMd(addr, val);
+}
+
+static void save_mq(const PhysPt addr, const uint64_t val)
+{
+	pq_save_overwritten(addr, 8);
+	WriteMq(addr, val);
+}
+
+// Pushes can overwrite the queue too
+static void push_16(const uint16_t value)
+{
+	pq_save_overwritten(SegPhys(ss) + ((reg_esp - 2) & cpu.stack.mask), 2);
+	CPU_Push16(value);
+}
+
+static void push_32(const uint32_t value)
+{
+	pq_save_overwritten(SegPhys(ss) + ((reg_esp - 4) & cpu.stack.mask), 4);
+	CPU_Push32(value);
+}
+
+#define Push_16 push_16
+#define Push_32 push_32
 #define Pop_16 CPU_Pop16
 #define Pop_32 CPU_Pop32
 
+// The REP MOVS/STOS runs written straight to host memory bypass SaveMb() and
+// co., so they have to keep the queued bytes themselves
+#define STRING_BEFORE_HOST_WRITE(address, num_bytes) \
+	pq_save_overwritten(address, num_bytes)
+
 #include "instructions.h"
 #include "core_normal/support.h"
 #include "core_normal/string.h"
@@ -23,10 +23,14 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <sstream>
+#include <type_traits>
 
 #include "control.h"
+#include "cpu_budget.h"
 #include "debug.h"
+#include "guest_stats.h"
 #include "lazyflags.h"
 #include "mapper.h"
 #include "math_utils.h"
@@ -34,6 +38,7 @@
 #include "paging.h"
 #include "pic.h"
 #include "programs.h"
+#include "savestate.h"
 #include "setup.h"
 #include "string_utils.h"
 #include "support.h"
@@ -97,6 +102,8 @@ static int cpu_cycle_down = 0;
 
 int64_t CPU_IODelayRemoved = 0;
 
+bool CPU_SkipIdlePolling = false;
+
 CPU_Decoder* cpudecoder;
 
 bool CPU_CycleAutoAdjust = false;
@@ -111,6 +118,9 @@ static Bitu cpu_extflags_toggle = 0;
 
 Bitu CPU_PrefetchQueueSize = 0;
 
+uint8_t CPU_DynamicCoreTranslationThreshold = 0;
+uint16_t CPU_DynamicCoreCacheSizeMb = 8;
+
 void CPU_Core_Full_Init();
 void CPU_Core_Normal_Init();
 void CPU_Core_Simple_Init();
@@ -125,6 +135,7 @@ void CPU_Core_Dyn_X86_SetFPUMode(bool dh_fpu);
 void CPU_Core_Dynrec_Init();
 void CPU_Core_Dynrec_Cache_Init(bool enable_cache);
 void CPU_Core_Dynrec_Cache_Close();
+void CPU_Core_Dynrec_SetBlockCacheFile(const std_fs::path& file);
 #endif
 
 /* In debug mode exceptions are tested and dosbox exits when
@@ -732,6 +743,9 @@ void CPU_DebugException(uint32_t triggers,Bitu oldeip) {
 
 void CPU_Exception(Bitu which,Bitu error ) {
 //	LOG_MSG("Exception %d error %x",which,error);
+	if (which == EXCEPTION_PF) {
+		++guest_stats.page_faults;
+	}
 	cpu.exception.error=error;
 	CPU_Interrupt(which,CPU_INT_EXCEPTION | ((which>=8) ? CPU_INT_HAS_ERROR : 0),reg_eip);
 }
@@ -2114,6 +2128,37 @@ void CPU_VERW(Bitu selector) {
 	SETFLAGBIT(ZF,true);
 }
 
+// The descriptor each segment register was last loaded from in protected
+// mode, once it passed the checks. Programs keep reloading the very same
+// selectors, and as the checks only depend on the selector, the descriptor,
+// and the privilege level, they can be skipped if none of these changed. The
+// descriptor itself is still read, as the guest can rewrite the descriptor
+// tables without us noticing.
+struct LoadedSegment {
+	uint32_t descriptor[2] = {};
+	Bitu selector          = 0;
+	Bitu cpl               = 0;
+	bool is_valid          = false;
+
+	bool Matches(const Bitu value, const Descriptor& desc) const
+	{
+		return is_valid && selector == value && cpl == cpu.cpl &&
+		       descriptor[0] == desc.saved.fill[0] &&
+		       descriptor[1] == desc.saved.fill[1];
+	}
+
+	void Set(const Bitu value, const Descriptor& desc)
+	{
+		descriptor[0] = desc.saved.fill[0];
+		descriptor[1] = desc.saved.fill[1];
+		selector      = value;
+		cpl           = cpu.cpl;
+		is_valid      = true;
+	}
+};
+
+static LoadedSegment loaded_segments[gs + 1] = {};
+
 bool CPU_SetSegGeneral(SegNames seg,Bitu value) {
 	value &= 0xffff;
 	if (!cpu.pmode || (reg_flags & FLAG_VM)) {
@@ -2126,6 +2171,7 @@ bool CPU_SetSegGeneral(SegNames seg,Bitu value) {
 		}
 		return false;
 	} else {
+		auto& loaded = loaded_segments[seg];
 		if (seg==ss) {
 			// Stack needs to be non-zero
 			if ((value & 0xfffc)==0) {
@@ -2137,23 +2183,26 @@ bool CPU_SetSegGeneral(SegNames seg,Bitu value) {
 //				E_Exit("CPU_SetSegGeneral: Stack segment beyond limits");
 				return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
 			}
-			if (((value & 3)!=cpu.cpl) || (desc.DPL()!=cpu.cpl)) {
-//				E_Exit("CPU_SetSegGeneral: Stack segment with invalid privileges");
-				return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
-			}
+			if (!loaded.Matches(value, desc)) {
+				if (((value & 3)!=cpu.cpl) || (desc.DPL()!=cpu.cpl)) {
+//					E_Exit("CPU_SetSegGeneral: Stack segment with invalid privileges");
+					return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
+				}
 
-			switch (desc.Type()) {
-			case DESC_DATA_EU_RW_NA:		case DESC_DATA_EU_RW_A:
-			case DESC_DATA_ED_RW_NA:		case DESC_DATA_ED_RW_A:
-				break;
-			default:
-				//Earth Siege 1
-				return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
-			}
+				switch (desc.Type()) {
+				case DESC_DATA_EU_RW_NA:		case DESC_DATA_EU_RW_A:
+				case DESC_DATA_ED_RW_NA:		case DESC_DATA_ED_RW_A:
+					break;
+				default:
+					//Earth Siege 1
+					return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
+				}
 
-			if (!desc.saved.seg.p) {
-//				E_Exit("CPU_SetSegGeneral: Stack segment not present");	// or #SS(sel)
-				return CPU_PrepareException(EXCEPTION_SS,value & 0xfffc);
+				if (!desc.saved.seg.p) {
+//					E_Exit("CPU_SetSegGeneral: Stack segment not present");	// or #SS(sel)
+					return CPU_PrepareException(EXCEPTION_SS,value & 0xfffc);
+				}
+				loaded.Set(value, desc);
 			}
 
 			Segs.val[seg]=value;
@@ -2177,27 +2226,30 @@ bool CPU_SetSegGeneral(SegNames seg,Bitu value) {
 			if (!cpu.gdt.GetDescriptor(value,desc)) {
 				return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
 			}
-			switch (desc.Type()) {
-			case DESC_DATA_EU_RO_NA:		case DESC_DATA_EU_RO_A:
-			case DESC_DATA_EU_RW_NA:		case DESC_DATA_EU_RW_A:
-			case DESC_DATA_ED_RO_NA:		case DESC_DATA_ED_RO_A:
-			case DESC_DATA_ED_RW_NA:		case DESC_DATA_ED_RW_A:
-			case DESC_CODE_R_NC_A:			case DESC_CODE_R_NC_NA:
-				if (((value & 3)>desc.DPL()) || (cpu.cpl>desc.DPL())) {
-					// extreme pinball
+			if (!loaded.Matches(value, desc)) {
+				switch (desc.Type()) {
+				case DESC_DATA_EU_RO_NA:		case DESC_DATA_EU_RO_A:
+				case DESC_DATA_EU_RW_NA:		case DESC_DATA_EU_RW_A:
+				case DESC_DATA_ED_RO_NA:		case DESC_DATA_ED_RO_A:
+				case DESC_DATA_ED_RW_NA:		case DESC_DATA_ED_RW_A:
+				case DESC_CODE_R_NC_A:			case DESC_CODE_R_NC_NA:
+					if (((value & 3)>desc.DPL()) || (cpu.cpl>desc.DPL())) {
+						// extreme pinball
+						return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
+					}
+					break;
+				case DESC_CODE_R_C_A:			case DESC_CODE_R_C_NA:
+					break;
+				default:
+					// gabriel knight
 					return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
-				}
-				break;
-			case DESC_CODE_R_C_A:			case DESC_CODE_R_C_NA:
-				break;
-			default:
-				// gabriel knight
-				return CPU_PrepareException(EXCEPTION_GP,value & 0xfffc);
 
-			}
-			if (!desc.saved.seg.p) {
-				// win
-				return CPU_PrepareException(EXCEPTION_NP,value & 0xfffc);
+				}
+				if (!desc.saved.seg.p) {
+					// win
+					return CPU_PrepareException(EXCEPTION_NP,value & 0xfffc);
+				}
+				loaded.Set(value, desc);
 			}
 
 			Segs.val[seg]=value;
@@ -2656,6 +2708,34 @@ std::string CPU_GetCyclesConfigAsString()
 	}
 }
 
+// The register file only; the rest of the CPU state (mode, descriptor
+// tables, control registers) is expected to match the saved one
+static void save_cpu_regs(std::vector<uint8_t>& data)
+{
+	static_assert(std::is_trivially_copyable_v<CPU_Regs>);
+	static_assert(std::is_trivially_copyable_v<Segments>);
+
+	FillFlags();
+
+	data.resize(sizeof(cpu_regs) + sizeof(Segs));
+	memcpy(data.data(), &cpu_regs, sizeof(cpu_regs));
+	memcpy(data.data() + sizeof(cpu_regs), &Segs, sizeof(Segs));
+}
+
+static bool check_cpu_regs(const std::vector<uint8_t>& data)
+{
+	return data.size() == sizeof(cpu_regs) + sizeof(Segs);
+}
+
+static void load_cpu_regs(const std::vector<uint8_t>& data)
+{
+	memcpy(&cpu_regs, data.data(), sizeof(cpu_regs));
+	memcpy(&Segs, data.data() + sizeof(cpu_regs), sizeof(Segs));
+
+	lflags.type   = t_UNKNOWN;
+	cpu.direction = 1 - ((reg_flags & FLAG_DF) >> 9);
+}
+
 class Cpu final {
 private:
 	static bool initialised;
@@ -2724,6 +2804,11 @@ public:
 #elif C_DYNREC
 		CPU_Core_Dynrec_Init();
 #endif
+		SAVESTATE_AddComponent("cpu_regs",
+		                       save_cpu_regs,
+		                       check_cpu_regs,
+		                       load_cpu_regs);
+
 		MAPPER_AddHandler(cpu_decrease_cycles,
 		                  SDL_SCANCODE_F11,
 		                  PRIMARY_MOD,
@@ -3164,9 +3249,22 @@ public:
 		const std::string cpu_core = secprop->Get_string("core");
 		const std::string cpu_type = secprop->Get_string("cputype");
 
+#if C_DYNAMIC_X86 || C_DYNREC
+		CPU_DynamicCoreCacheSizeMb = check_cast<uint16_t>(
+		        secprop->Get_int("dynamic_core_cache_size"));
+#endif
 		ConfigureCpuCore(cpu_core);
 		ConfigureCpuType(cpu_core, cpu_type);
 
+#if C_DYNAMIC_X86 || C_DYNREC
+		CPU_DynamicCoreTranslationThreshold = check_cast<uint8_t>(
+		        secprop->Get_int("dynamic_core_threshold"));
+#endif
+#if C_DYNREC
+		CPU_Core_Dynrec_SetBlockCacheFile(
+		        secprop->Get_string("dynamic_core_cache_file"));
+#endif
+
 		auto cycles_pref = secprop->Get_string("cycles");
 		trim(cycles_pref);
 
@@ -3196,6 +3294,10 @@ public:
 			set_modern_cycles_config(CpuMode::Real);
 		}
 
+		CPU_SkipIdlePolling = secprop->Get_bool("cpu_skip_idle_polling");
+
+		CPU_BUDGET_Configure(secprop->Get_int("cpu_budget"));
+
 		cpu_cycle_up   = secprop->Get_int("cycleup");
 		cpu_cycle_down = secprop->Get_int("cycledown");
 
@@ -3234,6 +3336,7 @@ void init_cpu_dosbox_settings(Section_prop& secprop)
 {
 	constexpr auto Always   = Property::Changeable::Always;
 	constexpr auto WhenIdle = Property::Changeable::WhenIdle;
+	constexpr auto OnlyAtStart = Property::Changeable::OnlyAtStart;
 	constexpr auto DeprecatedButAllowed = Property::Changeable::DeprecatedButAllowed;
 
 	auto pstring = secprop.Add_string("core", WhenIdle, "auto");
@@ -3267,6 +3370,32 @@ void init_cpu_dosbox_settings(Section_prop& secprop)
 	        "            Programs that self-modify their code might misbehave or crash on\n"
 	        "            the 'dynamic' core; use the 'normal' core for such programs.");
 
+#if C_DYNAMIC_X86 || C_DYNREC
+	auto pint_threshold = secprop.Add_int("dynamic_core_threshold", WhenIdle, 0);
+	pint_threshold->SetMinMax(0, UINT8_MAX);
+	pint_threshold->Set_help(
+	        "Number of times the 'dynamic' core lets the 'normal' core interpret a piece\n"
+	        "of code before translating it (0 by default). With 0, all code is\n"
+	        "translated on first use. Higher values keep run-once setup code\n"
+	        "interpreted and save translation time and cache space for hot code.");
+
+	auto pint_cache_size = secprop.Add_int("dynamic_core_cache_size", OnlyAtStart, 8);
+	pint_cache_size->SetMinMax(2, 256);
+	pint_cache_size->Set_help(
+	        "Size of the 'dynamic' core's code cache in megabytes (8 by default).\n"
+	        "When the cache is full, the least recently entered code gets overwritten\n"
+	        "first. Large Windows 3.x and 9x workloads can benefit from a larger cache.");
+#endif
+#if C_DYNREC
+	pstring = secprop.Add_string("dynamic_core_cache_file", WhenIdle, "");
+	pstring->Set_help(
+	        "Remember which code blocks the 'dynamic' core translated in a file, and\n"
+	        "translate them ahead of time on the next run (unset by default).\n"
+	        "Blocks are only reused if the guest code page they were found in is\n"
+	        "unchanged, so the same file can safely be used across program versions.\n"
+	        "Use a separate file per game for the best results.");
+#endif
+
 	pstring = secprop.Add_string("cputype", Always, "auto");
 	pstring->Set_values(
 	        {"auto", "386", "386_fast", "386_prefetch", "486", "pentium", "pentium_mmx"});
@@ -3377,7 +3506,24 @@ void init_cpu_dosbox_settings(Section_prop& secprop)
 	        "millisecond can vary; this might cause issues in some DOS programs.",
 	        (CpuThrottleDefault ? "enabled" : "disabled")));
 
-	auto pint = secprop.Add_int("cycleup", Always, DefaultCpuCycleUp);
+	pbool = secprop.Add_bool("cpu_skip_idle_polling", Always, false);
+	pbool->Set_help(
+	        "Skip ahead to the next emulated hardware event when the DOS program is\n"
+	        "busy-waiting on an I/O port, e.g., for the vertical retrace or a key press\n"
+	        "(disabled by default). This lowers the host CPU load of such programs\n"
+	        "considerably. Programs that measure the CPU speed by counting polling loop\n"
+	        "iterations might see a slower CPU when enabled.");
+
+	auto pint = secprop.Add_int("cpu_budget", Always, 0);
+	pint->SetMinMax(0, 100000);
+	pint->Set_help(
+	        "Share a budget of host CPU time between the instances running on 'max' cycles,\n"
+	        "in percent of one host core (0 by default, disabled). The instances of the\n"
+	        "same host user with the same budget each get an equal part of it, at most\n"
+	        "their 'max' percentage. E.g., 300 lets three instances use a full core each,\n"
+	        "or six instances half a core each. Not supported on Windows hosts.");
+
+	pint = secprop.Add_int("cycleup", Always, DefaultCpuCycleUp);
 	pint->SetMinMax(CpuCycleStepMin, CpuCycleStepMax);
 	pint->Set_help(
 	        format_str("Number of cycles to add with the 'Inc Cycles' hotkey (%d by default).\n"
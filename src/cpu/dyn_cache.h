@@ -24,6 +24,8 @@
 #include <new>
 #include <type_traits>
 
+#include "guest_stats.h"
+#include "host_memory.h"
 #include "mem_unaligned.h"
 #include "paging.h"
 #include "types.h"
@@ -89,6 +91,9 @@ public:
 		uint16_t maskstart = 0;
 		uint16_t masklen   = 0;
 
+		// the block was entered since the allocator last swept past it
+		bool referenced = false;
+
 		// Manage the write mask
 		void DeleteWriteMask();
 		inline void AddByteToWriteMaskAt(const size_t page_index);
@@ -151,9 +156,31 @@ static uint8_t* cache_code_start_ptr   = {};
 static uint8_t* cache_code             = {};
 static uint8_t* cache_code_link_blocks = {};
 
-static std::vector<CacheBlock> cache_blocks(CACHE_BLOCKS);
+static TrackedHostMemory tracked_cache_code{HostMemoryUse::DynrecCache};
+
+// size of the code cache and the number of cache blocks managing it, set
+// from CPU_DynamicCoreCacheSizeMb when the cache is first allocated
+static size_t cache_total      = CACHE_TOTAL;
+static size_t cache_num_blocks = CACHE_BLOCKS;
+
+static std::vector<CacheBlock> cache_blocks = {};
 static CacheBlock link_blocks[2] = {}; // default linking (specially marked)
 
+// counters of the self-modifying code handling, logged when the cache is
+// closed to see which programs keep invalidating their translated code
+static struct {
+	uint32_t invalidated_blocks   = 0;
+	uint32_t interpreted_granules = 0;
+	uint64_t interpreted_entries  = 0;
+} smc_stats = {};
+
+#if C_DYNREC
+class CodePageHandler;
+namespace DynrecProfile {
+static void on_page_released(const CodePageHandler* codepage);
+}
+#endif
+
 // the CodePageHandler class provides access to the contained
 // cache blocks and intercepts writes to the code for special treatment
 class CodePageHandler final : public PageHandler {
@@ -181,10 +208,38 @@ public:
 		// code present)
 		memset(&hash_map,0,sizeof(hash_map));
 		memset(&write_map,0,sizeof(write_map));
+		memset(&smc_counts, 0, sizeof(smc_counts));
 		if (invalidation_map) {
 			delete [] invalidation_map;
 			invalidation_map = nullptr;
 		}
+		if (entry_counts) {
+			delete [] entry_counts;
+			entry_counts = nullptr;
+		}
+	}
+
+	// count an entry into not yet translated code at the given page
+	// offset, returns true once it was entered often enough to be
+	// worth translating (see CPU_DynamicCoreTranslationThreshold)
+	bool CountEntry(Bitu start)
+	{
+		if (!entry_counts) {
+			entry_counts = alloc_invalidation_map();
+		}
+		if (entry_counts[start] >= CPU_DynamicCoreTranslationThreshold) {
+			return true;
+		}
+		entry_counts[start]++;
+		return false;
+	}
+
+	// code starting at the given page offset was invalidated so often that
+	// it is only interpreted from now on, as translating it again would
+	// most likely just be wasted
+	bool IsSelfModifying(Bitu start) const
+	{
+		return smc_counts[start >> SmcGranuleShift] >= SmcInterpretThreshold;
 	}
 
 	// clear out blocks that contain code which has been modified
@@ -212,6 +267,12 @@ public:
 				// test if this block is in the range
 				if (start<=block->page.end && end>=block->page.start) {
 					if (ip_point<=block->page.end && ip_point>=block->page.start) is_current_block=true;
+					// cross page blocks are accounted in
+					// the page they start in
+					if (block->hash.index) {
+						CountInvalidation(block->page.start);
+					}
+					++guest_stats.dyn_blocks_invalidated;
 					block->Clear(); // clear the block,
 					                // decrements the
 					                // write_map accordingly
@@ -223,12 +284,22 @@ public:
 		return is_current_block;
 	}
 
+	void CountInvalidation(Bitu start)
+	{
+		++smc_stats.invalidated_blocks;
+		auto& count = smc_counts[start >> SmcGranuleShift];
+		if (count < SmcInterpretThreshold &&
+		    ++count == SmcInterpretThreshold) {
+			++smc_stats.interpreted_granules;
+		}
+	}
+
 	uint8_t *alloc_invalidation_map() const
 	{
 		constexpr size_t map_size = 4096;
 		uint8_t *map = new (std::nothrow) uint8_t[map_size];
 		if (!map) {
-			E_Exit("failed to allocate invalidation_map");
+			E_Exit("failed to allocate code page map");
 		}
 		memset(map, 0, map_size);
 		return map;
@@ -500,6 +571,10 @@ public:
 		next=cache.free_pages;
 		cache.free_pages=this;
 		prev=nullptr;
+
+#if C_DYNREC
+		DynrecProfile::on_page_released(this);
+#endif
 	}
 
 	void ClearRelease()
@@ -530,6 +605,11 @@ public:
 		return nullptr; // none found
 	}
 
+	bool HasActiveBlocks() const
+	{
+		return active_blocks != 0;
+	}
+
 	HostPt GetHostReadPt(Bitu phys_page) override
 	{
 		hostmem = old_pagehandler->GetHostReadPt(phys_page);
@@ -546,6 +626,14 @@ public:
 	// the byte at address i
 	uint8_t write_map[4096] = {};
 	uint8_t *invalidation_map = nullptr;
+	// number of times the code at i was entered without being translated
+	uint8_t *entry_counts = nullptr;
+
+	// number of times blocks starting in each 16-byte granule of the
+	// page were invalidated, saturating at SmcInterpretThreshold
+	static constexpr Bitu SmcGranuleShift         = 4;
+	static constexpr uint8_t SmcInterpretThreshold = 8;
+	uint8_t smc_counts[4096 >> SmcGranuleShift]    = {};
 
 	CodePageHandler *prev = nullptr;
 	CodePageHandler *next = nullptr;
@@ -702,10 +790,61 @@ void CacheBlock::Clear()
 		page.handler=nullptr;
 	}
 	cache.DeleteWriteMask();
+	cache.referenced = false;
+}
+
+// the block that follows in the code cache, wrapping around at its end
+static CacheBlock* cache_next_in_ring(CacheBlock* block)
+{
+#if (C_DYNAMIC_X86)
+	const bool cache_is_full = !block->cache.next;
+#elif (C_DYNREC)
+	const uint8_t *limit = (cache_code_start_ptr + cache_total - CACHE_MAXSIZE);
+	const bool cache_is_full = (!block->cache.next ||
+	                            (block->cache.next->cache.start > limit));
+#endif
+	if (cache_is_full) {
+		// LOG_DEBUG("Cache full; restarting");
+		return cache.block.first;
+	}
+	return block->cache.next;
+}
+
+// The cache is filled like a ring, overwriting the oldest blocks. Blocks
+// that were entered since the last sweep get a second chance: the opened
+// block is moved past them so hot code survives while cold code is
+// overwritten (a CLOCK approximation of LRU eviction).
+static void cache_skip_referenced_blocks()
+{
+	constexpr int MaxSecondChances = 64;
+
+	CacheBlock* start = cache.block.active;
+	for (int i = 0; i < MaxSecondChances; ++i) {
+		// look for a referenced block in the range that would be
+		// merged into the opened block
+		CacheBlock* referenced = nullptr;
+		Bitu size              = 0;
+		for (auto block = start; block && size < CACHE_MAXSIZE;
+		     block = block->cache.next) {
+			if (block->cache.referenced) {
+				referenced = block;
+				break;
+			}
+			size += block->cache.size;
+		}
+		if (!referenced) {
+			break;
+		}
+		referenced->cache.referenced = false;
+		start = cache_next_in_ring(referenced);
+	}
+	cache.block.active = start;
 }
 
 static CacheBlock *cache_openblock()
 {
+	cache_skip_referenced_blocks();
+
 	CacheBlock *block = cache.block.active;
 	// check for enough space in this block
 	Bitu size=block->cache.size;
@@ -735,6 +874,8 @@ skipresize:
 
 static void cache_closeblock()
 {
+	++guest_stats.dyn_blocks_translated;
+
 	CacheBlock *block = cache.block.active;
 	// links point to the default linking code
 	block->link[0].to=&link_blocks[0];
@@ -770,19 +911,7 @@ static void cache_closeblock()
 		}
 	}
 	// advance the active block pointer
-#if (C_DYNAMIC_X86)
-	const bool cache_is_full = !block->cache.next;
-#elif (C_DYNREC)
-	const uint8_t *limit = (cache_code_start_ptr + CACHE_TOTAL - CACHE_MAXSIZE);
-	const bool cache_is_full = (!block->cache.next ||
-	                            (block->cache.next->cache.start > limit));
-#endif
-	if (cache_is_full) {
-		// LOG_DEBUG("Cache full; restarting");
-		cache.block.active=cache.block.first;
-	} else {
-		cache.block.active=block->cache.next;
-	}
+	cache.block.active = cache_next_in_ring(block);
 }
 
 // TODO functions cache_addb, cache_addw, cache_addd, cache_addq definitely
@@ -857,7 +986,19 @@ static void cache_block_before_close();
 static void cache_block_closing(const uint8_t *block_start, Bitu block_size);
 #endif
 
-static constexpr size_t cache_code_size = CACHE_TOTAL + CACHE_MAXSIZE + host_pagesize - 1 + host_pagesize;
+static size_t cache_code_size()
+{
+	return cache_total + CACHE_MAXSIZE + host_pagesize - 1 + host_pagesize;
+}
+
+static void cache_configure_size()
+{
+	cache_total = static_cast<size_t>(CPU_DynamicCoreCacheSizeMb) * 1024 * 1024;
+	// keep the ratio of cache blocks to cache memory
+	cache_num_blocks = CACHE_BLOCKS * (cache_total / (1024 * 1024)) /
+	                   (CACHE_TOTAL / (1024 * 1024));
+	cache_blocks = std::vector<CacheBlock>(cache_num_blocks);
+}
 constexpr bool is_64bit_platform = sizeof(void *) == 8;
 
 static inline void dyn_mem_adjust(void *&ptr, size_t &size)
@@ -974,9 +1115,12 @@ static void cache_init(bool enable) {
 			return;
 		}
 		cache_initialized = true;
+		if (cache_blocks.empty()) {
+			cache_configure_size();
+		}
 		cache.block.free = &cache_blocks[0];
 		// initialize the cache blocks
-		for (int i=0;i<CACHE_BLOCKS-1;i++) {
+		for (size_t i = 0; i < cache_num_blocks - 1; i++) {
 			cache_blocks[i].link[0].to = (CacheBlock *)1;
 			cache_blocks[i].link[1].to = (CacheBlock *)1;
 			cache_blocks[i].cache.next = &cache_blocks[i + 1];
@@ -986,11 +1130,11 @@ static void cache_init(bool enable) {
 #if defined (WIN32)
 			LPVOID lp_vmem = nullptr;
 			if (CPU_UseRwxMemProtect) {
-				lp_vmem = VirtualAlloc(nullptr, cache_code_size,
+				lp_vmem = VirtualAlloc(nullptr, cache_code_size(),
 				                       MEM_COMMIT,
 				                       PAGE_EXECUTE_READWRITE); // all operations allowed
 			} else {
-				lp_vmem = VirtualAlloc(nullptr, cache_code_size,
+				lp_vmem = VirtualAlloc(nullptr, cache_code_size(),
 				                       MEM_COMMIT | MEM_RESERVE,
 				                       PAGE_READWRITE); // needs on-going management
 			}
@@ -1002,16 +1146,18 @@ static void cache_init(bool enable) {
 #if defined(HAVE_MAP_JIT)
 			map_flags |= MAP_JIT;
 #endif
-			cache_code_start_ptr=static_cast<uint8_t *>(mmap(nullptr, cache_code_size, prot_flags, map_flags, -1, 0));
+			cache_code_start_ptr=static_cast<uint8_t *>(mmap(nullptr, cache_code_size(), prot_flags, map_flags, -1, 0));
 			if (cache_code_start_ptr == MAP_FAILED) {
 				E_Exit("DYNCACHE: Failed memory-mapping cache memory because: %s", strerror(errno));
 			}
 #else
-			cache_code_start_ptr=static_cast<uint8_t *>(malloc(cache_code_size));
+			cache_code_start_ptr=static_cast<uint8_t *>(malloc(cache_code_size()));
 			if (!cache_code_start_ptr) {
 				E_Exit("DYNCACHE: Failed allocating cache memory because: %s", strerror(errno));
 			}
 #endif
+			tracked_cache_code.Track(cache_code_start_ptr, cache_code_size());
+
 			// align the cache at a page boundary
 			cache_code = reinterpret_cast<uint8_t *>(
 			    (reinterpret_cast<uintptr_t>(cache_code_start_ptr) +
@@ -1023,7 +1169,7 @@ static void cache_init(bool enable) {
 			cache.block.first=block;
 			cache.block.active=block;
 			block->cache.start=&cache_code[0];
-			block->cache.size=CACHE_TOTAL;
+			block->cache.size=cache_total;
 			block->cache.next = nullptr; // last block in the list
 		}
 
@@ -1084,7 +1230,22 @@ static void cache_init(bool enable) {
 	}
 }
 
+static void cache_log_smc_stats()
+{
+	if (!smc_stats.invalidated_blocks) {
+		return;
+	}
+	LOG_MSG("DYNCACHE: Self-modifying code invalidated %u blocks; %u code "
+	        "regions were switched to interpreted mode and entered %" PRIu64
+	        " times",
+	        smc_stats.invalidated_blocks,
+	        smc_stats.interpreted_granules,
+	        smc_stats.interpreted_entries);
+	smc_stats = {};
+}
+
 static void cache_close(void) {
+	cache_log_smc_stats();
 /*	for (;;) {
 		if (cache.used_pages) {
 			CodePageHandler * cpage=cache.used_pages;
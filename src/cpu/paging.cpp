@@ -29,6 +29,7 @@
 #include "lazyflags.h"
 #include "cpu.h"
 #include "debug.h"
+#include "guest_stats.h"
 #include "setup.h"
 
 #define LINK_TOTAL		(64*1024)
@@ -146,28 +147,53 @@ struct PF_Entry {
 static struct {
 	uint8_t used = 0; // keeps track of number of entries
 	PF_Entry entries[PF_QUEUESIZE];
+
+	// Set once the guest's handler returned to the latest faulting
+	// instruction, see PAGING_CheckPageFaultReturn()
+	bool has_returned = false;
 } pf_queue;
 
+// Faults in unchecked memory accesses can't abort the instruction, so the
+// guest's handler is run right away in a nested loop with the full core,
+// until it returns to the faulting instruction. The handler runs in regular
+// time slices; the return is caught by the IRET that leads back to the
+// instruction, which ends the slice.
 static Bits PageFaultCore()
 {
-	CPU_CycleLeft+=CPU_Cycles;
-	CPU_Cycles=1;
 	Bits ret=CPU_Core_Full_Run();
-	CPU_CycleLeft+=CPU_Cycles;
 	if (ret<0) E_Exit("Got a dosbox close machine in pagefault core?");
 	if (ret) 
 		return ret;
 	if (!pf_queue.used) E_Exit("PF Core without PF");
-	PF_Entry * entry=&pf_queue.entries[pf_queue.used-1];
-	X86PageEntry pentry;
-	pentry.set(phys_readd(entry->page_addr));
-	if (pentry.p && entry->cs == SegValue(cs) && entry->eip == reg_eip) {
-		cpu.mpl = entry->mpl;
+	if (pf_queue.has_returned) {
+		pf_queue.has_returned = false;
+		cpu.mpl = pf_queue.entries[pf_queue.used - 1].mpl;
 		return -1;
 	}
 	return 0;
 }
 
+void PAGING_CheckPageFaultReturn()
+{
+	if (!pf_queue.used) {
+		return;
+	}
+	const auto entry = &pf_queue.entries[pf_queue.used - 1];
+	if (entry->cs != SegValue(cs) || entry->eip != reg_eip) {
+		return;
+	}
+	X86PageEntry pentry;
+	pentry.set(phys_readd(entry->page_addr));
+	if (!pentry.p) {
+		return;
+	}
+	pf_queue.has_returned = true;
+
+	// Leave the nested core right after the IRET
+	CPU_CycleLeft += CPU_Cycles;
+	CPU_Cycles = 0;
+}
+
 bool first=false;
 
 void PAGING_PageFault(PhysPt lin_addr,uint32_t page_addr,uint32_t faultcode) {
@@ -186,6 +212,8 @@ void PAGING_PageFault(PhysPt lin_addr,uint32_t page_addr,uint32_t faultcode) {
 	entry->mpl=cpu.mpl;
 	cpu.mpl=3;
 
+	++guest_stats.nested_page_faults;
+
 	CPU_Exception(EXCEPTION_PF,faultcode);
 	DOSBOX_RunMachine();
 	pf_queue.used--;
@@ -197,13 +225,23 @@ void PAGING_PageFault(PhysPt lin_addr,uint32_t page_addr,uint32_t faultcode) {
 
 static inline void InitPageUpdateLink(uint32_t relink,PhysPt addr) {
 	if (relink==0) return;
+	uint32_t dir_entry   = 0;
+	uint32_t table_entry = 0;
 	if (paging.links.used) {
 		if (paging.links.entries[paging.links.used-1]==(addr>>12)) {
 			paging.links.used--;
+			dir_entry   = paging.links.dir_entries[paging.links.used];
+			table_entry = paging.links.table_entries[paging.links.used];
 			PAGING_UnlinkPages(addr>>12,1);
 		}
 	}
-	if (relink>1) PAGING_LinkPage_ReadOnly(addr>>12,relink);
+	if (relink>1) {
+		PAGING_LinkPage_ReadOnly(addr>>12,relink);
+
+		// still the same translation, only linked read-only now
+		paging.links.dir_entries[paging.links.used - 1]   = dir_entry;
+		paging.links.table_entries[paging.links.used - 1] = table_entry;
+	}
 }
 
 static inline void InitPageCheckPresence(PhysPt lin_addr,bool writing,X86PageEntry& table,X86PageEntry& entry) {
@@ -274,6 +312,18 @@ static inline bool InitPage_CheckUseraccess(uint32_t u1,uint32_t u2) {
 }
 
 
+// Remembers the page table entries the most recent link was made from, so
+// the link can be kept on a CR3 reload if the new page directory maps the
+// page through the same entries
+static void remember_link_source(const X86PageEntry& table, const X86PageEntry& entry)
+{
+	assert(paging.links.used > 0);
+	const auto index = paging.links.used - 1;
+
+	paging.links.dir_entries[index]   = table.get();
+	paging.links.table_entries[index] = entry.get();
+}
+
 class InitPageHandler final : public PageHandler {
 public:
 	InitPageHandler() {
@@ -488,13 +538,16 @@ public:
 				// if reading we could link the page as read-only to later cacth writes,
 				// will slow down pretty much but allows catching all dirty events
 				PAGING_LinkPage(lin_page,phys_page);
+				remember_link_source(table, entry);
 			} else {
 				if (priv_check==1) {
 					PAGING_LinkPage(lin_page,phys_page);
+					remember_link_source(table, entry);
 					return 1;
 				} else if (writing) {
 					PageHandler * handler=MEM_GetPageHandler(phys_page);
 					PAGING_LinkPage(lin_page,phys_page);
+					remember_link_source(table, entry);
 					if (!(handler->flags & PFLAG_READABLE)) return 1;
 					if (!(handler->flags & PFLAG_WRITEABLE)) return 1;
 					if (get_tlb_read(lin_addr)!=get_tlb_write(lin_addr)) return 1;
@@ -502,6 +555,7 @@ public:
 					else return 1;
 				} else {
 					PAGING_LinkPage_ReadOnly(lin_page,phys_page);
+					remember_link_source(table, entry);
 				}
 			}
 		} else {
@@ -564,11 +618,13 @@ public:
 			}
 			phys_page = entry.base;
 			// maybe use read-only page here if possible
+			PAGING_LinkPage(lin_page,phys_page);
+			remember_link_source(table, entry);
 		} else {
 			if (lin_page<LINK_START) phys_page=paging.firstmb[lin_page];
 			else phys_page=lin_page;
+			PAGING_LinkPage(lin_page,phys_page);
 		}
-		PAGING_LinkPage(lin_page,phys_page);
 	}
 };
 
@@ -664,6 +720,7 @@ public:
 			}
 			phys_page = entry.base;
 			PAGING_LinkPage(lin_page,phys_page);
+			remember_link_source(table, entry);
 		} else {
 			if (lin_page<LINK_START) phys_page=paging.firstmb[lin_page];
 			else phys_page=lin_page;
@@ -694,6 +751,7 @@ public:
 				return 0;
 			}
 			PAGING_LinkPage(lin_page, entry.base);
+			remember_link_source(table, entry);
 		} else {
 			uint32_t phys_page;
 			if (lin_page<LINK_START) phys_page=paging.firstmb[lin_page];
@@ -723,11 +781,13 @@ public:
 				            entry.get());
 			}
 			phys_page = entry.base;
+			PAGING_LinkPage(lin_page,phys_page);
+			remember_link_source(table, entry);
 		} else {
 			if (lin_page<LINK_START) phys_page=paging.firstmb[lin_page];
 			else phys_page=lin_page;
+			PAGING_LinkPage(lin_page,phys_page);
 		}
-		PAGING_LinkPage(lin_page,phys_page);
 	}
 };
 
@@ -790,6 +850,8 @@ void PAGING_InitTLB()
 
 void PAGING_ClearTLB()
 {
+	++guest_stats.tlb_flushes;
+
 	uint32_t * entries=&paging.links.entries[0];
 	for (;paging.links.used>0;paging.links.used--) {
 		const auto page=*entries++;
@@ -841,6 +903,8 @@ void PAGING_LinkPage(uint32_t lin_page,uint32_t phys_page) {
 	if (handler->flags & PFLAG_WRITEABLE) paging.tlb.write[lin_page]=handler->GetHostWritePt(phys_page)-lin_base;
 	else paging.tlb.write[lin_page]=nullptr;
 
+	paging.links.dir_entries[paging.links.used]   = 0;
+	paging.links.table_entries[paging.links.used] = 0;
 	paging.links.entries[paging.links.used++]=lin_page;
 	paging.tlb.readhandler[lin_page]=handler;
 	paging.tlb.writehandler[lin_page]=handler;
@@ -863,6 +927,8 @@ void PAGING_LinkPage_ReadOnly(uint32_t lin_page,uint32_t phys_page) {
 	else paging.tlb.read[lin_page]=nullptr;
 	paging.tlb.write[lin_page]=nullptr;
 
+	paging.links.dir_entries[paging.links.used]   = 0;
+	paging.links.table_entries[paging.links.used] = 0;
 	paging.links.entries[paging.links.used++]=lin_page;
 	paging.tlb.readhandler[lin_page]=handler;
 	paging.tlb.writehandler[lin_page]=&init_page_handler_userro;
@@ -893,6 +959,8 @@ void PAGING_InitTLB()
 
 void PAGING_ClearTLB()
 {
+	++guest_stats.tlb_flushes;
+
 	uint32_t* entries = &paging.links.entries[0];
 	for (;paging.links.used>0;paging.links.used--) {
 		Bitu page=*entries++;
@@ -947,7 +1015,9 @@ void PAGING_LinkPage(uint32_t lin_page, uint32_t phys_page)
 	if (handler->flags & PFLAG_WRITEABLE) entry->write=handler->GetHostWritePt(phys_page)-lin_base;
 	else entry->write=0;
 
- 	paging.links.entries[paging.links.used++]=lin_page;
+	paging.links.dir_entries[paging.links.used]   = 0;
+	paging.links.table_entries[paging.links.used] = 0;
+	paging.links.entries[paging.links.used++]=lin_page;
 	entry->readhandler=handler;
 	entry->writehandler=handler;
 }
@@ -970,7 +1040,9 @@ void PAGING_LinkPage_ReadOnly(uint32_t lin_page, uint32_t phys_page)
 	else entry->read=0;
 	entry->write=0;
 
- 	paging.links.entries[paging.links.used++]=lin_page;
+	paging.links.dir_entries[paging.links.used]   = 0;
+	paging.links.table_entries[paging.links.used] = 0;
+	paging.links.entries[paging.links.used++]=lin_page;
 	entry->readhandler=handler;
 	entry->writehandler=&init_page_handler_userro;
 }
@@ -978,6 +1050,94 @@ void PAGING_LinkPage_ReadOnly(uint32_t lin_page, uint32_t phys_page)
 #endif
 
 
+void PAGING_InvalidatePage(Bitu lin_addr)
+{
+	PAGING_UnlinkPages(lin_addr >> 12, 1);
+}
+
+// Unlinks only the linear pages that translate into the given physical pages,
+// for when the host memory behind them moves but their handlers stay the
+// same. This keeps the rest of the TLB intact, unlike PAGING_ClearTLB.
+void PAGING_UnlinkPhysPages(const Bitu phys_page, const Bitu pages)
+{
+	auto& links = paging.links;
+
+	uint32_t num_kept = 0;
+	for (uint32_t i = 0; i < links.used; ++i) {
+		const auto lin_page = links.entries[i];
+		const auto lin_addr = lin_page << 12;
+
+		// A page can be listed more than once if it got unlinked and
+		// linked again in the meantime, so drop all of its links
+		if (get_tlb_readhandler(lin_addr) == &init_page_handler) {
+			continue;
+		}
+		const auto page = PAGING_GetPhysicalPage(lin_addr) >> 12;
+		if (page >= phys_page && page < phys_page + pages) {
+			PAGING_UnlinkPages(lin_page, 1);
+			continue;
+		}
+		links.entries[num_kept]       = lin_page;
+		links.dir_entries[num_kept]   = links.dir_entries[i];
+		links.table_entries[num_kept] = links.table_entries[i];
+		++num_kept;
+	}
+	links.used = num_kept;
+}
+
+// A CR3 reload invalidates all translations, but there's no need to redo the
+// ones the new page directory maps through the very same page directory and
+// table entries (accessed and dirty bits included). This keeps the pages
+// shared by all address spaces, such as the kernel's, linked across task
+// switches, and only unlinks the pages that actually differ.
+static void unlink_changed_translations()
+{
+	auto& links = paging.links;
+
+	uint32_t dir_index = UINT32_MAX;
+	uint32_t dir_entry = 0;
+
+	for (uint32_t i = 0; i < links.used; ++i) {
+		const auto lin_page = links.entries[i];
+
+		bool is_unchanged = false;
+		if (links.table_entries[i]) {
+			if ((lin_page >> 10) != dir_index) {
+				dir_index = lin_page >> 10;
+				dir_entry = phys_readd(paging.base.addr + dir_index * 4);
+			}
+			if (dir_entry == links.dir_entries[i]) {
+				X86PageEntry table;
+				table.set(dir_entry);
+				is_unchanged = phys_readd((table.base << 12) +
+				                          (lin_page & 0x3ff) * 4) ==
+				               links.table_entries[i];
+			}
+		}
+		if (!is_unchanged) {
+			links.table_entries[i] = 0;
+			PAGING_UnlinkPages(lin_page, 1);
+		}
+	}
+
+	// Drop the unlinked pages from the list. A page can be listed more
+	// than once if it got unlinked and linked again in the meantime; it's
+	// kept only if all of its links are unchanged.
+	uint32_t num_kept = 0;
+	for (uint32_t i = 0; i < links.used; ++i) {
+		const auto lin_page = links.entries[i];
+		if (!links.table_entries[i] ||
+		    get_tlb_readhandler(lin_page << 12) == &init_page_handler) {
+			continue;
+		}
+		links.entries[num_kept]       = lin_page;
+		links.dir_entries[num_kept]   = links.dir_entries[i];
+		links.table_entries[num_kept] = links.table_entries[i];
+		++num_kept;
+	}
+	links.used = num_kept;
+}
+
 void PAGING_SetDirBase(Bitu cr3) {
 	assert(cr3 <= UINT32_MAX);
 	paging.cr3=static_cast<uint32_t>(cr3);
@@ -986,7 +1146,7 @@ void PAGING_SetDirBase(Bitu cr3) {
 	paging.base.addr=static_cast<PhysPt>(cr3 & ~4095);
 //	LOG(LOG_PAGING,LOG_NORMAL)("CR3:%X Base %X",cr3,paging.base.page);
 	if (paging.enabled) {
-		PAGING_ClearTLB();
+		unlink_changed_translations();
 	}
 }
 
@@ -0,0 +1,84 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_CPU_TRACE_FORMAT_H
+#define DOSBOX_CPU_TRACE_FORMAT_H
+
+#include <cstdint>
+
+// Binary CPU trace format
+// ~~~~~~~~~~~~~~~~~~~~~~~
+// The heavy debugger's TRACE command records every executed instruction into
+// a ring buffer of these fixed-size records, without disassembling anything,
+// and writes the buffer to LOGCPU.BIN when the trace stops. The file is a
+// header followed by the records, oldest first, in the byte order of the
+// host that wrote it. contrib/decode_cpu_trace turns it into text.
+//
+// This header is shared with the decoder, so it must not depend on anything
+// else in the tree.
+
+namespace CpuTrace {
+
+constexpr char Magic[8] = {'D', 'B', 'X', 'T', 'R', 'A', 'C', 'E'};
+
+constexpr uint32_t Version = 1;
+
+constexpr auto NumCodeBytes = 11;
+
+struct FileHeader {
+	char magic[8]        = {};
+	uint32_t version     = 0;
+	uint32_t record_size = 0;
+	uint64_t num_records = 0;
+};
+static_assert(sizeof(FileHeader) == 24);
+
+struct Record {
+	uint32_t eip = 0;
+	uint16_t cs  = 0;
+	uint16_t ss  = 0;
+	uint16_t ds  = 0;
+	uint16_t es  = 0;
+	uint16_t fs  = 0;
+	uint16_t gs  = 0;
+
+	uint32_t eax = 0;
+	uint32_t ebx = 0;
+	uint32_t ecx = 0;
+	uint32_t edx = 0;
+	uint32_t esi = 0;
+	uint32_t edi = 0;
+	uint32_t ebp = 0;
+	uint32_t esp = 0;
+
+	uint32_t flags = 0;
+
+	// Non-zero if the code segment is 32-bit
+	uint8_t is_code_32bit = 0;
+
+	// The bytes at CS:EIP, enough for all but the longest instructions;
+	// zeroed from the first byte that couldn't be read
+	uint8_t code[NumCodeBytes] = {};
+};
+static_assert(sizeof(Record) == 64);
+
+} // namespace CpuTrace
+
+#endif
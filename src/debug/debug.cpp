@@ -21,11 +21,15 @@
 
 #if C_DEBUG
 
+#include <algorithm>
 #include <cctype>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
+#include <iterator>
 #include <list>
+#include <map>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -47,6 +51,7 @@
 #include "shell.h"
 #include "programs.h"
 #include "debug_inc.h"
+#include "cpu_trace_format.h"
 #include "../cpu/lazyflags.h"
 #include "keyboard.h"
 #include "setup.h"
@@ -106,6 +111,16 @@ static int		cpuLogCounter	= 0;
 static int		cpuLogType		= 1;	// log detail
 static bool zeroProtect = false;
 bool	logHeavy	= false;
+
+// The binary trace's ring buffer, allocated while tracing
+static std::vector<CpuTrace::Record> cpu_trace = {};
+static size_t cpu_trace_next  = 0;
+static bool cpu_trace_wrapped = false;
+
+constexpr size_t DefaultCpuTraceRecords = 1024 * 1024;
+
+static void start_cpu_trace(size_t num_records);
+static void write_cpu_trace();
 #endif
 
 static struct  {
@@ -360,8 +375,19 @@ public:
 	static void				DeleteAll			(void);
 	static void				ShowList			(void);
 
+	// Called by the watched pages' handler after each write to them
+	static void CheckWatchedPage(Bitu phys_page);
+
 
 private:
+	bool IsMemoryChangeBreakpoint() const noexcept
+	{
+		return type == BKPNT_MEMORY || type == BKPNT_MEMORY_PROT ||
+		       type == BKPNT_MEMORY_LINEAR;
+	}
+	void StartWatching();
+	void StopWatching();
+
 	EBreakpoint type = {};
 	// Physical
 	PhysPt location  = 0;
@@ -372,6 +398,9 @@ private:
 	uint8_t intNr    = 0;
 	uint16_t ahValue = 0;
 	uint16_t alValue = 0;
+	// Memory change
+	PhysPt watched_address = 0;
+	bool is_watching       = false;
 	// Shared
 	bool active = 0;
 	bool once   = 0;
@@ -425,12 +454,180 @@ void CBreakpoint::Activate(bool _active)
 		}
 	}
 #endif
+	if (IsMemoryChangeBreakpoint()) {
+		// The address is looked up again on every activation, as the
+		// segments and page tables might have changed in the meantime
+		StopWatching();
+		if (_active) {
+			StartWatching();
+		}
+	}
 	active = _active;
 }
 
 // Statics
 static std::list<CBreakpoint *> BPoints = {};
 
+// Memory change breakpoints
+// ~~~~~~~~~~~~~~~~~~~~~~~~~
+// The pages with memory change breakpoints get a handler without direct write
+// access, so only the writes to these pages go through the handler, which
+// checks the breakpoints after each write. All the other memory keeps its
+// direct host accesses through the TLB, and runs at full speed.
+//
+// Only plain RAM pages can be watched. The handler is flagged as holding no
+// code, so the dynamic cores don't replace it with their own handler; the
+// code on watched pages runs on the normal core instead.
+class WatchPageHandler final : public PageHandler {
+public:
+	WatchPageHandler(PageHandler* ram_handler, const Bitu page)
+	        : original(ram_handler),
+	          phys_page(page)
+	{
+		flags = PFLAG_READABLE | PFLAG_NOCODE;
+	}
+
+	HostPt GetHostReadPt(Bitu page) override
+	{
+		return original->GetHostReadPt(page);
+	}
+
+	void writeb(PhysPt addr, uint8_t val) override
+	{
+		host_writeb(Target(addr), val);
+		CBreakpoint::CheckWatchedPage(phys_page);
+	}
+	void writew(PhysPt addr, uint16_t val) override
+	{
+		host_writew(Target(addr), val);
+		CBreakpoint::CheckWatchedPage(phys_page);
+	}
+	void writed(PhysPt addr, uint32_t val) override
+	{
+		host_writed(Target(addr), val);
+		CBreakpoint::CheckWatchedPage(phys_page);
+	}
+	void writeq(PhysPt addr, uint64_t val) override
+	{
+		host_writeq(Target(addr), val);
+		CBreakpoint::CheckWatchedPage(phys_page);
+	}
+
+	PageHandler* const original;
+	const Bitu phys_page;
+	int num_watches = 0;
+
+private:
+	// Multi-byte writes crossing the end of the page are split into byte
+	// writes by the callers
+	HostPt Target(const PhysPt addr)
+	{
+		return original->GetHostWritePt(phys_page) + (addr & (MEM_PAGE_SIZE - 1));
+	}
+};
+
+// Kept for the whole run: a handler can remove itself while it's running
+static std::map<Bitu, std::unique_ptr<WatchPageHandler>> watch_handlers = {};
+
+void CBreakpoint::StartWatching()
+{
+	assert(!is_watching);
+
+	// Protected mode memory is only watched in protected mode
+	if (type == BKPNT_MEMORY_PROT) {
+		Descriptor desc;
+		if (!cpu.pmode || !cpu.gdt.GetDescriptor(segment, desc) ||
+		    desc.GetLimit() == 0) {
+			return;
+		}
+	}
+	const PhysPt address = (type == BKPNT_MEMORY_LINEAR)
+	                             ? offset
+	                             : GetAddress(segment, offset);
+
+	// Also links the page in the TLB, for the physical address lookup
+	uint8_t current_value = 0;
+	if (mem_readb_checked(address, &current_value)) {
+		return;
+	}
+	const auto phys_address = PAGING_GetPhysicalAddress(address);
+	const auto phys_page    = phys_address / MEM_PAGE_SIZE;
+
+	auto& handler = watch_handlers[phys_page];
+	const auto current_handler = MEM_GetPageHandler(phys_page);
+
+	if (!handler || current_handler != handler.get()) {
+		constexpr auto RamFlags = PFLAG_READABLE | PFLAG_WRITEABLE;
+		if (phys_page >= MEM_TotalPages() || current_handler->flags != RamFlags) {
+			DEBUG_ShowMsg("DEBUG: Can't watch memory at %08X, it isn't plain RAM\n",
+			              phys_address);
+			return;
+		}
+		handler = std::make_unique<WatchPageHandler>(current_handler, phys_page);
+	}
+	if (handler->num_watches++ == 0) {
+		MEM_SetPageHandler(phys_page, 1, handler.get());
+		PAGING_ClearTLB();
+	}
+
+	watched_address = phys_address;
+	is_watching     = true;
+
+	// Only changes from now on count
+	SetValue(current_value);
+}
+
+void CBreakpoint::StopWatching()
+{
+	if (!is_watching) {
+		return;
+	}
+	is_watching = false;
+
+	const auto phys_page = watched_address / MEM_PAGE_SIZE;
+	const auto& handler  = watch_handlers[phys_page];
+	assert(handler && handler->num_watches > 0);
+
+	// Leave the page alone if it got a different handler in the meantime
+	if (--handler->num_watches == 0 && MEM_GetPageHandler(phys_page) == handler.get()) {
+		MEM_SetPageHandler(phys_page, 1, handler->original);
+		PAGING_ClearTLB();
+	}
+}
+
+void CBreakpoint::CheckWatchedPage(const Bitu phys_page)
+{
+	const auto& handler = watch_handlers[phys_page];
+	assert(handler);
+	const auto page_data = handler->original->GetHostReadPt(phys_page);
+
+	bool is_hit = false;
+	for (auto bp : BPoints) {
+		if (!bp->is_watching || bp->watched_address / MEM_PAGE_SIZE != phys_page) {
+			continue;
+		}
+		const auto value = host_readb(page_data +
+		                              (bp->watched_address & (MEM_PAGE_SIZE - 1)));
+		if (value == bp->GetValue()) {
+			continue;
+		}
+		DEBUG_ShowMsg("DEBUG: Memory breakpoint %s: %04X:%04X - %02X -> %02X\n",
+		              (bp->GetType() == BKPNT_MEMORY_PROT) ? "(Prot)" : "",
+		              bp->GetSegment(),
+		              bp->GetOffset(),
+		              bp->GetValue(),
+		              value);
+		bp->SetValue(value);
+		is_hit = true;
+	}
+
+	// Stops after the instruction that made the change
+	if (is_hit) {
+		DeactivateBreakpoints();
+		DEBUG_EnableDebugger();
+	}
+}
+
 #if C_HEAVY_DEBUG
 template <typename T>
 void DEBUG_UpdateMemoryReadBreakpoints(const PhysPt addr)
@@ -545,31 +742,9 @@ bool CBreakpoint::CheckBreakpoint(Bitu seg, Bitu off)
 			return true;
 		}
 #if C_HEAVY_DEBUG
-		// Memory breakpoint support
+		// Memory read breakpoint support
 		else if (bp->IsActive()) {
-			if ((bp->GetType()==BKPNT_MEMORY) || (bp->GetType()==BKPNT_MEMORY_PROT) || (bp->GetType()==BKPNT_MEMORY_LINEAR)) {
-				// Watch Protected Mode Memoryonly in pmode
-				if (bp->GetType()==BKPNT_MEMORY_PROT) {
-					// Check if pmode is active
-					if (!cpu.pmode) return false;
-					// Check if descriptor is valid
-					Descriptor desc;
-					if (!cpu.gdt.GetDescriptor(bp->GetSegment(),desc)) return false;
-					if (desc.GetLimit()==0) return false;
-				}
-
-				Bitu address; 
-				if (bp->GetType()==BKPNT_MEMORY_LINEAR) address = bp->GetOffset();
-				else address = GetAddress(bp->GetSegment(),bp->GetOffset());
-				uint8_t value=0;
-				if (mem_readb_checked(address,&value)) return false;
-				if (bp->GetValue() != value) {
-					// Yup, memory value changed
-					DEBUG_ShowMsg("DEBUG: Memory breakpoint %s: %04X:%04X - %02X -> %02X\n",(bp->GetType()==BKPNT_MEMORY_PROT)?"(Prot)":"",bp->GetSegment(),bp->GetOffset(),bp->GetValue(),value);
-					bp->SetValue(value);
-					return true;
-				}
-			} else if (bp->GetType() == BKPNT_MEMORY_READ) {
+			if (bp->GetType() == BKPNT_MEMORY_READ) {
 				if (bp->WasMemoryRead()) {
 					// Yup, memory value was read
 					DEBUG_ShowMsg("DEBUG: Memory read breakpoint: %04X:%04X\n",
@@ -1184,8 +1359,6 @@ bool ParseCommand(char* str) {
 		return true;
 	}
 
-#if C_HEAVY_DEBUG
-
 	if (command == "BPM") { // Add new breakpoint
 		uint16_t seg = (uint16_t)GetHexValue(found,found);found++; // skip ":"
 		uint32_t ofs = GetHexValue(found,found);
@@ -1194,19 +1367,6 @@ bool ParseCommand(char* str) {
 		return true;
 	}
 
-	if (command == "BPMR") { // Add new breakpoint
-		uint16_t seg = (uint16_t)GetHexValue(found, found);
-		found++; // skip ":"
-		uint32_t ofs    = GetHexValue(found, found);
-		CBreakpoint* bp = CBreakpoint::AddMemBreakpoint(seg, ofs);
-		bp->SetType(BKPNT_MEMORY_READ);
-		bp->FlagMemoryAsUnread();
-		DEBUG_ShowMsg("DEBUG: Set memory read breakpoint at %04X:%04X\n",
-		              seg,
-		              ofs);
-		return true;
-	}
-
 	if (command == "BPPM") { // Add new breakpoint
 		uint16_t seg = (uint16_t)GetHexValue(found,found);found++; // skip ":"
 		uint32_t ofs = GetHexValue(found,found);
@@ -1226,6 +1386,19 @@ bool ParseCommand(char* str) {
 		return true;
 	}
 
+#if C_HEAVY_DEBUG
+	if (command == "BPMR") { // Add new breakpoint
+		uint16_t seg = (uint16_t)GetHexValue(found, found);
+		found++; // skip ":"
+		uint32_t ofs    = GetHexValue(found, found);
+		CBreakpoint* bp = CBreakpoint::AddMemBreakpoint(seg, ofs);
+		bp->SetType(BKPNT_MEMORY_READ);
+		bp->FlagMemoryAsUnread();
+		DEBUG_ShowMsg("DEBUG: Set memory read breakpoint at %04X:%04X\n",
+		              seg,
+		              ofs);
+		return true;
+	}
 #endif
 
 	if (command == "BPINT") { // Add Interrupt Breakpoint
@@ -1412,6 +1585,17 @@ bool ParseCommand(char* str) {
 		return true;
 	}
 
+	if (command == "TRACE") { // Toggle the binary cpu trace
+		if (cpu_trace.empty()) {
+			const auto num_records = GetHexValue(found, found);
+			start_cpu_trace(num_records ? num_records
+			                            : DefaultCpuTraceRecords);
+		} else {
+			write_cpu_trace();
+		}
+		return true;
+	}
+
 	if (command == "ZEROPROTECT") { //toggle zero protection
 		zeroProtect = !zeroProtect;
 		DEBUG_ShowMsg("DEBUG: Zero code execution protection %s.\n",zeroProtect?"on":"off");
@@ -1426,12 +1610,12 @@ bool ParseCommand(char* str) {
 		DEBUG_ShowMsg("BPINT  [intNr] *          - Set interrupt breakpoint.\n");
 		DEBUG_ShowMsg("BPINT  [intNr] [ah] *     - Set interrupt breakpoint with ah.\n");
 		DEBUG_ShowMsg("BPINT  [intNr] [ah] [al]  - Set interrupt breakpoint with ah and al.\n");
-#if C_HEAVY_DEBUG
 		DEBUG_ShowMsg("BPM    [segment]:[offset] - Set memory breakpoint (memory change).\n");
+#if C_HEAVY_DEBUG
 		DEBUG_ShowMsg("BPMR   [segment]:[offset] - Set memory breakpoint (memory read).\n");
+#endif
 		DEBUG_ShowMsg("BPPM   [selector]:[offset]- Set pmode-memory breakpoint (memory change).\n");
 		DEBUG_ShowMsg("BPLM   [linear address]   - Set linear memory breakpoint (memory change).\n");
-#endif
 		DEBUG_ShowMsg("BPLIST                    - List breakpoints.\n");
 		DEBUG_ShowMsg("BPDEL  [bpNr] / *         - Delete breakpoint nr / all.\n");
 		DEBUG_ShowMsg("C / D  [segment]:[offset] - Set code / data view address.\n");
@@ -1441,6 +1625,7 @@ bool ParseCommand(char* str) {
 		DEBUG_ShowMsg("LOG [num]                 - Write cpu log file.\n");
 		DEBUG_ShowMsg("LOGS/LOGL/LOGC [num]      - Write short/long/cs:ip-only cpu log file.\n");
 		DEBUG_ShowMsg("HEAVYLOG                  - Enable/Disable automatic cpu log when DOSBox exits.\n");
+		DEBUG_ShowMsg("TRACE [num]               - Start/Stop the binary cpu trace of the last num instructions.\n");
 		DEBUG_ShowMsg("ZEROPROTECT               - Enable/Disable zero code execution detection.\n");
 #endif
 		DEBUG_ShowMsg("SR [reg] [value]          - Set register value.\n");
@@ -2695,8 +2880,105 @@ void DEBUG_HeavyLogInstruction()
 	if (++logCount >= LOGCPUMAX) logCount = 0;
 }
 
+// The binary trace only copies the registers and code bytes. The
+// disassembly is left to contrib/decode_cpu_trace, so tracing runs at close
+// to the full speed of the heavy debug build.
+static void start_cpu_trace(const size_t num_records)
+{
+	cpu_trace.assign(num_records, {});
+	cpu_trace_next    = 0;
+	cpu_trace_wrapped = false;
+
+	DEBUG_ShowMsg("DEBUG: Binary cpu trace of the last %zu instructions started.\n",
+	              num_records);
+}
+
+static void trace_instruction()
+{
+	auto& record = cpu_trace[cpu_trace_next];
+
+	record.eip = reg_eip;
+	record.cs  = SegValue(cs);
+	record.ss  = SegValue(ss);
+	record.ds  = SegValue(ds);
+	record.es  = SegValue(es);
+	record.fs  = SegValue(fs);
+	record.gs  = SegValue(gs);
+
+	record.eax = reg_eax;
+	record.ebx = reg_ebx;
+	record.ecx = reg_ecx;
+	record.edx = reg_edx;
+	record.esi = reg_esi;
+	record.edi = reg_edi;
+	record.ebp = reg_ebp;
+	record.esp = reg_esp;
+
+	FillFlags();
+	record.flags = static_cast<uint32_t>(reg_flags);
+
+	record.is_code_32bit = cpu.code.big ? 1 : 0;
+
+	const auto start = GetAddress(SegValue(cs), reg_eip);
+	for (uint32_t i = 0; i < CpuTrace::NumCodeBytes; ++i) {
+		if (mem_readb_checked(start + i, &record.code[i])) {
+			std::fill(record.code + i, std::end(record.code), 0);
+			break;
+		}
+	}
+
+	if (++cpu_trace_next == cpu_trace.size()) {
+		cpu_trace_next    = 0;
+		cpu_trace_wrapped = true;
+	}
+}
+
+static void write_cpu_trace()
+{
+	const std_fs::path log_cpu_bin = "LOGCPU.BIN";
+
+	std::ofstream out(log_cpu_bin, std::ios::binary);
+	if (!out.is_open()) {
+		DEBUG_ShowMsg("DEBUG: Binary cpu trace file couldn't be created.\n");
+	} else {
+		CpuTrace::FileHeader header = {};
+		std::copy(std::begin(CpuTrace::Magic),
+		          std::end(CpuTrace::Magic),
+		          header.magic);
+		header.version     = CpuTrace::Version;
+		header.record_size = sizeof(CpuTrace::Record);
+		header.num_records = cpu_trace_wrapped ? cpu_trace.size()
+		                                       : cpu_trace_next;
+
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		// Oldest first: the older part is past the write position once the
+		// buffer has wrapped around
+		auto write_records = [&](const size_t first, const size_t last) {
+			out.write(reinterpret_cast<const char*>(cpu_trace.data() + first),
+			          static_cast<std::streamsize>(
+			                  (last - first) * sizeof(CpuTrace::Record)));
+		};
+		if (cpu_trace_wrapped) {
+			write_records(cpu_trace_next, cpu_trace.size());
+		}
+		write_records(0, cpu_trace_next);
+
+		DEBUG_ShowMsg("DEBUG: Binary cpu trace of %llu instructions written to '%s'.\n",
+		              static_cast<unsigned long long>(header.num_records),
+		              std_fs::absolute(log_cpu_bin).string().c_str());
+	}
+
+	cpu_trace.clear();
+	cpu_trace.shrink_to_fit();
+}
+
 void DEBUG_HeavyWriteLogInstruction()
 {
+	if (!cpu_trace.empty()) {
+		write_cpu_trace();
+	}
+
 	if (!logHeavy) return;
 	logHeavy = false;
 
@@ -2754,6 +3036,9 @@ bool DEBUG_HeavyIsBreakpoint(void) {
 	}
 	// LogInstruction
 	if (logHeavy) DEBUG_HeavyLogInstruction();
+	if (!cpu_trace.empty()) {
+		trace_instruction();
+	}
 	if (zeroProtect) {
 		uint32_t value = 0;
 		if (!mem_readd_checked(SegPhys(cs)+reg_eip,&value)) {
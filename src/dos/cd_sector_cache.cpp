@@ -0,0 +1,59 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "cd_sector_cache.h"
+
+#include <algorithm>
+
+CdSectorCache::CdSectorCache(const size_t _max_sectors)
+        : SectorCache(_max_sectors, SectorSize)
+{}
+
+void CdSectorCache::Clear()
+{
+	SectorCache::Clear();
+
+	next_sector   = std::numeric_limits<uint32_t>::max();
+	read_ahead    = 0;
+	is_sequential = false;
+}
+
+void CdSectorCache::NoteRequest(const uint32_t sector)
+{
+	is_sequential = (sector == next_sector);
+	if (!is_sequential) {
+		read_ahead = 0;
+	}
+	next_sector = sector + 1;
+}
+
+uint32_t CdSectorCache::GetReadAheadOnMiss()
+{
+	if (!IsEnabled() || !is_sequential) {
+		return 0;
+	}
+	// Small caches only read ahead by half their size, so the sectors read
+	// ahead don't evict each other
+	const auto limit = static_cast<uint32_t>(
+	        std::min(static_cast<size_t>(MaxReadAhead), GetMaxSectors() / 2));
+
+	read_ahead = std::min(std::max(read_ahead * 2, MinReadAhead), limit);
+	return read_ahead;
+}
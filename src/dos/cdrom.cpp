@@ -18,6 +18,8 @@
 
 #include "cdrom.h"
 
+#include <algorithm>
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -26,12 +28,26 @@
 #include "channel_names.h"
 #include "dosbox.h"
 #include "pic.h"
+#include "setup.h"
 #include "string_utils.h"
 
 namespace CDROM {
 std::array<std::unique_ptr<CDROM_Interface>, MaxNumDosDriveLetters> cdroms;
 }
 
+size_t CDROM_GetSectorCacheSize()
+{
+	constexpr auto DefaultNumSectors = 1024;
+
+	const auto section = control ? static_cast<Section_prop*>(
+	                                       control->GetSection("dos"))
+	                             : nullptr;
+	if (!section) {
+		return DefaultNumSectors;
+	}
+	return static_cast<size_t>(std::max(section->Get_int("cdrom_sector_cache"), 0));
+}
+
 // ******************************************************
 // Fake CDROM
 // ******************************************************
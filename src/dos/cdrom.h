@@ -24,19 +24,27 @@
 
 #include "dosbox.h"
 
+#include <condition_variable>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "cd_sector_cache.h"
+#include "chd_image.h"
 #include "support.h"
 #include "mem.h"
 #include "mixer.h"
 #include "rwqueue.h"
+#include "std_filesystem.h"
 
 #include "decoders/SDL_sound.h"
 
@@ -129,6 +137,10 @@ namespace CDROM {
 extern std::array<std::unique_ptr<CDROM_Interface>, MaxNumDosDriveLetters> cdroms;
 }
 
+// The number of data sectors that images and physical drives cache, from the
+// 'cdrom_sector_cache' setting
+size_t CDROM_GetSectorCacheSize();
+
 class CDROM_Interface_Fake final : public CDROM_Interface {
 public:
 	bool SetDevice([[maybe_unused]] const char* path) override
@@ -223,6 +235,10 @@ private:
 		virtual int getLength()                     = 0;
 		virtual void setAudioPosition(uint32_t pos) = 0;
 		const uint16_t chunkSize                    = 0;
+
+		// Serialises the decoder thread's access with the sector reads
+		// on the emulation thread
+		std::mutex mutex = {};
 	};
 
 	class BinaryFile final : public TrackFile {
@@ -261,7 +277,17 @@ private:
 
 	class AudioFile final : public TrackFile {
 	public:
+		// The properties of an opened file; when they're known
+		// beforehand, the file is only opened on its first read
+		struct Properties {
+			int length       = 0;
+			uint32_t rate    = 0;
+			uint16_t format  = 0;
+			uint8_t channels = 0;
+		};
+
 		AudioFile(const char* filename, bool& error);
+		AudioFile(const std::string& filename, const Properties& properties);
 		~AudioFile() override;
 
 		AudioFile()                 = delete;
@@ -282,8 +308,60 @@ private:
 		// areas of this class.
 		void setAudioPosition([[maybe_unused]] uint32_t pos) override {}
 
+		Properties getProperties();
+
+	private:
+		bool openSample();
+
+		Sound_Sample* sample                 = nullptr;
+		std::string filename                 = {};
+		std::optional<Properties> properties = {};
+	};
+
+	// A track of a CHD image, presented like the track's data in a BIN
+	// file: the sector data of its frames, without their subcode
+	class ChdFile final : public TrackFile {
+	public:
+		ChdFile(const std::shared_ptr<ChdImage>& image,
+		        uint32_t first_frame, uint32_t num_frames,
+		        uint16_t sector_size, bool is_audio);
+
+		ChdFile()               = delete;
+		ChdFile(const ChdFile&) = delete; // prevent copying
+		ChdFile& operator=(const ChdFile&) = delete; // prevent
+		                                             // assignment
+
+		bool read(uint8_t* buffer, const uint32_t offset,
+		          const uint32_t requested_bytes) override;
+		bool seek(const uint32_t offset) override;
+		uint32_t decode(int16_t* buffer,
+		                const uint32_t desired_track_frames) override;
+		uint16_t getEndian() override;
+		uint32_t getRate() override
+		{
+			return 44100;
+		}
+		uint8_t getChannels() override
+		{
+			return 2;
+		}
+		int getLength() override
+		{
+			return length_redbook_bytes;
+		}
+		void setAudioPosition(uint32_t pos) override
+		{
+			audio_pos = pos;
+		}
+
 	private:
-		Sound_Sample* sample = nullptr;
+		bool readFrames(uint8_t* buffer, uint32_t offset,
+		                uint32_t num_bytes);
+
+		std::shared_ptr<ChdImage> image = nullptr;
+		uint32_t first_frame            = 0;
+		uint16_t sector_size            = 0;
+		bool is_audio                   = false;
 	};
 
 public:
@@ -341,32 +419,97 @@ private:
 		uint32_t totalTrackFrames   = 0;
 		uint32_t startSector        = 0;
 		uint32_t totalRedbookFrames = 0;
-		bool isPlaying              = false;
-		bool isPaused               = false;
-
-		// TODO `MixerBufferByteSize` is hardcoded to 1024 * 16 bytes,
-		// so this buffer has been 32k long for a while now. There's
-		// potential for buffer overflows, though; the code that writes
-		// to the buffer asserts the max length of the writes, but
-		// allows lengths far greater than the 32k limit. So it kinda
-		// works, but by fluke.
-		//
-		// Probably the safest way going forward is to turn this into a
-		// `std::vector` and size it as needed at runtime.
-		//
-		int16_t buffer[MixerBufferByteSize * 2] = {};
+		// Counts the playback requests, to tell apart the decoded
+		// blocks of the current request from the ones before it
+		uint32_t generation = 0;
+		bool isPlaying      = false;
+		bool isPaused       = false;
+
+		// Played when the decoder thread falls behind
+		const std::vector<int16_t> silence = std::vector<int16_t>(
+		        MixerBufferByteSize * REDBOOK_CHANNELS);
 	} player;
 
+	// A run of frames decoded from the playing track, in the track's
+	// sample format and number of channels
+	struct DecodedBlock {
+		std::vector<int16_t> samples = {};
+		uint32_t generation          = 0;
+		// Zero frames mark the end of the track
+		uint32_t num_frames = 0;
+		bool seek_failed    = false;
+	};
+
+	// Decodes the playing track ahead of the mixer on a worker thread, so
+	// slow codecs, seeks, and storage don't stall the audio callback
+	static constexpr uint32_t DecodedBlockFrames = 1024;
+	static constexpr size_t MaxDecodedBlocks     = 16; // ~370 ms at 44.1 kHz
+
+	static struct trackDecoder {
+		std::thread thread             = {};
+		std::mutex mutex               = {};
+		std::condition_variable waiter = {};
+		RWQueue<DecodedBlock> queue{MaxDecodedBlocks, RWQueueMode::LockFree};
+
+		// The latest playback request, guarded by the mutex
+		std::weak_ptr<TrackFile> trackFile = {};
+		uint32_t byteOffset                = 0;
+		uint32_t generation                = 0;
+		bool hasRequest                    = false;
+		bool shouldExit                    = false;
+
+		// The block being played, only used by the mixer callback
+		DecodedBlock block         = {};
+		uint32_t playedBlockFrames = 0;
+	} decoder;
+
+	// The parsed cue sheets, kept for the session so remounting them, such
+	// as when swapping the discs of a set, neither parses them nor opens
+	// their audio tracks' decoders again. The entries are only used while
+	// the cue sheet and its files are unchanged.
+	struct CachedFile {
+		std::string path                       = {};
+		std_fs::file_time_type last_write_time = {};
+		uintmax_t size                         = 0;
+		// Set for the audio files
+		std::optional<AudioFile::Properties> audio = {};
+
+		// Records the file's size and modification time
+		bool Stat();
+		bool IsUnchanged() const;
+	};
+
+	struct CachedCueSheet {
+		CachedFile cue                = {};
+		std::vector<CachedFile> files = {};
+		// The tracks, without their files, and their files' indexes
+		std::vector<Track> tracks       = {};
+		std::vector<size_t> track_files = {};
+		std::string mcn                 = {};
+	};
+
+	static std::map<std::string, CachedCueSheet> cueSheetCache;
+
 	// Private utility functions
+	bool  LoadChdFile(const char *filename);
 	bool  LoadIsoFile(const char *filename);
 	bool  CanReadPVD(TrackFile *file,
 	                 const uint16_t sectorSize,
 	                 const bool mode2);
 	std::vector<Track>::iterator GetTrack(const uint32_t sector);
+	bool ReadDataSectorsAhead(uint8_t* buffer, const Track& track,
+	                          const uint32_t sector, const uint32_t offset);
 	void CDAudioCallBack(uint16_t desired_frames);
+	static void RequestDecoding(const std::shared_ptr<TrackFile>& track_file,
+	                            const uint32_t byte_offset);
+	static void TrackDecoderLoop();
 
 	// Private functions for cue sheet processing
 	bool  LoadCueSheet(const char *cuefile);
+	bool  LoadCachedCueSheet(const char *cuefile);
+	void  CacheCueSheet(const char *cuefile,
+	                    std::vector<CachedFile> files,
+	                    const std::vector<std::shared_ptr<TrackFile>> &file_ptrs);
 	bool  GetRealFileName(std::string& filename, std::string& pathname);
 	bool  GetCueKeyword(std::string &keyword, std::istream &in);
 	bool  GetCueFrame(uint32_t &frames, std::istream &in);
@@ -379,6 +522,11 @@ private:
 	// member variables
 	std::vector<Track>   tracks;
 	std::vector<uint8_t> readBuffer;
+	std::vector<uint8_t> readAheadBuffer;
+	CdSectorCache        sectorCache;
+	// Serialises the sector reads, which the IDE emulation runs on a
+	// worker thread
+	std::mutex           sectorMutex;
 	std::string          mcn;
 	static int           refCount;
 };
@@ -442,7 +590,45 @@ private:
 	bool Open(const char* device_name);
 	std::vector<int16_t> ReadAudio(const uint32_t sector, const uint32_t frames_requested) override;
 
+	bool ReadCookedSectors(uint8_t* buffer, const uint32_t sector,
+	                       const uint32_t num);
+	void ReadAhead(const uint32_t next_sector);
+	void ClearSectorCache();
+	void StartReader();
+	void StopReader();
+	void ReaderLoop();
+
+	struct SectorRange {
+		uint32_t start = 0;
+		uint32_t end   = 0;
+
+		bool Contains(const uint32_t sector) const
+		{
+			return sector >= start && sector < end;
+		}
+	};
+
 	int cdrom_fd = -1;
+
+	// The cooked data sectors are cached like the images' ones. While
+	// programs read sequentially, the reader thread reads the following
+	// sectors into the cache, so the seeks and spin-ups of the drive don't
+	// stall the emulation.
+	CdSectorCache sector_cache{CDROM_GetSectorCacheSize()};
+
+	std::thread reader                    = {};
+	std::mutex reader_mutex               = {};
+	std::condition_variable reader_waiter = {};
+	std::optional<SectorRange> queued     = {};
+	SectorRange reading                   = {};
+	std::vector<uint8_t> reader_buffer    = {};
+
+	// Reads that finish after a disc change don't get cached
+	uint32_t media_generation = 0;
+
+	uint32_t next_request = 0;
+	uint32_t ahead_end    = 0;
+	bool should_stop      = false;
 };
 
 #elif defined(WIN32)
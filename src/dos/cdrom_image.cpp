@@ -23,6 +23,7 @@
 
 #include "cdrom.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cctype>
 #include <chrono>
@@ -44,6 +45,7 @@
 #include "channel_names.h"
 #include "drives.h"
 #include "fs_utils.h"
+#include "host_threads.h"
 #include "math_utils.h"
 #include "setup.h"
 #include "string_utils.h"
@@ -60,6 +62,8 @@ using tracks_size_t    = std::vector<CDROM_Interface_Image::Track>::size_type;
 // Ensure the maximum allowed redbook bytes stays within the API type sizes
 static_assert(MAX_REDBOOK_BYTES <= UINT32_MAX);
 
+static_assert(CdSectorCache::SectorSize == BYTES_PER_COOKED_REDBOOK_FRAME);
+
 // Report bad seeks that would go beyond the end of the track
 bool CDROM_Interface_Image::TrackFile::offsetInsideTrack(const uint32_t offset)
 {
@@ -129,6 +133,8 @@ bool CDROM_Interface_Image::BinaryFile::read(uint8_t *buffer,
 	if (adjusted_bytes == 0) // no work to do!
 		return true;
 
+	std::lock_guard<std::mutex> lock(mutex);
+
 	// Reposition if needed
 	if (!seek(offset))
 		return false;
@@ -219,14 +225,12 @@ uint32_t CDROM_Interface_Image::BinaryFile::decode(int16_t *buffer,
 	return ceil_udivide(bytes_read, BYTES_PER_REDBOOK_PCM_FRAME);
 }
 
-CDROM_Interface_Image::AudioFile::AudioFile(const char *filename, bool &error)
-	: TrackFile(4096)
+CDROM_Interface_Image::AudioFile::AudioFile(const char *_filename, bool &error)
+	: TrackFile(4096),
+	  filename(_filename)
 {
-	// Use the audio file's sample rate and number of channels as-is
-	Sound_AudioInfo desired = {AUDIO_S16, 0, 0};
-	sample = Sound_NewSampleFromFile(filename, &desired);
 	const std::string filename_only = get_basename(filename);
-	if (sample) {
+	if (openSample()) {
 		error = false;
 		LOG_MSG("CDROM: Loaded %s [%d Hz, %d-channel, %2.1f minutes]",
 		        filename_only.c_str(), getRate(), getChannels(),
@@ -237,6 +241,35 @@ CDROM_Interface_Image::AudioFile::AudioFile(const char *filename, bool &error)
 	}
 }
 
+CDROM_Interface_Image::AudioFile::AudioFile(const std::string &_filename,
+                                            const Properties &_properties)
+	: TrackFile(4096),
+	  filename(_filename),
+	  properties(_properties)
+{
+	length_redbook_bytes = _properties.length;
+}
+
+bool CDROM_Interface_Image::AudioFile::openSample()
+{
+	if (sample)
+		return true;
+
+	// Use the audio file's sample rate and number of channels as-is
+	Sound_AudioInfo desired = {AUDIO_S16, 0, 0};
+	sample = Sound_NewSampleFromFile(filename.c_str(), &desired);
+
+	if (!sample && properties)
+		LOG_MSG("CDROM: Failed opening CDDA track '%s'",
+		        get_basename(filename).c_str());
+	return sample != nullptr;
+}
+
+CDROM_Interface_Image::AudioFile::Properties CDROM_Interface_Image::AudioFile::getProperties()
+{
+	return {getLength(), getRate(), getEndian(), getChannels()};
+}
+
 CDROM_Interface_Image::AudioFile::~AudioFile()
 {
 	// Guard to prevent double-free or nullptr free
@@ -262,10 +295,9 @@ CDROM_Interface_Image::AudioFile::~AudioFile()
 bool CDROM_Interface_Image::AudioFile::seek(const uint32_t requested_pos)
 {
 	// Check for logic bugs and if the track is already positioned as requested
-	assertm(sample, "Audio sample needs to be valid, but is the nullptr");
 	assertm(requested_pos <= MAX_REDBOOK_BYTES, "Requested offset exceeds CDROM size");
 
-	if (!offsetInsideTrack(requested_pos))
+	if (!offsetInsideTrack(requested_pos) || !openSample())
 		return false;
 
 	if (audio_pos == requested_pos) {
@@ -325,7 +357,6 @@ bool CDROM_Interface_Image::AudioFile::read(uint8_t *buffer,
 {
 	// Guard again logic bugs and the no-op case
 	assertm(buffer != nullptr, "buffer needs to be allocated but is the nullptr");
-	assertm(sample != nullptr, "Audio sample needs to be valid, but is the nullptr");
 	assertm(requested_pos <= MAX_REDBOOK_BYTES, "Requested offset exceeds CDROM size");
 	assertm(requested_bytes <= MAX_REDBOOK_BYTES,
 	        "Requested bytes exceeds CDROM size");
@@ -348,6 +379,8 @@ bool CDROM_Interface_Image::AudioFile::read(uint8_t *buffer,
 		return false; // we always correctly return false to the application in this case.
 	}
 
+	std::lock_guard<std::mutex> lock(mutex);
+
 	if (!seek(requested_pos))
 		return false;
 
@@ -430,6 +463,7 @@ uint32_t CDROM_Interface_Image::AudioFile::decode(int16_t *buffer,
 {
 	assertm(audio_pos < MAX_REDBOOK_BYTES,
 	        "Tried to decode audio before the playback position was set");
+	assertm(sample, "Tried to decode audio before seeking to the position");
 
 	// Sound_Decode_Direct returns frames (agnostic of bitrate and channels)
 	const uint32_t frames_decoded =
@@ -445,16 +479,22 @@ uint32_t CDROM_Interface_Image::AudioFile::decode(int16_t *buffer,
 
 uint16_t CDROM_Interface_Image::AudioFile::getEndian()
 {
+	if (properties)
+		return properties->format;
 	return sample ? sample->actual.format : AUDIO_S16SYS;
 }
 
 uint32_t CDROM_Interface_Image::AudioFile::getRate()
 {
+	if (properties)
+		return properties->rate;
 	return sample ? sample->actual.rate : 0;
 }
 
 uint8_t CDROM_Interface_Image::AudioFile::getChannels()
 {
+	if (properties)
+		return properties->channels;
 	return sample ? sample->actual.channels : 0;
 }
 
@@ -477,13 +517,110 @@ int CDROM_Interface_Image::AudioFile::getLength()
 	return length_redbook_bytes;
 }
 
+CDROM_Interface_Image::ChdFile::ChdFile(const std::shared_ptr<ChdImage>& _image,
+                                        const uint32_t _first_frame,
+                                        const uint32_t num_frames,
+                                        const uint16_t _sector_size,
+                                        const bool _is_audio)
+        : TrackFile(BYTES_PER_RAW_REDBOOK_FRAME),
+          image(_image),
+          first_frame(_first_frame),
+          sector_size(_sector_size),
+          is_audio(_is_audio)
+{
+	length_redbook_bytes = static_cast<int>(num_frames * sector_size);
+}
+
+// Reads the sector data spanning the byte range, frame by frame
+bool CDROM_Interface_Image::ChdFile::readFrames(uint8_t *buffer,
+                                                uint32_t offset,
+                                                uint32_t num_bytes)
+{
+	while (num_bytes > 0) {
+		const uint32_t frame = first_frame + offset / sector_size;
+		const uint32_t frame_offset = offset % sector_size;
+		const uint32_t chunk_bytes = std::min(num_bytes,
+		                                      sector_size - frame_offset);
+		if (!image->ReadFrame(frame, frame_offset, buffer, chunk_bytes))
+			return false;
+
+		buffer += chunk_bytes;
+		offset += chunk_bytes;
+		num_bytes -= chunk_bytes;
+	}
+	return true;
+}
+
+bool CDROM_Interface_Image::ChdFile::read(uint8_t *buffer,
+                                          const uint32_t offset,
+                                          const uint32_t requested_bytes)
+{
+	assertm(buffer, "The buffer pointer is invalid");
+
+	const uint32_t adjusted_bytes = adjustOverRead(offset, requested_bytes);
+	if (adjusted_bytes == 0) // no work to do!
+		return true;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (!readFrames(buffer, offset, adjusted_bytes))
+		return false;
+
+	// CHD images store the audio samples big endian, but reads return
+	// them like BIN files do
+	if (is_audio) {
+		for (uint32_t i = (offset & 1); i + 1 < adjusted_bytes; i += 2)
+			std::swap(buffer[i], buffer[i + 1]);
+	}
+	return true;
+}
+
+bool CDROM_Interface_Image::ChdFile::seek(const uint32_t offset)
+{
+	// The frames are read at absolute positions, so there's nothing to
+	// move
+	return offsetInsideTrack(offset);
+}
+
+uint32_t CDROM_Interface_Image::ChdFile::decode(int16_t *buffer,
+                                                const uint32_t desired_track_frames)
+{
+	assertm(buffer, "The buffer pointer is invalid");
+	assertm(audio_pos < MAX_REDBOOK_BYTES,
+	        "Tried to decode audio before the playback position was set");
+
+	const auto length = static_cast<uint32_t>(length_redbook_bytes);
+	if (audio_pos >= length)
+		return 0;
+
+	const uint32_t bytes = std::min(desired_track_frames * BYTES_PER_REDBOOK_PCM_FRAME,
+	                                length - audio_pos);
+	if (!readFrames(reinterpret_cast<uint8_t *>(buffer), audio_pos, bytes))
+		return 0;
+
+	// decoding is an audio-task, so update our audio position
+	audio_pos += bytes;
+
+	return ceil_udivide(bytes, BYTES_PER_REDBOOK_PCM_FRAME);
+}
+
+uint16_t CDROM_Interface_Image::ChdFile::getEndian()
+{
+	// The samples are played as they're stored
+	return AUDIO_S16MSB;
+}
+
 // initialize static members
 int CDROM_Interface_Image::refCount = 0;
 CDROM_Interface_Image::imagePlayer CDROM_Interface_Image::player;
+CDROM_Interface_Image::trackDecoder CDROM_Interface_Image::decoder;
+std::map<std::string, CDROM_Interface_Image::CachedCueSheet> CDROM_Interface_Image::cueSheetCache = {};
 
 CDROM_Interface_Image::CDROM_Interface_Image()
         : tracks{},
           readBuffer{},
+          readAheadBuffer{},
+          sectorCache(CDROM_GetSectorCacheSize()),
           mcn("")
 {
 	if (refCount == 0) {
@@ -498,6 +635,11 @@ CDROM_Interface_Image::CDROM_Interface_Image()
 			                                   ChannelFeature::DigitalAudio});
 
 			player.channel->Enable(false); // only enabled during playback periods
+
+			decoder.shouldExit = false;
+			decoder.thread = std::thread(&CDROM_Interface_Image::TrackDecoderLoop);
+			set_thread_name(decoder.thread, "dosbox:cdda");
+			HOST_THREADS_Apply(decoder.thread, HostThreadGroup::Audio);
 		}
 #ifdef DEBUG
 		LOG_MSG("CDROM: Initialised the %s audio channel", ChannelName::CdAudio);
@@ -519,6 +661,14 @@ CDROM_Interface_Image::~CDROM_Interface_Image()
 		}
 		MIXER_DeregisterChannel(player.channel);
 		player.channel.reset();
+
+		if (decoder.thread.joinable()) {
+			decoder.mutex.lock();
+			decoder.shouldExit = true;
+			decoder.mutex.unlock();
+			decoder.waiter.notify_all();
+			decoder.thread.join();
+		}
 	}
 	if (player.cd == this) {
 		player.cd = nullptr;
@@ -527,7 +677,8 @@ CDROM_Interface_Image::~CDROM_Interface_Image()
 
 bool CDROM_Interface_Image::SetDevice(const char* path)
 {
-	const bool result = LoadCueSheet(path) || LoadIsoFile(path);
+	const bool result = LoadChdFile(path) || LoadCueSheet(path) ||
+	                    LoadIsoFile(path);
 	if (!result) {
 		// print error message on dosbox console
 		char buf[MAX_LINE_LENGTH];
@@ -728,16 +879,10 @@ bool CDROM_Interface_Image::PlayAudioSector(uint32_t start, uint32_t len)
 	const auto sector_offset = start - track->start;
 	const auto byte_offset = track->skip + sector_offset * track->sectorSize;
 
-	// Guard: Bail if our track could not be seeked
-	if (!track_file->seek(byte_offset)) {
-		LOG_MSG("CDROM: Track %d failed to seek to byte %u, so cancelling playback",
-		        track->number, byte_offset);
-		StopAudio();
-		return false;
-	}
-
-	// We're performing an audio-task, so update the audio position
-	track_file->setAudioPosition(byte_offset);
+	// The decoder thread seeks the track and decodes it ahead of the
+	// mixer; if the seek fails, the callback cancels the playback
+	++player.generation;
+	RequestDecoding(track_file, byte_offset);
 
 	// Get properties about the current track
 	const uint8_t track_channels = track_file->getChannels();
@@ -823,6 +968,7 @@ bool CDROM_Interface_Image::StopAudio(void)
 	if (player.channel) {
 		player.channel->Enable(false);
 	}
+	RequestDecoding(nullptr, 0);
 #ifdef DEBUG
 	LOG_MSG("CDROM: StopAudio => stopped playback and halted the mixer");
 #endif
@@ -952,6 +1098,15 @@ track_iter CDROM_Interface_Image::GetTrack(const uint32_t sector)
 
 bool CDROM_Interface_Image::ReadSector(uint8_t *buffer, const bool raw, const uint32_t sector)
 {
+	std::lock_guard<std::mutex> lock(sectorMutex);
+
+	if (!raw && sectorCache.IsEnabled()) {
+		sectorCache.NoteRequest(sector);
+		if (sectorCache.Read(sector, buffer)) {
+			return true;
+		}
+	}
+
 	track_const_iter track = GetTrack(sector);
 
 	// Guard: Bail if the requested sector fell outside our tracks
@@ -982,7 +1137,56 @@ bool CDROM_Interface_Image::ReadSector(uint8_t *buffer, const bool raw, const ui
 	        length);
 #endif
 #endif
-	return track->file->read(buffer, offset, length);
+	// Only the data tracks' cooked sectors are cached
+	if (raw || !sectorCache.IsEnabled() || track->attr != 0x40) {
+		return track->file->read(buffer, offset, length);
+	}
+	if (ReadDataSectorsAhead(buffer, *track, sector, offset)) {
+		return true;
+	}
+	if (!track->file->read(buffer, offset, length)) {
+		return false;
+	}
+	sectorCache.Insert(sector, buffer);
+	return true;
+}
+
+// Reads a missed data sector together with the sectors following it in the
+// track, if the requests are sequential, caching them all
+bool CDROM_Interface_Image::ReadDataSectorsAhead(uint8_t* buffer,
+                                                 const Track& track,
+                                                 const uint32_t sector,
+                                                 const uint32_t offset)
+{
+	const auto track_end = track.start + track.length;
+	if (sector < track.start || sector >= track_end) {
+		return false;
+	}
+	const auto num_ahead = std::min(sectorCache.GetReadAheadOnMiss(),
+	                                track_end - sector - 1);
+	if (num_ahead == 0) {
+		return false;
+	}
+
+	// The sectors are contiguous in the track's file, so one read gets
+	// them all; the last one only needs its cooked data
+	const uint32_t num_bytes = num_ahead * track.sectorSize +
+	                           BYTES_PER_COOKED_REDBOOK_FRAME;
+	const auto file_length = track.file->getLength();
+	if (file_length < 0 || offset + num_bytes > static_cast<uint32_t>(file_length)) {
+		return false;
+	}
+	readAheadBuffer.resize(num_bytes);
+	if (!track.file->read(readAheadBuffer.data(), offset, num_bytes)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i <= num_ahead; ++i) {
+		sectorCache.Insert(sector + i,
+		                   readAheadBuffer.data() + i * track.sectorSize);
+	}
+	std::memcpy(buffer, readAheadBuffer.data(), BYTES_PER_COOKED_REDBOOK_FRAME);
+	return true;
 }
 
 bool CDROM_Interface_Image::ReadSectorsHost(void *buffer, bool raw, unsigned long sector, unsigned long num)
@@ -1021,45 +1225,253 @@ void CDROM_Interface_Image::CDAudioCallBack(uint16_t desired_track_frames)
 		return;
 	}
 
-	const auto decoded_track_frames = check_cast<uint16_t>(
-	        track_file->decode(player.buffer, desired_track_frames));
+	// The number of samples per frame the blocks were decoded with
+	const auto num_channels = track_file->getChannels();
+
+	auto frames_remaining = static_cast<uint32_t>(desired_track_frames);
+	while (frames_remaining > 0) {
+		auto& block = decoder.block;
 
-	if (!decoded_track_frames) {
-		// This particular CDDA track has come to an end, but the
-		// program has requested we continue playing for a longer
-		// period. So keep going!
-		const auto fraction_played = static_cast<double>(
-		                                     player.playedTrackFrames) /
-		                             player.totalTrackFrames;
+		// Fetch the next block of the current request, dropping the ones
+		// decoded before the last seek
+		if (block.generation != player.generation ||
+		    decoder.playedBlockFrames >= block.num_frames) {
+			if (decoder.queue.Size() == 0) {
+				break;
+			}
+			block = *decoder.queue.Dequeue();
+			decoder.playedBlockFrames = 0;
 
-		const auto played_redbook_frames = static_cast<uint32_t>(
-		        ceil(fraction_played * player.totalRedbookFrames));
+			if (block.generation != player.generation) {
+				continue;
+			}
+		}
 
-		const auto new_redbook_start_frame = player.startSector +
-		                                     played_redbook_frames;
+		if (block.seek_failed) {
+			LOG_MSG("CDROM: Track failed to seek to sector %u, so cancelling playback",
+			        player.startSector);
+			player.cd->StopAudio();
+			return;
+		}
 
-		const auto remaining_redbook_frames = player.totalRedbookFrames -
-		                                      played_redbook_frames;
+		if (block.num_frames == 0) {
+			// This particular CDDA track has come to an end, but the
+			// program has requested we continue playing for a longer
+			// period. So keep going!
+			const auto fraction_played = static_cast<double>(
+			                                     player.playedTrackFrames) /
+			                             player.totalTrackFrames;
 
-		player.cd->PlayAudioSector(new_redbook_start_frame,
-		                           remaining_redbook_frames);
+			const auto played_redbook_frames = static_cast<uint32_t>(
+			        ceil(fraction_played * player.totalRedbookFrames));
 
-		return;
-	}
+			const auto new_redbook_start_frame = player.startSector +
+			                                     played_redbook_frames;
+
+			const auto remaining_redbook_frames = player.totalRedbookFrames -
+			                                      played_redbook_frames;
+
+			player.cd->PlayAudioSector(new_redbook_start_frame,
+			                           remaining_redbook_frames);
+			break;
+		}
+
+		const auto num_frames = std::min(frames_remaining,
+		                                 block.num_frames -
+		                                         decoder.playedBlockFrames);
 
-	// Use the stereo or mono and native or nonnative AddSamples call
-	// assigned during construction
-	(player.channel.get()->*player.addFrames)(decoded_track_frames, player.buffer);
+		// Use the stereo or mono and native or nonnative AddSamples
+		// call assigned during construction
+		(player.channel.get()->*player.addFrames)(
+		        check_cast<int>(num_frames),
+		        block.samples.data() + decoder.playedBlockFrames * num_channels);
 
-	player.playedTrackFrames += decoded_track_frames;
-	if (player.playedTrackFrames >= player.totalTrackFrames) {
+		decoder.playedBlockFrames += num_frames;
+		frames_remaining -= num_frames;
+
+		player.playedTrackFrames += num_frames;
+		if (player.playedTrackFrames >= player.totalTrackFrames) {
 #ifdef DEBUG
-		LOG_MSG("CDROM: CDAudioCallBack stopping because "
-		"playedTrackFrames (%u) >= totalTrackFrames (%u)",
-		player.playedTrackFrames, player.totalTrackFrames);
+			LOG_MSG("CDROM: CDAudioCallBack stopping because "
+			        "playedTrackFrames (%u) >= totalTrackFrames (%u)",
+			        player.playedTrackFrames,
+			        player.totalTrackFrames);
 #endif
-		player.cd->StopAudio();
+			player.cd->StopAudio();
+			return;
+		}
+	}
+
+	// The decoder thread is still seeking or has fallen behind, so fill
+	// the rest with silence rather than waiting for it
+	if (frames_remaining > 0 && player.isPlaying) {
+		(player.channel.get()->*player.addFrames)(check_cast<int>(frames_remaining),
+		                                          player.silence.data());
+	}
+}
+
+void CDROM_Interface_Image::RequestDecoding(const std::shared_ptr<TrackFile>& track_file,
+                                            const uint32_t byte_offset)
+{
+	{
+		std::lock_guard<std::mutex> lock(decoder.mutex);
+		decoder.trackFile  = track_file;
+		decoder.byteOffset = byte_offset;
+		decoder.generation = player.generation;
+		decoder.hasRequest = true;
 	}
+	decoder.waiter.notify_all();
+}
+
+void CDROM_Interface_Image::TrackDecoderLoop()
+{
+	// The track being decoded and the state of its request
+	std::weak_ptr<TrackFile> track_file_ref = {};
+	uint32_t byte_offset = 0;
+	uint32_t generation  = 0;
+	bool needs_seek      = false;
+	bool is_decoding     = false;
+
+	// The mixer callback consumes the blocks without notifying us, so we
+	// check for room to decode into at a fraction of a block's duration
+	constexpr auto PollInterval = std::chrono::milliseconds(5);
+
+	std::unique_lock<std::mutex> lock(decoder.mutex);
+	while (true) {
+		const auto has_room = [] {
+			return decoder.queue.Size() < decoder.queue.MaxCapacity();
+		};
+		decoder.waiter.wait_for(lock, PollInterval, [&] {
+			return decoder.shouldExit || decoder.hasRequest ||
+			       (is_decoding && has_room());
+		});
+
+		if (decoder.shouldExit) {
+			return;
+		}
+
+		// Pick up the latest request, skipping any that have been
+		// superseded while we were busy decoding or seeking
+		if (decoder.hasRequest) {
+			track_file_ref     = decoder.trackFile;
+			byte_offset        = decoder.byteOffset;
+			generation         = decoder.generation;
+			decoder.hasRequest = false;
+			needs_seek         = true;
+			is_decoding        = !track_file_ref.expired();
+		}
+		if (!is_decoding || !has_room()) {
+			continue;
+		}
+		lock.unlock();
+
+		// Seeking and decoding can be slow, so do them without holding
+		// the request lock
+		DecodedBlock block = {};
+		block.generation   = generation;
+
+		if (const auto track_file = track_file_ref.lock(); track_file) {
+			std::lock_guard<std::mutex> file_lock(track_file->mutex);
+
+			if (needs_seek) {
+				needs_seek = false;
+				if (track_file->seek(byte_offset)) {
+					// We're performing an audio-task, so update
+					// the audio position
+					track_file->setAudioPosition(byte_offset);
+				} else {
+					block.seek_failed = true;
+				}
+			}
+			if (!block.seek_failed) {
+				block.samples.resize(DecodedBlockFrames *
+				                     track_file->getChannels());
+				block.num_frames = track_file->decode(block.samples.data(),
+				                                      DecodedBlockFrames);
+			}
+		}
+
+		// The track has ended, failed to seek, or has been ejected
+		is_decoding = block.num_frames > 0;
+
+		decoder.queue.Enqueue(std::move(block));
+		lock.lock();
+	}
+}
+
+// The sector sizes of the CHD track types, as stored in the frames
+static bool get_chd_sector_format(const std::string& type,
+                                  uint16_t& sector_size, bool& mode2)
+{
+	mode2 = false;
+	if (type == "MODE1" || type == "MODE2_FORM1") {
+		sector_size = BYTES_PER_COOKED_REDBOOK_FRAME;
+	} else if (type == "MODE1_RAW" || type == "AUDIO") {
+		sector_size = BYTES_PER_RAW_REDBOOK_FRAME;
+	} else if (type == "MODE2" || type == "MODE2_FORM_MIX") {
+		sector_size = 2336;
+		mode2       = true;
+	} else if (type == "MODE2_RAW") {
+		sector_size = BYTES_PER_RAW_REDBOOK_FRAME;
+		mode2       = true;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool CDROM_Interface_Image::LoadChdFile(const char* filename)
+{
+	std::string error = {};
+	std::shared_ptr<ChdImage> image = ChdImage::Open(filename, error);
+	if (!image) {
+		if (!error.empty()) {
+			LOG_WARNING("CDROM: Can't load '%s': %s", filename, error.c_str());
+		}
+		return false;
+	}
+
+	tracks.clear();
+	uint32_t lba = 0;
+	for (const auto& chd_track : image->GetTracks()) {
+		Track track  = {};
+		track.number = static_cast<uint8_t>(tracks.size() + 1);
+		if (chd_track.number != track.number ||
+		    track.number > MAX_REDBOOK_TRACKS ||
+		    !get_chd_sector_format(chd_track.type, track.sectorSize, track.mode2)) {
+			LOG_WARNING("CDROM: Can't load '%s': unsupported track %d of type %s",
+			            filename,
+			            chd_track.number,
+			            chd_track.type.c_str());
+			tracks.clear();
+			return false;
+		}
+		const bool is_audio = (chd_track.type == "AUDIO");
+		track.attr = is_audio ? 0 : 0x40; // data
+
+		// Tracks start at their index 1, after any pregap stored
+		// with them
+		const uint32_t stored_pregap = chd_track.has_pregap_data
+		                                     ? std::min(chd_track.pregap,
+		                                                chd_track.frames)
+		                                     : 0;
+		track.start  = lba + chd_track.pregap;
+		track.length = chd_track.frames - stored_pregap;
+		track.file   = std::make_shared<ChdFile>(image,
+		                                         chd_track.first_frame + stored_pregap,
+		                                         track.length,
+		                                         track.sectorSize,
+		                                         is_audio);
+		tracks.push_back(track);
+
+		lba = track.start + track.length + chd_track.postgap;
+	}
+
+	Track leadout_track  = {};
+	leadout_track.number = static_cast<uint8_t>(tracks.size() + 1);
+	leadout_track.start  = lba;
+	tracks.push_back(leadout_track);
+	return true;
 }
 
 bool CDROM_Interface_Image::LoadIsoFile(const char* filename)
@@ -1153,9 +1565,109 @@ static std::string dirname(char* file)
 }
 #endif
 
+bool CDROM_Interface_Image::CachedFile::Stat()
+{
+	std::error_code ec = {};
+	size = std_fs::file_size(path, ec);
+	if (ec)
+		return false;
+	last_write_time = std_fs::last_write_time(path, ec);
+	return !ec;
+}
+
+bool CDROM_Interface_Image::CachedFile::IsUnchanged() const
+{
+	CachedFile current = {};
+	current.path = path;
+	return current.Stat() && current.size == size &&
+	       current.last_write_time == last_write_time;
+}
+
+bool CDROM_Interface_Image::LoadCachedCueSheet(const char *cuefile)
+{
+	const auto it = cueSheetCache.find(cuefile);
+	if (it == cueSheetCache.end())
+		return false;
+
+	const CachedCueSheet &cached = it->second;
+	const auto is_unchanged = [](const CachedFile &file) {
+		return file.IsUnchanged();
+	};
+	if (!cached.cue.IsUnchanged() ||
+	    !std::all_of(cached.files.begin(), cached.files.end(), is_unchanged)) {
+		cueSheetCache.erase(it);
+		return false;
+	}
+
+	std::vector<std::shared_ptr<TrackFile>> files = {};
+	for (const auto &file : cached.files) {
+		if (file.audio) {
+			files.push_back(std::make_shared<AudioFile>(file.path, *file.audio));
+			continue;
+		}
+		bool error = true;
+		files.push_back(std::make_shared<BinaryFile>(file.path.c_str(), error));
+		if (error) {
+			cueSheetCache.erase(it);
+			return false;
+		}
+	}
+
+	tracks = cached.tracks;
+	for (size_t i = 0; i < tracks.size(); ++i) {
+		if (cached.track_files[i] < files.size())
+			tracks[i].file = files[cached.track_files[i]];
+	}
+	mcn = cached.mcn;
+
+	LOG_MSG("CDROM: Loaded %s with its previously parsed tracks",
+	        get_basename(cuefile).c_str());
+	return true;
+}
+
+void CDROM_Interface_Image::CacheCueSheet(const char *cuefile,
+                                          std::vector<CachedFile> files,
+                                          const std::vector<std::shared_ptr<TrackFile>> &file_ptrs)
+{
+	assert(files.size() == file_ptrs.size());
+
+	CachedCueSheet cached = {};
+	cached.cue.path = cuefile;
+	if (!cached.cue.Stat())
+		return;
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		if (!files[i].Stat())
+			return;
+		if (const auto audio_file = dynamic_cast<AudioFile *>(file_ptrs[i].get()))
+			files[i].audio = audio_file->getProperties();
+	}
+	cached.files = std::move(files);
+
+	for (const auto &track : tracks) {
+		const auto file = std::find(file_ptrs.begin(), file_ptrs.end(), track.file);
+		cached.track_files.push_back(track.file
+		                                     ? static_cast<size_t>(file - file_ptrs.begin())
+		                                     : file_ptrs.size());
+		cached.tracks.push_back(track);
+		cached.tracks.back().file = nullptr;
+	}
+	cached.mcn = mcn;
+
+	cueSheetCache[cuefile] = std::move(cached);
+}
+
 bool CDROM_Interface_Image::LoadCueSheet(const char *cuefile)
 {
+	if (LoadCachedCueSheet(cuefile))
+		return true;
+
 	tracks.clear();
+	mcn.clear();
+
+	// The track files, to cache the parsed cue sheet with
+	std::vector<CachedFile> files = {};
+	std::vector<std::shared_ptr<TrackFile>> file_ptrs = {};
 
 	Track track;
 	uint32_t shift = 0;
@@ -1260,6 +1772,11 @@ bool CDROM_Interface_Image::LoadCueSheet(const char *cuefile)
 			}
 			if (error) {
 				success = false;
+			} else {
+				CachedFile file = {};
+				file.path = filename;
+				files.push_back(file);
+				file_ptrs.push_back(track.file);
 			}
 		}
 		else if (command == "PREGAP") success = GetCueFrame(currPregap, line);
@@ -1292,6 +1809,7 @@ bool CDROM_Interface_Image::LoadCueSheet(const char *cuefile)
 	if (!AddTrack(track, shift, -1, totalPregap, 0)) {
 		return false;
 	}
+	CacheCueSheet(cuefile, std::move(files), file_ptrs);
 	return true;
 }
 
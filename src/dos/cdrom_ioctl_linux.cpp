@@ -16,7 +16,9 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 
 #include "cdrom.h"
@@ -35,6 +37,7 @@
 
 CDROM_Interface_Ioctl::~CDROM_Interface_Ioctl()
 {
+	StopReader();
 	if (IsOpen()) {
 		close(cdrom_fd);
 	}
@@ -219,6 +222,10 @@ bool CDROM_Interface_Ioctl::GetMediaTrayStatus(bool& mediaPresent,
 	auto ret     = ioctl(cdrom_fd, CDROM_MEDIA_CHANGED, CDSL_CURRENT);
 	mediaChanged = (ret > 0) && (ret & 1);
 
+	if (mediaChanged || !mediaPresent) {
+		ClearSectorCache();
+	}
+
 #ifdef DEBUG_IOCTL
 	LOG_INFO("CDROM_IOCTL: GetMediaTrayStatus => media is %s, %s, and the tray is %s",
 	         mediaPresent ? "present" : "not present",
@@ -229,10 +236,202 @@ bool CDROM_Interface_Ioctl::GetMediaTrayStatus(bool& mediaPresent,
 	return true;
 }
 
-bool CDROM_Interface_Ioctl::ReadSector(uint8_t* /*buffer*/, const bool /*raw*/,
-                                       const uint32_t /*sector*/)
+// Returns the number of whole sectors read
+static uint32_t read_cooked_sectors(const int fd, uint8_t* buffer,
+                                    const uint32_t sector, const uint32_t num)
+{
+	const size_t num_bytes = num * static_cast<size_t>(CD_FRAMESIZE);
+	const auto offset = static_cast<off_t>(sector) * CD_FRAMESIZE;
+
+	size_t num_read = 0;
+	while (num_read < num_bytes) {
+		const auto ret = pread(fd,
+		                       buffer + num_read,
+		                       num_bytes - num_read,
+		                       offset + static_cast<off_t>(num_read));
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret <= 0) {
+			break;
+		}
+		num_read += static_cast<size_t>(ret);
+	}
+	return static_cast<uint32_t>(num_read / CD_FRAMESIZE);
+}
+
+static bool read_raw_sectors(const int fd, uint8_t* buffer,
+                             const uint32_t sector, const uint32_t num)
+{
+	struct cdrom_read cdrom_read;
+	cdrom_read.cdread_lba     = static_cast<int>(sector);
+	cdrom_read.cdread_bufaddr = reinterpret_cast<char*>(buffer);
+	cdrom_read.cdread_buflen  = static_cast<int>(num * CD_FRAMESIZE_RAW);
+
+	return ioctl(fd, CDROMREADRAW, &cdrom_read) >= 0;
+}
+
+// Serves the sectors from the cache, reading the missed ones from the disc,
+// and keeps the reader thread ahead of sequential requests
+bool CDROM_Interface_Ioctl::ReadCookedSectors(uint8_t* buffer,
+                                              const uint32_t sector,
+                                              const uint32_t num)
+{
+	if (!sector_cache.IsEnabled()) {
+		return read_cooked_sectors(cdrom_fd, buffer, sector, num) == num;
+	}
+
+	std::unique_lock<std::mutex> lock(reader_mutex);
+
+	uint32_t i = 0;
+	while (i < num) {
+		const auto current = sector + i;
+
+		// Rather than reading it again, wait for the sector if the
+		// reader is already at it
+		reader_waiter.wait(lock, [&] { return !reading.Contains(current); });
+
+		if (sector_cache.Read(current, buffer + i * CD_FRAMESIZE)) {
+			++i;
+			continue;
+		}
+
+		// Read the run of missed sectors in one go
+		uint32_t num_missed = 1;
+		while (i + num_missed < num &&
+		       !sector_cache.Contains(current + num_missed) &&
+		       !reading.Contains(current + num_missed)) {
+			++num_missed;
+		}
+		const auto generation = media_generation;
+		auto data = buffer + i * CD_FRAMESIZE;
+
+		lock.unlock();
+		const auto num_read = read_cooked_sectors(cdrom_fd, data, current, num_missed);
+		lock.lock();
+
+		if (generation == media_generation) {
+			for (uint32_t j = 0; j < num_read; ++j) {
+				sector_cache.Insert(current + j, data + j * CD_FRAMESIZE);
+			}
+		}
+		if (num_read != num_missed) {
+			return false;
+		}
+		i += num_missed;
+	}
+
+	const auto is_sequential = (sector == next_request);
+	next_request = sector + num;
+	if (is_sequential) {
+		ReadAhead(next_request);
+	} else {
+		ahead_end = next_request;
+	}
+	return true;
+}
+
+// Queues the next sectors for the reader thread once the programs have
+// consumed half of what it read ahead. Called with the reader mutex held.
+void CDROM_Interface_Ioctl::ReadAhead(const uint32_t next_sector)
+{
+	constexpr auto ReadAheadSize = CdSectorCache::MaxReadAhead;
+
+	const auto is_busy = queued || reading.end > reading.start;
+	if (is_busy || !reader.joinable() ||
+	    ahead_end >= next_sector + ReadAheadSize / 2) {
+		return;
+	}
+
+	// Don't read ahead more than half the cache, or the read-ahead would
+	// evict the sectors the programs are about to read
+	const auto num_sectors = std::min(static_cast<size_t>(ReadAheadSize),
+	                                  sector_cache.GetMaxSectors() / 2);
+	if (num_sectors == 0) {
+		return;
+	}
+	const auto start = std::max(ahead_end, next_sector);
+	ahead_end = start + static_cast<uint32_t>(num_sectors);
+
+	queued = SectorRange{start, ahead_end};
+	reader_waiter.notify_all();
+}
+
+void CDROM_Interface_Ioctl::ReaderLoop()
+{
+	std::unique_lock<std::mutex> lock(reader_mutex);
+	while (true) {
+		reader_waiter.wait(lock, [&] { return queued || should_stop; });
+		if (should_stop) {
+			return;
+		}
+		reading = *queued;
+		queued.reset();
+
+		const auto generation  = media_generation;
+		const auto num_sectors = reading.end - reading.start;
+		reader_buffer.resize(num_sectors * CD_FRAMESIZE);
+
+		// Slow call to read from the drive, avoid holding the lock
+		lock.unlock();
+		const auto num_read = read_cooked_sectors(cdrom_fd,
+		                                          reader_buffer.data(),
+		                                          reading.start,
+		                                          num_sectors);
+		lock.lock();
+
+		if (generation == media_generation) {
+			for (uint32_t i = 0; i < num_read; ++i) {
+				sector_cache.Insert(reading.start + i,
+				                    reader_buffer.data() + i * CD_FRAMESIZE);
+			}
+		}
+		reading = {};
+		reader_waiter.notify_all();
+	}
+}
+
+void CDROM_Interface_Ioctl::StartReader()
 {
-	return false; /*TODO*/
+	assert(!reader.joinable());
+	if (!sector_cache.IsEnabled()) {
+		return;
+	}
+	should_stop = false;
+	reader      = std::thread(&CDROM_Interface_Ioctl::ReaderLoop, this);
+}
+
+void CDROM_Interface_Ioctl::StopReader()
+{
+	if (!reader.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(reader_mutex);
+		should_stop = true;
+		queued.reset();
+	}
+	reader_waiter.notify_all();
+	reader.join();
+}
+
+void CDROM_Interface_Ioctl::ClearSectorCache()
+{
+	std::lock_guard<std::mutex> lock(reader_mutex);
+	++media_generation;
+	queued.reset();
+	sector_cache.Clear();
+	ahead_end = next_request;
+}
+
+bool CDROM_Interface_Ioctl::ReadSector(uint8_t* buffer, const bool raw,
+                                       const uint32_t sector)
+{
+	if (!IsOpen()) {
+		return false;
+	}
+	return raw ? read_raw_sectors(cdrom_fd, buffer, sector, 1)
+	           : ReadCookedSectors(buffer, sector, 1);
 }
 
 bool CDROM_Interface_Ioctl::ReadSectors(PhysPt buffer, const bool raw,
@@ -246,27 +445,13 @@ bool CDROM_Interface_Ioctl::ReadSectors(PhysPt buffer, const bool raw,
 	                        : num * (unsigned int)CD_FRAMESIZE;
 	assert(buflen);
 	std::vector<uint8_t> buf(buflen, 0);
-	int ret = 0;
-
-	if (raw) {
-		struct cdrom_read cdrom_read;
-		cdrom_read.cdread_lba = (int)sector;
-		cdrom_read.cdread_bufaddr = reinterpret_cast<char *>(buf.data());
-		cdrom_read.cdread_buflen = (int)buflen;
 
-		ret = ioctl(cdrom_fd, CDROMREADRAW, &cdrom_read);
-	} else {
-		ret = lseek(cdrom_fd, (off_t)(sector * (unsigned long)CD_FRAMESIZE),
-		            SEEK_SET);
-		if (ret >= 0)
-			ret = read(cdrom_fd, buf.data(), buflen);
-		if ((Bitu)ret != buflen)
-			ret = -1;
-	}
+	const auto success = raw ? read_raw_sectors(cdrom_fd, buf.data(), sector, num)
+	                         : ReadCookedSectors(buf.data(), sector, num);
 
 	MEM_BlockWrite(buffer, buf.data(), buflen);
 
-	return (ret > 0);
+	return success;
 }
 
 // Opens the given device name, replacing any currently opened device
@@ -284,10 +469,14 @@ bool CDROM_Interface_Ioctl::Open(const char* device_name)
 		return false;
 	}
 
+	StopReader();
 	if (IsOpen()) {
 		close(cdrom_fd);
 	}
 	cdrom_fd = fd;
+
+	ClearSectorCache();
+	StartReader();
 	return true;
 }
 
@@ -319,12 +508,21 @@ bool CDROM_Interface_Ioctl::SetDevice(const char* path)
 	return false;
 }
 
-bool CDROM_Interface_Ioctl::ReadSectorsHost([[maybe_unused]] void *buffer,
-                                            [[maybe_unused]] bool raw,
-                                            [[maybe_unused]] unsigned long sector,
-                                            [[maybe_unused]] unsigned long num)
+bool CDROM_Interface_Ioctl::ReadSectorsHost(void* buffer, bool raw,
+                                            unsigned long sector,
+                                            unsigned long num)
 {
-	return false; /*TODO*/
+	if (!IsOpen()) {
+		return false;
+	}
+	const auto data = static_cast<uint8_t*>(buffer);
+	return raw ? read_raw_sectors(cdrom_fd,
+	                              data,
+	                              check_cast<uint32_t>(sector),
+	                              check_cast<uint32_t>(num))
+	           : ReadCookedSectors(data,
+	                               check_cast<uint32_t>(sector),
+	                               check_cast<uint32_t>(num));
 }
 
 bool CDROM_Interface_Ioctl::LoadUnloadMedia(bool unload)
@@ -332,6 +530,7 @@ bool CDROM_Interface_Ioctl::LoadUnloadMedia(bool unload)
 	if (!IsOpen()) {
 		return false;
 	}
+	ClearSectorCache();
 	if (unload) {
 		return ioctl(cdrom_fd, CDROMEJECT) == 0;
 	} else {
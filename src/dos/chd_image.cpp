@@ -0,0 +1,747 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "chd_image.h"
+
+#include "config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(C_SYSTEM_ZLIB_NG)
+#include <zlib-ng.h>
+#define inflateInit2 zng_inflateInit2
+#define inflate zng_inflate
+#define inflateEnd zng_inflateEnd
+#define z_stream zng_stream
+#else
+#include <zlib.h>
+#endif
+
+#include "cross.h"
+
+namespace {
+
+constexpr uint32_t HeaderSize = 124;
+constexpr uint32_t Version    = 5;
+
+constexpr uint32_t make_fourcc(const char (&s)[5])
+{
+	return static_cast<uint32_t>(static_cast<uint8_t>(s[0]) << 24 |
+	                             static_cast<uint8_t>(s[1]) << 16 |
+	                             static_cast<uint8_t>(s[2]) << 8 |
+	                             static_cast<uint8_t>(s[3]));
+}
+
+constexpr auto CodecZlib   = make_fourcc("zlib");
+constexpr auto CodecCdZlib = make_fourcc("cdzl");
+
+constexpr auto MetaTrackV2 = make_fourcc("CHT2");
+constexpr auto MetaTrack   = make_fourcc("CHTR");
+
+constexpr uint32_t SubcodeSize = ChdImage::FrameSize - ChdImage::SectorDataSize;
+
+// The tracks' frames are padded to multiples of this in the image
+constexpr uint32_t TrackPadding = 4;
+
+// The compression types in the map; the first four select one of the
+// header's codecs, and the ones from 'RleSmall' on only appear while the
+// map is compressed
+enum Compression : uint8_t {
+	Codec0      = 0,
+	Codec3      = 3,
+	None        = 4,
+	Self        = 5,
+	Parent      = 6,
+	RleSmall    = 7,
+	RleLarge    = 8,
+	Self0       = 9,
+	Self1       = 10,
+	ParentSelf  = 11,
+	Parent0     = 12,
+	Parent1     = 13,
+	NumCompressionTypes = 16,
+};
+
+uint16_t read_be16(const uint8_t* p)
+{
+	return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+uint32_t read_be32(const uint8_t* p)
+{
+	return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+	       static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+
+uint64_t read_be48(const uint8_t* p)
+{
+	return static_cast<uint64_t>(read_be16(p)) << 32 | read_be32(p + 2);
+}
+
+uint64_t read_be64(const uint8_t* p)
+{
+	return static_cast<uint64_t>(read_be32(p)) << 32 | read_be32(p + 4);
+}
+
+// CRC-16/CCITT, as used by the map and the hunks
+uint16_t crc16(const uint8_t* data, const size_t num_bytes)
+{
+	static const auto table = [] {
+		std::vector<uint16_t> t(256);
+		for (uint32_t i = 0; i < t.size(); ++i) {
+			uint32_t crc = i << 8;
+			for (int bit = 0; bit < 8; ++bit) {
+				crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+			}
+			t[i] = static_cast<uint16_t>(crc);
+		}
+		return t;
+	}();
+
+	uint16_t crc = 0xffff;
+	for (size_t i = 0; i < num_bytes; ++i) {
+		crc = static_cast<uint16_t>(crc << 8) ^ table[(crc >> 8) ^ data[i]];
+	}
+	return crc;
+}
+
+// Reads bits most significant first, returning zeros past the end
+class BitReader {
+public:
+	BitReader(const uint8_t* _data, const size_t _num_bytes)
+	        : data(_data),
+	          num_bytes(_num_bytes)
+	{}
+
+	uint64_t Read(const int num_bits)
+	{
+		uint64_t value = 0;
+		for (int i = 0; i < num_bits; ++i, ++position) {
+			const auto byte = position / 8;
+			const auto bit = byte < num_bytes
+			                       ? (data[byte] >> (7 - position % 8)) & 1
+			                       : 0;
+			value = value << 1 | static_cast<uint64_t>(bit);
+		}
+		return value;
+	}
+
+	bool HasOverflowed() const
+	{
+		return position > num_bytes * 8;
+	}
+
+private:
+	const uint8_t* data = nullptr;
+	size_t num_bytes    = 0;
+	size_t position     = 0;
+};
+
+// The canonical Huffman code compressing the map's compression types
+class MapTypeDecoder {
+public:
+	static constexpr int MaxBits = 8;
+
+	bool ImportTree(BitReader& bits)
+	{
+		// The code lengths are run-length encoded in 4-bit values, with
+		// 1 escaping a literal 1 or a run of 3 or more lengths
+		constexpr int NumBits = 4;
+
+		size_t code = 0;
+		while (code < lengths.size()) {
+			auto length = static_cast<int>(bits.Read(NumBits));
+			if (length != 1) {
+				lengths[code++] = length;
+				continue;
+			}
+			length = static_cast<int>(bits.Read(NumBits));
+			if (length == 1) {
+				lengths[code++] = length;
+				continue;
+			}
+			const auto repeats = bits.Read(NumBits) + 3;
+			if (code + repeats > lengths.size()) {
+				return false;
+			}
+			std::fill_n(lengths.begin() + code, repeats, length);
+			code += repeats;
+		}
+		return AssignCodes() && !bits.HasOverflowed();
+	}
+
+	uint8_t Decode(BitReader& bits) const
+	{
+		uint32_t code = 0;
+		for (int length = 1; length <= MaxBits; ++length) {
+			code = code << 1 | static_cast<uint32_t>(bits.Read(1));
+			for (size_t i = 0; i < lengths.size(); ++i) {
+				if (lengths[i] == length && codes[i] == code) {
+					return static_cast<uint8_t>(i);
+				}
+			}
+		}
+		// Not a valid code; the map's CRC check will fail
+		return None;
+	}
+
+private:
+	// The longest codes get the lowest numbers
+	bool AssignCodes()
+	{
+		uint32_t starts[MaxBits + 1] = {};
+		for (const auto length : lengths) {
+			if (length > MaxBits) {
+				return false;
+			}
+			++starts[length];
+		}
+		uint32_t start = 0;
+		for (int length = MaxBits; length > 0; --length) {
+			const auto next_start = (start + starts[length]) >> 1;
+			if (length != 1 && next_start * 2 != start + starts[length]) {
+				return false;
+			}
+			starts[length] = start;
+			start          = next_start;
+		}
+		for (size_t i = 0; i < lengths.size(); ++i) {
+			if (lengths[i] > 0) {
+				codes[i] = starts[lengths[i]]++;
+			}
+		}
+		return true;
+	}
+
+	std::vector<int> lengths    = std::vector<int>(NumCompressionTypes);
+	std::vector<uint32_t> codes = std::vector<uint32_t>(NumCompressionTypes);
+};
+
+// Inflates raw deflate data into exactly 'dest_bytes'
+bool inflate_raw(const uint8_t* src, const uint32_t src_bytes, uint8_t* dest,
+                 const uint32_t dest_bytes)
+{
+	z_stream stream = {};
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+		return false;
+	}
+	stream.next_in   = const_cast<uint8_t*>(src);
+	stream.avail_in  = src_bytes;
+	stream.next_out  = dest;
+	stream.avail_out = dest_bytes;
+
+	const auto result = inflate(&stream, Z_FINISH);
+	const auto is_complete = stream.avail_out == 0 &&
+	                         (result == Z_STREAM_END || result == Z_OK ||
+	                          result == Z_BUF_ERROR);
+	inflateEnd(&stream);
+	return is_complete;
+}
+
+// The error-correction codes of Mode 1 and Mode 2 Form 1 sectors, which the
+// 'cdzl' codec drops together with the sync pattern when they can be
+// regenerated
+constexpr uint8_t SyncPattern[] = {
+        0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00};
+
+void compute_ecc_block(const uint8_t* src, const uint32_t major_count,
+                       const uint32_t minor_count, const uint32_t major_mult,
+                       const uint32_t minor_inc, uint8_t* dest)
+{
+	static const auto luts = [] {
+		std::vector<uint8_t> f(256), b(256);
+		for (uint32_t i = 0; i < 256; ++i) {
+			const auto j = (i << 1) ^ ((i & 0x80) ? 0x11d : 0);
+			f[i]     = static_cast<uint8_t>(j);
+			b[i ^ j] = static_cast<uint8_t>(i);
+		}
+		return std::make_pair(f, b);
+	}();
+	const auto& f_lut = luts.first;
+	const auto& b_lut = luts.second;
+
+	const auto size = major_count * minor_count;
+	for (uint32_t major = 0; major < major_count; ++major) {
+		auto index    = (major >> 1) * major_mult + (major & 1);
+		uint8_t ecc_a = 0;
+		uint8_t ecc_b = 0;
+		for (uint32_t minor = 0; minor < minor_count; ++minor) {
+			const auto value = src[index];
+			index += minor_inc;
+			if (index >= size) {
+				index -= size;
+			}
+			ecc_a = f_lut[ecc_a ^ value];
+			ecc_b ^= value;
+		}
+		ecc_a = b_lut[f_lut[ecc_a] ^ ecc_b];
+
+		dest[major]               = ecc_a;
+		dest[major + major_count] = ecc_a ^ ecc_b;
+	}
+}
+
+void restore_sync_and_ecc(uint8_t* sector)
+{
+	std::memcpy(sector, SyncPattern, sizeof(SyncPattern));
+
+	// Mode 2 sectors compute the codes as if their header was zero
+	constexpr size_t HeaderOffset = sizeof(SyncPattern);
+	uint8_t header[4]             = {};
+	const auto is_mode2           = sector[HeaderOffset + 3] == 2;
+	if (is_mode2) {
+		std::memcpy(header, sector + HeaderOffset, sizeof(header));
+		std::memset(sector + HeaderOffset, 0, sizeof(header));
+	}
+	compute_ecc_block(sector + HeaderOffset, 86, 24, 2, 86, sector + 0x81c);
+	compute_ecc_block(sector + HeaderOffset, 52, 43, 86, 88, sector + 0x8c8);
+	if (is_mode2) {
+		std::memcpy(sector + HeaderOffset, header, sizeof(header));
+	}
+}
+
+// A 'cdzl' hunk holds the flags of the frames to restore the sync and codes
+// of, the compressed size of the sector data, and then the deflated sector
+// data and subcode of all the frames
+bool decompress_cdzl(const uint8_t* src, const uint32_t src_bytes,
+                     uint8_t* dest, const uint32_t dest_bytes)
+{
+	const auto frames        = dest_bytes / ChdImage::FrameSize;
+	const auto ecc_bytes     = (frames + 7) / 8;
+	const auto complen_bytes = dest_bytes < 65536 ? 2u : 3u;
+	const auto header_bytes  = ecc_bytes + complen_bytes;
+	if (src_bytes < header_bytes) {
+		return false;
+	}
+
+	uint32_t base_bytes = read_be16(src + ecc_bytes);
+	if (complen_bytes > 2) {
+		base_bytes = base_bytes << 8 | src[ecc_bytes + 2];
+	}
+	if (base_bytes > src_bytes - header_bytes) {
+		return false;
+	}
+
+	std::vector<uint8_t> buffer(frames * ChdImage::FrameSize);
+	const auto subcode = buffer.data() + frames * ChdImage::SectorDataSize;
+	if (!inflate_raw(src + header_bytes,
+	                 base_bytes,
+	                 buffer.data(),
+	                 frames * ChdImage::SectorDataSize) ||
+	    !inflate_raw(src + header_bytes + base_bytes,
+	                 src_bytes - header_bytes - base_bytes,
+	                 subcode,
+	                 frames * SubcodeSize)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < frames; ++i) {
+		const auto frame = dest + i * ChdImage::FrameSize;
+		std::memcpy(frame,
+		            buffer.data() + i * ChdImage::SectorDataSize,
+		            ChdImage::SectorDataSize);
+		std::memcpy(frame + ChdImage::SectorDataSize,
+		            subcode + i * SubcodeSize,
+		            SubcodeSize);
+		if (src[i / 8] & (1 << (i % 8))) {
+			restore_sync_and_ecc(frame);
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+ChdImage::ChdImage(FILE* _file) : file(_file) {}
+
+ChdImage::~ChdImage()
+{
+	if (prefetch.valid()) {
+		prefetch.wait();
+	}
+	if (file) {
+		fclose(file);
+	}
+}
+
+std::unique_ptr<ChdImage> ChdImage::Open(const std::string& path, std::string& error)
+{
+	error = {};
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) {
+		return nullptr;
+	}
+	return Open(file, error);
+}
+
+std::unique_ptr<ChdImage> ChdImage::Open(FILE* file, std::string& error)
+{
+	error = {};
+	std::unique_ptr<ChdImage> image(new ChdImage(file));
+	if (!image->ReadHeader(error) || !image->ReadMap(error) ||
+	    !image->ReadMetadata(error)) {
+		return nullptr;
+	}
+	return image;
+}
+
+bool ChdImage::ReadFile(const uint64_t offset, uint8_t* data, const size_t num_bytes)
+{
+	std::lock_guard<std::mutex> lock(file_mutex);
+	return cross_fseeko(file, static_cast<cross_off_t>(offset), SEEK_SET) == 0 &&
+	       fread(data, 1, num_bytes, file) == num_bytes;
+}
+
+bool ChdImage::ReadHeader(std::string& error)
+{
+	uint8_t header[HeaderSize] = {};
+	if (!ReadFile(0, header, sizeof(header)) ||
+	    std::memcmp(header, "MComprHD", 8) != 0) {
+		return false;
+	}
+	const auto version = read_be32(header + 12);
+	if (version != Version || read_be32(header + 8) != HeaderSize) {
+		error = "only version 5 CHD images are supported";
+		return false;
+	}
+
+	for (int i = 0; i < 4; ++i) {
+		compressors[i] = read_be32(header + 16 + i * 4);
+		if (compressors[i] != 0 && compressors[i] != CodecZlib &&
+		    compressors[i] != CodecCdZlib) {
+			error = "the CHD image uses an unsupported codec; recompress it with 'chdman createcd -c cdzl'";
+			return false;
+		}
+	}
+	logical_bytes = read_be64(header + 32);
+	map_offset    = read_be64(header + 40);
+	meta_offset   = read_be64(header + 48);
+	hunk_bytes    = read_be32(header + 56);
+
+	const auto unit_bytes = read_be32(header + 60);
+	if (unit_bytes != FrameSize || hunk_bytes == 0 || hunk_bytes % FrameSize != 0) {
+		error = "the CHD image isn't a CD-ROM image";
+		return false;
+	}
+	const auto parent_sha1 = header + 104;
+	if (std::any_of(parent_sha1, parent_sha1 + 20, [](auto b) { return b != 0; })) {
+		error = "CHD images with a parent image aren't supported";
+		return false;
+	}
+
+	frames_per_hunk = hunk_bytes / FrameSize;
+	num_frames      = static_cast<uint32_t>(logical_bytes / FrameSize);
+	return true;
+}
+
+bool ChdImage::ReadMap(std::string& error)
+{
+	error = "the CHD image's map is damaged";
+
+	uint8_t header[16] = {};
+	if (!ReadFile(map_offset, header, sizeof(header))) {
+		return false;
+	}
+	const auto map_bytes   = read_be32(header);
+	const auto first_offs  = read_be48(header + 4);
+	const auto map_crc     = read_be16(header + 10);
+	const int length_bits  = header[12];
+	const int self_bits    = header[13];
+	const int parent_bits  = header[14];
+
+	std::vector<uint8_t> compressed(map_bytes);
+	if (!ReadFile(map_offset + sizeof(header), compressed.data(), compressed.size())) {
+		return false;
+	}
+	BitReader bits(compressed.data(), compressed.size());
+
+	MapTypeDecoder decoder = {};
+	if (!decoder.ImportTree(bits)) {
+		return false;
+	}
+
+	const auto num_hunks = static_cast<uint32_t>(
+	        (logical_bytes + hunk_bytes - 1) / hunk_bytes);
+	map.resize(num_hunks);
+
+	// The compression types come first, with runs of the same type
+	uint8_t last_type = 0;
+	uint32_t repeats  = 0;
+	for (auto& entry : map) {
+		if (repeats > 0) {
+			entry.compression = last_type;
+			--repeats;
+			continue;
+		}
+		const auto type = decoder.Decode(bits);
+		if (type == RleSmall) {
+			repeats = 2 + decoder.Decode(bits);
+		} else if (type == RleLarge) {
+			repeats = 2 + 16 + (decoder.Decode(bits) << 4);
+			repeats += decoder.Decode(bits);
+		} else {
+			last_type = type;
+		}
+		entry.compression = last_type;
+	}
+
+	// Then the locations of the hunks, as the raw map the CRC covers
+	std::vector<uint8_t> raw_map(map.size() * 12);
+	uint64_t offset    = first_offs;
+	uint64_t last_self = 0;
+	for (uint32_t i = 0; i < map.size(); ++i) {
+		auto& entry = map[i];
+		switch (entry.compression) {
+		case None:
+			entry.offset = offset;
+			entry.length = hunk_bytes;
+			entry.crc    = static_cast<uint16_t>(bits.Read(16));
+			offset += entry.length;
+			break;
+		case Self:
+			entry.offset = last_self = bits.Read(self_bits);
+			break;
+		case Self1: ++last_self; [[fallthrough]];
+		case Self0:
+			entry.compression = Self;
+			entry.offset      = last_self;
+			break;
+		case Parent:
+			bits.Read(parent_bits);
+			[[fallthrough]];
+		case ParentSelf:
+		case Parent0:
+		case Parent1:
+			error = "CHD images with a parent image aren't supported";
+			return false;
+		default:
+			if (entry.compression > Codec3) {
+				return false;
+			}
+			entry.offset = offset;
+			entry.length = static_cast<uint32_t>(bits.Read(length_bits));
+			entry.crc    = static_cast<uint16_t>(bits.Read(16));
+			offset += entry.length;
+			break;
+		}
+
+		auto raw = raw_map.data() + i * 12;
+		raw[0]   = entry.compression;
+		for (int b = 0; b < 3; ++b) {
+			raw[1 + b] = static_cast<uint8_t>(entry.length >> (16 - b * 8));
+		}
+		for (int b = 0; b < 6; ++b) {
+			raw[4 + b] = static_cast<uint8_t>(entry.offset >> (40 - b * 8));
+		}
+		raw[10] = static_cast<uint8_t>(entry.crc >> 8);
+		raw[11] = static_cast<uint8_t>(entry.crc);
+	}
+	if (bits.HasOverflowed() || crc16(raw_map.data(), raw_map.size()) != map_crc) {
+		return false;
+	}
+	error = {};
+	return true;
+}
+
+bool ChdImage::ReadMetadata(std::string& error)
+{
+	auto offset = meta_offset;
+	while (offset != 0) {
+		uint8_t header[16] = {};
+		if (!ReadFile(offset, header, sizeof(header))) {
+			error = "the CHD image's metadata is damaged";
+			return false;
+		}
+		const auto tag = read_be32(header);
+		const auto length = read_be32(header + 4) & 0xffffff;
+		if (tag == MetaTrack || tag == MetaTrackV2) {
+			std::vector<char> text(length + 1);
+			if (!ReadFile(offset + sizeof(header),
+			              reinterpret_cast<uint8_t*>(text.data()),
+			              length)) {
+				error = "the CHD image's metadata is damaged";
+				return false;
+			}
+			Track track = {};
+			char type[32] = {};
+			char subtype[32] = {};
+			char pregap_type[32] = {};
+			char pregap_subtype[32] = {};
+			int frames = 0;
+			int pregap = 0;
+			int postgap = 0;
+			const auto num_fields = sscanf(
+			        text.data(),
+			        "TRACK:%d TYPE:%31s SUBTYPE:%31s FRAMES:%d PREGAP:%d "
+			        "PGTYPE:%31s PGSUB:%31s POSTGAP:%d",
+			        &track.number, type, subtype, &frames, &pregap,
+			        pregap_type, pregap_subtype, &postgap);
+			if (num_fields < 4 || frames <= 0 || pregap < 0 || postgap < 0) {
+				error = "the CHD image's track list is damaged";
+				return false;
+			}
+			track.type    = type;
+			track.frames  = static_cast<uint32_t>(frames);
+			track.pregap  = static_cast<uint32_t>(pregap);
+			track.postgap = static_cast<uint32_t>(postgap);
+			track.has_pregap_data = num_fields >= 6 && pregap_type[0] == 'V';
+			tracks.push_back(track);
+		}
+		offset = read_be64(header + 8);
+	}
+
+	std::sort(tracks.begin(), tracks.end(), [](const auto& a, const auto& b) {
+		return a.number < b.number;
+	});
+
+	uint32_t frame = 0;
+	for (auto& track : tracks) {
+		track.first_frame = frame;
+		frame += (track.frames + TrackPadding - 1) / TrackPadding * TrackPadding;
+	}
+	if (tracks.empty() ||
+	    tracks.back().first_frame + tracks.back().frames > num_frames) {
+		error = "the CHD image's track list doesn't match its contents";
+		return false;
+	}
+	return true;
+}
+
+bool ChdImage::DecompressHunk(uint32_t number, Hunk& hunk)
+{
+	// Hunks duplicating earlier ones refer to them
+	while (number < map.size() && map[number].compression == Self) {
+		if (map[number].offset >= number) {
+			return false;
+		}
+		number = static_cast<uint32_t>(map[number].offset);
+	}
+	if (number >= map.size()) {
+		return false;
+	}
+	const auto& entry = map[number];
+
+	hunk.resize(hunk_bytes);
+	if (entry.compression == None) {
+		if (!ReadFile(entry.offset, hunk.data(), hunk.size())) {
+			return false;
+		}
+	} else {
+		std::vector<uint8_t> compressed(entry.length);
+		if (!ReadFile(entry.offset, compressed.data(), compressed.size())) {
+			return false;
+		}
+		const auto codec = compressors[entry.compression];
+		const auto is_decompressed =
+		        codec == CodecCdZlib
+		                ? decompress_cdzl(compressed.data(), entry.length, hunk.data(), hunk_bytes)
+		        : codec == CodecZlib
+		                ? inflate_raw(compressed.data(), entry.length, hunk.data(), hunk_bytes)
+		                : false;
+		if (!is_decompressed) {
+			return false;
+		}
+	}
+	return crc16(hunk.data(), hunk.size()) == entry.crc;
+}
+
+void ChdImage::CacheHunk(const uint32_t number, Hunk&& hunk)
+{
+	if (cache_index.find(number) != cache_index.end()) {
+		return;
+	}
+	if (cached_hunks.size() >= MaxCachedHunks) {
+		cache_index.erase(cached_hunks.back().number);
+		cached_hunks.pop_back();
+	}
+	cached_hunks.push_front({number, std::move(hunk)});
+	cache_index[number] = cached_hunks.begin();
+}
+
+void ChdImage::CollectPrefetchedHunk()
+{
+	if (prefetch.valid() && prefetch.get()) {
+		CacheHunk(prefetch_number, std::move(prefetch_hunk));
+	}
+	prefetch_hunk = {};
+}
+
+// Decompresses a hunk on a worker thread, unless it's cached or another
+// one is still being decompressed
+void ChdImage::PrefetchHunk(const uint32_t number)
+{
+	if (number >= map.size() || cache_index.find(number) != cache_index.end()) {
+		return;
+	}
+	if (prefetch.valid()) {
+		using namespace std::chrono_literals;
+		if (prefetch.wait_for(0s) != std::future_status::ready) {
+			return;
+		}
+		CollectPrefetchedHunk();
+		if (cache_index.find(number) != cache_index.end()) {
+			return;
+		}
+	}
+	prefetch_number = number;
+	prefetch = std::async(std::launch::async, [this, number] {
+		return DecompressHunk(number, prefetch_hunk);
+	});
+}
+
+const ChdImage::Hunk* ChdImage::GetHunk(const uint32_t number)
+{
+	if (prefetch.valid() && prefetch_number == number) {
+		CollectPrefetchedHunk();
+	}
+
+	auto it = cache_index.find(number);
+	if (it == cache_index.end()) {
+		Hunk hunk = {};
+		if (!DecompressHunk(number, hunk)) {
+			return nullptr;
+		}
+		CacheHunk(number, std::move(hunk));
+		it = cache_index.find(number);
+	} else {
+		cached_hunks.splice(cached_hunks.begin(), cached_hunks, it->second);
+	}
+	PrefetchHunk(number + 1);
+	return &it->second->data;
+}
+
+bool ChdImage::ReadFrame(const uint32_t frame, const uint32_t offset,
+                         uint8_t* data, const uint32_t num_bytes)
+{
+	if (frame >= num_frames || offset + num_bytes > FrameSize) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(cache_mutex);
+
+	const auto hunk = GetHunk(frame / frames_per_hunk);
+	if (!hunk) {
+		return false;
+	}
+	const auto frame_offset = (frame % frames_per_hunk) * FrameSize;
+	std::memcpy(data, hunk->data() + frame_offset + offset, num_bytes);
+	return true;
+}
@@ -0,0 +1,131 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "dir_prefetcher.h"
+
+#include <deque>
+
+#include "cross.h"
+#include "host_threads.h"
+
+DirPrefetcher::DirPrefetcher(const std::string& base_dir, const size_t max_entries)
+{
+	thread = std::thread(&DirPrefetcher::Run, this, base_dir, max_entries);
+	HOST_THREADS_Apply(thread, HostThreadGroup::Worker);
+}
+
+DirPrefetcher::~DirPrefetcher()
+{
+	stop_requested = true;
+	Wait();
+}
+
+void DirPrefetcher::Wait()
+{
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+static std::string with_trailing_separator(std::string path)
+{
+	if (!path.empty() && path.back() != CROSS_FILESPLIT) {
+		path += CROSS_FILESPLIT;
+	}
+	return path;
+}
+
+void DirPrefetcher::Run(std::string base_dir, const size_t max_entries)
+{
+	std::deque<std::string> pending = {with_trailing_separator(std::move(base_dir))};
+	size_t num_entries = 0;
+
+	while (!pending.empty() && !stop_requested && num_entries < max_entries) {
+		const auto dir = std::move(pending.front());
+		pending.pop_front();
+
+		std::error_code ec = {};
+
+		// Taken first, so changes made while listing drop the listing
+		Listing listing = {};
+		listing.last_write_time = std_fs::last_write_time(dir, ec);
+		if (ec) {
+			continue;
+		}
+
+		// The drive cache expects these, as the host's listings have them
+		listing.entries.push_back({".", true});
+		listing.entries.push_back({"..", true});
+
+		std_fs::directory_iterator it(dir, ec);
+		for (; !ec && it != std_fs::directory_iterator(); it.increment(ec)) {
+			if (stop_requested) {
+				return;
+			}
+			const auto name = it->path().filename().string();
+			const auto is_directory = it->is_directory(ec);
+			if (ec) {
+				ec.clear();
+				continue;
+			}
+			listing.entries.push_back({name, is_directory});
+
+			// Symlinked directories could loop back up the tree
+			if (is_directory && !it->is_symlink(ec)) {
+				pending.push_back(dir + name + CROSS_FILESPLIT);
+			}
+			ec.clear();
+		}
+		if (ec) {
+			continue;
+		}
+
+		num_entries += listing.entries.size();
+
+		const std::lock_guard lock(mutex);
+		listings.insert_or_assign(dir, std::move(listing));
+	}
+}
+
+std::optional<std::vector<DirPrefetcher::Entry>> DirPrefetcher::Take(const std::string& dir)
+{
+	Listing listing = {};
+	{
+		const std::lock_guard lock(mutex);
+		const auto it = listings.find(dir);
+		if (it == listings.end()) {
+			return {};
+		}
+		listing = std::move(it->second);
+		listings.erase(it);
+	}
+
+	std::error_code ec = {};
+	if (std_fs::last_write_time(dir, ec) != listing.last_write_time || ec) {
+		return {};
+	}
+	return std::move(listing.entries);
+}
+
+size_t DirPrefetcher::GetNumListings()
+{
+	const std::lock_guard lock(mutex);
+	return listings.size();
+}
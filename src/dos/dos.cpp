@@ -29,6 +29,7 @@
 #include "callback.h"
 #include "dos_locale.h"
 #include "drives.h"
+#include "guest_stats.h"
 #include "mem.h"
 #include "program_mount_common.h"
 #include "regs.h"
@@ -158,6 +159,8 @@ static inline void overhead() {
 
 #define DOSNAMEBUF 256
 static Bitu DOS_21Handler(void) {
+	++guest_stats.int21_calls[reg_ah];
+
 	if (((reg_ah != 0x50) && (reg_ah != 0x51) && (reg_ah != 0x62) && (reg_ah != 0x64)) && (reg_ah<0x6c)) {
 		DOS_PSP psp(dos.psp());
 		psp.SetStack(RealMake(SegValue(ss),reg_sp-18));
@@ -361,8 +364,13 @@ static Bitu DOS_21Handler(void) {
 //TODO Find out the values for when reg_al!=0
 //TODO Hope this doesn't do anything special
 	case 0x0d:		/* Disk Reset */
-//Sure let's reset a virtual disk
-		break;	
+		// Write back the buffered sectors of the disk images
+		for (const auto& drive : Drives) {
+			if (drive) {
+				drive->FlushBuffers();
+			}
+		}
+		break;
 	case 0x0e:		/* Select Default Drive */
 		DOS_SetDefaultDrive(reg_dl);
 		reg_al=DOS_DRIVES;
@@ -754,8 +762,7 @@ static Bitu DOS_21Handler(void) {
 		{ 
 			uint16_t toread=DOS_GetAmount();
 			dos.echo=true;
-			if (DOS_ReadFile(reg_bx,dos_copybuf,&toread)) {
-				MEM_BlockWrite(SegPhys(ds)+reg_dx,dos_copybuf,toread);
+			if (DOS_ReadFileToMemory(reg_bx, SegPhys(ds) + reg_dx, &toread)) {
 				reg_ax=toread;
 				CALLBACK_SCF(false);
 			} else {
@@ -503,6 +503,24 @@ void DOS_DTA::GetSearchParams(FatAttributeFlags& attr, char* pattern) const
 	pattern[12]=0;
 }
 
+std::string DOS_DTA::ToSearchPattern(const char* pattern)
+{
+	// Same as a SetupSearch followed by GetSearchParams
+	std::string search_pattern = "        .   ";
+
+	const char* find_ext = strchr(pattern, '.');
+	const auto name_len  = find_ext ? static_cast<size_t>(find_ext - pattern)
+	                                : strlen(pattern);
+	search_pattern.replace(0, std::min<size_t>(name_len, 8), pattern,
+	                       std::min<size_t>(name_len, 8));
+	if (find_ext) {
+		++find_ext;
+		const auto ext_len = std::min<size_t>(strlen(find_ext), 3);
+		search_pattern.replace(9, ext_len, find_ext, ext_len);
+	}
+	return search_pattern;
+}
+
 DOS_FCB::DOS_FCB(uint16_t seg, uint16_t off, bool allow_extended)
         : MemStruct(seg, off),
           extended(false),
@@ -400,19 +400,16 @@ bool DOS_Execute(char * name,PhysPt block_pt,uint8_t flags) {
 	if (iscom) {	/* COM Load 64k - 256 bytes max */
 		pos=0;DOS_SeekFile(fhandle,&pos,DOS_SEEK_SET);	
 		readsize=0xffff-256;
-		DOS_ReadFile(fhandle,loadbuf,&readsize);
-		MEM_BlockWrite(loadaddress,loadbuf,readsize);
+		DOS_ReadFileToMemory(fhandle, loadaddress, &readsize);
 	} else {	/* EXE Load in 32kb blocks and then relocate */
 		pos=headersize;DOS_SeekFile(fhandle,&pos,DOS_SEEK_SET);	
 		while (imagesize>0x7FFF) {
-			readsize=0x8000;DOS_ReadFile(fhandle,loadbuf,&readsize);
-			MEM_BlockWrite(loadaddress,loadbuf,readsize);
+			readsize=0x8000;DOS_ReadFileToMemory(fhandle, loadaddress, &readsize);
 //			if (readsize!=0x8000) LOG(LOG_EXEC,LOG_NORMAL)("Illegal header");
 			loadaddress+=0x8000;imagesize-=0x8000;
 		}
 		if (imagesize>0) {
-			readsize=(uint16_t)imagesize;DOS_ReadFile(fhandle,loadbuf,&readsize);
-			MEM_BlockWrite(loadaddress,loadbuf,readsize);
+			readsize=(uint16_t)imagesize;DOS_ReadFileToMemory(fhandle, loadaddress, &readsize);
 //			if (readsize!=imagesize) LOG(LOG_EXEC,LOG_NORMAL)("Illegal header");
 		}
 		/* Relocate the exe image */
@@ -48,6 +48,19 @@ std::array<std::unique_ptr<DOS_File>, DOS_FILES> Files = {};
 
 std::array<std::shared_ptr<DOS_Drive>, DOS_DRIVES> Drives = {};
 
+// Counts the changes to the drives, directories, and file names
+static uint32_t files_generation = 0;
+
+void DOS_NotifyFilesChanged()
+{
+	++files_generation;
+}
+
+uint32_t DOS_GetFilesGeneration()
+{
+	return files_generation;
+}
+
 enum class FileSharingMode
 {
 	Compatibility,
@@ -217,6 +230,7 @@ uint8_t DOS_GetDefaultDrive(void) {
 void DOS_SetDefaultDrive(uint8_t drive) {
 //	if (drive<=DOS_DRIVES && ((drive<2) || Drives[drive])) DOS_SDA(DOS_SDA_SEG,DOS_SDA_OFS).SetDrive(drive);
 	if (drive<DOS_DRIVES && ((drive<2) || Drives[drive])) {dos.current_drive = drive; DOS_SDA(DOS_SDA_SEG,DOS_SDA_OFS).SetDrive(drive);}
+	DOS_NotifyFilesChanged();
 }
 
 bool DOS_MakeName(const char* const name, char* const fullname, uint8_t* drive)
@@ -424,6 +438,8 @@ static bool PathExists(const char *name);
 
 bool DOS_ChangeDir(const char* const dir)
 {
+	DOS_NotifyFilesChanged();
+
 	uint8_t drive;
 	char fulldir[DOS_PATHLENGTH];
 	const auto exists_and_set = DOS_MakeName(dir, fulldir, &drive) &&
@@ -437,6 +453,8 @@ bool DOS_ChangeDir(const char* const dir)
 
 bool DOS_MakeDir(const char* const dir)
 {
+	DOS_NotifyFilesChanged();
+
 	uint8_t drive;char fulldir[DOS_PATHLENGTH];
 	size_t len = strlen(dir);
 	if(!len || dir[len-1] == '\\') {
@@ -466,6 +484,8 @@ bool DOS_MakeDir(const char* const dir)
 
 bool DOS_RemoveDir(const char* const dir)
 {
+	DOS_NotifyFilesChanged();
+
 	/* We need to do the test before the removal as can not rely on
 	 * the host to forbid removal of the current directory.
 	 * We never change directory. Everything happens in the drives.
@@ -522,6 +542,8 @@ static bool PathExists(const char* const name)
 
 bool DOS_Rename(const char* const oldname, const char* const newname)
 {
+	DOS_NotifyFilesChanged();
+
 	uint8_t driveold;char fullold[DOS_PATHLENGTH];
 	uint8_t drivenew;char fullnew[DOS_PATHLENGTH];
 	if (!DOS_MakeName(oldname,fullold,&driveold)) return false;
@@ -569,13 +591,13 @@ bool DOS_Rename(const char* const oldname, const char* const newname)
 	return false;
 }
 
-bool DOS_FindFirst(const char* search, FatAttributeFlags attr, bool fcb_findfirst)
+// Splits a search into its drive, directory and pattern, the common part of
+// DOS_FindFirst and DOS_FindAll
+static bool prepare_search(const char* search, const FatAttributeFlags attr,
+                           uint8_t& drive, char (&dir)[DOS_PATHLENGTH],
+                           char (&pattern)[DOS_PATHLENGTH], bool& is_device)
 {
-	LOG(LOG_FILES, LOG_NORMAL)
-	("file search attributes %X name %s", attr._data, search);
-	DOS_DTA dta(dos.dta());
-	uint8_t drive;char fullsearch[DOS_PATHLENGTH];
-	char dir[DOS_PATHLENGTH];char pattern[DOS_PATHLENGTH];
+	char fullsearch[DOS_PATHLENGTH];
 	size_t len = strlen(search);
 
 	const bool is_root = (len > 2) && (search[len - 2] == ':') &&
@@ -589,7 +611,7 @@ bool DOS_FindFirst(const char* search, FatAttributeFlags attr, bool fcb_findfirs
 	}
 	if (!DOS_MakeName(search,fullsearch,&drive)) return false;
 	//Check for devices. FindDevice checks for leading subdir as well
-	bool device = (DOS_FindDevice(search) != DOS_DEVICES);
+	is_device = (DOS_FindDevice(search) != DOS_DEVICES);
 
 	/* Split the search in dir and pattern */
 	char * find_last;
@@ -602,11 +624,25 @@ bool DOS_FindFirst(const char* search, FatAttributeFlags attr, bool fcb_findfirs
 		safe_strcpy(pattern, find_last + 1);
 		safe_strcpy(dir, fullsearch);
 	}
+	return true;
+}
+
+bool DOS_FindFirst(const char* search, FatAttributeFlags attr, bool fcb_findfirst)
+{
+	LOG(LOG_FILES, LOG_NORMAL)
+	("file search attributes %X name %s", attr._data, search);
+	DOS_DTA dta(dos.dta());
+	uint8_t drive;
+	char dir[DOS_PATHLENGTH];char pattern[DOS_PATHLENGTH];
+	bool device = false;
+	if (!prepare_search(search, attr, drive, dir, pattern, device)) {
+		return false;
+	}
 
 	dta.SetupSearch(drive, attr, pattern);
 
 	if(device) {
-		find_last = strrchr(pattern,'.');
+		char* find_last = strrchr(pattern,'.');
 		if(find_last) *find_last = 0;
 		//TODO use current date and time
 		dta.SetResult(pattern, 0, 0, 0, FatAttributeFlags::Device);
@@ -621,6 +657,70 @@ bool DOS_FindFirst(const char* search, FatAttributeFlags attr, bool fcb_findfirs
 	return false;
 }
 
+bool DOS_FindAll(const char* search, const FatAttributeFlags attr,
+                 std::vector<DOS_DTA::Result>& results)
+{
+	uint8_t drive;
+	char dir[DOS_PATHLENGTH];
+	char pattern[DOS_PATHLENGTH];
+	bool device = false;
+	if (!prepare_search(search, attr, drive, dir, pattern, device)) {
+		return false;
+	}
+
+	auto add_result = [&results](const char* name,
+	                             const uint32_t size,
+	                             const uint16_t date,
+	                             const uint16_t time,
+	                             const FatAttributeFlags found_attr) {
+		DOS_DTA::Result result = {};
+		result.name = name;
+		result.size = size;
+		result.date = date;
+		result.time = time;
+		result.attr = found_attr;
+		results.emplace_back(std::move(result));
+	};
+
+	if (device) {
+		char* find_last = strrchr(pattern, '.');
+		if (find_last) {
+			*find_last = 0;
+		}
+		add_result(pattern, 0, 0, 0, FatAttributeFlags::Device);
+		return true;
+	}
+
+	// The drive matches the names against the pattern as stored in the DTA
+	const auto found = Drives.at(drive)->FindAll(dir,
+	                                             attr,
+	                                             DOS_DTA::ToSearchPattern(pattern).c_str(),
+	                                             add_result);
+	if (found) {
+		return *found;
+	}
+
+	// Otherwise search through the shell's internal DTA
+	const RealPt save_dta = dos.dta();
+	dos.dta(dos.tables.tempdta);
+	DOS_DTA dta(dos.dta());
+
+	dta.SetupSearch(drive, attr, pattern);
+
+	bool has_next_entry = Drives.at(drive)->FindFirst(dir, dta);
+	const bool has_entries = has_next_entry;
+	while (has_next_entry) {
+		DOS_DTA::Result result = {};
+		dta.GetResult(result);
+		results.emplace_back(std::move(result));
+
+		has_next_entry = Drives.at(drive)->FindNext(dta);
+	}
+
+	dos.dta(save_dta);
+	return has_entries;
+}
+
 bool DOS_FindNext(void) {
 	DOS_DTA dta(dos.dta());
 	uint8_t i = dta.GetSearchDrive();
@@ -667,6 +767,28 @@ bool DOS_ReadFile(uint16_t entry,uint8_t * data,uint16_t * amount,bool fcb) {
 	return ret;
 }
 
+// Reads straight into guest memory when it's plain host memory, saving the
+// copy through the bounce buffer
+bool DOS_ReadFileToMemory(const uint16_t entry, const PhysPt dest, uint16_t* amount)
+{
+	const auto handle = RealHandle(entry);
+
+	// Reading from devices can run guest code, which could remap the
+	// memory while it's being read into
+	const auto is_file = handle < DOS_FILES && Files[handle] &&
+	                     (Files[handle]->GetInformation() & 0x80) == 0;
+
+	if (const auto host_ptr = is_file ? MEM_GetHostWritePtr(dest, *amount)
+	                                  : nullptr) {
+		return DOS_ReadFile(entry, host_ptr, amount);
+	}
+	if (!DOS_ReadFile(entry, dos_copybuf, amount)) {
+		return false;
+	}
+	MEM_BlockWrite(dest, dos_copybuf, *amount);
+	return true;
+}
+
 bool DOS_WriteFile(uint16_t entry,uint8_t * data,uint16_t * amount,bool fcb) {
 	uint32_t handle = fcb?entry:RealHandle(entry);
 	if (handle>=DOS_FILES) {
@@ -760,12 +882,18 @@ bool DOS_FlushFile(uint16_t entry) {
 		return false;
 	};
 	LOG(LOG_DOSMISC,LOG_NORMAL)("FFlush used.");
+	const auto drive = Files[handle]->GetDrive();
+	if (drive < DOS_DRIVES && Drives[drive]) {
+		Drives[drive]->FlushBuffers();
+	}
 	return true;
 }
 
 bool DOS_CreateFile(const char* name, FatAttributeFlags attributes,
                     uint16_t* entry, bool fcb)
 {
+	DOS_NotifyFilesChanged();
+
 	// Creation of a device is the same as opening it
 	// Tc201 installer
 	if (DOS_FindDevice(name) != DOS_DEVICES)
@@ -957,6 +1085,8 @@ bool DOS_OpenFileExtended(const char* name, uint16_t flags,
 
 bool DOS_UnlinkFile(const char* const name)
 {
+	DOS_NotifyFilesChanged();
+
 	char fullname[DOS_PATHLENGTH];
 	uint8_t drive;
 
@@ -21,7 +21,10 @@
 
 #include <map>
 #include <memory>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "../ints/int10.h"
 #include "autoexec.h"
@@ -193,76 +196,113 @@ static void log_layout_read_error()
 	            strerror(errno));
 }
 
-static uint32_t read_kcl_file(const FILE_unique_ptr &kcl_file, const char *layout_id, bool first_id_only)
-{
-	assert(kcl_file);
-	assert(layout_id);
-	static uint8_t rbuf[8192];
+// Index of the layouts stored in a keyboard library (KCL) file
+struct KclLayoutEntry {
+	uint32_t position = 0;
 
-	// check ID-bytes of file
-	auto dr = fread(rbuf, sizeof(uint8_t), 7, kcl_file.get());
-	if ((dr < 7) || (rbuf[0] != 0x4b) || (rbuf[1] != 0x43) || (rbuf[2] != 0x46)) {
-		return 0;
-	}
+	// The first language code of the layout, and all the codes it is
+	// known under, including the ones with their numeric IDs appended
+	std::string main_code          = {};
+	std::vector<std::string> codes = {};
+};
 
-	const auto seek_pos = 7 + rbuf[6];
-	if (fseek(kcl_file.get(), seek_pos, SEEK_SET) != 0) {
-		log_layout_read_error();
-		return 0;
-	}
+using kcl_index_t = std::vector<KclLayoutEntry>;
 
-	for (;;) {
-		const auto cur_pos = ftell(kcl_file.get());
-		dr = fread(rbuf, sizeof(uint8_t), 5, kcl_file.get());
-		if (dr < 5)
-			break;
-		uint16_t len=host_readw(&rbuf[0]);
+static kcl_index_t build_kcl_index(const std::string& data)
+{
+	kcl_index_t index = {};
 
-		uint8_t data_len=rbuf[2];
-		assert (data_len < UINT8_MAX);
-		static_assert(UINT8_MAX < sizeof(rbuf), "rbuf too small");
+	auto byte_at = [&data](const size_t pos) {
+		return static_cast<uint8_t>(data[pos]);
+	};
 
-		char lng_codes[258];
+	// check ID-bytes of file
+	if (data.size() < 7 || byte_at(0) != 0x4b || byte_at(1) != 0x43 ||
+	    byte_at(2) != 0x46) {
+		return index;
+	}
 
-		constexpr int8_t lang_codes_offset = -2;
-		if (fseek(kcl_file.get(), lang_codes_offset, SEEK_CUR) != 0) {
-			log_layout_read_error();
-			return 0;
-		}
+	size_t cur_pos = 7 + byte_at(6);
+	while (cur_pos + 5 <= data.size()) {
+		const uint16_t len = host_readw(reinterpret_cast<const uint8_t*>(
+		        data.data() + cur_pos));
+		const uint8_t data_len = byte_at(cur_pos + 2);
+
+		KclLayoutEntry entry = {};
+		entry.position       = check_cast<uint32_t>(cur_pos);
 
 		// get all language codes for this layout
-		for (auto i = 0; i < data_len;) {
-			if (fread(rbuf, sizeof(uint8_t), 2, kcl_file.get()) != 2) {
-				break;
-			}
-			uint16_t lcnum = host_readw(&rbuf[0]);
-			i+=2;
-			uint16_t lng_pos = 0;
-			for (;i<data_len;) {
-				if (fread(rbuf, sizeof(uint8_t), 1, kcl_file.get()) != 1) {
+		auto pos = cur_pos + 3;
+		for (auto i = 0; i < data_len && pos + 2 <= data.size();) {
+			const uint16_t lcnum = host_readw(reinterpret_cast<const uint8_t*>(
+			        data.data() + pos));
+			pos += 2;
+			i += 2;
+
+			std::string code = {};
+			for (; i < data_len && pos < data.size();) {
+				const auto c = data[pos++];
+				i++;
+				if (c == ',') {
 					break;
 				}
-				i++;
-				if (((char)rbuf[0])==',') break;
-				lng_codes[lng_pos++] = (char)rbuf[0];
+				code += c;
 			}
-			lng_codes[lng_pos] = 0;
-			if (strcasecmp(lng_codes, layout_id)==0) {
-				// language ID found in file, return file position
-				return check_cast<uint32_t>(cur_pos);
+			if (entry.codes.empty()) {
+				entry.main_code = code;
 			}
-			if (first_id_only) break;
+			entry.codes.push_back(code);
 			if (lcnum) {
-				sprintf(&lng_codes[lng_pos], "%d", lcnum);
-				if (strcasecmp(lng_codes, layout_id)==0) {
-					// language ID found in file, return file position
-					return check_cast<uint32_t>(cur_pos);
-				}
+				entry.codes.push_back(code + std::to_string(lcnum));
+			}
+		}
+		index.emplace_back(std::move(entry));
+
+		cur_pos += 3 + len;
+	}
+	return index;
+}
+
+// Returns the index of the given KCL file; the index is built once for every
+// distinct file content and reused by all the subsequent layout lookups
+static const kcl_index_t& get_kcl_index(const FILE_unique_ptr& kcl_file)
+{
+	static std::map<std::pair<size_t, size_t>, kcl_index_t> cached_indexes = {};
+
+	std::string data = {};
+
+	char buf[8192];
+	size_t num_read = 0;
+	while ((num_read = fread(buf, 1, sizeof(buf), kcl_file.get())) > 0) {
+		data.append(buf, num_read);
+	}
+
+	const auto key = std::make_pair(data.size(), std::hash<std::string>{}(data));
+
+	const auto it = cached_indexes.find(key);
+	if (it != cached_indexes.end()) {
+		return it->second;
+	}
+	return cached_indexes.emplace(key, build_kcl_index(data)).first->second;
+}
+
+static uint32_t read_kcl_file(const FILE_unique_ptr &kcl_file, const char *layout_id, bool first_id_only)
+{
+	assert(kcl_file);
+	assert(layout_id);
+
+	for (const auto& entry : get_kcl_index(kcl_file)) {
+		if (first_id_only) {
+			if (!entry.codes.empty() && iequals(entry.main_code, layout_id)) {
+				return entry.position;
 			}
+			continue;
 		}
-		if (fseek(kcl_file.get(), cur_pos + 3 + len, SEEK_SET) != 0) {
-			log_layout_read_error();
-			return 0;
+		for (const auto& code : entry.codes) {
+			if (iequals(code, layout_id)) {
+				// language ID found in file, return file position
+				return entry.position;
+			}
 		}
 	}
 	return 0;
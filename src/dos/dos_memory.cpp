@@ -24,7 +24,9 @@
 #include "mem.h"
 #include "support.h"
 
+#include <algorithm>
 #include <string_view>
+#include <vector>
 
 enum class McbFaultStrategy { Deny, Repair, Report, Allow };
 
@@ -97,8 +99,107 @@ static bool triage_block(DOS_MCB &mcb, const uint8_t repair_type)
 	return true;
 }
 
+// Index of the MCB chain
+// ~~~~~~~~~~~~~~~~~~~~~~
+// A copy of the headers of the conventional memory chain (continuing into the
+// UMBs when they're linked), so allocations can merge and search the free
+// blocks without walking the chain in guest memory repeatedly. Programs are
+// free to edit the MCBs directly, so the index is only trusted after every
+// entry has been checked against the guest-visible chain; if anything differs
+// it's rebuilt by a regular walk. It's never built for chains with corrupt
+// MCB types, so those are always handled by the fault strategy code.
+struct McbIndexEntry {
+	uint16_t segment = 0;
+	uint16_t psp_segment = 0;
+	uint16_t size = 0;
+	uint8_t type = 0;
+};
+
+static std::vector<McbIndexEntry> mcb_index = {};
+
+static McbIndexEntry read_index_entry(const uint16_t segment)
+{
+	const DOS_MCB mcb(segment);
+	return {segment, mcb.GetPSPSeg(), mcb.GetSize(), mcb.GetType()};
+}
+
+static bool is_index_current()
+{
+	if (mcb_index.empty() || mcb_index.front().segment != dos.firstMCB) {
+		return false;
+	}
+	// The segments follow from the sizes, so matching headers also means
+	// the chain is laid out the same way
+	for (const auto& entry : mcb_index) {
+		const auto current = read_index_entry(entry.segment);
+		if (current.type != entry.type ||
+		    current.psp_segment != entry.psp_segment ||
+		    current.size != entry.size) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void rebuild_index()
+{
+	mcb_index.clear();
+
+	auto segment = dos.firstMCB;
+	for (;;) {
+		const auto entry = read_index_entry(segment);
+		if (entry.type != middle_mcb_type && entry.type != ending_mcb_type) {
+			mcb_index.clear();
+			return;
+		}
+		mcb_index.push_back(entry);
+		if (entry.type == ending_mcb_type) {
+			return;
+		}
+		const auto next_segment = segment + entry.size + 1;
+		if (next_segment > UINT16_MAX) {
+			// a chain wrapping around the address space is as good
+			// as corrupt
+			mcb_index.clear();
+			return;
+		}
+		segment = static_cast<uint16_t>(next_segment);
+	}
+}
+
+static void invalidate_index()
+{
+	mcb_index.clear();
+}
+
+// Merges the adjacent free blocks of a current index, and their MCBs
+static void compress_index()
+{
+	for (size_t i = 0; i + 1 < mcb_index.size();) {
+		auto& entry      = mcb_index[i];
+		const auto& next = mcb_index[i + 1];
+		if (entry.psp_segment != MCB_FREE || next.psp_segment != MCB_FREE) {
+			++i;
+			continue;
+		}
+		entry.size = static_cast<uint16_t>(entry.size + next.size + 1);
+		entry.type = next.type;
+
+		DOS_MCB mcb(entry.segment);
+		mcb.SetSize(entry.size);
+		mcb.SetType(entry.type);
+
+		mcb_index.erase(mcb_index.begin() + static_cast<ptrdiff_t>(i) + 1);
+	}
+}
+
 static void DOS_CompressMemory()
 {
+	if (is_index_current()) {
+		compress_index();
+		return;
+	}
+
 	uint16_t mcb_segment = dos.firstMCB;
 	DOS_MCB mcb(mcb_segment);
 	DOS_MCB mcb_next(0);
@@ -117,6 +218,7 @@ static void DOS_CompressMemory()
 			mcb.SetPt(mcb_segment);
 		}
 	}
+	rebuild_index();
 }
 
 void DOS_FreeProcessMemory(uint16_t pspseg) {
@@ -172,6 +274,130 @@ bool DOS_SetMemAllocStrategy(const uint16_t strat)
 	return false;
 }
 
+// Splits the free block of the index entry in two, allocating its first part
+static void allocate_index_front(const size_t index, const uint16_t blocks,
+                                 const char* psp_name)
+{
+	auto& entry = mcb_index[index];
+
+	const McbIndexEntry rest = {static_cast<uint16_t>(entry.segment + blocks + 1),
+	                            MCB_FREE,
+	                            static_cast<uint16_t>(entry.size - blocks - 1),
+	                            entry.type};
+	DOS_MCB mcb_next(rest.segment);
+	mcb_next.SetPSPSeg(rest.psp_segment);
+	mcb_next.SetType(rest.type);
+	mcb_next.SetSize(rest.size);
+
+	entry.size        = blocks;
+	entry.type        = middle_mcb_type;
+	entry.psp_segment = dos.psp();
+
+	DOS_MCB mcb(entry.segment);
+	mcb.SetSize(entry.size);
+	mcb.SetType(entry.type);
+	mcb.SetPSPSeg(entry.psp_segment);
+	mcb.SetFileName(psp_name);
+
+	mcb_index.insert(mcb_index.begin() + static_cast<ptrdiff_t>(index) + 1, rest);
+}
+
+// Splits the free block of the index entry in two, allocating its last part
+static void allocate_index_back(const size_t index, const uint16_t blocks,
+                                const char* psp_name)
+{
+	auto& entry = mcb_index[index];
+
+	const McbIndexEntry allocated = {
+	        static_cast<uint16_t>(entry.segment + entry.size - blocks),
+	        dos.psp(),
+	        blocks,
+	        entry.type};
+	DOS_MCB mcb_next(allocated.segment);
+	mcb_next.SetSize(allocated.size);
+	mcb_next.SetType(allocated.type);
+	mcb_next.SetPSPSeg(allocated.psp_segment);
+	mcb_next.SetFileName(psp_name);
+
+	entry.size = static_cast<uint16_t>(entry.size - blocks - 1);
+	entry.type = middle_mcb_type;
+
+	DOS_MCB mcb(entry.segment);
+	mcb.SetSize(entry.size);
+	mcb.SetPSPSeg(MCB_FREE);
+	mcb.SetType(entry.type);
+
+	mcb_index.insert(mcb_index.begin() + static_cast<ptrdiff_t>(index) + 1,
+	                 allocated);
+}
+
+// The search of DOS_AllocateMemory over the free blocks of a current index
+static bool allocate_from_index(uint16_t* segment, uint16_t* blocks,
+                                const uint16_t mem_strat, const char* psp_name)
+{
+	constexpr auto NotFound = SIZE_MAX;
+
+	uint16_t bigsize = 0;
+	size_t found     = NotFound;
+
+	for (size_t i = 0; i < mcb_index.size(); ++i) {
+		auto& entry = mcb_index[i];
+		if (entry.psp_segment != MCB_FREE) {
+			continue;
+		}
+		if (entry.size < *blocks) {
+			bigsize = std::max(bigsize, entry.size);
+		} else if (entry.size == *blocks && (mem_strat & 0x3f) < 2) {
+			/* MCB fits precisely, use it if search strategy is firstfit or bestfit */
+			entry.psp_segment = dos.psp();
+			DOS_MCB(entry.segment).SetPSPSeg(entry.psp_segment);
+			*segment = entry.segment + 1;
+			return true;
+		} else {
+			switch (mem_strat & 0x3f) {
+			case 0: /* firstfit */
+				allocate_index_front(i, *blocks, psp_name);
+				*segment = mcb_index[i].segment + 1;
+				return true;
+			case 1: /* bestfit */
+				if (found == NotFound || entry.size < mcb_index[found].size) {
+					found = i;
+				}
+				break;
+			default: /* everything else is handled as lastfit by dos */
+				found = i;
+				break;
+			}
+		}
+	}
+
+	if (found == NotFound) {
+		/* no fitting MCB found, return size of largest block */
+		*blocks = bigsize;
+		DOS_SetError(DOSERR_INSUFFICIENT_MEMORY);
+		return false;
+	}
+
+	auto& entry = mcb_index[found];
+	if ((mem_strat & 0x3f) == 0x01) {
+		/* bestfit, allocate block at the beginning of the MCB */
+		allocate_index_front(found, *blocks, psp_name);
+		*segment = mcb_index[found].segment + 1;
+	} else if (entry.size == *blocks) {
+		/* lastfit using the whole block */
+		entry.psp_segment = dos.psp();
+		DOS_MCB mcb(entry.segment);
+		mcb.SetPSPSeg(entry.psp_segment);
+		mcb.SetFileName(psp_name);
+		*segment = entry.segment + 1;
+	} else {
+		/* lastfit, allocate block at the end of the MCB */
+		allocate_index_back(found, *blocks, psp_name);
+		*segment = mcb_index[found + 1].segment + 1;
+	}
+	return true;
+}
+
 bool DOS_AllocateMemory(uint16_t * segment,uint16_t * blocks) {
 	DOS_CompressMemory();
 	uint16_t bigsize=0;
@@ -190,6 +416,13 @@ bool DOS_AllocateMemory(uint16_t * segment,uint16_t * blocks) {
 	DOS_MCB psp_mcb(dos.psp()-1);
 	char psp_name[9];
 	psp_mcb.GetFileName(psp_name);
+
+	// The index covers the chain starting at the first MCB; allocations
+	// from the separate UMB chain take the regular walk
+	if (!mcb_index.empty() && !((mem_strat & 0xc0) && (umb_start == umb_start_seg))) {
+		return allocate_from_index(segment, blocks, mem_strat, psp_name);
+	}
+
 	uint16_t found_seg=0,found_seg_size=0;
 	for (;;) {
 		mcb.SetPt(mcb_segment);
@@ -317,6 +550,7 @@ bool DOS_ResizeMemory(uint16_t segment,uint16_t * blocks) {
 			return true;
 		}
 		/* Shrinking MCB */
+		invalidate_index();
 		DOS_MCB	mcb_new_next(segment+(*blocks));
 		mcb.SetSize(*blocks);
 		mcb_new_next.SetType(mcb.GetType());
@@ -332,6 +566,7 @@ bool DOS_ResizeMemory(uint16_t segment,uint16_t * blocks) {
 		return true;
 	}
 	/* MCB will grow, try to join with following MCB */
+	invalidate_index();
 	if (mcb.GetType() != ending_mcb_type) {
 		if (mcb_next.GetPSPSeg()==MCB_FREE) {
 			total+=mcb_next.GetSize()+1;
@@ -385,6 +620,17 @@ bool DOS_FreeMemory(uint16_t segment) {
 	}
 	mcb.SetPSPSeg(MCB_FREE);
 //	DOS_CompressMemory();
+
+	// Keep the index in sync, the blocks get merged by the next allocation
+	const auto entry = std::lower_bound(mcb_index.begin(),
+	                                    mcb_index.end(),
+	                                    segment - 1,
+	                                    [](const McbIndexEntry& e, const int seg) {
+		                                    return e.segment < seg;
+	                                    });
+	if (entry != mcb_index.end() && entry->segment == segment - 1) {
+		entry->psp_segment = MCB_FREE;
+	}
 	return true;
 }
 
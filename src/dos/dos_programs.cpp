@@ -44,6 +44,7 @@
 #include "program_rescan.h"
 #include "program_serial.h"
 #include "program_setver.h"
+#include "program_stats.h"
 #include "program_subst.h"
 #include "program_tree.h"
 
@@ -99,6 +100,7 @@ void Add_VFiles(const bool add_autoexec)
 	PROGRAMS_MakeFile("RESCAN.COM", ProgramCreate<RESCAN>);
 	PROGRAMS_MakeFile("SERIAL.COM", ProgramCreate<SERIAL>);
 	PROGRAMS_MakeFile("SETVER.EXE", ProgramCreate<SETVER>);
+	PROGRAMS_MakeFile("STATS.COM", ProgramCreate<STATS>);
 	PROGRAMS_MakeFile("SUBST.EXE", ProgramCreate<SUBST>);
 	PROGRAMS_MakeFile("TREE.COM", ProgramCreate<TREE>);
 
@@ -24,8 +24,10 @@
 #include <vector>
 
 #include "cross.h"
+#include "dir_prefetcher.h"
 #include "dos_inc.h"
 #include "drives.h"
+#include "host_dir_watcher.h"
 #include "string_utils.h"
 #include "support.h"
 
@@ -37,26 +39,13 @@ bool SortByName(DOS_Drive_Cache::CFileInfo* const a,
 	return strcmp(a->shortname, b->shortname) < 0;
 }
 
-bool SortByNameRev(DOS_Drive_Cache::CFileInfo* const a,
-                   DOS_Drive_Cache::CFileInfo* const b)
+// Inserts an entry into a list sorted by short name, after any entries with
+// the same short name
+static void insert_sorted(std::vector<DOS_Drive_Cache::CFileInfo*>& list,
+                          DOS_Drive_Cache::CFileInfo* const info)
 {
-	return strcmp(a->shortname, b->shortname) > 0;
-}
-
-bool SortByDirName(DOS_Drive_Cache::CFileInfo* const a,
-                   DOS_Drive_Cache::CFileInfo* const b)
-{
-	// Directories first...
-	if (a->isDir!=b->isDir) return (a->isDir>b->isDir);	
-	return strcmp(a->shortname,b->shortname)<0;
-}
-
-bool SortByDirNameRev(DOS_Drive_Cache::CFileInfo* const a,
-                      DOS_Drive_Cache::CFileInfo* const b)
-{
-	// Directories first...
-	if (a->isDir!=b->isDir) return (a->isDir>b->isDir);	
-	return strcmp(a->shortname,b->shortname)>0;
+	const auto it = std::upper_bound(list.begin(), list.end(), info, SortByName);
+	list.insert(it, info);
 }
 
 DOS_Drive_Cache::DOS_Drive_Cache(void)
@@ -111,6 +100,8 @@ void DOS_Drive_Cache::Clear(void) {
 }
 
 void DOS_Drive_Cache::EmptyCache(void) {
+	DOS_NotifyFilesChanged();
+
 	// Empty Cache and reinit
 	Clear();
 	dirBase		= new CFileInfo;
@@ -119,6 +110,85 @@ void DOS_Drive_Cache::EmptyCache(void) {
 	if (basePath[0] != 0) SetBaseDir(basePath);
 }
 
+void DOS_Drive_Cache::StartPrefetch()
+{
+	if (basePath[0] != 0) {
+		prefetcher = std::make_unique<DirPrefetcher>(basePath);
+	}
+}
+
+void DOS_Drive_Cache::StartWatching()
+{
+	watcher = std::make_unique<HostDirWatcher>();
+	if (!watcher->IsSupported()) {
+		watcher.reset();
+		return;
+	}
+	if (basePath[0] != 0) {
+		watcher->Watch(basePath);
+	}
+}
+
+// Finds the directory of a host path if it's been cached in, without reading
+// any directories
+DOS_Drive_Cache::CFileInfo* DOS_Drive_Cache::FindCachedDir(const std::string& host_dir)
+{
+	const auto base_len = safe_strlen(basePath);
+	if (host_dir.compare(0, base_len, basePath) != 0) {
+		return nullptr;
+	}
+
+	CFileInfo* dir = dirBase;
+	size_t start   = base_len;
+	while (dir && start < host_dir.size()) {
+		auto end = host_dir.find(CROSS_FILESPLIT, start);
+		if (end == std::string::npos) {
+			end = host_dir.size();
+		}
+		const auto name = host_dir.substr(start, end - start);
+
+		const auto it = std::find_if(dir->fileList.begin(),
+		                             dir->fileList.end(),
+		                             [&](const CFileInfo* info) {
+			                             return info->isDir &&
+			                                    name == info->orgname;
+		                             });
+		dir   = (it != dir->fileList.end()) ? *it : nullptr;
+		start = end + 1;
+	}
+	return (dir && IsCachedIn(dir)) ? dir : nullptr;
+}
+
+// Caches out the directories whose names changed on the host. Changes that
+// the cache already has, like the files that DOS programs create, are
+// skipped.
+void DOS_Drive_Cache::ProcessHostChanges()
+{
+	if (!watcher) {
+		return;
+	}
+	for (const auto& event : watcher->TakeEvents()) {
+		if (event.change == HostDirWatcher::Change::Overflow) {
+			LOG(LOG_DOSMISC, LOG_NORMAL)("DIRCACHE: Lost host changes, emptying the cache");
+			EmptyCache();
+			return;
+		}
+		CFileInfo* dir = FindCachedDir(event.dir);
+		if (!dir || dir->isOverlayDir) {
+			continue;
+		}
+		const auto is_cached = std::any_of(dir->fileList.begin(),
+		                                   dir->fileList.end(),
+		                                   [&](const CFileInfo* info) {
+			                                   return event.name == info->orgname;
+		                                   });
+		const auto is_added = (event.change == HostDirWatcher::Change::Added);
+		if (is_cached != is_added) {
+			CacheOutDir(dir);
+		}
+	}
+}
+
 void DOS_Drive_Cache::SetLabel(const char* vname,bool cdrom,bool allowupdate) {
 /* allowupdate defaults to true. if mount sets a label then allowupdate is 
  * false and will this function return at once after the first call.
@@ -213,6 +283,8 @@ char* DOS_Drive_Cache::GetExpandNameAndNormaliseCase(const char* path)
 }
 
 void DOS_Drive_Cache::AddEntry(const char* path, bool checkExists) {
+	DOS_NotifyFilesChanged();
+
 	// Get Last part...
 	char file	[CROSS_LEN];
 	char expand	[CROSS_LEN];
@@ -249,6 +321,8 @@ void DOS_Drive_Cache::AddEntry(const char* path, bool checkExists) {
 	}
 }
 void DOS_Drive_Cache::AddEntryDirOverlay(const char* path, bool checkExists) {
+	DOS_NotifyFilesChanged();
+
 	// Get Last part...
 	char file	[CROSS_LEN];
 	char expand	[CROSS_LEN];
@@ -355,6 +429,12 @@ void DOS_Drive_Cache::CacheOut(const char* path, bool ignoreLastDir) {
 	}
 
 //	LOG_DEBUG("DIR: Caching out %s : dir %s",expand,dir->orgname);
+	CacheOutDir(dir);
+}
+
+void DOS_Drive_Cache::CacheOutDir(CFileInfo* dir) {
+	DOS_NotifyFilesChanged();
+
 	// delete file objects...
 	//Maybe check if it is a file and then only delete the file and possibly the long name. instead of all objects in the dir.
 	for(uint32_t i=0; i<dir->fileList.size(); i++) {
@@ -688,28 +768,7 @@ void DOS_Drive_Cache::CreateShortName(CFileInfo* curDir, CFileInfo* info) {
 		}
 
 		// keep list sorted for CreateShortNameID to work correctly
-		if (curDir->longNameList.size()>0) {
-			if (!(strcmp(info->shortname,curDir->longNameList.back()->shortname)<0)) {
-				// append at end of list
-				curDir->longNameList.push_back(info);
-			} else {
-				// look for position where to insert this element
-				bool found=false;
-				std::vector<CFileInfo*>::iterator it;
-				for (it=curDir->longNameList.begin(); it!=curDir->longNameList.end(); ++it) {
-					if (strcmp(info->shortname,(*it)->shortname)<0) {
-						found = true;
-						break;
-					}
-				}
-				// Put it in longname list...
-				if (found) curDir->longNameList.insert(it,info);
-				else curDir->longNameList.push_back(info);
-			}
-		} else {
-			// empty file list, append
-			curDir->longNameList.push_back(info);
-		}
+		insert_sorted(curDir->longNameList, info);
 	} else {
 		safe_strcpy(info->shortname, tmpName);
 	}
@@ -727,6 +786,8 @@ DOS_Drive_Cache::CFileInfo* DOS_Drive_Cache::FindDirInfo(const char* path, char*
 	CFileInfo*	curDir = dirBase;
 	uint16_t		id;
 
+	ProcessHostChanges();
+
 	if (save_dir && (strcmp(path,save_path)==0)) {
 		safe_strncpy(expandedPath, save_expanded, CROSS_LEN);
 		return save_dir;
@@ -827,7 +888,14 @@ bool DOS_Drive_Cache::OpenDir(CFileInfo* dir, const char* expand, uint16_t& id)
 		safe_strcat(expandcopy, end);
 	}
 	// open dir
-	if (dirSearch[id]) {
+	if (dirSearch[id] && dirLister) {
+		if (dirLister(expandcopy)) {
+			safe_strcpy(dirPath, expandcopy);
+			return true;
+		}
+		dirSearch[id]->id = MAX_OPENDIRS;
+		dirSearch[id]     = nullptr;
+	} else if (dirSearch[id]) {
 		// open dir
 		dir_information* dirp = open_directory(expandcopy);
 		if (dirp || dir->isOverlayDir) { 
@@ -853,30 +921,8 @@ void DOS_Drive_Cache::CreateEntry(CFileInfo* dir, const char* name, bool is_dire
 	// Check for long filenames...
 	CreateShortName(dir, info);		
 
-	bool found = false;
-
 	// keep list sorted (so GetLongName works correctly, used by CreateShortName in this routine)
-	if (dir->fileList.size()>0) {
-		if (!(strcmp(info->shortname,dir->fileList.back()->shortname)<0)) {
-			// append at end of list
-			dir->fileList.push_back(info);
-		} else {
-			// look for position where to insert this element
-			std::vector<CFileInfo*>::iterator it;
-			for (it=dir->fileList.begin(); it!=dir->fileList.end(); ++it) {
-				if (strcmp(info->shortname,(*it)->shortname)<0) {
-					found = true;
-					break;
-				}
-			}
-			// Put file in lists
-			if (found) dir->fileList.insert(it,info);
-			else dir->fileList.push_back(info);
-		}
-	} else {
-		// empty file list, append
-		dir->fileList.push_back(info);
-	}
+	insert_sorted(dir->fileList, info);
 }
 
 void DOS_Drive_Cache::CopyEntry(CFileInfo* dir, CFileInfo* from) {
@@ -896,27 +942,52 @@ bool DOS_Drive_Cache::ReadDir(uint16_t id, char* &result) {
 		return false;
 
 	if (!IsCachedIn(dirSearch[id])) {
-		// Try to open directory
-		dir_information* dirp = open_directory(dirPath);
-		if (!dirp) {
+		// Use the background listing if there's a current one
+		const auto prefetched = prefetcher ? prefetcher->Take(dirPath)
+		                                   : std::nullopt;
+		// Drives whose contents aren't on the host list them themselves
+		const auto listed = dirLister ? dirLister(dirPath) : std::nullopt;
+		if (dirLister && !listed) {
 			if (dirSearch[id]) {
 				dirSearch[id]->id = MAX_OPENDIRS;
 				dirSearch[id] = nullptr;
 			}
 			return false;
 		}
-		// Read complete directory
-		char dir_name[CROSS_LEN];
-		bool is_directory;
-		if (read_directory_first(dirp, dir_name, is_directory)) {
-			CreateEntry(dirSearch[id], dir_name, is_directory);
-			while (read_directory_next(dirp, dir_name, is_directory)) {
+		if (listed) {
+			for (const auto& entry : *listed) {
+				CreateEntry(dirSearch[id], entry.name.c_str(), entry.is_directory);
+			}
+		} else if (prefetched) {
+			for (const auto& entry : *prefetched) {
+				CreateEntry(dirSearch[id], entry.name.c_str(), entry.is_directory);
+			}
+		} else {
+			// Try to open directory
+			dir_information* dirp = open_directory(dirPath);
+			if (!dirp) {
+				if (dirSearch[id]) {
+					dirSearch[id]->id = MAX_OPENDIRS;
+					dirSearch[id] = nullptr;
+				}
+				return false;
+			}
+			// Read complete directory
+			char dir_name[CROSS_LEN];
+			bool is_directory;
+			if (read_directory_first(dirp, dir_name, is_directory)) {
 				CreateEntry(dirSearch[id], dir_name, is_directory);
+				while (read_directory_next(dirp, dir_name, is_directory)) {
+					CreateEntry(dirSearch[id], dir_name, is_directory);
+				}
 			}
-		}
 
-		// close dir
-		close_directory(dirp);
+			// close dir
+			close_directory(dirp);
+		}
+		if (watcher) {
+			watcher->Watch(dirPath);
+		}
 
 		// Info
 /*		if (!dirp) {
@@ -990,13 +1061,19 @@ bool DOS_Drive_Cache::FindFirst(char* path, uint16_t& id) {
 	for (Bitu i=0; i<dirSearch[dirID]->fileList.size(); i++) {
 		CopyEntry(dirFindFirst[dirFindFirstID],dirSearch[dirID]->fileList[i]);
 	}
-	// Now re-sort the fileList accordingly to output
+	// Now re-sort the fileList accordingly to output. The entries are
+	// already sorted by name, so reversing them and moving the directories
+	// to the front gives the other orders without a full sort.
+	auto& find_list = dirFindFirst[dirFindFirstID]->fileList;
+	auto is_dir = [](const CFileInfo* info) { return info->isDir; };
 	switch (sortDirType) {
 		case ALPHABETICAL		: break;
-//		case ALPHABETICAL		: std::sort(dirFindFirst[dirFindFirstID]->fileList.begin(), dirFindFirst[dirFindFirstID]->fileList.end(), SortByName);		break;
-		case DIRALPHABETICAL	: std::sort(dirFindFirst[dirFindFirstID]->fileList.begin(), dirFindFirst[dirFindFirstID]->fileList.end(), SortByDirName);		break;
-		case ALPHABETICALREV	: std::sort(dirFindFirst[dirFindFirstID]->fileList.begin(), dirFindFirst[dirFindFirstID]->fileList.end(), SortByNameRev);		break;
-		case DIRALPHABETICALREV	: std::sort(dirFindFirst[dirFindFirstID]->fileList.begin(), dirFindFirst[dirFindFirstID]->fileList.end(), SortByDirNameRev);	break;
+		case DIRALPHABETICAL	: std::stable_partition(find_list.begin(), find_list.end(), is_dir);	break;
+		case ALPHABETICALREV	: std::reverse(find_list.begin(), find_list.end());	break;
+		case DIRALPHABETICALREV	:
+			std::reverse(find_list.begin(), find_list.end());
+			std::stable_partition(find_list.begin(), find_list.end(), is_dir);
+			break;
 		case NOSORT				: break;
 	}
 
@@ -18,13 +18,17 @@
 
 #include "drives.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <iterator>
+#include <vector>
 
 #include "bios.h"
 #include "bios_disk.h"
+#include "control.h"
 #include "dos_inc.h"
 #include "string_utils.h"
 #include "support.h"
@@ -50,6 +54,9 @@ public:
 	void Close() override;
 	uint16_t GetInformation(void) override;
 	bool IsOnReadOnlyMedium() const override;
+
+	uint32_t getAbsoluteSector(uint32_t bytePos, uint32_t* numContiguous = nullptr);
+	void resetClusterIndex();
 public:
 	std::shared_ptr<fatDrive> myDrive   = nullptr;
 	uint32_t firstCluster               = 0;
@@ -65,6 +72,19 @@ public:
 	bool set_archive_on_close   = false;
 	bool loadedSector           = false;
 	const bool read_only_medium = false;
+
+private:
+	// A run of consecutive clusters of the file, starting at the
+	// 'logical_cluster'th cluster of the file
+	struct ClusterExtent {
+		uint32_t logical_cluster = 0;
+		uint32_t first_cluster   = 0;
+		uint32_t num_clusters    = 0;
+	};
+
+	// The file's cluster chain as far as it has been followed, so seeks
+	// don't have to walk the chain from its start
+	std::vector<ClusterExtent> cluster_extents = {};
 };
 
 /* IN - char * filename: Name in regular filename format, e.g. bob.txt */
@@ -111,7 +131,7 @@ bool fatFile::Read(uint8_t * data, uint16_t *size) {
 	}
 
 	if (!loadedSector) {
-		currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+		currentSector = getAbsoluteSector(seekpos);
 		if(currentSector == 0) {
 			/* EOC reached before EOF */
 			*size = 0;
@@ -119,7 +139,7 @@ bool fatFile::Read(uint8_t * data, uint16_t *size) {
 			return true;
 		}
 		curSectOff = seekpos % myDrive->getSectorSize();
-		myDrive->readSector(currentSector, sectorBuffer);
+		myDrive->readDataSector(currentSector, sectorBuffer);
 		loadedSector = true;
 	}
 
@@ -130,10 +150,46 @@ bool fatFile::Read(uint8_t * data, uint16_t *size) {
 			*size = sizecount;
 			return true; 
 		}
+		// Whole sectors from the start of a loaded sector are read
+		// straight into the caller's buffer, up to the end of the run
+		// of clusters that are consecutive on the disk
+		const uint32_t sector_size = myDrive->getSectorSize();
+		if (curSectOff == 0 && sizedec >= sector_size &&
+		    filelength - seekpos >= sector_size) {
+			uint32_t num_contiguous_sectors = 1;
+			getAbsoluteSector(seekpos, &num_contiguous_sectors);
+
+			const uint32_t num_sectors = std::min({num_contiguous_sectors,
+			                                       sizedec / sector_size,
+			                                       (filelength - seekpos) /
+			                                               sector_size});
+
+			memcpy(data + sizecount, sectorBuffer, sector_size);
+			if (num_sectors > 1) {
+				myDrive->readDataSectors(currentSector + 1,
+				                     num_sectors - 1,
+				                     data + sizecount + sector_size);
+			}
+			const auto num_bytes = num_sectors * sector_size;
+			sizecount += check_cast<uint16_t>(num_bytes);
+			sizedec -= check_cast<uint16_t>(num_bytes);
+			seekpos += num_bytes;
+
+			// Load the following sector like the bytewise copy does
+			currentSector = getAbsoluteSector(seekpos);
+			if (currentSector == 0) {
+				/* EOC reached before EOF */
+				*size = sizecount;
+				loadedSector = false;
+				return true;
+			}
+			myDrive->readDataSector(currentSector, sectorBuffer);
+			continue;
+		}
 		data[sizecount++] = sectorBuffer[curSectOff++];
 		seekpos++;
 		if(curSectOff >= myDrive->getSectorSize()) {
-			currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+			currentSector = getAbsoluteSector(seekpos);
 			if(currentSector == 0) {
 				/* EOC reached before EOF */
 				//LOG_MSG("EOC reached before EOF, seekpos %d, filelen %d", seekpos, filelength);
@@ -142,7 +198,7 @@ bool fatFile::Read(uint8_t * data, uint16_t *size) {
 				return true;
 			}
 			curSectOff = 0;
-			myDrive->readSector(currentSector, sectorBuffer);
+			myDrive->readDataSector(currentSector, sectorBuffer);
 			loadedSector = true;
 			//LOG_MSG("Reading absolute sector at %d for seekpos %d", currentSector, seekpos);
 		}
@@ -172,6 +228,7 @@ bool fatFile::Write(uint8_t * data, uint16_t *size) {
 			myDrive->deleteClustChain(firstCluster, seekpos);
 		if (seekpos == 0)
 			firstCluster = 0;
+		resetClusterIndex();
 		filelength = seekpos;
 		goto finalizeWrite;
 	}
@@ -181,6 +238,7 @@ bool fatFile::Write(uint8_t * data, uint16_t *size) {
 		uint32_t clustSize = myDrive->getClusterSize();
 		if(filelength == 0) {
 			firstCluster = myDrive->getFirstFreeClust();
+			resetClusterIndex();
 			if(firstCluster == 0) goto finalizeWrite; // out of space
 			myDrive->allocateCluster(firstCluster, 0);
 			filelength = clustSize;
@@ -199,26 +257,27 @@ bool fatFile::Write(uint8_t * data, uint16_t *size) {
 		if(seekpos >= filelength) {
 			if(filelength == 0) {
 				firstCluster = myDrive->getFirstFreeClust();
+				resetClusterIndex();
 				if(firstCluster == 0) goto finalizeWrite; // out of space
 				myDrive->allocateCluster(firstCluster, 0);
-				currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
-				myDrive->readSector(currentSector, sectorBuffer);
+				currentSector = getAbsoluteSector(seekpos);
+				myDrive->readDataSector(currentSector, sectorBuffer);
 				loadedSector = true;
 			}
 			if (!loadedSector) {
-				currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+				currentSector = getAbsoluteSector(seekpos);
 				if(currentSector == 0) {
 					/* EOC reached before EOF - try to increase file allocation */
 					myDrive->appendCluster(firstCluster);
 					/* Try getting sector again */
-					currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+					currentSector = getAbsoluteSector(seekpos);
 					if(currentSector == 0) {
 						/* No can do. lets give up and go home.  We must be out of room */
 						goto finalizeWrite;
 					}
 				}
 				curSectOff = seekpos % myDrive->getSectorSize();
-				myDrive->readSector(currentSector, sectorBuffer);
+				myDrive->readDataSector(currentSector, sectorBuffer);
 				loadedSector = true;
 			}
 			filelength = seekpos+1;
@@ -226,19 +285,19 @@ bool fatFile::Write(uint8_t * data, uint16_t *size) {
 		sectorBuffer[curSectOff++] = data[sizecount++];
 		seekpos++;
 		if(curSectOff >= myDrive->getSectorSize()) {
-			if(loadedSector) myDrive->writeSector(currentSector, sectorBuffer);
+			if(loadedSector) myDrive->writeDataSector(currentSector, sectorBuffer);
 
-			currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+			currentSector = getAbsoluteSector(seekpos);
 			if(currentSector == 0) loadedSector = false;
 			else {
 				curSectOff = 0;
-				myDrive->readSector(currentSector, sectorBuffer);
+				myDrive->readDataSector(currentSector, sectorBuffer);
 				loadedSector = true;
 			}
 		}
 		--sizedec;
 	}
-	if(curSectOff>0 && loadedSector) myDrive->writeSector(currentSector, sectorBuffer);
+	if(curSectOff>0 && loadedSector) myDrive->writeDataSector(currentSector, sectorBuffer);
 
 finalizeWrite:
 	myDrive->directoryBrowse(dirCluster, &tmpentry, dirIndex);
@@ -255,6 +314,74 @@ finalizeWrite:
 	return true;
 }
 
+// Looks up the absolute sector of a byte of the file, returning 0 past the end
+// of its cluster chain. 'numContiguous' receives the number of sectors from
+// there on that are known to be consecutive on the disk.
+uint32_t fatFile::getAbsoluteSector(const uint32_t bytePos, uint32_t* numContiguous)
+{
+	if (numContiguous) {
+		*numContiguous = 1;
+	}
+	if (firstCluster == 0) {
+		return myDrive->getAbsoluteSectFromBytePos(firstCluster, bytePos);
+	}
+
+	const uint32_t sectors_per_cluster = myDrive->getClusterSize() /
+	                                     myDrive->getSectorSize();
+	const uint32_t logical_sector  = bytePos / myDrive->getSectorSize();
+	const uint32_t logical_cluster = logical_sector / sectors_per_cluster;
+
+	// Follow the chain on from the last indexed cluster. The end of the
+	// chain isn't remembered, as other handles of the file may extend it.
+	if (cluster_extents.empty()) {
+		cluster_extents.push_back({0, firstCluster, 1});
+	}
+	while (true) {
+		auto& last = cluster_extents.back();
+
+		const auto end_cluster = last.logical_cluster + last.num_clusters;
+		if (logical_cluster < end_cluster) {
+			break;
+		}
+		const auto last_cluster = last.first_cluster + last.num_clusters - 1;
+
+		uint32_t next_cluster = 0;
+		if (!myDrive->getNextCluster(last_cluster, &next_cluster)) {
+			return 0;
+		}
+		if (next_cluster == last_cluster + 1) {
+			++last.num_clusters;
+		} else {
+			cluster_extents.push_back({end_cluster, next_cluster, 1});
+		}
+	}
+
+	const auto extent = std::prev(
+	        std::upper_bound(cluster_extents.begin(),
+	                         cluster_extents.end(),
+	                         logical_cluster,
+	                         [](const uint32_t cluster, const ClusterExtent& e) {
+		                         return cluster < e.logical_cluster;
+	                         }));
+
+	const auto cluster = extent->first_cluster +
+	                     (logical_cluster - extent->logical_cluster);
+	const auto sector_in_cluster = logical_sector % sectors_per_cluster;
+
+	if (numContiguous) {
+		const auto num_clusters_left = extent->logical_cluster +
+		                               extent->num_clusters - logical_cluster;
+		*numContiguous = num_clusters_left * sectors_per_cluster -
+		                 sector_in_cluster;
+	}
+	return myDrive->getClustFirstSect(cluster) + sector_in_cluster;
+}
+
+void fatFile::resetClusterIndex()
+{
+	cluster_extents.clear();
+}
+
 bool fatFile::Seek(uint32_t *pos, uint32_t type) {
 	int32_t seekto=0;
 	
@@ -274,13 +401,13 @@ bool fatFile::Seek(uint32_t *pos, uint32_t type) {
 
 	if(seekto<0) seekto = 0;
 	seekpos = (uint32_t)seekto;
-	currentSector = myDrive->getAbsoluteSectFromBytePos(firstCluster, seekpos);
+	currentSector = getAbsoluteSector(seekpos);
 	if (currentSector == 0) {
 		/* not within file size, thus no sector is available */
 		loadedSector = false;
 	} else {
 		curSectOff = seekpos % myDrive->getSectorSize();
-		myDrive->readSector(currentSector, sectorBuffer);
+		myDrive->readDataSector(currentSector, sectorBuffer);
 		loadedSector = true;
 	}
 	*pos = seekpos;
@@ -307,8 +434,9 @@ void fatFile::Close()
 
 		/* Flush buffer */
 		if (loadedSector) {
-			myDrive->writeSector(currentSector, sectorBuffer);
+			myDrive->writeDataSector(currentSector, sectorBuffer);
 		}
+		myDrive->FlushBuffers();
 	}
 
 	set_archive_on_close = false;
@@ -566,6 +694,56 @@ bool fatDrive::getDirClustNum(const char* dir, uint32_t* clustNum, bool parDir)
 }
 
 uint8_t fatDrive::readSector(uint32_t sectnum, void * data) {
+	if (sector_cache.Read(sectnum, data)) {
+		return 0;
+	}
+	const auto result = readSectorFromDisk(sectnum, data);
+	if (result == 0) {
+		sector_cache.Insert(sectnum, data);
+	}
+	return result;
+}
+
+uint8_t fatDrive::writeSector(uint32_t sectnum, void * data) {
+	// Guard
+	if (!loadedDisk) {
+		return 0;
+	}
+	sector_cache.Write(sectnum, data);
+	return 0;
+}
+
+uint8_t fatDrive::readDataSector(uint32_t sectnum, void* data)
+{
+	if (sector_cache.Read(sectnum, data)) {
+		return 0;
+	}
+	return readSectorFromDisk(sectnum, data);
+}
+
+uint8_t fatDrive::writeDataSector(uint32_t sectnum, void* data)
+{
+	if (sector_cache.WriteIfCached(sectnum, data)) {
+		return 0;
+	}
+	return writeSectorToDisk(sectnum, data);
+}
+
+void fatDrive::FlushBuffers()
+{
+	sector_cache.Flush();
+}
+
+void fatDrive::EmptyCache()
+{
+	// The disk may be changed underneath us, so drop the cached sectors
+	// as well
+	sector_cache.Clear();
+	curFatSect = 0xffffffff;
+}
+
+uint8_t fatDrive::readSectorFromDisk(uint32_t sectnum, void* data)
+{
 	// Guard
 	if (!loadedDisk) {
 		return 0;
@@ -582,21 +760,49 @@ uint8_t fatDrive::readSector(uint32_t sectnum, void * data) {
 	return loadedDisk->Read_Sector(head, cylinder, sector, data);
 }
 
-uint8_t fatDrive::writeSector(uint32_t sectnum, void * data) {
+uint8_t fatDrive::readDataSectors(uint32_t sectnum, uint32_t num_sectors, void* data)
+{
+	// Guard
+	if (!loadedDisk) {
+		return 0;
+	}
+
+	// Sectors in the cache may be newer than the ones on the disk
+	bool is_any_cached = false;
+	for (uint32_t i = 0; i < num_sectors && !is_any_cached; ++i) {
+		is_any_cached = sector_cache.Contains(sectnum + i);
+	}
+
+	if (absolute && !is_any_cached) {
+		return loadedDisk->Read_AbsoluteSectors(sectnum, num_sectors, data);
+	}
+	auto sector_data = static_cast<uint8_t*>(data);
+	for (uint32_t i = 0; i < num_sectors; ++i) {
+		if (const auto result = readDataSector(sectnum + i, sector_data);
+		    result != 0) {
+			return result;
+		}
+		sector_data += getSectorSize();
+	}
+	return 0;
+}
+
+uint8_t fatDrive::writeSectorToDisk(uint32_t sectnum, const void* data)
+{
 	// Guard
 	if (!loadedDisk) {
 		return 0;
 	}
 
 	if (absolute) {
-		return loadedDisk->Write_AbsoluteSector(sectnum, data);
+		return loadedDisk->Write_AbsoluteSectors(sectnum, 1, data);
 	}
 	uint32_t cylindersize = bootbuffer.headcount * bootbuffer.sectorspertrack;
 	uint32_t cylinder = sectnum / cylindersize;
 	sectnum %= cylindersize;
 	uint32_t head = sectnum / bootbuffer.sectorspertrack;
 	uint32_t sector = sectnum % bootbuffer.sectorspertrack + 1L;
-	return loadedDisk->Write_Sector(head, cylinder, sector, data);
+	return loadedDisk->Write_Sectors(head, cylinder, sector, 1, data);
 }
 
 uint32_t fatDrive::getSectorCount()
@@ -620,6 +826,30 @@ uint32_t fatDrive::getAbsoluteSectFromBytePos(uint32_t startClustNum, uint32_t b
 	return  getAbsoluteSectFromChain(startClustNum, bytePos / bootbuffer.bytespersector);
 }
 
+bool fatDrive::getNextCluster(const uint32_t clustNum, uint32_t* nextClust)
+{
+	const auto value = getClusterValue(clustNum);
+	switch (fattype) {
+	case FAT12:
+		if (value >= 0xff8) {
+			return false;
+		}
+		break;
+	case FAT16:
+		if (value >= 0xfff8) {
+			return false;
+		}
+		break;
+	case FAT32:
+		if (value >= 0xfffffff8) {
+			return false;
+		}
+		break;
+	}
+	*nextClust = value;
+	return true;
+}
+
 uint32_t fatDrive::getAbsoluteSectFromChain(uint32_t startClustNum, uint32_t logicalSector) {
 	int32_t skipClust = logicalSector / bootbuffer.sectorspercluster;
 	uint32_t sectClust = logicalSector % bootbuffer.sectorspercluster;
@@ -775,12 +1005,43 @@ constexpr uint16_t dta_pages()
 	return pages;
 }
 
+// Writes the cached sectors back when a directory-changing operation returns,
+// so the image is consistent for the BIOS and IDE code sharing it
+class BufferFlusher {
+public:
+	explicit BufferFlusher(DOS_Drive& _drive) : drive(_drive) {}
+	~BufferFlusher()
+	{
+		drive.FlushBuffers();
+	}
+
+	BufferFlusher(const BufferFlusher&)            = delete;
+	BufferFlusher& operator=(const BufferFlusher&) = delete;
+
+private:
+	DOS_Drive& drive;
+};
+
+static size_t get_sector_cache_size()
+{
+	constexpr auto DefaultNumSectors = 512;
+
+	const auto section = control ? static_cast<Section_prop*>(
+	                                       control->GetSection("dos"))
+	                             : nullptr;
+	if (!section) {
+		return DefaultNumSectors;
+	}
+	return static_cast<size_t>(std::max(section->Get_int("fat_sector_cache"), 0));
+}
+
 fatDrive::fatDrive(const char *sysFilename,
                    uint32_t bytesector,
                    uint32_t cylsector,
                    uint32_t headscyl,
                    uint32_t cylinders,
-                   bool roflag)
+                   bool roflag,
+                   const std::string& overlay_filename)
 	: loadedDisk(nullptr),
 	  created_successfully(true),
 	  partSectOff(0),
@@ -793,7 +1054,11 @@ fatDrive::fatDrive(const char *sysFilename,
 	  firstRootDirSect(0),
 	  cwdDirCluster(0),
 	  fatSectBuffer{0},
-	  curFatSect(0)
+	  curFatSect(0),
+	  sector_cache(get_sector_cache_size(), BytePerSector,
+	               [this](const uint32_t sectnum, const uint8_t* data) {
+		               writeSectorToDisk(sectnum, data);
+	               })
 {
 	FILE *diskfile;
 	uint32_t filesize;
@@ -806,7 +1071,13 @@ fatDrive::fatDrive(const char *sysFilename,
 		imgDTA    = new DOS_DTA(imgDTAPtr);
 	}
 	assert(sysFilename);
-	diskfile = fopen_wrap_ro_fallback(sysFilename, readonly);
+	// With an overlay, the image itself is only ever read
+	const bool has_overlay = !overlay_filename.empty();
+	bool is_image_readonly = readonly || has_overlay;
+	diskfile = fopen_wrap_ro_fallback(sysFilename, is_image_readonly);
+	if (!has_overlay) {
+		readonly = is_image_readonly;
+	}
 	created_successfully = (diskfile != nullptr);
 	if (!created_successfully)
 		return;
@@ -824,7 +1095,13 @@ fatDrive::fatDrive(const char *sysFilename,
 	if(is_hdd) {
 		/* Set user specified harddrive parameters */
 		loadedDisk->Set_Geometry(headscyl, cylinders,cylsector, bytesector);
+	}
+	if (has_overlay && !loadedDisk->AttachOverlay(overlay_filename)) {
+		created_successfully = false;
+		return;
+	}
 
+	if(is_hdd) {
 		loadedDisk->Read_Sector(0,0,1,&mbrData);
 
 		if(mbrData.magic1!= 0x55 ||	mbrData.magic2!= 0xaa) LOG_MSG("Possibly invalid partition table in disk image.");
@@ -1040,8 +1317,14 @@ uint32_t fatDrive::getFirstFreeClust(void) {
 bool fatDrive::IsRemote(void) {	return false; }
 bool fatDrive::IsRemovable(void) { return false; }
 
+fatDrive::~fatDrive()
+{
+	sector_cache.Flush();
+}
+
 Bits fatDrive::UnMount()
 {
+	sector_cache.Flush();
 	return 0;
 }
 
@@ -1178,6 +1461,8 @@ std::unique_ptr<DOS_File> fatDrive::FileOpen(const char* name, uint8_t flags)
 }
 
 bool fatDrive::FileUnlink(const char * name) {
+	const BufferFlusher flusher(*this);
+
 	if (readonly) {
 		DOS_SetError(DOSERR_ACCESS_DENIED);
 		return false;
@@ -1396,6 +1681,8 @@ bool fatDrive::GetFileAttr(const char* name, FatAttributeFlags* attr)
 
 bool fatDrive::SetFileAttr(const char* name, const FatAttributeFlags attr)
 {
+	const BufferFlusher flusher(*this);
+
 	if (readonly) {
 		DOS_SetError(DOSERR_ACCESS_DENIED);
 		return false;
@@ -1549,6 +1836,8 @@ void fatDrive::zeroOutCluster(uint32_t clustNumber) {
 
 bool fatDrive::MakeDir(const char* dir)
 {
+	const BufferFlusher flusher(*this);
+
 	if (readonly) {
 		DOS_SetError(DOSERR_ACCESS_DENIED);
 		return false;
@@ -1605,6 +1894,8 @@ bool fatDrive::MakeDir(const char* dir)
 }
 
 bool fatDrive::RemoveDir(const char *dir) {
+	const BufferFlusher flusher(*this);
+
 	if (readonly) {
 		DOS_SetError(DOSERR_ACCESS_DENIED);
 		return false;
@@ -1662,6 +1953,8 @@ bool fatDrive::RemoveDir(const char *dir) {
 }
 
 bool fatDrive::Rename(const char * oldname, const char * newname) {
+	const BufferFlusher flusher(*this);
+
 	if (readonly) {
 		DOS_SetError(DOSERR_ACCESS_DENIED);
 		return false;
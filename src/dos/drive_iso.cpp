@@ -158,7 +158,7 @@ isoDrive::isoDrive(char driveLetter, const char *fileName, uint8_t mediaid, int
 	this->fileName[0]  = '\0';
 	this->discLabel[0] = '\0';
 	memset(dirIterators, 0, sizeof(dirIterators));
-	memset(sectorHashEntries, 0, sizeof(sectorHashEntries));
+	memset(&cachedDirSector, 0, sizeof(cachedDirSector));
 	memset(&rootEntry, 0, sizeof(isoDirEntry));
 
 	safe_strcpy(this->fileName, fileName);
@@ -469,20 +469,19 @@ void isoDrive::FreeDirIterator(const int dirIterator) {
 }
 
 bool isoDrive::ReadCachedSector(uint8_t** buffer, const uint32_t sector) {
-	// get hash table entry
-	int pos = sector % ISO_MAX_HASH_TABLE_SIZE;
-	SectorHashEntry& he = sectorHashEntries[pos];
+	CachedSector& cs = cachedDirSector;
 
 	// check if the entry is valid and contains the correct sector
-	if (!he.valid || he.sector != sector) {
-		if (!CDROM::cdroms[subUnit]->ReadSector(he.data, false, sector)) {
+	if (!cs.valid || cs.sector != sector) {
+		if (!CDROM::cdroms[subUnit]->ReadSector(cs.data, false, sector)) {
+			cs.valid = false;
 			return false;
 		}
-		he.valid = true;
-		he.sector = sector;
+		cs.valid = true;
+		cs.sector = sector;
 	}
 
-	*buffer = he.data;
+	*buffer = cs.data;
 	return true;
 }
 
@@ -25,6 +25,7 @@
 #include "drives.h"
 #include "drive_local.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <climits>
 #include <cstdio>
@@ -40,6 +41,7 @@
 #include "string_utils.h"
 #include "cross.h"
 #include "inout.h"
+#include "tracy.h"
 
 bool localDrive::FileIsReadOnly(const char* name)
 {
@@ -220,6 +222,7 @@ std::unique_ptr<DOS_File> localDrive::FileOpen(const char* name, uint8_t flags)
 
 FILE* localDrive::GetHostFilePtr(const char* const name, const char* const type)
 {
+	FlushBuffers();
 	return fopen(MapDosToHostFilename(name).c_str(), type);
 }
 
@@ -275,6 +278,9 @@ bool localDrive::FindFirst(const char* _dir, DOS_DTA& dta, bool fcb_findfirst)
 	safe_strcat(tempDir, _dir);
 	CROSS_FILENAME(tempDir);
 
+	// So the sizes of files being written are up to date
+	FlushBuffers();
+
 	if (allocation.mediaid == 0xF0) {
 		EmptyCache(); //rescan floppie-content on each findfirst
 	}
@@ -333,16 +339,72 @@ bool localDrive::FindFirst(const char* _dir, DOS_DTA& dta, bool fcb_findfirst)
 
 bool localDrive::FindNext(DOS_DTA& dta)
 {
-	char* dir_ent;
-	struct stat stat_block;
-	char full_name[CROSS_LEN];
-	char dir_entcopy[CROSS_LEN];
-
 	FatAttributeFlags search_attr = {};
 	char search_pattern[DOS_NAMELENGTH_ASCII];
 
 	dta.GetSearchParams(search_attr, search_pattern);
-	uint16_t id = dta.GetDirID();
+
+	return FindNextMatch(dta.GetDirID(),
+	                     search_attr,
+	                     search_pattern,
+	                     [&dta](const char* name,
+	                            const uint32_t size,
+	                            const uint16_t date,
+	                            const uint16_t time,
+	                            const FatAttributeFlags attr) {
+		                     dta.SetResult(name, size, date, time, attr);
+	                     });
+}
+
+std::optional<bool> localDrive::FindAll(const char* _dir, const FatAttributeFlags attr,
+                                        const char* search_pattern,
+                                        const FindResultCallback& on_result)
+{
+	// Leave the volume label special cases to FindFirst
+	if (attr.volume) {
+		return {};
+	}
+
+	char tempDir[CROSS_LEN];
+	safe_strcpy(tempDir, basedir);
+	safe_strcat(tempDir, _dir);
+	CROSS_FILENAME(tempDir);
+
+	FlushBuffers();
+
+	if (allocation.mediaid == 0xF0) {
+		EmptyCache();
+	}
+
+	const auto temp_dir_len = strlen(tempDir);
+	if (temp_dir_len < 1 || tempDir[temp_dir_len - 1] != CROSS_FILESPLIT) {
+		constexpr char end[] = {CROSS_FILESPLIT, '\0'};
+		safe_strcat(tempDir, end);
+	}
+
+	uint16_t id;
+	if (!dirCache.FindFirst(tempDir, id)) {
+		DOS_SetError(DOSERR_PATH_NOT_FOUND);
+		return false;
+	}
+	safe_strcpy(srchInfo[id].srch_dir, tempDir);
+
+	// The search slot gets freed when running out of entries
+	bool found = false;
+	while (FindNextMatch(id, attr, search_pattern, on_result)) {
+		found = true;
+	}
+	return found;
+}
+
+bool localDrive::FindNextMatch(const uint16_t id, const FatAttributeFlags search_attr,
+                               const char* search_pattern,
+                               const FindResultCallback& on_result)
+{
+	char* dir_ent;
+	struct stat stat_block;
+	char full_name[CROSS_LEN];
+	char dir_entcopy[CROSS_LEN];
 
 	while (true) {
 		if (!dirCache.FindNext(id, dir_ent)) {
@@ -401,16 +463,17 @@ bool localDrive::FindNext(DOS_DTA& dta)
 			find_time = 6;
 			find_date = 4;
 		}
-		dta.SetResult(find_name,
-		              find_size,
-		              find_date,
-		              find_time,
-		              find_attr._data);
+		on_result(find_name, find_size, find_date, find_time, find_attr._data);
 		return true;
 	}
 	return false;
 }
 
+void localDrive::FlushBuffers()
+{
+	localFile::FlushBuffers(this);
+}
+
 bool localDrive::GetFileAttr(const char* name, FatAttributeFlags* attr)
 {
 	if (local_drive_get_attributes(MapDosToHostFilename(name), *attr) != DOSERR_NONE) {
@@ -565,18 +628,177 @@ localDrive::localDrive(const char* startdir, uint16_t _bytes_sector,
 	dirCache.SetBaseDir(basedir);
 }
 
+// The open local files, so that handles to the same host file can see each
+// other's buffered reads and writes. Never destroyed, as files still open at
+// exit are closed by the destruction of other static objects.
+static std::vector<localFile*>& open_local_files = *new std::vector<localFile*>();
+
+constexpr size_t MinReadAheadSize = 4 * 1024;
+constexpr size_t MaxReadAheadSize = 64 * 1024;
+constexpr size_t WriteBufferSize  = 32 * 1024;
+
+void localFile::FlushBuffers(const localDrive* drive)
+{
+	for (const auto file : open_local_files) {
+		if (file->local_drive.lock().get() == drive) {
+			file->FlushBuffers();
+		}
+	}
+}
+
+bool localFile::FlushBuffers()
+{
+	const auto flushed = FlushWriteBuffer();
+	return DiscardReadBuffer() && flushed;
+}
+
+// Before this handle reads, the other handles to the same file have to write
+// out their buffered writes, and before it writes to the host file, they also
+// have to drop their read-aheads
+void localFile::FlushOtherHandles(const bool is_writing)
+{
+	for (const auto file : open_local_files) {
+		const auto has_read_ahead = (file->read_buffer_len > 0);
+		if (file == this || (file->write_buffer.empty() && !(is_writing && has_read_ahead)) ||
+		    file->path != path) {
+			continue;
+		}
+		file->FlushWriteBuffer();
+		if (is_writing) {
+			file->DiscardReadBuffer();
+		}
+	}
+}
+
+int64_t localFile::GetPosition() const
+{
+	return host_position - static_cast<int64_t>(read_buffer_len - read_buffer_pos) +
+	       static_cast<int64_t>(write_buffer.size());
+}
+
+bool localFile::FlushWriteBuffer()
+{
+	if (write_buffer.empty()) {
+		return true;
+	}
+	// Taken out first, as the other handles flush this one in turn
+	std::vector<uint8_t> data = {};
+	std::swap(data, write_buffer);
+	FlushOtherHandles(true);
+
+	const auto num_bytes = static_cast<int64_t>(data.size());
+	const auto ret = write_native_file(file_handle, data.data(), num_bytes);
+	host_position += ret.num_bytes;
+
+	// Keeps the buffer's allocation
+	data.clear();
+	std::swap(data, write_buffer);
+
+	if (ret.error || ret.num_bytes != num_bytes) {
+		LOG_WARNING("FS: Failed writing to file '%s'", path.string().c_str());
+		return false;
+	}
+	return true;
+}
+
+// Moves the host file back to the DOS file position
+bool localFile::DiscardReadBuffer()
+{
+	if (read_buffer_pos == read_buffer_len) {
+		read_buffer_pos = read_buffer_len = 0;
+		return true;
+	}
+	const auto position = GetPosition();
+	read_buffer_pos = read_buffer_len = 0;
+
+	host_position = seek_native_file(file_handle, position, NativeSeek::Set);
+	if (host_position == NativeSeekFailed) {
+		LOG_WARNING("FS: File seek failed for '%s'", path.string().c_str());
+		host_position = get_native_file_position(file_handle);
+		return false;
+	}
+	return true;
+}
+
+size_t localFile::ReadFromBuffer(uint8_t* data, const size_t num_bytes)
+{
+	const auto num_buffered = std::min(num_bytes, read_buffer_len - read_buffer_pos);
+	if (num_buffered > 0) {
+		memcpy(data, read_buffer.data() + read_buffer_pos, num_buffered);
+		read_buffer_pos += num_buffered;
+	}
+	return num_buffered;
+}
+
+// The read-ahead doubles with every read that follows on from the previous
+// one, and starts small again after seeks
+size_t localFile::GetNextReadAheadSize() const
+{
+	if (host_position == read_ahead_end) {
+		return std::clamp(read_ahead_size * 2, MinReadAheadSize, MaxReadAheadSize);
+	}
+	return MinReadAheadSize;
+}
+
+// Reads ahead from where the buffer's been used up
+bool localFile::FillReadBuffer()
+{
+	assert(read_buffer_pos == read_buffer_len && write_buffer.empty());
+
+	read_ahead_size = GetNextReadAheadSize();
+	read_buffer.resize(read_ahead_size);
+
+	const auto ret = read_native_file(file_handle,
+	                                  read_buffer.data(),
+	                                  static_cast<int64_t>(read_ahead_size));
+	read_buffer_pos = 0;
+	read_buffer_len = static_cast<size_t>(ret.num_bytes);
+	host_position += ret.num_bytes;
+	read_ahead_end = host_position;
+
+	return !ret.error;
+}
+
 bool localFile::Read(uint8_t *data, uint16_t *size)
 {
+	ZoneScoped;
 	assert(file_handle != InvalidNativeFileHandle);
 	// check if the file is opened in write-only mode
 	if ((this->flags & 0xf) == OPEN_WRITE) {
 		DOS_SetError(DOSERR_ACCESS_DENIED);
 		return false;
 	}
+	if (!FlushWriteBuffer()) {
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return false;
+	}
+	FlushOtherHandles(false);
+
+	const size_t num_requested = *size;
+	auto num_read = ReadFromBuffer(data, num_requested);
+
+	// Reads bigger than the read-ahead go straight to the host
+	bool error = false;
+	if (num_read < num_requested) {
+		const auto num_remaining = num_requested - num_read;
+		if (num_remaining >= GetNextReadAheadSize()) {
+			read_buffer_pos = read_buffer_len = 0;
+
+			const auto ret = read_native_file(file_handle,
+			                                  data + num_read,
+			                                  static_cast<int64_t>(num_remaining));
+			num_read += static_cast<size_t>(ret.num_bytes);
+			host_position += ret.num_bytes;
+			read_ahead_end = host_position;
+			error = ret.error;
+		} else {
+			error = !FillReadBuffer();
+			num_read += ReadFromBuffer(data + num_read, num_remaining);
+		}
+	}
 
-	const auto ret = read_native_file(file_handle, data, *size);
-	*size          = check_cast<uint16_t>(ret.num_bytes);
-	if (ret.error) {
+	*size = check_cast<uint16_t>(num_read);
+	if (error) {
 		DOS_SetError(DOSERR_ACCESS_DENIED);
 		return false;
 	}
@@ -593,6 +815,7 @@ bool localFile::Read(uint8_t *data, uint16_t *size)
 
 bool localFile::Write(uint8_t *data, uint16_t *size)
 {
+	ZoneScoped;
 	assert(file_handle != InvalidNativeFileHandle);
 	uint8_t lastflags = this->flags & 0xf;
 	if (lastflags == OPEN_READ || lastflags == OPEN_READ_NO_MOD) {	// check if file opened in read-only mode
@@ -605,8 +828,21 @@ bool localFile::Write(uint8_t *data, uint16_t *size)
 
 	set_archive_on_close = true;
 
+	if (!DiscardReadBuffer()) {
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return false;
+	}
+
+	// Only one handle to a file can hold buffered writes, so they reach
+	// the host file in order
+	FlushOtherHandles(true);
+
 	// Truncate the file
 	if (*size == 0) {
+		if (!FlushWriteBuffer()) {
+			DOS_SetError(DOSERR_ACCESS_DENIED);
+			return false;
+		}
 		if (!truncate_native_file(file_handle)) {
 			LOG_DEBUG("FS: Failed truncating file '%s'", name.c_str());
 			return false;
@@ -615,9 +851,21 @@ bool localFile::Write(uint8_t *data, uint16_t *size)
 		return true;
 	}
 
-	// Otherwise we have some data to write
+	// Otherwise we have some data to write. Small writes are buffered,
+	// and the buffer is written out when it's full.
+	if (write_buffer.size() + *size > WriteBufferSize && !FlushWriteBuffer()) {
+		*size = 0;
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return false;
+	}
+	if (*size < WriteBufferSize) {
+		write_buffer.insert(write_buffer.end(), data, data + *size);
+		return true;
+	}
+
 	const auto ret = write_native_file(file_handle, data, *size);
 	*size          = check_cast<uint16_t>(ret.num_bytes);
+	host_position += ret.num_bytes;
 	if (ret.error) {
 		DOS_SetError(DOSERR_ACCESS_DENIED);
 		return false;
@@ -643,22 +891,24 @@ bool localFile::Seek(uint32_t *pos_addr, uint32_t type)
 			break;
 		}
 		case DOS_SEEK_CUR: {
-			const auto current_pos = get_native_file_position(file_handle);
-			if (current_pos == NativeSeekFailed) {
-				LOG_WARNING("FS: File seek failed for '%s'", path.string().c_str());
-				DOS_SetError(DOSERR_ACCESS_DENIED);
-				return false;
-			}
-			seek_to = check_cast<uint32_t>(current_pos) + *pos_addr;
+			// Known without asking the host, so the position queries of
+			// every DOS read and write stay cheap
+			seek_to = check_cast<uint32_t>(GetPosition()) + *pos_addr;
 			break;
 		}
 		case DOS_SEEK_END: {
+			if (!FlushBuffers()) {
+				DOS_SetError(DOSERR_ACCESS_DENIED);
+				return false;
+			}
+			FlushOtherHandles(false);
 			const auto end_pos = seek_native_file(file_handle, 0, NativeSeek::End);
 			if (end_pos == NativeSeekFailed) {
 				LOG_WARNING("FS: File seek failed for '%s'", path.string().c_str());
 				DOS_SetError(DOSERR_ACCESS_DENIED);
 				return false;
 			}
+			host_position = end_pos;
 			seek_to = check_cast<uint32_t>(end_pos) + *pos_addr;
 			break;
 		}
@@ -670,14 +920,35 @@ bool localFile::Seek(uint32_t *pos_addr, uint32_t type)
 		}
 	}
 
+	// Seeks to where the file already is, or within the read-ahead, don't
+	// need the host
+	if (seek_to == GetPosition()) {
+		*pos_addr = seek_to;
+		return true;
+	}
+	const auto buffer_start = host_position - static_cast<int64_t>(read_buffer_len);
+	if (write_buffer.empty() && seek_to >= buffer_start && seek_to <= host_position) {
+		read_buffer_pos = static_cast<size_t>(seek_to - buffer_start);
+		*pos_addr       = seek_to;
+		return true;
+	}
+
+	if (!FlushWriteBuffer()) {
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return false;
+	}
+	read_buffer_pos = read_buffer_len = 0;
+
 	// Always use NativeSeek::Set set since we calculate the absolute value above
 	auto returned_pos = seek_native_file(file_handle, seek_to, NativeSeek::Set);
 
 	if (returned_pos == NativeSeekFailed) {
 		LOG_WARNING("FS: File seek failed for '%s'", path.string().c_str());
 		DOS_SetError(DOSERR_ACCESS_DENIED);
+		host_position = get_native_file_position(file_handle);
 		return false;
 	}
+	host_position = returned_pos;
 
 	// The returned value is always positive.
 	// It can exceed 32-bit signed max (ex. Blackthorne)
@@ -726,6 +997,10 @@ void localFile::Close()
 {
 	assert(file_handle != InvalidNativeFileHandle);
 
+	// Also when other references are left, as duplicating and closing a
+	// handle is how DOS programs commit their writes
+	FlushBuffers();
+
 	// only close if one reference left
 	if (refCtr == 1) {
 		if (set_archive_on_close) {
@@ -776,6 +1051,9 @@ localFile::localFile(const char* _name, const std_fs::path& path,
 	attr = FatAttributeFlags::Archive;
 
 	SetName(_name);
+
+	host_position = get_native_file_position(file_handle);
+	open_local_files.push_back(this);
 }
 
 localFile::~localFile()
@@ -790,6 +1068,8 @@ localFile::~localFile()
 		// Make sure to avoid virtual dispatch inside a destructor
 		localFile::Close();
 	}
+
+	std::erase(open_local_files, this);
 }
 
 // ********************************************
@@ -888,6 +1168,17 @@ bool cdromDrive::FindFirst(const char* _dir, DOS_DTA& dta, [[maybe_unused]]bool
 	return localDrive::FindFirst(_dir,dta);
 }
 
+std::optional<bool> cdromDrive::FindAll(const char* _dir, const FatAttributeFlags attr,
+                                        const char* search_pattern,
+                                        const FindResultCallback& on_result)
+{
+	if (MSCDEX_HasMediaChanged(subUnit)) {
+		// Let FindFirst reinit the cache and label
+		return {};
+	}
+	return localDrive::FindAll(_dir, attr, search_pattern, on_result);
+}
+
 void cdromDrive::SetDir(const char* path)
 {
 	// If media has changed, reInit drivecache.
@@ -23,6 +23,8 @@
 #include "dos_system.h"
 #include "drives.h"
 
+#include <vector>
+
 class localFile : public DOS_File {
 public:
 	localFile(const char* name, const std_fs::path& path,
@@ -46,16 +48,46 @@ public:
 	{
 		return path;
 	}
+
+	// Writes out the buffered writes and drops the read-ahead, leaving the
+	// host file at the DOS file position
+	bool FlushBuffers();
+
+	// Flushes the buffers of the open files on a drive
+	static void FlushBuffers(const localDrive* drive);
+
 	const std::weak_ptr<localDrive> local_drive = {};
 	NativeFileHandle file_handle = InvalidNativeFileHandle;
 
 private:
 	void MaybeFlushTime();
+	bool FlushWriteBuffer();
+	bool DiscardReadBuffer();
+	void FlushOtherHandles(bool is_writing);
+	size_t ReadFromBuffer(uint8_t* data, size_t num_bytes);
+	size_t GetNextReadAheadSize() const;
+	bool FillReadBuffer();
+	int64_t GetPosition() const;
+
 	const std_fs::path path = {};
 	const char* basedir     = nullptr;
 
 	const bool read_only_medium = false;
 	bool set_archive_on_close   = false;
+
+	// Small reads are served from a read-ahead buffer, which grows while
+	// the file is read sequentially. Small writes are collected and written
+	// to the host at once.
+	std::vector<uint8_t> read_buffer  = {};
+	size_t read_buffer_pos            = 0;
+	size_t read_buffer_len            = 0;
+	size_t read_ahead_size            = 0;
+	int64_t read_ahead_end            = -1;
+	std::vector<uint8_t> write_buffer = {};
+
+	// Where the host file is, which differs from the DOS file position
+	// while reads or writes are buffered
+	int64_t host_position = 0;
 };
 
 #endif
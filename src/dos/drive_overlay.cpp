@@ -283,6 +283,10 @@ std::pair<NativeFileHandle, std_fs::path> Overlay_Drive::create_file_in_overlay(
 		file_handle = create_native_file(newname, attributes);
 	}
 
+	if (file_handle != InvalidNativeFileHandle) {
+		add_DOSname_to_cache(dos_filename);
+	}
+
 	return {file_handle, newname};
 }
 
@@ -311,6 +315,11 @@ bool OverlayFile::create_copy()
 
 	assert(file_handle != InvalidNativeFileHandle);
 
+	// The copy is made from the host file, so it has to be up to date
+	if (!FlushBuffers()) {
+		return false;
+	}
+
 	const auto location_in_old_file = get_native_file_position(file_handle);
 	if (location_in_old_file == NativeSeekFailed) {
 		LOG_ERR("OVERLAY: Failed getting current position in file '%s': %s",
@@ -383,6 +392,7 @@ Overlay_Drive::Overlay_Drive(const char *startdir,
           overlap_folder(),
           DOSnames_cache{},
           DOSdirs_cache{},
+          DOSdirs_index{},
           special_prefix("DBOVERLAY")
 {
 	//Currently this flag does nothing, as the current behavior is to not reread due to caching everything.
@@ -490,7 +500,10 @@ std::unique_ptr<DOS_File> Overlay_Drive::FileOpen(const char* name, uint8_t flag
 	safe_strcat(newname, name);
 	CROSS_FILENAME(newname);
 
-	NativeFileHandle file_handle = open_native_file(newname, write_access);
+	// Only files the overlay is known to hold are opened from it
+	NativeFileHandle file_handle = is_file_in_overlay(name)
+	                                     ? open_native_file(newname, write_access)
+	                                     : InvalidNativeFileHandle;
 	if (file_handle != InvalidNativeFileHandle) {
 		if (logoverlay) {
 			LOG_MSG("FS: Overlay file '%s' opened.", newname);
@@ -594,17 +607,11 @@ std::unique_ptr<DOS_File> Overlay_Drive::FileCreate(const char* name,
 }
 
 void Overlay_Drive::add_DOSname_to_cache(const char* name) {
-	for (std::vector<std::string>::const_iterator itc = DOSnames_cache.begin(); itc != DOSnames_cache.end(); ++itc){
-		if (name == (*itc)) return;
-	}
-	DOSnames_cache.push_back(name);
+	DOSnames_cache.emplace(name);
 }
 
 void Overlay_Drive::remove_DOSname_from_cache(const char* name) {
-	for (std::vector<std::string>::iterator it = DOSnames_cache.begin(); it != DOSnames_cache.end(); ++it) {
-		if (name == (*it)) { DOSnames_cache.erase(it); return;}
-	}
-
+	DOSnames_cache.erase(name);
 }
 
 bool Overlay_Drive::Sync_leading_dirs(const char* dos_filename){
@@ -663,6 +670,7 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 		//Clear all lists
 		DOSnames_cache.clear();
 		DOSdirs_cache.clear();
+		DOSdirs_index.clear();
 		deleted_files_in_base.clear();
 		deleted_paths_in_base.clear();
 		//Ensure hiding of the folder that contains the overlay, if it is part of the base folder.
@@ -787,7 +795,7 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 			upcase(dosname);  //Should not be really needed, as uppercase in the overlay is a requirement...
 			CROSS_DOSFILENAME(dosname);
 			if (logoverlay) LOG_MSG("update cache add dosname %s",dosname);
-			DOSnames_cache.push_back(dosname);
+			DOSnames_cache.emplace(dosname);
 		}
 	}
 
@@ -801,10 +809,10 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 	}
 #endif
 
-	for (i = DOSnames_cache.begin(); i != DOSnames_cache.end(); ++i) {
+	for (const auto& dosname : DOSnames_cache) {
 		char fakename[CROSS_LEN];
 		safe_strcpy(fakename, basedir);
-		safe_strcat(fakename, (*i).c_str());
+		safe_strcat(fakename, dosname.c_str());
 		CROSS_FILENAME(fakename);
 		dirCache.AddEntry(fakename,true);
 	}
@@ -884,13 +892,14 @@ again:
 
 	//First try overlay:
 	char ovname[CROSS_LEN];
-	char relativename[CROSS_LEN];
-	safe_strcpy(relativename, srchInfo[id].srch_dir);
 	//strip off basedir: //TODO cleanup
 	safe_strcpy(ovname, overlaydir);
 	char* prel = full_name + safe_strlen(basedir);
 
-	
+	char preldos[CROSS_LEN];
+	safe_strcpy(preldos, prel);
+	CROSS_DOSFILENAME(preldos);
+	upcase(preldos);
 
 #if 0
 	//Check hidden/deleted directories first. TODO is this really needed. If the directory exist in the overlay things are weird anyway.
@@ -901,16 +910,18 @@ again:
 	}
 #endif
 
-	safe_strcat(ovname, prel);
-	bool statok = ( stat(ovname,&stat_block)==0);
+	// Only entries the overlay is known to hold are looked up in it
+	bool statok = false;
+	if (is_file_in_overlay(preldos) || is_dir_only_in_overlay(preldos)) {
+		safe_strcat(ovname, preldos);
+		CROSS_FILENAME(ovname);
+		statok = (stat(ovname, &stat_block) == 0);
+	}
 
 	if (logoverlay) LOG_MSG("listing %s",dir_entcopy);
 	if (statok) {
 		if (logoverlay) LOG_MSG("using overlay data for %s : %s",full_name, ovname);
 	} else {
-		char preldos[CROSS_LEN];
-		safe_strcpy(preldos, prel);
-		CROSS_DOSFILENAME(preldos);
 		if (is_deleted_file(preldos)) { //dir.. maybe lower or keep it as is TODO
 			if (logoverlay) LOG_MSG("skipping deleted file %s %s %s",preldos,full_name,ovname);
 			goto again;
@@ -980,10 +991,11 @@ bool Overlay_Drive::FileUnlink(const char * name) {
 	safe_strcat(overlayname, name);
 	CROSS_FILENAME(overlayname);
 	//	char *fullname = dirCache.GetExpandNameAndNormaliseCase(newname);
-	if (unlink(overlayname)) {
+	const bool in_overlay = is_file_in_overlay(name);
+	if (!in_overlay || unlink(overlayname)) {
 		//Unlink failed for some reason try finding it.
 		struct stat buffer;
-		if(stat(overlayname,&buffer)) {
+		if (!in_overlay || errno == ENOENT) {
 			//file not found in overlay, check the basedrive
 			//Check if file not already deleted 
 			if (is_deleted_file(name)) {
@@ -1031,10 +1043,12 @@ bool Overlay_Drive::GetFileAttr(const char* name, FatAttributeFlags* attr)
 	safe_strcat(overlayname, name);
 	CROSS_FILENAME(overlayname);
 
-	// Try to retrieve attributes
-	const auto result = local_drive_get_attributes(overlayname, *attr);
-	if (result == DOSERR_NONE) {
-		return true;
+	// Try to retrieve attributes, if the overlay holds the entry
+	if (is_file_in_overlay(name) || is_dir_only_in_overlay(name)) {
+		const auto result = local_drive_get_attributes(overlayname, *attr);
+		if (result == DOSERR_NONE) {
+			return true;
+		}
 	}
 
 	// Maybe check for deleted path as well
@@ -1073,10 +1087,8 @@ bool Overlay_Drive::SetFileAttr(const char* name, FatAttributeFlags attr)
 
 void Overlay_Drive::add_deleted_file(const char* name,bool create_on_disk) {
 	if (logoverlay) LOG_MSG("add del file %s",name);
-	if (!is_deleted_file(name)) {
-		deleted_files_in_base.push_back(name);
+	if (deleted_files_in_base.emplace(name).second) {
 		if (create_on_disk) add_special_file_to_disk(name, "DEL");
-
 	}
 }
 
@@ -1118,31 +1130,31 @@ std::string Overlay_Drive::create_filename_of_special_operation(const char* dosn
 
 bool Overlay_Drive::is_dir_only_in_overlay(const char* name) {
 	if (!name || !*name) return false;
-	if (DOSdirs_cache.empty()) return false;
-	for(std::vector<std::string>::iterator it = DOSdirs_cache.begin(); it != DOSdirs_cache.end(); ++it) {
-		if (*it == name) return true;
-	}
-	return false;
+	return DOSdirs_index.find(name) != DOSdirs_index.end();
+}
+
+bool Overlay_Drive::is_file_in_overlay(const char* name) {
+	if (!name || !*name) return false;
+	return DOSnames_cache.find(name) != DOSnames_cache.end();
 }
 
 bool Overlay_Drive::is_deleted_file(const char* name) {
 	if (!name || !*name) return false;
-	if (deleted_files_in_base.empty()) return false;
-	for(std::vector<std::string>::iterator it = deleted_files_in_base.begin(); it != deleted_files_in_base.end(); ++it) {
-		if (*it == name) return true;
-	}
-	return false;
+	return deleted_files_in_base.find(name) != deleted_files_in_base.end();
 }
 
 void Overlay_Drive::add_DOSdir_to_cache(const char* name) {
 	if (!name || !*name ) return; //Skip empty file.
 	LOG_MSG("Adding name to overlay_only_dir_cache %s",name);
-	if (!is_dir_only_in_overlay(name)) {
+	if (DOSdirs_index.emplace(name).second) {
 		DOSdirs_cache.push_back(name); 
 	}
 }
 
 void Overlay_Drive::remove_DOSdir_from_cache(const char* name) {
+	if (DOSdirs_index.erase(name) == 0) {
+		return;
+	}
 	for(std::vector<std::string>::iterator it = DOSdirs_cache.begin(); it != DOSdirs_cache.end(); ++it) {
 		if ( *it == name) {
 			DOSdirs_cache.erase(it);
@@ -1152,19 +1164,15 @@ void Overlay_Drive::remove_DOSdir_from_cache(const char* name) {
 }
 
 void Overlay_Drive::remove_deleted_file(const char* name,bool create_on_disk) {
-	for(std::vector<std::string>::iterator it = deleted_files_in_base.begin(); it != deleted_files_in_base.end(); ++it) {
-		if (*it == name) {
-			deleted_files_in_base.erase(it);
-			if (create_on_disk) remove_special_file_from_disk(name, "DEL");
-			return;
-		}
+	if (deleted_files_in_base.erase(name) != 0) {
+		if (create_on_disk) remove_special_file_from_disk(name, "DEL");
 	}
 }
 void Overlay_Drive::add_deleted_path(const char* name, bool create_on_disk) {
 	if (!name || !*name ) return; //Skip empty file.
 	if (logoverlay) LOG_MSG("add del path %s",name);
 	if (!is_deleted_path(name)) {
-		deleted_paths_in_base.push_back(name);
+		deleted_paths_in_base.emplace(name);
 		//Add it to deleted files as well, so it gets skipped in FindNext. 
 		//Maybe revise that.
 		if (create_on_disk) add_special_file_to_disk(name,"RMD");
@@ -1174,26 +1182,20 @@ void Overlay_Drive::add_deleted_path(const char* name, bool create_on_disk) {
 bool Overlay_Drive::is_deleted_path(const char* name) {
 	if (!name || !*name) return false;
 	if (deleted_paths_in_base.empty()) return false;
-	std::string sname(name);
-	std::string::size_type namelen = sname.length();;
-	for(std::vector<std::string>::iterator it = deleted_paths_in_base.begin(); it != deleted_paths_in_base.end(); ++it) {
-		std::string::size_type blockedlen = (*it).length();
-		if (namelen < blockedlen) continue;
-		//See if input starts with name. 
-		std::string::size_type n = sname.find(*it);
-		if (n == 0 && ((namelen == blockedlen) || *(name + blockedlen) == '\\' )) return true;
+	//See if the name itself or one of its leading directories is deleted.
+	const std::string sname(name);
+	std::string::size_type n = 0;
+	while ((n = sname.find('\\', n)) != std::string::npos) {
+		if (deleted_paths_in_base.count(sname.substr(0, n))) return true;
+		++n;
 	}
-	return false;
+	return deleted_paths_in_base.count(sname) != 0;
 }
 
 void Overlay_Drive::remove_deleted_path(const char* name, bool create_on_disk) {
-	for(std::vector<std::string>::iterator it = deleted_paths_in_base.begin(); it != deleted_paths_in_base.end(); ++it) {
-		if (*it == name) {
-			deleted_paths_in_base.erase(it);
-			remove_deleted_file(name,false); //Rethink maybe.
-			if (create_on_disk) remove_special_file_from_disk(name,"RMD");
-			break;
-		}
+	if (deleted_paths_in_base.erase(name) != 0) {
+		remove_deleted_file(name,false); //Rethink maybe.
+		if (create_on_disk) remove_special_file_from_disk(name,"RMD");
 	}
 }
 bool Overlay_Drive::check_if_leading_is_deleted(const char* name){
@@ -1210,13 +1212,8 @@ bool Overlay_Drive::check_if_leading_is_deleted(const char* name){
 }
 
 bool Overlay_Drive::FileExists(const char* name) {
-	char overlayname[CROSS_LEN];
-	safe_strcpy(overlayname, overlaydir);
-	safe_strcat(overlayname, name);
-	CROSS_FILENAME(overlayname);
-	struct stat temp_stat;
-	if(stat(overlayname,&temp_stat)==0 && (temp_stat.st_mode & S_IFDIR)==0) return true;
-	
+	if (is_file_in_overlay(name)) return true;
+
 	if (is_deleted_file(name)) return false;
 
 	return localDrive::FileExists(name);
@@ -1264,13 +1261,15 @@ bool Overlay_Drive::Rename(const char * oldname, const char * newname) {
 
 	// check if overlaynameold exists and if so rename it to overlaynamenew
 	std::error_code ec = {};
-	if (std_fs::exists(overlaynameold, ec)) {
+	if (is_file_in_overlay(oldname)) {
 		std_fs::rename(overlaynameold, overlaynamenew, ec);
 
 		success = !ec; // success if no error-code
 
 		if (success) {
 			timestamp_cache.erase(overlaynameold);
+			remove_DOSname_from_cache(oldname);
+			add_DOSname_to_cache(newname);
 		}
 
 		// Overlay file renamed: mark the old base file as deleted.
@@ -1313,7 +1312,8 @@ bool Overlay_Drive::Rename(const char * oldname, const char * newname) {
 		//Ensure that the file is not marked as deleted anymore.
 		if (is_deleted_file(newname)) remove_deleted_file(newname,true);
 		dirCache.EmptyCache();
-		update_cache(true);
+		// The overlay's contents are tracked, no need to read them again
+		update_cache(false);
 		if (logoverlay) {
 			LOG_MSG("OPTIMISE: rename took %" PRId64, GetTicksSince(a));
 		}
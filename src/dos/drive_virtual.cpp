@@ -23,6 +23,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <unordered_map>
 
 #include "cross.h"
 #include "dos_inc.h"
@@ -71,6 +72,28 @@ public:
 static vfile_block_t first_file = {};
 static vfile_block_t parent_dir = {};
 
+// The files and directories by their upper-cased path on the drive, e.g.,
+// 'MIXER.COM' or 'SYSTEM\FOO.TXT'. The list above keeps the order FindNext
+// returns the entries in, but every command run through the PATH looks up
+// names on the drive several times, so the lookups go through this index.
+static std::unordered_map<std::string, vfile_block_t> vfiles_by_path = {};
+
+static std::string get_vfile_path(const std::string& name, const unsigned int position)
+{
+	auto path = position ? vfilenames[position].shortname + "\\" + name : name;
+	upcase(path);
+	return path;
+}
+
+static vfile_block_t find_vfile_by_path(const char* path)
+{
+	std::string key = path;
+	upcase(key);
+
+	const auto it = vfiles_by_path.find(key);
+	return it != vfiles_by_path.end() ? it->second : vfile_block_t{};
+}
+
 // this gets replaced with std::find_if later
 template <typename Predicate>
 vfile_block_t find_vfile_by_predicate(vfile_block_t head_file, Predicate predicate_)
@@ -87,9 +110,8 @@ vfile_block_t find_vfile_by_predicate(vfile_block_t head_file, Predicate predica
 
 vfile_block_t find_vfile_by_name_and_pos(const std::string& name, unsigned int position)
 {
-	return find_vfile_by_predicate(first_file, [name, position](vfile_block_t vfile) {
-		return position == vfile->position && iequals(name, vfile->name);
-	});
+	const auto it = vfiles_by_path.find(get_vfile_path(name, position));
+	return it != vfiles_by_path.end() ? it->second : vfile_block_t{};
 }
 
 vfile_block_t find_vfile_by_name_and_dir(const char* name, const char* dir)
@@ -204,6 +226,8 @@ void VFILE_Register(const char *name,
 	new_file->isdir    = isdir;
 	new_file->next = first_file;
 	first_file = new_file;
+
+	vfiles_by_path[get_vfile_path(new_file->name, position)] = new_file;
 }
 
 void VFILE_Register(const char *name, const std::vector<uint8_t> &blob, const char *dir)
@@ -224,15 +248,22 @@ void VFILE_Remove(const char* name, const char* dir)
 {
 	auto vfile = find_vfile_by_name_and_dir(name, dir);
 
-	if (vfile) {
-		if (vfile.get() == first_file.get()) {
-			first_file = vfile->next;
-		}
-		// Finally release the vfile itself
-		vfile.reset();
+	if (!vfile) {
+		return;
+	}
+	vfiles_by_path.erase(get_vfile_path(vfile->name, vfile->position));
 
+	if (vfile == first_file) {
+		first_file = vfile->next;
 		return;
 	}
+	auto prev_file = first_file;
+	while (prev_file && prev_file->next != vfile) {
+		prev_file = prev_file->next;
+	}
+	if (prev_file) {
+		prev_file->next = vfile->next;
+	}
 }
 
 void VFILE_GetPathZDrive(std::string &path, const std::string &dirname)
@@ -639,26 +670,16 @@ const char* Virtual_Drive::GetLabel()
 	return "DOSBOX";
 }
 
-bool Virtual_Drive::is_name_equal(const vfile_block_t vfile, const char* name) const
-{
-	unsigned int position = vfile->position;
-	return iequals(name,
-	               position ? vfilenames[position].shortname + "\\" + vfile->name
-	                        : vfile->name);
-}
-
 vfile_block_t Virtual_Drive::find_vfile_by_name(const char* name) const
 {
-	return find_vfile_by_predicate(first_file, [this, name](vfile_block_t vfile) {
-		return is_name_equal(vfile, name);
-	});
+	return find_vfile_by_path(name);
 }
 
 vfile_block_t Virtual_Drive::find_vfile_dir_by_name(const char* dir) const
 {
-	return find_vfile_by_predicate(first_file, [dir](vfile_block_t vfile) {
-		return vfile->isdir && iequals(vfile->name, dir);
-	});
+	// The directories are all in the root, so their path is their name
+	const auto vfile = find_vfile_by_path(dir);
+	return vfile && vfile->isdir ? vfile : vfile_block_t{};
 }
 
 bool Virtual_Drive::vfile_name_exists(const std::string& name) const
@@ -671,6 +692,7 @@ void Virtual_Drive::EmptyCache()
 	while (first_file) {
 		first_file = first_file->next;
 	}
+	vfiles_by_path.clear();
 	vfile_pos = 1;
 	PROGRAMS_Destroy(nullptr);
 	vfilenames = {Filename{"", ""}};
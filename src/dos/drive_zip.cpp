@@ -0,0 +1,446 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "drives.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "string_utils.h"
+#include "support.h"
+
+// How many of the last opened files stay decompressed after they're closed,
+// as programs often reopen the same files
+constexpr size_t MaxKeptReaders = 4;
+
+class zipFile final : public DOS_File {
+public:
+	zipFile(std::shared_ptr<ZipEntryReader> reader, const char* name,
+	        const ZipArchive::Entry& entry);
+	zipFile(const zipFile&)            = delete;
+	zipFile& operator=(const zipFile&) = delete;
+
+	bool Read(uint8_t* data, uint16_t* size) override;
+	bool Write(uint8_t* data, uint16_t* size) override;
+	bool Seek(uint32_t* pos, uint32_t type) override;
+	void Close() override;
+	uint16_t GetInformation(void) override;
+	bool IsOnReadOnlyMedium() const override;
+
+private:
+	std::shared_ptr<ZipEntryReader> reader = {};
+	uint32_t position                      = 0;
+};
+
+zipFile::zipFile(std::shared_ptr<ZipEntryReader> entry_reader, const char* name,
+                 const ZipArchive::Entry& entry)
+        : reader(std::move(entry_reader))
+{
+	SetName(name);
+	time = entry.dos_time;
+	date = entry.dos_date;
+	attr = static_cast<uint8_t>(entry.dos_attributes | FatAttributeFlags::ReadOnly);
+}
+
+bool zipFile::Read(uint8_t* data, uint16_t* size)
+{
+	size_t num_read = 0;
+	if (!reader->Read(position, data, *size, num_read)) {
+		LOG_WARNING("DOS: Can't decompress '%s' from its ZIP archive",
+		            GetName());
+		*size = 0;
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return false;
+	}
+	*size = check_cast<uint16_t>(num_read);
+	position += *size;
+	return true;
+}
+
+bool zipFile::Write(uint8_t* /*data*/, uint16_t* /*size*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return false;
+}
+
+bool zipFile::Seek(uint32_t* pos, uint32_t type)
+{
+	// The offsets of relative seeks can be negative, and wrap around like
+	// they do on local drives
+	switch (type) {
+	case DOS_SEEK_SET: position = *pos; break;
+	case DOS_SEEK_CUR: position += *pos; break;
+	case DOS_SEEK_END:
+		position = static_cast<uint32_t>(
+		                   std::min<uint64_t>(reader->GetSize(), UINT32_MAX)) +
+		           *pos;
+		break;
+	default: DOS_SetError(DOSERR_FUNCTION_NUMBER_INVALID); return false;
+	}
+	*pos = position;
+	return true;
+}
+
+void zipFile::Close() {}
+
+uint16_t zipFile::GetInformation(void)
+{
+	return 0x40; // read-only drive
+}
+
+bool zipFile::IsOnReadOnlyMedium() const
+{
+	return true;
+}
+
+static FatAttributeFlags get_attributes(const ZipArchive::Entry& entry)
+{
+	FatAttributeFlags attributes = entry.dos_attributes;
+	attributes.volume    = false;
+	attributes.device    = false;
+	attributes.directory = entry.is_directory;
+	attributes.read_only = true;
+	return attributes;
+}
+
+zipDrive::zipDrive(const char* archive_path,
+                   std::unique_ptr<ZipArchive> zip_archive, const uint8_t media_id)
+        : archive(std::move(zip_archive)),
+          mediaid(media_id)
+{
+	type = DosDriveType::Zip;
+	safe_strcpy(info, archive_path);
+
+	root.is_directory = true;
+	root.dos_date     = DOS_PackDate(1980, 1, 1);
+
+	// The drive cache only sees the paths, and lists the archive's
+	// directories instead of the host's. The lister has to be set before
+	// the base directory, which is listed right away.
+	safe_strcpy(basedir, archive_path);
+	constexpr char end[] = {CROSS_FILESPLIT, '\0'};
+	safe_strcat(basedir, end);
+	dirCache.SetDirLister([this](const std::string& dir)
+	                              -> std::optional<std::vector<DOS_Drive_Cache::ListedEntry>> {
+		const auto path    = ToArchivePath(dir.c_str());
+		const auto entries = archive->ListDir(path);
+		if (!entries) {
+			return {};
+		}
+		std::vector<DOS_Drive_Cache::ListedEntry> listed = {};
+		if (!path.empty()) {
+			listed.push_back({".", true});
+			listed.push_back({"..", true});
+		}
+		for (const auto entry : *entries) {
+			listed.push_back({entry->name, entry->is_directory});
+		}
+		return listed;
+	});
+	dirCache.SetBaseDir(basedir);
+}
+
+// Turns a path within the drive cache's base directory into its path in the
+// archive
+std::string zipDrive::ToArchivePath(const char* host_path) const
+{
+	const auto basedir_len = strlen(basedir);
+	std::string path       = host_path;
+	if (path.size() < basedir_len - 1) {
+		return {};
+	}
+	path.erase(0, std::min(path.size(), basedir_len));
+	std::replace(path.begin(), path.end(), CROSS_FILESPLIT, '/');
+	while (!path.empty() && path.back() == '/') {
+		path.pop_back();
+	}
+	return path;
+}
+
+// Finds an entry by its archive path, with any "." and ".." components
+const ZipArchive::Entry* zipDrive::FindEntry(const std::string& archive_path) const
+{
+	std::vector<std::string> components = {};
+	for (const auto& component : split(archive_path, "/")) {
+		if (component == "..") {
+			if (components.empty()) {
+				return nullptr;
+			}
+			components.pop_back();
+		} else if (!component.empty() && component != ".") {
+			components.push_back(component);
+		}
+	}
+	if (components.empty()) {
+		return &root;
+	}
+	std::string path = components.front();
+	for (auto it = components.begin() + 1; it != components.end(); ++it) {
+		path += '/' + *it;
+	}
+	return archive->Find(path);
+}
+
+const ZipArchive::Entry* zipDrive::FindEntry(const char* dos_name)
+{
+	char host_name[CROSS_LEN];
+	safe_strcpy(host_name, basedir);
+	safe_strcat(host_name, dos_name);
+	CROSS_FILENAME(host_name);
+	return FindEntry(ToArchivePath(dirCache.GetExpandNameAndNormaliseCase(host_name)));
+}
+
+std::unique_ptr<DOS_File> zipDrive::FileOpen(const char* name, uint8_t flags)
+{
+	if ((flags & 0x0f) != OPEN_READ) {
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return nullptr;
+	}
+	const auto entry = FindEntry(name);
+	if (!entry || entry->is_directory) {
+		DOS_SetError(DOSERR_FILE_NOT_FOUND);
+		return nullptr;
+	}
+	auto reader = GetReader(*entry);
+	if (!reader) {
+		LOG_WARNING("DOS: Can't open '%s', as it's encrypted or uses an unsupported compression method",
+		            entry->path.c_str());
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return nullptr;
+	}
+	auto file   = std::make_unique<zipFile>(std::move(reader), name, *entry);
+	file->flags = flags;
+	return file;
+}
+
+std::unique_ptr<DOS_File> zipDrive::FileCreate(const char* /*name*/,
+                                               FatAttributeFlags /*attributes*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return nullptr;
+}
+
+bool zipDrive::FileUnlink(const char* /*name*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return false;
+}
+
+bool zipDrive::RemoveDir(const char* /*dir*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return false;
+}
+
+bool zipDrive::MakeDir(const char* /*dir*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return false;
+}
+
+bool zipDrive::TestDir(const char* dir)
+{
+	const auto entry = FindEntry(dir);
+	return entry && entry->is_directory;
+}
+
+bool zipDrive::FindFirst(const char* _dir, DOS_DTA& dta, bool fcb_findfirst)
+{
+	char tempDir[CROSS_LEN];
+	safe_strcpy(tempDir, basedir);
+	safe_strcat(tempDir, _dir);
+	CROSS_FILENAME(tempDir);
+
+	// End the temp directory with a slash
+	const auto temp_dir_len = strlen(tempDir);
+	if (temp_dir_len < 1 || tempDir[temp_dir_len - 1] != CROSS_FILESPLIT) {
+		constexpr char end[] = {CROSS_FILESPLIT, '\0'};
+		safe_strcat(tempDir, end);
+	}
+
+	uint16_t id;
+	if (!dirCache.FindFirst(tempDir, id)) {
+		DOS_SetError(DOSERR_PATH_NOT_FOUND);
+		return false;
+	}
+	safe_strcpy(srchInfo[id].srch_dir, tempDir);
+	dta.SetDirID(id);
+
+	FatAttributeFlags search_attr = {};
+	dta.GetSearchParams(search_attr, tempDir);
+
+	if (search_attr == FatAttributeFlags::Volume) {
+		if (is_empty(dirCache.GetLabel())) {
+			DOS_SetError(DOSERR_NO_MORE_FILES);
+			return false;
+		}
+		dta.SetResult(dirCache.GetLabel(), 0, 0, 0, FatAttributeFlags::Volume);
+		return true;
+	} else if (search_attr.volume && (*_dir == 0) && !fcb_findfirst) {
+		if (WildFileCmp(dirCache.GetLabel(), tempDir)) {
+			dta.SetResult(dirCache.GetLabel(), 0, 0, 0, FatAttributeFlags::Volume);
+			return true;
+		}
+	}
+	return FindNext(dta);
+}
+
+bool zipDrive::FindNext(DOS_DTA& dta)
+{
+	char* dir_ent;
+	char full_name[CROSS_LEN];
+	char dir_entcopy[CROSS_LEN];
+
+	FatAttributeFlags search_attr = {};
+	char search_pattern[DOS_NAMELENGTH_ASCII];
+
+	dta.GetSearchParams(search_attr, search_pattern);
+	uint16_t id = dta.GetDirID();
+
+	while (true) {
+		if (!dirCache.FindNext(id, dir_ent)) {
+			DOS_SetError(DOSERR_NO_MORE_FILES);
+			return false;
+		}
+		if (!WildFileCmp(dir_ent, search_pattern)) {
+			continue;
+		}
+
+		safe_strcpy(full_name, srchInfo[id].srch_dir);
+		safe_strcat(full_name, dir_ent);
+
+		// GetExpandNameAndNormaliseCase might indirectly destroy
+		// dir_ent, so it's copied first
+		safe_strcpy(dir_entcopy, dir_ent);
+		const auto entry = FindEntry(ToArchivePath(
+		        dirCache.GetExpandNameAndNormaliseCase(full_name)));
+		if (!entry) {
+			continue;
+		}
+
+		const auto find_attr = get_attributes(*entry);
+		if ((find_attr.directory && !search_attr.directory) ||
+		    (find_attr.hidden && !search_attr.hidden) ||
+		    (find_attr.system && !search_attr.system)) {
+			continue;
+		}
+
+		/*file is okay, setup everything to be copied in DTA Block */
+		char find_name[DOS_NAMELENGTH_ASCII] = "";
+		if (safe_strlen(dir_entcopy) < DOS_NAMELENGTH_ASCII) {
+			safe_strcpy(find_name, dir_entcopy);
+			upcase(find_name);
+		}
+		const auto find_size = static_cast<uint32_t>(
+		        std::min<uint64_t>(entry->size, UINT32_MAX));
+		dta.SetResult(find_name,
+		              find_size,
+		              entry->dos_date,
+		              entry->dos_time,
+		              find_attr._data);
+		return true;
+	}
+	return false;
+}
+
+bool zipDrive::GetFileAttr(const char* name, FatAttributeFlags* attr)
+{
+	const auto entry = FindEntry(name);
+	if (!entry) {
+		*attr = 0;
+		return false;
+	}
+	*attr = get_attributes(*entry);
+	return true;
+}
+
+bool zipDrive::SetFileAttr(const char* name, [[maybe_unused]] const FatAttributeFlags attr)
+{
+	if (FindEntry(name)) {
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+	} else {
+		DOS_SetError(DOSERR_FILE_NOT_FOUND);
+	}
+	return false;
+}
+
+bool zipDrive::Rename(const char* /*oldname*/, const char* /*newname*/)
+{
+	DOS_SetError(DOSERR_ACCESS_DENIED);
+	return false;
+}
+
+bool zipDrive::AllocationInfo(uint16_t* bytes_sector, uint8_t* sectors_cluster,
+                              uint16_t* total_clusters, uint16_t* free_clusters)
+{
+	*bytes_sector    = 512;
+	*sectors_cluster = 32;
+	*total_clusters  = 32765;
+	*free_clusters   = 0;
+	return true;
+}
+
+bool zipDrive::FileExists(const char* name)
+{
+	const auto entry = FindEntry(name);
+	return entry && !entry->is_directory;
+}
+
+uint8_t zipDrive::GetMediaByte(void)
+{
+	return mediaid;
+}
+
+bool zipDrive::IsRemote(void)
+{
+	return false;
+}
+
+bool zipDrive::IsRemovable(void)
+{
+	return false;
+}
+
+Bits zipDrive::UnMount(void)
+{
+	return 0;
+}
+
+std::shared_ptr<ZipEntryReader> zipDrive::GetReader(const ZipArchive::Entry& entry)
+{
+	const auto it = std::find_if(kept_readers.begin(),
+	                             kept_readers.end(),
+	                             [&](const auto& kept) {
+		                             return kept.first == &entry;
+	                             });
+	if (it != kept_readers.end()) {
+		kept_readers.splice(kept_readers.begin(), kept_readers, it);
+		return it->second;
+	}
+	std::shared_ptr<ZipEntryReader> reader = archive->OpenEntry(entry);
+	if (!reader) {
+		return nullptr;
+	}
+	if (kept_readers.size() >= MaxKeptReaders) {
+		kept_readers.pop_back();
+	}
+	kept_readers.emplace_front(&entry, reader);
+	return reader;
+}
@@ -203,6 +203,7 @@ void DriveManager::RegisterFilesystemImage(const int drive,
 	auto& disks = drive_infos.at(drive).disks;
 	disks.clear();
 	disks.push_back(image);
+	DOS_NotifyFilesChanged();
 }
 
 void DriveManager::AppendFilesystemImages(const int drive,
@@ -221,6 +222,7 @@ void DriveManager::InitializeDrive(int drive) {
 		if (disk_pointer && drive_info.disks.size() > 1) {
 			disk_pointer->Activate();
 		}
+		DOS_NotifyFilesChanged();
 	}
 }
 
@@ -267,6 +269,7 @@ void DriveManager::CycleDisks(int requested_drive, bool notify)
 			new_disk->Activate();
 		}
 		Drives.at(drive) = new_disk;
+		DOS_NotifyFilesChanged();
 
 		// Re-attach the new drive to the controller
 		if (is_cdrom && index > -1) {
@@ -310,6 +313,7 @@ int DriveManager::UnmountDrive(int drive) {
 	if (result == 0) {
 		drive_infos.at(drive) = {};
 		Drives.at(drive)      = nullptr;
+		DOS_NotifyFilesChanged();
 	}
 	return result;
 }
@@ -0,0 +1,109 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "host_dir_watcher.h"
+
+#include "dosbox.h"
+
+#if defined(LINUX)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#if defined(LINUX)
+
+HostDirWatcher::HostDirWatcher()
+{
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd < 0) {
+		LOG_WARNING("DIRCACHE: Can't watch host directories for changes");
+	}
+}
+
+HostDirWatcher::~HostDirWatcher()
+{
+	if (fd >= 0) {
+		close(fd);
+	}
+}
+
+void HostDirWatcher::Watch(const std::string& dir)
+{
+	if (fd < 0) {
+		return;
+	}
+	constexpr uint32_t Mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+	                          IN_MOVED_TO | IN_ONLYDIR;
+
+	// Running out of watches only means the directory isn't refreshed
+	if (const auto wd = inotify_add_watch(fd, dir.c_str(), Mask); wd >= 0) {
+		watched_dirs[wd] = dir;
+	}
+}
+
+std::vector<HostDirWatcher::Event> HostDirWatcher::TakeEvents()
+{
+	std::vector<Event> events = {};
+	if (fd < 0) {
+		return events;
+	}
+
+	alignas(inotify_event) char buffer[4096];
+	ssize_t len = 0;
+	while ((len = read(fd, buffer, sizeof(buffer))) > 0) {
+		for (auto pos = buffer; pos < buffer + len;) {
+			const auto ev = reinterpret_cast<const inotify_event*>(pos);
+			pos += sizeof(inotify_event) + ev->len;
+
+			if (ev->mask & IN_Q_OVERFLOW) {
+				events.push_back({{}, {}, Change::Overflow});
+				continue;
+			}
+			const auto it = watched_dirs.find(ev->wd);
+			if (it == watched_dirs.end()) {
+				continue;
+			}
+			if (ev->mask & IN_IGNORED) {
+				watched_dirs.erase(it);
+				continue;
+			}
+			const auto change = (ev->mask & (IN_CREATE | IN_MOVED_TO))
+			                          ? Change::Added
+			                          : Change::Removed;
+			events.push_back({it->second, ev->len ? ev->name : "", change});
+		}
+	}
+	return events;
+}
+
+#else
+
+HostDirWatcher::HostDirWatcher() {}
+
+HostDirWatcher::~HostDirWatcher() {}
+
+void HostDirWatcher::Watch(const std::string&) {}
+
+std::vector<HostDirWatcher::Event> HostDirWatcher::TakeEvents()
+{
+	return {};
+}
+
+#endif
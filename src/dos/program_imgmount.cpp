@@ -180,6 +180,12 @@ void IMGMOUNT::Run(void)
 		roflag = true;
 	}
 
+	// Writes go to a copy-on-write delta file instead of the image
+	std::string overlay_path = {};
+	if (cmd->FindString("-overlay", overlay_path, true)) {
+		overlay_path = resolve_home(overlay_path).string();
+	}
+
 	// Types 'cdrom' and 'iso' are synonyms. Name 'cdrom' is easier
 	// to remember and makes more sense, while name 'iso' is
 	// required for backwards compatibility and for users conflating
@@ -367,6 +373,11 @@ void IMGMOUNT::Run(void)
 		temp_line = paths[0];
 	}
 
+	if (!overlay_path.empty() && (fstype == "iso" || paths.size() > 1)) {
+		WriteOut(MSG_Get("PROGRAM_IMGMOUNT_OVERLAY_UNSUPPORTED"));
+		return;
+	}
+
 	auto write_out_mount_status = [this](const char* image_type,
 	                                     const std::vector<std::string>& images,
 	                                     const char drive_letter) {
@@ -386,7 +397,11 @@ void IMGMOUNT::Run(void)
 
 	if (fstype == "fat") {
 		if (imgsizedetect) {
-			FILE* diskfile = fopen_wrap_ro_fallback(temp_line, roflag);
+			bool is_image_readonly = roflag || !overlay_path.empty();
+			FILE* diskfile = fopen_wrap_ro_fallback(temp_line, is_image_readonly);
+			if (overlay_path.empty()) {
+				roflag = is_image_readonly;
+			}
 			if (!diskfile) {
 				WriteOut(MSG_Get("PROGRAM_IMGMOUNT_INVALID_IMAGE"));
 				return;
@@ -440,7 +455,8 @@ void IMGMOUNT::Run(void)
 			                                            sizes[1],
 			                                            sizes[2],
 			                                            sizes[3],
-			                                            roflag);
+			                                            roflag,
+			                                            overlay_path);
 			if (fat_image->created_successfully) {
 				fat_images.push_back(fat_image);
 			} else {
@@ -559,7 +575,9 @@ void IMGMOUNT::Run(void)
 		write_out_mount_status(MSG_Get("MOUNT_TYPE_ISO"), paths, drive);
 
 	} else if (fstype == "none") {
-		FILE* new_disk = fopen_wrap_ro_fallback(temp_line, roflag);
+		// With an overlay, the image itself is only ever read
+		bool is_image_readonly = roflag || !overlay_path.empty();
+		FILE* new_disk = fopen_wrap_ro_fallback(temp_line, is_image_readonly);
 		if (!new_disk) {
 			WriteOut(MSG_Get("PROGRAM_IMGMOUNT_INVALID_IMAGE"));
 			return;
@@ -582,13 +600,19 @@ void IMGMOUNT::Run(void)
 
 		const auto drive_index = drive - '0';
 
-		imageDiskList.at(drive_index) = std::make_shared<imageDisk>(
-		        new_disk, temp_line.c_str(), imagesize, is_hdd);
-
+		auto new_image = std::make_shared<imageDisk>(new_disk,
+		                                             temp_line.c_str(),
+		                                             imagesize,
+		                                             is_hdd);
 		if (is_hdd) {
-			imageDiskList.at(drive_index)
-			        ->Set_Geometry(sizes[2], sizes[3], sizes[1], sizes[0]);
+			new_image->Set_Geometry(sizes[2], sizes[3], sizes[1], sizes[0]);
+		}
+		if (!overlay_path.empty() && !new_image->AttachOverlay(overlay_path)) {
+			WriteOut(MSG_Get("PROGRAM_IMGMOUNT_INVALID_OVERLAY"),
+			         overlay_path.c_str());
+			return;
 		}
+		imageDiskList.at(drive_index) = new_image;
 
 		if ((drive == '2' || drive == '3') && is_hdd) {
 			updateDPT();
@@ -615,11 +639,12 @@ void IMGMOUNT::AddMessages()
 	        "  [color=light-green]imgmount[reset] [color=white]DRIVE[reset] [color=light-cyan]CDROM-SET[reset] [-fs iso] [-ide] -t cdrom|iso\n"
 	        "  [color=light-green]imgmount[reset] [color=white]DRIVE[reset] [color=light-cyan]IMAGEFILE[reset] [IMAGEFILE2 [..]] [-fs fat] -t hdd|floppy -ro\n"
 	        "  [color=light-green]imgmount[reset] [color=white]DRIVE[reset] [color=light-cyan]BOOTIMAGE[reset] [-fs fat|none] -t hdd -size GEOMETRY -ro\n"
+	        "  [color=light-green]imgmount[reset] [color=white]DRIVE[reset] [color=light-cyan]IMAGEFILE[reset] [-fs fat|none] -t hdd|floppy -overlay DELTAFILE\n"
 	        "  [color=light-green]imgmount[reset] -u [color=white]DRIVE[reset]  (unmounts the [color=white]DRIVE[reset]'s image)\n"
 	        "\n"
 	        "Parameters:\n"
 	        "  [color=white]DRIVE[reset]      drive letter where the image will be mounted: A, C, D, ...\n"
-	        "  [color=light-cyan]CDROM-SET[reset]  ISO, CUE+BIN, CUE+ISO, or CUE+ISO+FLAC/OPUS/OGG/MP3/WAV\n"
+	        "  [color=light-cyan]CDROM-SET[reset]  ISO, CUE+BIN, CUE+ISO, CUE+ISO+FLAC/OPUS/OGG/MP3/WAV, or CHD\n"
 	        "  [color=light-cyan]IMAGEFILE[reset]  hard drive or floppy image in FAT16 or FAT12 format\n"
 	        "  [color=light-cyan]BOOTIMAGE[reset]  bootable disk image with specified -size GEOMETRY:\n"
 	        "             bytes-per-sector,sectors-per-head,heads,cylinders\n"
@@ -629,6 +654,9 @@ void IMGMOUNT::AddMessages()
 			"      [color=light-green]imgmount[reset] [color=white]A[reset] [color=light-cyan]floppy*.img[reset] -t floppy\n"
 	        "  - [color=yellow]%s+F4[reset] swaps & mounts the next [color=light-cyan]CDROM-SET[reset] or [color=light-cyan]BOOTIMAGE[reset], if provided.\n"
 	        "  - The -ro flag mounts the disk image in read-only (write-protected) mode.\n"
+	        "  - The -overlay flag writes all changes to the DELTAFILE instead of the image,\n"
+	        "    which is left unchanged. The DELTAFILE is created if it doesn't exist, and\n"
+	        "    only grows by the sectors written, so many DELTAFILEs can share an image.\n"
 	        "  - The -ide flag emulates an IDE controller with attached IDE CD drive, useful\n"
 	        "    for CD-based games that need a real DOS environment via bootable HDD image.\n"
 	        "\n"
@@ -689,6 +717,13 @@ void IMGMOUNT::AddMessages()
 	        "Drive already mounted at that letter.\n");
 
 	MSG_Add("PROGRAM_IMGMOUNT_CANT_CREATE", "Can't create drive from file.\n");
+
+	MSG_Add("PROGRAM_IMGMOUNT_OVERLAY_UNSUPPORTED",
+	        "The -overlay flag needs a single floppy or hard drive image.\n");
+
+	MSG_Add("PROGRAM_IMGMOUNT_INVALID_OVERLAY",
+	        "Could not open '%s' as an overlay of the image.\n"
+	        "Check that it's accessible and was created for the same image.\n");
 	MSG_Add("PROGRAM_IMGMOUNT_MOUNT_NUMBER", "Drive number %d mounted as %s.\n");
 
 	MSG_Add("PROGRAM_IMGMOUNT_NON_LOCAL_DRIVE",
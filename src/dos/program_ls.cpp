@@ -20,6 +20,7 @@
 
 #include "program_ls.h"
 
+#include <algorithm>
 #include <string>
 
 #include "ansi_code_markup.h"
@@ -98,30 +99,20 @@ void LS::Run()
 
 	std::vector<DOS_DTA::Result> dir_contents = {};
 
-	const RealPt original_dta = dos.dta();
-	dos.dta(dos.tables.tempdta);
-	DOS_DTA dta(dos.dta());
-
 	for (const auto& pattern : patterns) {
 		if (shutdown_requested) {
 			break;
 		}
-
-		if (!DOS_FindFirst(pattern.c_str(), search_attr)) {
-			continue;
-		}
-
-		do {
-			DOS_DTA::Result result = {};
-			dta.GetResult(result);
-			if (result.IsDummyDirectory()) {
-				continue;
-			}
-			dir_contents.push_back(result);
-		} while (!shutdown_requested && DOS_FindNext());
+		DOS_FindAll(pattern.c_str(), search_attr, dir_contents);
 	}
 
-	dos.dta(original_dta);
+	dir_contents.erase(std::remove_if(dir_contents.begin(),
+	                                  dir_contents.end(),
+	                                  [](const DOS_DTA::Result& result) {
+		                                  return result.IsDummyDirectory();
+	                                  }),
+	                   dir_contents.end());
+
 	if (shutdown_requested) {
 		return;
 	}
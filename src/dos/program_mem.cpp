@@ -22,6 +22,7 @@
 #include "program_mem.h"
 
 #include "callback.h"
+#include "host_memory.h"
 #include "program_more_output.h"
 #include "regs.h"
 
@@ -33,6 +34,10 @@ void MEM::Run(void)
 		output.Display();
 		return;
 	}
+	if (cmd->FindExist("/HOST", false)) {
+		ShowHostMemory();
+		return;
+	}
 	/* Show conventional Memory */
 	WriteOut("\n");
 
@@ -108,26 +113,69 @@ void MEM::Run(void)
 	}
 }
 
+void MEM::ShowHostMemory()
+{
+	constexpr size_t KB = 1024;
+
+	WriteOut("\n");
+	WriteOut(MSG_Get("PROGRAM_MEM_HOST_HEADER"));
+
+	size_t total_bytes          = 0;
+	size_t total_resident_bytes = 0;
+	for (const auto& usage : HOST_MEMORY_GetUsage()) {
+		WriteOut(MSG_Get("PROGRAM_MEM_HOST_USE"),
+		         HOST_MEMORY_GetName(usage.use),
+		         usage.num_bytes / KB,
+		         usage.num_resident_bytes / KB);
+
+		total_bytes += usage.num_bytes;
+		total_resident_bytes += usage.num_resident_bytes;
+	}
+	WriteOut(MSG_Get("PROGRAM_MEM_HOST_USE"),
+	         MSG_Get("PROGRAM_MEM_HOST_TOTAL"),
+	         total_bytes / KB,
+	         total_resident_bytes / KB);
+
+	const auto resident_bytes = HOST_MEMORY_GetProcessResidentBytes();
+	const auto peak_bytes     = HOST_MEMORY_GetProcessPeakResidentBytes();
+	if (resident_bytes && peak_bytes) {
+		WriteOut("\n");
+		WriteOut(MSG_Get("PROGRAM_MEM_HOST_PROCESS"),
+		         *resident_bytes / KB,
+		         *peak_bytes / KB);
+	}
+}
+
 void MEM::AddMessages()
 {
 	MSG_Add("PROGRAM_MEM_HELP_LONG",
 	        "Display the DOS memory information.\n"
 	        "\n"
 	        "Usage:\n"
-	        "  [color=light-green]mem[reset]\n"
+	        "  [color=light-green]mem[reset] [/host]\n"
 	        "\n"
 	        "Parameters:\n"
-	        "  This command has no parameters.\n"
+	        "  /host  show the host memory used by the emulator instead\n"
 	        "\n"
 	        "Notes:\n"
 	        "  This command shows the DOS memory status, including the free conventional\n"
 	        "  memory, UMB (upper) memory, XMS (extended) memory, and EMS (expanded) memory.\n"
+	        "  With /host, it shows the host memory taken by the emulated RAM, the video\n"
+	        "  memory, the dynamic core's code cache, the SoundFonts, and other large\n"
+	        "  buffers, and how much of it is resident in the host's physical memory.\n"
 	        "\n"
 	        "Examples:\n"
-	        "  [color=light-green]mem[reset]\n");
+	        "  [color=light-green]mem[reset]\n"
+	        "  [color=light-green]mem[reset] /host\n");
 	MSG_Add("PROGRAM_MEM_CONVEN", "%10d KB free conventional memory\n");
 	MSG_Add("PROGRAM_MEM_EXTEND", "%10d KB free extended memory\n");
 	MSG_Add("PROGRAM_MEM_EXPAND", "%10d KB free expanded memory\n");
 	MSG_Add("PROGRAM_MEM_UPPER",
 	        "%10d KB free upper memory in %d blocks (largest UMB %d KB)\n");
+	MSG_Add("PROGRAM_MEM_HOST_HEADER",
+	        "Host memory          Allocated      Resident\n");
+	MSG_Add("PROGRAM_MEM_HOST_USE", "%-16s %10zu KB %9zu KB\n");
+	MSG_Add("PROGRAM_MEM_HOST_TOTAL", "Total");
+	MSG_Add("PROGRAM_MEM_HOST_PROCESS",
+	        "Process: %zu KB resident, %zu KB at peak\n");
 }
@@ -37,6 +37,7 @@ public:
 	void Run(void) override;
 private:
         static void AddMessages();
+	void ShowHostMemory();
 };
 
 #endif // DOSBOX_PROGRAM_MEM_H
@@ -20,6 +20,7 @@
 
 #include "program_mixer.h"
 
+#include <algorithm>
 #include <cctype>
 #include <optional>
 
@@ -744,6 +745,10 @@ void MIXER::Run()
 		MIDI_ListAll(this);
 		return;
 	}
+	if (cmd->FindExist("/PROFILE")) {
+		ShowProfile();
+		return;
+	}
 
 	constexpr auto remove = true;
 	auto show_status      = !cmd->FindExist("/NOSHOW", remove);
@@ -800,6 +805,7 @@ void MIXER::AddMessages()
 	        "Usage:\n"
 	        "  [color=light-green]mixer[reset] [color=light-cyan][CHANNEL][reset] [color=white]COMMANDS[reset] [/noshow]\n"
 	        "  [color=light-green]mixer[reset] [/listmidi]\n"
+	        "  [color=light-green]mixer[reset] [/profile]\n"
 	        "\n"
 	        "Parameters:\n"
 	        "  [color=light-cyan]CHANNEL[reset]   mixer channel to change the settings of\n"
@@ -815,6 +821,8 @@ void MIXER::AddMessages()
 	        "Notes:\n"
 	        "  - Run [color=light-green]mixer[reset] without arguments to view the current settings.\n"
 	        "  - Run [color=light-green]mixer[reset] /listmidi to list all available MIDI devices.\n"
+	        "  - Run [color=light-green]mixer[reset] /profile to show the host CPU time the channels and\n"
+	        "    effects have used since the previous /profile run.\n"
 	        "  - You may change the settings of more than one channel in a single command.\n"
 	        "  - If no channel is specified, you can set crossfeed, reverb, or chorus\n"
 	        "    of all channels globally.\n"
@@ -830,6 +838,14 @@ void MIXER::AddMessages()
 	MSG_Add("SHELL_CMD_MIXER_HEADER_LABELS",
 	        "[color=white]Channel      Volume    Volume (dB)   Mode     Xfeed  Reverb  Chorus[reset]");
 
+	MSG_Add("SHELL_CMD_MIXER_PROFILE_LAYOUT", "%-22s %7.2f%% %7.2f%% %7.2f%% %7.2f%%");
+	MSG_Add("SHELL_CMD_MIXER_PROFILE_TOTAL_LAYOUT", "%-22s%27s %7.2f%%");
+
+	MSG_Add("SHELL_CMD_MIXER_PROFILE_LABELS",
+	        "[color=white]Host CPU time used over the last %.1f seconds:\n"
+	        "\n"
+	        "Channel       Device Resample  Filters    Total[reset]");
+
 	MSG_Add("SHELL_CMD_MIXER_CHANNEL_OFF", "off");
 	MSG_Add("SHELL_CMD_MIXER_CHANNEL_STEREO", "Stereo");
 	MSG_Add("SHELL_CMD_MIXER_CHANNEL_REVERSE", "Reverse");
@@ -987,3 +1003,70 @@ void MIXER::ShowMixerStatus()
 
 	MIXER_UnlockAudioDevice();
 }
+
+void MIXER::ShowProfile()
+{
+	std::string column_layout = MSG_Get("SHELL_CMD_MIXER_PROFILE_LAYOUT");
+	column_layout.append({'\n'});
+
+	std::string total_layout = MSG_Get("SHELL_CMD_MIXER_PROFILE_TOTAL_LAYOUT");
+	total_layout.append({'\n'});
+
+	MIXER_LockAudioDevice();
+
+	const auto profile = MIXER_GetProfile();
+
+	// Percentages of the host time the measurements span
+	const auto elapsed_ns = static_cast<double>(std::max(profile.elapsed_ns,
+	                                                     int64_t{1}));
+	auto to_percent = [&](const int64_t ns) {
+		return static_cast<double>(ns) * 100.0 / elapsed_ns;
+	};
+
+	auto markup_name = [](const std::string& name) {
+		return convert_ansi_markup(std::string("[color=light-cyan]") +
+		                           name + std::string("[reset]"));
+	};
+
+	auto show_channel = [&](const std::string& name,
+	                        const MixerChannelProfile& p) {
+		WriteOut(column_layout.c_str(),
+		         markup_name(name).c_str(),
+		         to_percent(p.device_ns),
+		         to_percent(p.resample_ns),
+		         to_percent(p.filters_ns),
+		         to_percent(p.device_ns + p.resample_ns + p.filters_ns));
+	};
+
+	// The master and its effects only have a total
+	auto show_total = [&](const std::string& name, const int64_t ns) {
+		WriteOut(total_layout.c_str(), markup_name(name).c_str(), "", to_percent(ns));
+	};
+
+	WriteOut(MSG_Get("SHELL_CMD_MIXER_PROFILE_LABELS"),
+	         elapsed_ns / 1'000'000'000.0);
+	WriteOut("\n");
+
+	int64_t total_ns = 0;
+
+	for (auto& [name, chan] : MIXER_GetChannels()) {
+		const auto p = chan->GetProfile();
+		show_channel(name, p);
+
+		total_ns += p.device_ns + p.resample_ns + p.filters_ns;
+	}
+
+	show_total("REVERB", profile.reverb_ns);
+	show_total("CHORUS", profile.chorus_ns);
+	show_total(ChannelName::Master, profile.master_ns);
+
+	total_ns += profile.reverb_ns + profile.chorus_ns + profile.master_ns;
+
+	WriteOut("\n");
+	show_total("TOTAL", total_ns);
+
+	MIXER_UnlockAudioDevice();
+
+	// Every run shows the time since the previous one
+	MIXER_ResetProfile();
+}
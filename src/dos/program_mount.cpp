@@ -268,15 +268,33 @@ void MOUNT::Run(void) {
 			return;
 		}
 		/* Not a switch so a normal directory/file */
-		if (!S_ISDIR(test.st_mode)) {
-			WriteOut(MSG_Get("PROGRAM_MOUNT_ERROR_2"),temp_line.c_str());
-			return;
-		}
+		const bool is_directory = S_ISDIR(test.st_mode);
 
-		if (temp_line[temp_line.size() - 1] != CROSS_FILESPLIT) temp_line += CROSS_FILESPLIT;
+		if (is_directory && temp_line[temp_line.size() - 1] != CROSS_FILESPLIT) temp_line += CROSS_FILESPLIT;
 		uint8_t int8_tize = (uint8_t)sizes[1];
 
-		if (type == "cdrom") {
+		if (!is_directory) {
+			// Files can only be mounted as ZIP archives, as read-only
+			// drives of their contents
+			std::string zip_error = {};
+			auto archive = (type == "dir")
+			                     ? ZipArchive::Open(temp_line, zip_error)
+			                     : nullptr;
+			if (!archive) {
+				if (zip_error.empty()) {
+					WriteOut(MSG_Get("PROGRAM_MOUNT_ERROR_2"),
+					         temp_line.c_str());
+				} else {
+					WriteOut(MSG_Get("PROGRAM_MOUNT_ZIP_ERROR"),
+					         temp_line.c_str(),
+					         zip_error.c_str());
+				}
+				return;
+			}
+			newdrive = std::make_shared<zipDrive>(temp_line.c_str(),
+			                                      std::move(archive),
+			                                      mediaid);
+		} else if (type == "cdrom") {
 			// Following options were relevant only for physical CD-ROM support:
 			for (auto opt : {"-noioctl", "-ioctl", "-ioctl_dx", "-ioctl_mci", "-ioctl_dio"}) {
 				if (cmd->FindExist(opt, false))
@@ -360,6 +378,16 @@ void MOUNT::Run(void) {
 				        readonly,
 				        section->Get_bool(
 				                "allow_write_protected_files"));
+
+				const auto dos_section = static_cast<Section_prop*>(
+				        control->GetSection("dos"));
+				assert(dos_section);
+				if (type == "dir") {
+					newdrive->dirCache.StartWatching();
+					if (dos_section->Get_bool("mount_prefetch")) {
+						newdrive->dirCache.StartPrefetch();
+					}
+				}
 			}
 		}
 	} else {
@@ -420,7 +448,7 @@ void MOUNT::AddMessages() {
 	        "\n"
 	        "Parameters:\n"
 	        "  [color=white]DRIVE[reset]      drive letter where the directory will be mounted: A, C, D, ...\n"
-	        "  [color=light-cyan]DIRECTORY[reset]  directory on the host OS to mount\n"
+	        "  [color=light-cyan]DIRECTORY[reset]  directory on the host OS to mount, or a ZIP archive\n"
 	        "  TYPE       type of the directory to mount: dir, floppy, cdrom, or overlay\n"
 	        "  SIZE       free space for the virtual drive (KB for floppies, MB otherwise)\n"
 	        "  LABEL      drive label name to use\n"
@@ -428,6 +456,7 @@ void MOUNT::AddMessages() {
 	        "Notes:\n"
 	        "  - '-t overlay' redirects writes for mounted drive to another directory.\n"
 	        "  - '-ro' mounts the drive as read-only.\n"
+	        "  - ZIP archives are always mounted read-only, as drives of their contents.\n"
 	        "  - Additional options are described in the manual (README file, chapter 4).\n"
 	        "\n"
 	        "Examples:\n");
@@ -446,7 +475,8 @@ void MOUNT::AddMessages() {
 
 	MSG_Add("PROGRAM_MOUNT_CDROMS_FOUND","CD-ROMs found: %d\n");
 	MSG_Add("PROGRAM_MOUNT_ERROR_1","Directory %s doesn't exist.\n");
-	MSG_Add("PROGRAM_MOUNT_ERROR_2","%s isn't a directory.\n");
+	MSG_Add("PROGRAM_MOUNT_ERROR_2","%s isn't a directory or a ZIP archive.\n");
+	MSG_Add("PROGRAM_MOUNT_ZIP_ERROR", "Can't mount %s: %s.\n");
 	MSG_Add("PROGRAM_MOUNT_ILL_TYPE","Illegal type %s\n");
 	MSG_Add("PROGRAM_MOUNT_ALREADY_MOUNTED","Drive %c already mounted with %s\n");
 	MSG_Add("PROGRAM_MOUNT_UMOUNT_NOT_MOUNTED","Drive %c isn't mounted.\n");
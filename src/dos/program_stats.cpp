@@ -0,0 +1,147 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "program_stats.h"
+
+#include "guest_stats.h"
+#include "program_more_output.h"
+
+constexpr size_t MaxTopEntries = 10;
+
+void STATS::Run()
+{
+	if (HelpRequested()) {
+		MoreOutputStrings output(*this);
+		output.AddString(MSG_Get("PROGRAM_STATS_HELP_LONG"));
+		output.Display();
+		return;
+	}
+
+	if (cmd->FindExist("/reset", true)) {
+		STATS_Reset();
+		WriteOut(MSG_Get("PROGRAM_STATS_RESET"));
+		return;
+	}
+
+	// Copy the counters first, so the output doesn't count itself
+	const auto stats   = guest_stats;
+	const auto seconds = STATS_GetSecondsSinceReset();
+
+	MoreOutputStrings output(*this);
+	output.AddString(MSG_Get("PROGRAM_STATS_ELAPSED"), seconds);
+
+	output.AddString("\n");
+	output.AddString(MSG_Get("PROGRAM_STATS_CYCLES_HEADER"));
+	for (size_t i = 0; i < NumStatsCores; ++i) {
+		if (const auto cycles = stats.cycles[i]; cycles) {
+			const auto mips = seconds > 0.0 ? cycles / seconds / 1'000'000.0
+			                                : 0.0;
+			output.AddString("  %-10s %16llu %10.2f\n",
+			                 STATS_GetCoreName(static_cast<StatsCore>(i)),
+			                 static_cast<unsigned long long>(cycles),
+			                 mips);
+		}
+	}
+
+	auto add_count = [&](const char* msg_name, const uint64_t count) {
+		output.AddString("  %-40s %16llu\n",
+		                 MSG_Get(msg_name),
+		                 static_cast<unsigned long long>(count));
+	};
+	output.AddString("\n");
+	add_count("PROGRAM_STATS_DYN_TRANSLATED", stats.dyn_blocks_translated);
+	add_count("PROGRAM_STATS_DYN_INVALIDATED", stats.dyn_blocks_invalidated);
+	add_count("PROGRAM_STATS_PIC_EVENTS", stats.pic_events);
+	add_count("PROGRAM_STATS_PAGE_FAULTS", stats.page_faults);
+	add_count("PROGRAM_STATS_NESTED_PAGE_FAULTS", stats.nested_page_faults);
+	add_count("PROGRAM_STATS_TLB_FLUSHES", stats.tlb_flushes);
+
+	auto add_top_counts = [&](const char* msg_name,
+	                          const uint64_t* counts,
+	                          const size_t num_counts,
+	                          const int index_digits) {
+		output.AddString("\n");
+		output.AddString(MSG_Get(msg_name));
+
+		const auto top_counts = STATS_GetTopCounts(counts,
+		                                           num_counts,
+		                                           MaxTopEntries);
+		if (top_counts.empty()) {
+			output.AddString(MSG_Get("PROGRAM_STATS_NONE"));
+		}
+		for (const auto& entry : top_counts) {
+			output.AddString("  %0*Xh %16llu\n",
+			                 index_digits,
+			                 entry.index,
+			                 static_cast<unsigned long long>(entry.count));
+		}
+	};
+	add_top_counts("PROGRAM_STATS_PORTS_HEADER",
+	               stats.io_port_accesses.data(),
+	               stats.io_port_accesses.size(),
+	               3);
+	add_top_counts("PROGRAM_STATS_INT21_HEADER",
+	               stats.int21_calls.data(),
+	               stats.int21_calls.size(),
+	               2);
+
+	output.Display();
+}
+
+void STATS::AddMessages()
+{
+	MSG_Add("PROGRAM_STATS_HELP_LONG",
+	        "Display the guest performance counters.\n"
+	        "\n"
+	        "Usage:\n"
+	        "  [color=light-green]stats[reset]\n"
+	        "  [color=light-green]stats[reset] /reset\n"
+	        "\n"
+	        "Parameters:\n"
+	        "  /reset  reset all counters to zero\n"
+	        "\n"
+	        "Notes:\n"
+	        "  - The counters show where the emulated machine spends its time: the cycles\n"
+	        "    executed with each CPU core, the dynamic core's translated blocks, the\n"
+	        "    timer events, page faults, TLB flushes, the busiest I/O ports, and the\n"
+	        "    most called DOS (INT 21h) functions.\n"
+	        "  - The MIPS figures are the cycles per second of host time since the last\n"
+	        "    reset, including the time spent idle.\n"
+	        "  - Set [color=light-cyan]stats_log_interval[reset] to also log the counters periodically.\n"
+	        "\n"
+	        "Examples:\n"
+	        "  [color=light-green]stats[reset]\n"
+	        "  [color=light-green]stats[reset] /reset\n");
+	MSG_Add("PROGRAM_STATS_RESET", "Guest performance counters reset.\n");
+	MSG_Add("PROGRAM_STATS_ELAPSED", "Counted over %.1f seconds\n");
+	MSG_Add("PROGRAM_STATS_CYCLES_HEADER",
+	        "  [color=white]CPU core             Cycles       MIPS[reset]\n");
+	MSG_Add("PROGRAM_STATS_DYN_TRANSLATED", "Dynamic core blocks translated");
+	MSG_Add("PROGRAM_STATS_DYN_INVALIDATED", "Dynamic core blocks invalidated");
+	MSG_Add("PROGRAM_STATS_PIC_EVENTS", "Timer events");
+	MSG_Add("PROGRAM_STATS_PAGE_FAULTS", "Page faults");
+	MSG_Add("PROGRAM_STATS_NESTED_PAGE_FAULTS", "Page faults handled in a nested loop");
+	MSG_Add("PROGRAM_STATS_TLB_FLUSHES", "TLB flushes");
+	MSG_Add("PROGRAM_STATS_PORTS_HEADER",
+	        "  [color=white]Busiest I/O ports[reset]\n");
+	MSG_Add("PROGRAM_STATS_INT21_HEADER",
+	        "  [color=white]Most called INT 21h functions[reset]\n");
+	MSG_Add("PROGRAM_STATS_NONE", "  none\n");
+}
@@ -287,27 +287,22 @@ bool TREE::DisplayTree(MoreOutputStrings& output, const std::string& path,
 
 	// Get directory content
 
-	const RealPt save_dta = dos.dta();
-	dos.dta(dos.tables.tempdta);
-
 	const auto pattern = path + "*.*";
 	FatAttributeFlags flags = {};
 	flags.system    = true;
 	flags.hidden    = true;
 	flags.directory = true;
 
-	bool has_next_entry = DOS_FindFirst(pattern.c_str(), flags._data);
+	std::vector<DOS_DTA::Result> search_results = {};
+	DOS_FindAll(pattern.c_str(), flags._data, search_results);
 	size_t space_needed = 7; // length of indentation + ellipsis
 
-	while (!shutdown_requested && has_next_entry) {
-		DOS_DTA::Result result = {};
-
-		const DOS_DTA dta(dos.dta());
-		dta.GetResult(result);
+	for (const auto& result : search_results) {
+		if (shutdown_requested) {
+			break;
+		}
 		assert(!result.name.empty());
 
-		has_next_entry = DOS_FindNext();
-
 		if (!should_display(result)) {
 			continue;
 		}
@@ -320,7 +315,6 @@ bool TREE::DisplayTree(MoreOutputStrings& output, const std::string& path,
 		}
 
 		if (dir_contents.size() > MaxObjectsInDir) {
-			dos.dta(save_dta);
 			output.AddString("\n");
 			output.AddString(
 			        MSG_Get("PROGRAM_TREE_TOO_MANY_FILES_SUBDIRS"));
@@ -329,8 +323,6 @@ bool TREE::DisplayTree(MoreOutputStrings& output, const std::string& path,
 		}
 	}
 
-	dos.dta(save_dta);
-
 	// If paging is enabled, chek if we have enough screen horizontal space
 	// to display this directory
 
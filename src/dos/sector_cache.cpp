@@ -0,0 +1,148 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "sector_cache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+SectorCache::SectorCache(const size_t _max_sectors, const size_t _sector_size,
+                         WriteSector _write_sector)
+        : write_sector(std::move(_write_sector)),
+          max_sectors(_max_sectors),
+          sector_size(_sector_size)
+{
+	assert(sector_size > 0);
+	index.reserve(max_sectors);
+}
+
+bool SectorCache::Contains(const uint32_t sectnum) const
+{
+	return index.find(sectnum) != index.end();
+}
+
+bool SectorCache::Read(const uint32_t sectnum, void* data)
+{
+	const auto it = index.find(sectnum);
+	if (it == index.end()) {
+		return false;
+	}
+	// Move the sector to the front as the most recently used
+	entries.splice(entries.begin(), entries, it->second);
+
+	std::memcpy(data, it->second->data.data(), sector_size);
+	return true;
+}
+
+void SectorCache::Insert(const uint32_t sectnum, const void* data)
+{
+	if (IsEnabled()) {
+		Store(sectnum, data);
+	}
+}
+
+void SectorCache::Write(const uint32_t sectnum, const void* data)
+{
+	assert(write_sector);
+	if (!IsEnabled()) {
+		write_sector(sectnum, static_cast<const uint8_t*>(data));
+		return;
+	}
+	Store(sectnum, data).is_dirty = true;
+}
+
+bool SectorCache::WriteIfCached(const uint32_t sectnum, const void* data)
+{
+	assert(write_sector);
+	if (!Contains(sectnum)) {
+		return false;
+	}
+	Store(sectnum, data).is_dirty = true;
+	return true;
+}
+
+SectorCache::Entry& SectorCache::Store(const uint32_t sectnum, const void* data)
+{
+	assert(IsEnabled());
+
+	if (const auto it = index.find(sectnum); it != index.end()) {
+		entries.splice(entries.begin(), entries, it->second);
+	} else {
+		if (entries.size() >= max_sectors) {
+			// Evict the least recently used sector, recycling its
+			// buffer
+			auto& oldest = entries.back();
+			if (oldest.is_dirty) {
+				write_sector(oldest.sectnum, oldest.data.data());
+			}
+			index.erase(oldest.sectnum);
+			entries.splice(entries.begin(), entries, std::prev(entries.end()));
+		} else {
+			entries.emplace_front();
+			entries.front().data.resize(sector_size);
+		}
+		auto& entry    = entries.front();
+		entry.sectnum  = sectnum;
+		entry.is_dirty = false;
+		index[sectnum] = entries.begin();
+	}
+
+	auto& entry = entries.front();
+	std::memcpy(entry.data.data(), data, sector_size);
+	return entry;
+}
+
+void SectorCache::Flush()
+{
+	std::vector<Entry*> dirty_entries = {};
+	for (auto& entry : entries) {
+		if (entry.is_dirty) {
+			dirty_entries.push_back(&entry);
+		}
+	}
+	// Write back in the order of the disk to keep the host writes
+	// sequential
+	std::sort(dirty_entries.begin(),
+	          dirty_entries.end(),
+	          [](const Entry* a, const Entry* b) { return a->sectnum < b->sectnum; });
+
+	for (auto entry : dirty_entries) {
+		write_sector(entry->sectnum, entry->data.data());
+		entry->is_dirty = false;
+	}
+}
+
+void SectorCache::Clear()
+{
+	Flush();
+	entries.clear();
+	index.clear();
+}
+
+size_t SectorCache::GetNumDirtySectors() const
+{
+	return static_cast<size_t>(
+	        std::count_if(entries.begin(), entries.end(), [](const Entry& entry) {
+		        return entry.is_dirty;
+	        }));
+}
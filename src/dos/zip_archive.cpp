@@ -0,0 +1,482 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "zip_archive.h"
+
+#include "config.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(C_SYSTEM_ZLIB_NG)
+#include <zlib-ng.h>
+#define inflateInit2 zng_inflateInit2
+#define inflate zng_inflate
+#define inflateEnd zng_inflateEnd
+#define z_stream zng_stream
+#else
+#include <zlib.h>
+#endif
+
+#include "cross.h"
+#include "mem_host.h"
+
+namespace {
+
+constexpr uint32_t EndOfCentralDirSignature        = 0x06054b50;
+constexpr uint32_t Zip64EndOfCentralDirSignature   = 0x06064b50;
+constexpr uint32_t Zip64EndLocatorSignature        = 0x07064b50;
+constexpr uint32_t CentralDirEntrySignature        = 0x02014b50;
+constexpr uint32_t LocalHeaderSignature            = 0x04034b50;
+
+constexpr size_t EndOfCentralDirSize      = 22;
+constexpr size_t Zip64EndOfCentralDirSize = 56;
+constexpr size_t Zip64EndLocatorSize      = 20;
+constexpr size_t CentralDirEntrySize      = 46;
+constexpr size_t LocalHeaderSize          = 30;
+
+// The end of the central directory can be followed by a comment of up to
+// 64 KB
+constexpr size_t MaxCommentSize = 0xffff;
+
+constexpr uint16_t Zip64ExtraFieldId = 0x0001;
+
+constexpr uint16_t MethodStored   = 0;
+constexpr uint16_t MethodDeflated = 8;
+
+constexpr uint16_t FlagEncrypted = 1 << 0;
+
+// The 'made by' hosts whose external attributes hold FAT attributes: MS-DOS,
+// OS/2 HPFS, Windows NTFS and VFAT
+bool has_dos_attributes(const uint16_t made_by)
+{
+	const auto host = made_by >> 8;
+	return host == 0 || host == 6 || host == 10 || host == 14;
+}
+
+constexpr uint8_t DosAttributeDirectory = 0x10;
+
+bool read_at(FILE* file, const uint64_t offset, uint8_t* data, const size_t num_bytes)
+{
+	return cross_fseeko(file, static_cast<cross_off_t>(offset), SEEK_SET) == 0 &&
+	       fread(data, 1, num_bytes, file) == num_bytes;
+}
+
+std::string parent_of(const std::string& path)
+{
+	const auto separator = path.rfind('/');
+	return separator == std::string::npos ? std::string() : path.substr(0, separator);
+}
+
+} // namespace
+
+std::unique_ptr<ZipArchive> ZipArchive::Open(const std::string& path,
+                                             std::string& error)
+{
+	error = {};
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) {
+		return nullptr;
+	}
+	return Open(file, error);
+}
+
+std::unique_ptr<ZipArchive> ZipArchive::Open(FILE* file, std::string& error)
+{
+	error = {};
+	std::unique_ptr<ZipArchive> archive(new ZipArchive(file));
+	if (!archive->ReadCentralDirectory(error)) {
+		return nullptr;
+	}
+	archive->BuildIndex();
+	return archive;
+}
+
+ZipArchive::ZipArchive(FILE* f) : file(f, fclose)
+{
+	if (cross_fseeko(f, 0, SEEK_END) == 0) {
+		const auto end = cross_ftello(f);
+		file_size      = end > 0 ? static_cast<uint64_t>(end) : 0;
+	}
+}
+
+bool ZipArchive::ReadCentralDirectory(std::string& error)
+{
+	// Search the end of the file backwards for the end of the central
+	// directory record
+	if (file_size < EndOfCentralDirSize) {
+		return false;
+	}
+	const auto tail_size = static_cast<size_t>(
+	        std::min<uint64_t>(file_size, EndOfCentralDirSize + MaxCommentSize));
+	const auto tail_offset = file_size - tail_size;
+
+	std::vector<uint8_t> tail(tail_size);
+	if (!read_at(file.get(), tail_offset, tail.data(), tail.size())) {
+		return false;
+	}
+	size_t eocd = tail_size - EndOfCentralDirSize + 1;
+	do {
+		--eocd;
+		if (host_readd(&tail[eocd]) == EndOfCentralDirSignature &&
+		    eocd + EndOfCentralDirSize + host_readw(&tail[eocd + 20]) <= tail_size) {
+			break;
+		}
+	} while (eocd > 0);
+	if (host_readd(&tail[eocd]) != EndOfCentralDirSignature) {
+		return false;
+	}
+
+	uint64_t num_entries = host_readw(&tail[eocd + 10]);
+	uint64_t dir_size    = host_readd(&tail[eocd + 12]);
+	uint64_t dir_offset  = host_readd(&tail[eocd + 16]);
+
+	// ZIP64 archives keep the real values in a record of their own, found
+	// through a locator right before the end of the central directory
+	const auto eocd_offset = tail_offset + eocd;
+	if (eocd_offset >= Zip64EndLocatorSize) {
+		uint8_t locator[Zip64EndLocatorSize] = {};
+		if (read_at(file.get(), eocd_offset - Zip64EndLocatorSize, locator, sizeof(locator)) &&
+		    host_readd(locator) == Zip64EndLocatorSignature) {
+			uint8_t record[Zip64EndOfCentralDirSize] = {};
+			if (!read_at(file.get(), host_readq(locator + 8), record, sizeof(record)) ||
+			    host_readd(record) != Zip64EndOfCentralDirSignature) {
+				error = "the ZIP archive's central directory is damaged";
+				return false;
+			}
+			num_entries = host_readq(record + 32);
+			dir_size    = host_readq(record + 40);
+			dir_offset  = host_readq(record + 48);
+		}
+	}
+
+	// Dividing can't overflow, unlike multiplying the untrusted ZIP64
+	// entry count
+	if (dir_offset > file_size || dir_size > file_size - dir_offset ||
+	    num_entries > dir_size / CentralDirEntrySize) {
+		error = "the ZIP archive's central directory is damaged";
+		return false;
+	}
+	if (host_readw(&tail[eocd + 4]) != 0 || host_readw(&tail[eocd + 6]) != 0) {
+		error = "ZIP archives split into several files aren't supported";
+		return false;
+	}
+
+	std::vector<uint8_t> dir(static_cast<size_t>(dir_size));
+	if (!read_at(file.get(), dir_offset, dir.data(), dir.size())) {
+		error = "the ZIP archive's central directory can't be read";
+		return false;
+	}
+
+	entries.reserve(static_cast<size_t>(num_entries));
+	size_t pos = 0;
+	for (uint64_t i = 0; i < num_entries; ++i) {
+		if (pos + CentralDirEntrySize > dir.size() ||
+		    host_readd(&dir[pos]) != CentralDirEntrySignature) {
+			error = "the ZIP archive's central directory is damaged";
+			return false;
+		}
+		const auto p = &dir[pos];
+
+		const auto name_bytes    = host_readw(p + 28);
+		const auto extra_bytes   = host_readw(p + 30);
+		const auto comment_bytes = host_readw(p + 32);
+		if (pos + CentralDirEntrySize + name_bytes + extra_bytes +
+		            comment_bytes > dir.size()) {
+			error = "the ZIP archive's central directory is damaged";
+			return false;
+		}
+
+		Entry entry = {};
+		entry.is_encrypted    = (host_readw(p + 8) & FlagEncrypted) != 0;
+		entry.method          = host_readw(p + 10);
+		entry.dos_time        = host_readw(p + 12);
+		entry.dos_date        = host_readw(p + 14);
+		entry.compressed_size = host_readd(p + 20);
+		entry.size            = host_readd(p + 24);
+		entry.header_offset   = host_readd(p + 42);
+		if (has_dos_attributes(host_readw(p + 4))) {
+			entry.dos_attributes = static_cast<uint8_t>(host_readd(p + 38));
+		}
+
+		std::string name(reinterpret_cast<const char*>(p + CentralDirEntrySize),
+		                 name_bytes);
+		std::replace(name.begin(), name.end(), '\\', '/');
+		entry.is_directory = (!name.empty() && name.back() == '/') ||
+		                     (entry.dos_attributes & DosAttributeDirectory);
+
+		// The ZIP64 extra field holds the values that didn't fit, in
+		// this order
+		auto extra = p + CentralDirEntrySize + name_bytes;
+		const auto extra_end = extra + extra_bytes;
+		while (extra + 4 <= extra_end) {
+			const auto id    = host_readw(extra);
+			const auto bytes = host_readw(extra + 2);
+			auto field       = extra + 4;
+			extra += 4 + bytes;
+			if (id != Zip64ExtraFieldId || extra > extra_end) {
+				continue;
+			}
+			auto take = [&](uint64_t& value) {
+				if (value == UINT32_MAX && field + 8 <= extra) {
+					value = host_readq(field);
+					field += 8;
+				}
+			};
+			take(entry.size);
+			take(entry.compressed_size);
+			take(entry.header_offset);
+		}
+
+		// Drop the leading and trailing separators, and skip the names
+		// that could escape the archive's root
+		const auto first = name.find_first_not_of('/');
+		const auto last  = name.find_last_not_of('/');
+		pos += CentralDirEntrySize + name_bytes + extra_bytes + comment_bytes;
+		if (first == std::string::npos) {
+			continue;
+		}
+		entry.path = name.substr(first, last - first + 1);
+		if (entry.path == ".." || entry.path.starts_with("../") ||
+		    entry.path.find("/../") != std::string::npos ||
+		    entry.path.ends_with("/..")) {
+			continue;
+		}
+		entry.name = entry.path.substr(entry.path.rfind('/') + 1);
+		entries.push_back(std::move(entry));
+	}
+	return true;
+}
+
+void ZipArchive::BuildIndex()
+{
+	// Add the directories that only the paths of their contents imply
+	std::unordered_map<std::string, bool> known = {};
+	for (const auto& entry : entries) {
+		known.emplace(entry.path, entry.is_directory);
+	}
+	const auto num_listed = entries.size();
+	for (size_t i = 0; i < num_listed; ++i) {
+		for (auto dir = parent_of(entries[i].path); !dir.empty();
+		     dir = parent_of(dir)) {
+			if (!known.emplace(dir, true).second) {
+				break;
+			}
+			Entry entry        = {};
+			entry.path         = dir;
+			entry.name         = dir.substr(dir.rfind('/') + 1);
+			entry.is_directory = true;
+			entry.dos_time     = entries[i].dos_time;
+			entry.dos_date     = entries[i].dos_date;
+			entries.push_back(std::move(entry));
+		}
+	}
+
+	// The first of any duplicate entries wins
+	dirs[""] = {};
+	for (const auto& entry : entries) {
+		if (index.emplace(entry.path, &entry).second && entry.is_directory) {
+			dirs.try_emplace(entry.path);
+		}
+	}
+	// List the entries in the archive's order, leaving out the ones whose
+	// parent is a file
+	for (const auto& entry : entries) {
+		const auto dir = dirs.find(parent_of(entry.path));
+		if (index[entry.path] == &entry && dir != dirs.end()) {
+			dir->second.push_back(&entry);
+		}
+	}
+}
+
+const ZipArchive::Entry* ZipArchive::Find(const std::string& path) const
+{
+	const auto it = index.find(path);
+	return it == index.end() ? nullptr : it->second;
+}
+
+const std::vector<const ZipArchive::Entry*>* ZipArchive::ListDir(const std::string& path) const
+{
+	const auto it = dirs.find(path);
+	return it == dirs.end() ? nullptr : &it->second;
+}
+
+std::unique_ptr<ZipEntryReader> ZipArchive::OpenEntry(const Entry& entry) const
+{
+	if (entry.is_directory || entry.is_encrypted ||
+	    (entry.method != MethodStored && entry.method != MethodDeflated)) {
+		return nullptr;
+	}
+
+	// The data follows the local header, whose variable parts can differ
+	// from the central directory's
+	uint8_t header[LocalHeaderSize] = {};
+	if (!read_at(file.get(), entry.header_offset, header, sizeof(header)) ||
+	    host_readd(header) != LocalHeaderSignature) {
+		return nullptr;
+	}
+	const auto data_offset = entry.header_offset + LocalHeaderSize +
+	                         host_readw(header + 26) + host_readw(header + 28);
+	if (data_offset > file_size || entry.compressed_size > file_size - data_offset) {
+		return nullptr;
+	}
+	return std::make_unique<ZipEntryReader>(file, data_offset, entry);
+}
+
+struct ZipEntryReader::Inflater {
+	z_stream stream          = {};
+	uint64_t read_in         = 0;
+	uint8_t input[16 * 1024] = {};
+	bool is_ready            = false;
+	bool is_finished         = false;
+
+	Inflater()
+	{
+		is_ready = inflateInit2(&stream, -MAX_WBITS) == Z_OK;
+	}
+	~Inflater()
+	{
+		if (is_ready) {
+			inflateEnd(&stream);
+		}
+	}
+	Inflater(const Inflater&)            = delete;
+	Inflater& operator=(const Inflater&) = delete;
+};
+
+ZipEntryReader::ZipEntryReader(std::shared_ptr<FILE> f, const uint64_t offset,
+                               const ZipArchive::Entry& entry)
+        : file(std::move(f)),
+          data_offset(offset),
+          compressed_size(entry.compressed_size),
+          size(entry.size),
+          is_deflated(entry.method == MethodDeflated)
+{}
+
+ZipEntryReader::~ZipEntryReader() = default;
+
+bool ZipEntryReader::ReadRaw(const uint64_t offset, uint8_t* data, const size_t num_bytes)
+{
+	// The readers of an archive share its file
+	return read_at(file.get(), data_offset + offset, data, num_bytes);
+}
+
+bool ZipEntryReader::RestartInflating()
+{
+	inflater   = std::make_unique<Inflater>();
+	next_block = 0;
+	return inflater->is_ready;
+}
+
+bool ZipEntryReader::InflateNextBlock()
+{
+	const auto block_offset = next_block * BlockSize;
+	const auto block_size   = std::min<uint64_t>(BlockSize, size - block_offset);
+
+	Block block = {next_block, std::vector<uint8_t>(static_cast<size_t>(block_size))};
+
+	auto& stream     = inflater->stream;
+	stream.next_out  = block.data.data();
+	stream.avail_out = static_cast<uInt>(block.data.size());
+	while (stream.avail_out > 0) {
+		if (inflater->is_finished) {
+			return false;
+		}
+		if (stream.avail_in == 0) {
+			const auto bytes = static_cast<size_t>(
+			        std::min<uint64_t>(sizeof(inflater->input),
+			                           compressed_size - inflater->read_in));
+			if (bytes == 0 || !ReadRaw(inflater->read_in, inflater->input, bytes)) {
+				return false;
+			}
+			inflater->read_in += bytes;
+			stream.next_in  = inflater->input;
+			stream.avail_in = static_cast<uInt>(bytes);
+		}
+		const auto result = inflate(&stream, Z_NO_FLUSH);
+		if (result == Z_STREAM_END) {
+			inflater->is_finished = true;
+		} else if (result != Z_OK) {
+			return false;
+		}
+	}
+
+	if (cached_blocks.size() >= MaxCachedBlocks) {
+		cache_index.erase(cached_blocks.back().number);
+		cached_blocks.pop_back();
+	}
+	cached_blocks.push_front(std::move(block));
+	cache_index[next_block] = cached_blocks.begin();
+	++next_block;
+	return true;
+}
+
+const std::vector<uint8_t>* ZipEntryReader::GetBlock(const uint64_t number)
+{
+	if (const auto it = cache_index.find(number); it != cache_index.end()) {
+		cached_blocks.splice(cached_blocks.begin(), cached_blocks, it->second);
+		return &it->second->data;
+	}
+
+	// Deflated data can only be decompressed forwards, so the blocks
+	// before the stream's position have to be decompressed again
+	if ((!inflater || number < next_block) && !RestartInflating()) {
+		inflater.reset();
+		return nullptr;
+	}
+	while (next_block <= number) {
+		if (!InflateNextBlock()) {
+			inflater.reset();
+			return nullptr;
+		}
+	}
+	return &cached_blocks.front().data;
+}
+
+bool ZipEntryReader::Read(const uint64_t offset, uint8_t* data,
+                          const size_t num_bytes, size_t& num_read)
+{
+	num_read = 0;
+	if (offset >= size) {
+		return true;
+	}
+	const auto bytes = static_cast<size_t>(std::min<uint64_t>(num_bytes, size - offset));
+
+	if (!is_deflated) {
+		if (!ReadRaw(offset, data, bytes)) {
+			return false;
+		}
+		num_read = bytes;
+		return true;
+	}
+
+	while (num_read < bytes) {
+		const auto position = offset + num_read;
+		const auto block    = GetBlock(position / BlockSize);
+		if (!block) {
+			return false;
+		}
+		const auto block_offset = static_cast<size_t>(position % BlockSize);
+		const auto chunk = std::min(bytes - num_read, block->size() - block_offset);
+		std::memcpy(data + num_read, block->data() + block_offset, chunk);
+		num_read += chunk;
+	}
+	return true;
+}
@@ -33,11 +33,13 @@
 #include "callback.h"
 #include "capture/capture.h"
 #include "control.h"
+#include "cpu_budget.h"
 #include "cpu.h"
 #include "cross.h"
 #include "debug.h"
 #include "dos/dos_locale.h"
 #include "dos_inc.h"
+#include "guest_stats.h"
 #include "hardware.h"
 #include "inout.h"
 #include "ints/int10.h"
@@ -53,12 +55,15 @@
 #include "programs.h"
 #include "reelmagic.h"
 #include "render.h"
+#include "replay.h"
+#include "savestate.h"
 #include "setup.h"
 #include "shell.h"
 #include "support.h"
 #include "timer.h"
 #include "tracy.h"
 #include "video.h"
+#include "worker_pool.h"
 
 bool shutdown_requested = false;
 MachineType machine;
@@ -151,8 +156,22 @@ void DOSBOX_SetTicksScheduled(const int64_t ticks_scheduled)
 	ticks.scheduled = ticks_scheduled;
 }
 
+int64_t DOSBOX_GetTicksRemaining()
+{
+	return ticks.remain;
+}
+
+void DOSBOX_ShiftTicks(const int64_t num_ticks)
+{
+	ticks.last += num_ticks;
+}
+
 bool mono_cga = false;
 
+// Emulated time after which DOSBox quits, in ticks (milliseconds), see the
+// --time-limit option
+static uint32_t guest_time_limit_ticks = 0;
+
 void Null_Init([[maybe_unused]] Section *sec) {
 	// do nothing
 }
@@ -160,13 +179,67 @@ void Null_Init([[maybe_unused]] Section *sec) {
 // forward declaration
 static void increase_ticks();
 
+// Polls the host's events at a fixed host-time cadence instead of after every
+// emulated tick. When fast-forwarding or catching up on several ticks at once,
+// this saves polling SDL (and the syscalls that come with it) hundreds of
+// times per host millisecond.
+static bool poll_host_events()
+{
+	constexpr int64_t PollIntervalUs = 1000;
+
+	static int64_t last_poll_us = 0;
+
+	const auto now_us = GetTicksUs();
+	if (now_us - last_poll_us < PollIntervalUs) {
+		return true;
+	}
+	last_poll_us = now_us;
+
+	return GFX_Events();
+}
+
+// The core the cycles of a run of the decoder are counted for
+static StatsCore get_stats_core(const CPU_Decoder* decoder)
+{
+	if (decoder == &CPU_Core_Normal_Run || decoder == &CPU_Core_Normal_Trap_Run) {
+		return StatsCore::Normal;
+	}
+	if (decoder == &CPU_Core_Simple_Run || decoder == &CPU_Core_Simple_Trap_Run) {
+		return StatsCore::Simple;
+	}
+	if (decoder == &CPU_Core_Full_Run) {
+		return StatsCore::Full;
+	}
+#if C_DYNAMIC_X86
+	if (decoder == &CPU_Core_Dyn_X86_Run || decoder == &CPU_Core_Dyn_X86_Trap_Run) {
+		return StatsCore::Dynamic;
+	}
+#elif C_DYNREC
+	if (decoder == &CPU_Core_Dynrec_Run || decoder == &CPU_Core_Dynrec_Trap_Run) {
+		return StatsCore::Dynamic;
+	}
+#endif
+	return StatsCore::Other;
+}
+
 static Bitu Normal_Loop()
 {
+	ZoneScoped;
 	Bits ret;
 
 	while (true) {
 		if (PIC_RunQueue()) {
-			ret = (*cpudecoder)();
+			const auto decoder      = cpudecoder;
+			const auto cycles_begin = CPU_Cycles + CPU_CycleLeft;
+
+			ret = (*decoder)();
+
+			if (const auto executed = cycles_begin -
+			                          (CPU_Cycles + CPU_CycleLeft);
+			    executed > 0) {
+				const auto core = get_stats_core(decoder);
+				guest_stats.cycles[static_cast<size_t>(core)] += executed;
+			}
 			if (ret < 0) {
 				return 1;
 			}
@@ -185,14 +258,24 @@ static Bitu Normal_Loop()
 			}
 #endif
 		} else {
-			if (!GFX_Events()) {
+			if (!poll_host_events()) {
 				return 0;
 			}
 			if (ticks.remain > 0) {
 				TIMER_AddTick();
 				--ticks.remain;
+
+				if (guest_time_limit_ticks &&
+				    PIC_Ticks >= guest_time_limit_ticks) {
+					LOG_MSG("DOSBOX: Reached the time limit of %u seconds, exiting",
+					        guest_time_limit_ticks / 1000);
+					GFX_RequestExit(true);
+					return 0;
+				}
 			} else {
 				increase_ticks();
+				TracyPlot("CPU cycles per tick",
+				          static_cast<int64_t>(CPU_CycleMax));
 				return 0;
 			}
 		}
@@ -294,7 +377,9 @@ static void increase_ticks()
 		}
 
 		// Ratio we are aiming for is 100% usage
-		auto ratio = (ticks.scheduled * (CPU_CyclePercUsed * 1024 / 100)) /
+		const auto percent_used = CPU_BUDGET_GetShare(CPU_CyclePercUsed);
+
+		auto ratio = (ticks.scheduled * (percent_used * 1024 / 100)) /
 		             ticks.done;
 
 		auto new_cycle_max = CPU_CycleMax;
@@ -520,6 +605,46 @@ void DOSBOX_SetMachineTypeFromConfig(Section_prop* section)
 	       (machine != MCH_VGA && svgaCard == SVGA_None));
 }
 
+static std_fs::path savestate_file = {};
+
+static void save_state(const bool pressed)
+{
+	if (pressed && !savestate_file.empty()) {
+		SAVESTATE_Save(savestate_file);
+	}
+}
+
+#if C_DEBUG
+// Only the memory and the CPU registers are registered so far, while the
+// rest of the CPU (control registers, paging, descriptor caches) and the
+// devices keep running on their current state, so loading and rewinding
+// are limited to debug builds until all of them are
+static void load_state(const bool pressed)
+{
+	if (pressed && !savestate_file.empty()) {
+		SAVESTATE_Load(savestate_file);
+	}
+}
+
+static int rewind_interval_ms = 0;
+
+static void capture_rewind_point()
+{
+	static int ms_until_capture = 0;
+	if (--ms_until_capture <= 0) {
+		ms_until_capture = rewind_interval_ms;
+		SAVESTATE_CaptureRewindPoint();
+	}
+}
+
+static void rewind_state(const bool pressed)
+{
+	if (pressed && !SAVESTATE_Rewind()) {
+		LOG_MSG("SAVESTATE: Couldn't rewind to an earlier state");
+	}
+}
+#endif
+
 static void DOSBOX_RealInit(Section* sec)
 {
 	Section_prop* section = static_cast<Section_prop*>(sec);
@@ -533,6 +658,31 @@ static void DOSBOX_RealInit(Section* sec)
 
 	MAPPER_AddHandler(DOSBOX_UnlockSpeed, SDL_SCANCODE_F12, MMOD2, "speedlock", "Speedlock");
 
+	// Headless runs have nobody watching, so run as fast as possible
+	const auto arguments = &control->arguments;
+	if (arguments->headless) {
+		DOSBOX_UnlockSpeed(true);
+	}
+
+	constexpr int64_t TicksPerSecond = 1000;
+	guest_time_limit_ticks = arguments->time_limit && *arguments->time_limit > 0
+	                               ? check_cast<uint32_t>(*arguments->time_limit *
+	                                                      TicksPerSecond)
+	                               : 0;
+
+	savestate_file = section->Get_path("savestate_file")->realpath;
+	MAPPER_AddHandler(save_state, SDL_SCANCODE_UNKNOWN, 0, "savestate", "Save State");
+#if C_DEBUG
+	MAPPER_AddHandler(load_state, SDL_SCANCODE_UNKNOWN, 0, "loadstate", "Load State");
+
+	rewind_interval_ms = section->Get_int("rewind_interval");
+	if (rewind_interval_ms > 0) {
+		SAVESTATE_SetRewindDepth(check_cast<size_t>(section->Get_int("rewind_depth")));
+		TIMER_AddTickHandler(capture_rewind_point);
+		MAPPER_AddHandler(rewind_state, SDL_SCANCODE_UNKNOWN, 0, "rewind", "Rewind");
+	}
+#endif
+
 	DOSBOX_SetMachineTypeFromConfig(section);
 
 	// Set the user's prefered MCB fault handling strategy
@@ -658,6 +808,45 @@ void DOSBOX_Init()
 	        "though a few games might require a higher value.\n"
 	        "There is generally no speed advantage when raising this value.");
 
+	pstring = secprop->Add_string("memory_backing", only_at_start, "heap");
+	pstring->Set_values({"heap", "hugepages", "file"});
+	pstring->Set_help(
+	        "How the memory of the emulated machine is allocated on the host ('heap' by\n"
+	        "default):\n"
+	        "  heap:       Regular memory allocation.\n"
+	        "  hugepages:  Use transparent huge pages, which lowers the overhead of the\n"
+	        "              host's page walks with large 'memsize' values (Linux only).\n"
+	        "  file:       Map 'memory_file' copy-on-write as the initial memory contents.\n"
+	        "              Instances using the same file share its unmodified pages;\n"
+	        "              changes are never written back to the file.");
+
+	pstring = secprop->Add_path("memory_file", only_at_start, "");
+	pstring->Set_help(
+	        "Memory image used with 'memory_backing = file' (empty by default).\n"
+	        "Memory beyond the end of the file starts out zeroed.");
+
+	pstring = secprop->Add_path("savestate_file", only_at_start, "savestate.bin");
+	pstring->Set_help(
+	        "File the 'Save State' and 'Load State' mapper events write to and read from\n"
+	        "('savestate.bin' by default). The state is written in the background, the\n"
+	        "emulation keeps running while it's being saved (not on Windows).\n"
+	        "Note: Only the memory and the CPU registers are saved at the moment, so the\n"
+	        "      'Load State' event is only available in debug builds.");
+
+	pint = secprop->Add_int("rewind_interval", only_at_start, 0);
+	pint->SetMinMax(0, 60000);
+	pint->Set_help(
+	        "Keep a snapshot of the state every this many milliseconds, to step back\n"
+	        "through them with the 'Rewind' mapper event (0 by default, disabled).\n"
+	        "Only the memory pages changed since the previous snapshot are kept, but every\n"
+	        "snapshot compares all the memory, so intervals below 100 ms slow down the\n"
+	        "emulation. The same limits as for save states apply, so rewinding is only\n"
+	        "available in debug builds.");
+
+	pint = secprop->Add_int("rewind_depth", only_at_start, 60);
+	pint->SetMinMax(1, 10000);
+	pint->Set_help("Number of snapshots kept for rewinding (60 by default).");
+
 	pstring = secprop->Add_string("mcb_fault_strategy", only_at_start, "repair");
 	pstring->Set_help(
 	        "How software-corrupted memory chain blocks should be handled:\n"
@@ -741,6 +930,19 @@ void DOSBOX_Init()
 	        "Currently, you need to disable this for a few games, otherwise they will crash\n"
 	        "at startup (e.g., Deus, Ishar 3, Robinson's Requiem, Time Warriors).");
 
+	pint = secprop->Add_int("stats_log_interval", only_at_start, 0);
+	pint->SetMinMax(0, 3600);
+	pint->Set_help(
+	        "Log the guest performance counters every this many seconds of emulated time\n"
+	        "(0 by default, disabled). The counters can also be shown with the STATS command.");
+
+	pstring = secprop->Add_string("worker_threads", only_at_start, "auto");
+	pstring->Set_help(
+	        "Number of worker threads shared by the subsystems that render in parallel,\n"
+	        "such as the Voodoo rasteriser and the mixer with 'parallel_rendering' enabled\n"
+	        "('auto' by default). 'auto' starts one per host CPU core, less one for the\n"
+	        "emulation thread.");
+
 	pbool = secprop->Add_bool("speed_mods", only_at_start, true);
 	pbool->Set_help(
 	        "Permit changes known to improve performance (enabled by default).\n"
@@ -750,6 +952,9 @@ void DOSBOX_Init()
 
 	secprop->AddInitFunction(&CALLBACK_Init);
 	secprop->AddInitFunction(&PIC_Init);
+	secprop->AddInitFunction(&STATS_Init);
+	secprop->AddInitFunction(&REPLAY_Init);
+	secprop->AddInitFunction(&WORKERS_Init);
 	secprop->AddInitFunction(&PROGRAMS_Init);
 	secprop->AddInitFunction(&TIMER_Init);
 	secprop->AddInitFunction(&CMOS_Init);
@@ -833,7 +1038,10 @@ void DOSBOX_Init()
 	        "  12: 4 MB for the FBI and two TMUs, each with 4 MB.");
 
 	pbool = secprop->Add_bool("voodoo_multithreading", only_at_start, true);
-	pbool->Set_help("Use threads to improve 3dfx Voodoo performance (enabled by default).");
+	pbool->Set_help(
+	        "Use threads to improve 3dfx Voodoo performance (enabled by default).\n"
+	        "The card's commands are processed on their own thread while the emulation\n"
+	        "carries on, and the triangles are drawn on the worker threads.");
 
 	pbool = secprop->Add_bool("voodoo_bilinear_filtering", only_at_start, false);
 	pbool->Set_help(
@@ -1112,8 +1320,9 @@ void DOSBOX_Init()
 	        "  - for 'direct':     realport (required), rxdelay (optional).\n"
 	        "                      (e.g., realport:COM1, realport:ttyS0).\n"
 	        "  - for 'modem':      listenport, sock, bps (all optional).\n"
-	        "  - for 'nullmodem':  server, rxdelay, txdelay, telnet, usedtr,\n"
-	        "                      transparent, port, inhsocket, sock (all optional).\n"
+	        "  - for 'nullmodem':  server, rxdelay, txdelay, txsize, nodelay, telnet,\n"
+	        "                      usedtr, transparent, port, inhsocket, sock\n"
+	        "                      (all optional).\n"
 	        "The 'sock' parameter specifies the protocol to use at both sides of the\n"
 	        "connection. Valid values are 0 for TCP, and 1 for ENet reliable UDP.\n"
 	        "Example: serial1=modem listenport:5000 sock:1");
@@ -1178,6 +1387,33 @@ void DOSBOX_Init()
 	        "A single number is treated as the major version.\n"
 	        "Common settings are 3.3, 5.0, 6.22, and 7.1.");
 
+	pint = secprop->Add_int("fat_sector_cache", when_idle, 512);
+	pint->SetMinMax(0, 65536);
+	pint->Set_help(
+	        "Number of sectors of mounted FAT disk images to cache in memory (512 by\n"
+	        "default). Writes are held in the cache and written back to the image when\n"
+	        "files are closed, on disk resets, and on unmounting. 0 disables the cache.");
+
+	pint = secprop->Add_int("cdrom_sector_cache", when_idle, 1024);
+	pint->SetMinMax(0, 65536);
+	pint->Set_help(
+	        "Number of data sectors of mounted CD-ROM images and physical CD-ROM drives to\n"
+	        "cache in memory (1024 by default). Sequential reads also read ahead of the\n"
+	        "requested sectors, on a background thread for physical drives on Linux.\n"
+	        "0 disables the cache.");
+
+	pbool = secprop->Add_bool("mount_prefetch", when_idle, false);
+	pbool->Set_help(
+	        "List the directory trees of mounted host directories in the background\n"
+	        "(disabled by default). Speeds up the first access to directories on slow\n"
+	        "storage such as network shares.");
+
+	pbool = secprop->Add_bool("batch_file_cache", when_idle, false);
+	pbool->Set_help(
+	        "Keep the contents of running batch files in memory (disabled by default).\n"
+	        "Batch files are then only read again when their size or timestamp changes,\n"
+	        "which speeds up long batch files that jump around with GOTO.");
+
 	// DOS locale settings
 
 	secprop->AddInitFunction(&DOS_Locale_Init, changeable_at_runtime);
@@ -1267,6 +1503,27 @@ void DOSBOX_Init()
 	pbool->SetEnabledOptions({"SLIRP"});
 #endif
 
+	pstring = secprop->Add_string("nic_backend", when_idle, "slirp");
+	pstring->Set_values({"slirp", "tap"});
+	pstring->SetOptionHelp(
+	        "SLIRP",
+	        "The host network the NE2000 card is connected to ('slirp' by default):\n"
+	        "  slirp:  The software-based network described above.\n"
+	        "  tap:    A TAP device on the host set with 'tap_device' (Linux and BSD\n"
+	        "          only). Frames are passed to the host's network stack as they are,\n"
+	        "          allowing much faster LAN transfers; the device has to be created\n"
+	        "          and bridged or routed on the host beforehand.");
+#if C_SLIRP
+	pstring->SetEnabledOptions({"SLIRP"});
+#endif
+
+	pstring = secprop->Add_string("tap_device", when_idle, "tap0");
+	pstring->SetOptionHelp("SLIRP",
+	                       "The TAP device used by the 'tap' NIC backend ('tap0' by default).");
+#if C_SLIRP
+	pstring->SetEnabledOptions({"SLIRP"});
+#endif
+
 	phex = secprop->Add_hex("nicbase", when_idle, 0x300);
 	phex->Set_values(
 	        {"200", "220", "240", "260", "280", "2c0", "300", "320", "340", "360"});
@@ -1295,6 +1552,17 @@ void DOSBOX_Init()
 	pstring->SetEnabledOptions({"SLIRP"});
 #endif
 
+	pint = secprop->Add_int("nic_rx_coalescing", when_idle, 0);
+	pint->SetMinMax(0, 10000);
+	pint->SetOptionHelp("SLIRP",
+	                    "Raise one receive interrupt for all the frames arriving within this many\n"
+	                    "microseconds (0 by default, one interrupt per frame). A few hundred\n"
+	                    "microseconds can speed up bulk transfers with drivers that empty the\n"
+	                    "whole receive ring in their interrupt handler.");
+#if C_SLIRP
+	pint->SetEnabledOptions({"SLIRP"});
+#endif
+
 	pstring = secprop->Add_string("tcp_port_forwards", when_idle, "");
 	pstring->SetOptionHelp(
 	        "SLIRP",
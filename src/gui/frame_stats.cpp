@@ -0,0 +1,199 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <fstream>
+
+#include "checks.h"
+#include "logging.h"
+#include "mixer.h"
+
+CHECK_NARROWING();
+
+// The stages, in the order of the log and the CSV columns
+enum Column { Emulation, Render, Upload, Present, NumColumns };
+
+constexpr const char* ColumnNames[NumColumns] = {"emulation",
+                                                 "render",
+                                                 "upload",
+                                                 "present"};
+
+constexpr int64_t SummaryPeriodUs = 1'000'000;
+
+static struct {
+	bool is_enabled   = false;
+	std::ofstream csv = {};
+
+	// The current frame
+	std::array<int64_t, NumColumns> frame_us = {};
+	int64_t frame_start_us                   = 0;
+	int64_t frame_number                     = 0;
+
+	// The frames since the last summary
+	int64_t summary_start_us                         = 0;
+	int num_summary_frames                           = 0;
+	std::array<int64_t, NumColumns> summary_total_us = {};
+	std::array<int64_t, NumColumns> summary_max_us   = {};
+	int min_audio_ms                                 = 0;
+	int max_audio_ms                                 = 0;
+} stats = {};
+
+static Column to_column(const FrameStage stage)
+{
+	switch (stage) {
+	case FrameStage::Render: return Render;
+	case FrameStage::Upload: return Upload;
+	case FrameStage::Present: return Present;
+	}
+	assert(false);
+	return Emulation;
+}
+
+static void reset_summary(const int64_t now_us)
+{
+	stats.summary_start_us   = now_us;
+	stats.num_summary_frames = 0;
+	stats.summary_total_us   = {};
+	stats.summary_max_us     = {};
+}
+
+void FRAMESTATS_Init(const std::string& setting)
+{
+	stats.csv.close();
+	stats.frame_us       = {};
+	stats.frame_start_us = 0;
+	stats.frame_number   = 0;
+	reset_summary(0);
+
+	stats.is_enabled = (setting != "off");
+	if (!stats.is_enabled || setting == "log") {
+		return;
+	}
+
+	stats.csv.open(setting, std::ios::trunc);
+	if (!stats.csv) {
+		LOG_WARNING("FRAMESTATS: Can't write to '%s', only logging the frame statistics",
+		            setting.c_str());
+		return;
+	}
+	stats.csv << "frame,time_ms";
+	for (const auto name : ColumnNames) {
+		stats.csv << ',' << name << "_us";
+	}
+	stats.csv << ",audio_buffer_ms\n";
+
+	LOG_MSG("FRAMESTATS: Writing the frame statistics to '%s'", setting.c_str());
+}
+
+bool FRAMESTATS_IsEnabled()
+{
+	return stats.is_enabled;
+}
+
+void FRAMESTATS_AddStageTime(const FrameStage stage, const int64_t elapsed_us)
+{
+	stats.frame_us[to_column(stage)] += elapsed_us;
+}
+
+static void log_summary(const int64_t elapsed_us)
+{
+	const auto num_frames = stats.num_summary_frames;
+
+	auto ms = [](const int64_t us) { return static_cast<double>(us) / 1000; };
+	auto average_ms = [&](const Column column) {
+		return ms(stats.summary_total_us[column]) / num_frames;
+	};
+
+	LOG_MSG("FRAMESTATS: %.1f fps, average (max) ms: emulation %.2f (%.2f), "
+	        "render %.2f (%.2f), upload %.2f (%.2f), present %.2f (%.2f); "
+	        "audio buffer %d to %d ms",
+	        num_frames * 1'000'000.0 / static_cast<double>(elapsed_us),
+	        average_ms(Emulation),
+	        ms(stats.summary_max_us[Emulation]),
+	        average_ms(Render),
+	        ms(stats.summary_max_us[Render]),
+	        average_ms(Upload),
+	        ms(stats.summary_max_us[Upload]),
+	        average_ms(Present),
+	        ms(stats.summary_max_us[Present]),
+	        stats.min_audio_ms,
+	        stats.max_audio_ms);
+}
+
+void FRAMESTATS_EndFrame()
+{
+	if (!stats.is_enabled) {
+		return;
+	}
+	const auto now_us = GetTicksUs();
+
+	// The first frame only starts the measurements
+	if (stats.frame_start_us == 0) {
+		stats.frame_us       = {};
+		stats.frame_start_us = now_us;
+		reset_summary(now_us);
+		return;
+	}
+
+	auto& frame_us = stats.frame_us;
+
+	const auto pipeline_us = frame_us[Render] + frame_us[Upload] +
+	                         frame_us[Present];
+	frame_us[Emulation] = std::max(GetTicksDiff(now_us, stats.frame_start_us) -
+	                                       pipeline_us,
+	                               static_cast<int64_t>(0));
+
+	const auto audio_ms = MIXER_GetBufferedMs();
+
+	if (stats.csv) {
+		stats.csv << stats.frame_number << ',' << now_us / 1000;
+		for (const auto us : frame_us) {
+			stats.csv << ',' << us;
+		}
+		stats.csv << ',' << audio_ms << '\n';
+	}
+
+	if (stats.num_summary_frames == 0) {
+		stats.min_audio_ms = audio_ms;
+		stats.max_audio_ms = audio_ms;
+	}
+	++stats.num_summary_frames;
+	for (auto column = 0; column < NumColumns; ++column) {
+		stats.summary_total_us[column] += frame_us[column];
+		stats.summary_max_us[column] = std::max(stats.summary_max_us[column],
+		                                        frame_us[column]);
+	}
+	stats.min_audio_ms = std::min(stats.min_audio_ms, audio_ms);
+	stats.max_audio_ms = std::max(stats.max_audio_ms, audio_ms);
+
+	const auto summary_elapsed_us = GetTicksDiff(now_us, stats.summary_start_us);
+	if (summary_elapsed_us >= SummaryPeriodUs) {
+		log_summary(summary_elapsed_us);
+		reset_summary(now_us);
+	}
+
+	frame_us             = {};
+	stats.frame_start_us = now_us;
+	++stats.frame_number;
+}
@@ -21,11 +21,13 @@
 
 #include "dosbox.h"
 
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
 #include <memory>
 #include <mutex>
+#include <optional>
 
 #include "../capture/capture.h"
 #include "control.h"
@@ -38,9 +40,15 @@
 #include "shell.h"
 #include "string_utils.h"
 #include "support.h"
+#include "tracy.h"
 #include "vga.h"
 #include "video.h"
 
+#define XXH_INLINE_ALL 1
+#define XXH_NO_INLINE_HINTS 1
+#define XXH_STATIC_LINKING_ONLY 1
+#include "../libs/decoders/xxhash.h"
+
 Render_t render;
 ScalerLineHandler_t RENDER_DrawLine;
 
@@ -81,7 +89,20 @@ static void check_palette()
 	}
 	Bitu i;
 	switch (render.scale.outMode) {
-	case scalerMode8: break;
+	case scalerMode8:
+		// The output looks up the colours itself, so the frame doesn't
+		// need to be redrawn; only the output's palette is updated
+		for (i = render.pal.first; i <= render.pal.last; i++) {
+			uint8_t r = render.pal.rgb[i].red;
+			uint8_t g = render.pal.rgb[i].green;
+			uint8_t b = render.pal.rgb[i].blue;
+
+			render.pal.lut.b32[i] = GFX_GetRGB(r, g, b);
+		}
+		GFX_SetPalette(render.pal.lut.b32,
+		               check_cast<uint8_t>(render.pal.first),
+		               check_cast<uint8_t>(render.pal.last));
+		break;
 	case scalerMode15:
 	case scalerMode16:
 		for (i = render.pal.first; i <= render.pal.last; i++) {
@@ -122,6 +143,12 @@ static void check_palette()
 void RENDER_SetPalette(const uint8_t entry, const uint8_t red,
                        const uint8_t green, const uint8_t blue)
 {
+	// Palette-cycling games and fades often write the colours they already
+	// have, which would only widen the range check_palette() goes through
+	auto& colour = render.pal.rgb[entry];
+	if (colour.red == red && colour.green == green && colour.blue == blue) {
+		return;
+	}
 	render.pal.rgb[entry].red   = red;
 	render.pal.rgb[entry].green = green;
 	render.pal.rgb[entry].blue  = blue;
@@ -136,29 +163,73 @@ void RENDER_SetPalette(const uint8_t entry, const uint8_t red,
 
 static void empty_line_handler(const void*) {}
 
+// Hashes of the cached source lines
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Lines with a known hash are checked for changes by hashing the source line
+// alone, instead of comparing it with the cached copy, halving the memory
+// read. The hash is only known for the lines that passed through the start
+// handler; the lines drawn after the scaler took over the rest of the frame
+// are compared with the cache in the next frame, which also hashes them.
+//
+static std::array<std::optional<uint64_t>, SCALER_MAXHEIGHT> cached_line_hashes = {};
+
+static void forget_line_hashes(const size_t first_line)
+{
+	for (auto i = first_line; i < cached_line_hashes.size(); ++i) {
+		cached_line_hashes[i] = {};
+	}
+}
+
+static bool is_line_changed(const uintptr_t* src, const size_t line)
+{
+	const auto num_bytes = render.src_start * sizeof(uintptr_t);
+	const auto hash      = XXH3_64bits(src, num_bytes);
+
+	auto& cached_hash = cached_line_hashes[line];
+	if (cached_hash) {
+		const auto is_changed = (*cached_hash != hash);
+		cached_hash           = hash;
+		return is_changed;
+	}
+	cached_hash = hash;
+
+	auto cache = reinterpret_cast<const uintptr_t*>(render.scale.cacheRead);
+	for (Bits x = render.src_start; x > 0;) {
+		const auto src_ptr = reinterpret_cast<const uint8_t*>(src);
+		const auto src_val = read_unaligned_size_t(src_ptr);
+		if (src_val != cache[0]) {
+			return true;
+		}
+		x--;
+		src++;
+		cache++;
+	}
+	return false;
+}
+
 static void start_line_handler(const void* s)
 {
 	if (s) {
-		auto src = static_cast<const uintptr_t*>(s);
-		auto cache = reinterpret_cast<uintptr_t*>(render.scale.cacheRead);
-		for (Bits x = render.src_start; x > 0;) {
-			const auto src_ptr = reinterpret_cast<const uint8_t*>(src);
-			const auto src_val = read_unaligned_size_t(src_ptr);
-			if (src_val != cache[0]) {
-				if (!GFX_StartUpdate(render.scale.outWrite,
-				                     render.scale.outPitch)) {
-					RENDER_DrawLine = empty_line_handler;
-					return;
-				}
-				render.scale.outWrite += render.scale.outPitch *
-				                         Scaler_ChangedLines[0];
-				RENDER_DrawLine = render.scale.lineHandler;
-				RENDER_DrawLine(s);
+		const auto line = render.scale.inLine;
+		assert(line < cached_line_hashes.size());
+
+		if (is_line_changed(static_cast<const uintptr_t*>(s), line)) {
+			// The scaler draws the rest of the frame without
+			// hashing the lines
+			forget_line_hashes(line + 1);
+
+			if (!GFX_StartUpdate(render.scale.outWrite,
+			                     render.scale.outPitch)) {
+				// Nothing gets cached, not even this line
+				forget_line_hashes(line);
+				RENDER_DrawLine = empty_line_handler;
 				return;
 			}
-			x--;
-			src++;
-			cache++;
+			render.scale.outWrite += render.scale.outPitch *
+			                         Scaler_ChangedLines[0];
+			RENDER_DrawLine = render.scale.lineHandler;
+			RENDER_DrawLine(s);
+			return;
 		}
 	}
 	render.scale.cacheRead += render.scale.cachePitch;
@@ -225,6 +296,7 @@ bool RENDER_StartUpdate()
 		render.fullFrame        = true;
 		render.scale.clearCache = false;
 		RENDER_DrawLine         = clear_cache_handler;
+		forget_line_hashes(0);
 	} else {
 		if (render.pal.changed) {
 			// Assume pal changes always do a full screen update
@@ -235,6 +307,7 @@ bool RENDER_StartUpdate()
 			}
 			RENDER_DrawLine  = render.scale.linePalHandler;
 			render.fullFrame = true;
+			forget_line_hashes(0);
 		} else {
 			RENDER_DrawLine = start_line_handler;
 			if (CAPTURE_IsCapturingImage() ||
@@ -249,6 +322,46 @@ bool RENDER_StartUpdate()
 	return true;
 }
 
+// Frame skipping
+// ~~~~~~~~~~~~~~
+// When the emulation falls behind the host's time, it runs the missed
+// emulated time in a burst. A frame starting with at least a frame period of
+// that backlog left is followed by the next one before the host's time
+// catches up, so it would only be replaced before it could be seen; skipping
+// it leaves the host's time to the emulation. A few frames in a row at most
+// are skipped so the screen keeps updating, and captured frames never are.
+//
+bool RENDER_ShouldSkipFrame(const double frame_period_ms)
+{
+	constexpr auto MaxConsecutiveSkippedFrames = 3;
+
+	static int num_skipped_frames = 0;
+
+	const auto is_behind = static_cast<double>(DOSBOX_GetTicksRemaining()) >=
+	                       frame_period_ms;
+
+	if (!is_behind || num_skipped_frames >= MaxConsecutiveSkippedFrames ||
+	    CAPTURE_IsCapturingImage() || CAPTURE_IsCapturingVideo()) {
+		num_skipped_frames = 0;
+		return false;
+	}
+	++num_skipped_frames;
+	return true;
+}
+
+bool RENDER_CanSkipUnchangedLine()
+{
+	// The clear-cache and palette-change handlers need every line, and
+	// the empty handler isn't caching anything
+	return render.updating && (RENDER_DrawLine == start_line_handler ||
+	                           RENDER_DrawLine == render.scale.lineHandler);
+}
+
+bool RENDER_IsCachingLines()
+{
+	return render.updating && RENDER_DrawLine != empty_line_handler;
+}
+
 static void halt_render()
 {
 	RENDER_DrawLine = empty_line_handler;
@@ -261,6 +374,7 @@ extern uint32_t PIC_Ticks;
 
 void RENDER_EndUpdate(bool abort)
 {
+	ZoneScoped;
 	if (!render.updating) {
 		return;
 	}
@@ -288,6 +402,10 @@ void RENDER_EndUpdate(bool abort)
 		image.image_data           = (uint8_t*)&scalerSourceCache;
 		image.palette_data         = (uint8_t*)&render.pal.rgb;
 
+		// Nothing is drawn to the output if the cached source lines
+		// all stayed the same
+		image.is_unchanged = !render.scale.outWrite && !abort;
+
 		const auto frames_per_second = static_cast<float>(render.fps);
 
 		CAPTURE_AddFrame(image, frames_per_second);
@@ -338,9 +456,9 @@ void RENDER_Reinit()
 	RENDER_Init(get_render_section());
 }
 
-static void render_reset()
+static void render_reset(const bool allow_output_doubling = true)
 {
-	static std::mutex render_reset_mutex;
+	static std::recursive_mutex render_reset_mutex;
 
 	if (render.src.width == 0 || render.src.height == 0) {
 		return;
@@ -349,12 +467,20 @@ static void render_reset()
 	// Despite rendering being a single-threaded sequence, the Reset() can
 	// be called from the rendering callback, which might come from a video
 	// driver operating in a different thread or process.
-	std::lock_guard<std::mutex> guard(render_reset_mutex);
+	std::lock_guard<std::recursive_mutex> guard(render_reset_mutex);
 
 	uint16_t render_width_px = render.src.width;
 	bool double_width        = render.src.double_width;
 	bool double_height       = render.src.double_height;
 
+	// Indexed frames are passed on undoubled if the output looks up their
+	// palette on the GPU, as it doubles them in the same pass
+	const auto is_doubled_by_output = allow_output_doubling &&
+	                                  (double_width || double_height) &&
+	                                  render.src.pixel_format ==
+	                                          PixelFormat::Indexed8 &&
+	                                  GFX_CanLookUpPalette();
+
 	uint8_t gfx_flags, xscale, yscale;
 	ScalerSimpleBlock_t* simpleBlock = &ScaleNormal1x;
 
@@ -364,7 +490,9 @@ static void render_reset()
 		render.scale.size = maxsize_current_input;
 	}
 
-	if (double_height && double_width) {
+	if (is_doubled_by_output) {
+		simpleBlock = &ScaleNormal1x;
+	} else if (double_height && double_width) {
 		simpleBlock = &ScaleNormal2x;
 	} else if (double_width) {
 		simpleBlock = &ScaleNormalDw;
@@ -388,6 +516,10 @@ static void render_reset()
 
 	switch (render.src.pixel_format) {
 	case PixelFormat::Indexed8:
+		// Passed through as-is if the output can look up the palette
+		// (see GFX_GetBestMode)
+		render.src_start = (render.src.width * 2) / src_pixel_bytes;
+		break;
 	case PixelFormat::RGB555_Packed16:
 	case PixelFormat::RGB565_Packed16:
 		render.src_start = (render.src.width * 2) / src_pixel_bytes;
@@ -411,9 +543,13 @@ static void render_reset()
 		}
 	}
 	render_width_px *= xscale;
-	const auto render_height_px = make_aspect_table(render.src.height,
-	                                                yscale,
-	                                                yscale);
+	auto render_height_px = make_aspect_table(render.src.height, yscale, yscale);
+
+	if (is_doubled_by_output) {
+		render_width_px *= (double_width ? 2 : 1);
+		render_height_px *= (double_height ? 2 : 1);
+		gfx_flags |= GFX_DBL_OUTPUT;
+	}
 
 	// Set up scaler variables
 	if (double_height) {
@@ -437,6 +573,13 @@ static void render_reset()
 	                        render.src.video_mode,
 	                        &render_callback);
 
+	if (is_doubled_by_output && !(gfx_flags & GFX_DBL_OUTPUT)) {
+		// The output couldn't set up the palette lookup after all, so
+		// the scalers have to double the frames
+		render_reset(false);
+		return;
+	}
+
 	if (gfx_flags & GFX_CAN_8) {
 		render.scale.outMode = scalerMode8;
 	} else if (gfx_flags & GFX_CAN_15) {
@@ -0,0 +1,324 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "render_line_kernels.h"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define RENDER_KERNELS_NEON 1
+#include <arm_neon.h>
+#else
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RENDER_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RENDER_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+#if RENDER_KERNELS_AVX2
+__attribute__((target("avx2"))) static __m256i bits_avx2(const __m256i v,
+                                                        const int mask)
+{
+	return _mm256_and_si256(v, _mm256_set1_epi32(mask));
+}
+#endif
+
+// The bit replications of the 15 and 16-bit conversions, spelled out for each
+// vector type. The channels' top bits are copied into the low bits, so that
+// full intensity maps to 255.
+struct Rgb555 {
+	// xRRRrrGGGggBBBbb -> RRRrrRRRGGGggGGGBBBbbBBB
+	static uint32_t to_32(const uint32_t v)
+	{
+		return ((v & (31 << 10)) << 9) | ((v & (31 << 5)) << 6) |
+		       ((v & 31) << 3) | ((v & (7 << 12)) << 4) |
+		       ((v & (7 << 7)) << 1) | ((v & (7 << 2)) >> 2);
+	}
+
+#if RENDER_KERNELS_NEON
+	static uint32x4_t to_32(const uint32x4_t v)
+	{
+		auto bits = [v](const uint32_t mask) {
+			return vandq_u32(v, vdupq_n_u32(mask));
+		};
+		const auto high = vorrq_u32(vorrq_u32(vshlq_n_u32(bits(31 << 10), 9),
+		                                      vshlq_n_u32(bits(31 << 5), 6)),
+		                            vshlq_n_u32(bits(31), 3));
+		const auto low = vorrq_u32(vorrq_u32(vshlq_n_u32(bits(7 << 12), 4),
+		                                     vshlq_n_u32(bits(7 << 7), 1)),
+		                           vshrq_n_u32(bits(7 << 2), 2));
+		return vorrq_u32(high, low);
+	}
+#endif
+
+#if RENDER_KERNELS_SSE2
+	static __m128i to_32(const __m128i v)
+	{
+		auto bits = [v](const int mask) {
+			return _mm_and_si128(v, _mm_set1_epi32(mask));
+		};
+		const auto high = _mm_or_si128(
+		        _mm_or_si128(_mm_slli_epi32(bits(31 << 10), 9),
+		                     _mm_slli_epi32(bits(31 << 5), 6)),
+		        _mm_slli_epi32(bits(31), 3));
+		const auto low = _mm_or_si128(
+		        _mm_or_si128(_mm_slli_epi32(bits(7 << 12), 4),
+		                     _mm_slli_epi32(bits(7 << 7), 1)),
+		        _mm_srli_epi32(bits(7 << 2), 2));
+		return _mm_or_si128(high, low);
+	}
+#endif
+
+#if RENDER_KERNELS_AVX2
+	__attribute__((target("avx2"))) static __m256i to_32(const __m256i v)
+	{
+		const auto high = _mm256_or_si256(
+		        _mm256_or_si256(_mm256_slli_epi32(bits_avx2(v, 31 << 10), 9),
+		                        _mm256_slli_epi32(bits_avx2(v, 31 << 5), 6)),
+		        _mm256_slli_epi32(bits_avx2(v, 31), 3));
+		const auto low = _mm256_or_si256(
+		        _mm256_or_si256(_mm256_slli_epi32(bits_avx2(v, 7 << 12), 4),
+		                        _mm256_slli_epi32(bits_avx2(v, 7 << 7), 1)),
+		        _mm256_srli_epi32(bits_avx2(v, 7 << 2), 2));
+		return _mm256_or_si256(high, low);
+	}
+#endif
+};
+
+struct Rgb565 {
+	// RRRrrGGggggBBBbb -> RRRrrRRRGGggggGGBBBbbBBB
+	static uint32_t to_32(const uint32_t v)
+	{
+		return ((v & (31 << 11)) << 8) | ((v & (63 << 5)) << 5) |
+		       ((v & 0xe01f) << 3) | ((v & (3 << 9)) >> 1) |
+		       ((v & (7 << 2)) >> 2);
+	}
+
+#if RENDER_KERNELS_NEON
+	static uint32x4_t to_32(const uint32x4_t v)
+	{
+		auto bits = [v](const uint32_t mask) {
+			return vandq_u32(v, vdupq_n_u32(mask));
+		};
+		const auto high = vorrq_u32(vorrq_u32(vshlq_n_u32(bits(31 << 11), 8),
+		                                      vshlq_n_u32(bits(63 << 5), 5)),
+		                            vshlq_n_u32(bits(0xe01f), 3));
+		const auto low = vorrq_u32(vshrq_n_u32(bits(3 << 9), 1),
+		                           vshrq_n_u32(bits(7 << 2), 2));
+		return vorrq_u32(high, low);
+	}
+#endif
+
+#if RENDER_KERNELS_SSE2
+	static __m128i to_32(const __m128i v)
+	{
+		auto bits = [v](const int mask) {
+			return _mm_and_si128(v, _mm_set1_epi32(mask));
+		};
+		const auto high = _mm_or_si128(
+		        _mm_or_si128(_mm_slli_epi32(bits(31 << 11), 8),
+		                     _mm_slli_epi32(bits(63 << 5), 5)),
+		        _mm_slli_epi32(bits(0xe01f), 3));
+		const auto low = _mm_or_si128(_mm_srli_epi32(bits(3 << 9), 1),
+		                              _mm_srli_epi32(bits(7 << 2), 2));
+		return _mm_or_si128(high, low);
+	}
+#endif
+
+#if RENDER_KERNELS_AVX2
+	__attribute__((target("avx2"))) static __m256i to_32(const __m256i v)
+	{
+		const auto high = _mm256_or_si256(
+		        _mm256_or_si256(_mm256_slli_epi32(bits_avx2(v, 31 << 11), 8),
+		                        _mm256_slli_epi32(bits_avx2(v, 63 << 5), 5)),
+		        _mm256_slli_epi32(bits_avx2(v, 0xe01f), 3));
+		const auto low = _mm256_or_si256(
+		        _mm256_srli_epi32(bits_avx2(v, 3 << 9), 1),
+		        _mm256_srli_epi32(bits_avx2(v, 7 << 2), 2));
+		return _mm256_or_si256(high, low);
+	}
+#endif
+};
+
+template <typename Format, bool Doubled>
+static void convert_scalar(const uint16_t* src, size_t num_pixels, uint32_t* out)
+{
+	while (num_pixels--) {
+		const auto pixel = Format::to_32(*src++);
+		*out++ = pixel;
+		if constexpr (Doubled) {
+			*out++ = pixel;
+		}
+	}
+}
+
+#if RENDER_KERNELS_NEON
+template <typename Format, bool Doubled>
+static void convert_neon(const uint16_t* src, size_t num_pixels, uint32_t* out)
+{
+	for (; num_pixels >= 8; num_pixels -= 8, src += 8) {
+		const auto values = vld1q_u16(src);
+		const auto low  = Format::to_32(vmovl_u16(vget_low_u16(values)));
+		const auto high = Format::to_32(vmovl_high_u16(values));
+
+		// The interleaving stores write every pixel twice
+		if constexpr (Doubled) {
+			vst2q_u32(out, uint32x4x2_t{{low, low}});
+			vst2q_u32(out + 8, uint32x4x2_t{{high, high}});
+			out += 16;
+		} else {
+			vst1q_u32(out, low);
+			vst1q_u32(out + 4, high);
+			out += 8;
+		}
+	}
+	convert_scalar<Format, Doubled>(src, num_pixels, out);
+}
+#endif
+
+#if RENDER_KERNELS_SSE2
+template <typename Format, bool Doubled>
+static void convert_sse2(const uint16_t* src, size_t num_pixels, uint32_t* out)
+{
+	const auto zero = _mm_setzero_si128();
+
+	for (; num_pixels >= 8; num_pixels -= 8, src += 8) {
+		const auto values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		const auto low  = Format::to_32(_mm_unpacklo_epi16(values, zero));
+		const auto high = Format::to_32(_mm_unpackhi_epi16(values, zero));
+
+		const auto out_pt = reinterpret_cast<__m128i*>(out);
+		if constexpr (Doubled) {
+			_mm_storeu_si128(out_pt, _mm_unpacklo_epi32(low, low));
+			_mm_storeu_si128(out_pt + 1, _mm_unpackhi_epi32(low, low));
+			_mm_storeu_si128(out_pt + 2, _mm_unpacklo_epi32(high, high));
+			_mm_storeu_si128(out_pt + 3, _mm_unpackhi_epi32(high, high));
+			out += 16;
+		} else {
+			_mm_storeu_si128(out_pt, low);
+			_mm_storeu_si128(out_pt + 1, high);
+			out += 8;
+		}
+	}
+	convert_scalar<Format, Doubled>(src, num_pixels, out);
+}
+#endif
+
+#if RENDER_KERNELS_AVX2
+template <typename Format, bool Doubled>
+__attribute__((target("avx2"))) static void convert_avx2(const uint16_t* src,
+                                                         size_t num_pixels,
+                                                         uint32_t* out)
+{
+	for (; num_pixels >= 8; num_pixels -= 8, src += 8) {
+		const auto values = _mm256_cvtepu16_epi32(
+		        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+		const auto pixels = Format::to_32(values);
+
+		const auto out_pt = reinterpret_cast<__m256i*>(out);
+		if constexpr (Doubled) {
+			const auto first  = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+			const auto second = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+			_mm256_storeu_si256(out_pt,
+			                    _mm256_permutevar8x32_epi32(pixels, first));
+			_mm256_storeu_si256(out_pt + 1,
+			                    _mm256_permutevar8x32_epi32(pixels, second));
+			out += 16;
+		} else {
+			_mm256_storeu_si256(out_pt, pixels);
+			out += 8;
+		}
+	}
+	convert_scalar<Format, Doubled>(src, num_pixels, out);
+}
+
+static bool host_has_avx2()
+{
+	static const bool has_avx2 = __builtin_cpu_supports("avx2");
+	return has_avx2;
+}
+#endif
+
+using convert_kernel_f = void (*)(const uint16_t* src, size_t num_pixels,
+                                  uint32_t* out);
+
+template <typename Format, bool Doubled>
+static convert_kernel_f get_convert_kernel()
+{
+#if RENDER_KERNELS_NEON
+	return convert_neon<Format, Doubled>;
+#else
+#if RENDER_KERNELS_AVX2
+	if (host_has_avx2()) {
+		return convert_avx2<Format, Doubled>;
+	}
+#endif
+#if RENDER_KERNELS_SSE2
+	return convert_sse2<Format, Doubled>;
+#else
+	return convert_scalar<Format, Doubled>;
+#endif
+#endif
+}
+
+// Neither SSE nor NEON can gather from a 256-entry table of 32-bit colours
+// faster than scalar loads, so the palette lookups are left as plain loops
+void RENDER_Convert8To32(const uint8_t* src, size_t num_pixels,
+                         const uint32_t* lut, uint32_t* out)
+{
+	while (num_pixels--) {
+		*out++ = lut[*src++];
+	}
+}
+
+void RENDER_Convert8To32Doubled(const uint8_t* src, size_t num_pixels,
+                                const uint32_t* lut, uint32_t* out)
+{
+	while (num_pixels--) {
+		out[0] = out[1] = lut[*src++];
+		out += 2;
+	}
+}
+
+void RENDER_Convert15To32(const uint16_t* src, const size_t num_pixels,
+                          uint32_t* out)
+{
+	get_convert_kernel<Rgb555, false>()(src, num_pixels, out);
+}
+
+void RENDER_Convert15To32Doubled(const uint16_t* src, const size_t num_pixels,
+                                 uint32_t* out)
+{
+	get_convert_kernel<Rgb555, true>()(src, num_pixels, out);
+}
+
+void RENDER_Convert16To32(const uint16_t* src, const size_t num_pixels,
+                          uint32_t* out)
+{
+	get_convert_kernel<Rgb565, false>()(src, num_pixels, out);
+}
+
+void RENDER_Convert16To32Doubled(const uint16_t* src, const size_t num_pixels,
+                                 uint32_t* out)
+{
+	get_convert_kernel<Rgb565, true>()(src, num_pixels, out);
+}
@@ -0,0 +1,55 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_RENDER_LINE_KERNELS_H
+#define DOSBOX_RENDER_LINE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Pixel conversion kernels of the simple scalers
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Convert runs of source pixels to 32-bit XRGB8888 output pixels, the
+// 'Doubled' variants writing every pixel twice for the double-wide scalers.
+// The 15/16-bit conversions are vectorised: with NEON on 64-bit Arm hosts, and
+// with SSE2 or AVX2 on x86 hosts, picked at runtime by the CPU's features.
+// The outputs are identical to the scalers' 'PMAKE' conversions on
+// little-endian hosts.
+
+// Looks up the colours of 8-bit palette indexes in 'lut'
+void RENDER_Convert8To32(const uint8_t* src, size_t num_pixels,
+                         const uint32_t* lut, uint32_t* out);
+
+void RENDER_Convert8To32Doubled(const uint8_t* src, size_t num_pixels,
+                                const uint32_t* lut, uint32_t* out);
+
+// Expands xRRRRRGGGGGBBBBB pixels
+void RENDER_Convert15To32(const uint16_t* src, size_t num_pixels, uint32_t* out);
+
+void RENDER_Convert15To32Doubled(const uint16_t* src, size_t num_pixels,
+                                 uint32_t* out);
+
+// Expands RRRRRGGGGGGBBBBB pixels
+void RENDER_Convert16To32(const uint16_t* src, size_t num_pixels, uint32_t* out);
+
+void RENDER_Convert16To32Doubled(const uint16_t* src, size_t num_pixels,
+                                 uint32_t* out);
+
+#endif
@@ -26,6 +26,8 @@
 #include "render.h"
 #include <cstring>
 
+#include "render_line_kernels.h"
+
 uint8_t Scaler_Aspect[SCALER_MAXHEIGHT]        = {};
 uint16_t Scaler_ChangedLines[SCALER_MAXHEIGHT] = {};
 
@@ -56,13 +58,9 @@ scalerChangeCache_t scalerChangeCache;
 #define conc3d(A,B,C) _conc5(A,_,B,_,C)
 #define conc4d(A,B,C,D) _conc7(A,_,B,_,C,_,D)
 
+// Copies the doubled lines; memcpy uses the widest moves the host has
 static inline void BituMove( void *_dst, const void * _src, Bitu size) {
-	 auto dst = static_cast<Bitu*>(_dst);
-	 auto src = static_cast<const Bitu*>(_src);
-	 size /= sizeof(Bitu);
-	 for (Bitu x = 0; x < size; x++) {
-		 dst[x] = src[x];
-	 }
+	 std::memcpy(_dst, _src, size);
 }
 
 static inline void ScalerAddLines( Bitu changed, Bitu count ) {
@@ -96,6 +94,9 @@ static inline void ScalerAddLines( Bitu changed, Bitu count ) {
 
 #define CC scalerChangeCache
 
+// The VGA passes nullptr for the lines it knows haven't changed
+#define RENDER_NULL_INPUT
+
 /* Include the different rendering routines */
 #define SBPP 8
 #define DBPP 8
@@ -85,6 +85,30 @@ static void conc4d(SCALERNAME,SBPP,DBPP,R)(const void *s) {
 #endif
 #endif //defined(SCALERLINEAR)
 			hadChange = 1;
+#if defined(PCONVERT)
+			const Bitu run = x > 32 ? 32 : x;
+			std::memcpy(cache, src, run * sizeof(SRCTYPE));
+			// Converts into the second line, which is the write cache
+			// for the linear scalers, so the first is only written to
+#if (SCALERHEIGHT > 1)
+			PTYPE* converted = line1;
+#else
+			PTYPE* converted = line0;
+#endif
+#if (SCALERWIDTH > 1)
+			PCONVERT_DOUBLED(src, run, converted);
+#else
+			PCONVERT(src, run, converted);
+#endif
+#if (SCALERHEIGHT > 1)
+			std::memcpy(line0, line1, run * SCALERWIDTH * PSIZE);
+			line1 += run * SCALERWIDTH;
+#endif
+			x -= run;
+			src += run;
+			cache += run;
+			line0 += run * SCALERWIDTH;
+#else
 			for (Bitu i = x > 32 ? 32 : x;i>0;i--,x--) {
 				const SRCTYPE S = *src;
 				*cache = S;
@@ -96,6 +120,7 @@ static void conc4d(SCALERNAME,SBPP,DBPP,R)(const void *s) {
 				line1 += SCALERWIDTH;
 #endif
 			}
+#endif // defined(PCONVERT)
 #if defined(SCALERLINEAR)
 #if (SCALERHEIGHT > 1)
 			Bitu copyLen = (Bitu)((uint8_t*)line1 - (uint8_t*)WC[0]);
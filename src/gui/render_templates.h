@@ -203,6 +203,25 @@
 #	define SRCTYPE uint32_t
 #endif
 
+// The kernels converting whole runs of pixels to 32-bit, used instead of
+// PMAKE by the simple scalers
+#if DBPP == 32 && !defined(WORDS_BIGENDIAN)
+#	if SBPP == 8 || SBPP == 9
+#		define PCONVERT(_SRC, _NUM, _OUT) \
+			RENDER_Convert8To32(_SRC, _NUM, render.pal.lut.b32, _OUT)
+#		define PCONVERT_DOUBLED(_SRC, _NUM, _OUT) \
+			RENDER_Convert8To32Doubled(_SRC, _NUM, render.pal.lut.b32, _OUT)
+#	elif SBPP == 15
+#		define PCONVERT(_SRC, _NUM, _OUT) RENDER_Convert15To32(_SRC, _NUM, _OUT)
+#		define PCONVERT_DOUBLED(_SRC, _NUM, _OUT) \
+			RENDER_Convert15To32Doubled(_SRC, _NUM, _OUT)
+#	elif SBPP == 16
+#		define PCONVERT(_SRC, _NUM, _OUT) RENDER_Convert16To32(_SRC, _NUM, _OUT)
+#		define PCONVERT_DOUBLED(_SRC, _NUM, _OUT) \
+			RENDER_Convert16To32Doubled(_SRC, _NUM, _OUT)
+#	endif
+#endif
+
 //  C0 C1 C2 D3
 //  C3 C4 C5 D4
 //  C6 C7 C8 D5
@@ -285,6 +304,8 @@
 #undef PSIZE
 #undef PTYPE
 #undef PMAKE
+#undef PCONVERT
+#undef PCONVERT_DOUBLED
 #undef WC
 #undef LC
 #undef FC
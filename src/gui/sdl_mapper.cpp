@@ -114,6 +114,11 @@ typedef std::vector<CBindGroup *>::iterator CBindGroup_it;
 
 static CBindList holdlist;
 
+// Bumped whenever binds are added or removed, and on every triggered
+// (key, button, or hat) activation; the joystick polling only has to
+// dispatch unmoved axes again after one of these
+static uint32_t bind_generation = 0;
+
 class CEvent {
 public:
 	CEvent(const char *ev_entry) : bindlist{}
@@ -214,12 +219,14 @@ public:
 		list->push_back(this);
 		event=nullptr;
 		all_binds.push_back(this);
+		++bind_generation;
 	}
 
 	virtual ~CBind()
 	{
 		if (list)
 			list->remove(this);
+		++bind_generation;
 	}
 
 	CBind(const CBind&) = delete; // prevent copy
@@ -809,8 +816,17 @@ public:
 				old_button_state[i]=button_pressed[i];
 			}
 		}
+		// Axes at rest don't need their bindings activated again on
+		// every poll, only when something could have overridden them
+		const bool needs_redispatch = (bind_generation != last_bind_generation);
+		last_bind_generation = bind_generation;
+
 		for (int i = 0; i < axes; i++) {
 			Sint16 caxis_pos = SDL_JoystickGetAxis(sdl_joystick, i);
+			if (caxis_pos == old_axis_pos[i] && !needs_redispatch)
+				continue;
+			old_axis_pos[i] = caxis_pos;
+
 			/* activate bindings for joystick position */
 			if (caxis_pos>1) {
 				if (old_neg_axis_state[i]) {
@@ -945,6 +961,8 @@ protected:
 	bool old_button_state[MAXBUTTON] = {};
 	bool old_pos_axis_state[MAXAXIS] = {};
 	bool old_neg_axis_state[MAXAXIS] = {};
+	Sint16 old_axis_pos[MAXAXIS] = {};
+	uint32_t last_bind_generation = 0;
 	uint8_t old_hat_state[MAXHAT] = {};
 	bool is_dummy;
 };
@@ -1417,6 +1435,8 @@ static struct CMapper {
 
 void CBindGroup::ActivateBindList(CBindList * list,Bits value,bool ev_trigger) {
 	assert(list);
+	if (ev_trigger)
+		++bind_generation;
 	Bitu validmod=0;
 	CBindList_it it;
 	for (it = list->begin(); it != list->end(); ++it) {
@@ -1431,6 +1451,8 @@ void CBindGroup::ActivateBindList(CBindList * list,Bits value,bool ev_trigger) {
 
 void CBindGroup::DeactivateBindList(CBindList * list,bool ev_trigger) {
 	assert(list);
+	if (ev_trigger)
+		++bind_generation;
 	CBindList_it it;
 	for (it = list->begin(); it != list->end(); ++it) {
 		(*it)->DeActivateBind(ev_trigger);
@@ -21,7 +21,9 @@
 
 #include "dosbox.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cerrno>
 #include <cmath>
@@ -29,7 +31,11 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
 #include <sys/types.h>
+#include <thread>
 #include <tuple>
 #include <unistd.h>
 
@@ -51,12 +57,16 @@
 #include "../capture/capture.h"
 #include "../dos/dos_locale.h"
 #include "../ints/int10.h"
+#include "async_logging.h"
 #include "control.h"
 #include "cpu.h"
 #include "cross.h"
 #include "debug.h"
+#include "frame_stats.h"
 #include "fs_utils.h"
 #include "gui_msgs.h"
+#include "host_memory.h"
+#include "host_threads.h"
 #include "joystick.h"
 #include "keyboard.h"
 #include "mapper.h"
@@ -67,9 +77,11 @@
 #include "pic.h"
 #include "rect.h"
 #include "render.h"
+#include "rwqueue.h"
 #include "sdlmain.h"
 #include "setup.h"
 #include "string_utils.h"
+#include "support.h"
 #include "timer.h"
 #include "titlebar.h"
 #include "tracy.h"
@@ -111,6 +123,21 @@ typedef void (APIENTRYP PFNGLUNIFORM2FPROC) (GLint location, GLfloat v0, GLfloat
 typedef void (APIENTRYP PFNGLUNIFORM1IPROC) (GLint location, GLint v0);
 typedef void (APIENTRYP PFNGLUSEPROGRAMPROC) (GLuint program);
 typedef void (APIENTRYP PFNGLVERTEXATTRIBPOINTERPROC) (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid *pointer);
+typedef void (APIENTRYP PFNGLACTIVETEXTUREPROC) (GLenum texture);
+typedef void (APIENTRYP PFNGLBINDFRAMEBUFFERPROC) (GLenum target, GLuint framebuffer);
+typedef GLenum (APIENTRYP PFNGLCHECKFRAMEBUFFERSTATUSPROC) (GLenum target);
+typedef void (APIENTRYP PFNGLDELETEFRAMEBUFFERSPROC) (GLsizei n, const GLuint *framebuffers);
+typedef void (APIENTRYP PFNGLFRAMEBUFFERTEXTURE2DPROC) (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+typedef void (APIENTRYP PFNGLGENFRAMEBUFFERSPROC) (GLsizei n, GLuint *framebuffers);
+typedef void (APIENTRYP PFNGLBINDBUFFERPROC) (GLenum target, GLuint buffer);
+typedef void (APIENTRYP PFNGLBUFFERDATAPROC) (GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+typedef void (APIENTRYP PFNGLDELETEBUFFERSPROC) (GLsizei n, const GLuint *buffers);
+typedef void (APIENTRYP PFNGLGENBUFFERSPROC) (GLsizei n, GLuint *buffers);
+typedef void *(APIENTRYP PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (APIENTRYP PFNGLUNMAPBUFFERPROC) (GLenum target);
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC) (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC) (GLuint program, GLenum pname, GLint value);
 
 /* Apple defines these functions in their GL header (as core functions)
  * so we can't use their names as function pointers. We can't link
@@ -137,6 +164,21 @@ PFNGLUNIFORM2FPROC glUniform2f = nullptr;
 PFNGLUNIFORM1IPROC glUniform1i = nullptr;
 PFNGLUSEPROGRAMPROC glUseProgram = nullptr;
 PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer = nullptr;
+PFNGLACTIVETEXTUREPROC glActiveTexture = nullptr;
+PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer = nullptr;
+PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus = nullptr;
+PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers = nullptr;
+PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D = nullptr;
+PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers = nullptr;
+PFNGLBINDBUFFERPROC glBindBuffer = nullptr;
+PFNGLBUFFERDATAPROC glBufferData = nullptr;
+PFNGLDELETEBUFFERSPROC glDeleteBuffers = nullptr;
+PFNGLGENBUFFERSPROC glGenBuffers = nullptr;
+PFNGLMAPBUFFERRANGEPROC glMapBufferRange = nullptr;
+PFNGLUNMAPBUFFERPROC glUnmapBuffer = nullptr;
+PFNGLGETPROGRAMBINARYPROC glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glProgramParameteri = nullptr;
 }
 
 /* "using" is meant to hide identical names declared in outer scope
@@ -161,6 +203,21 @@ PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer = nullptr;
 #define glUniform1i               gl2::glUniform1i
 #define glUseProgram              gl2::glUseProgram
 #define glVertexAttribPointer     gl2::glVertexAttribPointer
+#define glActiveTexture           gl2::glActiveTexture
+#define glBindFramebuffer         gl2::glBindFramebuffer
+#define glCheckFramebufferStatus  gl2::glCheckFramebufferStatus
+#define glDeleteFramebuffers      gl2::glDeleteFramebuffers
+#define glFramebufferTexture2D    gl2::glFramebufferTexture2D
+#define glGenFramebuffers         gl2::glGenFramebuffers
+#define glBindBuffer              gl2::glBindBuffer
+#define glBufferData              gl2::glBufferData
+#define glDeleteBuffers           gl2::glDeleteBuffers
+#define glGenBuffers              gl2::glGenBuffers
+#define glMapBufferRange          gl2::glMapBufferRange
+#define glUnmapBuffer             gl2::glUnmapBuffer
+#define glGetProgramBinary        gl2::glGetProgramBinary
+#define glProgramBinary           gl2::glProgramBinary
+#define glProgramParameteri       gl2::glProgramParameteri
 
 #endif // C_OPENGL
 
@@ -207,12 +264,15 @@ static SDL_Rect to_sdl_rect(const DosBox::Rect& r)
 
 static void clean_up_sdl_resources();
 static void handle_video_resize(int width, int height);
+static void wait_for_presentation();
 
 static void update_frame_texture([[maybe_unused]] const uint16_t* changedLines);
 static bool present_frame_texture();
 #if C_OPENGL
 static void update_frame_gl(const uint16_t *changedLines);
+static void draw_frame_gl();
 static bool present_frame_gl();
+static void finish_rendered_readback();
 static const char* safe_gl_get_string(const GLenum requested_name,
                                       const char* default_result);
 #endif
@@ -580,13 +640,58 @@ static bool is_command_pressed(const SDL_Event event)
 
 uint8_t GFX_GetBestMode(const uint8_t flags)
 {
-	return (flags & GFX_CAN_32) & ~(GFX_CAN_8 | GFX_CAN_15 | GFX_CAN_16);
+	// 8-bit frames are only taken if their palette can be looked up on
+	// the GPU, with 32-bit kept as the fallback of GFX_SetSize()
+	const uint8_t indexed_flag = GFX_CanLookUpPalette() ? (flags & GFX_CAN_8) : 0;
+
+	return indexed_flag |
+	       ((flags & GFX_CAN_32) & ~(GFX_CAN_8 | GFX_CAN_15 | GFX_CAN_16));
+}
+
+bool GFX_CanLookUpPalette()
+{
+#if C_OPENGL
+	return sdl.want_rendering_backend == RenderingBackend::OpenGl &&
+	       sdl.opengl.palette.is_supported;
+#else
+	return false;
+#endif
+}
+
+void GFX_SetPalette([[maybe_unused]] const uint32_t* colours,
+                    [[maybe_unused]] const uint8_t first,
+                    [[maybe_unused]] const uint8_t last)
+{
+#if C_OPENGL
+	assert(first <= last);
+
+	auto& palette = sdl.opengl.palette;
+
+	const auto num_colours = last - first + 1;
+	const auto dest        = palette.colours.begin() + first;
+	if (std::equal(dest, dest + num_colours, colours + first)) {
+		return;
+	}
+	std::copy_n(colours + first, num_colours, dest);
+
+	// Only the changed range of the palette texture is uploaded
+	if (palette.is_dirty) {
+		palette.dirty_first = std::min(palette.dirty_first, first);
+		palette.dirty_last  = std::max(palette.dirty_last, last);
+	} else {
+		palette.dirty_first = first;
+		palette.dirty_last  = last;
+		palette.is_dirty    = true;
+	}
+#endif
 }
 
 // Let the presentation layer safely call no-op functions.
 // Useful during output initialization or transitions.
 void GFX_DisengageRendering()
 {
+	wait_for_presentation();
+
 	sdl.frame.update  = update_frame_noop;
 	sdl.frame.present = present_frame_noop;
 }
@@ -722,6 +827,7 @@ static void log_display_properties(const int render_width_px,
 	case FrameMode::Cfr: frame_mode = "CFR"; break;
 	case FrameMode::Vfr: frame_mode = "VFR"; break;
 	case FrameMode::ThrottledVfr: frame_mode = "throttled VFR"; break;
+	case FrameMode::JustInTime: frame_mode = "just-in-time CFR"; break;
 	case FrameMode::Unset: frame_mode = "Unset frame mode"; break;
 	default: assertm(false, "Invalid FrameMode");
 	}
@@ -819,8 +925,142 @@ static void save_rate_to_frame_period(const double rate_hz)
 
 static std::unique_ptr<Pacer> render_pacer = {};
 
+// Just-in-time presentation
+// ~~~~~~~~~~~~~~~~~~~~~~~~~
+// With vsync, a frame completed early waits in the buffer swap until the
+// display's vertical blank, which adds up to a refresh of latency. The
+// just-in-time mode measures that wait, and shifts the emulated time against
+// the host's a millisecond per frame so the frames are completed just before
+// the vertical blank. Falling past it makes the swap wait for the next one,
+// which the shifting moves back from the same way.
+//
+// Each frame has to pair with a refresh, so this needs the DOS and display
+// rates to match; the emulation then follows the display's clock.
+//
+constexpr int64_t JitSwapWaitMarginUs = 2'000;
+
+// The time the last buffer swap waited, or -1 once it has been accounted
+static std::atomic<int64_t> last_swap_wait_us = -1;
+
+static void record_swap_wait(const int64_t swap_start_us)
+{
+	last_swap_wait_us = GetTicksUsSince(swap_start_us);
+}
+
+static void schedule_just_in_time()
+{
+	const auto swap_wait_us = last_swap_wait_us.exchange(-1);
+	if (swap_wait_us < 0) {
+		return;
+	}
+	constexpr int64_t TickUs = 1'000;
+	if (swap_wait_us > JitSwapWaitMarginUs + TickUs) {
+		DOSBOX_ShiftTicks(1);
+	} else if (swap_wait_us < JitSwapWaitMarginUs / 2) {
+		DOSBOX_ShiftTicks(-1);
+	}
+}
+
+// Presentation thread
+// ~~~~~~~~~~~~~~~~~~~
+// With the OpenGL output, the emulation thread only uploads the finished
+// frame, then hands the context over to the presentation thread, which draws
+// the frame and swaps the buffers. The swap blocks until the next vertical
+// blank when vsync is on, and drivers can stall it further; on the thread,
+// this only delays the next frame's upload instead of the emulation.
+//
+// Everything using the context on the emulation thread first waits for the
+// frame in flight with wait_for_presentation(), which takes the context back.
+//
+// The texture output always presents on the emulation thread, as an SDL
+// renderer can only be used from the thread that created it.
+//
+#if C_OPENGL
+static struct {
+	std::thread thread = {};
+
+	// Handed-off frames, and the acknowledgements of their presentation
+	RWQueue<bool> frames{1};
+	RWQueue<bool> presented{1};
+
+	// Only accessed from the emulation thread
+	bool is_frame_in_flight = false;
+} presenter;
+
+static void present_frames_on_thread()
+{
+	while (presenter.frames.Dequeue()) {
+		SDL_GL_MakeCurrent(sdl.window, sdl.opengl.context);
+
+		// Post-render images are captured on the emulation thread,
+		// see GFX_EndUpdate()
+		const auto is_presenting = render_pacer->CanRun();
+		if (is_presenting) {
+			draw_frame_gl();
+
+			const auto swap_start_us = GetTicksUs();
+			SDL_GL_SwapWindow(sdl.window);
+			record_swap_wait(swap_start_us);
+		}
+		render_pacer->Checkpoint();
+
+		SDL_GL_MakeCurrent(sdl.window, nullptr);
+
+		presenter.presented.Enqueue(true);
+	}
+}
+#endif
+
+static void wait_for_presentation()
+{
+#if C_OPENGL
+	if (!presenter.is_frame_in_flight) {
+		return;
+	}
+	presenter.presented.Dequeue();
+	presenter.is_frame_in_flight = false;
+
+	SDL_GL_MakeCurrent(sdl.window, sdl.opengl.context);
+#endif
+}
+
+static void stop_presentation_thread()
+{
+#if C_OPENGL
+	wait_for_presentation();
+	if (presenter.thread.joinable()) {
+		presenter.frames.Stop();
+		presenter.thread.join();
+	}
+#endif
+}
+
+// Presents the frame on the presentation thread when that's in use, or
+// right away otherwise. A frame handed to the thread counts as presented.
+static bool present_frame()
+{
+#if C_OPENGL
+	if (sdl.frame.present == present_frame_gl && sdl.frame.threaded_presentation) {
+		if (!presenter.thread.joinable()) {
+			presenter.frames.Start();
+			presenter.thread = std::thread(present_frames_on_thread);
+			set_thread_name(presenter.thread, "dosbox:present");
+		}
+		wait_for_presentation();
+		SDL_GL_MakeCurrent(sdl.window, nullptr);
+
+		presenter.is_frame_in_flight = true;
+		presenter.frames.Enqueue(true);
+		return true;
+	}
+#endif
+	return sdl.frame.present();
+}
+
 static int benchmark_presentation_rate()
 {
+	wait_for_presentation();
+
 	// If the presentation function is empty, then we can't benchmark
 	assert(sdl.frame.present != present_frame_noop ||
 	       sdl.frame.update != update_frame_noop);
@@ -899,6 +1139,8 @@ static VsyncState measure_vsync_state(int& bench_rate)
 
 static void set_vsync(const VsyncState state)
 {
+	wait_for_presentation();
+
 	if (state == VsyncState::Yield) {
 		return;
 	}
@@ -986,7 +1228,7 @@ static void maybe_present_throttled(const bool frame_is_new)
 		last_present_time = now - (9 * wait_overage / 10);
 
 		if (frame_is_new || was_new_and_throttled) {
-			sdl.frame.present();
+			present_frame();
 		}
 	}
 	// Otherwise we've had to throttle the frame, however if the frame was
@@ -1012,13 +1254,16 @@ static void maybe_present_synced(const bool present_if_last_skipped)
 	const auto should_present = on_time || (present_if_last_skipped &&
 	                                        !last_frame_presented);
 
-	last_frame_presented = should_present ? sdl.frame.present() : false;
+	last_frame_presented = should_present ? present_frame() : false;
 
 	last_sync_time = should_present ? GetTicksUs() : now;
 }
 
 static void setup_presentation_mode(FrameMode &previous_mode)
 {
+	// The pacer is used by the presentation thread
+	wait_for_presentation();
+
 	// Always get the reported refresh rate and hint the VGA side with it.
 	// This ensures the VGA side always has the host's rate to prior to its
 	// next mode change.
@@ -1037,11 +1282,26 @@ static void setup_presentation_mode(FrameMode &previous_mode)
 	// to be set below
 	auto mode = FrameMode::Unset;
 
-	// Manual CFR or VFR modes
+	// Manual CFR, VFR, or just-in-time modes
 	if (sdl.frame.desired_mode == FrameMode::Cfr ||
-	    sdl.frame.desired_mode == FrameMode::Vfr) {
+	    sdl.frame.desired_mode == FrameMode::Vfr ||
+	    sdl.frame.desired_mode == FrameMode::JustInTime) {
 		mode = sdl.frame.desired_mode;
 
+		// The frames can only be timed against the vertical blank if
+		// each of them pairs with a refresh
+		constexpr auto MaxJitRateMismatch = 0.005;
+		const auto rates_match = std::abs(host_rate - dos_rate) <=
+		                         MaxJitRateMismatch * dos_rate;
+		if (mode == FrameMode::JustInTime && (!vsync_is_on || !rates_match)) {
+			mode = FrameMode::Cfr;
+			if (previous_mode != mode) {
+				LOG_WARNING("SDL: Just-in-time presentation needs vsync and a %.3f Hz display "
+				            "rate to match the DOS rate, using CFR",
+				            dos_rate);
+			}
+		}
+
 		// Frames will be presented at the DOS rate.
 		save_rate_to_frame_period(dos_rate);
 
@@ -1226,6 +1486,7 @@ static SDL_Window* SetWindowMode(const RenderingBackend rendering_backend,
 		return sdl.window;
 	}
 
+	wait_for_presentation();
 	clean_up_sdl_resources();
 
 	if (!sdl.window || (sdl.rendering_backend != rendering_backend)) {
@@ -1313,6 +1574,10 @@ static SDL_Window* SetWindowMode(const RenderingBackend rendering_backend,
 				sdl.opengl.context = nullptr;
 			}
 
+			// The readback buffer went away with the old context
+			sdl.opengl.readback.buffer     = 0;
+			sdl.opengl.readback.is_pending = false;
+
 			assert(sdl.opengl.context == nullptr);
 			sdl.opengl.context = SDL_GL_CreateContext(sdl.window);
 			if (sdl.opengl.context == nullptr) {
@@ -1388,6 +1653,7 @@ finish:
 // Returns the current window; used for mapper UI.
 SDL_Window* GFX_GetWindow()
 {
+	wait_for_presentation();
 	return sdl.window;
 }
 
@@ -1590,6 +1856,466 @@ static bool LoadGLShaders(const std::string& source, GLuint *vertex,
 	}
 	return false;
 }
+
+// Compiled shader programs
+// ~~~~~~~~~~~~~~~~~~~~~~~~
+// The programs compiled during the session are kept, so switching back to a
+// shader (e.g., when the adaptive CRT shaders follow the video mode changes)
+// doesn't compile it again. If the driver supports it, the linked program
+// binaries are also cached on disk, so later sessions can skip compiling.
+//
+// The programs are keyed by their source, which all the shader settings are
+// parsed from, so reloaded shaders that were edited get compiled again. The
+// disk cache is also keyed by the driver, as the binaries are specific to it.
+//
+constexpr auto ShaderCacheDir = "shader-cache";
+
+static struct {
+	std::map<std::string, GLuint> programs = {};
+
+	bool has_binary_cache = false;
+	std::string driver_id = {};
+} shader_programs = {};
+
+static void setup_program_binary_cache(const bool is_supported)
+{
+	shader_programs.has_binary_cache = is_supported;
+
+	shader_programs.driver_id = safe_gl_get_string(GL_VENDOR, "");
+	shader_programs.driver_id += safe_gl_get_string(GL_RENDERER, "");
+	shader_programs.driver_id += safe_gl_get_string(GL_VERSION, "");
+}
+
+// The programs belong to a context that's gone
+static void forget_shader_programs()
+{
+	shader_programs.programs.clear();
+}
+
+static std_fs::path get_program_binary_path(const std::string& source)
+{
+	// 64-bit FNV-1a, as it's stable across sessions
+	uint64_t hash = 0xcbf29ce484222325;
+	for (const auto c : shader_programs.driver_id + source) {
+		hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3;
+	}
+	const auto hi = static_cast<uint32_t>(hash >> 32);
+	const auto lo = static_cast<uint32_t>(hash);
+
+	return GetConfigDir() / ShaderCacheDir / format_str("%08x%08x.bin", hi, lo);
+}
+
+static GLuint load_program_binary(const std::string& source)
+{
+	const auto path = get_program_binary_path(source);
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return 0;
+	}
+	GLenum format = 0;
+	file.read(reinterpret_cast<char*>(&format), sizeof(format));
+
+	const std::vector<char> binary((std::istreambuf_iterator<char>(file)),
+	                               std::istreambuf_iterator<char>());
+	file.close();
+	if (binary.empty()) {
+		return 0;
+	}
+
+	const auto program = glCreateProgram();
+	if (!program) {
+		return 0;
+	}
+	glProgramBinary(program, format, binary.data(), check_cast<GLsizei>(binary.size()));
+
+	// Binaries of other driver versions are rejected
+	GLint is_program_linked = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &is_program_linked);
+	if (!is_program_linked) {
+		glDeleteProgram(program);
+
+		std::error_code ec = {};
+		std_fs::remove(path, ec);
+		return 0;
+	}
+	return program;
+}
+
+static void save_program_binary(const GLuint program, const std::string& source)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+	std::vector<char> binary(static_cast<size_t>(length));
+	GLenum format = 0;
+	glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+	const auto path = get_program_binary_path(source);
+
+	std::error_code ec = {};
+	std_fs::create_directories(path.parent_path(), ec);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+	file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+	if (!file) {
+		LOG_WARNING("OPENGL: Can't write the shader cache file '%s'",
+		            path.string().c_str());
+	}
+}
+
+// Compiles and links the shader source, or returns 0 on failure
+static GLuint build_shader_program(const std::string& source)
+{
+	GLuint vertexShader, fragmentShader;
+
+	if (!LoadGLShaders(source, &vertexShader, &fragmentShader)) {
+		LOG_ERR("OPENGL: Failed to compile shader");
+		return 0;
+	}
+
+	const auto program = glCreateProgram();
+	if (!program) {
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+
+		LOG_WARNING("OPENGL: Can't create program object, "
+		            "falling back to texture");
+		return 0;
+	}
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+
+	if (shader_programs.has_binary_cache) {
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	// Link the program
+	glLinkProgram(program);
+
+	// Even if we *are* successful, we may delete the shader objects
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	// Check the link status
+	GLint is_program_linked = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &is_program_linked);
+
+	// The info log might contain warnings and info messages
+	// even if the linking was successful, so we'll always log
+	// it if it's non-empty.
+	GLint info_len = 0;
+
+	glGetProgramiv(program, GL_INFO_LOG_LENGTH, &info_len);
+
+	if (info_len > 1) {
+		std::vector<GLchar> info_log(info_len);
+
+		glGetProgramInfoLog(program, info_len, nullptr, info_log.data());
+
+		if (is_program_linked) {
+			LOG_WARNING("OPENGL: Program info log:\n %s", info_log.data());
+		} else {
+			LOG_ERR("OPENGL: Error linking program:\n %s", info_log.data());
+		}
+	}
+
+	if (!is_program_linked) {
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+// Returns the program of the shader source from the caches, or builds it
+static GLuint get_shader_program(const std::string& source)
+{
+	auto& programs = shader_programs.programs;
+
+	if (const auto it = programs.find(source); it != programs.end()) {
+		glGetError();
+		glUseProgram(it->second);
+		if (glGetError() == GL_NO_ERROR) {
+			return it->second;
+		}
+		forget_shader_programs();
+	}
+
+	GLuint program = 0;
+	if (shader_programs.has_binary_cache) {
+		program = load_program_binary(source);
+	}
+	if (!program) {
+		program = build_shader_program(source);
+		if (program && shader_programs.has_binary_cache) {
+			save_program_binary(program, source);
+		}
+	}
+	if (program) {
+		programs[source] = program;
+	}
+	return program;
+}
+
+// Palette lookup of 8-bit indexed frames
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Instead of uploading every frame as 32-bit pixels, the indexed frames are
+// uploaded as-is, along with their 256-colour palette. Before the frame is
+// drawn, a pass through a framebuffer object looks up the colour of each
+// index and renders the result into the regular 32-bit texture, so the
+// user's shader and the presentation are unaffected.
+//
+// The lookup writes the stored palette bytes unchanged, so the sRGB
+// conversion is disabled during the pass.
+//
+constexpr auto PaletteShaderSource = R"GLSL(#version 120
+
+#if defined(VERTEX)
+
+attribute vec4 a_position;
+
+void main()
+{
+	gl_Position = a_position;
+}
+
+#elif defined(FRAGMENT)
+
+uniform sampler2D indexTexture;
+uniform sampler2D paletteTexture;
+uniform vec2 indexTextureSize;
+
+// How many times the pixels and lines of undoubled frames are repeated
+uniform vec2 frameScale;
+
+void main()
+{
+	// The pass renders into a texture of the same size, or of twice the
+	// width or height for the undoubled frames. The nearest index is
+	// sampled, which repeats it just like the scalers would.
+	float index = texture2D(indexTexture,
+	                        gl_FragCoord.xy / (indexTextureSize * frameScale)).r;
+
+	gl_FragColor = texture2D(paletteTexture,
+	                         vec2((index * 255.0 + 0.5) / 256.0, 0.5));
+}
+
+#endif
+)GLSL";
+
+static bool build_palette_program()
+{
+	auto& palette = sdl.opengl.palette;
+
+	GLuint vertex_shader   = 0;
+	GLuint fragment_shader = 0;
+	if (!LoadGLShaders(PaletteShaderSource, &vertex_shader, &fragment_shader)) {
+		return false;
+	}
+
+	palette.program = glCreateProgram();
+	if (palette.program) {
+		glAttachShader(palette.program, vertex_shader);
+		glAttachShader(palette.program, fragment_shader);
+		glLinkProgram(palette.program);
+	}
+	glDeleteShader(vertex_shader);
+	glDeleteShader(fragment_shader);
+
+	GLint is_program_linked = 0;
+	if (palette.program) {
+		glGetProgramiv(palette.program, GL_LINK_STATUS, &is_program_linked);
+	}
+	if (!is_program_linked) {
+		if (palette.program) {
+			glDeleteProgram(palette.program);
+		}
+		palette.program = 0;
+		return false;
+	}
+
+	glUseProgram(palette.program);
+	glUniform1i(glGetUniformLocation(palette.program, "indexTexture"), 0);
+	glUniform1i(glGetUniformLocation(palette.program, "paletteTexture"), 1);
+
+	palette.index_size = glGetUniformLocation(palette.program,
+	                                          "indexTextureSize");
+	palette.frame_scale = glGetUniformLocation(palette.program, "frameScale");
+	palette.position = glGetAttribLocation(palette.program, "a_position");
+	return true;
+}
+
+static void set_nearest_texture_parameters()
+{
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+}
+
+// Sets up the lookup into the current 'sdl.opengl.texture', doubling the
+// frames by the given scale. Restores the texture and program bindings of
+// the regular drawing when done.
+static bool setup_palette_lookup(const int texsize_w_px, const int texsize_h_px,
+                                 const int scale_x, const int scale_y)
+{
+	auto& palette = sdl.opengl.palette;
+	if (!palette.is_supported) {
+		return false;
+	}
+
+	// The program isn't usable anymore with a new context
+	glGetError();
+	if (palette.program) {
+		glUseProgram(palette.program);
+		if (glGetError() != GL_NO_ERROR) {
+			glDeleteProgram(palette.program);
+			palette.program = 0;
+		}
+	}
+	if (!palette.program && !build_palette_program()) {
+		LOG_WARNING("OPENGL: Failed to build the palette lookup shader, "
+		            "using 32-bit frames");
+		palette.is_supported = false;
+		glUseProgram(sdl.opengl.program_object);
+		return false;
+	}
+	// The textures of the doubled frames are exactly twice as large, also
+	// when rounded up to powers of two
+	const auto index_w_px = texsize_w_px / scale_x;
+	const auto index_h_px = texsize_h_px / scale_y;
+
+	glUniform2f(palette.index_size, (GLfloat)index_w_px, (GLfloat)index_h_px);
+	glUniform2f(palette.frame_scale, (GLfloat)scale_x, (GLfloat)scale_y);
+
+	// The indexes in unit 0, where the frame's texture is sampled from
+	if (palette.index_texture > 0) {
+		glDeleteTextures(1, &palette.index_texture);
+	}
+	glGenTextures(1, &palette.index_texture);
+	glBindTexture(GL_TEXTURE_2D, palette.index_texture);
+	set_nearest_texture_parameters();
+	glTexImage2D(GL_TEXTURE_2D,
+	             0,
+	             GL_LUMINANCE8,
+	             index_w_px,
+	             index_h_px,
+	             0,
+	             GL_LUMINANCE,
+	             GL_UNSIGNED_BYTE,
+	             nullptr);
+
+	// The palette stays bound to unit 1
+	glActiveTexture(GL_TEXTURE1);
+	if (palette.palette_texture > 0) {
+		glDeleteTextures(1, &palette.palette_texture);
+	}
+	glGenTextures(1, &palette.palette_texture);
+	glBindTexture(GL_TEXTURE_2D, palette.palette_texture);
+	set_nearest_texture_parameters();
+	glTexImage2D(GL_TEXTURE_2D,
+	             0,
+	             GL_RGBA8,
+	             check_cast<GLsizei>(palette.colours.size()),
+	             1,
+	             0,
+	             GL_BGRA_EXT,
+	             GL_UNSIGNED_INT_8_8_8_8_REV,
+	             palette.colours.data());
+	glActiveTexture(GL_TEXTURE0);
+	palette.is_dirty = false;
+
+	if (palette.framebuffer > 0) {
+		glDeleteFramebuffers(1, &palette.framebuffer);
+	}
+	glGenFramebuffers(1, &palette.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, palette.framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER,
+	                       GL_COLOR_ATTACHMENT0,
+	                       GL_TEXTURE_2D,
+	                       sdl.opengl.texture,
+	                       0);
+	const auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBindTexture(GL_TEXTURE_2D, sdl.opengl.texture);
+	glUseProgram(sdl.opengl.program_object);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_WARNING("OPENGL: Can't render into the frame's texture (status 0x%x), "
+		            "using 32-bit frames",
+		            status);
+		palette.is_supported = false;
+		return false;
+	}
+
+	// The lookup pass draws the same triangle as the user shader, also
+	// when there's no user shader setting it up. Sharing the vertex data
+	// lets both programs use the same attribute array.
+	constexpr GLfloat TriangleVertices[] = {-1.0f, 1.0f, -1.0f, -3.0f, 3.0f, 1.0f};
+	std::copy(std::begin(TriangleVertices),
+	          std::end(TriangleVertices),
+	          std::begin(sdl.opengl.vertex_data));
+	return true;
+}
+
+// Looks up the colours of the indexes into the frame's texture
+static void expand_indexed_frame_gl()
+{
+	const auto& palette = sdl.opengl.palette;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, palette.framebuffer);
+	glViewport(0, 0, sdl.draw.render_width_px, sdl.draw.render_height_px);
+	if (sdl.opengl.framebuffer_is_srgb_encoded) {
+		glDisable(GL_FRAMEBUFFER_SRGB);
+	}
+
+	glUseProgram(palette.program);
+	glVertexAttribPointer(palette.position, 2, GL_FLOAT, GL_FALSE, 0, sdl.opengl.vertex_data);
+	glEnableVertexAttribArray(palette.position);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(sdl.draw_rect_px.x,
+	           sdl.draw_rect_px.y,
+	           sdl.draw_rect_px.w,
+	           sdl.draw_rect_px.h);
+	if (sdl.opengl.framebuffer_is_srgb_encoded) {
+		glEnable(GL_FRAMEBUFFER_SRGB);
+	}
+	glUseProgram(sdl.opengl.program_object);
+	glBindTexture(GL_TEXTURE_2D, sdl.opengl.texture);
+}
+
+// (Re)creates the ring of pixel buffer objects the frames are uploaded
+// through, each large enough for a whole frame
+static void setup_upload_buffers(const size_t frame_bytes)
+{
+	auto& upload = sdl.opengl.upload;
+	if (!upload.is_supported) {
+		return;
+	}
+	if (upload.size) {
+		glDeleteBuffers(check_cast<GLsizei>(upload.buffers.size()),
+		                upload.buffers.data());
+	}
+	glGenBuffers(check_cast<GLsizei>(upload.buffers.size()), upload.buffers.data());
+
+	for (const auto buffer : upload.buffers) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER,
+		             check_cast<GLsizeiptr>(frame_bytes),
+		             nullptr,
+		             GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	upload.size  = frame_bytes;
+	upload.index = 0;
+}
 #endif
 
 static bool is_using_kmsdrm_driver()
@@ -1858,74 +2584,17 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 					glUseProgram(sdl.opengl.program_object);
 					if (glGetError() != GL_NO_ERROR) {
 						// program is not usable (probably new context), purge it
-						glDeleteProgram(sdl.opengl.program_object);
+						// along with the other cached programs
+						forget_shader_programs();
 						sdl.opengl.program_object = 0;
 					}
 				}
 
 				// does program need to be rebuilt?
 				if (sdl.opengl.program_object == 0) {
-					GLuint vertexShader, fragmentShader;
-
-					if (!LoadGLShaders(sdl.opengl.shader_source,
-					                   &vertexShader,
-					                   &fragmentShader)) {
-						LOG_ERR("OPENGL: Failed to compile shader");
-						goto fallback_texture;
-					}
-
-					sdl.opengl.program_object = glCreateProgram();
+					sdl.opengl.program_object = get_shader_program(
+					        sdl.opengl.shader_source);
 					if (!sdl.opengl.program_object) {
-						glDeleteShader(vertexShader);
-						glDeleteShader(fragmentShader);
-
-						LOG_WARNING("OPENGL: Can't create program object, "
-						            "falling back to texture");
-						goto fallback_texture;
-					}
-					glAttachShader(sdl.opengl.program_object, vertexShader);
-					glAttachShader(sdl.opengl.program_object, fragmentShader);
-
-					// Link the program
-					glLinkProgram(sdl.opengl.program_object);
-
-					// Even if we *are* successful, we may delete the shader objects
-					glDeleteShader(vertexShader);
-					glDeleteShader(fragmentShader);
-
-					// Check the link status
-					GLint is_program_linked = 0;
-					glGetProgramiv(sdl.opengl.program_object, GL_LINK_STATUS, &is_program_linked);
-
-					// The info log might contain warnings and info messages
-					// even if the linking was successful, so we'll always log
-					// it if it's non-empty.
-					GLint info_len = 0;
-
-					glGetProgramiv(sdl.opengl.program_object,
-					               GL_INFO_LOG_LENGTH,
-					               &info_len);
-
-					if (info_len > 1) {
-						std::vector<GLchar> info_log(info_len);
-
-						glGetProgramInfoLog(sdl.opengl.program_object,
-						                    info_len,
-						                    nullptr,
-						                    info_log.data());
-
-						if (is_program_linked) {
-							LOG_WARNING("OPENGL: Program info log:\n %s",
-							            info_log.data());
-						} else {
-							LOG_ERR("OPENGL: Error linking program:\n %s",
-							        info_log.data());
-						}
-					}
-
-					if (!is_program_linked) {
-						glDeleteProgram(sdl.opengl.program_object);
-						sdl.opengl.program_object = 0;
 						goto fallback_texture;
 					}
 
@@ -1962,6 +2631,8 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 		sdl.opengl.framebuf = malloc(framebuffer_bytes); // 32 bit colour
 		sdl.opengl.pitch = render_width_px * 4;
 
+		setup_upload_buffers(framebuffer_bytes);
+
 		// One-time initialize the window size
 		if (!sdl.desktop.window.adjusted_initial_size) {
 			initialize_sdl_window_size(sdl.window,
@@ -2124,9 +2795,30 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 			glEndList();
 		}
 
+		// Undoubled frames are doubled by the palette lookup
+		const auto is_doubled_by_lookup = (flags & GFX_DBL_OUTPUT) != 0;
+		const auto scale_x = (is_doubled_by_lookup && double_width) ? 2 : 1;
+		const auto scale_y = (is_doubled_by_lookup && double_height) ? 2 : 1;
+
+		auto& palette     = sdl.opengl.palette;
+		palette.is_active = (flags & GFX_CAN_8) &&
+		                    setup_palette_lookup(texsize_w_px,
+		                                         texsize_h_px,
+		                                         scale_x,
+		                                         scale_y);
+		if (palette.is_active) {
+			palette.width_px  = render_width_px / scale_x;
+			palette.height_px = render_height_px / scale_y;
+			sdl.opengl.pitch  = palette.width_px;
+		}
+
 		OPENGL_ERROR("End of setsize");
 
-		retFlags          = GFX_CAN_32 | GFX_CAN_RANDOM;
+		retFlags = (palette.is_active ? GFX_CAN_8 : GFX_CAN_32) |
+		           GFX_CAN_RANDOM;
+		if (palette.is_active && is_doubled_by_lookup) {
+			retFlags |= GFX_DBL_OUTPUT;
+		}
 		sdl.frame.update  = update_frame_gl;
 		sdl.frame.present = present_frame_gl;
 #else
@@ -2176,13 +2868,8 @@ void GFX_SetShader([[maybe_unused]] const ShaderInfo& shader_info,
 	sdl.opengl.shader_info   = shader_info;
 	sdl.opengl.shader_source = shader_source;
 
-	if (!sdl.opengl.use_shader) {
-		return;
-	}
-	if (sdl.opengl.program_object) {
-		glDeleteProgram(sdl.opengl.program_object);
-		sdl.opengl.program_object = 0;
-	}
+	// The program stays cached, in case the shader is switched back to
+	sdl.opengl.program_object = 0;
 #endif
 }
 
@@ -2324,7 +3011,7 @@ static void switch_fullscreen(bool pressed)
 //
 bool GFX_StartUpdate(uint8_t * &pixels, int &pitch)
 {
-	if (!sdl.active || sdl.updating)
+	if (!sdl.active || sdl.updating || sdl.headless)
 		return false;
 
 	switch (sdl.rendering_backend) {
@@ -2362,12 +3049,22 @@ void GFX_EndUpdate(const uint16_t* changedLines)
 
 	sdl.frame.update(changedLines);
 
+	const auto upload_us = GetTicksUsSince(start_us);
+
+#if C_OPENGL
+	finish_rendered_readback();
+#endif
+
 	if (CAPTURE_IsCapturingPostRenderImage()) {
 		// Always present the frame if we want to capture the next rendered
 		// frame, regardless of the presentation mode. This is necessary to
 		// keep the contents of rendered and raw/upscaled screenshots in sync
 		// (so they capture the exact same frame) in multi-output image
 		// capture modes.
+		//
+		// The capture reads the back buffer, so this is always presented
+		// on the emulation thread.
+		wait_for_presentation();
 		sdl.frame.present();
 	} else {
 		// Helper lambda indicating whether the frame should be presented.
@@ -2388,12 +3085,16 @@ void GFX_EndUpdate(const uint16_t* changedLines)
 			break;
 		case FrameMode::Vfr:
 			if (vfr_should_present()) {
-				sdl.frame.present();
+				present_frame();
 			}
 			break;
 		case FrameMode::ThrottledVfr:
 			maybe_present_throttled(vfr_should_present());
 			break;
+		case FrameMode::JustInTime:
+			schedule_just_in_time();
+			maybe_present_synced(sdl.updating);
+			break;
 		case FrameMode::Unset:
 			break;
 		}
@@ -2402,6 +3103,11 @@ void GFX_EndUpdate(const uint16_t* changedLines)
 	const auto elapsed_us = GetTicksUsSince(start_us);
 	cumulative_time_rendered_us += elapsed_us;
 
+	if (FRAMESTATS_IsEnabled()) {
+		FRAMESTATS_AddStageTime(FrameStage::Upload, upload_us);
+		FRAMESTATS_AddStageTime(FrameStage::Present, elapsed_us - upload_us);
+	}
+
 	// Update "ticks done" with the rendering time
 	constexpr auto MicrosInMillisecond = 1000;
 
@@ -2418,6 +3124,8 @@ void GFX_EndUpdate(const uint16_t* changedLines)
 
 	sdl.updating = false;
 
+	FRAMESTATS_EndFrame();
+
 	FrameMark;
 }
 
@@ -2431,7 +3139,11 @@ static void update_frame_texture([[maybe_unused]] const uint16_t *changedLines)
 	                  sdl.texture.input_surface->pitch);
 }
 
-static std::optional<RenderedImage> get_rendered_output_from_backbuffer()
+// Reads back the rendered output. With 'read_async' set and pixel buffer
+// objects available, the OpenGL output is only queued for reading and nothing
+// is returned; the image gets captured later by finish_rendered_readback().
+static std::optional<RenderedImage> get_rendered_output_from_backbuffer(
+        [[maybe_unused]] const bool read_async = false)
 {
 	// This should be impossible, but maybe the user is hitting the screen
 	// capture hotkey on startup even before DOS comes alive.
@@ -2458,7 +3170,7 @@ static std::optional<RenderedImage> get_rendered_output_from_backbuffer()
 	const auto output_rect_px = canvas_rect_px.Copy().Intersect(
 	        to_rect(sdl.draw_rect_px));
 
-	auto allocate_image = [&]() {
+	auto allocate_image = [&](const bool with_data) {
 		image.params.width              = iroundf(output_rect_px.w);
 		image.params.height             = iroundf(output_rect_px.h);
 		image.params.double_width       = false;
@@ -2476,9 +3188,11 @@ static std::optional<RenderedImage> get_rendered_output_from_backbuffer()
 
 		image.palette_data = nullptr;
 
-		const auto image_size_bytes = check_cast<uint32_t>(
-		        image.params.height * image.pitch);
-		image.image_data = new uint8_t[image_size_bytes];
+		if (with_data) {
+			const auto image_size_bytes = check_cast<uint32_t>(
+			        image.params.height * image.pitch);
+			image.image_data = new uint8_t[image_size_bytes];
+		}
 	};
 
 #if C_OPENGL
@@ -2493,7 +3207,41 @@ static std::optional<RenderedImage> get_rendered_output_from_backbuffer()
 		// memory. This should not cause any slowdowns whatsoever.
 		glPixelStorei(GL_PACK_ALIGNMENT, 1);
 
-		allocate_image();
+		auto& readback = sdl.opengl.readback;
+		if (read_async && readback.is_supported) {
+			// Only set up the image and start the transfer into the
+			// pixel buffer object; finish_rendered_readback() fills
+			// in the pixels once the GPU has caught up
+			allocate_image(false);
+			image.is_flipped_vertically = true;
+
+			if (!readback.buffer) {
+				glGenBuffers(1, &readback.buffer);
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+			glBufferData(GL_PIXEL_PACK_BUFFER,
+			             check_cast<GLsizeiptr>(image.params.height *
+			                                    image.pitch),
+			             nullptr,
+			             GL_STREAM_READ);
+
+			glReadPixels(iroundf(output_rect_px.x),
+			             iroundf(output_rect_px.y),
+			             image.params.width,
+			             image.params.height,
+			             GL_BGR,
+			             GL_UNSIGNED_BYTE,
+			             nullptr);
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			readback.image        = image;
+			readback.is_pending   = true;
+			readback.frames_since = 0;
+			return {};
+		}
+
+		allocate_image(true);
 
 		glReadPixels(iroundf(output_rect_px.x),
 		             iroundf(output_rect_px.y),
@@ -2517,7 +3265,7 @@ static std::optional<RenderedImage> get_rendered_output_from_backbuffer()
 		return {};
 	}
 
-	allocate_image();
+	allocate_image(true);
 
 	// SDL2 pixel formats are a bit weird coming from OpenGL...
 	// You would think SDL_PIXELFORMAT_BGR888 is an alias of
@@ -2569,7 +3317,9 @@ static bool present_frame_texture()
 			}
 		}
 
+		const auto swap_start_us = GetTicksUs();
 		SDL_RenderPresent(sdl.renderer);
+		record_swap_wait(swap_start_us);
 	}
 	render_pacer->Checkpoint();
 	return is_presenting;
@@ -2578,56 +3328,240 @@ static bool present_frame_texture()
 // OpenGL frame-based update and presentation
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 #if C_OPENGL
-static void update_frame_gl(const uint16_t* changedLines)
+// Calls 'func(y, height_px)' for each run of changed lines of a frame of
+// 'total_height_px' lines
+template <typename Function>
+static void for_each_changed_run(const uint16_t* changedLines,
+                                 const int total_height_px, Function&& func)
 {
-	if (changedLines) {
-		const auto framebuf = static_cast<uint8_t *>(sdl.opengl.framebuf);
-		const auto pitch = sdl.opengl.pitch;
-		int y = 0;
-		size_t index = 0;
-		while (y < sdl.draw.render_height_px) {
-			if (!(index & 1)) {
-				y += changedLines[index];
-			} else {
-				const uint8_t *pixels = framebuf + y * pitch;
-				const int height_px = changedLines[index];
-				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y,
-				                sdl.draw.render_width_px, height_px, GL_BGRA_EXT,
-				                GL_UNSIGNED_INT_8_8_8_8_REV, pixels);
-				y += height_px;
-			}
-			index++;
+	int y = 0;
+	size_t index = 0;
+	while (y < total_height_px) {
+		if (!(index & 1)) {
+			y += changedLines[index];
+		} else {
+			const int height_px = changedLines[index];
+			func(y, height_px);
+			y += height_px;
+		}
+		index++;
+	}
+}
+
+// Maps the next buffer of the upload ring and binds it as the unpack buffer,
+// or returns nullptr if the frame has to be uploaded directly
+static uint8_t* map_next_upload_buffer()
+{
+	auto& upload = sdl.opengl.upload;
+	if (!upload.size) {
+		return nullptr;
+	}
+	upload.index = (upload.index + 1) % upload.buffers.size();
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.buffers[upload.index]);
+
+	// Invalidating the whole buffer lets the driver hand out fresh memory
+	// if the GPU is still reading from the previous contents
+	const auto pixels = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+	                                     0,
+	                                     check_cast<GLsizeiptr>(upload.size),
+	                                     GL_MAP_WRITE_BIT |
+	                                             GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (!pixels) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	return static_cast<uint8_t*>(pixels);
+}
+
+// Uploads the runs of changed lines into the bound texture
+static void upload_changed_lines_gl(const uint16_t* changedLines,
+                                    const int width_px, const int height_px,
+                                    const GLenum format, const GLenum type)
+{
+	const auto framebuf = static_cast<uint8_t *>(sdl.opengl.framebuf);
+	const auto pitch = sdl.opengl.pitch;
+
+	// The changed lines are copied into a pixel buffer object, from which
+	// the GPU pulls them asynchronously. The framebuffer itself has to
+	// stay in system memory: the scalers only write the changed pixels of
+	// each line, so it has to keep the previous frame's contents.
+	auto is_buffered = false;
+	if (const auto buffer = map_next_upload_buffer(); buffer) {
+		for_each_changed_run(changedLines, height_px, [&](const int y, const int run_px) {
+			const auto offset = static_cast<size_t>(y) * pitch;
+			memcpy(buffer + offset,
+			       framebuf + offset,
+			       static_cast<size_t>(run_px) * pitch);
+		});
+		// The contents can get lost (e.g., on mode switches), in which
+		// case the frame is uploaded directly
+		is_buffered = (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE);
+		if (!is_buffered) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 		}
+	}
+
+	for_each_changed_run(changedLines, height_px, [&](const int y, const int run_px) {
+		const auto offset = static_cast<size_t>(y) * pitch;
+
+		// With a bound unpack buffer, the pointer is an offset into it
+		const void* pixels = is_buffered
+		                           ? reinterpret_cast<const void*>(offset)
+		                           : framebuf + offset;
+
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y,
+		                width_px, run_px,
+		                format, type, pixels);
+	});
+
+	if (is_buffered) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+}
+
+static void update_indexed_frame_gl(const uint16_t* changedLines)
+{
+	auto& palette = sdl.opengl.palette;
+	if (!changedLines && !palette.is_dirty) {
+		sdl.opengl.actual_frame_count++;
+		return;
+	}
+
+	if (palette.is_dirty) {
+		const auto first = palette.dirty_first;
+		const auto count = palette.dirty_last - first + 1;
+
+		glActiveTexture(GL_TEXTURE1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, first, 0, count, 1,
+		                GL_BGRA_EXT, GL_UNSIGNED_INT_8_8_8_8_REV,
+		                palette.colours.data() + first);
+		glActiveTexture(GL_TEXTURE0);
+		palette.is_dirty = false;
+
+		// A palette change alone changes the whole image, so the frame
+		// is presented like any other updated one
+		sdl.updating = true;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, palette.index_texture);
+	if (changedLines) {
+		// The lines are as wide as their pixel count
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		upload_changed_lines_gl(changedLines,
+		                        palette.width_px,
+		                        palette.height_px,
+		                        GL_LUMINANCE,
+		                        GL_UNSIGNED_BYTE);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+	expand_indexed_frame_gl();
+}
+
+static void update_frame_gl(const uint16_t* changedLines)
+{
+	wait_for_presentation();
+
+	if (sdl.opengl.palette.is_active) {
+		update_indexed_frame_gl(changedLines);
+	} else if (changedLines) {
+		upload_changed_lines_gl(changedLines,
+		                        sdl.draw.render_width_px,
+		                        sdl.draw.render_height_px,
+		                        GL_BGRA_EXT,
+		                        GL_UNSIGNED_INT_8_8_8_8_REV);
 	} else {
 		sdl.opengl.actual_frame_count++;
 	}
 }
 
+static void draw_frame_gl()
+{
+	glClear(GL_COLOR_BUFFER_BIT);
+	if (sdl.opengl.program_object) {
+		glUniform1i(sdl.opengl.ruby.frame_count,
+		            sdl.opengl.actual_frame_count++);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	} else {
+		glCallList(sdl.opengl.displaylist);
+	}
+}
+
+// The rendered output read into the pixel buffer object is mapped this many
+// frames later, by when the GPU has long finished the transfer, so mapping it
+// doesn't stall the pipeline like a direct glReadPixels() would
+constexpr auto ReadbackLatencyFrames = 2;
+
+// Captures the rendered output read back into the pixel buffer object once
+// it's due
+static void finish_rendered_readback()
+{
+	auto& readback = sdl.opengl.readback;
+	if (!readback.is_pending) {
+		return;
+	}
+	if (++readback.frames_since < ReadbackLatencyFrames) {
+		return;
+	}
+	readback.is_pending = false;
+
+	// The output might have been switched in the meantime
+	if (sdl.rendering_backend != RenderingBackend::OpenGl) {
+		return;
+	}
+	wait_for_presentation();
+
+	auto image = readback.image;
+
+	const auto image_size_bytes = check_cast<uint32_t>(image.params.height *
+	                                                   image.pitch);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	const auto pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER,
+	                                     0,
+	                                     check_cast<GLsizeiptr>(image_size_bytes),
+	                                     GL_MAP_READ_BIT);
+	if (pixels) {
+		image.image_data = new uint8_t[image_size_bytes];
+		std::memcpy(image.image_data, pixels, image_size_bytes);
+
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (image.image_data) {
+		CAPTURE_AddPostRenderImage(image);
+	} else {
+		LOG_WARNING("OPENGL: Failed mapping the rendered output");
+	}
+}
+
 static bool present_frame_gl()
 {
 	const auto is_presenting = render_pacer->CanRun();
 	if (is_presenting) {
-		glClear(GL_COLOR_BUFFER_BIT);
-		if (sdl.opengl.program_object) {
-			glUniform1i(sdl.opengl.ruby.frame_count,
-			            sdl.opengl.actual_frame_count++);
-			glDrawArrays(GL_TRIANGLES, 0, 3);
-		} else {
-			glCallList(sdl.opengl.displaylist);
-		}
+		draw_frame_gl();
 
 		if (CAPTURE_IsCapturingPostRenderImage()) {
-			// glReadPixels() implicitly blocks until all pipelined rendering
-			// commands have finished, so we're guaranateed to read the
-			// contents of the up-to-date backbuffer here right before the
-			// buffer swap.
-			const auto image = get_rendered_output_from_backbuffer();
-			if (image) {
-				CAPTURE_AddPostRenderImage(*image);
+			// The frame is read back asynchronously if possible, and
+			// only once while the capture request is pending.
+			// Otherwise glReadPixels() implicitly blocks until all
+			// pipelined rendering commands have finished, so we're
+			// guaranateed to read the contents of the up-to-date
+			// backbuffer here right before the buffer swap.
+			if (!sdl.opengl.readback.is_pending) {
+				constexpr auto ReadAsync = true;
+
+				const auto image = get_rendered_output_from_backbuffer(
+				        ReadAsync);
+				if (image) {
+					CAPTURE_AddPostRenderImage(*image);
+				}
 			}
 		}
 
+		const auto swap_start_us = GetTicksUs();
 		SDL_GL_SwapWindow(sdl.window);
+		record_swap_wait(swap_start_us);
 	}
 	render_pacer->Checkpoint();
 	return is_presenting;
@@ -2698,6 +3632,8 @@ static void clean_up_sdl_resources()
 
 static void GUI_ShutDown(Section *)
 {
+	stop_presentation_thread();
+
 	GFX_Stop();
 
 	if (sdl.draw.callback)
@@ -3246,6 +4182,37 @@ static void set_output(Section* sec, const bool wants_aspect_ratio_correction)
 			         glUniform2f && glUniform1i && glUseProgram &&
 			         glVertexAttribPointer);
 
+			glActiveTexture = (PFNGLACTIVETEXTUREPROC)SDL_GL_GetProcAddress(
+			        "glActiveTexture");
+			glBindFramebuffer = (PFNGLBINDFRAMEBUFFERPROC)SDL_GL_GetProcAddress(
+			        "glBindFramebuffer");
+			glCheckFramebufferStatus = (PFNGLCHECKFRAMEBUFFERSTATUSPROC)
+			        SDL_GL_GetProcAddress("glCheckFramebufferStatus");
+			glDeleteFramebuffers = (PFNGLDELETEFRAMEBUFFERSPROC)
+			        SDL_GL_GetProcAddress("glDeleteFramebuffers");
+			glFramebufferTexture2D = (PFNGLFRAMEBUFFERTEXTURE2DPROC)
+			        SDL_GL_GetProcAddress("glFramebufferTexture2D");
+			glGenFramebuffers = (PFNGLGENFRAMEBUFFERSPROC)SDL_GL_GetProcAddress(
+			        "glGenFramebuffers");
+			glBindBuffer = (PFNGLBINDBUFFERPROC)SDL_GL_GetProcAddress(
+			        "glBindBuffer");
+			glBufferData = (PFNGLBUFFERDATAPROC)SDL_GL_GetProcAddress(
+			        "glBufferData");
+			glDeleteBuffers = (PFNGLDELETEBUFFERSPROC)SDL_GL_GetProcAddress(
+			        "glDeleteBuffers");
+			glGenBuffers = (PFNGLGENBUFFERSPROC)SDL_GL_GetProcAddress(
+			        "glGenBuffers");
+			glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC)SDL_GL_GetProcAddress(
+			        "glMapBufferRange");
+			glUnmapBuffer = (PFNGLUNMAPBUFFERPROC)SDL_GL_GetProcAddress(
+			        "glUnmapBuffer");
+			glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)
+			        SDL_GL_GetProcAddress("glGetProgramBinary");
+			glProgramBinary = (PFNGLPROGRAMBINARYPROC)SDL_GL_GetProcAddress(
+			        "glProgramBinary");
+			glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)
+			        SDL_GL_GetProcAddress("glProgramParameteri");
+
 			sdl.opengl.framebuf = nullptr;
 			sdl.opengl.texture = 0;
 			sdl.opengl.displaylist = 0;
@@ -3254,6 +4221,7 @@ static void set_output(Section* sec, const bool wants_aspect_ratio_correction)
 			const auto gl_version_string = safe_gl_get_string(GL_VERSION,
 			                                                  "0.0.0");
 			const int gl_version_major = gl_version_string[0] - '0';
+			const int gl_version_minor = gl_version_string[2] - '0';
 
 			sdl.opengl.npot_textures_supported =
 			        gl_version_major >= 2 ||
@@ -3264,6 +4232,30 @@ static void set_output(Section* sec, const bool wants_aspect_ratio_correction)
 			                                     ? "supported"
 			                                     : "not supported";
 
+			// The palette lookup renders into the frame's texture
+			// through a framebuffer object
+			const auto has_framebuffer_objects =
+			        gl_version_major >= 3 ||
+			        SDL_GL_ExtensionSupported("GL_ARB_framebuffer_object");
+
+			sdl.opengl.palette.is_supported =
+			        sdl.opengl.use_shader && has_framebuffer_objects &&
+			        glActiveTexture && glBindFramebuffer &&
+			        glCheckFramebufferStatus && glDeleteFramebuffers &&
+			        glFramebufferTexture2D && glGenFramebuffers;
+
+			const auto has_pixel_buffer_objects =
+			        gl_version_major >= 3 ||
+			        (SDL_GL_ExtensionSupported("GL_ARB_pixel_buffer_object") &&
+			         SDL_GL_ExtensionSupported("GL_ARB_map_buffer_range"));
+
+			sdl.opengl.upload.is_supported =
+			        has_pixel_buffer_objects && glBindBuffer &&
+			        glBufferData && glDeleteBuffers && glGenBuffers &&
+			        glMapBufferRange && glUnmapBuffer;
+
+			sdl.opengl.readback.is_supported = sdl.opengl.upload.is_supported;
+
 			LOG_INFO("OPENGL: Vendor: %s",
 			         safe_gl_get_string(GL_VENDOR, "unknown"));
 
@@ -3275,6 +4267,25 @@ static void set_output(Section* sec, const bool wants_aspect_ratio_correction)
 
 			LOG_INFO("OPENGL: NPOT textures %s",
 			         npot_support_msg.c_str());
+
+			LOG_INFO("OPENGL: Pixel buffer objects %s",
+			         sdl.opengl.upload.is_supported ? "supported"
+			                                        : "not supported");
+
+			const auto has_program_binaries =
+			        gl_version_major > 4 ||
+			        (gl_version_major == 4 && gl_version_minor >= 1) ||
+			        SDL_GL_ExtensionSupported("GL_ARB_get_program_binary");
+
+			GLint num_binary_formats = 0;
+			if (has_program_binaries) {
+				glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS,
+				              &num_binary_formats);
+			}
+			setup_program_binary_cache(num_binary_formats > 0 &&
+			                           sdl.opengl.use_shader &&
+			                           glGetProgramBinary &&
+			                           glProgramBinary && glProgramParameteri);
 		}
 	} /* OPENGL is requested end */
 #endif    // OPENGL
@@ -3359,6 +4370,7 @@ static void read_gui_config(Section* sec)
 	sdl.updating        = false;
 	sdl.resizing_window = false;
 	sdl.wait_on_error   = section->Get_bool("waitonerror");
+	sdl.headless        = control->arguments.headless;
 
 	sdl.desktop.fullscreen = control->arguments.fullscreen ||
 	                         section->Get_bool("fullscreen");
@@ -3367,6 +4379,22 @@ static void read_gui_config(Section* sec)
 	set_priority_levels(priority_conf->Get_string("active"),
 	                    priority_conf->Get_string("inactive"));
 
+	const auto affinity_conf = section->GetMultiVal("thread_affinity")->GetSection();
+	const auto thread_priority_conf =
+	        section->GetMultiVal("thread_priority")->GetSection();
+
+	HOST_THREADS_Configure(HostThreadGroup::Emulation,
+	                       affinity_conf->Get_string("emulation"),
+	                       "auto");
+	HOST_THREADS_Configure(HostThreadGroup::Audio,
+	                       affinity_conf->Get_string("audio"),
+	                       thread_priority_conf->Get_string("audio"));
+	HOST_THREADS_Configure(HostThreadGroup::Worker,
+	                       affinity_conf->Get_string("workers"),
+	                       thread_priority_conf->Get_string("workers"));
+
+	HOST_THREADS_ApplyToCurrentThread(HostThreadGroup::Emulation);
+
 	sdl.pause_when_inactive = section->Get_bool("pause_when_inactive");
 
 	sdl.mute_when_inactive = section->Get_bool("mute_when_inactive") ||
@@ -3420,6 +4448,10 @@ static void read_gui_config(Section* sec)
 
 	sdl.vsync.skip_us = section->Get_int("vsync_skip");
 
+	sdl.frame.threaded_presentation = section->Get_bool("threaded_presentation");
+
+	FRAMESTATS_Init(section->Get_string("frame_stats"));
+
 	render_pacer = std::make_unique<Pacer>("Render",
 	                                       sdl.vsync.skip_us,
 	                                       Pacer::LogLevel::TIMEOUTS);
@@ -3440,6 +4472,8 @@ static void read_gui_config(Section* sec)
 		sdl.frame.desired_mode = FrameMode::Cfr;
 	else if (presentation_mode_pref == "vfr")
 		sdl.frame.desired_mode = FrameMode::Vfr;
+	else if (presentation_mode_pref == "jit")
+		sdl.frame.desired_mode = FrameMode::JustInTime;
 	else {
 		sdl.frame.desired_mode = FrameMode::Unset;
 		LOG_WARNING("SDL: Invalid 'presentation_mode' setting: '%s', using 'auto'",
@@ -3507,12 +4541,36 @@ static void read_config(Section* sec)
 	TITLEBAR_ReadConfig(*conf);
 }
 
+// High polling rate mice deliver several motion events per poll; they are
+// summed up and passed on as one, ahead of whatever event follows them so
+// that button presses are reported at the right position
+static struct {
+	bool is_pending = false;
+	float x_rel     = 0.0f;
+	float y_rel     = 0.0f;
+	int32_t x_abs   = 0;
+	int32_t y_abs   = 0;
+} pending_motion = {};
+
 static void handle_mouse_motion(SDL_MouseMotionEvent* motion)
 {
-	MOUSE_EventMoved(static_cast<float>(motion->xrel),
-	                 static_cast<float>(motion->yrel),
-	                 check_cast<int32_t>(motion->x),
-	                 check_cast<int32_t>(motion->y));
+	pending_motion.is_pending = true;
+	pending_motion.x_rel += static_cast<float>(motion->xrel);
+	pending_motion.y_rel += static_cast<float>(motion->yrel);
+	pending_motion.x_abs = check_cast<int32_t>(motion->x);
+	pending_motion.y_abs = check_cast<int32_t>(motion->y);
+}
+
+static void flush_mouse_motion()
+{
+	if (!pending_motion.is_pending) {
+		return;
+	}
+	MOUSE_EventMoved(pending_motion.x_rel,
+	                 pending_motion.y_rel,
+	                 pending_motion.x_abs,
+	                 pending_motion.y_abs);
+	pending_motion = {};
 }
 
 static void handle_mouse_wheel(SDL_MouseWheelEvent* wheel)
@@ -3538,10 +4596,72 @@ static void handle_mouse_button(SDL_MouseButtonEvent* button)
 	notify_button(button->button, button->state == SDL_PRESSED);
 }
 
+// Key events are polled between emulated ticks; when the emulation runs
+// behind the host clock (catching up after a stall, e.g., a blocking
+// present), a whole burst of ticks would otherwise see all keys that
+// arrived meanwhile at once, and a quick tap could be pressed and released
+// within the same emulated millisecond. Such events are held back, and
+// dispatched at the emulated time matching when they arrived on the host.
+struct DelayedKeyEvent {
+	SDL_Event event  = {};
+	double due_index = 0.0;
+};
+
+static std::deque<DelayedKeyEvent> delayed_key_events = {};
+
+static void delayed_key_events_handler(uint32_t val);
+
+static void dispatch_delayed_key_events(const bool dispatch_all = false)
+{
+	if (delayed_key_events.empty()) {
+		return;
+	}
+	while (!delayed_key_events.empty() &&
+	       (dispatch_all || delayed_key_events.front().due_index <= PIC_FullIndex())) {
+		auto event = delayed_key_events.front().event;
+		delayed_key_events.pop_front();
+		MAPPER_CheckEvent(&event);
+	}
+
+	PIC_RemoveEvents(delayed_key_events_handler);
+	if (!delayed_key_events.empty()) {
+		const auto delay = delayed_key_events.front().due_index - PIC_FullIndex();
+		PIC_AddEvent(delayed_key_events_handler, std::max(delay, 0.0));
+	}
+}
+
+static void delayed_key_events_handler(uint32_t /*val*/)
+{
+	dispatch_delayed_key_events();
+}
+
+static void handle_key_event(SDL_Event& event)
+{
+	// How long ago the event arrived, and how far the emulation lags
+	// behind the host, both in milliseconds
+	const auto age_ms = static_cast<int64_t>(SDL_GetTicks() - event.key.timestamp);
+	const auto lag_ms = DOSBOX_GetTicksRemaining();
+
+	const auto delay_ms = std::max(lag_ms - age_ms, static_cast<int64_t>(0));
+	if (delay_ms == 0 && delayed_key_events.empty()) {
+		MAPPER_CheckEvent(&event);
+		return;
+	}
+
+	// Never overtake the events already waiting
+	auto due_index = PIC_FullIndex() + static_cast<double>(delay_ms);
+	if (!delayed_key_events.empty()) {
+		due_index = std::max(due_index, delayed_key_events.back().due_index);
+	}
+	delayed_key_events.push_back({event, due_index});
+	dispatch_delayed_key_events();
+}
+
 void GFX_LosingFocus()
 {
 	sdl.laltstate = SDL_KEYUP;
 	sdl.raltstate = SDL_KEYUP;
+	dispatch_delayed_key_events(true);
 	MAPPER_LosingFocus();
 }
 
@@ -3568,6 +4688,8 @@ void GFX_RegenerateWindow(Section *sec) {
 
 static void handle_video_resize(int width, int height)
 {
+	wait_for_presentation();
+
 	/* Maybe a screen rotation has just occurred, so we simply resize.
 	There may be a different cause for a forced resized, though.    */
 	if (sdl.desktop.full.display_res && sdl.desktop.fullscreen) {
@@ -3721,6 +4843,9 @@ bool GFX_Events()
 		MAPPER_UpdateJoysticks();
 	}
 #endif
+	// Catch up on any held back key events the PIC didn't get to yet
+	dispatch_delayed_key_events();
+
 	while (SDL_PollEvent(&event)) {
 #if C_DEBUG
 		if (is_debugger_event(event)) {
@@ -3728,6 +4853,12 @@ bool GFX_Events()
 			continue;
 		}
 #endif
+		if (event.type == SDL_MOUSEMOTION) {
+			handle_mouse_motion(&event.motion);
+			continue;
+		}
+		flush_mouse_motion();
+
 		if (is_user_event(event)) {
 			handle_user_event(event);
 			continue;
@@ -3866,6 +4997,7 @@ bool GFX_Events()
 				//               event.window.data1,
 				//               event.window.data2);
 				if (sdl.rendering_backend == RenderingBackend::OpenGl) {
+					wait_for_presentation();
 					glViewport(sdl.draw_rect_px.x,
 					           sdl.draw_rect_px.y,
 					           sdl.draw_rect_px.w,
@@ -3902,6 +5034,7 @@ bool GFX_Events()
 				}
 #	if C_OPENGL
 				if (sdl.rendering_backend == RenderingBackend::OpenGl) {
+					wait_for_presentation();
 					glViewport(sdl.draw_rect_px.x,
 					           sdl.draw_rect_px.y,
 					           sdl.draw_rect_px.w,
@@ -4018,7 +5151,6 @@ bool GFX_Events()
 			}
 			break; // end of SDL_WINDOWEVENT
 
-		case SDL_MOUSEMOTION: handle_mouse_motion(&event.motion); break;
 		case SDL_MOUSEWHEEL: handle_mouse_wheel(&event.wheel); break;
 		case SDL_MOUSEBUTTONDOWN:
 		case SDL_MOUSEBUTTONUP: handle_mouse_button(&event.button); break;
@@ -4054,9 +5186,15 @@ bool GFX_Events()
 			}
 			[[fallthrough]];
 #endif
-		default: MAPPER_CheckEvent(&event);
+		default:
+			if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+				handle_key_event(event);
+			} else {
+				MAPPER_CheckEvent(&event);
+			}
 		}
 	}
+	flush_mouse_motion();
 	return !shutdown_requested;
 }
 
@@ -4169,6 +5307,21 @@ static void messages_add_command_line()
 	        "\n"
 	        "  --exit                   Exit after running '-c <command>'s and [autoexec] sections.\n"
 	        "\n"
+	        "  --headless               Run without a window and sound output, as fast as\n"
+	        "                           possible. Meant for automated test runs; combine it\n"
+	        "                           with --exit or --time-limit.\n"
+	        "\n"
+	        "  --trace-startup          Log the time taken by each initialisation step.\n"
+	        "\n"
+	        "  --time-limit <seconds>   Exit after the given amount of emulated time.\n"
+	        "\n"
+	        "  --record <file>          Record the keyboard and mouse input, the cycles and\n"
+	        "                           the clock to the file, to reproduce the session.\n"
+	        "\n"
+	        "  --replay <file>          Replay a session recorded with --record, ignoring\n"
+	        "                           the host input; exits where the recording ended.\n"
+	        "                           Combine it with --headless for benchmark runs.\n"
+	        "\n"
 	        "  --startmapper            Run the mapper GUI.\n"
 	        "\n"
 	        "  --erasemapper            Delete the default mapper file.\n"
@@ -4349,14 +5502,33 @@ static void config_add_sdl()
 	        "at 70 Hz. 0 disables this and will always render (default).");
 	pint->SetMinMax(0, 14000);
 
+	pbool = sdl_sec->Add_bool("threaded_presentation", on_start, true);
+	pbool->Set_help(
+	        "Present the frames on a separate thread with the 'opengl' output, so waiting\n"
+	        "for vsync or the video driver doesn't stall the emulation (enabled by default).\n"
+	        "The 'texture' outputs always present on the emulation thread.");
+
 	pstring = sdl_sec->Add_string("presentation_mode", always, "auto");
 	pstring->Set_help(
 	        "Select the frame presentation mode:\n"
 	        "  auto:  Intelligently time and drop frames to prevent emulation stalls,\n"
 	        "         based on host and DOS frame rates (default).\n"
 	        "  cfr:   Always present DOS frames at a constant frame rate.\n"
-	        "  vfr:   Always present changed DOS frames at a variable frame rate.");
-	pstring->Set_values({"auto", "cfr", "vfr"});
+	        "  vfr:   Always present changed DOS frames at a variable frame rate.\n"
+	        "  jit:   Like 'cfr', but time the emulation so the frames are completed just\n"
+	        "         before the display's vertical blank, trimming up to a frame of\n"
+	        "         latency. Needs vsync and a display refresh rate matching the DOS\n"
+	        "         rate, otherwise 'cfr' is used.");
+	pstring->Set_values({"auto", "cfr", "vfr", "jit"});
+
+	pstring = sdl_sec->Add_string("frame_stats", on_start, "off");
+	pstring->Set_help(
+	        "Measure where the time of each frame goes: emulation, rendering, uploading\n"
+	        "and presenting the frame, and the audio buffer level ('off' by default).\n"
+	        "  off:     Don't measure the frames (default).\n"
+	        "  log:     Log a summary of the frames every second.\n"
+	        "  <path>:  Also write every frame's measurements to this CSV file,\n"
+	        "           e.g., 'frame_stats.csv'.");
 
 	auto pmulti = sdl_sec->AddMultiVal("capture_mouse", deprecated, ",");
 	pmulti->Set_help("Moved to [mouse] section and renamed to 'mouse_capture'.");
@@ -4383,6 +5555,37 @@ static void config_add_sdl()
 	psection->Add_string("inactive", always, "auto")
 	        ->Set_values({"auto", "lowest", "lower", "normal", "higher", "highest"});
 
+	pmulti = sdl_sec->AddMultiVal("thread_affinity", on_start, " ");
+	pmulti->SetValue("auto auto auto");
+	pmulti->Set_help(
+	        "Host CPU cores to run the emulation, audio and worker threads on,\n"
+	        "respectively ('auto auto auto' by default). Each value is either 'auto' to\n"
+	        "let the host operating system pick the cores, or a comma-separated list of\n"
+	        "core numbers and ranges, e.g., '0', '2,3' or '4-7'. Pinning co-located\n"
+	        "instances to their own cores stops them from interfering with each other.\n"
+	        "The audio threads are the mixer's and the MIDI, OPL and CD audio renderers;\n"
+	        "the workers are the Voodoo, capture and decoder threads.\n"
+	        "Not supported on macOS.");
+
+	psection = pmulti->GetSection();
+	psection->Add_string("emulation", on_start, "auto");
+	psection->Add_string("audio", on_start, "auto");
+	psection->Add_string("workers", on_start, "auto");
+
+	pmulti = sdl_sec->AddMultiVal("thread_priority", on_start, " ");
+	pmulti->SetValue("auto auto");
+	pmulti->Set_help(
+	        "Priority levels of the audio and worker threads, respectively, relative to\n"
+	        "the emulation thread set by 'priority' ('auto auto' by default).\n"
+	        "'auto' lets the host operating system manage the priority. Raising the\n"
+	        "priority above 'normal' may need elevated rights.");
+
+	psection = pmulti->GetSection();
+	psection->Add_string("audio", on_start, "auto")
+	        ->Set_values({"auto", "lowest", "lower", "normal", "higher", "highest"});
+	psection->Add_string("workers", on_start, "auto")
+	        ->Set_values({"auto", "lowest", "lower", "normal", "higher", "highest"});
+
 	pbool = sdl_sec->Add_bool("mute_when_inactive", on_start, false);
 	pbool->Set_help("Mute the sound when the window is inactive (disabled by default).");
 
@@ -4648,6 +5851,7 @@ int sdl_main(int argc, char* argv[])
 	}
 
 	loguru::init(argc, argv);
+	LOGGING_StartAsyncWriter();
 
 	LOG_MSG("%s version %s", DOSBOX_PROJECT_NAME, DOSBOX_GetDetailedVersion());
 	LOG_MSG("---");
@@ -4806,6 +6010,13 @@ int sdl_main(int argc, char* argv[])
 			return err;
 		}
 
+		// Headless runs use SDL's dummy drivers, which don't open a
+		// window or an audio device
+		if (arguments->headless) {
+			SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+			SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+		}
+
 		// Timer is needed for title bar animations
 		if (SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
 			E_Exit("SDL: Can't init SDL %s", SDL_GetError());
@@ -4830,6 +6041,16 @@ int sdl_main(int argc, char* argv[])
 		        SDL_GetCurrentVideoDriver(),
 		        SDL_GetCurrentAudioDriver());
 
+		// The dummy video driver has no OpenGL, and there's nothing to
+		// present anyway. Put these first, so users can still override
+		// them with their own --set options.
+		if (arguments->headless) {
+			arguments->set.insert(arguments->set.begin(),
+			                      {"nosound=on",
+			                       "output=texture",
+			                       "texture_renderer=software"});
+		}
+
 		for (auto line : arguments->set) {
 			trim(line);
 
@@ -4923,6 +6144,8 @@ int sdl_main(int argc, char* argv[])
 		// Run the machine until shutdown
 		control->StartUp();
 
+		HOST_MEMORY_LogUsage();
+
 		// Shutdown and release
 		control.reset();
 
@@ -4965,6 +6188,8 @@ int sdl_main(int argc, char* argv[])
 	// cleanup order. Happens with SDL_VIDEODRIVER=wayland as of SDL 2.0.12.
 	QuitSDL();
 
+	LOGGING_StopAsyncWriter();
+
 	return return_code;
 }
 
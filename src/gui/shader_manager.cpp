@@ -139,6 +139,18 @@ void ShaderManager::LoadShader(const std::string& shader_name)
 {
 	auto new_shader_name = shader_name;
 
+	// Switching back to a shader used before (e.g., when the adaptive CRT
+	// shaders follow the video mode changes) doesn't need reading and
+	// parsing it again
+	if (const auto cached = loaded_shaders.find(new_shader_name);
+	    cached != loaded_shaders.end()) {
+		current_shader.source = cached->second.source;
+		current_shader.info   = {new_shader_name,
+		                         cached->second.settings,
+		                         IsAdaptive(new_shader_name)};
+		return;
+	}
+
 	if (!ReadShaderSource(new_shader_name, current_shader.source)) {
 		current_shader.source.clear();
 
@@ -162,18 +174,21 @@ void ShaderManager::LoadShader(const std::string& shader_name)
 	const auto settings = ParseShaderSettings(new_shader_name,
 	                                          current_shader.source);
 
-	const bool is_adaptive = [&] {
-		if (mode == ShaderMode::Single) {
-			return false;
+	loaded_shaders[new_shader_name] = {current_shader.source, settings};
 
-		} else {
-			// This will turn off vertical integer scaling for the
-			// 'sharp' shader in 'integer_scaling = auto' mode
-			return (new_shader_name != SharpShaderName);
-		}
-	}();
+	current_shader.info = {new_shader_name, settings, IsAdaptive(new_shader_name)};
+}
 
-	current_shader.info = {new_shader_name, settings, is_adaptive};
+bool ShaderManager::IsAdaptive(const std::string& shader_name) const
+{
+	if (mode == ShaderMode::Single) {
+		return false;
+
+	} else {
+		// This will turn off vertical integer scaling for the
+		// 'sharp' shader in 'integer_scaling = auto' mode
+		return (shader_name != SharpShaderName);
+	}
 }
 
 const ShaderInfo& ShaderManager::GetCurrentShaderInfo() const
@@ -188,6 +203,9 @@ const std::string& ShaderManager::GetCurrentShaderSource() const
 
 void ShaderManager::ReloadCurrentShader()
 {
+	// Pick up the changes made to the shader file
+	loaded_shaders.erase(current_shader.info.name);
+
 	LoadShader(current_shader.info.name);
 	LOG_MSG("RENDER: Reloaded current shader '%s'",
 	        current_shader.info.name.c_str());
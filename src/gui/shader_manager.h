@@ -21,6 +21,7 @@
 #ifndef DOSBOX_SHADER_MANAGER_H
 #define DOSBOX_SHADER_MANAGER_H
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -168,6 +169,8 @@ private:
 	ShaderSettings ParseShaderSettings(const std::string& shader_name,
 	                                   const std::string& source) const;
 
+	bool IsAdaptive(const std::string& shader_name) const;
+
 	void MaybeAutoSwitchShader();
 
 	std::string FindShaderAutoGraphicsStandard() const;
@@ -188,6 +191,13 @@ private:
 		std::string source = {};
 	} current_shader = {};
 
+	// The shaders loaded so far, keyed by their name
+	struct LoadedShader {
+		std::string source      = {};
+		ShaderSettings settings = {};
+	};
+	std::map<std::string, LoadedShader> loaded_shaders = {};
+
 	std::string shader_name_from_config = {};
 
 	int pixels_per_scanline                   = 1;
@@ -28,11 +28,10 @@
 
 CHECK_NARROWING();
 
-Disney::Disney() : LptDac(ChannelName::DisneySoundSourceDac, UseMixerRate)
-{
-	// Prime the FIFO with a single silent sample
-	fifo.emplace(data_reg);
-}
+Disney::Disney()
+        : LptDac(ChannelName::DisneySoundSourceDac, UseMixerRate, {},
+                 DacOutput::Clocked)
+{}
 
 void Disney::BindToPort(const io_port_t lpt_port)
 {
@@ -79,18 +78,11 @@ void Disney::ConfigureFilters(const FilterState state)
 
 // Eight bit data sent to the D/A convener is loaded into a 16 level FIFO. Data
 // is clocked from this FIFO at the fixed rate of 7 kHz +/- 5%.
-AudioFrame Disney::Render()
-{
-	assert(fifo.size());
-	const float sample = lut_u8to16[fifo.front()];
-	if (fifo.size() > 1)
-		fifo.pop();
-	return {sample, sample};
-}
-
-bool Disney::IsFifoFull() const
+bool Disney::IsFifoFull()
 {
-	return fifo.size() >= MaxFifoSize;
+	// The FIFO also holds the sample being output
+	RenderUpToNow();
+	return NumFifoFrames() + 1 >= MaxFifoSize;
 }
 
 void Disney::WriteData(const io_port_t, const io_val_t data, const io_width_t)
@@ -107,8 +99,6 @@ uint8_t Disney::ReadStatus(const io_port_t, const io_width_t)
 
 void Disney::WriteControl(const io_port_t, const io_val_t value, const io_width_t)
 {
-	RenderUpToNow();
-
 	const auto new_control = LptControlRegister{check_cast<uint8_t>(value)};
 
 	// The rising edge of the pulse on Pin 17 from the printer interface
@@ -119,12 +109,7 @@ void Disney::WriteControl(const io_port_t, const io_val_t value, const io_width_
 
 	if (!control_reg.select && new_control.select)
 		if (!IsFifoFull())
-			fifo.emplace(data_reg);
+			QueueFrame(lut_u8to16[data_reg]);
 
 	control_reg.data = new_control.data;
 }
-
-Disney::~Disney()
-{
-	fifo = {};
-}
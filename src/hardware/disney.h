@@ -21,8 +21,6 @@
 
 #include "dosbox.h"
 
-#include <queue>
-
 #include "inout.h"
 #include "lpt_dac.h"
 #include "mixer.h"
@@ -30,16 +28,12 @@
 class Disney final : public LptDac {
 public:
 	Disney();
-	~Disney() final;
 
 	void BindToPort(const io_port_t lpt_port) final;
 	void ConfigureFilters(const FilterState state) final;
 
-protected:
-	AudioFrame Render() final;
-
 private:
-	bool IsFifoFull() const;
+	bool IsFifoFull();
 	void WriteData(const io_port_t, const io_val_t value, const io_width_t);
 	uint8_t ReadStatus(const io_port_t, const io_width_t);
 	void WriteControl(const io_port_t, const io_val_t value, const io_width_t);
@@ -47,9 +41,6 @@ private:
 	// The DSS is an LPT DAC with a 16-level FIFO running at 7kHz
 	static constexpr auto DisneySampleRateHz = 7000;
 	static constexpr auto MaxFifoSize        = 16;
-
-	// Managed objects
-	std::queue<uint8_t> fifo = {};
 };
 
 #endif
@@ -53,6 +53,33 @@ static void UpdateEMSMapping()
 	}
 }
 
+// Translates the DMA address into a physical memory address by mapping its
+// 4 KB page through the first megabyte's (and the EMS board's) page tables
+static PhysPt map_dma_address(const PhysPt spage, const PhysPt mem_address)
+{
+	// Find the right EMS page that contains the current address
+	auto page = (spage >> 12) + (mem_address >> 12);
+	if (page < EMM_PAGEFRAME4K) {
+		page = paging.firstmb[page];
+	} else if (page < EMM_PAGEFRAME4K + 0x10) {
+		page = ems_board_mapping[page];
+	} else if (page < LINK_START) {
+		page = paging.firstmb[page];
+	}
+	return check_cast<PhysPt>(page * dos_pagesize +
+	                          (mem_address & (dos_pagesize - 1)));
+}
+
+// Returns the host memory backing the physical address, or nullptr if the
+// page lies past the end of the guest's RAM
+static uint8_t* get_dma_host_ptr(const PhysPt phys_address)
+{
+	if ((phys_address / dos_pagesize) >= MEM_TotalPages()) {
+		return nullptr;
+	}
+	return MemBase + phys_address;
+}
+
 // Generic function to read or write a block of data to or from memory.
 // Don't use this directly; call two helpers: DMA_BlockRead or DMA_BlockWrite
 static void perform_dma_io(const DMA_DIRECTION direction, const PhysPt spage,
@@ -61,8 +88,6 @@ static void perform_dma_io(const DMA_DIRECTION direction, const PhysPt spage,
 {
 	assert(is_dma16 == 0 || is_dma16 == 1);
 
-	const auto highpart_addr_page = spage >> 12;
-
 	// Maybe move the mem_address into the 16-bit range
 	mem_address <<= is_dma16;
 
@@ -72,37 +97,28 @@ static void perform_dma_io(const DMA_DIRECTION direction, const PhysPt spage,
 	// Convert from DMA 'words' to actual bytes, no greater than 64 KB
 	auto remaining_bytes = check_cast<uint16_t>(num_words << is_dma16);
 	do {
-		// Find the right EMS page that contains the current address
-		auto page = highpart_addr_page + (mem_address >> 12);
-		if (page < EMM_PAGEFRAME4K) {
-			page = paging.firstmb[page];
-		} else if (page < EMM_PAGEFRAME4K + 0x10) {
-			page = ems_board_mapping[page];
-		} else if (page < LINK_START) {
-			page = paging.firstmb[page];
-		}
-
-		// Calculate the offset within the page
 		const auto pos_in_page       = mem_address & (dos_pagesize - 1);
 		const auto bytes_to_page_end = check_cast<uint16_t>(
 		        dos_pagesize - pos_in_page);
-		const auto chunk_start = check_cast<PhysPt>(page * dos_pagesize +
-		                                            pos_in_page);
 
 		// Determine how many bytes to transfer within this page
 		const auto chunk_bytes = std::min(remaining_bytes, bytes_to_page_end);
 
-		// Copy the data from the page address into the data pointer
+		// The pages are contiguous in host memory, so each chunk is a
+		// single copy. Reads from unbacked memory return an open bus
+		// and writes to it are dropped.
+		const auto host_pt = get_dma_host_ptr(
+		        map_dma_address(spage, mem_address));
+
 		if (direction == DMA_DIRECTION::READ) {
-			for (auto i = 0; i < chunk_bytes; ++i) {
-				data_pt[i] = phys_readb(chunk_start + i);
+			if (host_pt) {
+				memcpy(data_pt, host_pt, chunk_bytes);
+			} else {
+				memset(data_pt, 0xff, chunk_bytes);
 			}
-		}
-
-		// Copy the data from the data pointer into the page address
-		else if (direction == DMA_DIRECTION::WRITE) {
-			for (auto i = 0; i < chunk_bytes; ++i) {
-				phys_writeb(chunk_start + i, data_pt[i]);
+		} else if (direction == DMA_DIRECTION::WRITE) {
+			if (host_pt) {
+				memcpy(host_pt, data_pt, chunk_bytes);
 			}
 		}
 
@@ -431,6 +447,50 @@ size_t DmaChannel::Write(const size_t words, uint8_t* const src_buffer)
 	return ReadOrWrite(DMA_DIRECTION::WRITE, words, src_buffer);
 }
 
+size_t DmaChannel::Skip(const size_t words)
+{
+	return ReadOrWrite(DMA_DIRECTION::READ, words, nullptr);
+}
+
+std::span<const uint8_t> DmaChannel::PeekRead(const size_t words) const
+{
+	const auto want_words = std::min(words, static_cast<size_t>(curr_count) + 1);
+	if (want_words == 0) {
+		return {};
+	}
+	auto remaining_bytes = want_words << is_16bit;
+	auto mem_address     = static_cast<PhysPt>(
+	        (curr_addr & dma_wrapping) << is_16bit);
+
+	const uint8_t* const start = get_dma_host_ptr(
+	        map_dma_address(page_base, mem_address));
+	if (!start) {
+		return {};
+	}
+
+	// Extend the window for as long as the mapped pages follow each other
+	// in host memory, which they do unless EMS or UMB mappings interfere
+	size_t contiguous_bytes = 0;
+	while (remaining_bytes) {
+		const auto host_pt = get_dma_host_ptr(
+		        map_dma_address(page_base, mem_address));
+		if (host_pt != start + contiguous_bytes) {
+			break;
+		}
+		const auto pos_in_page = mem_address & (dos_pagesize - 1);
+		const auto chunk_bytes = std::min(remaining_bytes,
+		                                  static_cast<size_t>(dos_pagesize -
+		                                                      pos_in_page));
+		mem_address += check_cast<PhysPt>(chunk_bytes);
+		contiguous_bytes += chunk_bytes;
+		remaining_bytes -= chunk_bytes;
+	}
+
+	// Only hand out whole words
+	contiguous_bytes &= ~static_cast<size_t>(is_16bit);
+	return {start, contiguous_bytes};
+}
+
 size_t DmaChannel::ReadOrWrite(const DMA_DIRECTION direction,
                                const size_t words, uint8_t* const buffer)
 {
@@ -443,13 +503,17 @@ size_t DmaChannel::ReadOrWrite(const DMA_DIRECTION direction,
 again:
 	Bitu left = (curr_count + 1);
 	if (want < left) {
-		perform_dma_io(direction, page_base, curr_addr, curr_buffer, want, is_16bit);
+		if (curr_buffer) {
+			perform_dma_io(direction, page_base, curr_addr, curr_buffer, want, is_16bit);
+		}
 		done += want;
 		curr_addr += want;
 		curr_count -= want;
 	} else {
-		perform_dma_io(direction, page_base, curr_addr, curr_buffer, left, is_16bit);
-		curr_buffer += left << is_16bit;
+		if (curr_buffer) {
+			perform_dma_io(direction, page_base, curr_addr, curr_buffer, left, is_16bit);
+			curr_buffer += left << is_16bit;
+		}
 		want -= left;
 		done += left;
 		ReachedTerminalCount();
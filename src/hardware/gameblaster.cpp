@@ -114,7 +114,8 @@ void GameBlaster::Open(const int port_choice, const std::string& card_choice,
 	                            ChannelFeature::Stereo,
 	                            ChannelFeature::ReverbSend,
 	                            ChannelFeature::ChorusSend,
-	                            ChannelFeature::Synthesizer});
+	                            ChannelFeature::Synthesizer,
+	                            ChannelFeature::ParallelRendering});
 
 	// The filter parameters have been tweaked by analysing real hardware
 	// recordings. The results are virtually indistinguishable from the
@@ -177,6 +178,32 @@ AudioFrame GameBlaster::RenderFrame()
 	return {static_cast<float>(left_accum), static_cast<float>(right_accum)};
 }
 
+void GameBlaster::RenderFrames(AudioFrame* out, const size_t num_frames)
+{
+	static device_sound_interface::sound_stream stream;
+
+	// Render the whole block from each SAA-1099 device into the left and
+	// right halves of the buffer
+	device_buffer.resize(num_frames * 2);
+
+	int16_t* p_buf[] = {device_buffer.data(), device_buffer.data() + num_frames};
+
+	const auto num_samples = check_cast<int>(num_frames);
+
+	// Accumulate the samples from both SAA-1099 devices
+	devices[0]->sound_stream_update(stream, nullptr, p_buf, num_samples);
+	for (size_t i = 0; i < num_frames; ++i) {
+		out[i] = {static_cast<float>(p_buf[0][i]),
+		          static_cast<float>(p_buf[1][i])};
+	}
+
+	devices[1]->sound_stream_update(stream, nullptr, p_buf, num_samples);
+	for (size_t i = 0; i < num_frames; ++i) {
+		out[i].left += static_cast<float>(p_buf[0][i]);
+		out[i].right += static_cast<float>(p_buf[1][i]);
+	}
+}
+
 void GameBlaster::RenderUpToNow()
 {
 	const auto now = PIC_FullIndex();
@@ -228,20 +255,23 @@ void GameBlaster::AudioCallback(const int requested_frames)
 	}
 #endif
 
-	auto frames_remaining = requested_frames;
+	const auto num_requested = static_cast<size_t>(requested_frames);
+	render_buffer.clear();
 
-	// First, add any frames we've queued since the last callback
-	while (frames_remaining && fifo.size()) {
-		channel->AddSamples_sfloat(1, &fifo.front()[0]);
+	// First, take any frames we've queued since the last callback
+	while (render_buffer.size() < num_requested && fifo.size()) {
+		render_buffer.push_back(fifo.front());
 		fifo.pop();
-		--frames_remaining;
 	}
-	// If the queue's run dry, render the remainder and sync-up our time datum
-	while (frames_remaining) {
-		auto frame = RenderFrame();
-		channel->AddSamples_sfloat(1, &frame[0]);
-		--frames_remaining;
+	// If the queue's run dry, render the remainder in one go and sync-up
+	// our time datum
+	if (const auto num_queued = render_buffer.size(); num_queued < num_requested) {
+		render_buffer.resize(num_requested);
+		RenderFrames(render_buffer.data() + num_queued,
+		             num_requested - num_queued);
 	}
+	channel->AddSamples_sfloat(requested_frames, &render_buffer[0][0]);
+
 	last_rendered_ms = PIC_FullIndex();
 }
 
@@ -53,6 +53,7 @@ public:
 private:
 	// Audio rendering
 	AudioFrame RenderFrame();
+	void RenderFrames(AudioFrame* out, const size_t num_frames);
 	void AudioCallback(const int requested_frames);
 	void RenderUpToNow();
 
@@ -83,6 +84,10 @@ private:
 
 	std::queue<AudioFrame> fifo = {};
 
+	// Scratch buffers of the audio callback's blocks
+	std::vector<int16_t> device_buffer    = {};
+	std::vector<AudioFrame> render_buffer = {};
+
 	// Static rate-related configuration
 	static constexpr auto ChipClockHz   = 14318180 / 2;
 	static constexpr auto RenderDivisor = 32;
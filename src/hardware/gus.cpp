@@ -166,6 +166,11 @@ private:
 	bool Is16Bit() const noexcept;
 	float GetVolScalar(const vol_scalars_array_t& vol_scalars);
 	float GetSample(const ram_array_t& ram) noexcept;
+	int64_t GetFramesToBoundary(const VoiceCtrl& ctrl) const noexcept;
+	template <bool is_16bit>
+	void RenderRun(const ram_array_t& ram, const vol_scalars_array_t& vol_scalars,
+	               const AudioFrame pan_scalar, AudioFrame* frames,
+	               const int64_t num_frames) noexcept;
 	int32_t PopWavePos() noexcept;
 	float PopVolScalar(const vol_scalars_array_t& vol_scalars);
 	float Read8BitSample(const ram_array_t& ram, int32_t addr) const noexcept;
@@ -478,17 +483,110 @@ void Voice::RenderFrames(const ram_array_t& ram,
 
 	const auto pan_scalar = pan_scalars.at(pan_position);
 
-	// Sum the voice's samples into the exising frames, angled in L-R space
-	for (auto& frame : frames) {
+	const auto num_frames = static_cast<int64_t>(frames.size());
+
+	// Sum the voice's samples into the exising frames, angled in L-R space.
+	// Up to the next wave or volume boundary, the positions only step
+	// linearly, so those frames are rendered in a tight loop; the frame
+	// reaching the boundary then raises the IRQ, loops, or stops the voice.
+	int64_t i = 0;
+	while (i < num_frames) {
+		const auto num_run_frames = std::min({GetFramesToBoundary(wave_ctrl),
+		                                      GetFramesToBoundary(vol_ctrl),
+		                                      num_frames - i});
+		auto run_frames = &frames[static_cast<size_t>(i)];
+		if (Is16Bit()) {
+			RenderRun<true>(ram, vol_scalars, pan_scalar, run_frames, num_run_frames);
+		} else {
+			RenderRun<false>(ram, vol_scalars, pan_scalar, run_frames, num_run_frames);
+		}
+		i += num_run_frames;
+		if (i == num_frames) {
+			break;
+		}
+
+		auto& frame  = frames[static_cast<size_t>(i)];
 		float sample = GetSample(ram);
 		sample *= PopVolScalar(vol_scalars);
 		frame.left += sample * pan_scalar.left;
 		frame.right += sample * pan_scalar.right;
+		++i;
 	}
 	// Keep track of how many ms this voice has generated
 	Is16Bit() ? generated_16bit_ms++ : generated_8bit_ms++;
 }
 
+// Returns how many frames the control can step through before reaching its
+// start or end boundary
+int64_t Voice::GetFramesToBoundary(const VoiceCtrl& ctrl) const noexcept
+{
+	constexpr auto Unbounded = std::numeric_limits<int64_t>::max();
+
+	if (ctrl.state & CTRL::DISABLED) {
+		return Unbounded;
+	}
+	const int64_t distance = (ctrl.state & CTRL::DECREASING)
+	                               ? int64_t{ctrl.pos} - ctrl.start
+	                               : int64_t{ctrl.end} - ctrl.pos;
+	if (distance <= 0) {
+		return 0;
+	}
+	if (ctrl.inc <= 0) {
+		return Unbounded;
+	}
+	// The frames whose step stays short of the boundary
+	return (distance - 1) / ctrl.inc;
+}
+
+// Renders frames that don't reach either control's boundary; it computes
+// the same samples as GetSample() and PopVolScalar() do for each frame.
+template <bool is_16bit>
+void Voice::RenderRun(const ram_array_t& ram, const vol_scalars_array_t& vol_scalars,
+                      const AudioFrame pan_scalar, AudioFrame* frames,
+                      const int64_t num_frames) noexcept
+{
+	auto step_of = [](const VoiceCtrl& ctrl) {
+		if (ctrl.state & CTRL::DISABLED) {
+			return 0;
+		}
+		return (ctrl.state & CTRL::DECREASING) ? -ctrl.inc : ctrl.inc;
+	};
+	const auto wave_step = step_of(wave_ctrl);
+	const auto vol_step  = step_of(vol_ctrl);
+
+	const bool can_interpolate = wave_ctrl.inc < WAVE_WIDTH;
+
+	auto read_sample = [&](const int32_t addr) {
+		return is_16bit ? Read16BitSample(ram, addr) : Read8BitSample(ram, addr);
+	};
+
+	auto wave_pos = wave_ctrl.pos;
+	auto vol_pos  = vol_ctrl.pos;
+
+	for (int64_t i = 0; i < num_frames; ++i) {
+		const auto addr     = wave_pos / WAVE_WIDTH;
+		const auto fraction = wave_pos & (WAVE_WIDTH - 1);
+
+		float sample = read_sample(addr);
+		if (can_interpolate && fraction) {
+			const float next_sample = read_sample(addr + 1);
+			constexpr float WAVE_WIDTH_INV = 1.0 / WAVE_WIDTH;
+			sample += (next_sample - sample) *
+			          static_cast<float>(fraction) * WAVE_WIDTH_INV;
+		}
+		const auto vol_index = ceil_sdivide(vol_pos, VOLUME_INC_SCALAR);
+		sample *= vol_scalars.at(static_cast<size_t>(vol_index));
+
+		frames[i].left += sample * pan_scalar.left;
+		frames[i].right += sample * pan_scalar.right;
+
+		wave_pos += wave_step;
+		vol_pos += vol_step;
+	}
+	wave_ctrl.pos = wave_pos;
+	vol_ctrl.pos  = vol_pos;
+}
+
 // Returns the current wave position and increments the position
 // to the next wave position.
 int32_t Voice::PopWavePos() noexcept
@@ -10,8 +10,10 @@
 #include "dosbox.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cassert>
+#include <future>
 
 #include "bios_disk.h"
 #include "callback.h"
@@ -21,6 +23,7 @@
 #include "inout.h"
 #include "mem.h"
 #include "mixer.h"
+#include "pci_bus.h"
 #include "pic.h"
 #include "setup.h"
 #include "string_utils.h"
@@ -181,6 +184,7 @@ public:
 	virtual void prepare_write(uint32_t offset, uint32_t size);
 	virtual void io_completion();
 	virtual bool increment_current_address(uint32_t count = 1);
+	void bus_master_transfer();
 
 public:
 	uint8_t sector[512 * 128] = {};
@@ -190,6 +194,10 @@ public:
 	uint32_t multiple_sector_max = sizeof(sector) / 512;
 	uint32_t multiple_sector_count = 1;
 
+	/* transfer mode picked by SET FEATURES, as in its count register:
+	   20h+n for multiword DMA mode n, 40h+n for Ultra DMA mode n */
+	uint8_t transfer_mode = 0x22;
+
 	uint32_t heads = 0;
 	uint32_t sects = 0;
 	uint32_t cyls = 0;
@@ -246,6 +254,7 @@ public:
 	virtual void io_completion();
 	virtual void atapi_cmd_completion();
 	virtual void on_atapi_busy_time();
+	virtual double start_sector_read();
 	virtual void read_subchannel();
 	virtual void play_audio_msf();
 	virtual void pause_resume();
@@ -287,6 +296,15 @@ public:
 	uint8_t sector[512 * 128] = {};
 	uint32_t sector_i = 0;
 	uint32_t sector_total = 0;
+
+	/* READ(10) and READ(12) fetch their sectors on a worker thread while the
+	   drive reports busy, so slow host storage doesn't stall the emulation */
+	std::future<bool> pending_read = {};
+	CDROM_Interface *pending_read_cdrom = nullptr;
+	uint8_t read_buffer[sizeof(sector)] = {};
+
+	/* where the optics sit after the last read, to time the seeks */
+	uint32_t head_lba = 0;
 };
 
 class IDEController {
@@ -316,6 +334,13 @@ public:
 	bool interrupt_enable = true; /* bit 1 of alt (0x3F6) */
 	bool host_reset = false;      /* bit 2 of alt */
 	bool irq_pending = false;
+
+	/* PCI bus-master DMA, only on the primary and secondary controllers */
+	bool bus_master = false;
+	uint8_t bm_command = 0;      /* bus-master command register (BAR4+0) */
+	uint8_t bm_status = 0;       /* bus-master status register (BAR4+2) */
+	uint32_t bm_prd_table = 0;   /* physical region descriptor table (BAR4+4) */
+	bool bm_dma_pending = false; /* drive is waiting for the start bit */
 	/* defaults for CD-ROM emulation */
 	double spinup_time = 0.0;
 	double spindown_timeout = 0.0;
@@ -1121,11 +1146,18 @@ void IDEATAPICDROMDevice::on_atapi_busy_time()
 			state = IDE_DEV_READY;
 			status = IDE_STATUS_DRIVE_READY;
 		} else {
-			/* OK, try to read */
-			CDROM_Interface *cdrom = getMSCDEXDrive();
-			bool res = (cdrom != nullptr ? cdrom->ReadSectorsHost(/*buffer*/ sector, false, LBA, TransferLength)
-			                          : false);
+			/* the drive stays busy until the background read completes */
+			using namespace std::chrono_literals;
+			if (pending_read.valid() && pending_read.wait_for(0s) != std::future_status::ready) {
+				PIC_AddEvent(IDE_DelayedCommand, 1 /*ms*/, controller->interface_index);
+				return;
+			}
+			/* the read only counts if the CD-ROM wasn't swapped meanwhile */
+			bool res = pending_read.valid() && pending_read.get() &&
+			           pending_read_cdrom != nullptr && pending_read_cdrom == getMSCDEXDrive();
+			pending_read_cdrom = nullptr;
 			if (res) {
+				memcpy(sector, read_buffer, TransferLength * 2048);
 				prepare_read(0, std::min((TransferLength * 2048), host_maximum_byte_count));
 				feature = 0x00;
 				state = IDE_DEV_DATA_READ;
@@ -1305,7 +1337,47 @@ IDEATAPICDROMDevice::IDEATAPICDROMDevice(IDEController *c, uint8_t requested_dri
 }
 
 IDEATAPICDROMDevice::~IDEATAPICDROMDevice()
-{}
+{
+	/* the CD-ROM is only removed after its device, so finish reading it */
+	if (pending_read.valid())
+		pending_read.wait();
+}
+
+/* starts reading the sectors of a READ command in the background, returning
+   how long (in ms) the drive takes to seek to them */
+double IDEATAPICDROMDevice::start_sector_read()
+{
+	/* a seek across the whole disc takes about 100 ms, and even reads
+	   continuing from the optics' position take 3 ms */
+	constexpr double MinSeekTime = 3.0;
+	constexpr double FullSeekTime = 100.0;
+
+	if (TransferLength == 0)
+		return MinSeekTime;
+
+	/* any previous read was abandoned by a reset; wait for it to finish
+	   with the buffer */
+	if (pending_read.valid())
+		pending_read.wait();
+
+	CDROM_Interface *cdrom = getMSCDEXDrive();
+	pending_read_cdrom = cdrom;
+	if (cdrom != nullptr) {
+		const uint32_t lba = LBA;
+		const uint32_t num_sectors = TransferLength;
+		pending_read = std::async(std::launch::async, [this, cdrom, lba, num_sectors] {
+			return cdrom->ReadSectorsHost(read_buffer, false, lba, num_sectors);
+		});
+	} else {
+		pending_read = {};
+	}
+
+	const uint32_t distance = (LBA > head_lba) ? (LBA - head_lba) : (head_lba - LBA);
+	head_lba = LBA + TransferLength;
+
+	/* the optics move faster over longer distances */
+	return MinSeekTime + FullSeekTime * std::sqrt(std::min(1.0, (double)distance / MAX_REDBOOK_SECTOR));
+}
 
 void IDEATAPICDROMDevice::on_mode_select_io_complete()
 {
@@ -1646,8 +1718,9 @@ void IDEATAPICDROMDevice::atapi_cmd_completion()
 			count = 0x02;
 			state = IDE_DEV_ATAPI_BUSY;
 			status = IDE_STATUS_BUSY;
-			/* TBD: Emulate CD-ROM spin-up delay, and seek delay */
-			PIC_AddEvent(IDE_DelayedCommand, (faked_command ? 0.000001 : 3) /*ms*/,
+			/* TBD: Emulate CD-ROM spin-up delay */
+			const double seek_time = start_sector_read();
+			PIC_AddEvent(IDE_DelayedCommand, (faked_command ? 0.000001 : seek_time) /*ms*/,
 			             controller->interface_index);
 		} else {
 			count = 0x03;
@@ -1684,8 +1757,9 @@ void IDEATAPICDROMDevice::atapi_cmd_completion()
 			count = 0x02;
 			state = IDE_DEV_ATAPI_BUSY;
 			status = IDE_STATUS_BUSY;
-			/* TBD: Emulate CD-ROM spin-up delay, and seek delay */
-			PIC_AddEvent(IDE_DelayedCommand, (faked_command ? 0.000001 : 3) /*ms*/,
+			/* TBD: Emulate CD-ROM spin-up delay */
+			const double seek_time = start_sector_read();
+			PIC_AddEvent(IDE_DelayedCommand, (faked_command ? 0.000001 : seek_time) /*ms*/,
 			             controller->interface_index);
 		} else {
 			count = 0x03;
@@ -1945,6 +2019,155 @@ void IDEATADevice::prepare_read(uint32_t offset, uint32_t size)
 	assert(sector_total <= sizeof(sector));
 }
 
+/* Returns the guest RAM behind 'size' bytes at a physical address, or nullptr
+   if they lie past its end. Bus-master DMA bypasses the paging and EMS mappings */
+static uint8_t *bus_master_host_ptr(const PhysPt address, const uint32_t size)
+{
+	const uint64_t end = static_cast<uint64_t>(address) + size;
+	if (end > static_cast<uint64_t>(MEM_TotalPages()) * dos_pagesize)
+		return nullptr;
+	return MemBase + address;
+}
+
+/* the sector the task file registers point at, in LBA or C/H/S mode */
+static bool get_current_sector(const IDEATADevice &ata, uint32_t &sectorn)
+{
+	if (drivehead_is_lba(ata.drivehead)) {
+		sectorn = (((uint32_t)ata.drivehead & 0xFu) << 24u) | (uint32_t)ata.lba[0] |
+		          ((uint32_t)ata.lba[1] << 8u) | ((uint32_t)ata.lba[2] << 16u);
+		return true;
+	}
+
+	const uint32_t cyl = ata.lba[1] | ((uint32_t)ata.lba[2] << 8u);
+	if (ata.lba[0] == 0 || (uint32_t)(ata.drivehead & 0xF) >= ata.heads ||
+	    (uint32_t)ata.lba[0] > ata.sects || cyl >= ata.cyls) {
+		LOG_WARNING("IDE: C/H/S %u/%u/%u out of bounds %u/%u/%u", cyl,
+		            (uint32_t)(ata.drivehead & 0xF), (uint32_t)ata.lba[0], ata.cyls,
+		            ata.heads, ata.sects);
+		return false;
+	}
+
+	sectorn = ((ata.drivehead & 0xFu) * ata.sects) + (cyl * ata.sects * ata.heads) +
+	          ((uint32_t)ata.lba[0] - 1u);
+	return true;
+}
+
+/* READ DMA and WRITE DMA: move all of the command's sectors between the disk
+   and the guest memory the bus-master's PRD table describes in one go, instead
+   of a port access per word and an interrupt per sector as with PIO */
+void IDEATADevice::bus_master_transfer()
+{
+	constexpr uint8_t BmActive = 0x01;
+	constexpr uint8_t BmError = 0x02;
+
+	const bool to_memory = (command == 0xC8 || command == 0xC9);
+	controller->bm_dma_pending = false;
+
+	auto fail = [this](const uint8_t bm_flags) {
+		controller->bm_status = check_cast<uint8_t>((controller->bm_status & ~BmActive) | bm_flags);
+		abort_error();
+		allow_writing = true;
+		controller->raise_irq();
+	};
+
+	const auto disk = getBIOSdisk();
+	if (disk == nullptr) {
+		LOG_WARNING("IDE: ATA DMA fail, bios disk N/A");
+		fail(0);
+		return;
+	}
+
+	uint32_t sectorn = 0;
+	if (!get_current_sector(*this, sectorn)) {
+		fail(0);
+		return;
+	}
+	const uint32_t total = (count & 0xFF) ? (count & 0xFF) : 256;
+
+	/* each PRD entry: dword physical address, word byte count (0 = 64 KB)
+	   and word flags, where bit 15 marks the last entry */
+	PhysPt prd = controller->bm_prd_table & ~3u;
+	PhysPt region = 0;
+	uint32_t region_left = 0;
+	bool end_of_table = false;
+
+	auto next_region = [&]() {
+		if (end_of_table)
+			return false;
+		const auto entry = bus_master_host_ptr(prd, 8);
+		if (entry == nullptr)
+			return false;
+		region = host_readd(entry) & ~1u;
+		const auto size = host_readw(entry + 4) & 0xFFFEu;
+		region_left = size ? size : 0x10000;
+		end_of_table = (host_readw(entry + 6) & 0x8000) != 0;
+		prd += 8;
+		return true;
+	};
+
+	constexpr uint32_t max_sectors = sizeof(sector) / 512;
+	for (uint32_t done = 0; done < total;) {
+		const auto num_sectors = std::min(total - done, max_sectors);
+		const auto num_bytes = num_sectors * 512;
+
+		if (to_memory && disk->Read_AbsoluteSectors(sectorn + done, num_sectors, sector) != 0) {
+			LOG_WARNING("IDE: ATA DMA read failed");
+			fail(0);
+			return;
+		}
+
+		for (uint32_t pos = 0; pos < num_bytes;) {
+			if (region_left == 0 && !next_region()) {
+				LOG_WARNING("IDE: ATA DMA PRD table shorter than the transfer");
+				fail(BmError);
+				return;
+			}
+			const auto chunk = std::min(region_left, num_bytes - pos);
+
+			/* like ISA DMA, unbacked memory reads as an open bus and drops writes */
+			const auto host_pt = bus_master_host_ptr(region, chunk);
+			if (to_memory) {
+				if (host_pt)
+					memcpy(host_pt, sector + pos, chunk);
+			} else if (host_pt) {
+				memcpy(sector + pos, host_pt, chunk);
+			} else {
+				memset(sector + pos, 0xFF, chunk);
+			}
+
+			region += chunk;
+			region_left -= chunk;
+			pos += chunk;
+		}
+
+		if (!to_memory && disk->Write_AbsoluteSectors(sectorn + done, num_sectors, sector) != 0) {
+			LOG_WARNING("IDE: ATA DMA write failed");
+			fail(0);
+			return;
+		}
+		done += num_sectors;
+	}
+
+	/* the registers point at the last sector transferred, as after PIO */
+	progress_count = total;
+	if (total > 1 && !increment_current_address(total - 1)) {
+		LOG_WARNING("IDE: DMA advance error");
+		fail(0);
+		return;
+	}
+	count = 0;
+
+	/* the bus-master stays active if the PRD table describes more memory
+	   than the drive transferred */
+	if (region_left == 0 && end_of_table)
+		controller->bm_status &= ~BmActive;
+
+	status = IDE_STATUS_DRIVE_READY | IDE_STATUS_DRIVE_SEEK_COMPLETE;
+	state = IDE_DEV_READY;
+	allow_writing = true;
+	controller->raise_irq();
+}
+
 void IDEATAPICDROMDevice::generate_mmc_inquiry()
 {
 	uint32_t i;
@@ -2075,12 +2298,15 @@ void IDEATADevice::generate_identify_device()
 		host_writew(sector + (47 * 2),
 		            check_cast<uint16_t>(0x80 | multiple_sector_max)); /* <- READ/WRITE MULTIPLE MAX SECTORS */
 
+	const bool has_dma = controller->bus_master;
+
 	host_writew(sector + (48 * 2), 0x0000); /* :0  0=we do not support doubleword (32-bit) PIO */
-	host_writew(sector + (49 * 2), 0x0A00); /* :13 0=Standby timer values managed by device */
+	host_writew(sector + (49 * 2), has_dma ? 0x0B00 : 0x0A00);
+	                                        /* :13 0=Standby timer values managed by device */
 	                                        /* :11 1=IORDY supported */
 	                                        /* :10 0=IORDY not disabled */
 	                                        /* :9  1=LBA supported */
-	                                        /* :8  0=DMA not supported */
+	                                        /* :8  1=DMA supported (with a bus-master controller) */
 	host_writew(sector + (50 * 2), 0x4000); /* TBD: ??? */
 	host_writew(sector + (51 * 2), 0x00F0); /* PIO data transfer cycle timing mode */
 	host_writew(sector + (52 * 2), 0x00F0); /* DMA data transfer cycle timing mode */
@@ -2100,8 +2326,16 @@ void IDEATADevice::generate_identify_device()
 
 	host_writed(sector + (60 * 2), check_cast<uint16_t>(ptotal)); /* total user addressable sectors (LBA) */
 	host_writew(sector + (62 * 2), 0x0000);                       /* TBD: ??? */
-	host_writew(sector + (63 * 2), 0x0000); /* :10 0=Multiword DMA mode 2 not selected */
-	                                        /* TBD: Basically, we don't do DMA. Fill out this comment */
+	/* 10:8 multiword DMA mode selected, 2:0 multiword DMA modes 0-2 supported */
+	uint16_t mwdma = 0x0000;
+	/* 10:8 Ultra DMA mode selected, 2:0 Ultra DMA modes 0-2 supported */
+	uint16_t udma = 0x0000;
+	if (has_dma) {
+		const auto mode = transfer_mode & 0x07;
+		mwdma = check_cast<uint16_t>(0x0007 | ((transfer_mode & 0xF8) == 0x20 ? 0x100 << mode : 0));
+		udma = check_cast<uint16_t>(0x0007 | ((transfer_mode & 0xF8) == 0x40 ? 0x100 << mode : 0));
+	}
+	host_writew(sector + (63 * 2), mwdma);
 	host_writew(sector + (64 * 2), 0x0003); /* 7:0 PIO modes supported (TBD: ???) */
 	host_writew(sector + (65 * 2), 0x0000); /* TBD: ??? */
 	host_writew(sector + (66 * 2), 0x0000); /* TBD: ??? */
@@ -2115,7 +2349,7 @@ void IDEATADevice::generate_identify_device()
 	host_writew(sector + (85 * 2), 0x4208); /* commands in 82 enabled */
 	host_writew(sector + (86 * 2), 0x4000); /* commands in 83 enabled */
 	host_writew(sector + (87 * 2), 0x4000); /* TBD: ??? */
-	host_writew(sector + (88 * 2), 0x0000); /* TBD: ??? */
+	host_writew(sector + (88 * 2), udma);
 	host_writew(sector + (93 * 3), 0x0000); /* TBD: ??? */
 
 	/* ATA-8 integrity checksum */
@@ -3201,15 +3435,13 @@ static void IDE_DelayedCommand(uint32_t idx /*which IDE controller*/)
 			if ((512 * ata->multiple_sector_count) > sizeof(ata->sector))
 				E_Exit("SECTOR OVERFLOW");
 
-			for (uint32_t cc = 0; cc < std::min(ata->multiple_sector_count, sectcount); cc++) {
-				/* it would be great if the disk object had a "read
-				 * multiple sectors" member function */
-				if (disk->Read_AbsoluteSector(sectorn + cc, ata->sector + (cc * 512)) != 0) {
-					LOG_WARNING("IDE: ATA read failed");
-					ata->abort_error();
-					dev->controller->raise_irq();
-					return;
-				}
+			if (disk->Read_AbsoluteSectors(sectorn,
+			                               std::min(ata->multiple_sector_count, sectcount),
+			                               ata->sector) != 0) {
+				LOG_WARNING("IDE: ATA read failed");
+				ata->abort_error();
+				dev->controller->raise_irq();
+				return;
 			}
 
 			/* NTS: the way this command works is that the drive reads ONE sector, then fires the IRQ
@@ -3264,15 +3496,13 @@ static void IDE_DelayedCommand(uint32_t idx /*which IDE controller*/)
 				          ((uint32_t)ata->lba[0] - 1);
 			}
 
-			for (uint32_t cc = 0; cc < std::min(ata->multiple_sector_count, sectcount); cc++) {
-				/* it would be great if the disk object had a "write
-				 * multiple sectors" member function */
-				if (disk->Write_AbsoluteSector(sectorn + cc, ata->sector + (cc * 512)) != 0) {
-					LOG_WARNING("IDE: Failed to write sector");
-					ata->abort_error();
-					dev->controller->raise_irq();
-					return;
-				}
+			if (disk->Write_AbsoluteSectors(sectorn,
+			                                std::min(ata->multiple_sector_count, sectcount),
+			                                ata->sector) != 0) {
+				LOG_WARNING("IDE: Failed to write sector");
+				ata->abort_error();
+				dev->controller->raise_irq();
+				return;
 			}
 
 			for (uint32_t cc = 0; cc < std::min(ata->multiple_sector_count, sectcount); cc++) {
@@ -3307,6 +3537,20 @@ static void IDE_DelayedCommand(uint32_t idx /*which IDE controller*/)
 			dev->controller->raise_irq();
 			break;
 
+		case 0xC8: /* READ DMA */
+		case 0xC9:
+		case 0xCA: /* WRITE DMA */
+		case 0xCB:
+			/* the drive is ready: transfer straight away if the bus-master
+			   is running, otherwise once the driver sets its start bit */
+			if (dev->controller->bm_command & 0x01) {
+				ata->bus_master_transfer();
+			} else {
+				dev->status = IDE_STATUS_DRQ | IDE_STATUS_DRIVE_READY | IDE_STATUS_DRIVE_SEEK_COMPLETE;
+				dev->controller->bm_dma_pending = true;
+			}
+			break;
+
 		case 0xEC: /*IDENTIFY DEVICE (CONTINUED) */
 			dev->state = IDE_DEV_DATA_READ;
 			dev->status = IDE_STATUS_DRQ | IDE_STATUS_DRIVE_READY | IDE_STATUS_DRIVE_SEEK_COMPLETE;
@@ -3372,6 +3616,7 @@ static void IDE_DelayedCommand(uint32_t idx /*which IDE controller*/)
 void IDEController::raise_irq()
 {
 	irq_pending = true;
+	bm_status |= 0x04; /* the bus-master status latches the drive's interrupt */
 	if (IRQ >= 0 && interrupt_enable)
 		PIC_ActivateIRQ(check_cast<uint8_t>(IRQ));
 }
@@ -3730,6 +3975,55 @@ void IDEATADevice::writecommand(uint8_t cmd)
 		controller->raise_irq();
 		allow_writing = true;
 		break;
+	case 0xC8: /* READ DMA WITH RETRY */
+	case 0xC9: /* READ DMA WITHOUT RETRY */
+	case 0xCA: /* WRITE DMA WITH RETRY */
+	case 0xCB: /* WRITE DMA WITHOUT RETRY */
+		if (!controller->bus_master) {
+			LOG_WARNING("IDE: ATA DMA command %02X without a bus-master controller", cmd);
+			abort_error();
+			allow_writing = true;
+			controller->raise_irq();
+			break;
+		}
+		/* the drive "seeks", then waits for the bus-master to start the transfer */
+		progress_count = 0;
+		state = IDE_DEV_BUSY;
+		status = IDE_STATUS_BUSY;
+		PIC_AddEvent(IDE_DelayedCommand, (faked_command ? 0.000001 : 0.1) /*ms*/,
+		             controller->interface_index);
+		break;
+	case 0xEF: /* SET FEATURES */
+		switch (feature & 0xFF) {
+		case 0x03: /* set transfer mode from the count register */
+			if ((count & 0xF8) == 0x00 || (count & 0xF8) == 0x08) {
+				/* PIO default or flow control modes, which we run at any speed */
+			} else if (controller->bus_master &&
+			           ((count & 0xF8) == 0x20 || (count & 0xF8) == 0x40) && (count & 0x07) <= 2) {
+				transfer_mode = check_cast<uint8_t>(count);
+			} else {
+				abort_error();
+				allow_writing = true;
+				controller->raise_irq();
+				return;
+			}
+			break;
+		case 0x02: /* enable write cache */
+		case 0x82: /* disable write cache */
+		case 0x55: /* disable read look-ahead */
+		case 0xAA: /* enable read look-ahead */
+			break;
+		default:
+			LOG_WARNING("IDE: ATA SET FEATURES subcommand %02X", feature & 0xFF);
+			abort_error();
+			allow_writing = true;
+			controller->raise_irq();
+			return;
+		}
+		status = IDE_STATUS_DRIVE_READY | IDE_STATUS_DRIVE_SEEK_COMPLETE;
+		controller->raise_irq();
+		allow_writing = true;
+		break;
 	case 0xA0: /*ATAPI PACKET*/
 		   /* We're not an ATAPI packet device!
 		    * Windows 95 seems to issue this at startup to hard drives. Duh. */
@@ -3785,6 +4079,169 @@ void IDEDevice::select(uint8_t ndh, bool switched_to)
 	//  state = IDE_DEV_READY;
 }
 
+/* PCI bus-master IDE, modelled on the Intel PIIX3's IDE function. Its BAR4
+   holds 8 I/O ports per channel (primary, then secondary):
+     +0 command: bit 0 start, bit 3 direction (1 = write to memory)
+     +2 status: bit 0 active, bit 1 error, bit 2 interrupt (both write 1 to
+        clear), bits 5 and 6 master and slave DMA capable
+     +4 physical address of the PRD table (dword) */
+struct PCI_BusMasterIDEDevice : public PCI_Device {
+	enum : uint16_t {
+		vendor = 0x8086,
+		device = 0x7010,
+	};
+
+	PCI_BusMasterIDEDevice() : PCI_Device(vendor, device) {}
+
+	bool InitializeRegisters(uint8_t registers[256]) override
+	{
+		registers[0x04] = 0x05; // command register: I/O space, bus master
+		registers[0x05] = 0x00;
+		registers[0x06] = 0x80; // status register: fast back-to-back
+		registers[0x07] = 0x02; // medium DEVSEL timing
+
+		registers[0x08] = 0x00; // revision
+		registers[0x09] = 0x80; // programming interface: bus master, legacy ports
+		registers[0x0a] = 0x01; // subclass code: IDE
+		registers[0x0b] = 0x01; // class code: mass storage
+		registers[0x0d] = 0x00; // latency timer
+		registers[0x0e] = 0x00; // header type (other)
+
+		// BAR 4, the bus-master registers
+		constexpr auto port_num = static_cast<uint16_t>(port_num_bus_master_ide);
+		registers[0x20] = static_cast<uint8_t>((port_num & 0xf0) + 1);
+		registers[0x21] = static_cast<uint8_t>((port_num >> 8) & 0xff);
+		registers[0x22] = 0;
+		registers[0x23] = 0;
+
+		registers[0x3c] = 0xff; // legacy IRQs 14 and 15
+
+		// IDE timing registers: decode both channels' legacy ports
+		registers[0x41] = 0x80;
+		registers[0x43] = 0x80;
+		return true;
+	}
+
+	Bits ParseReadRegister(uint8_t regnum) override
+	{
+		return regnum;
+	}
+
+	bool OverrideReadRegister([[maybe_unused]] uint8_t regnum,
+	                          [[maybe_unused]] uint8_t* rval,
+	                          [[maybe_unused]] uint8_t* rval_mask) override
+	{
+		return false;
+	}
+
+	Bits ParseWriteRegister(uint8_t regnum, uint8_t value) override
+	{
+		// the BARs are fixed, only the command and timing registers change
+		if (regnum == 0x04 || (regnum >= 0x40 && regnum < 0x48))
+			return value;
+		return -1;
+	}
+};
+
+static IO_ReadHandleObject bus_master_read_handler = {};
+static IO_WriteHandleObject bus_master_write_handler = {};
+
+static IDEController *get_bus_master_controller(const io_port_t port)
+{
+	return idecontroller[(port - port_num_bus_master_ide) >> 3];
+}
+
+static uint8_t bus_master_read(const io_port_t port)
+{
+	const auto ide = get_bus_master_controller(port);
+	if (ide == nullptr)
+		return 0xFF;
+
+	switch (port & 7) {
+	case 0: return ide->bm_command;
+	case 2: return ide->bm_status;
+	case 4:
+	case 5:
+	case 6:
+	case 7: return check_cast<uint8_t>((ide->bm_prd_table >> (8 * (port & 3))) & 0xFF);
+	default: return 0x00;
+	}
+}
+
+static void bus_master_write(const io_port_t port, const uint8_t val)
+{
+	const auto ide = get_bus_master_controller(port);
+	if (ide == nullptr)
+		return;
+
+	switch (port & 7) {
+	case 0:
+		if (val & 0x01) {
+			if (!(ide->bm_command & 0x01))
+				ide->bm_status |= 0x01;
+		} else {
+			ide->bm_status &= ~0x01;
+		}
+		ide->bm_command = val & 0x09;
+
+		/* the drive was waiting for the transfer to start */
+		if ((val & 0x01) && ide->bm_dma_pending) {
+			auto ata = dynamic_cast<IDEATADevice *>(ide->device[ide->select]);
+			if (ata && ata->state == IDE_DEV_BUSY && (ata->command & 0xFC) == 0xC8)
+				ata->bus_master_transfer();
+			else
+				ide->bm_dma_pending = false;
+		}
+		break;
+	case 2:
+		ide->bm_status = check_cast<uint8_t>((ide->bm_status & 0x01) |
+		                                     (ide->bm_status & ~val & 0x06) | (val & 0x60));
+		break;
+	case 4:
+	case 5:
+	case 6:
+	case 7: {
+		const auto shift = 8 * (port & 3);
+		ide->bm_prd_table = (ide->bm_prd_table & ~(0xFFu << shift)) | (uint32_t(val) << shift);
+		break;
+	}
+	default: break;
+	}
+}
+
+static uint32_t bus_master_io_r(io_port_t port, io_width_t width)
+{
+	uint32_t ret = 0;
+	for (uint8_t i = 0; i < static_cast<uint8_t>(width); ++i)
+		ret |= uint32_t(bus_master_read(port + i)) << (8 * i);
+	return ret;
+}
+
+static void bus_master_io_w(io_port_t port, io_val_t val, io_width_t width)
+{
+	for (uint8_t i = 0; i < static_cast<uint8_t>(width); ++i)
+		bus_master_write(port + i, check_cast<uint8_t>((val >> (8 * i)) & 0xFF));
+}
+
+/* registers the bus-master with the first controller that can use it */
+static bool install_bus_master(const uint8_t index)
+{
+	if (index >= 2 || !PCI_IsInitialized())
+		return false;
+
+	static bool is_installed = false;
+	if (!is_installed) {
+		PCI_AddDevice(new PCI_BusMasterIDEDevice());
+		bus_master_read_handler.Install(port_num_bus_master_ide, bus_master_io_r,
+		                                io_width_t::dword, 16);
+		bus_master_write_handler.Install(port_num_bus_master_ide, bus_master_io_w,
+		                                 io_width_t::dword, 16);
+		is_installed = true;
+		LOG_MSG("IDE: PCI bus-master DMA at I/O port %04xh", port_num_bus_master_ide);
+	}
+	return true;
+}
+
 IDEController::IDEController(const uint8_t index,
                              const uint8_t irq,
                              const uint16_t port,
@@ -3826,6 +4283,10 @@ IDEController::IDEController(const uint8_t index,
 	PIC_SetIRQMask((uint32_t)IRQ, false);
 
 	idecontroller[index] = this;
+
+	bus_master = install_bus_master(index);
+	if (bus_master)
+		bm_status = 0x60; /* both drives DMA capable */
 }
 
 void IDEController::install_io_ports()
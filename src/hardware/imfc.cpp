@@ -2160,11 +2160,29 @@ private:
 	CounterData m_counter1{"timer.counter1"};
 	CounterData m_counter2{"timer.counter2"};
 
-	static void registerNextEvent()
+	// Only the transitions of the counter 0 output can be observed, so
+	// instead of ticking every 2 microseconds on the emulation thread, the
+	// counter skips ahead to the next tick that changes the output and the
+	// event is scheduled for then. An unprogrammed counter doesn't tick at
+	// all until it's written.
+	void registerNextEvent()
 	{
+		PIC_RemoveEvents(Intel8253_TimerEvent);
+
+		if (m_counter0.m_counter == 0U) {
+			return;
+		}
+
+		unsigned int num_ticks = 1;
+		if (m_counter0.m_runningCounter > 1) {
+			num_ticks = m_counter0.m_runningCounter;
+			m_counter0.m_runningCounter = 1;
+		}
+
 		// PIC_AddEvent takes milliseconds as argument
 		// the counter0 has a resolution of 2 microseconds
-		PIC_AddEvent(Intel8253_TimerEvent, 0.002, 0); // FIXME
+		constexpr double TickMs = 0.002;
+		PIC_AddEvent(Intel8253_TimerEvent, TickMs * num_ticks, 0);
 	}
 
 public:
@@ -2173,10 +2191,7 @@ public:
 		PIC_RemoveEvents(Intel8253_TimerEvent);
 	}
 
-	explicit Intel8253(const std::string& name) : m_name(name)
-	{
-		Intel8253::registerNextEvent(); // FIXME
-	}
+	explicit Intel8253(const std::string& name) : m_name(name) {}
 	DataProvider<bool>* getTimerA() const
 	{
 		return m_timerA.getDataProvider();
@@ -2202,6 +2217,7 @@ public:
 	{
 		IMF_LOG("writePortCNTR0 / value=0x%X", val);
 		m_counter0.writeCounterByte(val);
+		registerNextEvent();
 	}
 
 	uint8_t readPortCNTR1()
@@ -2319,7 +2335,7 @@ public:
 			}
 		}
 		// TODO: the other timers
-		Intel8253::registerNextEvent(); // FIXME
+		registerNextEvent();
 	}
 };
 
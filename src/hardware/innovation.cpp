@@ -21,9 +21,12 @@
 
 #include "innovation.h"
 
+#include <cmath>
+
 #include "channel_names.h"
 #include "checks.h"
 #include "control.h"
+#include "math_utils.h"
 #include "pic.h"
 #include "support.h"
 
@@ -33,7 +36,8 @@ void Innovation::Open(const std::string_view model_choice,
                       const std::string_view clock_choice,
                       const int filter_strength_6581,
                       const int filter_strength_8580, const int port_choice,
-                      const std::string& channel_filter_choice)
+                      const std::string& channel_filter_choice,
+                      const bool threaded)
 {
 	using namespace std::placeholders;
 
@@ -105,6 +109,7 @@ void Innovation::Open(const std::string_view model_choice,
 	}
 
 	const auto sample_rate_hz = mixer_channel->GetSampleRate();
+	clocks_per_frame          = chip_clock / sample_rate_hz;
 
 	// Determine the passband frequency, which is capped at 90% of Nyquist.
 	const double passband = 0.9 * sample_rate_hz / 2;
@@ -129,6 +134,10 @@ void Innovation::Open(const std::string_view model_choice,
 	// Ready state-values for rendering
 	last_rendered_ms = 0.0;
 
+	if (threaded) {
+		StartRenderer(sample_rate_hz);
+	}
+
 	// Variable model_name is only used for logging, so use a const char* here
 	const char* model_name = model_choice == "8580" ? "8580" : "6581";
 	constexpr auto us_per_s = 1'000'000.0;
@@ -162,6 +171,8 @@ void Innovation::Close()
 	read_handler.Uninstall();
 	write_handler.Uninstall();
 
+	StopRenderer();
+
 	// Deregister the mixer channel and remove it
 	assert(channel);
 	MIXER_DeregisterChannel(channel);
@@ -176,6 +187,21 @@ void Innovation::Close()
 uint8_t Innovation::ReadFromPort(io_port_t port, io_width_t)
 {
 	const auto sid_port = static_cast<io_port_t>(port - base_port);
+
+	// The SID's state lives on the renderer thread, so wait for it to
+	// catch up with the queued work and read the register there
+	if (renderer.enabled) {
+		std::promise<uint8_t> read_result = {};
+		auto value = read_result.get_future();
+
+		Work work        = {};
+		work.type        = WorkType::Read;
+		work.reg         = check_cast<uint8_t>(sid_port);
+		work.read_result = &read_result;
+		QueueWork(work);
+
+		return value.get();
+	}
 	return service->read(sid_port);
 }
 
@@ -185,7 +211,16 @@ void Innovation::WriteToPort(io_port_t port, io_val_t value, io_width_t)
 
 	const auto data = check_cast<uint8_t>(value);
 	const auto sid_port = static_cast<io_port_t>(port - base_port);
-	service->write(sid_port, data);
+
+	if (renderer.enabled) {
+		Work work = {};
+		work.type = WorkType::Write;
+		work.reg  = check_cast<uint8_t>(sid_port);
+		work.val  = data;
+		QueueWork(work);
+	} else {
+		service->write(sid_port, data);
+	}
 }
 
 void Innovation::RenderUpToNow()
@@ -198,6 +233,17 @@ void Innovation::RenderUpToNow()
 		last_rendered_ms = now;
 		return;
 	}
+	// The renderer thread runs the clocks before it applies the next
+	// queued register access
+	if (renderer.enabled) {
+		if (last_rendered_ms < now) {
+			const auto num_clocks = static_cast<int>(
+			        std::ceil((now - last_rendered_ms) / ms_per_clock));
+			last_rendered_ms += num_clocks * ms_per_clock;
+			renderer.num_unsent_clocks += num_clocks;
+		}
+		return;
+	}
 	// Keep rendering until we're current
 	while (last_rendered_ms < now) {
 		last_rendered_ms += ms_per_clock;
@@ -225,6 +271,31 @@ void Innovation::AudioCallback(const uint16_t requested_frames)
 {
 	assert(channel);
 
+	if (renderer.enabled) {
+		// Have the renderer thread stay ahead of the mixer by the
+		// prebuffer: it runs the clocks timestamped since the last
+		// register write, then tops up the frames if they fall short,
+		// as the synchronous path below does
+		renderer.num_consumed_frames += requested_frames;
+
+		Work work          = {};
+		work.type          = WorkType::Render;
+		work.target_frames = renderer.num_consumed_frames +
+		                     renderer.render_ahead_frames;
+		QueueWork(work);
+
+		auto& audio_frames = renderer.audio_frames;
+		if (renderer.audio_frame_fifo.BulkDequeue(audio_frames,
+		                                          requested_frames)) {
+			channel->AddSamples_mfloat(requested_frames,
+			                           audio_frames.data());
+		} else {
+			channel->AddSilence();
+		}
+		last_rendered_ms = PIC_FullIndex();
+		return;
+	}
+
 	//if (fifo.size())
 	//	LOG_MSG("INNOVATION: Queued %2lu cycle-accurate frames", fifo.size());
 
@@ -246,6 +317,151 @@ void Innovation::AudioCallback(const uint16_t requested_frames)
 	last_rendered_ms = PIC_FullIndex();
 }
 
+void Innovation::QueueWork(const Work& work)
+{
+	assert(renderer.enabled);
+
+	auto queued       = work;
+	queued.num_clocks = renderer.num_unsent_clocks;
+	renderer.work_fifo.Enqueue(std::move(queued));
+	renderer.num_unsent_clocks = 0;
+}
+
+// Queues the rendered samples as frames, dropping those that don't fit when
+// the emulation runs ahead of the mixer. Returns the number of frames queued.
+int Innovation::QueueFrames(const short* samples, const int num_samples)
+{
+	auto& fifo = renderer.audio_frame_fifo;
+
+	const auto num_free = check_cast<int>(fifo.MaxCapacity() - fifo.Size());
+	const auto num_frames = std::min(num_samples, num_free);
+	if (num_frames <= 0) {
+		return 0;
+	}
+
+	auto& frames = renderer.rendered_frames;
+	frames.resize(check_cast<size_t>(num_frames));
+	for (int i = 0; i < num_frames; ++i) {
+		frames[check_cast<size_t>(i)] = static_cast<float>(samples[i] * 2);
+	}
+	fifo.BulkEnqueue(frames, check_cast<size_t>(num_frames));
+
+	renderer.num_rendered_frames += num_frames;
+	return num_frames;
+}
+
+void Innovation::RunClocks(std::vector<short>& samples, int num_clocks)
+{
+	// The SID renders at most one sample per clock
+	constexpr int MaxClocksPerRun = 4096;
+
+	while (num_clocks > 0) {
+		const auto clocks = std::min(num_clocks, MaxClocksPerRun);
+		samples.resize(check_cast<size_t>(clocks));
+
+		const auto num_samples = service->clock(check_cast<unsigned int>(clocks),
+		                                        samples.data());
+		QueueFrames(samples.data(), num_samples);
+		num_clocks -= clocks;
+	}
+}
+
+void Innovation::RenderFramesUpTo(std::vector<short>& samples,
+                                  const int64_t target_frames)
+{
+	while (renderer.num_rendered_frames < target_frames) {
+		// Run about as many clocks as the missing frames take
+		const auto num_missing = target_frames - renderer.num_rendered_frames;
+		const auto clocks = std::clamp(static_cast<int>(num_missing * clocks_per_frame),
+		                               1,
+		                               4096);
+		samples.resize(check_cast<size_t>(clocks));
+
+		const auto num_samples = service->clock(check_cast<unsigned int>(clocks),
+		                                        samples.data());
+
+		// With the FIFO full, the mixer has enough frames waiting
+		if (QueueFrames(samples.data(), num_samples) < num_samples) {
+			break;
+		}
+	}
+}
+
+// Runs the clocks of the queued work, and then applies its register access,
+// until the renderer is stopped
+void Innovation::RenderThread()
+{
+	std::vector<short> samples = {};
+
+	while (const auto work = renderer.work_fifo.Dequeue()) {
+		if (work->num_clocks > 0) {
+			RunClocks(samples, work->num_clocks);
+		}
+
+		switch (work->type) {
+		case WorkType::Render:
+			RenderFramesUpTo(samples, work->target_frames);
+			break;
+
+		case WorkType::Write: service->write(work->reg, work->val); break;
+
+		case WorkType::Read:
+			assert(work->read_result);
+			work->read_result->set_value(service->read(work->reg));
+			break;
+		}
+	}
+}
+
+void Innovation::StartRenderer(const int sample_rate_hz)
+{
+	// Render ahead of the mixer by its prebuffer. Allow for four times that,
+	// plus the largest mixer request, to accumulate before frames are
+	// dropped, so the mixer always finds the frames it waits for.
+	renderer.render_ahead_frames = iround(MIXER_GetPreBufferMs() *
+	                                      sample_rate_hz / MillisInSecond);
+
+	constexpr int MaxRequestedFrames = 16384;
+	renderer.audio_frame_fifo.Resize(check_cast<size_t>(
+	        renderer.render_ahead_frames * 4 + MaxRequestedFrames));
+
+	// Tunes change all 25 registers in bursts, so allow for plenty of them
+	constexpr size_t MaxQueuedAccesses = 16384;
+	renderer.work_fifo.Resize(MaxQueuedAccesses);
+
+	renderer.num_unsent_clocks   = 0;
+	renderer.num_consumed_frames = 0;
+	renderer.num_rendered_frames = 0;
+	renderer.enabled             = true;
+
+	const auto render = std::bind(&Innovation::RenderThread, this);
+	renderer.thread   = std::thread(render);
+	set_thread_name(renderer.thread, "dosbox:sid");
+
+	Work work          = {};
+	work.type          = WorkType::Render;
+	work.target_frames = renderer.render_ahead_frames;
+	QueueWork(work);
+
+	LOG_MSG("INNOVATION: Rendering on a worker thread %d ms ahead of the mixer",
+	        MIXER_GetPreBufferMs());
+}
+
+void Innovation::StopRenderer()
+{
+	if (!renderer.enabled) {
+		return;
+	}
+
+	renderer.work_fifo.Stop();
+	renderer.audio_frame_fifo.Stop();
+
+	if (renderer.thread.joinable()) {
+		renderer.thread.join();
+	}
+	renderer.enabled = false;
+}
+
 Innovation innovation;
 static void innovation_destroy([[maybe_unused]] Section *sec)
 {
@@ -263,13 +479,15 @@ static void innovation_init(Section *sec)
 	const auto filter_strength_6581  = conf->Get_int("6581filter");
 	const auto filter_strength_8580  = conf->Get_int("8580filter");
 	const auto channel_filter_choice = conf->Get_string("innovation_filter");
+	const auto threaded              = conf->Get_bool("innovation_threaded");
 
 	innovation.Open(model_choice,
 	                clock_choice,
 	                filter_strength_6581,
 	                filter_strength_8580,
 	                port_choice,
-	                channel_filter_choice);
+	                channel_filter_choice,
+	                threaded);
 
 	constexpr auto changeable_at_runtime = true;
 	sec->AddDestroyFunction(&innovation_destroy, changeable_at_runtime);
@@ -326,6 +544,13 @@ static void init_innovation_dosbox_settings(Section_prop& sec_prop)
 	        "Filter for the Innovation audio output:\n"
 	        "  off:       Don't filter the output (default).\n"
 	        "  <custom>:  Custom filter definition; see 'sb_filter' for details.");
+
+	auto* bool_prop = sec_prop.Add_bool("innovation_threaded", when_idle, false);
+	bool_prop->Set_help(
+	        "Render the SID on a separate thread, ahead of the mixer by the 'prebuffer'\n"
+	        "duration (disabled by default). The register writes keep their exact timing,\n"
+	        "but the output is delayed by the prebuffer. This reduces the load on the\n"
+	        "emulation thread on slower multi-core hosts.");
 }
 
 void INNOVATION_AddConfigSection(const ConfigPtr& conf)
@@ -23,12 +23,16 @@
 
 #include "dosbox.h"
 
+#include <future>
 #include <memory>
 #include <queue>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "mixer.h"
 #include "inout.h"
+#include "rwqueue.h"
 
 #include "residfp/SID.h"
 
@@ -37,7 +41,7 @@ public:
 	void Open(const std::string_view model_choice,
 	          const std::string_view clock_choice, int filter_strength_6581,
 	          int filter_strength_8580, int port_choice,
-	          const std::string& channel_filter_choice);
+	          const std::string& channel_filter_choice, bool threaded);
 
 	void Close();
 	~Innovation()
@@ -53,6 +57,52 @@ private:
 	int16_t TallySilence(const int16_t sample);
 	void WriteToPort(io_port_t port, io_val_t value, io_width_t width);
 
+	// Threaded rendering: the register accesses are queued with the number
+	// of chip clocks to run before them, and a worker thread runs the SID
+	// and renders its frames ahead of the mixer
+	enum class WorkType { Render, Write, Read };
+
+	struct Work {
+		int num_clocks = 0;
+		WorkType type  = WorkType::Render;
+		uint8_t reg    = 0;
+		uint8_t val    = 0;
+
+		// Render: the total number of frames to have rendered by now
+		int64_t target_frames = 0;
+
+		// Read: receives the register's value
+		std::promise<uint8_t>* read_result = nullptr;
+	};
+
+	struct {
+		bool enabled       = false;
+		std::thread thread = {};
+
+		RWQueue<Work> work_fifo{1, RWQueueMode::LockFree};
+		RWQueue<float> audio_frame_fifo{1, RWQueueMode::LockFree};
+
+		// Clocks timestamped since the last queued work
+		int num_unsent_clocks = 0;
+
+		// Frames taken by the mixer, and those rendered by the thread
+		int64_t num_consumed_frames = 0;
+		int64_t num_rendered_frames = 0;
+		int render_ahead_frames     = 0;
+
+		// The mixer's and the renderer thread's frame buffers
+		std::vector<float> audio_frames    = {};
+		std::vector<float> rendered_frames = {};
+	} renderer = {};
+
+	void StartRenderer(int sample_rate_hz);
+	void StopRenderer();
+	void RenderThread();
+	void QueueWork(const Work& work);
+	void RunClocks(std::vector<short>& samples, int num_clocks);
+	void RenderFramesUpTo(std::vector<short>& samples, int64_t target_frames);
+	int QueueFrames(const short* samples, int num_samples);
+
 	// Managed objects
 	MixerChannelPtr channel               = nullptr;
 	IO_ReadHandleObject read_handler      = {};
@@ -63,6 +113,7 @@ private:
 	// Initial configuration
 	double chip_clock            = 0.0;
 	double ms_per_clock          = 0.0;
+	double clocks_per_frame      = 0.0;
 	io_port_t base_port          = 0;
 	int idle_after_silent_frames = 0;
 
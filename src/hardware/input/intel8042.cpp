@@ -232,10 +232,13 @@ static size_t buffer_num_used  = 0;
 static size_t waiting_bytes_from_aux = 0;
 static size_t waiting_bytes_from_kbd = 0;
 
-// true = delay timer is in progress
-static bool delay_running = false;
-// true = delay timer expired, event can be sent immediately
-static bool delay_expired = true;
+// The simulated data transfer delay is kept as a deadline; restarting it
+// doesn't touch the PIC queue, and an event only gets scheduled when a byte in
+// the buffer is waiting for the delay to expire
+static double delay_deadline_ms = 0.0;
+// true = delay event is scheduled, at the given time
+static bool delay_event_pending = false;
+static double delay_event_ms    = 0.0;
 
 // Executing command, do not notify devices about readiness for accepting frame
 static bool should_skip_device_notify = false;
@@ -438,20 +441,36 @@ static void maybe_transfer_buffer(); // forward declaration
 
 static void delay_handler(uint32_t /*val*/)
 {
-	delay_running = false;
-	delay_expired = true;
+	delay_event_pending = false;
 
+	// If the delay was restarted in the meantime, this schedules the
+	// event again for the new deadline
 	maybe_transfer_buffer();
 }
 
+static bool is_delay_expired()
+{
+	return PIC_FullIndex() >= delay_deadline_ms;
+}
+
 static void restart_delay_timer(const double time_ms = PortDelayMs)
 {
-	if (delay_running) {
+	delay_deadline_ms = PIC_FullIndex() + time_ms;
+}
+
+static void schedule_delay_event()
+{
+	// An event scheduled for a later deadline would deliver the byte late
+	if (delay_event_pending) {
+		if (delay_event_ms <= delay_deadline_ms) {
+			return;
+		}
 		PIC_RemoveEvents(delay_handler);
 	}
-	PIC_AddEvent(delay_handler, time_ms);
-	delay_running = true;
-	delay_expired = false;
+	const auto now = PIC_FullIndex();
+	PIC_AddEvent(delay_handler, delay_deadline_ms - now);
+	delay_event_pending = true;
+	delay_event_ms      = delay_deadline_ms;
 }
 
 static void maybe_transfer_buffer()
@@ -464,7 +483,8 @@ static void maybe_transfer_buffer()
 
 	// If not set to skip the delay, do not send byte until timer expires
 	const auto idx = buffer_start_idx;
-	if (!delay_expired && !buffer[idx].skip_delay) {
+	if (!buffer[idx].skip_delay && !is_delay_expired()) {
+		schedule_delay_event();
 		return;
 	}
 
@@ -31,6 +31,7 @@
 #include "intel8042.h"
 #include "intel8255.h"
 #include "pic.h"
+#include "replay.h"
 #include "support.h"
 #include "timer.h"
 
@@ -666,6 +667,11 @@ void KEYBOARD_NotifyReadyForFrame()
 
 void KEYBOARD_AddKey(const KBD_KEYS key_type, const bool is_pressed)
 {
+	if (REPLAY_IsIgnoringHostInput()) {
+		return;
+	}
+	REPLAY_RecordKey(key_type, is_pressed);
+
 	if (should_wait_for_secure_mode && !control->SecureMode()) {
 		warn_waiting_for_secure_mode();
 		return;
@@ -33,6 +33,7 @@
 #include "cpu.h"
 #include "math_utils.h"
 #include "pic.h"
+#include "replay.h"
 #include "video.h"
 
 CHECK_NARROWING();
@@ -548,6 +549,11 @@ void MOUSE_EventMoved(const float x_rel, const float y_rel,
 {
 	// Event from GFX
 
+	if (REPLAY_IsIgnoringHostInput()) {
+		return;
+	}
+	REPLAY_RecordMouseMoved(x_rel, y_rel, x_abs, y_abs);
+
 	// Update cursor position and visibility
 	update_cursor_absolute_position(x_abs, y_abs);
 	update_cursor_visibility();
@@ -609,6 +615,11 @@ void MOUSE_EventButton(const MouseButtonId button_id, const bool pressed)
 {
 	// Event from GFX
 
+	if (REPLAY_IsIgnoringHostInput()) {
+		return;
+	}
+	REPLAY_RecordMouseButton(button_id, pressed);
+
 	// Never ignore any button releases - always pass them
 	// to concrete interfaces, they will decide whether to
 	// ignore them or not.
@@ -671,6 +682,11 @@ void MOUSE_EventWheel(const int16_t w_rel)
 {
 	// Event from GFX
 
+	if (REPLAY_IsIgnoringHostInput()) {
+		return;
+	}
+	REPLAY_RecordMouseWheel(w_rel);
+
 	// Drop unneeded events
 	if (should_drop_press_or_wheel()) {
 		return;
@@ -420,6 +420,9 @@ void ManyMouseGlue::HandleEvent(const ManyMouseEvent &event, const bool critical
 			// is consistent across various platforms
 			break;
 		}
+		// Report the movement made before the button change first,
+		// the click has to happen where the mouse actually was
+		ReportMovement(device_idx);
 		MOUSE_EventButton(static_cast<MouseButtonId>(event.item),
 		                  event.value,
 		                  interface_id);
@@ -451,6 +454,21 @@ void ManyMouseGlue::HandleEvent(const ManyMouseEvent &event, const bool critical
 	}
 }
 
+void ManyMouseGlue::ReportMovement(const uint8_t device_idx)
+{
+	if (device_idx >= rel_x.size() ||
+	    (rel_x[device_idx] == 0 && rel_y[device_idx] == 0)) {
+		return;
+	}
+
+	const auto interface_id = physical_devices[device_idx].GetMappedInterfaceId();
+	MOUSE_EventMoved(static_cast<float>(rel_x[device_idx]),
+	                 static_cast<float>(rel_y[device_idx]),
+	                 interface_id);
+	rel_x[device_idx] = 0;
+	rel_y[device_idx] = 0;
+}
+
 void ManyMouseGlue::Tick()
 {
 	assert(mouse_config.capture != MouseCapture::NoMouse);
@@ -463,15 +481,7 @@ void ManyMouseGlue::Tick()
 	// Report accumulated mouse movements
 	assert(rel_x.size() < UINT8_MAX);
 	for (uint8_t idx = 0; idx < rel_x.size(); idx++) {
-		if (rel_x[idx] == 0 && rel_y[idx] == 0)
-			continue;
-
-		const auto interface_id = physical_devices[idx].GetMappedInterfaceId();
-		MOUSE_EventMoved(static_cast<float>(rel_x[idx]),
-		                 static_cast<float>(rel_y[idx]),
-		                 interface_id);
-		rel_x[idx] = 0;
-		rel_y[idx] = 0;
+		ReportMovement(idx);
 	}
 
 	if (is_mapping_in_effect)
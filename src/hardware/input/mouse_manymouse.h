@@ -88,6 +88,7 @@ private:
 
 	void HandleEvent(const ManyMouseEvent &event,
 	                 const bool critical_only = false);
+	void ReportMovement(const uint8_t device_idx);
 
 	bool initialized = false;
 	bool malfunction = false; // once set to false, will stay false forever
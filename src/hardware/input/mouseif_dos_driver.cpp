@@ -259,6 +259,13 @@ static void maybe_start_delay_timer(const uint8_t timer_delay_ms)
 	delay_finished = false;
 }
 
+static void cancel_delay_timer()
+{
+	PIC_RemoveEvents(delay_handler);
+	delay_running  = false;
+	delay_finished = true;
+}
+
 static void maybe_trigger_event()
 {
 	if (!delay_finished) {
@@ -277,8 +284,7 @@ static void maybe_trigger_event()
 static void clear_pending_events()
 {
 	if (delay_running) {
-		PIC_RemoveEvents(delay_handler);
-		delay_running = false;
+		cancel_delay_timer();
 	}
 
 	pending_moved  = false;
@@ -1308,8 +1314,17 @@ void MOUSEDOS_NotifyMoved(const float x_rel, const float y_rel,
 
 void MOUSEDOS_NotifyButton(const MouseButtons12S new_buttons_12S)
 {
+	const bool has_changed = (pending_button_state._data !=
+	                          new_buttons_12S._data);
+
 	pending_button = true;
 	pending_button_state = new_buttons_12S;
+
+	// Button changes shouldn't wait for the rate limiting delay; the
+	// movement gathered so far is reported along with them
+	if (has_changed) {
+		cancel_delay_timer();
+	}
 	maybe_trigger_event();
 }
 
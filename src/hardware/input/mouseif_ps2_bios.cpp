@@ -360,6 +360,13 @@ static void maybe_start_delay_timer(const uint8_t timer_delay_ms)
 	delay_expired = false;
 }
 
+static void cancel_delay_timer()
+{
+	PIC_RemoveEvents(delay_handler);
+	delay_running = false;
+	delay_expired = true;
+}
+
 static bool should_report()
 {
 	return !mode_wrap && !mode_remote && is_reporting;
@@ -704,8 +711,14 @@ void MOUSEPS2_NotifyButton(const MouseButtons12S new_buttons_12S,
 	buttons_all = new_buttons_all;
 	MOUSEPS2_UpdateButtonSquish();
 
-	has_data_for_frame |= (buttons_old._data != buttons._data) ||
-	                      vmm_needs_dummy_event;
+	const bool has_changed = (buttons_old._data != buttons._data);
+	has_data_for_frame |= has_changed || vmm_needs_dummy_event;
+
+	// Button changes shouldn't wait for the sample rate delay; the
+	// movement gathered so far goes out in the same frame
+	if (has_changed) {
+		cancel_delay_timer();
+	}
 	maybe_transfer_frame();
 	vmm_needs_dummy_event = false;
 }
@@ -21,30 +21,23 @@
 
 #include "inout.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <limits>
 #include <cstring>
-#include <unordered_map>
+#include <vector>
 
 #include "setup.h"
 #include "cpu.h"
 #include "../src/cpu/lazyflags.h"
 #include "callback.h"
+#include "guest_stats.h"
+#include "iohandler_containers.h"
+#include "pic.h"
 
 //#define ENABLE_PORTLOG
 
-// type-sized IO handler containers
-extern std::unordered_map<io_port_t, io_read_f> io_read_handlers[io_widths];
-extern std::unordered_map<io_port_t, io_write_f> io_write_handlers[io_widths];
-
-// type-sized IO handler API
-uint8_t read_byte_from_port(const io_port_t port);
-uint16_t read_word_from_port(const io_port_t port);
-uint32_t read_dword_from_port(const io_port_t port);
-void write_byte_to_port(const io_port_t port, const uint8_t val);
-void write_word_to_port(const io_port_t port, const uint16_t val);
-void write_dword_to_port(const io_port_t port, const uint32_t val);
-
 
 struct IOF_Entry {
 	Bitu cs;
@@ -103,6 +96,101 @@ inline void IO_USEC_write_delay() {
 	CPU_IODelayRemoved += delaycyc;
 }
 
+/* Idle polling detection: programs that busy-wait on a port (e.g., the
+ * retrace bit in 3DAh or the keyboard controller status) keep reading the
+ * same value from the same port in a tight loop until some emulated event
+ * changes it. Once this is seen often enough, the rest of the current
+ * cycle slice is skipped like a HLT would, which fast-forwards emulated
+ * time to the next PIC event and lets the host CPU idle. Devices that know
+ * when the value will change, like the joystick's one-shots, set a deadline
+ * so the skip stops there instead.
+ */
+static struct {
+	io_port_t port    = 0;
+	io_width_t width  = io_width_t::byte;
+	io_val_t value    = 0;
+	int64_t last_time = 0;
+	int repeats       = 0;
+
+	// set by the read handler for the current read only
+	bool has_deadline  = false;
+	double deadline_ms = 0.0;
+} polling = {};
+
+constexpr int PollingRepeatsToSkip = 16;
+constexpr int32_t PollingMaxLoopCycles = 64;
+
+static int64_t polling_time_now()
+{
+	return static_cast<int64_t>(PIC_Ticks) * CPU_CycleMax + PIC_TickIndexND();
+}
+
+void IO_SetPollingDeadline(const double deadline_ms)
+{
+	polling.has_deadline = true;
+	polling.deadline_ms  = deadline_ms;
+}
+
+// Returns the number of cycles the polling loop can be skipped ahead by
+static int32_t get_polling_skip_cycles()
+{
+	if (!polling.has_deadline) {
+		return CPU_Cycles;
+	}
+	const auto ms_left = polling.deadline_ms - PIC_FullIndex();
+	if (ms_left <= 0.0) {
+		return 0;
+	}
+	const auto cycles_left = std::ceil(ms_left * CPU_CycleMax);
+	return cycles_left < CPU_Cycles ? static_cast<int32_t>(cycles_left)
+	                                : CPU_Cycles;
+}
+
+static void reset_polling_detection()
+{
+	polling.repeats = 0;
+}
+
+static void check_polling_loop(const io_port_t port, const io_width_t width,
+                               const io_val_t value)
+{
+	if (!CPU_SkipIdlePolling) {
+		polling.has_deadline = false;
+		return;
+	}
+	const auto now = polling_time_now();
+
+	// a tight loop only spends the read delay plus a few instructions
+	// between two reads
+	const auto max_loop_cycles = CPU_CycleMax / IODELAY_READ_MICROSk +
+	                             PollingMaxLoopCycles;
+
+	const bool is_same_read = port == polling.port && width == polling.width &&
+	                          value == polling.value;
+	const bool is_tight_loop = (now - polling.last_time) <= max_loop_cycles;
+
+	if (is_same_read && is_tight_loop) {
+		++polling.repeats;
+	} else {
+		polling.port    = port;
+		polling.width   = width;
+		polling.value   = value;
+		polling.repeats = 0;
+	}
+	polling.last_time = now;
+
+	if (polling.repeats >= PollingRepeatsToSkip && CPU_Cycles > 0) {
+		const auto skip_cycles = get_polling_skip_cycles();
+
+		// continue measuring from where the skip lands, so the loop
+		// keeps being recognised after the next event
+		polling.last_time += skip_cycles;
+		CPU_IODelayRemoved += skip_cycles;
+		CPU_Cycles -= skip_cycles;
+	}
+	polling.has_deadline = false;
+}
+
 #ifdef ENABLE_PORTLOG
 static uint8_t crtc_index = 0;
 
@@ -167,7 +255,9 @@ void log_io(io_width_t width, bool write, io_port_t port, io_val_t val)
 
 void IO_WriteB(io_port_t port, uint8_t val)
 {
+	++guest_stats.io_port_accesses[port];
 	log_io(io_width_t::byte, true, port, val);
+	reset_polling_detection();
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 1))) {
 		const auto old_lflags = lflags;
 		const auto old_cpudecoder=cpudecoder;
@@ -201,7 +291,9 @@ void IO_WriteB(io_port_t port, uint8_t val)
 
 void IO_WriteW(io_port_t port, uint16_t val)
 {
+	++guest_stats.io_port_accesses[port];
 	log_io(io_width_t::word, true, port, val);
+	reset_polling_detection();
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 2))) {
 		const auto old_lflags = lflags;
 		const auto old_cpudecoder=cpudecoder;
@@ -235,7 +327,9 @@ void IO_WriteW(io_port_t port, uint16_t val)
 
 void IO_WriteD(io_port_t port, uint32_t val)
 {
+	++guest_stats.io_port_accesses[port];
 	log_io(io_width_t::dword, true, port, val);
+	reset_polling_detection();
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 4))) {
 		const auto old_lflags = lflags;
 		const auto old_cpudecoder=cpudecoder;
@@ -268,6 +362,7 @@ void IO_WriteD(io_port_t port, uint32_t val)
 
 uint8_t IO_ReadB(io_port_t port)
 {
+	++guest_stats.io_port_accesses[port];
 	uint8_t retval;
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 1))) {
 		const auto old_lflags = lflags;
@@ -298,6 +393,7 @@ uint8_t IO_ReadB(io_port_t port)
 	} else {
 		IO_USEC_read_delay();
 		retval = read_byte_from_port(port);
+		check_polling_loop(port, io_width_t::byte, retval);
 	}
 	log_io(io_width_t::byte, false, port, retval);
 	return retval;
@@ -305,6 +401,7 @@ uint8_t IO_ReadB(io_port_t port)
 
 uint16_t IO_ReadW(io_port_t port)
 {
+	++guest_stats.io_port_accesses[port];
 	uint16_t retval;
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 2))) {
 		const auto old_lflags = lflags;
@@ -334,6 +431,7 @@ uint16_t IO_ReadW(io_port_t port)
 	} else {
 		IO_USEC_read_delay();
 		retval = read_word_from_port(port);
+		check_polling_loop(port, io_width_t::word, retval);
 	}
 	log_io(io_width_t::word, false, port, retval);
 	return retval;
@@ -341,6 +439,7 @@ uint16_t IO_ReadW(io_port_t port)
 
 uint32_t IO_ReadD(io_port_t port)
 {
+	++guest_stats.io_port_accesses[port];
 	uint32_t retval;
 	if (GETFLAG(VM) && (CPU_IO_Exception(port, 4))) {
 		const auto old_lflags = lflags;
@@ -369,6 +468,7 @@ uint32_t IO_ReadD(io_port_t port)
 		cpudecoder=old_cpudecoder;
 	} else {
 		retval = read_dword_from_port(port);
+		check_polling_loop(port, io_width_t::dword, retval);
 	}
 
 	log_io(io_width_t::dword, false, port, retval);
@@ -377,25 +477,69 @@ uint32_t IO_ReadD(io_port_t port)
 
 
 class IO final : public Module_base {
+private:
+	static void LogBusiestPorts()
+	{
+		constexpr size_t NumPortsToLog = 8;
+
+		struct PortAccesses {
+			io_port_t port   = 0;
+			uint64_t reads  = 0;
+			uint64_t writes = 0;
+		};
+		std::vector<PortAccesses> busiest = {};
+
+		for (uint32_t p = 0; p <= UINT16_MAX; ++p) {
+			const auto port = static_cast<io_port_t>(p);
+
+			PortAccesses accesses = {port, 0, 0};
+			for (uint8_t i = 0; i < io_widths; ++i) {
+				accesses.reads += io_read_handlers[i].GetAccessCount(port);
+				accesses.writes += io_write_handlers[i].GetAccessCount(port);
+			}
+			if (accesses.reads || accesses.writes) {
+				busiest.push_back(accesses);
+			}
+		}
+
+		const auto by_total = [](const PortAccesses& a, const PortAccesses& b) {
+			return (a.reads + a.writes) > (b.reads + b.writes);
+		};
+		const auto num_ports = std::min(busiest.size(), NumPortsToLog);
+		std::partial_sort(busiest.begin(),
+		                  busiest.begin() + num_ports,
+		                  busiest.end(),
+		                  by_total);
+
+		for (size_t i = 0; i < num_ports; ++i) {
+			LOG_DEBUG("IOBUS: Port %04Xh: %llu reads, %llu writes",
+			          busiest[i].port,
+			          static_cast<unsigned long long>(busiest[i].reads),
+			          static_cast<unsigned long long>(busiest[i].writes));
+		}
+	}
+
 public:
 	IO(Section* configuration):Module_base(configuration){
 		iof_queue.used = 0;
 	}
 	~IO()
 	{
+		LogBusiestPorts();
+
 		[[maybe_unused]] size_t total_bytes = 0u;
 		for (uint8_t i = 0; i < io_widths; ++i) {
-			const auto readers = io_read_handlers[i].size();
-			const auto writers = io_write_handlers[i].size();
+			const auto readers = io_read_handlers[i].Size();
+			const auto writers = io_write_handlers[i].Size();
 			LOG_DEBUG("IOBUS: Releasing %d read and %d write %d-bit port handlers",
 			          static_cast<int>(readers),
 			          static_cast<int>(writers),
 			          8 << i);
 
-			total_bytes += readers * sizeof(io_read_f) + sizeof(io_read_handlers[i]);
-			total_bytes += writers * sizeof(io_write_f) + sizeof(io_write_handlers[i]);
-			io_read_handlers[i].clear();
-			io_write_handlers[i].clear();
+			total_bytes += io_read_handlers[i].AllocatedBytes();
+			total_bytes += io_write_handlers[i].AllocatedBytes();
+			io_read_handlers[i].Clear();
+			io_write_handlers[i].Clear();
 		}
 		LOG_DEBUG("IOBUS: Handlers consumed %d total bytes",
 		          static_cast<int>(total_bytes));
@@ -19,15 +19,14 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
-#include "dosbox.h"
+#include "iohandler_containers.h"
 
 #include <cassert>
 #include <cstring>
 #include <functional>
 #include <limits>
-#include <unordered_map>
 
-#include "inout.h"
+#include "dosbox.h"
 #include "support.h"
 
 void IO_ReadHandleObject::Uninstall(){
@@ -55,12 +54,12 @@ IO_WriteHandleObject::~IO_WriteHandleObject(){
 }
 
 // type-sized IO handlers
-std::unordered_map<io_port_t, io_read_f> io_read_handlers[io_widths] = {};
+IoHandlerTable<io_read_f> io_read_handlers[io_widths] = {};
 constexpr auto &io_read_byte_handler = io_read_handlers[0];
 constexpr auto &io_read_word_handler = io_read_handlers[1];
 constexpr auto &io_read_dword_handler = io_read_handlers[2];
 
-std::unordered_map<io_port_t, io_write_f> io_write_handlers[io_widths] = {};
+IoHandlerTable<io_write_f> io_write_handlers[io_widths] = {};
 constexpr auto &io_write_byte_handler = io_write_handlers[0];
 constexpr auto &io_write_word_handler = io_write_handlers[1];
 constexpr auto &io_write_dword_handler = io_write_handlers[2];
@@ -73,31 +72,33 @@ constexpr io_val_t blocked_read(const io_port_t, const io_width_t)
 // type-sized IO handler API
 uint8_t read_byte_from_port(const io_port_t port)
 {
-	const auto [it, was_blocked] = io_read_byte_handler.emplace(port, blocked_read);
-	if (was_blocked)
+	auto reader = io_read_byte_handler.Find(port);
+	if (!reader) {
 		LOG(LOG_IO, LOG_WARN)("Unhandled read from port %04Xh; blocking", port);
-	return it->second(port, io_width_t::byte) & 0xff;
+		io_read_byte_handler.Set(port, blocked_read);
+		reader = io_read_byte_handler.Find(port);
+		assert(reader);
+	}
+	return (*reader)(port, io_width_t::byte) & 0xff;
 }
 
 uint16_t read_word_from_port(const io_port_t port)
 {
-	const auto reader = io_read_word_handler.find(port);
-	const auto value = reader != io_read_word_handler.end()
-	                           ? (reader->second(port, io_width_t::word) & 0xffff)
-	                           : static_cast<io_val_t>(
-	                                     read_byte_from_port(port) |
-	                                     (read_byte_from_port(port + 1) << 8));
+	const auto reader = io_read_word_handler.Find(port);
+	const auto value = reader ? ((*reader)(port, io_width_t::word) & 0xffff)
+	                          : static_cast<io_val_t>(
+	                                    read_byte_from_port(port) |
+	                                    (read_byte_from_port(port + 1) << 8));
 	return check_cast<uint16_t>(value);
 }
 
 uint32_t read_dword_from_port(const io_port_t port)
 {
-	const auto reader = io_read_dword_handler.find(port);
-	const auto value = reader != io_read_dword_handler.end()
-	                           ? reader->second(port, io_width_t::dword)
-	                           : static_cast<io_val_t>(
-	                                     read_word_from_port(port) |
-	                                     (read_word_from_port(port + 2) << 16));
+	const auto reader = io_read_dword_handler.Find(port);
+	const auto value = reader ? (*reader)(port, io_width_t::dword)
+	                          : static_cast<io_val_t>(
+	                                    read_word_from_port(port) |
+	                                    (read_word_from_port(port + 2) << 16));
 	assert(value <= UINT32_MAX);
 	return static_cast<uint32_t>(value);
 }
@@ -109,19 +110,23 @@ constexpr void blocked_write(const io_port_t, const io_val_t, const io_width_t)
 
 void write_byte_to_port(const io_port_t port, const uint8_t val)
 {
-	const auto [it, was_blocked] = io_write_byte_handler.emplace(port, blocked_write);
-	if (was_blocked)
+	auto writer = io_write_byte_handler.Find(port);
+	if (!writer) {
 		LOG(LOG_IO, LOG_WARN)("Unhandled write of value 0x%02x"
 		                      " (%u) to port %04Xh; blocking",
 		                      val, val, port);
-	it->second(port, val, io_width_t::byte);
+		io_write_byte_handler.Set(port, blocked_write);
+		writer = io_write_byte_handler.Find(port);
+		assert(writer);
+	}
+	(*writer)(port, val, io_width_t::byte);
 }
 
 void write_word_to_port(const io_port_t port, const uint16_t val)
 {
-	const auto writer = io_write_word_handler.find(port);
-	if (writer != io_write_word_handler.end()) {
-		writer->second(port, val, io_width_t::word);
+	const auto writer = io_write_word_handler.Find(port);
+	if (writer) {
+		(*writer)(port, val, io_width_t::word);
 	} else {
 		write_byte_to_port(port, static_cast<uint8_t>(val & 0xff));
 		write_byte_to_port(port + 1, static_cast<uint8_t>(val >> 8));
@@ -130,9 +135,9 @@ void write_word_to_port(const io_port_t port, const uint16_t val)
 
 void write_dword_to_port(const io_port_t port, const uint32_t val)
 {
-	const auto writer = io_write_dword_handler.find(port);
-	if (writer != io_write_dword_handler.end()) {
-		writer->second(port, val, io_width_t::dword);
+	const auto writer = io_write_dword_handler.Find(port);
+	if (writer) {
+		(*writer)(port, val, io_width_t::dword);
 	} else {
 		write_word_to_port(port, static_cast<uint16_t>(val & 0xffff));
 		write_word_to_port(port + 2, static_cast<uint16_t>(val >> 16));
@@ -145,11 +150,11 @@ void IO_RegisterReadHandler(io_port_t port,
                             io_port_t range)
 {
 	while (range--) {
-		io_read_byte_handler[port] = handler;
+		io_read_byte_handler.Set(port, handler);
 		if (max_width == io_width_t::word || max_width == io_width_t::dword)
-			io_read_word_handler[port] = handler;
+			io_read_word_handler.Set(port, handler);
 		if (max_width == io_width_t::dword)
-			io_read_dword_handler[port] = handler;
+			io_read_dword_handler.Set(port, handler);
 		++port;
 	}
 }
@@ -160,11 +165,11 @@ void IO_RegisterWriteHandler(io_port_t port,
                              io_port_t range)
 {
 	while (range--) {
-		io_write_byte_handler[port] = handler;
+		io_write_byte_handler.Set(port, handler);
 		if (max_width == io_width_t::word || max_width == io_width_t::dword)
-			io_write_word_handler[port] = handler;
+			io_write_word_handler.Set(port, handler);
 		if (max_width == io_width_t::dword)
-			io_write_dword_handler[port] = handler;
+			io_write_dword_handler.Set(port, handler);
 		++port;
 	}
 }
@@ -174,11 +179,11 @@ void IO_FreeReadHandler(io_port_t port,
                         io_port_t range)
 {
 	while (range--) {
-		io_read_byte_handler.erase(port);
+		io_read_byte_handler.Erase(port);
 		if (max_width == io_width_t::word || max_width == io_width_t::dword)
-			io_read_word_handler.erase(port);
+			io_read_word_handler.Erase(port);
 		if (max_width == io_width_t::dword)
-			io_read_dword_handler.erase(port);
+			io_read_dword_handler.Erase(port);
 		++port;
 	}
 }
@@ -188,11 +193,11 @@ void IO_FreeWriteHandler(io_port_t port,
                          io_port_t range)
 {
 	while (range--) {
-		io_write_byte_handler.erase(port);
+		io_write_byte_handler.Erase(port);
 		if (width == io_width_t::word || width == io_width_t::dword)
-			io_write_word_handler.erase(port);
+			io_write_word_handler.Erase(port);
 		if (width == io_width_t::dword)
-			io_write_dword_handler.erase(port);
+			io_write_dword_handler.Erase(port);
 		++port;
 	}
 }
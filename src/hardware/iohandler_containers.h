@@ -0,0 +1,143 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_IOHANDLER_CONTAINERS_H
+#define DOSBOX_IOHANDLER_CONTAINERS_H
+
+#include "inout.h"
+
+#include <array>
+#include <cassert>
+#include <memory>
+
+// Directly indexed table of port handlers
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The 64K port space is split into 256 pages of 256 ports. Pages are only
+// allocated once a handler gets registered in them, so the handful of
+// pages that are actually used (ISA sound cards, VGA, the PIC/PIT/DMA
+// block) cost about 8 KB each, and a lookup costs two array indexes
+// instead of a hash lookup.
+//
+// Every dispatched access is also counted per port, which gives a cheap
+// profile of the busiest ports (e.g., retrace polling on 3DAh).
+
+template <typename Handler>
+class IoHandlerTable {
+public:
+	static constexpr size_t PortsPerPage = 256;
+	static constexpr size_t NumPages = (UINT16_MAX + 1) / PortsPerPage;
+
+	// Returns the handler for the port, or nullptr if none is registered
+	Handler* Find(const io_port_t port)
+	{
+		const auto& page = pages[port / PortsPerPage];
+		if (!page) {
+			return nullptr;
+		}
+		const auto index = port % PortsPerPage;
+		auto& handler    = page->handlers[index];
+		if (!handler) {
+			return nullptr;
+		}
+		++page->accesses[index];
+		return &handler;
+	}
+
+	// Registers a handler for the port, replacing any existing one
+	void Set(const io_port_t port, const Handler& handler)
+	{
+		auto& page = pages[port / PortsPerPage];
+		if (!page) {
+			page = std::make_unique<Page>();
+		}
+		auto& entry = page->handlers[port % PortsPerPage];
+		if (!entry) {
+			++num_handlers;
+		}
+		entry = handler;
+	}
+
+	void Erase(const io_port_t port)
+	{
+		const auto& page = pages[port / PortsPerPage];
+		if (!page) {
+			return;
+		}
+		auto& entry = page->handlers[port % PortsPerPage];
+		if (entry) {
+			entry = nullptr;
+			assert(num_handlers > 0);
+			--num_handlers;
+		}
+	}
+
+	size_t Size() const
+	{
+		return num_handlers;
+	}
+
+	size_t AllocatedBytes() const
+	{
+		size_t bytes = sizeof(*this);
+		for (const auto& page : pages) {
+			if (page) {
+				bytes += sizeof(Page);
+			}
+		}
+		return bytes;
+	}
+
+	uint32_t GetAccessCount(const io_port_t port) const
+	{
+		const auto& page = pages[port / PortsPerPage];
+		return page ? page->accesses[port % PortsPerPage] : 0;
+	}
+
+	void Clear()
+	{
+		for (auto& page : pages) {
+			page.reset();
+		}
+		num_handlers = 0;
+	}
+
+private:
+	struct Page {
+		std::array<Handler, PortsPerPage> handlers   = {};
+		std::array<uint32_t, PortsPerPage> accesses = {};
+	};
+
+	std::array<std::unique_ptr<Page>, NumPages> pages = {};
+	size_t num_handlers = 0;
+};
+
+// type-sized IO handler containers
+extern IoHandlerTable<io_read_f> io_read_handlers[io_widths];
+extern IoHandlerTable<io_write_f> io_write_handlers[io_widths];
+
+// type-sized IO handler API
+uint8_t read_byte_from_port(const io_port_t port);
+uint16_t read_word_from_port(const io_port_t port);
+uint32_t read_dword_from_port(const io_port_t port);
+void write_byte_to_port(const io_port_t port, const uint8_t val);
+void write_word_to_port(const io_port_t port, const uint16_t val);
+void write_dword_to_port(const io_port_t port, const uint32_t val);
+
+#endif
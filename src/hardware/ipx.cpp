@@ -23,10 +23,15 @@
 
 #include <SDL_net.h>
 
+#include <atomic>
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "cross.h"
 #include "string_utils.h"
@@ -63,6 +68,83 @@ static RealPt ipx_callback;
 
 SDLNet_SocketSet clientSocketSet;
 
+// The client's socket is read on its own thread, which waits on the socket
+// set and queues the packets until the emulation thread hands them to the
+// ECBs, so incoming packets don't wait for the next tick's single read
+static std::thread ipx_client_thread;
+static std::atomic_bool ipx_client_running = false;
+
+static std::deque<std::vector<uint8_t>> received_packets;
+static std::mutex received_packets_mutex;
+static std::atomic<size_t> num_received_packets = 0;
+
+static void receive_client_packets()
+{
+	UDPpacket inPacket;
+	inPacket.data    = (Uint8 *)recvBuffer;
+	inPacket.maxlen  = IPXBUFFERSIZE;
+	inPacket.channel = UDPChannel;
+
+	while (ipx_client_running) {
+		constexpr auto TimeoutMs = 100;
+		const int num_ready = SDLNet_CheckSockets(clientSocketSet, TimeoutMs);
+		if (num_ready == -1) {
+			LOG_ERR("IPX: %s", SDLNet_GetError());
+			continue;
+		}
+		// Its amazing how much simpler UDP is than TCP
+		while (num_ready > 0 && SDLNet_UDP_Recv(ipxClientSocket, &inPacket) > 0) {
+			std::lock_guard<std::mutex> lock(received_packets_mutex);
+			received_packets.emplace_back(inPacket.data,
+			                              inPacket.data + inPacket.len);
+			num_received_packets = received_packets.size();
+		}
+	}
+}
+
+static void start_client_thread()
+{
+	clientSocketSet = SDLNet_AllocSocketSet(1);
+	if (!clientSocketSet || SDLNet_UDP_AddSocket(clientSocketSet, ipxClientSocket) == -1) {
+		LOG_ERR("IPX: %s", SDLNet_GetError());
+		return;
+	}
+	ipx_client_running = true;
+	ipx_client_thread  = std::thread(receive_client_packets);
+}
+
+static void stop_client_thread()
+{
+	ipx_client_running = false;
+	if (ipx_client_thread.joinable()) {
+		ipx_client_thread.join();
+	}
+	if (clientSocketSet) {
+		SDLNet_FreeSocketSet(clientSocketSet);
+		clientSocketSet = nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(received_packets_mutex);
+	received_packets.clear();
+	num_received_packets = 0;
+}
+
+// Takes the oldest packet received by the client thread
+static bool pop_received_packet(std::vector<uint8_t>& packet)
+{
+	if (num_received_packets == 0) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(received_packets_mutex);
+	if (received_packets.empty()) {
+		return false;
+	}
+	packet = std::move(received_packets.front());
+	received_packets.pop_front();
+	num_received_packets = received_packets.size();
+	return true;
+}
+
 packetBuffer incomingPacket;
 
 static uint16_t socketCount;
@@ -608,15 +690,10 @@ static void receivePacket(uint8_t *buffer, int16_t bufSize) {
 }
 
 static void IPX_ClientLoop(void) {
-	int numrecv;
-	UDPpacket inPacket;
-	inPacket.data = (Uint8 *)recvBuffer;
-	inPacket.maxlen = IPXBUFFERSIZE;
-	inPacket.channel = UDPChannel;
-
-	// Its amazing how much simpler UDP is than TCP
-	numrecv = SDLNet_UDP_Recv(ipxClientSocket, &inPacket);
-	if(numrecv) receivePacket(inPacket.data, inPacket.len);
+	std::vector<uint8_t> packet = {};
+	while (pop_received_packet(packet)) {
+		receivePacket(packet.data(), check_cast<int16_t>(packet.size()));
+	}
 }
 
 
@@ -625,6 +702,7 @@ void DisconnectFromServer(bool unexpected) {
 	if(incomingPacket.connected) {
 		incomingPacket.connected = false;
 		TIMER_DelTickHandler(&IPX_ClientLoop);
+		stop_client_thread();
 		SDLNet_UDP_Close(ipxClientSocket);
 	}
 }
@@ -739,17 +817,9 @@ static void sendPacket(ECBClass* sendecb) {
 }
 
 static bool pingCheck(IPXHeader * outHeader) {
-	char buffer[1024];
-	UDPpacket regPacket;
-	IPXHeader *regHeader;
-	regPacket.data = (Uint8 *)buffer;
-	regPacket.maxlen = sizeof(buffer);
-	regPacket.channel = UDPChannel;
-	regHeader = (IPXHeader *)buffer;
-
-	const int result = SDLNet_UDP_Recv(ipxClientSocket, &regPacket);
-	if (result != 0) {
-		memcpy(outHeader, regHeader, sizeof(IPXHeader));
+	std::vector<uint8_t> packet = {};
+	if (pop_received_packet(packet) && packet.size() >= sizeof(IPXHeader)) {
+		memcpy(outHeader, packet.data(), sizeof(IPXHeader));
 		return true;
 	}
 	return false;
@@ -826,6 +896,7 @@ bool ConnectToServer(const char* strAddr)
 				LOG_MSG("IPX: Connected to server.  IPX address is %d:%d:%d:%d:%d:%d", CONVIPX(localIpxAddr.netnode));
 
 				incomingPacket.connected = true;
+				start_client_thread();
 				TIMER_AddTickHandler(&IPX_ClientLoop);
 				return true;
 			}
@@ -1026,12 +1097,14 @@ public:
 				}
 				if(isIpxServer) {
 					WriteOut("List of active connections:\n\n");
-					int i;
-					IPaddress *ptrAddr;
-					for(i=0;i<SOCKETTABLESIZE;i++) {
-						if(IPX_isConnectedToServer(i,&ptrAddr)) {
-							WriteOut("     %d.%d.%d.%d from port %d\n", CONVIP(ptrAddr->host), SDLNet_Read16(&ptrAddr->port));
-						}
+					for (const auto& client : IPX_GetServerClients()) {
+						WriteOut("     %d.%d.%d.%d from port %d: %" PRIu64 " packets (%" PRIu64 " bytes) in, %" PRIu64 " packets (%" PRIu64 " bytes) out\n",
+						         CONVIP(client.address.host),
+						         SDLNet_Read16(&client.address.port),
+						         client.packets_received,
+						         client.bytes_received,
+						         client.packets_sent,
+						         client.bytes_sent);
 					}
 					WriteOut("\n");
 				}
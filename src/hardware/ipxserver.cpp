@@ -21,7 +21,10 @@
 #if C_IPX
 
 #include <atomic>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "ipx.h"
 #include "ipxserver.h"
@@ -33,10 +36,26 @@ static IPaddress ipxServerIp;     // IPAddress for server's listening port
 static UDPsocket ipxServerSocket; // Listening server socket
 static SDLNet_SocketSet socket_set = nullptr;
 
-static packetBuffer connBuffer[SOCKETTABLESIZE];
-
 static uint8_t inBuffer[IPXBUFFERSIZE];
-static IPaddress ipconn[SOCKETTABLESIZE]; // Active TCP/IP connection
+
+// The connected clients, looked up by their UDP address. The server thread
+// updates them, and the IPXNET command reads them, so they're guarded by a
+// mutex.
+static std::vector<IpxServerClient> clients;
+static std::unordered_map<uint64_t, size_t> client_index_by_address;
+static std::mutex clients_mutex;
+
+static uint64_t address_key(const uint32_t host, const uint16_t port)
+{
+	return (static_cast<uint64_t>(host) << 16) | port;
+}
+
+static IpxServerClient* find_client(const uint32_t host, const uint16_t port)
+{
+	const auto it = client_index_by_address.find(address_key(host, port));
+	return (it == client_index_by_address.end()) ? nullptr
+	                                             : &clients[it->second];
+}
 
 static std::thread ipx_server_thread;
 static std::atomic_bool ipx_server_running = false;
@@ -67,59 +86,72 @@ static void closeSocket(uint16_t sockidx) {
 */
 
 static void sendIPXPacket(uint8_t *buffer, int16_t bufSize) {
-	uint16_t srcport, destport;
-	uint32_t srchost, desthost;
-	UDPpacket outPacket;
-	outPacket.channel = -1;
-	outPacket.data = buffer;
-	outPacket.len = bufSize;
-	outPacket.maxlen = bufSize;
 	IPXHeader *tmpHeader;
 	tmpHeader = (IPXHeader *)buffer;
 
-	srchost = tmpHeader->src.addr.byIP.host;
-	desthost = tmpHeader->dest.addr.byIP.host;
+	const uint32_t srchost = tmpHeader->src.addr.byIP.host;
+	const uint32_t desthost = tmpHeader->dest.addr.byIP.host;
+
+	const uint16_t srcport = tmpHeader->src.addr.byIP.port;
+	const uint16_t destport = tmpHeader->dest.addr.byIP.port;
+
+	auto make_packet = [&](const IPaddress& address) {
+		UDPpacket outPacket;
+		outPacket.channel = UDP_UNICAST;
+		outPacket.data = buffer;
+		outPacket.len = bufSize;
+		outPacket.maxlen = bufSize;
+		outPacket.address = address;
+		return outPacket;
+	};
 
-	srcport = tmpHeader->src.addr.byIP.port;
-	destport = tmpHeader->dest.addr.byIP.port;
+	auto count_sent = [&](IpxServerClient& client) {
+		++client.packets_sent;
+		client.bytes_sent += static_cast<uint64_t>(bufSize);
+	};
 
 	if(desthost == 0xffffffff) {
-		// Broadcast
-		for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
-			if(connBuffer[i].connected && ((ipconn[i].host != srchost)||(ipconn[i].port!=srcport))) {
-				outPacket.address = ipconn[i];
-				const int result = SDLNet_UDP_Send(ipxServerSocket,
-				                                   UDP_UNICAST,
-				                                   &outPacket);
-				if (result == 0) {
-					LOG_MSG("IPXSERVER: %s", SDLNet_GetError());
-					continue;
-				}
-				//LOG_MSG("IPXSERVER: Packet of %d bytes sent from %d.%d.%d.%d to %d.%d.%d.%d (BROADCAST) (%x CRC)", bufSize, CONVIP(srchost), CONVIP(ipconn[i].host), packetCRC(&buffer[30], bufSize-30));
+		// Broadcast; all the copies go out with a single call
+		std::vector<UDPpacket> packets = {};
+		std::vector<UDPpacket*> packet_ptrs = {};
+		packets.reserve(clients.size());
+
+		for (auto& client : clients) {
+			if ((client.address.host != srchost) || (client.address.port != srcport)) {
+				packets.push_back(make_packet(client.address));
+				count_sent(client);
 			}
 		}
-	} else {
+		if (packets.empty()) {
+			return;
+		}
+		for (auto& packet : packets) {
+			packet_ptrs.push_back(&packet);
+		}
+		const int num_sent = SDLNet_UDP_SendV(ipxServerSocket,
+		                                      packet_ptrs.data(),
+		                                      static_cast<int>(packet_ptrs.size()));
+		if (num_sent < static_cast<int>(packet_ptrs.size())) {
+			LOG_MSG("IPXSERVER: %s", SDLNet_GetError());
+		}
+	} else if (auto client = find_client(desthost, destport); client) {
 		// Specific address
-		for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
-			if((connBuffer[i].connected) && (ipconn[i].host == desthost) && (ipconn[i].port == destport)) {
-				outPacket.address = ipconn[i];
-				const int result = SDLNet_UDP_Send(ipxServerSocket,
-				                                   UDP_UNICAST,
-				                                   &outPacket);
-				if (result == 0) {
-					LOG_MSG("IPXSERVER: %s", SDLNet_GetError());
-					continue;
-				}
-				//LOG_MSG("IPXSERVER: Packet sent from %d.%d.%d.%d to %d.%d.%d.%d", CONVIP(srchost), CONVIP(desthost));
-			}
+		auto outPacket = make_packet(client->address);
+		const int result = SDLNet_UDP_Send(ipxServerSocket,
+		                                   UDP_UNICAST,
+		                                   &outPacket);
+		if (result == 0) {
+			LOG_MSG("IPXSERVER: %s", SDLNet_GetError());
+			return;
 		}
+		count_sent(*client);
 	}
 }
 
-bool IPX_isConnectedToServer(Bits tableNum, IPaddress ** ptrAddr) {
-	if(tableNum >= SOCKETTABLESIZE) return false;
-	*ptrAddr = &ipconn[tableNum];
-	return connBuffer[tableNum].connected;
+std::vector<IpxServerClient> IPX_GetServerClients()
+{
+	std::lock_guard<std::mutex> lock(clients_mutex);
+	return clients;
 }
 
 static void ackClient(IPaddress clientAddr) {
@@ -173,31 +205,45 @@ static void IPX_ServerLoop() {
 			// Null destination node means its a server registration packet
 			if(tmpHeader->dest.addr.byIP.host == 0x0) {
 				UnpackIP(tmpHeader->src.addr.byIP, &tmpAddr);
-				for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
-					if(!connBuffer[i].connected) {
-						// Use prefered host IP rather than the reported source IP
-						// It may be better to use the reported source
-						ipconn[i] = inPacket.address;
-
-						connBuffer[i].connected = true;
-						host = ipconn[i].host;
-						LOG_MSG("IPXSERVER: Connect from %d.%d.%d.%d", CONVIP(host));
-						ackClient(inPacket.address);
-						return;
-					} else {
-						if((ipconn[i].host == tmpAddr.host) && (ipconn[i].port == tmpAddr.port)) {
-
-							LOG_MSG("IPXSERVER: Reconnect from %d.%d.%d.%d", CONVIP(tmpAddr.host));
-							// Update anonymous port number if changed
-							ipconn[i].port = inPacket.address.port;
-							ackClient(inPacket.address);
-							return;
-						}
-					}
+
+				std::lock_guard<std::mutex> lock(clients_mutex);
+				if (auto client = find_client(tmpAddr.host, tmpAddr.port); client) {
+					LOG_MSG("IPXSERVER: Reconnect from %d.%d.%d.%d", CONVIP(tmpAddr.host));
+					// Update anonymous port number if changed
+					client_index_by_address.erase(address_key(tmpAddr.host, tmpAddr.port));
+					client->address.port = inPacket.address.port;
+					client_index_by_address[address_key(client->address.host,
+					                                    client->address.port)] =
+					        static_cast<size_t>(client - clients.data());
+					ackClient(inPacket.address);
+				} else if (clients.size() < IpxServerMaxClients) {
+					// Use prefered host IP rather than the reported source IP
+					// It may be better to use the reported source
+					IpxServerClient new_client = {};
+					new_client.address = inPacket.address;
+
+					client_index_by_address[address_key(inPacket.address.host,
+					                                    inPacket.address.port)] =
+					        clients.size();
+					clients.push_back(new_client);
+
+					host = inPacket.address.host;
+					LOG_MSG("IPXSERVER: Connect from %d.%d.%d.%d", CONVIP(host));
+					ackClient(inPacket.address);
+				} else {
+					LOG_WARNING("IPXSERVER: Refused connection from %d.%d.%d.%d, the server is full",
+					            CONVIP(tmpAddr.host));
 				}
+				return;
 			}
 		}
 
+		std::lock_guard<std::mutex> lock(clients_mutex);
+		if (auto client = find_client(inPacket.address.host, inPacket.address.port); client) {
+			++client->packets_received;
+			client->bytes_received += static_cast<uint64_t>(inPacket.len);
+		}
+
 		// IPX packet is complete.  Now interpret IPX header and send to respective IP address
 		sendIPXPacket((uint8_t*)inPacket.data,
 		              static_cast<int16_t>(inPacket.len));
@@ -223,8 +269,10 @@ bool IPX_StartServer(uint16_t portnum)
 		ipxServerSocket = SDLNet_UDP_Open(portnum);
 		if(!ipxServerSocket) return false;
 
-		for (auto& i : connBuffer) {
-			i.connected = false;
+		{
+			std::lock_guard<std::mutex> lock(clients_mutex);
+			clients.clear();
+			client_index_by_address.clear();
 		}
 
 		if (!socket_set) {
@@ -18,9 +18,11 @@
 
 #include "joystick.h"
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
 #include <cstring>
+#include <limits>
 
 #include "control.h"
 #include "inout.h"
@@ -218,19 +220,54 @@ static uint8_t read_p201(io_port_t, io_width_t)
 	return ret;
 }
 
+// The axis bits of the timed port only change when one of the one-shots times
+// out, so they're worked out once per timeout instead of on every read of the
+// game's polling loop.
+constexpr auto TimedAxesOutdated = std::numeric_limits<double>::lowest();
+constexpr auto TimedAxesSettled  = std::numeric_limits<double>::max();
+
+static struct {
+	uint8_t bits          = 0x0f;
+	double next_change_ms = TimedAxesOutdated;
+} timed_axes = {};
+
+static void update_timed_axes(const double now)
+{
+	uint8_t bits        = 0x0f;
+	auto next_change_ms = TimedAxesSettled;
+
+	auto check_axis = [&](const double tick, const uint8_t bit) {
+		if (tick < now) {
+			bits &= ~bit;
+		} else {
+			next_change_ms = std::min(next_change_ms, tick);
+		}
+	};
+	if (stick[0].enabled) {
+		check_axis(stick[0].xtick, 1);
+		check_axis(stick[0].ytick, 2);
+	}
+	if (stick[1].enabled) {
+		check_axis(stick[1].xtick, 4);
+		check_axis(stick[1].ytick, 8);
+	}
+	timed_axes.bits           = bits;
+	timed_axes.next_change_ms = next_change_ms;
+}
+
 static uint8_t read_p201_timed(io_port_t, io_width_t)
 {
-	uint8_t ret = 0xff;
-	const auto currentTick = PIC_FullIndex();
-	if( stick[0].enabled ){
-		if( stick[0].xtick < currentTick ) ret &=~1;
-		if( stick[0].ytick < currentTick ) ret &=~2;
+	const auto now = PIC_FullIndex();
+	if (now > timed_axes.next_change_ms) {
+		update_timed_axes(now);
 	}
-	if( stick[1].enabled ){
-		if( stick[1].xtick < currentTick ) ret &=~4;
-		if( stick[1].ytick < currentTick ) ret &=~8;
+	// Let the idle polling detection skip ahead to the next timeout, but
+	// not past it
+	if (timed_axes.next_change_ms != TimedAxesSettled) {
+		IO_SetPollingDeadline(timed_axes.next_change_ms);
 	}
 
+	uint8_t ret = 0xf0 | timed_axes.bits;
 	if (stick[0].enabled) {
 		if (stick[0].button[0]) ret&=~16;
 		if (stick[0].button[1]) ret&=~32;
@@ -310,12 +347,14 @@ static void write_p201_timed(io_port_t, io_val_t, io_width_t)
 		                                          : stick[1].ypos,
 		                                   calibrated_axis_rates.y);
 	}
+	timed_axes.next_change_ms = TimedAxesOutdated;
 }
 
 void JOYSTICK_Enable(uint8_t which, bool enabled)
 {
 	assert(which < 2);
 	stick[which].enabled = enabled;
+	timed_axes.next_change_ms = TimedAxesOutdated;
 }
 
 void JOYSTICK_Button(uint8_t which, int num, bool pressed)
@@ -23,6 +23,8 @@
 
 #include "dosbox.h"
 
+#include <cmath>
+
 #include "pic.h"
 #include "setup.h"
 #include "support.h"
@@ -32,8 +34,10 @@
 #include "ston1_dac.h"
 
 LptDac::LptDac(const std::string_view name, const int channel_rate_hz,
-               std::set<ChannelFeature> extra_features)
-        : dac_name(name)
+               std::set<ChannelFeature> extra_features,
+               const DacOutput _dac_output)
+        : dac_name(name),
+          dac_output(_dac_output)
 {
 	using namespace std::placeholders;
 
@@ -79,7 +83,7 @@ void LptDac::BindHandlers(const io_port_t lpt_port, const io_write_f write_data,
 	control_write_handler.Install(control_port, write_control, io_width_t::byte);
 }
 
-void LptDac::RenderUpToNow()
+void LptDac::QueueFrame(const AudioFrame frame)
 {
 	const auto now = PIC_FullIndex();
 
@@ -87,33 +91,86 @@ void LptDac::RenderUpToNow()
 	assert(channel);
 	if (channel->WakeUp()) {
 		last_rendered_ms = now;
-		return;
 	}
-	// Keep rendering until we're current
+	queued_writes.push_back({now, frame});
+}
+
+// Returns the number of frames the DAC outputs before the given time, and
+// moves the last rendered time datum past them
+int LptDac::NumFramesUntil(const double timestamp_ms)
+{
+	if (timestamp_ms <= last_rendered_ms) {
+		return 0;
+	}
 	assert(ms_per_frame > 0.0);
-	while (last_rendered_ms < now) {
-		last_rendered_ms += ms_per_frame;
-		render_queue.emplace(Render());
+	const auto num_frames = static_cast<int>(
+	        std::ceil((timestamp_ms - last_rendered_ms) / ms_per_frame));
+
+	last_rendered_ms += num_frames * ms_per_frame;
+	return num_frames;
+}
+
+void LptDac::RenderFrames(int num_frames)
+{
+	// A clocked DAC moves to the next level in its FIFO after every frame
+	while (num_frames > 0 && !fifo.empty()) {
+		render_queue.push_back(output_frame);
+		output_frame = fifo.front();
+		fifo.pop();
+		--num_frames;
+	}
+	// Otherwise the output holds its level
+	if (num_frames > 0) {
+		render_queue.insert(render_queue.end(),
+		                    static_cast<size_t>(num_frames),
+		                    output_frame);
+	}
+}
+
+void LptDac::ConvertQueuedWrites()
+{
+	for (const auto& write : queued_writes) {
+		// The frames before the write keep the previous level
+		RenderFrames(NumFramesUntil(write.timestamp_ms));
+
+		if (dac_output == DacOutput::Clocked) {
+			fifo.push(write.frame);
+		} else {
+			output_frame = write.frame;
+		}
 	}
+	queued_writes.clear();
+}
+
+void LptDac::RenderUpToNow()
+{
+	ConvertQueuedWrites();
+	RenderFrames(NumFramesUntil(PIC_FullIndex()));
+}
+
+size_t LptDac::NumFifoFrames() const
+{
+	return fifo.size();
 }
 
 void LptDac::AudioCallback(const int requested_frames)
 {
 	assert(channel);
 
-	auto frames_remaining = requested_frames;
+	// First, convert the writes queued since the last callback. If the
+	// frames fall short, render the remainder after them and sync-up our
+	// time datum.
+	ConvertQueuedWrites();
 
-	// First, add any frames we've queued since the last callback
-	while (frames_remaining && render_queue.size()) {
-		channel->AddSamples_sfloat(1, &render_queue.front()[0]);
-		render_queue.pop();
-		--frames_remaining;
+	const auto num_requested = check_cast<size_t>(requested_frames);
+	if (render_queue.size() < num_requested) {
+		RenderFrames(check_cast<int>(num_requested - render_queue.size()));
 	}
-	// If the queue's run dry, render the remainder and sync-up our time datum
-	while (frames_remaining) {
-		const auto frame = Render();
-		channel->AddSamples_sfloat(1, &frame[0]);
-		--frames_remaining;
+	if (num_requested > 0) {
+		channel->AddSamples_sfloat(requested_frames, &render_queue[0][0]);
+		render_queue.erase(render_queue.begin(),
+		                   render_queue.begin() +
+		                           static_cast<std::ptrdiff_t>(num_requested));
 	}
 	last_rendered_ms = PIC_FullIndex();
 }
@@ -135,7 +192,9 @@ LptDac::~LptDac()
 	assert(channel);
 	MIXER_DeregisterChannel(channel);
 
-	render_queue = {};
+	queued_writes = {};
+	fifo          = {};
+	render_queue  = {};
 }
 
 std::unique_ptr<LptDac> lpt_dac = {};
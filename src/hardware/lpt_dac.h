@@ -26,6 +26,7 @@
 #include <queue>
 #include <set>
 #include <string_view>
+#include <vector>
 
 #include "inout.h"
 #include "lpt.h"
@@ -34,8 +35,19 @@
 // Provides mandatory scafolding for derived LPT DAC devices
 class LptDac {
 public:
+	// How the DAC turns the levels written to it into output frames
+	enum class DacOutput {
+		// Written levels are output straight away and held until the
+		// next write (a zero-order hold)
+		Latched,
+		// Written levels are queued in the DAC's FIFO and clocked out
+		// at one per frame, holding the last when the FIFO runs dry
+		Clocked,
+	};
+
 	LptDac(const std::string_view name, const int channel_rate_hz,
-	       std::set<ChannelFeature> extra_features = {});
+	       std::set<ChannelFeature> extra_features = {},
+	       const DacOutput dac_output = DacOutput::Latched);
 
 	virtual ~LptDac();
 
@@ -55,10 +67,22 @@ public:
 
 protected:
 	// Base LPT DAC functionality
-	virtual AudioFrame Render() = 0;
+	// ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+	// DACs queue the levels written to them with the emulated time of the
+	// write, and the writes are converted to frames in one pass when the
+	// mixer asks for them (or when the DAC needs its FIFO level).
+
+	// Queues a level written to the DAC at the current emulated time
+	void QueueFrame(const AudioFrame frame);
+
+	// Converts the queued writes to frames up to the current emulated time
 	void RenderUpToNow();
+
+	// The number of levels waiting in a clocked DAC's FIFO, not counting
+	// the level being output
+	size_t NumFifoFrames() const;
+
 	void AudioCallback(const int requested_frames);
-	std::queue<AudioFrame> render_queue = {};
 
 	MixerChannelPtr channel = {};
 
@@ -80,6 +104,30 @@ protected:
 
 	LptStatusRegister status_reg   = {};
 	LptControlRegister control_reg = {};
+
+private:
+	void ConvertQueuedWrites();
+	int NumFramesUntil(const double timestamp_ms);
+	void RenderFrames(int num_frames);
+
+	struct TimestampedFrame {
+		double timestamp_ms = 0.0;
+		AudioFrame frame    = {};
+	};
+
+	// Levels written since they were last converted to frames
+	std::vector<TimestampedFrame> queued_writes = {};
+
+	// Levels waiting in a clocked DAC's FIFO
+	std::queue<AudioFrame> fifo = {};
+
+	// Frames converted from the writes, waiting for the mixer
+	std::vector<AudioFrame> render_queue = {};
+
+	// The level the DAC is currently outputting
+	AudioFrame output_frame = {};
+
+	DacOutput dac_output = DacOutput::Latched;
 };
 
 #endif
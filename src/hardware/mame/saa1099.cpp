@@ -249,6 +249,22 @@ void saa1099_device::device_start()
 }
 
 
+//-------------------------------------------------
+//  is_any_channel_audible - whether any channel
+//  has a generator enabled and a non-zero amplitude
+//-------------------------------------------------
+
+bool saa1099_device::is_any_channel_audible() const
+{
+	for (const auto &channel : m_channels) {
+		const bool is_enabled = channel.freq_enable || channel.noise_enable;
+		if (is_enabled && (channel.amplitude[LEFT] || channel.amplitude[RIGHT]))
+			return true;
+	}
+	return false;
+}
+
+
 //-------------------------------------------------
 //  sound_stream_update - handle a stream update
 //-------------------------------------------------
@@ -259,8 +275,8 @@ void saa1099_device::sound_stream_update([[maybe_unused]] sound_stream &stream,
                                          int samples)
 {
 	int j, ch;
-	/* if the channels are disabled we're done */
-	if (!m_all_ch_enable)
+	/* if the channels are disabled or all of them are silent we're done */
+	if (!m_all_ch_enable || !is_any_channel_audible())
 	{
 		/* init output data */
 		memset(outputs[LEFT],0,samples*sizeof(*outputs[LEFT]));
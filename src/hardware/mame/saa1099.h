@@ -76,6 +76,7 @@ private:
 	};
 
 	void envelope_w(int ch);
+	bool is_any_channel_audible() const;
 
 	sound_stream *m_stream;           /* our stream */
 	const double m_noise_freqs[3];    /* noise frequencies based on chip-clock */
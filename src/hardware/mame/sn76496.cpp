@@ -410,6 +410,16 @@ void sn76496_base_device::sound_stream_update([[maybe_unused]] sound_stream &str
 	int16_t out;
 	int16_t out2 = 0;
 
+	// With every channel fully attenuated the output is silent regardless
+	// of the oscillators, so skip clocking the chip altogether
+	if ((m_volume[0] | m_volume[1] | m_volume[2] | m_volume[3]) == 0) {
+		std::fill_n(lbuffer, samples, 0);
+		if (rbuffer) {
+			std::fill_n(rbuffer, samples, 0);
+		}
+		return;
+	}
+
 	while (samples > 0)
 	{
 		// clock chip once
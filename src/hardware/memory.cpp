@@ -19,12 +19,23 @@
 
 #include "mem.h"
 
+#include <algorithm>
 #include <cstring>
+#include <span>
 
+#if defined(HAVE_MMAP)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "host_memory.h"
 #include "inout.h"
 #include "paging.h"
 #include "pci_bus.h"
 #include "regs.h"
+#include "savestate.h"
 #include "setup.h"
 #include "support.h"
 
@@ -41,7 +52,7 @@ static struct MemoryBlock {
 	struct page_t {
 		uint8_t bytes[dos_pagesize] = {};
 	};
-	std::vector<page_t> pages           = {};
+	std::span<page_t> pages             = {};
 	std::vector<PageHandler*> phandlers = {};
 	std::vector<MemHandle> mhandles     = {};
 	struct {
@@ -62,6 +73,206 @@ static struct MemoryBlock {
 // Points to the first byte of the first DOS memory page
 HostPt MemBase = {};
 
+enum class MemoryBacking { Heap, HugePages, File };
+
+// Host memory holding the guest's RAM pages. Besides the heap, it can be
+// mapped with transparent huge pages, which saves the host a lot of TLB
+// misses with large memory sizes, or mapped copy-on-write from a file, so
+// instances started from the same memory image share its unmodified pages.
+class GuestRam {
+public:
+	using page_t = MemoryBlock::page_t;
+
+	GuestRam() = default;
+	~GuestRam()
+	{
+		Free();
+	}
+
+	GuestRam(const GuestRam&)            = delete;
+	GuestRam& operator=(const GuestRam&) = delete;
+
+	// Allocates zeroed pages (or pages holding the file contents), carrying
+	// over the contents of the previous allocation
+	std::span<page_t> Allocate(const size_t num_pages,
+	                           const MemoryBacking backing,
+	                           const std_fs::path& file)
+	{
+		page_t* new_pages   = nullptr;
+		size_t mapped_bytes = 0;
+
+		if (backing != MemoryBacking::Heap) {
+#if defined(HAVE_MMAP)
+			new_pages = Map(num_pages * dos_pagesize, backing, file, mapped_bytes);
+#else
+			LOG_WARNING("MEMORY: Memory backing other than 'heap' isn't supported on this platform");
+#endif
+		}
+		if (!new_pages) {
+			new_pages    = new page_t[num_pages]();
+			mapped_bytes = 0;
+		}
+
+		if (pages) {
+			std::copy_n(pages, std::min(num_pages, size), new_pages);
+		}
+		Free();
+
+		pages       = new_pages;
+		size        = num_pages;
+		mapped_size = mapped_bytes;
+		tracked.Track(pages, size * sizeof(page_t));
+		return {pages, size};
+	}
+
+private:
+#if defined(HAVE_MMAP)
+	static page_t* Map(const size_t num_bytes, const MemoryBacking backing,
+	                   const std_fs::path& file, size_t& mapped_bytes)
+	{
+		if (backing == MemoryBacking::HugePages) {
+			return MapHugePages(num_bytes, mapped_bytes);
+		}
+		assert(backing == MemoryBacking::File);
+		return MapFile(num_bytes, file, mapped_bytes);
+	}
+
+	static page_t* MapAnonymous(const size_t num_bytes)
+	{
+		const auto ptr = mmap(nullptr,
+		                      num_bytes,
+		                      PROT_READ | PROT_WRITE,
+		                      MAP_PRIVATE | MAP_ANONYMOUS,
+		                      -1,
+		                      0);
+		return (ptr == MAP_FAILED) ? nullptr : static_cast<page_t*>(ptr);
+	}
+
+	static page_t* MapHugePages([[maybe_unused]] const size_t num_bytes,
+	                            [[maybe_unused]] size_t& mapped_bytes)
+	{
+#if defined(MADV_HUGEPAGE)
+		constexpr size_t HugePageSize = 2 * megabyte;
+
+		// Huge pages can only be used for aligned 2 MB ranges, so map one
+		// more and trim the unaligned head and tail
+		const auto size = (num_bytes + HugePageSize - 1) & ~(HugePageSize - 1);
+		const auto raw = reinterpret_cast<uint8_t*>(
+		        MapAnonymous(size + HugePageSize));
+		if (!raw) {
+			LOG_WARNING("MEMORY: Can't map %zu MB for huge pages, using the heap",
+			            size / megabyte);
+			return nullptr;
+		}
+		const auto raw_address = reinterpret_cast<uintptr_t>(raw);
+		const auto head = ((raw_address + HugePageSize - 1) & ~(HugePageSize - 1)) -
+		                  raw_address;
+		if (head) {
+			munmap(raw, head);
+		}
+		if (HugePageSize - head) {
+			munmap(raw + head + size, HugePageSize - head);
+		}
+		const auto base = raw + head;
+
+		if (madvise(base, size, MADV_HUGEPAGE) != 0) {
+			LOG_WARNING("MEMORY: Transparent huge pages aren't available on this host");
+		}
+		mapped_bytes = size;
+		return reinterpret_cast<page_t*>(base);
+#else
+		LOG_WARNING("MEMORY: Transparent huge pages aren't supported on this platform");
+		return nullptr;
+#endif
+	}
+
+	static page_t* MapFile(const size_t num_bytes, const std_fs::path& file,
+	                       size_t& mapped_bytes)
+	{
+		const auto fd = open(file.string().c_str(), O_RDONLY);
+		if (fd < 0) {
+			LOG_WARNING("MEMORY: Can't open memory file '%s', using the heap",
+			            file.string().c_str());
+			return nullptr;
+		}
+		struct stat file_stat = {};
+		if (fstat(fd, &file_stat) != 0) {
+			close(fd);
+			return nullptr;
+		}
+
+		// The memory beyond the end of the file stays anonymous (and
+		// zeroed), the rest gets replaced with a private mapping of the
+		// file, which is only copied page by page as the guest writes it
+		const auto pages = MapAnonymous(num_bytes);
+		const auto file_bytes = std::min(num_bytes,
+		                                 static_cast<size_t>(file_stat.st_size));
+		if (pages && file_bytes &&
+		    mmap(pages,
+		         file_bytes,
+		         PROT_READ | PROT_WRITE,
+		         MAP_PRIVATE | MAP_FIXED,
+		         fd,
+		         0) == MAP_FAILED) {
+			LOG_WARNING("MEMORY: Can't map memory file '%s', using the heap",
+			            file.string().c_str());
+			munmap(pages, num_bytes);
+			close(fd);
+			return nullptr;
+		}
+		close(fd);
+
+		if (pages) {
+			LOG_MSG("MEMORY: Mapped %zu KB of memory file '%s' copy-on-write",
+			        file_bytes / 1024,
+			        file.string().c_str());
+			mapped_bytes = num_bytes;
+		}
+		return pages;
+	}
+#endif
+
+	void Free()
+	{
+		if (!pages) {
+			return;
+		}
+#if defined(HAVE_MMAP)
+		if (mapped_size) {
+			munmap(pages, mapped_size);
+		} else {
+			delete[] pages;
+		}
+#else
+		delete[] pages;
+#endif
+		pages       = nullptr;
+		size        = 0;
+		mapped_size = 0;
+		tracked.Clear();
+	}
+
+	page_t* pages      = nullptr;
+	size_t size        = 0;
+	size_t mapped_size = 0;
+
+	TrackedHostMemory tracked{HostMemoryUse::GuestRam};
+};
+
+static GuestRam guest_ram = {};
+
+static MemoryBacking get_memory_backing(const Section_prop* section)
+{
+	const std::string backing = section->Get_string("memory_backing");
+	if (backing == "hugepages") {
+		return MemoryBacking::HugePages;
+	}
+	if (backing == "file") {
+		return MemoryBacking::File;
+	}
+	return MemoryBacking::Heap;
+}
+
 class IllegalPageHandler final : public PageHandler {
 public:
 	IllegalPageHandler() {
@@ -203,25 +414,132 @@ void mem_strcpy(PhysPt dest,PhysPt src) {
 	mem_writeb_inline(dest,0);
 }
 
+// The block functions below work a page at a time: runs within pages that
+// are linked to host memory in the TLB get copied in one go, everything else
+// (MMIO, VGA, pages with translated code, pages not linked yet) goes through
+// the page handlers a byte at a time. Touching a page that isn't linked yet
+// usually links it, so the rest of it takes the fast path.
+
+// Bytes left until the end of the page holding the address
+static inline Bitu bytes_left_in_page(const PhysPt address)
+{
+	return dos_pagesize - (address & (dos_pagesize - 1));
+}
+
+// The memory breakpoints of heavy debugging builds need to see every access
+static inline HostPt get_block_read_ptr([[maybe_unused]] const PhysPt address)
+{
+#if C_HEAVY_DEBUG
+	return nullptr;
+#else
+	const auto tlb_addr = get_tlb_read(address);
+	return tlb_addr ? tlb_addr + address : nullptr;
+#endif
+}
+
+static inline HostPt get_block_write_ptr(const PhysPt address)
+{
+	const auto tlb_addr = get_tlb_write(address);
+	return tlb_addr ? tlb_addr + address : nullptr;
+}
+
+// Returns how many bytes can be copied with a single memmove, extending the
+// run across the following pages for as long as both sides stay contiguous in
+// host memory, which RAM usually does. This turns large moves, like XMS block
+// moves between extended and conventional memory, into a few big copies.
+static Bitu get_host_copy_run(const PhysPt dest, const PhysPt src, const Bitu size,
+                              const HostPt write_ptr, const HostPt read_ptr)
+{
+	// Ascending byte copies of overlapping runs repeat the source pattern,
+	// so never copy past the start of the destination in one go
+	auto max_run = size;
+	if (write_ptr > read_ptr) {
+		max_run = std::min(max_run, static_cast<Bitu>(write_ptr - read_ptr));
+	}
+
+	auto run = std::min({max_run, bytes_left_in_page(src), bytes_left_in_page(dest)});
+	while (run < max_run) {
+		const auto next_src  = static_cast<PhysPt>(src + run);
+		const auto next_dest = static_cast<PhysPt>(dest + run);
+		if (get_block_read_ptr(next_src) != read_ptr + run ||
+		    get_block_write_ptr(next_dest) != write_ptr + run) {
+			break;
+		}
+		run += std::min({max_run - run,
+		                 bytes_left_in_page(next_src),
+		                 bytes_left_in_page(next_dest)});
+	}
+	return run;
+}
+
 void mem_memcpy(PhysPt dest,PhysPt src,Bitu size) {
-	while (size--) mem_writeb_inline(dest++,mem_readb_inline(src++));
+	while (size) {
+		const auto read_ptr  = get_block_read_ptr(src);
+		const auto write_ptr = get_block_write_ptr(dest);
+
+		if (read_ptr && write_ptr) {
+			const auto run = get_host_copy_run(dest, src, size, write_ptr, read_ptr);
+			memmove(write_ptr, read_ptr, run);
+			src += run;
+			dest += run;
+			size -= run;
+		} else {
+			mem_writeb_inline(dest++, mem_readb_inline(src++));
+			--size;
+		}
+	}
 }
 
 void MEM_BlockRead(PhysPt pt,void * data,Bitu size) {
 	uint8_t * write=reinterpret_cast<uint8_t *>(data);
-	while (size--) {
-		*write++=mem_readb_inline(pt++);
+	while (size) {
+		if (const auto read_ptr = get_block_read_ptr(pt)) {
+			const auto chunk = std::min(size, bytes_left_in_page(pt));
+			memcpy(write, read_ptr, chunk);
+			write += chunk;
+			pt += chunk;
+			size -= chunk;
+		} else {
+			*write++ = mem_readb_inline(pt++);
+			--size;
+		}
 	}
 }
 
 void MEM_BlockWrite(PhysPt pt, const void *data, size_t size)
 {
 	const uint8_t *read = static_cast<const uint8_t *>(data);
-	while (size--) {
-		mem_writeb_inline(pt++,*read++);
+	while (size) {
+		if (const auto write_ptr = get_block_write_ptr(pt)) {
+			const auto chunk = std::min<size_t>(size, bytes_left_in_page(pt));
+			memcpy(write_ptr, read, chunk);
+			read += chunk;
+			pt += chunk;
+			size -= chunk;
+		} else {
+			mem_writeb_inline(pt++, *read++);
+			--size;
+		}
 	}
 }
 
+HostPt MEM_GetHostWritePtr(const PhysPt pt, const size_t size)
+{
+	const auto write_ptr = get_block_write_ptr(pt);
+	if (!write_ptr) {
+		return nullptr;
+	}
+	size_t run = bytes_left_in_page(pt);
+	while (run < size) {
+		const auto next = static_cast<PhysPt>(pt + run);
+		if (get_block_write_ptr(next) != write_ptr + run) {
+			return nullptr;
+		}
+		run += bytes_left_in_page(next);
+	}
+	return write_ptr;
+}
+
 void MEM_BlockCopy(PhysPt dest,PhysPt src,Bitu size) {
 	mem_memcpy(dest,src,size);
 }
@@ -710,6 +1028,31 @@ static void check_num_megabytes(const int num_megabytes)
 	}
 }
 
+// Stores loaded memory contents. Pages that hold translated code go through
+// their page handler, so the dynamic core notices the code changed.
+static void restore_memory(const uint8_t* data, const size_t size)
+{
+	assert(size == memory.pages.size() * dos_pagesize);
+
+	for (size_t page = 0; page < memory.pages.size(); ++page) {
+		auto& bytes      = memory.pages[page].bytes;
+		const auto saved = data + page * dos_pagesize;
+		if (memcmp(bytes, saved, dos_pagesize) == 0) {
+			continue;
+		}
+		const auto handler = memory.phandlers[page];
+		if ((handler->flags & PFLAG_HASCODE) && !(handler->flags & PFLAG_HASROM)) {
+			const auto base = static_cast<PhysPt>(page * dos_pagesize);
+			for (PhysPt offset = 0; offset < dos_pagesize; offset += 4) {
+				handler->writed(base + offset, host_readd(saved + offset));
+			}
+		}
+		memcpy(bytes, saved, dos_pagesize);
+	}
+	// the page tables might have changed
+	PAGING_ClearTLB();
+}
+
 HostPt GetMemBase(void)
 {
 	return MemBase;
@@ -730,7 +1073,11 @@ public:
 		const auto num_pages = (num_megabytes * megabyte) / dos_pagesize;
 
 		// Size the actual memory pages
-		memory.pages.resize(num_pages);
+		const auto memory_file = section->Get_path("memory_file");
+		assert(memory_file);
+		memory.pages = guest_ram.Allocate(num_pages,
+		                                  get_memory_backing(section),
+		                                  memory_file->realpath);
 
 		// The MemBase is address of the first page's first byte
 		MemBase = &(memory.pages[0].bytes[0]);
@@ -740,6 +1087,11 @@ public:
 		        num_megabytes,
 		        static_cast<void*>(MemBase));
 
+		SAVESTATE_AddMemoryRegion("memory",
+		                          MemBase,
+		                          memory.pages.size() * dos_pagesize,
+		                          restore_memory);
+
 		// Setup the page handlers, defaulting to the RAM handler
 		memory.phandlers.clear();
 		memory.phandlers.resize(num_pages, &ram_page_handler);
@@ -22,10 +22,13 @@
 #include "mixer.h"
 
 #include <algorithm>
+#include <bit>
+#include <chrono>
 #include <cinttypes>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <mutex>
 #include <optional>
 #include <sys/types.h>
 
@@ -38,10 +41,12 @@
 #include "control.h"
 #include "cross.h"
 #include "hardware.h"
+#include "host_threads.h"
 #include "mapper.h"
 #include "math_utils.h"
 #include "mem.h"
 #include "midi.h"
+#include "mixer_kernels.h"
 #include "pic.h"
 #include "ring_buffer.h"
 #include "setup.h"
@@ -49,6 +54,7 @@
 #include "timer.h"
 #include "tracy.h"
 #include "video.h"
+#include "worker_pool.h"
 
 #include "mverb/MVerb.h"
 #include "tal-chorus/ChorusEngine.h"
@@ -81,9 +87,42 @@ struct CrossfeedSettings {
 	float global_strength  = 0.0f;
 };
 
+// Lets the send effects skip processing while they would only output
+// silence: once their input has been silent for a whole block, and the tail
+// of their output has died away
+class SilenceGate {
+public:
+	// Far below the 16-bit output's resolution, even after the master gain
+	static constexpr auto Threshold = 0.01f;
+
+	bool IsOpen(const float input_peak) const
+	{
+		return has_tail || input_peak > Threshold;
+	}
+
+	void SetOutputPeak(const float output_peak)
+	{
+		has_tail = output_peak > Threshold;
+	}
+
+	void Reset()
+	{
+		has_tail = false;
+	}
+
+private:
+	bool has_tail = false;
+};
+
 struct ReverbSettings {
 	EmVerb mverb = {};
 
+	SilenceGate gate = {};
+
+	// MVerb operates on two non-interleaved sample streams
+	std::array<std::vector<float>, 2> in_buf  = {};
+	std::array<std::vector<float>, 2> out_buf = {};
+
 	// MVerb does not have an integrated high-pass filter to shape
 	// the low-end response like other reverbs. So we're adding one
 	// here. This helps take control over low-frequency build-up,
@@ -127,12 +166,58 @@ struct ReverbSettings {
 		for (auto& f : highpass_filter) {
 			f.setup(sample_rate_hz, highpass_freq_hz);
 		}
+		gate.Reset();
+	}
+
+	// Feeds 'num_frames' frames of the send bus to the reverb, and mixes
+	// its output into 'out_frames'. The send bus is filtered in place.
+	void Process(AudioFrame* in_frames, const int num_frames, AudioFrame* out_frames)
+	{
+		const auto num_samples = check_cast<size_t>(num_frames * 2);
+
+		const auto input_peak = MIXER_GetPeakAmplitude(&in_frames->left,
+		                                               num_samples);
+		if (!gate.IsOpen(input_peak)) {
+			return;
+		}
+
+		// High-pass filter the reverb input
+		for (auto frame = in_frames; frame != in_frames + num_frames; ++frame) {
+			*frame = {highpass_filter[0].filter(frame->left),
+			          highpass_filter[1].filter(frame->right)};
+		}
+
+		for (auto& buf : in_buf) {
+			buf.resize(check_cast<size_t>(num_frames));
+		}
+		for (auto& buf : out_buf) {
+			buf.resize(check_cast<size_t>(num_frames));
+		}
+		MIXER_DeinterleaveFrames(&in_frames->left,
+		                         in_buf[0].size(),
+		                         in_buf[0].data(),
+		                         in_buf[1].data());
+
+		float* in_ptrs[2]  = {in_buf[0].data(), in_buf[1].data()};
+		float* out_ptrs[2] = {out_buf[0].data(), out_buf[1].data()};
+		mverb.process(in_ptrs, out_ptrs, num_frames);
+
+		gate.SetOutputPeak(
+		        std::max(MIXER_GetPeakAmplitude(out_buf[0].data(), out_buf[0].size()),
+		                 MIXER_GetPeakAmplitude(out_buf[1].data(), out_buf[1].size())));
+
+		MIXER_AccumulateDeinterleavedFrames(&out_frames->left,
+		                                    out_buf[0].data(),
+		                                    out_buf[1].data(),
+		                                    out_buf[0].size());
 	}
 };
 
 struct ChorusSettings {
 	ChorusEngine chorus_engine = ChorusEngine(DefaultSampleRateHz);
 
+	SilenceGate gate = {};
+
 	ChorusPreset preset            = ChorusPreset::None;
 	float synthesizer_send_level   = 0.0f;
 	float digital_audio_send_level = 0.0f;
@@ -153,16 +238,90 @@ struct ChorusSettings {
 
 		// The chorus effect can only operates in 100% wet output mode,
 		// so we don't need to configure it for that.
+
+		gate.Reset();
 	}
+
+	// Applies the chorus effect to 'num_frames' frames of the send bus in
+	// place, and mixes the results into 'out_frames'
+	void Process(AudioFrame* frames, const int num_frames, AudioFrame* out_frames)
+	{
+		const auto num_samples = check_cast<size_t>(num_frames * 2);
+
+		if (!gate.IsOpen(MIXER_GetPeakAmplitude(&frames->left, num_samples))) {
+			return;
+		}
+
+		for (auto frame = frames; frame != frames + num_frames; ++frame) {
+			chorus_engine.process(&frame->left, &frame->right);
+		}
+
+		gate.SetOutputPeak(MIXER_GetPeakAmplitude(&frames->left, num_samples));
+
+		MIXER_AccumulateSamples(&out_frames->left, &frames->left, num_samples);
+	}
+};
+
+// Adds the host time spent in its scope to a profile counter
+class ProfileTimer {
+public:
+	explicit ProfileTimer(int64_t& total_ns)
+	        : total_ns(total_ns),
+	          start(std::chrono::steady_clock::now())
+	{}
+
+	~ProfileTimer()
+	{
+		total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+		                    std::chrono::steady_clock::now() - start)
+		                    .count();
+	}
+
+	ProfileTimer(const ProfileTimer&)            = delete;
+	ProfileTimer& operator=(const ProfileTimer&) = delete;
+
+private:
+	int64_t& total_ns;
+	const std::chrono::steady_clock::time_point start;
 };
 
+constexpr auto DefaultResampleQuality = 5;
+constexpr auto MaxResampleQuality     = 10;
+
+// Keeps the accumulated frames within the mix's capture buffer
+constexpr auto MaxProcessingBlocksize = 512;
+
 struct MixerSettings {
 	RingBuffer<AudioFrame, MixerBufferByteSize> work       = {};
 	RingBuffer<AudioFrame, MixerBufferByteSize> aux_reverb = {};
 	RingBuffer<AudioFrame, MixerBufferByteSize> aux_chorus = {};
 
-	std::vector<float> temp_buf = {};
-	std::vector<float> out_buf  = {};
+	// The finished frames, handed over from the emulation thread to the
+	// SDL audio callback without locking, and the callback's scratch
+	// buffer to pop them into
+	SpscRingBuffer<AudioFrame, MixerBufferByteSize> output_queue = {};
+	std::array<AudioFrame, MixerBufferByteSize> callback_frames  = {};
+
+	// Counted by the audio callback, and when the queue is full
+	std::atomic<int> underruns = 0;
+	std::atomic<int> overruns  = 0;
+
+	// Serialises the threads feeding the channels and the mixing; the
+	// audio callback never takes it
+	std::recursive_mutex mutex = {};
+
+	// Renders the channels supporting it on the shared worker threads in
+	// parallel, when enabled
+	struct {
+		bool is_enabled = false;
+
+		// The channels of the current tick
+		std::vector<MixerChannel*> channels = {};
+
+		// Taken instead of the mixer's mutex while rendering in
+		// parallel, to serialise the accumulation into the mix buffers
+		std::recursive_mutex mutex = {};
+	} parallel = {};
 
 	AudioFrame master_volume = {1.0f, 1.0f};
 
@@ -174,12 +333,19 @@ struct MixerSettings {
 	std::atomic<int> pos               = 0;
 	std::atomic<int> frames_done       = 0;
 	std::atomic<int> frames_needed     = 0;
-	std::atomic<int> min_frames_needed = 0;
 	std::atomic<int> max_frames_needed = 0;
 	std::atomic<float> frames_per_tick = 0;
 
 	float frame_counter = 0;
 
+	MixerProfile profile = {};
+
+	std::chrono::steady_clock::time_point profile_start =
+	        std::chrono::steady_clock::now();
+
+	// Where the frames of the current tick start within 'frames_needed'
+	int tick_start_frame = 0;
+
 	// Sample rate negotiated with SDL (technically, this is the rate of
 	// sample *frames* per second).
 	std::atomic<int> sample_rate_hz = 0;
@@ -188,6 +354,13 @@ struct MixerSettings {
 	int blocksize    = 0;
 	int prebuffer_ms = 25;
 
+	// The Speex resampler quality new channels start with
+	int resample_quality = DefaultResampleQuality;
+
+	// The minimum number of frames the channels render and the master mix
+	// processes at once, accumulated over the ticks; 0 processes every tick
+	int processing_blocksize = 0;
+
 	SDL_AudioDeviceID sdl_device = 0;
 
 	MixerState state = MixerState::Uninitialized;
@@ -210,6 +383,41 @@ struct MixerSettings {
 
 static struct MixerSettings mixer = {};
 
+// The mixer's own buffers are part of its settings
+static TrackedHostMemory tracked_mixer{HostMemoryUse::MixerBuffers};
+
+using MixBuffer = RingBuffer<AudioFrame, MixerBufferByteSize>;
+
+// The mix buffers hold interleaved stereo frames, which the sample kernels
+// process as flat runs of floats
+static_assert(sizeof(AudioFrame) == 2 * sizeof(float));
+
+static float* mix_buffer_samples(MixBuffer& buffer, const int frame)
+{
+	return reinterpret_cast<float*>(buffer.data().data()) + frame * 2;
+}
+
+// Splits 'num_frames' frames of the mix buffers starting at 'start_frame' into
+// the contiguous runs between their wrap-arounds, and calls 'process' with the
+// first frame, the length, and the offset within the requested frames of each
+template <typename Process>
+static void for_each_mix_buffer_run(const int start_frame, int num_frames,
+                                    Process process)
+{
+	constexpr auto BufferFrames = MixerBufferByteSize;
+
+	auto frame = start_frame % BufferFrames;
+	auto done  = 0;
+	while (num_frames > 0) {
+		const auto run = std::min(num_frames, BufferFrames - frame);
+		process(frame, run, done);
+
+		num_frames -= run;
+		done += run;
+		frame = 0;
+	}
+}
+
 // TODO This is hacky and should be removed. Only the PS1 Audio uses it.
 alignas(sizeof(float)) uint8_t MixTemp[MixerBufferByteSize] = {};
 
@@ -256,6 +464,40 @@ int MIXER_GetPreBufferMs()
 	return mixer.prebuffer_ms;
 }
 
+MixerProfile MIXER_GetProfile()
+{
+	auto profile = mixer.profile;
+
+	profile.elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+	                             std::chrono::steady_clock::now() -
+	                             mixer.profile_start)
+	                             .count();
+	return profile;
+}
+
+void MIXER_ResetProfile()
+{
+	MIXER_LockAudioDevice();
+
+	mixer.profile       = {};
+	mixer.profile_start = std::chrono::steady_clock::now();
+
+	for (const auto& [_, channel] : mixer.channels) {
+		channel->ResetProfile();
+	}
+
+	MIXER_UnlockAudioDevice();
+}
+
+int MIXER_GetBufferedMs()
+{
+	const auto sample_rate_hz = mixer.sample_rate_hz.load();
+	if (sample_rate_hz <= 0) {
+		return 0;
+	}
+	return check_cast<int>(mixer.output_queue.Size()) * 1000 / sample_rate_hz;
+}
+
 int MIXER_GetSampleRate()
 {
 	const auto sample_rate_hz = mixer.sample_rate_hz.load();
@@ -263,17 +505,25 @@ int MIXER_GetSampleRate()
 	return sample_rate_hz;
 }
 
+// Set on the threads taking part in the parallel rendering of the channels,
+// the emulation thread holding the mixer's mutex all the while
+static thread_local bool is_rendering_in_parallel = false;
+
 void MIXER_LockAudioDevice()
 {
-	if (mixer.sdl_device > 0) {
-		SDL_LockAudioDevice(mixer.sdl_device);
+	if (is_rendering_in_parallel) {
+		mixer.parallel.mutex.lock();
+	} else {
+		mixer.mutex.lock();
 	}
 }
 
 void MIXER_UnlockAudioDevice()
 {
-	if (mixer.sdl_device > 0) {
-		SDL_UnlockAudioDevice(mixer.sdl_device);
+	if (is_rendering_in_parallel) {
+		mixer.parallel.mutex.unlock();
+	} else {
+		mixer.mutex.unlock();
 	}
 }
 
@@ -285,7 +535,9 @@ MixerChannel::MixerChannel(MIXER_Handler _handler, const char* _name,
           features(_features),
           sleeper(*this),
           do_sleep(HasFeature(ChannelFeature::Sleep))
-{}
+{
+	tracked_state.Track(this, sizeof(*this));
+}
 
 bool MixerChannel::HasFeature(const ChannelFeature feature) const
 {
@@ -675,6 +927,7 @@ MixerChannelPtr MIXER_AddChannel(MIXER_Handler handler,
 	assert(sample_rate_hz >= 0);
 
 	auto chan = std::make_shared<MixerChannel>(handler, name, features);
+	chan->SetResampleQuality(mixer.resample_quality);
 	chan->SetSampleRate(sample_rate_hz);
 	chan->SetAppVolume({1.0f, 1.0f});
 
@@ -933,24 +1186,31 @@ void MixerChannel::ConfigureResampler()
 
 		// Only init the resampler once
 		if (!speex_resampler.state) {
-			constexpr auto NumChannels     = 2; // always stereo
-			constexpr auto ResampleQuality = 5;
-
-			speex_resampler.state = speex_resampler_init(NumChannels,
-			                                             in_rate_hz,
-			                                             out_rate_hz,
-			                                             ResampleQuality,
-			                                             nullptr);
+			constexpr auto NumChannels = 2; // always stereo
+
+			speex_resampler.state = speex_resampler_init(
+			        NumChannels,
+			        in_rate_hz,
+			        out_rate_hz,
+			        speex_resampler.quality,
+			        nullptr);
 		}
 
 		speex_resampler_set_rate(speex_resampler.state, in_rate_hz, out_rate_hz);
 
-		LOG_DEBUG("%s: Speex resampler is on, input rate: %d Hz, output rate: %d Hz",
+		LOG_DEBUG("%s: Speex resampler is on, input rate: %d Hz, output rate: %d Hz, quality: %d",
 		          name.c_str(),
 		          in_rate_hz,
-		          out_rate_hz);
+		          out_rate_hz,
+		          speex_resampler.quality);
 	};
 
+	// Holding every frame for a whole number of output frames gives the
+	// exact staircase of the DAC, so resampling it wouldn't add anything
+	const auto is_integer_upsample = (channel_rate_hz > 0 &&
+	                                  channel_rate_hz < mixer_rate_hz &&
+	                                  mixer_rate_hz % channel_rate_hz == 0);
+
 	switch (resample_method) {
 	case ResampleMethod::LerpUpsampleOrResample:
 		if (channel_rate_hz < mixer_rate_hz) {
@@ -971,6 +1231,10 @@ void MixerChannel::ConfigureResampler()
 		break;
 
 	case ResampleMethod::ZeroOrderHoldAndResample:
+		// Hold the frames at the mixer rate instead if that's exact
+		zoh_upsampler.target_rate_hz = is_integer_upsample
+		                                     ? mixer_rate_hz
+		                                     : zoh_upsampler.requested_rate_hz;
 		if (channel_rate_hz < zoh_upsampler.target_rate_hz) {
 			do_zoh_upsample = true;
 			InitZohUpsamplerState();
@@ -1089,9 +1353,26 @@ void MixerChannel::Mix(const int frames_requested)
 
 	frames_needed = frames_requested;
 
-	auto stretch_factor = static_cast<float>(sample_rate_hz) /
-	                      static_cast<float>(mixer.sample_rate_hz);
+	const auto stretch_factor = static_cast<float>(sample_rate_hz) /
+	                            static_cast<float>(mixer.sample_rate_hz);
+
+	// The device's time is what's left after the stages it calls into
+	const auto stages_ns = profile.resample_ns + profile.filters_ns;
+	int64_t total_ns     = 0;
+	{
+		ProfileTimer timer(total_ns);
+		RenderFrames(stretch_factor);
+	}
+	profile.device_ns += total_ns -
+	                     (profile.resample_ns + profile.filters_ns - stages_ns);
+
+	if (do_sleep) {
+		sleeper.MaybeSleep();
+	}
+}
 
+void MixerChannel::RenderFrames(const float stretch_factor)
+{
 	while (frames_needed > frames_done) {
 		auto frames_remaining = iceil(
 		        static_cast<float>(frames_needed - frames_done) *
@@ -1106,10 +1387,6 @@ void MixerChannel::Mix(const int frames_requested)
 
 		handler(frames_remaining);
 	}
-
-	if (do_sleep) {
-		sleeper.MaybeSleep();
-	}
 }
 
 void MixerChannel::AddSilence()
@@ -1247,6 +1524,27 @@ static int clamp_filter_cutoff_freq([[maybe_unused]] const std::string& channel_
 	}
 }
 
+// Copies the sections of a designed filter to run them with the sample
+// kernels, starting from silence
+template <typename Filter>
+static void set_filter_cascade(MixerFilterCascade& cascade, Filter& filter)
+{
+	cascade.num_sections = check_cast<size_t>(filter.getNumStages());
+	assert(cascade.num_sections <= cascade.sections.size());
+
+	for (size_t i = 0; i < cascade.num_sections; ++i) {
+		const auto& stage = filter[static_cast<int>(i)];
+		const auto a0     = stage.getA0();
+
+		cascade.sections[i] = {stage.getB0() / a0,
+		                       stage.getB1() / a0,
+		                       stage.getB2() / a0,
+		                       stage.getA1() / a0,
+		                       stage.getA2() / a0};
+	}
+	cascade.states = {};
+}
+
 void MixerChannel::ConfigureHighPassFilter(const int order, const int _cutoff_freq_hz)
 {
 	assert(order > 0);
@@ -1255,9 +1553,9 @@ void MixerChannel::ConfigureHighPassFilter(const int order, const int _cutoff_fr
 	const auto cutoff_freq_hz = clamp_filter_cutoff_freq(name, _cutoff_freq_hz);
 
 	assert(order > 0 && order <= MaxFilterOrder);
-	for (auto& f : filters.highpass.hpf) {
-		f.setup(order, mixer.sample_rate_hz, cutoff_freq_hz);
-	}
+	Iir::Butterworth::HighPass<MaxFilterOrder> hpf = {};
+	hpf.setup(order, mixer.sample_rate_hz, cutoff_freq_hz);
+	set_filter_cascade(filters.highpass.cascade, hpf);
 
 	filters.highpass.order          = order;
 	filters.highpass.cutoff_freq_hz = cutoff_freq_hz;
@@ -1271,9 +1569,9 @@ void MixerChannel::ConfigureLowPassFilter(const int order, const int _cutoff_fre
 	const auto cutoff_freq_hz = clamp_filter_cutoff_freq(name, _cutoff_freq_hz);
 
 	assert(order > 0 && order <= MaxFilterOrder);
-	for (auto& f : filters.lowpass.lpf) {
-		f.setup(order, mixer.sample_rate_hz, cutoff_freq_hz);
-	}
+	Iir::Butterworth::LowPass<MaxFilterOrder> lpf = {};
+	lpf.setup(order, mixer.sample_rate_hz, cutoff_freq_hz);
+	set_filter_cascade(filters.lowpass.cascade, lpf);
 
 	filters.lowpass.order          = order;
 	filters.lowpass.cutoff_freq_hz = cutoff_freq_hz;
@@ -1395,7 +1693,7 @@ void MixerChannel::SetZeroOrderHoldUpsamplerTargetRate(const int target_rate_hz)
 
 	// TODO make sure that the ZOH target frequency cannot be set after the
 	// filter has been configured
-	zoh_upsampler.target_rate_hz = target_rate_hz;
+	zoh_upsampler.requested_rate_hz = target_rate_hz;
 
 #ifdef DEBUG_MIXER
 	LOG_DEBUG("%s: Set zero-order-hold upsampler target rate to %d Hz",
@@ -1440,6 +1738,26 @@ void MixerChannel::SetResampleMethod(const ResampleMethod method)
 	ConfigureResampler();
 }
 
+void MixerChannel::SetResampleQuality(const int quality)
+{
+	speex_resampler.quality = std::clamp(quality, 0, MaxResampleQuality);
+
+	if (speex_resampler.state) {
+		speex_resampler_set_quality(speex_resampler.state,
+		                            speex_resampler.quality);
+	}
+}
+
+MixerChannelProfile MixerChannel::GetProfile() const
+{
+	return profile;
+}
+
+void MixerChannel::ResetProfile()
+{
+	profile = {};
+}
+
 void MixerChannel::SetCrossfeedStrength(const float strength)
 {
 	assert(strength >= 0.0f);
@@ -1583,134 +1901,46 @@ static constexpr void fill_8to16_lut()
 	}
 }
 
-template <class Type, bool stereo, bool signeddata, bool nativeorder>
-AudioFrame MixerChannel::ConvertNextFrame(const Type* data, const int pos)
+// Converts a block of integer samples to floats in the 16-bit range. The left
+// and right samples of stereo frames are converted alike, so the block is
+// converted as a flat run of samples.
+template <class Type, bool signeddata, bool nativeorder>
+static void convert_samples(const Type* data, const size_t num_samples, float* out)
 {
-	assert(pos >= 0);
+	static_assert(!std::is_same_v<Type, float>);
 
-	AudioFrame frame = {};
+	if constexpr (sizeof(Type) == 1) {
+		const auto bytes = reinterpret_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < num_samples; ++i) {
+			out[i] = signeddata ? lut_s8to16[static_cast<int8_t>(bytes[i])]
+			                    : lut_u8to16[bytes[i]];
+		}
 
-	const auto left_pos  = pos * 2 + 0;
-	const auto right_pos = pos * 2 + 1;
+	} else if constexpr (!nativeorder && std::endian::native == std::endian::big) {
+		// The non-native samples are little-endian, so only need
+		// swapping on big-endian hosts
+		static_assert(sizeof(Type) == 2);
 
-	if (sizeof(Type) == 1) {
-		// Integer types
-		// unsigned 8-bit
-		if (!signeddata) {
-			if (stereo) {
-				frame.left  = lut_u8to16[static_cast<uint8_t>(data[left_pos])];
-				frame.right = lut_u8to16[static_cast<uint8_t>(data[right_pos])];
-			} else {
-				frame.left = lut_u8to16[static_cast<uint8_t>(data[pos])];
-			}
-		}
-		// signed 8-bit
-		else {
-			if (stereo) {
-				frame.left  = lut_s8to16[static_cast<int8_t>(data[left_pos])];
-				frame.right = lut_s8to16[static_cast<int8_t>(data[right_pos])];
-			} else {
-				frame.left = lut_s8to16[static_cast<int8_t>(data[pos])];
-			}
+		for (size_t i = 0; i < num_samples; ++i) {
+			const auto value = host_readw(
+			        reinterpret_cast<const uint8_t*>(data + i));
+
+			out[i] = signeddata
+			               ? static_cast<float>(static_cast<int16_t>(value))
+			               : static_cast<float>(static_cast<int>(value) - 32768);
 		}
+
+	} else if constexpr (signeddata) {
+		static_assert(sizeof(Type) == 2);
+		MIXER_ConvertS16ToFloat(reinterpret_cast<const int16_t*>(data),
+		                        num_samples,
+		                        out);
 	} else {
-		// 16-bit and 32-bit both contain 16-bit data internally
-		if (signeddata) {
-			if (stereo) {
-				if (nativeorder) {
-					frame.left  = static_cast<float>(data[left_pos]);
-					frame.right = static_cast<float>(data[right_pos]);
-				} else {
-					auto host_pt0 = reinterpret_cast<const uint8_t* const>(
-					        data + left_pos);
-					auto host_pt1 = reinterpret_cast<const uint8_t* const>(
-					        data + right_pos);
-
-					if (sizeof(Type) == 2) {
-						frame.left  = (int16_t)host_readw(host_pt0);
-						frame.right = (int16_t)host_readw(host_pt1);
-					} else {
-						frame.left = static_cast<float>(
-						        (int32_t)host_readd(host_pt0));
-						frame.right = static_cast<float>(
-						        (int32_t)host_readd(host_pt1));
-					}
-				}
-			} else { // mono
-				if (nativeorder) {
-					frame.left = static_cast<float>(data[pos]);
-				} else {
-					auto host_pt = reinterpret_cast<const uint8_t* const>(
-					        data + pos);
-
-					if (sizeof(Type) == 2) {
-						frame.left = (int16_t)host_readw(host_pt);
-					} else {
-						frame.left = static_cast<float>(
-						        (int32_t)host_readd(host_pt));
-					}
-				}
-			}
-		} else { // unsigned
-			const auto offs = 32768;
-			if (stereo) {
-				if (nativeorder) {
-					frame.left = static_cast<float>(
-					        static_cast<int>(data[left_pos]) -
-					        offs);
-					frame.right = static_cast<float>(
-					        static_cast<int>(data[right_pos]) -
-					        offs);
-				} else {
-					auto host_pt0 = reinterpret_cast<const uint8_t* const>(
-					        data + left_pos);
-					auto host_pt1 = reinterpret_cast<const uint8_t* const>(
-					        data + right_pos);
-
-					if (sizeof(Type) == 2) {
-						frame.left = static_cast<float>(
-						        static_cast<int>(host_readw(
-						                host_pt0)) -
-						        offs);
-						frame.right = static_cast<float>(
-						        static_cast<int>(host_readw(
-						                host_pt1)) -
-						        offs);
-					} else {
-						frame.left = static_cast<float>(
-						        static_cast<int>(host_readd(
-						                host_pt0)) -
-						        offs);
-						frame.right = static_cast<float>(
-						        static_cast<int>(host_readd(
-						                host_pt1)) -
-						        offs);
-					}
-				}
-			} else { // mono
-				if (nativeorder) {
-					frame.left = static_cast<float>(
-					        static_cast<int>(data[pos]) - offs);
-				} else {
-					auto host_pt = reinterpret_cast<const uint8_t* const>(
-					        data + pos);
-
-					if (sizeof(Type) == 2) {
-						frame.left = static_cast<float>(
-						        static_cast<int>(host_readw(
-						                host_pt)) -
-						        offs);
-					} else {
-						frame.left = static_cast<float>(
-						        static_cast<int>(host_readd(
-						                host_pt)) -
-						        offs);
-					}
-				}
-			}
-		}
+		static_assert(sizeof(Type) == 2);
+		MIXER_ConvertU16ToFloat(reinterpret_cast<const uint16_t*>(data),
+		                        num_samples,
+		                        out);
 	}
-	return frame;
 }
 
 // Converts sample stream to floats, performs output channel mappings, removes
@@ -1722,43 +1952,43 @@ void MixerChannel::ConvertSamplesAndMaybeZohUpsample(const Type* data,
 {
 	assert(num_frames >= 0);
 
-	const auto mapped_output_left  = output_map.left;
-	const auto mapped_output_right = output_map.right;
+	// Convert the whole block first, then map, scale, and optionally
+	// upsample its frames
+	constexpr auto SamplesPerFrame = stereo ? 2 : 1;
 
-	const auto mapped_channel_left  = channel_map.left;
-	const auto mapped_channel_right = channel_map.right;
+	const auto num_samples = static_cast<size_t>(num_frames) * SamplesPerFrame;
 
-	auto pos             = 0;
-	AudioFrame out_frame = {};
+	// Float samples are already in the 16-bit range, so the device's
+	// buffer is read in place without any conversion or copying
+	const float* samples = nullptr;
+	if constexpr (std::is_same_v<Type, float>) {
+		samples = data;
+	} else {
+		convert_buf.resize(num_samples);
+		convert_samples<Type, signeddata, nativeorder>(data,
+		                                               num_samples,
+		                                               convert_buf.data());
+		samples = convert_buf.data();
+	}
 
-	// We set size to zero which will not change the data in the container
-	// at all. Then we overwrite the data below with `emplace_back()` which
-	// will set the correct length.
-	out.resize(0);
+	auto converted_frame = [&](const int pos) {
+		return stereo ? AudioFrame{samples[pos * 2], samples[pos * 2 + 1]}
+		              : AudioFrame{samples[pos], 0.0f};
+	};
 
-	while (pos < num_frames) {
-		prev_frame = next_frame;
+	const auto mapped_output_left  = output_map.left;
+	const auto mapped_output_right = output_map.right;
 
-		if (std::is_same<Type, float>::value) {
-			if (stereo) {
-				next_frame.left = static_cast<float>(
-				        data[pos * 2 + 0]);
-				next_frame.right = static_cast<float>(
-				        data[pos * 2 + 1]);
-			} else {
-				next_frame.left = static_cast<float>(data[pos]);
-			}
-		} else {
-			next_frame = ConvertNextFrame<Type, stereo, signeddata, nativeorder>(
-			        data, pos);
-		}
+	const auto mapped_channel_left  = channel_map.left;
+	const auto mapped_channel_right = channel_map.right;
 
+	auto map_and_scale = [&](const AudioFrame frame) {
 		AudioFrame frame_with_gain = {};
 		if (stereo) {
-			frame_with_gain = {prev_frame[mapped_channel_left],
-			                   prev_frame[mapped_channel_right]};
+			frame_with_gain = {frame[mapped_channel_left],
+			                   frame[mapped_channel_right]};
 		} else {
-			frame_with_gain = {prev_frame[mapped_channel_left]};
+			frame_with_gain = {frame[mapped_channel_left]};
 		}
 		frame_with_gain *= combined_volume_gain;
 
@@ -1766,23 +1996,79 @@ void MixerChannel::ConvertSamplesAndMaybeZohUpsample(const Type* data,
 		// prevent severe clicks and pops. Becomes a no-op when done.
 		envelope.Process(stereo, frame_with_gain);
 
-		out_frame = {};
-		out_frame[mapped_output_left]  += frame_with_gain.left;
+		AudioFrame out_frame = {};
+		out_frame[mapped_output_left] += frame_with_gain.left;
 		out_frame[mapped_output_right] += frame_with_gain.right;
+		return out_frame;
+	};
+
+	if (do_zoh_upsample) {
+		// We set size to zero which will not change the data in the
+		// container at all. Then we overwrite the data below with
+		// `emplace_back()` which will set the correct length.
+		out.resize(0);
 
-		out.emplace_back(out_frame.left);
-		out.emplace_back(out_frame.right);
+		auto pos = 0;
+		while (pos < num_frames) {
+			prev_frame = next_frame;
+			next_frame = converted_frame(pos);
+
+			const auto out_frame = map_and_scale(prev_frame);
+			out.emplace_back(out_frame.left);
+			out.emplace_back(out_frame.right);
 
-		if (do_zoh_upsample) {
 			zoh_upsampler.pos += zoh_upsampler.step;
 			if (zoh_upsampler.pos > 1.0f) {
 				zoh_upsampler.pos -= 1.0f;
 				++pos;
 			}
+		}
+		return;
+	}
+
+	// Without upsampling, every frame is output one frame late, the first
+	// one being the last frame of the previous block
+	out.resize(static_cast<size_t>(num_frames) * 2);
+	if (num_frames == 0) {
+		return;
+	}
+
+	auto write_frame = [&](const int out_pos, const AudioFrame frame) {
+		const auto out_frame = map_and_scale(frame);
+		out[out_pos * 2]     = out_frame.left;
+		out[out_pos * 2 + 1] = out_frame.right;
+	};
+	write_frame(0, next_frame);
+
+	const auto num_delayed = static_cast<size_t>(num_frames - 1);
+
+	const auto is_unmapped = (mapped_output_left == Left &&
+	                          mapped_output_right == Right &&
+	                          mapped_channel_left == Left &&
+	                          (mapped_channel_right == Right || !stereo));
+
+	// Unmapped frames need only scaling once the envelope is done
+	if (is_unmapped && !envelope.IsActive()) {
+		const auto [gain_left, gain_right] = combined_volume_gain;
+		if (stereo) {
+			MIXER_ScaleStereoFrames(
+			        samples, num_delayed, gain_left, gain_right, &out[2]);
 		} else {
-			++pos;
+			MIXER_ScaleMonoFramesToStereo(
+			        samples, num_delayed, gain_left, gain_right, &out[2]);
+		}
+	} else {
+		for (auto pos = 1; pos < num_frames; ++pos) {
+			write_frame(pos, converted_frame(pos - 1));
 		}
 	}
+
+	if (num_frames > 1) {
+		prev_frame = converted_frame(num_frames - 2);
+	} else {
+		prev_frame = next_frame;
+	}
+	next_frame = converted_frame(num_frames - 1);
 }
 
 static spx_uint32_t estimate_max_out_frames(SpeexResamplerState* resampler_state,
@@ -1992,8 +2278,8 @@ void MixerChannel::AddSamples(const int num_frames, const Type* data)
 	// buffers and to simplify the code.
 	//
 	auto& convert_dest_buf = (do_lerp_upsample || do_resample)
-	                               ? mixer.temp_buf
-	                               : mixer.out_buf;
+	                               ? temp_buf
+	                               : out_buf;
 
 	ConvertSamplesAndMaybeZohUpsample<Type, stereo, signeddata, nativeorder>(
 	        data, num_frames, convert_dest_buf);
@@ -2001,15 +2287,15 @@ void MixerChannel::AddSamples(const int num_frames, const Type* data)
 	if (do_lerp_upsample) {
 		auto& s = lerp_upsampler;
 
-		auto in_pos = mixer.temp_buf.cbegin();
-		auto& out   = mixer.out_buf;
+		auto in_pos = temp_buf.cbegin();
+		auto& out   = out_buf;
 
 		// We set size to zero which will not change the data in the
 		// container at all. Then we overwrite the data below with
 		// `emplace_back()` which will set the correct length.
 		out.resize(0);
 
-		while (in_pos != mixer.temp_buf.cend()) {
+		while (in_pos != temp_buf.cend()) {
 			AudioFrame curr_frame = {*in_pos, *(in_pos + 1)};
 
 			assert(s.pos >= 0.0f && s.pos <= 1.0f);
@@ -2051,82 +2337,127 @@ void MixerChannel::AddSamples(const int num_frames, const Type* data)
 
 	if (do_resample) {
 		auto in_frames = check_cast<spx_uint32_t>(
-		        mixer.temp_buf.size() / 2);
+		        temp_buf.size() / 2);
 
 		auto out_frames = check_cast<spx_uint32_t>(
 		        estimate_max_out_frames(speex_resampler.state, in_frames));
 
 
-		mixer.out_buf.resize(out_frames * 2);
+		out_buf.resize(out_frames * 2);
+
+		ProfileTimer timer(profile.resample_ns);
 
 		speex_resampler_process_interleaved_float(speex_resampler.state,
-		                                          mixer.temp_buf.data(),
+		                                          temp_buf.data(),
 		                                          &in_frames,
-		                                          mixer.out_buf.data(),
+		                                          out_buf.data(),
 		                                          &out_frames);
 
 		// 'out_frames' now contains the actual number of
 		// resampled frames, so ensure the number of output frames
 		// is within the logical size.
-		assert(out_frames <= mixer.out_buf.size() / 2);
-		mixer.out_buf.resize(out_frames * 2); // only shrinks
+		assert(out_frames <= out_buf.size() / 2);
+		out_buf.resize(out_frames * 2); // only shrinks
 	}
 
 	MIXER_LockAudioDevice();
 
 	// Optionally filter, apply crossfeed, then mix the results to the
-	// master output
+	// master output. The filters run over the whole block in place, on both
+	// channels at once. The crossfeed and the sleeper carry state from frame
+	// to frame, so they run frame by frame in place, while the sends and the
+	// mixing are done with the vectorised sample kernels.
 	const auto pos_offset = mixer.pos + frames_done;
-	auto work_pos         = mixer.work.begin() + pos_offset;
-	auto aux_reverb_pos   = mixer.aux_reverb.begin() + pos_offset;
-	auto aux_chorus_pos   = mixer.aux_chorus.begin() + pos_offset;
+	const auto out_frames = check_cast<int>(out_buf.size() / 2);
 
-	auto out_buf_pos = mixer.out_buf.cbegin();
+	// Applies 'process' to the frames of the output buffer in place
+	auto process_out_buf = [&](auto process) {
+		for (auto it = out_buf.begin(); it != out_buf.end(); it += 2) {
+			const auto frame = process(AudioFrame{it[0], it[1]});
 
-	while (out_buf_pos != mixer.out_buf.cend()) {
-		AudioFrame frame = {*out_buf_pos++, *out_buf_pos++};
-
-		if (filters.highpass.state == FilterState::On) {
-			frame = {filters.highpass.hpf[0].filter(frame.left),
-			         filters.highpass.hpf[1].filter(frame.right)};
-		}
-		if (filters.lowpass.state == FilterState::On) {
-			frame = {filters.lowpass.lpf[0].filter(frame.left),
-			         filters.lowpass.lpf[1].filter(frame.right)};
+			it[0] = frame.left;
+			it[1] = frame.right;
 		}
+	};
 
-		if (do_crossfeed) {
-			frame = ApplyCrossfeed(frame);
+	const auto do_highpass = (filters.highpass.state == FilterState::On);
+	const auto do_lowpass  = (filters.lowpass.state == FilterState::On);
+
+	// Runs the filter's sections over the output buffer
+	auto filter_out_buf = [&](MixerFilterCascade& cascade) {
+		MIXER_FilterStereoFrames(out_buf.data(),
+		                         out_buf.size() / 2,
+		                         cascade.sections.data(),
+		                         cascade.states.data(),
+		                         cascade.num_sections);
+	};
+
+	if (do_highpass || do_lowpass || do_crossfeed) {
+		ProfileTimer timer(profile.filters_ns);
+
+		if (do_highpass) {
+			filter_out_buf(filters.highpass.cascade);
 		}
-		if (do_reverb_send) {
-			// Accumulate reverb sends from the individual channels
-			// in the reverb aux buffer. Once we've done this for
-			// all our channels, we can feed the accumulated inputs
-			// through the reverb only once. The reverb is
-			// configured for 100% wet output.
-			//
-			// Our reverb algorithm is a linear process, so applying
-			// the reverb effect individually to N channels would
-			// yield bit-identical results, but it would be N-times
-			// more expensive.
-			*aux_reverb_pos++ += (frame * reverb.send_gain);
+		if (do_lowpass) {
+			filter_out_buf(filters.lowpass.cascade);
 		}
-		if (do_chorus_send) {
-			// Similarly to reverb processing, we accumulate chorus
-			// sends from the individual channels in the chorus aux
-			// buffer. The chorus configured for 100% wet output.
-			*aux_chorus_pos++ += (frame * chorus.send_gain);
+		if (do_crossfeed) {
+			process_out_buf([&](const AudioFrame frame) {
+				return ApplyCrossfeed(frame);
+			});
 		}
+	}
 
-		if (do_sleep) {
-			frame = sleeper.MaybeFadeOrListen(frame);
-		}
+	const float* out_samples = out_buf.data();
+
+	// Accumulate reverb sends from the individual channels in the reverb
+	// aux buffer. Once we've done this for all our channels, we can feed
+	// the accumulated inputs through the reverb only once. The reverb is
+	// configured for 100% wet output.
+	//
+	// Our reverb algorithm is a linear process, so applying the reverb
+	// effect individually to N channels would yield bit-identical results,
+	// but it would be N-times more expensive.
+	//
+	// Similarly to reverb processing, we accumulate chorus sends from the
+	// individual channels in the chorus aux buffer. The chorus configured
+	// for 100% wet output.
+	if (do_reverb_send || do_chorus_send) {
+		auto send_run = [&](const int frame, const int run, const int done) {
+			const auto src         = out_samples + done * 2;
+			const auto num_samples = static_cast<size_t>(run) * 2;
+
+			if (do_reverb_send) {
+				MIXER_AccumulateScaledSamples(
+				        mix_buffer_samples(mixer.aux_reverb, frame),
+				        src,
+				        reverb.send_gain,
+				        num_samples);
+			}
+			if (do_chorus_send) {
+				MIXER_AccumulateScaledSamples(
+				        mix_buffer_samples(mixer.aux_chorus, frame),
+				        src,
+				        chorus.send_gain,
+				        num_samples);
+			}
+		};
+		for_each_mix_buffer_run(pos_offset, out_frames, send_run);
+	}
 
-		// Mix samples to the master output
-		*work_pos++ += frame;
+	if (do_sleep) {
+		process_out_buf([&](const AudioFrame frame) {
+			return sleeper.MaybeFadeOrListen(frame);
+		});
 	}
 
-	const auto out_frames = check_cast<int>(mixer.out_buf.size() / 2);
+	// Mix samples to the master output
+	auto mix_run = [&](const int frame, const int run, const int done) {
+		MIXER_AccumulateSamples(mix_buffer_samples(mixer.work, frame),
+		                        out_samples + done * 2,
+		                        static_cast<size_t>(run) * 2);
+	};
+	for_each_mix_buffer_run(pos_offset, out_frames, mix_run);
 
 	frames_done += out_frames;
 
@@ -2279,7 +2610,10 @@ void MixerChannel::FillUp()
 	}
 	const auto index = PIC_TickIndex();
 
-	auto frames_remaining = static_cast<int>(index * mixer.frames_needed);
+	const auto tick_frames = mixer.frames_needed - mixer.tick_start_frame;
+
+	auto frames_remaining = mixer.tick_start_frame +
+	                        static_cast<int>(index * tick_frames);
 	while (frames_remaining > 0) {
 		const auto frames_to_mix = std::clamp(
 		        frames_remaining, 0, static_cast<int>(MixerBufferByteSize));
@@ -2359,115 +2693,165 @@ static constexpr float calc_frames_per_tick(const int freq_hz)
 	return static_cast<float>(freq_hz) / MillisecondsPerTick;
 }
 
-// Mix a certain amount of new sample frames
-static void mix_samples(const int frames_requested)
+static void start_parallel_rendering()
 {
-	assert(frames_requested >= 0);
+	mixer.parallel.is_enabled = true;
 
-	constexpr auto CaptureBufFrames = 1024;
+	LOG_MSG("MIXER: Rendering channels in parallel on up to %d worker threads",
+	        WORKERS_GetNumThreads());
+}
 
-	const auto frames_added = std::min(frames_requested - mixer.frames_done,
-	                                   CaptureBufFrames);
+static void stop_parallel_rendering()
+{
+	mixer.parallel.is_enabled = false;
+}
 
-	const auto pos_offset     = mixer.pos + mixer.frames_done;
-	const auto start_work_pos = mixer.work.begin() + pos_offset;
+// Renders all channels, then accumulates their results in the master mix
+// buffer. When parallel rendering is enabled, the channels supporting it
+// render on the shared worker threads and the emulation thread, after the
+// others rendered in order. The threads then accumulate their results in
+// whichever order they finish, so the sums can differ in their lowest bits
+// from run to run.
+static void render_channels(const int frames_requested)
+{
+	auto& parallel = mixer.parallel;
 
-	// Render all channels and accumulate results in the master mixbuffer
-	for (const auto& [_, channel] : mixer.channels) {
-		channel->Mix(frames_requested);
+	if (!parallel.is_enabled) {
+		for (const auto& [_, channel] : mixer.channels) {
+			channel->Mix(frames_requested);
+		}
+		return;
 	}
 
-	if (mixer.do_reverb) {
-		// Use the contents of the reverb aux buffer as the reverb's
-		// input, then mix its output to the master mix buffer.
-		auto work_pos       = start_work_pos;
-		auto aux_reverb_pos = mixer.aux_reverb.begin() + pos_offset;
-		auto num_frames     = frames_added;
-
-		while (num_frames--) {
-			auto in_frame = *aux_reverb_pos++;
+	parallel.channels.clear();
+	for (const auto& [_, channel] : mixer.channels) {
+		// Sleeping channels have nothing to render, so they're not
+		// worth waking up a worker thread for
+		if (!channel->is_enabled) {
+			continue;
+		}
+		if (channel->HasFeature(ChannelFeature::ParallelRendering)) {
+			parallel.channels.push_back(channel.get());
+		} else {
+			channel->Mix(frames_requested);
+		}
+	}
+	if (parallel.channels.empty()) {
+		return;
+	}
 
-			// High-pass filter the reverb input
-			auto& hpf = mixer.reverb.highpass_filter;
+	const auto num_channels = check_cast<int>(parallel.channels.size());
 
-			in_frame = {hpf[0].filter(in_frame.left),
-			            hpf[1].filter(in_frame.right)};
+	WORKERS_ParallelFor(num_channels, num_channels - 1, [&](const int index, int) {
+		ZoneScopedN("Mixer parallel render");
 
-			// MVerb operates on two non-interleaved sample streams
-			float* in_buf[2] = {&in_frame.left, &in_frame.right};
+		is_rendering_in_parallel = true;
+		parallel.channels[index]->Mix(frames_requested);
+		is_rendering_in_parallel = false;
+	});
+}
 
-			AudioFrame out_frame = {};
-			float* out_buf[2] = {&out_frame.left, &out_frame.right};
+// Runs the master output's high-pass filter and then the compressor over
+// 'num_frames' frames in place
+template <bool DoCompressor>
+static void process_master_frames(AudioFrame* frames, const int num_frames)
+{
+	auto& hpf = mixer.highpass_filter;
 
-			constexpr auto NumFrames = 1;
-			mixer.reverb.mverb.process(in_buf, out_buf, NumFrames);
+	for (auto frame = frames; frame != frames + num_frames; ++frame) {
+		AudioFrame out = {hpf[0].filter(frame->left),
+		                  hpf[1].filter(frame->right)};
 
-			*work_pos++ += out_frame;
+		if constexpr (DoCompressor) {
+			// The compressor is the very last step
+			out = mixer.compressor.Process(out);
 		}
+		*frame = out;
 	}
+}
 
-	if (mixer.do_chorus) {
-		// Apply chorus effect to the chorus aux buffer, then mix the
-		// results to the master output
-		auto work_pos       = start_work_pos;
-		auto aux_chorus_pos = mixer.aux_chorus.begin() + pos_offset;
-		auto num_frames     = frames_added;
+static void mix_samples(const int frames_requested)
+{
+	assert(frames_requested >= 0);
 
-		while (num_frames--) {
-			auto frame = *aux_chorus_pos++;
-			mixer.chorus.chorus_engine.process(&frame.left, &frame.right);
+	ZoneScoped;
+	TracyPlot("Mixer frames requested", static_cast<int64_t>(frames_requested));
 
-			*work_pos++ += frame;
-		}
-	}
+	constexpr auto CaptureBufFrames = 1024;
 
-	// Apply high-pass filter to the master output
-	{
-		auto work_pos   = start_work_pos;
-		auto num_frames = frames_added;
+	const auto frames_added = std::min(frames_requested - mixer.frames_done,
+	                                   CaptureBufFrames);
 
-		while (num_frames--) {
-			auto& hpf = mixer.highpass_filter;
+	const auto pos_offset = mixer.pos + mixer.frames_done;
 
-			const auto frame = *work_pos;
-			*work_pos++      = {hpf[0].filter(frame.left),
-			                    hpf[1].filter(frame.right)};
-		}
+	// Render all channels and accumulate results in the master mixbuffer
+	render_channels(frames_requested);
+
+	if (mixer.do_reverb) {
+		ProfileTimer timer(mixer.profile.reverb_ns);
+
+		// Use the contents of the reverb aux buffer as the reverb's
+		// input, then mix its output to the master mix buffer.
+		auto reverb_run = [](const int frame, const int run, int) {
+			mixer.reverb.Process(mixer.aux_reverb.data().data() + frame,
+			                     run,
+			                     mixer.work.data().data() + frame);
+		};
+		for_each_mix_buffer_run(pos_offset, frames_added, reverb_run);
 	}
 
-	if (mixer.do_compressor) {
-		// Apply compressor to the master output as the very last step
-		auto work_pos   = start_work_pos;
-		auto num_frames = frames_added;
+	if (mixer.do_chorus) {
+		ProfileTimer timer(mixer.profile.chorus_ns);
 
-		while (num_frames--) {
-			const auto frame = *work_pos;
-			*work_pos++      = mixer.compressor.Process(frame);
-		}
+		// Apply chorus effect to the chorus aux buffer, then mix the
+		// results to the master output
+		auto chorus_run = [](const int frame, const int run, int) {
+			mixer.chorus.Process(mixer.aux_chorus.data().data() + frame,
+			                     run,
+			                     mixer.work.data().data() + frame);
+		};
+		for_each_mix_buffer_run(pos_offset, frames_added, chorus_run);
 	}
 
+	ProfileTimer master_timer(mixer.profile.master_ns);
+
 	// Capture audio output if requested
-	if (CAPTURE_IsCapturingAudio() || CAPTURE_IsCapturingVideo()) {
-		int16_t out[CaptureBufFrames][2] = {};
+	const auto do_capture = CAPTURE_IsCapturingAudio() ||
+	                        CAPTURE_IsCapturingVideo();
 
-		auto work_pos   = start_work_pos;
+	// Only the added frames get written and captured
+	int16_t capture_buf[CaptureBufFrames][2];
 
-		for (auto i = 0; i < frames_added; ++i) {
-			const auto in_frame = *work_pos++;
+	// Filter and compress the master output in a single sweep, then
+	// convert the frames to capture while they're still in the cache
+	auto master_run = [&](const int frame, const int run, const int done) {
+		auto frames = mixer.work.data().data() + frame;
 
-			const auto left = static_cast<uint16_t>(
-			        clamp_to_int16(static_cast<int>(in_frame.left)));
+		if (mixer.do_compressor) {
+			process_master_frames<true>(frames, run);
+		} else {
+			process_master_frames<false>(frames, run);
+		}
 
-			const auto right = static_cast<uint16_t>(
-			        clamp_to_int16(static_cast<int>(in_frame.right)));
+		if (do_capture) {
+			MIXER_ConvertToInt16(&frames->left,
+			                     static_cast<size_t>(run) * 2,
+			                     capture_buf[done]);
+		}
+	};
+	for_each_mix_buffer_run(pos_offset, frames_added, master_run);
 
-			out[i][0] = static_cast<int16_t>(host_to_le16(left));
-			out[i][1] = static_cast<int16_t>(host_to_le16(right));
+	if (do_capture) {
+		for (auto i = 0; i < frames_added; ++i) {
+			for (auto& sample : capture_buf[i]) {
+				sample = static_cast<int16_t>(
+				        host_to_le16(static_cast<uint16_t>(sample)));
+			}
 		}
 
 		CAPTURE_AddAudioData(mixer.sample_rate_hz,
 		                     frames_added,
-		                     reinterpret_cast<int16_t*>(out));
+		                     reinterpret_cast<int16_t*>(capture_buf));
 	}
 
 	// Reset the frames_per_tick
@@ -2475,20 +2859,6 @@ static void mix_samples(const int frames_requested)
 	mixer.frames_done     = frames_requested;
 }
 
-static void handle_mix_samples()
-{
-	MIXER_LockAudioDevice();
-
-	mix_samples(mixer.frames_needed);
-
-	mixer.frame_counter += mixer.frames_per_tick;
-	mixer.frames_needed += ifloor(mixer.frame_counter);
-
-	mixer.frame_counter -= floor(mixer.frame_counter);
-
-	MIXER_UnlockAudioDevice();
-}
-
 static void reduce_channels_done_counts(const int at_most)
 {
 	assert(at_most >= 0);
@@ -2498,131 +2868,125 @@ static void reduce_channels_done_counts(const int at_most)
 	}
 }
 
-static void handle_mix_no_sound()
+// Adds the frames of the next tick to the ones the channels have to render
+static void add_next_tick_frames()
+{
+	mixer.frame_counter += mixer.frames_per_tick;
+	const auto tick_frames = ifloor(mixer.frame_counter);
+	mixer.frame_counter -= floor(mixer.frame_counter);
+
+	mixer.tick_start_frame = mixer.frames_needed;
+	mixer.frames_needed += tick_frames;
+}
+
+// Mixes the frames of the ticks accumulated so far once they make up a
+// processing block, then retires them from the mix buffers, optionally
+// queueing them for the audio callback first
+static void mix_and_retire_frames(const bool queue_output)
 {
 	MIXER_LockAudioDevice();
 
+	if (mixer.frames_needed < mixer.processing_blocksize) {
+		add_next_tick_frames();
+
+		MIXER_UnlockAudioDevice();
+		return;
+	}
+
 	mix_samples(mixer.frames_needed);
 
-	// Clear piece we've just generated
-	auto work_pos   = mixer.work.begin() + mixer.pos;
-	auto num_frames = mixer.frames_needed.load();
+	const auto num_frames = mixer.frames_needed.load();
 
-	mixer.pos += num_frames;
+	auto retire_run = [&](const int frame, const int run, int) {
+		auto work_frames = mixer.work.data().data() + frame;
 
-	const auto work_size = check_cast<int>(mixer.work.size());
-	if (mixer.pos >= work_size) {
-		mixer.pos -= work_size;
-	}
+		if (queue_output) {
+			const auto num_queued = mixer.output_queue.Push(
+			        work_frames, static_cast<size_t>(run));
 
-	constexpr AudioFrame Silence = {0.0f};
-	while (num_frames--) {
-		*work_pos++ = Silence;
-	}
+			if (num_queued < static_cast<size_t>(run)) {
+				++mixer.overruns;
+			}
+		}
 
-	reduce_channels_done_counts(mixer.frames_needed);
+		constexpr AudioFrame Silence = {0.0f};
 
-	// Set values for next tick
-	mixer.frame_counter += mixer.frames_per_tick;
-	mixer.frames_needed = ifloor(mixer.frame_counter);
+		std::fill_n(work_frames, run, Silence);
+		std::fill_n(mixer.aux_reverb.data().data() + frame, run, Silence);
+		std::fill_n(mixer.aux_chorus.data().data() + frame, run, Silence);
+	};
+	for_each_mix_buffer_run(mixer.pos, num_frames, retire_run);
 
-	mixer.frame_counter -= floor(mixer.frame_counter);
-	mixer.frames_done = 0;
+	mixer.pos = (mixer.pos + num_frames) % check_cast<int>(mixer.work.size());
+
+	reduce_channels_done_counts(num_frames);
+
+	// Set values for next tick
+	mixer.frames_needed = 0;
+	mixer.frames_done   = 0;
+	add_next_tick_frames();
 
 	MIXER_UnlockAudioDevice();
 }
 
+static void handle_mix_samples()
+{
+	constexpr auto QueueOutput = true;
+	mix_and_retire_frames(QueueOutput);
+}
+
+static void handle_mix_no_sound()
+{
+	constexpr auto QueueOutput = false;
+	mix_and_retire_frames(QueueOutput);
+}
+
+// Runs on the SDL audio thread, and only takes the frames queued by
+// handle_mix_samples(), so it never has to wait for the emulation
 static void SDLCALL mixer_callback([[maybe_unused]] void* userdata,
                                    Uint8* stream, int bytes_requested)
 {
 	assert(bytes_requested >= 0);
 
 	ZoneScoped;
+
+	// SDL's audio thread is started from the pinned emulation thread, and
+	// restarted with the audio device
+	thread_local bool is_thread_configured = false;
+	if (!is_thread_configured) {
+		HOST_THREADS_ApplyToCurrentThread(HostThreadGroup::Audio);
+		is_thread_configured = true;
+	}
+
 	memset(stream, 0, static_cast<size_t>(bytes_requested));
 
 	constexpr auto BytesPer16BitSample = 2;
 	constexpr auto BytesPerSampleFrame = BytesPer16BitSample * 2; // stereo
 
-	const auto frames_requested = bytes_requested / BytesPerSampleFrame;
-
-	auto reduce_frames = 0;
-
-	// Used for time-stretching the audio in the buffer overrun scenario.
-	float index     = 0;
-	float index_add = 0;
-
-	if (mixer.frames_done < frames_requested) {
-		// Buffer underrun
-#if 0
-		LOG_WARNING("MIXER: Full underrun requested %d, have %d, min %d",
-		            frames_requested,
-		            mixer.frames_done.load(),
-		            mixer.min_frames_needed.load());
-#endif
+	const auto frames_requested = std::min(
+	        static_cast<size_t>(bytes_requested / BytesPerSampleFrame),
+	        mixer.callback_frames.size());
 
-		reduce_frames = mixer.frames_done;
+	auto& frames = mixer.callback_frames;
+	auto output  = reinterpret_cast<int16_t*>(stream);
 
-	} else if (mixer.frames_done < mixer.max_frames_needed) {
-		auto frames_remaining = mixer.frames_done - frames_requested;
+	const auto frames_available = mixer.output_queue.Size();
 
-		if (frames_remaining < mixer.min_frames_needed) {
-			frames_remaining = (mixer.min_frames_needed - frames_remaining);
-
-			frames_remaining = 1 + (2 * frames_remaining) /
-			                               mixer.min_frames_needed;
-#if 0
-			LOG_WARNING("MIXER: Needed underrun requested %d, have %d, min %d, remaining %d",
-			            frames_requested,
-			            mixer.frames_done.load(),
-			            mixer.min_frames_needed.load(),
-			            frames_remaining);
-#endif
-			reduce_frames = frames_requested - frames_remaining;
-
-		} else {
-			reduce_frames = frames_requested;
-#if 0
-			LOG_MSG("MIXER: Regular run requested %d, have %d, min %d, remaining %d",
-			        frames_requested,
-			        mixer.frames_done.load(),
-			        mixer.min_frames_needed.load(),
-			        frames_remaining);
-#endif
+	if (frames_available <= static_cast<size_t>(mixer.max_frames_needed)) {
+		// Regular run, or an underrun if the emulation couldn't keep up;
+		// the missing frames are left silent
+		const auto num_frames = mixer.output_queue.Pop(frames.data(),
+		                                               frames_requested);
+		if (num_frames < frames_requested) {
+			++mixer.underruns;
 		}
 
+		MIXER_ConvertToInt16(reinterpret_cast<const float*>(frames.data()),
+		                     num_frames * 2,
+		                     output);
 	} else {
 		// Buffer overrun -- this usually happens in fast-forward mode.
-#if 0
-		LOG_WARNING("MIXER: Overflow run requested %d, have %d, min % d ",
-		            frames_requested,
-		            mixer.frames_done.load(),
-		            mixer.min_frames_needed.load());
-#endif
-		if (mixer.frames_done > MixerBufferByteSize) {
-			index_add = static_cast<float>(
-			        MixerBufferByteSize - 2 * mixer.min_frames_needed);
-		} else {
-			index_add = static_cast<float>(
-			        mixer.frames_done - 2 * mixer.min_frames_needed);
-		}
-
-		index_add = index_add / static_cast<float>(frames_requested);
-		reduce_frames = mixer.frames_done - 2 * mixer.min_frames_needed;
-	}
-
-	reduce_channels_done_counts(reduce_frames);
-
-	// Reset mixer.frames_per_tick
-	mixer.frames_per_tick = calc_frames_per_tick(mixer.sample_rate_hz);
-
-	mixer.frames_done -= reduce_frames;
-
-	const auto frames_needed = mixer.frames_needed - reduce_frames;
-	mixer.frames_needed      = frames_needed;
-
-	auto output = reinterpret_cast<int16_t*>(stream);
-
-	if (frames_requested != reduce_frames) {
+		//
 		// We're doing a very crude sample-skipping style audio
 		// stretching here. However, it's worth keeping it as this path
 		// is almost exclusively used in the fast-forward mode to
@@ -2630,57 +2994,48 @@ static void SDLCALL mixer_callback([[maybe_unused]] void* userdata,
 		//
 		// Without this effect, the audio becomes a crackling mess when
 		// fast-forwarding.
-		auto num_frames = std::min(reduce_frames, frames_requested);
-		auto work_pos   = mixer.work.begin() + mixer.pos.load();
+		const auto num_frames = mixer.output_queue.Pop(frames.data(),
+		                                               frames_available);
 
-		while (num_frames--) {
-			index += index_add;
+		const auto index_add = static_cast<float>(num_frames) /
+		                       static_cast<float>(frames_requested);
+		auto index = 0.0f;
 
-			const auto frame = *(work_pos + static_cast<int>(index));
-
-			*output++ = clamp_to_int16(frame.left);
-			*output++ = clamp_to_int16(frame.right);
-		}
-	} else {
-		auto num_frames = reduce_frames;
-		auto work_pos   = mixer.work.begin() + mixer.pos.load();
+		for (size_t i = 0; i < frames_requested; ++i) {
+			index += index_add;
 
-		while (num_frames--) {
-			const auto frame = *work_pos++;
+			const auto frame = frames[std::min(static_cast<size_t>(index),
+			                                   num_frames - 1)];
 
 			*output++ = clamp_to_int16(frame.left);
 			*output++ = clamp_to_int16(frame.right);
 		}
 	}
+}
 
-	// Clear the used buffers
-	{
-		auto num_frames = reduce_frames;
-
-		const auto pos_offset = mixer.pos.load();
-		auto work_pos         = mixer.work.begin() + pos_offset;
-		auto aux_reverb_pos   = mixer.aux_reverb.begin() + pos_offset;
-		auto aux_chorus_pos   = mixer.aux_chorus.begin() + pos_offset;
-
-		while (num_frames--) {
-			constexpr AudioFrame Silence = {0.0f};
+static void stop_mixer([[maybe_unused]] Section* sec)
+{
+	stop_parallel_rendering();
 
-			*work_pos++       = Silence;
-			*aux_reverb_pos++ = Silence;
-			*aux_chorus_pos++ = Silence;
-		}
+	if (mixer.underruns > 0 || mixer.overruns > 0) {
+		LOG_MSG("MIXER: The audio output had %d buffer underruns and %d overruns",
+		        mixer.underruns.load(),
+		        mixer.overruns.load());
 	}
 
-	mixer.pos += reduce_frames;
+	// Report where the resampling time went to help tuning the quality
+	for (const auto& [name, channel] : mixer.channels) {
+		constexpr auto NanosPerMs = 1'000'000;
 
-	const auto work_size = check_cast<int>(mixer.work.size());
-	if (mixer.pos >= work_size) {
-		mixer.pos -= work_size;
+		if (const auto resample_ns = channel->GetProfile().resample_ns;
+		    resample_ns > 0) {
+			LOG_DEBUG("MIXER: %s spent %" PRId64 " ms resampling",
+			          name.c_str(),
+			          resample_ns / NanosPerMs);
+		}
 	}
 }
 
-static void stop_mixer([[maybe_unused]] Section* sec) {}
-
 [[maybe_unused]] static const char* to_string(const MixerState s)
 {
 	switch (s) {
@@ -2763,10 +3118,53 @@ void MIXER_CloseAudioDevice()
 }
 
 // Sets `mixer.sample_rate_hz` and `mixer.blocksize` on success
-static bool init_sdl_sound(const int requested_sample_rate_hz,
+// SDL starts its audio subsystem with its default driver, so it's restarted
+// with the requested one
+static void select_sdl_audio_driver(const std::string& requested_driver)
+{
+	// The driver set in the environment takes precedence (e.g., the dummy
+	// driver of headless runs)
+	if (requested_driver == "auto" || SDL_getenv("SDL_AUDIODRIVER")) {
+		return;
+	}
+	if (const auto current_driver = SDL_GetCurrentAudioDriver();
+	    current_driver && iequals(requested_driver, std::string(current_driver))) {
+		return;
+	}
+
+	SDL_AudioQuit();
+	if (SDL_AudioInit(requested_driver.c_str()) == 0) {
+		return;
+	}
+
+	std::string available_drivers = {};
+	for (auto i = 0; i < SDL_GetNumAudioDrivers(); ++i) {
+		if (!available_drivers.empty()) {
+			available_drivers += ", ";
+		}
+		available_drivers += SDL_GetAudioDriver(i);
+	}
+	LOG_WARNING("MIXER: Can't use the '%s' audio driver: %s; available drivers "
+	            "are: %s; using 'auto'",
+	            requested_driver.c_str(),
+	            SDL_GetError(),
+	            available_drivers.c_str());
+
+	set_section_property_value("mixer", "audio_driver", "auto");
+
+	if (SDL_AudioInit(nullptr) != 0) {
+		LOG_WARNING("MIXER: Can't restart the default audio driver: %s",
+		            SDL_GetError());
+	}
+}
+
+static bool init_sdl_sound(const std::string& requested_driver,
+                           const int requested_sample_rate_hz,
                            const int requested_blocksize_in_frames,
                            const bool allow_negotiate)
 {
+	select_sdl_audio_driver(requested_driver);
+
 	SDL_AudioSpec desired  = {};
 	SDL_AudioSpec obtained = {};
 
@@ -2847,9 +3245,13 @@ static bool init_sdl_sound(const int requested_sample_rate_hz,
 		                           format_str("%d", mixer.blocksize));
 	}
 
-	LOG_MSG("MIXER: Initialised stereo %d Hz audio with %d sample frame buffer",
+	const auto driver = SDL_GetCurrentAudioDriver();
+
+	LOG_MSG("MIXER: Initialised stereo %d Hz audio with %d sample frame buffer "
+	        "using the '%s' driver",
 	        mixer.sample_rate_hz.load(),
-	        mixer.blocksize);
+	        mixer.blocksize,
+	        driver ? driver : "unknown");
 
 	return true;
 }
@@ -2890,6 +3292,8 @@ void MIXER_Init(Section* sec)
 	assert(secprop);
 
 	if (mixer.state == MixerState::Uninitialized) {
+		tracked_mixer.Track(&mixer, sizeof(mixer));
+
 		// Initialize the 8-bit to 16-bit lookup table
 		fill_8to16_lut();
 
@@ -2923,7 +3327,8 @@ void MIXER_Init(Section* sec)
 			set_no_sound();
 
 		} else {
-			if (init_sdl_sound(secprop->Get_int("rate"),
+			if (init_sdl_sound(secprop->Get_string("audio_driver"),
+			                   secprop->Get_int("rate"),
 							   secprop->Get_int("blocksize"),
 							   secprop->Get_bool("negotiate"))) {
 
@@ -2935,6 +3340,15 @@ void MIXER_Init(Section* sec)
 			}
 		}
 
+		mixer.resample_quality = clamp(secprop->Get_int("resample_quality"),
+		                               0,
+		                               MaxResampleQuality);
+
+		mixer.processing_blocksize = clamp(secprop->Get_int(
+		                                           "processing_blocksize"),
+		                                   0,
+		                                   MaxProcessingBlocksize);
+
 		const auto requested_prebuffer_ms = secprop->Get_int("prebuffer");
 		mixer.prebuffer_ms = clamp(requested_prebuffer_ms, 1, MaxPrebufferMs);
 
@@ -2945,9 +3359,14 @@ void MIXER_Init(Section* sec)
 		mixer.frames_per_tick = calc_frames_per_tick(mixer.sample_rate_hz);
 		mixer.frame_counter     = 0;
 		mixer.frames_done       = 0;
-		mixer.frames_needed     = mixer.min_frames_needed + 1;
-		mixer.min_frames_needed = 0;
-		mixer.max_frames_needed = mixer.blocksize * 2 + 2 * prebuffer_frames;
+		mixer.frames_needed     = 1;
+		mixer.tick_start_frame  = 0;
+		mixer.max_frames_needed = mixer.blocksize * 2 + 2 * prebuffer_frames +
+		                          mixer.processing_blocksize;
+
+		if (secprop->Get_bool("parallel_rendering")) {
+			start_parallel_rendering();
+		}
 
 		sec->AddDestroyFunction(&stop_mixer);
 	}
@@ -3085,12 +3504,47 @@ static void init_mixer_dosbox_settings(Section_prop& sec_prop)
 	        "(%s by default). Larger values might help with sound stuttering but will\n"
 	        "introduce more latency.");
 
+	int_prop = sec_prop.Add_int("processing_blocksize", OnlyAtStart, 0);
+	int_prop->SetMinMax(0, MaxProcessingBlocksize);
+	int_prop->Set_help(
+	        "Minimum number of sample frames the channels render and the mixer processes\n"
+	        "in one go (0 by default). 0 processes the audio on every 1 ms emulation tick;\n"
+	        "larger values (e.g., 64 to 256) gather the frames of several ticks into one\n"
+	        "block, which reduces the per-call overhead of the audio emulation at the cost\n"
+	        "of slightly more latency. The timing of the emulated devices is unaffected.");
+
 	bool_prop = sec_prop.Add_bool("negotiate", OnlyAtStart, DefaultAllowNegotiate);
 	bool_prop->Set_help(
 	        "Negotiate a possibly better 'blocksize' setting (%s by default).\n"
 	        "Enable it if you're not getting audio or the sound is stuttering with your\n"
 	        "'blocksize' setting. Disable it to force the manually set 'blocksize' value.");
 
+	auto string_prop = sec_prop.Add_string("audio_driver", OnlyAtStart, "auto");
+	string_prop->Set_help(
+	        "Host audio driver to output the sound through ('auto' by default).\n"
+	        "  auto:         Use the default driver of the host.\n"
+	        "  <name>:       Use the named driver, e.g., 'pipewire' or 'alsa' on Linux,\n"
+	        "                'wasapi' on Windows, or 'coreaudio' on macOS. Talking to the\n"
+	        "                native driver directly (instead of through a sound server\n"
+	        "                like PulseAudio) can reach lower latencies with a small\n"
+	        "                'blocksize' and 'prebuffer'.\n"
+	        "Ignored if the SDL_AUDIODRIVER environment variable is set.");
+
+	int_prop = sec_prop.Add_int("resample_quality", OnlyAtStart, DefaultResampleQuality);
+	int_prop->SetMinMax(0, MaxResampleQuality);
+	int_prop->Set_help(
+	        "Quality of the resampler converting the channels to the output rate, from 0\n"
+	        "(fastest) to 10 (best quality); %s by default. Lower values save CPU time at\n"
+	        "the cost of more aliasing. Channels whose rate divides the output rate evenly\n"
+	        "are upsampled by repeating their samples and skip the resampler entirely.");
+
+	bool_prop = sec_prop.Add_bool("parallel_rendering", OnlyAtStart, false);
+	bool_prop->Set_help(
+	        "Render the synthesizer channels that support it in parallel on worker threads\n"
+	        "(disabled by default). Spreads the cost of the audio emulation across CPU\n"
+	        "cores, but the audio output is no longer bit-identical from run to run.\n"
+	        "Currently supported by the OPL, CMS, Tandy and PS/1 synthesizers.");
+
 	constexpr auto DefaultOn = true;
 	bool_prop = sec_prop.Add_bool("compressor", WhenIdle, DefaultOn);
 	bool_prop->Set_help(
@@ -3099,7 +3553,7 @@ static void init_mixer_dosbox_settings(Section_prop& sec_prop)
 	        "  off:  Disable compressor.\n"
 	        "  on:   Enable compressor (default).");
 
-	auto string_prop = sec_prop.Add_string("crossfeed", WhenIdle, "off");
+	string_prop = sec_prop.Add_string("crossfeed", WhenIdle, "off");
 	string_prop->Set_help(
 	        "Enable crossfeed globally on all stereo channels for headphone listening:\n"
 	        "  off:     No crossfeed (default).\n"
@@ -0,0 +1,674 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#include "mixer_kernels.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define MIXER_KERNELS_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIXER_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+constexpr auto Int16Min = static_cast<float>(INT16_MIN);
+constexpr auto Int16Max = static_cast<float>(INT16_MAX);
+
+static void accumulate_scalar(float* dest, const float* src, size_t num_samples)
+{
+	while (num_samples--) {
+		*dest++ += *src++;
+	}
+}
+
+static void accumulate_scaled_scalar(float* dest, const float* src,
+                                     const float gain, size_t num_samples)
+{
+	while (num_samples--) {
+		const auto scaled = *src++ * gain;
+		*dest++ += scaled;
+	}
+}
+
+static void convert_to_int16_scalar(const float* src, size_t num_samples,
+                                    int16_t* out)
+{
+	while (num_samples--) {
+		*out++ = static_cast<int16_t>(std::clamp(*src++, Int16Min, Int16Max));
+	}
+}
+
+static void convert_s16_to_float_scalar(const int16_t* src, size_t num_samples,
+                                        float* out)
+{
+	while (num_samples--) {
+		*out++ = static_cast<float>(*src++);
+	}
+}
+
+static void convert_u16_to_float_scalar(const uint16_t* src, size_t num_samples,
+                                        float* out)
+{
+	while (num_samples--) {
+		*out++ = static_cast<float>(static_cast<int>(*src++) - 32768);
+	}
+}
+
+static void scale_stereo_frames_scalar(const float* src, size_t num_frames,
+                                       const float gain_left,
+                                       const float gain_right, float* out)
+{
+	while (num_frames--) {
+		*out++ = *src++ * gain_left;
+		*out++ = *src++ * gain_right;
+	}
+}
+
+static void scale_mono_frames_to_stereo_scalar(const float* src,
+                                               size_t num_frames,
+                                               const float gain_left,
+                                               const float gain_right, float* out)
+{
+	while (num_frames--) {
+		const auto sample = *src++;
+		*out++ = sample * gain_left;
+		*out++ = sample * gain_right;
+	}
+}
+
+static void deinterleave_frames_scalar(const float* src, size_t num_frames,
+                                       float* left, float* right)
+{
+	while (num_frames--) {
+		*left++  = *src++;
+		*right++ = *src++;
+	}
+}
+
+static void accumulate_deinterleaved_frames_scalar(float* dest, const float* left,
+                                                   const float* right,
+                                                   size_t num_frames)
+{
+	while (num_frames--) {
+		*dest++ += *left++;
+		*dest++ += *right++;
+	}
+}
+
+static float get_peak_amplitude_scalar(const float* src, size_t num_samples,
+                                       float peak = 0.0f)
+{
+	while (num_samples--) {
+		peak = std::max(peak, std::fabs(*src++));
+	}
+	return peak;
+}
+
+[[maybe_unused]] static void filter_stereo_frames_scalar(
+        float* frames, size_t num_frames, const MixerBiquad* sections,
+        MixerBiquadState* states, const size_t num_sections)
+{
+	for (; num_frames > 0; --num_frames, frames += 2) {
+		for (size_t channel = 0; channel < 2; ++channel) {
+			double sample = frames[channel];
+
+			for (size_t i = 0; i < num_sections; ++i) {
+				const auto& s = sections[i];
+				auto& v1      = states[i].v1[channel];
+				auto& v2      = states[i].v2[channel];
+
+				const auto w = sample - s.a1 * v1 - s.a2 * v2;
+				sample       = s.b0 * w + s.b1 * v1 + s.b2 * v2;
+
+				v2 = v1;
+				v1 = w;
+			}
+			frames[channel] = static_cast<float>(sample);
+		}
+	}
+}
+
+#if MIXER_KERNELS_NEON
+static void accumulate_neon(float* dest, const float* src, size_t num_samples)
+{
+	for (; num_samples >= 8; num_samples -= 8, src += 8, dest += 8) {
+		vst1q_f32(dest, vaddq_f32(vld1q_f32(dest), vld1q_f32(src)));
+		vst1q_f32(dest + 4, vaddq_f32(vld1q_f32(dest + 4), vld1q_f32(src + 4)));
+	}
+	accumulate_scalar(dest, src, num_samples);
+}
+
+// Multiplies and adds separately, as a fused multiply-add would round
+// differently from the scalar code
+static void accumulate_scaled_neon(float* dest, const float* src,
+                                   const float gain, size_t num_samples)
+{
+	const auto gains = vdupq_n_f32(gain);
+
+	for (; num_samples >= 4; num_samples -= 4, src += 4, dest += 4) {
+		const auto scaled = vmulq_f32(vld1q_f32(src), gains);
+		vst1q_f32(dest, vaddq_f32(vld1q_f32(dest), scaled));
+	}
+	accumulate_scaled_scalar(dest, src, gain, num_samples);
+}
+
+static void convert_to_int16_neon(const float* src, size_t num_samples,
+                                  int16_t* out)
+{
+	const auto min = vdupq_n_f32(Int16Min);
+	const auto max = vdupq_n_f32(Int16Max);
+
+	for (; num_samples >= 8; num_samples -= 8, src += 8, out += 8) {
+		// The clamped values fit, so the narrowing doesn't saturate;
+		// the conversions truncate like the scalar casts
+		const auto low = vcvtq_s32_f32(
+		        vminq_f32(vmaxq_f32(vld1q_f32(src), min), max));
+		const auto high = vcvtq_s32_f32(
+		        vminq_f32(vmaxq_f32(vld1q_f32(src + 4), min), max));
+
+		vst1q_s16(out, vcombine_s16(vmovn_s32(low), vmovn_s32(high)));
+	}
+	convert_to_int16_scalar(src, num_samples, out);
+}
+
+static void convert_s16_to_float_neon(const int16_t* src, size_t num_samples,
+                                      float* out)
+{
+	for (; num_samples >= 8; num_samples -= 8, src += 8, out += 8) {
+		const auto samples = vld1q_s16(src);
+		vst1q_f32(out, vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))));
+		vst1q_f32(out + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))));
+	}
+	convert_s16_to_float_scalar(src, num_samples, out);
+}
+
+// Flipping the top bit turns the unsigned samples into signed ones offset
+// by 32768
+static void convert_u16_to_float_neon(const uint16_t* src, size_t num_samples,
+                                      float* out)
+{
+	const auto sign_bit = vdupq_n_u16(0x8000);
+
+	for (; num_samples >= 8; num_samples -= 8, src += 8, out += 8) {
+		const auto samples = vreinterpretq_s16_u16(
+		        veorq_u16(vld1q_u16(src), sign_bit));
+		vst1q_f32(out, vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))));
+		vst1q_f32(out + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))));
+	}
+	convert_u16_to_float_scalar(src, num_samples, out);
+}
+
+static void scale_stereo_frames_neon(const float* src, size_t num_frames,
+                                     const float gain_left,
+                                     const float gain_right, float* out)
+{
+	const float gain_pairs[4] = {gain_left, gain_right, gain_left, gain_right};
+	const auto gains = vld1q_f32(gain_pairs);
+
+	for (; num_frames >= 2; num_frames -= 2, src += 4, out += 4) {
+		vst1q_f32(out, vmulq_f32(vld1q_f32(src), gains));
+	}
+	scale_stereo_frames_scalar(src, num_frames, gain_left, gain_right, out);
+}
+
+// The interleaving store writes the left and right samples in turn
+static void scale_mono_frames_to_stereo_neon(const float* src, size_t num_frames,
+                                             const float gain_left,
+                                             const float gain_right, float* out)
+{
+	const auto gains_left  = vdupq_n_f32(gain_left);
+	const auto gains_right = vdupq_n_f32(gain_right);
+
+	for (; num_frames >= 4; num_frames -= 4, src += 4, out += 8) {
+		const auto samples = vld1q_f32(src);
+
+		const float32x4x2_t frames = {
+		        {vmulq_f32(samples, gains_left), vmulq_f32(samples, gains_right)}};
+		vst2q_f32(out, frames);
+	}
+	scale_mono_frames_to_stereo_scalar(src, num_frames, gain_left, gain_right, out);
+}
+
+// The de-interleaving loads and interleaving stores split and join the frames
+static void deinterleave_frames_neon(const float* src, size_t num_frames,
+                                     float* left, float* right)
+{
+	for (; num_frames >= 4; num_frames -= 4, src += 8, left += 4, right += 4) {
+		const auto frames = vld2q_f32(src);
+		vst1q_f32(left, frames.val[0]);
+		vst1q_f32(right, frames.val[1]);
+	}
+	deinterleave_frames_scalar(src, num_frames, left, right);
+}
+
+static void accumulate_deinterleaved_frames_neon(float* dest, const float* left,
+                                                 const float* right,
+                                                 size_t num_frames)
+{
+	for (; num_frames >= 4; num_frames -= 4, dest += 8, left += 4, right += 4) {
+		auto frames   = vld2q_f32(dest);
+		frames.val[0] = vaddq_f32(frames.val[0], vld1q_f32(left));
+		frames.val[1] = vaddq_f32(frames.val[1], vld1q_f32(right));
+		vst2q_f32(dest, frames);
+	}
+	accumulate_deinterleaved_frames_scalar(dest, left, right, num_frames);
+}
+
+static float get_peak_amplitude_neon(const float* src, size_t num_samples)
+{
+	auto peaks = vdupq_n_f32(0.0f);
+	for (; num_samples >= 4; num_samples -= 4, src += 4) {
+		peaks = vmaxq_f32(peaks, vabsq_f32(vld1q_f32(src)));
+	}
+	return get_peak_amplitude_scalar(src, num_samples, vmaxvq_f32(peaks));
+}
+
+// The left and right samples of a frame are filtered in the two lanes of a
+// vector, with the states and coefficients kept in registers for the block
+static void filter_stereo_frames_neon(float* frames, size_t num_frames,
+                                      const MixerBiquad* sections,
+                                      MixerBiquadState* states,
+                                      const size_t num_sections)
+{
+	float64x2_t b0[MixerMaxBiquads];
+	float64x2_t b1[MixerMaxBiquads];
+	float64x2_t b2[MixerMaxBiquads];
+	float64x2_t a1[MixerMaxBiquads];
+	float64x2_t a2[MixerMaxBiquads];
+	float64x2_t v1[MixerMaxBiquads];
+	float64x2_t v2[MixerMaxBiquads];
+
+	for (size_t i = 0; i < num_sections; ++i) {
+		b0[i] = vdupq_n_f64(sections[i].b0);
+		b1[i] = vdupq_n_f64(sections[i].b1);
+		b2[i] = vdupq_n_f64(sections[i].b2);
+		a1[i] = vdupq_n_f64(sections[i].a1);
+		a2[i] = vdupq_n_f64(sections[i].a2);
+		v1[i] = vld1q_f64(states[i].v1.data());
+		v2[i] = vld1q_f64(states[i].v2.data());
+	}
+
+	for (; num_frames > 0; --num_frames, frames += 2) {
+		auto sample = vcvt_f64_f32(vld1_f32(frames));
+
+		for (size_t i = 0; i < num_sections; ++i) {
+			const auto w = vsubq_f64(vsubq_f64(sample, vmulq_f64(a1[i], v1[i])),
+			                         vmulq_f64(a2[i], v2[i]));
+			sample = vaddq_f64(vaddq_f64(vmulq_f64(b0[i], w),
+			                             vmulq_f64(b1[i], v1[i])),
+			                   vmulq_f64(b2[i], v2[i]));
+			v2[i] = v1[i];
+			v1[i] = w;
+		}
+		vst1_f32(frames, vcvt_f32_f64(sample));
+	}
+
+	for (size_t i = 0; i < num_sections; ++i) {
+		vst1q_f64(states[i].v1.data(), v1[i]);
+		vst1q_f64(states[i].v2.data(), v2[i]);
+	}
+}
+#endif
+
+#if MIXER_KERNELS_SSE2
+static void accumulate_sse2(float* dest, const float* src, size_t num_samples)
+{
+	for (; num_samples >= 8; num_samples -= 8, src += 8, dest += 8) {
+		_mm_storeu_ps(dest, _mm_add_ps(_mm_loadu_ps(dest), _mm_loadu_ps(src)));
+		_mm_storeu_ps(dest + 4,
+		              _mm_add_ps(_mm_loadu_ps(dest + 4), _mm_loadu_ps(src + 4)));
+	}
+	accumulate_scalar(dest, src, num_samples);
+}
+
+static void accumulate_scaled_sse2(float* dest, const float* src,
+                                   const float gain, size_t num_samples)
+{
+	const auto gains = _mm_set1_ps(gain);
+
+	for (; num_samples >= 4; num_samples -= 4, src += 4, dest += 4) {
+		const auto scaled = _mm_mul_ps(_mm_loadu_ps(src), gains);
+		_mm_storeu_ps(dest, _mm_add_ps(_mm_loadu_ps(dest), scaled));
+	}
+	accumulate_scaled_scalar(dest, src, gain, num_samples);
+}
+
+static void convert_to_int16_sse2(const float* src, size_t num_samples,
+                                  int16_t* out)
+{
+	const auto min = _mm_set1_ps(Int16Min);
+	const auto max = _mm_set1_ps(Int16Max);
+
+	for (; num_samples >= 8; num_samples -= 8, src += 8, out += 8) {
+		// CVTTPS2DQ truncates like the scalar casts, and the clamped
+		// values pass through the saturating pack unchanged
+		const auto low = _mm_cvttps_epi32(
+		        _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src), min), max));
+		const auto high = _mm_cvttps_epi32(
+		        _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + 4), min), max));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+		                 _mm_packs_epi32(low, high));
+	}
+	convert_to_int16_scalar(src, num_samples, out);
+}
+
+// Sign-extends the 16-bit samples by unpacking them into the top halves of
+// 32-bit lanes and shifting them back down arithmetically
+static void store_s16_as_float_sse2(const __m128i samples, float* out)
+{
+	const auto low  = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+	const auto high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+
+	_mm_storeu_ps(out, _mm_cvtepi32_ps(low));
+	_mm_storeu_ps(out + 4, _mm_cvtepi32_ps(high));
+}
+
+static void convert_s16_to_float_sse2(const int16_t* src, size_t num_samples,
+                                      float* out)
+{
+	for (; num_samples >= 8; num_samples -= 8, src += 8, out += 8) {
+		store_s16_as_float_sse2(
+		        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), out);
+	}
+	convert_s16_to_float_scalar(src, num_samples, out);
+}
+
+// Flipping the top bit turns the unsigned samples into signed ones offset
+// by 32768
+static void convert_u16_to_float_sse2(const uint16_t* src, size_t num_samples,
+                                      float* out)
+{
+	const auto sign_bit = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+
+	for (; num_samples >= 8; num_samples -= 8, src += 8, out += 8) {
+		const auto samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		store_s16_as_float_sse2(_mm_xor_si128(samples, sign_bit), out);
+	}
+	convert_u16_to_float_scalar(src, num_samples, out);
+}
+
+static void scale_stereo_frames_sse2(const float* src, size_t num_frames,
+                                     const float gain_left,
+                                     const float gain_right, float* out)
+{
+	const auto gains = _mm_setr_ps(gain_left, gain_right, gain_left, gain_right);
+
+	for (; num_frames >= 2; num_frames -= 2, src += 4, out += 4) {
+		_mm_storeu_ps(out, _mm_mul_ps(_mm_loadu_ps(src), gains));
+	}
+	scale_stereo_frames_scalar(src, num_frames, gain_left, gain_right, out);
+}
+
+// Unpacking the mono samples with themselves doubles them into frames
+static void scale_mono_frames_to_stereo_sse2(const float* src, size_t num_frames,
+                                             const float gain_left,
+                                             const float gain_right, float* out)
+{
+	const auto gains = _mm_setr_ps(gain_left, gain_right, gain_left, gain_right);
+
+	for (; num_frames >= 4; num_frames -= 4, src += 4, out += 8) {
+		const auto samples = _mm_loadu_ps(src);
+
+		_mm_storeu_ps(out, _mm_mul_ps(_mm_unpacklo_ps(samples, samples), gains));
+		_mm_storeu_ps(out + 4,
+		              _mm_mul_ps(_mm_unpackhi_ps(samples, samples), gains));
+	}
+	scale_mono_frames_to_stereo_scalar(src, num_frames, gain_left, gain_right, out);
+}
+
+// Shuffling the even and odd samples of two vectors of frames apart splits
+// them, and unpacking them joins them again
+static void deinterleave_frames_sse2(const float* src, size_t num_frames,
+                                     float* left, float* right)
+{
+	for (; num_frames >= 4; num_frames -= 4, src += 8, left += 4, right += 4) {
+		const auto frames_lo = _mm_loadu_ps(src);
+		const auto frames_hi = _mm_loadu_ps(src + 4);
+
+		_mm_storeu_ps(left,
+		              _mm_shuffle_ps(frames_lo, frames_hi, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(right,
+		              _mm_shuffle_ps(frames_lo, frames_hi, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+	deinterleave_frames_scalar(src, num_frames, left, right);
+}
+
+static void accumulate_deinterleaved_frames_sse2(float* dest, const float* left,
+                                                 const float* right,
+                                                 size_t num_frames)
+{
+	for (; num_frames >= 4; num_frames -= 4, dest += 8, left += 4, right += 4) {
+		const auto lefts  = _mm_loadu_ps(left);
+		const auto rights = _mm_loadu_ps(right);
+
+		_mm_storeu_ps(dest,
+		              _mm_add_ps(_mm_loadu_ps(dest),
+		                         _mm_unpacklo_ps(lefts, rights)));
+		_mm_storeu_ps(dest + 4,
+		              _mm_add_ps(_mm_loadu_ps(dest + 4),
+		                         _mm_unpackhi_ps(lefts, rights)));
+	}
+	accumulate_deinterleaved_frames_scalar(dest, left, right, num_frames);
+}
+
+// Clearing the sign bits gives the absolute values
+static float get_peak_amplitude_sse2(const float* src, size_t num_samples)
+{
+	const auto abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	auto peaks = _mm_setzero_ps();
+	for (; num_samples >= 4; num_samples -= 4, src += 4) {
+		peaks = _mm_max_ps(peaks, _mm_and_ps(_mm_loadu_ps(src), abs_mask));
+	}
+	peaks = _mm_max_ps(peaks, _mm_movehl_ps(peaks, peaks));
+	peaks = _mm_max_ss(peaks, _mm_shuffle_ps(peaks, peaks, 1));
+
+	return get_peak_amplitude_scalar(src, num_samples, _mm_cvtss_f32(peaks));
+}
+
+// The left and right samples of a frame are filtered in the two lanes of a
+// vector, with the states and coefficients kept in registers for the block.
+// The conversions between the float and double lanes round like the scalar
+// casts.
+static void filter_stereo_frames_sse2(float* frames, size_t num_frames,
+                                      const MixerBiquad* sections,
+                                      MixerBiquadState* states,
+                                      const size_t num_sections)
+{
+	__m128d b0[MixerMaxBiquads];
+	__m128d b1[MixerMaxBiquads];
+	__m128d b2[MixerMaxBiquads];
+	__m128d a1[MixerMaxBiquads];
+	__m128d a2[MixerMaxBiquads];
+	__m128d v1[MixerMaxBiquads];
+	__m128d v2[MixerMaxBiquads];
+
+	for (size_t i = 0; i < num_sections; ++i) {
+		b0[i] = _mm_set1_pd(sections[i].b0);
+		b1[i] = _mm_set1_pd(sections[i].b1);
+		b2[i] = _mm_set1_pd(sections[i].b2);
+		a1[i] = _mm_set1_pd(sections[i].a1);
+		a2[i] = _mm_set1_pd(sections[i].a2);
+		v1[i] = _mm_loadu_pd(states[i].v1.data());
+		v2[i] = _mm_loadu_pd(states[i].v2.data());
+	}
+
+	for (; num_frames > 0; --num_frames, frames += 2) {
+		const auto frame = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(frames));
+		auto sample = _mm_cvtps_pd(_mm_castsi128_ps(frame));
+
+		for (size_t i = 0; i < num_sections; ++i) {
+			const auto w = _mm_sub_pd(_mm_sub_pd(sample, _mm_mul_pd(a1[i], v1[i])),
+			                          _mm_mul_pd(a2[i], v2[i]));
+			sample = _mm_add_pd(_mm_add_pd(_mm_mul_pd(b0[i], w),
+			                               _mm_mul_pd(b1[i], v1[i])),
+			                    _mm_mul_pd(b2[i], v2[i]));
+			v2[i] = v1[i];
+			v1[i] = w;
+		}
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(frames),
+		                 _mm_castps_si128(_mm_cvtpd_ps(sample)));
+	}
+
+	for (size_t i = 0; i < num_sections; ++i) {
+		_mm_storeu_pd(states[i].v1.data(), v1[i]);
+		_mm_storeu_pd(states[i].v2.data(), v2[i]);
+	}
+}
+#endif
+
+void MIXER_AccumulateSamples(float* dest, const float* src, const size_t num_samples)
+{
+#if MIXER_KERNELS_NEON
+	accumulate_neon(dest, src, num_samples);
+#elif MIXER_KERNELS_SSE2
+	accumulate_sse2(dest, src, num_samples);
+#else
+	accumulate_scalar(dest, src, num_samples);
+#endif
+}
+
+void MIXER_AccumulateScaledSamples(float* dest, const float* src,
+                                   const float gain, const size_t num_samples)
+{
+#if MIXER_KERNELS_NEON
+	accumulate_scaled_neon(dest, src, gain, num_samples);
+#elif MIXER_KERNELS_SSE2
+	accumulate_scaled_sse2(dest, src, gain, num_samples);
+#else
+	accumulate_scaled_scalar(dest, src, gain, num_samples);
+#endif
+}
+
+void MIXER_ConvertToInt16(const float* src, const size_t num_samples, int16_t* out)
+{
+#if MIXER_KERNELS_NEON
+	convert_to_int16_neon(src, num_samples, out);
+#elif MIXER_KERNELS_SSE2
+	convert_to_int16_sse2(src, num_samples, out);
+#else
+	convert_to_int16_scalar(src, num_samples, out);
+#endif
+}
+
+void MIXER_ConvertS16ToFloat(const int16_t* src, const size_t num_samples, float* out)
+{
+#if MIXER_KERNELS_NEON
+	convert_s16_to_float_neon(src, num_samples, out);
+#elif MIXER_KERNELS_SSE2
+	convert_s16_to_float_sse2(src, num_samples, out);
+#else
+	convert_s16_to_float_scalar(src, num_samples, out);
+#endif
+}
+
+void MIXER_ConvertU16ToFloat(const uint16_t* src, const size_t num_samples, float* out)
+{
+#if MIXER_KERNELS_NEON
+	convert_u16_to_float_neon(src, num_samples, out);
+#elif MIXER_KERNELS_SSE2
+	convert_u16_to_float_sse2(src, num_samples, out);
+#else
+	convert_u16_to_float_scalar(src, num_samples, out);
+#endif
+}
+
+void MIXER_ScaleStereoFrames(const float* src, const size_t num_frames,
+                             const float gain_left, const float gain_right,
+                             float* out)
+{
+#if MIXER_KERNELS_NEON
+	scale_stereo_frames_neon(src, num_frames, gain_left, gain_right, out);
+#elif MIXER_KERNELS_SSE2
+	scale_stereo_frames_sse2(src, num_frames, gain_left, gain_right, out);
+#else
+	scale_stereo_frames_scalar(src, num_frames, gain_left, gain_right, out);
+#endif
+}
+
+void MIXER_ScaleMonoFramesToStereo(const float* src, const size_t num_frames,
+                                   const float gain_left, const float gain_right,
+                                   float* out)
+{
+#if MIXER_KERNELS_NEON
+	scale_mono_frames_to_stereo_neon(src, num_frames, gain_left, gain_right, out);
+#elif MIXER_KERNELS_SSE2
+	scale_mono_frames_to_stereo_sse2(src, num_frames, gain_left, gain_right, out);
+#else
+	scale_mono_frames_to_stereo_scalar(src, num_frames, gain_left, gain_right, out);
+#endif
+}
+
+void MIXER_DeinterleaveFrames(const float* src, const size_t num_frames,
+                              float* left, float* right)
+{
+#if MIXER_KERNELS_NEON
+	deinterleave_frames_neon(src, num_frames, left, right);
+#elif MIXER_KERNELS_SSE2
+	deinterleave_frames_sse2(src, num_frames, left, right);
+#else
+	deinterleave_frames_scalar(src, num_frames, left, right);
+#endif
+}
+
+void MIXER_AccumulateDeinterleavedFrames(float* dest, const float* left,
+                                         const float* right,
+                                         const size_t num_frames)
+{
+#if MIXER_KERNELS_NEON
+	accumulate_deinterleaved_frames_neon(dest, left, right, num_frames);
+#elif MIXER_KERNELS_SSE2
+	accumulate_deinterleaved_frames_sse2(dest, left, right, num_frames);
+#else
+	accumulate_deinterleaved_frames_scalar(dest, left, right, num_frames);
+#endif
+}
+
+float MIXER_GetPeakAmplitude(const float* src, const size_t num_samples)
+{
+#if MIXER_KERNELS_NEON
+	return get_peak_amplitude_neon(src, num_samples);
+#elif MIXER_KERNELS_SSE2
+	return get_peak_amplitude_sse2(src, num_samples);
+#else
+	return get_peak_amplitude_scalar(src, num_samples);
+#endif
+}
+
+void MIXER_FilterStereoFrames(float* frames, const size_t num_frames,
+                              const MixerBiquad* sections,
+                              MixerBiquadState* states, const size_t num_sections)
+{
+	assert(num_sections <= MixerMaxBiquads);
+
+#if MIXER_KERNELS_NEON
+	filter_stereo_frames_neon(frames, num_frames, sections, states, num_sections);
+#elif MIXER_KERNELS_SSE2
+	filter_stereo_frames_sse2(frames, num_frames, sections, states, num_sections);
+#else
+	filter_stereo_frames_scalar(frames, num_frames, sections, states, num_sections);
+#endif
+}
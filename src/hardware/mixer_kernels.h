@@ -0,0 +1,102 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef DOSBOX_MIXER_KERNELS_H
+#define DOSBOX_MIXER_KERNELS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Sample kernels of the mixer
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Convert the channels' blocks of samples, and mix them into the master
+// output. Stereo frames are interleaved, and processed as flat runs of
+// samples wherever the left and right samples are treated alike. The
+// kernels are vectorised with NEON on 64-bit Arm hosts, and with SSE2 on x86
+// hosts. The scalar fallbacks produce bit-identical output.
+
+// Adds 'num_samples' samples of 'src' to 'dest'
+void MIXER_AccumulateSamples(float* dest, const float* src, size_t num_samples);
+
+// Adds 'num_samples' samples of 'src' scaled by 'gain' to 'dest'
+void MIXER_AccumulateScaledSamples(float* dest, const float* src,
+                                   float gain, size_t num_samples);
+
+// Converts 'num_samples' samples to 16-bit, clamping and truncating them the
+// same way as 'clamp_to_int16'
+void MIXER_ConvertToInt16(const float* src, size_t num_samples, int16_t* out);
+
+// Converts 'num_samples' signed 16-bit samples to floats
+void MIXER_ConvertS16ToFloat(const int16_t* src, size_t num_samples, float* out);
+
+// Converts 'num_samples' unsigned 16-bit samples to floats, centred on zero
+void MIXER_ConvertU16ToFloat(const uint16_t* src, size_t num_samples, float* out);
+
+// Scales the left and right samples of 'num_frames' stereo frames by their
+// gains, writing stereo frames to 'out'
+void MIXER_ScaleStereoFrames(const float* src, size_t num_frames,
+                             float gain_left, float gain_right, float* out);
+
+// Scales 'num_frames' mono samples by the left and right gains, writing
+// stereo frames to 'out'
+void MIXER_ScaleMonoFramesToStereo(const float* src, size_t num_frames,
+                                   float gain_left, float gain_right, float* out);
+
+// Splits 'num_frames' stereo frames into separate runs of left and right
+// samples
+void MIXER_DeinterleaveFrames(const float* src, size_t num_frames, float* left,
+                              float* right);
+
+// Adds separate runs of 'num_frames' left and right samples to the stereo
+// frames of 'dest'
+void MIXER_AccumulateDeinterleavedFrames(float* dest, const float* left,
+                                         const float* right, size_t num_frames);
+
+// Returns the largest absolute value of 'num_samples' samples
+float MIXER_GetPeakAmplitude(const float* src, size_t num_samples);
+
+// A second-order section of an IIR filter, with its coefficients divided by
+// a0. Sections run in direct form II, like the Iir library's filters.
+struct MixerBiquad {
+	double b0 = 1.0;
+	double b1 = 0.0;
+	double b2 = 0.0;
+	double a1 = 0.0;
+	double a2 = 0.0;
+};
+
+// The delayed values of a section for the left and right channels
+struct MixerBiquadState {
+	std::array<double, 2> v1 = {};
+	std::array<double, 2> v2 = {};
+};
+
+constexpr size_t MixerMaxBiquads = 8;
+
+// Runs 'num_frames' stereo frames in place through a cascade of up to
+// 'MixerMaxBiquads' sections, filtering the left and right samples together.
+// The samples pass through the cascade in double precision.
+void MIXER_FilterStereoFrames(float* frames, size_t num_frames,
+                              const MixerBiquad* sections,
+                              MixerBiquadState* states, size_t num_sections);
+
+#endif
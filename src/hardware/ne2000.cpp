@@ -26,6 +26,7 @@
 
 #if C_NE2000
 
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
@@ -44,6 +45,7 @@
 
 EthernetConnection* ethernet = nullptr;
 static void NE2000_TX_Event(uint32_t val);
+static void NE2000_RX_IRQ_Event(uint32_t val);
 
 //Never completely fill the ne2k ring so that we never
 // hit the unclear completely full buffer condition.
@@ -149,6 +151,8 @@ bx_ne2k_c::reset(unsigned type)
   BX_NE2K_THIS s.CR.rdma_cmd = 4;
   BX_NE2K_THIS s.ISR.reset    = 1;
   BX_NE2K_THIS s.DCR.longaddr = 1;
+  PIC_RemoveEvents(NE2000_RX_IRQ_Event);
+  BX_NE2K_THIS s.rx_irq_scheduled = false;
   PIC_DeActivateIRQ(s.base_irq);
   //DEV_pic_lower_irq(BX_NE2K_THIS s.base_irq);
 }
@@ -1230,7 +1234,6 @@ int bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
   uint8_t nextpage;
   uint8_t pkthdr[4];
   const auto *pktbuf = (const uint8_t *) buf;
-  uint8_t *startptr;
   static uint8_t bcast_addr[6] = {0xff,0xff,0xff,0xff,0xff,0xff};
 
   if(io_len != 60) {
@@ -1276,6 +1279,7 @@ int bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
     return -1;
   }
   // some computers don't care...
+  const auto received_len = io_len;
   if (io_len < 60) io_len=60;
 
   // Do address filtering if not in promiscuous mode
@@ -1321,25 +1325,47 @@ int bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
   pkthdr[3] = check_cast<uint8_t>((io_len + 4) >> 8);	// length-hi
 
   // copy into buffer, update curpage, and signal interrupt if config'd
-  startptr = & BX_NE2K_THIS s.mem[BX_NE2K_THIS s.curr_page * 256 -
-			       BX_NE2K_MEMSTART];
-  if ((nextpage > BX_NE2K_THIS s.curr_page) ||
-      ((BX_NE2K_THIS s.curr_page + pages) == BX_NE2K_THIS s.page_stop)) {
-    memcpy(startptr, pkthdr, 4);
-    memcpy(startptr + 4, buf, io_len);
-    BX_NE2K_THIS s.curr_page = nextpage;
-  } else {
-    unsigned int endbytes = (unsigned int)(BX_NE2K_THIS s.page_stop - BX_NE2K_THIS s.curr_page)
-      * 256u;
-    memcpy(startptr, pkthdr, 4);
-    memcpy(startptr + 4, buf, (size_t)(endbytes - 4u));
-    startptr = & BX_NE2K_THIS s.mem[BX_NE2K_THIS s.page_start * 256u -
-				 BX_NE2K_MEMSTART];
-    memcpy(startptr, (const void *)(pktbuf + endbytes - 4u),
-	   io_len - endbytes + 8u);
-    BX_NE2K_THIS s.curr_page = nextpage;
+  //
+  // The ring wraps at most once per frame, so every part of the frame goes
+  // in with at most two copies. Runts are padded with zeros instead of
+  // reading past the end of the received data.
+  const size_t ring_start = BX_NE2K_THIS s.page_start * 256u - BX_NE2K_MEMSTART;
+  const size_t ring_end = BX_NE2K_THIS s.page_stop * 256u - BX_NE2K_MEMSTART;
+  size_t ring_pos = BX_NE2K_THIS s.curr_page * 256u - BX_NE2K_MEMSTART;
+
+  if (ring_end > sizeof(BX_NE2K_THIS s.mem) || ring_pos < ring_start ||
+      ring_pos >= ring_end) {
+    BX_DEBUG("receive ring outside of the packet memory");
+    return -1;
   }
 
+  auto copy_to_ring = [&](const uint8_t *data, size_t num_bytes) {
+    const auto num_before_wrap = std::min(num_bytes, ring_end - ring_pos);
+    if (data) {
+      memcpy(&BX_NE2K_THIS s.mem[ring_pos], data, num_before_wrap);
+    } else {
+      memset(&BX_NE2K_THIS s.mem[ring_pos], 0, num_before_wrap);
+    }
+    ring_pos += num_before_wrap;
+    num_bytes -= num_before_wrap;
+    if (ring_pos == ring_end) {
+      ring_pos = ring_start;
+    }
+    if (num_bytes) {
+      if (data) {
+        memcpy(&BX_NE2K_THIS s.mem[ring_pos], data + num_before_wrap, num_bytes);
+      } else {
+        memset(&BX_NE2K_THIS s.mem[ring_pos], 0, num_bytes);
+      }
+      ring_pos += num_bytes;
+    }
+  };
+
+  copy_to_ring(pkthdr, sizeof(pkthdr));
+  copy_to_ring(pktbuf, received_len);
+  copy_to_ring(nullptr, io_len - received_len);
+  BX_NE2K_THIS s.curr_page = nextpage;
+
   BX_NE2K_THIS s.RSR.rx_ok = 1;
   if (pktbuf[0] & 0x80) {
     BX_NE2K_THIS s.RSR.rx_mbit = 1;
@@ -1349,7 +1375,13 @@ int bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
 
   if (BX_NE2K_THIS s.IMR.rx_inte) {
 	//LOG_MSG("packet rx interrupt");
+	if (BX_NE2K_THIS s.rx_irq_window_ms <= 0.0) {
 	  PIC_ActivateIRQ(s.base_irq);
+	} else if (!BX_NE2K_THIS s.rx_irq_scheduled) {
+	  // The frames arriving until the event fires share its interrupt
+	  BX_NE2K_THIS s.rx_irq_scheduled = true;
+	  PIC_AddEvent(NE2000_RX_IRQ_Event, BX_NE2K_THIS s.rx_irq_window_ms, 0);
+	}
     //DEV_pic_raise_irq(BX_NE2K_THIS s.base_irq);
   } //else LOG_MSG("no packet rx interrupt");
   return static_cast<int>(io_len);
@@ -1429,6 +1461,23 @@ static void NE2000_TX_Event([[maybe_unused]] uint32_t val)
 	theNE2kDevice->tx_timer();
 }
 
+void bx_ne2k_c::rx_irq_timer()
+{
+	s.rx_irq_scheduled = false;
+
+	// The driver might have already serviced the frames by polling the ISR
+	if (s.ISR.pkt_rx && s.IMR.rx_inte) {
+		PIC_ActivateIRQ(s.base_irq);
+	}
+}
+
+static void NE2000_RX_IRQ_Event([[maybe_unused]] uint32_t val)
+{
+	theNE2kDevice->rx_irq_timer();
+}
+
+// Delivers the frames the backend has queued since the last tick; the
+// backend services the host network on its own thread
 static void NE2000_Poller(void) {
 	ethernet->GetPackets([](const uint8_t *packet, int len) {
 		//LOG_MSG("NE2000: Received %d bytes", header->len);
@@ -1460,10 +1509,12 @@ public:
 			return;
 		}
 
-		ethernet = ETHERNET_OpenConnection("slirp");
+		const std::string backend = section->Get_string("nic_backend");
+
+		ethernet = ETHERNET_OpenConnection(backend);
 		if(!ethernet)
 		{
-			LOG_MSG("NE2000: Failed to open Ethernet slirp backend");
+			LOG_MSG("NE2000: Failed to open Ethernet %s backend", backend.c_str());
 			load_success = false;
 			return;
 		}
@@ -1505,6 +1556,10 @@ public:
 		theNE2kDevice->s.base_address = base;
 		theNE2kDevice->s.base_irq = irq;
 
+		constexpr auto MicrosPerMilli = 1000.0;
+		theNE2kDevice->s.rx_irq_window_ms = section->Get_int("nic_rx_coalescing") /
+		                                    MicrosPerMilli;
+
 		theNE2kDevice->init();
 
 		// install I/O-handlers and timer
@@ -1523,6 +1578,7 @@ public:
 		theNE2kDevice = nullptr;
 		TIMER_DelTickHandler(NE2000_Poller);
 		PIC_RemoveEvents(NE2000_TX_Event);
+		PIC_RemoveEvents(NE2000_RX_IRQ_Event);
 	}
 };
 
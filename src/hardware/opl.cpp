@@ -29,7 +29,9 @@
 #include "checks.h"
 #include "control.h"
 #include "cpu.h"
+#include "host_threads.h"
 #include "mapper.h"
+#include "math_utils.h"
 #include "mem.h"
 #include "opl_capture.h"
 #include "setup.h"
@@ -310,15 +312,23 @@ void Opl::Init()
 
 void Opl::WriteReg(const io_port_t selected_reg, const uint8_t val)
 {
-	if (opl.mode == OplMode::Esfm) {
-		ESFM_write_reg_buffered_fast(&esfm.chip, selected_reg, val);
+	if (opl.mode != OplMode::Esfm && selected_reg == 0x105) {
+		opl.newm = selected_reg & 0x01;
+	}
 
+	if (renderer.enabled) {
+		QueueWork(WorkType::WriteReg, selected_reg, val);
+	} else {
+		WriteChipReg(selected_reg, val);
+	}
+}
 
+void Opl::WriteChipReg(const io_port_t selected_reg, const uint8_t val)
+{
+	if (opl.mode == OplMode::Esfm) {
+		ESFM_write_reg_buffered_fast(&esfm.chip, selected_reg, val);
 	} else { // OPL
 		OPL3_WriteRegBuffered(&opl.chip, selected_reg, val);
-		if (selected_reg == 0x105) {
-			opl.newm = selected_reg & 0x01;
-		}
 	}
 }
 
@@ -390,37 +400,42 @@ int16_t remove_dc_bias(const int16_t back_sample)
 	return static_cast<int16_t>(front_sample - average);
 }
 
-AudioFrame Opl::RenderFrame()
+// Appends 'num_frames' frames to 'frames'. Both OPL2s of the dual OPL2 mode are
+// halves of the one OPL3 chip, so each block is generated in a single call.
+void Opl::RenderFrames(const int num_frames, std::vector<AudioFrame>& frames)
 {
-	static int16_t buf[2] = {};
-
-	if (opl.mode == OplMode::Esfm) {
-		ESFM_generate_stream(&esfm.chip, buf, 1);
+	constexpr auto BlockFrames = 256;
 
-		if (ctrl.wants_dc_bias_removed) {
-			buf[0] = remove_dc_bias<Left>(buf[0]);
-			buf[1] = remove_dc_bias<Right>(buf[1]);
-		}
+	int16_t buf[BlockFrames * 2];
 
-		AudioFrame frame = {buf[0], buf[1]};
-		return frame;
+	auto frames_remaining = num_frames;
+	while (frames_remaining > 0) {
+		const auto n = std::min(frames_remaining, BlockFrames);
 
-	} else { // OPL
-		OPL3_GenerateStream(&opl.chip, buf, 1);
+		if (opl.mode == OplMode::Esfm) {
+			ESFM_generate_stream(&esfm.chip, buf, static_cast<uint32_t>(n));
+		} else { // OPL
+			OPL3_GenerateStream(&opl.chip, buf, static_cast<uint32_t>(n));
+		}
 
 		if (ctrl.wants_dc_bias_removed) {
-			buf[0] = remove_dc_bias<Left>(buf[0]);
-			buf[1] = remove_dc_bias<Right>(buf[1]);
+			for (auto i = 0; i < n * 2; i += 2) {
+				buf[i]     = remove_dc_bias<Left>(buf[i]);
+				buf[i + 1] = remove_dc_bias<Right>(buf[i + 1]);
+			}
 		}
 
-		AudioFrame frame = {};
+		const auto start = frames.size();
+		frames.resize(start + check_cast<size_t>(n));
+
 		if (adlib_gold) {
-			adlib_gold->Process(buf, 1, &frame[0]);
+			adlib_gold->Process(buf, n, &frames[start][0]);
 		} else {
-			frame.left  = buf[0];
-			frame.right = buf[1];
+			for (auto i = 0; i < n; ++i) {
+				frames[start + i] = {buf[i * 2], buf[i * 2 + 1]};
+			}
 		}
-		return frame;
+		frames_remaining -= n;
 	}
 }
 
@@ -434,16 +449,54 @@ void Opl::RenderUpToNow()
 		last_rendered_ms = now;
 		return;
 	}
-	// Keep rendering until we're current
+	// Keep rendering until we're current; the renderer thread renders the
+	// frames before it applies the next queued write
+	auto num_frames = 0;
 	while (last_rendered_ms < now) {
 		last_rendered_ms += ms_per_frame;
-		fifo.emplace(RenderFrame());
+		++num_frames;
+	}
+	if (renderer.enabled) {
+		renderer.num_unsent_frames += num_frames;
+		renderer.num_queued_frames += num_frames;
+	} else if (num_frames > 0) {
+		RenderFrames(num_frames, fifo);
 	}
 }
 
 void Opl::AudioCallback(const int requested_frames)
 {
 	assert(channel);
+
+	if (renderer.enabled) {
+		// Order the same frames the synchronous path below renders:
+		// those timestamped since the last callback first, then the
+		// remainder of the requested frames. The renderer thread is
+		// ahead of us by the frames it rendered at startup, so the
+		// requested frames are usually waiting in the FIFO already.
+		const auto num_remaining = std::max(requested_frames -
+		                                            renderer.num_queued_frames,
+		                                    0);
+		renderer.num_queued_frames = std::max(renderer.num_queued_frames -
+		                                              requested_frames,
+		                                      0);
+
+		renderer.num_unsent_frames += num_remaining;
+		if (renderer.num_unsent_frames > 0) {
+			QueueWork(WorkType::Render, 0, 0);
+		}
+
+		auto& audio_frames = renderer.audio_frames;
+		if (renderer.audio_frame_fifo.BulkDequeue(audio_frames,
+		                                          requested_frames)) {
+			channel->AddSamples_sfloat(requested_frames,
+			                           &audio_frames[0][0]);
+		} else {
+			channel->AddSilence();
+		}
+		last_rendered_ms = PIC_FullIndex();
+		return;
+	}
 #if 0
 	if (fifo.size()) {
 		LOG_MSG("%s: Queued %2lu cycle-accurate frames",
@@ -451,23 +504,121 @@ void Opl::AudioCallback(const int requested_frames)
 		        fifo.size());
 	}
 #endif
-	auto frames_remaining = requested_frames;
+	const auto num_requested = check_cast<size_t>(requested_frames);
 
-	// First, send any frames we've queued since the last callback
-	while (frames_remaining && fifo.size()) {
-		channel->AddSamples_sfloat(1, &fifo.front()[0]);
-		fifo.pop();
-		--frames_remaining;
+	// First, send any frames we've queued since the last callback. If the
+	// queue's run dry, render the remainder after them and sync-up our
+	// time datum.
+	if (fifo.size() < num_requested) {
+		RenderFrames(check_cast<int>(num_requested - fifo.size()), fifo);
 	}
-	// If the queue's run dry, render the remainder and sync-up our time datum
-	while (frames_remaining) {
-		const auto frame = RenderFrame();
-		channel->AddSamples_sfloat(1, &frame[0]);
-		--frames_remaining;
+	if (num_requested > 0) {
+		channel->AddSamples_sfloat(requested_frames, &fifo[0][0]);
+		fifo.erase(fifo.begin(),
+		           fifo.begin() + static_cast<std::ptrdiff_t>(num_requested));
 	}
 	last_rendered_ms = PIC_FullIndex();
 }
 
+void Opl::QueueWork(const WorkType type, const uint16_t reg, const uint8_t val)
+{
+	assert(renderer.enabled);
+
+	renderer.work_fifo.Enqueue(Work{renderer.num_unsent_frames, type, reg, val});
+	renderer.num_unsent_frames = 0;
+}
+
+void Opl::RenderFramesToFifo(std::vector<AudioFrame>& audio_frames,
+                             const int num_frames)
+{
+	audio_frames.clear();
+	RenderFrames(num_frames, audio_frames);
+
+	renderer.audio_frame_fifo.BulkEnqueue(audio_frames,
+	                                      check_cast<size_t>(num_frames));
+}
+
+// Renders the frames of the queued work, and then applies its write to the
+// synth, until the renderer is stopped
+void Opl::RenderThread()
+{
+	std::vector<AudioFrame> audio_frames = {};
+
+	while (const auto work = renderer.work_fifo.Dequeue()) {
+		if (work->num_frames > 0) {
+			RenderFramesToFifo(audio_frames, work->num_frames);
+		}
+
+		switch (work->type) {
+		case WorkType::Render: break;
+
+		case WorkType::WriteReg: WriteChipReg(work->reg, work->val); break;
+
+		case WorkType::StereoControl:
+			adlib_gold->StereoControlWrite(
+			        static_cast<StereoProcessorControlReg>(work->reg),
+			        work->val);
+			break;
+
+		case WorkType::SurroundControl:
+			adlib_gold->SurroundControlWrite(work->val);
+			break;
+		}
+	}
+}
+
+void Opl::StartRenderer()
+{
+	// The synth's state is read back in ESFM native mode, so it has to stay
+	// current on the emulation thread
+	if (opl.mode == OplMode::Esfm) {
+		LOG_WARNING("%s: Threaded rendering isn't supported in ESFM mode",
+		            channel->GetName().c_str());
+		return;
+	}
+
+	// Render ahead of the mixer by its prebuffer, and allow for four times
+	// that to accumulate before the renderer thread has to wait
+	const auto frames_per_ms = iround(OplSampleRateHz / MillisInSecond);
+	const auto render_ahead_frames = MIXER_GetPreBufferMs() * frames_per_ms;
+
+	renderer.audio_frame_fifo.Resize(check_cast<size_t>(render_ahead_frames * 4));
+
+	// Games write hundreds of registers within a few milliseconds when
+	// setting up instruments, so allow for generous bursts
+	constexpr size_t MaxQueuedWrites = 16384;
+	renderer.work_fifo.Resize(MaxQueuedWrites);
+
+	renderer.enabled = true;
+
+	const auto render = std::bind(&Opl::RenderThread, this);
+	renderer.thread   = std::thread(render);
+	set_thread_name(renderer.thread, "dosbox:opl");
+	HOST_THREADS_Apply(renderer.thread, HostThreadGroup::Audio);
+
+	renderer.num_unsent_frames = render_ahead_frames;
+	QueueWork(WorkType::Render, 0, 0);
+
+	LOG_MSG("%s: Rendering on a worker thread %d ms ahead of the mixer",
+	        channel->GetName().c_str(),
+	        MIXER_GetPreBufferMs());
+}
+
+void Opl::StopRenderer()
+{
+	if (!renderer.enabled) {
+		return;
+	}
+
+	renderer.work_fifo.Stop();
+	renderer.audio_frame_fifo.Stop();
+
+	if (renderer.thread.joinable()) {
+		renderer.thread.join();
+	}
+	renderer.enabled = false;
+}
+
 void Opl::CacheWrite(const io_port_t port, const uint8_t val)
 {
 	// capturing?
@@ -512,24 +663,22 @@ void Opl::AdlibGoldControlWrite(const uint8_t val)
 {
 	switch (ctrl.index) {
 	case 0x04:
-		adlib_gold->StereoControlWrite(StereoProcessorControlReg::VolumeLeft,
-		                               val);
+		AdlibGoldStereoControlWrite(StereoProcessorControlReg::VolumeLeft, val);
 		break;
 	case 0x05:
-		adlib_gold->StereoControlWrite(StereoProcessorControlReg::VolumeRight,
-		                               val);
+		AdlibGoldStereoControlWrite(StereoProcessorControlReg::VolumeRight, val);
 		break;
 	case 0x06:
-		adlib_gold->StereoControlWrite(StereoProcessorControlReg::Bass, val);
+		AdlibGoldStereoControlWrite(StereoProcessorControlReg::Bass, val);
 		break;
 
 	case 0x07:
-		adlib_gold->StereoControlWrite(StereoProcessorControlReg::Treble, val);
+		AdlibGoldStereoControlWrite(StereoProcessorControlReg::Treble, val);
 		break;
 
 	case 0x08:
-		adlib_gold->StereoControlWrite(StereoProcessorControlReg::SwitchFunctions,
-		                               val);
+		AdlibGoldStereoControlWrite(StereoProcessorControlReg::SwitchFunctions,
+		                            val);
 		break;
 
 	case 0x09: // Left FM Volume
@@ -550,6 +699,25 @@ void Opl::AdlibGoldControlWrite(const uint8_t val)
 		break;
 
 	case 0x18: // Surround
+		AdlibGoldSurroundControlWrite(val);
+	}
+}
+
+void Opl::AdlibGoldStereoControlWrite(const StereoProcessorControlReg reg,
+                                      const uint8_t val)
+{
+	if (renderer.enabled) {
+		QueueWork(WorkType::StereoControl, static_cast<uint16_t>(reg), val);
+	} else {
+		adlib_gold->StereoControlWrite(reg, val);
+	}
+}
+
+void Opl::AdlibGoldSurroundControlWrite(const uint8_t val)
+{
+	if (renderer.enabled) {
+		QueueWork(WorkType::SurroundControl, 0, val);
+	} else {
 		adlib_gold->SurroundControlWrite(val);
 	}
 }
@@ -831,7 +999,8 @@ Opl::Opl(Section* configuration, const OplMode _opl_mode)
 	                             ChannelFeature::FadeOut,
 	                             ChannelFeature::ReverbSend,
 	                             ChannelFeature::ChorusSend,
-	                             ChannelFeature::Synthesizer};
+	                             ChannelFeature::Synthesizer,
+	                             ChannelFeature::ParallelRendering};
 
 	const auto dual_opl = opl.mode != OplMode::Opl2;
 
@@ -874,6 +1043,10 @@ Opl::Opl(Section* configuration, const OplMode _opl_mode)
 
 	Init();
 
+	if (section->Get_bool("opl_threaded")) {
+		StartRenderer();
+	}
+
 	using namespace std::placeholders;
 
 	const auto read_from = std::bind(&Opl::PortRead, this, _1, _2);
@@ -920,6 +1093,8 @@ Opl::~Opl()
 		wh.Uninstall();
 	}
 
+	StopRenderer();
+
 	// Deregister the mixer channel, after which it's cleaned up
 	assert(channel);
 	MIXER_DeregisterChannel(channel);
@@ -974,6 +1149,14 @@ static void init_opl_dosbox_settings(Section_prop& secprop)
 	        "(1990), and Wizardry 7 (1992). Please open an issue ticket if you find other\n"
 	        "affected games.");
 
+	pbool = secprop.Add_bool("opl_threaded", when_idle, false);
+	pbool->Set_help(
+	        "Render the OPL synth on a separate thread, ahead of the mixer by the\n"
+	        "'prebuffer' duration (disabled by default). The register writes keep their\n"
+	        "exact timing, but the OPL output is delayed by the prebuffer. This reduces\n"
+	        "the load on the emulation thread on slower multi-core hosts. Not supported\n"
+	        "with 'oplmode = esfm'.");
+
 	pstring = secprop.Add_string("oplemu", deprecated, "");
 	pstring->Set_help("Only 'nuked' OPL emulation is supported now.");
 
@@ -24,12 +24,15 @@
 #include <cmath>
 #include <memory>
 #include <queue>
+#include <thread>
+#include <vector>
 
 #include "adlib_gold.h"
 #include "hardware.h"
 #include "inout.h"
 #include "mixer.h"
 #include "pic.h"
+#include "rwqueue.h"
 #include "setup.h"
 
 #include "ESFMu/esfm.h"
@@ -118,7 +121,8 @@ private:
 	IO_ReadHandleObject ReadHandler[3];
 	IO_WriteHandleObject WriteHandler[3];
 
-	std::queue<AudioFrame> fifo = {};
+	// Frames rendered at the writes since the last callback
+	std::vector<AudioFrame> fifo = {};
 
 	OplChip chip[2]  = {};
 
@@ -157,10 +161,44 @@ private:
 		bool wants_dc_bias_removed = false;
 	} ctrl = {};
 
+	// Threaded rendering: the writes to the synth's state are queued with
+	// the number of frames to render before them, and a worker thread
+	// renders the frames ahead of the mixer
+	enum class WorkType { Render, WriteReg, StereoControl, SurroundControl };
+
+	struct Work {
+		int num_frames = 0;
+		WorkType type  = WorkType::Render;
+		uint16_t reg   = 0;
+		uint8_t val    = 0;
+	};
+
+	struct {
+		bool enabled       = false;
+		std::thread thread = {};
+
+		RWQueue<Work> work_fifo{1, RWQueueMode::LockFree};
+		RWQueue<AudioFrame> audio_frame_fifo{1, RWQueueMode::LockFree};
+
+		std::vector<AudioFrame> audio_frames = {};
+
+		// Frames timestamped since the last queued work, and those
+		// timestamped since the last callback
+		int num_unsent_frames = 0;
+		int num_queued_frames = 0;
+	} renderer = {};
+
 	void Init();
 
+	void StartRenderer();
+	void StopRenderer();
+	void RenderThread();
+	void QueueWork(const WorkType type, const uint16_t reg, const uint8_t val);
+	void RenderFramesToFifo(std::vector<AudioFrame>& audio_frames,
+	                        const int num_frames);
+
 	void AudioCallback(const int frames);
-	AudioFrame RenderFrame();
+	void RenderFrames(const int num_frames, std::vector<AudioFrame>& frames);
 	void RenderUpToNow();
 
 	void PortWrite(const io_port_t port, const io_val_t value,
@@ -170,11 +208,15 @@ private:
 
 	io_port_t WriteAddr(const io_port_t port, const uint8_t val);
 	void WriteReg(const io_port_t selected_reg, const uint8_t val);
+	void WriteChipReg(const io_port_t selected_reg, const uint8_t val);
 	void CacheWrite(const io_port_t port, const uint8_t val);
 	void DualWrite(const uint8_t index, const uint8_t reg, const uint8_t value);
 
 	void AdlibGoldControlWrite(const uint8_t val);
 	uint8_t AdlibGoldControlRead(void);
+	void AdlibGoldStereoControlWrite(const StereoProcessorControlReg reg,
+	                                 const uint8_t val);
+	void AdlibGoldSurroundControlWrite(const uint8_t val);
 
 	void EsfmSetLegacyMode();
 };
@@ -109,12 +109,13 @@ skipWrite:
 	}
 
 	InitHeader();
+	bufsWritten = 0;
 
 	// Prepare space at start of the file for the header
-	fwrite(&header, 1, sizeof(header), handle);
+	CAPTURE_AppendToFile(handle, GetHeaderData());
 
 	// Write the Raw To Reg table
-	fwrite(&to_reg, 1, raw_used, handle);
+	CAPTURE_AppendToFile(handle, std::vector<uint8_t>(to_reg, to_reg + raw_used));
 
 	// Write the cache of last commands
 	WriteCache();
@@ -203,9 +204,14 @@ void OplCapture::MakeTables()
 
 void OplCapture::ClearBuf()
 {
-	fwrite(buf, 1, bufUsed, handle);
+	CAPTURE_AppendToFile(handle, std::vector<uint8_t>(buf, buf + bufUsed));
 	header.commands += bufUsed / 2;
 	bufUsed = 0;
+
+	// Keeps the file playable up to here if it never gets closed
+	if (++bufsWritten % 16 == 0) {
+		CAPTURE_WriteToFileAt(handle, 0, GetHeaderData());
+	}
 }
 
 void OplCapture::AddBuf(const uint8_t raw, const uint8_t val)
@@ -289,21 +295,27 @@ void OplCapture::InitHeader()
 	header.conv_table_size = raw_used;
 }
 
+// Returns the endianised header
+std::vector<uint8_t> OplCapture::GetHeaderData() const
+{
+	auto le_header         = header;
+	le_header.version_high = host_to_le(header.version_high);
+	le_header.version_low  = host_to_le(header.version_low);
+	le_header.commands     = host_to_le(header.commands);
+	le_header.milliseconds = host_to_le(header.milliseconds);
+
+	const auto data = reinterpret_cast<const uint8_t*>(&le_header);
+	return std::vector<uint8_t>(data, data + sizeof(le_header));
+}
+
 void OplCapture::CloseFile()
 {
 	if (handle) {
 		ClearBuf();
 
-		// Endianise the header and write it to beginning of the
-		// file
-		header.version_high = host_to_le(header.version_high);
-		header.version_low  = host_to_le(header.version_low);
-		header.commands     = host_to_le(header.commands);
-		header.milliseconds = host_to_le(header.milliseconds);
-
-		fseek(handle, 0, SEEK_SET);
-		fwrite(&header, 1, sizeof(header), handle);
-		fclose(handle);
+		// Write the header to beginning of the file
+		CAPTURE_WriteToFileAt(handle, 0, GetHeaderData());
+		CAPTURE_CloseFile(handle);
 
 		handle = nullptr;
 	}
@@ -21,6 +21,8 @@
 
 #include "dosbox.h"
 
+#include <vector>
+
 #include "inout.h"
 #include "opl.h"
 
@@ -113,6 +115,9 @@ private:
 
 	uint32_t bufUsed = 0;
 
+	// The header is updated with every 16th buffer written
+	uint32_t bufsWritten = 0;
+
 	OplRegisterCache* cache;
 
 	void MakeEntry(uint8_t reg, uint8_t& raw);
@@ -125,6 +130,7 @@ private:
 	void WriteCache();
 
 	void InitHeader();
+	std::vector<uint8_t> GetHeaderData() const;
 
 	void CloseFile();
 };
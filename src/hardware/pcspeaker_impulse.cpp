@@ -25,8 +25,11 @@
 
 #include "pcspeaker_impulse.h"
 
+#include <algorithm>
+
 #include "checks.h"
 #include "math_utils.h"
+#include "mixer_kernels.h"
 
 CHECK_NARROWING();
 
@@ -415,22 +418,25 @@ void PcSpeakerImpulse::AddImpulse(float index, const int16_t amplitude)
 		phase = sinc_oversampling_factor - phase;
 	}
 
-	for (auto i = 0; i < sinc_filter_quality; ++i) {
-		const auto wave_i    = check_cast<uint16_t>(offset + i);
-		const auto impulse_i = check_cast<uint16_t>(
-		        phase + i * sinc_oversampling_factor);
-		waveform_deque.at(wave_i) += amplitude * impulse_lut.at(impulse_i);
-	}
+	const auto wave_i    = check_cast<size_t>(offset);
+	const auto impulse_i = check_cast<size_t>(phase * sinc_filter_quality);
+	assert(wave_i + sinc_filter_quality <= waveform.size());
+	assert(impulse_i + sinc_filter_quality <= impulse_lut.size());
+
+	MIXER_AccumulateScaledSamples(&waveform[wave_i],
+	                              &impulse_lut[impulse_i],
+	                              amplitude,
+	                              sinc_filter_quality);
 }
 
 #else
 	// Mathematically intensive reference implementation
 	const auto portion_of_ms = static_cast <double>(index) / MillisInSecond;
-	for (size_t i = 0; i < waveform_deque.size(); ++i) {
+	for (size_t i = 0; i < waveform.size(); ++i) {
 		const auto impulse_time = static_cast<double>(i) / sample_rate_hz -
 		                          portion_of_ms;
 
-		waveform_deque[i] += amplitude * CalcImpulse(impulse_time);
+		waveform[i] += amplitude * CalcImpulse(impulse_time);
 	}
 }
 #endif
@@ -440,16 +446,18 @@ void PcSpeakerImpulse::ChannelCallback(int requested_frames)
 	ForwardPIT(1.0f);
 	pit.last_index = 0;
 
-	static float accumulator = 0;
-	while (requested_frames > 0 && waveform_deque.size()) {
-		// Pop the first sample off the waveform
-		accumulator += waveform_deque.front();
-		waveform_deque.pop_front();
-		waveform_deque.push_back(0.0f);
+	if (requested_frames <= 0) {
+		return;
+	}
+	const auto num_frames = static_cast<size_t>(requested_frames);
+	output_frames.resize(num_frames);
 
-		// Pass the sample to the mixer and decrement the requested frames
-		channel->AddSamples_mfloat(1, &accumulator);
-		--requested_frames;
+	static float accumulator = 0;
+	for (size_t i = 0; i < num_frames; ++i) {
+		// Take the next sample off the waveform, which is silent past
+		// its end
+		accumulator += i < waveform.size() ? waveform[i] : 0.0f;
+		output_frames[i] = accumulator;
 
 		// Keep a tally of sequential silence so we can sleep the channel
 		tally_of_silence = fabsf(accumulator) > 1.0f
@@ -460,25 +468,31 @@ void PcSpeakerImpulse::ChannelCallback(int requested_frames)
 		// hit 0 if no other waveforms are generated.
 		accumulator *= sinc_amplitude_fade;
 	}
-
-	// Write silence if the waveform deque ran out
-	if (requested_frames)
-		pit.prev_amplitude = neutral_amplitude;
-
-	while (requested_frames) {
-		channel->AddSamples_m16(1, &neutral_amplitude);
-		++tally_of_silence;
-		--requested_frames;
-	}
+	channel->AddSamples_mfloat(requested_frames, output_frames.data());
+
+	// Move the remaining waveform to the front and follow it with silence
+	const auto num_consumed = std::min(num_frames, waveform.size());
+	std::copy(waveform.begin() + static_cast<std::ptrdiff_t>(num_consumed),
+	          waveform.end(),
+	          waveform.begin());
+	std::fill(waveform.end() - static_cast<std::ptrdiff_t>(num_consumed),
+	          waveform.end(),
+	          0.0f);
 }
 
 void PcSpeakerImpulse::InitializeImpulseLUT()
 {
 	assert(impulse_lut.size() == sinc_filter_width);
 
-	for (auto i = 0u; i < sinc_filter_width; ++i) {
-		impulse_lut[i] = CalcImpulse(i / (static_cast<double>(sample_rate_hz) *
-		                                  sinc_oversampling_factor));
+	// Tap 'i' of 'phase' is the impulse at oversampled position
+	// 'phase + i * sinc_oversampling_factor'
+	for (auto phase = 0; phase < sinc_oversampling_factor; ++phase) {
+		for (auto i = 0; i < sinc_filter_quality; ++i) {
+			const auto pos = phase + i * sinc_oversampling_factor;
+			impulse_lut[static_cast<size_t>(phase * sinc_filter_quality + i)] =
+			        CalcImpulse(pos / (static_cast<double>(sample_rate_hz) *
+			                           sinc_oversampling_factor));
+		}
 	}
 }
 
@@ -527,7 +541,7 @@ PcSpeakerImpulse::PcSpeakerImpulse()
 
 	// Size the waveform queue
 	constexpr auto waveform_size = sinc_filter_quality + sample_rate_per_ms;
-	waveform_deque.resize(waveform_size, 0.0f);
+	waveform.resize(waveform_size, 0.0f);
 
 	// Register the sound channel
 	const auto callback = std::bind(&PcSpeakerImpulse::ChannelCallback,
@@ -21,8 +21,8 @@
 #include "pcspeaker.h"
 
 #include <array>
-#include <deque>
 #include <string>
+#include <vector>
 
 #include "channel_names.h"
 #include "inout.h"
@@ -110,8 +110,14 @@ private:
 		int16_t prev_amplitude = negative_amplitude;
 	} pit = {};
 
-	std::deque<float> waveform_deque = {};
+	// The upcoming samples, starting at the current millisecond
+	std::vector<float> waveform = {};
 
+	// The frames passed to the mixer channel by the callback
+	std::vector<float> output_frames = {};
+
+	// The impulse's taps grouped by their oversampling phase, so the taps
+	// added to the waveform at each phase are contiguous
 	std::array<float, sinc_filter_width> impulse_lut = {};
 
 	MixerChannelPtr channel = nullptr;
@@ -17,11 +17,17 @@
  */
 
 #include "dosbox.h"
+
+#include <unordered_map>
+#include <vector>
+
 #include "inout.h"
 #include "cpu.h"
 #include "callback.h"
+#include "guest_stats.h"
 #include "pic.h"
 #include "timer.h"
+#include "tracy.h"
 #include "setup.h"
 
 // PIC Controllers
@@ -38,8 +44,6 @@
 // "master-slave" relationship, which is misleading given that fact that the
 // primary has no control over the secondary.
 
-#define PIC_QUEUESIZE 512
-
 struct PIC_Controller {
 	Bitu icw_words;
 	Bitu icw_index;
@@ -190,18 +194,223 @@ void PIC_Controller::start_irq(uint8_t val) {
 }
 
 
-struct PICEntry {
-	double index;
-	Bitu value;
-	PIC_EventHandler pic_event;
-	PICEntry * next;
+// PIC event queue
+// ~~~~~~~~~~~~~~~
+// Scheduled events are kept in a binary min-heap ordered by their due index
+// (and their insertion order for equal indexes, so events due at the same
+// time still fire first-in first-out). Entries live in a growable pool and
+// are also indexed by handler, so removing the events of a handler only
+// visits that handler's entries instead of the whole queue.
+
+class PicEventQueue {
+public:
+	struct Entry {
+		double index = 0.0;
+		uint32_t value = 0;
+		PIC_EventHandler pic_event = nullptr;
+
+		uint64_t sequence = 0;
+
+		// position in the heap and in the handler's entry list
+		size_t heap_pos = 0;
+		size_t handler_pos = 0;
+	};
+
+	using EntryId = uint32_t;
+
+	bool IsEmpty() const
+	{
+		return heap.empty();
+	}
+
+	const Entry& Top() const
+	{
+		assert(!heap.empty());
+		return pool[heap.front()];
+	}
+
+	void Add(const PIC_EventHandler handler, const double index,
+	         const uint32_t value)
+	{
+		const auto id = AllocEntry();
+		auto& entry   = pool[id];
+
+		entry.index     = index;
+		entry.value     = value;
+		entry.pic_event = handler;
+		entry.sequence  = next_sequence++;
+
+		auto& handler_entries = by_handler[handler];
+		entry.handler_pos     = handler_entries.size();
+		handler_entries.push_back(id);
+
+		entry.heap_pos = heap.size();
+		heap.push_back(id);
+		SiftUp(entry.heap_pos);
+	}
+
+	// Removes the earliest entry and returns a copy of it
+	Entry Pop()
+	{
+		assert(!heap.empty());
+		const auto id    = heap.front();
+		const auto entry = pool[id];
+		Remove(id);
+		return entry;
+	}
+
+	void RemoveEvents(const PIC_EventHandler handler)
+	{
+		const auto it = by_handler.find(handler);
+		if (it == by_handler.end()) {
+			return;
+		}
+		auto& handler_entries = it->second;
+		while (!handler_entries.empty()) {
+			Remove(handler_entries.back());
+		}
+	}
+
+	void RemoveSpecificEvents(const PIC_EventHandler handler, const uint32_t value)
+	{
+		const auto it = by_handler.find(handler);
+		if (it == by_handler.end()) {
+			return;
+		}
+		auto& handler_entries = it->second;
+		for (size_t i = handler_entries.size(); i-- > 0;) {
+			const auto id = handler_entries[i];
+			// Removal swaps the last entry into slot i, which has
+			// already been checked
+			if (pool[id].value == value) {
+				Remove(id);
+			}
+		}
+	}
+
+	// Moves all scheduled events one millisecond closer. Rounding can
+	// turn two nearly equal indexes into equal ones, which changes their
+	// tie-break order, so the heap is rebuilt afterwards (still linear).
+	void AdvanceOneTick()
+	{
+		for (const auto id : heap) {
+			pool[id].index -= 1.0;
+		}
+		for (size_t pos = heap.size() / 2; pos-- > 0;) {
+			SiftDown(pos);
+		}
+	}
+
+	void Clear()
+	{
+		pool.clear();
+		free_ids.clear();
+		heap.clear();
+		by_handler.clear();
+		next_sequence = 0;
+	}
+
+private:
+	EntryId AllocEntry()
+	{
+		if (!free_ids.empty()) {
+			const auto id = free_ids.back();
+			free_ids.pop_back();
+			return id;
+		}
+		pool.emplace_back();
+		return check_cast<EntryId>(pool.size() - 1);
+	}
+
+	bool IsEarlier(const EntryId a, const EntryId b) const
+	{
+		const auto& ea = pool[a];
+		const auto& eb = pool[b];
+		if (ea.index != eb.index) {
+			return ea.index < eb.index;
+		}
+		return ea.sequence < eb.sequence;
+	}
+
+	void Place(const size_t pos, const EntryId id)
+	{
+		heap[pos]         = id;
+		pool[id].heap_pos = pos;
+	}
+
+	void SiftUp(size_t pos)
+	{
+		const auto id = heap[pos];
+		while (pos > 0) {
+			const auto parent = (pos - 1) / 2;
+			if (!IsEarlier(id, heap[parent])) {
+				break;
+			}
+			Place(pos, heap[parent]);
+			pos = parent;
+		}
+		Place(pos, id);
+	}
+
+	void SiftDown(size_t pos)
+	{
+		const auto id   = heap[pos];
+		const auto size = heap.size();
+		for (;;) {
+			auto child = 2 * pos + 1;
+			if (child >= size) {
+				break;
+			}
+			if (child + 1 < size && IsEarlier(heap[child + 1], heap[child])) {
+				++child;
+			}
+			if (!IsEarlier(heap[child], id)) {
+				break;
+			}
+			Place(pos, heap[child]);
+			pos = child;
+		}
+		Place(pos, id);
+	}
+
+	void Remove(const EntryId id)
+	{
+		auto& entry = pool[id];
+
+		// Unlink from the handler's entry list by swapping in the last
+		auto& handler_entries = by_handler[entry.pic_event];
+		const auto last_id    = handler_entries.back();
+		handler_entries[entry.handler_pos] = last_id;
+		pool[last_id].handler_pos          = entry.handler_pos;
+		handler_entries.pop_back();
+
+		// Unlink from the heap by moving the last element into the hole
+		const auto pos     = entry.heap_pos;
+		const auto last_pos = heap.size() - 1;
+		if (pos != last_pos) {
+			Place(pos, heap[last_pos]);
+			heap.pop_back();
+			if (pos > 0 && IsEarlier(heap[pos], heap[(pos - 1) / 2])) {
+				SiftUp(pos);
+			} else {
+				SiftDown(pos);
+			}
+		} else {
+			heap.pop_back();
+		}
+
+		free_ids.push_back(id);
+	}
+
+	std::vector<Entry> pool        = {};
+	std::vector<EntryId> free_ids  = {};
+	std::vector<EntryId> heap      = {};
+	std::unordered_map<PIC_EventHandler, std::vector<EntryId>> by_handler = {};
+
+	uint64_t next_sequence = 0;
 };
 
-static struct {
-	PICEntry entries[PIC_QUEUESIZE];
-	PICEntry * free_entry;
-	PICEntry * next_entry;
-} pic_queue;
+static PicEventQueue pic_queue = {};
 
 static void write_command(io_port_t port, io_val_t value, io_width_t)
 {
@@ -422,34 +631,9 @@ void PIC_SetIRQMask(uint32_t irq, bool masked)
 	pic->set_imr(newmask);
 }
 
-static void AddEntry(PICEntry * entry) {
-	PICEntry * find_entry=pic_queue.next_entry;
-	if (find_entry == nullptr) {
-		entry->next=nullptr;
-		pic_queue.next_entry=entry;
-	} else if (find_entry->index > entry->index) {
-		pic_queue.next_entry=entry;
-		entry->next=find_entry;
-	} else {
-		while (find_entry) {
-			if (find_entry->next) {
-				/* See if the next index comes later than this
-				 * one */
-				if (find_entry->next->index > entry->index) {
-					entry->next      = find_entry->next;
-					find_entry->next = entry;
-					break;
-				} else {
-					find_entry = find_entry->next;
-				}
-			} else {
-				entry->next      = find_entry->next;
-				find_entry->next = entry;
-				break;
-			}
-		}
-	}
-	Bits cycles=PIC_MakeCycles(pic_queue.next_entry->index-PIC_TickIndex());
+static void check_next_event()
+{
+	Bits cycles = PIC_MakeCycles(pic_queue.Top().index - PIC_TickIndex());
 	if (cycles<CPU_Cycles) {
 		CPU_CycleLeft+=CPU_Cycles;
 		CPU_Cycles=0;
@@ -460,69 +644,20 @@ static double srv_lag = 0.0;
 
 void PIC_AddEvent(PIC_EventHandler handler, double delay, uint32_t val)
 {
-	if (!pic_queue.free_entry) {
-		LOG(LOG_PIC,LOG_ERROR)("Event queue full");
-		return;
-	}
-	PICEntry * entry=pic_queue.free_entry;
-	if(InEventService) entry->index = delay + srv_lag;
-	else entry->index = delay + PIC_TickIndex();
-
-	entry->pic_event=handler;
-	entry->value=val;
-	pic_queue.free_entry=pic_queue.free_entry->next;
-	AddEntry(entry);
+	const auto index = InEventService ? delay + srv_lag
+	                                  : delay + PIC_TickIndex();
+	pic_queue.Add(handler, index, val);
+	check_next_event();
 }
 
 void PIC_RemoveSpecificEvents(PIC_EventHandler handler, uint32_t val)
 {
-	PICEntry *entry = pic_queue.next_entry;
-	PICEntry *prev_entry;
-	prev_entry = nullptr;
-	while (entry) {
-		if ((entry->pic_event == handler) && (entry->value == val)) {
-			if (prev_entry) {
-				prev_entry->next=entry->next;
-				entry->next=pic_queue.free_entry;
-				pic_queue.free_entry=entry;
-				entry=prev_entry->next;
-				continue;
-			} else {
-				pic_queue.next_entry=entry->next;
-				entry->next=pic_queue.free_entry;
-				pic_queue.free_entry=entry;
-				entry=pic_queue.next_entry;
-				continue;
-			}
-		}
-		prev_entry=entry;
-		entry=entry->next;
-	}
+	pic_queue.RemoveSpecificEvents(handler, val);
 }
 
-void PIC_RemoveEvents(PIC_EventHandler handler) {
-	PICEntry * entry=pic_queue.next_entry;
-	PICEntry * prev_entry;
-	prev_entry=nullptr;
-	while (entry) {
-		if (entry->pic_event == handler) {
-			if (prev_entry) {
-				prev_entry->next=entry->next;
-				entry->next=pic_queue.free_entry;
-				pic_queue.free_entry=entry;
-				entry=prev_entry->next;
-				continue;
-			} else {
-				pic_queue.next_entry=entry->next;
-				entry->next=pic_queue.free_entry;
-				pic_queue.free_entry=entry;
-				entry=pic_queue.next_entry;
-				continue;
-			}
-		}
-		prev_entry=entry;
-		entry=entry->next;
-	}
+void PIC_RemoveEvents(PIC_EventHandler handler)
+{
+	pic_queue.RemoveEvents(handler);
 }
 
 
@@ -533,29 +668,26 @@ bool PIC_RunQueue(void) {
 	if (CPU_CycleLeft<=0) {
 		return false;
 	}
+	ZoneScoped;
 
 	const auto index_nd_f = static_cast<double>(PIC_TickIndexND());
 
 	/* Check the queue for an entry */
 	InEventService = true;
-	while (pic_queue.next_entry &&
-	       (pic_queue.next_entry->index * static_cast<double>(CPU_CycleMax) <= index_nd_f)) {
-		PICEntry *entry = pic_queue.next_entry;
-		pic_queue.next_entry = entry->next;
-
-		srv_lag = entry->index;
-		(entry->pic_event)(entry->value); // call the event handler
+	while (!pic_queue.IsEmpty() &&
+	       (pic_queue.Top().index * static_cast<double>(CPU_CycleMax) <= index_nd_f)) {
+		const auto entry = pic_queue.Pop();
 
-		/* Put the entry in the free list */
-		entry->next=pic_queue.free_entry;
-		pic_queue.free_entry=entry;
+		srv_lag = entry.index;
+		(entry.pic_event)(entry.value); // call the event handler
+		++guest_stats.pic_events;
 	}
 	InEventService = false;
 
 	/* Check when to set the new cycle end */
-	if (pic_queue.next_entry) {
+	if (!pic_queue.IsEmpty()) {
 		auto cycles = static_cast<int32_t>(
-		        pic_queue.next_entry->index * static_cast<double>(CPU_CycleMax) -
+		        pic_queue.Top().index * static_cast<double>(CPU_CycleMax) -
 		        index_nd_f);
 		if (!cycles) {
 			cycles = 1;
@@ -607,11 +739,7 @@ void TIMER_AddTick(void) {
 	CPU_Cycles=0;
 	PIC_Ticks++;
 	/* Go through the list of scheduled events and lower their index with 1000 */
-	PICEntry * entry=pic_queue.next_entry;
-	while (entry) {
-		entry->index -= 1.0f;
-		entry=entry->next;
-	}
+	pic_queue.AdvanceOneTick();
 	/* Call our list of ticker handlers */
 	TickerBlock * ticker=firstticker;
 	while (ticker) {
@@ -674,12 +802,7 @@ public:
 		WriteHandler[2].Install(0xa0, write_command, io_width_t::byte);
 		WriteHandler[3].Install(0xa1, write_data, io_width_t::byte);
 		/* Initialize the pic queue */
-		for (i=0;i<PIC_QUEUESIZE-1;i++) {
-			pic_queue.entries[i].next=&pic_queue.entries[i+1];
-		}
-		pic_queue.entries[PIC_QUEUESIZE-1].next=nullptr;
-		pic_queue.free_entry=&pic_queue.entries[0];
-		pic_queue.next_entry=nullptr;
+		pic_queue.Clear();
 	}
 
 	~PIC_8259A(){
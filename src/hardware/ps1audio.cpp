@@ -26,6 +26,7 @@
 #include <cstring>
 #include <memory>
 #include <queue>
+#include <vector>
 
 #include "channel_names.h"
 #include "checks.h"
@@ -455,6 +456,7 @@ private:
 
 	void AudioCallback(uint16_t requested_frames);
 	float RenderSample();
+	void RenderSamples(float* out, const size_t num_samples);
 	void RenderUpToNow();
 
 	void WriteSoundGeneratorPort205(io_port_t port, io_val_t, io_width_t);
@@ -465,6 +467,10 @@ private:
 	std::queue<float> fifo             = {};
 	sn76496_device device;
 
+	// Scratch buffers of the audio callback's blocks
+	std::vector<int16_t> device_buffer = {};
+	std::vector<float> render_buffer   = {};
+
 	// Static rate-related configuration
 	static constexpr auto Ps1PsgClockHz = 4'000'000;
 	static constexpr auto RenderDivisor = 16;
@@ -490,7 +496,8 @@ Ps1Synth::Ps1Synth(const std::string& filter_choice)
 	                           {ChannelFeature::Sleep,
 	                            ChannelFeature::ReverbSend,
 	                            ChannelFeature::ChorusSend,
-	                            ChannelFeature::Synthesizer});
+	                            ChannelFeature::Synthesizer,
+	                            ChannelFeature::ParallelRendering});
 
 	// Setup PSG filters
 	if (const auto maybe_bool = parse_bool_setting(filter_choice)) {
@@ -534,6 +541,21 @@ float Ps1Synth::RenderSample()
 	return static_cast<float>(sample);
 }
 
+void Ps1Synth::RenderSamples(float* out, const size_t num_samples)
+{
+	assert(dsi);
+
+	static device_sound_interface::sound_stream ss;
+
+	// Request the whole block of mono samples from the audio device
+	device_buffer.resize(num_samples);
+	int16_t* buf[] = {device_buffer.data(), nullptr};
+
+	dsi->sound_stream_update(ss, nullptr, buf, check_cast<int>(num_samples));
+
+	std::copy(device_buffer.begin(), device_buffer.end(), out);
+}
+
 void Ps1Synth::RenderUpToNow()
 {
 	const auto now = PIC_FullIndex();
@@ -565,20 +587,23 @@ void Ps1Synth::AudioCallback(const uint16_t requested_frames)
 	// if (fifo.size())
 	//	LOG_MSG("PS1: Queued %2lu cycle-accurate frames", fifo.size());
 
-	auto frames_remaining = requested_frames;
+	const auto num_requested = static_cast<size_t>(requested_frames);
+	render_buffer.clear();
 
-	// First, send any frames we've queued since the last callback
-	while (frames_remaining && fifo.size()) {
-		channel->AddSamples_mfloat(1, &fifo.front());
+	// First, take any frames we've queued since the last callback
+	while (render_buffer.size() < num_requested && fifo.size()) {
+		render_buffer.push_back(fifo.front());
 		fifo.pop();
-		--frames_remaining;
 	}
-	// If the queue's run dry, render the remainder and sync-up our time datum
-	while (frames_remaining) {
-		float sample = RenderSample();
-		channel->AddSamples_mfloat(1, &sample);
-		--frames_remaining;
+	// If the queue's run dry, render the remainder in one go and sync-up
+	// our time datum
+	if (const auto num_queued = render_buffer.size(); num_queued < num_requested) {
+		render_buffer.resize(num_requested);
+		RenderSamples(render_buffer.data() + num_queued,
+		              num_requested - num_queued);
 	}
+	channel->AddSamples_mfloat(requested_frames, render_buffer.data());
+
 	last_rendered_ms = PIC_FullIndex();
 }
 
@@ -0,0 +1,397 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "picture_kernels.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define PICTURE_KERNELS_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PICTURE_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// The colour bytes of a BGRX8888 byte array pixel read as a 32-bit value
+constexpr uint32_t RgbMask = std::endian::native == std::endian::little
+                                   ? 0x00ffffff
+                                   : 0xffffff00;
+
+// The BT.601 conversion of pl_mpeg. The chroma terms are shared by the four
+// pixels of a 2x2 block.
+struct ChromaTerms {
+	int r = 0;
+	int g = 0;
+	int b = 0;
+};
+
+static ChromaTerms get_chroma_terms(const uint8_t cb_value, const uint8_t cr_value)
+{
+	const int cb = cb_value - 128;
+	const int cr = cr_value - 128;
+	return {(cr * 104597) >> 16, (cb * 25674 + cr * 53278) >> 16, (cb * 132201) >> 16};
+}
+
+static uint8_t clamp_to_byte(const int value)
+{
+	return static_cast<uint8_t>(std::clamp(value, 0, 255));
+}
+
+static void put_pixel(const ChromaTerms& terms, const uint8_t luma, uint8_t* out)
+{
+	const int y = ((luma - 16) * 76309) >> 16;
+	out[0]      = clamp_to_byte(y + terms.b);
+	out[1]      = clamp_to_byte(y - terms.g);
+	out[2]      = clamp_to_byte(y + terms.r);
+	out[3]      = 0;
+}
+
+// Kernels converting a run of 2x2 blocks of a pair of lines
+using convert_kernel_f = void (*)(const uint8_t* y0, const uint8_t* y1,
+                                  const uint8_t* cb, const uint8_t* cr,
+                                  size_t num_blocks, uint8_t* out0, uint8_t* out1);
+
+static void convert_scalar(const uint8_t* y0, const uint8_t* y1, const uint8_t* cb,
+                           const uint8_t* cr, size_t num_blocks, uint8_t* out0,
+                           uint8_t* out1)
+{
+	while (num_blocks--) {
+		const auto terms = get_chroma_terms(*cb++, *cr++);
+		put_pixel(terms, y0[0], out0);
+		put_pixel(terms, y0[1], out0 + 4);
+		put_pixel(terms, y1[0], out1);
+		put_pixel(terms, y1[1], out1 + 4);
+		y0 += 2;
+		y1 += 2;
+		out0 += 8;
+		out1 += 8;
+	}
+}
+
+// The vector kernels work on 16-bit lanes. The conversion's constants don't
+// fit those, so each multiplication is split into a shift and a 16-bit
+// multiplication keeping the high half of the products: for an integer 'a',
+// floor(a * (n * 65536 + k) / 65536) equals a * n + floor(a * k / 65536), so
+// the results stay identical to the scalar version's.
+//
+//   (y - 16) * 76309 >> 16 = v + hi(v * 10773), where v = y - 16
+//   cr * 104597 >> 16      = 2 * cr + hi(cr * -26475)
+//   cb * 132201 >> 16      = 2 * cb + hi(cb * 1129)
+//   (cb * 25674 + cr * 53278) >> 16 = cr + ((cb * 25674 + cr * -12258) >> 16)
+
+#if PICTURE_KERNELS_SSE2
+static __m128i get_luma_sse2(const __m128i luma)
+{
+	const auto v = _mm_sub_epi16(luma, _mm_set1_epi16(16));
+	return _mm_add_epi16(v, _mm_mulhi_epi16(v, _mm_set1_epi16(10773)));
+}
+
+// Converts 16 pixels of a line with the chroma terms of their 8 blocks
+static void put_pixels_sse2(const uint8_t* luma, const __m128i r,
+                            const __m128i g, const __m128i b, uint8_t* out)
+{
+	const auto zero  = _mm_setzero_si128();
+	const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(luma));
+	const auto y_lo  = get_luma_sse2(_mm_unpacklo_epi8(bytes, zero));
+	const auto y_hi  = get_luma_sse2(_mm_unpackhi_epi8(bytes, zero));
+
+	// Each block's terms apply to a pair of neighbouring pixels
+	const auto red   = _mm_packus_epi16(_mm_add_epi16(y_lo, _mm_unpacklo_epi16(r, r)),
+	                                    _mm_add_epi16(y_hi, _mm_unpackhi_epi16(r, r)));
+	const auto green = _mm_packus_epi16(_mm_sub_epi16(y_lo, _mm_unpacklo_epi16(g, g)),
+	                                    _mm_sub_epi16(y_hi, _mm_unpackhi_epi16(g, g)));
+	const auto blue  = _mm_packus_epi16(_mm_add_epi16(y_lo, _mm_unpacklo_epi16(b, b)),
+	                                    _mm_add_epi16(y_hi, _mm_unpackhi_epi16(b, b)));
+
+	const auto bg_lo = _mm_unpacklo_epi8(blue, green);
+	const auto bg_hi = _mm_unpackhi_epi8(blue, green);
+	const auto rx_lo = _mm_unpacklo_epi8(red, zero);
+	const auto rx_hi = _mm_unpackhi_epi8(red, zero);
+
+	auto dest = reinterpret_cast<__m128i*>(out);
+	_mm_storeu_si128(dest + 0, _mm_unpacklo_epi16(bg_lo, rx_lo));
+	_mm_storeu_si128(dest + 1, _mm_unpackhi_epi16(bg_lo, rx_lo));
+	_mm_storeu_si128(dest + 2, _mm_unpacklo_epi16(bg_hi, rx_hi));
+	_mm_storeu_si128(dest + 3, _mm_unpackhi_epi16(bg_hi, rx_hi));
+}
+
+static void convert_sse2(const uint8_t* y0, const uint8_t* y1, const uint8_t* cb,
+                         const uint8_t* cr, size_t num_blocks, uint8_t* out0,
+                         uint8_t* out1)
+{
+	const auto zero      = _mm_setzero_si128();
+	const auto offset    = _mm_set1_epi16(128);
+	const auto g_factors = _mm_set_epi16(
+	        -12258, 25674, -12258, 25674, -12258, 25674, -12258, 25674);
+
+	auto load_chroma = [&](const uint8_t* src) {
+		const auto bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+		return _mm_sub_epi16(_mm_unpacklo_epi8(bytes, zero), offset);
+	};
+
+	for (; num_blocks >= 8; num_blocks -= 8) {
+		const auto b_values = load_chroma(cb);
+		const auto r_values = load_chroma(cr);
+
+		const auto r = _mm_add_epi16(_mm_add_epi16(r_values, r_values),
+		                             _mm_mulhi_epi16(r_values, _mm_set1_epi16(-26475)));
+		const auto b = _mm_add_epi16(_mm_add_epi16(b_values, b_values),
+		                             _mm_mulhi_epi16(b_values, _mm_set1_epi16(1129)));
+
+		const auto g_lo = _mm_srai_epi32(
+		        _mm_madd_epi16(_mm_unpacklo_epi16(b_values, r_values), g_factors),
+		        16);
+		const auto g_hi = _mm_srai_epi32(
+		        _mm_madd_epi16(_mm_unpackhi_epi16(b_values, r_values), g_factors),
+		        16);
+		const auto g = _mm_add_epi16(_mm_packs_epi32(g_lo, g_hi), r_values);
+
+		put_pixels_sse2(y0, r, g, b, out0);
+		put_pixels_sse2(y1, r, g, b, out1);
+
+		y0 += 16;
+		y1 += 16;
+		cb += 8;
+		cr += 8;
+		out0 += 64;
+		out1 += 64;
+	}
+	convert_scalar(y0, y1, cb, cr, num_blocks, out0, out1);
+}
+#endif
+
+#if PICTURE_KERNELS_NEON
+static int16x8_t mulhi_neon(const int16x8_t a, const int16_t k)
+{
+	return vcombine_s16(vshrn_n_s32(vmull_n_s16(vget_low_s16(a), k), 16),
+	                    vshrn_n_s32(vmull_high_n_s16(a, k), 16));
+}
+
+static int16x8_t get_luma_neon(const uint8x8_t luma)
+{
+	const auto v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(luma)), vdupq_n_s16(16));
+	return vaddq_s16(v, mulhi_neon(v, 10773));
+}
+
+// Converts 16 pixels of a line with the chroma terms of their 8 blocks
+static void put_pixels_neon(const uint8_t* luma, const int16x8_t r,
+                            const int16x8_t g, const int16x8_t b, uint8_t* out)
+{
+	const auto bytes = vld1q_u8(luma);
+	const auto y_lo  = get_luma_neon(vget_low_u8(bytes));
+	const auto y_hi  = get_luma_neon(vget_high_u8(bytes));
+
+	// Each block's terms apply to a pair of neighbouring pixels
+	uint8x16x4_t pixels = {};
+	pixels.val[0] = vcombine_u8(vqmovun_s16(vaddq_s16(y_lo, vzip1q_s16(b, b))),
+	                            vqmovun_s16(vaddq_s16(y_hi, vzip2q_s16(b, b))));
+	pixels.val[1] = vcombine_u8(vqmovun_s16(vsubq_s16(y_lo, vzip1q_s16(g, g))),
+	                            vqmovun_s16(vsubq_s16(y_hi, vzip2q_s16(g, g))));
+	pixels.val[2] = vcombine_u8(vqmovun_s16(vaddq_s16(y_lo, vzip1q_s16(r, r))),
+	                            vqmovun_s16(vaddq_s16(y_hi, vzip2q_s16(r, r))));
+	pixels.val[3] = vdupq_n_u8(0);
+	vst4q_u8(out, pixels);
+}
+
+static void convert_neon(const uint8_t* y0, const uint8_t* y1, const uint8_t* cb,
+                         const uint8_t* cr, size_t num_blocks, uint8_t* out0,
+                         uint8_t* out1)
+{
+	auto load_chroma = [](const uint8_t* src) {
+		return vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(src))),
+		                 vdupq_n_s16(128));
+	};
+
+	for (; num_blocks >= 8; num_blocks -= 8) {
+		const auto b_values = load_chroma(cb);
+		const auto r_values = load_chroma(cr);
+
+		const auto r = vaddq_s16(vaddq_s16(r_values, r_values),
+		                         mulhi_neon(r_values, -26475));
+		const auto b = vaddq_s16(vaddq_s16(b_values, b_values),
+		                         mulhi_neon(b_values, 1129));
+
+		const auto g_lo = vmlal_n_s16(vmull_n_s16(vget_low_s16(b_values), 25674),
+		                              vget_low_s16(r_values),
+		                              -12258);
+		const auto g_hi = vmlal_high_n_s16(vmull_high_n_s16(b_values, 25674),
+		                                   r_values,
+		                                   -12258);
+		const auto g = vaddq_s16(vcombine_s16(vshrn_n_s32(g_lo, 16),
+		                                      vshrn_n_s32(g_hi, 16)),
+		                         r_values);
+
+		put_pixels_neon(y0, r, g, b, out0);
+		put_pixels_neon(y1, r, g, b, out1);
+
+		y0 += 16;
+		y1 += 16;
+		cb += 8;
+		cr += 8;
+		out0 += 64;
+		out1 += 64;
+	}
+	convert_scalar(y0, y1, cb, cr, num_blocks, out0, out1);
+}
+#endif
+
+static void convert_picture(const convert_kernel_f convert,
+                            const uint8_t* y_plane, const size_t y_stride,
+                            const uint8_t* cb_plane, const uint8_t* cr_plane,
+                            const size_t c_stride, const size_t width,
+                            const size_t height, uint8_t* out,
+                            const size_t out_stride)
+{
+	const auto num_blocks = width / 2;
+	for (size_t row = 0; row < height / 2; ++row) {
+		const auto y0 = y_plane + row * 2 * y_stride;
+		const auto c_offset = row * c_stride;
+		const auto out0     = out + row * 2 * out_stride;
+		convert(y0,
+		        y0 + y_stride,
+		        cb_plane + c_offset,
+		        cr_plane + c_offset,
+		        num_blocks,
+		        out0,
+		        out0 + out_stride);
+	}
+}
+
+void ReelMagic_ConvertYCbCrToBgrx(const uint8_t* y_plane, const size_t y_stride,
+                                  const uint8_t* cb_plane, const uint8_t* cr_plane,
+                                  const size_t c_stride, const size_t width,
+                                  const size_t height, uint8_t* out,
+                                  const size_t out_stride)
+{
+#if PICTURE_KERNELS_NEON
+	constexpr auto convert = convert_neon;
+#elif PICTURE_KERNELS_SSE2
+	constexpr auto convert = convert_sse2;
+#else
+	constexpr auto convert = convert_scalar;
+#endif
+	convert_picture(convert, y_plane, y_stride, cb_plane, cr_plane, c_stride,
+	                width, height, out, out_stride);
+}
+
+static void mix_scalar(const uint32_t* vga, const uint32_t* picture,
+                       size_t num_pixels, uint32_t* out)
+{
+	while (num_pixels--) {
+		const auto pixel = *vga++ & RgbMask;
+		*out++           = pixel ? pixel : *picture;
+		++picture;
+	}
+}
+
+#if PICTURE_KERNELS_SSE2
+static void mix_sse2(const uint32_t* vga, const uint32_t* picture,
+                     size_t num_pixels, uint32_t* out)
+{
+	const auto rgb_mask = _mm_set1_epi32(RgbMask);
+	const auto zero     = _mm_setzero_si128();
+
+	for (; num_pixels >= 4; num_pixels -= 4, vga += 4, picture += 4, out += 4) {
+		const auto pixels = _mm_and_si128(
+		        _mm_loadu_si128(reinterpret_cast<const __m128i*>(vga)), rgb_mask);
+		const auto under = _mm_loadu_si128(
+		        reinterpret_cast<const __m128i*>(picture));
+		const auto is_transparent = _mm_cmpeq_epi32(pixels, zero);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+		                 _mm_or_si128(_mm_and_si128(is_transparent, under),
+		                              _mm_andnot_si128(is_transparent, pixels)));
+	}
+	mix_scalar(vga, picture, num_pixels, out);
+}
+#endif
+
+#if PICTURE_KERNELS_NEON
+static void mix_neon(const uint32_t* vga, const uint32_t* picture,
+                     size_t num_pixels, uint32_t* out)
+{
+	const auto rgb_mask = vdupq_n_u32(RgbMask);
+
+	for (; num_pixels >= 4; num_pixels -= 4, vga += 4, picture += 4, out += 4) {
+		const auto pixels = vandq_u32(vld1q_u32(vga), rgb_mask);
+		const auto is_transparent = vceqq_u32(pixels, vdupq_n_u32(0));
+		vst1q_u32(out, vbslq_u32(is_transparent, vld1q_u32(picture), pixels));
+	}
+	mix_scalar(vga, picture, num_pixels, out);
+}
+#endif
+
+void ReelMagic_MixLineOverPicture(const uint32_t* vga, const uint32_t* picture,
+                                  const size_t num_pixels, uint32_t* out)
+{
+#if PICTURE_KERNELS_NEON
+	mix_neon(vga, picture, num_pixels, out);
+#elif PICTURE_KERNELS_SSE2
+	mix_sse2(vga, picture, num_pixels, out);
+#else
+	mix_scalar(vga, picture, num_pixels, out);
+#endif
+}
+
+static void double_scalar(const uint32_t* picture, const size_t num_pixels,
+                          uint32_t* out)
+{
+	for (size_t i = 0; i < num_pixels; ++i) {
+		out[i] = picture[i >> 1];
+	}
+}
+
+#if PICTURE_KERNELS_SSE2
+static void double_sse2(const uint32_t* picture, size_t num_pixels, uint32_t* out)
+{
+	for (; num_pixels >= 8; num_pixels -= 8, picture += 4, out += 8) {
+		const auto pixels = _mm_loadu_si128(
+		        reinterpret_cast<const __m128i*>(picture));
+		auto dest = reinterpret_cast<__m128i*>(out);
+		_mm_storeu_si128(dest, _mm_unpacklo_epi32(pixels, pixels));
+		_mm_storeu_si128(dest + 1, _mm_unpackhi_epi32(pixels, pixels));
+	}
+	double_scalar(picture, num_pixels, out);
+}
+#endif
+
+#if PICTURE_KERNELS_NEON
+static void double_neon(const uint32_t* picture, size_t num_pixels, uint32_t* out)
+{
+	for (; num_pixels >= 8; num_pixels -= 8, picture += 4, out += 8) {
+		const auto pixels = vld1q_u32(picture);
+		vst2q_u32(out, uint32x4x2_t{{pixels, pixels}});
+	}
+	double_scalar(picture, num_pixels, out);
+}
+#endif
+
+void ReelMagic_DoublePictureLine(const uint32_t* picture, const size_t num_pixels,
+                                 uint32_t* out)
+{
+#if PICTURE_KERNELS_NEON
+	double_neon(picture, num_pixels, out);
+#elif PICTURE_KERNELS_SSE2
+	double_sse2(picture, num_pixels, out);
+#else
+	double_scalar(picture, num_pixels, out);
+#endif
+}
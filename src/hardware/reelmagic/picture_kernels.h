@@ -0,0 +1,53 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_REELMAGIC_PICTURE_KERNELS_H
+#define DOSBOX_REELMAGIC_PICTURE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Picture kernels of the ReelMagic video mixer
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The decoded MPEG pictures are kept in the mixer's output format: BGRX8888
+// byte arrays with zero X bytes, so they can be mixed with the VGA lines 32
+// bits at a time. The kernels are vectorised with SSE2 on x86 hosts and with
+// NEON on 64-bit Arm hosts, and their outputs are identical to the scalar
+// pixel-at-a-time versions.
+
+// Converts a 4:2:0 YCbCr picture following BT.601, identically to pl_mpeg's
+// plm_frame_to_bgra() except for the zeroed X bytes. Like pl_mpeg, only whole
+// 2x2 blocks are converted, so the last column and row of odd-sized pictures
+// are left untouched.
+void ReelMagic_ConvertYCbCrToBgrx(const uint8_t* y_plane, size_t y_stride,
+                                  const uint8_t* cb_plane, const uint8_t* cr_plane,
+                                  size_t c_stride, size_t width, size_t height,
+                                  uint8_t* out, size_t out_stride);
+
+// Mixes a line of BGRX8888 VGA pixels over a line of picture pixels: the
+// black VGA pixels are transparent. The X bytes of the output are zeroed.
+void ReelMagic_MixLineOverPicture(const uint32_t* vga, const uint32_t* picture,
+                                  size_t num_pixels, uint32_t* out);
+
+// Writes 'num_pixels' output pixels, each picture pixel twice
+void ReelMagic_DoublePictureLine(const uint32_t* picture, size_t num_pixels,
+                                 uint32_t* out);
+
+#endif
@@ -22,24 +22,35 @@
 
 #include "reelmagic.h"
 
+#include <algorithm>
 #include <array>
+#include <condition_variable>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
+#include <deque>
 #include <exception>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "audio_frame.h"
 #include "channel_names.h"
 #include "dos_system.h"
+#include "host_threads.h"
 #include "logging.h"
 #include "mixer.h"
 #include "setup.h"
+#include "support.h"
 
 // bring in the MPEG-1 decoder library...
 #define PL_MPEG_IMPLEMENTATION
 #include "mpeg_decoder.h"
+#include "picture_kernels.h"
 
 // global config
 static ReelMagic_PlayerConfiguration _globalDefaultPlayerConfiguration;
@@ -78,16 +89,24 @@ struct RMException : ::std::exception {
 
 class AudioFifo {
 private:
-	plm_t* mpeg_stream        = {};
-	plm_samples_t* mp2_buffer = {};
-	int sample_rate           = 0;
-	uint16_t num_inspected    = 0;
+	plm_t* mpeg_stream     = {};
+	int sample_rate        = 0;
+	uint16_t num_inspected = 0;
+
+	// Decoded by the player's decoder thread and played by the mixer
+	// callback
+	std::mutex mutex              = {};
+	std::deque<AudioFrame> frames = {};
 
 public:
 	AudioFifo() = default;
 
-	AudioFifo(plm_t* plm) : mpeg_stream(plm)
+	AudioFifo(const AudioFifo&)            = delete;
+	AudioFifo& operator=(const AudioFifo&) = delete;
+
+	void Open(plm_t* plm)
 	{
+		mpeg_stream = plm;
 		assert(mpeg_stream);
 		assert(mpeg_stream->audio_decoder);
 		assert(mpeg_stream->audio_decoder->buffer);
@@ -111,59 +130,48 @@ public:
 		sample_rate = rate;
 	}
 
-	const float* PopFrame()
+	// Decodes the MP2 frames demuxed so far; runs on the decoder thread
+	void DecodeAvailableFrames()
 	{
+		if (!mpeg_stream) {
+			return;
+		}
 		constexpr uint16_t max_frames = PLM_AUDIO_SAMPLES_PER_FRAME;
 
-		// A helper to get the audio frame at the current position.
-		auto at_pos = [&]() {
-			assert(mp2_buffer);
-			constexpr uint8_t num_channels = 2; // L & R
-			const auto pos = num_channels * mp2_buffer->count++;
-			return mp2_buffer->interleaved + pos;
-		};
-		// A lamda to get the current frame and decode the next
-		// MP2 buffer once we've used all the current frames.
-		//
-		auto get_frame = [&]() -> float* {
-			// If the MP2 buffer is still valid, return the audio
-			// frame at the current position.
-			if (mp2_buffer && mp2_buffer->count < max_frames) {
-				return at_pos();
-			}
-			// Otherwise try decoding the next MP2 frame
-			assert(mpeg_stream);
-			if (mp2_buffer = plm_decode_audio(mpeg_stream); mp2_buffer) {
-				// If we got a new MP2 buffer then reset the
-				// usage count and return its first frame.
-				mp2_buffer->count = 0;
-				return at_pos();
-			}
-			// We're out! No more frames or MP2 buffers available.
-			return nullptr;
-		};
-		// A lamda to skip past initial empty audio chunks (up to half a
-		// frame's worth) which helps reduce or eliminate gap-stuttering
-		// during the initial video playback.
-		//
-		auto skip_initial_gaps = [&](float* frame) {
-			while (num_inspected < max_frames && frame) {
-				++num_inspected;
-				if (frame[0] == 0.0f && frame[1] == 0.0f) {
-					frame = get_frame();
-				} else {
-					break;
+		while (const auto mp2_buffer = plm_decode_audio(mpeg_stream)) {
+			std::lock_guard<std::mutex> lock(mutex);
+
+			const float* frame = mp2_buffer->interleaved;
+			for (auto i = 0; i < max_frames; ++i, frame += 2) {
+				// Skip past initial empty audio chunks (up to half a
+				// frame's worth) which helps reduce or eliminate
+				// gap-stuttering during the initial video playback.
+				if (num_inspected < max_frames) {
+					++num_inspected;
+					if (frame[0] == 0.0f && frame[1] == 0.0f) {
+						continue;
+					}
 				}
+				frames.emplace_back(frame[0], frame[1]);
 			}
-			return frame;
-		};
+		}
+	}
 
-		return skip_initial_gaps(get_frame());
+	// Moves up to 'num_frames' decoded frames into 'out'; runs on the
+	// mixer
+	void PopFrames(const int num_frames, std::vector<AudioFrame>& out)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		const auto n = std::min(frames.size(), static_cast<size_t>(num_frames));
+		out.assign(frames.begin(), frames.begin() + n);
+		frames.erase(frames.begin(), frames.begin() + n);
 	}
 
-	void ResetMp2Buffer()
+	void Reset()
 	{
-		mp2_buffer    = {};
+		std::lock_guard<std::mutex> lock(mutex);
+		frames.clear();
 		num_inspected = 0;
 	}
 };
@@ -195,12 +203,59 @@ class ReelMagic_MediaPlayerImplementation : public ReelMagic_MediaPlayer,
 
 	// stuff about the MPEG decoder...
 	plm_t* _plm                   = {};
-	plm_frame_t* _nextFrame       = {};
 	float _framerate              = {};
 	uint8_t _magicalRSizeOverride = {};
 
 	AudioFifo audio_fifo = {};
 
+	// Threaded decoding
+	// ~~~~~~~~~~~~~~~~~
+	// Once the asset checks out, a decoder thread owns the MPEG decoder: it
+	// decodes the pictures ahead of presentation into a small queue, and
+	// the audio demuxed along with them into the audio FIFO. The file can
+	// only be read on the emulation thread (DOS files go through the
+	// emulated DOS), so the decoder reads from a buffer of the file's bytes
+	// that the emulation thread keeps topped up on every vertical refresh.
+	struct Picture {
+		std::vector<uint8_t> pixels = {};
+		// The demuxer's position after decoding the picture
+		Bitu bytes_decoded  = 0;
+		uint32_t generation = 0;
+		// Marks the end of the stream
+		bool is_end = false;
+	};
+
+	static constexpr size_t MaxQueuedPictures = 3;
+	static constexpr size_t ReadAheadBytes    = 64 * 1024;
+	static constexpr uint16_t ReadChunkBytes  = 4096;
+
+	std::thread _decoder            = {};
+	std::mutex _mutex               = {};
+	std::condition_variable _waiter = {};
+	bool _isThreaded                = false;
+
+	// Guarded by the mutex
+	std::deque<Picture> _pictures       = {};
+	std::optional<uint32_t> _pendingSeek = {};
+	// Counts the seeks, to drop the pictures decoded before the last one
+	uint32_t _generation = 0;
+	bool _loop           = false;
+	bool _decodeEnded    = false;
+	bool _shouldExit     = false;
+
+	// The file's bytes at the decoder's read position, also guarded by
+	// the mutex
+	std::vector<uint8_t> _fileBytes   = {};
+	size_t _fileBytesRead             = 0;
+	std::optional<uint32_t> _fileSeek = {};
+	bool _fileEnded                   = false;
+
+	// The next picture to show, only used on the emulation thread
+	std::vector<uint8_t> _picture = {};
+	Bitu _bytesDecoded            = 0;
+	int _picturesDue              = 0;
+	bool _awaitingSeekPicture     = false;
+
 	static void plmBufferLoadCallback(plm_buffer_t* self, void* user)
 	{
 		// note: based on plm_buffer_load_file_callback()
@@ -211,10 +266,14 @@ class ReelMagic_MediaPlayerImplementation : public ReelMagic_MediaPlayer,
 			auto bytes_available = self->capacity - self->length;
 			if (bytes_available > 4096)
 				bytes_available = 4096;
-			const uint32_t bytes_read = ((ReelMagic_MediaPlayerImplementation*)user)
-			                                    ->_file->Read(self->bytes + self->length,
-			                                                  static_cast<uint16_t>(
-			                                                          bytes_available));
+
+			const auto player = static_cast<ReelMagic_MediaPlayerImplementation*>(user);
+			const auto data   = self->bytes + self->length;
+			const auto amount = static_cast<uint16_t>(bytes_available);
+
+			const uint32_t bytes_read = player->_isThreaded
+			                                  ? player->ReadBufferedFile(data, amount)
+			                                  : player->_file->Read(data, amount);
 			self->length += bytes_read;
 
 			if (bytes_read == 0) {
@@ -227,9 +286,13 @@ class ReelMagic_MediaPlayerImplementation : public ReelMagic_MediaPlayer,
 	static void plmBufferSeekCallback([[maybe_unused]] plm_buffer_t* self, void* user, size_t absPos)
 	{
 		assert(absPos <= UINT32_MAX);
+		const auto player = static_cast<ReelMagic_MediaPlayerImplementation*>(user);
+		if (player->_isThreaded) {
+			player->SeekBufferedFile(static_cast<uint32_t>(absPos));
+			return;
+		}
 		try {
-			((ReelMagic_MediaPlayerImplementation*)user)
-			        ->_file->Seek(static_cast<uint32_t>(absPos), DOS_SEEK_SET);
+			player->_file->Seek(static_cast<uint32_t>(absPos), DOS_SEEK_SET);
 		} catch (...) {
 			// XXX what to do on failure !?
 		}
@@ -247,19 +310,205 @@ class ReelMagic_MediaPlayerImplementation : public ReelMagic_MediaPlayer,
 		}
 	}
 
-	void advanceNextFrame()
+	plm_frame_t* decodeNextFrame()
 	{
-		_nextFrame = plm_decode_video(_plm);
-		if (!_nextFrame) {
+		auto frame = plm_decode_video(_plm);
+		if (!frame) {
 			// note: will return nullptr frame once when looping...
 			// give it one more go...
 			if (plm_get_loop(_plm)) {
-				_nextFrame = plm_decode_video(_plm);
+				frame = plm_decode_video(_plm);
 			}
-			if (!_nextFrame) {
-				_playing = false;
+		}
+		return frame;
+	}
+
+	// The pictures are converted to the video mixer's BGRX format
+	static constexpr size_t PictureBytesPerPixel = 4;
+
+	void convertFrame(const plm_frame_t* const frame, std::vector<uint8_t>& picture) const
+	{
+		const auto stride = _attrs.PictureSize.Width * PictureBytesPerPixel;
+		picture.resize(stride * _attrs.PictureSize.Height);
+		ReelMagic_ConvertYCbCrToBgrx(frame->y.data,
+		                             frame->y.width,
+		                             frame->cb.data,
+		                             frame->cr.data,
+		                             frame->cb.width,
+		                             frame->width,
+		                             frame->height,
+		                             picture.data(),
+		                             stride);
+	}
+
+	// Runs on the decoder thread; waits for the emulation thread to read
+	// ahead while the buffer is empty
+	uint32_t ReadBufferedFile(uint8_t* const data, const uint16_t amount)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_waiter.wait(lock, [&] {
+			return _shouldExit || _fileEnded ||
+			       _fileBytesRead < _fileBytes.size();
+		});
+		const auto num_bytes = std::min(static_cast<size_t>(amount),
+		                                _fileBytes.size() - _fileBytesRead);
+
+		std::memcpy(data, _fileBytes.data() + _fileBytesRead, num_bytes);
+		_fileBytesRead += num_bytes;
+		return static_cast<uint32_t>(num_bytes);
+	}
+
+	// Runs on the decoder thread; the emulation thread performs the seek
+	// before reading ahead again
+	void SeekBufferedFile(const uint32_t pos)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_fileBytes.clear();
+		_fileBytesRead = 0;
+		_fileSeek      = pos;
+		_fileEnded     = false;
+	}
+
+	// Runs on the emulation thread
+	void ReadAheadFile()
+	{
+		if (!_isThreaded) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_fileSeek) {
+				try {
+					_file->Seek(*_fileSeek, DOS_SEEK_SET);
+				} catch (...) {
+					// XXX what to do on failure !?
+				}
+				_fileSeek.reset();
+			}
+
+			// Drop the bytes the decoder has consumed
+			_fileBytes.erase(_fileBytes.begin(),
+			                 _fileBytes.begin() + _fileBytesRead);
+			_fileBytesRead = 0;
+
+			while (!_fileEnded && _fileBytes.size() < ReadAheadBytes) {
+				const auto old_size = _fileBytes.size();
+				_fileBytes.resize(old_size + ReadChunkBytes);
+
+				uint32_t bytes_read = 0;
+				try {
+					bytes_read = _file->Read(_fileBytes.data() + old_size,
+					                         ReadChunkBytes);
+				} catch (...) {
+					bytes_read = 0;
+				}
+				_fileBytes.resize(old_size + bytes_read);
+
+				if (bytes_read == 0) {
+					_fileEnded = true;
+				}
 			}
 		}
+		_waiter.notify_all();
+	}
+
+	// Runs on the decoder thread, until the player is destroyed
+	void DecoderLoop()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (true) {
+			_waiter.wait(lock, [&] {
+				return _shouldExit || _pendingSeek ||
+				       (!_decodeEnded && _pictures.size() < MaxQueuedPictures);
+			});
+			if (_shouldExit) {
+				return;
+			}
+			const auto generation  = _generation;
+			const auto seek_offset = std::exchange(_pendingSeek, std::nullopt);
+			const auto loop        = _loop;
+			lock.unlock();
+
+			if (seek_offset) {
+				plm_rewind(_plm);
+				plm_buffer_seek(_plm->demux->buffer, (size_t)*seek_offset);
+				audio_fifo.Reset();
+
+				// this is a hacky way to force an audio decoder reset...
+				if (_plm->audio_decoder)
+					// something (hopefully not sample rate) changes between byte seeks in crime
+					// patrol...
+					_plm->audio_decoder->has_header = FALSE;
+			}
+			plm_set_loop(_plm, loop ? TRUE : FALSE);
+
+			Picture picture    = {};
+			picture.generation = generation;
+			if (const auto frame = decodeNextFrame(); frame) {
+				convertFrame(frame, picture.pixels);
+			} else {
+				picture.is_end = true;
+			}
+			picture.bytes_decoded = plm_buffer_tell(_plm->demux->buffer);
+
+			audio_fifo.DecodeAvailableFrames();
+
+			lock.lock();
+			if (picture.generation == _generation) {
+				_decodeEnded = picture.is_end;
+				_pictures.push_back(std::move(picture));
+			}
+		}
+	}
+
+	void StartDecoder()
+	{
+		_isThreaded = true;
+		_decoder = std::thread(&ReelMagic_MediaPlayerImplementation::DecoderLoop, this);
+		set_thread_name(_decoder, "dosbox:reelmagic");
+		HOST_THREADS_Apply(_decoder, HostThreadGroup::Worker);
+	}
+
+	void StopDecoder()
+	{
+		if (!_decoder.joinable()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_shouldExit = true;
+		}
+		_waiter.notify_all();
+		_decoder.join();
+	}
+
+	// Moves the next decoded picture of the current seek into the picture
+	// to show. Returns false if there isn't one yet, or if the stream has
+	// ended, which stops the playback.
+	bool PopPicture()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			while (!_pictures.empty() &&
+			       _pictures.front().generation != _generation) {
+				_pictures.pop_front();
+			}
+			if (_pictures.empty()) {
+				return false;
+			}
+			auto& picture = _pictures.front();
+			if (picture.is_end) {
+				// Leave the end marker for the next attempt
+				_playing     = false;
+				_picturesDue = 0;
+				return false;
+			}
+			_picture.swap(picture.pixels);
+			_bytesDecoded = picture.bytes_decoded;
+			_pictures.pop_front();
+		}
+		_waiter.notify_all();
+		return true;
 	}
 
 	unsigned FindMagicalFCode()
@@ -422,16 +671,20 @@ public:
 		}
 
 		CollectVideoStats();
-		advanceNextFrame(); // attempt to decode the first frame of video...
-		if (!_nextFrame || (_attrs.PictureSize.Width == 0) ||
+		// attempt to decode the first frame of video...
+		const auto first_frame = decodeNextFrame();
+		if (!first_frame || (_attrs.PictureSize.Width == 0) ||
 		    (_attrs.PictureSize.Height == 0)) {
 			// something failed... asset is deemed bad at this point...
 			plm_destroy(_plm);
 			_plm = nullptr;
+		} else {
+			convertFrame(first_frame, _picture);
+			_bytesDecoded = plm_buffer_tell(_plm->demux->buffer);
 		}
 		// Setup the audio FIFO if we have audio
 		if (_plm && _plm->audio_decoder) {
-			audio_fifo = AudioFifo(_plm);
+			audio_fifo.Open(_plm);
 		}
 
 		if (!_plm) {
@@ -451,12 +704,14 @@ public:
 				("Media Player Audio Decoder Enabled @ %uHz",
 				 (unsigned)audio_fifo.GetSampleRate());
 			}
+			StartDecoder();
 		}
 	}
 	~ReelMagic_MediaPlayerImplementation() override
 	{
 		LOG(LOG_REELMAGIC, LOG_NORMAL)
 		("Destroying Media Player #%u with file %s", GetBaseHandle(), _file->GetFileName());
+		StopDecoder();
 		DeactivatePlayerAudioFifo(audio_fifo);
 		if (ReelMagic_GetVideoMixerMPEGProvider() == this)
 			ReelMagic_ClearVideoMixerMPEGProvider();
@@ -470,19 +725,25 @@ public:
 	//
 	void OnVerticalRefresh(void* const outputBuffer, const float fps) override
 	{
+		ReadAheadFile();
+
 		if (fps != _vgaFps) {
 			_vgaFps                = fps;
 			_vgaFramesPerMpegFrame = _vgaFps;
 			_vgaFramesPerMpegFrame /= _framerate;
 			_waitVgaFramesUntilNextMpegFrame = _vgaFramesPerMpegFrame;
 			_drawNextFrame                   = true;
+			_picturesDue                     = 0;
+		}
+
+		// The first picture after a seek replaces the one to show
+		if (_awaitingSeekPicture && PopPicture()) {
+			_awaitingSeekPicture = false;
 		}
 
 		if (_drawNextFrame) {
-			if (_nextFrame) {
-				plm_frame_to_rgb(_nextFrame,
-				                 (uint8_t*)outputBuffer,
-				                 _attrs.PictureSize.Width * 3);
+			if (!_picture.empty()) {
+				std::memcpy(outputBuffer, _picture.data(), _picture.size());
 			}
 			_drawNextFrame = false;
 		}
@@ -495,7 +756,13 @@ public:
 
 		for (_waitVgaFramesUntilNextMpegFrame -= 1.f; _waitVgaFramesUntilNextMpegFrame < 0.f;
 		     _waitVgaFramesUntilNextMpegFrame += _vgaFramesPerMpegFrame) {
-			advanceNextFrame();
+			++_picturesDue;
+		}
+
+		// If the decoder has fallen behind, the due pictures are caught
+		// up on the following refreshes
+		while (_picturesDue > 0 && !_awaitingSeekPicture && PopPicture()) {
+			--_picturesDue;
 			_drawNextFrame = true;
 		}
 	}
@@ -580,7 +847,7 @@ public:
 		// rounding up the demux position to align....
 		// NOTE: I'm not sure if this should be different for DMA streaming mode!
 		const Bitu alignTo = 4096;
-		Bitu rv            = plm_buffer_tell(_plm->demux->buffer);
+		Bitu rv            = _bytesDecoded;
 		rv += alignTo - 1;
 		rv &= ~(alignTo - 1);
 		return rv;
@@ -594,7 +861,19 @@ public:
 		if (_playing)
 			return;
 		_playing = true;
-		plm_set_loop(_plm, (playMode == MPPM_LOOP) ? TRUE : FALSE);
+		{
+			// Give the decoder another go if the stream has ended,
+			// which restarts it when looping
+			std::lock_guard<std::mutex> lock(_mutex);
+			_loop = (playMode == MPPM_LOOP);
+			if (_decodeEnded) {
+				while (!_pictures.empty() && _pictures.back().is_end) {
+					_pictures.pop_back();
+				}
+				_decodeEnded = false;
+			}
+		}
+		_waiter.notify_all();
 		_stopOnComplete = playMode == MPPM_STOPONCOMPLETE;
 		ReelMagic_SetVideoMixerMPEGProvider(this);
 		ActivatePlayerAudioFifo(audio_fifo);
@@ -612,17 +891,24 @@ public:
 	}
 	void SeekToByteOffset(const uint32_t offset) override
 	{
-		plm_rewind(_plm);
-		plm_buffer_seek(_plm->demux->buffer, (size_t)offset);
-		audio_fifo.ResetMp2Buffer();
-
-		// this is a hacky way to force an audio decoder reset...
-		if (_plm->audio_decoder)
-			// something (hopefully not sample rate) changes between byte seeks in crime
-			// patrol...
-			_plm->audio_decoder->has_header = FALSE;
+		if (!_plm) {
+			return;
+		}
+		// The decoder thread performs the seek and decodes the first
+		// picture after it, which the next vertical refresh picks up
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			++_generation;
+			_pendingSeek = offset;
+			_decodeEnded = false;
+			_pictures.clear();
+		}
+		_waiter.notify_all();
+		audio_fifo.Reset();
 
-		advanceNextFrame();
+		_bytesDecoded        = offset;
+		_picturesDue         = 0;
+		_awaitingSeekPicture = true;
 	}
 	void NotifyConfigChange() override
 	{
@@ -767,14 +1053,15 @@ static void RMMixerChannelCallback(uint16_t frames_remaining)
 	assert(mixer_channel);
 	assert(frames_remaining > 0);
 
-	while (frames_remaining > 0) {
-		if (const auto frame = active_fifo->PopFrame(); frame) {
-			mixer_channel->AddSamples_sfloat(1, frame);
-			--frames_remaining;
-		} else {
-			mixer_channel->AddSilence();
-			frames_remaining = 0;
-		}
+	static std::vector<AudioFrame> frames = {};
+	active_fifo->PopFrames(frames_remaining, frames);
+
+	if (!frames.empty()) {
+		mixer_channel->AddSamples_sfloat(static_cast<int>(frames.size()),
+		                                 &frames[0][0]);
+	}
+	if (frames.size() < frames_remaining) {
+		mixer_channel->AddSilence();
 	}
 }
 
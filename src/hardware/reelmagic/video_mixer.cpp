@@ -31,8 +31,10 @@
 #include <cstring>
 #include <exception>
 #include <string>
+#include <type_traits>
 
 #include "../../gui/render_scalers.h" //SCALER_MAXWIDTH SCALER_MAXHEIGHT
+#include "picture_kernels.h"
 #include "rgb565.h"
 #include "setup.h"
 #include "video.h"
@@ -65,7 +67,7 @@ struct RMException : ::std::exception {
 // being a bit redundant here as an attempt to keep this
 // already complicated logic somewhat readable
 namespace {
-struct RenderOutputPixel {
+struct alignas(4) RenderOutputPixel {
 	uint8_t blue;
 	uint8_t green;
 	uint8_t red;
@@ -156,10 +158,13 @@ struct VGAOverPalettePixel : VGAPalettePixel {
 	}
 };
 
-struct PlayerPicturePixel {
-	uint8_t red;
-	uint8_t green;
+// The MPEG pictures are kept in the output format with zero alpha bytes, so
+// the picture kernels can mix them with the VGA lines 32 bits at a time
+struct alignas(4) PlayerPicturePixel {
 	uint8_t blue;
+	uint8_t green;
+	uint8_t red;
+	uint8_t alpha;
 	template <typename T>
 	inline void CopyRGBTo(T& out) const
 	{
@@ -172,6 +177,13 @@ struct PlayerPicturePixel {
 		return false;
 	}
 };
+static_assert(sizeof(PlayerPicturePixel) == sizeof(uint32_t));
+
+// The VGA pixels that always show the MPEG picture
+template <typename T>
+constexpr bool IsUnderlay = std::is_same_v<T, VGAUnderPalettePixel> ||
+                            std::is_same_v<T, VGAUnder16bppPixel> ||
+                            std::is_same_v<T, VGAUnder32bppPixel>;
 } // namespace
 
 //
@@ -211,6 +223,7 @@ static ReelMagic_VideoMixerMPEGProvider* _requestedMpegProvider = nullptr;
 static ReelMagic_VideoMixerMPEGProvider* _activeMpegProvider    = nullptr;
 
 static RenderOutputPixel _finalMixedRenderLineBuffer[SCALER_MAXWIDTH];
+static PlayerPicturePixel _scaledMpegLineBuffer[SCALER_MAXWIDTH];
 static Bitu _currentRenderLineNumber = 0;
 static uint32_t _renderWidth         = 0;
 static uint32_t _renderHeight        = 0;
@@ -245,6 +258,46 @@ static inline void MixPixel(RenderOutputPixel& out, const VGAPixelT& vga_pixel)
 	out.alpha = 0;
 }
 
+// Mixes a line of VGA pixels over a line of MPEG pixels already scaled to
+// the VGA width. The underlays and the 32bpp overlays don't need to look at
+// the pixels one at a time, so they're left to the picture kernels.
+template <typename T>
+static inline void MixLine(const T* src, const PlayerPicturePixel* mpeg,
+                           const Bitu width)
+{
+	RenderOutputPixel* const out = _finalMixedRenderLineBuffer;
+	if constexpr (IsUnderlay<T>) {
+		std::memcpy(out, mpeg, width * sizeof(*out));
+	} else if constexpr (std::is_same_v<T, VGAOver32bppPixel>) {
+		ReelMagic_MixLineOverPicture(reinterpret_cast<const uint32_t*>(src),
+		                             reinterpret_cast<const uint32_t*>(mpeg),
+		                             width,
+		                             reinterpret_cast<uint32_t*>(out));
+	} else {
+		for (Bitu i = 0; i < width; ++i) {
+			MixPixel(out[i], src[i], mpeg[i]);
+		}
+	}
+}
+
+// Mixes a line of VGA pixels over a line of MPEG pixels half as wide
+template <typename T>
+static inline void MixLineDoubled(const T* src, const PlayerPicturePixel* mpeg,
+                                  const Bitu width)
+{
+	auto double_line = [&](void* const out) {
+		ReelMagic_DoublePictureLine(reinterpret_cast<const uint32_t*>(mpeg),
+		                            width,
+		                            static_cast<uint32_t*>(out));
+	};
+	if constexpr (IsUnderlay<T>) {
+		double_line(_finalMixedRenderLineBuffer);
+	} else {
+		double_line(_scaledMpegLineBuffer);
+		MixLine(src, _scaledMpegLineBuffer, width);
+	}
+}
+
 static void ClearMpegPictureBuffer(const PlayerPicturePixel p)
 {
 	for (Bitu i = 0; i < (sizeof(_mpegPictureBuffer) / sizeof(_mpegPictureBuffer[0])); ++i)
@@ -257,6 +310,7 @@ static void ClearMpegPictureBuffer()
 	p.red   = 0;
 	p.green = 0;
 	p.blue  = 0;
+	p.alpha = 0;
 	ClearMpegPictureBuffer(p);
 }
 
@@ -377,13 +431,7 @@ CREATE_RMR_VGA_TYPED_FUNCTIONS(RMR_DrawLine_VGAOnly)
 template <typename T>
 static inline void RMR_DrawLine_VGAMPEGSameSize(const T* src)
 {
-	const Bitu lineWidth = _vgaImageInfo.width;
-
-	RenderOutputPixel* const out = _finalMixedRenderLineBuffer;
-
-	for (Bitu i = 0; i < lineWidth; ++i) {
-		MixPixel(out[i], src[i], _mpegPictureBufferPtr[i]);
-	}
+	MixLine(src, _mpegPictureBufferPtr, _vgaImageInfo.width);
 
 	_mpegPictureBufferPtr += _mpegPictureWidth;
 
@@ -395,12 +443,8 @@ CREATE_RMR_VGA_TYPED_FUNCTIONS(RMR_DrawLine_VGAMPEGSameSize)
 template <typename T>
 static inline void RMR_DrawLine_VSO_MPEGDoubleVGASize(const T* src)
 {
-	const Bitu lineWidth         = _vgaImageInfo.width;
-	RenderOutputPixel* const out = _finalMixedRenderLineBuffer;
 	_mpegPictureBufferPtr -= _mpegPictureWidth * (_currentRenderLineNumber++ & 1);
-	for (Bitu i = 0; i < lineWidth; ++i) {
-		MixPixel(out[i], src[i], _mpegPictureBufferPtr[i >> 1]);
-	}
+	MixLineDoubled(src, _mpegPictureBufferPtr, _vgaImageInfo.width);
 	_mpegPictureBufferPtr += _mpegPictureWidth;
 	RENDER_DrawLine(_finalMixedRenderLineBuffer);
 }
@@ -409,10 +453,7 @@ CREATE_RMR_VGA_TYPED_FUNCTIONS(RMR_DrawLine_VSO_MPEGDoubleVGASize)
 template <typename T>
 static inline void RMR_DrawLine_VSO_VGAMPEGSameWidthSkip6Vertical(const T* src)
 {
-	const Bitu lineWidth         = _vgaImageInfo.width;
-	RenderOutputPixel* const out = _finalMixedRenderLineBuffer;
-	for (Bitu i = 0; i < lineWidth; ++i)
-		MixPixel(out[i], src[i], _mpegPictureBufferPtr[i]);
+	MixLine(src, _mpegPictureBufferPtr, _vgaImageInfo.width);
 	_mpegPictureBufferPtr += _mpegPictureWidth;
 	if (++_currentRenderLineNumber >= 6) {
 		_currentRenderLineNumber = 0;
@@ -425,11 +466,8 @@ CREATE_RMR_VGA_TYPED_FUNCTIONS(RMR_DrawLine_VSO_VGAMPEGSameWidthSkip6Vertical)
 template <typename T>
 static inline void RMR_DrawLine_VSO_VGAMPEGDoubleSameWidthSkip6Vertical(const T* src)
 {
-	const Bitu lineWidth         = _vgaImageInfo.width;
-	RenderOutputPixel* const out = _finalMixedRenderLineBuffer;
 	_mpegPictureBufferPtr -= _mpegPictureWidth * (_currentRenderLineNumber & 1);
-	for (Bitu i = 0; i < lineWidth; ++i)
-		MixPixel(out[i], src[i], _mpegPictureBufferPtr[i >> 1]);
+	MixLineDoubled(src, _mpegPictureBufferPtr, _vgaImageInfo.width);
 	_mpegPictureBufferPtr += _mpegPictureWidth;
 	if (++_currentRenderLineNumber >= 6) {
 		_currentRenderLineNumber = 0;
@@ -458,12 +496,11 @@ static void Initialize_RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_Dimensions()
 template <typename T>
 static inline void RMR_DrawLine_VSO_GeneralResizeMPEGToVGA(const T* src)
 {
-	const Bitu lineWidth         = _vgaImageInfo.width;
-	RenderOutputPixel* const out = _finalMixedRenderLineBuffer;
+	const Bitu lineWidth = _vgaImageInfo.width;
 	for (Bitu i = 0; i < lineWidth; ++i)
-		MixPixel(out[i],
-		         src[i],
-		         _mpegPictureBufferPtr[(i * _RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_WidthRatio) >> 12]);
+		_scaledMpegLineBuffer[i] =
+		        _mpegPictureBufferPtr[(i * _RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_WidthRatio) >> 12];
+	MixLine(src, _scaledMpegLineBuffer, lineWidth);
 	_mpegPictureBufferPtr =
 	        &_mpegPictureBuffer[_mpegPictureWidth * ((++_currentRenderLineNumber *
 	                                                  _RMR_DrawLine_VSO_GeneralResizeMPEGToVGA_HeightRatio) >>
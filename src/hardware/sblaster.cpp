@@ -23,6 +23,7 @@
 #include <iomanip>
 #include <map>
 #include <optional>
+#include <span>
 #include <string>
 #include <tuple>
 
@@ -890,6 +891,20 @@ static uint32_t read_dma_8bit(const uint32_t bytes_to_read, const uint32_t i = 0
 	return check_cast<uint32_t>(bytes_read);
 }
 
+// Returns the next 8-bit samples straight from the guest's memory if the
+// transfer is contiguous in host memory, and only copies them into the DMA
+// buffer otherwise
+static std::span<const uint8_t> read_dma_8bit_in_place(const uint32_t bytes_to_read)
+{
+	const auto in_place = sb.dma.chan->PeekRead(bytes_to_read);
+	if (in_place.size() == bytes_to_read) {
+		sb.dma.chan->Skip(bytes_to_read);
+		return in_place;
+	}
+	const auto bytes_read = read_dma_8bit(bytes_to_read);
+	return {sb.dma.buf.b8, bytes_read};
+}
+
 static uint32_t read_dma_16bit(const uint32_t bytes_to_read, const uint32_t i = 0)
 {
 	const auto unsigned_buf = reinterpret_cast<uint8_t*>(sb.dma.buf.b16 + i);
@@ -899,6 +914,30 @@ static uint32_t read_dma_16bit(const uint32_t bytes_to_read, const uint32_t i =
 	return check_cast<uint32_t>(bytes_read);
 }
 
+// Returns the next 16-bit samples straight from the guest's memory if the
+// whole transfer is contiguous and aligned in host memory, or an empty span if
+// they have to be copied with read_dma_16bit(). Native byte order only.
+static std::span<const int16_t> read_dma_16bit_in_place(const uint32_t words_to_read,
+                                                        const uint8_t words_per_sample)
+{
+#if defined(WORDS_BIGENDIAN)
+	return {};
+#else
+	if (words_to_read % words_per_sample) {
+		return {};
+	}
+	const auto num_samples = words_to_read / words_per_sample;
+
+	const auto in_place = sb.dma.chan->PeekRead(words_to_read);
+	if (in_place.size() != num_samples * sizeof(int16_t) ||
+	    reinterpret_cast<uintptr_t>(in_place.data()) % alignof(int16_t)) {
+		return {};
+	}
+	sb.dma.chan->Skip(words_to_read);
+	return {reinterpret_cast<const int16_t*>(in_place.data()), num_samples};
+#endif
+}
+
 static void play_dma_transfer(const uint32_t bytes_requested)
 {
 	// How many bytes should we read from DMA?
@@ -930,7 +969,8 @@ static void play_dma_transfer(const uint32_t bytes_requested)
 
 	auto decode_adpcm_dma =
 	        [&](auto decode_adpcm_fn) -> std::tuple<uint32_t, uint32_t, uint16_t> {
-		const uint32_t num_bytes = read_dma_8bit(bytes_to_read);
+		const auto data          = read_dma_8bit_in_place(bytes_to_read);
+		const auto num_bytes     = check_cast<uint32_t>(data.size());
 		uint32_t num_samples     = 0;
 		uint16_t num_frames      = 0;
 
@@ -938,14 +978,14 @@ static void play_dma_transfer(const uint32_t bytes_requested)
 		uint32_t i = 0;
 		if (num_bytes > 0 && sb.adpcm.haveref) {
 			sb.adpcm.haveref   = false;
-			sb.adpcm.reference = sb.dma.buf.b8[0];
+			sb.adpcm.reference = data[0];
 			sb.adpcm.stepsize  = MinAdaptiveStepSize;
 			++i;
 		}
 		// Decode the remaining DMA buffer into samples using the
 		// provided function
 		while (i < num_bytes) {
-			const auto decoded = decode_adpcm_fn(sb.dma.buf.b8[i]);
+			const auto decoded = decode_adpcm_fn(data[i]);
 			constexpr auto NumDecoded = check_cast<uint8_t>(
 			        decoded.size());
 
@@ -979,7 +1019,18 @@ static void play_dma_transfer(const uint32_t bytes_requested)
 
 	case DmaMode::Pcm8Bit:
 		if (sb.dma.stereo) {
-			bytes_read = read_dma_8bit(bytes_to_read, sb.dma.remain_size);
+			// Without a dangling sample from the last round, the
+			// samples can be used in place
+			const uint8_t* buf = sb.dma.buf.b8;
+			if (sb.dma.remain_size == 0) {
+				const auto data = read_dma_8bit_in_place(bytes_to_read);
+
+				buf        = data.data();
+				bytes_read = check_cast<uint32_t>(data.size());
+			} else {
+				bytes_read = read_dma_8bit(bytes_to_read,
+				                           sb.dma.remain_size);
+			}
 			samples = bytes_read + sb.dma.remain_size;
 			frames  = check_cast<uint16_t>(samples / channels);
 
@@ -988,29 +1039,29 @@ static void play_dma_transfer(const uint32_t bytes_requested)
 			// therefore user-space data.
 			if (frames) {
 				if (sb.dma.sign) {
-					const auto signed_buf = reinterpret_cast<int8_t*>(
-					        sb.dma.buf.b8);
+					const auto signed_buf = reinterpret_cast<const int8_t*>(
+					        buf);
 					sb.chan->AddSamples_s8s(
 					        frames,
 					        maybe_silence(samples, signed_buf));
 				} else {
-					sb.chan->AddSamples_s8(
-					        frames,
-					        maybe_silence(samples,
-					                      sb.dma.buf.b8));
+					sb.chan->AddSamples_s8(frames,
+					                       maybe_silence(samples, buf));
 				}
 			}
 			// Otherwise there's an unhandled dangling sample from
 			// the last round
 			if (samples & 1) {
 				sb.dma.remain_size = 1;
-				sb.dma.buf.b8[0]   = sb.dma.buf.b8[samples - 1];
+				sb.dma.buf.b8[0]   = buf[samples - 1];
 			} else {
 				sb.dma.remain_size = 0;
 			}
 
 		} else { // Mono
-			bytes_read = read_dma_8bit(bytes_to_read);
+			const auto data = read_dma_8bit_in_place(bytes_to_read);
+
+			bytes_read = check_cast<uint32_t>(data.size());
 			samples    = bytes_read;
 			frames     = check_cast<uint16_t>(samples / channels);
 			assert(channels == 1 && frames == samples); // sanity-check
@@ -1019,12 +1070,12 @@ static void play_dma_transfer(const uint32_t bytes_requested)
 				sb.chan->AddSamples_m8s(
 				        frames,
 				        maybe_silence(samples,
-				                      reinterpret_cast<int8_t*>(
-				                              sb.dma.buf.b8)));
+				                      reinterpret_cast<const int8_t*>(
+				                              data.data())));
 			} else {
 				sb.chan->AddSamples_m8(frames,
 				                       maybe_silence(samples,
-				                                     sb.dma.buf.b8));
+				                                     data.data()));
 			}
 		}
 		break;
@@ -1035,9 +1086,24 @@ static void play_dma_transfer(const uint32_t bytes_requested)
 
 	case DmaMode::Pcm16Bit:
 		if (sb.dma.stereo) {
-			bytes_read = read_dma_16bit(bytes_to_read, sb.dma.remain_size);
-			samples = (bytes_read + sb.dma.remain_size) /
-			          dma16_to_sample_divisor;
+			// Without a dangling sample from the last round, the
+			// samples can be used in place
+			const auto in_place = sb.dma.remain_size
+			                            ? std::span<const int16_t>{}
+			                            : read_dma_16bit_in_place(
+			                                      bytes_to_read,
+			                                      dma16_to_sample_divisor);
+			const int16_t* buf = sb.dma.buf.b16;
+			if (!in_place.empty()) {
+				buf     = in_place.data();
+				samples = check_cast<uint32_t>(in_place.size());
+				bytes_read = samples * dma16_to_sample_divisor;
+			} else {
+				bytes_read = read_dma_16bit(bytes_to_read,
+				                            sb.dma.remain_size);
+				samples = (bytes_read + sb.dma.remain_size) /
+				          dma16_to_sample_divisor;
+			}
 			frames = check_cast<uint16_t>(samples / channels);
 
 			// Only add whole frames when in stereo DMA mode
@@ -1046,27 +1112,25 @@ static void play_dma_transfer(const uint32_t bytes_requested)
 				if (sb.dma.sign) {
 					sb.chan->AddSamples_s16_nonnative(
 					        frames,
-					        maybe_silence(samples,
-					                      sb.dma.buf.b16));
+					        maybe_silence(samples, buf));
 				} else {
 					sb.chan->AddSamples_s16u_nonnative(
 					        frames,
 					        maybe_silence(samples,
-					                      reinterpret_cast<uint16_t*>(
-					                              sb.dma.buf.b16)));
+					                      reinterpret_cast<const uint16_t*>(
+					                              buf)));
 				}
 #else
 				if (sb.dma.sign) {
 					sb.chan->AddSamples_s16(
 					        frames,
-					        maybe_silence(samples,
-					                      sb.dma.buf.b16));
+					        maybe_silence(samples, buf));
 				} else {
 					sb.chan->AddSamples_s16u(
 					        frames,
 					        maybe_silence(samples,
-					                      reinterpret_cast<uint16_t*>(
-					                              sb.dma.buf.b16)));
+					                      reinterpret_cast<const uint16_t*>(
+					                              buf)));
 				}
 #endif
 			}
@@ -1074,40 +1138,49 @@ static void play_dma_transfer(const uint32_t bytes_requested)
 				// Carry over the dangling sample into the next
 				// round, or...
 				sb.dma.remain_size = 1;
-				sb.dma.buf.b16[0] = sb.dma.buf.b16[samples - 1];
+				sb.dma.buf.b16[0] = buf[samples - 1];
 			} else {
 				// ...the DMA transfer is done
 				sb.dma.remain_size = 0;
 			}
 		} else { // 16-bit mono
-			bytes_read = read_dma_16bit(bytes_to_read);
-			samples    = bytes_read / dma16_to_sample_divisor;
-			frames     = check_cast<uint16_t>(samples / channels);
+			const auto in_place = read_dma_16bit_in_place(
+			        bytes_to_read, dma16_to_sample_divisor);
+
+			const int16_t* buf = sb.dma.buf.b16;
+			if (!in_place.empty()) {
+				buf     = in_place.data();
+				samples = check_cast<uint32_t>(in_place.size());
+				bytes_read = samples * dma16_to_sample_divisor;
+			} else {
+				bytes_read = read_dma_16bit(bytes_to_read);
+				samples    = bytes_read / dma16_to_sample_divisor;
+			}
+			frames = check_cast<uint16_t>(samples / channels);
 			assert(channels == 1 && frames == samples); // sanity-check
 			                                            // mono
 #if defined(WORDS_BIGENDIAN)
 			if (sb.dma.sign) {
 				sb.chan->AddSamples_m16_nonnative(
 				        frames,
-				        maybe_silence(samples, sb.dma.buf.b16));
+				        maybe_silence(samples, buf));
 			} else {
 				sb.chan->AddSamples_m16u_nonnative(
 				        frames,
 				        maybe_silence(samples,
-				                      reinterpret_cast<uint16_t*>(
-				                              sb.dma.buf.b16)));
+				                      reinterpret_cast<const uint16_t*>(
+				                              buf)));
 			}
 #else
 			if (sb.dma.sign) {
 				sb.chan->AddSamples_m16(frames,
-				                        maybe_silence(samples,
-				                                      sb.dma.buf.b16));
+				                        maybe_silence(samples, buf));
 			} else {
 				sb.chan->AddSamples_m16u(
 				        frames,
 				        maybe_silence(samples,
-				                      reinterpret_cast<uint16_t*>(
-				                              sb.dma.buf.b16)));
+				                      reinterpret_cast<const uint16_t*>(
+				                              buf)));
 			}
 #endif
 		}
@@ -24,7 +24,9 @@
 
 #include "misc_util.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 #include "timer.h"
 
@@ -64,6 +66,9 @@ NETClientSocket* NETClientSocket::NETClientFactory(const SocketType socketType,
 	return nullptr;
 }
 
+void NETClientSocket::SetNoDelay(const bool)
+{}
+
 void NETClientSocket::FlushBuffer()
 {
 	if (sendbufferindex) {
@@ -642,11 +647,61 @@ bool TCPClientSocket::GetRemoteAddressString(char *buffer)
 	return true;
 }
 
+void TCPClientSocket::SetNoDelay(const bool enabled)
+{
+#ifdef NATIVESOCKETS
+	if (!mysock)
+		return;
+
+	// Both SDL_net's sockets and the inherited ones start with the
+	// _TCPsocketX layout
+	const auto channel = reinterpret_cast<_TCPsocketX*>(mysock)->channel;
+	const int flag     = enabled ? 1 : 0;
+	if (setsockopt(channel,
+	               IPPROTO_TCP,
+	               TCP_NODELAY,
+	               reinterpret_cast<const char*>(&flag),
+	               sizeof(flag)) != 0) {
+		LOG_WARNING("SDLNET: Failed to %s Nagle's algorithm on the TCP socket",
+		            enabled ? "disable" : "enable");
+	}
+#else
+	(void)enabled;
+#endif
+}
+
+// Returns false if the connection was closed
+bool TCPClientSocket::FillReceiveBuffer()
+{
+	receive_pos = 0;
+	receive_len = 0;
+	if (!SDLNet_CheckSockets(listensocketset, 0))
+		return true;
+
+	const int result = SDLNet_TCP_Recv(mysock,
+	                                   receive_buffer.data(),
+	                                   static_cast<int>(receive_buffer.size()));
+	if (result < 1) {
+		isopen = false;
+		return false;
+	}
+	receive_len = static_cast<size_t>(result);
+	return true;
+}
+
 bool TCPClientSocket::ReceiveArray(uint8_t *data, size_t &n)
 {
 	assertm(n <= static_cast<size_t>(std::numeric_limits<int>::max()),
 	        "SDL_net can't handle more bytes at a time.");
 	assert(data);
+
+	// Hand out what's left of the last chunk first
+	if (receive_pos < receive_len) {
+		n = std::min(n, receive_len - receive_pos);
+		memcpy(data, receive_buffer.data() + receive_pos, n);
+		receive_pos += n;
+		return true;
+	}
 	if (SDLNet_CheckSockets(listensocketset, 0)) {
 		const int result = SDLNet_TCP_Recv(mysock, data, static_cast<int>(n));
 		if(result < 1) {
@@ -665,17 +720,14 @@ bool TCPClientSocket::ReceiveArray(uint8_t *data, size_t &n)
 
 SocketState TCPClientSocket::GetcharNonBlock(uint8_t &val)
 {
-	SocketState state = SocketState::Empty;
-	if(SDLNet_CheckSockets(listensocketset,0))
-	{
-		if (SDLNet_TCP_Recv(mysock, &val, 1) == 1)
-			state = SocketState::Good;
-		else {
-			isopen = false;
-			state = SocketState::Closed;
-		}
-	}
-	return state;
+	if (receive_pos == receive_len && !FillReceiveBuffer())
+		return SocketState::Closed;
+
+	if (receive_pos == receive_len)
+		return SocketState::Empty;
+
+	val = receive_buffer[receive_pos++];
+	return SocketState::Good;
 }
 
 bool TCPClientSocket::Putchar(uint8_t val)
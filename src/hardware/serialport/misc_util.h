@@ -23,6 +23,7 @@
 
 #if C_MODEM
 
+#include <array>
 #include <vector>
 
 #include "support.h"
@@ -40,6 +41,7 @@
 #include <cstdio>  //darwin
 #include <cstdlib> //darwin
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 // socklen_t should be handled by configure
@@ -97,6 +99,10 @@ public:
 	virtual bool ReceiveArray(uint8_t *data, size_t &n) = 0;
 	virtual bool GetRemoteAddressString(char *buffer) = 0;
 
+	// Disables or enables Nagle's algorithm on stream sockets; a no-op on
+	// the others
+	virtual void SetNoDelay(const bool enabled);
+
 	void FlushBuffer();
 	void SetSendBufferSize(size_t n);
 	bool SendByteBuffered(uint8_t val);
@@ -199,8 +205,10 @@ public:
 	bool SendArray(const uint8_t *data, size_t n) override;
 	bool ReceiveArray(uint8_t *data, size_t &n) override;
 	bool GetRemoteAddressString(char *buffer) override;
+	void SetNoDelay(const bool enabled) override;
 
 private:
+	bool FillReceiveBuffer();
 
 #ifdef NATIVESOCKETS
 	_TCPsocketX *nativetcpstruct = nullptr;
@@ -208,6 +216,13 @@ private:
 
 	TCPsocket mysock = nullptr;
 	SDLNet_SocketSet listensocketset = nullptr;
+
+	// Received data is read in chunks, and handed out from here, so
+	// reading a byte doesn't cost a poll and a receive call each
+	static constexpr size_t ReceiveBufferSize = 4096;
+	std::array<uint8_t, ReceiveBufferSize> receive_buffer = {};
+	size_t receive_pos = 0;
+	size_t receive_len = 0;
 };
 
 class TCPServerSocket : public NETServerSocket {
@@ -79,6 +79,18 @@ CNullModem::CNullModem(const uint8_t port_idx, CommandLine *cmd)
 			tx_gather=12;
 		}
 	}
+	// txsize: How many bytes to gather at most before sending them,
+	// regardless of txdelay.
+	if (getUintFromString("txsize:", tx_buffer_size, cmd)) {
+		if (!(tx_buffer_size > 0 && tx_buffer_size <= 65536)) {
+			tx_buffer_size = 256;
+		}
+	}
+	// nodelay: Send TCP data right away instead of letting Nagle's
+	// algorithm hold back small packets; data is gathered by txdelay.
+	if (getUintFromString("nodelay:", bool_temp, cmd)) {
+		nodelay = (bool_temp == 1);
+	}
 	// port is for both server and client
 	if (getUintFromString("port:", temptcpport, cmd)) {
 		if (!(temptcpport>0&&temptcpport<65536)) {
@@ -210,7 +222,8 @@ bool CNullModem::ClientConnect(NETClientSocket *newsocket)
 		setCD(false);
 		return false;
 	}
-	clientsocket->SetSendBufferSize(256);
+	clientsocket->SetSendBufferSize(tx_buffer_size);
+	clientsocket->SetNoDelay(nodelay);
 	clientsocket->GetRemoteAddressString(peernamebuf);
 	// transmit the line status
 	if (!transparent) setRTSDTR(getRTS(), getDTR());
@@ -248,7 +261,8 @@ bool CNullModem::ServerConnect() {
 	log_ser(dbg_aux, "SERIAL: Port %" PRIu8 " a client (%s) has connected.",
 	        GetPortNumber(), peeripbuf);
 #endif
-	clientsocket->SetSendBufferSize(256);
+	clientsocket->SetSendBufferSize(tx_buffer_size);
+	clientsocket->SetNoDelay(nodelay);
 	rx_state=N_RX_IDLE;
 	setEvent(SERIAL_POLLING_EVENT, 1);
 	
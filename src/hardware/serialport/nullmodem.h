@@ -92,6 +92,11 @@ private:
 	uint32_t tx_gather = 0; // how long to gather tx data before
 	                        // sending all of them [milliseconds]
 
+	uint32_t tx_buffer_size = 256; // how many bytes to gather at most
+	                               // before sending them
+
+	bool nodelay = true; // disable Nagle's algorithm on TCP connections
+
 	bool dtrrespect = false; // dtr behavior - only send data to the serial
 	                         // port when DTR is on
 
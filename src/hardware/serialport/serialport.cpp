@@ -279,7 +279,21 @@ void CSerial::handleEvent(uint16_t type)
 		break;
 
 	case SERIAL_RX_TIMEOUT_EVENT:
-		rise(TIMEOUT_PRIORITY);
+		rx_timeout_event_pending = false;
+		if (rx_timeout_armed) {
+			// The timeout may have been restarted since the event
+			// was scheduled
+			const auto remaining_ms = rx_timeout_deadline -
+			                          PIC_FullIndex();
+			if (remaining_ms > 0.0) {
+				setEvent(SERIAL_RX_TIMEOUT_EVENT,
+				         static_cast<float>(remaining_ms));
+				rx_timeout_event_pending = true;
+			} else {
+				rx_timeout_armed = false;
+				rise(TIMEOUT_PRIORITY);
+			}
+		}
 		break;
 
 	default:
@@ -287,6 +301,28 @@ void CSerial::handleEvent(uint16_t type)
 	}
 }
 
+// The FIFO timeout restarts with every byte received or read, which at high
+// baud rates would remove and schedule a PIC event for every byte. Instead,
+// restarting it only moves its deadline, and the pending event
+// re-schedules itself for the remainder when it fires early.
+void CSerial::startRxTimeout()
+{
+	const auto timeout_ms = bytetime * 4.0f;
+
+	rx_timeout_deadline = PIC_FullIndex() + static_cast<double>(timeout_ms);
+	rx_timeout_armed    = true;
+
+	if (!rx_timeout_event_pending) {
+		setEvent(SERIAL_RX_TIMEOUT_EVENT, timeout_ms);
+		rx_timeout_event_pending = true;
+	}
+}
+
+void CSerial::stopRxTimeout()
+{
+	rx_timeout_armed = false;
+}
+
 /*****************************************************************************/
 /* Interrupt control routines                                               **/
 /*****************************************************************************/
@@ -375,9 +411,12 @@ void CSerial::receiveByteEx(uint8_t data, uint8_t error)
 		// Overrun error ;o
 		error |= LSR_OVERRUN_ERROR_MASK;
 	}
-	removeEvent(SERIAL_RX_TIMEOUT_EVENT);
-	if(rxfifo->getUsage()==rx_interrupt_threshold) rise (RX_PRIORITY);
-	else setEvent(SERIAL_RX_TIMEOUT_EVENT,bytetime*4.0f);
+	if (rxfifo->getUsage() == rx_interrupt_threshold) {
+		stopRxTimeout();
+		rise(RX_PRIORITY);
+	} else {
+		startRxTimeout();
+	}
 
 	if(error) {
 		// A lot of UART chips generate a framing error too when receiving break
@@ -567,8 +606,11 @@ uint32_t CSerial::Read_RHR()
 		clear (TIMEOUT_PRIORITY);
 		// RX int. is cleared if the buffer holds less data than the threshold
 		if(rxfifo->getUsage()<rx_interrupt_threshold)clear(RX_PRIORITY);
-		removeEvent(SERIAL_RX_TIMEOUT_EVENT);
-		if(!rxfifo->isEmpty()) setEvent(SERIAL_RX_TIMEOUT_EVENT,bytetime*4.0f);
+		if (rxfifo->isEmpty()) {
+			stopRxTimeout();
+		} else {
+			startRxTimeout();
+		}
 		return data;
 	}
 }
@@ -1189,6 +1231,12 @@ bool CSerial::getUintFromString(const char *name, uint32_t &data, CommandLine *c
 	return result;
 }
 
+size_t CSerial::GetRxBatchSize() const
+{
+	const auto usage = rxfifo->getUsage();
+	return usage < rx_interrupt_threshold ? rx_interrupt_threshold - usage : 1;
+}
+
 CSerial::~CSerial() {
 	DOS_DelDevice(mydosdevice);
 	for (uint16_t i = 0; i <= SERIAL_BASE_EVENT_COUNT; i++)
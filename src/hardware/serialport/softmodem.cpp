@@ -20,6 +20,7 @@
 
 #if C_MODEM
 
+#include <algorithm>
 #include <cctype>
 #include <cstdlib>
 #include <cstring>
@@ -32,6 +33,7 @@
 #include "softmodem.h"
 #include "math_utils.h"
 #include "misc_util.h"
+#include "pic.h"
 #include "version.h"
 
 class PhonebookEntry {
@@ -177,15 +179,40 @@ void CSerialModem::handleUpperEvent(uint16_t type)
 {
 	switch (type) {
 	case SERIAL_RX_EVENT: {
-		// check for bytes to be sent to port
-		if (CSerial::CanReceiveByte())
-			if (rqueue->inuse() && (CSerial::getRTS() || (flowcontrol != 3))) {
-				uint8_t rbyte = rqueue->getb();
-				// LOG_MSG("SERIAL: Port %" PRIu8 " modem sending byte %2x"
-				//         " back to UART3", GetPortNumber(), rbyte);
-				CSerial::receiveByte(rbyte);
-			}
-		if(CSerial::CanReceiveByte()) setEvent(SERIAL_RX_EVENT, bytetime*0.98f);
+		// Send the bytes that are due to the port, one per byte time
+		// counted from when the line stopped being idle
+		const auto now = PIC_FullIndex();
+		const auto rx_bytetime_ms = static_cast<double>(bytetime) * 0.98;
+
+		auto can_send = [&] {
+			return CSerial::CanReceiveByte() && rqueue->inuse() &&
+			       (CSerial::getRTS() || (flowcontrol != 3));
+		};
+		if (rx_idle) {
+			rx_next_byte_ms = now;
+			rx_idle         = false;
+		}
+		while (can_send() && rx_next_byte_ms <= now) {
+			const auto rbyte = rqueue->getb();
+			// LOG_MSG("SERIAL: Port %" PRIu8 " modem sending byte %2x"
+			//         " back to UART3", GetPortNumber(), rbyte);
+			CSerial::receiveByte(rbyte);
+			rx_next_byte_ms += rx_bytetime_ms;
+		}
+		if (!can_send()) {
+			rx_idle = true;
+		}
+		// Wait for as many bytes as can arrive before the RX interrupt
+		// would be raised, and send them in one go. Once there's nothing
+		// left to send, the polling event restarts us.
+		if (CSerial::CanReceiveByte() && rqueue->inuse()) {
+			const auto batch_size = CSerial::GetRxBatchSize();
+			const auto delay_ms   = std::max(rx_next_byte_ms - now, 0.0) +
+			                      static_cast<double>(batch_size - 1) *
+			                              rx_bytetime_ms;
+			setEvent(SERIAL_RX_EVENT,
+			         static_cast<float>(std::max(delay_ms, rx_bytetime_ms)));
+		}
 		break;
 	}
 	case MODEM_TX_EVENT: {
@@ -884,11 +911,18 @@ void CSerialModem::TelnetEmulation(uint8_t *data, uint32_t size)
 			}
 		}
 		} else {
-			if (c == 0xff) {
+			// Pass the data up to the next IAC through in one go
+			const auto run_start = data + i;
+			const auto iac = static_cast<const uint8_t*>(
+			        memchr(run_start, 0xff, size - i));
+			const auto run_len = static_cast<uint32_t>(
+			        iac ? iac - run_start : size - i);
+			rqueue->adds(run_start, run_len);
+
+			// The loop's increment then steps over the IAC
+			i += run_len;
+			if (iac)
 				telClient.inIAC = true;
-				continue;
-			}
-			rqueue->addb(c);
 		}
 	}
 }
@@ -928,54 +962,69 @@ void CSerialModem::Timer2()
 	// Handle incoming data from serial port, read as much as available
 	CSerial::setCTS(true);	// buffer will get 'emptier', new data can be received
 	while (tqueue->inuse()) {
-		const uint8_t txval = tqueue->getb();
-		if (commandmode) {
-			if (cmdpos < 2) {
-				// Ignore everything until we see "AT" sequence.
-				if (cmdpos == 0 && toupper(txval) != 'A') {
-					continue;
-				}
+		if (!commandmode) {
+			// Take all of the data at once; tmpbuf is as large as the
+			// queue is.
+			const auto chunk = tmpbuf + txbuffersize;
+			const auto len   = tqueue->inuse();
+			tqueue->gets(chunk, len);
+			txbuffersize += len;
+			cmdpause = 0;
 
-				if (cmdpos == 1 && toupper(txval) != 'T') {
-					Echo(reg[MREG_BACKSPACE_CHAR]);
-					cmdpos = 0;
-					continue;
+			// Only a chunk of nothing but escape characters can
+			// continue the escape sequence, anything else resets it
+			const auto esc = reg[MREG_ESCAPE_CHAR];
+			if (std::all_of(chunk, chunk + len, [esc](const uint8_t c) {
+				    return c == esc;
+			    })) {
+				for (uint32_t i = 0; i < len; ++i) {
+					plusinc = (plusinc >= 1 && plusinc <= 3) ? plusinc + 1
+					                                         : 0;
 				}
 			} else {
-				// Now entering command.
-				if (txval == reg[MREG_BACKSPACE_CHAR]) {
-					if (cmdpos > 2) {
-						Echo(txval);
-						cmdpos--;
-					}
-					continue;
-				}
+				plusinc = 0;
+			}
+			continue;
+		}
 
-				if (txval == reg[MREG_LF_CHAR]) {
-					continue; // Real modem doesn't seem to skip this?
-				}
+		// In command mode, go one character at a time
+		const uint8_t txval = tqueue->getb();
+		if (cmdpos < 2) {
+			// Ignore everything until we see "AT" sequence.
+			if (cmdpos == 0 && toupper(txval) != 'A') {
+				continue;
+			}
 
-				if (txval == reg[MREG_CR_CHAR]) {
+			if (cmdpos == 1 && toupper(txval) != 'T') {
+				Echo(reg[MREG_BACKSPACE_CHAR]);
+				cmdpos = 0;
+				continue;
+			}
+		} else {
+			// Now entering command.
+			if (txval == reg[MREG_BACKSPACE_CHAR]) {
+				if (cmdpos > 2) {
 					Echo(txval);
-					DoCommand();
-					continue;
+					cmdpos--;
 				}
+				continue;
 			}
 
-			if (cmdpos < 99) {
-				Echo(txval);
-				cmdbuf[cmdpos] = txval;
-				cmdpos++;
+			if (txval == reg[MREG_LF_CHAR]) {
+				continue; // Real modem doesn't seem to skip this?
 			}
-		} else {
-			if (plusinc >= 1 && plusinc <= 3 && txval == reg[MREG_ESCAPE_CHAR]) // +
-				plusinc++;
-			else {
-				plusinc = 0;
+
+			if (txval == reg[MREG_CR_CHAR]) {
+				Echo(txval);
+				DoCommand();
+				continue;
 			}
-			cmdpause = 0;
-			tmpbuf[txbuffersize] = txval;
-			txbuffersize++;
+		}
+
+		if (cmdpos < 99) {
+			Echo(txval);
+			cmdbuf[cmdpos] = txval;
+			cmdpos++;
 		}
 	} // while loop
 
@@ -989,8 +1038,9 @@ void CSerialModem::Timer2()
 	}
 	// Handle incoming to the serial port
 	if (!commandmode && clientsocket && rqueue->left()) {
-		size_t usesize = rqueue->left() >= 16 ? 16 : rqueue->left();
-		// size_t usesize = 1;
+		// Take as much as the queue can hold; the UART still hands it
+		// to the program at the line rate
+		size_t usesize = rqueue->left();
 		if (!clientsocket->ReceiveArray(tmpbuf, usesize)) {
 			SendRes(ResNOCARRIER);
 			LOG_INFO("SERIAL: No carrier on receive");
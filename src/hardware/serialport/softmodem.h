@@ -23,6 +23,8 @@
 
 #if C_MODEM
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <memory>
 
@@ -110,13 +112,15 @@ public:
 
 		//assert((used + len) <= size);
 		size_t where = pos + used;
+		if (where >= size)
+			where -= size;
 		used += len;
-		while (len--) {
-			if (where >= size)
-				where -= size;
-			//LOG_MSG("+'%x'", *str);
-			data[where++] = *str++;
-		}
+
+		// At most two copies: up to the end of the ring, then the rest
+		// from its start
+		const auto first = std::min(len, size - where);
+		memcpy(data.data() + where, str, first);
+		memcpy(data.data(), str + first, len - first);
 	}
 
 	uint8_t getb()
@@ -149,13 +153,15 @@ public:
 			return;
 		}
 		// assert(used >= len);
+		len = std::min(len, used);
 		used -= len;
-		while (len--) {
-			//LOG_MSG("-%x", data[pos]);
-			*str++ = data[pos];
-			if (++pos >= size)
-				pos -= size;
-		}
+
+		const auto first = std::min(len, size - pos);
+		memcpy(str, data.data() + pos, first);
+		memcpy(str + first, data.data(), len - first);
+		pos += len;
+		if (pos >= size)
+			pos -= size;
 	}
 
 private:
@@ -237,6 +243,10 @@ protected:
 	bool connected = false;
 	uint32_t doresponse = 0;
 	uint8_t waiting_tx_character = 0;
+
+	// When the next byte is due to the port in PIC_FullIndex() time
+	double rx_next_byte_ms = 0.0;
+	bool rx_idle           = true;
 	uint32_t cmdpause = 0;
 	int32_t ringtimer = 0;
 	int32_t ringcount = 0;
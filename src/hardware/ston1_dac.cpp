@@ -48,13 +48,6 @@ void StereoOn1::ConfigureFilters(const FilterState state)
 	channel->SetLowPassFilter(state);
 }
 
-AudioFrame StereoOn1::Render()
-{
-	const float left  = lut_u8to16[stereo_data[0]];
-	const float right = lut_u8to16[stereo_data[1]];
-	return {left, right};
-}
-
 void StereoOn1::WriteData(const io_port_t, const io_val_t data, const io_width_t)
 {
 	data_reg = check_cast<uint8_t>(data);
@@ -73,8 +66,6 @@ uint8_t StereoOn1::ReadStatus(const io_port_t, const io_width_t)
 
 void StereoOn1::WriteControl(const io_port_t, const io_val_t value, const io_width_t)
 {
-	RenderUpToNow();
-
 	const auto new_control = LptControlRegister{check_cast<uint8_t>(value)};
 
 	// Write data to the left channel
@@ -86,4 +77,8 @@ void StereoOn1::WriteControl(const io_port_t, const io_val_t value, const io_wid
 		stereo_data[1] = data_reg;
 
 	control_reg.data = new_control.data;
+
+	const float left  = lut_u8to16[stereo_data[0]];
+	const float right = lut_u8to16[stereo_data[1]];
+	QueueFrame({left, right});
 }
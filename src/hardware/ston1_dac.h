@@ -39,7 +39,6 @@ public:
 	void ConfigureFilters(const FilterState state) final;
 
 protected:
-	AudioFrame Render() final;
 	void WriteData(const io_port_t, const io_val_t value, const io_width_t);
 	uint8_t ReadStatus(const io_port_t, const io_width_t);
 	void WriteControl(const io_port_t, const io_val_t value, const io_width_t);
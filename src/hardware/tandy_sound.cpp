@@ -45,6 +45,7 @@
 #include <array>
 #include <queue>
 #include <string_view>
+#include <vector>
 
 #include "bios.h"
 #include "checks.h"
@@ -148,6 +149,7 @@ private:
 
 	void AudioCallback(const int requested_frames);
 	float RenderSample();
+	void RenderSamples(float* out, const size_t num_samples);
 	void RenderUpToNow();
 	void WriteToPort(io_port_t, io_val_t value, io_width_t);
 
@@ -157,6 +159,10 @@ private:
 	std::unique_ptr<sn76496_base_device> device = {};
 	std::queue<float> fifo                      = {};
 
+	// Scratch buffers of the audio callback's blocks
+	std::vector<int16_t> device_buffer = {};
+	std::vector<float> render_buffer   = {};
+
 	// Static rate-related configuration
 	static constexpr auto RenderDivisor = 16;
 	static constexpr auto RenderRateHz  = ceil_sdivide(TandyPsgClockHz,
@@ -518,7 +524,8 @@ TandyPSG::TandyPSG(const ConfigProfile config_profile,
 	                            ChannelFeature::FadeOut,
 	                            ChannelFeature::ReverbSend,
 	                            ChannelFeature::ChorusSend,
-	                            ChannelFeature::Synthesizer});
+	                            ChannelFeature::Synthesizer,
+	                            ChannelFeature::ParallelRendering});
 
 	// Setup fadeout
 	if (!channel->ConfigureFadeOut(fadeout_choice)) {
@@ -585,6 +592,21 @@ float TandyPSG::RenderSample()
 	return static_cast<float>(sample);
 }
 
+void TandyPSG::RenderSamples(float* out, const size_t num_samples)
+{
+	assert(dsi);
+
+	static device_sound_interface::sound_stream ss;
+
+	// Request the whole block of mono samples from the audio device
+	device_buffer.resize(num_samples);
+	int16_t* buf[] = {device_buffer.data(), nullptr};
+
+	dsi->sound_stream_update(ss, nullptr, buf, check_cast<int>(num_samples));
+
+	std::copy(device_buffer.begin(), device_buffer.end(), out);
+}
+
 void TandyPSG::RenderUpToNow()
 {
 	const auto now = PIC_FullIndex();
@@ -620,20 +642,23 @@ void TandyPSG::AudioCallback(const int requested_frames)
 	}
 #endif
 
-	auto frames_remaining = requested_frames;
+	const auto num_requested = static_cast<size_t>(requested_frames);
+	render_buffer.clear();
 
-	// First, send any frames we've queued since the last callback
-	while (frames_remaining && fifo.size()) {
-		channel->AddSamples_mfloat(1, &fifo.front());
+	// First, take any frames we've queued since the last callback
+	while (render_buffer.size() < num_requested && fifo.size()) {
+		render_buffer.push_back(fifo.front());
 		fifo.pop();
-		--frames_remaining;
 	}
-	// If the queue's run dry, render the remainder and sync-up our time datum
-	while (frames_remaining) {
-		float sample = RenderSample();
-		channel->AddSamples_mfloat(1, &sample);
-		--frames_remaining;
+	// If the queue's run dry, render the remainder in one go and sync-up
+	// our time datum
+	if (const auto num_queued = render_buffer.size(); num_queued < num_requested) {
+		render_buffer.resize(num_requested);
+		RenderSamples(render_buffer.data() + num_queued,
+		              num_requested - num_queued);
 	}
+	channel->AddSamples_mfloat(requested_frames, render_buffer.data());
+
 	last_rendered_ms = PIC_FullIndex();
 }
 
@@ -74,6 +74,10 @@ struct PIT_Block {
 	double delay = 0.0;
 	double start = 0.0;
 
+	// The number of whole periods between the start and the last read of
+	// a periodic mode's counter or output, see get_time_in_period()
+	double num_periods = 0.0;
+
 	uint16_t read_latch = 0;
 	uint16_t write_latch = 0;
 
@@ -193,7 +197,26 @@ static void PIT0_Event(uint32_t /*val*/)
 	}
 }
 
-static bool counter_output(const PIT_Block &channel)
+// Returns fmod(elapsed_ms, channel.delay). Programs that time themselves by
+// the PIT read it many times per period, so the number of whole periods is
+// cached and the time into the period is worked out with a fused multiply-add
+// instead. Whenever the exact result lies within the period it's
+// representable, and the FMA returns it unrounded, matching fmod's exact
+// result. Otherwise the cached number of periods is out of date (the result
+// falls outside the period) and fmod is used to refresh it.
+static double get_time_in_period(PIT_Block &channel, const double elapsed_ms)
+{
+	const auto time_in_period = std::fma(-channel.num_periods,
+	                                     channel.delay,
+	                                     elapsed_ms);
+	if (time_in_period >= 0.0 && time_in_period < channel.delay) {
+		return time_in_period;
+	}
+	channel.num_periods = std::trunc(elapsed_ms / channel.delay);
+	return std::fmod(elapsed_ms, channel.delay);
+}
+
+static bool counter_output(PIT_Block &channel)
 {
 	auto index = PIC_FullIndex() - channel.start;
 	switch (channel.mode) {
@@ -206,13 +229,13 @@ static bool counter_output(const PIT_Block &channel)
 	case PitMode::RateGeneratorAlias:
 		if (channel.mode_changed)
 			return true;
-		index = fmod(index, channel.delay);
+		index = get_time_in_period(channel, index);
 		return index>0;
 	case PitMode::SquareWave:
 	case PitMode::SquareWaveAlias:
 		if (channel.mode_changed)
 			return true;
-		index = fmod(index, channel.delay);
+		index = get_time_in_period(channel, index);
 		return (index * 2 < channel.delay);
 	case PitMode::SoftwareStrobe:
 		// Only low on terminal count
@@ -317,12 +340,12 @@ static void counter_latch(PIT_Block &channel)
 		break;
 	case PitMode::RateGenerator:
 	case PitMode::RateGeneratorAlias:
-		elapsed_ms = fmod(elapsed_ms, channel.delay);
+		elapsed_ms = get_time_in_period(channel, elapsed_ms);
 		save_read_latch(count - (elapsed_ms / channel.delay) * count);
 		break;
 	case PitMode::SquareWave:
 	case PitMode::SquareWaveAlias:
-		elapsed_ms = fmod(elapsed_ms, channel.delay);
+		elapsed_ms = get_time_in_period(channel, elapsed_ms);
 		elapsed_ms *= 2;
 		if (elapsed_ms > channel.delay)
 			elapsed_ms -= channel.delay;
@@ -394,6 +394,11 @@ void VGA_Init(Section* sec)
 {
 	vga.draw.resizing = false;
 	vga.mode          = M_ERROR; // For first init
+
+	const auto section = static_cast<Section_prop*>(sec);
+	assert(section);
+	vga.draw.render_per_scanline = section->Get_bool("vga_render_per_scanline");
+
 	SVGA_Setup_Driver();
 	VGA_SetupMemory(sec);
 	VGA_SetupMisc();
@@ -23,20 +23,26 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cmath>
 #include <cstring>
+#include <optional>
 #include <utility>
+#include <vector>
 
 #include "../gui/render_scalers.h"
 #include "../ints/int10.h"
 #include "bitops.h"
+#include "frame_stats.h"
 #include "math_utils.h"
 #include "mem_unaligned.h"
 #include "pic.h"
 #include "reelmagic.h"
 #include "render.h"
 #include "rgb565.h"
+#include "tracy.h"
 #include "vga.h"
+#include "vga_draw_lines.h"
 #include "video.h"
 
 // #define DEBUG_VGA_DRAW
@@ -212,45 +218,23 @@ static uint8_t *Composite_Process(uint8_t border, uint32_t blocks, bool double_w
 			++i;
 		}
 
-		// Decode
+		// Subtract the chroma from the luma
 		i = temp + 5;
-		i[-1] = (i[-1] << 3) - ap[-1];
-		i[0] = (i[0] << 3) - ap[0];
-
-		uint16_t idx = 0;
-
-		auto composite_convert = [&](const int ii, const int q) {
-			i[1]        = (i[1] << 3) - ap[1];
-			const int c = i[0] + i[0];
-			const int d = i[-1] + i[1];
-
-			const int y = left_shift_signed(c + d, 8) +
-			              vga.composite.sharpness * (c - d);
-
-			const int rr = y + vga.composite.ri * (ii) +
-			               vga.composite.rq * (q);
-
-			const int gg = y + vga.composite.gi * (ii) +
-			               vga.composite.gq * (q);
-
-			const int bb = y + vga.composite.bi * (ii) +
-			               vga.composite.bq * (q);
-			++i;
-			++ap;
-			++bp;
-
-			const auto srgb = (byte_clamp(rr) << 16) |
-			                  (byte_clamp(gg) << 8) | byte_clamp(bb);
+		for (int x = -1; x < w + 1; ++x) {
+			i[x] = (i[x] << 3) - ap[x];
+		}
 
-			write_unaligned_uint32_at(TempLine, idx++, srgb);
-		};
+		// Decode
+		CompositeCoefficients coefficients = {};
+		coefficients.ri        = vga.composite.ri;
+		coefficients.rq        = vga.composite.rq;
+		coefficients.gi        = vga.composite.gi;
+		coefficients.gq        = vga.composite.gq;
+		coefficients.bi        = vga.composite.bi;
+		coefficients.bq        = vga.composite.bq;
+		coefficients.sharpness = vga.composite.sharpness;
 
-		for (uint32_t x = 0; x < blocks; ++x) {
-			composite_convert(ap[0], bp[0]);
-			composite_convert(-bp[0], ap[0]);
-			composite_convert(-ap[0], -bp[0]);
-			composite_convert(bp[0], -ap[0]);
-		}
+		VGA_DecodeCompositeLine(i, ap, bp, blocks * 4, coefficients, TempLine);
 	}
 	return TempLine;
 }
@@ -279,62 +263,26 @@ static uint8_t *VGA_Draw_CGA4_Composite_Line(Bitu vidstart, Bitu line)
 
 static uint8_t * VGA_Draw_4BPP_Line(Bitu vidstart, Bitu line) {
 	const uint8_t *base = vga.tandy.draw_base + ((line & vga.tandy.line_mask) << vga.tandy.line_shift);
-	uint8_t* draw=TempLine;
-	Bitu end = vga.draw.blocks*2;
-	while(end) {
-		uint8_t byte = base[vidstart & vga.tandy.addr_mask];
-		*draw++=vga.attr.palette[byte >> 4];
-		*draw++=vga.attr.palette[byte & 0x0f];
-		++vidstart;
-		--end;
-	}
+	VGA_Expand4BppLine(base,
+	                   vidstart,
+	                   vga.tandy.addr_mask,
+	                   vga.draw.blocks * 2,
+	                   vga.attr.palette,
+	                   TempLine);
 	return TempLine;
 }
 
 static uint8_t * VGA_Draw_4BPP_Line_Double(Bitu vidstart, Bitu line) {
 	const uint8_t *base = vga.tandy.draw_base + ((line & vga.tandy.line_mask) << vga.tandy.line_shift);
-	uint8_t* draw=TempLine;
-	Bitu end = vga.draw.blocks;
-	while(end) {
-		uint8_t byte = base[vidstart & vga.tandy.addr_mask];
-		uint8_t data = vga.attr.palette[byte >> 4];
-		*draw++ = data; *draw++ = data;
-		data = vga.attr.palette[byte & 0x0f];
-		*draw++ = data; *draw++ = data;
-		++vidstart;
-		--end;
-	}
+	VGA_Expand4BppLineDoubled(base,
+	                          vidstart,
+	                          vga.tandy.addr_mask,
+	                          vga.draw.blocks,
+	                          vga.attr.palette,
+	                          TempLine);
 	return TempLine;
 }
 
-#ifdef VGA_KEEP_CHANGES
-static uint8_t * VGA_Draw_Changes_Line(Bitu vidstart, Bitu line) {
-	Bitu checkMask = vga.changes.checkMask;
-	uint8_t *map = vga.changes.map;
-	Bitu start = (vidstart >> VGA_CHANGE_SHIFT);
-	Bitu end = ((vidstart + vga.draw.line_length ) >> VGA_CHANGE_SHIFT);
-	for (; start <= end; ++start) {
-		if ( map[start] & checkMask ) {
-			Bitu offset = vidstart & vga.draw.linear_mask;
-			if (vga.draw.linear_mask-offset < vga.draw.line_length)
-				memcpy(vga.draw.linear_base+vga.draw.linear_mask+1, vga.draw.linear_base, vga.draw.line_length);
-			uint8_t *ret = &vga.draw.linear_base[ offset ];
-#if !defined(C_UNALIGNED_MEMORY)
-			if (((Bitu)ret) & (sizeof(Bitu) - 1)) {
-				memcpy( TempLine, ret, vga.draw.line_length );
-				return TempLine;
-			}
-#endif
-			return ret;
-		}
-	}
-//	memset( TempLine, 0x30, vga.changes.lineWidth );
-//	return TempLine;
-	return 0;
-}
-
-#endif
-
 static uint8_t * VGA_Draw_Linear_Line(Bitu vidstart, Bitu /*line*/) {
 	Bitu offset = vidstart & vga.draw.linear_mask;
 	uint8_t* ret = &vga.draw.linear_base[offset];
@@ -367,6 +315,14 @@ static uint8_t * VGA_Draw_Linear_Line(Bitu vidstart, Bitu /*line*/) {
 	return ret;
 }
 
+// Passes on the raw 8-bit DAC palette indexes, leaving the colour lookup to
+// the output (see GFX_CanLookUpPalette). Screens disabled through the
+// sequencer are blanked with a black palette instead.
+static uint8_t* draw_linear_line_as_indexes(Bitu vidstart, Bitu line)
+{
+	return VGA_Draw_Linear_Line(vidstart, line);
+}
+
 static uint8_t* draw_unwrapped_line_from_dac_palette(Bitu vidstart,
                                                      [[maybe_unused]] const Bitu line = 0)
 {
@@ -377,29 +333,28 @@ static uint8_t* draw_unwrapped_line_from_dac_palette(Bitu vidstart,
 	const auto linear_addr                   = vga.draw.linear_base;
 
 	// Video mode-specific line variables
-	const auto pixels_in_line = static_cast<uint16_t>(vga.draw.line_length /
-	                                                  bytes_per_pixel);
-	const auto video_end = vidstart + pixels_in_line;
+	size_t pixels_remaining = vga.draw.line_length / bytes_per_pixel;
 
 	// The line address is where the RGB888 palettized pixel is written.
-	// It's incremented forward per pixel.
-	auto line_addr = reinterpret_cast<uint32_t*>(TempLine);
+	auto line_addr = TempLine;
 
-	auto linear_pos = vidstart;
+	// This function typically runs on 640+-wide lines and is a rendering
+	// bottleneck, so the line is palettized in runs up to where the linear
+	// address wraps around (if it does at all), instead of masking the
+	// address of every pixel.
+	while (pixels_remaining) {
+		const auto masked_pos     = vidstart & linear_mask;
+		const auto last_in_memory = linear_mask - masked_pos;
 
-	// Draw in batches of four to let the host pipeline deeper.
-	constexpr auto num_repeats = 4;
-	assert(pixels_in_line % num_repeats == 0);
+		const auto run = last_in_memory < pixels_remaining
+		                       ? static_cast<size_t>(last_in_memory) + 1
+		                       : pixels_remaining;
 
-	// This function typically runs on 640+-wide lines and is a rendering
-	// bottleneck.
-	while (linear_pos < video_end) {
-		auto repeats = num_repeats;
-		while (repeats--) {
-			const auto masked_pos    = linear_pos++ & linear_mask;
-			const auto palette_index = *(linear_addr + masked_pos);
-			*line_addr++ = *(palette_map + palette_index);
-		}
+		VGA_PalettizeLine(linear_addr + masked_pos, run, palette_map, line_addr);
+
+		vidstart += run;
+		pixels_remaining -= run;
+		line_addr += run * bytes_per_pixel;
 	}
 
 	return TempLine;
@@ -448,36 +403,18 @@ static uint8_t* draw_linear_line_from_dac_palette(Bitu vidstart, Bitu /*line*/)
 		        vga.draw.line_length - wrapped_len);
 
 		// unwrapped chunk: to top of memory block
-		auto palette_index_end = palette_index_it +
-		                         std::min(unwrapped_len, pixels_remaining);
-		while (palette_index_it != palette_index_end) {
-			memcpy(line_addr,
-			       palette_map + *palette_index_it++,
-			       bytes_per_pixel);
-			line_addr += bytes_per_pixel;
-			--pixels_remaining;
-		}
+		const auto unwrapped_pixels = std::min(unwrapped_len, pixels_remaining);
+		VGA_PalettizeLine(palette_index_it, unwrapped_pixels, palette_map, line_addr);
+		line_addr += unwrapped_pixels * bytes_per_pixel;
+		pixels_remaining -= unwrapped_pixels;
 
 		// wrapped chunk: from the base of the memory block
-		palette_index_it  = vga.draw.linear_base;
-		palette_index_end = palette_index_it +
-		                    std::min(wrapped_len, pixels_remaining);
-		while (palette_index_it != palette_index_end) {
-			memcpy(line_addr,
-			       palette_map + *palette_index_it++,
-			       bytes_per_pixel);
-			line_addr += bytes_per_pixel;
-			--pixels_remaining;
-		}
-
+		VGA_PalettizeLine(vga.draw.linear_base,
+		                  std::min(wrapped_len, pixels_remaining),
+		                  palette_map,
+		                  line_addr);
 	} else {
-		auto palette_index_end = palette_index_it + pixels_remaining;
-		while (palette_index_it != palette_index_end) {
-			memcpy(line_addr,
-			       palette_map + *palette_index_it++,
-			       bytes_per_pixel);
-			line_addr += bytes_per_pixel;
-		}
+		VGA_PalettizeLine(palette_index_it, pixels_remaining, palette_map, line_addr);
 	}
 	return TempLine;
 }
@@ -794,6 +731,148 @@ static uint8_t *VGA_TEXT_Herc_Draw_Line(Bitu vidstart, Bitu line)
 	}
 	return TempLine;
 }
+// Glyph cache of the 8/9-dot wide text modes
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Holds the pixels of the glyph rows drawn recently, keyed by the character,
+// attribute and the glyph's row, so the cells of the same colours and
+// characters (most of a text screen) are copied instead of drawn pixel by
+// pixel.
+//
+// The cache is cleared when anything the glyph pixels depend on changes: the
+// font memory or tables, the 16 palette colours, the blink phase, the
+// underline row, and the 8/9-dot settings. This is checked once per line, as
+// the palette and fonts can be changed mid-frame.
+//
+constexpr size_t GlyphCacheSize = 8192;
+
+struct CachedGlyphRow {
+	// The character, the attribute, the row and the valid flag
+	uint32_t key = 0;
+
+	std::array<Bgrx8888, 9> pixels = {};
+};
+
+struct GlyphCacheState {
+	uint32_t font_generation         = 0;
+	const uint8_t* font_tables[2]    = {nullptr, nullptr};
+	std::array<Bgrx8888, 16> colours = {};
+
+	bool blink                    = false;
+	Bitu blinking                 = 0;
+	uint8_t underline_row         = 0;
+	bool is_eight_dot_mode        = false;
+	bool is_line_graphics_enabled = false;
+
+	bool operator==(const GlyphCacheState& other) const
+	{
+		return font_generation == other.font_generation &&
+		       font_tables[0] == other.font_tables[0] &&
+		       font_tables[1] == other.font_tables[1] &&
+		       colours == other.colours && blink == other.blink &&
+		       blinking == other.blinking &&
+		       underline_row == other.underline_row &&
+		       is_eight_dot_mode == other.is_eight_dot_mode &&
+		       is_line_graphics_enabled == other.is_line_graphics_enabled;
+	}
+};
+
+static struct {
+	std::vector<CachedGlyphRow> rows = std::vector<CachedGlyphRow>(GlyphCacheSize);
+	GlyphCacheState state = {};
+} glyph_cache = {};
+
+static void validate_glyph_cache()
+{
+	GlyphCacheState state = {};
+
+	state.font_generation = vga.draw.font_generation;
+	state.font_tables[0]  = vga.draw.font_tables[0];
+	state.font_tables[1]  = vga.draw.font_tables[1];
+	std::copy_n(std::begin(vga.dac.palette_map),
+	            state.colours.size(),
+	            state.colours.begin());
+
+	state.blink                    = vga.draw.blink;
+	state.blinking                 = vga.draw.blinking;
+	state.underline_row            = vga.crtc.underline_location & 0x1f;
+	state.is_eight_dot_mode        = vga.seq.clocking_mode.is_eight_dot_mode;
+	state.is_line_graphics_enabled = vga.attr.mode_control.is_line_graphics_enabled;
+
+	if (!(state == glyph_cache.state)) {
+		for (auto& row : glyph_cache.rows) {
+			row.key = 0;
+		}
+		glyph_cache.state = state;
+	}
+}
+
+static void draw_glyph_row(const uint8_t chr, const uint8_t attr,
+                           const Bitu line, Bgrx8888* pixels)
+{
+	const auto palette_map = vga.dac.palette_map;
+
+	// the font pattern
+	uint16_t font = vga.draw.font_tables[(attr >> 3) & 1][(chr << 5) + line];
+
+	uint8_t bg_palette_idx = attr >> 4;
+	// if blinking is enabled bit7 is not mapped to attributes
+	if (vga.draw.blinking) {
+		bg_palette_idx &= ~0x8;
+	}
+	// choose foreground color if blinking not set for this cell or
+	// blink on
+	const uint8_t fg_palette_idx = (vga.draw.blink || (attr & 0x80) == 0)
+	                                     ? (attr & 0xf)
+	                                     : bg_palette_idx;
+
+	// underline: all foreground [freevga: 0x77, previous 0x7]
+	if (((attr & 0x77) == 0x01) &&
+	    (vga.crtc.underline_location & 0x1f) == line) {
+		bg_palette_idx = fg_palette_idx;
+	}
+
+	// The font's bits will indicate which color is used per pixel
+	const auto fg_colour = palette_map[fg_palette_idx];
+	const auto bg_colour = palette_map[bg_palette_idx];
+
+	if (vga.seq.clocking_mode.is_eight_dot_mode) {
+		for (auto n = 0; n < 8; ++n) {
+			*pixels++ = (font & 0x80) ? fg_colour : bg_colour;
+			font <<= 1;
+		}
+	} else {
+		font <<= 1; // 9 pixels
+		// Extend to the 9th pixel if needed
+		if ((font & 0x2) && vga.attr.mode_control.is_line_graphics_enabled &&
+		    (chr >= 0xc0) && (chr <= 0xdf)) {
+			font |= 1;
+		}
+		for (auto n = 0; n < 9; ++n) {
+			*pixels++ = (font & 0x100) ? fg_colour : bg_colour;
+			font <<= 1;
+		}
+	}
+}
+
+static const Bgrx8888* get_glyph_row(const uint8_t chr, const uint8_t attr,
+                                     const Bitu line)
+{
+	constexpr uint32_t ValidKey = 1 << 31;
+
+	const auto key = static_cast<uint32_t>(chr | (attr << 8) | (line << 16)) |
+	                 ValidKey;
+
+	// Fibonacci hashing spreads the neighbouring keys over the cache
+	const auto index = ((key * 0x9e3779b1u) >> 19) & (GlyphCacheSize - 1);
+
+	auto& row = glyph_cache.rows[index];
+	if (row.key != key) {
+		draw_glyph_row(chr, attr, line, row.pixels.data());
+		row.key = key;
+	}
+	return row.pixels.data();
+}
+
 // combined 8/9-dot wide text mode line drawing function
 static uint8_t* draw_text_line_from_dac_palette(Bitu vidstart, Bitu line)
 {
@@ -801,6 +880,8 @@ static uint8_t* draw_text_line_from_dac_palette(Bitu vidstart, Bitu line)
 	const uint8_t* vidmem  = VGA_Text_Memwrap(vidstart);
 	const auto palette_map = vga.dac.palette_map;
 
+	validate_glyph_cache();
+
 	auto blocks = vga.draw.blocks;
 	if (vga.draw.panning) {
 		++blocks; // if the text is panned part of an
@@ -811,59 +892,17 @@ static uint8_t* draw_text_line_from_dac_palette(Bitu vidstart, Bitu line)
 	// the console text right (and vice-versa)
 	const uint16_t draw_idx_start = 8 + vga.draw.panning;
 
-	// This holds the to-be-written pixel offset, and is incremented per
-	// pixel and also per character block.
-	auto draw_idx = draw_idx_start;
+	const auto glyph_width = vga.seq.clocking_mode.is_eight_dot_mode ? 8 : 9;
+	const auto glyph_bytes = glyph_width * sizeof(Bgrx8888);
+
+	auto cell_addr = TempLine + draw_idx_start * sizeof(Bgrx8888);
 
 	while (blocks--) { // for each character in the line
 		const auto chr  = *vidmem++;
 		const auto attr = *vidmem++;
-		// the font pattern
-		uint16_t font = vga.draw.font_tables[(attr >> 3) & 1][(chr << 5) + line];
 
-		uint8_t bg_palette_idx = attr >> 4;
-		// if blinking is enabled bit7 is not mapped to attributes
-		if (vga.draw.blinking) {
-			bg_palette_idx &= ~0x8;
-		}
-		// choose foreground color if blinking not set for this cell or
-		// blink on
-		const uint8_t fg_palette_idx = (vga.draw.blink || (attr & 0x80) == 0)
-		                                     ? (attr & 0xf)
-		                                     : bg_palette_idx;
-
-		// underline: all foreground [freevga: 0x77, previous 0x7]
-		if (((attr & 0x77) == 0x01) &&
-		    (vga.crtc.underline_location & 0x1f) == line) {
-			bg_palette_idx = fg_palette_idx;
-		}
-
-		// The font's bits will indicate which color is used per pixel
-		const auto fg_colour = palette_map[fg_palette_idx];
-		const auto bg_colour = palette_map[bg_palette_idx];
-
-		if (vga.seq.clocking_mode.is_eight_dot_mode) {
-			for (auto n = 0; n < 8; ++n) {
-				const auto color = (font & 0x80) ? fg_colour
-				                                 : bg_colour;
-				write_unaligned_uint32_at(TempLine, draw_idx++, color);
-				font <<= 1;
-			}
-		} else {
-			font <<= 1; // 9 pixels
-			// Extend to the 9th pixel if needed
-			if ((font & 0x2) &&
-			    vga.attr.mode_control.is_line_graphics_enabled &&
-			    (chr >= 0xc0) && (chr <= 0xdf)) {
-				font |= 1;
-			}
-			for (auto n = 0; n < 9; ++n) {
-				const auto color = (font & 0x100) ? fg_colour
-				                                  : bg_colour;
-				write_unaligned_uint32_at(TempLine, draw_idx++, color);
-				font <<= 1;
-			}
-		}
+		memcpy(cell_addr, get_glyph_row(chr, attr, line), glyph_bytes);
+		cell_addr += glyph_bytes;
 	}
 	// draw the text mode cursor if needed
 	if (!SkipCursor(vidstart, line)) {
@@ -883,7 +922,7 @@ static uint8_t* draw_text_line_from_dac_palette(Bitu vidstart, Bitu line)
 
 			auto draw_addr = &TempLine[cursor_draw_offset];
 
-			draw_idx = draw_idx_start;
+			auto draw_idx = draw_idx_start;
 			for (uint8_t n = 0; n < 8; ++n) {
 				write_unaligned_uint32_at(draw_addr, draw_idx++, fg_colour);
 			}
@@ -892,23 +931,6 @@ static uint8_t* draw_text_line_from_dac_palette(Bitu vidstart, Bitu line)
 	return TempLine + 32;
 }
 
-#ifdef VGA_KEEP_CHANGES
-static inline void VGA_ChangesEnd(void ) {
-	if ( vga.changes.active ) {
-//		vga.changes.active = false;
-		Bitu end = vga.draw.address >> VGA_CHANGE_SHIFT;
-		Bitu total = 4 + end - vga.changes.start;
-		uint32_t clearMask = vga.changes.clearMask;
-		total >>= 2;
-		uint32_t *clear = (uint32_t *)&vga.changes.map[  vga.changes.start & ~3 ];
-		while ( total-- ) {
-			clear[0] &= clearMask;
-			++clear;
-		}
-	}
-}
-#endif
-
 static void VGA_ProcessSplit()
 {
 	if (vga.attr.mode_control.is_pixel_panning_enabled) {
@@ -931,6 +953,8 @@ static void VGA_ProcessSplit()
 static uint8_t bg_color_index = 0; // screen-off black index
 static void VGA_DrawSingleLine(uint32_t /*blah*/)
 {
+	FrameStageTimer render_timer(FrameStage::Render);
+
 	if (vga.attr.disabled) {
 		switch(machine) {
 		case MCH_PCJR:
@@ -1022,6 +1046,9 @@ static void VGA_DrawSingleLine(uint32_t /*blah*/)
 	}
 	++vga.draw.lines_done;
 	if (vga.draw.split_line==vga.draw.lines_done) VGA_ProcessSplit();
+
+	// The frame's upload and presentation are timed separately
+	render_timer.Stop();
 	if (vga.draw.lines_done < vga.draw.lines_total) {
 		PIC_AddEvent(VGA_DrawSingleLine, vga.draw.delay.per_line_ms);
 	} else RENDER_EndUpdate(false);
@@ -1029,6 +1056,8 @@ static void VGA_DrawSingleLine(uint32_t /*blah*/)
 
 static void VGA_DrawEGASingleLine(uint32_t /*blah*/)
 {
+	FrameStageTimer render_timer(FrameStage::Render);
+
 	if (vga.attr.disabled) {
 		std::fill(templine_buffer.begin(), templine_buffer.end(), 0);
 		ReelMagic_RENDER_DrawLine(TempLine);
@@ -1046,41 +1075,287 @@ static void VGA_DrawEGASingleLine(uint32_t /*blah*/)
 	}
 	++vga.draw.lines_done;
 	if (vga.draw.split_line==vga.draw.lines_done) VGA_ProcessSplit();
+
+	// The frame's upload and presentation are timed separately
+	render_timer.Stop();
 	if (vga.draw.lines_done < vga.draw.lines_total) {
 		PIC_AddEvent(VGA_DrawEGASingleLine, vga.draw.delay.per_line_ms);
 	} else RENDER_EndUpdate(false);
 }
 
+// Skipping unchanged lines
+// ~~~~~~~~~~~~~~~~~~~~~~~~
+// In the planar EGA and chained or unchained VGA modes, all writes to the
+// video memory go through the page handlers, which mark the blocks they
+// write to in vga.changes. If a line is read from the same address as when
+// it was last drawn, and none of its blocks have been written since, the
+// scaler gets nullptr for it instead: this skips both drawing the line and
+// the scaler's comparison against its cached copy.
+//
+// The SVGA modes map the video memory (and the linear frame buffer) into the
+// host address space, so their writes run at RAM speed but aren't seen by
+// any handler; nor are the writes of the S3 accelerator. Their lines are
+// hashed instead, and skipped if both their address and hash match the last
+// drawn ones. Hashing reads each line once, which is still cheaper than
+// drawing it and the scaler comparing it.
+//
+enum class LineTracking { None, WrittenBlocks, LineHashes };
+
+static struct {
+	// The address and hash each line of the scaler cache was drawn from
+	std::vector<Bitu> line_addresses = {};
+	std::vector<uint64_t> line_hashes = {};
+
+	// The hash of the line being drawn, if it was hashed
+	std::optional<uint64_t> drawn_line_hash = {};
+
+	// The palette and screen state the cached lines were drawn with
+	std::array<Bgrx8888, ARRAY_LEN(vga.dac.palette_map)> palette_map = {};
+	bool is_screen_disabled = false;
+
+	LineTracking tracking = LineTracking::None;
+} line_changes = {};
+
+constexpr auto UncachedLine = ~static_cast<Bitu>(0);
+
+static void invalidate_cached_lines()
+{
+	std::fill(line_changes.line_addresses.begin(),
+	          line_changes.line_addresses.end(),
+	          UncachedLine);
+}
+
+static bool is_palettized_line_handler()
+{
+	return VGA_DrawLine == draw_linear_line_from_dac_palette ||
+	       VGA_DrawLine == draw_unwrapped_line_from_dac_palette;
+}
+
+static LineTracking get_line_tracking()
+{
+	if (VGA_DrawLine != draw_linear_line_from_dac_palette &&
+	    VGA_DrawLine != draw_unwrapped_line_from_dac_palette &&
+	    VGA_DrawLine != draw_linear_line_as_indexes &&
+	    VGA_DrawLine != VGA_Draw_Linear_Line) {
+		return LineTracking::None;
+	}
+	// The mixed lines also depend on the MPEG picture
+	if (ReelMagic_IsVideoMixerEnabled()) {
+		return LineTracking::None;
+	}
+	// The S3 accelerator writes the video memory directly
+	if (svgaCard == SVGA_S3Trio && (vga.s3.ext_mem_ctrl & 0x10)) {
+		return LineTracking::LineHashes;
+	}
+	switch (vga.mode) {
+	case M_EGA: return LineTracking::WrittenBlocks;
+	case M_VGA:
+		// The chain-4 handler marks the fastmem addresses, and non
+		// chain-4 chained modes are host-mapped
+		return (!vga.config.chained || vga.draw.linear_base == vga.fastmem)
+		             ? LineTracking::WrittenBlocks
+		             : LineTracking::LineHashes;
+	case M_LIN4:
+	case M_LIN8:
+	case M_LIN15:
+	case M_LIN16:
+	case M_LIN24:
+	case M_LIN32: return LineTracking::LineHashes;
+	default: return LineTracking::None;
+	}
+}
+
+static void start_line_change_tracking()
+{
+	auto& changes = vga.changes;
+	std::swap(changes.written, changes.previous);
+	std::fill(changes.written.begin(), changes.written.end(), 0);
+
+	// Only the palettized lines depend on the palette and the screen
+	// state, the indexed ones leave both to the renderer
+	const auto is_palettized = is_palettized_line_handler();
+
+	const auto& palette_map = vga.dac.palette_map;
+	const auto palette_changed = is_palettized &&
+	                             !std::equal(std::begin(palette_map),
+	                                         std::end(palette_map),
+	                                         line_changes.palette_map.begin());
+
+	const bool is_screen_disabled = is_palettized &&
+	                                vga.seq.clocking_mode.is_screen_disabled;
+
+	const auto previous_tracking = line_changes.tracking;
+	line_changes.tracking        = get_line_tracking();
+
+	if (line_changes.tracking != previous_tracking ||
+	    line_changes.tracking == LineTracking::None || palette_changed ||
+	    is_screen_disabled != line_changes.is_screen_disabled) {
+		invalidate_cached_lines();
+		std::copy(std::begin(palette_map),
+		          std::end(palette_map),
+		          line_changes.palette_map.begin());
+		line_changes.is_screen_disabled = is_screen_disabled;
+	}
+	line_changes.line_addresses.resize(vga.draw.lines_total, UncachedLine);
+	line_changes.line_hashes.resize(vga.draw.lines_total);
+}
+
+static bool are_blocks_written(const Bitu first, const Bitu last)
+{
+	const auto& changes = vga.changes;
+	for (auto block = first; block <= last; ++block) {
+		if (changes.written[block] | changes.previous[block]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Every single changed 8-byte word changes the hash, as each step is a
+// bijection, and the four lanes let the multiplies overlap
+static uint64_t hash_line_bytes(const uint8_t* data, size_t num_bytes)
+{
+	constexpr uint64_t Prime = 0x9e3779b97f4a7c15;
+
+	auto mix = [](const uint64_t hash, const uint64_t word) {
+		return (std::rotl(hash, 23) ^ word) * Prime;
+	};
+
+	uint64_t lanes[4] = {1, 2, 3, 4};
+	for (; num_bytes >= sizeof(lanes); num_bytes -= sizeof(lanes)) {
+		for (auto& lane : lanes) {
+			uint64_t word = 0;
+			memcpy(&word, data, sizeof(word));
+			lane = mix(lane, word);
+			data += sizeof(word);
+		}
+	}
+	auto hash = lanes[0] ^ std::rotl(lanes[1], 16) ^ std::rotl(lanes[2], 32) ^
+	            std::rotl(lanes[3], 48);
+	while (num_bytes--) {
+		hash = mix(hash, *data++);
+	}
+	return hash;
+}
+
+static bool is_line_unchanged(const Bitu line, const Bitu address)
+{
+	line_changes.drawn_line_hash = {};
+
+	if (line_changes.tracking == LineTracking::None ||
+	    line >= line_changes.line_addresses.size() || !RENDER_IsCachingLines()) {
+		return false;
+	}
+
+	// The DAC palette variants palettize each source byte into a 32-bit
+	// pixel
+	const auto num_bytes = is_palettized_line_handler()
+	                             ? vga.draw.line_length / sizeof(uint32_t)
+	                             : vga.draw.line_length;
+	if (num_bytes == 0) {
+		return false;
+	}
+
+	const auto mask  = vga.draw.linear_mask;
+	const auto start = address & mask;
+	const auto end   = start + num_bytes - 1;
+
+	if (line_changes.tracking == LineTracking::LineHashes) {
+		// The rare lines wrapping around the end of the memory are
+		// always drawn
+		if (end > mask) {
+			return false;
+		}
+		const auto hash = hash_line_bytes(vga.draw.linear_base + start, num_bytes);
+		line_changes.drawn_line_hash = hash;
+
+		return line_changes.line_addresses[line] == address &&
+		       line_changes.line_hashes[line] == hash &&
+		       RENDER_CanSkipUnchangedLine();
+	}
+
+	if (line_changes.line_addresses[line] != address ||
+	    !RENDER_CanSkipUnchangedLine()) {
+		return false;
+	}
+	if (end <= mask) {
+		return !are_blocks_written(start >> VGA_CHANGE_SHIFT,
+		                           end >> VGA_CHANGE_SHIFT);
+	}
+	// The line wraps around the end of the memory
+	return !are_blocks_written(start >> VGA_CHANGE_SHIFT,
+	                           mask >> VGA_CHANGE_SHIFT) &&
+	       !are_blocks_written(0, (end & mask) >> VGA_CHANGE_SHIFT);
+}
+
+static void track_drawn_line(const Bitu line, const Bitu address)
+{
+	if (line >= line_changes.line_addresses.size()) {
+		return;
+	}
+	const auto is_hashed = (line_changes.tracking == LineTracking::LineHashes);
+
+	if (!RENDER_IsCachingLines() || (is_hashed && !line_changes.drawn_line_hash)) {
+		line_changes.line_addresses[line] = UncachedLine;
+		return;
+	}
+	line_changes.line_addresses[line] = address;
+	if (is_hashed) {
+		line_changes.line_hashes[line] = *line_changes.drawn_line_hash;
+	}
+}
+
+// The indexed lines can't be painted black while the screen is disabled, so
+// the renderer gets a black palette instead. It's resent every frame while
+// blanked, as DAC writes keep updating the renderer's palette.
+static void update_indexed_screen_blanking()
+{
+	static bool is_blanked = false;
+
+	const bool should_blank = (VGA_DrawLine == draw_linear_line_as_indexes) &&
+	                          vga.seq.clocking_mode.is_screen_disabled;
+	if (!should_blank && !is_blanked) {
+		return;
+	}
+	for (auto i = 0; i < NumVgaColors; ++i) {
+		const auto index  = static_cast<uint8_t>(i);
+		const auto colour = should_blank ? Bgrx8888() : vga.dac.palette_map[i];
+		RENDER_SetPalette(index, colour.Red8(), colour.Green8(), colour.Blue8());
+	}
+	is_blanked = should_blank;
+}
+
 static void VGA_DrawPart(uint32_t lines)
 {
+	ZoneScoped;
+	FrameStageTimer render_timer(FrameStage::Render);
+
 	while (lines--) {
-		uint8_t * data=VGA_DrawLine( vga.draw.address, vga.draw.address_line );
-		ReelMagic_RENDER_DrawLine(data);
+		const auto line = vga.draw.lines_done;
+		if (is_line_unchanged(line, vga.draw.address)) {
+			ReelMagic_RENDER_DrawLine(nullptr);
+		} else {
+			uint8_t * data=VGA_DrawLine( vga.draw.address, vga.draw.address_line );
+			ReelMagic_RENDER_DrawLine(data);
+			track_drawn_line(line, vga.draw.address);
+		}
 		++vga.draw.address_line;
 		if (vga.draw.address_line>=vga.draw.address_line_total) {
 			vga.draw.address_line=0;
 			vga.draw.address+=vga.draw.address_add;
 		}
 		++vga.draw.lines_done;
-		if (vga.draw.split_line==vga.draw.lines_done) {
-#ifdef VGA_KEEP_CHANGES
-			VGA_ChangesEnd( );
-#endif
-			VGA_ProcessSplit();
-#ifdef VGA_KEEP_CHANGES
-			vga.changes.start = vga.draw.address >> VGA_CHANGE_SHIFT;
-#endif
-		}
+		if (vga.draw.split_line==vga.draw.lines_done) VGA_ProcessSplit();
 	}
+
+	// The frame's upload and presentation are timed separately
+	render_timer.Stop();
 	if (--vga.draw.parts_left) {
 		PIC_AddEvent(VGA_DrawPart, vga.draw.delay.parts,
 		             (vga.draw.parts_left != 1)
 		                     ? vga.draw.parts_lines
 		                     : (vga.draw.lines_total - vga.draw.lines_done));
 	} else {
-#ifdef VGA_KEEP_CHANGES
-		VGA_ChangesEnd();
-#endif
 		RENDER_EndUpdate(false);
 	}
 }
@@ -1104,29 +1379,6 @@ void VGA_SetBlinking(const uint8_t enabled)
 	}
 }
 
-#ifdef VGA_KEEP_CHANGES
-static void inline VGA_ChangesStart( void ) {
-	vga.changes.start = vga.draw.address >> VGA_CHANGE_SHIFT;
-	vga.changes.last = vga.changes.start;
-	if ( vga.changes.lastAddress != vga.draw.address ) {
-//		LOG_MSG("Address");
-		VGA_DrawLine = VGA_Draw_Linear_Line;
-		vga.changes.lastAddress = vga.draw.address;
-	} else if ( render.fullFrame ) {
-//		LOG_MSG("Full Frame");
-		VGA_DrawLine = VGA_Draw_Linear_Line;
-	} else {
-//		LOG_MSG("Changes");
-		VGA_DrawLine = VGA_Draw_Changes_Line;
-	}
-	vga.changes.active = true;
-	vga.changes.checkMask = vga.changes.writeMask;
-	vga.changes.clearMask = ~( 0x01010101 << (vga.changes.frame & 7));
-	++vga.changes.frame;
-	vga.changes.writeMask = 1 << (vga.changes.frame & 7);
-}
-#endif
-
 static void VGA_VertInterrupt(uint32_t /*val*/)
 {
 	if ((!vga.draw.vret_triggered) &&
@@ -1158,6 +1410,9 @@ static void VGA_PanningLatch(uint32_t /*val*/)
 
 static void VGA_VerticalTimer(uint32_t /*val*/)
 {
+	// Emulated frames, next to the host's presented frames
+	FrameMarkNamed("Vertical retrace");
+
 	vga.draw.delay.framestart = PIC_FullIndex();
 	PIC_AddEvent(VGA_VerticalTimer, vga.draw.delay.vtotal);
 
@@ -1196,7 +1451,12 @@ static void VGA_VerticalTimer(uint32_t /*val*/)
 	//Check if we can actually render, else skip the rest (frameskip)
 	++vga.draw.cursor.count; // Do this here, else the cursor speed depends
 	                         // on the frameskip
-	if (vga.draw.vga_override || !ReelMagic_RENDER_StartUpdate()) {
+	if (vga.draw.vga_override) {
+		return;
+	}
+	update_indexed_screen_blanking();
+	if (RENDER_ShouldSkipFrame(vga.draw.delay.vtotal) ||
+	    !ReelMagic_RENDER_StartUpdate()) {
 		return;
 	}
 
@@ -1218,9 +1478,6 @@ static void VGA_VerticalTimer(uint32_t /*val*/)
 		++vga.draw.split_line; // EGA adds one buggy scanline
 	}
 //	if (machine==MCH_EGA) vga.draw.split_line = ((((vga.config.line_compare&0x5ff)+1)*2-1)/vga.draw.lines_scaled);
-#ifdef VGA_KEEP_CHANGES
-	bool startaddr_changed=false;
-#endif
 	switch (vga.mode) {
 	case M_EGA:
 		if (!(vga.crtc.mode_control.map_display_address_13)) {
@@ -1234,9 +1491,6 @@ static void VGA_VerticalTimer(uint32_t /*val*/)
 		vga.draw.address += vga.draw.bytes_skip;
 		vga.draw.address *= vga.draw.byte_panning_shift;
 		if (machine!=MCH_EGA) vga.draw.address += vga.draw.panning;
-#ifdef VGA_KEEP_CHANGES
-		startaddr_changed=true;
-#endif
 		break;
 	case M_VGA:
 		if (vga.config.compatible_chain4 && (vga.crtc.underline_location & 0x40)) {
@@ -1256,9 +1510,6 @@ static void VGA_VerticalTimer(uint32_t /*val*/)
 		vga.draw.address += vga.draw.bytes_skip;
 		vga.draw.address *= vga.draw.byte_panning_shift;
 		vga.draw.address += vga.draw.panning;
-#ifdef VGA_KEEP_CHANGES
-		startaddr_changed=true;
-#endif
 		break;
 	case M_TEXT:
 		vga.draw.byte_panning_shift = 2;
@@ -1296,10 +1547,6 @@ static void VGA_VerticalTimer(uint32_t /*val*/)
 	if (vga.draw.split_line == 0) {
 		VGA_ProcessSplit();
 	}
-#ifdef VGA_KEEP_CHANGES
-	if (startaddr_changed) VGA_ChangesStart();
-#endif
-
 	// check if some lines at the top off the screen are blanked
 	double draw_skip = 0.0;
 	if (vga.draw.vblank_skip) {
@@ -1317,6 +1564,7 @@ static void VGA_VerticalTimer(uint32_t /*val*/)
 		}
 		vga.draw.lines_done = 0;
 		vga.draw.parts_left = vga.draw.parts_total;
+		start_line_change_tracking();
 		PIC_AddEvent(VGA_DrawPart, vga.draw.delay.parts + draw_skip, vga.draw.parts_lines);
 		break;
 	case DRAWLINE:
@@ -1452,11 +1700,7 @@ PixelFormat VGA_ActivateHardwareCursor()
 // A single point to set total drawn lines and update affected delay values
 static void setup_line_drawing_delays(const uint32_t total_lines)
 {
-	const auto conf    = control->GetSection("dosbox");
-	const auto section = static_cast<Section_prop*>(conf);
-	assert(section);
-
-	if (vga.draw.mode == PART && !section->Get_bool("vga_render_per_scanline")) {
+	if (vga.draw.mode == PART && !vga.draw.render_per_scanline) {
 		// Render the screen in 4 parts; this was the legacy DOSBox behaviour.
 		// A few games needs this (e.g., Deus, Ishar 3, Robinson's Requiem,
 		// Time Travelers) and would crash at startup with per-scanline
@@ -1548,12 +1792,16 @@ struct DisplayTimings {
 	uint32_t blanking_end   = 0;
 	uint32_t retrace_start  = 0;
 	uint32_t retrace_end    = 0;
+
+	bool operator==(const DisplayTimings&) const = default;
 };
 
 struct VgaTimings {
 	uint32_t clock        = 0;
 	DisplayTimings horiz  = {};
 	DisplayTimings vert   = {};
+
+	bool operator==(const VgaTimings&) const = default;
 };
 
 // This function reads various VGA registers to calculate the display timings,
@@ -1741,12 +1989,12 @@ struct UpdatedTimings {
 	uint32_t vblank_skip       = 0;
 };
 
-static UpdatedTimings update_vga_timings(const VgaTimings& timings)
+static UpdatedTimings calculate_vga_delays(const VgaTimings& timings,
+                                           const double fps)
 {
 	const auto vert  = timings.vert;
 	const auto horiz = timings.horiz;
 
-	const auto fps     = VGA_GetPreferredRate();
 	const auto f_clock = fps * vert.total * horiz.total;
 
 	// Horizontal total (that's how long a line takes with whistles and bells)
@@ -1842,6 +2090,46 @@ static UpdatedTimings update_vga_timings(const VgaTimings& timings)
 	return {horiz_display_end, vert_display_end, vblank_skip};
 }
 
+// The drawing is set up again on every CRTC and mode register write that
+// might affect it, but the timings rarely change between these, so the delays
+// of the last timings and refresh rate are reused if they're still the same.
+static UpdatedTimings update_vga_timings(const VgaTimings& timings)
+{
+	static struct {
+		bool is_valid                  = false;
+		VgaTimings timings             = {};
+		double fps                     = 0.0;
+		decltype(vga.draw.delay) delay = {};
+		UpdatedTimings result          = {};
+	} last = {};
+
+	const auto fps = VGA_GetPreferredRate();
+
+	auto& delay = vga.draw.delay;
+
+	if (last.is_valid && last.timings == timings && last.fps == fps) {
+		delay.htotal    = last.delay.htotal;
+		delay.hblkstart = last.delay.hblkstart;
+		delay.hblkend   = last.delay.hblkend;
+		delay.hrstart   = last.delay.hrstart;
+		delay.hrend     = last.delay.hrend;
+		delay.vblkstart = last.delay.vblkstart;
+		delay.vblkend   = last.delay.vblkend;
+		delay.vrstart   = last.delay.vrstart;
+		delay.vrend     = last.delay.vrend;
+		delay.vdend     = last.delay.vdend;
+		return last.result;
+	}
+
+	last.result   = calculate_vga_delays(timings, fps);
+	last.timings  = timings;
+	last.fps      = fps;
+	last.delay    = delay;
+	last.is_valid = true;
+
+	return last.result;
+}
+
 static bool is_vga_scan_doubling_bit_set()
 {
 	// Scan doubling on VGA can be achieved in two ways:
@@ -2248,9 +2536,13 @@ ImageInfo setup_drawing()
 			// The ReelMagic video mixer expects linear VGA drawing
 			// (i.e.: Return to Zork's house intro), so limit the use
 			// of 18-bit palettized LUT routine to non-mixed output.
-			pixel_format = PixelFormat::BGRX32_ByteArray;
+			if (GFX_CanLookUpPalette()) {
+				VGA_DrawLine = draw_linear_line_as_indexes;
+			} else {
+				pixel_format = PixelFormat::BGRX32_ByteArray;
 
-			VGA_DrawLine = draw_linear_line_from_dac_palette;
+				VGA_DrawLine = draw_linear_line_from_dac_palette;
+			}
 		} else {
 			VGA_DrawLine = VGA_Draw_Linear_Line;
 		}
@@ -2347,7 +2639,9 @@ ImageInfo setup_drawing()
 			        render_width, render_height, double_width, double_height);
 		}
 
-		if (IS_VGA_ARCH) {
+		if (IS_VGA_ARCH && GFX_CanLookUpPalette()) {
+			VGA_DrawLine = draw_linear_line_as_indexes;
+		} else if (IS_VGA_ARCH) {
 			pixel_format = PixelFormat::BGRX32_ByteArray;
 
 			VGA_DrawLine = draw_linear_line_from_dac_palette;
@@ -2859,11 +3153,8 @@ ImageInfo setup_drawing()
 	vga.draw.line_length = render_width *
 	                       ((get_bits_per_pixel(pixel_format) + 1) / 8);
 
-#ifdef VGA_KEEP_CHANGES
-	vga.changes.active    = false;
-	vga.changes.frame     = 0;
-	vga.changes.writeMask = 1;
-#endif
+	// Any reconfiguration can change the drawn pixels
+	invalidate_cached_lines();
 
 #ifdef DEBUG_VGA_DRAW
 	LOG_DEBUG("VGA: horiz.total: %d, vert.total: %d",
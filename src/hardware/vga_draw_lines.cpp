@@ -0,0 +1,450 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "vga_draw_lines.h"
+
+#include <cstring>
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define VGA_DRAW_NEON 1
+#include <arm_neon.h>
+#else
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VGA_DRAW_SSSE3 1
+#include <tmmintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VGA_DRAW_SSE2 1
+#include <emmintrin.h>
+#endif
+#endif
+
+// Kernels working on a contiguous run of source bytes
+using expand_kernel_f = void (*)(const uint8_t* src, size_t num_bytes,
+                                 const uint8_t* palette, uint8_t* out);
+
+static void expand_4bpp_scalar(const uint8_t* src, size_t num_bytes,
+                               const uint8_t* palette, uint8_t* out)
+{
+	while (num_bytes--) {
+		const auto byte = *src++;
+		*out++ = palette[byte >> 4];
+		*out++ = palette[byte & 0x0f];
+	}
+}
+
+static void expand_4bpp_doubled_scalar(const uint8_t* src, size_t num_bytes,
+                                       const uint8_t* palette, uint8_t* out)
+{
+	while (num_bytes--) {
+		const auto byte = *src++;
+		out[0] = out[1] = palette[byte >> 4];
+		out[2] = out[3] = palette[byte & 0x0f];
+		out += 4;
+	}
+}
+
+#if VGA_DRAW_NEON
+// The 16 palette entries fit a single table register, so each lookup of 16
+// nibbles is one TBL instruction, and the interleaving stores put the high
+// and low nibbles' pixels back in order.
+static void expand_4bpp_neon(const uint8_t* src, size_t num_bytes,
+                             const uint8_t* palette, uint8_t* out)
+{
+	const auto table       = vld1q_u8(palette);
+	const auto low_nibbles = vdupq_n_u8(0x0f);
+
+	for (; num_bytes >= 16; num_bytes -= 16, src += 16, out += 32) {
+		const auto bytes = vld1q_u8(src);
+
+		uint8x16x2_t pixels = {};
+		pixels.val[0] = vqtbl1q_u8(table, vshrq_n_u8(bytes, 4));
+		pixels.val[1] = vqtbl1q_u8(table, vandq_u8(bytes, low_nibbles));
+		vst2q_u8(out, pixels);
+	}
+	expand_4bpp_scalar(src, num_bytes, palette, out);
+}
+
+static void expand_4bpp_doubled_neon(const uint8_t* src, size_t num_bytes,
+                                     const uint8_t* palette, uint8_t* out)
+{
+	const auto table       = vld1q_u8(palette);
+	const auto low_nibbles = vdupq_n_u8(0x0f);
+
+	for (; num_bytes >= 16; num_bytes -= 16, src += 16, out += 64) {
+		const auto bytes = vld1q_u8(src);
+		const auto high  = vqtbl1q_u8(table, vshrq_n_u8(bytes, 4));
+		const auto low   = vqtbl1q_u8(table, vandq_u8(bytes, low_nibbles));
+
+		const uint8x16x4_t pixels = {{high, high, low, low}};
+		vst4q_u8(out, pixels);
+	}
+	expand_4bpp_doubled_scalar(src, num_bytes, palette, out);
+}
+#endif
+
+#if VGA_DRAW_SSSE3
+// PSHUFB looks up 16 nibbles in the 16-entry palette at once
+__attribute__((target("ssse3"))) static void expand_4bpp_ssse3(
+        const uint8_t* src, size_t num_bytes, const uint8_t* palette, uint8_t* out)
+{
+	const auto table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(palette));
+	const auto low_nibbles = _mm_set1_epi8(0x0f);
+
+	for (; num_bytes >= 16; num_bytes -= 16, src += 16, out += 32) {
+		const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		const auto high = _mm_shuffle_epi8(
+		        table, _mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibbles));
+		const auto low = _mm_shuffle_epi8(table,
+		                                  _mm_and_si128(bytes, low_nibbles));
+
+		const auto out_pt = reinterpret_cast<__m128i*>(out);
+		_mm_storeu_si128(out_pt, _mm_unpacklo_epi8(high, low));
+		_mm_storeu_si128(out_pt + 1, _mm_unpackhi_epi8(high, low));
+	}
+	expand_4bpp_scalar(src, num_bytes, palette, out);
+}
+
+__attribute__((target("ssse3"))) static void expand_4bpp_doubled_ssse3(
+        const uint8_t* src, size_t num_bytes, const uint8_t* palette, uint8_t* out)
+{
+	const auto table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(palette));
+	const auto low_nibbles = _mm_set1_epi8(0x0f);
+
+	for (; num_bytes >= 16; num_bytes -= 16, src += 16, out += 64) {
+		const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		const auto high = _mm_shuffle_epi8(
+		        table, _mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibbles));
+		const auto low = _mm_shuffle_epi8(table,
+		                                  _mm_and_si128(bytes, low_nibbles));
+
+		// Interleave the pixels, then double them
+		const auto first  = _mm_unpacklo_epi8(high, low);
+		const auto second = _mm_unpackhi_epi8(high, low);
+
+		const auto out_pt = reinterpret_cast<__m128i*>(out);
+		_mm_storeu_si128(out_pt, _mm_unpacklo_epi8(first, first));
+		_mm_storeu_si128(out_pt + 1, _mm_unpackhi_epi8(first, first));
+		_mm_storeu_si128(out_pt + 2, _mm_unpacklo_epi8(second, second));
+		_mm_storeu_si128(out_pt + 3, _mm_unpackhi_epi8(second, second));
+	}
+	expand_4bpp_doubled_scalar(src, num_bytes, palette, out);
+}
+
+static bool host_has_ssse3()
+{
+	static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+	return has_ssse3;
+}
+#endif
+
+static expand_kernel_f get_expand_4bpp_kernel()
+{
+#if VGA_DRAW_NEON
+	return expand_4bpp_neon;
+#elif VGA_DRAW_SSSE3
+	return host_has_ssse3() ? expand_4bpp_ssse3 : expand_4bpp_scalar;
+#else
+	return expand_4bpp_scalar;
+#endif
+}
+
+static expand_kernel_f get_expand_4bpp_doubled_kernel()
+{
+#if VGA_DRAW_NEON
+	return expand_4bpp_doubled_neon;
+#elif VGA_DRAW_SSSE3
+	return host_has_ssse3() ? expand_4bpp_doubled_ssse3
+	                        : expand_4bpp_doubled_scalar;
+#else
+	return expand_4bpp_doubled_scalar;
+#endif
+}
+
+// Splits the line into the runs between the wraps of the masked address and
+// expands each run with the kernel
+static void expand_wrapped_line(const expand_kernel_f kernel,
+                                const uint8_t* base, Bitu start,
+                                const Bitu addr_mask, size_t num_bytes,
+                                const uint8_t* palette, uint8_t* out,
+                                const size_t pixels_per_byte)
+{
+	while (num_bytes) {
+		const auto pos          = start & addr_mask;
+		const auto last_in_mask = addr_mask - pos;
+
+		const auto run = last_in_mask < num_bytes
+		                       ? static_cast<size_t>(last_in_mask) + 1
+		                       : num_bytes;
+
+		kernel(base + pos, run, palette, out);
+
+		start += run;
+		num_bytes -= run;
+		out += run * pixels_per_byte;
+	}
+}
+
+void VGA_Expand4BppLine(const uint8_t* base, const Bitu start,
+                        const Bitu addr_mask, const size_t num_bytes,
+                        const uint8_t* palette, uint8_t* out)
+{
+	constexpr size_t PixelsPerByte = 2;
+	expand_wrapped_line(get_expand_4bpp_kernel(),
+	                    base,
+	                    start,
+	                    addr_mask,
+	                    num_bytes,
+	                    palette,
+	                    out,
+	                    PixelsPerByte);
+}
+
+void VGA_Expand4BppLineDoubled(const uint8_t* base, const Bitu start,
+                               const Bitu addr_mask, const size_t num_bytes,
+                               const uint8_t* palette, uint8_t* out)
+{
+	constexpr size_t PixelsPerByte = 4;
+	expand_wrapped_line(get_expand_4bpp_doubled_kernel(),
+	                    base,
+	                    start,
+	                    addr_mask,
+	                    num_bytes,
+	                    palette,
+	                    out,
+	                    PixelsPerByte);
+}
+
+// Neither SSE nor NEON can gather from a 256-entry table of 32-bit colours
+// faster than scalar loads, so this is left to the compiler's scheduling:
+// the loads are independent, and the stores compile to plain moves.
+void VGA_PalettizeLine(const uint8_t* indexes, size_t num_pixels,
+                       const Bgrx8888* palette_map, uint8_t* out)
+{
+	constexpr auto BytesPerPixel = sizeof(uint32_t);
+
+	while (num_pixels--) {
+		const uint32_t colour = palette_map[*indexes++];
+		memcpy(out, &colour, BytesPerPixel);
+		out += BytesPerPixel;
+	}
+}
+
+static uint8_t composite_clamp(const int v)
+{
+	const auto shifted = v >> 13;
+	return shifted < 0 ? 0u : (shifted > 255 ? 255u : static_cast<uint8_t>(shifted));
+}
+
+// The chroma's phase turns by 90 degrees every pixel, so the I and Q
+// components of the pixel are (a, b), (-b, a), (-a, -b) and (b, -a) in turn.
+// The products wrap around like the vector multiplies do.
+static void decode_composite_scalar(const int* luma, const int* chroma_a,
+                                    const int* chroma_b, const size_t first,
+                                    const size_t num_pixels,
+                                    const CompositeCoefficients& co, uint8_t* out)
+{
+	auto mul = [](const int a, const int b) {
+		return static_cast<int>(static_cast<uint32_t>(a) *
+		                        static_cast<uint32_t>(b));
+	};
+
+	for (auto p = first; p < num_pixels; ++p) {
+		const auto a = chroma_a[p];
+		const auto b = chroma_b[p];
+
+		int i = 0;
+		int q = 0;
+		switch (p & 3) {
+		case 0: i = a, q = b; break;
+		case 1: i = -b, q = a; break;
+		case 2: i = -a, q = -b; break;
+		default: i = b, q = -a; break;
+		}
+
+		const auto c = luma[p] + luma[p];
+		const auto d = luma[p - 1] + luma[p + 1];
+		const auto y = static_cast<int>(static_cast<uint32_t>(c + d) << 8) +
+		               mul(co.sharpness, c - d);
+
+		const auto rr = y + mul(co.ri, i) + mul(co.rq, q);
+		const auto gg = y + mul(co.gi, i) + mul(co.gq, q);
+		const auto bb = y + mul(co.bi, i) + mul(co.bq, q);
+
+		const uint32_t colour = (composite_clamp(rr) << 16) |
+		                        (composite_clamp(gg) << 8) |
+		                        composite_clamp(bb);
+		memcpy(out + p * sizeof(colour), &colour, sizeof(colour));
+	}
+}
+
+// The vector kernels decode four pixels at a time, with each lane's I and Q
+// coefficients signed for the lane's chroma phase: the even lanes take I from
+// 'a' and Q from 'b', and the odd lanes the other way around.
+#if VGA_DRAW_NEON
+static void decode_composite_neon(const int* luma, const int* chroma_a,
+                                  const int* chroma_b, const size_t num_pixels,
+                                  const CompositeCoefficients& co, uint8_t* out)
+{
+	const int32_t i_signs[4] = {1, -1, -1, 1};
+	const int32_t q_signs[4] = {1, 1, -1, -1};
+
+	auto lane_coefficients = [](const int32_t value, const int32_t* signs) {
+		const int32_t lanes[4] = {value * signs[0], value * signs[1],
+		                          value * signs[2], value * signs[3]};
+		return vld1q_s32(lanes);
+	};
+	const auto ri = lane_coefficients(co.ri, i_signs);
+	const auto rq = lane_coefficients(co.rq, q_signs);
+	const auto gi = lane_coefficients(co.gi, i_signs);
+	const auto gq = lane_coefficients(co.gq, q_signs);
+	const auto bi = lane_coefficients(co.bi, i_signs);
+	const auto bq = lane_coefficients(co.bq, q_signs);
+
+	const auto sharpness = vdupq_n_s32(co.sharpness);
+
+	const uint32_t odd_lanes[4] = {0, ~0u, 0, ~0u};
+	const auto is_odd_lane      = vld1q_u32(odd_lanes);
+
+	size_t p = 0;
+	for (; p + 4 <= num_pixels; p += 4) {
+		const auto a = vld1q_s32(chroma_a + p);
+		const auto b = vld1q_s32(chroma_b + p);
+		const auto i = vbslq_s32(is_odd_lane, b, a);
+		const auto q = vbslq_s32(is_odd_lane, a, b);
+
+		const auto c = vaddq_s32(vld1q_s32(luma + p), vld1q_s32(luma + p));
+		const auto d = vaddq_s32(vld1q_s32(luma + p - 1),
+		                         vld1q_s32(luma + p + 1));
+		const auto y = vmlaq_s32(vshlq_n_s32(vaddq_s32(c, d), 8),
+		                         sharpness,
+		                         vsubq_s32(c, d));
+
+		auto channel = [&](const int32x4_t ci, const int32x4_t cq) {
+			const auto v = vmlaq_s32(vmlaq_s32(y, ci, i), cq, q);
+			return vqmovn_s32(vshrq_n_s32(v, 13));
+		};
+		const auto rr = channel(ri, rq);
+		const auto gg = channel(gi, gq);
+		const auto bb = channel(bi, bq);
+
+		// The saturating narrowings clamp to 0..255
+		const auto br = vqmovun_s16(vcombine_s16(bb, rr));
+		const auto g0 = vqmovun_s16(vcombine_s16(gg, vdup_n_s16(0)));
+
+		// Interleave into B, G, R, X
+		const auto bg_rx  = vzip_u8(br, g0);
+		const auto pixels = vzip_u16(vreinterpret_u16_u8(bg_rx.val[0]),
+		                             vreinterpret_u16_u8(bg_rx.val[1]));
+		vst1q_u8(out + p * 4,
+		         vreinterpretq_u8_u16(vcombine_u16(pixels.val[0], pixels.val[1])));
+	}
+	decode_composite_scalar(luma, chroma_a, chroma_b, p, num_pixels, co, out);
+}
+#endif
+
+#if VGA_DRAW_SSE2
+// SSE2 has no 32-bit multiply keeping the low halves, so the even and odd
+// lanes are multiplied separately
+static __m128i mullo_epi32_sse2(const __m128i a, const __m128i b)
+{
+	const auto even = _mm_mul_epu32(a, b);
+	const auto odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static void decode_composite_sse2(const int* luma, const int* chroma_a,
+                                  const int* chroma_b, const size_t num_pixels,
+                                  const CompositeCoefficients& co, uint8_t* out)
+{
+	// Lanes are listed from the last to the first
+	auto i_lanes = [](const int32_t value) {
+		return _mm_set_epi32(value, -value, -value, value);
+	};
+	auto q_lanes = [](const int32_t value) {
+		return _mm_set_epi32(-value, -value, value, value);
+	};
+	const auto ri = i_lanes(co.ri);
+	const auto rq = q_lanes(co.rq);
+	const auto gi = i_lanes(co.gi);
+	const auto gq = q_lanes(co.gq);
+	const auto bi = i_lanes(co.bi);
+	const auto bq = q_lanes(co.bq);
+
+	const auto sharpness   = _mm_set1_epi32(co.sharpness);
+	const auto is_odd_lane = _mm_set_epi32(-1, 0, -1, 0);
+
+	auto load = [](const int* pt) {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pt));
+	};
+	auto select = [](const __m128i mask, const __m128i a, const __m128i b) {
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	};
+
+	size_t p = 0;
+	for (; p + 4 <= num_pixels; p += 4) {
+		const auto a = load(chroma_a + p);
+		const auto b = load(chroma_b + p);
+		const auto i = select(is_odd_lane, b, a);
+		const auto q = select(is_odd_lane, a, b);
+
+		const auto c = _mm_add_epi32(load(luma + p), load(luma + p));
+		const auto d = _mm_add_epi32(load(luma + p - 1), load(luma + p + 1));
+		const auto y = _mm_add_epi32(_mm_slli_epi32(_mm_add_epi32(c, d), 8),
+		                             mullo_epi32_sse2(sharpness,
+		                                              _mm_sub_epi32(c, d)));
+
+		auto channel = [&](const __m128i ci, const __m128i cq) {
+			const auto v = _mm_add_epi32(_mm_add_epi32(y, mullo_epi32_sse2(ci, i)),
+			                             mullo_epi32_sse2(cq, q));
+			return _mm_srai_epi32(v, 13);
+		};
+		const auto rr = channel(ri, rq);
+		const auto gg = channel(gi, gq);
+		const auto bb = channel(bi, bq);
+
+		// The saturating packs clamp to 0..255, giving the bytes
+		// B0-B3, R0-R3, G0-G3 and four zeros
+		const auto bytes = _mm_packus_epi16(_mm_packs_epi32(bb, rr),
+		                                    _mm_packs_epi32(gg, _mm_setzero_si128()));
+
+		// Interleave into B, G, R, X
+		const auto bg_rx = _mm_unpacklo_epi8(bytes, _mm_srli_si128(bytes, 8));
+		const auto pixels = _mm_unpacklo_epi16(bg_rx, _mm_srli_si128(bg_rx, 8));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + p * 4), pixels);
+	}
+	decode_composite_scalar(luma, chroma_a, chroma_b, p, num_pixels, co, out);
+}
+#endif
+
+void VGA_DecodeCompositeLine(const int* luma, const int* chroma_a,
+                             const int* chroma_b, const size_t num_pixels,
+                             const CompositeCoefficients& coefficients,
+                             uint8_t* out)
+{
+#if VGA_DRAW_NEON
+	decode_composite_neon(luma, chroma_a, chroma_b, num_pixels, coefficients, out);
+#elif VGA_DRAW_SSE2
+	decode_composite_sse2(luma, chroma_a, chroma_b, num_pixels, coefficients, out);
+#else
+	decode_composite_scalar(luma, chroma_a, chroma_b, 0, num_pixels, coefficients, out);
+#endif
+}
@@ -0,0 +1,77 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_VGA_DRAW_LINES_H
+#define DOSBOX_VGA_DRAW_LINES_H
+
+#include "dosbox.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bgrx8888.h"
+
+// Pixel expansion kernels of the VGA line handlers
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The 16-colour palette lookups are vectorised: with NEON on 64-bit Arm
+// hosts, and with SSSE3 on x86 hosts when the CPU supports it (checked at
+// runtime, as SSSE3 isn't part of the x86-64 baseline). The composite decoder
+// uses NEON or SSE2. Everything else uses the portable scalar code, which
+// produces the same output.
+
+// Expands 4-bit packed pixels (two per byte, high nibble first) into one
+// palette index per pixel. The source bytes are read from 'base' starting at
+// 'start', with the address wrapped by 'addr_mask'.
+void VGA_Expand4BppLine(const uint8_t* base, Bitu start, Bitu addr_mask,
+                        size_t num_bytes, const uint8_t* palette, uint8_t* out);
+
+// Same as VGA_Expand4BppLine, but writes every pixel twice
+void VGA_Expand4BppLineDoubled(const uint8_t* base, Bitu start, Bitu addr_mask,
+                               size_t num_bytes, const uint8_t* palette,
+                               uint8_t* out);
+
+// Looks up the colours of 8-bit palette indexes, writing 'num_pixels' BGRX8888
+// pixels to 'out' (which doesn't need to be aligned)
+void VGA_PalettizeLine(const uint8_t* indexes, size_t num_pixels,
+                       const Bgrx8888* palette_map, uint8_t* out);
+
+// The coefficients of the CGA composite decoder, see 'vga.composite'
+struct CompositeCoefficients {
+	int32_t ri = 0;
+	int32_t rq = 0;
+	int32_t gi = 0;
+	int32_t gq = 0;
+	int32_t bi = 0;
+	int32_t bq = 0;
+
+	int32_t sharpness = 0;
+};
+
+// Decodes 'num_pixels' pixels of a composite colour line into BGRX8888
+// pixels. 'luma' holds the samples with the chroma already subtracted, and
+// has to be readable from index -1 to 'num_pixels'. 'chroma_a' and
+// 'chroma_b' hold the demodulated chroma of each pixel, whose phase turns by
+// 90 degrees from pixel to pixel.
+void VGA_DecodeCompositeLine(const int* luma, const int* chroma_a,
+                             const int* chroma_b, size_t num_pixels,
+                             const CompositeCoefficients& coefficients,
+                             uint8_t* out);
+
+#endif
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "cpu.h"
+#include "host_memory.h"
 #include "inout.h"
 #include "mem.h"
 #include "mem_host.h"
@@ -52,12 +53,19 @@
 #define CHECKED4(v) ((v)&((vga.vmemwrap>>2)-1))
 
 
-#ifdef VGA_KEEP_CHANGES
-#define MEM_CHANGED( _MEM ) vga.changes.map[ (_MEM) >> VGA_CHANGE_SHIFT ] |= vga.changes.writeMask;
-//#define MEM_CHANGED( _MEM ) vga.changes.map[ (_MEM) >> VGA_CHANGE_SHIFT ] = 1;
-#else
-#define MEM_CHANGED( _MEM ) 
-#endif
+// Marks the blocks covering the written bytes; writes never span more than
+// two of them
+static inline void mem_changed(const uint32_t start, const uint32_t num_bytes)
+{
+	auto& written = vga.changes.written;
+
+	const auto first = start >> VGA_CHANGE_SHIFT;
+	const auto last  = (start + num_bytes - 1) >> VGA_CHANGE_SHIFT;
+	if (last < written.size()) {
+		written[first] = 1;
+		written[last]  = 1;
+	}
+}
 
 #define TANDY_VIDBASE(_X_)  &MemBase[ 0x80000 + (_X_)]
 
@@ -108,6 +116,46 @@ inline static uint32_t ModeOperation(uint8_t val) {
 	return full;
 }
 
+// Computes the planes written by each byte of a word or dword write. The
+// write mode and its registers are the same for all the bytes, so the common
+// cases are decided once per write instead of per byte: the latch copies of
+// write mode 1, and the write mode 0 writes storing the host data as it is
+// (no rotation, set/reset, logical operation or bit mask, e.g. in mode X).
+template <size_t NumBytes>
+inline static void mode_operations(const uint32_t val, uint32_t (&data)[NumBytes])
+{
+	const auto& config = vga.config;
+
+	if (config.write_mode == 0x01) {
+		for (auto& planes : data) {
+			planes = vga.latch.d;
+		}
+		return;
+	}
+	if (config.write_mode == 0x00 && config.data_rotate == 0 &&
+	    config.raster_op == 0x00 && config.full_bit_mask == 0xffffffff &&
+	    config.full_not_enable_set_reset == 0xffffffff) {
+		for (size_t i = 0; i < NumBytes; ++i) {
+			data[i] = ExpandTable[(val >> (i * 8)) & 0xff];
+		}
+		return;
+	}
+	for (size_t i = 0; i < NumBytes; ++i) {
+		data[i] = ModeOperation(static_cast<uint8_t>(val >> (i * 8)));
+	}
+}
+
+// Writes the data to the planes enabled by the map mask, returning the
+// resulting planes
+inline static uint32_t write_planes(const PhysPt start, const uint32_t data)
+{
+	auto& planes = reinterpret_cast<uint32_t*>(vga.mem.linear)[start];
+
+	planes = (planes & vga.config.full_not_map_mask) |
+	         (data & vga.config.full_map_mask);
+	return planes;
+}
+
 /* Gonna assume that whoever maps vga memory, maps it on 32/64kb boundary */
 
 #define VGA_PAGES		(128/4)
@@ -229,7 +277,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED(addr);
-		MEM_CHANGED( addr << 3);
+		mem_changed(addr << 3, 8);
 		writeHandler(addr+0,(uint8_t)(val >> 0));
 	}
 
@@ -239,7 +287,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED(addr);
-		MEM_CHANGED( addr << 3);
+		mem_changed(addr << 3, 16);
 		writeHandler(addr+0,(uint8_t)(val >> 0));
 		writeHandler(addr+1,(uint8_t)(val >> 8));
 	}
@@ -250,7 +298,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED(addr);
-		MEM_CHANGED( addr << 3);
+		mem_changed(addr << 3, 32);
 		writeHandler(addr+0,(uint8_t)(val >> 0));
 		writeHandler(addr+1,(uint8_t)(val >> 8));
 		writeHandler(addr+2,(uint8_t)(val >> 16));
@@ -292,13 +340,25 @@ public:
 class VGA_UnchainedEGA_Handler : public VGA_UnchainedRead_Handler {
 public:
 	void writeHandler(PhysPt start, uint8_t val) {
-		uint32_t data=ModeOperation(val);
 		/* Update video memory and the pixel buffer */
+		updatePixels(start, write_planes(start, ModeOperation(val)));
+	}
+
+	template <size_t NumBytes>
+	void writeHandlers(PhysPt start, uint32_t val)
+	{
+		uint32_t data[NumBytes];
+		mode_operations(val, data);
+
+		for (size_t i = 0; i < NumBytes; ++i) {
+			updatePixels(start + i, write_planes(start + i, data[i]));
+		}
+	}
+
+	void updatePixels(PhysPt start, uint32_t planes)
+	{
 		VgaLatch pixels;
-		pixels.d=((uint32_t*)vga.mem.linear)[start];
-		pixels.d&=vga.config.full_not_map_mask;
-		pixels.d|=(data & vga.config.full_map_mask);
-		((uint32_t*)vga.mem.linear)[start]=pixels.d;
+		pixels.d = planes;
 		uint8_t * write_pixels=&vga.fastmem[start<<3];
 
 		uint32_t colors0_3, colors4_7;
@@ -329,7 +389,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED2(addr);
-		MEM_CHANGED( addr << 3);
+		mem_changed(addr << 3, 8);
 		writeHandler(addr+0,(uint8_t)(val >> 0));
 	}
 
@@ -339,9 +399,8 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED2(addr);
-		MEM_CHANGED( addr << 3);
-		writeHandler(addr+0,(uint8_t)(val >> 0));
-		writeHandler(addr+1,(uint8_t)(val >> 8));
+		mem_changed(addr << 3, 16);
+		writeHandlers<2>(addr, val);
 	}
 
 	void writed(PhysPt addr, uint32_t val) override
@@ -350,11 +409,8 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED2(addr);
-		MEM_CHANGED( addr << 3);
-		writeHandler(addr+0,(uint8_t)(val >> 0));
-		writeHandler(addr+1,(uint8_t)(val >> 8));
-		writeHandler(addr+2,(uint8_t)(val >> 16));
-		writeHandler(addr+3,(uint8_t)(val >> 24));
+		mem_changed(addr << 3, 32);
+		writeHandlers<4>(addr, val);
 	}
 };
 
@@ -474,7 +530,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED(addr);
-		MEM_CHANGED( addr );
+		mem_changed(addr, 1);
 		writeHandler_byte(addr, val);
 		writeCache_byte(addr, val);
 	}
@@ -485,8 +541,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED(addr);
-		MEM_CHANGED( addr );
-//		MEM_CHANGED( addr + 1);
+		mem_changed(addr, 2);
 		if (addr & 1) {
 			writeHandler_byte(addr + 0, val >> 0);
 			writeHandler_byte(addr + 1, val >> 8);
@@ -502,8 +557,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED(addr);
-		MEM_CHANGED( addr );
-//		MEM_CHANGED( addr + 3);
+		mem_changed(addr, 4);
 		if (addr & 3) {
 			writeHandler_byte(addr + 0, val >> 0);
 			writeHandler_byte(addr + 1, val >> 8);
@@ -519,15 +573,21 @@ public:
 class VGA_UnchainedVGA_Handler final : public VGA_UnchainedRead_Handler {
 public:
 	void writeHandler( PhysPt addr, uint8_t val ) {
-		uint32_t data=ModeOperation(val);
-		VgaLatch pixels;
-		pixels.d=((uint32_t*)vga.mem.linear)[addr];
-		pixels.d&=vga.config.full_not_map_mask;
-		pixels.d|=(data & vga.config.full_map_mask);
-		((uint32_t*)vga.mem.linear)[addr]=pixels.d;
+		write_planes(addr, ModeOperation(val));
 //		if(vga.config.compatible_chain4)
 //			((uint32_t*)vga.mem.linear)[CHECKED2(addr+64*1024)]=pixels.d; 
 	}
+
+	template <size_t NumBytes>
+	void writeHandlers(PhysPt addr, uint32_t val)
+	{
+		uint32_t data[NumBytes];
+		mode_operations(val, data);
+
+		for (size_t i = 0; i < NumBytes; ++i) {
+			write_planes(addr + i, data[i]);
+		}
+	}
 public:
 	VGA_UnchainedVGA_Handler()  {
 		flags=PFLAG_NOCODE;
@@ -539,7 +599,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED2(addr);
-		MEM_CHANGED( addr << 2 );
+		mem_changed(addr << 2, 4);
 		writeHandler(addr+0,(uint8_t)(val >> 0));
 	}
 
@@ -549,9 +609,8 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED2(addr);
-		MEM_CHANGED( addr << 2);
-		writeHandler(addr+0,(uint8_t)(val >> 0));
-		writeHandler(addr+1,(uint8_t)(val >> 8));
+		mem_changed(addr << 2, 8);
+		writeHandlers<2>(addr, val);
 	}
 
 	void writed(PhysPt addr, uint32_t val) override
@@ -560,11 +619,8 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED2(addr);
-		MEM_CHANGED( addr << 2);
-		writeHandler(addr+0,(uint8_t)(val >> 0));
-		writeHandler(addr+1,(uint8_t)(val >> 8));
-		writeHandler(addr+2,(uint8_t)(val >> 16));
-		writeHandler(addr+3,(uint8_t)(val >> 24));
+		mem_changed(addr << 2, 16);
+		writeHandlers<4>(addr, val);
 	}
 };
 
@@ -574,6 +630,14 @@ public:
 		flags=PFLAG_NOCODE;
 	}
 
+	static void write_font(const PhysPt addr, const uint8_t val)
+	{
+		if (vga.draw.font[addr] != val) {
+			vga.draw.font[addr] = val;
+			++vga.draw.font_generation;
+		}
+	}
+
 	uint8_t readb(PhysPt addr) override
 	{
 		read_delay();
@@ -596,10 +660,10 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 
 		if (vga.seq.map_mask == 0x4) {
-			vga.draw.font[addr] = val;
+			write_font(addr, val);
 		} else {
 			if (vga.seq.map_mask & 0x4) // font map
-				vga.draw.font[addr] = val;
+				write_font(addr, val);
 			if (vga.seq.map_mask & 0x2) // character attribute
 				vga.mem.linear[CHECKED3(vga.svga.bank_read_full +
 				                        addr + 1)] = val;
@@ -662,7 +726,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED(addr);
-		MEM_CHANGED( addr );
+		mem_changed(addr, 1);
 		host_writeb(&vga.mem.linear[addr], val);
 	}
 
@@ -672,7 +736,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED(addr);
-		MEM_CHANGED(addr);
+		mem_changed(addr, 2);
 		host_writew_at(vga.mem.linear, addr, val);
 	}
 
@@ -682,7 +746,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) & vgapages.mask;
 		addr += vga.svga.bank_write_full;
 		addr = CHECKED(addr);
-		MEM_CHANGED(addr);
+		mem_changed(addr, 4);
 		host_writed_at(vga.mem.linear, addr, val);
 	}
 };
@@ -697,7 +761,7 @@ public:
 		write_delay();
 		addr = vga.svga.bank_write_full + (PAGING_GetPhysicalAddress(addr) & 0xffff);
 		addr = CHECKED4(addr);
-		MEM_CHANGED( addr << 3 );
+		mem_changed(addr << 3, 8);
 		writeHandler(addr+0,(uint8_t)(val >> 0));
 	}
 
@@ -706,9 +770,8 @@ public:
 		write_delay();
 		addr = vga.svga.bank_write_full + (PAGING_GetPhysicalAddress(addr) & 0xffff);
 		addr = CHECKED4(addr);
-		MEM_CHANGED( addr << 3 );
-		writeHandler(addr+0,(uint8_t)(val >> 0));
-		writeHandler(addr+1,(uint8_t)(val >> 8));
+		mem_changed(addr << 3, 16);
+		writeHandlers<2>(addr, val);
 	}
 
 	void writed(PhysPt addr, uint32_t val) override
@@ -716,11 +779,8 @@ public:
 		write_delay();
 		addr = vga.svga.bank_write_full + (PAGING_GetPhysicalAddress(addr) & 0xffff);
 		addr = CHECKED4(addr);
-		MEM_CHANGED( addr << 3 );
-		writeHandler(addr+0,(uint8_t)(val >> 0));
-		writeHandler(addr+1,(uint8_t)(val >> 8));
-		writeHandler(addr+2,(uint8_t)(val >> 16));
-		writeHandler(addr+3,(uint8_t)(val >> 24));
+		mem_changed(addr << 3, 32);
+		writeHandlers<4>(addr, val);
 	}
 
 	uint8_t readb(PhysPt addr) override
@@ -789,7 +849,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) - vga.lfb.addr;
 		addr = CHECKED(addr);
 		host_writeb(&vga.mem.linear[addr], val);
-		MEM_CHANGED( addr );
+		mem_changed(addr, 1);
 	}
 
 	void writew(PhysPt addr, uint16_t val) override
@@ -798,7 +858,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) - vga.lfb.addr;
 		addr = CHECKED(addr);
 		host_writew_at(vga.mem.linear, addr, val);
-		MEM_CHANGED( addr );
+		mem_changed(addr, 2);
 	}
 
 	void writed(PhysPt addr, uint32_t val) override
@@ -807,7 +867,7 @@ public:
 		addr = PAGING_GetPhysicalAddress(addr) - vga.lfb.addr;
 		addr = CHECKED(addr);
 		host_writed_at(vga.mem.linear, addr, val);
-		MEM_CHANGED( addr );
+		mem_changed(addr, 4);
 	}
 };
 
@@ -965,14 +1025,22 @@ static struct vg {
 	VGA_Empty_Handler empty = {};
 } vgaph;
 
-void VGA_ChangedBank(void) {
-#ifndef VGA_LFB_MAPPED
-	//If the mode is accurate than the correct mapper must have been installed already
-	if ( vga.mode >= M_LIN4 && vga.mode <= M_LIN32 ) {
+// A bank switch only moves the window into video memory, the handlers of the
+// window stay the same. They look up the bank on every access, so only the
+// pages linked straight to the host memory of the old bank need unlinking.
+void VGA_ChangedBank()
+{
+	const auto bank_read_full  = vga.svga.bank_read * vga.svga.bank_size;
+	const auto bank_write_full = vga.svga.bank_write * vga.svga.bank_size;
+
+	if (bank_read_full == vga.svga.bank_read_full &&
+	    bank_write_full == vga.svga.bank_write_full) {
 		return;
 	}
-#endif
-	VGA_SetupHandlers();
+	vga.svga.bank_read_full  = bank_read_full;
+	vga.svga.bank_write_full = bank_write_full;
+
+	PAGING_UnlinkPhysPages(VGA_PAGE_A0, 32);
 }
 
 void VGA_SetupHandlers(void) {
@@ -1131,12 +1199,21 @@ void VGA_StartUpdateLFB(void) {
 	MEM_SetLFB(vga.lfb.page, vga.vmemsize / 4096, vga.lfb.handler, &vgaph.mmio);
 }
 
+// Host memory backing the video memory
+static ZeroedBuffer linear_buffer  = {};
+static ZeroedBuffer fastmem_buffer = {};
+
+static TrackedHostMemory tracked_linear_buffer{HostMemoryUse::VideoMemory};
+static TrackedHostMemory tracked_fastmem_buffer{HostMemoryUse::VideoMemory};
+
+void VGA_ClearMemory()
+{
+	linear_buffer.Clear();
+	fastmem_buffer.Clear();
+}
+
 static void VGA_Memory_ShutDown(Section * /*sec*/) {
-#ifdef VGA_KEEP_CHANGES
-	delete[] vga.changes.map;
-	vga.mem.linear = {};
-	vga.fastmem    = {};
-#endif
+	vga.changes = {};
 }
 
 static uint32_t determine_vmem_delay_ns()
@@ -1198,37 +1275,37 @@ void VGA_SetupMemory(Section* sec)
 	// so this is realistically as strict as we should align the memory for
 	// host operations. However, DOS programs might write read and write to
 	// video memory in 16-byte chunks, so for convenience we align on 16-bytes.
-	constexpr uint8_t vmem_alignment    = 16;
-	using vmem_buffer_t                 = std::unique_ptr<uint8_t[]>;
-	static vmem_buffer_t linear_buffer  = {};
-	static vmem_buffer_t fastmem_buffer = {};
+	// The buffers are page-aligned, which covers this.
+	constexpr uint8_t vmem_alignment = 16;
 
 	// Allocate and verify alignment of the linear buffer, which includes
-	// one additional scanline worth of memory.
+	// one additional scanline worth of memory. The host only commits the
+	// pages the video modes in use write to, so text-mode programs don't
+	// take up the whole of a large 'vmemsize'.
 	const auto num_linear_bytes = std::max(vga_mem_bytes_min, vga.vmemsize) +
 	                              vga_mem_scanline_reserve;
-	std::tie(linear_buffer, vga.mem.linear) =
-	        make_unique_aligned_array<uint8_t>(vmem_alignment, num_linear_bytes);
+	linear_buffer  = ZeroedBuffer(num_linear_bytes);
+	vga.mem.linear = linear_buffer.data();
+	tracked_linear_buffer.Track(linear_buffer.data(), linear_buffer.size());
 	assert(reinterpret_cast<uintptr_t>(vga.mem.linear) % vmem_alignment == 0);
 
 	// Allocate and verify alignment of the fast-memory buffer, which is
 	// twice the size of the linear array.
 	const auto num_fastmem_bytes = 2 * num_linear_bytes;
-	std::tie(fastmem_buffer,
-	         vga.fastmem) = make_unique_aligned_array<uint8_t>(vmem_alignment,
-	                                                           num_fastmem_bytes);
+	fastmem_buffer = ZeroedBuffer(num_fastmem_bytes);
+	vga.fastmem    = fastmem_buffer.data();
+	tracked_fastmem_buffer.Track(fastmem_buffer.data(), fastmem_buffer.size());
 	assert(reinterpret_cast<uintptr_t>(vga.fastmem) % vmem_alignment == 0);
 
 	// In most cases these values stay the same. Assumptions: vmemwrap is power of 2,
 	// vmemwrap <= vmemsize, fastmem implicitly has mem wrap twice as big
 	vga.vmemwrap = vga.vmemsize;
 
-#ifdef VGA_KEEP_CHANGES
-	memset( &vga.changes, 0, sizeof( vga.changes ));
-	int changesMapSize = (vga.vmemsize >> VGA_CHANGE_SHIFT) + 32;
-	vga.changes.map = new uint8_t[changesMapSize];
-	memset(vga.changes.map, 0, changesMapSize);
-#endif
+	// Covers the fastmem addresses, the largest the handlers write to
+	const auto num_change_blocks = (num_fastmem_bytes >> VGA_CHANGE_SHIFT) + 1;
+	vga.changes.written.assign(num_change_blocks, 1);
+	vga.changes.previous.assign(num_change_blocks, 1);
+
 	vga.svga.bank_read = vga.svga.bank_write = 0;
 	vga.svga.bank_read_full = vga.svga.bank_write_full = 0;
 	vga.svga.bank_size = 0x10000; /* most common bank size is 64K */
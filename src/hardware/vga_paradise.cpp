@@ -56,7 +56,7 @@ static void bank_setup_pvga1a() {
 		// Single bank config is straightforward
 		vga.svga.bank_read = vga.svga.bank_write = pvga1a.PR0A;
 		vga.svga.bank_size = 4*1024;
-		VGA_SetupHandlers();
+		VGA_ChangedBank();
 	}
 }
 
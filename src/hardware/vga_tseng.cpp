@@ -247,7 +247,7 @@ void write_p3cd_et4k(io_port_t, io_val_t value, io_width_t)
 	const auto val = check_cast<uint8_t>(value);
 	vga.svga.bank_write = val & 0x0f;
 	vga.svga.bank_read = (val >> 4) & 0x0f;
-	VGA_SetupHandlers();
+	VGA_ChangedBank();
 }
 
 uint8_t read_p3cd_et4k(io_port_t, io_width_t)
@@ -648,7 +648,7 @@ void write_p3cd_et3k(io_port_t, io_val_t value, io_width_t)
 	vga.svga.bank_write = val & 0x07;
 	vga.svga.bank_read = (val>>3) & 0x07;
 	vga.svga.bank_size = (val&0x40)?64*1024:128*1024;
-	VGA_SetupHandlers();
+	VGA_ChangedBank();
 }
 
 uint8_t read_p3cd_et3k(io_port_t, io_width_t)
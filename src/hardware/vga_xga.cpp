@@ -21,6 +21,7 @@
 
 #include "dosbox.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
@@ -286,6 +287,113 @@ static Bitu GetMixResult(uint32_t mixmode, Bitu srcval, Bitu dstdata)
 	return destval;
 }
 
+// Row operations
+// ~~~~~~~~~~~~~~
+// The rectangle fills, blits and pattern fills are drawn a row at a time:
+// each row is clipped against the scissors and the end of the video memory
+// once, and then its pixels are mixed in the video memory directly, with the
+// fills and plain copies done by std::fill and memmove. The results are the
+// same as drawing pixel by pixel. The rows with source pixels outside the
+// video memory, or that would read pixels the row itself draws, are still
+// drawn pixel by pixel, as the order of the reads and writes matters there.
+
+static size_t get_bytes_per_pixel()
+{
+	switch (XGA_COLOR_MODE) {
+	case M_LIN8: return 1;
+	case M_LIN15:
+	case M_LIN16: return 2;
+	case M_LIN32: return 4;
+	default: break;
+	}
+	return 0;
+}
+
+// The bits of the colours XGA_DrawPoint stores
+static uint32_t get_stored_bits_mask()
+{
+	return (XGA_COLOR_MODE == M_LIN15) ? 0x7fff : get_point_mask();
+}
+
+static Bits get_pixel_address(const Bits x, const Bits y)
+{
+	return y * XGA_SCREEN_WIDTH + x;
+}
+
+static bool is_pixel_in_memory(const Bits address)
+{
+	const auto bytes_per_pixel = get_bytes_per_pixel();
+	return bytes_per_pixel && address >= 0 &&
+	       static_cast<Bitu>(address) < vga.vmemsize / bytes_per_pixel;
+}
+
+// Clips the pixels 'lo' to 'hi' of the row 'y' the same way as
+// XGA_DrawPoint, returning false if none of them are drawn
+static bool clip_row(const Bits y, Bits& lo, Bits& hi)
+{
+	if (!(xga.curcommand & 0x1) || !(xga.curcommand & 0x10)) {
+		return false;
+	}
+	if (!get_bytes_per_pixel()) {
+		return false;
+	}
+	if (y < xga.scissors.y1 || y > xga.scissors.y2) {
+		return false;
+	}
+	lo = std::max(lo, static_cast<Bits>(xga.scissors.x1));
+	hi = std::min(hi, static_cast<Bits>(xga.scissors.x2));
+
+	// Skip the pixels past the end of the video memory
+	const auto last_in_memory = static_cast<Bits>(vga.vmemsize /
+	                                              get_bytes_per_pixel()) - 1;
+	hi = std::min(hi, last_in_memory - y * XGA_SCREEN_WIDTH);
+
+	return lo <= hi;
+}
+
+// Calls the function with a value of the colour mode's pixel type
+template <typename Function>
+static void with_pixel_type(Function&& function)
+{
+	switch (get_bytes_per_pixel()) {
+	case 1: function(uint8_t{}); break;
+	case 2: function(uint16_t{}); break;
+	case 4: function(uint32_t{}); break;
+	default: break;
+	}
+}
+
+// Mixes a source colour into the consecutive pixels of a row
+template <typename T>
+static void mix_colour_into_row(const Bits address, const Bits num_pixels,
+                                const uint32_t mixmode, const Bitu srcval)
+{
+	auto pixels = reinterpret_cast<T*>(vga.mem.linear) + address;
+	const auto mask = get_stored_bits_mask();
+
+	switch (mixmode & 0xf) {
+	case 0x01: /* 0 (false) */
+	case 0x02: /* 1 (true) */
+	case 0x04: /* not SRC */
+	case 0x07: /* SRC */
+		std::fill_n(pixels,
+		            num_pixels,
+		            static_cast<T>(GetMixResult(mixmode, srcval, 0) & mask));
+		break;
+	case 0x05: /* SRC xor DST */
+		for (Bits i = 0; i < num_pixels; ++i) {
+			pixels[i] = static_cast<T>((srcval ^ pixels[i]) & mask);
+		}
+		break;
+	default:
+		for (Bits i = 0; i < num_pixels; ++i) {
+			pixels[i] = static_cast<T>(
+			        GetMixResult(mixmode, srcval, pixels[i]) & mask);
+		}
+		break;
+	}
+}
+
 static void XGA_DrawLineVector(const uint32_t val, const bool skip_last_pixel)
 {
 	// No work to do with a zero-length line
@@ -548,6 +656,34 @@ static void XGA_DrawRectangle(const uint32_t val, const bool skip_last_pixel)
 	// one pixel too wide (but don't underflow below zero).
 	const auto xrun = xga.MAPcount - (xga.MAPcount && skip_last_pixel);
 
+	// Fills with the foreground or background colour are mixed into the
+	// rows directly
+	const auto source = (xga.foremix >> 5) & 0x03;
+	if (((xga.pix_cntl >> 6) & 0x3) == 0x00 && source <= 0x01) {
+		srcval = (source == 0x01) ? xga.forecolor : xga.backcolor;
+
+		for (auto yat = 0; yat <= xga.MIPcount; ++yat) {
+			Bits lo = xga.curx;
+			Bits hi = lo + dx * xrun;
+			if (lo > hi) {
+				std::swap(lo, hi);
+			}
+			if (clip_row(srcy, lo, hi)) {
+				with_pixel_type([&](auto pixel_type) {
+					mix_colour_into_row<decltype(pixel_type)>(
+					        get_pixel_address(lo, srcy),
+					        hi - lo + 1,
+					        xga.foremix,
+					        srcval);
+				});
+			}
+			srcy += dy;
+		}
+		xga.curx = static_cast<uint16_t>(xga.curx + dx * (xrun + 1));
+		xga.cury = static_cast<uint16_t>(srcy);
+		return;
+	}
+
 	for (auto yat = 0; yat <= xga.MIPcount; ++yat) {
 		srcx = xga.curx;
 		for (auto xat = 0; xat <= xrun; ++xat) {
@@ -830,8 +966,6 @@ void XGA_DrawWait(uint32_t val, io_width_t width)
 
 void XGA_BlitRect(Bitu val) {
 	uint32_t xat, yat;
-	Bitu srcdata;
-	Bitu dstdata;
 	Bitu colorcmpdata;
 	Bits srcx, srcy, tarx, tary, dx, dy;
 
@@ -860,6 +994,134 @@ void XGA_BlitRect(Bitu val) {
 			break;
 	}
 
+	using namespace bit::literals;
+
+	// Returns whether the pixel is drawn, and its colour
+	auto blit_pixel = [&](const Bitu srcdata, const Bitu dstdata, Bitu& destval) {
+		if (mixselect == 0x3) {
+			if (srcdata == xga.forecolor) {
+				mixmode = xga.foremix;
+			} else {
+				if (srcdata == xga.backcolor) {
+					mixmode = xga.backmix;
+				} else {
+					/* Best guess otherwise */
+					mixmode = 0x67; /* Source is bitmap data, mix mode is src */
+				}
+			}
+		}
+
+		Bitu srcval = 0;
+		switch ((mixmode >> 5) & 0x03) {
+			case 0x00: /* Src is background color */
+				srcval = xga.backcolor;
+				break;
+			case 0x01: /* Src is foreground color */
+				srcval = xga.forecolor;
+				break;
+			case 0x02: /* Src is pixel data from PIX_TRANS register */
+				LOG_MSG("XGA: DrawPattern: Wants data from PIX_TRANS register");
+				srcval = 0;
+				break;
+			case 0x03: /* Src is bitmap data */
+				srcval = srcdata;
+				break;
+			default:
+				LOG_MSG("XGA: DrawPattern: Shouldn't be able to get here!");
+				srcval = 0;
+				break;
+		}
+		// For more information, see the "S3 Vision864 Graphics
+		// Accelerator" datasheet
+		//
+		// [http://hackipedia.org/browse.cgi/Computer/Platform/PC%2c%20IBM%20compatible/Video/VGA/SVGA/S3%20Graphics%2c%20Ltd/S3%20Vision864%20Graphics%20Accelerator%20(1994-10).pdf]
+		//
+		// Page 203 for "Multifunction Control Miscellaneous
+		// Register (MULT_MISC)" which this code holds as
+		// xga.control1, and Page 198 for "Color Compare
+		// Register (COLOR_CMP)" which this code holds as
+		// xga.color_compare.
+
+		// Always update if we're not comparing (COLOR_CMP is
+		// bit 8). Otherwise, either update if the SRC_NE bit is
+		// set with a matching colour or vice-versa (SRC_NE not
+		// set with non-matching colour).
+		if (bit::cleared(xga.control1, b8) ||
+		    bit::is(xga.control1, b7) == (srcval == colorcmpdata)) {
+
+			destval = GetMixResult(mixmode, srcval, dstdata);
+			// LOG_MSG("XGA: DrawPattern: Mixmode: %x Mixselect: %x", mixmode, mixselect);
+			return true;
+		}
+		return false;
+	};
+
+	// Plain copies without colour compare are moved a row at a time
+	const auto is_plain_copy = mixselect != 0x3 &&
+	                           ((mixmode >> 5) & 0x03) == 0x03 &&
+	                           (mixmode & 0xf) == 0x07 &&
+	                           bit::cleared(xga.control1, b8);
+
+	// Blits a row with the video memory addresses, returning false if a
+	// source pixel is outside the video memory
+	auto blit_row = [&](const Bits row_srcx, const Bits row_tarx) {
+		Bits lo = row_tarx;
+		Bits hi = row_tarx + dx * xga.MAPcount;
+		if (lo > hi) {
+			std::swap(lo, hi);
+		}
+		if (!clip_row(tary, lo, hi)) {
+			return true;
+		}
+		const auto num_pixels = hi - lo + 1;
+
+		// The first pixels in the drawing direction
+		const auto first_tarx = (dx > 0) ? lo : hi;
+		const auto first_srcx = row_srcx + (first_tarx - row_tarx);
+
+		const auto src_first = get_pixel_address(first_srcx, srcy);
+		const auto src_last  = src_first + dx * (num_pixels - 1);
+		const auto dst_first = get_pixel_address(first_tarx, tary);
+
+		if (!is_pixel_in_memory(src_first) || !is_pixel_in_memory(src_last)) {
+			return false;
+		}
+		with_pixel_type([&](auto pixel_type) {
+			using T = decltype(pixel_type);
+
+			auto pixels = reinterpret_cast<T*>(vga.mem.linear);
+			const auto mask = get_stored_bits_mask();
+
+			// Moving is only the same as copying pixel by pixel if
+			// no pixel is read after it's been written
+			const auto is_target_ahead = (dx > 0)
+			        ? (dst_first > src_first && dst_first <= src_last)
+			        : (dst_first < src_first && dst_first >= src_last);
+
+			if (is_plain_copy && !is_target_ahead) {
+				const auto dst_lo = std::min(dst_first,
+				                             dst_first + dx * (num_pixels - 1));
+				memmove(pixels + dst_lo,
+				        pixels + std::min(src_first, src_last),
+				        num_pixels * sizeof(T));
+				if (mask != get_point_mask()) {
+					for (Bits i = 0; i < num_pixels; ++i) {
+						pixels[dst_lo + i] &= mask;
+					}
+				}
+				return;
+			}
+			for (Bits i = 0; i < num_pixels; ++i) {
+				auto& dst = pixels[dst_first + dx * i];
+				Bitu destval = 0;
+				if (blit_pixel(pixels[src_first + dx * i], dst, destval)) {
+					dst = static_cast<T>(destval & mask);
+				}
+			}
+		});
+		return true;
+	};
+
 	/* Copy source to video ram */
 	srcy = xga.cury;
 	tary = xga.desty;
@@ -867,67 +1129,17 @@ void XGA_BlitRect(Bitu val) {
 		srcx = xga.curx;
 		tarx = xga.destx;
 
+		if (blit_row(srcx, tarx)) {
+			srcy += dy;
+			tary += dy;
+			continue;
+		}
 		for(xat=0;xat<=xga.MAPcount;xat++) {
-			srcdata = XGA_GetPoint(srcx, srcy);
-			dstdata = XGA_GetPoint(tarx, tary);
+			const Bitu srcdata = XGA_GetPoint(srcx, srcy);
+			const Bitu dstdata = XGA_GetPoint(tarx, tary);
 
-			if (mixselect == 0x3) {
-				if (srcdata == xga.forecolor) {
-					mixmode = xga.foremix;
-				} else {
-					if (srcdata == xga.backcolor) {
-						mixmode = xga.backmix;
-					} else {
-						/* Best guess otherwise */
-						mixmode = 0x67; /* Source is bitmap data, mix mode is src */
-					}
-				}
-			}
-
-			Bitu srcval = 0;
-			switch ((mixmode >> 5) & 0x03) {
-				case 0x00: /* Src is background color */
-					srcval = xga.backcolor;
-					break;
-				case 0x01: /* Src is foreground color */
-					srcval = xga.forecolor;
-					break;
-				case 0x02: /* Src is pixel data from PIX_TRANS register */
-					LOG_MSG("XGA: DrawPattern: Wants data from PIX_TRANS register");
-					srcval = 0;
-					break;
-				case 0x03: /* Src is bitmap data */
-					srcval = srcdata;
-					break;
-				default:
-					LOG_MSG("XGA: DrawPattern: Shouldn't be able to get here!");
-					srcval = 0;
-					break;
-			}
-			// For more information, see the "S3 Vision864 Graphics
-			// Accelerator" datasheet
-			//
-			// [http://hackipedia.org/browse.cgi/Computer/Platform/PC%2c%20IBM%20compatible/Video/VGA/SVGA/S3%20Graphics%2c%20Ltd/S3%20Vision864%20Graphics%20Accelerator%20(1994-10).pdf]
-			//
-			// Page 203 for "Multifunction Control Miscellaneous
-			// Register (MULT_MISC)" which this code holds as
-			// xga.control1, and Page 198 for "Color Compare
-			// Register (COLOR_CMP)" which this code holds as
-			// xga.color_compare.
-
-			// Always update if we're not comparing (COLOR_CMP is
-			// bit 8). Otherwise, either update if the SRC_NE bit is
-			// set with a matching colour or vice-versa (SRC_NE not
-			// set with non-matching colour).
-
-			using namespace bit::literals;
-
-			if (bit::cleared(xga.control1, b8) ||
-			    bit::is(xga.control1, b7) == (srcval == colorcmpdata)) {
-
-				const auto destval = GetMixResult(mixmode, srcval, dstdata);
-
-				// LOG_MSG("XGA: DrawPattern: Mixmode: %x Mixselect: %x", mixmode, mixselect);
+			Bitu destval = 0;
+			if (blit_pixel(srcdata, dstdata, destval)) {
 				XGA_DrawPoint((Bitu)tarx, (Bitu)tary, destval);
 			}
 
@@ -940,10 +1152,6 @@ void XGA_BlitRect(Bitu val) {
 }
 
 void XGA_DrawPattern(Bitu val) {
-	Bitu srcdata;
-	Bitu dstdata;
-
-
 	Bits xat, yat, srcx, srcy, tarx, tary, dx, dy;
 
 	dx = -1;
@@ -974,83 +1182,145 @@ void XGA_DrawPattern(Bitu val) {
 			break;
 	}
 
+	// Returns the colour of the pixel
+	auto pattern_pixel = [&](const Bitu srcdata, const Bitu dstdata) {
+		if (mixselect == 0x3) {
+
+			// S3 Trio32/Trio64 Integrated Graphics
+			// Accelerators, section 13.2 Bitmap Access
+			// Through The Graphics Engine.
+			// [https://jon.nerdgrounds.com/jmcs/docs/browse/Computer/Platform/PC%2c%20IBM%20compatible/Video/VGA/SVGA/S3%20Graphics%2c%20Ltd/S3%20Trio32%e2%88%95Trio64%20Integrated%20Graphics%20Accelerators%20%281995%2d03%29%2epdf]
+
+			// "If bits 7-6 are set to 11b, the current
+			// display bit map is selected as the mask bit
+			// source. The Read Mask" "register (AAE8H) is
+			// set up to indicate the active planes. When
+			// all bits of the read-enabled planes for a"
+			// "pixel are a 1, the mask bit 'ONE' is
+			// generated. If anyone of the read-enabled
+			// planes is a 0, then a mask" "bit 'ZERO' is
+			// generated. If the mask bit is 'ONE', the
+			// Foreground Mix register is used. If the mask
+			// bit is" "'ZERO', the Background Mix register
+			// is used." Notice that when an application in
+			// Windows 3.1 draws a black rectangle, I see
+			// foreground=0 background=ff and in this loop,
+			// srcdata=ff and readmask=ff. While the
+			// original DOSBox SVN "guess" code here would
+			// misattribute that to the background color
+			// (and erroneously draw a white rectangle),
+			// what should actually happen is that we use
+			// the foreground color because
+			// (srcdata&readmask)==readmask (all bits 1).
+
+			// This fixes visual bugs when running
+			// Windows 3.1 and Microsoft Creative Writer,
+			// and navigating to the basement and clicking
+			// around in the dark to reveal funny random
+			// things, leaves white rectangles on the screen
+			// where the image was when you released the
+			// mouse. Creative Writer clears the image by
+			// drawing a BLACK rectangle, while the DOSBox
+			// SVN "guess" mistakenly chose the background
+			// color and therefore a WHITE rectangle.
+
+			if ((srcdata & xga.readmask) == xga.readmask) {
+				mixmode = xga.foremix;
+			} else {
+				mixmode = xga.backmix;
+			}
+		}
+
+		Bitu srcval = 0;
+		switch ((mixmode >> 5) & 0x03) {
+			case 0x00: /* Src is background color */
+				srcval = xga.backcolor;
+				break;
+			case 0x01: /* Src is foreground color */
+				srcval = xga.forecolor;
+				break;
+			case 0x02: /* Src is pixel data from PIX_TRANS register */
+				LOG_MSG("XGA: DrawPattern: Wants data from PIX_TRANS register");
+				srcval = 0;
+				break;
+			case 0x03: /* Src is bitmap data */
+				srcval = srcdata;
+				break;
+			default:
+				LOG_MSG("XGA: DrawPattern: Shouldn't be able to get here!");
+				srcval = 0;
+				break;
+		}
+
+		return GetMixResult(mixmode, srcval, dstdata);
+	};
+
+	// Fills with the foreground or background colour, and rows whose
+	// pattern pixels aren't drawn over by the row itself, are mixed into
+	// the rows directly
+	const auto source = (mixmode >> 5) & 0x03;
+	const auto is_colour_fill = (mixselect == 0x00 && source <= 0x01);
+
+	auto draw_row = [&](const Bits row_tarx) {
+		Bits lo = row_tarx;
+		Bits hi = row_tarx + dx * xga.MAPcount;
+		if (lo > hi) {
+			std::swap(lo, hi);
+		}
+		if (!clip_row(tary, lo, hi)) {
+			return true;
+		}
+		const auto num_pixels = hi - lo + 1;
+		const auto dst_lo     = get_pixel_address(lo, tary);
+
+		if (is_colour_fill) {
+			with_pixel_type([&](auto pixel_type) {
+				mix_colour_into_row<decltype(pixel_type)>(
+				        dst_lo,
+				        num_pixels,
+				        mixmode,
+				        (source == 0x01) ? xga.forecolor : xga.backcolor);
+			});
+			return true;
+		}
+
+		const auto pattern_y     = srcy + (tary & 0x7);
+		const auto pattern_first = get_pixel_address(srcx, pattern_y);
+		if (pattern_first + 7 >= dst_lo && pattern_first <= dst_lo + num_pixels - 1) {
+			return false;
+		}
+		Bitu pattern[8] = {};
+		for (Bits x = 0; x < 8; ++x) {
+			pattern[x] = XGA_GetPoint(srcx + x, pattern_y);
+		}
+		with_pixel_type([&](auto pixel_type) {
+			using T = decltype(pixel_type);
+
+			auto pixels = reinterpret_cast<T*>(vga.mem.linear) + dst_lo;
+			const auto mask = get_stored_bits_mask();
+
+			for (Bits i = 0; i < num_pixels; ++i) {
+				const auto x = (dx > 0) ? (lo + i) : (hi - i);
+				auto& dst    = pixels[x - lo];
+				dst = static_cast<T>(pattern_pixel(pattern[x & 0x7], dst) & mask);
+			}
+		});
+		return true;
+	};
+
 	for(yat=0;yat<=xga.MIPcount;yat++) {
 		tarx = xga.destx;
+		if (draw_row(tarx)) {
+			tary += dy;
+			continue;
+		}
 		for(xat=0;xat<=xga.MAPcount;xat++) {
 
-			srcdata = XGA_GetPoint(srcx + (tarx & 0x7), srcy + (tary & 0x7));
+			const Bitu srcdata = XGA_GetPoint(srcx + (tarx & 0x7), srcy + (tary & 0x7));
 			//LOG_MSG("patternpoint (%3d/%3d)v%x",srcx + (tarx & 0x7), srcy + (tary & 0x7),srcdata);
-			dstdata = XGA_GetPoint(tarx, tary);
-
-			if (mixselect == 0x3) {
-
-				// S3 Trio32/Trio64 Integrated Graphics
-				// Accelerators, section 13.2 Bitmap Access
-				// Through The Graphics Engine.
-				// [https://jon.nerdgrounds.com/jmcs/docs/browse/Computer/Platform/PC%2c%20IBM%20compatible/Video/VGA/SVGA/S3%20Graphics%2c%20Ltd/S3%20Trio32%e2%88%95Trio64%20Integrated%20Graphics%20Accelerators%20%281995%2d03%29%2epdf]
-
-				// "If bits 7-6 are set to 11b, the current
-				// display bit map is selected as the mask bit
-				// source. The Read Mask" "register (AAE8H) is
-				// set up to indicate the active planes. When
-				// all bits of the read-enabled planes for a"
-				// "pixel are a 1, the mask bit 'ONE' is
-				// generated. If anyone of the read-enabled
-				// planes is a 0, then a mask" "bit 'ZERO' is
-				// generated. If the mask bit is 'ONE', the
-				// Foreground Mix register is used. If the mask
-				// bit is" "'ZERO', the Background Mix register
-				// is used." Notice that when an application in
-				// Windows 3.1 draws a black rectangle, I see
-				// foreground=0 background=ff and in this loop,
-				// srcdata=ff and readmask=ff. While the
-				// original DOSBox SVN "guess" code here would
-				// misattribute that to the background color
-				// (and erroneously draw a white rectangle),
-				// what should actually happen is that we use
-				// the foreground color because
-				// (srcdata&readmask)==readmask (all bits 1).
-
-				// This fixes visual bugs when running
-				// Windows 3.1 and Microsoft Creative Writer,
-				// and navigating to the basement and clicking
-				// around in the dark to reveal funny random
-				// things, leaves white rectangles on the screen
-				// where the image was when you released the
-				// mouse. Creative Writer clears the image by
-				// drawing a BLACK rectangle, while the DOSBox
-				// SVN "guess" mistakenly chose the background
-				// color and therefore a WHITE rectangle.
-
-				if ((srcdata & xga.readmask) == xga.readmask) {
-					mixmode = xga.foremix;
-				} else {
-					mixmode = xga.backmix;
-				}
-			}
-
-			Bitu srcval = 0;
-			switch ((mixmode >> 5) & 0x03) {
-				case 0x00: /* Src is background color */
-					srcval = xga.backcolor;
-					break;
-				case 0x01: /* Src is foreground color */
-					srcval = xga.forecolor;
-					break;
-				case 0x02: /* Src is pixel data from PIX_TRANS register */
-					LOG_MSG("XGA: DrawPattern: Wants data from PIX_TRANS register");
-					srcval = 0;
-					break;
-				case 0x03: /* Src is bitmap data */
-					srcval = srcdata;
-					break;
-				default:
-					LOG_MSG("XGA: DrawPattern: Shouldn't be able to get here!");
-					srcval = 0;
-					break;
-			}
+			const Bitu dstdata = XGA_GetPoint(tarx, tary);
 
-			const Bitu destval = GetMixResult(mixmode, srcval, dstdata);
+			const Bitu destval = pattern_pixel(srcdata, dstdata);
 			XGA_DrawPoint(tarx, tary, destval);
 			
 			tarx += dx;
@@ -83,7 +83,11 @@
 #include <condition_variable>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <SDL.h>
 #include <SDL_cpuinfo.h> // for proper SSE defines for MSVC
@@ -97,16 +101,18 @@
 #include "control.h"
 #include "cross.h"
 #include "fraction.h"
+#include "host_memory.h"
+#include "host_threads.h"
 #include "math_utils.h"
 #include "mem.h"
 #include "paging.h"
 #include "pci_bus.h"
 #include "pic.h"
 #include "render.h"
-#include "semaphore_internal.h"
 #include "setup.h"
 #include "support.h"
 #include "vga.h"
+#include "worker_pool.h"
 
 #ifndef DOSBOX_VOODOO_TYPES_H
 #define DOSBOX_VOODOO_TYPES_H
@@ -255,7 +261,15 @@ enum VoodooModel
 	VOODOO_2,
 };
 
-enum { TRIANGLE_THREADS = 3, TRIANGLE_WORKERS = TRIANGLE_THREADS + 1 };
+// The triangles are drawn on the shared worker threads, by up to this many
+// threads including the emulation thread
+constexpr int MaxTriangleWorkers = 16;
+
+// Triangles are split into bands of scanlines, a few more than there are
+// workers, so the workers finishing early pick up the remaining bands. Bands
+// with fewer pixels than this aren't worth waking up a thread for.
+constexpr int BandsPerTriangleWorker = 4;
+constexpr int MinTriangleBandPixels  = 200;
 
 /* maximum number of TMUs */
 #define MAX_TMU					2
@@ -717,14 +731,43 @@ struct ncc_table
 	rgb_t *				palette;				/* pointer to associated RGB palette */
 	rgb_t *				palettea;				/* pointer to associated ARGB palette */
 	rgb_t				texel[256];				/* texel lookup */
+	uint32_t			generation;				/* incremented when the texel or palette lookups change */
+};
+
+/* a texture with its texels decoded to ARGB, so the rasterizers fetch them
+   without the format's lookup; the levels are decoded as they get drawn */
+struct decoded_texture
+{
+	bool				valid;					/* does this hold a texture? */
+	uint32_t			base;					/* texture RAM offset of LOD 0 */
+	uint32_t			wmask, hmask;			/* LOD 0 width/height masks */
+	uint32_t			lodmask;				/* mask of available LODs */
+	uint32_t			format;					/* texture format */
+	const rgb_t *		lookup;					/* lookup the texels were decoded with */
+	uint32_t			lookup_generation;		/* NCC/palette generation of the lookup */
+	uint32_t			ram_span;				/* bytes of texture RAM from the base */
+	uint32_t			num_uses;				/* number of triangles drawn with it */
+	uint64_t			last_use;				/* for evicting the least recently used */
+	uint32_t			lods_decoded;			/* mask of decoded LODs */
+	uint32_t			lod_start[9];			/* index of the first texel of each LOD */
+	std::vector<uint32_t> texels;				/* decoded texels */
 };
 
-using mem_buffer_t = std::unique_ptr<uint8_t[]>;
+constexpr int NumDecodedTextures = 8;
+
+/* decoding costs more than the lookups of a single triangle, so only decode
+   the textures that get reused */
+constexpr uint32_t MinDecodedTextureUses = 2;
+
+// Backed by pages the host only commits once they're written to, as games
+// rarely use all of the frame buffer and texture memory
+using mem_buffer_t = ZeroedBuffer;
 
 struct tmu_state
 {
 	uint8_t*				ram;					/* pointer to aligned RAM */
 	mem_buffer_t				ram_buffer;				/* Managed buffer backing the RAM */
+	TrackedHostMemory			tracked_ram{HostMemoryUse::Voodoo};
 	uint32_t				mask;					/* mask to apply to pointers */
 	voodoo_reg *		reg;					/* pointer to our register base */
 	bool				regdirty;				/* true if the LOD/mode/base registers have changed */
@@ -761,6 +804,13 @@ struct tmu_state
 
 	rgb_t				palette[256];			/* palette lookup table */
 	rgb_t				palettea[256];			/* palette+alpha lookup table */
+
+	std::array<decoded_texture, NumDecodedTextures> decoded_textures; /* recently drawn textures */
+	uint64_t			decoded_uses;			/* use counter of the decoded textures */
+
+	/* decoded texels of each LOD of the current texture, or nullptr to fetch
+	   through the lookup; the LOD registers allow indexes past the 9 LODs */
+	const uint32_t *	decoded_lod[17];
 };
 
 struct tmu_shared_state
@@ -788,6 +838,7 @@ struct fbi_state
 {
 	uint8_t*				ram;					/* pointer to aligned frame buffer RAM */
 	mem_buffer_t				ram_buffer;				/* Managed buffer backing the RAM */
+	TrackedHostMemory			tracked_ram{HostMemoryUse::Voodoo};
 
 	uint32_t				mask;					/* mask to apply to pointers */
 	uint32_t				rgboffs[3];				/* word offset to 3 RGB buffers */
@@ -889,17 +940,70 @@ struct draw_state {
 	bool screen_update_pending   = false;
 };
 
+struct voodoo_state;
+
+using raster_func_t = void (*)(const voodoo_state* vs, uint32_t texmode0,
+                               uint32_t texmode1, void* destbase, int32_t y,
+                               const poly_extent* extent, stats_block& stats);
+
+/* the normalized register values selecting a rasterizer */
+struct raster_mode
+{
+	uint32_t tmus       = 0;
+	uint32_t color_path = 0;
+	uint32_t alpha_mode = 0;
+	uint32_t fog_mode   = 0;
+	uint32_t fbz_mode   = 0;
+	uint32_t tex_mode_0 = 0;
+	uint32_t tex_mode_1 = 0;
+
+	bool operator==(const raster_mode& other) const = default;
+};
+
+struct raster_mode_hash
+{
+	size_t operator()(const raster_mode& mode) const
+	{
+		uint64_t hash = 0xcbf29ce484222325;
+		for (const auto value : {mode.tmus, mode.color_path, mode.alpha_mode,
+		                         mode.fog_mode, mode.fbz_mode,
+		                         mode.tex_mode_0, mode.tex_mode_1}) {
+			hash = (hash ^ value) * 0x100000001b3;
+		}
+		return static_cast<size_t>(hash);
+	}
+};
+
+/* how much a rasterizer mode has been used, to find the modes that are worth
+   adding fast paths for */
+struct raster_mode_usage
+{
+	uint64_t triangles = 0;
+	uint64_t pixels    = 0;
+	bool is_fast_path  = false;
+};
+
 struct triangle_worker
 {
-	std::atomic_bool threads_active;
 	bool use_threads, disable_bilinear_filter;
 	uint16_t *drawbuf;
 	poly_vertex v1, v2, v3;
-	int32_t v1y, v3y, totalpix;
-	std::array<std::thread, TRIANGLE_THREADS> threads;
-	std::array<Semaphore, TRIANGLE_THREADS> sembegin;
-	Semaphore semdone;
-	int done_count;
+	int32_t v1y, v3y;
+
+	// The rasterizer of the triangle's mode, and the usage of the mode
+	raster_mode mode;
+	raster_func_t raster;
+	raster_mode_usage* usage;
+	uint32_t texmode0, texmode1;
+
+	// The extents of the triangle's scanlines, and the index of the
+	// scanline ending each band. The bands are drawn on the shared worker
+	// threads in parallel.
+	std::vector<poly_extent> extents;
+	std::vector<int32_t> band_ends;
+
+	// The most worker threads helping to draw a triangle
+	int num_threads;
 };
 
 struct voodoo_state
@@ -925,8 +1029,11 @@ struct voodoo_state
 	                                                    rasterizers */
 #endif
 
-	stats_block thread_stats[TRIANGLE_WORKERS] = {}; /* per-thread
-	                                                    statistics */
+	stats_block thread_stats[MaxTriangleWorkers] = {}; /* per-thread
+	                                                      statistics */
+
+	/* per-rasterizer mode statistics */
+	std::unordered_map<raster_mode, raster_mode_usage, raster_mode_hash> raster_modes = {};
 
 	bool send_config   = {};
 	bool clock_enabled = {};
@@ -1172,7 +1279,6 @@ inline int64_t float_to_int64(uint32_t data, int fixedbits)
 
 
 
-#ifdef C_ENABLE_VOODOO_OPENGL
 /*************************************
  *
  *  Rasterizer inlines
@@ -1236,6 +1342,7 @@ inline uint32_t normalize_tex_mode(uint32_t eff_tex_mode)
 	return eff_tex_mode;
 }
 
+#ifdef C_ENABLE_VOODOO_OPENGL
 inline uint32_t compute_raster_hash(const raster_info* info)
 {
 	uint32_t hash;
@@ -1981,7 +2088,11 @@ do																				\
 		t *= smax + 1;															\
 																				\
 		/* fetch texel data */													\
-		if (TEXMODE_FORMAT(TEXMODE) < 8)										\
+		if (const uint32_t* const decoded = (TT)->decoded_lod[ilod])			\
+		{																		\
+			c_local.u = decoded[t + s];											\
+		}																		\
+		else if (TEXMODE_FORMAT(TEXMODE) < 8)									\
 		{																		\
 			texel0 = (TT)->ram[(texbase + t + s) & (TT)->mask];					\
 			c_local.u = (LOOKUP)[texel0];										\
@@ -2042,7 +2153,14 @@ do																				\
 		t1 *= smax + 1;															\
 																				\
 		/* fetch texel data */													\
-		if (TEXMODE_FORMAT(TEXMODE) < 8)										\
+		if (const uint32_t* const decoded = (TT)->decoded_lod[ilod])			\
+		{																		\
+			texel0 = decoded[t + s];											\
+			texel1 = decoded[t + s1];											\
+			texel2 = decoded[t1 + s];											\
+			texel3 = decoded[t1 + s1];											\
+		}																		\
+		else if (TEXMODE_FORMAT(TEXMODE) < 8)									\
 		{																		\
 			texel0 = (TT)->ram[(texbase + t + s) & (TT)->mask];					\
 			texel1 = (TT)->ram[(texbase + t + s1) & (TT)->mask];				\
@@ -3035,9 +3153,119 @@ static double Voodoo_GetHRetracePosition();
 static dither_lut_t dither2_lookup = {};
 static dither_lut_t dither4_lookup = {};
 
-static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_t TEXMODE0,
-                                  uint32_t TEXMODE1, void* destbase, int32_t y,
-                                  const poly_extent* extent, stats_block& stats)
+#if defined(__SSE2__)
+/*-------------------------------------------------
+    color_combine_sse2 - the color combine unit
+    with the B, G, R and A channels of a pixel in
+    the 32-bit lanes of a vector. fbzColorPath is
+    decoded into lane masks once per span.
+-------------------------------------------------*/
+struct color_combine_sse2
+{
+	__m128i other_mask;   // the lanes of c_other that aren't zeroed
+	__m128i sub_mask;     // the lanes c_local is subtracted from
+	__m128i reverse;      // 0xff in the lanes whose blend isn't reversed
+	__m128i add_mask;     // the lanes c_local is added to
+	__m128i add_a_mask;   // the lanes a_local is added to
+	uint32_t invert;      // the inverted bits of the result
+	uint32_t rgb_mselect; // the blend factor selections
+	uint32_t a_mselect;
+
+	explicit color_combine_sse2(const uint32_t fbzcp)
+	{
+		auto lanes = [](const bool rgb, const bool alpha, const int value) {
+			return _mm_setr_epi32(rgb ? value : 0,
+			                      rgb ? value : 0,
+			                      rgb ? value : 0,
+			                      alpha ? value : 0);
+		};
+		other_mask = lanes(!FBZCP_CC_ZERO_OTHER(fbzcp),
+		                   !FBZCP_CCA_ZERO_OTHER(fbzcp), -1);
+		sub_mask = lanes(FBZCP_CC_SUB_CLOCAL(fbzcp),
+		                 FBZCP_CCA_SUB_CLOCAL(fbzcp), -1);
+		reverse = lanes(!FBZCP_CC_REVERSE_BLEND(fbzcp),
+		                !FBZCP_CCA_REVERSE_BLEND(fbzcp), 0xff);
+		add_mask = lanes(FBZCP_CC_ADD_ACLOCAL(fbzcp) == 1,
+		                 FBZCP_CCA_ADD_ACLOCAL(fbzcp), -1);
+		add_a_mask = lanes(FBZCP_CC_ADD_ACLOCAL(fbzcp) == 2, false, -1);
+		invert = (FBZCP_CC_INVERT_OUTPUT(fbzcp) ? 0x00ffffffu : 0) |
+		         (FBZCP_CCA_INVERT_OUTPUT(fbzcp) ? 0xff000000u : 0);
+
+		rgb_mselect = FBZCP_CC_MSELECT(fbzcp);
+		a_mselect   = FBZCP_CCA_MSELECT(fbzcp);
+	}
+
+	static __m128i expand(const uint32_t argb)
+	{
+		const auto zero = _mm_setzero_si128();
+		return _mm_unpacklo_epi16(
+		        _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(argb)), zero),
+		        zero);
+	}
+
+	// Returns the blended and clamped ARGB color
+	uint32_t combine(const rgb_union c_other, const rgb_union c_local,
+	                 const rgb_union texel) const
+	{
+		/* select the blend factors */
+		uint32_t blend_rgb = 0;
+		switch (rgb_mselect) {
+		case 1: blend_rgb = c_local.u; break;
+		case 2: blend_rgb = c_other.rgb.a * 0x010101u; break;
+		case 3: blend_rgb = c_local.rgb.a * 0x010101u; break;
+		case 4: blend_rgb = texel.rgb.a * 0x010101u; break;
+		case 5: blend_rgb = texel.u; break;
+		default: break;
+		}
+		uint32_t blend_a = 0;
+		switch (a_mselect) {
+		case 1:
+		case 3: blend_a = c_local.rgb.a; break;
+		case 2: blend_a = c_other.rgb.a; break;
+		case 4: blend_a = texel.rgb.a; break;
+		default: break;
+		}
+		const auto blend = _mm_add_epi32(
+		        _mm_xor_si128(expand((blend_rgb & 0xffffff) | (blend_a << 24)),
+		                      reverse),
+		        _mm_set1_epi32(1));
+
+		/* select zero or c_other, and subtract c_local */
+		const auto local = expand(c_local.u);
+		auto color = _mm_sub_epi32(_mm_and_si128(expand(c_other.u), other_mask),
+		                           _mm_and_si128(local, sub_mask));
+
+		/* do the blend; the colors and factors fit in 16 bits, and the
+		   factors' zero high halves make the multiply-add a plain multiply */
+		color = _mm_srai_epi32(_mm_madd_epi16(color, blend), 8);
+
+		/* add clocal or alocal */
+		const auto local_a = _mm_shuffle_epi32(local, _MM_SHUFFLE(3, 3, 3, 3));
+		color = _mm_add_epi32(color, _mm_and_si128(local, add_mask));
+		color = _mm_add_epi32(color, _mm_and_si128(local_a, add_a_mask));
+
+		/* clamp and invert */
+		color = _mm_packs_epi32(color, color);
+		color = _mm_packus_epi16(color, color);
+		return static_cast<uint32_t>(_mm_cvtsi128_si32(color)) ^ invert;
+	}
+};
+#endif
+
+/* a rasterizer template argument taking the mode from the register */
+constexpr uint32_t AnyMode = 0xffffffff;
+
+/*-------------------------------------------------
+    raster_generic - rasterizes a scanline; the
+    modes that aren't AnyMode are the normalized
+    values of the registers, so that the compiler
+    can fold the pipeline's mode checks
+-------------------------------------------------*/
+template <uint32_t TMUS, uint32_t FbzColorPath, uint32_t AlphaMode,
+          uint32_t FogMode, uint32_t FbzMode>
+static void raster_generic(const voodoo_state* vs, uint32_t TEXMODE0,
+                           uint32_t TEXMODE1, void* destbase, int32_t y,
+                           const poly_extent* extent, stats_block& stats)
 {
 	const uint8_t* dither_lookup = nullptr;
 	const uint8_t* dither4       = nullptr;
@@ -3053,11 +3281,16 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 	const auto& tmu0 = vs->tmu[0];
 	const auto& tmu1 = vs->tmu[1];
 
-	const uint32_t r_fbzColorPath = regs[fbzColorPath].u;
-	const uint32_t r_fbzMode      = regs[fbzMode].u;
-	const uint32_t r_alphaMode    = regs[alphaMode].u;
-	const uint32_t r_fogMode      = regs[fogMode].u;
-	const uint32_t r_zaColor      = regs[zaColor].u;
+	const uint32_t r_fbzColorPath = (FbzColorPath == AnyMode)
+	                                      ? regs[fbzColorPath].u
+	                                      : FbzColorPath;
+	const uint32_t r_fbzMode   = (FbzMode == AnyMode) ? regs[fbzMode].u
+	                                                  : FbzMode;
+	const uint32_t r_alphaMode = (AlphaMode == AnyMode) ? regs[alphaMode].u
+	                                                    : AlphaMode;
+	const uint32_t r_fogMode   = (FogMode == AnyMode) ? regs[fogMode].u
+	                                                  : FogMode;
+	const uint32_t r_zaColor   = regs[zaColor].u;
 
 	uint32_t r_stipple = regs[stipple].u;
 
@@ -3144,6 +3377,10 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 		itert1 = tmu1.startt + dy * tmu1.dtdy + dx * tmu1.dtdx;
 	}
 
+#if defined(__SSE2__)
+	const color_combine_sse2 combine(r_fbzColorPath);
+#endif
+
 	/* loop in X */
 	for (int32_t x = startx; x < stopx; x++)
 	{
@@ -3183,10 +3420,6 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 		CLAMPED_ARGB(iterr, iterg, iterb, itera, r_fbzColorPath, iterargb);
 
 
-		int32_t blendr;
-		int32_t blendg;
-		int32_t blendb;
-		int32_t blenda;
 		rgb_union c_other;
 		rgb_union c_local;
 
@@ -3280,6 +3513,19 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 			}
 		}
 
+#if defined(__SSE2__)
+		rgb_union combined;
+		combined.u = combine.combine(c_other, c_local, texel);
+		r = combined.rgb.r;
+		g = combined.rgb.g;
+		b = combined.rgb.b;
+		a = combined.rgb.a;
+#else
+		int32_t blendr;
+		int32_t blendg;
+		int32_t blendb;
+		int32_t blenda;
+
 		/* select zero or c_other */
 		if (FBZCP_CC_ZERO_OTHER(r_fbzColorPath) == 0)
 		{
@@ -3415,6 +3661,7 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 		if (FBZCP_CCA_INVERT_OUTPUT(r_fbzColorPath)) {
 			a ^= 0xff;
 		}
+#endif
 
 		/* pixel pipeline part 2 handles fog, alpha, and final output */
 		PIXEL_PIPELINE_MODIFY(vs, dither, dither4, x,
@@ -3445,6 +3692,103 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 	}
 }
 
+struct raster_fast_path
+{
+	uint32_t color_path;
+	uint32_t alpha_mode;
+	uint32_t fog_mode;
+	uint32_t fbz_mode;
+
+	/* the rasterizers by the number of TMUs */
+	std::array<raster_func_t, MAX_TMU + 1> rasters;
+};
+
+#define RASTER_FAST_PATH(COLOR_PATH, ALPHA_MODE, FOG_MODE, FBZ_MODE) \
+	{ \
+		COLOR_PATH, ALPHA_MODE, FOG_MODE, FBZ_MODE, \
+		{ \
+			raster_generic<0, COLOR_PATH, ALPHA_MODE, FOG_MODE, FBZ_MODE>, \
+			raster_generic<1, COLOR_PATH, ALPHA_MODE, FOG_MODE, FBZ_MODE>, \
+			raster_generic<2, COLOR_PATH, ALPHA_MODE, FOG_MODE, FBZ_MODE>, \
+		} \
+	}
+
+/* the rasterizers specialized for the most-used modes, matched in order; the
+   rasterizer mode usage logged at shutdown shows the modes that titles use, in
+   the format of these entries */
+static const raster_fast_path raster_fast_paths[] = {
+	/* opaque and unfogged */
+	RASTER_FAST_PATH(AnyMode, 0x00000000, 0x00000000, AnyMode),
+
+	/* unfogged */
+	RASTER_FAST_PATH(AnyMode, AnyMode, 0x00000000, AnyMode),
+
+	/* opaque */
+	RASTER_FAST_PATH(AnyMode, 0x00000000, AnyMode, AnyMode),
+};
+
+static const raster_fast_path raster_generic_path = RASTER_FAST_PATH(AnyMode,
+                                                                     AnyMode,
+                                                                     AnyMode,
+                                                                     AnyMode);
+
+static raster_func_t find_raster_fast_path(const raster_mode& mode, bool& is_fast_path)
+{
+	auto matches = [](const uint32_t path_value, const uint32_t value) {
+		return path_value == AnyMode || path_value == value;
+	};
+	for (const auto& path : raster_fast_paths) {
+		if (matches(path.color_path, mode.color_path) &&
+		    matches(path.alpha_mode, mode.alpha_mode) &&
+		    matches(path.fog_mode, mode.fog_mode) &&
+		    matches(path.fbz_mode, mode.fbz_mode)) {
+			is_fast_path = true;
+			return path.rasters[mode.tmus];
+		}
+	}
+	is_fast_path = false;
+	return raster_generic_path.rasters[mode.tmus];
+}
+
+/*-------------------------------------------------
+    log_raster_mode_usage - publishes the most-used
+    rasterizer modes, to tune the fast paths
+-------------------------------------------------*/
+static void log_raster_mode_usage(const voodoo_state* vs)
+{
+	constexpr size_t MaxLoggedModes = 10;
+
+	std::vector<std::pair<raster_mode, raster_mode_usage>> modes(
+	        vs->raster_modes.begin(), vs->raster_modes.end());
+	if (modes.empty()) {
+		return;
+	}
+	std::sort(modes.begin(), modes.end(), [](const auto& a, const auto& b) {
+		return a.second.pixels > b.second.pixels;
+	});
+
+	uint64_t total_pixels = 0;
+	for (const auto& [mode, usage] : modes) {
+		total_pixels += usage.pixels;
+	}
+
+	LOG_MSG("VOODOO: Most-used rasterizer modes, by pixels drawn:");
+	for (size_t i = 0; i < std::min(modes.size(), MaxLoggedModes); ++i) {
+		const auto& [mode, usage] = modes[i];
+		LOG_MSG("VOODOO:   RASTER_FAST_PATH(0x%08x, 0x%08x, 0x%08x, 0x%08x), // %u TMUs, textureMode 0x%08x 0x%08x: %.1f%% of pixels, %llu triangles%s",
+		        mode.color_path,
+		        mode.alpha_mode,
+		        mode.fog_mode,
+		        mode.fbz_mode,
+		        mode.tmus,
+		        mode.tex_mode_0,
+		        mode.tex_mode_1,
+		        total_pixels ? 100.0 * usage.pixels / total_pixels : 0.0,
+		        static_cast<unsigned long long>(usage.triangles),
+		        usage.is_fast_path ? ", fast path" : "");
+	}
+}
+
 #ifdef C_ENABLE_VOODOO_OPENGL
 /*-------------------------------------------------
     add_rasterizer - add a rasterizer to our
@@ -3639,7 +3983,9 @@ static void init_fbi(fbi_state* f, int fbmem)
 
 	// Align FBI memory to 64-bit, which is the maximum type written
 	constexpr auto mem_alignment = sizeof(uint64_t);
-	std::tie(f->ram_buffer, f->ram) = make_unique_aligned_array<uint8_t>(mem_alignment, fbmem);
+	f->ram_buffer = ZeroedBuffer(check_cast<size_t>(fbmem));
+	f->ram        = f->ram_buffer.data();
+	f->tracked_ram.Track(f->ram_buffer.data(), f->ram_buffer.size());
 	assert(reinterpret_cast<uintptr_t>(f->ram) % mem_alignment == 0);
 
 	f->mask = (uint32_t)(fbmem - 1);
@@ -3739,7 +4085,9 @@ static void init_tmu(voodoo_state *vs, tmu_state *t, voodoo_reg *reg, int tmem)
 
 	// Allocate and align the texture RAM to 64-bit, which is the maximum type written
 	constexpr auto mem_alignment = sizeof(uint64_t);
-	std::tie(t->ram_buffer, t->ram) = make_unique_aligned_array<uint8_t>(mem_alignment, tmem);
+	t->ram_buffer = ZeroedBuffer(check_cast<size_t>(tmem));
+	t->ram        = t->ram_buffer.data();
+	t->tracked_ram.Track(t->ram_buffer.data(), t->ram_buffer.size());
 	assert(reinterpret_cast<uintptr_t>(t->ram) % mem_alignment == 0);
 
 	t->mask = (uint32_t)(tmem - 1);
@@ -3953,6 +4301,7 @@ static void ncc_table_write(ncc_table *n, uint32_t regnum, uint32_t data)
 		if (n->palette[index] != palette_entry) {
 			/* set the ARGB for this palette index */
 			n->palette[index] = palette_entry;
+			++n->generation;
 #ifdef C_ENABLE_VOODOO_OPENGL
 			v->ogl_palette_changed = true;
 #endif
@@ -3961,6 +4310,8 @@ static void ncc_table_write(ncc_table *n, uint32_t regnum, uint32_t data)
 		/* if we have an ARGB palette as well, compute its value */
 		if (n->palettea != nullptr)
 		{
+			const rgb_t old_palettea_entry = n->palettea[index];
+
 			const uint32_t a = ((data >> 16) & 0xfc) |
 			                   ((data >> 22) & 0x03);
 
@@ -3974,6 +4325,9 @@ static void ncc_table_write(ncc_table *n, uint32_t regnum, uint32_t data)
 			                   ((data >> 4) & 0x03);
 
 			n->palettea[index] = MAKE_ARGB(a, r, g, b);
+			if (n->palettea[index] != old_palettea_entry) {
+				++n->generation;
+			}
 		}
 
 		/* this doesn't dirty the table or go to the registers, so bail */
@@ -4050,6 +4404,7 @@ static void ncc_table_update(ncc_table *n)
 
 	/* no longer dirty */
 	n->dirty = false;
+	++n->generation;
 }
 
 
@@ -4197,6 +4552,130 @@ static void recompute_texture_params(tmu_state *t)
 	//	E_Exit("Separate RGBA filters!"); // voodoo 2 feature not implemented
 }
 
+/*************************************
+ *
+ *  Decoded texture cache
+ *
+ *************************************/
+
+static uint32_t lod_num_texels(const tmu_state* t, const int lod)
+{
+	return ((t->wmask >> lod) + 1) * ((t->hmask >> lod) + 1);
+}
+
+static void decode_texture_lod(const tmu_state* t, decoded_texture& texture,
+                               const int lod)
+{
+	const auto base       = t->lodoffset[lod];
+	const auto num_texels = lod_num_texels(t, lod);
+	const auto lookup     = texture.lookup;
+	const auto out        = texture.texels.data() + texture.lod_start[lod];
+
+	/* the same fetches and lookups as the texture pipeline */
+	if (texture.format < 8) {
+		for (uint32_t i = 0; i < num_texels; ++i) {
+			out[i] = lookup[t->ram[(base + i) & t->mask]];
+		}
+	} else if (texture.format >= 10 && texture.format <= 12) {
+		for (uint32_t i = 0; i < num_texels; ++i) {
+			out[i] = lookup[*(uint16_t*)&t->ram[(base + 2 * i) & t->mask]];
+		}
+	} else {
+		for (uint32_t i = 0; i < num_texels; ++i) {
+			const uint32_t texel = *(uint16_t*)&t->ram[(base + 2 * i) & t->mask];
+			out[i] = (lookup[texel & 0xff] & 0xffffff) | ((texel & 0xff00) << 16);
+		}
+	}
+	texture.lods_decoded |= 1 << lod;
+}
+
+static decoded_texture& find_decoded_texture(tmu_state* t, const uint32_t format,
+                                             const uint32_t lookup_generation)
+{
+	for (auto& texture : t->decoded_textures) {
+		if (texture.valid && texture.base == t->lodoffset[0] &&
+		    texture.wmask == t->wmask && texture.hmask == t->hmask &&
+		    texture.lodmask == t->lodmask && texture.format == format &&
+		    texture.lookup == t->lookup &&
+		    texture.lookup_generation == lookup_generation) {
+			return texture;
+		}
+	}
+
+	/* replace the least recently used texture */
+	auto& texture = *std::min_element(t->decoded_textures.begin(),
+	                                  t->decoded_textures.end(),
+	                                  [](const auto& a, const auto& b) {
+		                                  return a.last_use < b.last_use;
+	                                  });
+	texture.valid             = true;
+	texture.base              = t->lodoffset[0];
+	texture.wmask             = t->wmask;
+	texture.hmask             = t->hmask;
+	texture.lodmask           = t->lodmask;
+	texture.format            = format;
+	texture.lookup            = t->lookup;
+	texture.lookup_generation = lookup_generation;
+	texture.num_uses          = 0;
+	texture.lods_decoded      = 0;
+
+	uint32_t num_texels = 0;
+	for (int lod = 0; lod <= 8; ++lod) {
+		texture.lod_start[lod] = num_texels;
+		num_texels += lod_num_texels(t, lod);
+	}
+	texture.texels.resize(num_texels);
+
+	const auto bppscale = format >> 3;
+	texture.ram_span = ((t->lodoffset[8] - t->lodoffset[0]) & t->mask) +
+	                   (lod_num_texels(t, 8) << bppscale);
+	return texture;
+}
+
+/* points the rasterizers at the decoded LODs of the current texture */
+static void select_decoded_texture(tmu_state* t)
+{
+	std::fill(std::begin(t->decoded_lod), std::end(t->decoded_lod), nullptr);
+	if (t->lookup == nullptr) {
+		return;
+	}
+
+	const auto format = TEXMODE_FORMAT(t->reg[textureMode].u);
+	const auto lookup_generation = t->ncc[0].generation + t->ncc[1].generation;
+
+	auto& texture    = find_decoded_texture(t, format, lookup_generation);
+	texture.last_use = ++t->decoded_uses;
+	if (++texture.num_uses < MinDecodedTextureUses) {
+		return;
+	}
+
+	/* decode the LODs the clamped LOD can select */
+	const int first_lod = t->lodmin >> 8;
+	const int last_lod  = std::min((t->lodmax >> 8) + 1, 8);
+	for (int lod = first_lod; lod <= last_lod; ++lod) {
+		if (((t->lodmask >> lod) & 1) == 0) {
+			continue;
+		}
+		if (((texture.lods_decoded >> lod) & 1) == 0) {
+			decode_texture_lod(t, texture, lod);
+		}
+		t->decoded_lod[lod] = texture.texels.data() + texture.lod_start[lod];
+	}
+}
+
+/* drops the decoded textures overlapping a 4-byte texture RAM write */
+static void invalidate_decoded_textures(tmu_state* t, const uint32_t address)
+{
+	for (auto& texture : t->decoded_textures) {
+		if (texture.valid &&
+		    (((address - texture.base) & t->mask) < texture.ram_span ||
+		     ((texture.base - address) & t->mask) < 4)) {
+			texture.valid    = false;
+			texture.last_use = 0;
+		}
+	}
+}
+
 static void prepare_tmu(tmu_state *t)
 {
 	int64_t texdx;
@@ -4236,6 +4715,8 @@ static void prepare_tmu(tmu_state *t)
 	/* get the log of the square root of texdx */
 	(void)fast_reciplog(texdx, &lodbase);
 	t->lodbasetemp = (-lodbase + (12 << 8)) / 2;
+
+	select_decoded_texture(t);
 }
 
 static inline int32_t round_coordinate(float value)
@@ -4302,28 +4783,32 @@ static void update_statistics(voodoo_state *vs, bool accumulate)
     COMMAND HANDLERS
 ***************************************************************************/
 
-static void triangle_worker_work(triangle_worker& tworker, int32_t worktstart, int32_t worktend)
+// Rasterizes a band of the current triangle, counting the statistics of the
+// thread drawing it separately
+static void triangle_worker_work(triangle_worker& tworker, const int band,
+                                 const int worker_id)
 {
-	/* determine the number of TMUs involved */
-	uint32_t tmus     = 0;
-	uint32_t texmode0 = 0;
-	uint32_t texmode1 = 0;
-	if (!FBIINIT3_DISABLE_TMUS(v->reg[fbiInit3].u) && FBZCP_TEXTURE_ENABLE(v->reg[fbzColorPath].u))
-	{
-		tmus = 1;
-		texmode0 = v->tmu[0].reg[textureMode].u;
-		if ((v->chipmask & 0x04) != 0)
-		{
-			tmus = 2;
-			texmode1 = v->tmu[1].reg[textureMode].u;
-		}
-		if (tworker.disable_bilinear_filter) //force disable bilinear filter
-		{
-			texmode0 &= ~6;
-			texmode1 &= ~6;
+	stats_block my_stats = {};
+
+	const int32_t first = (band == 0) ? 0 : tworker.band_ends[band - 1];
+	const int32_t last  = tworker.band_ends[band];
+
+	for (auto line = first; line != last; ++line) {
+		const auto& extent = tworker.extents[line];
+		if (extent.startx == extent.stopx) {
+			continue;
 		}
+		tworker.raster(v, tworker.texmode0, tworker.texmode1,
+		               tworker.drawbuf, tworker.v1y + line, &extent,
+		               my_stats);
 	}
+	sum_statistics(&v->thread_stats[worker_id], &my_stats);
+}
 
+// Computes the extents of the triangle's scanlines, and returns the number of
+// pixels they cover
+static int32_t triangle_worker_compute_extents(triangle_worker& tworker)
+{
 	/* compute the slopes for each portion of the triangle */
 	const poly_vertex v1 = tworker.v1;
 	const poly_vertex v2 = tworker.v2;
@@ -4336,17 +4821,14 @@ static void triangle_worker_work(triangle_worker& tworker, int32_t worktstart, i
 	const float dxdy_v2v3 = (v3.y == v2.y) ? 0.0f
 	                                       : (v3.x - v2.x) / (v3.y - v2.y);
 
-	stats_block my_stats = {};
-
-	const int32_t from = tworker.totalpix * worktstart / TRIANGLE_WORKERS;
-	const int32_t to   = tworker.totalpix * worktend / TRIANGLE_WORKERS;
-
-	for (int32_t curscan = tworker.v1y, scanend = tworker.v3y, sumpix = 0, lastsum = 0;
-	     curscan != scanend && lastsum < to;
-	     lastsum = sumpix, curscan++) {
-
-		const float fully = (float)(curscan) + 0.5f;
+	tworker.extents.resize(std::max(tworker.v3y - tworker.v1y, 0));
 
+	int32_t pixsum = 0;
+	auto extent    = tworker.extents.begin();
+	for (int32_t curscan = tworker.v1y, scanend = tworker.v3y;
+	     curscan < scanend;
+	     curscan++, extent++) {
+		const float fully  = (float)(curscan) + 0.5f;
 		const float startx = v1.x + (fully - v1.y) * dxdy_v1v3;
 
 		/* compute the ending X based on which part of the triangle we're in */
@@ -4355,138 +4837,118 @@ static void triangle_worker_work(triangle_worker& tworker, int32_t worktstart, i
 		                             : (v2.x + (fully - v2.y) * dxdy_v2v3));
 
 		/* clamp to full pixels */
-		poly_extent extent;
-		extent.startx = round_coordinate(startx);
-		extent.stopx = round_coordinate(stopx);
+		extent->startx = round_coordinate(startx);
+		extent->stopx  = round_coordinate(stopx);
 
 		/* force start < stop */
-		if (extent.startx >= extent.stopx)
-		{
-			if (extent.startx == extent.stopx) {
-				continue;
-			}
-			std::swap(extent.startx, extent.stopx);
+		if (extent->startx > extent->stopx) {
+			std::swap(extent->startx, extent->stopx);
 		}
-
-		sumpix += (extent.stopx - extent.startx);
-
-		if (sumpix <= from) {
-			continue;
-		}
-		if (lastsum < from) {
-			extent.startx += (from - lastsum);
-		}
-		if (sumpix > to) {
-			extent.stopx -= (sumpix - to);
-		}
-
-		raster_generic(v, tmus, texmode0, texmode1, tworker.drawbuf, curscan, &extent, my_stats);
+		pixsum += (extent->stopx - extent->startx);
 	}
-	sum_statistics(&v->thread_stats[worktstart], &my_stats);
+	return pixsum;
 }
 
-static int triangle_worker_thread_func(int32_t p)
+// Splits the scanlines into bands of about the same number of pixels
+static void triangle_worker_split_bands(triangle_worker& tworker,
+                                        const int32_t totalpix, const int num_bands)
 {
-	triangle_worker& tworker = v->tworker;
-	for (const int32_t tnum = p; tworker.threads_active;) {
-		tworker.sembegin[tnum].wait();
-		if (tworker.threads_active) {
-			triangle_worker_work(tworker, tnum, tnum + 1);
+	tworker.band_ends.clear();
+
+	const auto num_lines = static_cast<int32_t>(tworker.extents.size());
+
+	int64_t pixsum = 0;
+	for (int32_t line = 0; line != num_lines; ++line) {
+		const auto& extent = tworker.extents[line];
+		pixsum += (extent.stopx - extent.startx);
+
+		const auto band_end = static_cast<int64_t>(totalpix) *
+		                      static_cast<int64_t>(tworker.band_ends.size() + 1);
+		if (pixsum * num_bands >= band_end) {
+			tworker.band_ends.push_back(line + 1);
 		}
-		tworker.semdone.notify();
 	}
-	return 0;
+	if (tworker.band_ends.empty() || tworker.band_ends.back() != num_lines) {
+		tworker.band_ends.push_back(num_lines);
+	}
 }
 
-static void triangle_worker_shutdown(triangle_worker& tworker)
+// Selects the rasterizer for the registers' mode
+static void triangle_worker_select_rasterizer(triangle_worker& tworker)
 {
-	if (!tworker.threads_active) {
-		return;
-	}
-	tworker.threads_active = false;
-	for (size_t i = 0; i != TRIANGLE_THREADS; i++) {
-		tworker.sembegin[i].notify();
-	}
+	const auto regs = v->reg;
 
-	for (size_t i = 0; i != TRIANGLE_THREADS; i++) {
-		tworker.semdone.wait();
+	/* determine the number of TMUs involved */
+	uint32_t tmus     = 0;
+	uint32_t texmode0 = 0;
+	uint32_t texmode1 = 0;
+	if (!FBIINIT3_DISABLE_TMUS(regs[fbiInit3].u) && FBZCP_TEXTURE_ENABLE(regs[fbzColorPath].u))
+	{
+		tmus = 1;
+		texmode0 = v->tmu[0].reg[textureMode].u;
+		if ((v->chipmask & 0x04) != 0)
+		{
+			tmus = 2;
+			texmode1 = v->tmu[1].reg[textureMode].u;
+		}
+		if (tworker.disable_bilinear_filter) //force disable bilinear filter
+		{
+			texmode0 &= ~6;
+			texmode1 &= ~6;
+		}
 	}
+	tworker.texmode0 = texmode0;
+	tworker.texmode1 = texmode1;
 
-	for (auto& thread : tworker.threads) {
-		if (thread.joinable()) {
-			thread.join();
-		}
+	raster_mode mode = {};
+	mode.tmus        = tmus;
+	mode.color_path  = normalize_color_path(regs[fbzColorPath].u);
+	mode.alpha_mode  = normalize_alpha_mode(regs[alphaMode].u);
+	mode.fog_mode    = normalize_fog_mode(regs[fogMode].u);
+	mode.fbz_mode    = normalize_fbz_mode(regs[fbzMode].u);
+	mode.tex_mode_0  = (tmus >= 1) ? normalize_tex_mode(texmode0) : AnyMode;
+	mode.tex_mode_1  = (tmus >= 2) ? normalize_tex_mode(texmode1) : AnyMode;
+
+	// Consecutive triangles mostly share the mode
+	if (tworker.raster && mode == tworker.mode) {
+		return;
 	}
+	tworker.mode  = mode;
+	tworker.usage = &v->raster_modes[mode];
+	tworker.raster = find_raster_fast_path(mode, tworker.usage->is_fast_path);
 }
 
 static void triangle_worker_run(triangle_worker& tworker)
 {
-	if (!tworker.use_threads)
-	{
-		// do not use threaded calculation
-		tworker.totalpix = 0xFFFFFFF;
-		triangle_worker_work(tworker, 0, TRIANGLE_WORKERS);
-		return;
-	}
+	triangle_worker_select_rasterizer(tworker);
 
-	/* compute the slopes for each portion of the triangle */
-	const poly_vertex v1 = tworker.v1;
-	const poly_vertex v2 = tworker.v2;
-	const poly_vertex v3 = tworker.v3;
+	const auto totalpix = triangle_worker_compute_extents(tworker);
 
-	const float dxdy_v1v2 = (v2.y == v1.y) ? 0.0f
-	                                       : (v2.x - v1.x) / (v2.y - v1.y);
-	const float dxdy_v1v3 = (v3.y == v1.y) ? 0.0f
-	                                       : (v3.x - v1.x) / (v3.y - v1.y);
-	const float dxdy_v2v3 = (v3.y == v2.y) ? 0.0f
-	                                       : (v3.x - v2.x) / (v3.y - v2.y);
+	++tworker.usage->triangles;
+	tworker.usage->pixels += totalpix;
 
-	int32_t pixsum = 0;
-	for (int32_t curscan = tworker.v1y, scanend = tworker.v3y; curscan != scanend; curscan++)
-	{
-		const float fully  = (float)(curscan) + 0.5f;
-		const float startx = v1.x + (fully - v1.y) * dxdy_v1v3;
+	const auto num_workers = tworker.num_threads + 1;
+	const auto num_bands   = tworker.use_threads
+	                               ? std::clamp(totalpix / MinTriangleBandPixels,
+	                                            1,
+	                                            num_workers * BandsPerTriangleWorker)
+	                               : 1;
 
-		/* compute the ending X based on which part of the triangle we're in */
-		const float stopx = (fully < v2.y
-		                             ? (v1.x + (fully - v1.y) * dxdy_v1v2)
-		                             : (v2.x + (fully - v2.y) * dxdy_v2v3));
+	triangle_worker_split_bands(tworker, totalpix, num_bands);
 
-		/* clamp to full pixels */
-		const int32_t istartx = round_coordinate(startx);
-		const int32_t istopx  = round_coordinate(stopx);
-
-		/* force start < stop */
-		pixsum += (istartx > istopx ? istartx - istopx : istopx - istartx);
-	}
-	tworker.totalpix = pixsum;
-
-	// Don't wake up threads for just a few pixels
-	if (tworker.totalpix <= 200)
-	{
-		triangle_worker_work(tworker, 0, TRIANGLE_WORKERS);
+	// Small triangles are drawn without waking up any threads
+	const auto num_split_bands = static_cast<int>(tworker.band_ends.size());
+	if (num_split_bands == 1) {
+		triangle_worker_work(tworker, 0, 0);
 		return;
 	}
 
-	if (!tworker.threads_active)
-	{
-		tworker.threads_active = true;
-
-		int worker_id = 0;
-		for (auto& triangle_worker : tworker.threads) {
-			triangle_worker = std::thread([worker_id] {
-				triangle_worker_thread_func(worker_id);
-			});
-			++worker_id;
-		}
-	}
-	for (auto& begin_semaphore : tworker.sembegin) {
-		begin_semaphore.notify();
-	}
-	triangle_worker_work(tworker, TRIANGLE_THREADS, TRIANGLE_WORKERS);
-	for (size_t i = 0; i != TRIANGLE_THREADS; i++) {
-		tworker.semdone.wait();
-	}
+	// The participants index the per-thread statistics
+	WORKERS_ParallelFor(num_split_bands,
+	                    tworker.num_threads,
+	                    [&tworker](const int band, const int participant) {
+		                    triangle_worker_work(tworker, band, participant);
+	                    });
 }
 
 /*-------------------------------------------------
@@ -6663,7 +7125,7 @@ static int32_t texture_w(uint32_t offset, uint32_t data) {
 		dest = t->ram;
 		tbaseaddr &= t->mask;
 
-		[[maybe_unused]] bool changed = false;
+		bool changed = false;
 		if (dest[BYTE4_XOR_LE(tbaseaddr + 0)] != ((data >> 0) & 0xff)) {
 			dest[BYTE4_XOR_LE(tbaseaddr + 0)] = static_cast<uint8_t>((data >> 0) & 0xff);
 			changed = true;
@@ -6680,6 +7142,9 @@ static int32_t texture_w(uint32_t offset, uint32_t data) {
 			dest[BYTE4_XOR_LE(tbaseaddr + 3)] = static_cast<uint8_t>((data >> 24) & 0xff);
 			changed = true;
 		}
+		if (changed) {
+			invalidate_decoded_textures(t, tbaseaddr);
+		}
 
 #ifdef C_ENABLE_VOODOO_OPENGL
 		if (changed && v->ogl && v->active) {
@@ -6725,7 +7190,7 @@ static int32_t texture_w(uint32_t offset, uint32_t data) {
 		tbaseaddr &= t->mask;
 		tbaseaddr >>= 1;
 
-		[[maybe_unused]] bool changed = false;
+		bool changed = false;
 		if (dest[BYTE_XOR_LE(tbaseaddr + 0)] != ((data >> 0) & 0xffff)) {
 			dest[BYTE_XOR_LE(tbaseaddr + 0)] = static_cast<uint16_t>((data >> 0) & 0xffff);
 			changed = true;
@@ -6734,6 +7199,9 @@ static int32_t texture_w(uint32_t offset, uint32_t data) {
 			dest[BYTE_XOR_LE(tbaseaddr + 1)] = static_cast<uint16_t>((data >> 16) & 0xffff);
 			changed = true;
 		}
+		if (changed) {
+			invalidate_decoded_textures(t, tbaseaddr << 1);
+		}
 
 #ifdef C_ENABLE_VOODOO_OPENGL
 		if (changed && v->ogl && v->active) {
@@ -6949,7 +7417,8 @@ constexpr uint32_t next_addr(const uint32_t addr)
 	return addr + next_offset;
 }
 
-static void voodoo_w(const uint32_t addr, const uint32_t data, const uint32_t mask)
+static void execute_write(const uint32_t addr, const uint32_t data,
+                          const uint32_t mask)
 {
 	const auto offset = (addr >> 2) & offset_mask;
 
@@ -6962,8 +7431,230 @@ static void voodoo_w(const uint32_t addr, const uint32_t data, const uint32_t ma
 	}
 }
 
-static constexpr uint32_t voodoo_r(const uint32_t addr)
+/***************************************************************************
+    COMMAND THREAD
+***************************************************************************/
+
+// The guest's writes are executed on the Voodoo's own thread, so triangles
+// and fast fills are drawn while the emulation carries on, like the real card
+// working through its PCI FIFO. The emulation thread collects the writes in
+// batches and hands them over at the drawing commands. It only catches up
+// with the thread where the guest can observe the card's state: on register
+// and LFB reads, on the writes that change the video timing or the DAC, and
+// at the vertical retrace, where the swapped buffers are shown.
+
+struct VoodooWrite {
+	uint32_t addr = 0;
+	uint32_t data = 0;
+	uint32_t mask = 0;
+};
+
+// Hand a batch over once this many writes have been collected
+constexpr size_t VoodooWriteBatchSize = 1024;
+
+// The guest stalls once this many writes are queued, like on a full FIFO
+constexpr size_t MaxQueuedVoodooWrites = 64 * 1024;
+
+class VoodooCommandThread {
+public:
+	void Start();
+	void Stop();
+
+	bool IsRunning() const
+	{
+		return thread.joinable();
+	}
+
+	void Queue(const VoodooWrite& write);
+
+	// Hands the collected writes over to the thread
+	void Flush();
+
+	// Returns once the thread has executed all the writes
+	void WaitUntilIdle();
+
+private:
+	void Run();
+
+	// Only used by the emulation thread
+	std::vector<VoodooWrite> batch = {};
+
+	// Only used by the command thread
+	std::vector<VoodooWrite> executing = {};
+
+	std::vector<VoodooWrite> queued    = {};
+	std::mutex mutex                   = {};
+	std::condition_variable has_writes = {};
+	std::condition_variable progressed = {};
+	bool is_busy                       = false;
+	bool should_stop                   = false;
+
+	std::thread thread = {};
+};
+
+static VoodooCommandThread command_thread;
+
+void VoodooCommandThread::Start()
+{
+	assert(!IsRunning());
+
+	should_stop = false;
+	thread      = std::thread(&VoodooCommandThread::Run, this);
+	set_thread_name(thread, "dosbox:voodoo");
+	HOST_THREADS_Apply(thread, HostThreadGroup::Worker);
+}
+
+void VoodooCommandThread::Stop()
+{
+	if (!IsRunning()) {
+		return;
+	}
+	WaitUntilIdle();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		should_stop = true;
+	}
+	has_writes.notify_one();
+	thread.join();
+}
+
+void VoodooCommandThread::Queue(const VoodooWrite& write)
+{
+	batch.push_back(write);
+	if (batch.size() >= VoodooWriteBatchSize) {
+		Flush();
+	}
+}
+
+void VoodooCommandThread::Flush()
 {
+	if (batch.empty()) {
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		progressed.wait(lock, [this] {
+			return queued.size() < MaxQueuedVoodooWrites;
+		});
+		if (queued.empty()) {
+			std::swap(queued, batch);
+		} else {
+			queued.insert(queued.end(), batch.begin(), batch.end());
+			batch.clear();
+		}
+	}
+	has_writes.notify_one();
+}
+
+void VoodooCommandThread::WaitUntilIdle()
+{
+	Flush();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	progressed.wait(lock, [this] { return queued.empty() && !is_busy; });
+}
+
+void VoodooCommandThread::Run()
+{
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			is_busy = false;
+			progressed.notify_all();
+
+			has_writes.wait(lock, [this] {
+				return should_stop || !queued.empty();
+			});
+			if (should_stop) {
+				return;
+			}
+			executing.clear();
+			std::swap(executing, queued);
+			is_busy = true;
+		}
+		// The queue has room again
+		progressed.notify_all();
+
+		for (const auto& write : executing) {
+			execute_write(write.addr, write.data, write.mask);
+		}
+	}
+}
+
+// Catches up with the command thread before the emulation thread accesses
+// the card's state
+static void wait_for_voodoo_commands()
+{
+	if (command_thread.IsRunning()) {
+		command_thread.WaitUntilIdle();
+	}
+}
+
+// The writes handled with the emulation thread's state, like its timers
+static bool is_synchronous_register(const uint32_t offset)
+{
+	if ((offset & offset_base) != 0) {
+		return false;
+	}
+	switch (offset & 0xff) {
+	case hSync:
+	case vSync:
+	case backPorch:
+	case videoDimensions:
+	case clutData:
+	case dacData:
+	case fbiInit0:
+	case fbiInit1:
+	case fbiInit2:
+	case fbiInit3:
+	case fbiInit4:
+	case fbiInit5:
+	case fbiInit6: return true;
+	default: return false;
+	}
+}
+
+// The writes that start drawing, after which the thread has work to do
+static bool is_command_register(const uint32_t offset)
+{
+	if ((offset & offset_base) != 0) {
+		return false;
+	}
+	switch (offset & 0xff) {
+	case triangleCMD:
+	case ftriangleCMD:
+	case sDrawTriCMD:
+	case fastfillCMD:
+	case swapbufferCMD: return true;
+	default: return false;
+	}
+}
+
+static void voodoo_w(const uint32_t addr, const uint32_t data, const uint32_t mask)
+{
+	if (!command_thread.IsRunning()) {
+		execute_write(addr, data, mask);
+		return;
+	}
+
+	const auto offset = (addr >> 2) & offset_mask;
+
+	if (is_synchronous_register(offset)) {
+		command_thread.WaitUntilIdle();
+		execute_write(addr, data, mask);
+		return;
+	}
+
+	command_thread.Queue({addr, data, mask});
+	if (is_command_register(offset)) {
+		command_thread.Flush();
+	}
+}
+
+static uint32_t voodoo_r(const uint32_t addr)
+{
+	wait_for_voodoo_commands();
+
 	const auto offset = (addr >> 2) & offset_mask;
 
 	if ((offset & offset_base) == 0) {
@@ -7200,6 +7891,9 @@ static void voodoo_update_dimensions(void) {
 
 static void Voodoo_VerticalTimer(uint32_t /*val*/)
 {
+	// Show the frame as the guest has drawn it so far
+	wait_for_voodoo_commands();
+
 	v->draw.frame_start = PIC_FullIndex();
 	PIC_AddEvent(Voodoo_VerticalTimer, v->draw.frame_period_ms);
 
@@ -7639,6 +8333,7 @@ struct PCI_SSTDevice : public PCI_Device {
 			return value;
 		case 0x40:
 			Voodoo_Startup();
+			wait_for_voodoo_commands();
 			v->pci.init_enable = (uint32_t)(value & 7);
 			break;
 		case 0x41:
@@ -7646,11 +8341,13 @@ struct PCI_SSTDevice : public PCI_Device {
 		case 0x43: return -1;
 		case 0xc0:
 			Voodoo_Startup();
+			wait_for_voodoo_commands();
 			v->clock_enabled = true;
 			Voodoo_UpdateScreenStart();
 			return -1;
 		case 0xe0:
 			Voodoo_Startup();
+			wait_for_voodoo_commands();
 			v->clock_enabled = false;
 			Voodoo_UpdateScreenStart();
 			return -1;
@@ -7705,6 +8402,8 @@ static void voodoo_shutdown()
 	}
 	LOG_MSG("VOODOO: Shutting down");
 
+	command_thread.Stop();
+
 #ifdef C_ENABLE_VOODOO_OPENGL
 	if (v->ogl) {
 		voodoo_ogl_shutdown(v);
@@ -7712,7 +8411,7 @@ static void voodoo_shutdown()
 #endif
 
 	v->active = false;
-	triangle_worker_shutdown(v->tworker);
+	log_raster_mode_usage(v);
 
 	delete v;
 	v = nullptr;
@@ -7731,8 +8430,19 @@ static void Voodoo_Startup() {
 	v->draw = {};
 
 	v->tworker.use_threads = voodoo_multithreading;
+	v->tworker.num_threads = std::min(WORKERS_GetNumThreads(),
+	                                  MaxTriangleWorkers - 1);
 	v->tworker.disable_bilinear_filter = (voodoo_bilinear_filtering == false);
 
+	// The OpenGL calls have to be made on the emulation thread
+	auto use_command_thread = voodoo_multithreading;
+#ifdef C_ENABLE_VOODOO_OPENGL
+	use_command_thread = use_command_thread && !v->ogl;
+#endif
+	if (use_command_thread) {
+		command_thread.Start();
+	}
+
 	// Switch the pagehandler now that v has been allocated and is in use
 	voodoo_pagehandler = &voodoo_real_pagehandler;
 	PAGING_InitTLB();
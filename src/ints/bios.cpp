@@ -23,6 +23,7 @@
 #include "callback.h"
 #include "control.h"
 #include "cpu.h"
+#include "cross.h"
 #include "dosbox.h"
 #include "dos_memory.h"
 #include "hardware.h"
@@ -34,6 +35,7 @@
 #include "mouse.h"
 #include "pic.h"
 #include "regs.h"
+#include "replay.h"
 #include "serialport.h"
 #include "setup.h"
 
@@ -43,12 +45,6 @@
 // Constants
 constexpr uint32_t BiosMachineSignatureAddress = 0xfffff;
 
-#if defined(HAVE_CLOCK_GETTIME) && !defined(WIN32)
-// time.h is already included
-#else
-#include <sys/timeb.h>
-#endif
-
 // Reference:
 // - Ralf Brown's Interrupt List
 // - https://www.stanislavs.org/helppc/idx_interrupt.html
@@ -402,25 +398,14 @@ static Bitu INT11_Handler(void) {
 #endif
 
 static void BIOS_HostTimeSync() {
-	uint32_t milli = 0;
-	// TODO investigate if clock_gettime and ftime can be replaced
-	// by using C++11 chrono
-#if defined(HAVE_CLOCK_GETTIME) && !defined(WIN32)
-	struct timespec tp;
-	clock_gettime(CLOCK_REALTIME,&tp);
-
-	struct tm *loctime;
-	loctime = localtime(&tp.tv_sec);
-	milli = (uint32_t) (tp.tv_nsec / 1000000);
-#else
-	/* Setup time and date */
-	struct timeb timebuffer;
-	ftime(&timebuffer);
-
-	struct tm *loctime;
-	loctime = localtime (&timebuffer.time);
-	milli = (uint32_t) timebuffer.millitm;
-#endif
+	// The host time, or the recorded one while recording or replaying
+	const auto now_ms = REPLAY_GetWallClockMs();
+	const auto now_s  = static_cast<time_t>(now_ms / 1000);
+	const auto milli  = static_cast<uint32_t>(now_ms % 1000);
+
+	struct tm datetime = {};
+	cross::localtime_r(&now_s, &datetime);
+	const auto loctime = &datetime;
 	/*
 	loctime->tm_hour = 23;
 	loctime->tm_min = 59;
@@ -1262,10 +1247,12 @@ public:
 		/* INT 11 Get equipment list */
 		callback[1].Install(&INT11_Handler,CB_IRET,"Int 11 Equipment");
 		callback[1].Set_RealVec(0x11);
+		CALLBACK_SetMayRunInline(callback[1].Get_callback(), true);
 
 		/* INT 12 Memory Size default at 640 kb */
 		callback[2].Install(&INT12_Handler,CB_IRET,"Int 12 Memory");
 		callback[2].Set_RealVec(0x12);
+		CALLBACK_SetMayRunInline(callback[2].Get_callback(), true);
 		if (machine == MCH_TANDY) {
 			/* reduce reported memory size for the Tandy (32k graphics memory
 			   at the end of the conventional 640k) */
@@ -1308,6 +1295,8 @@ public:
 		/* INT 1A TIME and some other functions */
 		callback[6].Install(&INT1A_Handler,CB_IRET_STI,"Int 1a Time");
 		callback[6].Set_RealVec(0x1A);
+		// polled in tight timing loops by many games
+		CALLBACK_SetMayRunInline(callback[6].Get_callback(), true);
 
 		/* INT 1C System Timer tick called from INT 8 */
 		callback[7].Install(&INT1C_Handler,CB_IRET,"Int 1c Timer");
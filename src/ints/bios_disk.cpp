@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <cassert>
 #include <utility>
+#include <vector>
 
 #include "callback.h"
 #include "regs.h"
@@ -29,6 +30,7 @@
 #include "drives.h"
 #include "mapper.h"
 #include "string_utils.h"
+#include "tracy.h"
 
 diskGeo DiskGeometryList[] = {
 	{ 160,  8, 1, 40, 0},	// SS/DD 5.25"
@@ -157,25 +159,50 @@ void swapInNextDisk(bool pressed) {
 
 
 uint8_t imageDisk::Read_Sector(uint32_t head,uint32_t cylinder,uint32_t sector,void * data) {
+	return Read_Sectors(head, cylinder, sector, 1, data);
+}
+
+uint8_t imageDisk::Read_Sectors(uint32_t head, uint32_t cylinder, uint32_t sector,
+                                uint32_t num_sectors, void* data)
+{
 	uint32_t sectnum;
 
 	sectnum = ( (cylinder * heads + head) * sectors ) + sector - 1L;
 
-	return Read_AbsoluteSector(sectnum, data);
+	return Read_AbsoluteSectors(sectnum, num_sectors, data);
 }
 
 uint8_t imageDisk::Read_AbsoluteSector(uint32_t sectnum, void *data)
 {
-	const auto bytenum = check_cast<cross_off_t>(sectnum) * sector_size;
+	return Read_AbsoluteSectors(sectnum, 1, data);
+}
+
+uint8_t imageDisk::Read_AbsoluteSectors(uint32_t sectnum, uint32_t num_sectors,
+                                        void* data)
+{
+	ZoneScoped;
+	const auto bytenum   = check_cast<cross_off_t>(sectnum) * sector_size;
+	const auto num_bytes = static_cast<size_t>(num_sectors) * sector_size;
+
+	if (overlay) {
+		return ReadWithOverlay(bytenum, num_bytes, data);
+	}
+	return ReadImage(bytenum, num_bytes, data);
+}
 
+uint8_t imageDisk::ReadImage(const cross_off_t bytenum, const size_t num_bytes,
+                             void* data)
+{
 	if (last_action == WRITE || bytenum != current_fpos) {
 		if (cross_fseeko(diskimg, bytenum, SEEK_SET) != 0) {
-			LOG_ERR("BIOSDISK: Could not seek to sector %u in file '%s': %s",
-			        sectnum, diskname, strerror(errno));
+			LOG_ERR("BIOSDISK: Could not seek to byte %lld in file '%s': %s",
+			        static_cast<long long int>(bytenum),
+			        diskname,
+			        strerror(errno));
 			return 0xff;
 		}
 	}
-	size_t ret = fread(data, 1, sector_size, diskimg);
+	size_t ret = fread(data, 1, num_bytes, diskimg);
 	current_fpos=bytenum+ret;
 	last_action=READ;
 
@@ -183,19 +210,42 @@ uint8_t imageDisk::Read_AbsoluteSector(uint32_t sectnum, void *data)
 }
 
 uint8_t imageDisk::Write_Sector(uint32_t head,uint32_t cylinder,uint32_t sector,void * data) {
+	return Write_Sectors(head, cylinder, sector, 1, data);
+}
+
+uint8_t imageDisk::Write_Sectors(uint32_t head, uint32_t cylinder, uint32_t sector,
+                                 uint32_t num_sectors, const void* data)
+{
 	uint32_t sectnum;
 
 	sectnum = ( (cylinder * heads + head) * sectors ) + sector - 1L;
 
-	return Write_AbsoluteSector(sectnum, data);
+	return Write_AbsoluteSectors(sectnum, num_sectors, data);
 }
 
 
 uint8_t imageDisk::Write_AbsoluteSector(uint32_t sectnum, void *data) {
-	const auto bytenum = check_cast<cross_off_t>(sectnum) * sector_size;
+	return Write_AbsoluteSectors(sectnum, 1, data);
+}
+
+uint8_t imageDisk::Write_AbsoluteSectors(uint32_t sectnum, uint32_t num_sectors,
+                                         const void* data)
+{
+	ZoneScoped;
+	const auto bytenum   = check_cast<cross_off_t>(sectnum) * sector_size;
+	const auto num_bytes = static_cast<size_t>(num_sectors) * sector_size;
 
 	//LOG_MSG("Writing sectors to %ld at bytenum %d", sectnum, bytenum);
 
+	if (overlay) {
+		return WriteToOverlay(bytenum, num_bytes, data);
+	}
+	return WriteImage(bytenum, num_bytes, data);
+}
+
+uint8_t imageDisk::WriteImage(const cross_off_t bytenum, const size_t num_bytes,
+                              const void* data)
+{
 	if (last_action == READ || bytenum != current_fpos) {
 		if (cross_fseeko(diskimg, bytenum, SEEK_SET) != 0) {
 			LOG_ERR("BIOSDISK: Could not seek to byte %lld in file '%s': %s",
@@ -205,7 +255,7 @@ uint8_t imageDisk::Write_AbsoluteSector(uint32_t sectnum, void *data) {
 			return 0xff;
 		}
 	}
-	size_t ret = fwrite(data, 1, sector_size, diskimg);
+	size_t ret = fwrite(data, 1, num_bytes, diskimg);
 	current_fpos=bytenum+ret;
 	last_action=WRITE;
 
@@ -213,6 +263,86 @@ uint8_t imageDisk::Write_AbsoluteSector(uint32_t sectnum, void *data) {
 
 }
 
+bool imageDisk::AttachOverlay(const std::string& path)
+{
+	if (sector_size == 0 || sector_size % DiskImageOverlay::BlockSize != 0) {
+		LOG_ERR("BIOSDISK: Overlays of images with %u-byte sectors are not supported",
+		        sector_size);
+		return false;
+	}
+	overlay = DiskImageOverlay::Open(path, image_size_kb);
+	if (!overlay) {
+		LOG_ERR("BIOSDISK: Could not open '%s' as an overlay of image '%s'",
+		        path.c_str(),
+		        diskname);
+		return false;
+	}
+	LOG_MSG("BIOSDISK: Writing the changes to image '%s' to overlay '%s' (%u blocks)",
+	        diskname,
+	        path.c_str(),
+	        static_cast<unsigned>(overlay->GetNumBlocks()));
+	return true;
+}
+
+uint8_t imageDisk::ReadWithOverlay(const cross_off_t bytenum,
+                                   const size_t num_bytes, void* data)
+{
+	constexpr auto BlockSize = DiskImageOverlay::BlockSize;
+
+	const auto first_block = check_cast<uint32_t>(bytenum / BlockSize);
+	const auto num_blocks  = check_cast<uint32_t>(num_bytes / BlockSize);
+
+	auto block_data = static_cast<uint8_t*>(data);
+
+	uint32_t i = 0;
+	while (i < num_blocks) {
+		if (overlay->Contains(first_block + i)) {
+			if (!overlay->Read(first_block + i, block_data + i * BlockSize)) {
+				return 0xff;
+			}
+			++i;
+			continue;
+		}
+		// Read the run of blocks that aren't in the overlay from the
+		// image in one go
+		auto end = i + 1;
+		while (end < num_blocks && !overlay->Contains(first_block + end)) {
+			++end;
+		}
+		const auto block_bytenum = static_cast<cross_off_t>(first_block + i) *
+		                           BlockSize;
+		if (const auto result = ReadImage(block_bytenum,
+		                                  (end - i) * BlockSize,
+		                                  block_data + i * BlockSize);
+		    result != 0) {
+			return result;
+		}
+		i = end;
+	}
+	return 0x00;
+}
+
+uint8_t imageDisk::WriteToOverlay(const cross_off_t bytenum,
+                                  const size_t num_bytes, const void* data)
+{
+	constexpr auto BlockSize = DiskImageOverlay::BlockSize;
+
+	const auto first_block = check_cast<uint32_t>(bytenum / BlockSize);
+	const auto num_blocks  = check_cast<uint32_t>(num_bytes / BlockSize);
+
+	auto block_data = static_cast<const uint8_t*>(data);
+
+	for (uint32_t i = 0; i < num_blocks; ++i) {
+		if (!overlay->Write(first_block + i, block_data + i * BlockSize)) {
+			LOG_ERR("BIOSDISK: Could not write block %u to the overlay of image '%s'",
+			        first_block + i,
+			        diskname);
+			return 0x05;
+		}
+	}
+	return 0x00;
+}
+
 imageDisk::imageDisk(FILE *img_file, const char *img_name, uint32_t img_size_k, bool is_hdd)
         : hardDrive(is_hdd),
           active(false),
@@ -223,7 +353,8 @@ imageDisk::imageDisk(FILE *img_file, const char *img_name, uint32_t img_size_k,
           cylinders(0),
           sectors(0),
           current_fpos(0),
-          last_action(NONE)
+          last_action(NONE),
+          image_size_kb(img_size_k)
 {
 	fseek(diskimg,0,SEEK_SET);
 	memset(diskname,0,512);
@@ -326,11 +457,98 @@ static bool has_image(const std::array<T, N> &arr) {
 	return std::any_of(std::begin(arr), std::end(arr), to_bool);
 }
 
+// Copy to and from the real-mode buffer at seg:offset, wrapping the offset
+// within the segment like a byte-by-byte copy would
+static void write_to_segment(const uint16_t seg, uint16_t offset,
+                             const uint8_t* data, size_t num_bytes)
+{
+	while (num_bytes > 0) {
+		const auto chunk = std::min<size_t>(num_bytes, 0x10000 - offset);
+		MEM_BlockWrite(PhysicalMake(seg, offset), data, chunk);
+		data += chunk;
+		num_bytes -= chunk;
+		offset = 0;
+	}
+}
+
+static void read_from_segment(const uint16_t seg, uint16_t offset,
+                              uint8_t* data, size_t num_bytes)
+{
+	while (num_bytes > 0) {
+		const auto chunk = std::min<size_t>(num_bytes, 0x10000 - offset);
+		MEM_BlockRead(PhysicalMake(seg, offset), data, chunk);
+		data += chunk;
+		num_bytes -= chunk;
+		offset = 0;
+	}
+}
+
+// Runs a sector read straight into the caller's seg:offset buffer when it's
+// one run of plain host memory within the segment, otherwise through a bounce
+// buffer that's only copied out if the read succeeds
+template <typename ReadSectors>
+static uint8_t read_to_segment(const uint16_t seg, const uint16_t offset,
+                               const size_t num_bytes, ReadSectors read_sectors)
+{
+	if (offset + num_bytes <= 0x10000) {
+		const auto dest = PhysicalMake(seg, offset);
+		if (const auto host_ptr = MEM_GetHostWritePtr(dest, num_bytes)) {
+			return read_sectors(host_ptr);
+		}
+	}
+	std::vector<uint8_t> buffer(num_bytes);
+	const auto status = read_sectors(buffer.data());
+	if (status == 0x00) {
+		write_to_segment(seg, offset, buffer.data(), num_bytes);
+	}
+	return status;
+}
+
+// The disk address packet of the extended INT 13h functions
+struct DiskAddressPacket {
+	uint16_t num_sectors = 0;
+	uint16_t buffer_offset = 0;
+	uint16_t buffer_segment = 0;
+	uint64_t lba = 0;
+};
+
+static DiskAddressPacket read_disk_address_packet(const uint16_t seg, const uint16_t off)
+{
+	DiskAddressPacket packet = {};
+	packet.num_sectors    = real_readw(seg, off + 2);
+	packet.buffer_offset  = real_readw(seg, off + 4);
+	packet.buffer_segment = real_readw(seg, off + 6);
+	packet.lba            = real_readq(seg, off + 8);
+	return packet;
+}
+
+static uint64_t get_total_sectors(imageDisk& disk)
+{
+	uint32_t heads, cyls, sects, sect_size;
+	disk.Get_Geometry(&heads, &cyls, &sects, &sect_size);
+	return static_cast<uint64_t>(heads) * cyls * sects;
+}
+
+// Checks an extended read, write or verify against the disk, setting the
+// error status if it's out of range
+static bool is_valid_extended_transfer(const uint8_t drivenum,
+                                       const DiskAddressPacket& packet)
+{
+	// The packet can't describe more than 127 sectors (EDD 1.1)
+	if (packet.num_sectors == 0 || packet.num_sectors > 0x7f) {
+		last_status = 0x01;
+		return false;
+	}
+	const auto total = get_total_sectors(*imageDiskList[drivenum]);
+	if (packet.lba >= total || packet.num_sectors > total - packet.lba) {
+		last_status = 0x04; // sector not found
+		return false;
+	}
+	return true;
+}
+
 static Bitu INT13_DiskHandler(void) {
-	uint16_t segat, bufptr;
-	uint8_t sectbuf[512];
 	uint8_t  drivenum;
-	Bitu t;
 	last_drive = reg_dl;
 	drivenum = GetDosDriveNumber(reg_dl);
 	const bool any_images = has_image(imageDiskList);
@@ -410,21 +628,24 @@ static Bitu INT13_DiskHandler(void) {
 			return CBRET_NONE;
 		}
 
-		segat = SegValue(es);
-		bufptr = reg_bx;
-		for (Bitu i = 0; i < reg_al; i++) {
-			last_status = imageDiskList[drivenum]->Read_Sector((uint32_t)reg_dh, (uint32_t)(reg_ch | ((reg_cl & 0xc0)<< 2)), (uint32_t)((reg_cl & 63)+i), sectbuf);
-			if((last_status != 0x00) || (killRead)) {
+		{
+			// All the sectors are read with one host call, straight
+			// into the caller's buffer where possible
+			auto& disk = *imageDiskList[drivenum];
+			const auto num_bytes = reg_al * disk.getSectSize();
+			auto read_sectors = [&](void* data) {
+				return disk.Read_Sectors((uint32_t)reg_dh, (uint32_t)(reg_ch | ((reg_cl & 0xc0)<< 2)), (uint32_t)(reg_cl & 63), reg_al, data);
+			};
+			// The first read after setting the disk type fails, see AH=17h
+			last_status = killRead ? 0xff
+			                       : read_to_segment(SegValue(es), reg_bx, num_bytes, read_sectors);
+			if (last_status != 0x00) {
 				LOG_MSG("Error in disk read");
 				killRead = false;
 				reg_ah = 0x04;
 				CALLBACK_SCF(true);
 				return CBRET_NONE;
 			}
-			for(t=0;t<512;t++) {
-				real_writeb(segat,bufptr,sectbuf[t]);
-				bufptr++;
-			}
 		}
 		reg_ah = 0x00;
 		CALLBACK_SCF(false);
@@ -435,13 +656,11 @@ static Bitu INT13_DiskHandler(void) {
 			CALLBACK_SCF(true);
 			return CBRET_NONE;
 		}
-		bufptr = reg_bx;
-		for (Bitu i = 0; i < reg_al; i++) {
-			for(t=0;t<imageDiskList[drivenum]->getSectSize();t++) {
-				sectbuf[t] = real_readb(SegValue(es),bufptr);
-				bufptr++;
-			}
-			last_status = imageDiskList[drivenum]->Write_Sector((uint32_t)reg_dh, (uint32_t)(reg_ch | ((reg_cl & 0xc0) << 2)), (uint32_t)((reg_cl & 63) + i), &sectbuf[0]);
+		{
+			std::vector<uint8_t> buffer(reg_al * imageDiskList[drivenum]->getSectSize());
+			read_from_segment(SegValue(es), reg_bx, buffer.data(), buffer.size());
+
+			last_status = imageDiskList[drivenum]->Write_Sectors((uint32_t)reg_dh, (uint32_t)(reg_ch | ((reg_cl & 0xc0) << 2)), (uint32_t)(reg_cl & 63), reg_al, buffer.data());
 			if(last_status != 0x00) {
 				CALLBACK_SCF(true);
 				return CBRET_NONE;
@@ -582,6 +801,104 @@ static Bitu INT13_DiskHandler(void) {
 		reg_ah = 0x00;
 		CALLBACK_SCF(false);
 		break;
+	case 0x41: /* Check extensions present */
+		if (reg_bx != 0x55aa || driveInactive(drivenum)) {
+			reg_ah = 0x01;
+			CALLBACK_SCF(true);
+			return CBRET_NONE;
+		}
+		reg_bx = 0xaa55;
+		reg_ah = 0x21; // EDD 1.1
+		reg_cx = 0x0001; // fixed disk access subset: functions 42h to 48h
+		last_status = 0x00;
+		CALLBACK_SCF(false);
+		break;
+	case 0x42: /* Extended read sectors */
+	case 0x43: /* Extended write sectors */
+	case 0x44: /* Extended verify sectors */
+		{
+			if (driveInactive(drivenum)) {
+				reg_ah = last_status;
+				return CBRET_NONE;
+			}
+			const auto packet = read_disk_address_packet(SegValue(ds), reg_si);
+			if (!is_valid_extended_transfer(drivenum, packet)) {
+				real_writew(SegValue(ds), reg_si + 2, 0);
+				reg_ah = last_status;
+				CALLBACK_SCF(true);
+				return CBRET_NONE;
+			}
+
+			auto& disk = *imageDiskList[drivenum];
+			const auto sectnum   = static_cast<uint32_t>(packet.lba);
+			const auto num_bytes = packet.num_sectors * disk.getSectSize();
+
+			// The whole packet is a single host read or write
+			if (reg_ah == 0x42) {
+				auto read_sectors = [&](void* data) {
+					return disk.Read_AbsoluteSectors(sectnum, packet.num_sectors, data);
+				};
+				last_status = read_to_segment(packet.buffer_segment,
+				                              packet.buffer_offset,
+				                              num_bytes,
+				                              read_sectors);
+			} else if (reg_ah == 0x43) {
+				std::vector<uint8_t> buffer(num_bytes);
+				read_from_segment(packet.buffer_segment, packet.buffer_offset, buffer.data(), num_bytes);
+				last_status = disk.Write_AbsoluteSectors(sectnum, packet.num_sectors, buffer.data());
+			} else {
+				last_status = 0x00;
+			}
+			if (last_status != 0x00) {
+				LOG_MSG("Error in extended disk %s", reg_ah == 0x42 ? "read" : "write");
+				real_writew(SegValue(ds), reg_si + 2, 0);
+				last_status = reg_ah == 0x42 ? 0x04 : 0xcc;
+				reg_ah = last_status;
+				CALLBACK_SCF(true);
+				return CBRET_NONE;
+			}
+		}
+		reg_ah = 0x00;
+		CALLBACK_SCF(false);
+		break;
+	case 0x47: /* Extended seek */
+		if (driveInactive(drivenum)) {
+			reg_ah = last_status;
+			return CBRET_NONE;
+		}
+		last_status = 0x00;
+		reg_ah = 0x00;
+		CALLBACK_SCF(false);
+		break;
+	case 0x48: /* Get extended drive parameters */
+		{
+			if (driveInactive(drivenum)) {
+				reg_ah = last_status;
+				return CBRET_NONE;
+			}
+			const auto seg = SegValue(ds);
+			if (real_readw(seg, reg_si) < 0x1a) {
+				last_status = 0x01;
+				reg_ah = last_status;
+				CALLBACK_SCF(true);
+				return CBRET_NONE;
+			}
+			auto& disk = *imageDiskList[drivenum];
+			uint32_t heads, cyls, sects, sect_size;
+			disk.Get_Geometry(&heads, &cyls, &sects, &sect_size);
+
+			real_writew(seg, reg_si + 0x00, 0x1a); // size of the returned data
+			real_writew(seg, reg_si + 0x02, 0x0002); // the geometry is valid
+			real_writed(seg, reg_si + 0x04, cyls);
+			real_writed(seg, reg_si + 0x08, heads);
+			real_writed(seg, reg_si + 0x0c, sects);
+			real_writeq(seg, reg_si + 0x10, get_total_sectors(disk));
+			real_writew(seg, reg_si + 0x18, check_cast<uint16_t>(disk.getSectSize()));
+		}
+		last_status = 0x00;
+		reg_ah = 0x00;
+		CALLBACK_SCF(false);
+		break;
 	default:
 		LOG(LOG_BIOS,LOG_ERROR)("INT13: Function %x called on drive %x (dos drive %d)", reg_ah,  reg_dl, drivenum);
 		reg_ah=0xff;
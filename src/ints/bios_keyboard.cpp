@@ -652,7 +652,9 @@ void BIOS_SetupKeyboard(void) {
 	InitBiosSegment();
 
 	/* Allocate/setup a callback for int 0x16 and for standard IRQ 1 handler */
-	call_int16=CALLBACK_Allocate();	
+	// the keyboard polling of games is hot, and only changes IP
+	constexpr auto MayRunInline = true;
+	call_int16 = CALLBACK_Allocate(MayRunInline);
 	CALLBACK_Setup(call_int16,&INT16_Handler,CB_INT16,"Keyboard");
 	RealSetVec(0x16,CALLBACK_RealPointer(call_int16));
 
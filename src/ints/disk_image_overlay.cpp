@@ -0,0 +1,143 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "disk_image_overlay.h"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+
+#include "mem_host.h"
+
+constexpr char Magic[8] = {'D', 'B', 'O', 'X', 'D', 'E', 'L', 'T'};
+
+constexpr uint32_t Version = 1;
+
+// The magic, version, block size, base image size in KB, and a reserved field
+constexpr size_t HeaderSize = sizeof(Magic) + 4 * sizeof(uint32_t);
+
+// Each record is the block number followed by the block's data
+constexpr size_t RecordHeaderSize = sizeof(uint32_t);
+constexpr size_t RecordSize = RecordHeaderSize + DiskImageOverlay::BlockSize;
+
+std::unique_ptr<DiskImageOverlay> DiskImageOverlay::Open(const std::string& path,
+                                                         const uint32_t image_size_kb)
+{
+	FILE* delta_file = fopen(path.c_str(), "rb+");
+	if (!delta_file) {
+		delta_file = fopen(path.c_str(), "wb+");
+	}
+	if (!delta_file) {
+		return nullptr;
+	}
+	std::unique_ptr<DiskImageOverlay> overlay(new DiskImageOverlay(delta_file));
+	if (!overlay->LoadIndex(image_size_kb)) {
+		return nullptr;
+	}
+	return overlay;
+}
+
+DiskImageOverlay::DiskImageOverlay(FILE* delta_file) : file(delta_file)
+{
+	assert(file);
+}
+
+DiskImageOverlay::~DiskImageOverlay()
+{
+	fclose(file);
+}
+
+bool DiskImageOverlay::LoadIndex(const uint32_t image_size_kb)
+{
+	if (!Seek(0)) {
+		return false;
+	}
+	std::array<uint8_t, HeaderSize> header = {};
+	const auto header_bytes = fread(header.data(), 1, header.size(), file);
+
+	if (header_bytes == 0) {
+		// A new delta file
+		std::memcpy(header.data(), Magic, sizeof(Magic));
+		auto fields = header.data() + sizeof(Magic);
+		host_writed(fields, Version);
+		host_writed(fields + 4, BlockSize);
+		host_writed(fields + 8, image_size_kb);
+		host_writed(fields + 12, 0);
+
+		if (!Seek(0) || fwrite(header.data(), 1, header.size(), file) != header.size()) {
+			return false;
+		}
+		end_offset = HeaderSize;
+		return true;
+	}
+
+	const auto fields = header.data() + sizeof(Magic);
+	if (header_bytes != header.size() ||
+	    std::memcmp(header.data(), Magic, sizeof(Magic)) != 0 ||
+	    host_readd(fields) != Version || host_readd(fields + 4) != BlockSize ||
+	    host_readd(fields + 8) != image_size_kb) {
+		return false;
+	}
+
+	// A partial record at the end, as left by being interrupted while
+	// appending, is dropped and overwritten by the next new block
+	std::array<uint8_t, RecordSize> record = {};
+	cross_off_t offset = HeaderSize;
+	while (fread(record.data(), 1, record.size(), file) == record.size()) {
+		index[host_readd(record.data())] = offset + RecordHeaderSize;
+		offset += RecordSize;
+	}
+	end_offset = offset;
+	return true;
+}
+
+bool DiskImageOverlay::Seek(const cross_off_t offset)
+{
+	return cross_fseeko(file, offset, SEEK_SET) == 0;
+}
+
+bool DiskImageOverlay::Read(const uint32_t block, void* data)
+{
+	const auto it = index.find(block);
+	if (it == index.end() || !Seek(it->second)) {
+		return false;
+	}
+	return fread(data, 1, BlockSize, file) == BlockSize;
+}
+
+bool DiskImageOverlay::Write(const uint32_t block, const void* data)
+{
+	if (const auto it = index.find(block); it != index.end()) {
+		return Seek(it->second) && fwrite(data, 1, BlockSize, file) == BlockSize;
+	}
+
+	std::array<uint8_t, RecordHeaderSize> record_header = {};
+	host_writed(record_header.data(), block);
+
+	if (!Seek(end_offset) ||
+	    fwrite(record_header.data(), 1, record_header.size(), file) !=
+	            record_header.size() ||
+	    fwrite(data, 1, BlockSize, file) != BlockSize) {
+		return false;
+	}
+	index[block] = end_offset + RecordHeaderSize;
+	end_offset += RecordSize;
+	return true;
+}
@@ -20,6 +20,8 @@
 #include "dosbox.h"
 
 #include <algorithm>
+#include <array>
+#include <cassert>
 #include <cstring>
 #include <cstdlib>
 
@@ -319,6 +321,40 @@ static uint8_t EMM_ReallocatePages(uint16_t handle,uint16_t & pages) {
 	return EMM_NO_ERROR;
 }
 
+// Maps the four 4 KB pages of a 16 KB EMS page, starting at 'lin_page', to
+// the given physical pages. Programs tend to map the same pages over and over
+// again, so pages already mapped where they should be are left alone.
+// Remapping a page in the first megabyte only invalidates that page's TLB
+// entries, so there's no need to reset the whole TLB.
+static void map_ems_pages(const Bitu lin_page, const std::array<Bitu, 4>& phys_pages)
+{
+	assert(lin_page + phys_pages.size() <= LINK_START);
+
+	for (Bitu i = 0; i < phys_pages.size(); ++i) {
+		if (paging.firstmb[lin_page + i] != phys_pages[i]) {
+			PAGING_MapPage(lin_page + i, phys_pages[i]);
+		}
+	}
+}
+
+static void unmap_ems_pages(const Bitu lin_page)
+{
+	map_ems_pages(lin_page, {lin_page, lin_page + 1, lin_page + 2, lin_page + 3});
+}
+
+static void map_ems_pages(const Bitu lin_page, const uint16_t handle,
+                          const uint16_t log_page)
+{
+	std::array<Bitu, 4> phys_pages = {};
+
+	MemHandle memh = MEM_NextHandleAt(emm_handles[handle].mem, log_page * 4);
+	for (auto& phys_page : phys_pages) {
+		phys_page = check_cast<Bitu>(memh);
+		memh      = MEM_NextHandle(memh);
+	}
+	map_ems_pages(lin_page, phys_pages);
+}
+
 static uint8_t EMM_MapPage(Bitu phys_page,uint16_t handle,uint16_t log_page) {
 //	LOG_MSG("EMS MapPage handle %d phys %d log %d",handle,phys_page,log_page);
 	/* Check for too high physical page */
@@ -329,9 +365,7 @@ static uint8_t EMM_MapPage(Bitu phys_page,uint16_t handle,uint16_t log_page) {
 		/* Unmapping */
 		emm_mappings[phys_page].handle=NULL_HANDLE;
 		emm_mappings[phys_page].page=NULL_PAGE;
-		for (Bitu i=0;i<4;i++)
-			PAGING_MapPage(EMM_PAGEFRAME4K+phys_page*4+i,EMM_PAGEFRAME4K+phys_page*4+i);
-		PAGING_ClearTLB();
+		unmap_ems_pages(EMM_PAGEFRAME4K+phys_page*4);
 		return EMM_NO_ERROR;
 	}
 	/* Check for valid handle */
@@ -342,12 +376,7 @@ static uint8_t EMM_MapPage(Bitu phys_page,uint16_t handle,uint16_t log_page) {
 		emm_mappings[phys_page].handle=handle;
 		emm_mappings[phys_page].page=log_page;
 
-		MemHandle memh=MEM_NextHandleAt(emm_handles[handle].mem,log_page*4);;
-		for (Bitu i=0;i<4;i++) {
-			PAGING_MapPage(EMM_PAGEFRAME4K+phys_page*4+i,memh);
-			memh=MEM_NextHandle(memh);
-		}
-		PAGING_ClearTLB();
+		map_ems_pages(EMM_PAGEFRAME4K+phys_page*4,handle,log_page);
 		return EMM_NO_ERROR;
 	} else  {
 		/* Illegal logical page it is */
@@ -387,9 +416,7 @@ static uint8_t EMM_MapSegment(Bitu segment,uint16_t handle,uint16_t log_page) {
 				emm_segmentmappings[segment>>10].handle=NULL_HANDLE;
 				emm_segmentmappings[segment>>10].page=NULL_PAGE;
 			}
-			for (Bitu i=0;i<4;i++)
-				PAGING_MapPage(segment*16/4096+i,segment*16/4096+i);
-			PAGING_ClearTLB();
+			unmap_ems_pages(segment*16/4096);
 			return EMM_NO_ERROR;
 		}
 		/* Check for valid handle */
@@ -405,12 +432,7 @@ static uint8_t EMM_MapSegment(Bitu segment,uint16_t handle,uint16_t log_page) {
 				emm_segmentmappings[segment>>10].page=log_page;
 			}
 
-			MemHandle memh=MEM_NextHandleAt(emm_handles[handle].mem,log_page*4);;
-			for (Bitu i=0;i<4;i++) {
-				PAGING_MapPage(segment*16/4096+i,memh);
-				memh=MEM_NextHandle(memh);
-			}
-			PAGING_ClearTLB();
+			map_ems_pages(segment*16/4096,handle,log_page);
 			return EMM_NO_ERROR;
 		} else  {
 			/* Illegal logical page it is */
@@ -31,6 +31,12 @@ Int10Data int10;
 static callback_number_t call_10 = 0;
 static bool warned_ff=false;
 
+// True if a program has installed its own INT 10h handler in front of ours
+bool INT10_IsHandlerHooked()
+{
+	return RealGetVec(0x10) != CALLBACK_RealPointer(call_10);
+}
+
 static Bitu INT10_Handler(void) {
 #if 0
 	switch (reg_ah) {
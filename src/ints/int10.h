@@ -347,6 +347,11 @@ void INT10_GetFuncStateInformation(PhysPt save);
 
 void INT10_SetCursorShape(uint8_t first,uint8_t last);
 
+// The 'ViaInterrupt' functions below go through the INT 10h vector so that
+// programs hooking it see the calls, and run the handler directly when the
+// vector still points to ours.
+bool INT10_IsHandlerHooked();
+
 void INT10_SetCursorPos(uint8_t row,uint8_t col,uint8_t page);
 void INT10_SetCursorPosViaInterrupt(const uint8_t row, const uint8_t col,
                                     const uint8_t page);
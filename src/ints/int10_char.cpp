@@ -21,6 +21,8 @@
 
 #include "int10.h"
 
+#include <array>
+
 #include "bios.h"
 #include "callback.h"
 #include "inout.h"
@@ -106,6 +108,15 @@ static void TEXT_CopyRow(uint8_t cleft,uint8_t cright,uint8_t rold,uint8_t rnew,
 	MEM_BlockCopy(dest,src,(cright-cleft)*2);
 }
 
+// Moves the consecutive full-width rows [rfirst, rlast] up by nlines rows in
+// one block copy, which becomes a single memmove when the video memory is
+// directly mapped. Only used for upwards scrolls: the copy runs forwards.
+static void TEXT_CopyRowsUp(uint8_t rfirst,uint8_t rlast,uint8_t nlines,PhysPt base) {
+	const auto row_size = CurMode->twidth * 2u;
+	const PhysPt src = base + rfirst * row_size;
+	MEM_BlockCopy(src - nlines * row_size, src, (rlast - rfirst + 1) * row_size);
+}
+
 static void CGA2_FillRow(uint8_t cleft,uint8_t cright,uint8_t row,PhysPt base,uint8_t attr) {
 	BIOS_CHEIGHT;
 	PhysPt dest=base+((CurMode->twidth*row)*(cheight/2)+cleft);
@@ -184,11 +195,13 @@ static void TEXT_FillRow(uint8_t cleft,uint8_t cright,uint8_t row,PhysPt base,ui
 	/* Do some filing */
 	PhysPt dest;
 	dest=base+(row*CurMode->twidth+cleft)*2;
-	uint16_t fill=(attr<<8)+' ';
-	for (uint8_t x=0;x<(cright-cleft);x++) {
-		mem_writew(dest,fill);
-		dest+=2;
+	std::array<uint8_t, 2 * UINT8_MAX> cells;
+	const auto num_bytes = (cright - cleft) * 2u;
+	for (size_t i = 0; i < num_bytes; i += 2) {
+		cells[i]     = ' ';
+		cells[i + 1] = attr;
 	}
+	MEM_BlockWrite(dest, cells.data(), num_bytes);
 }
 
 uint16_t INT10_GetTextColumns()
@@ -248,6 +261,12 @@ void INT10_ScrollWindow(uint8_t rul,uint8_t cul,uint8_t rlr,uint8_t clr,int8_t n
 		nlines=rlr-rul+1;
 		goto filling;
 	}
+	if (CurMode->type == M_TEXT && nlines < 0 && start < end && cul == 0 &&
+	    clr == CurMode->twidth) {
+		// Full-width upwards scrolls, like the teletype output's
+		TEXT_CopyRowsUp(start + 1, end, static_cast<uint8_t>(-nlines), base);
+		start = end;
+	}
 	while (start!=end) {
 		start+=next;
 		switch (CurMode->type) {
@@ -419,6 +438,11 @@ void INT10_SetCursorPosViaInterrupt(const uint8_t row, const uint8_t col,
 {
 	constexpr uint8_t position_cmd = 0x2;
 
+	if (!INT10_IsHandlerHooked()) {
+		INT10_SetCursorPos(row, col, page);
+		return;
+	}
+
 	// Save regs
 	const auto old_ax = reg_ax;
 	const auto old_bx = reg_bx;
@@ -644,6 +668,18 @@ static void write_char_via_interrupt(const uint8_t cur_col, const uint8_t cur_ro
 	constexpr uint8_t with_attribute_cmd    = 0x9;
 	constexpr uint8_t without_attribute_cmd = 0x0A;
 
+	if (!INT10_IsHandlerHooked()) {
+		// What our handler does for these, without the round trip
+		auto attr = attribute;
+		if (use_attribute &&
+		    real_readb(BIOSMEM_SEG, BIOSMEM_CURRENT_MODE) == 0x11) {
+			attr = (attr & 0x80) | 0x3f;
+		}
+		INT10_SetCursorPos(cur_row, cur_col, page);
+		INT10_WriteChar(char_value, attr, page, write_char_cmd, use_attribute);
+		return;
+	}
+
 	// Position the cursor
 	INT10_SetCursorPosViaInterrupt(cur_row, cur_col, page);
 
@@ -844,6 +880,11 @@ void INT10_TeletypeOutputViaInterrupt(const uint8_t char_value, const uint8_t at
 {
 	constexpr uint8_t teletype_cmd = 0xE;
 
+	if (!INT10_IsHandlerHooked()) {
+		INT10_TeletypeOutput(char_value, attribute);
+		return;
+	}
+
 	// Save regs
 	const auto old_ax = reg_ax;
 	const auto old_bx = reg_bx;
@@ -821,6 +821,18 @@ bool INT10_IsTextMode(const VideoModeBlock& mode_block)
 	}
 }
 
+// Fills the 32 KB at the segment with the repeated low and high byte in one
+// block write, which is a memcpy if the video memory is directly mapped
+static void clear_video_memory(const uint16_t seg, const uint8_t low, const uint8_t high)
+{
+	std::array<uint8_t, 32 * 1024> fill;
+	for (size_t i = 0; i < fill.size(); i += 2) {
+		fill[i]     = low;
+		fill[i + 1] = high;
+	}
+	MEM_BlockWrite(PhysicalMake(seg, 0), fill.data(), fill.size());
+}
+
 static void finish_set_mode(bool clearmem) {
 	//  Clear video memory if needs be
 	if (clearmem) {
@@ -838,9 +850,7 @@ static void finish_set_mode(bool clearmem) {
 			}
 			// fall-through
 		case M_CGA2:
-			for (uint16_t ct=0;ct<16*1024;ct++) {
-				real_writew( 0xb800,ct*2,0x0000);
-			}
+			clear_video_memory(0xb800, 0x00, 0x00);
 			break;
 		case M_HERC_TEXT:
 		case M_TANDY_TEXT:
@@ -848,7 +858,7 @@ static void finish_set_mode(bool clearmem) {
 			// TODO Hercules had 32KB compared to CGA/MDA 16 KB,
 			// but does it matter in here?
 			uint16_t seg = (CurMode->mode==7)?0xb000:0xb800;
-			for (uint16_t ct=0;ct<16*1024;ct++) real_writew(seg,ct*2,0x0720);
+			clear_video_memory(seg, ' ', 0x07);
 			break;
 		}
 		case M_EGA:
@@ -866,8 +876,7 @@ static void finish_set_mode(bool clearmem) {
 		case M_CGA4_COMPOSITE:
 		case M_CGA_TEXT_COMPOSITE:
 			//  Hack we just access the memory directly
-			memset(vga.mem.linear,0,vga.vmemsize);
-			memset(vga.fastmem, 0, vga.vmemsize<<1);
+			VGA_ClearMemory();
 			break;
 		case M_ERROR:
 			assert(false);
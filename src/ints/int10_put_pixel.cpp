@@ -22,6 +22,7 @@
 #include "inout.h"
 #include "mem.h"
 #include "pci_bus.h"
+#include "vga.h"
 
 static uint8_t cga_masks[4]={0x3f,0xcf,0xf3,0xfc};
 static uint8_t cga_masks2[8]={0x7f,0xbf,0xdf,0xef,0xf7,0xfb,0xfd,0xfe};
@@ -140,19 +141,15 @@ void INT10_PutPixel(uint16_t x,uint16_t y,uint8_t page,uint8_t color) {
 		[[fallthrough]];
 	case M_EGA: {
 		/* Set the correct bitmask for the pixel position */
-		IO_Write(0x3ce, 0x8);
 		uint8_t mask = 128 >> (x & 7);
-		IO_Write(0x3cf, mask);
+		VGA_WriteGfxRegister(0x8, mask);
 		/* Set the color to set/reset register */
-		IO_Write(0x3ce, 0x0);
-		IO_Write(0x3cf, color);
+		VGA_WriteGfxRegister(0x0, color);
 		/* Enable all the set/resets */
-		IO_Write(0x3ce, 0x1);
-		IO_Write(0x3cf, 0xf);
+		VGA_WriteGfxRegister(0x1, 0xf);
 		/* test for xorring */
 		if (color & 0x80) {
-			IO_Write(0x3ce, 0x3);
-			IO_Write(0x3cf, 0x18);
+			VGA_WriteGfxRegister(0x3, 0x18);
 		}
 		// Perhaps also set mode 1
 		/* Calculate where the pixel is in video memory */
@@ -174,14 +171,11 @@ void INT10_PutPixel(uint16_t x,uint16_t y,uint8_t page,uint8_t color) {
 		mem_readb(off);
 		mem_writeb(off, 0xff);
 		/* Restore bitmask */
-		IO_Write(0x3ce, 0x8);
-		IO_Write(0x3cf, 0xff);
-		IO_Write(0x3ce, 0x1);
-		IO_Write(0x3cf, 0);
+		VGA_WriteGfxRegister(0x8, 0xff);
+		VGA_WriteGfxRegister(0x1, 0);
 		/* Restore write operating if changed */
 		if (color & 0x80) {
-			IO_Write(0x3ce, 0x3);
-			IO_Write(0x3cf, 0x0);
+			VGA_WriteGfxRegister(0x3, 0x0);
 		}
 		break;
 	}
@@ -256,13 +250,13 @@ void INT10_GetPixel(uint16_t x,uint16_t y,uint8_t page,uint8_t * color) {
 			Bitu shift=7-(x & 7);
 			/* Set the read map */
 			*color=0;
-			IO_Write(0x3ce,0x4);IO_Write(0x3cf,0);
+			VGA_WriteGfxRegister(0x4, 0);
 			*color|=((mem_readb(off)>>shift) & 1) << 0;
-			IO_Write(0x3ce,0x4);IO_Write(0x3cf,1);
+			VGA_WriteGfxRegister(0x4, 1);
 			*color|=((mem_readb(off)>>shift) & 1) << 1;
-			IO_Write(0x3ce,0x4);IO_Write(0x3cf,2);
+			VGA_WriteGfxRegister(0x4, 2);
 			*color|=((mem_readb(off)>>shift) & 1) << 2;
-			IO_Write(0x3ce,0x4);IO_Write(0x3cf,3);
+			VGA_WriteGfxRegister(0x4, 3);
 			*color|=((mem_readb(off)>>shift) & 1) << 3;
 			break;
 		}
@@ -70,6 +70,12 @@
  *          The seek-table file is versioned (see SEEK_TABLE_IDENTIFIER befow),
  *          therefore, if the format and version is updated, then the seek-table
  *          will be regenerated.
+ *
+ *       5. What happens when a CUE sheet mounts dozens of MP3 tracks?
+ *
+ *          The fast-seek file holds the tables of every MP3, so it's only read
+ *          and de-serialized once per session and kept in memory; the tracks
+ *          then look up their tables without touching the file again.
  */
 
 #include "mp3_seek_table.h"
@@ -79,6 +85,7 @@
 #include <climits>
 #include <fstream>
 #include <map>
+#include <mutex>
 #include <string>
 #include <sys/stat.h>
 
@@ -105,6 +112,18 @@ using std::ofstream;
 using seek_points_table_t = typename std::map<uint64_t, std::vector<drmp3_seek_point_serial> >;
 using frame_count_table_t = typename std::map<uint64_t, uint64_t>;
 
+// The tables of the fast-seek file, loaded on first use and shared by all the
+// MP3 streams opened afterwards
+struct fast_seek_cache_t {
+    string filename = {};
+    seek_points_table_t seek_points_table = {};
+    frame_count_table_t pcm_frame_count_table = {};
+    bool is_loaded = false;
+};
+
+static fast_seek_cache_t fast_seek_cache = {};
+static std::mutex fast_seek_cache_mutex = {};
+
 // Identifies a valid versioned seek-table
 #define SEEK_TABLE_IDENTIFIER "st-v6"
 
@@ -263,14 +282,13 @@ uint64_t generate_new_seek_points(const char* filename,
     return pcm_frame_count;
 }
 
-// This function attempts to fetch a seek-table for a given mp3 stream from the fast-seek file.
-// If anything is amiss then this function fails.
+// This function attempts to read the seek-tables of all the mp3 streams from the
+// fast-seek file. If anything is amiss then this function fails and leaves the
+// tables empty.
 //
-uint64_t load_existing_seek_points(const char* filename,
-                                 const uint64_t& stream_hash,
-                                 seek_points_table_t& seek_points_table,
-                                 frame_count_table_t& pcm_frame_count_table,
-                                 vector<drmp3_seek_point_serial>& seek_points) {
+bool load_seek_tables(const char* filename,
+                      seek_points_table_t& seek_points_table,
+                      frame_count_table_t& pcm_frame_count_table) {
 
     // The below sentinals sanity check and read the incoming
     // file one-by-one until all the data can be trusted.
@@ -278,12 +296,12 @@ uint64_t load_existing_seek_points(const char* filename,
     // Sentinal 1: bail if we got a zero-byte file.
     struct stat buffer;
     if (stat(filename, &buffer) != 0) {
-        return 0;
+        return false;
     }
 
     // Sentinal 2: Bail if the file isn't big enough to hold our identifier.
     if (get_file_size(filename) < static_cast<int64_t>(sizeof(SEEK_TABLE_IDENTIFIER))) {
-        return 0;
+        return false;
     }
 
     // Sentinal 3: Bail if we don't get a matching identifier.
@@ -293,20 +311,30 @@ uint64_t load_existing_seek_points(const char* filename,
     deserialize >> fetched_identifier;
     if (fetched_identifier != SEEK_TABLE_IDENTIFIER) {
         infile.close();
-        return 0;
+        return false;
     }
 
     // De-serialize the seek point and pcm_count tables.
     deserialize >> seek_points_table >> pcm_frame_count_table;
     infile.close();
+    return true;
+}
+
+// This function attempts to fetch a seek-table for a given mp3 stream from the
+// loaded fast-seek tables. If anything is amiss then this function fails.
+//
+uint64_t find_existing_seek_points(const uint64_t& stream_hash,
+                                   const seek_points_table_t& seek_points_table,
+                                   const frame_count_table_t& pcm_frame_count_table,
+                                   vector<drmp3_seek_point_serial>& seek_points) {
 
-    // Sentinal 4: does the seek_points table have our stream's hash?
+    // Sentinal 1: does the seek_points table have our stream's hash?
     const auto p_seek_points = seek_points_table.find(stream_hash);
     if (p_seek_points == seek_points_table.end()) {
         return 0;
     }
 
-    // Sentinal 5: does the pcm_frame_count table have our stream's hash?
+    // Sentinal 2: does the pcm_frame_count table have our stream's hash?
     const auto p_pcm_frame_count = pcm_frame_count_table.find(stream_hash);
     if (p_pcm_frame_count == pcm_frame_count_table.end()) {
         return 0;
@@ -337,13 +365,27 @@ uint64_t populate_seek_points(struct SDL_RWops* const context,
         return 0;
     }
 
-    // Attempt to fetch the seek points and pcm count from an existing look up table file.
-    seek_points_table_t seek_points_table;
-    frame_count_table_t pcm_frame_count_table;
-    auto pcm_frame_count = load_existing_seek_points(seektable_filename,
-                                                     stream_hash,
-                                                     seek_points_table,
-                                                     pcm_frame_count_table,
+    std::lock_guard<std::mutex> lock(fast_seek_cache_mutex);
+    auto& cache = fast_seek_cache;
+
+    // Read the look up table file once, the first time it's needed.
+    if (!cache.is_loaded || cache.filename != seektable_filename) {
+        cache.filename = seektable_filename;
+        cache.seek_points_table.clear();
+        cache.pcm_frame_count_table.clear();
+        if (!load_seek_tables(seektable_filename,
+                              cache.seek_points_table,
+                              cache.pcm_frame_count_table)) {
+            cache.seek_points_table.clear();
+            cache.pcm_frame_count_table.clear();
+        }
+        cache.is_loaded = true;
+    }
+
+    // Attempt to fetch the seek points and pcm count from the loaded look up tables.
+    auto pcm_frame_count = find_existing_seek_points(stream_hash,
+                                                     cache.seek_points_table,
+                                                     cache.pcm_frame_count_table,
                                                      p_mp3->seek_points_vector);
 
     // Otherwise calculate new seek points and save them to the fast-seek file.
@@ -351,8 +393,8 @@ uint64_t populate_seek_points(struct SDL_RWops* const context,
         pcm_frame_count = generate_new_seek_points(seektable_filename,
                                                    stream_hash,
                                                    p_mp3->p_dr,
-                                                   seek_points_table,
-                                                   pcm_frame_count_table,
+                                                   cache.seek_points_table,
+                                                   cache.pcm_frame_count_table,
                                                    p_mp3->seek_points_vector);
         if (pcm_frame_count == 0) {
             // LOG_MSG("MP3: could not load existing or generate new seek points for the stream");
@@ -34,6 +34,16 @@
 #  include "config.h"
 #endif
 
+// Without a configure step, pick the vectorised convolution from the
+// compiler's target: SSE2 on x86-64 and SSE2-enabled x86, NEON on Arm
+#if !defined(HAVE_EMMINTRIN_H) && !defined(HAVE_MMINTRIN_H) && !defined(HAVE_ARM_NEON_H)
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define HAVE_EMMINTRIN_H 1
+#  elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    define HAVE_ARM_NEON_H 1
+#  endif
+#endif
+
 #ifdef HAVE_EMMINTRIN_H
 #  include <emmintrin.h>
 #elif defined HAVE_MMINTRIN_H
@@ -93,43 +103,27 @@ double I0(double x)
 int convolve(const short* a, const short* b, int bLength)
 {
 #ifdef HAVE_EMMINTRIN_H
-    int out = 0;
+    // The sample window moves through its buffer, so it's rarely aligned
+    // like the sinc table: use unaligned loads. The 32-bit lanes wrap the
+    // same way as the scalar sum.
+    __m128i acc = _mm_setzero_si128();
 
-    const uintptr_t offset = (uintptr_t)(a) & 0x0f;
+    const int n = bLength / 8;
 
-    // check for aligned accesses
-    if (offset == ((uintptr_t)(b) & 0x0f))
+    for (int i = 0; i < n; i++)
     {
-        if (offset)
-        {
-            const int l = (0x10 - offset)/2;
-
-            for (int i = 0; i < l; i++)
-            {
-                out += *a++ * *b++;
-            }
-
-            bLength -= offset;
-        }
-
-        __m128i acc = _mm_setzero_si128();
-
-        const int n = bLength / 8;
-
-        for (int i = 0; i < n; i++)
-        {
-            const __m128i tmp = _mm_madd_epi16(*(__m128i*)a, *(__m128i*)b);
-            acc = _mm_add_epi16(acc, tmp);
-            a += 8;
-            b += 8;
-        }
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(va, vb));
+        a += 8;
+        b += 8;
+    }
 
-        __m128i vsum = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
-        vsum = _mm_add_epi32(vsum, _mm_srli_si128(vsum, 4));
-        out += _mm_cvtsi128_si32(vsum);
+    __m128i vsum = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+    vsum = _mm_add_epi32(vsum, _mm_srli_si128(vsum, 4));
+    int out = _mm_cvtsi128_si32(vsum);
 
-        bLength &= 7;
-    }
+    bLength &= 7;
 #elif defined HAVE_MMINTRIN_H
     __m64 acc = _mm_setzero_si64();
 
@@ -18,11 +18,22 @@
 
 #include "zmbv.h"
 
+#include <bit>
 #include <cassert>
+#include <climits>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <utility>
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define ZMBV_COMPARE_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZMBV_COMPARE_SSE2 1
+#include <emmintrin.h>
+#endif
 
 #include "math_utils.h"
 #include "mem_unaligned.h"
@@ -117,6 +128,8 @@ bool VideoCodec::SetupBuffers(const ZMBV_FORMAT _format, const int blockwidth, c
 
 	const auto blocks_needed = check_cast<uint32_t>(xblocks * yblocks);
 	blocks.resize(blocks_needed);
+	blockResults.resize(blocks_needed);
+	blocksPerRow = xblocks;
 
 	size_t i = 0;
 	for (auto y = 0; y < yblocks; ++y) {
@@ -160,17 +173,105 @@ void VideoCodec::CreateVectorTable()
 	}
 }
 
+// A pixel counts as changed if its lower 24 bits differ, so the unused top
+// byte of the 32-bit pixels is ignored
+template <class P>
+static bool is_changed(const P old_pixel, const P new_pixel)
+{
+	return ((old_pixel ^ new_pixel) & 0x00ffffff) != 0;
+}
+
 template <class P>
-int VideoCodec::PossibleBlock(const int vx, const int vy, const FrameBlock & block)
+static int count_changed_scalar(const P *pold, const P *pnew, const int num_pixels)
 {
 	int ret = 0;
-	P *pold = reinterpret_cast<P *>(oldframe) + block.start + (vy * pitch) + vx;
-	P *pnew = reinterpret_cast<P *>(newframe) + block.start;
-	;
+	for (auto x = 0; x < num_pixels; ++x) {
+		ret += is_changed(pold[x], pnew[x]) ? 1 : 0;
+	}
+	return ret;
+}
+
+// Counts the changed pixels of a block row, 16 bytes at a time
+#if ZMBV_COMPARE_SSE2
+template <class P>
+static int count_changed(const P *pold, const P *pnew, const int num_pixels)
+{
+	constexpr int Lanes = 16 / sizeof(P);
+
+	int ret = 0;
+	int x   = 0;
+	for (; x + Lanes <= num_pixels; x += Lanes) {
+		auto va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pold + x));
+		auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pnew + x));
+
+		// The movemask has one bit per byte, so sizeof(P) bits per pixel
+		int equal_bits = 0;
+		if constexpr (sizeof(P) == 1) {
+			equal_bits = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+		} else if constexpr (sizeof(P) == 2) {
+			equal_bits = _mm_movemask_epi8(_mm_cmpeq_epi16(va, vb));
+		} else {
+			const auto rgb_mask = _mm_set1_epi32(0x00ffffff);
+			va = _mm_and_si128(va, rgb_mask);
+			vb = _mm_and_si128(vb, rgb_mask);
+			equal_bits = _mm_movemask_epi8(_mm_cmpeq_epi32(va, vb));
+		}
+		const auto num_equal = std::popcount(static_cast<uint32_t>(equal_bits)) /
+		                       static_cast<int>(sizeof(P));
+		ret += Lanes - num_equal;
+	}
+	return ret + count_changed_scalar(pold + x, pnew + x, num_pixels - x);
+}
+#elif ZMBV_COMPARE_NEON
+template <class P>
+static int count_changed(const P *pold, const P *pnew, const int num_pixels)
+{
+	constexpr int Lanes = 16 / sizeof(P);
+
+	int ret = 0;
+	int x   = 0;
+	for (; x + Lanes <= num_pixels; x += Lanes) {
+		// The equal lanes are all ones, so their top bits count them
+		int num_equal = 0;
+		if constexpr (sizeof(P) == 1) {
+			const auto eq = vceqq_u8(vld1q_u8(pold + x), vld1q_u8(pnew + x));
+			num_equal = vaddvq_u8(vshrq_n_u8(eq, 7));
+		} else if constexpr (sizeof(P) == 2) {
+			const auto eq = vceqq_u16(vld1q_u16(pold + x), vld1q_u16(pnew + x));
+			num_equal = vaddvq_u16(vshrq_n_u16(eq, 15));
+		} else {
+			const auto rgb_mask = vdupq_n_u32(0x00ffffff);
+			const auto va = vandq_u32(vld1q_u32(pold + x), rgb_mask);
+			const auto vb = vandq_u32(vld1q_u32(pnew + x), rgb_mask);
+			num_equal = static_cast<int>(vaddvq_u32(vshrq_n_u32(vceqq_u32(va, vb), 31)));
+		}
+		ret += Lanes - num_equal;
+	}
+	return ret + count_changed_scalar(pold + x, pnew + x, num_pixels - x);
+}
+#else
+template <class P>
+static int count_changed(const P *pold, const P *pnew, const int num_pixels)
+{
+	return count_changed_scalar(pold, pnew, num_pixels);
+}
+#endif
+
+// Counts the changed pixels of every 4th row and column. Stops counting once
+// 'limit' is reached, as the search only needs to know the block is worse.
+template <class P>
+int VideoCodec::PossibleBlock(const int vx, const int vy, const FrameBlock & block, const int limit)
+{
+	int ret = 0;
+	const P *pold = reinterpret_cast<P *>(oldframe) + block.start + (vy * pitch) + vx;
+	const P *pnew = reinterpret_cast<P *>(newframe) + block.start;
+
 	for (auto y = 0; y < block.dy; y += 4) {
 		for (auto x = 0; x < block.dx; x += 4) {
-			const auto test = 0 - ((pold[x] - pnew[x]) & 0x00ffffff);
-			ret -= check_cast<int>(test >> 31);
+			ret += is_changed(pold[x], pnew[x]) ? 1 : 0;
+		}
+		if (ret >= limit) {
+			break;
 		}
 		pold += pitch * 4;
 		pnew += pitch * 4;
@@ -178,17 +279,18 @@ int VideoCodec::PossibleBlock(const int vx, const int vy, const FrameBlock & blo
 	return ret;
 }
 
+// Counts the changed pixels of the block, stopping once 'limit' is reached
 template <class P>
-int VideoCodec::CompareBlock(const int vx, const int vy, const FrameBlock & block)
+int VideoCodec::CompareBlock(const int vx, const int vy, const FrameBlock & block, const int limit)
 {
 	int ret = 0;
-	P *pold = reinterpret_cast<P *>(oldframe) + block.start + (vy * pitch) + vx;
-	P *pnew = reinterpret_cast<P *>(newframe) + block.start;
-	;
+	const P *pold = reinterpret_cast<P *>(oldframe) + block.start + (vy * pitch) + vx;
+	const P *pnew = reinterpret_cast<P *>(newframe) + block.start;
+
 	for (auto y = 0; y < block.dy; y++) {
-		for (auto x = 0; x < block.dx; x++) {
-			const auto test = 0 - ((pold[x] - pnew[x]) & 0x00ffffff);
-			ret -= check_cast<int>(test >> 31);
+		ret += count_changed(pold, pnew, block.dx);
+		if (ret >= limit) {
+			break;
 		}
 		pold += pitch;
 		pnew += pitch;
@@ -197,14 +299,14 @@ int VideoCodec::CompareBlock(const int vx, const int vy, const FrameBlock & bloc
 }
 
 template <class P>
-void VideoCodec::AddXorBlock(const int vx, const int vy, const FrameBlock & block)
+void VideoCodec::AddXorBlock(const int vx, const int vy, const FrameBlock & block, size_t offset)
 {
 	P *pold = reinterpret_cast<P *>(oldframe) + block.start + (vy * pitch) + vx;
 	P *pnew = reinterpret_cast<P *>(newframe) + block.start;
 	for (auto y = 0; y < block.dy; ++y) {
 		for (auto x = 0; x < block.dx; ++x) {
-			*reinterpret_cast<P *>(&work[workUsed]) = pnew[x] ^ pold[x];
-			workUsed += sizeof(P);
+			*reinterpret_cast<P *>(&work[offset]) = pnew[x] ^ pold[x];
+			offset += sizeof(P);
 		}
 		pold += pitch;
 		pnew += pitch;
@@ -216,6 +318,38 @@ void VideoCodec::AlignWork(size_t & offset) {
 	offset = (offset + blocks.size() * 2u + 3u) & ~3u;
 }
 
+template <class P>
+VideoCodec::BlockResult VideoCodec::SearchBlock(const FrameBlock & block)
+{
+	int8_t bestvx   = 0;
+	int8_t bestvy   = 0;
+	auto bestchange = CompareBlock<P>(0, 0, block, INT_MAX);
+	auto possibles  = 64;
+
+	for (auto v = 0; v < VectorCount && possibles; v++) {
+		if (bestchange < 4)
+			break;
+		auto vx = VectorTable[v].x;
+		auto vy = VectorTable[v].y;
+		if (PossibleBlock<P>(vx, vy, block, 4) < 4) {
+			possibles--;
+			// if (!possibles) Msg("Ran out of possibles, at
+			// %d of %d best%d\n",v,VectorCount,bestchange);
+			auto testchange = CompareBlock<P>(vx, vy, block, bestchange);
+			if (testchange < bestchange) {
+				bestchange = testchange;
+				bestvx     = check_cast<int8_t>(vx);
+				bestvy     = check_cast<int8_t>(vy);
+			}
+		}
+	}
+	BlockResult result = {};
+	result.vx          = bestvx;
+	result.vy          = bestvy;
+	result.changed     = (bestchange != 0);
+	return result;
+}
+
 template <class P>
 void VideoCodec::AddXorFrame()
 {
@@ -223,41 +357,137 @@ void VideoCodec::AddXorFrame()
 
 	AlignWork(workUsed);
 
-	size_t b = 0;
-	for (const auto & block : blocks) {
+	// Game screens are often static, and an unchanged frame only needs
+	// zero vectors
+	if (IsFrameUnchanged()) {
+		memset(vectors, 0, blocks.size() * 2);
+		return;
+	}
 
-		int8_t bestvx   = 0;
-		int8_t bestvy   = 0;
-		auto bestchange = CompareBlock<P>(0, 0, block);
-		auto possibles  = 64;
-
-		for (auto v = 0; v < VectorCount && possibles; v++) {
-			if (bestchange < 4)
-				break;
-			auto vx = VectorTable[v].x;
-			auto vy = VectorTable[v].y;
-			if (PossibleBlock<P>(vx, vy, block) < 4) {
-				possibles--;
-				// if (!possibles) Msg("Ran out of possibles, at
-				// %d of %d best%d\n",v,VectorCount,bestchange);
-				auto testchange = CompareBlock<P>(vx, vy, block);
-				if (testchange < bestchange) {
-					bestchange = testchange;
-					bestvx     = check_cast<int8_t>(vx);
-					bestvy     = check_cast<int8_t>(vy);
-				}
+	// The blocks' XOR data follow each other in the order of the blocks,
+	// so their offsets are only known once all the searches are done
+	RunInBands([this](const size_t first, const size_t last) {
+		for (auto b = first; b < last; ++b) {
+			blockResults[b] = SearchBlock<P>(blocks[b]);
+		}
+	});
+
+	for (size_t b = 0; b < blocks.size(); ++b) {
+		auto &result  = blockResults[b];
+		result.offset = workUsed;
+		if (result.changed) {
+			const auto &block = blocks[b];
+			workUsed += static_cast<size_t>(block.dx * block.dy) * sizeof(P);
+		}
+	}
+
+	RunInBands([this, vectors](const size_t first, const size_t last) {
+		for (auto b = first; b < last; ++b) {
+			const auto &result = blockResults[b];
+			vectors[b * 2 + 0] = static_cast<uint8_t>(left_shift_signed(result.vx, 1));
+			vectors[b * 2 + 1] = static_cast<uint8_t>(left_shift_signed(result.vy, 1));
+			if (result.changed) {
+				vectors[b * 2 + 0] |= 1;
+				AddXorBlock<P>(result.vx, result.vy, blocks[b], result.offset);
 			}
 		}
-		vectors[b * 2 + 0] = static_cast<uint8_t>(left_shift_signed(bestvx, 1));
-		vectors[b * 2 + 1] = static_cast<uint8_t>(left_shift_signed(bestvy, 1));
-		if (bestchange) {
-			vectors[b * 2 + 0] |= 1;
-			AddXorBlock<P>(bestvx, bestvy, block);
+	});
+}
+
+// Compares the visible lines, the borders around them are always zero
+bool VideoCodec::IsFrameUnchanged() const
+{
+	const auto first_line = static_cast<size_t>(MAX_VECTOR * pitch * pixelsize);
+	const auto num_bytes  = static_cast<size_t>(height * pitch * pixelsize);
+	return memcmp(oldframe + first_line, newframe + first_line, num_bytes) == 0;
+}
+
+// Runs the job on the block rows split into as many bands as there are
+// threads, and returns once all bands are done
+void VideoCodec::RunInBands(const std::function<void(size_t, size_t)> &job)
+{
+	auto &helpers = searchHelpers;
+	if (helpers.threads.empty()) {
+		job(0, blocks.size());
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(helpers.mutex);
+		helpers.job     = job;
+		helpers.numDone = 0;
+		++helpers.generation;
+	}
+	helpers.hasWork.notify_all();
+
+	const auto num_bands = helpers.threads.size() + 1;
+	const auto num_rows  = blocks.size() / static_cast<size_t>(blocksPerRow);
+	job(0, (num_rows / num_bands) * static_cast<size_t>(blocksPerRow));
+
+	std::unique_lock<std::mutex> lock(helpers.mutex);
+	helpers.workDone.wait(lock, [&] {
+		return helpers.numDone == helpers.threads.size();
+	});
+	helpers.job = {};
+}
+
+void VideoCodec::SearchHelperLoop(const size_t band, uint32_t generation)
+{
+	auto &helpers = searchHelpers;
+
+	std::unique_lock<std::mutex> lock(helpers.mutex);
+	while (true) {
+		helpers.hasWork.wait(lock, [&] {
+			return helpers.shouldExit || helpers.generation != generation;
+		});
+		if (helpers.shouldExit) {
+			return;
+		}
+		generation = helpers.generation;
+		const auto job = helpers.job;
+		lock.unlock();
+
+		const auto num_bands = helpers.threads.size() + 1;
+		const auto num_rows  = blocks.size() / static_cast<size_t>(blocksPerRow);
+		const auto first_row = num_rows * band / num_bands;
+		const auto last_row  = num_rows * (band + 1) / num_bands;
+		job(first_row * static_cast<size_t>(blocksPerRow),
+		    last_row * static_cast<size_t>(blocksPerRow));
+
+		lock.lock();
+		if (++helpers.numDone == helpers.threads.size()) {
+			helpers.workDone.notify_one();
 		}
-		++b;
 	}
 }
 
+void VideoCodec::SetSearchThreads(const int num_threads)
+{
+	StopSearchHelpers();
+
+	auto &helpers      = searchHelpers;
+	helpers.shouldExit = false;
+	for (auto band = 1; band < num_threads; ++band) {
+		helpers.threads.emplace_back(&VideoCodec::SearchHelperLoop,
+		                             this,
+		                             static_cast<size_t>(band),
+		                             helpers.generation);
+	}
+}
+
+void VideoCodec::StopSearchHelpers()
+{
+	auto &helpers = searchHelpers;
+	{
+		std::lock_guard<std::mutex> lock(helpers.mutex);
+		helpers.shouldExit = true;
+	}
+	helpers.hasWork.notify_all();
+	for (auto &thread : helpers.threads) {
+		thread.join();
+	}
+	helpers.threads.clear();
+}
+
 bool VideoCodec::SetupCompress(const int _width, const int _height)
 {
 	width  = _width;
@@ -334,8 +564,6 @@ bool VideoCodec::PrepareCompressFrame(int flags, const ZMBV_FORMAT _format, cons
 				work[workUsed++] = palette[i * 4 + 2];
 			}
 		}
-		/* Restart deflate */
-		deflateReset(&zstream);
 	} else {
 		const auto palette_bytes = palsize * 4;
 		if (palsize && pal && memcmp(pal, palette, palette_bytes)) {
@@ -368,6 +596,12 @@ void VideoCodec::CompressLines(const int lineCount, const uint8_t *lineData[])
 }
 
 int VideoCodec::FinishCompressFrame()
+{
+	EncodeFrame(finishedFrame);
+	return DeflateFrame(finishedFrame);
+}
+
+void VideoCodec::EncodeFrame(EncodedFrame &frame)
 {
 	assert(compress.writeBuf);
 	const auto &firstByte = compress.writeBuf[0];
@@ -393,20 +627,39 @@ int VideoCodec::FinishCompressFrame()
 		default: break;
 		}
 	}
+
+	// Hand over the work buffer, taking the frame's previous one in return
+	frame.data.resize(work.size());
+	std::swap(work, frame.data);
+
+	frame.size       = workUsed;
+	frame.writeBuf   = compress.writeBuf;
+	frame.writeSize  = compress.writeSize;
+	frame.writeDone  = compress.writeDone;
+	frame.isKeyframe = (firstByte & Mask_KeyFrame) != 0;
+}
+
+int VideoCodec::DeflateFrame(EncodedFrame &frame)
+{
+	if (frame.isKeyframe) {
+		/* Restart deflate */
+		deflateReset(&zstream);
+	}
+
 	/* Create the actual frame with compression */
-	zstream.next_in  = work.data();
-	zstream.avail_in = check_cast<uint32_t>(workUsed);
+	zstream.next_in  = frame.data.data();
+	zstream.avail_in = check_cast<uint32_t>(frame.size);
 	zstream.total_in = 0;
 
-	zstream.next_out  = compress.writeBuf + compress.writeDone;
-	zstream.avail_out = compress.writeSize - compress.writeDone;
+	zstream.next_out  = frame.writeBuf + frame.writeDone;
+	zstream.avail_out = frame.writeSize - frame.writeDone;
 	zstream.total_out = 0;
 
 	int bytes_processed = 0;
 
 	// Only tally bytes if the stream was OK
 	if (deflate(&zstream, Z_SYNC_FLUSH) >= Z_OK) {
-		bytes_processed = static_cast<int>(compress.writeDone + zstream.total_out);
+		bytes_processed = static_cast<int>(frame.writeDone + zstream.total_out);
 	}
 	return bytes_processed;
 }
@@ -608,3 +861,8 @@ VideoCodec::VideoCodec()
 	CreateVectorTable();
 	memset(&zstream, 0, sizeof(zstream));
 }
+
+VideoCodec::~VideoCodec()
+{
+	StopSearchHelpers();
+}
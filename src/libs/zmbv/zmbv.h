@@ -19,7 +19,11 @@
 #ifndef DOSBOX_ZMBV_H
 #define DOSBOX_ZMBV_H
 
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "config.h"
@@ -55,6 +59,18 @@ enum class ZMBV_FORMAT : uint8_t {
 void Msg(const char fmt[], ...);
 
 class VideoCodec {
+public:
+	// A frame finished by EncodeFrame(), waiting to be compressed into the
+	// buffer passed to PrepareCompressFrame()
+	struct EncodedFrame {
+		std::vector<uint8_t> data = {};
+		size_t size = 0;
+		uint8_t *writeBuf = nullptr;
+		uint32_t writeSize = 0;
+		uint32_t writeDone = 0;
+		bool isKeyframe = false;
+	};
+
 private:
 	struct FrameBlock {
 		int start = 0;
@@ -66,6 +82,14 @@ private:
 		int y = 0;
 		int slot = 0;
 	};
+	// The outcome of a block's motion vector search, and where its XOR data
+	// goes in the work buffer
+	struct BlockResult {
+		int8_t vx = 0;
+		int8_t vy = 0;
+		bool changed = false;
+		size_t offset = 0;
+	};
 	struct KeyframeHeader {
 		uint8_t high_version = 0;
 		uint8_t low_version = 0;
@@ -96,6 +120,8 @@ private:
 	uint32_t bufsize = 0;
 
 	std::vector<FrameBlock> blocks = {};
+	std::vector<BlockResult> blockResults = {};
+	int blocksPerRow = 0;
 	size_t workUsed = 0;
 	size_t workPos = 0;
 
@@ -110,6 +136,23 @@ private:
 	Compress compress = {};
 	z_stream zstream = {};
 
+	// The frame of the FinishCompressFrame() calls
+	EncodedFrame finishedFrame = {};
+
+	// The threads helping with the motion vector search; the calling
+	// thread searches the first band of block rows, and each helper one of
+	// the others
+	struct SearchHelpers {
+		std::vector<std::thread> threads = {};
+		std::mutex mutex = {};
+		std::condition_variable hasWork = {};
+		std::condition_variable workDone = {};
+		std::function<void(size_t, size_t)> job = {};
+		uint32_t generation = 0;
+		size_t numDone = 0;
+		bool shouldExit = false;
+	} searchHelpers;
+
 	// methods
 	void CreateVectorTable();
 	bool SetupBuffers(ZMBV_FORMAT format, int blockwidth, int blockheight);
@@ -119,20 +162,28 @@ private:
 	template <class P>
 	void UnXorFrame();
 	template <class P>
-	int PossibleBlock(int vx, int vy, const FrameBlock & block);
+	BlockResult SearchBlock(const FrameBlock & block);
+	template <class P>
+	int PossibleBlock(int vx, int vy, const FrameBlock & block, int limit);
 	template <class P>
-	int CompareBlock(int vx, int vy, const FrameBlock & block);
+	int CompareBlock(int vx, int vy, const FrameBlock & block, int limit);
 	template <class P>
-	void AddXorBlock(int vx, int vy, const FrameBlock & block);
+	void AddXorBlock(int vx, int vy, const FrameBlock & block, size_t offset);
 	template <class P>
 	void UnXorBlock(int vx, int vy, const FrameBlock & block);
 	template <class P>
 	void CopyBlock(int vx, int vy, const FrameBlock & block);
 
 	void AlignWork(size_t & offset);
+	bool IsFrameUnchanged() const;
+
+	void RunInBands(const std::function<void(size_t, size_t)> &job);
+	void SearchHelperLoop(size_t band, uint32_t generation);
+	void StopSearchHelpers();
 
 public:
 	VideoCodec();
+	~VideoCodec();
 
 	VideoCodec(const VideoCodec &) = delete;            // prevent copy
 	VideoCodec &operator=(const VideoCodec &) = delete; // prevent assignment
@@ -145,6 +196,20 @@ public:
 	void CompressLines(const int lineCount, const uint8_t *lineData[]);
 	bool PrepareCompressFrame(int flags, ZMBV_FORMAT _format, const uint8_t *pal, uint8_t *writeBuf, uint32_t writeSize);
 	int FinishCompressFrame();
+
+	// Splits FinishCompressFrame() in two steps that can run on different
+	// threads: EncodeFrame() finishes the frame's uncompressed data,
+	// swapping it into 'frame', and DeflateFrame() compresses it. The
+	// frames have to be deflated in the order they were encoded, but the
+	// next frames can be encoded meanwhile. Returns the frame's size in
+	// bytes.
+	void EncodeFrame(EncodedFrame &frame);
+	int DeflateFrame(EncodedFrame &frame);
+
+	// Searches the motion vectors of the delta frames on 'num_threads'
+	// threads, each taking a band of block rows. The output is identical
+	// to the single-threaded search.
+	void SetSearchThreads(int num_threads);
 	void FinishVideo();
 	bool DecompressFrame(uint8_t *framedata, int size);
 	void Output_UpsideDown_24(uint8_t *output);
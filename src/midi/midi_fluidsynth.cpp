@@ -22,6 +22,7 @@
 
 #if C_FLUIDSYNTH
 
+#include <algorithm>
 #include <bitset>
 #include <cassert>
 #include <deque>
@@ -35,17 +36,24 @@
 #include "control.h"
 #include "cross.h"
 #include "fs_utils.h"
+#include "host_threads.h"
 #include "math_utils.h"
 #include "mixer.h"
 #include "pic.h"
 #include "programs.h"
 #include "string_utils.h"
 #include "support.h"
+#include "tracy.h"
 
 MidiHandlerFluidsynth instance;
 
 constexpr auto SoundFontExtension = ".sf2";
 
+// FluidSynth renders its voices in 64-frame blocks internally
+constexpr uint16_t RenderBlockFrames = 64;
+
+constexpr auto MaxCpuCores = 16;
+
 static void init_fluid_dosbox_settings(Section_prop& secprop)
 {
 	constexpr auto when_idle = Property::Changeable::WhenIdle;
@@ -101,6 +109,21 @@ static void init_fluid_dosbox_settings(Section_prop& secprop)
 	        "Filter for the FluidSynth audio output:\n"
 	        "  off:       Don't filter the output (default).\n"
 	        "  <custom>:  Custom filter definition; see 'sb_filter' for details.");
+
+	auto* int_prop = secprop.Add_int("fsynth_cpu_cores", when_idle, 1);
+	assert(int_prop);
+	int_prop->SetMinMax(1, MaxCpuCores);
+	int_prop->Set_help(
+	        "Number of CPU cores FluidSynth renders its voices on (1 by default).\n"
+	        "Values above 1 render the voices of dense MIDI scores in parallel on\n"
+	        "additional threads, which helps heavy SoundFonts keep up on multi-core hosts.");
+
+	auto* bool_prop = secprop.Add_bool("fsynth_dynamic_samples", when_idle, false);
+	assert(bool_prop);
+	bool_prop->Set_help(
+	        "Only load the samples of the SoundFont's presets when a MIDI channel selects\n"
+	        "them (disabled by default). This greatly reduces the memory used by large\n"
+	        "SoundFonts, at the cost of short stalls when new presets are selected.");
 }
 
 // Parses the 'soundfont' setting which has the 'FILENAME [SCALE]' format.
@@ -263,6 +286,15 @@ bool MidiHandlerFluidsynth::Open([[maybe_unused]] const char* conf)
 	                      "synth.sample-rate",
 	                      sample_rate_hz);
 
+	const auto cpu_cores = clamp(section->Get_int("fsynth_cpu_cores"),
+	                             1,
+	                             MaxCpuCores);
+	fluid_settings_setint(fluid_settings.get(), "synth.cpu-cores", cpu_cores);
+
+	fluid_settings_setint(fluid_settings.get(),
+	                      "synth.dynamic-sample-loading",
+	                      section->Get_bool("fsynth_dynamic_samples") ? 1 : 0);
+
 	FluidSynthPtr fluid_synth(new_fluid_synth(fluid_settings.get()),
 	                         delete_fluid_synth);
 	if (!fluid_synth) {
@@ -557,10 +589,23 @@ bool MidiHandlerFluidsynth::Open([[maybe_unused]] const char* conf)
 	mixer_channel = std::move(fluidsynth_channel);
 	selected_font = soundfont;
 
+	// FluidSynth holds the samples in memory, so the file size is what the
+	// SoundFont takes up, or its upper bound with dynamic sample loading
+	std::error_code ec = {};
+	const auto soundfont_size = std_fs::file_size(soundfont, ec);
+	tracked_soundfont.Track(nullptr, ec ? 0 : static_cast<size_t>(soundfont_size));
+
+	if (cpu_cores > 1) {
+		LOG_MSG("FSYNTH: Rendering voices on %d CPU cores", cpu_cores);
+	}
+
 	// Start rendering audio
+	fill_stats = {};
+
 	const auto render = std::bind(&MidiHandlerFluidsynth::Render, this);
 	renderer          = std::thread(render);
 	set_thread_name(renderer, "dosbox:fsynth");
+	HOST_THREADS_Apply(renderer, HostThreadGroup::Audio);
 
 	// Start playback
 	is_open = true;
@@ -580,6 +625,8 @@ void MidiHandlerFluidsynth::Close()
 
 	LOG_MSG("FSYNTH: Shutting down");
 
+	PrintStats();
+
 	if (had_underruns) {
 		LOG_WARNING("FSYNTH: Fix underruns by lowering CPU load, increasing "
 		            "your conf's prebuffer, or using a simpler SoundFont");
@@ -604,6 +651,7 @@ void MidiHandlerFluidsynth::Close()
 	synth.reset();
 	settings.reset();
 	selected_font.clear();
+	tracked_soundfont.Clear();
 
 	// Deregister the mixer channel and remove it
 	assert(mixer_channel);
@@ -745,8 +793,8 @@ void MidiHandlerFluidsynth::MixerCallBack(const uint16_t requested_audio_frames)
 	// Report buffer underruns
 	constexpr auto warning_percent = 5.0f;
 
-	if (const auto percent_full = audio_frame_fifo.GetPercentFull();
-	    percent_full < warning_percent) {
+	const auto percent_full = audio_frame_fifo.GetPercentFull();
+	if (percent_full < warning_percent) {
 		static auto iteration = 0;
 		if (iteration++ % 100 == 0) {
 			LOG_WARNING("FSYNTH: Audio buffer underrun");
@@ -754,6 +802,10 @@ void MidiHandlerFluidsynth::MixerCallBack(const uint16_t requested_audio_frames)
 		had_underruns = true;
 	}
 
+	fill_stats.min_percent = std::min(fill_stats.min_percent, percent_full);
+	fill_stats.sum_percent += percent_full;
+	++fill_stats.num_callbacks;
+
 	static std::vector<AudioFrame> audio_frames = {};
 
 	const auto has_dequeued = audio_frame_fifo.BulkDequeue(audio_frames,
@@ -779,14 +831,19 @@ void MidiHandlerFluidsynth::RenderAudioFramesToFifo(const uint16_t num_audio_fra
 		audio_frames.resize(num_audio_frames);
 	}
 
-	fluid_synth_write_float(synth.get(),
-	                        num_audio_frames,
-	                        &audio_frames[0][0],
-	                        0,
-	                        2,
-	                        &audio_frames[0][0],
-	                        1,
-	                        2);
+	{
+		ZoneScopedN("FluidSynth render");
+		fluid_synth_write_float(synth.get(),
+		                        num_audio_frames,
+		                        &audio_frames[0][0],
+		                        0,
+		                        2,
+		                        &audio_frames[0][0],
+		                        1,
+		                        2);
+	}
+	TracyPlot("FluidSynth queued frames",
+	          static_cast<int64_t>(audio_frame_fifo.Size()));
 
 	audio_frame_fifo.BulkEnqueue(audio_frames, num_audio_frames);
 }
@@ -822,13 +879,37 @@ void MidiHandlerFluidsynth::ProcessWorkFromFifo()
 	}
 }
 
-// Keep the fifo populated with freshly rendered buffers
+// Keep the fifo populated with freshly rendered buffers. Without pending
+// MIDI work, whole blocks are rendered as long as the FIFO has room for them,
+// so a message arriving meanwhile waits for one block at most.
 void MidiHandlerFluidsynth::Render()
 {
 	while (work_fifo.IsRunning()) {
-		work_fifo.IsEmpty() ? RenderAudioFramesToFifo()
-		                    : ProcessWorkFromFifo();
+		if (!work_fifo.IsEmpty()) {
+			ProcessWorkFromFifo();
+			continue;
+		}
+		const auto free_frames = audio_frame_fifo.MaxCapacity() -
+		                         audio_frame_fifo.Size();
+
+		RenderAudioFramesToFifo(check_cast<uint16_t>(
+		        std::clamp(free_frames, size_t{1}, size_t{RenderBlockFrames})));
+	}
+}
+
+void MidiHandlerFluidsynth::PrintStats()
+{
+	// Is there enough information to be meaningful?
+	constexpr auto MinCallbacks = 1000;
+	if (fill_stats.num_callbacks < MinCallbacks) {
+		return;
 	}
+	const auto avg_percent = fill_stats.sum_percent /
+	                         static_cast<double>(fill_stats.num_callbacks);
+
+	LOG_MSG("FSYNTH: Audio buffer was %.0f%% full on average, and at least %.0f%% full",
+	        avg_percent,
+	        static_cast<double>(fill_stats.min_percent));
 }
 
 std::string format_sf2_line(size_t width, const std_fs::path& sf2_path)
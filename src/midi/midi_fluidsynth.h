@@ -31,6 +31,7 @@
 #include <fluidsynth.h>
 #include <thread>
 
+#include "host_memory.h"
 #include "mixer.h"
 #include "rwqueue.h"
 
@@ -74,17 +75,25 @@ private:
 	FluidSynthPtr synth{nullptr, &delete_fluid_synth};
 
 	MixerChannelPtr mixer_channel = nullptr;
-	RWQueue<AudioFrame> audio_frame_fifo{1};
-	RWQueue<MidiWork> work_fifo{1};
+	RWQueue<AudioFrame> audio_frame_fifo{1, RWQueueMode::LockFree};
+	RWQueue<MidiWork> work_fifo{1, RWQueueMode::LockFree};
 	std::thread renderer = {};
 
 	std::string selected_font = "";
+	TrackedHostMemory tracked_soundfont{HostMemoryUse::SoundFonts};
 
 	// Used to track the balance of time between the last mixer callback
 	// versus the current MIDI Sysex or Msg event.
 	double last_rendered_ms = 0.0;
 	double ms_per_audio_frame = 0.0;
 
+	// The audio frame FIFO's fill level seen by the mixer callbacks
+	struct {
+		float min_percent = 100.0f;
+		double sum_percent = 0.0;
+		int num_callbacks  = 0;
+	} fill_stats = {};
+
 	bool had_underruns = false;
 	bool is_open       = false;
 };
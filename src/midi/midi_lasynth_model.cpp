@@ -23,9 +23,13 @@
 #if C_MT32EMU
 
 #include <cassert>
+#include <list>
+#include <map>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "fs_utils.h"
+#include "host_memory.h"
 
 // Construct a new model and ensure both PCM and control ROM(s) are provided
 LASynthModel::LASynthModel(const std::string &rom_name,
@@ -50,6 +54,51 @@ LASynthModel::LASynthModel(const std::string &rom_name,
 	assert(ctrl_full || (ctrl_a && ctrl_b));
 }
 
+// The ROM IDs of an identified file, which are empty if it's not that type of
+// ROM. Identifying a file reads and hashes its whole content, so the result is
+// kept until the file's size or modification time changes.
+struct IdentifiedFile {
+	uintmax_t size                     = 0;
+	std_fs::file_time_type modified_at = {};
+
+	bool is_known              = false;
+	std::string pcm_rom_id     = {};
+	std::string control_rom_id = {};
+};
+
+static const IdentifiedFile* identify_file(const LASynthModel::Mt32ServicePtr& service,
+                                           const std::string& filename)
+{
+	static std::unordered_map<std::string, IdentifiedFile> identified_files = {};
+
+	std::error_code ec;
+	const auto size        = std_fs::file_size(filename, ec);
+	const auto modified_at = ec ? std_fs::file_time_type{}
+	                            : std_fs::last_write_time(filename, ec);
+	if (ec) {
+		return nullptr;
+	}
+
+	auto& file = identified_files[filename];
+	if (file.is_known && file.size == size && file.modified_at == modified_at) {
+		return &file;
+	}
+
+	mt32emu_rom_info info;
+	if (service->identifyROMFile(&info, filename.c_str(), nullptr) !=
+	    MT32EMU_RC_OK) {
+		identified_files.erase(filename);
+		return nullptr;
+	}
+
+	file = {size,
+	        modified_at,
+	        true,
+	        info.pcm_rom_id ? info.pcm_rom_id : "",
+	        info.control_rom_id ? info.control_rom_id : ""};
+	return &file;
+}
+
 std::optional<std_fs::path> LASynthModel::find_rom(const Mt32ServicePtr& service,
                                                    const std_fs::path& dir,
                                                    const Rom* rom)
@@ -69,10 +118,8 @@ std::optional<std_fs::path> LASynthModel::find_rom(const Mt32ServicePtr& service
 		if (ec) {
 			continue;
 		}
-		mt32emu_rom_info info;
-		if (service->identifyROMFile(&info,
-		                             filename.c_str(),
-		                             nullptr) != MT32EMU_RC_OK) {
+		const auto file = identify_file(service, filename);
+		if (!file) {
 			// Only log unknwon files one time (if not already in the unknown_files set).
 			if (unknown_files.insert(filename).second) {
 				LOG_WARNING("MT32: Unknown file in ROM folder: %s", filename.c_str());
@@ -80,14 +127,9 @@ std::optional<std_fs::path> LASynthModel::find_rom(const Mt32ServicePtr& service
 			continue;
 		}
 
-		const char* rom_id = nullptr;
-		if (rom->type == ROM_TYPE::PCM) {
-			rom_id = info.pcm_rom_id;
-		} else if (rom->type == ROM_TYPE::CONTROL) {
-			rom_id = info.control_rom_id;
-		}
-
-		if (rom_id && rom->id == rom_id) {
+		const auto& rom_id = (rom->type == ROM_TYPE::PCM) ? file->pcm_rom_id
+		                                                  : file->control_rom_id;
+		if (rom->id == rom_id) {
 			return entry.path();
 		}
 	}
@@ -108,6 +150,27 @@ bool LASynthModel::InDir(const Mt32ServicePtr& service, const std_fs::path& dir)
 	return have_pcm && have_ctrl;
 }
 
+// The full ROMs are handed to the library as read-only file mappings instead of
+// being read into its own buffers, so all the instances running on the host
+// share one copy of them in the page cache. The library refers to the data
+// until its context is freed, so the mappings are kept for the whole run.
+static const MappedFile* map_rom(const std_fs::path& path)
+{
+	static std::map<std_fs::path, MappedFile> mapped_roms = {};
+	static std::list<TrackedHostMemory> tracked_roms      = {};
+
+	if (const auto it = mapped_roms.find(path); it != mapped_roms.end()) {
+		return &it->second;
+	}
+	const auto mapped_rom = map_native_file(path);
+	if (!mapped_rom) {
+		return nullptr;
+	}
+	tracked_roms.emplace_back(HostMemoryUse::Mt32Roms)
+	        .Track(mapped_rom->data, mapped_rom->size);
+	return &mapped_roms.emplace(path, *mapped_rom).first->second;
+}
+
 // If present, loads either the full or partial ROMs from the provided directory
 bool LASynthModel::Load(const Mt32ServicePtr& service, const std_fs::path& dir) const
 {
@@ -121,6 +184,9 @@ bool LASynthModel::Load(const Mt32ServicePtr& service, const std_fs::path& dir)
 		if (!rom_path) {
 			return false;
 		}
+		if (const auto rom = map_rom(*rom_path); rom) {
+			return service->addROMData(rom->data, rom->size) == expected_code;
+		}
 		const auto rcode = service->addROMFile(rom_path->string().c_str());
 		return rcode == expected_code;
 	};
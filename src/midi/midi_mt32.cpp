@@ -38,6 +38,7 @@
 #include "control.h"
 #include "cross.h"
 #include "fs_utils.h"
+#include "host_threads.h"
 #include "math_utils.h"
 #include "midi.h"
 #include "midi_lasynth_model.h"
@@ -46,6 +47,7 @@
 #include "pic.h"
 #include "string_utils.h"
 #include "support.h"
+#include "tracy.h"
 
 // mt32emu Settings
 // ----------------
@@ -898,6 +900,7 @@ bool MidiHandler_mt32::Open([[maybe_unused]] const char* conf)
 	const auto render = std::bind(&MidiHandler_mt32::Render, this);
 	renderer          = std::thread(render);
 	set_thread_name(renderer, "dosbox:mt32");
+	HOST_THREADS_Apply(renderer, HostThreadGroup::Audio);
 
 	is_open = true;
 	return true;
@@ -1041,9 +1044,13 @@ void MidiHandler_mt32::RenderAudioFramesToFifo(const uint16_t num_frames)
 		audio_frames.resize(num_frames);
 	}
 
-	std::unique_lock<std::mutex> lock(service_mutex);
-	service->renderFloat(&audio_frames[0][0], num_frames);
-	lock.unlock();
+	{
+		ZoneScopedN("MT32 render");
+		const std::lock_guard<std::mutex> lock(service_mutex);
+		service->renderFloat(&audio_frames[0][0], num_frames);
+	}
+	TracyPlot("MT32 queued frames",
+	          static_cast<int64_t>(audio_frame_fifo.Size()));
 
 	audio_frame_fifo.BulkEnqueue(audio_frames, num_frames);
 }
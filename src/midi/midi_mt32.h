@@ -85,8 +85,8 @@ private:
 
 	// Managed objects
 	MixerChannelPtr channel = nullptr;
-	RWQueue<AudioFrame> audio_frame_fifo{1};
-	RWQueue<MidiWork> work_fifo{1};
+	RWQueue<AudioFrame> audio_frame_fifo{1, RWQueueMode::LockFree};
+	RWQueue<MidiWork> work_fifo{1, RWQueueMode::LockFree};
 
 	std::mutex service_mutex = {};
 	Mt32ServicePtr service   = {};
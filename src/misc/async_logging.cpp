@@ -0,0 +1,241 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "async_logging.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "logging.h"
+#include "rwqueue.h"
+#include "string_utils.h"
+#include "support.h"
+
+constexpr auto CallbackId = "async_stderr";
+
+constexpr size_t MaxQueuedMessages = 4096;
+
+constexpr int MaxMessagesPerSecond = 50;
+
+// Logging threads only queue messages while loguru holds its lock, so the
+// queue sees a single producer at a time
+static RWQueue<std::string> message_queue(MaxQueuedMessages, RWQueueMode::LockFree);
+
+static std::thread writer = {};
+
+static loguru::Verbosity stderr_verbosity = loguru::Verbosity_OFF;
+
+static bool is_running = false;
+
+// The state below is only accessed by the logging threads, under
+// loguru's lock
+static int num_dropped_messages = 0;
+
+struct CallSiteRate {
+	std::chrono::steady_clock::time_point window_start = {};
+	int num_messages   = 0;
+	int num_suppressed = 0;
+};
+
+struct CallSite {
+	const char* filename = nullptr;
+	unsigned line        = 0;
+
+	bool operator==(const CallSite& other) const
+	{
+		return filename == other.filename && line == other.line;
+	}
+};
+
+struct CallSiteHash {
+	size_t operator()(const CallSite& site) const
+	{
+		return std::hash<const char*>()(site.filename) ^
+		       (static_cast<size_t>(site.line) << 1);
+	}
+};
+
+static std::unordered_map<CallSite, CallSiteRate, CallSiteHash> call_site_rates = {};
+
+static void write_queued_messages()
+{
+	while (auto message = message_queue.Dequeue()) {
+		fputs(message->c_str(), stderr);
+
+		// Flush once the queue is drained, not for every message
+		if (message_queue.IsEmpty()) {
+			fflush(stderr);
+		}
+	}
+	fflush(stderr);
+}
+
+static std::string format_message(const loguru::Message& message)
+{
+	using namespace loguru;
+
+	const auto verbosity = message.verbosity;
+	if (!g_colorlogtostderr || !terminal_has_color()) {
+		return format_str("%s%s%s%s\n",
+		                  message.preamble,
+		                  message.indentation,
+		                  message.prefix,
+		                  message.message);
+	}
+	// The colouring of loguru's own stderr output; it doesn't export its
+	// dimmed style
+	constexpr auto TerminalDim = "\x1b[2m";
+	if (verbosity > Verbosity_WARNING) {
+		return format_str("%s%s%s%s%s%s%s%s\n",
+		                  terminal_reset(),
+		                  TerminalDim,
+		                  message.preamble,
+		                  message.indentation,
+		                  verbosity == Verbosity_INFO ? terminal_reset() : "",
+		                  message.prefix,
+		                  message.message,
+		                  terminal_reset());
+	}
+	return format_str("%s%s%s%s%s%s%s\n",
+	                  terminal_reset(),
+	                  verbosity == Verbosity_WARNING ? terminal_yellow()
+	                                                 : terminal_red(),
+	                  message.preamble,
+	                  message.indentation,
+	                  message.prefix,
+	                  message.message,
+	                  terminal_reset());
+}
+
+static void queue_message(std::string&& text)
+{
+	// Single producer, so the queue can't fill up between the check and
+	// the enqueue
+	if (message_queue.Size() >= message_queue.MaxCapacity()) {
+		++num_dropped_messages;
+		return;
+	}
+	if (num_dropped_messages > 0) {
+		auto notice = format_str("LOG: Dropped %d messages\n",
+		                         num_dropped_messages);
+		num_dropped_messages = 0;
+		message_queue.Enqueue(std::move(notice));
+
+		if (message_queue.Size() >= message_queue.MaxCapacity()) {
+			++num_dropped_messages;
+			return;
+		}
+	}
+	message_queue.Enqueue(std::move(text));
+}
+
+// Returns false if the message exceeds its call site's rate
+static bool check_rate(const loguru::Message& message)
+{
+	const auto now = std::chrono::steady_clock::now();
+
+	auto& rate = call_site_rates[{message.filename, message.line}];
+	if (now - rate.window_start >= std::chrono::seconds(1)) {
+		if (rate.num_suppressed > 0) {
+			queue_message(format_str("LOG: Suppressed %d messages from %s:%u\n",
+			                         rate.num_suppressed,
+			                         message.filename,
+			                         message.line));
+		}
+		rate.window_start   = now;
+		rate.num_messages   = 0;
+		rate.num_suppressed = 0;
+	}
+	if (++rate.num_messages > MaxMessagesPerSecond) {
+		if (rate.num_suppressed++ == 0) {
+			queue_message(format_str("LOG: Too many messages from %s:%u, "
+			                         "suppressing them for up to a second\n",
+			                         message.filename,
+			                         message.line));
+		}
+		return false;
+	}
+	return true;
+}
+
+static void stop_writer()
+{
+	message_queue.Stop();
+	if (writer.joinable()) {
+		writer.join();
+	}
+}
+
+static void log_callback(void* /*user_data*/, const loguru::Message& message)
+{
+	if (message.verbosity == loguru::Verbosity_FATAL) {
+		// Aborting next: write everything before returning
+		stop_writer();
+		fputs(format_message(message).c_str(), stderr);
+		fflush(stderr);
+		return;
+	}
+	if (!message_queue.IsRunning() || !check_rate(message)) {
+		return;
+	}
+	queue_message(format_message(message));
+}
+
+void LOGGING_StartAsyncWriter()
+{
+	if (is_running) {
+		return;
+	}
+	stderr_verbosity = loguru::g_stderr_verbosity;
+	if (stderr_verbosity == loguru::Verbosity_OFF) {
+		return;
+	}
+
+	message_queue.Start();
+	writer = std::thread(write_queued_messages);
+	set_thread_name(writer, "dosbox:log");
+
+	loguru::add_callback(CallbackId, log_callback, nullptr, stderr_verbosity);
+	loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+
+	static bool is_registered = false;
+	if (!is_registered) {
+		std::atexit(LOGGING_StopAsyncWriter);
+		is_registered = true;
+	}
+	is_running = true;
+}
+
+void LOGGING_StopAsyncWriter()
+{
+	if (!is_running) {
+		return;
+	}
+	is_running = false;
+
+	loguru::remove_callback(CallbackId);
+	loguru::g_stderr_verbosity = stderr_verbosity;
+
+	stop_writer();
+}
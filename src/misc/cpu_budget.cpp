@@ -0,0 +1,209 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "cpu_budget.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "cross.h"
+#include "logging.h"
+#include "std_filesystem.h"
+
+#if !defined(WIN32)
+
+// Slots not refreshed for this long belong to instances that don't compete
+// for the budget (anymore)
+constexpr int64_t StaleSlotMs = 1000;
+
+constexpr size_t MaxInstances = 64;
+
+struct Slot {
+	std::atomic<int64_t> owner        = 0;
+	std::atomic<int64_t> budget       = 0;
+	std::atomic<int64_t> heartbeat_ms = 0;
+};
+
+// A zero-filled file is an empty table
+struct SharedTable {
+	Slot slots[MaxInstances];
+};
+
+static_assert(std::atomic<int64_t>::is_always_lock_free,
+              "the slots are shared between processes");
+
+static struct {
+	int budget_percent  = 0;
+	SharedTable* table  = nullptr;
+	Slot* slot          = nullptr;
+} budget = {};
+
+static int64_t now_ms()
+{
+	// The steady clock counts from the host's boot, so it's the same in
+	// every process
+	using namespace std::chrono;
+	return duration_cast<milliseconds>(steady_clock::now().time_since_epoch())
+	        .count();
+}
+
+// The table lives in a directory only the user can write to, the runtime
+// directory if there's one, so other users can't plant or swap the file
+static std_fs::path get_shared_table_path()
+{
+	const auto runtime_dir = getenv("XDG_RUNTIME_DIR");
+
+	const auto dir = (runtime_dir && *runtime_dir) ? std_fs::path(runtime_dir)
+	                                               : GetConfigDir();
+
+	return dir / "dosbox-cpu-budget";
+}
+
+static SharedTable* map_shared_table()
+{
+	const auto path = get_shared_table_path();
+
+	const auto fd = open(path.c_str(),
+	                     O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC,
+	                     0600);
+	if (fd < 0) {
+		LOG_WARNING("CPU: Can't open the CPU budget file '%s'",
+		            path.string().c_str());
+		return nullptr;
+	}
+
+	// An existing file has to be a private one of ours; other instances
+	// might be using it, so it's only ever grown, never truncated
+	struct stat st = {};
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+	    st.st_uid != getuid() || (st.st_mode & (S_IRWXG | S_IRWXO)) != 0) {
+		LOG_WARNING("CPU: The CPU budget file '%s' isn't a private file of the user",
+		            path.string().c_str());
+		close(fd);
+		return nullptr;
+	}
+
+	void* mapping = MAP_FAILED;
+	if (st.st_size >= static_cast<off_t>(sizeof(SharedTable)) ||
+	    ftruncate(fd, sizeof(SharedTable)) == 0) {
+		mapping = mmap(nullptr,
+		               sizeof(SharedTable),
+		               PROT_READ | PROT_WRITE,
+		               MAP_SHARED,
+		               fd,
+		               0);
+	}
+	close(fd);
+
+	if (mapping == MAP_FAILED) {
+		LOG_WARNING("CPU: Can't map the CPU budget file '%s'",
+		            path.string().c_str());
+		return nullptr;
+	}
+	return static_cast<SharedTable*>(mapping);
+}
+
+static bool is_stale(const Slot& slot, const int64_t now)
+{
+	return slot.owner == 0 || now - slot.heartbeat_ms > StaleSlotMs;
+}
+
+// Takes over a free or stale slot, or the one we still own
+static Slot* claim_slot(const int64_t now)
+{
+	const int64_t pid = getpid();
+
+	for (auto& slot : budget.table->slots) {
+		auto owner = slot.owner.load();
+		if (owner == pid) {
+			return &slot;
+		}
+		if (is_stale(slot, now) && slot.owner.compare_exchange_strong(owner, pid)) {
+			slot.heartbeat_ms = now;
+			return &slot;
+		}
+	}
+	return nullptr;
+}
+
+void CPU_BUDGET_Configure(const int budget_percent)
+{
+	budget.budget_percent = std::max(budget_percent, 0);
+
+	if (budget.budget_percent > 0 && !budget.table) {
+		budget.table = map_shared_table();
+	}
+}
+
+int CPU_BUDGET_GetShare(const int max_percent)
+{
+	if (budget.budget_percent == 0 || !budget.table) {
+		return max_percent;
+	}
+
+	const auto now = now_ms();
+
+	// Someone took our slot over while we didn't compete
+	if (!budget.slot || budget.slot->owner != getpid()) {
+		budget.slot = claim_slot(now);
+		if (!budget.slot) {
+			return max_percent;
+		}
+	}
+	budget.slot->budget       = budget.budget_percent;
+	budget.slot->heartbeat_ms = now;
+
+	int num_instances = 0;
+	for (const auto& slot : budget.table->slots) {
+		if (!is_stale(slot, now) && slot.budget == budget.budget_percent) {
+			++num_instances;
+		}
+	}
+	assert(num_instances >= 1);
+
+	return std::clamp(budget.budget_percent / num_instances, 1, max_percent);
+}
+
+#else
+
+void CPU_BUDGET_Configure(const int budget_percent)
+{
+	if (budget_percent > 0) {
+		LOG_WARNING("CPU: 'cpu_budget' isn't supported on Windows hosts");
+	}
+}
+
+int CPU_BUDGET_GetShare(const int max_percent)
+{
+	return max_percent;
+}
+
+#endif
@@ -24,23 +24,34 @@
 
 #include "control.h"
 #include "ethernet_slirp.h"
+#include "ethernet_tap.h"
 
 EthernetConnection *ETHERNET_OpenConnection([[maybe_unused]] const std::string &backend)
 {
 	EthernetConnection *conn = nullptr;
 #if C_SLIRP
-	// Currently only slirp is supported
 	if (backend == "slirp") {
 		conn = new SlirpEthernetConnection;
-		assert(control);
-		const auto settings = control->GetSection("ethernet");
-		if (!conn->Initialize(settings)) {
-			LOG_WARNING("Failed to initialize the slirp Ethernet backend");
-			delete conn;
-			conn = nullptr;
-		}
 	}
 #endif
+#if ETHERNET_TAP_SUPPORTED
+	if (backend == "tap") {
+		conn = new TapEthernetConnection;
+	}
+#endif
+	if (!conn) {
+		LOG_WARNING("The '%s' Ethernet backend isn't available on this platform",
+		            backend.c_str());
+		return nullptr;
+	}
+
+	assert(control);
+	const auto settings = control->GetSection("ethernet");
+	if (!conn->Initialize(settings)) {
+		LOG_WARNING("Failed to initialize the %s Ethernet backend", backend.c_str());
+		delete conn;
+		conn = nullptr;
+	}
 
 	return conn;
 }
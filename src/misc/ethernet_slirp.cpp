@@ -23,6 +23,7 @@
 #if C_SLIRP
 
 #include <algorithm>
+#include <chrono>
 #include <map>
 #include <stdexcept>
 
@@ -129,7 +130,6 @@ SlirpEthernetConnection::SlirpEthernetConnection()
         : EthernetConnection(),
           config(),
           timers(),
-          get_packet_callback(),
           registered_fds(),
 #ifdef WIN32
           readfds(),
@@ -152,6 +152,8 @@ SlirpEthernetConnection::SlirpEthernetConnection()
 
 SlirpEthernetConnection::~SlirpEthernetConnection()
 {
+	StopPollThread();
+
 	if (slirp)
 		slirp_cleanup(slirp);
 }
@@ -217,6 +219,9 @@ bool SlirpEthernetConnection::Initialize(Section *dosbox_config)
 		ClearPortForwards(is_udp, forwarded_udp_ports);
 		forwarded_udp_ports = SetupPortForwards(is_udp, section->Get_string("udp_port_forwards"));
 
+		is_polling  = true;
+		poll_thread = std::thread(&SlirpEthernetConnection::PollLoop, this);
+
 		LOG_MSG("SLIRP: Successfully initialized");
 		return true;
 	} else {
@@ -368,19 +373,61 @@ void SlirpEthernetConnection::SendPacket(const uint8_t *packet, int len)
 		            len, GetMTU());
 		return;
 	}
+	std::lock_guard<std::mutex> lock(slirp_mutex);
 	slirp_input(slirp, packet, len);
 }
 
 void SlirpEthernetConnection::GetPackets(std::function<int(const uint8_t *, int)> callback)
 {
-	get_packet_callback = callback;
-	uint32_t timeout_ms = 0;
-	PollsClear();
-	PollsAddRegistered();
-	slirp_pollfds_fill(slirp, &timeout_ms, slirp_add_poll, this);
-	const bool poll_failed = !PollsPoll(timeout_ms);
-	slirp_pollfds_poll(slirp, poll_failed, slirp_get_revents, this);
-	TimersRun();
+	if (num_received_frames == 0) {
+		return;
+	}
+
+	std::deque<std::vector<uint8_t>> frames = {};
+	{
+		std::lock_guard<std::mutex> lock(received_frames_mutex);
+		frames.swap(received_frames);
+		num_received_frames = 0;
+	}
+
+	for (const auto& frame : frames) {
+		callback(frame.data(), static_cast<int>(frame.size()));
+	}
+}
+
+void SlirpEthernetConnection::PollLoop()
+{
+	// Wake up at least this often to run the timers
+	constexpr uint32_t MaxPollTimeoutMs = 5;
+
+	while (is_polling) {
+		uint32_t timeout_ms = MaxPollTimeoutMs;
+		{
+			std::lock_guard<std::mutex> lock(slirp_mutex);
+			PollsClear();
+			PollsAddRegistered();
+			slirp_pollfds_fill(slirp, &timeout_ms, slirp_add_poll, this);
+		}
+		timeout_ms = std::min(timeout_ms, MaxPollTimeoutMs);
+
+		const bool poll_failed = !PollsPoll(timeout_ms);
+		if (poll_failed) {
+			// Nothing to wait on (or the poll failed), so don't spin
+			std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+		}
+
+		std::lock_guard<std::mutex> lock(slirp_mutex);
+		slirp_pollfds_poll(slirp, poll_failed, slirp_get_revents, this);
+		TimersRun();
+	}
+}
+
+void SlirpEthernetConnection::StopPollThread()
+{
+	is_polling = false;
+	if (poll_thread.joinable()) {
+		poll_thread.join();
+	}
 }
 
 int SlirpEthernetConnection::ReceivePacket(const uint8_t *packet, int len)
@@ -393,7 +440,18 @@ int SlirpEthernetConnection::ReceivePacket(const uint8_t *packet, int len)
 		            len, GetMRU());
 		return -1;
 	}
-	return get_packet_callback(packet, len);
+
+	// Drop the frames the guest doesn't pick up, like a full receive ring
+	// would
+	constexpr size_t MaxQueuedFrames = 256;
+
+	std::lock_guard<std::mutex> lock(received_frames_mutex);
+	if (received_frames.size() >= MaxQueuedFrames) {
+		return -1;
+	}
+	received_frames.emplace_back(packet, packet + len);
+	num_received_frames = received_frames.size();
+	return len;
 }
 
 struct slirp_timer *SlirpEthernetConnection::TimerNew(SlirpTimerCb cb, void *cb_opaque)
@@ -25,8 +25,11 @@
 
 #if C_SLIRP
 
-#include <map>
+#include <atomic>
 #include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 // Specific unreleased slirp to work with MSVC
@@ -70,6 +73,10 @@ struct slirp_timer {
  * This backend uses a virtual Ethernet device. Only TCP, UDP and some ICMP
  * work over this interface. This is because libslirp terminates guest
  * connections during routing and passes them to sockets created in the host.
+ *
+ * libslirp's poll loop runs on its own thread, so the host sockets are
+ * serviced as soon as they're ready instead of once per emulated tick. The
+ * frames it produces for the guest are queued until GetPackets is called.
  */
 class SlirpEthernetConnection : public EthernetConnection {
 public:
@@ -122,20 +129,33 @@ private:
 	void PollsClear();
 	bool PollsPoll(uint32_t timeout_ms);
 
+	/* Runs libslirp's poll loop until the connection is closed */
+	void PollLoop();
+	void StopPollThread();
+
 	Slirp *slirp = nullptr;        /*!< Handle to libslirp */
 	SlirpConfig config = {};       /*!< Configuration passed to libslirp */
 	SlirpCb slirp_callbacks = {};  /*!< Callbacks used by libslirp */
 	std::deque<struct slirp_timer *> timers = {}; /*!< Stored timers */
 
-	/** The GetPacket callback
+	/** The received frames
 	 * When libslirp has a new packet for us it calls ReceivePacket,
-	 * but the EthernetConnection interface requires users to poll
-	 * for new packets using GetPackets. We temporarily store the
-	 * callback from GetPackets here for ReceivePacket.
-	 * This might seem racy, but keep in mind we control when
-	 * libslirp sends us packets via our polling system.
+	 * possibly on the poll thread, but the EthernetConnection interface
+	 * requires users to poll for new packets using GetPackets. The frames
+	 * are queued here until then; the atomic count lets GetPackets skip
+	 * locking when there's nothing to deliver.
+	 */
+	std::deque<std::vector<uint8_t>> received_frames = {};
+	std::mutex received_frames_mutex = {};
+	std::atomic<size_t> num_received_frames = 0;
+
+	/** The poll thread
+	 * libslirp isn't thread-safe, so every libslirp call is made with
+	 * the slirp mutex held, except for the blocking poll itself.
 	 */
-	std::function<int(const uint8_t *, int)> get_packet_callback = nullptr;
+	std::thread poll_thread = {};
+	std::mutex slirp_mutex = {};
+	std::atomic<bool> is_polling = false;
 
 	std::deque<int> registered_fds = {}; /*!< File descriptors to watch */
 
@@ -0,0 +1,134 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "ethernet_tap.h"
+
+#if ETHERNET_TAP_SUPPORTED
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/if.h>
+#include <linux/if_tun.h>
+#include <sys/ioctl.h>
+#endif
+
+#include "setup.h"
+#include "string_utils.h"
+
+// An Ethernet header followed by a full 1500-byte payload; the NE2000 can't
+// receive anything larger
+constexpr int MaxFrameSize = 14 + 1500;
+
+// The most frames passed to the adapter per call, so a flood of incoming
+// traffic can't stall the emulation for long
+constexpr int MaxFramesPerBatch = 256;
+
+TapEthernetConnection::~TapEthernetConnection()
+{
+	if (fd >= 0) {
+		close(fd);
+	}
+}
+
+bool TapEthernetConnection::OpenDevice(const std::string& device_name)
+{
+#if defined(__linux__)
+	fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0) {
+		LOG_WARNING("TAP: Failed to open /dev/net/tun: %s", strerror(errno));
+		return false;
+	}
+
+	struct ifreq request = {};
+	request.ifr_flags    = IFF_TAP | IFF_NO_PI;
+	safe_strcpy(request.ifr_name, device_name.c_str());
+
+	if (ioctl(fd, TUNSETIFF, &request) < 0) {
+		LOG_WARNING("TAP: Failed to attach to TAP device '%s': %s",
+		            device_name.c_str(),
+		            strerror(errno));
+		close(fd);
+		fd = -1;
+		return false;
+	}
+#else
+	const auto path = "/dev/" + device_name;
+
+	fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0) {
+		LOG_WARNING("TAP: Failed to open %s: %s", path.c_str(), strerror(errno));
+		return false;
+	}
+#endif
+	return true;
+}
+
+bool TapEthernetConnection::Initialize(Section* dosbox_config)
+{
+	const auto section = static_cast<Section_prop*>(dosbox_config);
+	assert(section);
+
+	const std::string device_name = section->Get_string("tap_device");
+
+	if (!OpenDevice(device_name)) {
+		LOG_MSG("TAP: Failed to initialize");
+		return false;
+	}
+
+	// Room for the largest frame the host might hand us, so oversized
+	// frames are read whole and dropped instead of arriving truncated
+	receive_buffer.resize(64 * 1024);
+
+	LOG_MSG("TAP: Attached to TAP device '%s'", device_name.c_str());
+	return true;
+}
+
+void TapEthernetConnection::SendPacket(const uint8_t* packet, int len)
+{
+	if (len <= 0 || len > MaxFrameSize) {
+		LOG_MSG("TAP: refusing to send packet with length %d", len);
+		return;
+	}
+
+	// Lossy like the wire: a full queue on the host drops the frame
+	[[maybe_unused]] const auto num_written = write(fd, packet, static_cast<size_t>(len));
+}
+
+void TapEthernetConnection::GetPackets(std::function<int(const uint8_t*, int)> callback)
+{
+	for (auto i = 0; i < MaxFramesPerBatch; ++i) {
+		const auto len = read(fd, receive_buffer.data(), receive_buffer.size());
+		if (len < 0) {
+			// EAGAIN: the kernel has no more frames for us
+			return;
+		}
+		if (len == 0 || len > MaxFrameSize) {
+			continue;
+		}
+		callback(receive_buffer.data(), static_cast<int>(len));
+	}
+}
+
+#endif
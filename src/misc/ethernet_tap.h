@@ -0,0 +1,78 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_ETHERNET_TAP_H
+#define DOSBOX_ETHERNET_TAP_H
+
+#include "dosbox.h"
+
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+        defined(__OpenBSD__) || defined(__DragonFly__)
+#define ETHERNET_TAP_SUPPORTED 1
+#else
+#define ETHERNET_TAP_SUPPORTED 0
+#endif
+
+#if ETHERNET_TAP_SUPPORTED
+
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "ethernet.h"
+
+/** A TAP-based Ethernet connection
+ * This backend attaches the emulated adapter to a TAP device on the host, so
+ * the guest's frames go to the host's network stack as they are, without
+ * slirp's userspace TCP/IP stack in between. The TAP device has to be
+ * created and bridged or routed on the host beforehand (e.g., with
+ * 'ip tuntap add dev tap0 mode tap user $USER').
+ *
+ * The device is non-blocking, so GetPackets drains every frame waiting in
+ * the kernel in a single call, up to a batch limit per emulated tick.
+ */
+class TapEthernetConnection : public EthernetConnection {
+public:
+	/* Boilerplate EthernetConnection interface */
+	TapEthernetConnection() = default;
+	~TapEthernetConnection() override;
+
+	/* We can't copy this */
+	TapEthernetConnection(const TapEthernetConnection&) = delete;
+	TapEthernetConnection& operator=(const TapEthernetConnection&) = delete;
+
+	bool Initialize(Section* config) override;
+	void SendPacket(const uint8_t* packet, int len) override;
+	void GetPackets(std::function<int(const uint8_t*, int)> callback) override;
+
+private:
+	bool OpenDevice(const std::string& device_name);
+
+	int fd = -1; /*!< The TAP device's file descriptor */
+
+	/** The receive buffer
+	 * Reused between the reads so draining the device doesn't allocate.
+	 */
+	std::vector<uint8_t> receive_buffer = {};
+};
+
+#endif
+
+#endif
@@ -27,6 +27,7 @@
 #include <fcntl.h>
 #include <glob.h>
 #include <optional>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -482,4 +483,36 @@ void set_dos_file_time(const NativeFileHandle handle, const uint16_t date, const
 	futimens(handle, unix_times);
 }
 
+std::optional<MappedFile> map_native_file(const std_fs::path& path)
+{
+	const auto fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return {};
+	}
+
+	struct stat file_stat = {};
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+		close(fd);
+		return {};
+	}
+	const auto size = static_cast<size_t>(file_stat.st_size);
+
+	// The mapping stays valid after closing the file
+	const auto data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return {};
+	}
+
+	return MappedFile{static_cast<const uint8_t*>(data), size};
+}
+
+void unmap_native_file(MappedFile& file)
+{
+	if (file.data) {
+		munmap(const_cast<uint8_t*>(file.data), file.size);
+	}
+	file = {};
+}
+
 #endif
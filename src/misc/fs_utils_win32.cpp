@@ -243,4 +243,50 @@ void set_dos_file_time(const NativeFileHandle handle, const uint16_t date, const
 	}
 }
 
+std::optional<MappedFile> map_native_file(const std_fs::path& path)
+{
+	const auto file = CreateFileW(path.c_str(),
+	                              GENERIC_READ,
+	                              FILE_SHARE_READ,
+	                              nullptr,
+	                              OPEN_EXISTING,
+	                              FILE_ATTRIBUTE_NORMAL,
+	                              nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return {};
+	}
+
+	LARGE_INTEGER size = {};
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+		CloseHandle(file);
+		return {};
+	}
+
+	// The mapping keeps the file open
+	const auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping) {
+		return {};
+	}
+
+	const auto data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		CloseHandle(mapping);
+		return {};
+	}
+
+	return MappedFile{static_cast<const uint8_t*>(data),
+	                  static_cast<size_t>(size.QuadPart),
+	                  mapping};
+}
+
+void unmap_native_file(MappedFile& file)
+{
+	if (file.data) {
+		UnmapViewOfFile(file.data);
+		CloseHandle(file.mapping);
+	}
+	file = {};
+}
+
 #endif
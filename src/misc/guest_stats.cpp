@@ -0,0 +1,165 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "guest_stats.h"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+#include "logging.h"
+#include "pic.h"
+#include "setup.h"
+#include "string_utils.h"
+#include "timer.h"
+
+GuestStats guest_stats = {};
+
+static int64_t reset_ticks_us = GetTicksUs();
+
+// The counters at the previous periodic log, to log the differences
+static GuestStats logged_stats = {};
+
+static double log_interval_ms = 0.0;
+
+const char* STATS_GetCoreName(const StatsCore core)
+{
+	switch (core) {
+	case StatsCore::Normal: return "normal";
+	case StatsCore::Simple: return "simple";
+	case StatsCore::Full: return "full";
+	case StatsCore::Dynamic: return "dynamic";
+	case StatsCore::Other: return "other";
+	}
+	return "";
+}
+
+std::vector<StatsCount> STATS_GetTopCounts(const uint64_t* counts,
+                                           const size_t num_counts,
+                                           const size_t max_entries)
+{
+	std::vector<StatsCount> top_counts = {};
+	for (size_t i = 0; i < num_counts; ++i) {
+		if (counts[i]) {
+			top_counts.push_back({static_cast<uint32_t>(i), counts[i]});
+		}
+	}
+
+	const auto num_entries = std::min(max_entries, top_counts.size());
+	std::partial_sort(top_counts.begin(),
+	                  top_counts.begin() + num_entries,
+	                  top_counts.end(),
+	                  [](const StatsCount& a, const StatsCount& b) {
+		                  return a.count > b.count;
+	                  });
+	top_counts.resize(num_entries);
+	return top_counts;
+}
+
+double STATS_GetSecondsSinceReset()
+{
+	return static_cast<double>(GetTicksUsSince(reset_ticks_us)) / 1'000'000.0;
+}
+
+void STATS_Reset()
+{
+	guest_stats    = {};
+	logged_stats   = {};
+	reset_ticks_us = GetTicksUs();
+}
+
+// Formats the busiest entries of 'counts' since 'previous' as 'index count'
+// pairs
+template <size_t N>
+static std::string format_top_counts(const std::array<uint64_t, N>& counts,
+                                     const std::array<uint64_t, N>& previous,
+                                     const int index_digits)
+{
+	constexpr size_t MaxEntries = 5;
+
+	static std::array<uint64_t, N> differences = {};
+	for (size_t i = 0; i < N; ++i) {
+		differences[i] = counts[i] - previous[i];
+	}
+
+	std::string text = {};
+	for (const auto& entry :
+	     STATS_GetTopCounts(differences.data(), N, MaxEntries)) {
+		text += format_str(" %0*Xh %llu",
+		                   index_digits,
+		                   entry.index,
+		                   static_cast<unsigned long long>(entry.count));
+	}
+	return text.empty() ? " none" : text;
+}
+
+static void log_stats(const uint32_t /*val*/)
+{
+	const auto& s    = guest_stats;
+	const auto& prev = logged_stats;
+
+	std::string cycles = {};
+	for (size_t i = 0; i < NumStatsCores; ++i) {
+		if (const auto c = s.cycles[i] - prev.cycles[i]; c) {
+			cycles += format_str(" %s %.1fM",
+			                     STATS_GetCoreName(static_cast<StatsCore>(i)),
+			                     static_cast<double>(c) / 1'000'000.0);
+		}
+	}
+
+	auto diff = [](const uint64_t now, const uint64_t before) {
+		return static_cast<unsigned long long>(now - before);
+	};
+
+	LOG_MSG("STATS: Cycles:%s; dynamic core blocks %llu translated, %llu invalidated; "
+	        "%llu PIC events, %llu page faults (%llu nested), %llu TLB flushes",
+	        cycles.empty() ? " none" : cycles.c_str(),
+	        diff(s.dyn_blocks_translated, prev.dyn_blocks_translated),
+	        diff(s.dyn_blocks_invalidated, prev.dyn_blocks_invalidated),
+	        diff(s.pic_events, prev.pic_events),
+	        diff(s.page_faults, prev.page_faults),
+	        diff(s.nested_page_faults, prev.nested_page_faults),
+	        diff(s.tlb_flushes, prev.tlb_flushes));
+
+	LOG_MSG("STATS: Busiest I/O ports:%s; INT 21h functions:%s",
+	        format_top_counts(s.io_port_accesses, prev.io_port_accesses, 3).c_str(),
+	        format_top_counts(s.int21_calls, prev.int21_calls, 2).c_str());
+
+	logged_stats = guest_stats;
+
+	PIC_AddEvent(log_stats, log_interval_ms);
+}
+
+void STATS_Init(Section* sec)
+{
+	assert(sec);
+	const auto secprop = static_cast<Section_prop*>(sec);
+
+	PIC_RemoveEvents(log_stats);
+
+	log_interval_ms = secprop->Get_int("stats_log_interval") * 1000.0;
+	if (log_interval_ms > 0.0) {
+		logged_stats = guest_stats;
+		PIC_AddEvent(log_stats, log_interval_ms);
+
+		LOG_MSG("STATS: Logging the guest performance counters every %d seconds",
+		        secprop->Get_int("stats_log_interval"));
+	}
+}
@@ -0,0 +1,265 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "host_memory.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "dosbox.h"
+
+#if defined(WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#if defined(HAVE_MMAP)
+#include <sys/mman.h>
+#endif
+#if defined(MACOSX)
+#include <mach/mach.h>
+#endif
+#endif
+
+static std::array<std::atomic<size_t>, NumHostMemoryUses> counted_bytes = {};
+
+struct TrackedBlock {
+	HostMemoryUse use = {};
+	const void* data  = nullptr;
+	size_t num_bytes  = 0;
+};
+
+struct TrackedBlocks {
+	std::mutex mutex = {};
+	std::unordered_map<const TrackedHostMemory*, TrackedBlock> blocks = {};
+};
+
+// The tracked blocks with an address, to measure their resident pages. It's
+// never destroyed, so the static trackers can go in any order at exit.
+static TrackedBlocks& get_blocks()
+{
+	static auto tracked = new TrackedBlocks();
+	return *tracked;
+}
+
+static size_t to_index(const HostMemoryUse use)
+{
+	const auto index = static_cast<size_t>(use);
+	assert(index < NumHostMemoryUses);
+	return index;
+}
+
+void HOST_MEMORY_Add(const HostMemoryUse use, const size_t num_bytes)
+{
+	counted_bytes[to_index(use)] += num_bytes;
+}
+
+void HOST_MEMORY_Remove(const HostMemoryUse use, const size_t num_bytes)
+{
+	[[maybe_unused]] const auto previous = counted_bytes[to_index(use)].fetch_sub(
+	        num_bytes);
+	assert(previous >= num_bytes);
+}
+
+TrackedHostMemory::TrackedHostMemory(const HostMemoryUse _use) : use(_use) {}
+
+TrackedHostMemory::~TrackedHostMemory()
+{
+	Clear();
+}
+
+void TrackedHostMemory::Track(const void* _data, const size_t _num_bytes)
+{
+	HOST_MEMORY_Remove(use, num_bytes);
+	HOST_MEMORY_Add(use, _num_bytes);
+
+	if (data || _data) {
+		auto& tracked = get_blocks();
+		std::lock_guard<std::mutex> lock(tracked.mutex);
+		if (_data) {
+			tracked.blocks[this] = {use, _data, _num_bytes};
+		} else {
+			tracked.blocks.erase(this);
+		}
+	}
+	data      = _data;
+	num_bytes = _num_bytes;
+}
+
+// The committed part of a block; the pages partly covered by the block are
+// counted whole
+static size_t get_resident_bytes(const void* data, const size_t num_bytes)
+{
+#if defined(HAVE_MMAP)
+	static const auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+
+	const auto start = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+	const auto end   = reinterpret_cast<uintptr_t>(data) + num_bytes;
+	const auto num_pages = (end - start + page_size - 1) / page_size;
+
+	std::vector<unsigned char> pages(num_pages);
+#if defined(MACOSX)
+	auto vec = reinterpret_cast<char*>(pages.data());
+#else
+	auto vec = pages.data();
+#endif
+	if (mincore(reinterpret_cast<void*>(start), end - start, vec) != 0) {
+		return num_bytes;
+	}
+	size_t num_resident_pages = 0;
+	for (const auto page : pages) {
+		num_resident_pages += (page & 1);
+	}
+	return std::min(num_resident_pages * page_size, num_bytes);
+#else
+	(void)data;
+	return num_bytes;
+#endif
+}
+
+std::vector<HostMemoryUsage> HOST_MEMORY_GetUsage()
+{
+	std::vector<HostMemoryUsage> usages(NumHostMemoryUses);
+	for (size_t i = 0; i < NumHostMemoryUses; ++i) {
+		usages[i].use                = static_cast<HostMemoryUse>(i);
+		usages[i].num_bytes          = counted_bytes[i];
+		usages[i].num_resident_bytes = usages[i].num_bytes;
+	}
+
+	auto& tracked = get_blocks();
+	std::lock_guard<std::mutex> lock(tracked.mutex);
+	for (const auto& [tracker, block] : tracked.blocks) {
+		auto& usage = usages[to_index(block.use)];
+
+		const auto num_resident_bytes = get_resident_bytes(block.data,
+		                                                   block.num_bytes);
+		usage.num_resident_bytes -= std::min(usage.num_resident_bytes,
+		                                     block.num_bytes - num_resident_bytes);
+	}
+	return usages;
+}
+
+const char* HOST_MEMORY_GetName(const HostMemoryUse use)
+{
+	switch (use) {
+	case HostMemoryUse::GuestRam: return "Guest RAM";
+	case HostMemoryUse::VideoMemory: return "Video memory";
+	case HostMemoryUse::DynrecCache: return "Dynrec cache";
+	case HostMemoryUse::Voodoo: return "Voodoo";
+	case HostMemoryUse::SoundFonts: return "SoundFonts";
+	case HostMemoryUse::Mt32Roms: return "MT-32 ROMs";
+	case HostMemoryUse::MixerBuffers: return "Mixer buffers";
+	case HostMemoryUse::CaptureQueues: return "Capture queues";
+	}
+	return "";
+}
+
+std::optional<size_t> HOST_MEMORY_GetProcessResidentBytes()
+{
+#if defined(WIN32)
+	// Kernel32's variant, so there's no need to link the PSAPI library
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return counters.WorkingSetSize;
+	}
+#elif defined(MACOSX)
+	mach_task_basic_info info = {};
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(),
+	              MACH_TASK_BASIC_INFO,
+	              reinterpret_cast<task_info_t>(&info),
+	              &count) == KERN_SUCCESS) {
+		return info.resident_size;
+	}
+#else
+	// The second field is the number of resident pages
+	if (auto statm = fopen("/proc/self/statm", "r")) {
+		unsigned long num_pages = 0;
+		unsigned long num_resident_pages = 0;
+		const auto num_read = fscanf(statm, "%lu %lu", &num_pages, &num_resident_pages);
+		fclose(statm);
+		if (num_read == 2) {
+			return static_cast<size_t>(num_resident_pages) *
+			       static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		}
+	}
+#endif
+	return {};
+}
+
+std::optional<size_t> HOST_MEMORY_GetProcessPeakResidentBytes()
+{
+#if defined(WIN32)
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return counters.PeakWorkingSetSize;
+	}
+#else
+	struct rusage usage = {};
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(MACOSX)
+		// In bytes on macOS, in kilobytes elsewhere
+		return static_cast<size_t>(usage.ru_maxrss);
+#else
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+	}
+#endif
+	return {};
+}
+
+void HOST_MEMORY_LogUsage()
+{
+	constexpr size_t KB = 1024;
+
+	size_t total_bytes          = 0;
+	size_t total_resident_bytes = 0;
+	for (const auto& usage : HOST_MEMORY_GetUsage()) {
+		if (usage.num_bytes == 0) {
+			continue;
+		}
+		LOG_MSG("MEMORY: %-14s %9zu KB, %9zu KB resident",
+		        HOST_MEMORY_GetName(usage.use),
+		        usage.num_bytes / KB,
+		        usage.num_resident_bytes / KB);
+
+		total_bytes += usage.num_bytes;
+		total_resident_bytes += usage.num_resident_bytes;
+	}
+	LOG_MSG("MEMORY: %-14s %9zu KB, %9zu KB resident",
+	        "Total tracked",
+	        total_bytes / KB,
+	        total_resident_bytes / KB);
+
+	const auto resident_bytes = HOST_MEMORY_GetProcessResidentBytes();
+	const auto peak_bytes     = HOST_MEMORY_GetProcessPeakResidentBytes();
+	if (resident_bytes && peak_bytes) {
+		LOG_MSG("MEMORY: Process %zu KB resident, %zu KB at peak",
+		        *resident_bytes / KB,
+		        *peak_bytes / KB);
+	}
+}
@@ -0,0 +1,312 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "host_threads.h"
+
+#include <array>
+#include <cassert>
+#include <optional>
+#include <vector>
+
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "logging.h"
+#include "string_utils.h"
+
+enum class ThreadPriority { Auto, Lowest, Lower, Normal, Higher, Highest };
+
+struct GroupSettings {
+	// Empty to let the host schedule the threads on any core
+	std::vector<int> cores   = {};
+	ThreadPriority priority = ThreadPriority::Auto;
+};
+
+static std::array<GroupSettings, 3> group_settings = {};
+
+static const char* to_string(const HostThreadGroup group)
+{
+	switch (group) {
+	case HostThreadGroup::Emulation: return "emulation";
+	case HostThreadGroup::Audio: return "audio";
+	case HostThreadGroup::Worker: return "worker";
+	}
+	return "unknown";
+}
+
+static GroupSettings& get_settings(const HostThreadGroup group)
+{
+	const auto index = static_cast<size_t>(group);
+	assert(index < group_settings.size());
+	return group_settings[index];
+}
+
+static std::optional<std::vector<int>> parse_cores(const std::string& pref)
+{
+	const auto num_cores = static_cast<int>(std::thread::hardware_concurrency());
+
+	std::vector<int> cores = {};
+	for (const auto& range : split(pref, ",")) {
+		const auto bounds = split(range, "-");
+		if (bounds.empty() || bounds.size() > 2) {
+			return {};
+		}
+		const auto first = parse_int(bounds.front());
+		const auto last  = parse_int(bounds.back());
+		if (!first || !last || *first < 0 || *last < *first ||
+		    (num_cores > 0 && *last >= num_cores)) {
+			return {};
+		}
+		for (auto core = *first; core <= *last; ++core) {
+			cores.push_back(core);
+		}
+	}
+	if (cores.empty()) {
+		return {};
+	}
+	return cores;
+}
+
+static std::optional<ThreadPriority> parse_priority(const std::string& pref)
+{
+	if (pref == "auto") {
+		return ThreadPriority::Auto;
+	}
+	if (pref == "lowest") {
+		return ThreadPriority::Lowest;
+	}
+	if (pref == "lower") {
+		return ThreadPriority::Lower;
+	}
+	if (pref == "normal") {
+		return ThreadPriority::Normal;
+	}
+	if (pref == "higher") {
+		return ThreadPriority::Higher;
+	}
+	if (pref == "highest") {
+		return ThreadPriority::Highest;
+	}
+	return {};
+}
+
+void HOST_THREADS_Configure(const HostThreadGroup group,
+                            const std::string& affinity_pref,
+                            const std::string& priority_pref)
+{
+	auto& settings = get_settings(group);
+
+	settings.cores.clear();
+	if (affinity_pref != "auto") {
+		if (const auto cores = parse_cores(affinity_pref); cores) {
+			settings.cores = *cores;
+		} else {
+			LOG_WARNING("SDL: Invalid %s thread affinity: '%s', using 'auto'",
+			            to_string(group),
+			            affinity_pref.c_str());
+		}
+	}
+#if defined(MACOSX)
+	if (!settings.cores.empty()) {
+		LOG_WARNING("SDL: Thread affinities are not supported on macOS");
+		settings.cores.clear();
+	}
+#endif
+
+	if (const auto priority = parse_priority(priority_pref); priority) {
+		settings.priority = *priority;
+	} else {
+		LOG_WARNING("SDL: Invalid %s thread priority: '%s', using 'auto'",
+		            to_string(group),
+		            priority_pref.c_str());
+		settings.priority = ThreadPriority::Auto;
+	}
+}
+
+// The cores a group's threads have to be put on, which are all of them for
+// unpinned groups if the emulation thread they were started from is pinned
+static std::vector<int> get_affinity(const HostThreadGroup group)
+{
+	const auto& cores = get_settings(group).cores;
+	if (!cores.empty() || group == HostThreadGroup::Emulation ||
+	    get_settings(HostThreadGroup::Emulation).cores.empty()) {
+		return cores;
+	}
+
+	std::vector<int> all_cores = {};
+	for (auto core = 0; core < static_cast<int>(std::thread::hardware_concurrency());
+	     ++core) {
+		all_cores.push_back(core);
+	}
+	return all_cores;
+}
+
+#if defined(WIN32)
+
+using NativeThread = HANDLE;
+
+static NativeThread get_native_thread(std::thread& thread)
+{
+#if defined(_MSC_VER)
+	return static_cast<HANDLE>(thread.native_handle());
+#else
+	// MinGW's threads are winpthreads
+	return pthread_gethandle(thread.native_handle());
+#endif
+}
+
+static bool set_affinity(const NativeThread thread, const std::vector<int>& cores)
+{
+	DWORD_PTR mask = 0;
+	for (const auto core : cores) {
+		if (core < static_cast<int>(sizeof(mask) * 8)) {
+			mask |= static_cast<DWORD_PTR>(1) << core;
+		}
+	}
+	return mask && SetThreadAffinityMask(thread, mask) != 0;
+}
+
+static bool set_priority(const NativeThread thread, const ThreadPriority priority)
+{
+	auto to_win32_priority = [priority] {
+		switch (priority) {
+		case ThreadPriority::Lowest: return THREAD_PRIORITY_LOWEST;
+		case ThreadPriority::Lower: return THREAD_PRIORITY_BELOW_NORMAL;
+		case ThreadPriority::Higher: return THREAD_PRIORITY_ABOVE_NORMAL;
+		case ThreadPriority::Highest: return THREAD_PRIORITY_HIGHEST;
+		default: return THREAD_PRIORITY_NORMAL;
+		}
+	};
+	return SetThreadPriority(thread, to_win32_priority()) != 0;
+}
+
+#else // Linux, macOS
+
+using NativeThread = pthread_t;
+
+static NativeThread get_native_thread(std::thread& thread)
+{
+	return thread.native_handle();
+}
+
+static bool set_affinity([[maybe_unused]] const NativeThread thread,
+                         [[maybe_unused]] const std::vector<int>& cores)
+{
+#if defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (const auto core : cores) {
+		if (core < CPU_SETSIZE) {
+			CPU_SET(core, &set);
+		}
+	}
+	return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+static bool set_priority(const NativeThread thread, const ThreadPriority priority)
+{
+	sched_param param = {};
+#if defined(__linux__)
+	// Linux's normal policy only has one priority level, so the lower ones
+	// use the batch and idle policies, and the higher ones the round-robin
+	// real-time policy, which needs the CAP_SYS_NICE capability or an
+	// RLIMIT_RTPRIO limit
+	auto policy = SCHED_OTHER;
+	switch (priority) {
+	case ThreadPriority::Lowest: policy = SCHED_IDLE; break;
+	case ThreadPriority::Lower: policy = SCHED_BATCH; break;
+	case ThreadPriority::Higher:
+		policy               = SCHED_RR;
+		param.sched_priority = sched_get_priority_min(SCHED_RR);
+		break;
+	case ThreadPriority::Highest:
+		policy               = SCHED_RR;
+		param.sched_priority = sched_get_priority_min(SCHED_RR) + 1;
+		break;
+	default: break;
+	}
+#else
+	// Spread the levels over the normal policy's priority range
+	constexpr auto policy = SCHED_OTHER;
+
+	const auto min_priority = sched_get_priority_min(policy);
+	const auto max_priority = sched_get_priority_max(policy);
+	const auto mid_priority = (min_priority + max_priority) / 2;
+	switch (priority) {
+	case ThreadPriority::Lowest: param.sched_priority = min_priority; break;
+	case ThreadPriority::Lower:
+		param.sched_priority = (min_priority + mid_priority) / 2;
+		break;
+	case ThreadPriority::Higher:
+		param.sched_priority = (mid_priority + max_priority) / 2;
+		break;
+	case ThreadPriority::Highest: param.sched_priority = max_priority; break;
+	default: param.sched_priority = mid_priority; break;
+	}
+#endif
+	return pthread_setschedparam(thread, policy, &param) == 0;
+}
+
+#endif
+
+static void apply(const NativeThread thread, const HostThreadGroup group)
+{
+	// Only warn once per group, as the pools start several threads
+	static std::array<bool, 3> has_warned = {};
+	auto& warned = has_warned[static_cast<size_t>(group)];
+
+	const auto cores = get_affinity(group);
+	if (!cores.empty() && !set_affinity(thread, cores) && !warned) {
+		warned = true;
+		LOG_WARNING("SDL: Failed to set the affinity of a %s thread",
+		            to_string(group));
+	}
+
+	const auto priority = get_settings(group).priority;
+	if (priority != ThreadPriority::Auto && !set_priority(thread, priority) &&
+	    !warned) {
+		warned = true;
+		LOG_WARNING("SDL: Failed to set the priority of a %s thread; raising "
+		            "it may need elevated rights",
+		            to_string(group));
+	}
+}
+
+void HOST_THREADS_Apply(std::thread& thread, const HostThreadGroup group)
+{
+	assert(thread.joinable());
+	apply(get_native_thread(thread), group);
+}
+
+void HOST_THREADS_ApplyToCurrentThread(const HostThreadGroup group)
+{
+#if defined(WIN32)
+	apply(GetCurrentThread(), group);
+#else
+	apply(pthread_self(), group);
+#endif
+}
@@ -26,10 +26,13 @@
 #include <cstdlib>
 #include <cstring>
 #include <deque>
+#include <fstream>
+#include <iterator>
 #include <map>
 
 #include "std_filesystem.h"
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include "ansi_code_markup.h"
@@ -42,8 +45,6 @@
 #include "support.h"
 #include "unicode.h"
 
-#define LINE_IN_MAXLEN 2048
-
 CHECK_NARROWING();
 
 static const char *msg_not_found = "Message not Found!\n";
@@ -63,19 +64,6 @@ private:
 		                   code_page);
 	}
 
-	const char* CachedRenderString(const std::string& msg,
-	                               std::map<uint16_t, std::string>& output_msg_by_codepage)
-	{
-		assert(msg.length());
-		const uint16_t cp = get_utf8_code_page();
-		if (output_msg_by_codepage[cp].empty()) {
-			output_msg_by_codepage[cp] = to_dos(msg, cp);
-			assert(output_msg_by_codepage[cp].length());
-		}
-
-		return output_msg_by_codepage[cp].c_str();
-	}
-
 public:
 	Message() = delete;
 	Message(const char *markup)
@@ -156,51 +144,49 @@ static bool load_message_file(const std_fs::path &filename)
 		return false;
 	}
 
-	FILE *mfile = fopen(filename.string().c_str(), "rt");
+	std::ifstream mfile(filename, std::ios::binary);
 	if (!mfile) {
 		LOG_MSG("LANG: Failed opening language file: %s, skipping",
 		        filename.string().c_str());
 		return false;
 	}
 
-	char linein[LINE_IN_MAXLEN];
-	char name[LINE_IN_MAXLEN];
-	char message[LINE_IN_MAXLEN * 10];
-	/* Start out with empty strings */
-	name[0] = 0;
-	message[0] = 0;
-	while (fgets(linein, LINE_IN_MAXLEN, mfile) != nullptr) {
-		/* Parse the read line */
-		/* First remove characters 10 and 13 from the line */
-		char * parser=linein;
-		char * writer=linein;
-		while (*parser) {
-			if (*parser!=10 && *parser!=13) {
-				*writer++=*parser;
-			}
-			parser++;
+	// Read the whole file in one go and parse it in place, instead of
+	// assembling every message line by line
+	const std::string contents((std::istreambuf_iterator<char>(mfile)),
+	                           std::istreambuf_iterator<char>());
+
+	std::string name    = {};
+	std::string message = {};
+
+	std::string_view remaining = contents;
+	while (!remaining.empty()) {
+		const auto line_end = remaining.find('\n');
+
+		auto line = remaining.substr(0, line_end);
+		remaining.remove_prefix(line_end == std::string_view::npos
+		                                ? remaining.size()
+		                                : line_end + 1);
+		if (line.ends_with('\r')) {
+			line.remove_suffix(1);
 		}
-		*writer=0;
-		/* New message name */
-		if (linein[0]==':') {
-			message[0] = 0;
-			safe_strcpy(name, linein + 1);
-			/* End of message marker */
-		} else if (linein[0]=='.') {
-			/* Replace/Add the message to the internal languagefile */
-			/* Remove last newline (marker is \n.\n) */
-			size_t ll = safe_strlen(message);
-			// This second if should not be needed, but better be safe.
-			if (ll && message[ll - 1] == '\n')
-				message[ll - 1] = 0;
-			msg_replace(name, message);
+
+		if (line.starts_with(':')) {
+			// New message name
+			name = line.substr(1);
+			message.clear();
+		} else if (line.starts_with('.')) {
+			// End of message marker; the message doesn't include the
+			// newline before the marker
+			if (message.ends_with('\n')) {
+				message.pop_back();
+			}
+			msg_replace(name.c_str(), message.c_str());
 		} else {
-			/* Normal message to be added */
-			safe_strcat(message, linein);
-			safe_strcat(message, "\n");
+			message.append(line);
+			message += '\n';
 		}
 	}
-	fclose(mfile);
 	LOG_MSG("LANG: Loaded language file: %s", filename.string().c_str());
 	return true;
 }
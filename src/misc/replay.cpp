@@ -0,0 +1,430 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "replay.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "control.h"
+#include "cpu.h"
+#include "logging.h"
+#include "pic.h"
+#include "setup.h"
+#include "support.h"
+#include "timer.h"
+#include "video.h"
+
+// The file is plain text, one record per line:
+//
+//   dosbox-replay <version>
+//   start_time_ms <milliseconds since the Unix epoch>
+//   random_seed <seed>
+//   cycles <tick> <cycles>
+//   key <tick> <cycle> <KBD_KEYS value> <pressed>
+//   mouse_moved <tick> <cycle> <x_rel> <y_rel> <x_abs> <y_abs>
+//   mouse_button <tick> <cycle> <MouseButtonId value> <pressed>
+//   mouse_wheel <tick> <cycle> <w_rel>
+//   end <tick>
+//
+// The ticks are counted from the start of the emulation, and the relative
+// mouse movements are written as hexadecimal floats so they replay exactly.
+
+constexpr auto FileMagic   = "dosbox-replay";
+constexpr int  FileVersion = 1;
+
+enum class ReplayMode { Off, Recording, Replaying };
+
+enum class EventType { Key, MouseMoved, MouseButton, MouseWheel };
+
+struct InputEvent {
+	uint64_t tick  = 0;
+	int32_t cycle  = 0;
+	EventType type = EventType::Key;
+
+	// The key, mouse button or wheel movement
+	int32_t code = 0;
+	bool pressed = false;
+
+	float x_rel   = 0.0f;
+	float y_rel   = 0.0f;
+	int32_t x_abs = 0;
+	int32_t y_abs = 0;
+};
+
+static ReplayMode mode = ReplayMode::Off;
+
+static uint64_t elapsed_ticks = 0;
+static int64_t start_time_ms  = 0;
+
+// Recording state; the autotype thread adds keys too, hence the mutex
+static std::ofstream record_file = {};
+static std::mutex record_mutex   = {};
+static int last_recorded_cycles  = -1;
+
+// Replay state
+static std::vector<InputEvent> replay_events = {};
+static std::vector<std::pair<uint64_t, int>> replay_cycles = {};
+static std::optional<uint64_t> replay_end_tick = {};
+static size_t next_event_index        = 0;
+static size_t next_cycles_index       = 0;
+static bool is_dispatching_replay     = false;
+
+static int64_t get_host_time_ms()
+{
+	using namespace std::chrono;
+	return duration_cast<milliseconds>(system_clock::now().time_since_epoch())
+	        .count();
+}
+
+int64_t REPLAY_GetWallClockMs()
+{
+	if (mode == ReplayMode::Off) {
+		return get_host_time_ms();
+	}
+	// Each tick is one emulated millisecond
+	return start_time_ms + static_cast<int64_t>(elapsed_ticks);
+}
+
+bool REPLAY_IsIgnoringHostInput()
+{
+	return mode == ReplayMode::Replaying && !is_dispatching_replay;
+}
+
+// Recording
+// ~~~~~~~~~
+
+template <typename... Args>
+static void write_record(const char* name, const Args&... args)
+{
+	std::lock_guard<std::mutex> lock(record_mutex);
+
+	record_file << name << ' ' << elapsed_ticks << ' ' << PIC_TickIndexND();
+	((record_file << ' ' << args), ...);
+	record_file << '\n';
+}
+
+void REPLAY_RecordKey(const KBD_KEYS key, const bool is_pressed)
+{
+	if (mode != ReplayMode::Recording) {
+		return;
+	}
+	write_record("key", static_cast<int>(key), static_cast<int>(is_pressed));
+}
+
+void REPLAY_RecordMouseMoved(const float x_rel, const float y_rel,
+                             const int32_t x_abs, const int32_t y_abs)
+{
+	if (mode != ReplayMode::Recording) {
+		return;
+	}
+	std::ostringstream rel = {};
+	rel << std::hexfloat << x_rel << ' ' << y_rel;
+	write_record("mouse_moved", rel.str(), x_abs, y_abs);
+}
+
+void REPLAY_RecordMouseButton(const MouseButtonId button_id, const bool pressed)
+{
+	if (mode != ReplayMode::Recording) {
+		return;
+	}
+	write_record("mouse_button",
+	             static_cast<int>(button_id),
+	             static_cast<int>(pressed));
+}
+
+void REPLAY_RecordMouseWheel(const int16_t w_rel)
+{
+	if (mode != ReplayMode::Recording) {
+		return;
+	}
+	write_record("mouse_wheel", w_rel);
+}
+
+static void record_cycles()
+{
+	if (CPU_CycleMax == last_recorded_cycles) {
+		return;
+	}
+	last_recorded_cycles = CPU_CycleMax;
+
+	std::lock_guard<std::mutex> lock(record_mutex);
+	record_file << "cycles " << elapsed_ticks << ' ' << CPU_CycleMax << '\n';
+}
+
+static bool start_recording(const std::string& path)
+{
+	record_file.open(path, std::ios::out | std::ios::trunc);
+	if (!record_file) {
+		LOG_ERR("REPLAY: Can't create the recording '%s'", path.c_str());
+		return false;
+	}
+
+	start_time_ms = get_host_time_ms();
+
+	const auto seed = std::random_device{}();
+	SetRandomizerSeed(seed);
+
+	record_file << FileMagic << ' ' << FileVersion << '\n'
+	            << "start_time_ms " << start_time_ms << '\n'
+	            << "random_seed " << seed << '\n';
+
+	LOG_MSG("REPLAY: Recording the session to '%s'", path.c_str());
+	return true;
+}
+
+// Replaying
+// ~~~~~~~~~
+
+static std::optional<InputEvent> parse_event(const std::string& type,
+                                             std::istringstream& fields)
+{
+	InputEvent event = {};
+	fields >> event.tick >> event.cycle;
+
+	int pressed = 0;
+	if (type == "key") {
+		event.type = EventType::Key;
+		fields >> event.code >> pressed;
+	} else if (type == "mouse_moved") {
+		event.type = EventType::MouseMoved;
+
+		// Hexadecimal floats can't be read with operator>>
+		std::string x_rel = {};
+		std::string y_rel = {};
+		fields >> x_rel >> y_rel >> event.x_abs >> event.y_abs;
+		event.x_rel = std::strtof(x_rel.c_str(), nullptr);
+		event.y_rel = std::strtof(y_rel.c_str(), nullptr);
+	} else if (type == "mouse_button") {
+		event.type = EventType::MouseButton;
+		fields >> event.code >> pressed;
+	} else if (type == "mouse_wheel") {
+		event.type = EventType::MouseWheel;
+		fields >> event.code;
+	} else {
+		return {};
+	}
+	event.pressed = (pressed != 0);
+
+	if (fields.fail()) {
+		return {};
+	}
+	return event;
+}
+
+static bool load_replay(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file) {
+		LOG_ERR("REPLAY: Can't open the recording '%s'", path.c_str());
+		return false;
+	}
+
+	std::string line = {};
+	std::string magic = {};
+	int version = 0;
+	if (!std::getline(file, line) ||
+	    !(std::istringstream(line) >> magic >> version) ||
+	    magic != FileMagic || version != FileVersion) {
+		LOG_ERR("REPLAY: '%s' is not a version %d recording",
+		        path.c_str(),
+		        FileVersion);
+		return false;
+	}
+
+	auto line_number = 1;
+	while (std::getline(file, line)) {
+		++line_number;
+
+		std::istringstream fields(line);
+		std::string type = {};
+		if (!(fields >> type)) {
+			continue;
+		}
+
+		auto is_valid = true;
+		if (type == "start_time_ms") {
+			is_valid = static_cast<bool>(fields >> start_time_ms);
+		} else if (type == "random_seed") {
+			uint32_t seed = 0;
+			is_valid = static_cast<bool>(fields >> seed);
+			SetRandomizerSeed(seed);
+		} else if (type == "cycles") {
+			uint64_t tick = 0;
+			int cycles    = 0;
+			is_valid = static_cast<bool>(fields >> tick >> cycles);
+			replay_cycles.emplace_back(tick, cycles);
+		} else if (type == "end") {
+			uint64_t tick = 0;
+			is_valid = static_cast<bool>(fields >> tick);
+			replay_end_tick = tick;
+		} else if (const auto event = parse_event(type, fields); event) {
+			replay_events.push_back(*event);
+		} else {
+			is_valid = false;
+		}
+
+		if (!is_valid) {
+			LOG_ERR("REPLAY: Invalid line %d in '%s': '%s'",
+			        line_number,
+			        path.c_str(),
+			        line.c_str());
+			return false;
+		}
+	}
+
+	if (!replay_end_tick) {
+		LOG_WARNING("REPLAY: '%s' has no end, the recording was cut short",
+		            path.c_str());
+	}
+	LOG_MSG("REPLAY: Replaying %u input events from '%s'",
+	        static_cast<unsigned>(replay_events.size()),
+	        path.c_str());
+	return true;
+}
+
+static void dispatch_event(const uint32_t index)
+{
+	assert(index < replay_events.size());
+	const auto& event = replay_events[index];
+
+	is_dispatching_replay = true;
+	switch (event.type) {
+	case EventType::Key:
+		KEYBOARD_AddKey(static_cast<KBD_KEYS>(event.code), event.pressed);
+		break;
+	case EventType::MouseMoved:
+		MOUSE_EventMoved(event.x_rel, event.y_rel, event.x_abs, event.y_abs);
+		break;
+	case EventType::MouseButton:
+		MOUSE_EventButton(static_cast<MouseButtonId>(event.code),
+		                  event.pressed);
+		break;
+	case EventType::MouseWheel:
+		MOUSE_EventWheel(static_cast<int16_t>(event.code));
+		break;
+	}
+	is_dispatching_replay = false;
+}
+
+// Schedules the events of the current tick at the cycles they were recorded at
+static void schedule_events()
+{
+	while (next_event_index < replay_events.size() &&
+	       replay_events[next_event_index].tick <= elapsed_ticks) {
+		const auto& event = replay_events[next_event_index];
+
+		const auto delay = (event.tick == elapsed_ticks && CPU_CycleMax > 0)
+		                         ? static_cast<double>(event.cycle) / CPU_CycleMax
+		                         : 0.0;
+		PIC_AddEvent(dispatch_event, delay, static_cast<uint32_t>(next_event_index));
+		++next_event_index;
+	}
+}
+
+static void replay_tick()
+{
+	while (next_cycles_index < replay_cycles.size() &&
+	       replay_cycles[next_cycles_index].first <= elapsed_ticks) {
+		CPU_CycleMax = replay_cycles[next_cycles_index].second;
+		++next_cycles_index;
+	}
+	// Overrides the cycles the auto-adjustment might have picked
+	if (next_cycles_index > 0) {
+		CPU_CycleMax  = replay_cycles[next_cycles_index - 1].second;
+		CPU_CycleLeft = CPU_CycleMax;
+	}
+
+	schedule_events();
+
+	if (replay_end_tick && elapsed_ticks >= *replay_end_tick) {
+		LOG_MSG("REPLAY: Reached the end of the recording after %llu ticks",
+		        static_cast<unsigned long long>(elapsed_ticks));
+		mode = ReplayMode::Off;
+		GFX_RequestExit(true);
+	}
+}
+
+// Lifecycle
+// ~~~~~~~~~
+
+static void tick_handler()
+{
+	++elapsed_ticks;
+
+	if (mode == ReplayMode::Recording) {
+		record_cycles();
+	} else if (mode == ReplayMode::Replaying) {
+		replay_tick();
+	}
+}
+
+static void replay_destroy(Section*)
+{
+	if (mode == ReplayMode::Recording) {
+		std::lock_guard<std::mutex> lock(record_mutex);
+		record_file << "end " << elapsed_ticks << '\n';
+		record_file.close();
+
+		LOG_MSG("REPLAY: Recorded %llu ticks",
+		        static_cast<unsigned long long>(elapsed_ticks));
+	}
+	mode = ReplayMode::Off;
+}
+
+void REPLAY_Init(Section* sec)
+{
+	assert(sec);
+
+	// The session is recorded or replayed once, across restarts
+	static bool is_initialised = false;
+	if (is_initialised) {
+		return;
+	}
+	is_initialised = true;
+
+	const auto& record_path = control->arguments.record;
+	const auto& replay_path = control->arguments.replay;
+
+	if (!record_path.empty() && !replay_path.empty()) {
+		LOG_ERR("REPLAY: '--record' and '--replay' can't be used together");
+		return;
+	}
+
+	if (!record_path.empty() && start_recording(record_path)) {
+		mode = ReplayMode::Recording;
+	} else if (!replay_path.empty() && load_replay(replay_path)) {
+		mode = ReplayMode::Replaying;
+		schedule_events();
+	} else {
+		return;
+	}
+
+	TIMER_AddTickHandler(tick_handler);
+	sec->AddDestroyFunction(&replay_destroy);
+}
@@ -22,10 +22,13 @@
 
 #include "../capture/image/image_saver.h"
 
+#include <algorithm>
 #include <cassert>
+#include <string>
 
 template <typename T>
-RWQueue<T>::RWQueue(size_t queue_capacity)
+RWQueue<T>::RWQueue(size_t queue_capacity, const RWQueueMode queue_mode)
+        : mode(queue_mode)
 {
 	Resize(queue_capacity);
 }
@@ -36,15 +39,125 @@ void RWQueue<T>::Resize(size_t queue_capacity)
 	std::lock_guard<std::mutex> lock(mutex);
 	capacity = queue_capacity;
 	assert(capacity > 0);
+
+	if (mode == RWQueueMode::LockFree) {
+		ring        = std::make_unique<T[]>(capacity);
+		write_index = 0;
+		read_index  = 0;
+	}
 }
 
 template <typename T>
 size_t RWQueue<T>::Size()
 {
+	if (mode == RWQueueMode::LockFree) {
+		return RingSize();
+	}
 	std::lock_guard<std::mutex> lock(mutex);
 	return queue.size();
 }
 
+// Lock-free mode helpers
+// ~~~~~~~~~~~~~~~~~~~~~~
+// A blocking thread flags that it waits before checking the indexes under the
+// mutex, and the other thread checks the flag after publishing its index. The
+// fences order these so that at least one of them sees the other's store, so
+// a wake-up can't get lost between the check and the wait.
+
+template <typename T>
+size_t RWQueue<T>::RingSize() const
+{
+	const auto num_read = read_index.load(std::memory_order_acquire);
+	return write_index.load(std::memory_order_acquire) - num_read;
+}
+
+template <typename T>
+void RWQueue<T>::WaitForRoom(const size_t num_items)
+{
+	auto can_proceed = [&] {
+		return !is_running || capacity - RingSize() >= num_items;
+	};
+	if (can_proceed()) {
+		return;
+	}
+	std::unique_lock<std::mutex> lock(mutex);
+	is_producer_waiting = true;
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	has_room.wait(lock, can_proceed);
+	is_producer_waiting = false;
+}
+
+template <typename T>
+void RWQueue<T>::WaitForItems(const size_t num_items)
+{
+	auto can_proceed = [&] {
+		return !is_running || RingSize() >= num_items;
+	};
+	if (can_proceed()) {
+		return;
+	}
+	std::unique_lock<std::mutex> lock(mutex);
+	is_consumer_waiting = true;
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	has_items.wait(lock, can_proceed);
+	is_consumer_waiting = false;
+}
+
+template <typename T>
+void RWQueue<T>::NotifyProducer()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (is_producer_waiting.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(mutex);
+		has_room.notify_one();
+	}
+}
+
+template <typename T>
+void RWQueue<T>::NotifyConsumer()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (is_consumer_waiting.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(mutex);
+		has_items.notify_one();
+	}
+}
+
+// Moves items into and out of the ring in at most two runs, split where the
+// ring wraps around
+template <typename T>
+void RWQueue<T>::MoveIntoRing(typename std::vector<T>::iterator source,
+                              const size_t num_items)
+{
+	const auto num_written = write_index.load(std::memory_order_relaxed);
+	const auto start       = num_written % capacity;
+	const auto first_run   = std::min(num_items, capacity - start);
+
+	const auto source_split = source + static_cast<difference_t>(first_run);
+	std::move(source, source_split, ring.get() + start);
+	std::move(source_split,
+	          source_split + static_cast<difference_t>(num_items - first_run),
+	          ring.get());
+
+	write_index.store(num_written + num_items, std::memory_order_release);
+}
+
+template <typename T>
+void RWQueue<T>::MoveOutOfRing(typename std::vector<T>::iterator target,
+                               const size_t num_items)
+{
+	const auto num_read  = read_index.load(std::memory_order_relaxed);
+	const auto start     = num_read % capacity;
+	const auto first_run = std::min(num_items, capacity - start);
+
+	target = std::move(ring.get() + start, ring.get() + start + first_run, target);
+	std::move(ring.get(), ring.get() + (num_items - first_run), target);
+
+	read_index.store(num_read + num_items, std::memory_order_release);
+}
+
 template <typename T>
 void RWQueue<T>::Start()
 {
@@ -70,6 +183,13 @@ void RWQueue<T>::Stop()
 template <typename T>
 void RWQueue<T>::Clear()
 {
+	if (mode == RWQueueMode::LockFree) {
+		// Discard the items by catching up with the producer
+		read_index.store(write_index.load(std::memory_order_acquire),
+		                 std::memory_order_release);
+		NotifyProducer();
+		return;
+	}
 	{
 		std::lock_guard<std::mutex> lock(mutex);
 		queue.clear();
@@ -94,6 +214,9 @@ float RWQueue<T>::GetPercentFull()
 template <typename T>
 bool RWQueue<T>::IsEmpty()
 {
+	if (mode == RWQueueMode::LockFree) {
+		return RingSize() == 0;
+	}
 	std::lock_guard<std::mutex> lock(mutex);
 	return queue.empty();
 }
@@ -107,6 +230,19 @@ bool RWQueue<T>::IsRunning() const
 template <typename T>
 bool RWQueue<T>::Enqueue(T&& item)
 {
+	if (mode == RWQueueMode::LockFree) {
+		WaitForRoom(1);
+		if (!is_running) {
+			return false;
+		}
+		const auto num_written = write_index.load(std::memory_order_relaxed);
+		ring[num_written % capacity] = std::move(item);
+		write_index.store(num_written + 1, std::memory_order_release);
+
+		NotifyConsumer();
+		return is_running;
+	}
+
 	// wait until we're stopped or the queue has room to accept the item
 	std::unique_lock<std::mutex> lock(mutex);
 	has_room.wait(lock,
@@ -142,7 +278,24 @@ bool RWQueue<T>::BulkEnqueue(std::vector<T>& from_source, const size_t num_reque
 	auto source_start  = from_source.begin();
 	auto num_remaining = num_requested;
 
-	while (num_remaining > 0) {
+	while (mode == RWQueueMode::LockFree && num_remaining > 0) {
+		const auto free_capacity = capacity - RingSize();
+
+		const auto num_items = std::max(min_items,
+		                                std::min(num_remaining,
+		                                         free_capacity));
+		WaitForRoom(num_items);
+		if (!is_running) {
+			break;
+		}
+		MoveIntoRing(source_start, num_items);
+		source_start += static_cast<difference_t>(num_items);
+		num_remaining -= num_items;
+
+		NotifyConsumer();
+	}
+
+	while (mode == RWQueueMode::Locking && num_remaining > 0) {
 		std::unique_lock<std::mutex> lock(mutex);
 
 		const auto free_capacity = static_cast<size_t>(capacity -
@@ -184,6 +337,22 @@ bool RWQueue<T>::BulkEnqueue(std::vector<T>& from_source, const size_t num_reque
 template <typename T>
 std::optional<T> RWQueue<T>::Dequeue()
 {
+	if (mode == RWQueueMode::LockFree) {
+		WaitForItems(1);
+
+		// Even if the queue has stopped, we need to drain the
+		// (previously) queued items before we're done.
+		auto optional_item = std::optional<T>();
+		if (RingSize() > 0) {
+			const auto num_read = read_index.load(std::memory_order_relaxed);
+			optional_item = std::move(ring[num_read % capacity]);
+			read_index.store(num_read + 1, std::memory_order_release);
+
+			NotifyProducer();
+		}
+		return optional_item;
+	}
+
 	// wait until we're stopped or the queue has an item
 	std::unique_lock<std::mutex> lock(mutex);
 	has_items.wait(lock, [this] { return !is_running || !queue.empty(); });
@@ -216,7 +385,28 @@ bool RWQueue<T>::BulkDequeue(std::vector<T>& into_target, const size_t num_reque
 	auto target_start  = into_target.begin();
 	auto num_remaining = num_requested;
 
-	while (num_remaining > 0) {
+	while (mode == RWQueueMode::LockFree && num_remaining > 0) {
+		const auto num_items = std::max(min_items,
+		                                std::min(num_remaining, RingSize()));
+		WaitForItems(num_items);
+
+		// Even if the queue has stopped, we need to drain the
+		// (previously) queued items before we're done.
+		const auto num_available = std::min(num_items, RingSize());
+		if (num_available == 0) {
+			// If we stopped while dequeing, cap off the target
+			// vector based on the subset that were dequeued.
+			into_target.resize(num_requested - num_remaining);
+			break;
+		}
+		MoveOutOfRing(target_start, num_available);
+		target_start += static_cast<difference_t>(num_available);
+		num_remaining -= num_available;
+
+		NotifyProducer();
+	}
+
+	while (mode == RWQueueMode::Locking && num_remaining > 0) {
 		std::unique_lock<std::mutex> lock(mutex);
 
 		const auto num_items = std::max(min_items,
@@ -271,3 +461,21 @@ template class RWQueue<MidiWork>;
 
 #include "render.h"
 template class RWQueue<SaveImageTask>;
+
+#include "../capture/capture_writer.h"
+template class RWQueue<CaptureWriteTask>;
+
+// CD-DA track decoding
+#include "../dos/cdrom.h"
+template class RWQueue<CDROM_Interface_Image::DecodedBlock>;
+
+// Threaded OPL rendering
+#include "../hardware/opl.h"
+#include "../hardware/opl_capture.h"
+template class RWQueue<Opl::Work>;
+
+// Frame presentation thread
+template class RWQueue<bool>;
+
+// Asynchronous log writer
+template class RWQueue<std::string>;
@@ -0,0 +1,653 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "savestate.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <memory>
+
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "logging.h"
+#include "worker_pool.h"
+
+// File layout, all values in host byte order:
+//
+//   magic ("DBSS"), version (uint32), number of records (uint32)
+//   per record: name size (uint16), name, data size (uint64), data
+//
+constexpr char FileMagic[]     = {'D', 'B', 'S', 'S'};
+constexpr uint32_t FileVersion = 1;
+
+struct Registration {
+	std::string name = {};
+
+	savestate_save_f save   = {};
+	savestate_check_f check = {};
+	savestate_load_f load   = {};
+
+	uint8_t* region_data        = nullptr;
+	size_t region_size          = 0;
+	savestate_restore_f restore = {};
+};
+
+// Kept in registration order, so states get loaded in the order the modules
+// were initialized
+static std::vector<Registration> registrations = {};
+
+// Bumped on every change of the registrations, so the rewind snapshots can
+// tell they no longer match them
+static uint64_t registrations_generation = 0;
+
+// A record ready to be written: its header is serialized up front, so
+// writing it out doesn't need any allocations
+struct Record {
+	std::vector<uint8_t> header = {};
+	std::vector<uint8_t> buffer = {};
+
+	const uint8_t* data = nullptr;
+	size_t size         = 0;
+};
+
+#if !defined(WIN32)
+static struct {
+	pid_t pid        = 0;
+	std::string file = {};
+} pending_save = {};
+#endif
+
+static void add_registration(Registration&& registration)
+{
+	++registrations_generation;
+
+	const auto it = std::find_if(registrations.begin(),
+	                             registrations.end(),
+	                             [&](const Registration& r) {
+		                             return r.name == registration.name;
+	                             });
+	if (it != registrations.end()) {
+		*it = std::move(registration);
+	} else {
+		registrations.emplace_back(std::move(registration));
+	}
+}
+
+void SAVESTATE_AddComponent(const std::string& name, savestate_save_f save,
+                            savestate_check_f check, savestate_load_f load)
+{
+	assert(!name.empty() && name.size() <= UINT16_MAX);
+	assert(save && check && load);
+
+	Registration registration = {};
+	registration.name         = name;
+	registration.save         = std::move(save);
+	registration.check        = std::move(check);
+	registration.load         = std::move(load);
+	add_registration(std::move(registration));
+}
+
+void SAVESTATE_AddMemoryRegion(const std::string& name, uint8_t* data,
+                               size_t size, savestate_restore_f restore)
+{
+	assert(!name.empty() && name.size() <= UINT16_MAX);
+	assert(data);
+
+	Registration registration = {};
+	registration.name         = name;
+	registration.region_data  = data;
+	registration.region_size  = size;
+	registration.restore      = std::move(restore);
+	add_registration(std::move(registration));
+}
+
+void SAVESTATE_Remove(const std::string& name)
+{
+	++registrations_generation;
+
+	std::erase_if(registrations,
+	              [&](const Registration& r) { return r.name == name; });
+}
+
+template <typename T>
+static void append(std::vector<uint8_t>& out, const T& value)
+{
+	const auto bytes = reinterpret_cast<const uint8_t*>(&value);
+	out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+static std::vector<Record> take_records()
+{
+	std::vector<Record> records = {};
+	records.reserve(registrations.size());
+
+	for (const auto& registration : registrations) {
+		Record record = {};
+		if (registration.save) {
+			registration.save(record.buffer);
+			record.data = record.buffer.data();
+			record.size = record.buffer.size();
+		} else {
+			record.data = registration.region_data;
+			record.size = registration.region_size;
+		}
+		const auto name_size = static_cast<uint16_t>(registration.name.size());
+		append(record.header, name_size);
+		record.header.insert(record.header.end(),
+		                     registration.name.begin(),
+		                     registration.name.end());
+		append(record.header, static_cast<uint64_t>(record.size));
+
+		records.emplace_back(std::move(record));
+	}
+	return records;
+}
+
+// Writes the file through a 'write(data, size) -> bool' function
+template <typename WriteFunction>
+static bool write_records(const std::vector<Record>& records, WriteFunction&& write)
+{
+	const auto num_records = static_cast<uint32_t>(records.size());
+
+	bool ok = write(FileMagic, sizeof(FileMagic)) &&
+	          write(&FileVersion, sizeof(FileVersion)) &&
+	          write(&num_records, sizeof(num_records));
+
+	for (const auto& record : records) {
+		ok = ok && write(record.header.data(), record.header.size()) &&
+		     write(record.data, record.size);
+	}
+	return ok;
+}
+
+static bool write_file(const std::vector<Record>& records, const std_fs::path& file)
+{
+	std::ofstream out(file, std::ios::binary | std::ios::trunc);
+	return out && write_records(records, [&](const void* data, const size_t size) {
+		       out.write(static_cast<const char*>(data),
+		                 static_cast<std::streamsize>(size));
+		       return static_cast<bool>(out);
+	       });
+}
+
+#if !defined(WIN32)
+// Runs in the forked child, so it sticks to async-signal-safe calls
+[[noreturn]] static void write_file_and_exit(const std::vector<Record>& records,
+                                             const char* temp_file,
+                                             const char* file)
+{
+	const auto fd = open(temp_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		_exit(1);
+	}
+	auto write_fully = [fd](const void* data, size_t size) {
+		auto bytes = static_cast<const uint8_t*>(data);
+		while (size > 0) {
+			const auto written = write(fd, bytes, size);
+			if (written < 0) {
+				return false;
+			}
+			bytes += written;
+			size -= static_cast<size_t>(written);
+		}
+		return true;
+	};
+	const bool ok = write_records(records, write_fully);
+	if (close(fd) != 0 || !ok || rename(temp_file, file) != 0) {
+		unlink(temp_file);
+		_exit(1);
+	}
+	_exit(0);
+}
+#endif
+
+bool SAVESTATE_WaitForSave()
+{
+#if !defined(WIN32)
+	if (pending_save.pid <= 0) {
+		return true;
+	}
+	int status = 0;
+	while (waitpid(pending_save.pid, &status, 0) < 0 && errno == EINTR) {
+	}
+	pending_save.pid = 0;
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		LOG_WARNING("SAVESTATE: Failed writing state to '%s'",
+		            pending_save.file.c_str());
+		return false;
+	}
+	LOG_MSG("SAVESTATE: Saved state to '%s'", pending_save.file.c_str());
+#endif
+	return true;
+}
+
+bool SAVESTATE_Save(const std_fs::path& file)
+{
+	// only one save can be in flight, they write the same files
+	SAVESTATE_WaitForSave();
+
+	const auto records = take_records();
+
+#if !defined(WIN32)
+	const auto file_string = file.string();
+	const auto temp_string = file_string + ".tmp";
+
+	const auto pid = fork();
+	if (pid == 0) {
+		write_file_and_exit(records, temp_string.c_str(), file_string.c_str());
+	}
+	if (pid > 0) {
+		pending_save.pid  = pid;
+		pending_save.file = file_string;
+		return true;
+	}
+	LOG_WARNING("SAVESTATE: Can't fork a process to write the state, writing it directly");
+#endif
+
+	if (!write_file(records, file)) {
+		LOG_WARNING("SAVESTATE: Failed writing state to '%s'",
+		            file.string().c_str());
+		return false;
+	}
+	LOG_MSG("SAVESTATE: Saved state to '%s'", file.string().c_str());
+	return true;
+}
+
+struct LoadedRecord {
+	std::string name          = {};
+	std::vector<uint8_t> data = {};
+};
+
+static bool read_records(const std_fs::path& file, std::vector<LoadedRecord>& records)
+{
+	std::ifstream in(file, std::ios::binary);
+	if (!in) {
+		LOG_WARNING("SAVESTATE: Can't open state file '%s'",
+		            file.string().c_str());
+		return false;
+	}
+
+	char magic[sizeof(FileMagic)] = {};
+	uint32_t version              = 0;
+	uint32_t num_records          = 0;
+
+	in.read(magic, sizeof(magic));
+	in.read(reinterpret_cast<char*>(&version), sizeof(version));
+	in.read(reinterpret_cast<char*>(&num_records), sizeof(num_records));
+
+	if (!in || memcmp(magic, FileMagic, sizeof(magic)) != 0 ||
+	    version != FileVersion) {
+		LOG_WARNING("SAVESTATE: '%s' isn't a valid state file",
+		            file.string().c_str());
+		return false;
+	}
+
+	for (uint32_t i = 0; i < num_records; ++i) {
+		uint16_t name_size = 0;
+		uint64_t data_size = 0;
+
+		LoadedRecord record = {};
+		in.read(reinterpret_cast<char*>(&name_size), sizeof(name_size));
+		record.name.resize(name_size);
+		in.read(record.name.data(), name_size);
+		in.read(reinterpret_cast<char*>(&data_size), sizeof(data_size));
+		if (!in) {
+			break;
+		}
+		record.data.resize(data_size);
+		in.read(reinterpret_cast<char*>(record.data.data()),
+		        static_cast<std::streamsize>(data_size));
+		if (!in) {
+			break;
+		}
+		records.emplace_back(std::move(record));
+	}
+
+	if (records.size() != num_records) {
+		LOG_WARNING("SAVESTATE: State file '%s' is truncated",
+		            file.string().c_str());
+		return false;
+	}
+	return true;
+}
+
+static bool check_record(const Registration& registration,
+                         const std::vector<uint8_t>& data)
+{
+	if (registration.check) {
+		return registration.check(data);
+	}
+	return data.size() == registration.region_size;
+}
+
+static void load_record(const Registration& registration, const LoadedRecord& record)
+{
+	if (registration.load) {
+		registration.load(record.data);
+	} else if (registration.restore) {
+		registration.restore(record.data.data(), record.data.size());
+	} else {
+		std::copy(record.data.begin(), record.data.end(), registration.region_data);
+	}
+}
+
+bool SAVESTATE_Load(const std_fs::path& file)
+{
+	SAVESTATE_WaitForSave();
+
+	// read and check everything first, so a broken or mismatching file
+	// doesn't leave a mix of the current and the saved state behind
+	std::vector<LoadedRecord> records = {};
+	if (!read_records(file, records)) {
+		return false;
+	}
+
+	std::vector<const LoadedRecord*> matches = {};
+	matches.reserve(registrations.size());
+
+	for (const auto& registration : registrations) {
+		const auto record = std::find_if(records.begin(),
+		                                 records.end(),
+		                                 [&](const LoadedRecord& r) {
+			                                 return r.name == registration.name;
+		                                 });
+		if (record == records.end()) {
+			LOG_WARNING("SAVESTATE: No '%s' state in '%s'",
+			            registration.name.c_str(),
+			            file.string().c_str());
+			return false;
+		}
+		if (!check_record(registration, record->data)) {
+			LOG_WARNING("SAVESTATE: Can't load '%s' state from '%s'",
+			            registration.name.c_str(),
+			            file.string().c_str());
+			return false;
+		}
+		matches.push_back(&*record);
+	}
+
+	for (size_t i = 0; i < registrations.size(); ++i) {
+		load_record(registrations[i], *matches[i]);
+	}
+	LOG_MSG("SAVESTATE: Loaded state from '%s'", file.string().c_str());
+	return true;
+}
+
+// Rewinding
+// ~~~~~~~~~
+// The memory region deltas are a list of changed pages, each stored as its
+// page index (uint32) followed by runs of a zero count (uint16), a literal
+// count (uint16) and the literal bytes of the page XORed with its previous
+// contents. Unchanged bytes XOR to zero, so the runs mostly skip them.
+constexpr size_t DeltaPageSize = 4096;
+
+struct RewindRecord {
+	// The state of a component
+	std::vector<uint8_t> component = {};
+
+	// The delta turning a memory region back into its contents at the
+	// previous snapshot; not valid for the oldest snapshot
+	std::shared_future<std::vector<uint8_t>> undo_delta = {};
+};
+
+using RewindSnapshot = std::vector<RewindRecord>;
+
+static struct {
+	size_t max_snapshots = 0;
+	uint64_t generation  = 0;
+
+	std::deque<RewindSnapshot> snapshots = {};
+
+	// The memory regions' contents at the latest snapshot, or empty if
+	// there's none
+	std::vector<std::vector<uint8_t>> regions = {};
+} rewind_state = {};
+
+static void reset_rewind()
+{
+	rewind_state.snapshots.clear();
+	rewind_state.regions.clear();
+	rewind_state.regions.resize(registrations.size());
+	rewind_state.generation = registrations_generation;
+}
+
+void SAVESTATE_SetRewindDepth(const size_t num_snapshots)
+{
+	rewind_state.max_snapshots = num_snapshots;
+	reset_rewind();
+}
+
+// Collects the pages differing from the previous contents as XOR deltas,
+// and updates the previous contents
+static std::vector<uint8_t> take_changed_pages(uint8_t* previous,
+                                               const uint8_t* current,
+                                               const size_t size)
+{
+	std::vector<uint8_t> pages = {};
+
+	for (size_t offset = 0; offset < size; offset += DeltaPageSize) {
+		const auto page_size = std::min(DeltaPageSize, size - offset);
+		if (memcmp(previous + offset, current + offset, page_size) == 0) {
+			continue;
+		}
+		const auto index = static_cast<uint32_t>(offset / DeltaPageSize);
+		append(pages, index);
+		for (size_t i = 0; i < page_size; ++i) {
+			pages.push_back(previous[offset + i] ^ current[offset + i]);
+		}
+		memcpy(previous + offset, current + offset, page_size);
+	}
+	return pages;
+}
+
+static std::vector<uint8_t> encode_changed_pages(const std::vector<uint8_t>& pages,
+                                                 const size_t region_size)
+{
+	// Zero runs shorter than this are cheaper to keep in the literals
+	constexpr size_t MinZeroRun = 4;
+
+	std::vector<uint8_t> delta = {};
+
+	size_t pos = 0;
+	while (pos < pages.size()) {
+		uint32_t index = 0;
+		memcpy(&index, pages.data() + pos, sizeof(index));
+		append(delta, index);
+		pos += sizeof(index);
+
+		const auto page_size = std::min(DeltaPageSize,
+		                                region_size - index * DeltaPageSize);
+		const auto page      = pages.data() + pos;
+
+		size_t i = 0;
+		while (i < page_size) {
+			const auto zeros_start = i;
+			while (i < page_size && page[i] == 0) {
+				++i;
+			}
+			const auto literals_start = i;
+			auto zeros_end            = i;
+			while (i < page_size) {
+				if (page[i] != 0) {
+					zeros_end = ++i;
+				} else if (++i - zeros_end >= MinZeroRun) {
+					break;
+				}
+			}
+			i = zeros_end;
+
+			append(delta, static_cast<uint16_t>(literals_start - zeros_start));
+			append(delta, static_cast<uint16_t>(zeros_end - literals_start));
+			delta.insert(delta.end(), page + literals_start, page + zeros_end);
+		}
+		pos += page_size;
+	}
+	return delta;
+}
+
+static void apply_delta(const std::vector<uint8_t>& delta, uint8_t* region,
+                        const size_t region_size)
+{
+	auto read_u16 = [&](size_t& pos) {
+		uint16_t value = 0;
+		memcpy(&value, delta.data() + pos, sizeof(value));
+		pos += sizeof(value);
+		return value;
+	};
+
+	size_t pos = 0;
+	while (pos < delta.size()) {
+		uint32_t index = 0;
+		memcpy(&index, delta.data() + pos, sizeof(index));
+		pos += sizeof(index);
+
+		const auto offset    = index * DeltaPageSize;
+		const auto page_size = std::min(DeltaPageSize, region_size - offset);
+		const auto page      = region + offset;
+
+		size_t i = 0;
+		while (i < page_size) {
+			i += read_u16(pos);
+			const auto num_literals = read_u16(pos);
+			for (size_t n = 0; n < num_literals; ++n) {
+				page[i++] ^= delta[pos++];
+			}
+		}
+	}
+}
+
+void SAVESTATE_CaptureRewindPoint()
+{
+	if (rewind_state.max_snapshots == 0) {
+		return;
+	}
+	if (rewind_state.generation != registrations_generation) {
+		reset_rewind();
+	}
+
+	RewindSnapshot snapshot(registrations.size());
+
+	for (size_t i = 0; i < registrations.size(); ++i) {
+		const auto& registration = registrations[i];
+		auto& record             = snapshot[i];
+
+		if (registration.save) {
+			registration.save(record.component);
+			continue;
+		}
+
+		auto& previous = rewind_state.regions[i];
+		if (previous.empty()) {
+			previous.assign(registration.region_data,
+			                registration.region_data + registration.region_size);
+			continue;
+		}
+
+		// Finding the changed pages has to happen now, while the guest
+		// is stopped, but the encoding can run in the background
+		auto pages = take_changed_pages(previous.data(),
+		                                registration.region_data,
+		                                registration.region_size);
+
+		auto promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
+		record.undo_delta = promise->get_future().share();
+
+		WORKERS_Submit([promise,
+		                pages       = std::move(pages),
+		                region_size = registration.region_size]() {
+			promise->set_value(encode_changed_pages(pages, region_size));
+		});
+	}
+
+	rewind_state.snapshots.emplace_back(std::move(snapshot));
+
+	if (rewind_state.snapshots.size() > rewind_state.max_snapshots) {
+		rewind_state.snapshots.pop_front();
+
+		// Nothing left to go back to from the oldest one
+		for (auto& record : rewind_state.snapshots.front()) {
+			record.undo_delta = {};
+		}
+	}
+}
+
+bool SAVESTATE_Rewind()
+{
+	if (rewind_state.generation != registrations_generation) {
+		reset_rewind();
+	}
+	if (rewind_state.snapshots.empty()) {
+		return false;
+	}
+
+	const auto& snapshot = rewind_state.snapshots.back();
+
+	// as with loading, nothing gets applied unless all the components
+	// accept their state
+	for (size_t i = 0; i < registrations.size(); ++i) {
+		const auto& registration = registrations[i];
+		if (registration.check && !registration.check(snapshot[i].component)) {
+			LOG_WARNING("SAVESTATE: Can't rewind the '%s' state",
+			            registration.name.c_str());
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < registrations.size(); ++i) {
+		const auto& registration = registrations[i];
+		const auto& record       = snapshot[i];
+
+		if (registration.load) {
+			registration.load(record.component);
+			continue;
+		}
+
+		auto& previous = rewind_state.regions[i];
+		if (registration.restore) {
+			registration.restore(previous.data(), previous.size());
+		} else {
+			std::copy(previous.begin(), previous.end(), registration.region_data);
+		}
+
+		// Step the copy back to the snapshot before
+		if (record.undo_delta.valid()) {
+			apply_delta(record.undo_delta.get(), previous.data(), previous.size());
+		}
+	}
+
+	rewind_state.snapshots.pop_back();
+
+	// Without snapshots the next capture has to start from scratch
+	if (rewind_state.snapshots.empty()) {
+		reset_rewind();
+	}
+	return true;
+}
@@ -20,6 +20,7 @@
 #include "setup.h"
 
 #include <algorithm>
+#include <chrono>
 #include <climits>
 #include <cstdlib>
 #include <fstream>
@@ -810,12 +811,39 @@ void Property::SetEnabledOptions(const std::vector<std::string>& in)
 	enabled_options = in;
 }
 
+template <typename T>
+T* Section_prop::AddProperty(T* property)
+{
+	assert(property);
+	properties.push_back(property);
+
+	// Keep the first one of any duplicates, like the searches did
+	std::string name = property->propname;
+	lowcase(name);
+	properties_by_name.try_emplace(std::move(name), property);
+	return property;
+}
+
+Property* Section_prop::FindProperty(const std::string_view name) const
+{
+	std::string key(name);
+	lowcase(key);
+
+	const auto it = properties_by_name.find(key);
+	return it != properties_by_name.end() ? it->second : nullptr;
+}
+
+Property* Section_prop::FindPropertyExact(const std::string_view name) const
+{
+	const auto property = FindProperty(name);
+	return (property && property->propname == name) ? property : nullptr;
+}
+
 Prop_int* Section_prop::Add_int(const std::string& _propname,
                                 Property::Changeable::Value when, int _value)
 {
 	Prop_int* test = new Prop_int(_propname, when, _value);
-	properties.push_back(test);
-	return test;
+	return AddProperty(test);
 }
 
 Prop_string* Section_prop::Add_string(const std::string& _propname,
@@ -823,32 +851,28 @@ Prop_string* Section_prop::Add_string(const std::string& _propname,
                                       const char* _value)
 {
 	Prop_string* test = new Prop_string(_propname, when, _value);
-	properties.push_back(test);
-	return test;
+	return AddProperty(test);
 }
 
 Prop_path* Section_prop::Add_path(const std::string& _propname,
                                   Property::Changeable::Value when, const char* _value)
 {
 	Prop_path* test = new Prop_path(_propname, when, _value);
-	properties.push_back(test);
-	return test;
+	return AddProperty(test);
 }
 
 Prop_bool* Section_prop::Add_bool(const std::string& _propname,
                                   Property::Changeable::Value when, bool _value)
 {
 	Prop_bool* test = new Prop_bool(_propname, when, _value);
-	properties.push_back(test);
-	return test;
+	return AddProperty(test);
 }
 
 Prop_hex* Section_prop::Add_hex(const std::string& _propname,
                                 Property::Changeable::Value when, Hex _value)
 {
 	Prop_hex* test = new Prop_hex(_propname, when, _value);
-	properties.push_back(test);
-	return test;
+	return AddProperty(test);
 }
 
 PropMultiVal* Section_prop::AddMultiVal(const std::string& _propname,
@@ -856,8 +880,7 @@ PropMultiVal* Section_prop::AddMultiVal(const std::string& _propname,
                                         const std::string& sep)
 {
 	PropMultiVal* test = new PropMultiVal(_propname, when, sep);
-	properties.push_back(test);
-	return test;
+	return AddProperty(test);
 }
 
 PropMultiValRemain* Section_prop::AddMultiValRemain(const std::string& _propname,
@@ -865,145 +888,75 @@ PropMultiValRemain* Section_prop::AddMultiValRemain(const std::string& _propname
                                                     const std::string& sep)
 {
 	PropMultiValRemain* test = new PropMultiValRemain(_propname, when, sep);
-	properties.push_back(test);
-	return test;
+	return AddProperty(test);
 }
 
 int Section_prop::Get_int(const std::string& _propname) const
 {
-	for (const_it tel = properties.begin(); tel != properties.end(); ++tel) {
-		if ((*tel)->propname == _propname) {
-			return ((*tel)->GetValue());
-		}
-	}
-	return 0;
+	const auto property = FindPropertyExact(_propname);
+	return property ? static_cast<int>(property->GetValue()) : 0;
 }
 
 bool Section_prop::Get_bool(const std::string& _propname) const
 {
-	for (const_it tel = properties.begin(); tel != properties.end(); ++tel) {
-		if ((*tel)->propname == _propname) {
-			return ((*tel)->GetValue());
-		}
-	}
-	return false;
+	const auto property = FindPropertyExact(_propname);
+	return property ? static_cast<bool>(property->GetValue()) : false;
 }
 
 double Section_prop::Get_double(const std::string& _propname) const
 {
-	for (const_it tel = properties.begin(); tel != properties.end(); ++tel) {
-		if ((*tel)->propname == _propname) {
-			return ((*tel)->GetValue());
-		}
-	}
-	return 0.0;
+	const auto property = FindPropertyExact(_propname);
+	return property ? static_cast<double>(property->GetValue()) : 0.0;
 }
 
 Prop_path* Section_prop::Get_path(const std::string& _propname) const
 {
-	for (const_it tel = properties.begin(); tel != properties.end(); ++tel) {
-		if ((*tel)->propname == _propname) {
-			Prop_path* val = dynamic_cast<Prop_path*>((*tel));
-			if (val) {
-				return val;
-			} else {
-				return nullptr;
-			}
-		}
-	}
-	return nullptr;
+	return dynamic_cast<Prop_path*>(FindPropertyExact(_propname));
 }
 
 PropMultiVal* Section_prop::GetMultiVal(const std::string& _propname) const
 {
-	for (const_it tel = properties.begin(); tel != properties.end(); ++tel) {
-		if ((*tel)->propname == _propname) {
-			PropMultiVal* val = dynamic_cast<PropMultiVal*>((*tel));
-			if (val) {
-				return val;
-			} else {
-				return nullptr;
-			}
-		}
-	}
-	return nullptr;
+	return dynamic_cast<PropMultiVal*>(FindPropertyExact(_propname));
 }
 
 PropMultiValRemain* Section_prop::GetMultiValRemain(const std::string& _propname) const
 {
-	for (const_it tel = properties.begin(); tel != properties.end(); ++tel) {
-		if ((*tel)->propname == _propname) {
-			PropMultiValRemain* val = dynamic_cast<PropMultiValRemain*>(
-			        (*tel));
-			if (val) {
-				return val;
-			} else {
-				return nullptr;
-			}
-		}
-	}
-	return nullptr;
+	return dynamic_cast<PropMultiValRemain*>(FindPropertyExact(_propname));
 }
 
 Property* Section_prop::Get_prop(int index)
 {
-	for (it tel = properties.begin(); tel != properties.end(); ++tel) {
-		if (!index--) {
-			return (*tel);
-		}
+	if (index < 0 || static_cast<size_t>(index) >= properties.size()) {
+		return nullptr;
 	}
-	return nullptr;
+	return properties[static_cast<size_t>(index)];
 }
 
 Property* Section_prop::Get_prop(const std::string_view propname)
 {
-	for (Property* property : properties) {
-		if (property->propname == propname) {
-			return property;
-		}
-	}
-	return nullptr;
+	return FindPropertyExact(propname);
 }
 
 std::string Section_prop::Get_string(const std::string& _propname) const
 {
-	for (const_it tel = properties.begin(); tel != properties.end(); ++tel) {
-		if ((*tel)->propname == _propname) {
-			return ((*tel)->GetValue());
-		}
-	}
-	return "";
+	const auto property = FindPropertyExact(_propname);
+	return property ? static_cast<std::string>(property->GetValue()) : "";
 }
 
 Prop_bool* Section_prop::GetBoolProp(const std::string& propname) const
 {
-	for (const auto property : properties) {
-		if (property->propname == propname) {
-			return dynamic_cast<Prop_bool*>(property);
-		}
-	}
-	return nullptr;
+	return dynamic_cast<Prop_bool*>(FindPropertyExact(propname));
 }
 
-
 Prop_string* Section_prop::GetStringProp(const std::string& propname) const
 {
-	for (const auto property : properties) {
-		if (property->propname == propname) {
-			return dynamic_cast<Prop_string*>(property);
-		}
-	}
-	return nullptr;
+	return dynamic_cast<Prop_string*>(FindPropertyExact(propname));
 }
 
 Hex Section_prop::Get_hex(const std::string& _propname) const
 {
-	for (const_it tel = properties.begin(); tel != properties.end(); ++tel) {
-		if ((*tel)->propname == _propname) {
-			return ((*tel)->GetValue());
-		}
-	}
-	return 0;
+	const auto property = FindPropertyExact(_propname);
+	return property ? static_cast<Hex>(property->GetValue()) : Hex(0);
 }
 
 bool Section_prop::HandleInputline(const std::string& line)
@@ -1029,11 +982,7 @@ bool Section_prop::HandleInputline(const std::string& line)
 	trim(name);
 	trim(val);
 
-	for (auto& p : properties) {
-		if (strcasecmp(p->propname.c_str(), name.c_str()) != 0) {
-			continue;
-		}
-
+	if (const auto p = FindProperty(name); p) {
 		if (p->IsDeprecated()) {
 			LOG_WARNING("CONFIG: Deprecated option '%s'", name.c_str());
 			LOG_WARNING("CONFIG: %s", p->GetHelp().c_str());
@@ -1076,10 +1025,8 @@ void Section_prop::PrintData(FILE* outfile) const
 
 std::string Section_prop::GetPropValue(const std::string& _property) const
 {
-	for (const_it tel = properties.begin(); tel != properties.end(); ++tel) {
-		if (!strcasecmp((*tel)->propname.c_str(), _property.c_str())) {
-			return (*tel)->GetValue().ToString();
-		}
+	if (const auto property = FindProperty(_property); property) {
+		return property->GetValue().ToString();
 	}
 	return NO_SUCH_PROPERTY;
 }
@@ -1326,8 +1273,17 @@ Config::Config(Config&& source) noexcept
 
 void Config::Init() const
 {
+	const auto log_timings = arguments.trace_startup;
+	const auto start       = std::chrono::steady_clock::now();
+
 	for (const auto& sec : sectionlist) {
-		sec->ExecuteInit();
+		sec->ExecuteInit(true, log_timings);
+	}
+
+	if (log_timings) {
+		const std::chrono::duration<double, std::milli> elapsed =
+		        std::chrono::steady_clock::now() - start;
+		LOG_MSG("STARTUP: Initialised all sections in %.2f ms", elapsed.count());
 	}
 }
 
@@ -1343,7 +1299,7 @@ void Section::AddDestroyFunction(SectionFunction func, bool changeable_at_runtim
 	destroyfunctions.emplace_front(func, changeable_at_runtime);
 }
 
-void Section::ExecuteInit(const bool init_all)
+void Section::ExecuteInit(const bool init_all, const bool log_timings)
 {
 	for (size_t i = 0; i < init_functions.size(); ++i) {
 		// Can we skip calling this function?
@@ -1355,8 +1311,19 @@ void Section::ExecuteInit(const bool init_all)
 		const auto size_on_entry = init_functions.size();
 
 		assert(init_functions[i].function);
+		const auto start = std::chrono::steady_clock::now();
+
 		init_functions[i].function(this);
 
+		if (log_timings) {
+			const std::chrono::duration<double, std::milli> elapsed =
+			        std::chrono::steady_clock::now() - start;
+			LOG_MSG("STARTUP: Init function %zu of section [%s] took %.2f ms",
+			        i + 1,
+			        GetName(),
+			        elapsed.count());
+		}
+
 		const auto size_on_exit = init_functions.size();
 
 		if (size_on_exit > size_on_entry) {
@@ -1914,6 +1881,8 @@ void Config::ParseArguments()
 	arguments.exit        = cmdline->FindRemoveBoolArgument("exit");
 	arguments.securemode = cmdline->FindRemoveBoolArgument("securemode");
 	arguments.noautoexec = cmdline->FindRemoveBoolArgument("noautoexec");
+	arguments.headless   = cmdline->FindRemoveBoolArgument("headless");
+	arguments.trace_startup = cmdline->FindRemoveBoolArgument("trace-startup");
 
 	arguments.eraseconf = cmdline->FindRemoveBoolArgument("eraseconf") ||
 	                      cmdline->FindRemoveBoolArgument("resetconf");
@@ -1927,8 +1896,11 @@ void Config::ParseArguments()
 	arguments.working_dir = cmdline->FindRemoveStringArgument("working-dir");
 	arguments.lang = cmdline->FindRemoveStringArgument("lang");
 	arguments.machine = cmdline->FindRemoveStringArgument("machine");
+	arguments.record  = cmdline->FindRemoveStringArgument("record");
+	arguments.replay  = cmdline->FindRemoveStringArgument("replay");
 
 	arguments.socket = cmdline->FindRemoveIntArgument("socket");
+	arguments.time_limit = cmdline->FindRemoveIntArgument("time-limit");
 
 	arguments.conf = cmdline->FindRemoveVectorArgument("conf");
 	arguments.set  = cmdline->FindRemoveVectorArgument("set");
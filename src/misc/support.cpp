@@ -35,9 +35,17 @@
 #include <fstream>
 #include <iterator>
 #include <map>
+#include <optional>
 #include <random>
 #include <stdexcept>
 #include <string>
+#include <utility>
+
+#if defined(WIN32)
+#include <windows.h>
+#elif defined(HAVE_MMAP)
+#include <sys/mman.h>
+#endif
 
 #include "cross.h"
 #include "debug.h"
@@ -350,11 +358,20 @@ template <typename T>
 	                    std::uniform_int_distribution<T>,
 	                    std::uniform_real_distribution<T>>::type;
 
+static std::optional<uint32_t> randomizer_seed = {};
+
+void SetRandomizerSeed(const uint32_t seed)
+{
+	randomizer_seed = seed;
+}
+
 template <typename T>
 std::function<T()> CreateRandomizer(const T min_value, const T max_value)
 {
-	static std::random_device rd;        // one-time call to the host OS
-	static std::mt19937 generator(rd()); // seed the mersenne_twister once
+	// Seed the mersenne_twister once, with a call to the host OS unless a
+	// seed was set
+	static std::mt19937 generator(randomizer_seed ? *randomizer_seed
+	                                              : std::random_device{}());
 
 	return [=]() {
 		auto distribute = uniform_distributor_t<T>(min_value, max_value);
@@ -639,3 +656,104 @@ std::pair<std::unique_ptr<T[]>, T*> make_unique_aligned_array(
 // Explicit template instantiations
 template std::pair<std::unique_ptr<uint8_t[]>, uint8_t*>
 make_unique_aligned_array<uint8_t>(const size_t, const size_t, const uint8_t&);
+
+// Maps zeroed pages the host only commits when they're first written to
+static uint8_t* map_zeroed_pages([[maybe_unused]] void* address,
+                                 [[maybe_unused]] const size_t num_bytes)
+{
+#if defined(WIN32)
+	const auto ptr = VirtualAlloc(address,
+	                              num_bytes,
+	                              MEM_RESERVE | MEM_COMMIT,
+	                              PAGE_READWRITE);
+	return static_cast<uint8_t*>(ptr);
+#elif defined(HAVE_MMAP)
+	// Mapping over an existing range replaces its pages with fresh ones
+	const auto flags = MAP_PRIVATE | MAP_ANONYMOUS | (address ? MAP_FIXED : 0);
+	const auto ptr = mmap(address, num_bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+	return (ptr == MAP_FAILED) ? nullptr : static_cast<uint8_t*>(ptr);
+#else
+	return nullptr;
+#endif
+}
+
+static void unmap_pages([[maybe_unused]] uint8_t* address,
+                        [[maybe_unused]] const size_t num_bytes)
+{
+#if defined(WIN32)
+	VirtualFree(address, 0, MEM_RELEASE);
+#elif defined(HAVE_MMAP)
+	munmap(address, num_bytes);
+#endif
+}
+
+ZeroedBuffer::ZeroedBuffer(const size_t _num_bytes) : num_bytes(_num_bytes)
+{
+	assert(num_bytes > 0);
+
+	bytes     = map_zeroed_pages(nullptr, num_bytes);
+	is_mapped = (bytes != nullptr);
+	if (!is_mapped) {
+		bytes = static_cast<uint8_t*>(std::calloc(num_bytes, 1));
+		if (!bytes) {
+			throw std::bad_alloc();
+		}
+	}
+}
+
+ZeroedBuffer::ZeroedBuffer(ZeroedBuffer&& other) noexcept
+        : bytes(std::exchange(other.bytes, nullptr)),
+          num_bytes(std::exchange(other.num_bytes, 0)),
+          is_mapped(std::exchange(other.is_mapped, false))
+{}
+
+ZeroedBuffer& ZeroedBuffer::operator=(ZeroedBuffer&& other) noexcept
+{
+	if (this != &other) {
+		Free();
+		bytes     = std::exchange(other.bytes, nullptr);
+		num_bytes = std::exchange(other.num_bytes, 0);
+		is_mapped = std::exchange(other.is_mapped, false);
+	}
+	return *this;
+}
+
+ZeroedBuffer::~ZeroedBuffer()
+{
+	Free();
+}
+
+void ZeroedBuffer::Free()
+{
+	if (is_mapped) {
+		unmap_pages(bytes, num_bytes);
+	} else {
+		std::free(bytes);
+	}
+	bytes     = nullptr;
+	num_bytes = 0;
+	is_mapped = false;
+}
+
+void ZeroedBuffer::Clear()
+{
+	if (!bytes) {
+		return;
+	}
+#if defined(WIN32)
+	// Decommitting the range and committing it again gives back zeroed
+	// pages; the range stays reserved in between
+	if (is_mapped) {
+		VirtualFree(bytes, num_bytes, MEM_DECOMMIT);
+		if (!VirtualAlloc(bytes, num_bytes, MEM_COMMIT, PAGE_READWRITE)) {
+			E_Exit("SUPPORT: Failed to commit %zu bytes of memory", num_bytes);
+		}
+		return;
+	}
+#else
+	if (is_mapped && map_zeroed_pages(bytes, num_bytes)) {
+		return;
+	}
+#endif
+	std::memset(bytes, 0, num_bytes);
+}
@@ -985,17 +985,23 @@ static wide_string dos_to_wide(const std::string& str,
 	wide_string str_out = {};
 	str_out.reserve(str.size());
 
+	// Look up the code page mapping once, not for every character
+	static const map_dos_to_grapheme_t no_mapping = {};
+
+	const auto it = per_code_page_mappings.find(code_page);
+	const auto& mapping = (it != per_code_page_mappings.end())
+	                            ? it->second.grapheme_to_dos
+	                            : no_mapping;
+
 	for (const auto character : str) {
 		const auto byte = static_cast<uint8_t>(character);
 		if (byte >= DecodeThresholdNonAscii) {
 			// Take from code page mapping
-			auto& mappings = per_code_page_mappings[code_page];
-
-			if ((per_code_page_mappings.count(code_page) == 0) ||
-			    (mappings.grapheme_to_dos.count(byte) == 0)) {
+			const auto found_it = mapping.find(byte);
+			if (found_it == mapping.end()) {
 				str_out.push_back(UnknownCharacter);
 			} else {
-				mappings.grapheme_to_dos[byte].PushInto(str_out);
+				found_it->second.PushInto(str_out);
 			}
 		} else if (is_control_code(byte)) {
 			const auto wide = screen_code_to_wide(byte, convert_mode);
@@ -2108,6 +2114,16 @@ static uint16_t get_custom_code_page(const uint16_t in_code_page)
 // External interface
 // ***************************************************************************
 
+// Strings of printable 7-bit ASCII characters are the same in UTF-8 and in
+// every DOS code page, so they can skip the conversions altogether
+static bool is_printable_ascii(const std::string& str)
+{
+	return std::all_of(str.begin(), str.end(), [](const char character) {
+		const auto byte = static_cast<uint8_t>(character);
+		return byte < DecodeThresholdNonAscii && !is_control_code(byte);
+	});
+}
+
 uint16_t get_utf8_code_page()
 {
 	load_config_if_needed();
@@ -2132,6 +2148,10 @@ static std::string utf8_to_dos_common(const std::string& str,
                                       const UnicodeFallback fallback,
                                       const uint16_t code_page)
 {
+	if (is_printable_ascii(str)) {
+		return str;
+	}
+
 	load_config_if_needed();
 
 	const auto tmp = utf8_to_wide(str);
@@ -2163,6 +2183,10 @@ static std::string dos_to_utf8_common(const std::string& str,
                                       const DosStringConvertMode convert_mode,
                                       const uint16_t code_page)
 {
+	if (is_printable_ascii(str)) {
+		return str;
+	}
+
 	load_config_if_needed();
 
 	const auto tmp = dos_to_wide(str, convert_mode, code_page);
@@ -2189,7 +2213,7 @@ static std::string lowercase_dos_common(const std::string& str,
 
 	assert(per_code_page_mappings.count(code_page) > 0);
 	const auto& mapping = per_code_page_mappings[code_page].lowercase;
-	assert(mapping.size() == UINT8_MAX);
+	assert(mapping.size() == UINT8_MAX + 1);
 
 	std::string str_out = str;
 	for (auto& entry : str_out) {
@@ -2217,7 +2241,7 @@ static std::string uppercase_dos_common(const std::string& str,
 
 	assert(per_code_page_mappings.count(code_page) > 0);
 	const auto& mapping = per_code_page_mappings[code_page].uppercase;
-	assert(mapping.size() == UINT8_MAX);
+	assert(mapping.size() == UINT8_MAX + 1);
 
 	std::string str_out = str;
 	for (auto& entry : str_out) {
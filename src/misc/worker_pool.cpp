@@ -0,0 +1,325 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "host_threads.h"
+#include "logging.h"
+#include "setup.h"
+#include "string_utils.h"
+#include "support.h"
+
+using Task = std::function<void()>;
+
+constexpr auto MaxWorkerThreads = 64;
+
+struct Worker {
+	std::thread thread     = {};
+	std::mutex mutex       = {};
+	std::deque<Task> tasks = {};
+};
+
+static struct {
+	int num_threads = 0;
+
+	// Guards starting and stopping the threads
+	std::mutex lifecycle_mutex = {};
+
+	std::vector<std::unique_ptr<Worker>> workers = {};
+	std::atomic_bool is_running                  = false;
+	bool should_stop                             = false;
+
+	// Set once the pool's section is destroyed or the process exits; tasks
+	// submitted after that run on the submitting thread
+	std::atomic_bool is_shut_down = false;
+
+	// The idle workers sleep until there are tasks queued
+	std::mutex idle_mutex           = {};
+	std::condition_variable idle_cv = {};
+	std::atomic_int num_queued      = 0;
+	std::atomic<size_t> next_queue  = 0;
+} pool = {};
+
+// The index of the worker running on this thread, if any
+static thread_local std::optional<size_t> this_worker = {};
+
+static std::optional<Task> take_task(const size_t index)
+{
+	const auto num_workers = pool.workers.size();
+
+	// Our own tasks first, and then the others' oldest ones
+	for (size_t i = 0; i < num_workers; ++i) {
+		auto& worker = *pool.workers[(index + i) % num_workers];
+
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (worker.tasks.empty()) {
+			continue;
+		}
+		Task task = {};
+		if (i == 0) {
+			task = std::move(worker.tasks.front());
+			worker.tasks.pop_front();
+		} else {
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+		}
+		--pool.num_queued;
+		return task;
+	}
+	return {};
+}
+
+static void run_worker(const size_t index)
+{
+	this_worker = index;
+
+	while (true) {
+		if (auto task = take_task(index); task) {
+			(*task)();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(pool.idle_mutex);
+		pool.idle_cv.wait(lock, [] {
+			return pool.should_stop || pool.num_queued > 0;
+		});
+		if (pool.should_stop && pool.num_queued == 0) {
+			return;
+		}
+	}
+}
+
+static void shut_down_workers();
+
+// Returns false if the pool is shut down
+static bool start_workers()
+{
+	std::lock_guard<std::mutex> lock(pool.lifecycle_mutex);
+	if (pool.is_running) {
+		return true;
+	}
+	if (pool.is_shut_down) {
+		return false;
+	}
+
+	// The threads have to be joined before the pool gets destroyed with
+	// the other statics
+	static const bool is_exit_handler_registered = [] {
+		return std::atexit(shut_down_workers) == 0;
+	}();
+	(void)is_exit_handler_registered;
+
+	const auto num_threads = WORKERS_GetNumThreads();
+
+	pool.should_stop = false;
+	for (auto i = 0; i < num_threads; ++i) {
+		pool.workers.emplace_back(std::make_unique<Worker>());
+	}
+	// Start them once all the queues exist, as the workers steal from each
+	// other
+	for (size_t i = 0; i < pool.workers.size(); ++i) {
+		auto& thread = pool.workers[i]->thread;
+		thread       = std::thread(run_worker, i);
+		set_thread_name(thread, "dosbox:worker");
+		HOST_THREADS_Apply(thread, HostThreadGroup::Worker);
+	}
+	pool.is_running = true;
+
+	LOG_MSG("WORKERS: Started %d worker threads", num_threads);
+	return true;
+}
+
+static void stop_workers()
+{
+	std::lock_guard<std::mutex> lock(pool.lifecycle_mutex);
+	if (!pool.is_running) {
+		return;
+	}
+
+	// The workers finish the queued tasks before exiting
+	{
+		std::lock_guard<std::mutex> idle_lock(pool.idle_mutex);
+		pool.should_stop = true;
+	}
+	pool.idle_cv.notify_all();
+
+	for (auto& worker : pool.workers) {
+		worker->thread.join();
+	}
+	pool.workers.clear();
+	pool.is_running = false;
+}
+
+static void shut_down_workers()
+{
+	pool.is_shut_down = true;
+	stop_workers();
+}
+
+void WORKERS_SetNumThreads(const int num_threads)
+{
+	assert(num_threads >= 0);
+	stop_workers();
+	pool.num_threads = std::min(num_threads, MaxWorkerThreads);
+}
+
+int WORKERS_GetNumThreads()
+{
+	if (pool.num_threads > 0) {
+		return pool.num_threads;
+	}
+	return std::clamp(static_cast<int>(std::thread::hardware_concurrency()) - 1,
+	                  1,
+	                  MaxWorkerThreads);
+}
+
+void WORKERS_Submit(Task task)
+{
+	if (!pool.is_running && !start_workers()) {
+		task();
+		return;
+	}
+
+	// The workers queue their subtasks to themselves, the others are spread
+	// over all the queues
+	const auto num_workers = pool.workers.size();
+	const auto index       = this_worker ? *this_worker
+	                                     : pool.next_queue++ % num_workers;
+	{
+		auto& worker = *pool.workers[index];
+
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (this_worker) {
+			worker.tasks.push_front(std::move(task));
+		} else {
+			worker.tasks.push_back(std::move(task));
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(pool.idle_mutex);
+		++pool.num_queued;
+	}
+	pool.idle_cv.notify_one();
+}
+
+// Parallel loops
+// ~~~~~~~~~~~~~~
+// The loop's state is shared with the helper tasks, as a helper can start
+// after the loop has finished when the workers are busy; it then finds no
+// items left and only drops its reference.
+
+struct ParallelLoop {
+	const std::function<void(int, int)>* func = nullptr;
+	int num_items                             = 0;
+
+	std::atomic_int next_item = 0;
+	std::atomic_int num_done  = 0;
+
+	std::mutex mutex           = {};
+	std::condition_variable cv = {};
+};
+
+static void run_loop_items(ParallelLoop& loop, const int participant)
+{
+	auto num_done = 0;
+	for (auto i = loop.next_item++; i < loop.num_items; i = loop.next_item++) {
+		(*loop.func)(i, participant);
+		++num_done;
+	}
+	if (num_done == 0) {
+		return;
+	}
+	if (loop.num_done.fetch_add(num_done) + num_done == loop.num_items) {
+		std::lock_guard<std::mutex> lock(loop.mutex);
+		loop.cv.notify_all();
+	}
+}
+
+void WORKERS_ParallelFor(const int num_items, const int max_helpers,
+                         const std::function<void(int index, int participant)>& func)
+{
+	const auto num_helpers = pool.is_shut_down
+	                               ? 0
+	                               : std::min({max_helpers,
+	                                           num_items - 1,
+	                                           WORKERS_GetNumThreads()});
+	if (num_helpers <= 0) {
+		for (auto i = 0; i < num_items; ++i) {
+			func(i, 0);
+		}
+		return;
+	}
+
+	auto loop       = std::make_shared<ParallelLoop>();
+	loop->func      = &func;
+	loop->num_items = num_items;
+
+	for (auto participant = 1; participant <= num_helpers; ++participant) {
+		WORKERS_Submit([loop, participant] {
+			run_loop_items(*loop, participant);
+		});
+	}
+	run_loop_items(*loop, 0);
+
+	std::unique_lock<std::mutex> lock(loop->mutex);
+	loop->cv.wait(lock, [&loop] { return loop->num_done == loop->num_items; });
+}
+
+// Lifecycle
+// ~~~~~~~~~
+
+static void workers_destroy(Section*)
+{
+	shut_down_workers();
+}
+
+void WORKERS_Init(Section* sec)
+{
+	assert(sec);
+	const auto secprop = static_cast<Section_prop*>(sec);
+
+	const std::string pref = secprop->Get_string("worker_threads");
+
+	auto num_threads = 0;
+	if (pref != "auto") {
+		const auto parsed = parse_int(pref);
+		if (parsed && *parsed >= 1 && *parsed <= MaxWorkerThreads) {
+			num_threads = *parsed;
+		} else {
+			LOG_WARNING("WORKERS: Invalid 'worker_threads' setting: '%s', using 'auto'",
+			            pref.c_str());
+		}
+	}
+	WORKERS_SetNumThreads(num_threads);
+	pool.is_shut_down = false;
+
+	sec->AddDestroyFunction(&workers_destroy);
+}
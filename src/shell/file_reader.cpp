@@ -20,6 +20,21 @@
 
 #include "file_reader.h"
 
+#include <algorithm>
+
+#include "control.h"
+
+// Larger batch files are read line by line, even in the cached mode
+constexpr uint32_t MaxCachedSize = 1024 * 1024;
+
+static bool is_batch_file_cache_enabled()
+{
+	const auto section = control ? static_cast<Section_prop*>(
+	                                       control->GetSection("dos"))
+	                             : nullptr;
+	return section && section->Get_bool("batch_file_cache");
+}
+
 std::unique_ptr<FileReader> FileReader::GetFileReader(const std::string& filename)
 {
 	auto fullname = DOS_Canonicalize(filename.c_str());
@@ -29,12 +44,14 @@ std::unique_ptr<FileReader> FileReader::GetFileReader(const std::string& filenam
 		return {};
 	}
 	DOS_CloseFile(handle);
-	return std::unique_ptr<FileReader>(new FileReader(std::move(fullname)));
+	return std::unique_ptr<FileReader>(
+	        new FileReader(std::move(fullname), is_batch_file_cache_enabled()));
 }
 
-FileReader::FileReader(std::string filename)
+FileReader::FileReader(std::string filename, const bool use_cache)
         : filename(std::move(filename)),
-          cursor(0)
+          cursor(0),
+          use_cache(use_cache)
 {}
 
 std::optional<std::string> FileReader::Read()
@@ -43,6 +60,14 @@ std::optional<std::string> FileReader::Read()
 	if (!DOS_OpenFile(filename.c_str(), (DOS_NOT_INHERIT | OPEN_READ), &entry)) {
 		return {};
 	}
+	auto line = (use_cache && RefreshCache(entry)) ? ReadFromCache()
+	                                               : ReadFromFile(entry);
+	DOS_CloseFile(entry);
+	return line;
+}
+
+std::optional<std::string> FileReader::ReadFromFile(const uint16_t entry)
+{
 	DOS_SeekFile(entry, &cursor, DOS_SEEK_SET);
 
 	uint8_t data           = 0;
@@ -59,7 +84,6 @@ std::optional<std::string> FileReader::Read()
 
 	cursor = 0;
 	DOS_SeekFile(entry, &cursor, DOS_SEEK_CUR);
-	DOS_CloseFile(entry);
 
 	if (line.empty()) {
 		return {};
@@ -68,6 +92,68 @@ std::optional<std::string> FileReader::Read()
 	return line;
 }
 
+// Reads the file again if its size or timestamp has changed since it was
+// cached. Returns false if it can't be cached.
+bool FileReader::RefreshCache(const uint16_t entry)
+{
+	uint32_t size = 0;
+	uint16_t time = 0;
+	uint16_t date = 0;
+	if (!DOS_SeekFile(entry, &size, DOS_SEEK_END) ||
+	    !DOS_GetFileDate(entry, &time, &date) || size > MaxCachedSize) {
+		cache.reset();
+		return false;
+	}
+	if (cache && cache->data.size() == size && cache->date == date &&
+	    cache->time == time) {
+		return true;
+	}
+
+	CachedContents contents = {};
+	contents.data.resize(size);
+	contents.date = date;
+	contents.time = time;
+
+	uint32_t position = 0;
+	DOS_SeekFile(entry, &position, DOS_SEEK_SET);
+	while (position < size) {
+		auto bytes_to_read = static_cast<uint16_t>(
+		        std::min<uint32_t>(size - position, UINT16_MAX));
+		auto data = reinterpret_cast<uint8_t*>(contents.data.data() + position);
+		if (!DOS_ReadFile(entry, data, &bytes_to_read) || bytes_to_read == 0) {
+			cache.reset();
+			return false;
+		}
+		position += bytes_to_read;
+	}
+
+	for (uint32_t i = 0; i < size; ++i) {
+		if (contents.data[i] == '\n') {
+			contents.line_starts.push_back(i + 1);
+		}
+	}
+	cache = std::move(contents);
+	return true;
+}
+
+std::optional<std::string> FileReader::ReadFromCache()
+{
+	const auto size = static_cast<uint32_t>(cache->data.size());
+	if (cursor >= size) {
+		return {};
+	}
+
+	// Like the uncached reads, a line runs up to and including its newline
+	const auto next_line = std::upper_bound(cache->line_starts.begin(),
+	                                        cache->line_starts.end(),
+	                                        cursor);
+	const auto end = (next_line == cache->line_starts.end()) ? size : *next_line;
+
+	std::string line = cache->data.substr(cursor, end - cursor);
+	cursor           = end;
+	return line;
+}
+
 void FileReader::Reset()
 {
 	cursor = 0;
@@ -23,9 +23,14 @@
 
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "shell.h"
 
+// Reads a batch file's lines, reopening the file for every line as DOS
+// allows batch files to change while they run. In the cached mode, the
+// contents are kept in memory and only read again when the file's size or
+// timestamp changes.
 class FileReader final : public LineReader {
 public:
 	static std::unique_ptr<FileReader> GetFileReader(const std::string& file);
@@ -40,10 +45,24 @@ public:
 	~FileReader() final                      = default;
 
 private:
-	explicit FileReader(std::string filename);
+	explicit FileReader(std::string filename, bool use_cache);
+
+	std::optional<std::string> ReadFromFile(uint16_t handle);
+	std::optional<std::string> ReadFromCache();
+	bool RefreshCache(uint16_t handle);
 
 	std::string filename;
 	uint32_t cursor;
+
+	struct CachedContents {
+		std::string data = {};
+		// The offsets the lines after the first start at
+		std::vector<uint32_t> line_starts = {};
+		uint16_t date = 0;
+		uint16_t time = 0;
+	};
+	bool use_cache = false;
+	std::optional<CachedContents> cache = {};
 };
 
 #endif
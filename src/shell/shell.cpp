@@ -34,6 +34,7 @@
 #include "fs_utils.h"
 #include "mapper.h"
 #include "regs.h"
+#include "replay.h"
 #include "string_utils.h"
 #include "support.h"
 #include "timer.h"
@@ -200,7 +201,7 @@ static uint16_t get_output_redirection(const char *out_file,
 
 uint16_t get_tick_random_number() {
 	constexpr uint16_t random_uplimit = 10000;
-	return (uint16_t)(GetTicks() % random_uplimit);
+	return (uint16_t)(REPLAY_GetWallClockMs() % random_uplimit);
 }
 
 // Yo dawg MSVC-Clang likes to complain about pragmas
@@ -46,6 +46,7 @@
 #include "drives.h"
 #include "paging.h"
 #include "regs.h"
+#include "replay.h"
 #include "string_utils.h"
 #include "support.h"
 #include "timer.h"
@@ -883,38 +884,28 @@ void DOS_Shell::CMD_DIR(char* args)
 
 	const bool is_root = strnlen(path, sizeof(path)) == 3;
 
-	/* Command uses dta so set it to our internal dta */
-	const RealPt save_dta = dos.dta();
-	dos.dta(dos.tables.tempdta);
-	DOS_DTA dta(dos.dta());
+	std::vector<DOS_DTA::Result> dir_contents;
 
-	bool ret = DOS_FindFirst(pattern.c_str(), FatAttributeFlags::NotVolume);
-	if (!ret) {
+	if (!DOS_FindAll(pattern.c_str(), FatAttributeFlags::NotVolume, dir_contents)) {
 		if (!has_option_bare)
 			output.AddString(MSG_Get("SHELL_FILE_NOT_FOUND"),
 			                 pattern.c_str());
-		dos.dta(save_dta);
 		output.Display();
 		return;
 	}
 
-	std::vector<DOS_DTA::Result> dir_contents;
-
-	do { // File name and extension
-		DOS_DTA::Result result = {};
-		dta.GetResult(result);
-
-		// Skip non-directories if option AD is present,
-		// or skip dirs in case of A-D
-		if (has_option_all_dirs && !result.IsDirectory()) {
-			continue;
-		} else if (has_option_all_files && result.IsDirectory()) {
-			continue;
-		}
-
-		dir_contents.emplace_back(result);
-
-	} while (DOS_FindNext());
+	// Skip non-directories if option AD is present,
+	// or skip dirs in case of A-D
+	if (has_option_all_dirs || has_option_all_files) {
+		const auto is_skipped = [&](const DOS_DTA::Result& result) {
+			return has_option_all_dirs ? !result.IsDirectory()
+			                           : result.IsDirectory();
+		};
+		dir_contents.erase(std::remove_if(dir_contents.begin(),
+		                                  dir_contents.end(),
+		                                  is_skipped),
+		                   dir_contents.end());
+	}
 
 	DOS_Sort(dir_contents, option_sorting, option_reverse);
 
@@ -998,9 +989,9 @@ void DOS_Shell::CMD_DIR(char* args)
 		                 file_count,
 		                 format_number(byte_count).c_str());
 
-		uint8_t drive = dta.GetSearchDrive();
+		const auto drive = drive_idx;
 		size_t free_space = 1024 * 1024 * 100;
-		if (Drives.at(drive)) {
+		if (drive < DOS_DRIVES && Drives.at(drive)) {
 			uint16_t bytes_sector;
 			uint8_t  sectors_cluster;
 			uint16_t total_clusters;
@@ -1018,7 +1009,6 @@ void DOS_Shell::CMD_DIR(char* args)
 		                 dir_count,
 		                 format_number(free_space).c_str());
 	}
-	dos.dta(save_dta);
 	output.Display();
 }
 
@@ -1723,7 +1713,7 @@ void DOS_Shell::CMD_DATE(char *args)
 	}
 	if (ScanCMDBool(args, "H")) {
 		// synchronize date with host
-		const time_t curtime = time(nullptr);
+		const auto curtime = static_cast<time_t>(REPLAY_GetWallClockMs() / 1000);
 		struct tm datetime;
 		cross::localtime_r(&curtime, &datetime);
 		reg_ah = 0x2b; // set system date
@@ -1808,7 +1798,7 @@ void DOS_Shell::CMD_TIME(char * args) {
 	}
 	if (ScanCMDBool(args, "H")) {
 		// synchronize time with host
-		const time_t curtime = time(nullptr);
+		const auto curtime = static_cast<time_t>(REPLAY_GetWallClockMs() / 1000);
 		struct tm datetime;
 		cross::localtime_r(&curtime, &datetime);
 		reg_ah = 0x2d; // set system time
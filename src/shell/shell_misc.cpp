@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <cstring>
 #include <memory>
+#include <unordered_map>
 
 #include "../ints/int10.h"
 #include "callback.h"
@@ -495,13 +496,26 @@ bool DOS_Shell::ExecuteProgram(std::string_view name, std::string_view args)
 	return false;
 }
 
-std::string DOS_Shell::Which(const std::string_view name) const
+// The resolved commands, valid for one PATH and as long as the files don't
+// change. Hits are still checked to exist as that also catches the changes
+// on the host that the drive caches are told about.
+struct WhichCache {
+	std::string path          = {};
+	uint32_t files_generation = 0;
+
+	std::unordered_map<std::string, std::string> files = {};
+};
+
+static WhichCache which_cache = {};
+
+static std::string find_command(const std::string_view name,
+                                const std::optional<std::string>& path)
 {
 	static constexpr auto extensions = {"", ".COM", ".EXE", ".BAT"};
 
 	std::vector<std::string> prefixes = {""};
 
-	if (const auto path = psp->GetEnvironmentValue("PATH")) {
+	if (path) {
 		auto path_directories = split_with_empties(*path, ';');
 
 		remove_empties(path_directories);
@@ -529,6 +543,36 @@ std::string DOS_Shell::Which(const std::string_view name) const
 	return "";
 }
 
+std::string DOS_Shell::Which(const std::string_view name) const
+{
+	const auto path = psp->GetEnvironmentValue("PATH");
+
+	auto key = std::string(name);
+	upcase(key);
+
+	// Probe the cached file first, it might bring the generation forward
+	const auto it = which_cache.files.find(key);
+	const auto is_hit = it != which_cache.files.end() &&
+	                    DOS_FileExists(it->second.c_str());
+
+	if (which_cache.files_generation != DOS_GetFilesGeneration() ||
+	    which_cache.path != path.value_or("")) {
+		which_cache.files.clear();
+		which_cache.files_generation = DOS_GetFilesGeneration();
+		which_cache.path             = path.value_or("");
+	} else if (is_hit) {
+		return it->second;
+	}
+
+	auto file = find_command(name, path);
+	if (file.empty()) {
+		which_cache.files.erase(key);
+	} else {
+		which_cache.files[key] = file;
+	}
+	return file;
+}
+
 std::string full_arguments = "";
 // TODO De-mystify magic numbers and verify logical correctness
 static void run_binary_executable(const std::string_view fullname,
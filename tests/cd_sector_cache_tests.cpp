@@ -0,0 +1,103 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/dos/cd_sector_cache.cpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// The caching itself is covered by the sector cache tests
+
+TEST(CdSectorCache, DisabledDoesntReadAhead)
+{
+	CdSectorCache cache(0);
+	EXPECT_FALSE(cache.IsEnabled());
+
+	cache.NoteRequest(1);
+	cache.NoteRequest(2);
+	EXPECT_EQ(cache.GetReadAheadOnMiss(), 0);
+}
+
+TEST(CdSectorCache, ReadAheadGrowsOnSequentialMisses)
+{
+	CdSectorCache cache(1024);
+
+	cache.NoteRequest(100);
+	EXPECT_EQ(cache.GetReadAheadOnMiss(), 0);
+
+	cache.NoteRequest(101);
+	EXPECT_EQ(cache.GetReadAheadOnMiss(), CdSectorCache::MinReadAhead);
+
+	// Hits keep the run going
+	for (uint32_t sector = 102; sector < 106; ++sector) {
+		cache.NoteRequest(sector);
+	}
+	cache.NoteRequest(106);
+	EXPECT_EQ(cache.GetReadAheadOnMiss(), CdSectorCache::MinReadAhead * 2);
+
+	for (auto i = 0; i < 10; ++i) {
+		cache.NoteRequest(107 + i);
+		EXPECT_LE(cache.GetReadAheadOnMiss(), CdSectorCache::MaxReadAhead);
+	}
+	cache.NoteRequest(117);
+	EXPECT_EQ(cache.GetReadAheadOnMiss(), CdSectorCache::MaxReadAhead);
+}
+
+TEST(CdSectorCache, ReadAheadStopsOnSeek)
+{
+	CdSectorCache cache(1024);
+
+	cache.NoteRequest(10);
+	cache.NoteRequest(11);
+	EXPECT_GT(cache.GetReadAheadOnMiss(), 0);
+
+	cache.NoteRequest(500);
+	EXPECT_EQ(cache.GetReadAheadOnMiss(), 0);
+
+	// A new run starts from the smallest window
+	cache.NoteRequest(501);
+	EXPECT_EQ(cache.GetReadAheadOnMiss(), CdSectorCache::MinReadAhead);
+}
+
+TEST(CdSectorCache, ReadAheadFitsSmallCaches)
+{
+	CdSectorCache cache(6);
+
+	for (uint32_t sector = 0; sector < 10; ++sector) {
+		cache.NoteRequest(sector);
+		EXPECT_LE(cache.GetReadAheadOnMiss(), 3);
+	}
+}
+
+TEST(CdSectorCache, ClearForgetsTheRequests)
+{
+	CdSectorCache cache(1024);
+
+	cache.NoteRequest(10);
+	cache.NoteRequest(11);
+	EXPECT_GT(cache.GetReadAheadOnMiss(), 0);
+
+	cache.Clear();
+	cache.NoteRequest(12);
+	EXPECT_EQ(cache.GetReadAheadOnMiss(), 0);
+}
+
+} // namespace
@@ -0,0 +1,304 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/dos/chd_image.cpp"
+
+#include <array>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#if defined(C_SYSTEM_ZLIB_NG)
+#define deflateInit2 zng_deflateInit2
+#define deflateBound zng_deflateBound
+#define deflate zng_deflate
+#define deflateEnd zng_deflateEnd
+#endif
+
+namespace {
+
+constexpr uint32_t HunkFrames = 2;
+constexpr uint32_t HunkBytes  = HunkFrames * ChdImage::FrameSize;
+constexpr uint32_t NumFrames  = 6;
+
+constexpr uint64_t MapOffset  = 124;
+constexpr uint64_t MetaOffset = 512;
+constexpr uint64_t HunkOffset = 1024;
+
+class BitWriter {
+public:
+	void Write(const uint64_t value, const int num_bits)
+	{
+		for (int i = num_bits - 1; i >= 0; --i, ++position) {
+			if (position % 8 == 0) {
+				bytes.push_back(0);
+			}
+			bytes.back() |= static_cast<uint8_t>(((value >> i) & 1)
+			                                     << (7 - position % 8));
+		}
+	}
+
+	std::vector<uint8_t> bytes = {};
+
+private:
+	size_t position = 0;
+};
+
+void put_be(std::vector<uint8_t>& out, const size_t offset,
+            const uint64_t value, const int num_bytes)
+{
+	for (int i = 0; i < num_bytes; ++i) {
+		out[offset + i] = static_cast<uint8_t>(value >> ((num_bytes - 1 - i) * 8));
+	}
+}
+
+std::vector<uint8_t> deflate_raw(const uint8_t* data, const size_t num_bytes)
+{
+	z_stream stream = {};
+	deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+	             Z_DEFAULT_STRATEGY);
+	std::vector<uint8_t> out(deflateBound(&stream, num_bytes));
+	stream.next_in   = const_cast<uint8_t*>(data);
+	stream.avail_in  = static_cast<decltype(stream.avail_in)>(num_bytes);
+	stream.next_out  = out.data();
+	stream.avail_out = static_cast<decltype(stream.avail_out)>(out.size());
+	deflate(&stream, Z_FINISH);
+	out.resize(stream.total_out);
+	deflateEnd(&stream);
+	return out;
+}
+
+// The frames as stored: the first has its sync pattern dropped, as if it's
+// to be regenerated, and so does its decompressed copy at frame 4
+std::vector<uint8_t> make_frame(const uint32_t frame)
+{
+	std::vector<uint8_t> data(ChdImage::FrameSize);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = static_cast<uint8_t>(frame * 7 + i);
+	}
+	if (frame % 4 == 0) {
+		std::fill_n(data.begin(), 12, 0);
+		// A Mode 1 header
+		data[15] = 1;
+	}
+	return data;
+}
+
+// A 'cdzl' hunk of frames 0 and 1, an uncompressed hunk of frames 2 and 3,
+// and a hunk duplicating the first one
+std::vector<uint8_t> make_chd(const uint32_t codec = make_fourcc("cdzl"))
+{
+	std::vector<uint8_t> hunk0 = {};
+	std::vector<uint8_t> hunk1 = {};
+	for (uint32_t frame = 0; frame < HunkFrames; ++frame) {
+		const auto data = make_frame(frame);
+		hunk0.insert(hunk0.end(), data.begin(), data.end());
+		const auto data1 = make_frame(frame + 2);
+		hunk1.insert(hunk1.end(), data1.begin(), data1.end());
+	}
+
+	std::vector<uint8_t> sectors = {};
+	std::vector<uint8_t> subcode = {};
+	for (uint32_t frame = 0; frame < HunkFrames; ++frame) {
+		const auto start = hunk0.begin() + frame * ChdImage::FrameSize;
+		sectors.insert(sectors.end(), start, start + ChdImage::SectorDataSize);
+		subcode.insert(subcode.end(),
+		               start + ChdImage::SectorDataSize,
+		               start + ChdImage::FrameSize);
+	}
+	const auto base      = deflate_raw(sectors.data(), sectors.size());
+	const auto sub       = deflate_raw(subcode.data(), subcode.size());
+	std::vector<uint8_t> compressed = {0x01, 0, 0};
+	put_be(compressed, 1, base.size(), 2);
+	compressed.insert(compressed.end(), base.begin(), base.end());
+	compressed.insert(compressed.end(), sub.begin(), sub.end());
+
+	// The decompressed first hunk has its sync pattern restored
+	auto restored = hunk0;
+	restore_sync_and_ecc(restored.data());
+	const auto crc0 = crc16(restored.data(), restored.size());
+	const auto crc1 = crc16(hunk1.data(), hunk1.size());
+
+	// The map, with all the compression types coded with 4 bits
+	BitWriter map = {};
+	for (int i = 0; i < NumCompressionTypes; ++i) {
+		map.Write(4, 4);
+	}
+	map.Write(Codec0, 4);
+	map.Write(None, 4);
+	map.Write(Self, 4);
+	map.Write(compressed.size(), 24);
+	map.Write(crc0, 16);
+	map.Write(crc1, 16);
+	map.Write(0, 8);
+
+	std::vector<uint8_t> raw_map(3 * 12);
+	raw_map[0] = Codec0;
+	put_be(raw_map, 1, compressed.size(), 3);
+	put_be(raw_map, 4, HunkOffset, 6);
+	put_be(raw_map, 10, crc0, 2);
+	raw_map[12] = None;
+	put_be(raw_map, 13, HunkBytes, 3);
+	put_be(raw_map, 16, HunkOffset + compressed.size(), 6);
+	put_be(raw_map, 22, crc1, 2);
+	raw_map[24] = Self;
+
+	std::vector<uint8_t> chd(HunkOffset);
+	std::memcpy(chd.data(), "MComprHD", 8);
+	put_be(chd, 8, HeaderSize, 4);
+	put_be(chd, 12, Version, 4);
+	put_be(chd, 16, codec, 4);
+	put_be(chd, 32, NumFrames * ChdImage::FrameSize, 8);
+	put_be(chd, 40, MapOffset, 8);
+	put_be(chd, 48, MetaOffset, 8);
+	put_be(chd, 56, HunkBytes, 4);
+	put_be(chd, 60, ChdImage::FrameSize, 4);
+
+	put_be(chd, MapOffset, map.bytes.size(), 4);
+	put_be(chd, MapOffset + 4, HunkOffset, 6);
+	put_be(chd, MapOffset + 10, crc16(raw_map.data(), raw_map.size()), 2);
+	chd[MapOffset + 12] = 24;
+	chd[MapOffset + 14] = 8;
+	chd[MapOffset + 13] = 8;
+	std::copy(map.bytes.begin(), map.bytes.end(), chd.begin() + MapOffset + 16);
+
+	// The tracks, listed out of order
+	const std::array<std::string, 2> tracks = {
+	        "TRACK:2 TYPE:AUDIO SUBTYPE:NONE FRAMES:2 PREGAP:0 PGTYPE:AUDIO PGSUB:NONE POSTGAP:0",
+	        "TRACK:1 TYPE:MODE1_RAW SUBTYPE:NONE FRAMES:3 PREGAP:0 PGTYPE:VMODE1_RAW PGSUB:NONE POSTGAP:0"};
+	auto offset = MetaOffset;
+	for (size_t i = 0; i < tracks.size(); ++i) {
+		const auto next = i + 1 < tracks.size()
+		                        ? offset + 16 + tracks[i].size() + 1
+		                        : 0;
+		put_be(chd, offset, make_fourcc("CHT2"), 4);
+		put_be(chd, offset + 4, tracks[i].size() + 1, 4);
+		put_be(chd, offset + 8, next, 8);
+		std::copy(tracks[i].begin(), tracks[i].end(), chd.begin() + offset + 16);
+		offset = next;
+	}
+
+	chd.insert(chd.end(), compressed.begin(), compressed.end());
+	chd.insert(chd.end(), hunk1.begin(), hunk1.end());
+	return chd;
+}
+
+std::unique_ptr<ChdImage> open_chd(const std::vector<uint8_t>& chd, std::string& error)
+{
+	FILE* file = tmpfile();
+	fwrite(chd.data(), 1, chd.size(), file);
+	return ChdImage::Open(file, error);
+}
+
+TEST(ChdImage, ListsTracks)
+{
+	std::string error = {};
+	const auto image  = open_chd(make_chd(), error);
+	ASSERT_TRUE(image) << error;
+	EXPECT_EQ(image->GetNumFrames(), NumFrames);
+
+	const auto& tracks = image->GetTracks();
+	ASSERT_EQ(tracks.size(), 2);
+	EXPECT_EQ(tracks[0].number, 1);
+	EXPECT_EQ(tracks[0].type, "MODE1_RAW");
+	EXPECT_EQ(tracks[0].frames, 3);
+	EXPECT_EQ(tracks[0].first_frame, 0);
+	EXPECT_TRUE(tracks[0].has_pregap_data);
+
+	// After the padding of the first track
+	EXPECT_EQ(tracks[1].number, 2);
+	EXPECT_EQ(tracks[1].type, "AUDIO");
+	EXPECT_EQ(tracks[1].first_frame, 4);
+	EXPECT_FALSE(tracks[1].has_pregap_data);
+}
+
+TEST(ChdImage, ReadsFrames)
+{
+	std::string error = {};
+	const auto image  = open_chd(make_chd(), error);
+	ASSERT_TRUE(image) << error;
+
+	// Read backwards, so the hunks come from the prefetch and the cache
+	for (uint32_t frame = NumFrames; frame-- > 0;) {
+		auto expected = make_frame(frame % 4);
+		if (frame % 4 == 0) {
+			restore_sync_and_ecc(expected.data());
+		}
+		std::vector<uint8_t> data(ChdImage::FrameSize);
+		ASSERT_TRUE(image->ReadFrame(frame, 0, data.data(), data.size()));
+		EXPECT_EQ(data, expected) << "frame " << frame;
+	}
+}
+
+TEST(ChdImage, RestoresSyncPattern)
+{
+	std::string error = {};
+	const auto image  = open_chd(make_chd(), error);
+	ASSERT_TRUE(image) << error;
+
+	std::array<uint8_t, sizeof(SyncPattern)> sync = {};
+	ASSERT_TRUE(image->ReadFrame(4, 0, sync.data(), sync.size()));
+	EXPECT_EQ(0, std::memcmp(sync.data(), SyncPattern, sizeof(SyncPattern)));
+
+	// Only the flagged frames
+	ASSERT_TRUE(image->ReadFrame(1, 0, sync.data(), sync.size()));
+	EXPECT_EQ(sync[0], make_frame(1)[0]);
+}
+
+TEST(ChdImage, ReadsPartialFrames)
+{
+	std::string error = {};
+	const auto image  = open_chd(make_chd(), error);
+	ASSERT_TRUE(image) << error;
+
+	const auto expected = make_frame(3);
+	std::vector<uint8_t> data(2048);
+	ASSERT_TRUE(image->ReadFrame(3, 16, data.data(), data.size()));
+	EXPECT_TRUE(std::equal(data.begin(), data.end(), expected.begin() + 16));
+
+	EXPECT_FALSE(image->ReadFrame(3, 2048, data.data(), data.size()));
+	EXPECT_FALSE(image->ReadFrame(NumFrames, 0, data.data(), 16));
+}
+
+TEST(ChdImage, RefusesUnsupportedCodecs)
+{
+	std::string error = {};
+	EXPECT_FALSE(open_chd(make_chd(make_fourcc("cdlz")), error));
+	EXPECT_FALSE(error.empty());
+}
+
+TEST(ChdImage, RefusesDamagedMaps)
+{
+	auto chd = make_chd();
+	chd[MapOffset + 10] ^= 0xff;
+
+	std::string error = {};
+	EXPECT_FALSE(open_chd(chd, error));
+	EXPECT_FALSE(error.empty());
+}
+
+TEST(ChdImage, IgnoresOtherFiles)
+{
+	std::string error = {};
+	EXPECT_FALSE(open_chd(std::vector<uint8_t>(4096, 0x20), error));
+	EXPECT_TRUE(error.empty());
+}
+
+} // namespace
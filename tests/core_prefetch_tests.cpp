@@ -0,0 +1,121 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "cpu.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "callback.h"
+#include "mem.h"
+#include "regs.h"
+
+#include "dosbox_test_fixture.h"
+
+namespace {
+
+constexpr uint16_t CodeSeg = 0x2000;
+
+Bitu stop_handler()
+{
+	return CBRET_STOP;
+}
+
+class CorePrefetchTest : public DOSBoxTestFixture {
+public:
+	CorePrefetchTest()
+	{
+		setting_overrides = {{"cpu", "core=normal"},
+		                     {"cpu", "cputype=386_prefetch"},
+		                     {"cpu", "cycles=fixed 1000"}};
+	}
+
+	void SetUp() override
+	{
+		DOSBoxTestFixture::SetUp();
+		stop_callback.Allocate(&stop_handler, "prefetch test stop");
+	}
+
+	void TearDown() override
+	{
+		stop_callback.Uninstall();
+		DOSBoxTestFixture::TearDown();
+	}
+
+protected:
+	// Runs the code at CodeSeg:0, with ES pointing at it too, until it
+	// reaches the stop callback written after it
+	void Run(const std::vector<uint8_t>& code)
+	{
+		const auto cb_number = stop_callback.Get_callback();
+
+		PhysPt pt = PhysicalMake(CodeSeg, 0);
+		for (const auto byte : code) {
+			mem_writeb(pt++, byte);
+		}
+		mem_writeb(pt++, 0xfe);
+		mem_writeb(pt++, 0x38);
+		mem_writew(pt, cb_number);
+
+		CPU_JMP(false, CodeSeg, 0, 0);
+		CPU_SetSegGeneral(es, CodeSeg);
+		SETFLAGBIT(IF, false);
+
+		for (int slice = 0; slice < 100; ++slice) {
+			CPU_CycleLeft = 0;
+			CPU_Cycles    = 1000;
+
+			const auto ret = (*cpudecoder)();
+			ASSERT_GE(ret, 0);
+			if (ret == cb_number) {
+				return;
+			}
+		}
+		FAIL() << "the code didn't reach the stop callback";
+	}
+
+private:
+	CALLBACK_HandlerObject stop_callback = {};
+};
+
+// The REP STOSB overwrites the instruction right after it, which is already
+// in the prefetch queue, so the old instruction still runs
+TEST_F(CorePrefetchTest, RepStosOverwritingTheQueueRunsTheQueuedCode)
+{
+	Run({
+	        0xb3, 0x00,       // mov bl, 0
+	        0xb0, 0x40,       // mov al, 0x40 (inc ax)
+	        0xbf, 0x0d, 0x00, // mov di, 13
+	        0xb9, 0x02, 0x00, // mov cx, 2
+	        0xfc,             // cld
+	        0xf3, 0xaa,       // rep stosb
+	        0xb3, 0x01,       // mov bl, 1, overwritten with inc ax, inc ax
+	});
+
+	EXPECT_EQ(reg_bl, 1);
+	EXPECT_EQ(reg_al, 0x40);
+
+	// the memory got overwritten all the same
+	EXPECT_EQ(real_readb(CodeSeg, 13), 0x40);
+	EXPECT_EQ(real_readb(CodeSeg, 14), 0x40);
+}
+
+} // namespace
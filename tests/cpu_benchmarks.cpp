@@ -0,0 +1,441 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+// CPU core benchmarks
+// ~~~~~~~~~~~~~~~~~~~
+// Boots the emulator headlessly with each CPU core and runs canned x86
+// workloads flat out, without the host pacing and the PIC events of the
+// normal machine loop. Every workload executes the same instructions on every
+// core and checks its results with a model of the code, then reports the
+// emulated cycles per second (one cycle per instruction, or per iteration of
+// a string instruction, so about the emulated MIPS).
+//
+// With threaded opcode dispatch, the normal core also runs as 'normal_switch'
+// with its table pointing at the opcode switch, to compare both dispatches.
+//
+// Run them with 'meson test -C build --benchmark --verbose'; the results are
+// also recorded as 'cycles' and 'mips' properties of the gtest XML output.
+
+#include "cpu.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "callback.h"
+#include "mem.h"
+#include "regs.h"
+
+#include "dosbox_test_fixture.h"
+
+namespace {
+
+// Segments of the real mode workloads and their data
+constexpr uint16_t IntegerLoopSeg = 0x2000;
+constexpr uint16_t StringOpsSeg   = 0x2100;
+constexpr uint16_t FpuKernelSeg   = 0x2200;
+constexpr uint16_t PagingEntrySeg = 0x2300;
+constexpr uint16_t DataSeg        = 0x3000;
+
+// The protected mode structures of the paging workload
+constexpr PhysPt GdtBase       = 0x50000;
+constexpr PhysPt PageDirBase   = 0x51000;
+constexpr PhysPt PageTableBase = 0x52000;
+constexpr PhysPt PagingCode    = 0x54000;
+
+// The pages the paging workload walks over
+constexpr PhysPt TouchedPagesBase = 0x60000;
+constexpr uint32_t NumTouchedPages = 64;
+
+constexpr auto SliceCycles = 100000;
+
+// mov ecx, 3000000
+// xor eax, eax
+// mov ebx, 0x12345678
+// 1: add eax, ebx
+//    rol ebx, 5
+//    xor ebx, eax
+//    lea eax, [eax + eax * 8 + 7]
+//    dec ecx
+//    jnz 1b
+constexpr uint32_t IntegerLoopIterations = 3000000;
+
+const std::vector<uint8_t> IntegerLoop = {
+        0x66, 0xb9, 0xc0, 0xc6, 0x2d, 0x00,
+        0x66, 0x31, 0xc0,
+        0x66, 0xbb, 0x78, 0x56, 0x34, 0x12,
+        0x66, 0x01, 0xd8,
+        0x66, 0xc1, 0xc3, 0x05,
+        0x66, 0x31, 0xc3,
+        0x67, 0x66, 0x8d, 0x44, 0xc0, 0x07,
+        0x66, 0x49,
+        0x75, 0xec,
+};
+
+// cld
+// mov dx, 400
+// 1: xor si, si          ; copy the first 32 KB of the segment to the second
+//    mov di, 0x8000
+//    mov cx, 0x2000
+//    rep movsd
+//    xor di, di          ; and fill the first with the pass number
+//    mov al, dl
+//    mov cx, 0x8000
+//    rep stosb
+//    dec dx
+//    jnz 1b
+const std::vector<uint8_t> StringOps = {
+        0xfc,
+        0xba, 0x90, 0x01,
+        0x31, 0xf6,
+        0xbf, 0x00, 0x80,
+        0xb9, 0x00, 0x20,
+        0x66, 0xf3, 0xa5,
+        0x31, 0xff,
+        0x88, 0xd0,
+        0xb9, 0x00, 0x80,
+        0xf3, 0xaa,
+        0x4a,
+        0x75, 0xe9,
+};
+
+// finit
+// fldz
+// mov cx, 60000         ; sum the dot product of two 8-element float vectors
+// 1: xor bx, bx
+// 2: fld dword [bx]
+//    fmul dword [bx + 32]
+//    faddp st(1), st
+//    add bx, 4
+//    cmp bx, 32
+//    jb 2b
+//    loop 1b
+// fstp qword [64]
+constexpr int FpuKernelPasses = 60000;
+
+const std::vector<uint8_t> FpuKernel = {
+        0x9b, 0xdb, 0xe3,
+        0xd9, 0xee,
+        0xb9, 0x60, 0xea,
+        0x31, 0xdb,
+        0xd9, 0x07,
+        0xd8, 0x4f, 0x20,
+        0xde, 0xc1,
+        0x83, 0xc3, 0x04,
+        0x83, 0xfb, 0x20,
+        0x72, 0xf1,
+        0xe2, 0xed,
+        0xdd, 0x1e, 0x40, 0x00,
+};
+
+// cli
+// lgdt [0]              ; with ds pointing to the GDT pseudo-descriptor
+// mov eax, PageDirBase
+// mov cr3, eax
+// mov eax, cr0
+// or eax, 0x80000001    ; enable protected mode and paging
+// mov cr0, eax
+// jmp dword 0x08:PagingCode
+const std::vector<uint8_t> PagingEntry = {
+        0xfa,
+        0x0f, 0x01, 0x16, 0x00, 0x00,
+        0x66, 0xb8, 0x00, 0x10, 0x05, 0x00,
+        0x0f, 0x22, 0xd8,
+        0x0f, 0x20, 0xc0,
+        0x66, 0x0d, 0x01, 0x00, 0x00, 0x80,
+        0x0f, 0x22, 0xc0,
+        0x66, 0xea, 0x00, 0x40, 0x05, 0x00, 0x08, 0x00,
+};
+
+// [bits 32]
+// mov ax, 0x10
+// mov ds, ax
+// mov es, ax
+// mov edx, PageDirBase
+// mov ecx, 20000
+// xor eax, eax
+// 1: mov cr3, edx        ; flush the TLB on every pass
+//    mov esi, TouchedPagesBase
+// 2: add eax, [esi + 4]
+//    add eax, esi
+//    mov [esi + 4], eax
+//    add esi, 4096
+//    cmp esi, TouchedPagesBase + NumTouchedPages * 4096
+//    jb 2b
+//    dec ecx
+//    jnz 1b
+constexpr int PagingPasses = 20000;
+
+const std::vector<uint8_t> PagingLoop = {
+        0x66, 0xb8, 0x10, 0x00,
+        0x8e, 0xd8,
+        0x8e, 0xc0,
+        0xba, 0x00, 0x10, 0x05, 0x00,
+        0xb9, 0x20, 0x4e, 0x00, 0x00,
+        0x31, 0xc0,
+        0x0f, 0x22, 0xda,
+        0xbe, 0x00, 0x00, 0x06, 0x00,
+        0x03, 0x46, 0x04,
+        0x01, 0xf0,
+        0x89, 0x46, 0x04,
+        0x81, 0xc6, 0x00, 0x10, 0x00, 0x00,
+        0x81, 0xfe, 0x00, 0x00, 0x0a, 0x00,
+        0x72, 0xea,
+        0x49,
+        0x75, 0xdf,
+};
+
+Bitu stop_handler()
+{
+	return CBRET_STOP;
+}
+
+class CpuBenchmark : public DOSBoxTestFixture,
+                     public ::testing::WithParamInterface<const char*> {
+public:
+	CpuBenchmark()
+	{
+		const std::string param = GetParam();
+		const auto core = (param == "normal_switch") ? "normal" : param;
+
+		setting_overrides = {{"cpu", "core=" + core},
+		                     {"cpu", "cycles=fixed 100000"}};
+	}
+
+	void SetUp() override
+	{
+		DOSBoxTestFixture::SetUp();
+		stop_callback.Allocate(&stop_handler, "benchmark stop");
+#if C_CORE_THREADED_DISPATCH
+		CPU_Core_Normal_SetThreadedDispatch(std::string(GetParam()) !=
+		                                    "normal_switch");
+#endif
+	}
+
+	void TearDown() override
+	{
+#if C_CORE_THREADED_DISPATCH
+		CPU_Core_Normal_SetThreadedDispatch(true);
+#endif
+		stop_callback.Uninstall();
+		DOSBoxTestFixture::TearDown();
+	}
+
+protected:
+	// Writes the code followed by the stop callback instruction. The
+	// writes go through the memory handlers so the dynamic cores drop any
+	// code they've translated from earlier runs.
+	void WriteCode(const PhysPt address, const std::vector<uint8_t>& code)
+	{
+		PhysPt pt = address;
+		for (const auto byte : code) {
+			mem_writeb(pt++, byte);
+		}
+		const auto cb_number = stop_callback.Get_callback();
+		mem_writeb(pt++, 0xfe);
+		mem_writeb(pt++, 0x38);
+		mem_writew(pt, cb_number);
+	}
+
+	// Runs the real mode code at seg:0 until it reaches the stop callback
+	// and reports how fast it went
+	void Run(const char* workload, const uint16_t seg,
+	         const uint16_t data_seg = DataSeg)
+	{
+		CPU_JMP(false, seg, 0, 0);
+		CPU_SetSegGeneral(ds, data_seg);
+		CPU_SetSegGeneral(es, data_seg);
+		SETFLAGBIT(IF, false);
+
+		const auto start = std::chrono::steady_clock::now();
+		const auto cycles = RunUntilStopped();
+		const auto elapsed = std::chrono::duration<double>(
+		        std::chrono::steady_clock::now() - start);
+		ASSERT_GT(cycles, 0);
+
+		const auto mips = static_cast<double>(cycles) / elapsed.count() / 1e6;
+		printf("%-13s %-12s %10lld cycles %9.3f s %8.1f MIPS\n",
+		       GetParam(),
+		       workload,
+		       static_cast<long long>(cycles),
+		       elapsed.count(),
+		       mips);
+
+		RecordProperty("cycles", std::to_string(cycles));
+		RecordProperty("mips", std::to_string(mips));
+	}
+
+private:
+	// A stripped-down Normal_Loop that runs the core in fixed slices and
+	// returns the number of cycles executed, or -1 if the core bailed out
+	int64_t RunUntilStopped()
+	{
+		const auto cb_number = stop_callback.Get_callback();
+
+		int64_t cycles = 0;
+		while (true) {
+			CPU_CycleLeft = 0;
+			CPU_Cycles    = SliceCycles;
+
+			const auto ret = (*cpudecoder)();
+			cycles += SliceCycles - CPU_Cycles;
+
+			if (ret < 0) {
+				return -1;
+			}
+			if (ret == cb_number) {
+				return cycles;
+			}
+			if (ret > 0 && ret < CB_MAX) {
+				(*CallBack_Handlers[ret])();
+			}
+		}
+	}
+
+	CALLBACK_HandlerObject stop_callback = {};
+};
+
+TEST_P(CpuBenchmark, IntegerLoop)
+{
+	WriteCode(PhysicalMake(IntegerLoopSeg, 0), IntegerLoop);
+	Run("integer", IntegerLoopSeg);
+
+	uint32_t eax = 0;
+	uint32_t ebx = 0x12345678;
+	for (uint32_t i = 0; i < IntegerLoopIterations; ++i) {
+		eax += ebx;
+		ebx = (ebx << 5) | (ebx >> 27);
+		ebx ^= eax;
+		eax = eax * 9 + 7;
+	}
+	EXPECT_EQ(reg_eax, eax);
+	EXPECT_EQ(reg_ebx, ebx);
+}
+
+TEST_P(CpuBenchmark, StringOps)
+{
+	WriteCode(PhysicalMake(StringOpsSeg, 0), StringOps);
+	Run("string", StringOpsSeg);
+
+	// The last pass copies the fill of the one before it and fills the
+	// first half with its own number
+	for (const uint16_t offset : {0x0000, 0x1234, 0x7fff}) {
+		EXPECT_EQ(real_readb(DataSeg, offset), 1) << "offset " << offset;
+	}
+	for (const uint16_t offset : {0x8000, 0xabcd, 0xffff}) {
+		EXPECT_EQ(real_readb(DataSeg, offset), 2) << "offset " << offset;
+	}
+}
+
+TEST_P(CpuBenchmark, FpuKernel)
+{
+	// Small integers and halves keep the sums exact on every FPU
+	// implementation
+	float dot_product = 0.0f;
+	for (uint16_t i = 0; i < 8; ++i) {
+		const float a = i + 1.0f;
+		const float b = (i + 1.0f) * 0.5f;
+
+		uint32_t a_bits = 0;
+		uint32_t b_bits = 0;
+		std::memcpy(&a_bits, &a, sizeof(a_bits));
+		std::memcpy(&b_bits, &b, sizeof(b_bits));
+		real_writed(DataSeg, i * 4, a_bits);
+		real_writed(DataSeg, 32 + i * 4, b_bits);
+
+		dot_product += a * b;
+	}
+
+	WriteCode(PhysicalMake(FpuKernelSeg, 0), FpuKernel);
+	Run("fpu", FpuKernelSeg);
+
+	const uint64_t sum_bits = real_readq(DataSeg, 64);
+	double sum = 0.0;
+	std::memcpy(&sum, &sum_bits, sizeof(sum));
+	EXPECT_EQ(sum, static_cast<double>(dot_product) * FpuKernelPasses);
+}
+
+TEST_P(CpuBenchmark, Paging)
+{
+	// GDT pseudo-descriptor, then a null, a flat code and a flat data
+	// descriptor
+	phys_writew(GdtBase, 3 * 8 - 1);
+	phys_writed(GdtBase + 2, GdtBase + 8);
+	phys_writeq(GdtBase + 8, 0);
+	phys_writeq(GdtBase + 16, 0x00cf9a000000ffff);
+	phys_writeq(GdtBase + 24, 0x00cf92000000ffff);
+
+	// Identity-map the first 4 MB
+	for (PhysPt i = 0; i < 1024; ++i) {
+		phys_writed(PageDirBase + i * 4, 0);
+		phys_writed(PageTableBase + i * 4, i * 4096 | 0x3);
+	}
+	phys_writed(PageDirBase, PageTableBase | 0x3);
+
+	for (uint32_t page = 0; page < NumTouchedPages; ++page) {
+		phys_writed(TouchedPagesBase + page * 4096 + 4, 0);
+	}
+
+	WriteCode(PhysicalMake(PagingEntrySeg, 0), PagingEntry);
+	WriteCode(PagingCode, PagingLoop);
+
+	// The entry code loads the GDT from ds:0
+	Run("paging", PagingEntrySeg, static_cast<uint16_t>(GdtBase >> 4));
+	EXPECT_TRUE(cpu.pmode);
+
+	// Back to real mode for the next test
+	CPU_SET_CRX(0, cpu.cr0 & ~(CR0_PAGING | CR0_PROTECTION));
+	CPU_JMP(false, 0, 0, 0);
+	CPU_SetSegGeneral(ds, 0);
+	CPU_SetSegGeneral(es, 0);
+
+	std::vector<uint32_t> values(NumTouchedPages, 0);
+	uint32_t eax = 0;
+	for (int pass = 0; pass < PagingPasses; ++pass) {
+		for (uint32_t page = 0; page < NumTouchedPages; ++page) {
+			eax += values[page] + TouchedPagesBase + page * 4096;
+			values[page] = eax;
+		}
+	}
+	EXPECT_EQ(reg_eax, eax);
+	for (uint32_t page = 0; page < NumTouchedPages; ++page) {
+		EXPECT_EQ(phys_readd(TouchedPagesBase + page * 4096 + 4), values[page])
+		        << "page " << page;
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(Cores, CpuBenchmark,
+                         ::testing::Values("normal",
+#if C_CORE_THREADED_DISPATCH
+                                           "normal_switch",
+#endif
+                                           "simple"
+#if C_DYNAMIC_X86 || C_DYNREC
+                                           ,
+                                           "dynamic"
+#endif
+                                           ),
+                         [](const auto& info) { return std::string(info.param); });
+
+} // namespace
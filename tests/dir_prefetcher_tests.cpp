@@ -0,0 +1,111 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/dos/dir_prefetcher.cpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+class DirPrefetcherTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		std_fs::remove_all(base);
+		std_fs::create_directories(base / "GAMES" / "DOOM");
+		std_fs::create_directories(base / "EMPTY");
+		std::ofstream(base / "AUTOEXEC.BAT") << "@echo off";
+		std::ofstream(base / "GAMES" / "DOOM" / "DOOM.EXE") << "MZ";
+	}
+
+	void TearDown() override
+	{
+		std_fs::remove_all(base);
+	}
+
+	std::string key(const std_fs::path& dir) const
+	{
+		return (dir / "").string();
+	}
+
+	const std_fs::path base = std_fs::temp_directory_path() /
+	                          "dosbox_dir_prefetcher_test";
+};
+
+std::vector<std::string> names(const std::vector<DirPrefetcher::Entry>& entries)
+{
+	std::vector<std::string> result = {};
+	for (const auto& entry : entries) {
+		result.push_back(entry.name + (entry.is_directory ? "/" : ""));
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+TEST_F(DirPrefetcherTest, ListsWholeTree)
+{
+	DirPrefetcher prefetcher(base.string());
+	prefetcher.Wait();
+	EXPECT_EQ(prefetcher.GetNumListings(), 4);
+
+	const auto root = prefetcher.Take(key(base));
+	ASSERT_TRUE(root);
+	EXPECT_EQ(names(*root),
+	          (std::vector<std::string>{"../", "./", "AUTOEXEC.BAT", "EMPTY/", "GAMES/"}));
+
+	const auto doom = prefetcher.Take(key(base / "GAMES" / "DOOM"));
+	ASSERT_TRUE(doom);
+	EXPECT_EQ(names(*doom), (std::vector<std::string>{"../", "./", "DOOM.EXE"}));
+}
+
+TEST_F(DirPrefetcherTest, HandsOutListingsOnce)
+{
+	DirPrefetcher prefetcher(base.string());
+	prefetcher.Wait();
+
+	EXPECT_TRUE(prefetcher.Take(key(base / "EMPTY")));
+	EXPECT_FALSE(prefetcher.Take(key(base / "EMPTY")));
+	EXPECT_FALSE(prefetcher.Take(key(base / "MISSING")));
+}
+
+TEST_F(DirPrefetcherTest, DropsModifiedListings)
+{
+	DirPrefetcher prefetcher(base.string());
+	prefetcher.Wait();
+
+	const auto dir = base / "GAMES";
+	std_fs::last_write_time(dir,
+	                        std_fs::last_write_time(dir) - std::chrono::seconds(10));
+	EXPECT_FALSE(prefetcher.Take(key(dir)));
+	EXPECT_TRUE(prefetcher.Take(key(base / "GAMES" / "DOOM")));
+}
+
+TEST_F(DirPrefetcherTest, StopsAtEntryLimit)
+{
+	DirPrefetcher prefetcher(base.string(), 1);
+	prefetcher.Wait();
+	EXPECT_EQ(prefetcher.GetNumListings(), 1);
+}
+
+} // namespace
@@ -0,0 +1,157 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/ints/disk_image_overlay.cpp"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "std_filesystem.h"
+
+namespace {
+
+constexpr uint32_t ImageSizeKb = 1440;
+
+using Block = std::vector<uint8_t>;
+
+Block make_block(const uint8_t value)
+{
+	return Block(DiskImageOverlay::BlockSize, value);
+}
+
+class DiskImageOverlayTest : public ::testing::Test {
+protected:
+	void TearDown() override
+	{
+		std_fs::remove(path);
+	}
+
+	const std_fs::path path = std_fs::temp_directory_path() /
+	                          "dosbox_disk_image_overlay_test.bin";
+};
+
+TEST_F(DiskImageOverlayTest, CreatesEmptyOverlay)
+{
+	std_fs::remove(path);
+
+	const auto overlay = DiskImageOverlay::Open(path.string(), ImageSizeKb);
+	ASSERT_TRUE(overlay);
+	EXPECT_EQ(overlay->GetNumBlocks(), 0);
+	EXPECT_FALSE(overlay->Contains(0));
+
+	Block out = make_block(0);
+	EXPECT_FALSE(overlay->Read(0, out.data()));
+}
+
+TEST_F(DiskImageOverlayTest, ReadsBackWrites)
+{
+	std_fs::remove(path);
+
+	const auto overlay = DiskImageOverlay::Open(path.string(), ImageSizeKb);
+	ASSERT_TRUE(overlay);
+
+	ASSERT_TRUE(overlay->Write(100, make_block(0xaa).data()));
+	ASSERT_TRUE(overlay->Write(3, make_block(0x33).data()));
+	EXPECT_TRUE(overlay->Contains(100));
+	EXPECT_TRUE(overlay->Contains(3));
+	EXPECT_FALSE(overlay->Contains(4));
+
+	Block out = make_block(0);
+	ASSERT_TRUE(overlay->Read(100, out.data()));
+	EXPECT_EQ(out, make_block(0xaa));
+	ASSERT_TRUE(overlay->Read(3, out.data()));
+	EXPECT_EQ(out, make_block(0x33));
+}
+
+TEST_F(DiskImageOverlayTest, IsSparse)
+{
+	std_fs::remove(path);
+	{
+		const auto overlay = DiskImageOverlay::Open(path.string(), ImageSizeKb);
+		ASSERT_TRUE(overlay);
+
+		// Far apart blocks, one of them rewritten in place
+		ASSERT_TRUE(overlay->Write(0, make_block(0x01).data()));
+		ASSERT_TRUE(overlay->Write(2000, make_block(0x02).data()));
+		ASSERT_TRUE(overlay->Write(0, make_block(0x03).data()));
+	}
+	EXPECT_EQ(std_fs::file_size(path), HeaderSize + 2 * RecordSize);
+}
+
+TEST_F(DiskImageOverlayTest, PersistsAcrossOpens)
+{
+	std_fs::remove(path);
+	{
+		const auto overlay = DiskImageOverlay::Open(path.string(), ImageSizeKb);
+		ASSERT_TRUE(overlay);
+		ASSERT_TRUE(overlay->Write(7, make_block(0x07).data()));
+		ASSERT_TRUE(overlay->Write(9, make_block(0x09).data()));
+		ASSERT_TRUE(overlay->Write(7, make_block(0x77).data()));
+	}
+
+	const auto overlay = DiskImageOverlay::Open(path.string(), ImageSizeKb);
+	ASSERT_TRUE(overlay);
+	EXPECT_EQ(overlay->GetNumBlocks(), 2);
+
+	Block out = make_block(0);
+	ASSERT_TRUE(overlay->Read(7, out.data()));
+	EXPECT_EQ(out, make_block(0x77));
+	ASSERT_TRUE(overlay->Read(9, out.data()));
+	EXPECT_EQ(out, make_block(0x09));
+
+	// New blocks are appended after the existing ones
+	ASSERT_TRUE(overlay->Write(8, make_block(0x08).data()));
+	ASSERT_TRUE(overlay->Read(9, out.data()));
+	EXPECT_EQ(out, make_block(0x09));
+}
+
+TEST_F(DiskImageOverlayTest, RejectsOverlayOfOtherImage)
+{
+	std_fs::remove(path);
+	ASSERT_TRUE(DiskImageOverlay::Open(path.string(), ImageSizeKb));
+
+	EXPECT_FALSE(DiskImageOverlay::Open(path.string(), ImageSizeKb * 2));
+}
+
+TEST_F(DiskImageOverlayTest, DropsPartialRecord)
+{
+	std_fs::remove(path);
+	{
+		const auto overlay = DiskImageOverlay::Open(path.string(), ImageSizeKb);
+		ASSERT_TRUE(overlay);
+		ASSERT_TRUE(overlay->Write(1, make_block(0x01).data()));
+		ASSERT_TRUE(overlay->Write(2, make_block(0x02).data()));
+	}
+	// As if interrupted while appending the second block
+	std_fs::resize_file(path, HeaderSize + RecordSize + 100);
+
+	const auto overlay = DiskImageOverlay::Open(path.string(), ImageSizeKb);
+	ASSERT_TRUE(overlay);
+	EXPECT_TRUE(overlay->Contains(1));
+	EXPECT_FALSE(overlay->Contains(2));
+
+	ASSERT_TRUE(overlay->Write(3, make_block(0x03).data()));
+	Block out = make_block(0);
+	ASSERT_TRUE(overlay->Read(3, out.data()));
+	EXPECT_EQ(out, make_block(0x03));
+}
+
+} // namespace
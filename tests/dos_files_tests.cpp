@@ -336,6 +336,38 @@ TEST_F(DOS_FilesTest, DOS_FindFirst_FindFile_Nonexistant)
 	EXPECT_EQ(dos.errorcode, DOSERR_NO_MORE_FILES);
 }
 
+TEST_F(DOS_FilesTest, DOS_FindAll_FindFile)
+{
+	// Z: is a virtual drive, so this takes the fallback through the DTA
+	const auto original_dta = dos.dta();
+
+	std::vector<DOS_DTA::Result> results = {};
+	EXPECT_TRUE(DOS_FindAll("Z:\\AUTOEXEC.BAT", 0, results));
+	ASSERT_EQ(results.size(), 1);
+	EXPECT_EQ(results[0].name, "AUTOEXEC.BAT");
+	EXPECT_EQ(dos.dta(), original_dta);
+
+	results.clear();
+	EXPECT_FALSE(DOS_FindAll("Z:\\AUTOEXEC.NO", 0, results));
+	EXPECT_TRUE(results.empty());
+}
+
+TEST_F(DOS_FilesTest, DOS_FindAll_FindDevice)
+{
+	std::vector<DOS_DTA::Result> results = {};
+	EXPECT_TRUE(DOS_FindAll("COM1", FatAttributeFlags::Device, results));
+	ASSERT_EQ(results.size(), 1);
+	EXPECT_TRUE(results[0].IsDevice());
+}
+
+TEST_F(DOS_FilesTest, DOS_DTA_ToSearchPattern)
+{
+	EXPECT_EQ(DOS_DTA::ToSearchPattern("*.*"), "*       .*  ");
+	EXPECT_EQ(DOS_DTA::ToSearchPattern("AUTOEXEC.BAT"), "AUTOEXEC.BAT");
+	EXPECT_EQ(DOS_DTA::ToSearchPattern("NOEXT"), "NOEXT   .   ");
+	EXPECT_EQ(DOS_DTA::ToSearchPattern("12345678ABC.1234"), "12345678.123");
+}
+
 TEST_F(DOS_FilesTest, DOS_DTAExtendName_Space_Pads)
 {
 	assert_DTAExtendName("1234.E  ", "1234    ", "E  ");
@@ -0,0 +1,126 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "dos_inc.h"
+
+#include <gtest/gtest.h>
+
+#include "dosbox_test_fixture.h"
+
+namespace {
+
+class DOS_MemoryTest : public DOSBoxTestFixture {
+protected:
+	void SetUp() override
+	{
+		DOSBoxTestFixture::SetUp();
+		saved_strategy = DOS_GetMemAllocStrategy();
+	}
+
+	void TearDown() override
+	{
+		DOS_SetMemAllocStrategy(saved_strategy);
+		DOSBoxTestFixture::TearDown();
+	}
+
+	static uint16_t allocate(uint16_t blocks)
+	{
+		uint16_t segment = 0;
+		EXPECT_TRUE(DOS_AllocateMemory(&segment, &blocks));
+		return segment;
+	}
+
+private:
+	uint16_t saved_strategy = 0;
+};
+
+TEST_F(DOS_MemoryTest, FirstFitReusesFreedBlock)
+{
+	ASSERT_TRUE(DOS_SetMemAllocStrategy(0));
+
+	const auto a = allocate(0x100);
+	const auto b = allocate(0x100);
+	EXPECT_EQ(b, a + 0x101);
+
+	ASSERT_TRUE(DOS_FreeMemory(a));
+	const auto c = allocate(0x80);
+	EXPECT_EQ(c, a);
+
+	const DOS_MCB mcb(c - 1);
+	EXPECT_EQ(mcb.GetSize(), 0x80);
+	EXPECT_EQ(mcb.GetPSPSeg(), dos.psp());
+
+	// The rest of the freed block stays free in front of 'b'
+	const DOS_MCB rest(c + 0x80);
+	EXPECT_EQ(rest.GetPSPSeg(), MCB_FREE);
+	EXPECT_EQ(rest.GetSize(), 0x100 - 0x80 - 1);
+
+	EXPECT_TRUE(DOS_FreeMemory(b));
+	EXPECT_TRUE(DOS_FreeMemory(c));
+}
+
+TEST_F(DOS_MemoryTest, SeesMcbsEditedByPrograms)
+{
+	ASSERT_TRUE(DOS_SetMemAllocStrategy(0));
+
+	const auto a = allocate(0x100);
+	const auto b = allocate(0x100);
+
+	// Free 'b' behind DOS's back, like some programs do
+	DOS_MCB(b - 1).SetPSPSeg(MCB_FREE);
+
+	const auto c = allocate(0x100);
+	EXPECT_EQ(c, b);
+
+	EXPECT_TRUE(DOS_FreeMemory(a));
+	EXPECT_TRUE(DOS_FreeMemory(c));
+}
+
+TEST_F(DOS_MemoryTest, LastFitAllocatesEndOfBlock)
+{
+	ASSERT_TRUE(DOS_SetMemAllocStrategy(0));
+	const auto first_fit = allocate(0x100);
+	ASSERT_TRUE(DOS_FreeMemory(first_fit));
+
+	ASSERT_TRUE(DOS_SetMemAllocStrategy(2));
+	const auto last_fit = allocate(0x100);
+	EXPECT_GT(last_fit, first_fit);
+
+	const DOS_MCB mcb(last_fit - 1);
+	EXPECT_EQ(mcb.GetSize(), 0x100);
+	EXPECT_EQ(mcb.GetPSPSeg(), dos.psp());
+
+	EXPECT_TRUE(DOS_FreeMemory(last_fit));
+}
+
+TEST_F(DOS_MemoryTest, ReportsLargestBlock)
+{
+	uint16_t segment = 0;
+	uint16_t blocks  = 0xffff;
+	EXPECT_FALSE(DOS_AllocateMemory(&segment, &blocks));
+	EXPECT_GT(blocks, 0);
+
+	// Which is what can be allocated
+	const auto largest = allocate(blocks);
+	EXPECT_NE(largest, 0);
+	EXPECT_TRUE(DOS_FreeMemory(largest));
+}
+
+} // namespace
@@ -23,6 +23,8 @@
 
 #include <iterator>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -54,6 +56,10 @@ public:
 		// This will register all the init functions, but won't run them
 		DOSBOX_Init();
 
+		for (const auto& [section_name, line] : setting_overrides) {
+			control->GetSection(section_name)->HandleInputline(line);
+		}
+
 		for (auto section_name : sections) {
 			_sec = control->GetSection(section_name);
 			_sec->ExecuteInit();
@@ -68,6 +74,11 @@ public:
 		GFX_RequestExit(true);
 	}
 
+protected:
+	// Settings applied on top of the test config before the sections are
+	// initialised, as section name and 'name=value' pairs
+	std::vector<std::pair<std::string, std::string>> setting_overrides = {};
+
 private:
 	char const *arg_c_str;
 	const char *argv[1];
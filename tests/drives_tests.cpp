@@ -40,6 +40,9 @@
 #include <gtest/gtest.h>
 
 #include <string>
+#include <vector>
+
+#include "dos_system.h"
 
 std::string run_Set_Label(char const * const input, bool cdrom) {
     char output[32] = { 0 };
@@ -226,4 +229,31 @@ TEST(Set_Label, InvalidCharsEndingDotCD)
     EXPECT_EQ("?*':&@(..", output);
 }
 
+TEST(Virtual_Drive, LooksUpRegisteredFiles)
+{
+    const std::vector<uint8_t> blob = {1, 2, 3};
+    VFILE_Register("IDXTEST.COM", blob, "");
+    VFILE_Register("IDXDIR", nullptr, 0, "/");
+    VFILE_Register("INNER.TXT", blob, "/IDXDIR/");
+
+    Virtual_Drive drive;
+    EXPECT_TRUE(drive.FileExists("IDXTEST.COM"));
+    EXPECT_TRUE(drive.FileExists("idxtest.com"));
+    EXPECT_TRUE(drive.FileExists("IDXDIR\\INNER.TXT"));
+    EXPECT_TRUE(drive.FileExists("idxdir\\inner.txt"));
+    EXPECT_FALSE(drive.FileExists("INNER.TXT"));
+    EXPECT_FALSE(drive.FileExists("IDXDIR"));
+    EXPECT_TRUE(drive.TestDir("idxdir"));
+    EXPECT_FALSE(drive.TestDir("IDXTEST.COM"));
+    EXPECT_NE(drive.FileOpen("IDXTEST.COM", OPEN_READ), nullptr);
+
+    // Also removes files that aren't the latest registered one
+    VFILE_Remove("IDXTEST.COM");
+    EXPECT_FALSE(drive.FileExists("IDXTEST.COM"));
+    EXPECT_TRUE(drive.FileExists("IDXDIR\\INNER.TXT"));
+
+    VFILE_Remove("INNER.TXT", "IDXDIR");
+    EXPECT_FALSE(drive.FileExists("IDXDIR\\INNER.TXT"));
+}
+
 } // namespace
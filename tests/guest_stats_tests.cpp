@@ -0,0 +1,73 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "guest_stats.h"
+
+#include <iterator>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+TEST(GuestStats, TopCountsDescending)
+{
+	const uint64_t counts[] = {0, 5, 1, 9, 0, 5, 3};
+
+	const auto top = STATS_GetTopCounts(counts, std::size(counts), 3);
+	ASSERT_EQ(top.size(), 3);
+	EXPECT_EQ(top[0].index, 3);
+	EXPECT_EQ(top[0].count, 9);
+	EXPECT_EQ(top[1].count, 5);
+	EXPECT_EQ(top[2].count, 5);
+}
+
+TEST(GuestStats, TopCountsSkipsZeros)
+{
+	const uint64_t counts[] = {0, 2, 0, 0, 7};
+
+	const auto top = STATS_GetTopCounts(counts, std::size(counts), 10);
+	ASSERT_EQ(top.size(), 2);
+	EXPECT_EQ(top[0].index, 4);
+	EXPECT_EQ(top[1].index, 1);
+}
+
+TEST(GuestStats, TopCountsEmpty)
+{
+	const uint64_t counts[] = {0, 0, 0};
+
+	EXPECT_TRUE(STATS_GetTopCounts(counts, std::size(counts), 5).empty());
+	EXPECT_TRUE(STATS_GetTopCounts(counts, std::size(counts), 0).empty());
+}
+
+TEST(GuestStats, Reset)
+{
+	guest_stats.page_faults = 3;
+	++guest_stats.io_port_accesses[0x3da];
+	++guest_stats.int21_calls[0x3d];
+
+	STATS_Reset();
+
+	EXPECT_EQ(guest_stats.page_faults, 0);
+	EXPECT_EQ(guest_stats.io_port_accesses[0x3da], 0);
+	EXPECT_EQ(guest_stats.int21_calls[0x3d], 0);
+	EXPECT_GE(STATS_GetSecondsSinceReset(), 0.0);
+}
+
+} // namespace
@@ -0,0 +1,98 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/dos/host_dir_watcher.cpp"
+
+#include <algorithm>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+#include "std_filesystem.h"
+
+namespace {
+
+class HostDirWatcherTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		std_fs::remove_all(base);
+		std_fs::create_directories(base / "SUB");
+		std::ofstream(base / "OLD.TXT");
+
+		if (!watcher.IsSupported()) {
+			GTEST_SKIP() << "Host directories can't be watched";
+		}
+		watcher.Watch(dir);
+	}
+
+	void TearDown() override
+	{
+		std_fs::remove_all(base);
+	}
+
+	bool has_event(const std::vector<HostDirWatcher::Event>& events,
+	               const std::string& name, const HostDirWatcher::Change change)
+	{
+		return std::any_of(events.begin(), events.end(), [&](const auto& event) {
+			return event.dir == dir && event.name == name &&
+			       event.change == change;
+		});
+	}
+
+	const std_fs::path base = std_fs::temp_directory_path() /
+	                          "dosbox_host_dir_watcher_test";
+	const std::string dir   = (base / "").string();
+
+	HostDirWatcher watcher = {};
+};
+
+TEST_F(HostDirWatcherTest, NoChanges)
+{
+	EXPECT_TRUE(watcher.TakeEvents().empty());
+}
+
+TEST_F(HostDirWatcherTest, ReportsAddedAndRemoved)
+{
+	std::ofstream(base / "NEW.TXT");
+	std_fs::remove(base / "OLD.TXT");
+
+	const auto events = watcher.TakeEvents();
+	EXPECT_TRUE(has_event(events, "NEW.TXT", HostDirWatcher::Change::Added));
+	EXPECT_TRUE(has_event(events, "OLD.TXT", HostDirWatcher::Change::Removed));
+	EXPECT_TRUE(watcher.TakeEvents().empty());
+}
+
+TEST_F(HostDirWatcherTest, ReportsRenames)
+{
+	std_fs::rename(base / "OLD.TXT", base / "RENAMED.TXT");
+
+	const auto events = watcher.TakeEvents();
+	EXPECT_TRUE(has_event(events, "OLD.TXT", HostDirWatcher::Change::Removed));
+	EXPECT_TRUE(has_event(events, "RENAMED.TXT", HostDirWatcher::Change::Added));
+}
+
+TEST_F(HostDirWatcherTest, IgnoresChangesInSubdirectories)
+{
+	std::ofstream(base / "SUB" / "FILE.TXT");
+	EXPECT_TRUE(watcher.TakeEvents().empty());
+}
+
+} // namespace
@@ -0,0 +1,115 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "host_memory.h"
+
+#include <cstring>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "support.h"
+
+namespace {
+
+size_t get_bytes(const HostMemoryUse use)
+{
+	return HOST_MEMORY_GetUsage().at(static_cast<size_t>(use)).num_bytes;
+}
+
+size_t get_resident_bytes(const HostMemoryUse use)
+{
+	return HOST_MEMORY_GetUsage().at(static_cast<size_t>(use)).num_resident_bytes;
+}
+
+TEST(HostMemory, CountsBytes)
+{
+	const auto use = HostMemoryUse::CaptureQueues;
+	const auto num_bytes = get_bytes(use);
+
+	HOST_MEMORY_Add(use, 1000);
+	HOST_MEMORY_Add(use, 24);
+	EXPECT_EQ(get_bytes(use), num_bytes + 1024);
+	EXPECT_EQ(get_resident_bytes(use), num_bytes + 1024);
+
+	HOST_MEMORY_Remove(use, 1024);
+	EXPECT_EQ(get_bytes(use), num_bytes);
+}
+
+TEST(HostMemory, TrackedBlockIsUncountedWhenGone)
+{
+	const auto use = HostMemoryUse::SoundFonts;
+	const auto num_bytes = get_bytes(use);
+	{
+		TrackedHostMemory tracked(use);
+		tracked.Track(nullptr, 4096);
+		EXPECT_EQ(get_bytes(use), num_bytes + 4096);
+
+		tracked.Track(nullptr, 512);
+		EXPECT_EQ(get_bytes(use), num_bytes + 512);
+	}
+	EXPECT_EQ(get_bytes(use), num_bytes);
+}
+
+TEST(HostMemory, ResidentBytesOfTouchedBlock)
+{
+	const auto use = HostMemoryUse::Voodoo;
+
+	constexpr size_t NumBytes = 1024 * 1024;
+	auto block = std::make_unique<uint8_t[]>(NumBytes);
+	std::memset(block.get(), 1, NumBytes);
+
+	TrackedHostMemory tracked(use);
+	tracked.Track(block.get(), NumBytes);
+
+	EXPECT_EQ(get_bytes(use), NumBytes);
+	EXPECT_EQ(get_resident_bytes(use), NumBytes);
+}
+
+#if !defined(WIN32)
+TEST(HostMemory, ResidentBytesOfLazyBlock)
+{
+	const auto use = HostMemoryUse::VideoMemory;
+
+	constexpr size_t NumBytes = 4 * 1024 * 1024;
+	ZeroedBuffer buffer(NumBytes);
+
+	TrackedHostMemory tracked(use);
+	tracked.Track(buffer.data(), buffer.size());
+
+	// Only the written pages are committed
+	buffer.data()[0] = 1;
+	EXPECT_EQ(get_bytes(use), NumBytes);
+	EXPECT_LT(get_resident_bytes(use), NumBytes / 2);
+	EXPECT_GT(get_resident_bytes(use), 0);
+}
+#endif
+
+TEST(HostMemory, ProcessResidentBytes)
+{
+	const auto resident_bytes = HOST_MEMORY_GetProcessResidentBytes();
+	const auto peak_bytes     = HOST_MEMORY_GetProcessPeakResidentBytes();
+	ASSERT_TRUE(resident_bytes);
+	ASSERT_TRUE(peak_bytes);
+	EXPECT_GT(*resident_bytes, 0);
+	EXPECT_GE(*peak_bytes, *resident_bytes);
+}
+
+} // namespace
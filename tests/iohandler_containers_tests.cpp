@@ -195,4 +195,17 @@ TEST(iohandler_containers, adjacent_dword_write)
 	EXPECT_EQ(read_word_from_port(word_port_start), val >> 16);
 }
 
+TEST(iohandler_containers, freed_handlers)
+{
+	constexpr uint16_t port = 0x3da;
+
+	IO_RegisterReadHandler(port, read_word_new, io_width_t::word, 2);
+	word_val_new = 0x1234;
+	EXPECT_EQ(read_word_from_port(port), 0x1234);
+
+	IO_FreeReadHandler(port, io_width_t::word, 2);
+	EXPECT_EQ(read_word_from_port(port), 0xffff);
+	EXPECT_EQ(read_byte_from_port(port + 1), 0xff);
+}
+
 } // namespace
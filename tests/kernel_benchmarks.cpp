@@ -0,0 +1,366 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+// Video and audio kernel benchmarks
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Times the VGA line kernels, the simple scalers' line handlers, and the
+// mixer's sample kernels, channel conversions, resamplers and compressor on
+// synthetic buffers, reporting their throughput. Their correctness is covered
+// by the unit tests; these only give a quick way to compare kernels and hosts.
+//
+// Run them with 'meson test -C build --benchmark --verbose', or a single
+// group with e.g. './build/tests/kernel_benchmarks --gtest_filter=Scalers.*'
+
+#include "mixer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../src/gui/render_line_kernels.h"
+#include "../src/gui/render_scalers.h"
+#include "../src/hardware/compressor.h"
+#include "../src/hardware/mixer_kernels.h"
+#include "../src/hardware/vga_draw_lines.h"
+#include "render.h"
+
+#include "dosbox_test_fixture.h"
+
+namespace {
+
+// Calls 'run' 'iterations' times, each processing 'units_per_iteration'
+// pixels, samples or frames, and reports the throughput
+template <typename Run>
+void benchmark(const char* name, const char* unit, const int iterations,
+               const size_t units_per_iteration, Run run)
+{
+	// Warm up the caches and any lazily initialised state
+	run();
+
+	const auto start = std::chrono::steady_clock::now();
+	for (auto i = 0; i < iterations; ++i) {
+		run();
+	}
+	const auto elapsed = std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - start);
+
+	const auto units = static_cast<double>(units_per_iteration) * iterations;
+	const auto mega_units_per_s = units / elapsed.count() / 1e6;
+	printf("%-32s %10.1f M%s/s %8.3f ns/%s\n",
+	       name,
+	       mega_units_per_s,
+	       unit,
+	       elapsed.count() * 1e9 / units,
+	       unit);
+}
+
+// A repeatable pattern that doesn't repeat within the vector widths
+template <typename T>
+std::vector<T> make_pattern(const size_t size, const uint32_t seed = 0x5a)
+{
+	std::vector<T> values(size);
+	uint32_t state = seed;
+	for (auto& value : values) {
+		state = state * 1103515245 + 12345;
+		value = static_cast<T>(state >> 8);
+	}
+	return values;
+}
+
+std::vector<float> make_samples(const size_t size, const float amplitude)
+{
+	std::vector<float> samples(size);
+	uint32_t state = 0x1234;
+	for (auto& sample : samples) {
+		state = state * 1103515245 + 12345;
+		sample = (static_cast<float>(state >> 8) / (1 << 24) - 0.5f) *
+		         2.0f * amplitude;
+	}
+	return samples;
+}
+
+// VGA line kernels
+// ----------------
+
+constexpr uint8_t Palette[16] = {0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87,
+                                 0x98, 0xa9, 0xba, 0xcb, 0xdc, 0xed, 0xfe, 0x0f};
+
+TEST(VgaDrawLines, Expand4Bpp)
+{
+	constexpr Bitu AddrMask = 64 * 1024 - 1;
+	const auto memory       = make_pattern<uint8_t>(AddrMask + 1);
+
+	// A 640-pixel 16-colour line, and a 320-pixel one written doubled
+	std::vector<uint8_t> out(640);
+	Bitu start = 0;
+	benchmark("VGA_Expand4BppLine", "px", 100000, out.size(), [&] {
+		VGA_Expand4BppLine(memory.data(), start, AddrMask, 320, Palette, out.data());
+		start += 320;
+	});
+	benchmark("VGA_Expand4BppLineDoubled", "px", 100000, out.size(), [&] {
+		VGA_Expand4BppLineDoubled(memory.data(), start, AddrMask, 160, Palette, out.data());
+		start += 160;
+	});
+}
+
+TEST(VgaDrawLines, Palettize)
+{
+	std::vector<Bgrx8888> palette_map(256);
+	for (size_t i = 0; i < palette_map.size(); ++i) {
+		palette_map[i] = Bgrx8888(static_cast<uint8_t>(i),
+		                          static_cast<uint8_t>(255 - i),
+		                          static_cast<uint8_t>(i * 3));
+	}
+	const auto indexes = make_pattern<uint8_t>(640);
+
+	std::vector<uint8_t> out(indexes.size() * 4);
+	benchmark("VGA_PalettizeLine", "px", 100000, indexes.size(), [&] {
+		VGA_PalettizeLine(indexes.data(), indexes.size(), palette_map.data(), out.data());
+	});
+}
+
+TEST(VgaDrawLines, DecodeComposite)
+{
+	constexpr size_t NumPixels = 640;
+
+	// Values in the ranges of the CGA composite emulation
+	std::vector<int> luma(NumPixels + 2);
+	std::vector<int> chroma_a(NumPixels);
+	std::vector<int> chroma_b(NumPixels);
+	const auto pattern = make_pattern<uint16_t>(luma.size() + NumPixels * 2);
+	for (size_t i = 0; i < luma.size(); ++i) {
+		luma[i] = pattern[i] % 16000;
+	}
+	for (size_t i = 0; i < NumPixels; ++i) {
+		chroma_a[i] = pattern[luma.size() + i] % 8000 - 4000;
+		chroma_b[i] = pattern[luma.size() + NumPixels + i] % 8000 - 4000;
+	}
+
+	CompositeCoefficients co = {};
+	co.ri        = 2014;
+	co.rq        = 1226;
+	co.gi        = -877;
+	co.gq        = -1659;
+	co.bi        = -3417;
+	co.bq        = 1050;
+	co.sharpness = 256;
+
+	std::vector<uint8_t> out(NumPixels * 4);
+	benchmark("VGA_DecodeCompositeLine", "px", 20000, NumPixels, [&] {
+		VGA_DecodeCompositeLine(luma.data() + 1,
+		                        chroma_a.data(),
+		                        chroma_b.data(),
+		                        NumPixels,
+		                        co,
+		                        out.data());
+	});
+}
+
+// Simple scalers
+// --------------
+
+TEST(Scalers, ConvertLine)
+{
+	const auto src8  = make_pattern<uint8_t>(640);
+	const auto src16 = make_pattern<uint16_t>(640);
+	const auto lut   = make_pattern<uint32_t>(256);
+
+	std::vector<uint32_t> out(640 * 2);
+	benchmark("RENDER_Convert8To32", "px", 100000, 640, [&] {
+		RENDER_Convert8To32(src8.data(), 640, lut.data(), out.data());
+	});
+	benchmark("RENDER_Convert15To32Doubled", "px", 100000, 640 * 2, [&] {
+		RENDER_Convert15To32Doubled(src16.data(), 640, out.data());
+	});
+	benchmark("RENDER_Convert16To32", "px", 100000, 640, [&] {
+		RENDER_Convert16To32(src16.data(), 640, out.data());
+	});
+}
+
+// Renders whole frames through a scaler's line handler the way the renderer
+// does, with 32-bit output. Two source frames take turns so every line has
+// changed and gets converted.
+void benchmark_scaler(const char* name, const ScalerSimpleBlock_t& scaler,
+                      const int handler_index, const uint16_t width,
+                      const uint16_t height, const size_t bytes_per_pixel)
+{
+	const auto handler = scaler.Linear[handler_index][scalerMode32];
+	ASSERT_NE(handler, nullptr);
+
+	const auto pitch = width * bytes_per_pixel;
+	const std::vector<std::vector<uint8_t>> frames = {
+	        make_pattern<uint8_t>(pitch * height, 1),
+	        make_pattern<uint8_t>(pitch * height, 2)};
+
+	const auto out_pitch = width * scaler.xscale * sizeof(uint32_t);
+	std::vector<uint8_t> out(out_pitch * height * scaler.yscale);
+
+	const auto lut = make_pattern<uint32_t>(256);
+	for (size_t i = 0; i < lut.size(); ++i) {
+		render.pal.lut.b32[i] = lut[i];
+	}
+	render.src.width        = width;
+	render.scale.cachePitch = static_cast<uint32_t>(pitch);
+	render.scale.outPitch   = static_cast<int>(out_pitch);
+
+	size_t frame_index = 0;
+	benchmark(name, "px", 200, static_cast<size_t>(width) * height, [&] {
+		render.scale.cacheRead  = reinterpret_cast<uint8_t*>(&scalerSourceCache);
+		render.scale.outWrite   = out.data();
+		render.scale.outLine    = 0;
+		Scaler_ChangedLineIndex = 0;
+		Scaler_ChangedLines[0]  = 0;
+
+		const auto& frame = frames[frame_index++ % frames.size()];
+		for (size_t y = 0; y < height; ++y) {
+			handler(frame.data() + y * pitch);
+		}
+	});
+}
+
+TEST(Scalers, Frames)
+{
+	benchmark_scaler("Normal1x 8 to 32, 640x480", ScaleNormal1x, 0, 640, 480, 1);
+	benchmark_scaler("Normal1x 16 to 32, 640x480", ScaleNormal1x, 2, 640, 480, 2);
+	benchmark_scaler("Normal1x 32 to 32, 640x480", ScaleNormal1x, 4, 640, 480, 4);
+	benchmark_scaler("NormalDw 8 to 32, 320x200", ScaleNormalDw, 0, 320, 200, 1);
+	benchmark_scaler("Normal2x 8 to 32, 320x200", ScaleNormal2x, 0, 320, 200, 1);
+	benchmark_scaler("Normal2x 15 to 32, 320x240", ScaleNormal2x, 1, 320, 240, 2);
+}
+
+// Mixer
+// -----
+
+constexpr size_t NumFrames = 1024;
+
+TEST(Mixer, SampleKernels)
+{
+	const auto src  = make_samples(NumFrames * 2, 32000.0f);
+	const auto src2 = make_samples(NumFrames * 2, 32000.0f);
+	const auto s16  = make_pattern<int16_t>(NumFrames * 2);
+
+	std::vector<float> dest(NumFrames * 2);
+	std::vector<int16_t> out16(NumFrames * 2);
+
+	benchmark("MIXER_AccumulateSamples", "sample", 50000, src.size(), [&] {
+		MIXER_AccumulateSamples(dest.data(), src.data(), src.size());
+	});
+	benchmark("MIXER_AccumulateScaledSamples", "sample", 50000, src.size(), [&] {
+		MIXER_AccumulateScaledSamples(dest.data(), src.data(), 0.5f, src.size());
+	});
+	benchmark("MIXER_ConvertToInt16", "sample", 50000, src.size(), [&] {
+		MIXER_ConvertToInt16(src2.data(), src2.size(), out16.data());
+	});
+	benchmark("MIXER_ConvertS16ToFloat", "sample", 50000, s16.size(), [&] {
+		MIXER_ConvertS16ToFloat(s16.data(), s16.size(), dest.data());
+	});
+	benchmark("MIXER_ScaleStereoFrames", "frame", 50000, NumFrames, [&] {
+		MIXER_ScaleStereoFrames(src.data(), NumFrames, 0.7f, 0.3f, dest.data());
+	});
+
+	// An 8th-order low-pass filter with unity gain, like the channels'
+	// custom filters
+	const std::vector<MixerBiquad> sections(4, {0.1875, 0.375, 0.1875, -0.5, 0.25});
+	std::vector<MixerBiquadState> states(sections.size());
+	std::vector<float> frames(src);
+	benchmark("MIXER_FilterStereoFrames", "frame", 5000, NumFrames, [&] {
+		MIXER_FilterStereoFrames(frames.data(),
+		                         NumFrames,
+		                         sections.data(),
+		                         states.data(),
+		                         sections.size());
+	});
+}
+
+TEST(Mixer, Compressor)
+{
+	Compressor compressor = {};
+	compressor.Configure(48000, Max16BitSampleValue, -6.0f, 3.0f, 0.01f, 5000.0f, 10.0f);
+
+	const auto samples = make_samples(NumFrames * 2, 40000.0f);
+
+	float sum = 0.0f;
+	benchmark("Compressor::Process", "frame", 5000, NumFrames, [&] {
+		for (size_t i = 0; i < samples.size(); i += 2) {
+			sum += compressor.Process({samples[i], samples[i + 1]}).left;
+		}
+	});
+	EXPECT_TRUE(std::isfinite(sum));
+}
+
+// The channel conversions and resamplers need the mixer's output rate, so
+// they run with the mixer initialised in 'nosound' mode
+class MixerChannelBenchmark : public DOSBoxTestFixture {
+public:
+	MixerChannelBenchmark()
+	{
+		setting_overrides = {{"mixer", "nosound=true"}};
+	}
+};
+
+void handler(const int) {}
+
+TEST_F(MixerChannelBenchmark, AddSamples)
+{
+	const auto u8  = make_pattern<uint8_t>(NumFrames);
+	const auto s16 = make_pattern<int16_t>(NumFrames * 2);
+	const auto f32 = make_samples(NumFrames * 2, 32000.0f);
+
+	MixerChannel channel(handler, "BENCHMARK", {ChannelFeature::Stereo});
+	channel.SetSampleRate(UseMixerRate);
+
+	benchmark("AddSamples_m8", "frame", 5000, NumFrames, [&] {
+		channel.AddSamples_m8(NumFrames, u8.data());
+	});
+	benchmark("AddSamples_s16", "frame", 5000, NumFrames, [&] {
+		channel.AddSamples_s16(NumFrames, s16.data());
+	});
+	benchmark("AddSamples_s16_nonnative", "frame", 5000, NumFrames, [&] {
+		channel.AddSamples_s16_nonnative(NumFrames, s16.data());
+	});
+	benchmark("AddSamples_sfloat", "frame", 5000, NumFrames, [&] {
+		channel.AddSamples_sfloat(NumFrames, f32.data());
+	});
+}
+
+TEST_F(MixerChannelBenchmark, Resamplers)
+{
+	const auto s16 = make_pattern<int16_t>(NumFrames * 2);
+
+	// From a typical Sound Blaster rate to the 48 kHz of the test config
+	auto run = [&](const char* name, const ResampleMethod method) {
+		MixerChannel channel(handler, "BENCHMARK", {ChannelFeature::Stereo});
+		channel.SetSampleRate(22050);
+		channel.SetZeroOrderHoldUpsamplerTargetRate(44100);
+		channel.SetResampleMethod(method);
+
+		benchmark(name, "frame", 2000, NumFrames, [&] {
+			channel.AddSamples_s16(NumFrames, s16.data());
+		});
+	};
+	run("Lerp upsample 22050 Hz", ResampleMethod::LerpUpsampleOrResample);
+	run("ZoH and resample 22050 Hz", ResampleMethod::ZeroOrderHoldAndResample);
+	run("Resample 22050 Hz", ResampleMethod::Resample);
+}
+
+} // namespace
@@ -20,8 +20,15 @@
 
 #include "mixer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "../src/hardware/mixer_kernels.h"
+#include "math_utils.h"
+
 static void callback(const uint16_t) {}
 
 constexpr auto ChannelName = "TEST";
@@ -81,4 +88,287 @@ TEST(MixerConfigureFadeOut, OutOfBounds)
 	ASSERT_FALSE(channel.ConfigureFadeOut("3001 10000"));
 }
 
+// Samples of the master mix in and beyond the 16-bit range, with fractions in
+// both directions and a pattern that doesn't repeat within the vector widths
+std::vector<float> make_samples(const size_t num_samples)
+{
+	std::vector<float> samples(num_samples);
+	uint32_t state = 12345;
+	for (auto& sample : samples) {
+		state  = state * 1103515245 + 12345;
+		sample = static_cast<float>(static_cast<int32_t>(state)) / 40000.0f;
+	}
+	return samples;
+}
+
+// Lengths around the vector widths
+constexpr size_t SampleCounts[] = {0, 1, 3, 4, 5, 7, 8, 9, 17, 1024, 1027};
+
+// The scalar reference implementations are the original frame-by-frame
+// loops, which the kernels have to match bit for bit
+TEST(MixerKernels, AccumulateMatchesReference)
+{
+	for (const auto num_samples : SampleCounts) {
+		const auto src = make_samples(num_samples + 1);
+		auto dest      = make_samples(num_samples + 2);
+		dest.erase(dest.begin());
+
+		auto expected = dest;
+		for (size_t i = 0; i < num_samples; ++i) {
+			expected[i] += src[i];
+		}
+
+		MIXER_AccumulateSamples(dest.data(), src.data(), num_samples);
+		EXPECT_EQ(dest, expected) << "num_samples " << num_samples;
+	}
+}
+
+TEST(MixerKernels, AccumulateScaledMatchesReference)
+{
+	for (const auto num_samples : SampleCounts) {
+		for (const auto gain : {0.0f, 0.3162f, 1.0f}) {
+			const auto src = make_samples(num_samples + 1);
+			auto dest      = make_samples(num_samples + 2);
+			dest.erase(dest.begin());
+
+			auto expected = dest;
+			for (size_t i = 0; i < num_samples; ++i) {
+				const auto scaled = src[i] * gain;
+				expected[i] += scaled;
+			}
+
+			MIXER_AccumulateScaledSamples(dest.data(), src.data(), gain, num_samples);
+			EXPECT_EQ(dest, expected)
+			        << "num_samples " << num_samples << ", gain " << gain;
+		}
+	}
+}
+
+TEST(MixerKernels, ConvertToInt16MatchesReference)
+{
+	for (const auto num_samples : SampleCounts) {
+		const auto src = make_samples(num_samples);
+
+		std::vector<int16_t> expected(num_samples + 1, 0x5a5a);
+		for (size_t i = 0; i < num_samples; ++i) {
+			expected[i] = clamp_to_int16(src[i]);
+		}
+
+		// One sample more than needed to check for overruns
+		std::vector<int16_t> out(num_samples + 1, 0x5a5a);
+		MIXER_ConvertToInt16(src.data(), num_samples, out.data());
+		EXPECT_EQ(out, expected) << "num_samples " << num_samples;
+	}
+}
+
+TEST(MixerKernels, ConvertToInt16Golden)
+{
+	const std::vector<float> src = {0.0f,     -0.0f,     0.9f,     -0.9f,
+	                                32766.5f, 32767.0f,  32767.9f, 1e9f,
+	                                -32768.0f, -32768.9f, -1e9f,   -1.5f};
+
+	std::vector<int16_t> out(src.size());
+	MIXER_ConvertToInt16(src.data(), src.size(), out.data());
+
+	const std::vector<int16_t> expected = {0,      0,      0,      0,
+	                                       32766,  32767,  32767,  32767,
+	                                       -32768, -32768, -32768, -1};
+	EXPECT_EQ(out, expected);
+}
+
+TEST(MixerKernels, ConvertS16ToFloatMatchesReference)
+{
+	for (const auto num_samples : SampleCounts) {
+		std::vector<int16_t> src(num_samples);
+		for (size_t i = 0; i < num_samples; ++i) {
+			src[i] = static_cast<int16_t>(i * 7919 + 32000);
+		}
+		if (num_samples > 2) {
+			src[1] = INT16_MIN;
+			src[2] = INT16_MAX;
+		}
+
+		std::vector<float> expected(num_samples + 1, 1.5f);
+		for (size_t i = 0; i < num_samples; ++i) {
+			expected[i] = static_cast<float>(src[i]);
+		}
+
+		std::vector<float> out(num_samples + 1, 1.5f);
+		MIXER_ConvertS16ToFloat(src.data(), num_samples, out.data());
+		EXPECT_EQ(out, expected) << "num_samples " << num_samples;
+	}
+}
+
+TEST(MixerKernels, ConvertU16ToFloatMatchesReference)
+{
+	for (const auto num_samples : SampleCounts) {
+		std::vector<uint16_t> src(num_samples);
+		for (size_t i = 0; i < num_samples; ++i) {
+			src[i] = static_cast<uint16_t>(i * 7919 + 32000);
+		}
+		if (num_samples > 2) {
+			src[1] = 0;
+			src[2] = UINT16_MAX;
+		}
+
+		std::vector<float> expected(num_samples + 1, 1.5f);
+		for (size_t i = 0; i < num_samples; ++i) {
+			expected[i] = static_cast<float>(static_cast<int>(src[i]) - 32768);
+		}
+
+		std::vector<float> out(num_samples + 1, 1.5f);
+		MIXER_ConvertU16ToFloat(src.data(), num_samples, out.data());
+		EXPECT_EQ(out, expected) << "num_samples " << num_samples;
+	}
+}
+
+TEST(MixerKernels, ScaleFramesMatchesReference)
+{
+	constexpr auto GainLeft  = 0.75f;
+	constexpr auto GainRight = 1.3f;
+
+	for (const auto num_frames : SampleCounts) {
+		const auto src = make_samples(num_frames * 2);
+
+		std::vector<float> expected_stereo(num_frames * 2 + 1, 1.5f);
+		std::vector<float> expected_mono(num_frames * 2 + 1, 1.5f);
+		for (size_t i = 0; i < num_frames; ++i) {
+			const auto stereo = AudioFrame{src[i * 2], src[i * 2 + 1]} *
+			                    AudioFrame{GainLeft, GainRight};
+			expected_stereo[i * 2]     = stereo.left;
+			expected_stereo[i * 2 + 1] = stereo.right;
+
+			const auto mono = AudioFrame{src[i]} *
+			                  AudioFrame{GainLeft, GainRight};
+			expected_mono[i * 2]     = mono.left;
+			expected_mono[i * 2 + 1] = mono.right;
+		}
+
+		std::vector<float> out(num_frames * 2 + 1, 1.5f);
+		MIXER_ScaleStereoFrames(src.data(), num_frames, GainLeft, GainRight, out.data());
+		EXPECT_EQ(out, expected_stereo) << "num_frames " << num_frames;
+
+		std::fill(out.begin(), out.end(), 1.5f);
+		MIXER_ScaleMonoFramesToStereo(src.data(), num_frames, GainLeft, GainRight, out.data());
+		EXPECT_EQ(out, expected_mono) << "num_frames " << num_frames;
+	}
+}
+
+TEST(MixerKernels, DeinterleaveFramesMatchesReference)
+{
+	for (const auto num_frames : SampleCounts) {
+		const auto src = make_samples(num_frames * 2);
+
+		std::vector<float> expected_left(num_frames + 1, 1.5f);
+		std::vector<float> expected_right(num_frames + 1, 1.5f);
+		for (size_t i = 0; i < num_frames; ++i) {
+			expected_left[i]  = src[i * 2];
+			expected_right[i] = src[i * 2 + 1];
+		}
+
+		std::vector<float> left(num_frames + 1, 1.5f);
+		std::vector<float> right(num_frames + 1, 1.5f);
+		MIXER_DeinterleaveFrames(src.data(), num_frames, left.data(), right.data());
+		EXPECT_EQ(left, expected_left) << "num_frames " << num_frames;
+		EXPECT_EQ(right, expected_right) << "num_frames " << num_frames;
+
+		// Accumulating them again doubles the frames
+		std::vector<float> dest(src);
+		dest.push_back(1.5f);
+		MIXER_AccumulateDeinterleavedFrames(dest.data(), left.data(), right.data(), num_frames);
+
+		for (size_t i = 0; i < num_frames * 2; ++i) {
+			ASSERT_EQ(dest[i], src[i] + src[i]) << "num_frames " << num_frames;
+		}
+		EXPECT_EQ(dest.back(), 1.5f) << "num_frames " << num_frames;
+	}
+}
+
+TEST(MixerKernels, GetPeakAmplitudeMatchesReference)
+{
+	for (const auto num_samples : SampleCounts) {
+		const auto src = make_samples(num_samples);
+
+		auto expected = 0.0f;
+		for (const auto sample : src) {
+			expected = std::max(expected, std::fabs(sample));
+		}
+		EXPECT_EQ(MIXER_GetPeakAmplitude(src.data(), num_samples), expected)
+		        << "num_samples " << num_samples;
+	}
+
+	// The peak is found in every lane, and for negative samples
+	for (size_t i = 0; i < 9; ++i) {
+		std::vector<float> src(9, 0.25f);
+		src[i] = -3.0f;
+		EXPECT_EQ(MIXER_GetPeakAmplitude(src.data(), src.size()), 3.0f) << "i " << i;
+	}
+}
+
+// The direct form II reference of the Iir library's filters, run for one
+// channel of the frames
+void filter_channel(std::vector<float>& frames, const size_t channel,
+                    const std::vector<MixerBiquad>& sections,
+                    std::vector<MixerBiquadState>& states)
+{
+	for (size_t i = channel; i < frames.size(); i += 2) {
+		double sample = frames[i];
+		for (size_t j = 0; j < sections.size(); ++j) {
+			const auto& s = sections[j];
+			auto& v1      = states[j].v1[channel];
+			auto& v2      = states[j].v2[channel];
+
+			const auto w = sample - s.a1 * v1 - s.a2 * v2;
+			sample       = s.b0 * w + s.b1 * v1 + s.b2 * v2;
+
+			v2 = v1;
+			v1 = w;
+		}
+		frames[i] = static_cast<float>(sample);
+	}
+}
+
+TEST(MixerKernels, FilterStereoFramesMatchesReference)
+{
+	for (size_t num_sections = 0; num_sections <= MixerMaxBiquads; ++num_sections) {
+		// Stable sections with different coefficients
+		std::vector<MixerBiquad> sections = {};
+		for (size_t i = 0; i < num_sections; ++i) {
+			const auto k = static_cast<double>(i) / 10.0;
+			sections.push_back({0.2 + k, 0.4 - k, 0.2, -0.5 + k, 0.25 - k / 2});
+		}
+
+		for (const auto num_frames : SampleCounts) {
+			const auto src = make_samples(num_frames * 2);
+
+			auto expected = src;
+			std::vector<MixerBiquadState> expected_states(num_sections);
+			filter_channel(expected, 0, sections, expected_states);
+			filter_channel(expected, 1, sections, expected_states);
+
+			// The states carry over between the blocks
+			auto frames = src;
+			std::vector<MixerBiquadState> states(num_sections);
+			const auto first_frames = num_frames / 3;
+			MIXER_FilterStereoFrames(frames.data(),
+			                         first_frames,
+			                         sections.data(),
+			                         states.data(),
+			                         num_sections);
+			MIXER_FilterStereoFrames(frames.data() + first_frames * 2,
+			                         num_frames - first_frames,
+			                         sections.data(),
+			                         states.data(),
+			                         num_sections);
+
+			EXPECT_EQ(frames, expected) << "num_sections " << num_sections
+			                            << ", num_frames " << num_frames;
+			for (size_t i = 0; i < num_sections; ++i) {
+				EXPECT_EQ(states[i].v1, expected_states[i].v1);
+				EXPECT_EQ(states[i].v2, expected_states[i].v2);
+			}
+		}
+	}
+}
+
 } // namespace
@@ -0,0 +1,231 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/hardware/reelmagic/picture_kernels.cpp"
+
+#include <cmath>
+#include <vector>
+
+#define PL_MPEG_IMPLEMENTATION
+#include "../src/hardware/reelmagic/mpeg_decoder.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// A decoded picture with every plane filled with a pattern that doesn't
+// repeat within the vector widths, and that hits the clamping on both ends
+struct TestPicture {
+	std::vector<uint8_t> y  = {};
+	std::vector<uint8_t> cb = {};
+	std::vector<uint8_t> cr = {};
+
+	plm_frame_t frame = {};
+
+	TestPicture(const unsigned width, const unsigned height)
+	{
+		// pl_mpeg's planes are padded to whole macroblocks
+		const auto y_width  = (width + 15) & ~15u;
+		const auto y_height = (height + 15) & ~15u;
+
+		y.resize(y_width * y_height);
+		cb.resize(y.size() / 4);
+		cr.resize(y.size() / 4);
+
+		uint8_t value = 0x5a;
+		for (auto plane : {&y, &cb, &cr}) {
+			for (auto& byte : *plane) {
+				byte  = value;
+				value = static_cast<uint8_t>(value * 13 + 7);
+			}
+		}
+
+		frame.width  = width;
+		frame.height = height;
+		frame.y      = {y_width, y_height, y.data()};
+		frame.cb     = {y_width / 2, y_height / 2, cb.data()};
+		frame.cr     = {y_width / 2, y_height / 2, cr.data()};
+	}
+};
+
+// The reference the kernels have to match: pl_mpeg's conversion, writing
+// into zeroed memory so the X bytes stay zero
+std::vector<uint8_t> reference_picture(TestPicture& picture)
+{
+	const auto stride = picture.frame.width * 4;
+	std::vector<uint8_t> out(stride * picture.frame.height);
+	plm_frame_to_bgra(&picture.frame, out.data(), static_cast<int>(stride));
+	return out;
+}
+
+std::vector<uint8_t> convert_test_picture(const convert_kernel_f convert,
+                                          const TestPicture& picture)
+{
+	const auto& frame = picture.frame;
+	const auto stride = frame.width * 4;
+	std::vector<uint8_t> out(stride * frame.height);
+	convert_picture(convert,
+	                frame.y.data,
+	                frame.y.width,
+	                frame.cb.data,
+	                frame.cr.data,
+	                frame.cb.width,
+	                frame.width,
+	                frame.height,
+	                out.data(),
+	                stride);
+	return out;
+}
+
+void expect_conversion(const convert_kernel_f convert)
+{
+	// Widths around the vector widths, and odd sizes
+	for (const unsigned width : {2, 14, 15, 16, 17, 18, 32, 34, 320, 352}) {
+		for (const unsigned height : {2, 3, 240}) {
+			TestPicture picture(width, height);
+			EXPECT_EQ(convert_test_picture(convert, picture),
+			          reference_picture(picture))
+			        << "width " << width << ", height " << height;
+		}
+	}
+}
+
+TEST(ReelMagicPictureKernels, ConvertGolden)
+{
+	// A block of black and white pixels, and a red block
+	const std::vector<uint8_t> y  = {16, 235, 81, 81, 235, 16, 81, 81};
+	const std::vector<uint8_t> cb = {128, 90};
+	const std::vector<uint8_t> cr = {128, 240};
+
+	std::vector<uint8_t> out(4 * 4 * 2);
+	ReelMagic_ConvertYCbCrToBgrx(y.data(), 4, cb.data(), cr.data(), 2, 4, 2,
+	                             out.data(), 16);
+
+	const std::vector<uint8_t> expected = {0,   0,   0,   0, 254, 254, 254, 0,
+	                                       0,   0,   253, 0, 0,   0,   253, 0,
+	                                       254, 254, 254, 0, 0,   0,   0,   0,
+	                                       0,   0,   253, 0, 0,   0,   253, 0};
+	EXPECT_EQ(out, expected);
+}
+
+TEST(ReelMagicPictureKernels, ConvertMatchesReference)
+{
+	expect_conversion(convert_scalar);
+#if PICTURE_KERNELS_SSE2
+	expect_conversion(convert_sse2);
+#endif
+#if PICTURE_KERNELS_NEON
+	expect_conversion(convert_neon);
+#endif
+}
+
+TEST(ReelMagicPictureKernels, ConvertLeavesOddEdgesUntouched)
+{
+	TestPicture picture(17, 3);
+
+	constexpr uint8_t Untouched = 0xa5;
+	std::vector<uint8_t> out(17 * 4 * 3, Untouched);
+	ReelMagic_ConvertYCbCrToBgrx(picture.y.data(), picture.frame.y.width,
+	                             picture.cb.data(), picture.cr.data(),
+	                             picture.frame.cb.width, 17, 3, out.data(), 17 * 4);
+
+	for (size_t i = 0; i < 4; ++i) {
+		EXPECT_EQ(out[16 * 4 + i], Untouched);
+		EXPECT_EQ(out[17 * 4 + 16 * 4 + i], Untouched);
+	}
+	for (size_t i = 2 * 17 * 4; i < out.size(); ++i) {
+		EXPECT_EQ(out[i], Untouched) << "byte " << i;
+	}
+}
+
+// VGA pixels with black ones in every position of the vectors, and with
+// garbage in the X bytes
+std::vector<uint32_t> make_vga_line(const size_t num_pixels)
+{
+	std::vector<uint32_t> line(num_pixels);
+	uint32_t state = 12345;
+	for (auto& pixel : line) {
+		state = state * 1103515245 + 12345;
+		pixel = (state >> 8) % 3 == 0 ? (state & 0xff000000) : state;
+	}
+	return line;
+}
+
+std::vector<uint32_t> make_picture_line(const size_t num_pixels)
+{
+	std::vector<uint32_t> line(num_pixels);
+	for (size_t i = 0; i < line.size(); ++i) {
+		line[i] = static_cast<uint32_t>(i * 0x030507 + 1) & RgbMask;
+	}
+	return line;
+}
+
+using mix_f = void (*)(const uint32_t*, const uint32_t*, size_t, uint32_t*);
+
+void expect_mixing(const mix_f mix)
+{
+	for (const size_t num_pixels : {1, 3, 4, 5, 8, 9, 320, 323}) {
+		const auto vga     = make_vga_line(num_pixels);
+		const auto picture = make_picture_line(num_pixels);
+
+		// One pixel more than needed to check for overruns
+		std::vector<uint32_t> out(num_pixels + 1, 0xdeadbeef);
+		mix(vga.data(), picture.data(), num_pixels, out.data());
+
+		for (size_t i = 0; i < num_pixels; ++i) {
+			const auto rgb = vga[i] & RgbMask;
+			ASSERT_EQ(out[i], rgb ? rgb : picture[i])
+			        << "num_pixels " << num_pixels << ", pixel " << i;
+		}
+		EXPECT_EQ(out.back(), 0xdeadbeef) << "num_pixels " << num_pixels;
+	}
+}
+
+TEST(ReelMagicPictureKernels, MixLineOverPicture)
+{
+	expect_mixing(ReelMagic_MixLineOverPicture);
+	expect_mixing(mix_scalar);
+}
+
+using double_f = void (*)(const uint32_t*, size_t, uint32_t*);
+
+void expect_doubling(const double_f double_line)
+{
+	for (const size_t num_pixels : {1, 2, 7, 8, 9, 15, 16, 17, 640, 641}) {
+		const auto picture = make_picture_line((num_pixels + 1) / 2);
+
+		std::vector<uint32_t> out(num_pixels + 1, 0xdeadbeef);
+		double_line(picture.data(), num_pixels, out.data());
+
+		for (size_t i = 0; i < num_pixels; ++i) {
+			ASSERT_EQ(out[i], picture[i / 2])
+			        << "num_pixels " << num_pixels << ", pixel " << i;
+		}
+		EXPECT_EQ(out.back(), 0xdeadbeef) << "num_pixels " << num_pixels;
+	}
+}
+
+TEST(ReelMagicPictureKernels, DoublePictureLine)
+{
+	expect_doubling(ReelMagic_DoublePictureLine);
+	expect_doubling(double_scalar);
+}
+
+} // namespace
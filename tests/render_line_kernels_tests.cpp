@@ -0,0 +1,122 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/gui/render_line_kernels.cpp"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// The scalers' little-endian PMAKE conversions the kernels have to match
+uint32_t reference_15_to_32(const uint32_t v)
+{
+	const auto r = (v >> 10) & 31;
+	const auto g = (v >> 5) & 31;
+	const auto b = v & 31;
+	return (((r << 3) | (r >> 2)) << 16) | (((g << 3) | (g >> 2)) << 8) |
+	       ((b << 3) | (b >> 2));
+}
+
+uint32_t reference_16_to_32(const uint32_t v)
+{
+	const auto r = (v >> 11) & 31;
+	const auto g = (v >> 5) & 63;
+	const auto b = v & 31;
+	return (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) |
+	       ((b << 3) | (b >> 2));
+}
+
+using convert_f = void (*)(const uint16_t*, size_t, uint32_t*);
+
+void expect_conversion(const convert_f convert, uint32_t (*reference)(uint32_t),
+                       const bool doubled)
+{
+	const auto mul = doubled ? 2 : 1;
+
+	// Every 16-bit value, at lengths around the vector widths
+	std::vector<uint16_t> src(65536);
+	for (size_t i = 0; i < src.size(); ++i) {
+		src[i] = static_cast<uint16_t>(i);
+	}
+	for (const size_t num_pixels : {1, 7, 8, 9, 15, 16, 17, 65535, 65536}) {
+		// One pixel more than needed to check for overruns
+		std::vector<uint32_t> out(num_pixels * mul + 1, 0xdeadbeef);
+		convert(src.data() + (src.size() - num_pixels), num_pixels, out.data());
+
+		for (size_t i = 0; i < num_pixels * mul; ++i) {
+			const uint16_t value = src[src.size() - num_pixels + i / mul];
+			ASSERT_EQ(out[i], reference(value))
+			        << "num_pixels " << num_pixels << ", value " << value;
+		}
+		EXPECT_EQ(out.back(), 0xdeadbeef) << "num_pixels " << num_pixels;
+	}
+}
+
+TEST(RenderLineKernels, Convert15To32)
+{
+	expect_conversion(RENDER_Convert15To32, reference_15_to_32, false);
+	expect_conversion(RENDER_Convert15To32Doubled, reference_15_to_32, true);
+}
+
+TEST(RenderLineKernels, Convert16To32)
+{
+	expect_conversion(RENDER_Convert16To32, reference_16_to_32, false);
+	expect_conversion(RENDER_Convert16To32Doubled, reference_16_to_32, true);
+}
+
+TEST(RenderLineKernels, ScalarMatchesReference)
+{
+	expect_conversion(convert_scalar<Rgb555, false>, reference_15_to_32, false);
+	expect_conversion(convert_scalar<Rgb565, true>, reference_16_to_32, true);
+}
+
+// The dispatch only picks one of the x86 kernels, so test both directly
+#if RENDER_KERNELS_SSE2
+TEST(RenderLineKernels, Sse2MatchesReference)
+{
+	expect_conversion(convert_sse2<Rgb555, false>, reference_15_to_32, false);
+	expect_conversion(convert_sse2<Rgb555, true>, reference_15_to_32, true);
+	expect_conversion(convert_sse2<Rgb565, false>, reference_16_to_32, false);
+	expect_conversion(convert_sse2<Rgb565, true>, reference_16_to_32, true);
+}
+#endif
+
+TEST(RenderLineKernels, Convert8To32)
+{
+	std::vector<uint32_t> lut(256);
+	for (size_t i = 0; i < lut.size(); ++i) {
+		lut[i] = static_cast<uint32_t>(i * 0x010305);
+	}
+	const std::vector<uint8_t> src = {0, 1, 254, 255};
+
+	std::vector<uint32_t> out(src.size());
+	RENDER_Convert8To32(src.data(), src.size(), lut.data(), out.data());
+	EXPECT_EQ(out, (std::vector<uint32_t>{lut[0], lut[1], lut[254], lut[255]}));
+
+	std::vector<uint32_t> out_doubled(src.size() * 2);
+	RENDER_Convert8To32Doubled(src.data(), src.size(), lut.data(), out_doubled.data());
+	EXPECT_EQ(out_doubled,
+	          (std::vector<uint32_t>{lut[0], lut[0], lut[1], lut[1],
+	                                 lut[254], lut[254], lut[255], lut[255]}));
+}
+
+} // namespace
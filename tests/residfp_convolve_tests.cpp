@@ -0,0 +1,70 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/libs/residfp/resample/SincResampler.cpp"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// The scalar convolution the vectorised ones have to match
+int reference_convolve(const short* a, const short* b, const int length)
+{
+	int out = 0;
+	for (int i = 0; i < length; ++i) {
+		out += a[i] * b[i];
+	}
+	return (out + (1 << 14)) >> 15;
+}
+
+// Signed samples of 'bits' bits, small enough for the sums not to overflow
+std::vector<short> make_samples(const size_t size, uint32_t state, const int bits)
+{
+	std::vector<short> samples(size);
+	for (auto& sample : samples) {
+		state = state * 1103515245 + 12345;
+		sample = static_cast<short>(static_cast<int32_t>(state) >> (32 - bits));
+	}
+	return samples;
+}
+
+TEST(ResidfpConvolve, MatchesReference)
+{
+	const auto a = make_samples(1024, 1, 12);
+	const auto b = make_samples(1024, 2, 11);
+
+	// Lengths around the vector widths, at every alignment of either buffer
+	for (const int length : {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 100, 999}) {
+		for (int offset_a = 0; offset_a < 8; ++offset_a) {
+			for (int offset_b = 0; offset_b < 8; ++offset_b) {
+				const auto pa = a.data() + offset_a;
+				const auto pb = b.data() + offset_b;
+				ASSERT_EQ(reSIDfp::convolve(pa, pb, length),
+				          reference_convolve(pa, pb, length))
+				        << "length " << length << ", offsets "
+				        << offset_a << " and " << offset_b;
+			}
+		}
+	}
+}
+
+} // namespace
@@ -19,6 +19,8 @@
  */
 
 #include <cstdio>
+#include <thread>
+#include <vector>
 
 #include "ring_buffer.h"
 
@@ -166,3 +168,111 @@ TEST(RingBuffer, iterator_inequality)
 	EXPECT_TRUE(it != buf.begin());
 	EXPECT_FALSE((it - 1) != buf.begin());
 }
+
+TEST(SpscRingBuffer, push_and_pop)
+{
+	SpscRingBuffer<int, BufSize> queue = {};
+
+	const int items[] = {1, 2, 3};
+	EXPECT_EQ(queue.Push(items, 3), 3u);
+	EXPECT_EQ(queue.Size(), 3u);
+
+	int popped[4] = {};
+	EXPECT_EQ(queue.Pop(popped, 4), 3u);
+	EXPECT_EQ(popped[0], 1);
+	EXPECT_EQ(popped[1], 2);
+	EXPECT_EQ(popped[2], 3);
+	EXPECT_EQ(queue.Size(), 0u);
+}
+
+TEST(SpscRingBuffer, full_and_empty)
+{
+	SpscRingBuffer<int, BufSize> queue = {};
+
+	std::vector<int> items(BufSize + 5);
+	for (size_t i = 0; i < items.size(); ++i) {
+		items[i] = static_cast<int>(i);
+	}
+
+	// Pushes only as many items as fit
+	EXPECT_EQ(queue.Push(items.data(), items.size()), BufSize);
+	EXPECT_EQ(queue.Push(items.data(), 1), 0u);
+
+	std::vector<int> popped(items.size());
+	EXPECT_EQ(queue.Pop(popped.data(), popped.size()), BufSize);
+	EXPECT_EQ(queue.Pop(popped.data(), 1), 0u);
+
+	for (size_t i = 0; i < BufSize; ++i) {
+		EXPECT_EQ(popped[i], items[i]);
+	}
+}
+
+TEST(SpscRingBuffer, wraparound)
+{
+	SpscRingBuffer<int, BufSize> queue = {};
+
+	// Keeps the queue partly filled while the indexes wrap several times
+	auto next_push = 0;
+	auto next_pop  = 0;
+	for (auto round = 0; round < BufSize * 3; ++round) {
+		const int items[] = {next_push, next_push + 1, next_push + 2};
+		const auto num_pushed = round < 3 ? 3u : 2u;
+		ASSERT_EQ(queue.Push(items, num_pushed), num_pushed);
+		next_push += static_cast<int>(num_pushed);
+
+		int popped[2] = {};
+		ASSERT_EQ(queue.Pop(popped, 2), 2u);
+		ASSERT_EQ(popped[0], next_pop++);
+		ASSERT_EQ(popped[1], next_pop++);
+	}
+	EXPECT_EQ(queue.Size(), 3u);
+}
+
+TEST(SpscRingBuffer, clear)
+{
+	SpscRingBuffer<int, BufSize> queue = {};
+
+	const int items[] = {1, 2, 3};
+	queue.Push(items, 3);
+	queue.Clear();
+	EXPECT_EQ(queue.Size(), 0u);
+	EXPECT_EQ(queue.Push(items, 3), 3u);
+}
+
+TEST(SpscRingBuffer, threaded_producer_and_consumer)
+{
+	SpscRingBuffer<int, BufSize> queue = {};
+
+	constexpr auto NumItems = 100000;
+
+	std::thread producer([&queue] {
+		auto next = 0;
+		while (next < NumItems) {
+			const int items[] = {next, next + 1, next + 2};
+			const auto num_items = std::min(3, NumItems - next);
+			const auto num_pushed = queue.Push(items, num_items);
+			next += static_cast<int>(num_pushed);
+
+			// Let the consumer run on hosts with a single core
+			if (num_pushed == 0) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	// Every item arrives once, in order
+	auto expected = 0;
+	while (expected < NumItems) {
+		int popped[5] = {};
+		const auto num_popped = queue.Pop(popped, 5);
+		for (size_t i = 0; i < num_popped; ++i) {
+			ASSERT_EQ(popped[i], expected++);
+		}
+		if (num_popped == 0) {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+
+	EXPECT_EQ(queue.Size(), 0u);
+}
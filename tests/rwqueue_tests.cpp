@@ -24,6 +24,7 @@
 #include <gmock/gmock.h>
 
 
+#include <chrono>
 #include <thread>
 #include <tuple>
 #include <vector>
@@ -114,17 +115,73 @@ TEST(RWQueue, TrivialCopyAsync)
 
 TEST(RWQueue, TrivialMoveAsync)
 {
-	const size_t max_depth = 8;
-	RWQueue<int> q(max_depth);
+	for (const auto mode : {RWQueueMode::Locking, RWQueueMode::LockFree}) {
+		const size_t max_depth = 8;
+		RWQueue<int> q(max_depth, mode);
 
-	std::thread writer(rw_produce_move_trivial, &q, &max_depth);
-	std::thread reader(rw_consume_trivial, &q, &max_depth);
+		std::thread writer(rw_produce_move_trivial, &q, &max_depth);
+		std::thread reader(rw_consume_trivial, &q, &max_depth);
 
-	writer.join();
-	reader.join();
+		writer.join();
+		reader.join();
 
-	// Make sure we've consumed all produced items and the queue is empty
-	EXPECT_EQ(q.Size(), 0);
+		// Make sure we've consumed all produced items and the queue is
+		// empty
+		EXPECT_EQ(q.Size(), 0);
+	}
+}
+
+TEST(RWQueue, LockFreeSerial)
+{
+	RWQueue<int> q(5, RWQueueMode::LockFree);
+
+	// Wraps around the ring several times
+	for (int i = 0; i != 23; ++i) {
+		EXPECT_TRUE(q.Enqueue(std::move(i)));
+		EXPECT_TRUE(q.Enqueue(i + 100));
+		EXPECT_EQ(q.Size(), 2);
+
+		EXPECT_EQ(*q.Dequeue(), i);
+		EXPECT_EQ(*q.Dequeue(), i + 100);
+		EXPECT_TRUE(q.IsEmpty());
+	}
+
+	std::vector<int> items = {1, 2, 3, 4};
+	EXPECT_TRUE(q.BulkEnqueue(items, items.size()));
+	EXPECT_EQ(q.Size(), 4);
+	EXPECT_FLOAT_EQ(q.GetPercentFull(), 80.0f);
+
+	q.Clear();
+	EXPECT_TRUE(q.IsEmpty());
+}
+
+TEST(RWQueue, LockFreeDrainsAfterStop)
+{
+	RWQueue<int> q(8, RWQueueMode::LockFree);
+
+	std::vector<int> items = {1, 2, 3};
+	q.BulkEnqueue(items, items.size());
+	q.Stop();
+
+	// Enqueueing fails, but the queued items can still be dequeued
+	EXPECT_FALSE(q.Enqueue(4));
+
+	q.BulkDequeue(items, 5);
+	EXPECT_EQ(items, (std::vector<int>{1, 2, 3}));
+
+	EXPECT_FALSE(q.Dequeue().has_value());
+	EXPECT_FALSE(q.BulkDequeue(items, 2));
+}
+
+TEST(RWQueue, LockFreeStopWakesConsumer)
+{
+	RWQueue<int> q(8, RWQueueMode::LockFree);
+
+	std::thread reader([&q] { EXPECT_FALSE(q.Dequeue().has_value()); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	q.Stop();
+	reader.join();
 }
 
 void bulk_enqueue(RWQueue<int>& q, const size_t total_to_enqueue,
@@ -190,16 +247,25 @@ void run_bulk_async_test(const size_t queue_capacity,
 	assert(total_to_queue >= num_per_bulk_enqueue);
 	assert(total_to_queue >= num_per_bulk_dequeue);
 
-	RWQueue<int> q(queue_capacity);
+	for (const auto mode : {RWQueueMode::Locking, RWQueueMode::LockFree}) {
+		RWQueue<int> q(queue_capacity, mode);
 
-	std::thread writer(bulk_enqueue, std::ref(q), total_to_queue, num_per_bulk_enqueue);
-	std::thread reader(bulk_dequeue, std::ref(q), total_to_queue, num_per_bulk_dequeue);
+		std::thread writer(bulk_enqueue,
+		                   std::ref(q),
+		                   total_to_queue,
+		                   num_per_bulk_enqueue);
+		std::thread reader(bulk_dequeue,
+		                   std::ref(q),
+		                   total_to_queue,
+		                   num_per_bulk_dequeue);
 
-	writer.join();
-	reader.join();
+		writer.join();
+		reader.join();
 
-	// Make sure we've consumed all produced items and the queue is empty
-	EXPECT_EQ(static_cast<int>(q.Size()), 0);
+		// Make sure we've consumed all produced items and the queue is
+		// empty
+		EXPECT_EQ(static_cast<int>(q.Size()), 0);
+	}
 }
 
 using bulk_params_t = typename std::tuple<size_t, size_t, size_t, size_t>;
@@ -0,0 +1,244 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "savestate.h"
+
+#include <array>
+#include <fstream>
+#include <numeric>
+
+#include <gtest/gtest.h>
+
+#include "worker_pool.h"
+
+namespace {
+
+class SaveStateTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		std::iota(region.begin(), region.end(), uint8_t(0));
+
+		SAVESTATE_AddComponent(
+		        "component",
+		        [this](std::vector<uint8_t>& data) {
+			        data.assign(component.begin(), component.end());
+		        },
+		        [this](const std::vector<uint8_t>& data) {
+			        return data.size() == component.size();
+		        },
+		        [this](const std::vector<uint8_t>& data) {
+			        std::copy(data.begin(), data.end(), component.begin());
+		        });
+		SAVESTATE_AddMemoryRegion("region", region.data(), region.size());
+	}
+
+	void TearDown() override
+	{
+		// Stops the worker threads the rewind captures started
+		WORKERS_SetNumThreads(0);
+
+		SAVESTATE_SetRewindDepth(0);
+		SAVESTATE_Remove("component");
+		SAVESTATE_Remove("region");
+		std_fs::remove(file);
+	}
+
+	const std_fs::path file = std_fs::temp_directory_path() /
+	                          "dosbox_savestate_test.bin";
+
+	std::array<uint8_t, 3> component = {1, 2, 3};
+	std::array<uint8_t, 8192> region = {};
+};
+
+TEST_F(SaveStateTest, RoundTrip)
+{
+	ASSERT_TRUE(SAVESTATE_Save(file));
+
+	// modifications after the save don't end up in the state
+	component = {4, 5, 6};
+	region.fill(0xff);
+
+	ASSERT_TRUE(SAVESTATE_WaitForSave());
+	ASSERT_TRUE(SAVESTATE_Load(file));
+
+	EXPECT_EQ(component, (std::array<uint8_t, 3>{1, 2, 3}));
+	for (size_t i = 0; i < region.size(); ++i) {
+		ASSERT_EQ(region[i], static_cast<uint8_t>(i));
+	}
+}
+
+TEST_F(SaveStateTest, MissingFile)
+{
+	EXPECT_FALSE(SAVESTATE_Load(file));
+	EXPECT_EQ(component, (std::array<uint8_t, 3>{1, 2, 3}));
+}
+
+TEST_F(SaveStateTest, InvalidFile)
+{
+	std::ofstream(file) << "not a save state";
+
+	EXPECT_FALSE(SAVESTATE_Load(file));
+	EXPECT_EQ(component, (std::array<uint8_t, 3>{1, 2, 3}));
+}
+
+TEST_F(SaveStateTest, TruncatedFileLeavesStateUntouched)
+{
+	ASSERT_TRUE(SAVESTATE_Save(file));
+	ASSERT_TRUE(SAVESTATE_WaitForSave());
+	std_fs::resize_file(file, std_fs::file_size(file) - 1);
+
+	component = {4, 5, 6};
+	EXPECT_FALSE(SAVESTATE_Load(file));
+	EXPECT_EQ(component, (std::array<uint8_t, 3>{4, 5, 6}));
+}
+
+TEST_F(SaveStateTest, RegionSizeMismatch)
+{
+	ASSERT_TRUE(SAVESTATE_Save(file));
+	ASSERT_TRUE(SAVESTATE_WaitForSave());
+
+	SAVESTATE_AddMemoryRegion("region", region.data(), region.size() / 2);
+	component = {4, 5, 6};
+	EXPECT_FALSE(SAVESTATE_Load(file));
+
+	// nothing gets loaded if any of the records doesn't fit
+	EXPECT_EQ(component, (std::array<uint8_t, 3>{4, 5, 6}));
+}
+
+TEST_F(SaveStateTest, RefusedComponentLeavesStateUntouched)
+{
+	// registered after the region, so it's checked after the region would
+	// have been loaded already if loading didn't check everything first
+	bool refuse = false;
+	SAVESTATE_AddComponent(
+	        "refusing",
+	        [](std::vector<uint8_t>& data) { data.clear(); },
+	        [&](const std::vector<uint8_t>&) { return !refuse; },
+	        [](const std::vector<uint8_t>&) {});
+
+	ASSERT_TRUE(SAVESTATE_Save(file));
+	ASSERT_TRUE(SAVESTATE_WaitForSave());
+
+	refuse = true;
+	region.fill(0xff);
+	EXPECT_FALSE(SAVESTATE_Load(file));
+	SAVESTATE_Remove("refusing");
+
+	for (const auto value : region) {
+		ASSERT_EQ(value, 0xff);
+	}
+}
+
+TEST_F(SaveStateTest, RewindStepsBackThroughSnapshots)
+{
+	SAVESTATE_SetRewindDepth(10);
+	SAVESTATE_CaptureRewindPoint();
+
+	// Sparse changes, a whole page, and the last bytes of the region
+	component = {4, 5, 6};
+	region[10] = 0xaa;
+	region[11] = 0xbb;
+	std::fill(region.begin() + 4096, region.begin() + 8192, uint8_t(0x5a));
+	SAVESTATE_CaptureRewindPoint();
+
+	component = {7, 8, 9};
+	region[10]   = 0;
+	region[8191] = 0;
+	SAVESTATE_CaptureRewindPoint();
+
+	component = {0, 0, 0};
+	region.fill(0x11);
+
+	ASSERT_TRUE(SAVESTATE_Rewind());
+	EXPECT_EQ(component, (std::array<uint8_t, 3>{7, 8, 9}));
+	EXPECT_EQ(region[10], 0);
+	EXPECT_EQ(region[11], 0xbb);
+	EXPECT_EQ(region[8190], 0x5a);
+	EXPECT_EQ(region[8191], 0);
+
+	ASSERT_TRUE(SAVESTATE_Rewind());
+	EXPECT_EQ(component, (std::array<uint8_t, 3>{4, 5, 6}));
+	EXPECT_EQ(region[10], 0xaa);
+	EXPECT_EQ(region[8191], 0x5a);
+
+	ASSERT_TRUE(SAVESTATE_Rewind());
+	EXPECT_EQ(component, (std::array<uint8_t, 3>{1, 2, 3}));
+	for (size_t i = 0; i < region.size(); ++i) {
+		ASSERT_EQ(region[i], static_cast<uint8_t>(i));
+	}
+
+	EXPECT_FALSE(SAVESTATE_Rewind());
+}
+
+TEST_F(SaveStateTest, RewindDropsTheOldestSnapshots)
+{
+	SAVESTATE_SetRewindDepth(2);
+	for (uint8_t value = 1; value <= 4; ++value) {
+		region[0] = value;
+		SAVESTATE_CaptureRewindPoint();
+	}
+
+	ASSERT_TRUE(SAVESTATE_Rewind());
+	EXPECT_EQ(region[0], 4);
+	ASSERT_TRUE(SAVESTATE_Rewind());
+	EXPECT_EQ(region[0], 3);
+	EXPECT_FALSE(SAVESTATE_Rewind());
+}
+
+TEST_F(SaveStateTest, RewindRefusedComponentLeavesStateUntouched)
+{
+	bool refuse = false;
+	SAVESTATE_AddComponent(
+	        "refusing",
+	        [](std::vector<uint8_t>& data) { data.clear(); },
+	        [&](const std::vector<uint8_t>&) { return !refuse; },
+	        [](const std::vector<uint8_t>&) {});
+
+	SAVESTATE_SetRewindDepth(10);
+	SAVESTATE_CaptureRewindPoint();
+
+	component = {4, 5, 6};
+	region.fill(0xff);
+
+	refuse = true;
+	EXPECT_FALSE(SAVESTATE_Rewind());
+	EXPECT_EQ(component, (std::array<uint8_t, 3>{4, 5, 6}));
+	EXPECT_EQ(region[0], 0xff);
+
+	// the snapshot is kept for another try
+	refuse = false;
+	ASSERT_TRUE(SAVESTATE_Rewind());
+	EXPECT_EQ(component, (std::array<uint8_t, 3>{1, 2, 3}));
+	EXPECT_EQ(region[1], 1);
+
+	SAVESTATE_Remove("refusing");
+}
+
+TEST_F(SaveStateTest, RewindForgetsSnapshotsOnReregistration)
+{
+	SAVESTATE_SetRewindDepth(10);
+	SAVESTATE_CaptureRewindPoint();
+
+	SAVESTATE_AddMemoryRegion("region", region.data(), region.size() / 2);
+	EXPECT_FALSE(SAVESTATE_Rewind());
+}
+
+} // namespace
@@ -0,0 +1,187 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/dos/sector_cache.cpp"
+
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr size_t SectorSize = 512;
+
+using Sector = std::vector<uint8_t>;
+
+Sector make_sector(const uint8_t value)
+{
+	return Sector(SectorSize, value);
+}
+
+// Records the write-backs of a cache under test
+class SectorCacheTest : public ::testing::Test {
+protected:
+	SectorCache make_cache(const size_t max_sectors)
+	{
+		return SectorCache(max_sectors,
+		                   SectorSize,
+		                   [this](const uint32_t sectnum, const uint8_t* data) {
+			                   written.emplace_back(sectnum, data[0]);
+		                   });
+	}
+
+	std::vector<std::pair<uint32_t, uint8_t>> written = {};
+};
+
+TEST_F(SectorCacheTest, ReadMissAndHit)
+{
+	auto cache = make_cache(4);
+
+	Sector out = make_sector(0);
+	EXPECT_FALSE(cache.Read(7, out.data()));
+
+	cache.Insert(7, make_sector(0x42).data());
+	EXPECT_TRUE(cache.Contains(7));
+	EXPECT_TRUE(cache.Read(7, out.data()));
+	EXPECT_EQ(out, make_sector(0x42));
+
+	EXPECT_EQ(cache.GetNumCachedSectors(), 1);
+	EXPECT_EQ(cache.GetNumDirtySectors(), 0);
+	EXPECT_TRUE(written.empty());
+}
+
+TEST_F(SectorCacheTest, WritesAreDeferred)
+{
+	auto cache = make_cache(4);
+
+	cache.Write(3, make_sector(0x11).data());
+	EXPECT_TRUE(written.empty());
+	EXPECT_EQ(cache.GetNumDirtySectors(), 1);
+
+	Sector out = make_sector(0);
+	EXPECT_TRUE(cache.Read(3, out.data()));
+	EXPECT_EQ(out, make_sector(0x11));
+}
+
+TEST_F(SectorCacheTest, EvictsLeastRecentlyUsed)
+{
+	auto cache = make_cache(2);
+
+	cache.Write(1, make_sector(0x01).data());
+	cache.Insert(2, make_sector(0x02).data());
+
+	// Touching sector 1 leaves the clean sector 2 as the oldest
+	Sector out = make_sector(0);
+	EXPECT_TRUE(cache.Read(1, out.data()));
+	cache.Insert(3, make_sector(0x03).data());
+	EXPECT_TRUE(cache.Contains(1));
+	EXPECT_FALSE(cache.Contains(2));
+	EXPECT_TRUE(written.empty());
+
+	// Evicting the dirty sector 1 writes it back
+	cache.Insert(4, make_sector(0x04).data());
+	EXPECT_FALSE(cache.Contains(1));
+	ASSERT_EQ(written.size(), 1);
+	EXPECT_EQ(written[0], std::make_pair(1u, uint8_t{0x01}));
+	EXPECT_EQ(cache.GetNumCachedSectors(), 2);
+}
+
+TEST_F(SectorCacheTest, FlushWritesInSectorOrder)
+{
+	auto cache = make_cache(8);
+
+	cache.Write(9, make_sector(0x09).data());
+	cache.Write(2, make_sector(0x02).data());
+	cache.Insert(4, make_sector(0x04).data());
+	cache.Write(5, make_sector(0x05).data());
+
+	cache.Flush();
+	const std::vector<std::pair<uint32_t, uint8_t>> expected = {{2, 0x02},
+	                                                            {5, 0x05},
+	                                                            {9, 0x09}};
+	EXPECT_EQ(written, expected);
+
+	// The flushed sectors stay cached as clean
+	EXPECT_EQ(cache.GetNumCachedSectors(), 4);
+	EXPECT_EQ(cache.GetNumDirtySectors(), 0);
+
+	cache.Flush();
+	EXPECT_EQ(written.size(), 3);
+}
+
+TEST_F(SectorCacheTest, WriteIfCached)
+{
+	auto cache = make_cache(4);
+
+	EXPECT_FALSE(cache.WriteIfCached(6, make_sector(0x66).data()));
+	EXPECT_FALSE(cache.Contains(6));
+
+	cache.Insert(6, make_sector(0x60).data());
+	EXPECT_TRUE(cache.WriteIfCached(6, make_sector(0x66).data()));
+
+	Sector out = make_sector(0);
+	EXPECT_TRUE(cache.Read(6, out.data()));
+	EXPECT_EQ(out, make_sector(0x66));
+	EXPECT_EQ(cache.GetNumDirtySectors(), 1);
+}
+
+TEST_F(SectorCacheTest, ClearWritesBackAndEmpties)
+{
+	auto cache = make_cache(4);
+
+	cache.Write(1, make_sector(0x01).data());
+	cache.Clear();
+
+	ASSERT_EQ(written.size(), 1);
+	EXPECT_EQ(cache.GetNumCachedSectors(), 0);
+	EXPECT_FALSE(cache.Contains(1));
+}
+
+TEST_F(SectorCacheTest, DisabledWritesThrough)
+{
+	auto cache = make_cache(0);
+	EXPECT_FALSE(cache.IsEnabled());
+
+	cache.Insert(1, make_sector(0x01).data());
+	EXPECT_FALSE(cache.Contains(1));
+
+	cache.Write(2, make_sector(0x02).data());
+	ASSERT_EQ(written.size(), 1);
+	EXPECT_EQ(written[0], std::make_pair(2u, uint8_t{0x02}));
+	EXPECT_EQ(cache.GetNumCachedSectors(), 0);
+}
+
+TEST(SectorCache, ReadOnlyWithoutWriteFunction)
+{
+	SectorCache cache(2, SectorSize);
+
+	cache.Insert(1, make_sector(0x01).data());
+	cache.Insert(2, make_sector(0x02).data());
+	cache.Insert(3, make_sector(0x03).data());
+	EXPECT_FALSE(cache.Contains(1));
+	EXPECT_EQ(cache.GetNumCachedSectors(), 2);
+	EXPECT_EQ(cache.GetNumDirtySectors(), 0);
+
+	cache.Clear();
+	EXPECT_EQ(cache.GetNumCachedSectors(), 0);
+}
+
+} // namespace
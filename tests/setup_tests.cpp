@@ -180,4 +180,33 @@ TEST(Value, Double)
 	EXPECT_DOUBLE_EQ(test_value, 42.0);
 }
 
+TEST(SectionProp, LookupByName)
+{
+	Section_prop section("test");
+	section.Add_int("rate", Property::Changeable::Always, 44100);
+	section.Add_bool("enabled", Property::Changeable::Always, false);
+	section.Add_string("mode", Property::Changeable::Always, "auto");
+
+	// Config files set the properties regardless of case
+	EXPECT_TRUE(section.HandleInputline("Rate = 22050"));
+	EXPECT_TRUE(section.HandleInputline("ENABLED=true"));
+	EXPECT_FALSE(section.HandleInputline("missing = 1"));
+
+	EXPECT_EQ(section.Get_int("rate"), 22050);
+	EXPECT_TRUE(section.Get_bool("enabled"));
+	EXPECT_EQ(section.Get_string("mode"), "auto");
+	EXPECT_EQ(section.GetPropValue("MODE"), "auto");
+	EXPECT_EQ(section.GetPropValue("missing"), NO_SUCH_PROPERTY);
+
+	// The getters only take the exact names
+	EXPECT_EQ(section.Get_int("RATE"), 0);
+	EXPECT_EQ(section.Get_prop("Mode"), nullptr);
+
+	// Indexes follow the order of adding
+	ASSERT_NE(section.Get_prop(2), nullptr);
+	EXPECT_EQ(section.Get_prop(2)->propname, "mode");
+	EXPECT_EQ(section.Get_prop(3), nullptr);
+	EXPECT_EQ(section.Get_prop(-1), nullptr);
+}
+
 } // namespace
@@ -0,0 +1,271 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/hardware/vga_draw_lines.cpp"
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// Every palette entry is distinct, so mixed-up nibbles can't go unnoticed
+constexpr uint8_t Palette[16] = {0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87,
+                                 0x98, 0xa9, 0xba, 0xcb, 0xdc, 0xed, 0xfe, 0x0f};
+
+// Video memory with a pattern that doesn't repeat within the vector widths
+std::vector<uint8_t> make_video_memory(const size_t size)
+{
+	std::vector<uint8_t> memory(size);
+	uint8_t value = 0x5a;
+	for (auto& byte : memory) {
+		byte = value;
+		value = static_cast<uint8_t>(value * 13 + 7);
+	}
+	return memory;
+}
+
+// The reference implementation the kernels have to match: the original
+// pixel-at-a-time VGA line handler
+std::vector<uint8_t> reference_4bpp(const std::vector<uint8_t>& memory,
+                                    Bitu start, const Bitu addr_mask,
+                                    const size_t num_bytes, const int repeats)
+{
+	std::vector<uint8_t> out = {};
+	for (size_t i = 0; i < num_bytes; ++i, ++start) {
+		const auto byte = memory[start & addr_mask];
+		out.insert(out.end(), repeats, Palette[byte >> 4]);
+		out.insert(out.end(), repeats, Palette[byte & 0x0f]);
+	}
+	return out;
+}
+
+TEST(VgaDrawLines, Expand4BppGolden)
+{
+	const std::vector<uint8_t> memory = {0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef};
+
+	std::array<uint8_t, 16> out = {};
+	VGA_Expand4BppLine(memory.data(), 0, 7, memory.size(), Palette, out.data());
+
+	const std::array<uint8_t, 16> expected = {0x10, 0x21, 0x32, 0x43,
+	                                          0x54, 0x65, 0x76, 0x87,
+	                                          0x98, 0xa9, 0xba, 0xcb,
+	                                          0xdc, 0xed, 0xfe, 0x0f};
+	EXPECT_EQ(out, expected);
+}
+
+TEST(VgaDrawLines, Expand4BppDoubledGolden)
+{
+	const std::vector<uint8_t> memory = {0x1e, 0xf0};
+
+	std::array<uint8_t, 8> out = {};
+	VGA_Expand4BppLineDoubled(memory.data(), 0, 1, memory.size(), Palette, out.data());
+
+	const std::array<uint8_t, 8> expected = {0x21, 0x21, 0xfe, 0xfe,
+	                                         0x0f, 0x0f, 0x10, 0x10};
+	EXPECT_EQ(out, expected);
+}
+
+TEST(VgaDrawLines, Expand4BppMatchesReference)
+{
+	constexpr Bitu AddrMask = 8 * 1024 - 1;
+	const auto memory       = make_video_memory(AddrMask + 1);
+
+	// Lengths around the vector widths, starting at odd addresses
+	for (const size_t num_bytes : {1, 15, 16, 17, 31, 80, 160, 333}) {
+		for (const Bitu start : {0, 3, 4093}) {
+			std::vector<uint8_t> out(num_bytes * 2);
+			VGA_Expand4BppLine(memory.data(), start, AddrMask, num_bytes, Palette, out.data());
+			EXPECT_EQ(out, reference_4bpp(memory, start, AddrMask, num_bytes, 1))
+			        << "num_bytes " << num_bytes << ", start " << start;
+
+			std::vector<uint8_t> out_doubled(num_bytes * 4);
+			VGA_Expand4BppLineDoubled(memory.data(), start, AddrMask, num_bytes, Palette, out_doubled.data());
+			EXPECT_EQ(out_doubled, reference_4bpp(memory, start, AddrMask, num_bytes, 2))
+			        << "num_bytes " << num_bytes << ", start " << start;
+		}
+	}
+}
+
+TEST(VgaDrawLines, Expand4BppWrapsAround)
+{
+	constexpr Bitu AddrMask = 8 * 1024 - 1;
+	const auto memory       = make_video_memory(AddrMask + 1);
+
+	// Starts 10 bytes before the end of the memory, and past the mask
+	for (const Bitu start : {AddrMask - 9, 3 * (AddrMask + 1) - 10}) {
+		constexpr size_t NumBytes = 80;
+
+		std::vector<uint8_t> out(NumBytes * 2);
+		VGA_Expand4BppLine(memory.data(), start, AddrMask, NumBytes, Palette, out.data());
+		EXPECT_EQ(out, reference_4bpp(memory, start, AddrMask, NumBytes, 1));
+
+		std::vector<uint8_t> out_doubled(NumBytes * 4);
+		VGA_Expand4BppLineDoubled(memory.data(), start, AddrMask, NumBytes, Palette, out_doubled.data());
+		EXPECT_EQ(out_doubled, reference_4bpp(memory, start, AddrMask, NumBytes, 2));
+	}
+}
+
+TEST(VgaDrawLines, Expand4BppUnmaskedAddress)
+{
+	const auto memory = make_video_memory(64);
+
+	std::vector<uint8_t> out(48 * 2);
+	VGA_Expand4BppLine(memory.data(), 16, ~static_cast<Bitu>(0), 48, Palette, out.data());
+	EXPECT_EQ(out, reference_4bpp(memory, 16, ~static_cast<Bitu>(0), 48, 1));
+}
+
+TEST(VgaDrawLines, PalettizeGolden)
+{
+	std::array<Bgrx8888, 256> palette_map = {};
+	for (size_t i = 0; i < palette_map.size(); ++i) {
+		palette_map[i] = Bgrx8888(static_cast<uint8_t>(i),
+		                          static_cast<uint8_t>(255 - i),
+		                          static_cast<uint8_t>(i * 3));
+	}
+	const std::array<uint8_t, 3> indexes = {0, 1, 255};
+
+	// Written one byte off to check unaligned output
+	std::array<uint8_t, 13> out = {};
+	VGA_PalettizeLine(indexes.data(), indexes.size(), palette_map.data(), out.data() + 1);
+
+	const std::array<uint8_t, 13> expected = {0x00,
+	                                          0x00, 0xff, 0x00, 0x00,
+	                                          0x01, 0xfe, 0x03, 0x00,
+	                                          0xff, 0x00, 0xfd, 0x00};
+	EXPECT_EQ(out, expected);
+}
+
+// The reference implementation of the composite decoder: the original
+// per-pixel loop, turning the chroma phase with the arguments of each call
+std::vector<uint8_t> reference_composite(const std::vector<int>& luma,
+                                         const std::vector<int>& chroma_a,
+                                         const std::vector<int>& chroma_b,
+                                         const size_t num_pixels,
+                                         const CompositeCoefficients& co)
+{
+	std::vector<uint8_t> out = {};
+
+	auto clamp = [](int v) {
+		v >>= 13;
+		return v < 0 ? 0u : (v > 255 ? 255u : static_cast<uint8_t>(v));
+	};
+
+	const int* i  = luma.data() + 1;
+	const int* ap = chroma_a.data();
+	const int* bp = chroma_b.data();
+
+	auto convert = [&](const int ii, const int q) {
+		const int c = i[0] + i[0];
+		const int d = i[-1] + i[1];
+		const int y = ((c + d) << 8) + co.sharpness * (c - d);
+
+		out.push_back(clamp(y + co.bi * ii + co.bq * q));
+		out.push_back(clamp(y + co.gi * ii + co.gq * q));
+		out.push_back(clamp(y + co.ri * ii + co.rq * q));
+		out.push_back(0);
+		++i;
+		++ap;
+		++bp;
+	};
+
+	for (size_t p = 0; p < num_pixels; ++p) {
+		switch (p & 3) {
+		case 0: convert(ap[0], bp[0]); break;
+		case 1: convert(-bp[0], ap[0]); break;
+		case 2: convert(-ap[0], -bp[0]); break;
+		default: convert(bp[0], -ap[0]); break;
+		}
+	}
+	return out;
+}
+
+TEST(VgaDrawLines, DecodeCompositeGolden)
+{
+	// Flat grey with a +1/-1 swing of the red I component
+	const std::vector<int> luma(4 + 2, 800);
+	const std::vector<int> chroma_a = {1, 1, 1, 1};
+	const std::vector<int> chroma_b = {0, 0, 0, 0};
+
+	CompositeCoefficients co = {};
+	co.ri        = 8192;
+	co.sharpness = 100;
+
+	std::array<uint8_t, 16> out = {};
+	VGA_DecodeCompositeLine(luma.data() + 1,
+	                        chroma_a.data(),
+	                        chroma_b.data(),
+	                        4,
+	                        co,
+	                        out.data());
+
+	const std::array<uint8_t, 16> expected = {100, 100, 101, 0,
+	                                          100, 100, 100, 0,
+	                                          100, 100, 99,  0,
+	                                          100, 100, 100, 0};
+	EXPECT_EQ(out, expected);
+}
+
+TEST(VgaDrawLines, DecodeCompositeMatchesReference)
+{
+	uint32_t state = 12345;
+	auto next_value = [&state](const int range) {
+		state = state * 1103515245 + 12345;
+		return static_cast<int>((state >> 8) % (2 * range + 1)) - range;
+	};
+
+	CompositeCoefficients co = {};
+	co.ri        = 2014;
+	co.rq        = 1226;
+	co.gi        = -877;
+	co.gq        = -1659;
+	co.bi        = -3417;
+	co.bq        = 1050;
+	co.sharpness = 256;
+
+	// Lengths around the vector widths, with values that get clamped on
+	// both ends
+	for (const size_t num_pixels : {1, 3, 4, 5, 8, 11, 640, 643}) {
+		std::vector<int> luma(num_pixels + 2);
+		std::vector<int> chroma_a(num_pixels);
+		std::vector<int> chroma_b(num_pixels);
+		for (auto& v : luma) {
+			v = next_value(16000);
+		}
+		for (size_t p = 0; p < num_pixels; ++p) {
+			chroma_a[p] = next_value(4000);
+			chroma_b[p] = next_value(4000);
+		}
+
+		std::vector<uint8_t> out(num_pixels * 4);
+		VGA_DecodeCompositeLine(luma.data() + 1,
+		                        chroma_a.data(),
+		                        chroma_b.data(),
+		                        num_pixels,
+		                        co,
+		                        out.data());
+		EXPECT_EQ(out, reference_composite(luma, chroma_a, chroma_b, num_pixels, co))
+		        << "num_pixels " << num_pixels;
+	}
+}
+
+} // namespace
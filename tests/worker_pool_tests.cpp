@@ -0,0 +1,145 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "worker_pool.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+class WorkerPool : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		WORKERS_SetNumThreads(4);
+	}
+
+	void TearDown() override
+	{
+		// Stops the threads
+		WORKERS_SetNumThreads(0);
+	}
+};
+
+TEST_F(WorkerPool, RunsSubmittedTasks)
+{
+	constexpr auto NumTasks = 1000;
+
+	std::atomic_int num_run = 0;
+	for (auto i = 0; i < NumTasks; ++i) {
+		WORKERS_Submit([&num_run] { ++num_run; });
+	}
+
+	// Stopping the pool finishes the queued tasks
+	WORKERS_SetNumThreads(4);
+	EXPECT_EQ(num_run, NumTasks);
+}
+
+TEST_F(WorkerPool, RunsTasksSubmittedByTasks)
+{
+	std::atomic_int num_run = 0;
+	for (auto i = 0; i < 100; ++i) {
+		WORKERS_Submit([&num_run] {
+			for (auto j = 0; j < 10; ++j) {
+				WORKERS_Submit([&num_run] { ++num_run; });
+			}
+		});
+	}
+	WORKERS_SetNumThreads(4);
+	EXPECT_EQ(num_run, 1000);
+}
+
+TEST_F(WorkerPool, ExitJoinsRunningThreads)
+{
+	// Leaving the threads running would terminate the process when the
+	// pool gets destroyed
+	EXPECT_EXIT(
+	        {
+		        WORKERS_Submit([] {});
+		        std::exit(0);
+	        },
+	        ::testing::ExitedWithCode(0),
+	        "");
+}
+
+TEST_F(WorkerPool, ParallelForCallsEveryIndexOnce)
+{
+	for (const auto num_items : {0, 1, 2, 5, 100, 1000}) {
+		std::vector<std::atomic_int> calls(num_items);
+
+		WORKERS_ParallelFor(num_items, 4, [&calls](const int index, int) {
+			++calls[index];
+		});
+		for (auto i = 0; i < num_items; ++i) {
+			EXPECT_EQ(calls[i], 1) << "num_items " << num_items;
+		}
+	}
+}
+
+TEST_F(WorkerPool, ParallelForParticipants)
+{
+	constexpr auto MaxHelpers = 2;
+
+	std::mutex mutex                  = {};
+	std::set<int> participants        = {};
+	std::set<std::thread::id> threads = {};
+
+	WORKERS_ParallelFor(1000, MaxHelpers, [&](int, const int participant) {
+		std::lock_guard<std::mutex> lock(mutex);
+		participants.insert(participant);
+		threads.insert(std::this_thread::get_id());
+	});
+
+	// Every thread taking part has its own participant index
+	EXPECT_GE(*participants.begin(), 0);
+	EXPECT_LE(*participants.rbegin(), MaxHelpers);
+	EXPECT_EQ(participants.size(), threads.size());
+}
+
+TEST_F(WorkerPool, ParallelForWithoutHelpers)
+{
+	std::set<std::thread::id> threads = {};
+
+	WORKERS_ParallelFor(100, 0, [&threads](int, const int participant) {
+		EXPECT_EQ(participant, 0);
+		threads.insert(std::this_thread::get_id());
+	});
+	EXPECT_EQ(threads.size(), 1);
+	EXPECT_EQ(threads.count(std::this_thread::get_id()), 1);
+}
+
+TEST_F(WorkerPool, NestedParallelFor)
+{
+	std::atomic_int num_calls = 0;
+
+	WORKERS_ParallelFor(8, 4, [&num_calls](int, int) {
+		WORKERS_ParallelFor(100, 4, [&num_calls](int, int) { ++num_calls; });
+	});
+	EXPECT_EQ(num_calls, 800);
+}
+
+} // namespace
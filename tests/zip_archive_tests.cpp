@@ -0,0 +1,404 @@
+/*
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *  Copyright (C) 2024-2024  The DOSBox Staging Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "../src/dos/zip_archive.cpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#if defined(C_SYSTEM_ZLIB_NG)
+#define deflateInit2 zng_deflateInit2
+#define deflateBound zng_deflateBound
+#define deflate zng_deflate
+#define deflateEnd zng_deflateEnd
+#define crc32 zng_crc32
+#endif
+
+namespace {
+
+void put_le(std::vector<uint8_t>& out, const uint64_t value, const int num_bytes)
+{
+	for (int i = 0; i < num_bytes; ++i) {
+		out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+	}
+}
+
+std::vector<uint8_t> deflate_raw(const std::vector<uint8_t>& data)
+{
+	z_stream stream = {};
+	deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8,
+	             Z_DEFAULT_STRATEGY);
+	std::vector<uint8_t> out(deflateBound(&stream, data.size()));
+	stream.next_in   = const_cast<uint8_t*>(data.data());
+	stream.avail_in  = static_cast<decltype(stream.avail_in)>(data.size());
+	stream.next_out  = out.data();
+	stream.avail_out = static_cast<decltype(stream.avail_out)>(out.size());
+	deflate(&stream, Z_FINISH);
+	out.resize(stream.total_out);
+	deflateEnd(&stream);
+	return out;
+}
+
+// Compressible data that doesn't repeat within the blocks
+std::vector<uint8_t> make_data(const size_t num_bytes)
+{
+	std::vector<uint8_t> data(num_bytes);
+	uint32_t state = 12345;
+	for (auto& byte : data) {
+		state = state * 1103515245 + 12345;
+		byte  = static_cast<uint8_t>('A' + (state >> 16) % 8);
+	}
+	return data;
+}
+
+struct ZipFile {
+	std::string name          = {};
+	std::vector<uint8_t> data = {};
+	bool deflated             = false;
+	uint8_t dos_attributes    = 0;
+	uint16_t flags            = 0;
+};
+
+// Writes an archive with each value that ZIP64 can extend, in ZIP64's
+// records if 'zip64' is set
+std::vector<uint8_t> make_zip(const std::vector<ZipFile>& files, const bool zip64 = false)
+{
+	std::vector<uint8_t> zip = {};
+	std::vector<uint8_t> dir = {};
+	for (const auto& file : files) {
+		const auto stored = file.deflated ? deflate_raw(file.data) : file.data;
+		const auto crc    = crc32(0, file.data.data(),
+                                       static_cast<uInt>(file.data.size()));
+		const auto offset = zip.size();
+
+		// A local extra field the central directory doesn't have
+		put_le(zip, LocalHeaderSignature, 4);
+		put_le(zip, 20, 2);
+		put_le(zip, file.flags, 2);
+		put_le(zip, file.deflated ? 8 : 0, 2);
+		put_le(zip, 0x6000, 2);
+		put_le(zip, 0x5821, 2);
+		put_le(zip, crc, 4);
+		put_le(zip, stored.size(), 4);
+		put_le(zip, file.data.size(), 4);
+		put_le(zip, file.name.size(), 2);
+		put_le(zip, 4, 2);
+		zip.insert(zip.end(), file.name.begin(), file.name.end());
+		put_le(zip, 0xcafe, 2);
+		put_le(zip, 0, 2);
+		zip.insert(zip.end(), stored.begin(), stored.end());
+
+		put_le(dir, CentralDirEntrySignature, 4);
+		put_le(dir, 20, 2);
+		put_le(dir, 20, 2);
+		put_le(dir, file.flags, 2);
+		put_le(dir, file.deflated ? 8 : 0, 2);
+		put_le(dir, 0x6000, 2);
+		put_le(dir, 0x5821, 2);
+		put_le(dir, crc, 4);
+		put_le(dir, zip64 ? UINT32_MAX : stored.size(), 4);
+		put_le(dir, zip64 ? UINT32_MAX : file.data.size(), 4);
+		put_le(dir, file.name.size(), 2);
+		put_le(dir, zip64 ? 28 : 0, 2);
+		put_le(dir, 0, 2);
+		put_le(dir, 0, 2);
+		put_le(dir, 0, 2);
+		put_le(dir, file.dos_attributes, 4);
+		put_le(dir, zip64 ? UINT32_MAX : offset, 4);
+		dir.insert(dir.end(), file.name.begin(), file.name.end());
+		if (zip64) {
+			put_le(dir, Zip64ExtraFieldId, 2);
+			put_le(dir, 24, 2);
+			put_le(dir, file.data.size(), 8);
+			put_le(dir, stored.size(), 8);
+			put_le(dir, offset, 8);
+		}
+	}
+	const auto dir_offset = zip.size();
+	zip.insert(zip.end(), dir.begin(), dir.end());
+
+	if (zip64) {
+		const auto record_offset = zip.size();
+		put_le(zip, Zip64EndOfCentralDirSignature, 4);
+		put_le(zip, Zip64EndOfCentralDirSize - 12, 8);
+		put_le(zip, 45, 2);
+		put_le(zip, 45, 2);
+		put_le(zip, 0, 4);
+		put_le(zip, 0, 4);
+		put_le(zip, files.size(), 8);
+		put_le(zip, files.size(), 8);
+		put_le(zip, dir.size(), 8);
+		put_le(zip, dir_offset, 8);
+
+		put_le(zip, Zip64EndLocatorSignature, 4);
+		put_le(zip, 0, 4);
+		put_le(zip, record_offset, 8);
+		put_le(zip, 1, 4);
+	}
+	put_le(zip, EndOfCentralDirSignature, 4);
+	put_le(zip, 0, 2);
+	put_le(zip, 0, 2);
+	put_le(zip, zip64 ? UINT16_MAX : files.size(), 2);
+	put_le(zip, zip64 ? UINT16_MAX : files.size(), 2);
+	put_le(zip, zip64 ? UINT32_MAX : dir.size(), 4);
+	put_le(zip, zip64 ? UINT32_MAX : dir_offset, 4);
+
+	// A comment, which the end of the central directory has to be found
+	// before
+	const std::string comment = "Shareware release";
+	put_le(zip, comment.size(), 2);
+	zip.insert(zip.end(), comment.begin(), comment.end());
+	return zip;
+}
+
+std::unique_ptr<ZipArchive> open_zip(const std::vector<uint8_t>& zip, std::string& error)
+{
+	FILE* file = tmpfile();
+	fwrite(zip.data(), 1, zip.size(), file);
+	return ZipArchive::Open(file, error);
+}
+
+std::vector<std::string> list_names(const ZipArchive& archive, const std::string& dir)
+{
+	std::vector<std::string> names = {};
+	if (const auto entries = archive.ListDir(dir)) {
+		for (const auto entry : *entries) {
+			names.push_back(entry->name);
+		}
+	}
+	return names;
+}
+
+std::vector<uint8_t> read_all(ZipEntryReader& reader, const size_t chunk_size)
+{
+	std::vector<uint8_t> data(reader.GetSize());
+	size_t position = 0;
+	size_t num_read = 0;
+	do {
+		const auto to_read = std::min(chunk_size, data.size() - position);
+		EXPECT_TRUE(reader.Read(position, data.data() + position, to_read, num_read));
+		position += num_read;
+	} while (num_read > 0);
+	EXPECT_EQ(position, data.size());
+	return data;
+}
+
+TEST(ZipArchive, IndexesEntries)
+{
+	const auto zip = make_zip({{"README.TXT", make_data(100)},
+	                           {"GAME/DATA/LEVEL1.DAT", make_data(200), true},
+	                           {"GAME\\SETUP.EXE", make_data(300)},
+	                           {"SAVES/", {}}});
+	std::string error  = {};
+	const auto archive = open_zip(zip, error);
+	ASSERT_TRUE(archive) << error;
+
+	// The directories without entries of their own are implied
+	EXPECT_EQ(list_names(*archive, ""),
+	          (std::vector<std::string>{"README.TXT", "SAVES", "GAME"}));
+	EXPECT_EQ(list_names(*archive, "GAME"),
+	          (std::vector<std::string>{"SETUP.EXE", "DATA"}));
+	EXPECT_EQ(list_names(*archive, "GAME/DATA"),
+	          (std::vector<std::string>{"LEVEL1.DAT"}));
+	EXPECT_EQ(list_names(*archive, "SAVES"), (std::vector<std::string>{}));
+	EXPECT_FALSE(archive->ListDir("README.TXT"));
+	EXPECT_FALSE(archive->ListDir("MISSING"));
+
+	const auto level = archive->Find("GAME/DATA/LEVEL1.DAT");
+	ASSERT_TRUE(level);
+	EXPECT_FALSE(level->is_directory);
+	EXPECT_EQ(level->size, 200);
+	EXPECT_EQ(level->dos_time, 0x6000);
+	EXPECT_EQ(level->dos_date, 0x5821);
+
+	const auto data = archive->Find("GAME/DATA");
+	ASSERT_TRUE(data);
+	EXPECT_TRUE(data->is_directory);
+	EXPECT_FALSE(archive->Find("MISSING"));
+}
+
+TEST(ZipArchive, ReadsAttributes)
+{
+	const auto zip = make_zip({{"HIDDEN.SYS", make_data(10), false, 0x02 | 0x04},
+	                           {"SUBDIR", {}, false, 0x10}});
+	std::string error  = {};
+	const auto archive = open_zip(zip, error);
+	ASSERT_TRUE(archive) << error;
+
+	EXPECT_EQ(archive->Find("HIDDEN.SYS")->dos_attributes, 0x06);
+	EXPECT_TRUE(archive->Find("SUBDIR")->is_directory);
+}
+
+TEST(ZipArchive, SkipsEscapingPaths)
+{
+	const auto zip = make_zip({{"../EVIL.EXE", make_data(10)},
+	                           {"A/../../EVIL.EXE", make_data(10)},
+	                           {"/GOOD.EXE", make_data(10)}});
+	std::string error  = {};
+	const auto archive = open_zip(zip, error);
+	ASSERT_TRUE(archive) << error;
+
+	EXPECT_EQ(list_names(*archive, ""), (std::vector<std::string>{"GOOD.EXE"}));
+	EXPECT_EQ(list_names(*archive, "A"), (std::vector<std::string>{}));
+}
+
+TEST(ZipArchive, ReadsStoredEntries)
+{
+	const auto contents = make_data(1000);
+	const auto zip      = make_zip({{"FILE.BIN", contents}});
+	std::string error   = {};
+	const auto archive  = open_zip(zip, error);
+	ASSERT_TRUE(archive) << error;
+
+	const auto reader = archive->OpenEntry(*archive->Find("FILE.BIN"));
+	ASSERT_TRUE(reader);
+	EXPECT_EQ(read_all(*reader, 333), contents);
+
+	// Reads past the end are cut short
+	std::vector<uint8_t> tail(100);
+	size_t num_read = 0;
+	EXPECT_TRUE(reader->Read(950, tail.data(), tail.size(), num_read));
+	EXPECT_EQ(num_read, 50);
+	EXPECT_TRUE(std::equal(tail.begin(), tail.begin() + 50, contents.begin() + 950));
+}
+
+TEST(ZipArchive, ReadsDeflatedEntriesAcrossBlocks)
+{
+	const auto contents = make_data(ZipEntryReader::BlockSize * 5 + 123);
+	const auto zip      = make_zip({{"FILE.BIN", contents, true}});
+	std::string error   = {};
+	const auto archive  = open_zip(zip, error);
+	ASSERT_TRUE(archive) << error;
+
+	const auto reader = archive->OpenEntry(*archive->Find("FILE.BIN"));
+	ASSERT_TRUE(reader);
+	EXPECT_EQ(read_all(*reader, 10000), contents);
+	EXPECT_EQ(reader->GetNumCachedBlocks(), 6);
+
+	// Reads behind the stream's position come from the cache
+	std::vector<uint8_t> data(5000);
+	size_t num_read = 0;
+	EXPECT_TRUE(reader->Read(30000, data.data(), data.size(), num_read));
+	EXPECT_EQ(num_read, data.size());
+	EXPECT_TRUE(std::equal(data.begin(), data.end(), contents.begin() + 30000));
+}
+
+TEST(ZipArchive, SeeksBackPastEvictedBlocks)
+{
+	constexpr auto NumBlocks = ZipEntryReader::MaxCachedBlocks + 8;
+
+	const auto contents = make_data(ZipEntryReader::BlockSize * NumBlocks);
+	const auto zip      = make_zip({{"FILE.BIN", contents, true}});
+	std::string error   = {};
+	const auto archive  = open_zip(zip, error);
+	ASSERT_TRUE(archive) << error;
+
+	const auto reader = archive->OpenEntry(*archive->Find("FILE.BIN"));
+	ASSERT_TRUE(reader);
+
+	std::vector<uint8_t> data(100);
+	size_t num_read = 0;
+	for (const uint64_t offset : {contents.size() - 100, uint64_t(10), contents.size() / 2}) {
+		EXPECT_TRUE(reader->Read(offset, data.data(), data.size(), num_read));
+		EXPECT_EQ(num_read, data.size());
+		EXPECT_TRUE(std::equal(data.begin(), data.end(), contents.begin() + offset))
+		        << "offset " << offset;
+		EXPECT_LE(reader->GetNumCachedBlocks(), ZipEntryReader::MaxCachedBlocks);
+	}
+}
+
+TEST(ZipArchive, ReadsZip64Records)
+{
+	const auto contents = make_data(5000);
+	const auto zip = make_zip({{"A.TXT", make_data(10)}, {"B/C.BIN", contents, true}},
+	                          true);
+	std::string error  = {};
+	const auto archive = open_zip(zip, error);
+	ASSERT_TRUE(archive) << error;
+
+	const auto entry = archive->Find("B/C.BIN");
+	ASSERT_TRUE(entry);
+	EXPECT_EQ(entry->size, contents.size());
+
+	const auto reader = archive->OpenEntry(*entry);
+	ASSERT_TRUE(reader);
+	EXPECT_EQ(read_all(*reader, 4096), contents);
+}
+
+TEST(ZipArchive, RefusesEncryptedEntries)
+{
+	const auto zip = make_zip({{"SECRET.TXT", make_data(10), false, 0, FlagEncrypted}});
+	std::string error  = {};
+	const auto archive = open_zip(zip, error);
+	ASSERT_TRUE(archive) << error;
+
+	const auto entry = archive->Find("SECRET.TXT");
+	ASSERT_TRUE(entry);
+	EXPECT_TRUE(entry->is_encrypted);
+	EXPECT_FALSE(archive->OpenEntry(*entry));
+}
+
+TEST(ZipArchive, RefusesDamagedDirectories)
+{
+	auto zip = make_zip({{"A.TXT", make_data(10)}});
+
+	// Points the central directory past the end of the archive
+	const auto eocd = zip.size() - EndOfCentralDirSize - 17;
+	zip[eocd + 19]  = 0x7f;
+
+	std::string error = {};
+	EXPECT_FALSE(open_zip(zip, error));
+	EXPECT_FALSE(error.empty());
+}
+
+TEST(ZipArchive, RefusesWrappingZip64EntryCounts)
+{
+	auto zip = make_zip({{"A.TXT", make_data(10)}}, true);
+
+	// An entry count whose central directory size wraps around to 40
+	// bytes when multiplied
+	const uint8_t signature[] = {0x50, 0x4b, 0x06, 0x06};
+	const auto record = std::search(zip.begin(), zip.end(),
+	                                std::begin(signature), std::end(signature));
+	ASSERT_NE(record, zip.end());
+
+	std::vector<uint8_t> num_entries = {};
+	put_le(num_entries, UINT64_MAX / CentralDirEntrySize + 1, 8);
+	std::copy(num_entries.begin(), num_entries.end(), record + 24);
+	std::copy(num_entries.begin(), num_entries.end(), record + 32);
+
+	std::string error = {};
+	EXPECT_FALSE(open_zip(zip, error));
+	EXPECT_FALSE(error.empty());
+}
+
+TEST(ZipArchive, IgnoresOtherFiles)
+{
+	std::string error = {};
+	EXPECT_FALSE(open_zip(make_data(5000), error));
+	EXPECT_TRUE(error.empty());
+
+	EXPECT_FALSE(open_zip({}, error));
+	EXPECT_TRUE(error.empty());
+}
+
+} // namespace